@@ -259,6 +259,30 @@ def envoy_cc_test_library(name,
         linkstatic = 1,
     )
 
+# Envoy C++ benchmark binaries (google-benchmark) should be specified with this function. They are
+# binaries rather than tests, since their numbers only mean something in an -c opt build on a quiet
+# machine, e.g. bazel run -c opt //test/benchmark:header_map_benchmark.
+def envoy_cc_benchmark_binary(name,
+                              srcs = [],
+                              data = [],
+                              external_deps = [],
+                              deps = [],
+                              repository = ""):
+    native.cc_binary(
+        name = name,
+        srcs = srcs,
+        data = data,
+        copts = envoy_copts(repository, test = True),
+        linkopts = envoy_test_linkopts(),
+        linkstatic = 1,
+        testonly = 1,
+        malloc = tcmalloc_external_dep(repository),
+        deps = deps + [envoy_external_dep_path(dep) for dep in external_deps] + [
+            envoy_external_dep_path('benchmark'),
+            repository + "//test/benchmark:main",
+        ],
+    )
+
 # Envoy Python test binaries should be specified with this function.
 def envoy_py_test_binary(name,
                          external_deps = [],
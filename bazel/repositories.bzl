@@ -226,6 +226,10 @@ def envoy_dependencies(path = "@envoy_deps//", skip_com_google_protobuf = False,
         com_github_lightstep_lightstep_tracer_cpp(repository)
     if not ("googletest" in skip_targets or "com_google_googletest" in existing_rule_keys):
         com_google_googletest()
+    if not ("benchmark" in skip_targets or "com_github_google_benchmark" in existing_rule_keys):
+        com_github_google_benchmark(repository)
+    if not ("re2" in skip_targets or "com_googlesource_code_re2" in existing_rule_keys):
+        com_googlesource_code_re2()
     if not (skip_com_google_protobuf or "com_google_protobuf" in existing_rule_keys):
         com_google_protobuf()
 
@@ -301,6 +305,29 @@ def com_google_googletest():
       actual = "@com_google_googletest//:gtest",
   )
 
+def com_github_google_benchmark(repository = ""):
+  native.new_git_repository(
+      name = "com_github_google_benchmark",
+      remote = "https://github.com/google/benchmark",
+      tag = "v1.3.0",
+      build_file = repository + "//bazel/external:benchmark.BUILD",
+  )
+  native.bind(
+      name = "benchmark",
+      actual = "@com_github_google_benchmark//:benchmark",
+  )
+
+def com_googlesource_code_re2():
+  native.git_repository(
+      name = "com_googlesource_code_re2",
+      remote = "https://github.com/google/re2",
+      tag = "2018-02-01",
+  )
+  native.bind(
+      name = "re2",
+      actual = "@com_googlesource_code_re2//:re2",
+  )
+
 def com_google_protobuf():
   # TODO(htuch): This can switch back to a point release http_archive at the next
   # release (> 3.4.1), we need HEAD proto_library support and
@@ -4,6 +4,8 @@
 TARGET_RECIPES = {
     "ares": "cares",
     "backward": "backward",
+    "brotlidec": "brotli",
+    "brotlienc": "brotli",
     "event": "libevent",
     "event_pthreads": "libevent",
     # TODO(htuch): This shouldn't be a build recipe, it's a tooling dependency
@@ -19,4 +21,5 @@ TARGET_RECIPES = {
     "xxhash": "xxhash",
     "yaml_cpp": "yaml-cpp",
     "zlib": "zlib",
+    "zstd": "zstd",
 }
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+set -e
+
+VERSION=1.3.3
+
+wget -O zstd-"$VERSION".tar.gz https://github.com/facebook/zstd/archive/v"$VERSION".tar.gz
+tar xf zstd-"$VERSION".tar.gz
+cd zstd-"$VERSION"/lib
+make V=1 PREFIX="$THIRDPARTY_BUILD" install-static install-includes
@@ -18,6 +18,30 @@ struct RawSlice {
   size_t len_ = 0;
 };
 
+/**
+ * Memory owned outside of any buffer which can be added to a buffer without copying it.
+ */
+class BufferFragment {
+public:
+  virtual ~BufferFragment() {}
+
+  /**
+   * @return the start of the fragment's data.
+   */
+  virtual const void* data() const PURE;
+
+  /**
+   * @return the size of the fragment's data.
+   */
+  virtual size_t size() const PURE;
+
+  /**
+   * Called once no buffer references the fragment's data any longer. The fragment may delete
+   * itself from within this call.
+   */
+  virtual void done() PURE;
+};
+
 /**
  * A basic buffer abstraction.
  */
@@ -44,6 +68,27 @@ public:
    */
   virtual void add(const Instance& data) PURE;
 
+  /**
+   * Add externally owned memory to the buffer without copying it. The data must stay valid and
+   * unmodified until fragment.done() is called, which happens once the data has been drained from
+   * this buffer and from any buffer it was moved into.
+   * @param fragment supplies the fragment to add.
+   */
+  virtual void addBufferFragment(BufferFragment& fragment) PURE;
+
+  /**
+   * Prepend a string to the buffer.
+   * @param data supplies the string to copy.
+   */
+  virtual void prepend(const std::string& data) PURE;
+
+  /**
+   * Prepend data from another buffer to this buffer. The supplied buffer is drained after this
+   * method is called. As little copying is done as possible.
+   * @param data supplies the buffer to move to the front of this buffer.
+   */
+  virtual void prepend(Instance& data) PURE;
+
   /**
    * Commit a set of slices originally obtained from reserve(). The number of slices can be
    * different from the number obtained from reserve(). The size of each slice can also be altered.
@@ -72,14 +117,7 @@ public:
    * @param out_size supplies the size of out.
    * @return the actual number of slices needed, which may be greater than out_size. Passing
    *         nullptr for out and 0 for out_size will just return the size of the array needed
-   *         to capture all of the slice data.
-   * TODO(mattklein123): WARNING: The underlying implementation of this function currently uses
-   * libevent's evbuffer. It has the infuriating property where calling getRawSlices(nullptr, 0)
-   * will return the slices that include all of the buffer data, but not any empty slices at the
-   * end. However, calling getRawSlices(iovec, SOME_CONST), WILL return potentially empty slices
-   * beyond the end of the buffer. Code that is trying to avoid stack overflow by limiting the
-   * number of returned slices needs to deal with this. When we get rid of evbuffer we can rework
-   * all of this.
+   *         to capture all of the slice data. Empty slices are never returned.
    */
   virtual uint64_t getRawSlices(RawSlice* out, uint64_t out_size) const PURE;
 
@@ -132,6 +170,13 @@ public:
    */
   virtual ssize_t search(const void* data, uint64_t size, size_t start) const PURE;
 
+  /**
+   * Release the memory an empty buffer keeps around for new data, e.g. once its owner has been
+   * idle for a while. The buffer allocates again on the next add or reserve. Does nothing if the
+   * buffer holds any data.
+   */
+  virtual void shrink() PURE;
+
   /**
    * Write the buffer out to a file descriptor.
    * @param fd supplies the descriptor to write to.
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+
 #include "envoy/common/exception.h"
 
 namespace Envoy {
@@ -40,6 +42,14 @@ public:
     valid_ = true;
   }
 
+  /**
+   * Move the contained value in, which will make it valid.
+   */
+  void value(T&& new_value) {
+    value_ = std::move(new_value);
+    valid_ = true;
+  }
+
   /**
    * @return the contained value. Will throw if the contained value is not valid.
    */
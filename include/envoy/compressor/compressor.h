@@ -1,6 +1,9 @@
 #pragma once
 
+#include <memory>
+
 #include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
 
 namespace Envoy {
 namespace Compressor {
@@ -13,12 +16,29 @@ public:
   virtual ~Compressor() {}
 
   /**
-   * Compresses data from one buffer into another buffer.
+   * Compresses data from one buffer into another buffer. The compressed data may be held back
+   * until a later call, but what a call outputs is committed to its output buffer before it
+   * returns, so each call may supply a different output buffer.
    * @param input_buffer supplies the buffer with data to be compressed.
    * @param output_buffer supplies the buffer to output compressed data.
    */
   virtual void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Ends the compressed stream: compresses the remaining data and writes the end of the format to
+   * the output buffer, so that a decoder accepts the output as a complete stream. reset() must be
+   * called before compressing another stream.
+   * @param output_buffer supplies the buffer to output compressed data.
+   */
+  virtual void end(Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Resets the compressor to compress a new stream with the same parameters.
+   */
+  virtual void reset() PURE;
 };
 
+typedef std::unique_ptr<Compressor> CompressorPtr;
+
 } // namespace Compressor
 } // namespace Envoy
@@ -23,6 +23,14 @@ public:
   virtual void onConfigUpdate(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
                               const std::string& version_info) PURE;
 
+  /**
+   * Called instead of onConfigUpdate() when a configuration update is received in which the
+   * watched resources are identical to those last accepted. Only used for watches on named
+   * resources.
+   * @param version_info update version.
+   */
+  virtual void onConfigUnchanged(const std::string& version_info) PURE;
+
   /**
    * Called when either the subscription is unable to fetch a config update or when onConfigUpdate
    * invokes an exception.
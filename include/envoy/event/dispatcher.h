@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -17,10 +18,49 @@
 #include "envoy/network/listener.h"
 #include "envoy/ssl/context.h"
 #include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
 
 namespace Envoy {
 namespace Event {
 
+/**
+ * All dispatcher stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DISPATCHER_STATS(HISTOGRAM)                                                            \
+  HISTOGRAM(loop_duration_us)                                                                      \
+  HISTOGRAM(poll_duration_us)                                                                      \
+  HISTOGRAM(io_duration_us)                                                                        \
+  HISTOGRAM(timer_duration_us)                                                                     \
+  HISTOGRAM(post_duration_us)                                                                      \
+  HISTOGRAM(post_callbacks)                                                                        \
+  HISTOGRAM(deferred_deletes)
+// clang-format on
+
+/**
+ * Struct definition for all dispatcher stats. @see stats_macros.h
+ */
+struct DispatcherStats {
+  ALL_DISPATCHER_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * All busy poll stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_BUSY_POLL_STATS(COUNTER)                                                               \
+  COUNTER(busy_poll_spin_us)                                                                       \
+  COUNTER(busy_poll_wakeups)                                                                       \
+  COUNTER(busy_poll_sleeps)
+// clang-format on
+
+/**
+ * Struct definition for all busy poll stats. @see stats_macros.h
+ */
+struct BusyPollStats {
+  ALL_BUSY_POLL_STATS(GENERATE_COUNTER_STRUCT)
+};
+
 /**
  * Callback invoked when a dispatcher post() runs.
  */
@@ -38,6 +78,38 @@ public:
    */
   virtual void clearDeferredDeleteList() PURE;
 
+  /**
+   * Start recording the dispatcher stats: for every iteration of the event loop, how long it took,
+   * how much of it was spent waiting for events and how much in I/O, timer and posted callbacks;
+   * and how many callbacks and deferred deletions were run in one go. Measuring the loop costs a
+   * few clock reads per callback, so only dispatchers which are worth watching record stats.
+   * Must be called before run().
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the prefix of the stat names, such as "server.worker_0.dispatcher.".
+   */
+  virtual void initializeStats(Stats::Scope& scope, const std::string& prefix) PURE;
+
+  /**
+   * Make run() keep polling for events without blocking for up to the supplied budget after the
+   * last event, before it blocks in the kernel again. This trades CPU for the latency of waking up
+   * a blocked thread. The sockets of the connections the dispatcher creates get SO_BUSY_POLL with
+   * the same budget. Must be called before run().
+   * @param budget supplies how long to keep polling for after each event.
+   * @param scope supplies the scope to create the busy poll stats in.
+   * @param prefix supplies the prefix of the stat names, such as "server.worker_0.dispatcher.".
+   */
+  virtual void enableBusyPoll(std::chrono::microseconds budget, Stats::Scope& scope,
+                              const std::string& prefix) PURE;
+
+  /**
+   * Bound the time the event loop spends deleting the items submitted for deferred deletion in one
+   * go. Once a pass over the deferred deletion list has taken longer than the budget, the items
+   * left are deleted on the next iterations of the loop, after the events which came in meanwhile.
+   * clearDeferredDeleteList() still deletes them all. Must be called before run().
+   * @param budget supplies the time each pass may take, or 0 for no limit.
+   */
+  virtual void setDeferredDeleteBudget(std::chrono::microseconds budget) PURE;
+
   /**
    * Create a client connection.
    * @param address supplies the address to connect to.
@@ -122,6 +194,15 @@ public:
    */
   virtual TimerPtr createTimer(TimerCb cb) PURE;
 
+  /**
+   * Allocate a coarse timer, which fires up to a fraction of a second late but is cheaper to enable
+   * and disable than a timer from createTimer(). For timeouts which are long, and which are usually
+   * disabled or reset before they fire, such as idle timeouts. @see Event::Timer for docs on how to
+   * use the timer.
+   * @param cb supplies the callback to invoke when the timer fires.
+   */
+  virtual TimerPtr createCoarseTimer(TimerCb cb) PURE;
+
   /**
    * Submit an item for deferred delete. @see DeferredDeletable.
    */
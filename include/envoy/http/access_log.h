@@ -159,6 +159,14 @@ public:
    * @return TRUE if the log should be written.
    */
   virtual bool evaluate(const RequestInfo& info, const HeaderMap& request_headers) PURE;
+
+  /**
+   * Evaluate what can be known from the request headers alone, as soon as they have been
+   * received.
+   * @return FALSE if evaluate() would reject the request whatever happens to it later, TRUE if
+   *         that can't be told yet.
+   */
+  virtual bool evaluateRequestHeaders(const HeaderMap& request_headers) PURE;
 };
 
 typedef std::unique_ptr<Filter> FilterPtr;
@@ -179,6 +187,14 @@ public:
    */
   virtual void log(const HeaderMap* request_headers, const HeaderMap* response_headers,
                    const RequestInfo& request_info) PURE;
+
+  /**
+   * Tell from its request headers whether a request could be logged at all. log() need not be
+   * called for a request which can't be.
+   * @param request_headers supplies the incoming request headers after filtering.
+   * @return FALSE if the request will not be logged.
+   */
+  virtual bool mayLog(const HeaderMap& request_headers) PURE;
 };
 
 typedef std::shared_ptr<Instance> InstanceSharedPtr;
@@ -190,9 +206,25 @@ class Formatter {
 public:
   virtual ~Formatter() {}
 
-  virtual std::string format(const Http::HeaderMap& request_headers,
-                             const Http::HeaderMap& response_headers,
-                             const RequestInfo& request_info) const PURE;
+  /**
+   * Append the formatted output to a string, so that the parts of a composite format do not each
+   * build a string of their own.
+   * @param output supplies the string to append to.
+   */
+  virtual void formatInto(const Http::HeaderMap& request_headers,
+                          const Http::HeaderMap& response_headers, const RequestInfo& request_info,
+                          std::string& output) const PURE;
+
+  /**
+   * @return std::string the formatted output.
+   */
+  std::string format(const Http::HeaderMap& request_headers,
+                     const Http::HeaderMap& response_headers,
+                     const RequestInfo& request_info) const {
+    std::string output;
+    formatInto(request_headers, response_headers, request_info, output);
+    return output;
+  }
 };
 
 typedef std::unique_ptr<Formatter> FormatterPtr;
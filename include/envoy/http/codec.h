@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -181,6 +182,14 @@ struct Http1Settings {
   // Enable codec to parse absolute uris. This enables forward/explicit proxy support for non TLS
   // traffic
   bool allow_absolute_url_{false};
+  // Share the storage of large header values that repeat across requests on the same worker. See
+  // HeaderValueInterner.
+  bool intern_header_values_{false};
+  // Decode requests with the buffering FastParserImpl instead of http_parser.
+  bool fast_parser_{false};
+  // If non zero, the data of chunk encoded responses is held back for up to this long, so that
+  // small writes which follow each other closely (e.g. server-sent events) go out as one chunk.
+  std::chrono::milliseconds chunk_aggregation_{0};
 };
 
 /**
@@ -192,6 +201,15 @@ struct Http2Settings {
   uint32_t max_concurrent_streams_{DEFAULT_MAX_CONCURRENT_STREAMS};
   uint32_t initial_stream_window_size_{DEFAULT_INITIAL_STREAM_WINDOW_SIZE};
   uint32_t initial_connection_window_size_{DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE};
+  // Share the storage of large header values that repeat across requests on the same worker. See
+  // HeaderValueInterner.
+  bool intern_header_values_{false};
+  // If larger than hpack_table_size_, the HPACK table advertised to the peer is doubled, up to
+  // this size, on connections where received headers compress poorly because the table churns.
+  uint32_t max_adaptive_hpack_table_size_{0};
+  // If larger than initial_stream_window_size_, the receive windows advertised to the peer grow, up
+  // to this size, on connections whose bandwidth-delay product they would otherwise limit.
+  uint32_t max_adaptive_window_size_{0};
 
   // disable HPACK compression
   static const uint32_t MIN_HPACK_TABLE_SIZE = 0;
@@ -273,6 +291,12 @@ public:
    * low watermark.
    */
   virtual void onUnderlyingConnectionBelowWriteBufferLowWatermark() PURE;
+
+  /**
+   * Release the memory the codec keeps between streams. Called when the underlying
+   * Network::Connection has been idle for a while and the codec has no active streams.
+   */
+  virtual void shrink() PURE;
 };
 
 /**
@@ -181,7 +181,8 @@ public:
    *
    * 4) If additional data needs to be added in the decodeTrailers() callback, this method can be
    * called in the context of the callback. All further filters will receive decodeData(..., false)
-   * followed by decodeTrailers().
+   * followed by decodeTrailers(). If the filter had stopped iteration, the data is added to the
+   * buffered data instead, and is sent on when the filter continues.
    *
    * It is an error to call this method in any other case.
    *
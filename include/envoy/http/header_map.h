@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
 
@@ -16,6 +17,8 @@ namespace Http {
  * Wrapper for a lower case string used in header operations to generally avoid needless case
  * insensitive compares.
  */
+class SharedHeaderValue;
+
 class LowerCaseString {
 public:
   LowerCaseString(LowerCaseString&& rhs) : string_(std::move(rhs.string_)) {}
@@ -39,14 +42,15 @@ private:
 
 /**
  * This is a string implementation for use in header processing. It is heavily optimized for
- * performance. It supports 3 different types of storage and can switch between them:
+ * performance. It supports 4 different types of storage and can switch between them:
  * 1) A reference.
  * 2) Interned string.
  * 3) Heap allocated storage.
+ * 4) A reference counted value shared with other strings (see SharedHeaderValue).
  */
 class HeaderString {
 public:
-  enum class Type { Inline, Reference, Dynamic };
+  enum class Type { Inline, Reference, Dynamic, Shared };
 
   /**
    * Default constructor. Sets up for inline storage.
@@ -77,7 +81,8 @@ public:
   void append(const char* data, uint32_t size);
 
   /**
-   * @return the modifiable backing buffer (either inline or heap allocated).
+   * @return the modifiable backing buffer (either inline or heap allocated). Must not be used on
+   *         reference or shared strings.
    */
   char* buffer() { return buffer_.dynamic_; }
 
@@ -87,8 +92,8 @@ public:
   const char* c_str() const { return buffer_.ref_; }
 
   /**
-   * Return the string to a default state. Reference strings are not touched. Both inline/dynamic
-   * strings are reset to zero size.
+   * Return the string to a default state. Reference strings are not touched. Shared strings drop
+   * their reference and become inline. Both inline/dynamic strings are reset to zero size.
    */
   void clear();
 
@@ -119,6 +124,12 @@ public:
    */
   void setReference(const std::string& ref_value);
 
+  /**
+   * Set the value of the string to a shared value. The string holds a reference to the value until
+   * it is overwritten or destroyed.
+   */
+  void setShared(SharedHeaderValue& value);
+
   /**
    * @return the size of the string, not including the null terminator.
    */
@@ -129,6 +140,11 @@ public:
    */
   Type type() const { return type_; }
 
+  /**
+   * @return the shared value backing the string, or nullptr if the string is not of Shared type.
+   */
+  SharedHeaderValue* shared() const { return type_ == Type::Shared ? shared_ : nullptr; }
+
   bool operator==(const char* rhs) const { return 0 == strcmp(c_str(), rhs); }
   bool operator!=(const char* rhs) const { return 0 != strcmp(c_str(), rhs); }
 
@@ -141,9 +157,11 @@ private:
   union {
     char inline_buffer_[128];
     uint32_t dynamic_capacity_;
+    SharedHeaderValue* shared_;
   };
 
   void freeDynamic();
+  void releaseShared();
 
   uint32_t string_length_;
   Type type_;
@@ -390,6 +408,13 @@ public:
    */
   virtual void remove(const LowerCaseString& key) PURE;
 
+  /**
+   * Remove all instances of each of a set of headers. This is cheaper than removing the keys one
+   * at a time, since the map is walked at most once.
+   * @param keys supplies the header keys to remove.
+   */
+  virtual void remove(const std::list<LowerCaseString>& keys) PURE;
+
   /**
    * @return the number of headers in the map.
    */
@@ -17,6 +17,13 @@ public:
    * client when there are errors establishing a connection to upstream server.
    */
   virtual void sendHeadersOnlyResponse(HeaderMap& headers) PURE;
+
+  /**
+   * Called once the upgrade request has been sent to the upstream host. From then on the WebSocket
+   * implementation only proxies data: it does not call back and does not refer to the request
+   * headers, request info or route entry it was created with.
+   */
+  virtual void onUpgradeRequestSent() PURE;
 };
 
 } // namespace Http
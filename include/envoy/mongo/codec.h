@@ -141,6 +141,12 @@ public:
   virtual void numberReturned(int32_t number_returned) PURE;
   virtual const std::list<Bson::DocumentSharedPtr>& documents() const PURE;
   virtual std::list<Bson::DocumentSharedPtr>& documents() PURE;
+
+  /**
+   * @return uint64_t the encoded size of the documents. A decoder which skips the documents of
+   *         replies still knows their size, while documents() is empty.
+   */
+  virtual uint64_t documentsByteSize() const PURE;
 };
 
 typedef std::unique_ptr<ReplyMessage> ReplyMessagePtr;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -81,6 +83,19 @@ public:
     Stats::Counter* bind_errors_;
   };
 
+  /**
+   * Stats of the worker which owns a downstream connection. Unlike ConnectionStats, which the
+   * filters on a connection set, the connection handler sets these for all the connections of a
+   * worker, so that they tell how the load is spread over the workers.
+   */
+  struct WorkerStats {
+    Stats::Counter& read_total_;
+    Stats::Counter& write_total_;
+    // Kept by the filters which open requests on the connection, such as the HTTP connection
+    // manager.
+    Stats::Gauge& rq_active_;
+  };
+
   virtual ~Connection() {}
 
   /**
@@ -157,6 +172,18 @@ public:
    */
   virtual void setConnectionStats(const ConnectionStats& stats) PURE;
 
+  /**
+   * Set the stats of the worker which owns the connection. Like the connection stats, they are
+   * eventually consistent.
+   */
+  virtual void setWorkerStats(const WorkerStats& stats) PURE;
+
+  /**
+   * @return const WorkerStats* the stats of the worker which owns the connection, or nullptr if
+   *         the worker does not keep stats.
+   */
+  virtual const WorkerStats* workerStats() const PURE;
+
   /**
    * @return the SSL connection data if this is an SSL connection, or nullptr if it is not.
    */
@@ -205,6 +232,34 @@ public:
    * @return boolean telling if the connection is currently above the high watermark.
    */
   virtual bool aboveHighWatermark() const PURE;
+
+  /**
+   * Release the memory of the connection's empty buffers whenever it has neither read nor written
+   * anything for the supplied period, and then run the memory release callbacks so that filters
+   * can release the memory they keep between requests. The buffers allocate again on the next
+   * read or write.
+   * @param period supplies how long the connection must be idle for.
+   */
+  virtual void enableIdleMemoryRelease(std::chrono::milliseconds period) PURE;
+
+  /**
+   * Add a callback which is run each time the connection releases its memory after being idle.
+   * @see enableIdleMemoryRelease().
+   */
+  virtual void addMemoryReleaseCallback(std::function<void()> cb) PURE;
+
+  /**
+   * Move the data read on this connection straight to the socket of a peer connection, and the
+   * data read on the peer straight to this connection's socket, with splice() through a pipe so
+   * that the data is never copied to user space. The spliced data bypasses the filters and the
+   * read buffers of both connections, so this is only done for plaintext connections which have
+   * nothing left in their read buffers, no write filters and no read filter other than the one
+   * which asks for it. Nothing else may be written to either connection afterwards.
+   * @param peer supplies the connection to splice with.
+   * @return bool whether the connections are spliced. They are not if either connection does not
+   *         meet the conditions above or the platform does not support splice().
+   */
+  virtual bool spliceWith(Connection& peer) PURE;
 };
 
 typedef std::unique_ptr<Connection> ConnectionPtr;
@@ -75,6 +75,17 @@ public:
    * Stop all listeners. This will not close any connections and is used for draining.
    */
   virtual void stopListeners() PURE;
+
+  /**
+   * Temporarily stop all listeners from accepting new connections. This will not close any
+   * connections. Listeners added while disabled start disabled.
+   */
+  virtual void disableListeners() PURE;
+
+  /**
+   * Resume accepting new connections on all listeners after disableListeners().
+   */
+  virtual void enableListeners() PURE;
 };
 
 typedef std::unique_ptr<ConnectionHandler> ConnectionHandlerPtr;
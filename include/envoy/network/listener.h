@@ -1,5 +1,7 @@
 #pragma once
 
+#include <sys/socket.h>
+
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -10,6 +12,70 @@
 namespace Envoy {
 namespace Network {
 
+/**
+ * A listener which takes part in connection balancing. @see ConnectionBalancer.
+ */
+class BalancedConnectionHandler {
+public:
+  virtual ~BalancedConnectionHandler() {}
+
+  /**
+   * @return uint64_t the number of connections owned by the worker of the listener. Called from
+   *         any thread.
+   */
+  virtual uint64_t numConnections() PURE;
+
+  /**
+   * @return Event::Dispatcher& the dispatcher of the worker of the listener.
+   */
+  virtual Event::Dispatcher& dispatcher() PURE;
+
+  /**
+   * Take over a socket which the listener of another worker accepted. Called on the thread of the
+   * listener.
+   * @param fd supplies the accepted socket.
+   * @param remote_addr supplies the remote address of the socket.
+   * @param remote_addr_len supplies the length of remote_addr.
+   */
+  virtual void onBalancedConnection(int fd, const sockaddr_storage& remote_addr,
+                                    socklen_t remote_addr_len) PURE;
+};
+
+/**
+ * Spreads the sockets accepted by the listeners of all workers for one listener configuration
+ * over those workers, by handing each socket over to the worker which owns the fewest connections
+ * before a connection is created for it.
+ */
+class ConnectionBalancer {
+public:
+  virtual ~ConnectionBalancer() {}
+
+  /**
+   * Add a listener to the ones sockets are spread over. Called on the thread of the listener.
+   */
+  virtual void registerHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Remove a listener added by registerHandler(). Called on the thread of the listener, before it
+   * is destroyed.
+   */
+  virtual void unregisterHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Pick the worker which is to own a socket that a listener accepted. If it is another worker
+   * than the listener's, the socket is posted to that worker's listener.
+   * @param handler supplies the listener which accepted the socket.
+   * @param fd supplies the accepted socket.
+   * @param remote_addr supplies the remote address of the socket.
+   * @param remote_addr_len supplies the length of remote_addr.
+   * @return bool whether the socket was handed over. If not, handler keeps it.
+   */
+  virtual bool balance(BalancedConnectionHandler& handler, int fd,
+                       const sockaddr_storage& remote_addr, socklen_t remote_addr_len) PURE;
+};
+
+typedef std::shared_ptr<ConnectionBalancer> ConnectionBalancerSharedPtr;
+
 /**
  * Listener configurations options.
  */
@@ -25,6 +91,8 @@ struct ListenerOptions {
   bool use_original_dst_;
   // Soft limit on size of the listener's new connection read and write buffers.
   uint32_t per_connection_buffer_limit_bytes_;
+  // If set, spreads the sockets accepted by this listener over the workers.
+  ConnectionBalancerSharedPtr connection_balancer_;
 
   /**
    * Factory for ListenerOptions with bind_to_port_ set.
@@ -34,7 +102,8 @@ struct ListenerOptions {
     return {.bind_to_port_ = true,
             .use_proxy_proto_ = false,
             .use_original_dst_ = false,
-            .per_connection_buffer_limit_bytes_ = 0};
+            .per_connection_buffer_limit_bytes_ = 0,
+            .connection_balancer_ = nullptr};
   }
 };
 
@@ -58,6 +127,17 @@ public:
 class Listener {
 public:
   virtual ~Listener() {}
+
+  /**
+   * Temporarily stop accepting new connections, e.g. while the server is overloaded. Connections
+   * which are waiting to be accepted stay in the socket's backlog.
+   */
+  virtual void disable() PURE;
+
+  /**
+   * Resume accepting new connections after disable().
+   */
+  virtual void enable() PURE;
 };
 
 typedef std::unique_ptr<Listener> ListenerPtr;
@@ -22,8 +22,14 @@ enum class RespType { Null, SimpleString, BulkString, Integer, Error, Array };
 class RespValue {
 public:
   RespValue() : type_(RespType::Null) {}
+  RespValue(const RespValue& other) : type_(RespType::Null) { *this = other; }
   ~RespValue() { cleanup(); }
 
+  /**
+   * Make a deep copy of another value.
+   */
+  RespValue& operator=(const RespValue& other);
+
   /**
    * Convert a RESP value to a string for debugging purposes.
    */
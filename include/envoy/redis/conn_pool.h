@@ -84,6 +84,12 @@ public:
    *         all operations use the same timeout.
    */
   virtual std::chrono::milliseconds opTimeout() const PURE;
+
+  /**
+   * @return bool whether the commands sent on a connection during an iteration of the event loop
+   *         are written together at the start of the next one, rather than one by one.
+   */
+  virtual bool batchWrites() const PURE;
 };
 
 /**
@@ -48,6 +48,13 @@ public:
    */
   virtual const std::list<std::string>& allowOrigins() const PURE;
 
+  /**
+   * @param origin supplies the origin of a request.
+   * @return bool whether access-control-allow-origin allows the origin, either by listing it or
+   *         through a "*" value.
+   */
+  virtual bool allowsOrigin(const std::string& origin) const PURE;
+
   /**
    * @return std::string access-control-allow-methods value.
    */
@@ -145,6 +152,14 @@ public:
   virtual RetryStatus shouldRetry(const Http::HeaderMap* response_headers,
                                   const Optional<Http::StreamResetReason>& reset_reason,
                                   DoRetryCallback callback) PURE;
+
+  /**
+   * Determine whether a hedged request, a copy of the request sent to another host while the
+   * original request is still outstanding, may be sent now. A hedged request uses up a retry and
+   * counts against the retry circuit breaker of the cluster until the retry state is destroyed.
+   * @return true if the hedged request should be sent.
+   */
+  virtual bool shouldHedge() PURE;
 };
 
 typedef std::unique_ptr<RetryState> RetryStatePtr;
@@ -26,10 +26,29 @@ public:
    * for example, 7c25513b-0466-4558-a64c-12c6704f37ed
    */
   virtual std::string uuid() PURE;
+
+  /**
+   * Write a new uuid4 to a caller provided buffer, e.g. straight into a header value.
+   * @param out receives UUID_LENGTH chars. No null terminator is written.
+   */
+  virtual void uuid(char* out) PURE;
+
+  static const size_t UUID_LENGTH = 36;
 };
 
 typedef std::unique_ptr<RandomGenerator> RandomGeneratorPtr;
 
+/**
+ * A runtime key which was registered ahead of time, typically while loading configuration, so that
+ * snapshots can look up its value by index rather than by hashing its name on every request.
+ */
+struct Key {
+  Key(const std::string& name, uint32_t index) : name_(name), index_(index) {}
+
+  const std::string name_;
+  const uint32_t index_;
+};
+
 /**
  * A snapshot of runtime data.
  */
@@ -96,6 +115,31 @@ public:
    * @return uint64_t the runtime value or the default value.
    */
   virtual uint64_t getInteger(const std::string& key, uint64_t default_value) const PURE;
+
+  /**
+   * Variants of the above which look up a registered key. They behave exactly like the variants
+   * taking the name of the key.
+   */
+  virtual bool featureEnabled(const Key& key, uint64_t default_value) const PURE;
+  virtual bool featureEnabled(const Key& key, uint64_t default_value,
+                              uint64_t random_value) const PURE;
+  virtual bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                              uint16_t num_buckets) const PURE;
+  virtual uint64_t getInteger(const Key& key, uint64_t default_value) const PURE;
+
+  /**
+   * @return uint64_t the generation of the snapshot. Each snapshot which is loaded gets a new
+   *         generation, so that a value derived from a snapshot can be cached until it changes.
+   */
+  virtual uint64_t generation() const PURE;
+
+  /**
+   * Test whether any runtime key starts with a prefix. This walks all the keys of the snapshot, so
+   * callers on the request path should cache the result along with generation().
+   * @param prefix supplies the prefix.
+   * @return true if any key starts with the prefix.
+   */
+  virtual bool hasKeyWithPrefix(const std::string& prefix) const PURE;
 };
 
 /**
@@ -11,6 +11,7 @@
 #include "envoy/ratelimit/ratelimit.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/server/admin.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/singleton/manager.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/tracing/http_tracer.h"
@@ -80,6 +81,11 @@ public:
    */
   virtual const LocalInfo::LocalInfo& localInfo() PURE;
 
+  /**
+   * @return Server::OverloadManager& the server's overload manager.
+   */
+  virtual Server::OverloadManager& overloadManager() PURE;
+
   /**
    * @return RandomGenerator& the random generator for the server.
    */
@@ -2,6 +2,7 @@
 
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
+#include "envoy/network/listener.h"
 #include "envoy/server/drain_manager.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/server/guarddog.h"
@@ -30,6 +31,17 @@ public:
   virtual Network::ListenSocketSharedPtr
   createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port) PURE;
 
+  /**
+   * Creates a bound socket with SO_REUSEPORT set, one of the sockets on the same address which the
+   * workers of a listener each listen on.
+   * @param address supplies the socket's address.
+   * @param worker_index supplies the index of the worker which listens on the socket.
+   * @return Network::ListenSocketSharedPtr an initialized and bound socket.
+   */
+  virtual Network::ListenSocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr address,
+                              uint32_t worker_index) PURE;
+
   /**
    * Creates a list of filter factories.
    * @param filters supplies the proto configuration.
@@ -70,6 +82,20 @@ public:
    */
   virtual Network::ListenSocket& socket() PURE;
 
+  /**
+   * @param worker_index supplies the index of a worker.
+   * @return Network::ListenSocket& the socket the worker listens on. This is socket() unless each
+   *         worker has a SO_REUSEPORT socket of its own, all bound to the address of socket().
+   *         Indexes past the number of sockets wrap around.
+   */
+  virtual Network::ListenSocket& workerSocket(uint32_t worker_index) PURE;
+
+  /**
+   * @return Network::ConnectionBalancerSharedPtr the balancer which spreads the connections the
+   *         workers accept over them, or nullptr if each worker keeps the connections it accepts.
+   */
+  virtual Network::ConnectionBalancerSharedPtr connectionBalancer() PURE;
+
   /**
    * @return Ssl::ServerContext* the SSL context
    */
@@ -170,6 +196,17 @@ public:
    */
   virtual void stopListeners() PURE;
 
+  /**
+   * Temporarily stop all listeners on all workers from accepting new connections, e.g. while the
+   * server is overloaded. This does nothing before the workers are started.
+   */
+  virtual void disableListeners() PURE;
+
+  /**
+   * Resume accepting new connections after disableListeners().
+   */
+  virtual void enableListeners() PURE;
+
   /**
    * Stop all threaded workers from running. When this routine returns all worker threads will
    * have exited.
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -59,6 +60,12 @@ public:
    */
   virtual std::chrono::seconds drainTime() PURE;
 
+  /**
+   * @return uint32_t the maximum number of connections each worker drain closes per second while
+   *         draining, or 0 for no limit.
+   */
+  virtual uint32_t drainRate() PURE;
+
   /**
    * @return const std::string& the path to the configuration file.
    */
@@ -131,6 +138,93 @@ public:
    * router/cluster/listener.
    */
   virtual uint64_t maxObjNameLength() PURE;
+
+  /**
+   * @return uint32_t the number of shards of the gauges of each upstream host.
+   */
+  virtual uint32_t hostStatsShards() PURE;
+
+  /**
+   * @return uint32_t the number of shards of each counter.
+   */
+  virtual uint32_t counterShards() PURE;
+
+  /**
+   * @return bool whether the counters and gauges of each cluster are kept in a compact block
+   *         whose names are only built when the stats are listed.
+   */
+  virtual bool compactClusterStats() PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long the server's DNS resolver caches resolutions.
+   */
+  virtual std::chrono::milliseconds dnsCacheTtl() PURE;
+
+  /**
+   * @return bool whether each worker listens on a SO_REUSEPORT socket of its own for each
+   *         listener rather than all workers sharing one socket.
+   */
+  virtual bool reusePort() PURE;
+
+  /**
+   * @return bool whether the workers hand the connections they accept over to the worker which
+   *         owns the fewest connections.
+   */
+  virtual bool balanceConnections() PURE;
+
+  /**
+   * @return bool whether the main thread and the workers record the stats of their event loops.
+   */
+  virtual bool dispatcherStats() PURE;
+
+  /**
+   * @return bool whether each worker keeps stats of the connections, requests and bytes of all
+   *         its listeners.
+   */
+  virtual bool workerStats() PURE;
+
+  /**
+   * @return bool whether listener updates which only change the filters of the filter chains are
+   *         applied in place, leaving the existing connections of the listener running.
+   */
+  virtual bool inPlaceListenerUpdates() PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long a downstream connection must be idle before it
+   *         releases the memory of its buffers and codec, or 0 if they are kept.
+   */
+  virtual std::chrono::milliseconds idleMemoryRelease() PURE;
+
+  /**
+   * @return std::chrono::microseconds how long the event loops of the workers keep polling after
+   *         the last event before they block, or 0 if they block right away.
+   */
+  virtual std::chrono::microseconds busyPoll() PURE;
+
+  /**
+   * @return std::chrono::microseconds how long the event loops of the workers may spend deleting
+   *         closed connections and other deferred deletions in one go, or 0 for no limit.
+   */
+  virtual std::chrono::microseconds deferredDeleteBudget() PURE;
+
+  /**
+   * @return const std::vector<uint32_t>& the CPUs to pin the workers to, in the order of the
+   *         workers, which wrap around if there are more workers than CPUs. Empty if the workers
+   *         are not pinned.
+   */
+  virtual const std::vector<uint32_t>& workerCpus() PURE;
+
+  /**
+   * @return bool whether the kernel hands the connections received on the CPU a worker is pinned
+   *         to to that worker's SO_REUSEPORT listen sockets.
+   */
+  virtual bool reusePortIncomingCpu() PURE;
+
+  /**
+   * @return uint64_t how many bytes of log messages may wait for the background thread which
+   *         writes them out, or 0 if messages are written out by the thread which logs them.
+   */
+  virtual uint64_t asyncLogBufferSize() PURE;
 };
 
 } // namespace Server
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * Watches the resources of the server (heap, buffers, connections and event loop lag), and
+ * decides which load shedding actions are in effect so that the server degrades under load
+ * instead of running out of memory. The actions can be queried from any thread.
+ */
+class OverloadManager {
+public:
+  virtual ~OverloadManager() {}
+
+  /**
+   * @return true if connections should be closed after their current request instead of being
+   *         kept alive.
+   */
+  virtual bool disableKeepalive() const PURE;
+
+  /**
+   * @return true if listeners have stopped accepting new connections.
+   */
+  virtual bool stopAcceptingConnections() const PURE;
+
+  /**
+   * @return true if new streams should be rejected with a 503.
+   */
+  virtual bool rejectNewStreams() const PURE;
+};
+
+} // namespace Server
+} // namespace Envoy
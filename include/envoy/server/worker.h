@@ -68,6 +68,17 @@ public:
    * TODO(mattklein123): Same comment about the addition of a completion as stopListener().
    */
   virtual void stopListeners() PURE;
+
+  /**
+   * Temporarily stop all listeners from accepting new connections, e.g. while the server is
+   * overloaded.
+   */
+  virtual void disableListeners() PURE;
+
+  /**
+   * Resume accepting new connections on all listeners after disableListeners().
+   */
+  virtual void enableListeners() PURE;
 };
 
 typedef std::unique_ptr<Worker> WorkerPtr;
@@ -82,6 +82,11 @@ public:
     std::array<uint8_t, 256 / 8> aes_key_; // AES256 key size, in bytes
   };
 
+  struct TlsCertificate {
+    std::string cert_chain_file_;
+    std::string private_key_file_;
+  };
+
   /**
    * @return True if client certificate is required, false otherwise.
    */
@@ -93,6 +98,12 @@ public:
    * are candidates for decrypting received tickets.
    */
   virtual const std::vector<SessionTicketKey>& sessionTicketKeys() const PURE;
+
+  /**
+   * @return The certificates to pick from by the server name a client indicates, after the one of
+   * certChainFile() and privateKeyFile(). That one is used when no other certificate matches.
+   */
+  virtual const std::vector<TlsCertificate>& sniCertificates() const PURE;
 };
 
 } // namespace Ssl
@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -65,19 +66,20 @@ class Metric {
 public:
   virtual ~Metric() {}
   /**
-   * Returns the full name of the Metric.
+   * Returns the full name of the Metric. Names are returned by value so that implementations can
+   * store them in a compact encoding.
    */
-  virtual const std::string& name() const PURE;
+  virtual std::string name() const PURE;
 
   /**
    * Returns a vector of configurable tags to identify this Metric.
    */
-  virtual const std::vector<Tag>& tags() const PURE;
+  virtual std::vector<Tag> tags() const PURE;
 
   /**
    * Returns the name of the Metric with the portions designated as tags removed.
    */
-  virtual const std::string& tagExtractedName() const PURE;
+  virtual std::string tagExtractedName() const PURE;
 };
 
 /**
@@ -135,6 +137,72 @@ public:
 
 typedef std::shared_ptr<Histogram> HistogramSharedPtr;
 
+/**
+ * Statistics of the values recorded into a histogram over some period.
+ */
+class HistogramStatistics {
+public:
+  virtual ~HistogramStatistics() {}
+
+  /**
+   * @return a human readable summary of the computed quantiles.
+   */
+  virtual std::string summary() const PURE;
+
+  /**
+   * @return the quantiles, in [0, 1], for which values are computed.
+   */
+  virtual const std::vector<double>& supportedQuantiles() const PURE;
+
+  /**
+   * @return the value at each of supportedQuantiles(), or NaN if no values were recorded. Values
+   *         are approximate, as they are computed from buckets.
+   */
+  virtual const std::vector<double>& computedQuantiles() const PURE;
+
+  /**
+   * @return the number of values recorded.
+   */
+  virtual uint64_t sampleCount() const PURE;
+
+  /**
+   * @return the sum of the values recorded.
+   */
+  virtual uint64_t sampleSum() const PURE;
+};
+
+/**
+ * A histogram whose values are recorded by each thread without locking and merged on the main
+ * thread when stats are flushed, rather than delivered to sinks one at a time.
+ */
+class ParentHistogram : public virtual Histogram {
+public:
+  virtual ~ParentHistogram() {}
+
+  /**
+   * Merge the values recorded by all threads since the last merge. Must be called on the main
+   * thread, as must the statistics accessors.
+   */
+  virtual void merge() PURE;
+
+  /**
+   * @return the statistics of the values recorded between the last two merges.
+   */
+  virtual const HistogramStatistics& intervalStatistics() const PURE;
+
+  /**
+   * @return the statistics of all the values merged so far.
+   */
+  virtual const HistogramStatistics& cumulativeStatistics() const PURE;
+
+  /**
+   * @return whether any values have been merged.
+   */
+  virtual bool used() const PURE;
+};
+
+typedef std::shared_ptr<ParentHistogram> ParentHistogramSharedPtr;
+
 /**
  * A sink for stats. Each sink is responsible for writing stats to a backing store.
  */
@@ -143,13 +211,14 @@ public:
   virtual ~Sink() {}
 
   /**
-   * This will be called before a sequence of flushCounter() and flushGauge() calls. Sinks can
-   * choose to optimize writing if desired with a paired endFlush() call.
+   * This will be called before a sequence of flushCounter(), flushGauge() and flushHistogram()
+   * calls. Sinks can choose to optimize writing if desired with a paired endFlush() call.
    */
   virtual void beginFlush() PURE;
 
   /**
-   * Flush a counter delta.
+   * Flush a counter delta. Only counters which were incremented since the previous flush are
+   * flushed.
    */
   virtual void flushCounter(const Counter& counter, uint64_t delta) PURE;
 
@@ -159,8 +228,15 @@ public:
   virtual void flushGauge(const Gauge& gauge, uint64_t value) PURE;
 
   /**
-   * This will be called after beginFlush(), some number of flushCounter(), and some number of
-   * flushGauge(). Sinks can use this to optimize writing if desired.
+   * Flush the statistics of a histogram. Its interval statistics cover the values recorded since
+   * the previous flush.
+   */
+  virtual void flushHistogram(const ParentHistogram& histogram) PURE;
+
+  /**
+   * This will be called after beginFlush(), some number of flushCounter(), some number of
+   * flushGauge() and some number of flushHistogram(). Sinks can use this to optimize writing if
+   * desired.
    */
   virtual void endFlush() PURE;
 
@@ -172,6 +248,33 @@ public:
 
 typedef std::unique_ptr<Sink> SinkPtr;
 
+/**
+ * A fixed set of counters and gauges which share a name prefix, such as the stats of a cluster.
+ * Each stat only keeps its name relative to the prefix: the full names are built when the store
+ * lists the stats, for flushing or for the admin endpoints, rather than for every stat up front.
+ */
+class StatsBlock {
+public:
+  virtual ~StatsBlock() {}
+
+  /**
+   * @return const std::string& the prefix of the names of all the stats of the block.
+   */
+  virtual const std::string& prefix() const PURE;
+
+  /**
+   * Call cb with each counter of the block.
+   */
+  virtual void forEachCounter(const std::function<void(Counter&)>& cb) PURE;
+
+  /**
+   * Call cb with each gauge of the block.
+   */
+  virtual void forEachGauge(const std::function<void(Gauge&)>& cb) PURE;
+};
+
+typedef std::shared_ptr<StatsBlock> StatsBlockSharedPtr;
+
 class Scope;
 typedef std::unique_ptr<Scope> ScopePtr;
 
@@ -222,10 +325,29 @@ public:
    */
   virtual std::list<CounterSharedPtr> counters() const PURE;
 
+  /**
+   * @return the counters which have been incremented since the last call, each once. Lets a flush
+   *         skip the counters which have not changed.
+   */
+  virtual std::list<CounterSharedPtr> dirtyCounters() PURE;
+
   /**
    * @return a list of all known gauges.
    */
   virtual std::list<GaugeSharedPtr> gauges() const PURE;
+
+  /**
+   * @return a list of all known histograms whose values are merged for flushing. Stores whose
+   *         histograms deliver each value to sinks as it is recorded return none.
+   */
+  virtual std::list<ParentHistogramSharedPtr> histograms() const PURE;
+
+  /**
+   * Add a block of stats, whose counters and gauges are then listed along with those of the
+   * store. The store only keeps a weak pointer: the stats of the block leave the store when its
+   * owner releases it.
+   */
+  virtual void addStatsBlock(StatsBlockSharedPtr block) PURE;
 };
 
 typedef std::unique_ptr<Store> StorePtr;
@@ -7,6 +7,8 @@
 #include "envoy/common/pure.h"
 #include "envoy/event/dispatcher.h"
 
+#include "common/common/assert.h"
+
 namespace Envoy {
 namespace ThreadLocal {
 
@@ -29,16 +31,21 @@ public:
   virtual ~Slot() {}
 
   /**
-   * @return ThreadLocalObjectSharedPtr a thread local object stored in the slot.
+   * @return ThreadLocalObjectSharedPtr& the thread local object stored in the slot. This refers to
+   *         the storage of the calling thread, so reading it takes no reference. Copy it to keep
+   *         the object past the next set().
    */
-  virtual ThreadLocalObjectSharedPtr get() PURE;
+  virtual ThreadLocalObjectSharedPtr& get() PURE;
 
   /**
    * This is a helper on top of get() that casts the object stored in the slot to the specified
-   * type. Since the slot only stores pointers to the base interface, dynamic_cast provides some
-   * level of protection via RTTI.
+   * type. It is called on the request path, so it neither copies the shared_ptr nor uses RTTI
+   * outside of debug builds, where dynamic_cast still checks the type.
    */
-  template <class T> T& getTyped() { return *std::dynamic_pointer_cast<T>(get()); }
+  template <class T> T& getTyped() {
+    ASSERT(dynamic_cast<T*>(get().get()) != nullptr);
+    return *static_cast<T*>(get().get());
+  }
 
   /**
    * Run a callback on all registered threads.
@@ -87,6 +94,20 @@ public:
    */
   virtual void registerThread(Event::Dispatcher& dispatcher, bool main_thread) PURE;
 
+  /**
+   * Start a batch of slot updates. Until the matching endBatch(), set() and runOnAllThreads() on
+   * any slot still run on the main thread right away, but what they would post to each worker is
+   * held back and posted as a single callback by endBatch(). Each worker thus applies all the
+   * updates of a batch, in order, without running anything else in between. Batches nest, and only
+   * the outermost endBatch() posts. Must be called on the main thread.
+   */
+  virtual void startBatch() PURE;
+
+  /**
+   * End a batch of slot updates started by startBatch().
+   */
+  virtual void endBatch() PURE;
+
   /**
    * This should be called by the main thread before any worker threads start to exit. This will
    * block TLS removal during slot destruction, given that worker threads are about to call
@@ -22,6 +22,15 @@
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * A TCP connection handed out by ClusterManager::pooledTcpConnForCluster().
+ */
+struct PooledTcpConnectionData {
+  Host::CreateConnectionData data_;
+  // Whether the connection was taken from the pool of established connections.
+  bool pooled_;
+};
+
 /**
  * Manages connection pools and load balancing for upstream clusters. The cluster manager is
  * persistent and shared among multiple ongoing requests/connections.
@@ -65,6 +74,14 @@ public:
    */
   virtual ThreadLocalCluster* get(const std::string& cluster) PURE;
 
+  /**
+   * @return uint64_t a counter, local to the calling thread, which changes whenever a cluster is
+   * updated or removed on this thread. A pointer returned by get() remains valid beyond the
+   * owning call for as long as this counter is unchanged, so a caller can keep it instead of
+   * looking up the cluster by name again.
+   */
+  virtual uint64_t threadLocalGeneration() PURE;
+
   /**
    * Allocate a load balanced HTTP connection pool for a cluster. This is *per-thread* so that
    * callers do not need to worry about per thread synchronization. The load balancing policy that
@@ -88,6 +105,14 @@ public:
   virtual Host::CreateConnectionData tcpConnForCluster(const std::string& cluster,
                                                        LoadBalancerContext* context) PURE;
 
+  /**
+   * Like tcpConnForCluster(), but hands out an established connection to the chosen host from the
+   * per-thread pool of idle connections when the cluster keeps one. A pooled connection is
+   * already connected, so the caller must not connect() it, and will see no Connected event.
+   */
+  virtual PooledTcpConnectionData pooledTcpConnForCluster(const std::string& cluster,
+                                                          LoadBalancerContext* context) PURE;
+
   /**
    * Returns a client that can be used to make async HTTP calls against the given cluster. The
    * client may be backed by a connection pool or by a multiplexed connection. The cluster manager
@@ -17,19 +17,26 @@ namespace Upstream {
  * All per host stats. @see stats_macros.h
  *
  * {rq_success, rq_error} have specific semantics driven by the needs of EDS load reporting. See
- * envoy.api.v2.UpstreamLocalityStats for the definitions of success/error. These are latched by
- * LoadStatsReporter, independent of the normal stats sink flushing.
+ * envoy.api.v2.UpstreamLocalityStats for the definitions of success/error. The load report stats
+ * of the hosts are also totalled per locality as they are updated, and LoadStatsReporter latches
+ * the totals, independent of the normal stats sink flushing.
  */
 // clang-format off
-#define ALL_HOST_STATS(COUNTER, GAUGE)                                                             \
+#define ALL_HOST_BASE_STATS(COUNTER, GAUGE)                                                        \
   COUNTER(cx_total)                                                                                \
   GAUGE  (cx_active)                                                                               \
   COUNTER(cx_connect_fail)                                                                         \
   COUNTER(rq_total)                                                                                \
-  COUNTER(rq_timeout)                                                                              \
+  COUNTER(rq_timeout)
+
+#define ALL_HOST_LOAD_STATS(COUNTER, GAUGE)                                                        \
   COUNTER(rq_success)                                                                              \
   COUNTER(rq_error)                                                                                \
   GAUGE  (rq_active)
+
+#define ALL_HOST_STATS(COUNTER, GAUGE)                                                             \
+  ALL_HOST_BASE_STATS(COUNTER, GAUGE)                                                              \
+  ALL_HOST_LOAD_STATS(COUNTER, GAUGE)
 // clang-format on
 
 /**
@@ -39,6 +46,13 @@ struct HostStats {
   ALL_HOST_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * The load report stats of all the hosts of a cluster in one locality. @see stats_macros.h
+ */
+struct LocalityLoadStats {
+  ALL_HOST_LOAD_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
 class ClusterInfo;
 
 /**
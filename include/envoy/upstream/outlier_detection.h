@@ -61,6 +61,21 @@ public:
    *         or the cluster did not have enough hosts to run through success rate outlier ejection.
    */
   virtual double successRate() const PURE;
+
+  /**
+   * @return the peak exponentially weighted moving average of the response times of the host in
+   *         milliseconds. A response time above the average replaces it, so the average follows a
+   *         host which slows down at once. -1 means that no response time was added in the last
+   *         interval or that outlier detection is not configured for the cluster.
+   */
+  virtual double peakEwmaResponseTime() const PURE;
+
+  /**
+   * @return the 99th percentile of the response times of the host in the last calculated
+   *         interval, in milliseconds. -1 means that the host did not have enough request volume
+   *         to calculate it or that latency outlier ejection is not enabled for the cluster.
+   */
+  virtual double p99ResponseTime() const PURE;
 };
 
 typedef std::unique_ptr<DetectorHostMonitor> DetectorHostMonitorPtr;
@@ -99,11 +114,27 @@ public:
    *         proceed with success rate based outlier ejection.
    */
   virtual double successRateEjectionThreshold() const PURE;
+
+  /**
+   * Returns the average of the 99th percentile response times of the hosts in the Detector for the
+   * last aggregation interval.
+   * @return the average in milliseconds, or -1 if there were not enough hosts with enough request
+   *         volume to proceed with latency based outlier ejection.
+   */
+  virtual double p99ResponseTimeAverage() const PURE;
+
+  /**
+   * Returns the latency threshold used in the last interval. Hosts whose 99th percentile response
+   * time is above the threshold are ejected.
+   * @return the threshold in milliseconds, or -1 if there were not enough hosts with enough request
+   *         volume to proceed with latency based outlier ejection.
+   */
+  virtual double p99ResponseTimeEjectionThreshold() const PURE;
 };
 
 typedef std::shared_ptr<Detector> DetectorSharedPtr;
 
-enum class EjectionType { Consecutive5xx, SuccessRate };
+enum class EjectionType { Consecutive5xx, SuccessRate, Latency };
 
 /**
  * Sink for outlier detection event logs.
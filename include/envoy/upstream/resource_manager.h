@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 
@@ -73,6 +74,13 @@ public:
    * @return Resource& active retries.
    */
   virtual Resource& retries() PURE;
+
+  /**
+   * Record the latency of a request which completed against the resources. An implementation may
+   * adapt its request limit to the latencies.
+   * @param latency supplies the time from the request being sent to its response completing.
+   */
+  virtual void onRequestLatency(std::chrono::microseconds latency) PURE;
 };
 
 } // namespace Upstream
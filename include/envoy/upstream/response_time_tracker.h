@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+
+#include "envoy/common/optional.h"
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Tracks the response times of a cluster as seen by one worker, to estimate their quantiles.
+ * Recent response times weigh more than old ones, so that the estimates follow the cluster.
+ */
+class ResponseTimeTracker {
+public:
+  virtual ~ResponseTimeTracker() {}
+
+  /**
+   * Record the response time of a request to the cluster.
+   * @param response_time supplies the time from the end of the request to the end of the response.
+   */
+  virtual void recordResponseTime(std::chrono::milliseconds response_time) PURE;
+
+  /**
+   * @param quantile supplies the quantile, between 0 and 1.
+   * @return Optional<std::chrono::milliseconds> the estimated response time at the quantile, or
+   *         an invalid Optional if too few response times have been recorded for an estimate.
+   */
+  virtual Optional<std::chrono::milliseconds> responseTimeQuantile(double quantile) PURE;
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "envoy/http/conn_pool.h"
+#include "envoy/upstream/load_balancer.h"
+#include "envoy/upstream/resource_manager.h"
+#include "envoy/upstream/response_time_tracker.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -29,6 +34,21 @@ public:
    * @return LoadBalancer& the backing load balancer.
    */
   virtual LoadBalancer& loadBalancer() PURE;
+
+  /**
+   * @return ResponseTimeTracker& the response times of the cluster on this worker.
+   */
+  virtual ResponseTimeTracker& responseTimes() PURE;
+
+  /**
+   * Allocate a load balanced HTTP connection pool for this cluster. This is the same as
+   * ClusterManager::httpConnPoolForCluster() without looking up the cluster by name again.
+   * @param priority the priority of the request.
+   * @param context the load balancer context of the request.
+   * @return Http::ConnectionPool::Instance* the pool or nullptr if no host is available.
+   */
+  virtual Http::ConnectionPool::Instance* httpConnPool(ResourcePriority priority,
+                                                       LoadBalancerContext* context) PURE;
 };
 
 } // namespace Upstream
@@ -117,6 +117,10 @@ public:
 };
 
 typedef std::shared_ptr<const Host> HostConstSharedPtr;
+typedef std::shared_ptr<std::vector<HostSharedPtr>> HostVectorSharedPtr;
+typedef std::shared_ptr<const std::vector<HostSharedPtr>> HostVectorConstSharedPtr;
+typedef std::shared_ptr<std::vector<std::vector<HostSharedPtr>>> HostListsSharedPtr;
+typedef std::shared_ptr<const std::vector<std::vector<HostSharedPtr>>> HostListsConstSharedPtr;
 
 /**
  * Base host set interface. This is used both for clusters, as well as per thread/worker host sets
@@ -168,6 +172,24 @@ public:
    * @return same as hostsPerLocality but only contains healthy hosts.
    */
   virtual const std::vector<std::vector<HostSharedPtr>>& healthyHostsPerLocality() const PURE;
+
+  /**
+   * @return for each locality of healthyHostsPerLocality(), its share of the healthy hosts scaled
+   *         by 10000. This is computed once per membership update, so that all of the load
+   *         balancers which route based on the localities of the set can read it without
+   *         recomputing it.
+   */
+  virtual const std::vector<uint64_t>& healthyLocalityPercentages() const PURE;
+
+  /**
+   * The vectors behind hosts(), healthyHosts(), hostsPerLocality() and healthyHostsPerLocality().
+   * A membership update replaces the vectors rather than modifying them, so they can be shared
+   * with other threads without being copied.
+   */
+  virtual HostVectorConstSharedPtr hostsPtr() const PURE;
+  virtual HostVectorConstSharedPtr healthyHostsPtr() const PURE;
+  virtual HostListsConstSharedPtr hostsPerLocalityPtr() const PURE;
+  virtual HostListsConstSharedPtr healthyHostsPerLocalityPtr() const PURE;
 };
 
 /**
@@ -211,7 +233,10 @@ public:
   GAUGE    (upstream_cx_tx_bytes_buffered)                                                         \
   COUNTER  (upstream_cx_protocol_error)                                                            \
   COUNTER  (upstream_cx_max_requests)                                                              \
+  COUNTER  (upstream_cx_idle_timeout)                                                              \
   COUNTER  (upstream_cx_none_healthy)                                                              \
+  COUNTER  (upstream_cx_pool_hit)                                                                  \
+  COUNTER  (upstream_cx_pool_miss)                                                                 \
   COUNTER  (upstream_rq_total)                                                                     \
   GAUGE    (upstream_rq_active)                                                                    \
   COUNTER  (upstream_rq_pending_total)                                                             \
@@ -219,6 +244,7 @@ public:
   COUNTER  (upstream_rq_pending_failure_eject)                                                     \
   GAUGE    (upstream_rq_pending_active)                                                            \
   COUNTER  (upstream_rq_cancelled)                                                                 \
+  COUNTER  (upstream_rq_pipelined)                                                                 \
   COUNTER  (upstream_rq_maintenance_mode)                                                          \
   COUNTER  (upstream_rq_timeout)                                                                   \
   COUNTER  (upstream_rq_per_try_timeout)                                                           \
@@ -227,6 +253,9 @@ public:
   COUNTER  (upstream_rq_retry)                                                                     \
   COUNTER  (upstream_rq_retry_success)                                                             \
   COUNTER  (upstream_rq_retry_overflow)                                                            \
+  COUNTER  (upstream_rq_hedge)                                                                     \
+  COUNTER  (upstream_rq_hedge_win)                                                                 \
+  COUNTER  (upstream_rq_shadow_overflow)                                                           \
   COUNTER  (upstream_flow_control_paused_reading_total)                                            \
   COUNTER  (upstream_flow_control_resumed_reading_total)                                           \
   COUNTER  (upstream_flow_control_backed_up_total)                                                 \
@@ -359,6 +388,13 @@ public:
    */
   virtual ClusterLoadReportStats& loadReportStats() const PURE;
 
+  /**
+   * @param locality supplies a locality of the hosts of the cluster.
+   * @return LocalityLoadStats& the totals of the load report stats of the cluster's hosts in the
+   *         locality. The hosts add to them as they update their own stats.
+   */
+  virtual LocalityLoadStats& localityLoadStats(const envoy::api::v2::Locality& locality) const PURE;
+
   /**
    * Returns an optional source address for upstream connections to bind to.
    *
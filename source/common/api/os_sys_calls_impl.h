@@ -11,6 +11,7 @@ public:
   int bind(int sockfd, const sockaddr* addr, socklen_t addrlen) override;
   int open(const std::string& full_path, int flags, int mode) override;
   ssize_t write(int fd, const void* buffer, size_t num_bytes) override;
+  ssize_t writev(int fd, const iovec* iov, int num_iov) override;
   int close(int fd) override;
   int shmOpen(const char* name, int oflag, mode_t mode) override;
   int shmUnlink(const char* name) override;
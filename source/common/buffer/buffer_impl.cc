@@ -1,30 +1,99 @@
 #include "common/buffer/buffer_impl.h"
 
+#include <sys/uio.h>
+
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "common/common/assert.h"
 
-#include "event2/buffer.h"
-
 namespace Envoy {
 namespace Buffer {
 
-// RawSlice is the same structure as evbuffer_iovec. This was put into place to avoid leaking
-// libevent into most code since we will likely replace evbuffer with our own implementation at
-// some point. However, we can avoid a bunch of copies since the structure is the same.
-static_assert(sizeof(RawSlice) == sizeof(evbuffer_iovec), "RawSlice != evbuffer_iovec");
-static_assert(offsetof(RawSlice, mem_) == offsetof(evbuffer_iovec, iov_base),
-              "RawSlice != evbuffer_iovec");
-static_assert(offsetof(RawSlice, len_) == offsetof(evbuffer_iovec, iov_len),
-              "RawSlice != evbuffer_iovec");
+// RawSlice is the same structure as iovec. This allows read() and write() to hand slices directly
+// to readv() and writev().
+static_assert(sizeof(RawSlice) == sizeof(iovec), "RawSlice != iovec");
+static_assert(offsetof(RawSlice, mem_) == offsetof(iovec, iov_base), "RawSlice != iovec");
+static_assert(offsetof(RawSlice, len_) == offsetof(iovec, iov_len), "RawSlice != iovec");
+
+namespace {
+// The maximum number of slices handed to a single readv()/writev() call.
+const uint64_t MaxIoSlices = 16;
+} // namespace
+
+const uint64_t Slice::DefaultSlabSize;
+
+Slice::Slice(uint64_t min_capacity)
+    : data_(0), reservable_(0), owns_tail_(true), external_(false) {
+  base_ = SlabPool::allocate(min_capacity, capacity_);
+}
+
+Slice::Slice(BufferFragment& fragment)
+    : base_(static_cast<uint8_t*>(const_cast<void*>(fragment.data())),
+            [&fragment](uint8_t*) -> void { fragment.done(); }),
+      capacity_(fragment.size()), data_(0), reservable_(fragment.size()), owns_tail_(false),
+      external_(true) {}
 
-void OwnedImpl::add(const void* data, uint64_t size) { evbuffer_add(buffer_.get(), data, size); }
+Slice::Slice(const std::shared_ptr<uint8_t>& base, uint64_t capacity, uint64_t data,
+             uint64_t reservable, bool external)
+    : base_(base), capacity_(capacity), data_(data), reservable_(reservable), owns_tail_(false),
+      external_(external) {}
+
+Slice Slice::shareFront(uint64_t size) const {
+  ASSERT(size <= dataSize());
+  return Slice(base_, capacity_, data_, data_ + size, external_);
+}
+
+uint64_t Slice::append(const void* data, uint64_t size) {
+  const uint64_t copy_size = std::min(size, reservableSize());
+  memcpy(reservableStart(), data, copy_size);
+  reservable_ += copy_size;
+  return copy_size;
+}
+
+uint64_t Slice::prepend(const void* data, uint64_t size) {
+  const uint64_t copy_size = std::min(size, headroomSize());
+  data_ -= copy_size;
+  memcpy(base_.get() + data_, static_cast<const uint8_t*>(data) + size - copy_size, copy_size);
+  return copy_size;
+}
 
-void OwnedImpl::add(const std::string& data) {
-  evbuffer_add(buffer_.get(), data.c_str(), data.size());
+void Slice::commit(uint64_t size) {
+  ASSERT(size <= reservableSize());
+  reservable_ += size;
 }
 
+void Slice::drain(uint64_t size) {
+  ASSERT(size <= dataSize());
+  data_ += size;
+}
+
+void Slice::moveToEnd() {
+  ASSERT(dataSize() == 0);
+  data_ = reservable_ = capacity_;
+}
+
+void OwnedImpl::add(const void* data, uint64_t size) {
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  length_ += size;
+  if (!slices_.empty()) {
+    const uint64_t copied = slices_.back().append(src, size);
+    src += copied;
+    size -= copied;
+  }
+
+  if (size > 0) {
+    // Size the slab to the data being added, but let it grow with the buffer so that a buffer
+    // built from many small writes does not turn into a long chain of small slices.
+    slices_.emplace_back(std::max(size, std::min(length_, Slice::DefaultSlabSize)));
+    slices_.back().append(src, size);
+  }
+}
+
+void OwnedImpl::add(const std::string& data) { add(data.c_str(), data.size()); }
+
 void OwnedImpl::add(const Instance& data) {
   uint64_t num_slices = data.getRawSlices(nullptr, 0);
   RawSlice slices[num_slices];
@@ -34,90 +103,357 @@ void OwnedImpl::add(const Instance& data) {
   }
 }
 
+void OwnedImpl::addShared(const Instance& data) {
+  // See move() for why we do the static cast.
+  const OwnedImpl& other = static_cast<const OwnedImpl&>(data);
+  for (const Slice& slice : other.slices_) {
+    appendSlice(slice.shareFront(slice.dataSize()));
+  }
+}
+
+void OwnedImpl::addBufferFragment(BufferFragment& fragment) {
+  if (fragment.size() == 0) {
+    fragment.done();
+    return;
+  }
+
+  appendSlice(Slice(fragment));
+}
+
+void OwnedImpl::prepend(const std::string& data) {
+  uint64_t size = data.size();
+  length_ += size;
+  if (!slices_.empty()) {
+    size -= slices_.front().prepend(data.c_str(), size);
+  }
+
+  if (size > 0) {
+    slices_.emplace_front(size);
+    slices_.front().moveToEnd();
+    slices_.front().prepend(data.c_str(), size);
+  }
+}
+
+void OwnedImpl::prepend(Instance& data) {
+  OwnedImpl& other = static_cast<OwnedImpl&>(data);
+  while (!other.slices_.empty()) {
+    if (other.slices_.back().dataSize() > 0) {
+      slices_.emplace_front(std::move(other.slices_.back()));
+    }
+    other.slices_.pop_back();
+  }
+
+  length_ += other.length_;
+  other.length_ = 0;
+  other.postProcess();
+}
+
 void OwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
-  int rc =
-      evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(rc == 0);
-  UNREFERENCED_PARAMETER(rc);
+  if (num_iovecs == 0) {
+    return;
+  }
+
+  // Reserved space always lives in the trailing slices. Find the slice that the first iovec
+  // refers to by walking back from the end, then commit each iovec into successive slices.
+  auto it = slices_.end();
+  while (it != slices_.begin()) {
+    --it;
+    if (it->reservableStart() == iovecs[0].mem_) {
+      break;
+    }
+  }
+
+  for (uint64_t i = 0; i < num_iovecs; i++, ++it) {
+    ASSERT(it != slices_.end() && it->reservableStart() == iovecs[i].mem_);
+    it->commit(iovecs[i].len_);
+    length_ += iovecs[i].len_;
+  }
 }
 
 void OwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
   ASSERT(start + size <= length());
 
-  evbuffer_ptr start_ptr;
-  int rc = evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET);
-  ASSERT(rc != -1);
-  UNREFERENCED_PARAMETER(rc);
+  uint8_t* dest = static_cast<uint8_t*>(data);
+  for (const Slice& slice : slices_) {
+    if (size == 0) {
+      break;
+    }
 
-  ev_ssize_t copied = evbuffer_copyout_from(buffer_.get(), &start_ptr, data, size);
-  ASSERT(static_cast<uint64_t>(copied) == size);
-  UNREFERENCED_PARAMETER(copied);
+    const uint64_t slice_size = slice.dataSize();
+    if (start >= slice_size) {
+      start -= slice_size;
+      continue;
+    }
+
+    const uint64_t copy_size = std::min(slice_size - start, size);
+    memcpy(dest, slice.data() + start, copy_size);
+    dest += copy_size;
+    size -= copy_size;
+    start = 0;
+  }
 }
 
-void OwnedImpl::drain(uint64_t size) {
+void OwnedImpl::drain(uint64_t size) { drainImpl(size); }
+
+void OwnedImpl::drainImpl(uint64_t size) {
   ASSERT(size <= length());
-  int rc = evbuffer_drain(buffer_.get(), size);
-  ASSERT(rc == 0);
-  UNREFERENCED_PARAMETER(rc);
+  length_ -= size;
+  while (size > 0) {
+    Slice& front = slices_.front();
+    const uint64_t slice_size = front.dataSize();
+    if (size < slice_size) {
+      front.drain(size);
+      return;
+    }
+
+    size -= slice_size;
+    // Fully drained slices are released even if they are the last one, so that an idle buffer
+    // does not pin a slab. Refilling it takes a slab from the thread's SlabPool free list.
+    slices_.pop_front();
+  }
 }
 
 uint64_t OwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
-  return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
-                       out_size);
-}
+  uint64_t num_slices = 0;
+  for (const Slice& slice : slices_) {
+    if (slice.dataSize() == 0) {
+      continue;
+    }
 
-uint64_t OwnedImpl::length() const { return evbuffer_get_length(buffer_.get()); }
+    if (num_slices < out_size) {
+      out[num_slices].mem_ = slice.data();
+      out[num_slices].len_ = slice.dataSize();
+    }
+    num_slices++;
+  }
+
+  return num_slices;
+}
 
 void* OwnedImpl::linearize(uint32_t size) {
   ASSERT(size <= length());
-  return evbuffer_pullup(buffer_.get(), size);
+  while (!slices_.empty() && slices_.front().dataSize() == 0) {
+    slices_.pop_front();
+  }
+
+  if (slices_.empty()) {
+    return nullptr;
+  }
+
+  if (slices_.front().dataSize() >= size) {
+    return slices_.front().data();
+  }
+
+  Slice linearized(size);
+  linearized.commit(size);
+  copyOut(0, size, linearized.data());
+  drainImpl(size);
+  length_ += size;
+  slices_.emplace_front(std::move(linearized));
+  return slices_.front().data();
+}
+
+void OwnedImpl::appendSlice(Slice&& slice) {
+  const uint64_t slice_size = slice.dataSize();
+  if (slice_size == 0) {
+    return;
+  }
+
+  length_ += slice_size;
+  // Drop a trailing empty slice so that chains do not accumulate holes.
+  if (!slices_.empty() && slices_.back().dataSize() == 0) {
+    slices_.pop_back();
+  }
+  slices_.emplace_back(std::move(slice));
 }
 
 void OwnedImpl::move(Instance& rhs) {
   // We do the static cast here because in practice we only have one buffer implementation right
-  // now and this is safe. Using the evbuffer move routines require having access to both evbuffers.
-  // This is a reasonable compromise in a high performance path where we want to maintain an
-  // abstraction in case we get rid of evbuffer later.
-  int rc = evbuffer_add_buffer(buffer_.get(), static_cast<LibEventInstance&>(rhs).buffer().get());
-  ASSERT(rc == 0);
-  UNREFERENCED_PARAMETER(rc);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  // now and this is safe. This is a reasonable compromise in a high performance path where we want
+  // to maintain an abstraction in case we add other buffer implementations later.
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  while (!other.slices_.empty()) {
+    appendSlice(std::move(other.slices_.front()));
+    other.slices_.pop_front();
+  }
+
+  other.length_ = 0;
+  other.postProcess();
 }
 
 void OwnedImpl::move(Instance& rhs, uint64_t length) {
   // See move() above for why we do the static cast.
-  int rc = evbuffer_remove_buffer(static_cast<LibEventInstance&>(rhs).buffer().get(), buffer_.get(),
-                                  length);
-  ASSERT(static_cast<uint64_t>(rc) == length);
-  UNREFERENCED_PARAMETER(rc);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  ASSERT(length <= other.length());
+  while (length > 0) {
+    Slice& front = other.slices_.front();
+    const uint64_t slice_size = front.dataSize();
+    if (length < slice_size) {
+      // Share the front of the slab rather than copying the partial slice.
+      appendSlice(front.shareFront(length));
+      other.drainImpl(length);
+      break;
+    }
+
+    appendSlice(std::move(front));
+    other.slices_.pop_front();
+    other.length_ -= slice_size;
+    length -= slice_size;
+  }
+
+  other.postProcess();
 }
 
 int OwnedImpl::read(int fd, uint64_t max_length) {
-  return evbuffer_read(buffer_.get(), fd, max_length);
+  if (max_length == 0) {
+    return 0;
+  }
+
+  RawSlice iovecs[2];
+  const uint64_t num_iovecs = reserve(max_length, iovecs, 2);
+  // Never read more than asked for, even if reserve() handed back more space.
+  uint64_t remaining = max_length;
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    iovecs[i].len_ = std::min<uint64_t>(iovecs[i].len_, remaining);
+    remaining -= iovecs[i].len_;
+  }
+
+  const ssize_t rc = ::readv(fd, reinterpret_cast<iovec*>(iovecs), num_iovecs);
+  if (rc <= 0) {
+    return rc;
+  }
+
+  uint64_t bytes_to_commit = rc;
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    iovecs[i].len_ = std::min<uint64_t>(iovecs[i].len_, bytes_to_commit);
+    bytes_to_commit -= iovecs[i].len_;
+  }
+
+  commit(iovecs, num_iovecs);
+  return rc;
 }
 
 uint64_t OwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
-  uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
-                                        reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(ret >= 1);
-  return ret;
+  ASSERT(num_iovecs > 0);
+  if (length == 0) {
+    return 0;
+  }
+
+  uint64_t num_used = 0;
+  uint64_t bytes_remaining = length;
+  if (!slices_.empty() && slices_.back().reservableSize() > 0 &&
+      (num_iovecs > 1 || slices_.back().reservableSize() >= length)) {
+    Slice& tail = slices_.back();
+    iovecs[0].mem_ = tail.reservableStart();
+    iovecs[0].len_ = tail.reservableSize();
+    bytes_remaining -= std::min(bytes_remaining, iovecs[0].len_);
+    num_used++;
+  }
+
+  if (bytes_remaining > 0) {
+    ASSERT(num_used < num_iovecs);
+    // Any trailing empty slice that could not satisfy the request is replaced.
+    if (num_used == 0 && !slices_.empty() && slices_.back().dataSize() == 0) {
+      slices_.pop_back();
+    }
+    slices_.emplace_back(bytes_remaining);
+    iovecs[num_used].mem_ = slices_.back().reservableStart();
+    iovecs[num_used].len_ = slices_.back().reservableSize();
+    num_used++;
+  }
+
+  return num_used;
 }
 
 ssize_t OwnedImpl::search(const void* data, uint64_t size, size_t start) const {
-  evbuffer_ptr start_ptr;
-  if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
+  if (start + size > length()) {
     return -1;
   }
 
-  evbuffer_ptr result_ptr =
-      evbuffer_search(buffer_.get(), static_cast<const char*>(data), size, &start_ptr);
-  return result_ptr.pos;
+  const uint8_t* needle = static_cast<const uint8_t*>(data);
+  if (size == 0) {
+    return start;
+  }
+
+  // Walk each slice looking for the first byte of the needle, then compare the rest of the needle
+  // across slice boundaries if need be.
+  size_t offset = 0;
+  for (auto it = slices_.begin(); it != slices_.end(); ++it) {
+    const uint64_t slice_size = it->dataSize();
+    if (start >= offset + slice_size) {
+      offset += slice_size;
+      continue;
+    }
+
+    const uint8_t* slice_data = it->data();
+    for (uint64_t i = start - offset; i < slice_size;) {
+      const uint8_t* first = static_cast<const uint8_t*>(
+          memchr(slice_data + i, needle[0], slice_size - i));
+      if (first == nullptr) {
+        break;
+      }
+      i = first - slice_data;
+      if (offset + i + size > length()) {
+        return -1;
+      }
+
+      // Compare the remainder of the needle, possibly across subsequent slices.
+      uint64_t matched = 0;
+      auto match_it = it;
+      uint64_t match_pos = i;
+      while (matched < size) {
+        const uint64_t match_slice_size = match_it->dataSize();
+        if (match_pos == match_slice_size) {
+          ++match_it;
+          match_pos = 0;
+          continue;
+        }
+
+        const uint64_t compare_size = std::min(size - matched, match_slice_size - match_pos);
+        if (memcmp(match_it->data() + match_pos, needle + matched, compare_size) != 0) {
+          break;
+        }
+        matched += compare_size;
+        match_pos += compare_size;
+      }
+
+      if (matched == size) {
+        return offset + i;
+      }
+      i++;
+    }
+
+    offset += slice_size;
+    start = offset;
+  }
+
+  return -1;
+}
+
+void OwnedImpl::shrink() {
+  if (length_ > 0) {
+    return;
+  }
+
+  // Swap rather than clear() so that the deque's own blocks are released as well.
+  std::deque<Slice>().swap(slices_);
 }
 
-int OwnedImpl::write(int fd) { return evbuffer_write(buffer_.get(), fd); }
+int OwnedImpl::write(int fd) {
+  RawSlice iovecs[MaxIoSlices];
+  const uint64_t num_slices = std::min(getRawSlices(iovecs, MaxIoSlices), MaxIoSlices);
+  if (num_slices == 0) {
+    return 0;
+  }
+
+  const ssize_t rc = ::writev(fd, reinterpret_cast<iovec*>(iovecs), num_slices);
+  if (rc > 0) {
+    drainImpl(rc);
+  }
+  return rc;
+}
 
-OwnedImpl::OwnedImpl() : buffer_(evbuffer_new()) {}
+OwnedImpl::OwnedImpl() {}
 
 OwnedImpl::OwnedImpl(const std::string& data) : OwnedImpl() { add(data); }
 
@@ -1,58 +1,157 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
 
 #include "envoy/buffer/buffer.h"
 
-#include "common/event/libevent.h"
+#include "common/buffer/slab_pool.h"
 
 namespace Envoy {
 namespace Buffer {
 
-class LibEventInstance : public Instance {
+/**
+ * A view into a region of a refcounted, fixed-size slab of memory allocated from SlabPool. The
+ * memory layout of a slice is:
+ *
+ *   |<- headroom ->|<------ data ------>|<-- reservable -->|
+ *   base_          base_ + data_        base_ + reservable_ base_ + capacity_
+ *
+ * Several slices (possibly in different buffers) may point into the same slab. This allows
+ * partial moves between buffers without copying. Only one slice ever owns the reservable tail of
+ * a slab, and headroom can only be written when the slab is not shared, so that no slice can
+ * modify data that is visible through another slice.
+ */
+class Slice {
 public:
-  // Allows access into the underlying buffer for move() optimizations.
-  virtual Event::Libevent::BufferPtr& buffer() PURE;
-  // Called after accessing the memory in buffer() directly to allow any post-processing.
-  virtual void postProcess() PURE;
+  /**
+   * Largest slab allocated for data added in small pieces. New slabs are sized to the data being
+   * added and grow with the buffer up to this size. Data larger than this gets a slab from a
+   * bigger size class (see SlabPool).
+   */
+  static const uint64_t DefaultSlabSize = 16384;
+
+  /**
+   * Allocate a new, empty, exclusively owned slab.
+   * @param min_capacity supplies the minimum amount of reservable space the slab must have.
+   */
+  explicit Slice(uint64_t min_capacity);
+
+  /**
+   * Wrap the data of an external fragment. The slice has no headroom or reservable space, and
+   * fragment.done() is called once the last slice referencing the data is destroyed.
+   */
+  explicit Slice(BufferFragment& fragment);
+
+  /**
+   * @return a new slice that shares the first size bytes of this slice's data. The new slice has
+   *         no reservable space. The caller is expected to drain() the same number of bytes from
+   *         this slice.
+   */
+  Slice shareFront(uint64_t size) const;
+
+  uint8_t* data() const { return base_.get() + data_; }
+  uint64_t dataSize() const { return reservable_ - data_; }
+  uint8_t* reservableStart() const { return base_.get() + reservable_; }
+  uint64_t reservableSize() const { return owns_tail_ ? capacity_ - reservable_ : 0; }
+  uint64_t headroomSize() const { return !external_ && base_.use_count() == 1 ? data_ : 0; }
+
+  /**
+   * Copy as much of the supplied data as fits into the reservable space.
+   * @return the number of bytes copied.
+   */
+  uint64_t append(const void* data, uint64_t size);
+
+  /**
+   * Copy as much of the tail end of the supplied data as fits into the headroom.
+   * @return the number of bytes copied.
+   */
+  uint64_t prepend(const void* data, uint64_t size);
+
+  /**
+   * Mark size bytes of the reservable space as data.
+   */
+  void commit(uint64_t size);
+
+  /**
+   * Remove size bytes from the front of the data.
+   */
+  void drain(uint64_t size);
+
+  /**
+   * Reposition an empty slice so that all of its capacity is headroom. Used when a new slab is
+   * allocated specifically to hold prepended data.
+   */
+  void moveToEnd();
+
+private:
+  Slice(const std::shared_ptr<uint8_t>& base, uint64_t capacity, uint64_t data,
+        uint64_t reservable, bool external);
+
+  std::shared_ptr<uint8_t> base_;
+  uint64_t capacity_;
+  uint64_t data_;
+  uint64_t reservable_;
+  bool owns_tail_;
+  // Set if base_ points at a BufferFragment rather than at a slab.
+  bool external_;
 };
 
 /**
- * Wraps an allocated and owned evbuffer.
- *
- * Note that due to the internals of move() accessing buffer(), OwnedImpl is not
- * compatible with non-LibEventInstance buffers.
+ * A buffer made of a chain of slices. Data added to the buffer is copied into slab memory owned
+ * by the buffer, except for buffer fragments which are referenced in place. Moving data between
+ * OwnedImpl instances transfers slices without copying data.
  */
-class OwnedImpl : public LibEventInstance {
+class OwnedImpl : public Instance {
 public:
   OwnedImpl();
   OwnedImpl(const std::string& data);
   OwnedImpl(const Instance& data);
   OwnedImpl(const void* data, uint64_t size);
 
-  // LibEventInstance
+  // Buffer::Instance
   void add(const void* data, uint64_t size) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void addBufferFragment(BufferFragment& fragment) override;
+  void prepend(const std::string& data) override;
+  void prepend(Instance& data) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
   void copyOut(size_t start, uint64_t size, void* data) const override;
   void drain(uint64_t size) override;
   uint64_t getRawSlices(RawSlice* out, uint64_t out_size) const override;
-  uint64_t length() const override;
+  uint64_t length() const override { return length_; }
   void* linearize(uint32_t size) override;
   void move(Instance& rhs) override;
   void move(Instance& rhs, uint64_t length) override;
   int read(int fd, uint64_t max_length) override;
   uint64_t reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) override;
   ssize_t search(const void* data, uint64_t size, size_t start) const override;
+  void shrink() override;
   int write(int fd) override;
-  void postProcess() override {}
 
-  Event::Libevent::BufferPtr& buffer() override { return buffer_; }
+  /**
+   * Add the data of another buffer by sharing its slices rather than copying the data. Neither
+   * buffer can modify the shared data, and it stays valid for as long as either buffer references
+   * it. Unlike add(), this does not go through the watermark accounting of subclasses.
+   * @param data supplies the buffer to share the data of.
+   */
+  void addShared(const Instance& data);
+
+  /**
+   * Called on a buffer after data has been removed from it by another buffer's move(). Allows
+   * subclasses which track the buffer length to do any post-processing.
+   */
+  virtual void postProcess() {}
 
 private:
-  Event::Libevent::BufferPtr buffer_;
+  void appendSlice(Slice&& slice);
+  void drainImpl(uint64_t size);
+
+  std::deque<Slice> slices_;
+  uint64_t length_{0};
 };
 
 } // namespace Buffer
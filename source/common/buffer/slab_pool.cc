@@ -0,0 +1,117 @@
+#include "common/buffer/slab_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/memory/stats.h"
+
+namespace Envoy {
+namespace Buffer {
+
+const uint64_t SlabPool::MinSlabSize;
+const uint64_t SlabPool::MaxPooledSlabSize;
+const uint64_t SlabPool::NumSizeClasses;
+const uint64_t SlabPool::MaxCachedSlabsPerClass;
+
+static_assert(SlabPool::MaxPooledSlabSize == SlabPool::MinSlabSize
+                                                 << (SlabPool::NumSizeClasses - 1),
+              "size classes do not cover MinSlabSize to MaxPooledSlabSize");
+
+namespace {
+
+// Set once the calling thread's cache has been destroyed during thread exit. Slabs released after
+// that point (e.g. by other thread local objects holding buffers) are freed directly. This is
+// trivially destructible so it remains valid for the whole life of the thread.
+thread_local bool cache_destroyed = false;
+
+class ThreadLocalCache {
+public:
+  ~ThreadLocalCache() {
+    clear();
+    cache_destroyed = true;
+  }
+
+  std::vector<uint8_t*>& freeList(uint64_t size_class) { return free_lists_[size_class]; }
+
+  uint64_t size() const {
+    uint64_t total = 0;
+    for (const auto& free_list : free_lists_) {
+      total += free_list.size();
+    }
+    return total;
+  }
+
+  void clear() {
+    for (auto& free_list : free_lists_) {
+      for (uint8_t* slab : free_list) {
+        delete[] slab;
+      }
+      free_list.clear();
+    }
+  }
+
+private:
+  std::array<std::vector<uint8_t*>, SlabPool::NumSizeClasses> free_lists_;
+};
+
+thread_local ThreadLocalCache cache;
+
+// Returns the size class index for a pooled capacity.
+uint64_t sizeClass(uint64_t capacity) {
+  uint64_t size_class = 0;
+  while ((SlabPool::MinSlabSize << size_class) < capacity) {
+    size_class++;
+  }
+  return size_class;
+}
+
+} // namespace
+
+std::shared_ptr<uint8_t> SlabPool::allocate(uint64_t min_capacity, uint64_t& capacity) {
+  uint8_t* slab = nullptr;
+  if (min_capacity > MaxPooledSlabSize) {
+    capacity = min_capacity;
+    slab = new uint8_t[capacity];
+  } else {
+    const uint64_t size_class = sizeClass(std::max(min_capacity, MinSlabSize));
+    capacity = MinSlabSize << size_class;
+    if (!cache_destroyed && !cache.freeList(size_class).empty()) {
+      slab = cache.freeList(size_class).back();
+      cache.freeList(size_class).pop_back();
+    } else {
+      slab = new uint8_t[capacity];
+    }
+  }
+
+  Memory::Stats::addBufferSlabBytes(capacity);
+  const uint64_t slab_capacity = capacity;
+  return std::shared_ptr<uint8_t>(slab,
+                                  [slab_capacity](uint8_t* p) { release(p, slab_capacity); });
+}
+
+void SlabPool::release(uint8_t* slab, uint64_t capacity) {
+  Memory::Stats::subtractBufferSlabBytes(capacity);
+  if (capacity <= MaxPooledSlabSize && !cache_destroyed) {
+    std::vector<uint8_t*>& free_list = cache.freeList(sizeClass(capacity));
+    if (free_list.size() < MaxCachedSlabsPerClass) {
+      free_list.push_back(slab);
+      return;
+    }
+  }
+
+  delete[] slab;
+}
+
+uint64_t SlabPool::cachedSlabs() { return cache_destroyed ? 0 : cache.size(); }
+
+void SlabPool::releaseCachedSlabs() {
+  if (!cache_destroyed) {
+    cache.clear();
+  }
+}
+
+} // namespace Buffer
+} // namespace Envoy
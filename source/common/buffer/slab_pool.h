@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * Allocator for buffer slabs. Slabs are rounded up to a power of two size class, starting at 512
+ * bytes so that small writes do not pin a large slab. Freed slabs are cached on a per-thread free
+ * list, so that a worker which is steadily proxying data reuses the same memory instead of going
+ * through malloc for every slab. Slabs larger than the biggest size class are allocated and freed
+ * directly.
+ *
+ * All slab memory currently handed out is accounted for in Memory::Stats::totalBufferSlabBytes().
+ */
+class SlabPool {
+public:
+  static const uint64_t MinSlabSize = 512;
+  static const uint64_t MaxPooledSlabSize = MinSlabSize << 8;
+  static const uint64_t NumSizeClasses = 9;
+  // The number of free slabs of each size class that are kept per thread.
+  static const uint64_t MaxCachedSlabsPerClass = 16;
+
+  /**
+   * Allocate a slab. The slab is returned to the allocating thread's free list (or the free list
+   * of whichever thread drops the last reference) when the returned pointer is released.
+   * @param min_capacity supplies the minimum size of the slab.
+   * @param capacity returns the actual size of the slab.
+   * @return the slab memory.
+   */
+  static std::shared_ptr<uint8_t> allocate(uint64_t min_capacity, uint64_t& capacity);
+
+  /**
+   * @return the number of free slabs cached by the calling thread.
+   */
+  static uint64_t cachedSlabs();
+
+  /**
+   * Free all slabs cached by the calling thread.
+   */
+  static void releaseCachedSlabs();
+
+private:
+  static void release(uint8_t* slab, uint64_t capacity);
+};
+
+} // namespace Buffer
+} // namespace Envoy
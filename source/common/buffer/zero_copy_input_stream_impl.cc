@@ -1,5 +1,7 @@
 #include "common/buffer/zero_copy_input_stream_impl.h"
 
+#include <algorithm>
+
 #include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 
@@ -44,7 +46,19 @@ bool ZeroCopyInputStreamImpl::Next(const void** data, int* size) {
   return false;
 }
 
-bool ZeroCopyInputStreamImpl::Skip(int) { NOT_IMPLEMENTED; }
+bool ZeroCopyInputStreamImpl::Skip(int count) {
+  ASSERT(count >= 0);
+  if (position_ != 0) {
+    buffer_->drain(position_);
+    position_ = 0;
+  }
+
+  // Skipped data, such as unknown fields, is drained without being copied out.
+  const uint64_t skipped = std::min<uint64_t>(count, buffer_->length());
+  buffer_->drain(skipped);
+  byte_count_ += skipped;
+  return skipped == uint64_t(count);
+}
 
 void ZeroCopyInputStreamImpl::BackUp(int count) {
   ASSERT(count >= 0);
@@ -1,17 +1,21 @@
 #include "common/common/base64.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "common/common/empty_string.h"
 
 namespace Envoy {
-static constexpr char CHAR_TABLE[] =
+namespace {
+
+constexpr char CHAR_TABLE[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 // Conversion table is taken from
 // https://opensource.apple.com/source/QuickTimeStreamingServer/QuickTimeStreamingServer-452/CommonUtilitiesLib/base64.c
-static const unsigned char REVERSE_LOOKUP_TABLE[256] = {
+const unsigned char REVERSE_LOOKUP_TABLE[256] = {
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
     52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 64, 64, 64, 64, 64, 64, 64, 0,  1,  2,  3,  4,  5,  6,
@@ -24,160 +28,274 @@ static const unsigned char REVERSE_LOOKUP_TABLE[256] = {
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64};
 
-std::string Base64::decode(const std::string& input) {
-  if (input.length() % 4 || input.empty()) {
-    return EMPTY_STRING;
-  }
+// Set in the group tables for characters which are not in the alphabet. It lies above the 24 bits
+// of a decoded group, so that one check covers all four characters of a group.
+constexpr uint32_t INVALID_CHAR = 0x01000000;
 
-  // First position of "valid" padding character.
-  uint64_t first_padding_index = input.length();
-  int max_length = input.length() / 4 * 3;
-  // At most last two chars can be '='.
-  if (input[input.length() - 1] == '=') {
-    max_length--;
-    first_padding_index = input.length() - 1;
-    if (input[input.length() - 2] == '=') {
-      max_length--;
-      first_padding_index = input.length() - 2;
+/**
+ * Tables which let the codec handle a whole group of three bytes or four characters with a few
+ * lookups, rather than going through the bytes or characters one at a time.
+ */
+struct GroupTables {
+  GroupTables() {
+    for (uint32_t i = 0; i < 4096; i++) {
+      char_pairs_[i][0] = CHAR_TABLE[i >> 6];
+      char_pairs_[i][1] = CHAR_TABLE[i & 0x3f];
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      const uint32_t value = REVERSE_LOOKUP_TABLE[i];
+      for (uint32_t position = 0; position < 4; position++) {
+        group_bits_[position][i] = value == 64 ? INVALID_CHAR : value << (18 - 6 * position);
+      }
     }
   }
-  std::string result;
-  result.reserve(max_length);
-
-  uint64_t bytes_left = input.length();
-  uint64_t cur_read = 0;
-
-  // Read input string by group of 4 chars, length of input string must be divided evenly by 4.
-  // Decode 4 chars 6 bits each into 3 chars 8 bits each.
-  while (bytes_left > 0) {
-    // Take first 6 bits from 1st converted char and first 2 bits from 2nd converted char,
-    // make 8 bits char from it.
-    // Use conversion table to map char to decoded value (value is between 0 and 63 inclusive for a
-    // valid character).
-    const unsigned char a = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read])];
-    const unsigned char b = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 1])];
-    if (a == 64 || b == 64) {
-      // Input contains an invalid character.
-      return EMPTY_STRING;
+
+  // The two characters which encode each 12 bit value.
+  char char_pairs_[4096][2];
+  // The bits of a decoded group which each character supplies, by its position in the group.
+  uint32_t group_bits_[4][256];
+};
+
+const GroupTables& groupTables() {
+  static const GroupTables* tables = new GroupTables();
+  return *tables;
+}
+
+/**
+ * Encode whole groups of three bytes.
+ * @return the end of the encoded characters.
+ */
+char* encodeGroups(const uint8_t* input, uint64_t num_groups, char* output) {
+  const GroupTables& tables = groupTables();
+  for (uint64_t i = 0; i < num_groups; i++, input += 3, output += 4) {
+    const uint32_t group = input[0] << 16 | input[1] << 8 | input[2];
+    memcpy(output, tables.char_pairs_[group >> 12], 2);
+    memcpy(output + 2, tables.char_pairs_[group & 0xfff], 2);
+  }
+  return output;
+}
+
+/**
+ * Encode the last one or two bytes of the input, if any, followed by padding.
+ */
+void encodeLast(const uint8_t* input, uint64_t length, char* output) {
+  if (length == 0) {
+    return;
+  }
+
+  const uint32_t group = input[0] << 16 | (length == 2 ? input[1] << 8 : 0);
+  output[0] = CHAR_TABLE[group >> 18];
+  output[1] = CHAR_TABLE[(group >> 12) & 0x3f];
+  output[2] = length == 2 ? CHAR_TABLE[(group >> 6) & 0x3f] : '=';
+  output[3] = '=';
+}
+
+/**
+ * Encode the first length bytes of a buffer slice by slice. A group which spans slices is put
+ * together in a carry of up to three bytes.
+ */
+void encodeBuffer(const Buffer::Instance& buffer, uint64_t length, char* output) {
+  uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  buffer.getRawSlices(slices, num_slices);
+
+  uint8_t carry[3];
+  uint64_t carry_length = 0;
+  for (const Buffer::RawSlice& slice : slices) {
+    if (length == 0) {
+      break;
     }
-    result.push_back(a << 2 | b >> 4);
-    const unsigned char c = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 2])];
-
-    // Decoded value 64 means invalid character unless we already know it is a valid padding.
-    // If so, following characters are all padding.
-    // Also we should check there are no unused bits.
-    if (c == 64) {
-      if (first_padding_index != cur_read + 2) {
-        // Input contains an invalid character.
-        return EMPTY_STRING;
-      } else if (b & 0b1111) {
-        // There are unused bits at tail.
-        return EMPTY_STRING;
-      } else {
-        return result;
+
+    const uint8_t* input = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t slice_length = std::min<uint64_t>(slice.len_, length);
+    length -= slice_length;
+    if (carry_length > 0) {
+      while (carry_length < 3 && slice_length > 0) {
+        carry[carry_length++] = *input++;
+        slice_length--;
       }
-    }
-    // Take last 4 bits from 2nd converted char and 4 first bits from 3rd converted char.
-    result.push_back(b << 4 | c >> 2);
-
-    const unsigned char d = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 3])];
-    if (d == 64) {
-      if (first_padding_index != cur_read + 3) {
-        // Input contains an invalid character.
-        return EMPTY_STRING;
-      } else if (c & 0b11) {
-        // There are unused bits at tail.
-        return EMPTY_STRING;
-      } else {
-        return result;
+      if (carry_length < 3) {
+        continue;
       }
+      output = encodeGroups(carry, 1, output);
+      carry_length = 0;
     }
-    // Take last 2 bits from 3rd converted char and all(6) bits from 4th converted char.
-    result.push_back(c << 6 | d);
 
-    cur_read += 4;
-    bytes_left -= 4;
+    output = encodeGroups(input, slice_length / 3, output);
+    carry_length = slice_length % 3;
+    memcpy(carry, input + slice_length - carry_length, carry_length);
   }
 
-  return result;
+  encodeLast(carry, carry_length, output);
 }
 
-void Base64::encodeBase(const uint8_t cur_char, uint64_t pos, uint8_t& next_c, std::string& ret) {
-  switch (pos % 3) {
-  case 0:
-    ret.push_back(CHAR_TABLE[cur_char >> 2]);
-    next_c = (cur_char & 0x03) << 4;
-    break;
-  case 1:
-    ret.push_back(CHAR_TABLE[next_c | (cur_char >> 4)]);
-    next_c = (cur_char & 0x0f) << 2;
-    break;
-  case 2:
-    ret.push_back(CHAR_TABLE[next_c | (cur_char >> 6)]);
-    ret.push_back(CHAR_TABLE[cur_char & 0x3f]);
-    next_c = 0;
-    break;
+/**
+ * Decode whole groups of four characters which contain no padding.
+ * @return bool whether all the characters are in the alphabet.
+ */
+bool decodeGroups(const uint8_t* input, uint64_t num_groups, uint8_t* output) {
+  const GroupTables& tables = groupTables();
+  for (uint64_t i = 0; i < num_groups; i++, input += 4, output += 3) {
+    const uint32_t group = tables.group_bits_[0][input[0]] | tables.group_bits_[1][input[1]] |
+                           tables.group_bits_[2][input[2]] | tables.group_bits_[3][input[3]];
+    if (group & INVALID_CHAR) {
+      return false;
+    }
+    output[0] = group >> 16;
+    output[1] = group >> 8;
+    output[2] = group;
   }
+  return true;
 }
 
-void Base64::encodeLast(uint64_t pos, uint8_t last_char, std::string& ret) {
-  switch (pos % 3) {
-  case 1:
-    ret.push_back(CHAR_TABLE[last_char]);
-    ret.push_back('=');
-    ret.push_back('=');
-    break;
-  case 2:
-    ret.push_back(CHAR_TABLE[last_char]);
-    ret.push_back('=');
-    break;
-  default:
-    break;
+/**
+ * Decode the last group of four characters of the input, which may end in padding.
+ * @return the number of bytes decoded, or -1 if the group is not valid.
+ */
+int decodeLast(const uint8_t* input, uint8_t* output) {
+  // Decoded value 64 means an invalid character. At most the last two characters can be padding,
+  // and there must be no unused bits before it.
+  const unsigned char a = REVERSE_LOOKUP_TABLE[input[0]];
+  const unsigned char b = REVERSE_LOOKUP_TABLE[input[1]];
+  if (a == 64 || b == 64) {
+    return -1;
+  }
+  output[0] = a << 2 | b >> 4;
+  if (input[2] == '=' && input[3] == '=') {
+    return (b & 0b1111) ? -1 : 1;
+  }
+
+  const unsigned char c = REVERSE_LOOKUP_TABLE[input[2]];
+  if (c == 64) {
+    return -1;
   }
+  output[1] = b << 4 | c >> 2;
+  if (input[3] == '=') {
+    return (c & 0b11) ? -1 : 2;
+  }
+
+  const unsigned char d = REVERSE_LOOKUP_TABLE[input[3]];
+  if (d == 64) {
+    return -1;
+  }
+  output[2] = c << 6 | d;
+  return 3;
 }
 
-std::string Base64::encode(const Buffer::Instance& buffer, uint64_t length) {
-  uint64_t output_length = (std::min(length, buffer.length()) + 2) / 3 * 4;
-  std::string ret;
-  ret.reserve(output_length);
+} // namespace
 
-  uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+std::string Base64::decode(const std::string& input) {
+  if (input.length() % 4 || input.empty()) {
+    return EMPTY_STRING;
+  }
+
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(input.data());
+  const uint64_t num_groups = input.length() / 4 - 1;
+  std::string result(input.length() / 4 * 3, '\0');
+  uint8_t* out = reinterpret_cast<uint8_t*>(&result[0]);
+  if (!decodeGroups(in, num_groups, out)) {
+    return EMPTY_STRING;
+  }
+
+  const int last_length = decodeLast(in + num_groups * 4, out + num_groups * 3);
+  if (last_length < 0) {
+    return EMPTY_STRING;
+  }
+  result.resize(num_groups * 3 + last_length);
+  return result;
+}
+
+bool Base64::decode(const Buffer::Instance& input, Buffer::Instance& output) {
+  const uint64_t length = input.length();
+  if (length % 4) {
+    return false;
+  }
+  if (length == 0) {
+    return true;
+  }
+
+  Buffer::RawSlice reserved;
+  output.reserve(length / 4 * 3, &reserved, 1);
+  uint8_t* out = static_cast<uint8_t*>(reserved.mem_);
+
+  uint64_t num_slices = input.getRawSlices(nullptr, 0);
   Buffer::RawSlice slices[num_slices];
-  buffer.getRawSlices(slices, num_slices);
+  input.getRawSlices(slices, num_slices);
 
-  uint64_t j = 0;
-  uint8_t next_c = 0;
-  for (Buffer::RawSlice& slice : slices) {
-    const uint8_t* slice_mem = static_cast<const uint8_t*>(slice.mem_);
+  // Everything but the last group, which may hold padding, is decoded slice by slice. A group
+  // which spans slices is put together in a carry.
+  uint64_t remaining = length - 4;
+  uint8_t carry[4];
+  uint64_t carry_length = 0;
+  for (const Buffer::RawSlice& slice : slices) {
+    if (remaining == 0) {
+      break;
+    }
 
-    for (uint64_t i = 0; i < slice.len_ && j < length; ++i, ++j) {
-      encodeBase(slice_mem[i], j, next_c, ret);
+    const uint8_t* in = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t slice_length = std::min<uint64_t>(slice.len_, remaining);
+    remaining -= slice_length;
+    if (carry_length > 0) {
+      while (carry_length < 4 && slice_length > 0) {
+        carry[carry_length++] = *in++;
+        slice_length--;
+      }
+      if (carry_length < 4) {
+        continue;
+      }
+      if (!decodeGroups(carry, 1, out)) {
+        return false;
+      }
+      out += 3;
+      carry_length = 0;
     }
 
-    if (j == length) {
-      break;
+    const uint64_t num_groups = slice_length / 4;
+    if (!decodeGroups(in, num_groups, out)) {
+      return false;
     }
+    out += num_groups * 3;
+    carry_length = slice_length % 4;
+    memcpy(carry, in + num_groups * 4, carry_length);
   }
 
-  encodeLast(j, next_c, ret);
+  uint8_t last[4];
+  input.copyOut(length - 4, 4, last);
+  const int last_length = decodeLast(last, out);
+  if (last_length < 0) {
+    return false;
+  }
 
-  return ret;
+  reserved.len_ = out + last_length - static_cast<uint8_t*>(reserved.mem_);
+  output.commit(&reserved, 1);
+  return true;
 }
 
-std::string Base64::encode(const char* input, uint64_t length) {
-  uint64_t output_length = (length + 2) / 3 * 4;
-  std::string ret;
-  ret.reserve(output_length);
-
-  uint64_t pos = 0;
-  uint8_t next_c = 0;
+std::string Base64::encode(const Buffer::Instance& buffer, uint64_t length) {
+  length = std::min(length, buffer.length());
+  std::string ret((length + 2) / 3 * 4, '\0');
+  encodeBuffer(buffer, length, &ret[0]);
+  return ret;
+}
 
-  for (uint64_t i = 0; i < length; ++i) {
-    encodeBase(input[i], pos++, next_c, ret);
+void Base64::encode(const Buffer::Instance& input, uint64_t length, Buffer::Instance& output) {
+  length = std::min(length, input.length());
+  if (length == 0) {
+    return;
   }
 
-  encodeLast(pos, next_c, ret);
+  Buffer::RawSlice reserved;
+  output.reserve((length + 2) / 3 * 4, &reserved, 1);
+  encodeBuffer(input, length, static_cast<char*>(reserved.mem_));
+  reserved.len_ = (length + 2) / 3 * 4;
+  output.commit(&reserved, 1);
+}
 
+std::string Base64::encode(const char* input, uint64_t length) {
+  std::string ret((length + 2) / 3 * 4, '\0');
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
+  char* out = encodeGroups(in, length / 3, &ret[0]);
+  encodeLast(in + length / 3 * 3, length % 3, out);
   return ret;
 }
 } // namespace Envoy
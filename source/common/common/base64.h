@@ -15,6 +15,15 @@ public:
    */
   static std::string encode(const Buffer::Instance& buffer, uint64_t length);
 
+  /**
+   * Base64 encode an input buffer into another buffer. The input is read slice by slice, without
+   * linearizing it.
+   * @param input supplies the buffer to encode.
+   * @param length supplies the length to encode which may be <= the buffer length.
+   * @param output supplies the buffer to append the encoded data to.
+   */
+  static void encode(const Buffer::Instance& input, uint64_t length, Buffer::Instance& output);
+
   /**
    * Base64 encode an input char buffer with a given length.
    * @param input char array to encode.
@@ -31,16 +40,14 @@ public:
    */
   static std::string decode(const std::string& input);
 
-private:
-  /**
-   * Helper method for encoding. This is used to encode all of the characters from the input string.
-   */
-  static void encodeBase(const uint8_t cur_char, uint64_t pos, uint8_t& next_c, std::string& ret);
-
   /**
-   * Encode last characters. It appends '=' chars to the ret if input
-   * string length is not divisible by 3.
+   * Base64 decode an input buffer into another buffer. The input is read slice by slice, without
+   * linearizing it.
+   * @param input supplies the buffer to decode.
+   * @param output supplies the buffer to append the decoded data to. Nothing is appended if the
+   *        input is not valid.
+   * @return bool whether the input is valid base64. An empty input is valid.
    */
-  static void encodeLast(uint64_t pos, uint8_t last_char, std::string& ret);
+  static bool decode(const Buffer::Instance& input, Buffer::Instance& output);
 };
 } // namespace Envoy
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Envoy {
+
+/**
+ * Per-thread free list of memory blocks sized for T. Objects which are created and destroyed at a
+ * high rate on a worker (per request objects) can allocate from it so that a steady load reuses
+ * the same memory instead of going through malloc for every object. Blocks are returned to the
+ * free list of the thread which frees them, and at most MaxCached blocks are kept per thread.
+ *
+ * It can be used for a class through class specific operator new and delete:
+ *
+ *   static void* operator new(size_t size) { return FreeList<Foo>::allocate(size); }
+ *   static void operator delete(void* p, size_t size) { FreeList<Foo>::release(p, size); }
+ *
+ * or for objects owned by a shared_ptr through FreeListAllocator and std::allocate_shared().
+ */
+template <class T, uint64_t MaxCached = 64> class FreeList {
+public:
+  /**
+   * @param size supplies the size of the block, which is sizeof(T) for the cached blocks.
+   * @return memory for the object.
+   */
+  static void* allocate(size_t size) {
+    if (size == sizeof(T) && !destroyed_ && !cache_.blocks_.empty()) {
+      void* block = cache_.blocks_.back();
+      cache_.blocks_.pop_back();
+      return block;
+    }
+
+    return ::operator new(size);
+  }
+
+  /**
+   * @param block supplies memory returned by allocate().
+   * @param size supplies the size passed to allocate().
+   */
+  static void release(void* block, size_t size) {
+    if (size == sizeof(T) && !destroyed_ && cache_.blocks_.size() < MaxCached) {
+      cache_.blocks_.push_back(block);
+      return;
+    }
+
+    ::operator delete(block);
+  }
+
+  /**
+   * @return the number of free blocks cached by the calling thread.
+   */
+  static uint64_t cached() { return destroyed_ ? 0 : cache_.blocks_.size(); }
+
+private:
+  struct Cache {
+    ~Cache() {
+      for (void* block : blocks_) {
+        ::operator delete(block);
+      }
+      blocks_.clear();
+      destroyed_ = true;
+    }
+
+    std::vector<void*> blocks_;
+  };
+
+  // Set once the calling thread's cache has been destroyed during thread exit. Blocks released
+  // after that point (e.g. by other thread local objects) are freed directly. This is trivially
+  // destructible so it remains valid for the whole life of the thread.
+  static thread_local bool destroyed_;
+  static thread_local Cache cache_;
+};
+
+template <class T, uint64_t MaxCached> thread_local bool FreeList<T, MaxCached>::destroyed_ = false;
+template <class T, uint64_t MaxCached>
+thread_local typename FreeList<T, MaxCached>::Cache FreeList<T, MaxCached>::cache_;
+
+/**
+ * Allocator which allocates single objects from a FreeList, e.g. for use with
+ * std::allocate_shared() so that both the object and its reference count are recycled:
+ *
+ *   std::allocate_shared<Foo>(FreeListAllocator<Foo>(), ...)
+ */
+template <class T> class FreeListAllocator {
+public:
+  typedef T value_type;
+
+  FreeListAllocator() {}
+  template <class U> FreeListAllocator(const FreeListAllocator<U>&) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(FreeList<T>::allocate(n * sizeof(T))); }
+  void deallocate(T* p, size_t n) { FreeList<T>::release(p, n * sizeof(T)); }
+
+  template <class U> bool operator==(const FreeListAllocator<U>&) const { return true; }
+  template <class U> bool operator!=(const FreeListAllocator<U>&) const { return false; }
+};
+
+} // namespace Envoy
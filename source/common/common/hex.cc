@@ -1,6 +1,5 @@
 #include "common/common/hex.h"
 
-#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -47,18 +46,16 @@ std::vector<uint8_t> Hex::decode(const std::string& hex_string) {
 }
 
 std::string Hex::uint64ToHex(uint64_t value) {
-  std::array<uint8_t, 8> data;
-
-  // This is explicitly done for performance reasons
-  data[7] = (value & 0x00000000000000FF);
-  data[6] = (value & 0x000000000000FF00) >> 8;
-  data[5] = (value & 0x0000000000FF0000) >> 16;
-  data[4] = (value & 0x00000000FF000000) >> 24;
-  data[3] = (value & 0x000000FF00000000) >> 32;
-  data[2] = (value & 0x0000FF0000000000) >> 40;
-  data[1] = (value & 0x00FF000000000000) >> 48;
-  data[0] = (value & 0xFF00000000000000) >> 56;
+  char output[16];
+  uint64ToHex(value, output);
+  return std::string(output, sizeof(output));
+}
 
-  return encode(&data[0], data.size());
+void Hex::uint64ToHex(uint64_t value, char* output) {
+  static const char* const digits = "0123456789abcdef";
+  for (int i = 15; i >= 0; i--) {
+    output[i] = digits[value & 0xf];
+    value >>= 4;
+  }
 }
 } // namespace Envoy
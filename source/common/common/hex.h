@@ -39,5 +39,12 @@ public:
    * @param value The integer to be converted.
    */
   static std::string uint64ToHex(uint64_t value);
+
+  /**
+   * Writes the given 64-bit integer as 16 hexadecimal digits, without allocating a string.
+   * @param value The integer to be converted.
+   * @param output supplies the buffer which the 16 digits are written to. It is not terminated.
+   */
+  static void uint64ToHex(uint64_t value, char* output);
 };
 } // namespace Envoy
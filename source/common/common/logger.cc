@@ -23,11 +23,42 @@ Logger::Logger(const std::string& name) {
   logger_->flush_on(spdlog::level::critical);
 }
 
-void LockingStderrOrFileSink::logToStdErr() { log_file_.reset(); }
+LockingStderrOrFileSink::~LockingStderrOrFileSink() { disableAsync(); }
+
+void LockingStderrOrFileSink::logToStdErr() {
+  // Messages which are still waiting go out to the file they were logged for.
+  flush();
+  std::lock_guard<std::mutex> write_guard(write_lock_);
+  log_file_.reset();
+}
 
 void LockingStderrOrFileSink::logToFile(const std::string& log_path,
                                         AccessLog::AccessLogManager& log_manager) {
-  log_file_ = log_manager.createAccessLog(log_path);
+  Filesystem::FileSharedPtr log_file = log_manager.createAccessLog(log_path);
+  std::lock_guard<std::mutex> write_guard(write_lock_);
+  log_file_ = log_file;
+}
+
+void LockingStderrOrFileSink::enableAsync(uint64_t max_buffered_bytes) {
+  disableAsync();
+  max_buffered_bytes_ = max_buffered_bytes;
+  write_thread_exit_ = false;
+  write_thread_.reset(new std::thread([this]() -> void { writeThreadFunc(); }));
+}
+
+void LockingStderrOrFileSink::disableAsync() {
+  if (!write_thread_) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(write_event_lock_);
+    write_thread_exit_ = true;
+    write_event_.notify_one();
+  }
+  write_thread_->join();
+  write_thread_.reset();
+  flush();
 }
 
 std::vector<Logger>& Registry::allLoggers() {
@@ -37,17 +68,90 @@ std::vector<Logger>& Registry::allLoggers() {
 }
 
 void LockingStderrOrFileSink::log(const spdlog::details::log_msg& msg) {
+  if (!write_thread_) {
+    write(msg.formatted.str());
+    return;
+  }
+
+  const uint64_t size = msg.formatted.size();
+  uint64_t buffered_bytes;
+  {
+    WriteBuffer& write_buffer = threadWriteBuffer();
+    std::lock_guard<std::mutex> guard(write_buffer.lock_);
+    if (buffered_bytes_ + size > max_buffered_bytes_) {
+      dropped_messages_++;
+      return;
+    }
+    write_buffer.data_.append(msg.formatted.data(), size);
+    buffered_bytes = buffered_bytes_ += size;
+  }
+
+  // Only the message which the writer finds waiting first has to wake it up.
+  if (buffered_bytes == size) {
+    std::lock_guard<std::mutex> guard(write_event_lock_);
+    write_event_.notify_one();
+  }
+}
+
+void LockingStderrOrFileSink::write(const std::string& data) {
   if (log_file_) {
     // Logfiles have internal locking to ensure serial, non-interleaved
     // writes, so no additional locking needed here.
-    log_file_->write(msg.formatted.str());
+    log_file_->write(data);
   } else {
     Thread::OptionalLockGuard<Thread::BasicLockable> guard(lock_);
-    std::cerr << msg.formatted.str();
+    std::cerr << data;
+  }
+}
+
+void LockingStderrOrFileSink::writeBuffers() {
+  std::string data;
+  for (WriteBuffer& write_buffer : write_buffers_) {
+    std::lock_guard<std::mutex> buffer_guard(write_buffer.lock_);
+    buffered_bytes_ -= write_buffer.data_.size();
+    data.append(write_buffer.data_);
+    write_buffer.data_.clear();
+  }
+
+  const uint64_t dropped_messages = dropped_messages_;
+  if (dropped_messages != reported_dropped_messages_) {
+    data.append("[" + std::to_string(dropped_messages - reported_dropped_messages_) +
+                " log messages dropped]\n");
+    reported_dropped_messages_ = dropped_messages;
+  }
+
+  if (!data.empty()) {
+    write(data);
   }
 }
 
+void LockingStderrOrFileSink::writeThreadFunc() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(write_event_lock_);
+      while (buffered_bytes_ == 0 && !write_thread_exit_) {
+        write_event_.wait(guard);
+      }
+
+      if (write_thread_exit_) {
+        return;
+      }
+    }
+
+    std::lock_guard<std::mutex> write_guard(write_lock_);
+    writeBuffers();
+  }
+}
+
+LockingStderrOrFileSink::WriteBuffer& LockingStderrOrFileSink::threadWriteBuffer() {
+  static std::atomic<uint32_t> next_index{};
+  static thread_local const uint32_t index = next_index++;
+  return write_buffers_[index % NUM_WRITE_BUFFERS];
+}
+
 void LockingStderrOrFileSink::flush() {
+  std::lock_guard<std::mutex> write_guard(write_lock_);
+  writeBuffers();
   if (log_file_) {
     // Logfiles have internal locking to ensure serial, non-interleaved
     // writes, so no additional locking needed here.
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "envoy/access_log/access_log.h"
@@ -69,9 +73,14 @@ private:
  * being two separate classes) because we can't setup file logging until after the AccessLogManager
  * is available, but by that time some loggers have cached their logger from the registry already,
  * so we need to be able switch implementations without replacing the object.
+ *
+ * Messages are written out by the logging thread, unless the sink is made asynchronous, in which
+ * case they are handed to a background thread.
  */
 class LockingStderrOrFileSink : public spdlog::sinks::sink {
 public:
+  ~LockingStderrOrFileSink();
+
   void setLock(Thread::BasicLockable& lock) { lock_ = &lock; }
 
   /**
@@ -90,13 +99,70 @@ public:
    */
   void logToFile(const std::string& log_path, AccessLog::AccessLogManager& log_manager);
 
+  /**
+   * Hand messages to a background thread which writes them out, so that the threads which log
+   * never wait on stderr or the log file. Messages logged while more than max_buffered_bytes are
+   * waiting to be written are dropped and counted.
+   *
+   * @note This method is not thread-safe and can only be called when no other threads
+   * are logging.
+   */
+  void enableAsync(uint64_t max_buffered_bytes);
+
+  /**
+   * Write out the waiting messages and stop the background thread, so that messages are written
+   * by the logging thread again.
+   *
+   * @note This method is not thread-safe and can only be called when no other threads
+   * are logging.
+   */
+  void disableAsync();
+
+  /**
+   * @return uint64_t the number of messages dropped because too many were waiting to be written.
+   */
+  uint64_t droppedMessages() const { return dropped_messages_; }
+
   // spdlog::sinks::sink
   void log(const spdlog::details::log_msg& msg) override;
   void flush() override;
 
 private:
+  /**
+   * Messages waiting to be written for a subset of the logging threads. Spreading the threads over
+   * several buffers keeps workers which log at the same time from contending on one lock.
+   */
+  struct WriteBuffer {
+    std::mutex lock_;
+    std::string data_;
+  };
+
+  void write(const std::string& data);
+  // Must be called with write_lock_ held.
+  void writeBuffers();
+  void writeThreadFunc();
+  WriteBuffer& threadWriteBuffer();
+
+  // Number of write buffers. Each logging thread sticks to one of them.
+  static const uint32_t NUM_WRITE_BUFFERS = 16;
+
   Thread::BasicLockable* lock_{};
   Filesystem::FileSharedPtr log_file_;
+
+  // Set while the sink is asynchronous. Thread::Thread logs through ASSERT, so the writer is a
+  // std::thread.
+  std::unique_ptr<std::thread> write_thread_;
+  uint64_t max_buffered_bytes_{};
+  WriteBuffer write_buffers_[NUM_WRITE_BUFFERS];
+  std::atomic<uint64_t> buffered_bytes_{};
+  std::atomic<uint64_t> dropped_messages_{};
+  uint64_t reported_dropped_messages_{};
+  // Held while messages are taken out of the write buffers and written, so that they are written
+  // in the order they were taken.
+  std::mutex write_lock_;
+  std::mutex write_event_lock_;
+  std::condition_variable write_event_;
+  bool write_thread_exit_{};
 };
 
 /**
@@ -196,6 +262,13 @@ protected:
  */
 #define ENVOY_LOG(LEVEL, ...) ENVOY_LOG_TO_LOGGER(ENVOY_LOGGER(), LEVEL, ##__VA_ARGS__)
 
+/**
+ * Convenience macro to check whether the class' logger logs at a level. The arguments of the log
+ * macros are evaluated even when nothing is logged, so the ones which are expensive to compute
+ * should be guarded by this check.
+ */
+#define ENVOY_LOG_CHECK_LEVEL(LEVEL) ENVOY_LOGGER().should_log(spdlog::level::LEVEL)
+
 /**
  * Convenience macro to log to the misc logger, which allows for logging without of direct access to
  * a logger.
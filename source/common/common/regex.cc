@@ -0,0 +1,65 @@
+#include "common/common/regex.h"
+
+#include "envoy/common/exception.h"
+
+#include "fmt/format.h"
+#include "re2/re2.h"
+
+namespace Envoy {
+namespace Regex {
+
+namespace {
+
+/**
+ * CompiledMatcher backed by RE2, which matches in time linear in the length of the subject.
+ */
+class Re2Matcher : public CompiledMatcher {
+public:
+  explicit Re2Matcher(const std::string& pattern) : regex_(pattern, options()) {
+    if (!regex_.ok()) {
+      throw EnvoyException(fmt::format("Invalid regex '{}': {}", pattern, regex_.error()));
+    }
+  }
+
+  // Regex::CompiledMatcher
+  bool fullMatch(const char* begin, const char* end) const override {
+    return re2::RE2::FullMatch(re2::StringPiece(begin, end - begin), regex_);
+  }
+  bool search(const char* begin, const char* end, std::vector<MatchGroup>& groups) const override {
+    const int group_count = regex_.NumberOfCapturingGroups() + 1;
+    std::vector<re2::StringPiece> pieces(group_count);
+    if (!regex_.Match(re2::StringPiece(begin, end - begin), 0, end - begin, re2::RE2::UNANCHORED,
+                      pieces.data(), group_count)) {
+      return false;
+    }
+
+    groups.resize(group_count);
+    for (int i = 0; i < group_count; i++) {
+      // A group which did not participate in the match has a null piece.
+      groups[i].begin_ = pieces[i].data();
+      groups[i].end_ = pieces[i].data() == nullptr ? nullptr : pieces[i].data() + pieces[i].size();
+    }
+    return true;
+  }
+
+private:
+  static re2::RE2::Options options() {
+    re2::RE2::Options options;
+    // Subjects are matched byte by byte, as std::regex did.
+    options.set_encoding(re2::RE2::Options::EncodingLatin1);
+    // Errors are reported through the exception rather than logged by RE2.
+    options.set_log_errors(false);
+    return options;
+  }
+
+  const re2::RE2 regex_;
+};
+
+} // namespace
+
+CompiledMatcherPtr Utility::parseRegex(const std::string& pattern) {
+  return CompiledMatcherPtr{new Re2Matcher(pattern)};
+}
+
+} // namespace Regex
+} // namespace Envoy
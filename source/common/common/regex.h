@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Regex {
+
+/**
+ * The part of a subject matched by a regex or by one of its capture groups. Both pointers are null
+ * if the group did not participate in the match.
+ */
+struct MatchGroup {
+  bool matched() const { return begin_ != nullptr; }
+  std::string str() const { return matched() ? std::string(begin_, end_) : std::string(); }
+
+  const char* begin_{};
+  const char* end_{};
+};
+
+/**
+ * A compiled regular expression. Matching is thread safe.
+ */
+class CompiledMatcher {
+public:
+  virtual ~CompiledMatcher() {}
+
+  /**
+   * @return whether the regex matches all of [begin, end), as std::regex_match().
+   */
+  virtual bool fullMatch(const char* begin, const char* end) const PURE;
+
+  /**
+   * Find the leftmost match of the regex in [begin, end), as std::regex_search().
+   * @param groups receives the whole match followed by each capture group if there is a match.
+   * @return whether there is a match.
+   */
+  virtual bool search(const char* begin, const char* end,
+                      std::vector<MatchGroup>& groups) const PURE;
+
+  bool fullMatch(const std::string& value) const {
+    return fullMatch(value.data(), value.data() + value.size());
+  }
+};
+
+typedef std::unique_ptr<const CompiledMatcher> CompiledMatcherPtr;
+typedef std::shared_ptr<const CompiledMatcher> CompiledMatcherSharedPtr;
+
+/**
+ * Regex compilation routines.
+ */
+class Utility {
+public:
+  /**
+   * Compile a regex with RE2, which matches in time linear in the length of the subject. The syntax
+   * is the ECMAScript syntax std::regex takes, less backreferences and lookaround assertions,
+   * which RE2 does not support. Captures inside repeated groups keep the last iteration in which
+   * they participated, as in Perl, rather than being reset on every iteration.
+   * @param pattern supplies the regex.
+   * @return CompiledMatcherPtr the compiled regex.
+   * @throw EnvoyException if the pattern is invalid or uses a construct RE2 does not support.
+   */
+  static CompiledMatcherPtr parseRegex(const std::string& pattern);
+};
+
+} // namespace Regex
+} // namespace Envoy
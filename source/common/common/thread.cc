@@ -1,12 +1,18 @@
 #include "common/common/thread.h"
 
 #ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sched.h>
 #include <sys/syscall.h>
 #elif defined(__APPLE__)
 #include <pthread.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <vector>
 
 #include "common/common/assert.h"
 #include "common/common/macros.h"
@@ -43,5 +49,57 @@ void Thread::join() {
   UNREFERENCED_PARAMETER(rc);
 }
 
+void parallelFor(uint32_t count, uint32_t num_threads, std::function<void(uint32_t)> fn) {
+  std::atomic<uint32_t> next_index{0};
+  std::vector<std::exception_ptr> exceptions(count);
+  auto run = [&]() -> void {
+    for (uint32_t i = next_index++; i < count; i = next_index++) {
+      try {
+        fn(i);
+      } catch (...) {
+        exceptions[i] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<ThreadPtr> threads;
+  for (uint32_t i = 1; i < std::min(num_threads, count); i++) {
+    threads.emplace_back(new Thread(run));
+  }
+  run();
+  for (ThreadPtr& thread : threads) {
+    thread->join();
+  }
+
+  for (const std::exception_ptr& exception : exceptions) {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+}
+
+bool pinCurrentThread(uint32_t cpu) {
+#ifdef __linux__
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+    return false;
+  }
+
+  // Allocate from the node of the CPU the thread runs on, which is now always the same one. A
+  // failure here only costs locality, so the thread still counts as pinned.
+  syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0);
+  return true;
+#else
+  UNREFERENCED_PARAMETER(cpu);
+  return false;
+#endif
+}
+
 } // namespace Thread
 } // namespace Envoy
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -36,6 +37,27 @@ private:
 
 typedef std::unique_ptr<Thread> ThreadPtr;
 
+/**
+ * Invoke a function for each index in [0, count), spread across up to num_threads threads of which
+ * the calling thread is one, and wait for all of the invocations to finish. The function must be
+ * safe to run concurrently for different indices. If any invocation throws, the exception of the
+ * lowest such index is rethrown on the calling thread, as it would be were the indices run in
+ * order.
+ * @param count supplies the number of indices.
+ * @param num_threads supplies the most threads to use. With 1, every index runs on the calling
+ *        thread.
+ * @param fn supplies the function to invoke with each index.
+ */
+void parallelFor(uint32_t count, uint32_t num_threads, std::function<void(uint32_t)> fn);
+
+/**
+ * Pin the calling thread to a CPU, and make the kernel place the memory the thread touches from
+ * then on on the NUMA node of that CPU.
+ * @param cpu supplies the index of the CPU.
+ * @return bool whether the thread was pinned. This is always false on platforms other than Linux.
+ */
+bool pinCurrentThread(uint32_t cpu);
+
 /**
  * Implementation of BasicLockable
  */
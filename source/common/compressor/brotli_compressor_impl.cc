@@ -0,0 +1,84 @@
+#include "common/compressor/brotli_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Compressor {
+
+BrotliCompressorImpl::BrotliCompressorImpl()
+    : state_ptr_(nullptr, [](BrotliEncoderState* state) { BrotliEncoderDestroyInstance(state); }) {}
+
+void BrotliCompressorImpl::init(uint32_t quality, uint32_t window_bits) {
+  ASSERT(!state_ptr_);
+  quality_ = quality;
+  window_bits_ = window_bits;
+  createEncoder();
+}
+
+void BrotliCompressorImpl::setChunk(uint64_t chunk) { chunk_ = chunk; }
+
+void BrotliCompressorImpl::createEncoder() {
+  state_ptr_.reset(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr));
+  RELEASE_ASSERT(state_ptr_);
+  RELEASE_ASSERT(BrotliEncoderSetParameter(state_ptr_.get(), BROTLI_PARAM_QUALITY, quality_));
+  RELEASE_ASSERT(BrotliEncoderSetParameter(state_ptr_.get(), BROTLI_PARAM_LGWIN, window_bits_));
+}
+
+void BrotliCompressorImpl::compress(const Buffer::Instance& input_buffer,
+                                    Buffer::Instance& output_buffer) {
+  reserve(output_buffer);
+
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    process(output_buffer, BROTLI_OPERATION_PROCESS, static_cast<const uint8_t*>(input_slice.mem_),
+            input_slice.len_);
+  }
+
+  commit(output_buffer);
+}
+
+void BrotliCompressorImpl::end(Buffer::Instance& output_buffer) {
+  reserve(output_buffer);
+  process(output_buffer, BROTLI_OPERATION_FINISH, nullptr, 0);
+  ASSERT(BrotliEncoderIsFinished(state_ptr_.get()));
+  commit(output_buffer);
+}
+
+void BrotliCompressorImpl::reset() {
+  // Unlike zlib, brotli has no way to reset an encoder, which is recreated instead.
+  createEncoder();
+}
+
+void BrotliCompressorImpl::process(Buffer::Instance& output_buffer,
+                                   BrotliEncoderOperation operation, const uint8_t* input,
+                                   size_t length) {
+  // The encoder consumes all of the input, and holds output back, until it runs out of output
+  // space. It only finishes a stream once all of the output is taken.
+  do {
+    if (avail_out_ == 0) {
+      commit(output_buffer);
+      reserve(output_buffer);
+    }
+    const BROTLI_BOOL result = BrotliEncoderCompressStream(state_ptr_.get(), operation, &length,
+                                                           &input, &avail_out_, &next_out_, nullptr);
+    RELEASE_ASSERT(result);
+  } while (length > 0 || BrotliEncoderHasMoreOutput(state_ptr_.get()) ||
+           (operation == BROTLI_OPERATION_FINISH && !BrotliEncoderIsFinished(state_ptr_.get())));
+}
+
+void BrotliCompressorImpl::reserve(Buffer::Instance& output_buffer) {
+  output_buffer.reserve(chunk_, &output_slice_, 1);
+  avail_out_ = output_slice_.len_;
+  next_out_ = static_cast<uint8_t*>(output_slice_.mem_);
+}
+
+void BrotliCompressorImpl::commit(Buffer::Instance& output_buffer) {
+  output_slice_.len_ = output_slice_.len_ - avail_out_;
+  output_buffer.commit(&output_slice_, 1);
+}
+
+} // namespace Compressor
+} // namespace Envoy
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "envoy/compressor/compressor.h"
+
+#include "brotli/encode.h"
+
+namespace Envoy {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface with brotli (RFC 7932).
+ */
+class BrotliCompressorImpl : public Compressor {
+public:
+  BrotliCompressorImpl();
+
+  /**
+   * Sets buffer size for feeding data to the compressor routines.
+   * @param chunk amount of memory reserved for the compressor output default = 4096.
+   */
+  void setChunk(uint64_t chunk);
+
+  /**
+   * Init must be called in order to initialize the compressor. It should be always called before
+   * calling compress.
+   * @param quality sets the compression level, from 0 (fastest) to 11 (best). @see
+   * BROTLI_PARAM_QUALITY (brotli/encode.h)
+   * @param window_bits sets the size of the sliding window, from 10 to 24. Larger values result in
+   * better compression, but will use more memory. @see BROTLI_PARAM_LGWIN (brotli/encode.h)
+   */
+  void init(uint32_t quality, uint32_t window_bits);
+
+  // Compressor::Compressor
+  void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void end(Buffer::Instance& output_buffer) override;
+  void reset() override;
+
+private:
+  void createEncoder();
+  void process(Buffer::Instance& output_buffer, BrotliEncoderOperation operation,
+               const uint8_t* input, size_t length);
+  void commit(Buffer::Instance& output_buffer);
+  void reserve(Buffer::Instance& output_buffer);
+
+  std::unique_ptr<BrotliEncoderState, std::function<void(BrotliEncoderState*)>> state_ptr_;
+  Buffer::RawSlice output_slice_;
+  size_t avail_out_{};
+  uint8_t* next_out_{};
+
+  uint32_t quality_{};
+  uint32_t window_bits_{};
+  uint64_t chunk_{4096};
+};
+
+} // namespace Compressor
+} // namespace Envoy
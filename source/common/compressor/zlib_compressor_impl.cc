@@ -30,15 +30,35 @@ void ZlibCompressorImpl::init(CompressionLevel comp_level, CompressionStrategy c
 void ZlibCompressorImpl::setChunk(uint64_t chunk) { chunk_ = chunk; }
 
 void ZlibCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  reserve(output_buffer);
   process(output_buffer, Z_SYNC_FLUSH);
   commit(output_buffer);
 }
 
+void ZlibCompressorImpl::end(Buffer::Instance& output_buffer) {
+  reserve(output_buffer);
+  // Unlike the other flush modes, Z_FINISH may need more than one full output chunk, and deflate()
+  // only reports Z_STREAM_END once all of the trailer is written.
+  int result;
+  do {
+    if (zstream_ptr_->avail_out == 0) {
+      commit(output_buffer);
+      reserve(output_buffer);
+    }
+    result = deflate(zstream_ptr_.get(), Z_FINISH);
+    RELEASE_ASSERT(result >= 0);
+  } while (result != Z_STREAM_END);
+  commit(output_buffer);
+}
+
+void ZlibCompressorImpl::reset() {
+  const int result = deflateReset(zstream_ptr_.get());
+  RELEASE_ASSERT(result == Z_OK);
+}
+
 void ZlibCompressorImpl::compress(const Buffer::Instance& input_buffer,
                                   Buffer::Instance& output_buffer) {
-  if (zstream_ptr_->total_out == 0) {
-    reserve(output_buffer);
-  }
+  reserve(output_buffer);
 
   const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
   Buffer::RawSlice slices[num_slices];
@@ -49,6 +69,8 @@ void ZlibCompressorImpl::compress(const Buffer::Instance& input_buffer,
     zstream_ptr_->next_in = static_cast<Bytef*>(input_slice.mem_);
     process(output_buffer, Z_NO_FLUSH);
   }
+
+  commit(output_buffer);
 }
 
 void ZlibCompressorImpl::process(Buffer::Instance& output_buffer, uint8_t flush_state) {
@@ -67,10 +67,10 @@ public:
    */
   void finish(Buffer::Instance& output_buffer);
 
-  /**
-   * Implements Envoy::Compressor
-   */
+  // Compressor::Compressor
   void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void end(Buffer::Instance& output_buffer) override;
+  void reset() override;
 
 private:
   void process(Buffer::Instance& output_buffer, uint8_t flush_state);
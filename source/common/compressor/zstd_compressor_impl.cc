@@ -0,0 +1,80 @@
+#include "common/compressor/zstd_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Compressor {
+
+ZstdCompressorImpl::ZstdCompressorImpl()
+    : cstream_ptr_(ZSTD_createCStream(), [](ZSTD_CStream* cstream) { ZSTD_freeCStream(cstream); }) {
+  RELEASE_ASSERT(cstream_ptr_);
+}
+
+void ZstdCompressorImpl::init(int32_t level) {
+  ASSERT(initialized_ == false);
+  level_ = level;
+  const size_t result = ZSTD_initCStream(cstream_ptr_.get(), level_);
+  RELEASE_ASSERT(!ZSTD_isError(result));
+  initialized_ = true;
+}
+
+void ZstdCompressorImpl::setChunk(uint64_t chunk) { chunk_ = chunk; }
+
+void ZstdCompressorImpl::compress(const Buffer::Instance& input_buffer,
+                                  Buffer::Instance& output_buffer) {
+  reserve(output_buffer);
+
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    ZSTD_inBuffer input{input_slice.mem_, input_slice.len_, 0};
+    while (input.pos < input.size) {
+      if (output_.pos == output_.size) {
+        commit(output_buffer);
+        reserve(output_buffer);
+      }
+      const size_t result = ZSTD_compressStream(cstream_ptr_.get(), &output_, &input);
+      RELEASE_ASSERT(!ZSTD_isError(result));
+    }
+  }
+
+  commit(output_buffer);
+}
+
+void ZstdCompressorImpl::end(Buffer::Instance& output_buffer) {
+  reserve(output_buffer);
+  // ZSTD_endStream() returns the number of bytes which are left to output, if the output buffer
+  // is too small for the end of the frame.
+  size_t remaining;
+  do {
+    if (output_.pos == output_.size) {
+      commit(output_buffer);
+      reserve(output_buffer);
+    }
+    remaining = ZSTD_endStream(cstream_ptr_.get(), &output_);
+    RELEASE_ASSERT(!ZSTD_isError(remaining));
+  } while (remaining > 0);
+  commit(output_buffer);
+}
+
+void ZstdCompressorImpl::reset() {
+  // ZSTD_resetCStream() is not part of the stable API. Initializing the stream again reuses its
+  // allocated context as well.
+  const size_t result = ZSTD_initCStream(cstream_ptr_.get(), level_);
+  RELEASE_ASSERT(!ZSTD_isError(result));
+}
+
+void ZstdCompressorImpl::reserve(Buffer::Instance& output_buffer) {
+  output_buffer.reserve(chunk_, &output_slice_, 1);
+  output_ = {output_slice_.mem_, output_slice_.len_, 0};
+}
+
+void ZstdCompressorImpl::commit(Buffer::Instance& output_buffer) {
+  output_slice_.len_ = output_.pos;
+  output_buffer.commit(&output_slice_, 1);
+}
+
+} // namespace Compressor
+} // namespace Envoy
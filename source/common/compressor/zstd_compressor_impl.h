@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "envoy/compressor/compressor.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface with zstd (RFC 8478).
+ */
+class ZstdCompressorImpl : public Compressor {
+public:
+  ZstdCompressorImpl();
+
+  /**
+   * Sets buffer size for feeding data to the compressor routines.
+   * @param chunk amount of memory reserved for the compressor output default = 4096.
+   */
+  void setChunk(uint64_t chunk);
+
+  /**
+   * Init must be called in order to initialize the compressor. It should be always called before
+   * calling compress.
+   * @param level sets the compression level, from 1 (fastest) to ZSTD_maxCLevel() (best). The low
+   * levels compress better than gzip at a lower cost.
+   */
+  void init(int32_t level);
+
+  // Compressor::Compressor
+  void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void end(Buffer::Instance& output_buffer) override;
+  void reset() override;
+
+private:
+  void commit(Buffer::Instance& output_buffer);
+  void reserve(Buffer::Instance& output_buffer);
+
+  std::unique_ptr<ZSTD_CStream, std::function<void(ZSTD_CStream*)>> cstream_ptr_;
+  Buffer::RawSlice output_slice_;
+  ZSTD_outBuffer output_{};
+
+  int32_t level_{};
+  bool initialized_{false};
+  uint64_t chunk_{4096};
+};
+
+} // namespace Compressor
+} // namespace Envoy
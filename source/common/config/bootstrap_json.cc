@@ -1,6 +1,13 @@
 #include "common/config/bootstrap_json.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
 #include "common/common/assert.h"
+#include "common/common/thread.h"
 #include "common/config/address_json.h"
 #include "common/config/cds_json.h"
 #include "common/config/json_utility.h"
@@ -13,6 +20,35 @@
 namespace Envoy {
 namespace Config {
 
+namespace {
+
+// Every v1 cluster and listener is validated against its schema and translated on its own, which
+// takes most of the time of loading a large config, so they are spread across threads. Messages are
+// added to the bootstrap up front as repeated fields can't be grown concurrently.
+template <class Message>
+void translateInParallel(
+    const std::vector<Json::ObjectSharedPtr>& json_objects,
+    Protobuf::RepeatedPtrField<Message>& messages,
+    std::function<void(const Json::Object& json_object, Message& message)> translate) {
+  std::vector<Message*> added;
+  added.reserve(json_objects.size());
+  for (uint32_t i = 0; i < json_objects.size(); i++) {
+    added.push_back(messages.Add());
+  }
+
+  // A thread translates at least this many objects, so that small configs aren't slowed down by
+  // starting threads.
+  const uint32_t min_objects_per_thread = 64;
+  const uint32_t num_threads = std::max(
+      1U, std::min<uint32_t>(std::thread::hardware_concurrency(),
+                             json_objects.size() / min_objects_per_thread));
+  Thread::parallelFor(json_objects.size(), num_threads, [&](uint32_t i) -> void {
+    translate(*json_objects[i], *added[i]);
+  });
+}
+
+} // namespace
+
 void BootstrapJson::translateClusterManagerBootstrap(const Json::Object& json_cluster_manager,
                                                      envoy::api::v2::Bootstrap& bootstrap) {
   json_cluster_manager.validateSchema(Json::Schema::CLUSTER_MANAGER_SCHEMA);
@@ -37,11 +73,12 @@ void BootstrapJson::translateClusterManagerBootstrap(const Json::Object& json_cl
         *json_cds, *bootstrap.mutable_dynamic_resources()->mutable_cds_config());
   }
 
-  for (const Json::ObjectSharedPtr& json_cluster :
-       json_cluster_manager.getObjectArray("clusters")) {
-    auto* cluster = bootstrap.mutable_static_resources()->mutable_clusters()->Add();
-    Config::CdsJson::translateCluster(*json_cluster, eds_config, *cluster);
-  }
+  translateInParallel<envoy::api::v2::Cluster>(
+      json_cluster_manager.getObjectArray("clusters"),
+      *bootstrap.mutable_static_resources()->mutable_clusters(),
+      [&eds_config](const Json::Object& json_cluster, envoy::api::v2::Cluster& cluster) -> void {
+        Config::CdsJson::translateCluster(json_cluster, eds_config, cluster);
+      });
 
   auto* cluster_manager = bootstrap.mutable_cluster_manager();
   JSON_UTIL_SET_STRING(json_cluster_manager, *cluster_manager, local_cluster_name);
@@ -62,10 +99,10 @@ void BootstrapJson::translateBootstrap(const Json::Object& json_config,
     Config::Utility::translateLdsConfig(*json_config.getObject("lds"), *lds_config);
   }
 
-  for (const auto json_listener : json_config.getObjectArray("listeners")) {
-    auto* listener = bootstrap.mutable_static_resources()->mutable_listeners()->Add();
-    Config::LdsJson::translateListener(*json_listener, *listener);
-  }
+  translateInParallel<envoy::api::v2::Listener>(
+      json_config.getObjectArray("listeners"),
+      *bootstrap.mutable_static_resources()->mutable_listeners(),
+      Config::LdsJson::translateListener);
 
   JSON_UTIL_SET_STRING(json_config, bootstrap, flags_path);
 
@@ -2,6 +2,7 @@
 
 #include <unordered_set>
 
+#include "common/common/hash.h"
 #include "common/config/utility.h"
 #include "common/protobuf/protobuf.h"
 
@@ -165,28 +166,43 @@ void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResp
     // build a map here from resource name to resource and then walk watches_.
     // We have to walk all watches (and need an efficient map as a result) to
     // ensure we deliver empty config updates when a resource is dropped.
-    std::unordered_map<std::string, ProtobufWkt::Any> resources;
+    std::unordered_map<std::string, const ProtobufWkt::Any*> resources;
     for (const auto& resource : message->resources()) {
       if (type_url != resource.type_url()) {
         throw EnvoyException(fmt::format("{} does not match {} type URL is DiscoveryResponse {}",
                                          resource.type_url(), type_url, message->DebugString()));
       }
       const std::string resource_name = Utility::resourceName(resource);
-      resources.emplace(resource_name, resource);
+      resources.emplace(resource_name, &resource);
     }
     for (auto watch : api_state_[type_url].watches_) {
       if (watch->resources_.empty()) {
         watch->callbacks_.onConfigUpdate(message->resources(), message->version_info());
         continue;
       }
+      // The management server resends every resource of the type URL on each push, so a watch on
+      // named resources (e.g. one EDS cluster among thousands) is skipped when none of its
+      // resources was added, changed or removed since it last accepted an update. The serialized
+      // bytes are hashed as received, without decoding them.
       Protobuf::RepeatedPtrField<ProtobufWkt::Any> found_resources;
-      for (auto watched_resource_name : watch->resources_) {
+      uint64_t resources_hash = 0;
+      for (const auto& watched_resource_name : watch->resources_) {
         auto it = resources.find(watched_resource_name);
         if (it != resources.end()) {
-          found_resources.Add()->MergeFrom(it->second);
+          found_resources.Add()->MergeFrom(*it->second);
+          resources_hash = HashUtil::xxHash64(it->second->value(),
+                                              HashUtil::xxHash64(type_url, resources_hash));
+        } else {
+          resources_hash = HashUtil::xxHash64("", resources_hash);
         }
       }
+      if (watch->updated_ && watch->resources_hash_ == resources_hash) {
+        watch->callbacks_.onConfigUnchanged(message->version_info());
+        continue;
+      }
       watch->callbacks_.onConfigUpdate(found_resources, message->version_info());
+      watch->resources_hash_ = resources_hash;
+      watch->updated_ = true;
     }
     api_state_[type_url].request_.set_version_info(message->version_info());
   } catch (const EnvoyException& e) {
@@ -72,6 +72,9 @@ private:
     GrpcMuxImpl& parent_;
     std::list<GrpcMuxWatchImpl*>::iterator entry_;
     bool inserted_;
+    // Hash of the named resources last accepted by callbacks_, valid when updated_ is set.
+    uint64_t resources_hash_{};
+    bool updated_{};
   };
 
   // Per muxed API state.
@@ -47,10 +47,12 @@ public:
   // Config::GrpcMuxCallbacks
   void onConfigUpdate(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
                       const std::string& version_info) override {
+    // The resources are unpacked in place rather than into a temporary which is then copied.
     Protobuf::RepeatedPtrField<ResourceType> typed_resources;
-    std::transform(resources.cbegin(), resources.cend(),
-                   Protobuf::RepeatedPtrFieldBackInserter(&typed_resources),
-                   MessageUtil::anyConvert<ResourceType>);
+    typed_resources.Reserve(resources.size());
+    for (const auto& resource : resources) {
+      MessageUtil::unpackTo(resource, *typed_resources.Add());
+    }
     callbacks_->onConfigUpdate(typed_resources);
     stats_.update_success_.inc();
     stats_.update_attempt_.inc();
@@ -60,6 +62,14 @@ public:
               resources.size(), RepeatedPtrUtil::debugString(typed_resources));
   }
 
+  void onConfigUnchanged(const std::string& version_info) override {
+    stats_.update_success_.inc();
+    stats_.update_attempt_.inc();
+    version_info_ = version_info;
+    stats_.version_.set(HashUtil::xxHash64(version_info_));
+    ENVOY_LOG(debug, "gRPC config for {} accepted with unchanged resources", type_url_);
+  }
+
   void onConfigUpdateFailed(const EnvoyException* e) override {
     // TODO(htuch): Less fragile signal that this is failure vs. reject.
     if (e == nullptr) {
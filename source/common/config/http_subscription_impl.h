@@ -76,6 +76,7 @@ public:
     const auto status = Protobuf::util::JsonStringToMessage(response.bodyAsString(), &message);
     if (!status.ok()) {
       ENVOY_LOG(warn, "REST config JSON conversion error: {}", status.ToString());
+      rejectResponse();
       handleFailure(nullptr);
       return;
     }
@@ -87,11 +88,14 @@ public:
       stats_.update_success_.inc();
     } catch (const EnvoyException& e) {
       ENVOY_LOG(warn, "REST config update rejected: {}", e.what());
+      rejectResponse();
       stats_.update_rejected_.inc();
       callbacks_->onConfigUpdateFailed(&e);
     }
   }
 
+  void onResponseUnchanged() override { stats_.update_success_.inc(); }
+
   void onFetchComplete() override {}
 
   void onFetchFailure(const EnvoyException* e) override {
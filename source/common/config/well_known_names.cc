@@ -24,6 +24,10 @@ std::vector<std::pair<std::string, std::string>> TagNameValues::getRegexMapping(
   // - Stand-ins for a variable segment of the name (including inside capture groups) will be
   // enclosed in <>.
   // - Typical * notation will be used to denote an arbitrary set of characters.
+  //
+  // The regexes are compiled with RE2, which has no lookahead. A word followed by optional
+  // [<segment>.]s and then a dot is written as word(?:\..*?)??\. rather than word(?=\.).*?\.,
+  // which matches the same names and captures the same text.
 
   // *_rq(_<response_code>
   name_regex_pairs.push_back({RESPONSE_CODE, "_rq(_(\\d{3}))$"});
@@ -32,51 +36,56 @@ std::vector<std::pair<std::string, std::string>> TagNameValues::getRegexMapping(
   name_regex_pairs.push_back({RESPONSE_CODE_CLASS, "_rq(_(\\dxx))$"});
 
   // http.[<stat_prefix>.]dynamodb.table.[<table_name>.]capacity.[<operation_name>.](__partition_id=<last_seven_characters_from_partition_id>)
-  name_regex_pairs.push_back({DYNAMO_PARTITION_ID, "^http(?=\\.).*?\\.dynamodb\\.table(?=\\.).*?\\."
-                                                   "capacity(?=\\.).*?(\\.__partition_id=(\\w{7}))"
-                                                   "$"});
+  name_regex_pairs.push_back({DYNAMO_PARTITION_ID, "^http(?:\\..*?)??\\.dynamodb\\.table"
+                                                   "(?:\\..*?)??\\.capacity(?:\\..*?)??"
+                                                   "(\\.__partition_id=(\\w{7}))$"});
 
   // http.[<stat_prefix>.]dynamodb.operation.(<operation_name>.)<base_stat> or
   // http.[<stat_prefix>.]dynamodb.table.[<table_name>.]capacity.(<operation_name>.)[<partition_id>]
-  name_regex_pairs.push_back({DYNAMO_OPERATION, "^http(?=\\.).*?\\.dynamodb.(?:operation|table(?="
-                                                "\\.).*?\\.capacity)(\\.(.*?))(?:\\.|$)"});
+  name_regex_pairs.push_back({DYNAMO_OPERATION, "^http(?:\\..*?)??\\.dynamodb."
+                                                "(?:operation|table(?:\\..*?)??\\.capacity)"
+                                                "(\\.(.*?))(?:\\.|$)"});
 
   // mongo.[<stat_prefix>.]collection.[<collection>.]callsite.(<callsite>.)query.<base_stat>
   name_regex_pairs.push_back(
       {MONGO_CALLSITE,
-       "^mongo(?=\\.).*?\\.collection(?=\\.).*?\\.callsite\\.((.*?)\\.).*?query.\\w+?$"});
+       "^mongo(?:\\..*?)??\\.collection(?:\\..*?)??\\.callsite\\.((.*?)\\.).*?query.\\w+?$"});
 
   // http.[<stat_prefix>.]dynamodb.table.(<table_name>.) or
   // http.[<stat_prefix>.]dynamodb.error.(<table_name>.)*
   name_regex_pairs.push_back(
-      {DYNAMO_TABLE, "^http(?=\\.).*?\\.dynamodb.(?:table|error)\\.((.*?)\\.)"});
+      {DYNAMO_TABLE, "^http(?:\\..*?)??\\.dynamodb.(?:table|error)\\.((.*?)\\.)"});
 
   // mongo.[<stat_prefix>.]collection.(<collection>.)query.<base_stat>
   name_regex_pairs.push_back(
-      {MONGO_COLLECTION, "^mongo(?=\\.).*?\\.collection\\.((.*?)\\.).*?query.\\w+?$"});
+      {MONGO_COLLECTION, "^mongo(?:\\..*?)??\\.collection\\.((.*?)\\.).*?query.\\w+?$"});
 
   // mongo.[<stat_prefix>.]cmd.(<cmd>.)<base_stat>
-  name_regex_pairs.push_back({MONGO_CMD, "^mongo(?=\\.).*?\\.cmd\\.((.*?)\\.)\\w+?$"});
+  name_regex_pairs.push_back({MONGO_CMD, "^mongo(?:\\..*?)??\\.cmd\\.((.*?)\\.)\\w+?$"});
 
   // cluster.[<route_target_cluster>.]grpc.[<grpc_service>.](<grpc_method>.)<base_stat>
   name_regex_pairs.push_back(
-      {GRPC_BRIDGE_METHOD, "^cluster(?=\\.).*?\\.grpc(?=\\.).*\\.((.*?)\\.)\\w+?$"});
+      {GRPC_BRIDGE_METHOD, "^cluster(?:\\..*?)??\\.grpc(?:\\..*)?\\.((.*?)\\.)\\w+?$"});
 
   // http.[<stat_prefix>.]user_agent.(<user_agent>.)<base_stat>
-  name_regex_pairs.push_back({HTTP_USER_AGENT, "^http(?=\\.).*?\\.user_agent\\.((.*?)\\.)\\w+?$"});
+  name_regex_pairs.push_back(
+      {HTTP_USER_AGENT, "^http(?:\\..*?)??\\.user_agent\\.((.*?)\\.)\\w+?$"});
 
   // vhost.[<virtual host name>.]vcluster.(<virtual_cluster_name>.)<base_stat>
-  name_regex_pairs.push_back({VIRTUAL_CLUSTER, "^vhost(?=\\.).*?\\.vcluster\\.((.*?)\\.)\\w+?$"});
+  name_regex_pairs.push_back(
+      {VIRTUAL_CLUSTER, "^vhost(?:\\..*?)??\\.vcluster\\.((.*?)\\.)\\w+?$"});
 
   // http.[<stat_prefix>.]fault.(<downstream_cluster>.)<base_stat>
   name_regex_pairs.push_back(
-      {FAULT_DOWNSTREAM_CLUSTER, "^http(?=\\.).*?\\.fault\\.((.*?)\\.)\\w+?$"});
+      {FAULT_DOWNSTREAM_CLUSTER, "^http(?:\\..*?)??\\.fault\\.((.*?)\\.)\\w+?$"});
 
   // listener.[<address>.]ssl.cipher.(<cipher>)
-  name_regex_pairs.push_back({SSL_CIPHER, "^listener(?=\\.).*?\\.ssl\\.cipher(\\.(.*?))$"});
+  name_regex_pairs.push_back(
+      {SSL_CIPHER, "^listener(?:\\..*?)??\\.ssl\\.cipher(\\.(.*?))$"});
 
   // cluster.[<route_target_cluster>.]grpc.(<grpc_service>.)*
-  name_regex_pairs.push_back({GRPC_BRIDGE_SERVICE, "^cluster(?=\\.).*?\\.grpc\\.((.*?)\\.)"});
+  name_regex_pairs.push_back(
+      {GRPC_BRIDGE_SERVICE, "^cluster(?:\\..*?)??\\.grpc\\.((.*?)\\.)"});
 
   // tcp.(<stat_prefix>.)<base_stat>
   name_regex_pairs.push_back({TCP_PREFIX, "^tcp\\.((.*?)\\.)\\w+?$"});
@@ -92,7 +101,7 @@ std::vector<std::pair<std::string, std::string>> TagNameValues::getRegexMapping(
 
   // http.(<stat_prefix>.)* or listener.[<address>.]http.(<stat_prefix>.)*
   name_regex_pairs.push_back(
-      {HTTP_CONN_MANAGER_PREFIX, "^(?:|listener(?=\\.).*?\\.)http\\.((.*?)\\.)"});
+      {HTTP_CONN_MANAGER_PREFIX, "^(?:|listener(?:\\..*?)??\\.)http\\.((.*?)\\.)"});
 
   // listener.(<address>.)*
   name_regex_pairs.push_back(
@@ -95,6 +95,8 @@ class HttpFilterNameValues {
 public:
   // Buffer filter
   const std::string BUFFER = "envoy.buffer";
+  // Cache filter
+  const std::string CACHE = "envoy.cache";
   // CORS filter
   const std::string CORS = "envoy.cors";
   // Dynamo filter
@@ -107,6 +109,8 @@ public:
   const std::string GRPC_JSON_TRANSCODER = "envoy.grpc_json_transcoder";
   // GRPC web filter
   const std::string GRPC_WEB = "envoy.grpc_web";
+  // Gzip filter
+  const std::string GZIP = "envoy.gzip";
   // IP tagging filter
   const std::string IP_TAGGING = "envoy.ip_tagging";
   // Rate limit filter
@@ -120,8 +124,9 @@ public:
   const V1Converter v1_converter_;
 
   HttpFilterNameValues()
-      : v1_converter_({BUFFER, CORS, DYNAMO, FAULT, GRPC_HTTP1_BRIDGE, GRPC_JSON_TRANSCODER,
-                       GRPC_WEB, HEALTH_CHECK, IP_TAGGING, RATE_LIMIT, ROUTER}) {}
+      : v1_converter_({BUFFER, CACHE, CORS, DYNAMO, FAULT, GRPC_HTTP1_BRIDGE,
+                       GRPC_JSON_TRANSCODER, GRPC_WEB, GZIP, HEALTH_CHECK, IP_TAGGING, RATE_LIMIT,
+                       ROUTER}) {}
 };
 
 typedef ConstSingleton<HttpFilterNameValues> HttpFilterNames;
@@ -146,6 +151,8 @@ class StatsSinkNameValues {
 public:
   // Statsd sink
   const std::string STATSD = "envoy.statsd";
+  // gRPC metrics service sink
+  const std::string METRICS_SERVICE = "envoy.metrics_service";
 };
 
 typedef ConstSingleton<StatsSinkNameValues> StatsSinkNames;
@@ -157,6 +164,8 @@ class AccessLogNameValues {
 public:
   // File access log
   const std::string FILE = "envoy.file_access_log";
+  // HTTP gRPC access log
+  const std::string HTTP_GRPC = "envoy.http_grpc_access_log";
 };
 
 typedef ConstSingleton<AccessLogNameValues> AccessLogNames;
@@ -5,14 +5,12 @@
 #include <string>
 #include <vector>
 
-#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/dynamo/dynamo_utility.h"
 #include "common/http/codes.h"
 #include "common/http/exception.h"
 #include "common/http/utility.h"
-#include "common/json/json_loader.h"
 
 #include "fmt/format.h"
 
@@ -23,134 +21,141 @@ Http::FilterHeadersStatus DynamoFilter::decodeHeaders(Http::HeaderMap& headers,
   if (enabled_) {
     start_decode_ = std::chrono::steady_clock::now();
     operation_ = RequestParser::parseOperation(headers);
-    return Http::FilterHeadersStatus::StopIteration;
-  } else {
-    return Http::FilterHeadersStatus::Continue;
+    if (RequestParser::isSingleTableOperation(operation_) ||
+        RequestParser::isBatchOperation(operation_)) {
+      request_body_parser_.reset(new RequestBodyParser(operation_));
+    }
   }
+
+  return Http::FilterHeadersStatus::Continue;
 }
 
 Http::FilterDataStatus DynamoFilter::decodeData(Buffer::Instance& data, bool end_stream) {
-  if (enabled_ && end_stream) {
-    onDecodeComplete(data);
+  if (enabled_) {
+    parseRequestBody(data);
+    if (end_stream) {
+      onDecodeComplete();
+    }
   }
 
-  if (!enabled_ || end_stream) {
-    return Http::FilterDataStatus::Continue;
-  } else {
-    // Buffer until the complete request has been processed.
-    return Http::FilterDataStatus::StopIterationAndBuffer;
-  }
+  return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus DynamoFilter::decodeTrailers(Http::HeaderMap&) {
   if (enabled_) {
-    Buffer::OwnedImpl empty;
-    onDecodeComplete(empty);
+    onDecodeComplete();
   }
 
   return Http::FilterTrailersStatus::Continue;
 }
 
-void DynamoFilter::onDecodeComplete(const Buffer::Instance& data) {
-  std::string body = buildBody(decoder_callbacks_->decodingBuffer(), data);
-  if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      table_descriptor_ = RequestParser::parseTable(operation_, *json_body);
-    } catch (const Json::Exception& jsonEx) {
-      // Body parsing failed. This should not happen, just put a stat for that.
-      scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
-    }
+void DynamoFilter::parseRequestBody(const Buffer::Instance& data) {
+  if (!request_body_parser_) {
+    return;
+  }
+
+  try {
+    request_body_parser_->parse(data);
+  } catch (const Json::Exception&) {
+    // Body parsing failed. This should not happen, just put a stat for that.
+    scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
+    request_body_parser_.reset();
+  }
+}
+
+void DynamoFilter::onDecodeComplete() {
+  if (!request_body_parser_) {
+    return;
+  }
+
+  try {
+    table_descriptor_ = request_body_parser_->finish();
+  } catch (const Json::Exception&) {
+    scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
+  }
+  request_body_parser_.reset();
+}
+
+void DynamoFilter::parseResponseBody(const Buffer::Instance& data) {
+  if (!response_body_parser_) {
+    return;
+  }
+
+  try {
+    response_body_parser_->parse(data);
+  } catch (const Json::Exception&) {
+    // Body parsing failed. This should not happen, just put a stat for that.
+    scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
+    response_body_parser_.reset();
   }
 }
 
-void DynamoFilter::onEncodeComplete(const Buffer::Instance& data) {
+void DynamoFilter::onEncodeComplete() {
   ASSERT(enabled_);
-  uint64_t status = Http::Utility::getResponseStatus(*response_headers_);
-  chargeBasicStats(status);
-
-  std::string body = buildBody(encoder_callbacks_->encodingBuffer(), data);
-  if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      chargeTablePartitionIdStats(*json_body);
-
-      if (Http::CodeUtility::is4xx(status)) {
-        chargeFailureSpecificStats(*json_body);
-      }
-      // Batch Operations will always return status 200 for a partial or full success. Check
-      // unprocessed keys to determine partial success.
-      // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
-      if (RequestParser::isBatchOperation(operation_)) {
-        chargeUnProcessedKeysStats(*json_body);
-      }
-    } catch (const Json::Exception&) {
-      // Body parsing failed. This should not happen, just put a stat for that.
-      scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
-    }
+  chargeBasicStats(response_status_);
+
+  std::unique_ptr<ResponseBodyParser> body = std::move(response_body_parser_);
+  if (!body || body->empty()) {
+    return;
+  }
+
+  try {
+    body->finish();
+  } catch (const Json::Exception&) {
+    scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
+    return;
+  }
+
+  chargeTablePartitionIdStats(*body);
+
+  if (Http::CodeUtility::is4xx(response_status_)) {
+    chargeFailureSpecificStats(*body);
+  }
+  // Batch Operations will always return status 200 for a partial or full success. Check
+  // unprocessed keys to determine partial success.
+  // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
+  if (RequestParser::isBatchOperation(operation_)) {
+    chargeUnProcessedKeysStats(*body);
   }
 }
 
 Http::FilterHeadersStatus DynamoFilter::encodeHeaders(Http::HeaderMap& headers, bool end_stream) {
-  Http::FilterHeadersStatus status = Http::FilterHeadersStatus::Continue;
   if (enabled_) {
-    response_headers_ = &headers;
+    response_status_ = Http::Utility::getResponseStatus(headers);
+    // The body is only parsed if it may be charged.
+    if (Http::CodeUtility::is4xx(response_status_) ||
+        RequestParser::isBatchOperation(operation_) ||
+        (!table_descriptor_.table_name.empty() && !operation_.empty())) {
+      response_body_parser_.reset(new ResponseBodyParser());
+    }
 
     if (end_stream) {
-      Buffer::OwnedImpl empty;
-      onEncodeComplete(empty);
-    } else {
-      status = Http::FilterHeadersStatus::StopIteration;
+      onEncodeComplete();
     }
   }
 
-  return status;
+  return Http::FilterHeadersStatus::Continue;
 }
 
 Http::FilterDataStatus DynamoFilter::encodeData(Buffer::Instance& data, bool end_stream) {
-  if (enabled_ && end_stream) {
-    onEncodeComplete(data);
+  if (enabled_) {
+    parseResponseBody(data);
+    if (end_stream) {
+      onEncodeComplete();
+    }
   }
 
-  if (!enabled_ || end_stream) {
-    return Http::FilterDataStatus::Continue;
-  } else {
-    // Buffer until the complete response has been processed.
-    return Http::FilterDataStatus::StopIterationAndBuffer;
-  }
+  return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus DynamoFilter::encodeTrailers(Http::HeaderMap&) {
   if (enabled_) {
-    Buffer::OwnedImpl empty;
-    onEncodeComplete(empty);
+    onEncodeComplete();
   }
 
   return Http::FilterTrailersStatus::Continue;
 }
 
-std::string DynamoFilter::buildBody(const Buffer::Instance* buffered,
-                                    const Buffer::Instance& last) {
-  std::string body;
-  if (buffered) {
-    uint64_t num_slices = buffered->getRawSlices(nullptr, 0);
-    Buffer::RawSlice slices[num_slices];
-    buffered->getRawSlices(slices, num_slices);
-    for (Buffer::RawSlice& slice : slices) {
-      body.append(static_cast<const char*>(slice.mem_), slice.len_);
-    }
-  }
-
-  uint64_t num_slices = last.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  last.getRawSlices(slices, num_slices);
-  for (Buffer::RawSlice& slice : slices) {
-    body.append(static_cast<const char*>(slice.mem_), slice.len_);
-  }
-
-  return body;
-}
-
 void DynamoFilter::chargeBasicStats(uint64_t status) {
   if (!operation_.empty()) {
     chargeStatsPerEntity(operation_, "operation", status);
@@ -197,11 +202,10 @@ void DynamoFilter::chargeStatsPerEntity(const std::string& entity, const std::st
       .recordValue(latency.count());
 }
 
-void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
+void DynamoFilter::chargeUnProcessedKeysStats(const ResponseBodyParser& body) {
   // The unprocessed keys block contains a list of tables and keys for that table that did not
   // complete apart of the batch operation. Only the table names will be logged for errors.
-  std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(json_body);
-  for (const std::string& unprocessed_table : unprocessed_tables) {
+  for (const std::string& unprocessed_table : body.unprocessedTables()) {
     scope_
         .counter(
             fmt::format("{}error.{}.BatchFailureUnprocessedKeys", stat_prefix_, unprocessed_table))
@@ -209,8 +213,8 @@ void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
-  std::string error_type = RequestParser::parseErrorType(json_body);
+void DynamoFilter::chargeFailureSpecificStats(const ResponseBodyParser& body) {
+  const std::string& error_type = body.errorType();
 
   if (!error_type.empty()) {
     if (table_descriptor_.table_name.empty()) {
@@ -226,14 +230,12 @@ void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeTablePartitionIdStats(const Json::Object& json_body) {
+void DynamoFilter::chargeTablePartitionIdStats(const ResponseBodyParser& body) {
   if (table_descriptor_.table_name.empty() || operation_.empty()) {
     return;
   }
 
-  std::vector<RequestParser::PartitionDescriptor> partitions =
-      RequestParser::parsePartitions(json_body);
-  for (const RequestParser::PartitionDescriptor& partition : partitions) {
+  for (const RequestParser::PartitionDescriptor& partition : body.partitions()) {
     std::string scope_string = Utility::buildPartitionStatString(
         stat_prefix_, table_descriptor_.table_name, operation_, partition.partition_id_);
     scope_.counter(scope_string).add(partition.capacity_);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/http/filter.h"
@@ -8,7 +9,6 @@
 #include "envoy/stats/stats.h"
 
 #include "common/dynamo/dynamo_request_parser.h"
-#include "common/json/json_loader.h"
 
 namespace Envoy {
 namespace Dynamo {
@@ -18,6 +18,7 @@ namespace Dynamo {
  * It captures RPS/latencies:
  *  1) Per table per response code (and group of response codes, e.g., 2xx/3xx/etc)
  *  2) Per operation per response code (and group of response codes, e.g., 2xx/3xx/etc)
+ * The bodies are parsed as they are streamed, without being buffered.
  */
 class DynamoFilter : public Http::StreamFilter {
 public:
@@ -46,15 +47,16 @@ public:
   }
 
 private:
-  void onDecodeComplete(const Buffer::Instance& data);
-  void onEncodeComplete(const Buffer::Instance& data);
-  std::string buildBody(const Buffer::Instance* buffered, const Buffer::Instance& last);
+  void parseRequestBody(const Buffer::Instance& data);
+  void parseResponseBody(const Buffer::Instance& data);
+  void onDecodeComplete();
+  void onEncodeComplete();
   void chargeBasicStats(uint64_t status);
   void chargeStatsPerEntity(const std::string& entity, const std::string& entity_type,
                             uint64_t status);
-  void chargeFailureSpecificStats(const Json::Object& json_body);
-  void chargeUnProcessedKeysStats(const Json::Object& json_body);
-  void chargeTablePartitionIdStats(const Json::Object& json_body);
+  void chargeFailureSpecificStats(const ResponseBodyParser& body);
+  void chargeUnProcessedKeysStats(const ResponseBodyParser& body);
+  void chargeTablePartitionIdStats(const ResponseBodyParser& body);
 
   Runtime::Loader& runtime_;
   std::string stat_prefix_;
@@ -65,7 +67,10 @@ private:
   RequestParser::TableDescriptor table_descriptor_{"", true};
   std::string error_type_{};
   MonotonicTime start_decode_;
-  Http::HeaderMap* response_headers_;
+  uint64_t response_status_{};
+  // Only present while a body which is needed for the stats is being parsed.
+  std::unique_ptr<RequestBodyParser> request_body_parser_;
+  std::unique_ptr<ResponseBodyParser> response_body_parser_;
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
 };
@@ -2,11 +2,14 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
 #include "common/common/utility.h"
 
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Dynamo {
 
@@ -70,11 +73,9 @@ RequestParser::TableDescriptor RequestParser::parseTable(const std::string& oper
   TableDescriptor table{"", true};
 
   // Simple operations on a single table, have "TableName" explicitly specified.
-  if (find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
-      SINGLE_TABLE_OPERATIONS.end()) {
+  if (isSingleTableOperation(operation)) {
     table.table_name = json_data.getString("TableName", "");
-  } else if (find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
-             BATCH_OPERATIONS.end()) {
+  } else if (isBatchOperation(operation)) {
     Json::ObjectSharedPtr tables = json_data.getObject("RequestItems", true);
     tables->iterate([&table](const std::string& key, const Json::Object&) {
       if (table.table_name.empty()) {
@@ -103,7 +104,10 @@ std::vector<std::string> RequestParser::parseBatchUnProcessedKeys(const Json::Ob
   return unprocessed_tables;
 }
 std::string RequestParser::parseErrorType(const Json::Object& json_data) {
-  std::string error_type = json_data.getString("__type", "");
+  return supportedErrorType(json_data.getString("__type", ""));
+}
+
+std::string RequestParser::supportedErrorType(const std::string& error_type) {
   if (error_type.empty()) {
     return "";
   }
@@ -122,6 +126,11 @@ bool RequestParser::isBatchOperation(const std::string& operation) {
          BATCH_OPERATIONS.end();
 }
 
+bool RequestParser::isSingleTableOperation(const std::string& operation) {
+  return find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
+         SINGLE_TABLE_OPERATIONS.end();
+}
+
 std::vector<RequestParser::PartitionDescriptor>
 RequestParser::parsePartitions(const Json::Object& json_data) {
   std::vector<RequestParser::PartitionDescriptor> partition_descriptors;
@@ -142,5 +151,84 @@ RequestParser::parsePartitions(const Json::Object& json_data) {
   return partition_descriptors;
 }
 
+void RequestBodyParser::parse(const Buffer::Instance& data) {
+  empty_ = empty_ && data.length() == 0;
+  parser_.parse(data);
+}
+
+RequestParser::TableDescriptor RequestBodyParser::finish() {
+  if (!empty_) {
+    parser_.finish();
+  }
+  return table_;
+}
+
+bool RequestBodyParser::onKey(const std::vector<std::string>& path, const std::string& key) {
+  if (!batch_) {
+    return path.empty() && key == "TableName";
+  }
+
+  if (path.size() == 1 && path[0] == "RequestItems") {
+    if (table_.table_name.empty()) {
+      table_.table_name = key;
+    } else if (table_.table_name != key) {
+      table_.table_name = "";
+      table_.is_single_table = false;
+      parser_.stop();
+    }
+  }
+  return false;
+}
+
+void RequestBodyParser::onValue(const std::string& value, bool is_string) {
+  if (!is_string) {
+    throw Json::Exception("TableName is not a string");
+  }
+  table_.table_name = value;
+  parser_.stop();
+}
+
+void ResponseBodyParser::parse(const Buffer::Instance& data) {
+  empty_ = empty_ && data.length() == 0;
+  parser_.parse(data);
+}
+
+void ResponseBodyParser::finish() {
+  if (!empty_) {
+    parser_.finish();
+  }
+}
+
+bool ResponseBodyParser::onKey(const std::vector<std::string>& path, const std::string& key) {
+  capacity_expected_ = false;
+  if (path.empty()) {
+    return key == "__type";
+  } else if (path.size() == 1 && path[0] == "UnprocessedKeys") {
+    unprocessed_tables_.push_back(key);
+  } else if (path.size() == 2 && path[0] == "ConsumedCapacity" && path[1] == "Partitions") {
+    partition_id_ = key;
+    capacity_expected_ = true;
+    return true;
+  }
+  return false;
+}
+
+void ResponseBodyParser::onValue(const std::string& value, bool is_string) {
+  if (!capacity_expected_) {
+    if (is_string) {
+      error_type_ = RequestParser::supportedErrorType(value);
+    }
+    return;
+  }
+
+  if (is_string) {
+    throw Json::Exception(fmt::format("capacity of partition {} is not a number", partition_id_));
+  }
+
+  // The capacity is rounded up like in parsePartitions().
+  partitions_.emplace_back(partition_id_,
+                           static_cast<uint64_t>(std::ceil(std::strtod(value.c_str(), nullptr))));
+}
+
 } // namespace Dynamo
 } // namespace Envoy
@@ -4,9 +4,11 @@
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/http/header_map.h"
 
 #include "common/json/json_loader.h"
+#include "common/json/json_stream_parser.h"
 
 namespace Envoy {
 namespace Dynamo {
@@ -68,6 +70,12 @@ public:
    */
   static std::string parseErrorType(const Json::Object& json_data);
 
+  /**
+   * @return the supported error type which ends the __type of an error response, or an empty
+   *         string.
+   */
+  static std::string supportedErrorType(const std::string& type);
+
   /**
    * Parse unprocessed keys for batch operation results.
    * @return empty set if there are no unprocessed keys or a set of table names that did not get
@@ -80,6 +88,11 @@ public:
    */
   static bool isBatchOperation(const std::string& operation);
 
+  /**
+   * @return true if the operation is in the set of supported SINGLE_TABLE_OPERATIONS
+   */
+  static bool isSingleTableOperation(const std::string& operation);
+
   /**
    * Parse the Partition ids and the consumed capacity from the body.
    * @return empty set if there is no partition data or a set of partition data containing
@@ -100,5 +113,92 @@ private:
   RequestParser() {}
 };
 
+/**
+ * Extracts the table of a request from its body, chunk by chunk as it is streamed. The parsing
+ * stops as soon as the table is known, and the body is never buffered.
+ */
+class RequestBodyParser : public Json::StreamParserCallbacks {
+public:
+  /**
+   * @param operation supplies the operation, which must be a single table or a batch operation.
+   */
+  RequestBodyParser(const std::string& operation)
+      : batch_(RequestParser::isBatchOperation(operation)) {}
+
+  /**
+   * @throw Json::Exception if the body is not valid JSON.
+   */
+  void parse(const Buffer::Instance& data);
+
+  /**
+   * @return RequestParser::TableDescriptor the table of the request, as parseTable() would.
+   * @throw Json::Exception if the body is truncated.
+   */
+  RequestParser::TableDescriptor finish();
+
+  // Json::StreamParserCallbacks
+  bool onKey(const std::vector<std::string>& path, const std::string& key) override;
+  void onValue(const std::string& value, bool is_string) override;
+
+private:
+  const bool batch_;
+  RequestParser::TableDescriptor table_{"", true};
+  Json::StreamParser parser_{*this};
+  bool empty_{true};
+};
+
+/**
+ * Extracts the error type, the unprocessed tables and the partitions of a response from its body,
+ * chunk by chunk as it is streamed. The body is never buffered.
+ */
+class ResponseBodyParser : public Json::StreamParserCallbacks {
+public:
+  /**
+   * @throw Json::Exception if the body is not valid JSON.
+   */
+  void parse(const Buffer::Instance& data);
+
+  /**
+   * @throw Json::Exception if the body is truncated.
+   */
+  void finish();
+
+  /**
+   * @return bool whether the body is empty, in which case there is nothing to charge.
+   */
+  bool empty() const { return empty_; }
+
+  /**
+   * @return the supported error type of the response, as parseErrorType() would.
+   */
+  const std::string& errorType() const { return error_type_; }
+
+  /**
+   * @return the tables of the unprocessed keys, as parseBatchUnProcessedKeys() would.
+   */
+  const std::vector<std::string>& unprocessedTables() const { return unprocessed_tables_; }
+
+  /**
+   * @return the partitions of the consumed capacity, as parsePartitions() would.
+   */
+  const std::vector<RequestParser::PartitionDescriptor>& partitions() const {
+    return partitions_;
+  }
+
+  // Json::StreamParserCallbacks
+  bool onKey(const std::vector<std::string>& path, const std::string& key) override;
+  void onValue(const std::string& value, bool is_string) override;
+
+private:
+  std::string error_type_;
+  std::vector<std::string> unprocessed_tables_;
+  std::vector<RequestParser::PartitionDescriptor> partitions_;
+  // The partition whose capacity is the next value, if capacity_expected_.
+  std::string partition_id_;
+  bool capacity_expected_{};
+  Json::StreamParser parser_{*this};
+  bool empty_{true};
+};
+
 } // namespace Dynamo
 } // namespace Envoy
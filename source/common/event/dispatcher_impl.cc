@@ -11,6 +11,7 @@
 #include "envoy/network/listener.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
 #include "common/event/file_event_impl.h"
 #include "common/event/signal_impl.h"
 #include "common/event/timer_impl.h"
@@ -25,47 +26,119 @@
 namespace Envoy {
 namespace Event {
 
+namespace {
+
+// Coarse timers fire up to this late.
+const std::chrono::milliseconds COARSE_TIMER_TICK{100};
+// Coarse timers of up to COARSE_TIMER_TICK * COARSE_TIMER_SLOTS are only checked once, when they
+// expire.
+const uint32_t COARSE_TIMER_SLOTS = 1024;
+
+} // namespace
+
 DispatcherImpl::DispatcherImpl()
     : DispatcherImpl(Buffer::WatermarkFactoryPtr{new Buffer::WatermarkBufferFactory}) {}
 
 DispatcherImpl::DispatcherImpl(Buffer::WatermarkFactoryPtr&& factory)
     : buffer_factory_(std::move(factory)), base_(event_base_new()),
-      deferred_delete_timer_(createTimer([this]() -> void { clearDeferredDeleteList(); })),
-      post_timer_(createTimer([this]() -> void { runPostCallbacks(); })),
-      current_to_delete_(&to_delete_1_) {}
+      early_close_supported_(event_base_get_features(base_.get()) & EV_FEATURE_EARLY_CLOSE),
+      coarse_timers_(*this, ProdMonotonicTimeSource::instance_, COARSE_TIMER_TICK,
+                     COARSE_TIMER_SLOTS),
+      deferred_delete_timer_(
+          createTimer([this]() -> void { deleteDeferred(deferred_delete_budget_); })),
+      post_timer_(createTimer([this]() -> void {
+        runCallback(CallbackType::Post, [this]() -> void { runPostCallbacks(); });
+      })) {}
 
 DispatcherImpl::~DispatcherImpl() {}
 
 void DispatcherImpl::clearDeferredDeleteList() {
-  ASSERT(isThreadSafe());
-  std::vector<DeferredDeletablePtr>* to_delete = current_to_delete_;
+  // Items left by a pass which ran out of budget were submitted first, so they go first.
+  if (deleting_index_ < deleting_.size()) {
+    deleteDeferred(std::chrono::microseconds(0));
+  }
+  deleteDeferred(std::chrono::microseconds(0));
+}
 
-  size_t num_to_delete = to_delete->size();
-  if (deferred_deleting_ || !num_to_delete) {
+void DispatcherImpl::deleteDeferred(std::chrono::microseconds budget) {
+  ASSERT(isThreadSafe());
+  if (deferred_deleting_) {
     return;
   }
 
-  ENVOY_LOG(trace, "clearing deferred deletion list (size={})", num_to_delete);
+  if (deleting_index_ == deleting_.size()) {
+    if (to_delete_.empty()) {
+      return;
+    }
 
-  // Swap the current deletion vector so that if we do deferred delete while we are deleting, we
-  // use the other vector. We will get another callback to delete that vector.
-  if (current_to_delete_ == &to_delete_1_) {
-    current_to_delete_ = &to_delete_2_;
-  } else {
-    current_to_delete_ = &to_delete_1_;
+    // Swap the deletion vectors so that if we do deferred delete while we are deleting, we use the
+    // other vector. We will get another callback to delete that vector.
+    deleting_.clear();
+    deleting_index_ = 0;
+    to_delete_.swap(deleting_);
   }
 
+  ENVOY_LOG(trace, "clearing deferred deletion list (size={})", deleting_.size() - deleting_index_);
   deferred_deleting_ = true;
 
   // Calling clear() on the vector does not specify which order destructors run in. We want to
-  // destroy in FIFO order so just do it manually. This required 2 passes over the vector which is
-  // not optimal but can be cleaned up later if needed.
-  for (size_t i = 0; i < num_to_delete; i++) {
-    (*to_delete)[i].reset();
+  // destroy in FIFO order so just do it manually. With a budget, the clock is read every few items
+  // and the pass stops once it is spent.
+  static const size_t BUDGET_CHECK_INTERVAL = 16;
+  const MonotonicTime start_time =
+      budget.count() > 0 ? ProdMonotonicTimeSource::instance_.currentTime() : MonotonicTime();
+  const size_t start_index = deleting_index_;
+  while (deleting_index_ < deleting_.size()) {
+    deleting_[deleting_index_++].reset();
+    if (budget.count() > 0 && (deleting_index_ - start_index) % BUDGET_CHECK_INTERVAL == 0 &&
+        ProdMonotonicTimeSource::instance_.currentTime() - start_time >= budget) {
+      break;
+    }
   }
 
-  to_delete->clear();
   deferred_deleting_ = false;
+
+  if (stats_) {
+    stats_->deferred_deletes_.recordValue(deleting_index_ - start_index);
+  }
+
+  if (deleting_index_ < deleting_.size()) {
+    ENVOY_LOG(trace, "deferred deletion out of budget with {} items left",
+              deleting_.size() - deleting_index_);
+  } else {
+    deleting_.clear();
+    deleting_index_ = 0;
+  }
+
+  // The timer may have been spent on the items left by the previous pass.
+  if (deleting_index_ < deleting_.size() || !to_delete_.empty()) {
+    deferred_delete_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
+void DispatcherImpl::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  ASSERT(isThreadSafe());
+  stats_.reset(new DispatcherStats{ALL_DISPATCHER_STATS(POOL_HISTOGRAM_PREFIX(scope, prefix))});
+}
+
+void DispatcherImpl::enableBusyPoll(std::chrono::microseconds budget, Stats::Scope& scope,
+                                    const std::string& prefix) {
+  ASSERT(isThreadSafe());
+  busy_poll_budget_ = budget;
+  busy_poll_stats_.reset(
+      new BusyPollStats{ALL_BUSY_POLL_STATS(POOL_COUNTER_PREFIX(scope, prefix))});
+}
+
+DispatcherImpl::CallbackStart DispatcherImpl::startCallback() {
+  return {ProdMonotonicTimeSource::instance_.currentTime(), callback_time_};
+}
+
+void DispatcherImpl::endCallback(CallbackType type, const CallbackStart& start) {
+  const std::chrono::nanoseconds elapsed =
+      ProdMonotonicTimeSource::instance_.currentTime() - start.time_;
+  const std::chrono::nanoseconds own = elapsed - (callback_time_ - start.nested_);
+  type_callback_time_[static_cast<int>(type)] += own;
+  callback_time_ += own;
 }
 
 Network::ClientConnectionPtr
@@ -127,11 +200,16 @@ TimerPtr DispatcherImpl::createTimer(TimerCb cb) {
   return TimerPtr{new TimerImpl(*this, cb)};
 }
 
+TimerPtr DispatcherImpl::createCoarseTimer(TimerCb cb) {
+  ASSERT(isThreadSafe());
+  return coarse_timers_.createTimer(cb);
+}
+
 void DispatcherImpl::deferredDelete(DeferredDeletablePtr&& to_delete) {
   ASSERT(isThreadSafe());
-  current_to_delete_->emplace_back(std::move(to_delete));
-  ENVOY_LOG(trace, "item added to deferred deletion list (size={})", current_to_delete_->size());
-  if (1 == current_to_delete_->size()) {
+  to_delete_.emplace_back(std::move(to_delete));
+  ENVOY_LOG(trace, "item added to deferred deletion list (size={})", to_delete_.size());
+  if (1 == to_delete_.size()) {
     deferred_delete_timer_->enableTimer(std::chrono::milliseconds(0));
   }
 }
@@ -148,7 +226,7 @@ void DispatcherImpl::post(std::function<void()> callback) {
   {
     std::unique_lock<std::mutex> lock(post_lock_);
     do_post = post_callbacks_.empty();
-    post_callbacks_.push_back(callback);
+    post_callbacks_.push_back(std::move(callback));
   }
 
   if (do_post) {
@@ -163,20 +241,113 @@ void DispatcherImpl::run(RunType type) {
   // callbacks that have to get run before the initial event loop starts running. libevent does
   // not gaurantee that events are run in any particular order. So even if we post() and call
   // event_base_once() before some other event, the other event might get called first.
-  runPostCallbacks();
+  runCallback(CallbackType::Post, [this]() -> void { runPostCallbacks(); });
+
+  if (type == RunType::Block && busy_poll_stats_) {
+    runBusyPoll();
+    return;
+  }
+
+  if (!stats_) {
+    event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
+    return;
+  }
 
-  event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
+  // To measure each iteration of the loop, libevent is run one iteration at a time. It keeps the
+  // exit flag set until the next event_base_loop(), which tells when exit() was called.
+  if (type == RunType::NonBlock) {
+    runLoopIteration(EVLOOP_NONBLOCK);
+    return;
+  }
+  while (runLoopIteration(EVLOOP_ONCE) == 0 && !event_base_got_exit(base_.get())) {
+  }
+}
+
+int DispatcherImpl::runLoop(int flags) {
+  return stats_ ? runLoopIteration(flags) : event_base_loop(base_.get(), flags);
+}
+
+void DispatcherImpl::runBusyPoll() {
+  // The loop polls without blocking for as long as it finds events, and for up to the budget
+  // after the last one, before it blocks again. Like with stats, libevent is run one iteration at a
+  // time and the exit flag tells when exit() was called.
+  MonotonicTimeSource& time_source = ProdMonotonicTimeSource::instance_;
+  const auto us = [](std::chrono::nanoseconds time) -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+  };
+
+  MonotonicTime idle_since = time_source.currentTime();
+  while (true) {
+    const MonotonicTime iteration_start = time_source.currentTime();
+    const uint64_t callbacks_run = callbacks_run_;
+    if (runLoop(EVLOOP_NONBLOCK) != 0 || event_base_got_exit(base_.get())) {
+      return;
+    }
+
+    if (callbacks_run_ != callbacks_run) {
+      busy_poll_stats_->busy_poll_wakeups_.inc();
+      busy_poll_stats_->busy_poll_spin_us_.add(us(iteration_start - idle_since));
+      idle_since = time_source.currentTime();
+      continue;
+    }
+
+    const MonotonicTime now = time_source.currentTime();
+    if (now - idle_since < busy_poll_budget_) {
+      continue;
+    }
+
+    busy_poll_stats_->busy_poll_sleeps_.inc();
+    busy_poll_stats_->busy_poll_spin_us_.add(us(now - idle_since));
+    if (runLoop(EVLOOP_ONCE) != 0 || event_base_got_exit(base_.get())) {
+      return;
+    }
+    idle_since = time_source.currentTime();
+  }
+}
+
+int DispatcherImpl::runLoopIteration(int flags) {
+  for (std::chrono::nanoseconds& time : type_callback_time_) {
+    time = std::chrono::nanoseconds::zero();
+  }
+  callback_time_ = std::chrono::nanoseconds::zero();
+
+  const MonotonicTime start = ProdMonotonicTimeSource::instance_.currentTime();
+  const int rc = event_base_loop(base_.get(), flags);
+  const std::chrono::nanoseconds loop_time =
+      ProdMonotonicTimeSource::instance_.currentTime() - start;
+
+  const auto us = [](std::chrono::nanoseconds time) -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+  };
+  stats_->loop_duration_us_.recordValue(us(loop_time));
+  stats_->poll_duration_us_.recordValue(us(loop_time - callback_time_));
+  stats_->io_duration_us_.recordValue(us(type_callback_time_[static_cast<int>(CallbackType::Io)]));
+  stats_->timer_duration_us_.recordValue(
+      us(type_callback_time_[static_cast<int>(CallbackType::Timer)]));
+  stats_->post_duration_us_.recordValue(
+      us(type_callback_time_[static_cast<int>(CallbackType::Post)]));
+  return rc;
 }
 
 void DispatcherImpl::runPostCallbacks() {
-  std::unique_lock<std::mutex> lock(post_lock_);
-  while (!post_callbacks_.empty()) {
-    std::function<void()> callback = post_callbacks_.front();
-    post_callbacks_.pop_front();
-
-    lock.unlock();
-    callback();
-    lock.lock();
+  // Callbacks posted while a batch runs are run as the next batch, in order.
+  std::vector<std::function<void()>> callbacks;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(post_lock_);
+      if (post_callbacks_.empty()) {
+        return;
+      }
+      callbacks.swap(post_callbacks_);
+    }
+
+    if (stats_) {
+      stats_->post_callbacks_.recordValue(callbacks.size());
+    }
+    for (std::function<void()>& callback : callbacks) {
+      callback();
+    }
+    callbacks.clear();
   }
 }
 
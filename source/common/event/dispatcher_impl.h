@@ -1,11 +1,14 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
-#include <list>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/network/connection_handler.h"
@@ -13,6 +16,7 @@
 #include "common/common/logger.h"
 #include "common/common/thread.h"
 #include "common/event/libevent.h"
+#include "common/event/timer_wheel.h"
 
 namespace Envoy {
 namespace Event {
@@ -31,8 +35,50 @@ public:
    */
   event_base& base() { return *base_; }
 
+  /**
+   * @return bool whether the event backend reports remote closes through the Closed file event
+   *         while reads are enabled too (EPOLLRDHUP), so that connections know a short read left
+   *         nothing more to read.
+   */
+  bool earlyCloseSupported() const { return early_close_supported_; }
+
+  /**
+   * @return std::chrono::microseconds the busy poll budget, or 0 if the dispatcher does not busy
+   *         poll. @see Dispatcher::enableBusyPoll().
+   */
+  std::chrono::microseconds busyPollBudget() const { return busy_poll_budget_; }
+
+  /**
+   * The kinds of event loop callbacks which the dispatcher stats tell apart.
+   */
+  enum class CallbackType { Io, Timer, Post };
+
+  /**
+   * Run a callback for the event loop, accounting the time it takes to the given type when the
+   * dispatcher records stats. Time spent in callbacks nested in it, such as the posted callbacks
+   * which a timer runs, is accounted to their own type.
+   */
+  template <class Callback> void runCallback(CallbackType type, Callback callback) {
+    callbacks_run_++;
+    if (!stats_) {
+      callback();
+      return;
+    }
+
+    const CallbackStart start = startCallback();
+    callback();
+    endCallback(type, start);
+  }
+
+
   // Event::Dispatcher
   void clearDeferredDeleteList() override;
+  void initializeStats(Stats::Scope& scope, const std::string& prefix) override;
+  void enableBusyPoll(std::chrono::microseconds budget, Stats::Scope& scope,
+                      const std::string& prefix) override;
+  void setDeferredDeleteBudget(std::chrono::microseconds budget) override {
+    deferred_delete_budget_ = budget;
+  }
   Network::ClientConnectionPtr
   createClientConnection(Network::Address::InstanceConstSharedPtr address,
                          Network::Address::InstanceConstSharedPtr source_address) override;
@@ -54,6 +100,7 @@ public:
                                          Network::ListenerCallbacks& cb, Stats::Scope& scope,
                                          const Network::ListenerOptions& listener_options) override;
   TimerPtr createTimer(TimerCb cb) override;
+  TimerPtr createCoarseTimer(TimerCb cb) override;
   void deferredDelete(DeferredDeletablePtr&& to_delete) override;
   void exit() override;
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override;
@@ -62,6 +109,18 @@ public:
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
 
 private:
+  struct CallbackStart {
+    MonotonicTime time_;
+    // callback_time_ when the callback started, to tell the time of nested callbacks apart.
+    std::chrono::nanoseconds nested_;
+  };
+
+  CallbackStart startCallback();
+  void endCallback(CallbackType type, const CallbackStart& start);
+  void deleteDeferred(std::chrono::microseconds budget);
+  int runLoop(int flags);
+  int runLoopIteration(int flags);
+  void runBusyPoll();
   void runPostCallbacks();
 #ifndef NDEBUG
   // Validate that an operation is thread safe, i.e. it's invoked on the same thread that the
@@ -75,14 +134,31 @@ private:
   Thread::ThreadId run_tid_{};
   Buffer::WatermarkFactoryPtr buffer_factory_;
   Libevent::BasePtr base_;
+  const bool early_close_supported_;
+  TimerWheel coarse_timers_;
   TimerPtr deferred_delete_timer_;
   TimerPtr post_timer_;
-  std::vector<DeferredDeletablePtr> to_delete_1_;
-  std::vector<DeferredDeletablePtr> to_delete_2_;
-  std::vector<DeferredDeletablePtr>* current_to_delete_;
+  // Items are submitted to to_delete_, which a pass over the deferred deletion list swaps with the
+  // emptied deleting_, so that the items submitted while deleting wait for the next pass.
+  std::vector<DeferredDeletablePtr> to_delete_;
+  std::vector<DeferredDeletablePtr> deleting_;
+  // The next item of deleting_ to delete, when a pass ran out of budget before the end.
+  size_t deleting_index_{};
+  std::chrono::microseconds deferred_delete_budget_{};
   std::mutex post_lock_;
-  std::list<std::function<void()>> post_callbacks_;
+  // The loop takes all the callbacks out at once and hands the emptied vector back, so after warm
+  // up posting only moves a callback in.
+  std::vector<std::function<void()>> post_callbacks_;
   bool deferred_deleting_{};
+  std::unique_ptr<DispatcherStats> stats_;
+  // Time spent in callbacks of each type, and in all of them, during the current loop iteration.
+  std::chrono::nanoseconds type_callback_time_[3]{};
+  std::chrono::nanoseconds callback_time_{};
+  // Counts the callbacks the loop runs, so that busy polling can tell whether an iteration found
+  // any events.
+  uint64_t callbacks_run_{};
+  std::chrono::microseconds busy_poll_budget_{};
+  std::unique_ptr<BusyPollStats> busy_poll_stats_;
 };
 
 } // namespace Event
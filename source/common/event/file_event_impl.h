@@ -26,8 +26,8 @@ public:
 private:
   void assignEvents(uint32_t events);
 
+  DispatcherImpl& dispatcher_;
   FileReadyCb cb_;
-  event_base* base_;
   int fd_;
   FileTriggerType trigger_;
 };
@@ -10,11 +10,17 @@
 namespace Envoy {
 namespace Event {
 
-TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : cb_(cb) {
+TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : dispatcher_(dispatcher), cb_(cb) {
   ASSERT(cb_);
-  evtimer_assign(
-      &raw_event_, &dispatcher.base(),
-      [](evutil_socket_t, short, void* arg) -> void { static_cast<TimerImpl*>(arg)->cb_(); }, this);
+  evtimer_assign(&raw_event_, &dispatcher.base(),
+                 [](evutil_socket_t, short, void* arg) -> void {
+                   TimerImpl* timer = static_cast<TimerImpl*>(arg);
+                   // The callback may delete the timer, so the dispatcher is held on to.
+                   DispatcherImpl& dispatcher = timer->dispatcher_;
+                   dispatcher.runCallback(DispatcherImpl::CallbackType::Timer,
+                                          [timer]() -> void { timer->cb_(); });
+                 },
+                 this);
 }
 
 void TimerImpl::disableTimer() { event_del(&raw_event_); }
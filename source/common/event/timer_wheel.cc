@@ -0,0 +1,123 @@
+#include "common/event/timer_wheel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Event {
+
+TimerWheel::TimerWheel(Dispatcher& dispatcher, MonotonicTimeSource& time_source,
+                       std::chrono::milliseconds tick, uint32_t num_slots)
+    : time_source_(time_source), tick_(tick), slots_(num_slots, nullptr),
+      ticker_(dispatcher.createTimer([this]() -> void { onTick(); })) {
+  ASSERT(tick_.count() > 0);
+  ASSERT(num_slots > 0);
+}
+
+TimerPtr TimerWheel::createTimer(TimerCb cb) { return TimerPtr{new WheelTimer(*this, cb)}; }
+
+void TimerWheel::WheelTimer::disableTimer() {
+  if (list_ != nullptr) {
+    wheel_.unlink(*this);
+  }
+}
+
+void TimerWheel::WheelTimer::enableTimer(const std::chrono::milliseconds& d) {
+  wheel_.enable(*this, d);
+}
+
+void TimerWheel::armTicker(MonotonicTime now) {
+  // Round up, so that the ticker fires once the tick is reached rather than just before.
+  const MonotonicTime next_tick_time = start_time_ + tick_ * (current_tick_ + 1);
+  const std::chrono::milliseconds delay =
+      std::chrono::duration_cast<std::chrono::milliseconds>(next_tick_time - now) +
+      std::chrono::milliseconds(1);
+  ticker_->enableTimer(std::max(delay, std::chrono::milliseconds(1)));
+}
+
+void TimerWheel::enable(WheelTimer& timer, std::chrono::milliseconds d) {
+  if (timer.list_ != nullptr) {
+    unlink(timer);
+  }
+
+  const MonotonicTime now = time_source_.currentTime();
+  if (!ticking_) {
+    // Nothing is enabled, so restart counting ticks from now.
+    start_time_ = now;
+    current_tick_ = 0;
+    ticking_ = true;
+    armTicker(now);
+  }
+
+  // The first tick at or after the expiry, which must not be a tick that was already processed.
+  const std::chrono::nanoseconds expiry = now - start_time_ + d;
+  timer.expiry_tick_ = std::max<uint64_t>(current_tick_ + 1,
+                                          (expiry + tick_ - std::chrono::nanoseconds(1)) / tick_);
+  link(timer, slots_[timer.expiry_tick_ % slots_.size()]);
+}
+
+void TimerWheel::link(WheelTimer& timer, WheelTimer*& list) {
+  timer.list_ = &list;
+  timer.prev_ = nullptr;
+  timer.next_ = list;
+  if (list != nullptr) {
+    list->prev_ = &timer;
+  }
+  list = &timer;
+  num_enabled_++;
+}
+
+void TimerWheel::onTick() {
+  const MonotonicTime now = time_source_.currentTime();
+  const uint64_t now_tick = (now - start_time_) / tick_;
+
+  // Move the timers which expired to a list of their own before running any callback, as the
+  // callbacks can enable, disable and destroy any timer. If the ticker fell behind by a whole turn
+  // of the wheel, each slot only has to be checked once.
+  const uint64_t ticks =
+      std::min<uint64_t>(now_tick > current_tick_ ? now_tick - current_tick_ : 0, slots_.size());
+  for (uint64_t i = 1; i <= ticks; i++) {
+    WheelTimer* timer = slots_[(current_tick_ + i) % slots_.size()];
+    while (timer != nullptr) {
+      WheelTimer* next = timer->next_;
+      if (timer->expiry_tick_ <= now_tick) {
+        unlink(*timer);
+        link(*timer, expired_);
+      }
+      timer = next;
+    }
+  }
+  current_tick_ = std::max(current_tick_, now_tick);
+
+  while (expired_ != nullptr) {
+    WheelTimer& timer = *expired_;
+    unlink(timer);
+    timer.cb_();
+  }
+
+  if (num_enabled_ > 0) {
+    armTicker(time_source_.currentTime());
+  } else {
+    ticking_ = false;
+  }
+}
+
+void TimerWheel::unlink(WheelTimer& timer) {
+  ASSERT(timer.list_ != nullptr);
+  if (timer.prev_ != nullptr) {
+    timer.prev_->next_ = timer.next_;
+  } else {
+    *timer.list_ = timer.next_;
+  }
+  if (timer.next_ != nullptr) {
+    timer.next_->prev_ = timer.prev_;
+  }
+  timer.list_ = nullptr;
+  num_enabled_--;
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * Hashed timer wheel for coarse timers, which fire on a tick of the wheel rather than when they
+ * expire, so up to a tick late, in exchange for enabling and disabling in constant time. An enabled
+ * timer is kept in the slot of the tick it expires on, modulo the number of slots, and the slot is
+ * checked as the wheel reaches each of its ticks; timers which expire turns of the wheel later stay
+ * in it. A single dispatcher timer drives the wheel while any of its timers are enabled. Not thread
+ * safe, like the dispatcher. The wheel must outlive its timers.
+ */
+class TimerWheel : NonCopyable {
+public:
+  TimerWheel(Dispatcher& dispatcher, MonotonicTimeSource& time_source,
+             std::chrono::milliseconds tick, uint32_t num_slots);
+
+  /**
+   * Allocate a timer on the wheel. @see Event::Timer.
+   * @param cb supplies the callback to invoke when the timer fires.
+   */
+  TimerPtr createTimer(TimerCb cb);
+
+  /**
+   * @return uint64_t the number of enabled timers.
+   */
+  uint64_t numEnabled() const { return num_enabled_; }
+
+private:
+  class WheelTimer : public Timer {
+  public:
+    WheelTimer(TimerWheel& wheel, TimerCb cb) : wheel_(wheel), cb_(cb) {}
+    ~WheelTimer() { disableTimer(); }
+
+    // Event::Timer
+    void disableTimer() override;
+    void enableTimer(const std::chrono::milliseconds& d) override;
+
+  private:
+    TimerWheel& wheel_;
+    const TimerCb cb_;
+    uint64_t expiry_tick_{};
+    // The head of the list the timer is in while it is enabled, either the list of a slot or the
+    // list of expired timers, and its neighbours in that list.
+    WheelTimer** list_{};
+    WheelTimer* prev_{};
+    WheelTimer* next_{};
+
+    friend class TimerWheel;
+  };
+
+  void armTicker(MonotonicTime now);
+  void enable(WheelTimer& timer, std::chrono::milliseconds d);
+  void link(WheelTimer& timer, WheelTimer*& list);
+  void onTick();
+  void unlink(WheelTimer& timer);
+
+  MonotonicTimeSource& time_source_;
+  const std::chrono::milliseconds tick_;
+  std::vector<WheelTimer*> slots_;
+  WheelTimer* expired_{};
+  TimerPtr ticker_;
+  bool ticking_{};
+  // Ticks are counted from start_time_, which is reset whenever the wheel starts ticking again.
+  MonotonicTime start_time_;
+  uint64_t current_tick_{};
+  uint64_t num_enabled_{};
+};
+
+} // namespace Event
+} // namespace Envoy
@@ -1,6 +1,8 @@
 #include "common/filesystem/filesystem_impl.h"
 
 #include <dirent.h>
+#include <limits.h>
+#include <sys/uio.h>
 
 #include <chrono>
 #include <cstdint>
@@ -57,6 +59,7 @@ FileImpl::FileImpl(const std::string& path, Event::Dispatcher& dispatcher,
                    Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec)
     : path_(path), file_lock_(lock), flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
+        std::lock_guard<std::mutex> lock(flush_event_lock_);
         flush_event_.notify_one();
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
@@ -79,7 +82,7 @@ void FileImpl::reopen() { reopen_file_ = true; }
 
 FileImpl::~FileImpl() {
   {
-    std::unique_lock<std::mutex> lock(write_lock_);
+    std::unique_lock<std::mutex> lock(flush_event_lock_);
     flush_thread_exit_ = true;
     flush_event_.notify_one();
   }
@@ -90,8 +93,9 @@ FileImpl::~FileImpl() {
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (fd_ != -1) {
-    if (flush_buffer_.length() > 0) {
-      doWrite(flush_buffer_);
+    moveWriteBuffers(about_to_write_buffer_);
+    if (about_to_write_buffer_.length() > 0) {
+      doWrite(about_to_write_buffer_);
     }
 
     os_sys_calls_.close(fd_);
@@ -106,16 +110,24 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   // We must do the actual writes to disk under lock, so that we don't intermix chunks from
   // different FileImpl pointing to the same underlying file. This can happen either via hot
   // restart or if calling code opens the same underlying file into a different FileImpl in the
-  // same process.
-  // TODO PERF: Currently, we use a single cross process lock to serialize all disk writes. This
-  //            will never block network workers, but does mean that only a single flush thread can
-  //            actually flush to disk. In the future it would be nice if we did away with the cross
-  //            process lock or had multiple locks.
+  // same process. The slices are written with as few writev() calls as possible, which keeps the
+  // lock held for a short time.
   {
     std::lock_guard<Thread::BasicLockable> lock(file_lock_);
-    for (Buffer::RawSlice& slice : slices) {
-      ssize_t rc = os_sys_calls_.write(fd_, slice.mem_, slice.len_);
-      ASSERT(rc == static_cast<ssize_t>(slice.len_));
+    uint64_t slice = 0;
+    while (slice < num_slices) {
+      iovec iov[IOV_MAX];
+      uint64_t num_iov = 0;
+      size_t num_bytes = 0;
+      for (; slice < num_slices && num_iov < IOV_MAX; slice++) {
+        iov[num_iov].iov_base = slices[slice].mem_;
+        iov[num_iov].iov_len = slices[slice].len_;
+        num_bytes += slices[slice].len_;
+        num_iov++;
+      }
+
+      ssize_t rc = os_sys_calls_.writev(fd_, iov, num_iov);
+      ASSERT(rc == static_cast<ssize_t>(num_bytes));
       UNREFERENCED_PARAMETER(rc);
       stats_.write_completed_.inc();
     }
@@ -125,28 +137,44 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   buffer.drain(buffer.length());
 }
 
+void FileImpl::moveWriteBuffers(Buffer::Instance& buffer) {
+  for (WriteBuffer& write_buffer : write_buffers_) {
+    std::lock_guard<std::mutex> lock(write_buffer.lock_);
+    write_buffered_bytes_ -= write_buffer.buffer_.length();
+    buffer.move(write_buffer.buffer_);
+  }
+}
+
+FileImpl::WriteBuffer& FileImpl::threadWriteBuffer() {
+  // Threads are handed out the buffers in turn the first time they write to any file, so that
+  // up to NUM_WRITE_BUFFERS workers never share a buffer.
+  static std::atomic<uint32_t> next_index{};
+  static thread_local const uint32_t index = next_index++;
+  return write_buffers_[index % NUM_WRITE_BUFFERS];
+}
+
 void FileImpl::flushThreadFunc() {
 
   while (true) {
-    std::unique_lock<std::mutex> flush_lock;
-
     {
-      std::unique_lock<std::mutex> write_lock(write_lock_);
+      std::unique_lock<std::mutex> flush_event_lock(flush_event_lock_);
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_) {
-        flush_event_.wait(write_lock);
+      // flush_event_ can be woken up either by large enough write buffers or by timer.
+      // In case it was timer, the write buffers can be empty.
+      while (write_buffered_bytes_ == 0 && !flush_thread_exit_) {
+        flush_event_.wait(flush_event_lock);
       }
 
       if (flush_thread_exit_) {
         return;
       }
+    }
 
-      flush_lock = std::unique_lock<std::mutex>(flush_lock_);
-      ASSERT(flush_buffer_.length() > 0);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
+    std::unique_lock<std::mutex> flush_lock(flush_lock_);
+    moveWriteBuffers(about_to_write_buffer_);
+    if (about_to_write_buffer_.length() == 0) {
+      // A synchronous flush() got to the data first.
+      continue;
     }
 
     // if we failed to open file before (-1 == fd_), then simply ignore
@@ -167,40 +195,35 @@ void FileImpl::flushThreadFunc() {
 }
 
 void FileImpl::flush() {
-  std::unique_lock<std::mutex> flush_buffer_lock;
-
-  {
-    std::lock_guard<std::mutex> write_lock(write_lock_);
-
-    // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
-    // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
-    // but has not yet completed doWrite().  This would allow flush() to
-    // return before the pending data has actually been written to disk.
-    flush_buffer_lock = std::unique_lock<std::mutex>(flush_lock_);
-
-    if (flush_buffer_.length() == 0) {
-      return;
-    }
-
-    about_to_write_buffer_.move(flush_buffer_);
-    ASSERT(flush_buffer_.length() == 0);
+  // flush_lock_ must be held while moving the data or else it is possible that flushThreadFunc()
+  // has already moved data from the write buffers to about_to_write_buffer_ but has not yet
+  // completed doWrite(). This would allow flush() to return before the pending data has actually
+  // been written to disk.
+  std::lock_guard<std::mutex> flush_lock(flush_lock_);
+  moveWriteBuffers(about_to_write_buffer_);
+  if (about_to_write_buffer_.length() == 0) {
+    return;
   }
 
   doWrite(about_to_write_buffer_);
 }
 
 void FileImpl::write(const std::string& data) {
-  std::lock_guard<std::mutex> lock(write_lock_);
-
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
-  }
+  std::call_once(flush_thread_once_, [this]() -> void { createFlushStructures(); });
 
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
-  flush_buffer_.add(data);
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
+  uint64_t buffered_bytes;
+  {
+    WriteBuffer& write_buffer = threadWriteBuffer();
+    std::lock_guard<std::mutex> lock(write_buffer.lock_);
+    write_buffer.buffer_.add(data);
+    buffered_bytes = write_buffered_bytes_ += data.length();
+  }
+
+  // Only the write which crosses the threshold has to wake up the flush thread.
+  if (buffered_bytes > MIN_FLUSH_SIZE && buffered_bytes - data.length() <= MIN_FLUSH_SIZE) {
+    std::lock_guard<std::mutex> lock(flush_event_lock_);
     flush_event_.notify_one();
   }
 }
@@ -76,21 +76,35 @@ public:
   void flush() override;
 
 private:
+  /**
+   * A buffer which a subset of the writing threads append to. Spreading the writers over several
+   * buffers keeps workers logging to the same file from all contending on one lock.
+   */
+  struct WriteBuffer {
+    std::mutex lock_;
+    Buffer::OwnedImpl buffer_;
+  };
+
   void doWrite(Buffer::Instance& buffer);
   void flushThreadFunc();
   void open();
   void createFlushStructures();
+  void moveWriteBuffers(Buffer::Instance& buffer);
+  WriteBuffer& threadWriteBuffer();
 
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
+  // Number of write buffers. Each writing thread sticks to one of them.
+  static const uint32_t NUM_WRITE_BUFFERS = 16;
 
   int fd_;
   std::string path_;
 
   // These locks are always acquired in the following order if multiple locks are held:
-  //    1) write_lock_
-  //    2) flush_lock_
+  //    1) flush_lock_
+  //    2) the lock_ of a write buffer
   //    3) file_lock_
+  // flush_event_lock_ is never held together with any of them.
   Thread::BasicLockable& file_lock_; // This lock is used only by the flush thread when writing
                                      // to disk. This is used to make sure that file blocks do
                                      // not get interleaved by multiple processes writing to
@@ -100,19 +114,20 @@ private:
                                      // concurrent access to the about_to_write_buffer_, fd_,
                                      // and all other data used during flushing and file
                                      // re-opening.
-  std::mutex write_lock_;            // The lock is used when filling the flush buffer. It allows
-                                     // multiple threads to write to the same file at relatively
-                                     // high performance.  It is always local to the process.
+  std::mutex flush_event_lock_;      // This lock is only used to wait on and signal flush_event_.
   Thread::ThreadPtr flush_thread_;
+  std::once_flag flush_thread_once_;
   std::condition_variable_any flush_event_;
   std::atomic<bool> flush_thread_exit_{};
   std::atomic<bool> reopen_file_{};
-  Buffer::OwnedImpl flush_buffer_; // This buffer is used by multiple threads. It gets filled and
-                                   // then flushed either when max size is reached or when a timer
-                                   // fires.
+  WriteBuffer write_buffers_[NUM_WRITE_BUFFERS]; // These buffers are filled by the writing
+                                                 // threads and then flushed either when
+                                                 // MIN_FLUSH_SIZE is reached or when a timer
+                                                 // fires.
+  std::atomic<uint64_t> write_buffered_bytes_{}; // Bytes in write_buffers_ across all of them.
   Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only by the flush thread. Data
-                                            // is moved from flush_buffer_ under lock, and then
-                                            // the lock is released so that flush_buffer_ can
+                                            // is moved from write_buffers_ under their locks,
+                                            // which are released right away so that they can
                                             // continue to fill. This buffer is then used for the
                                             // final write to disk.
   Event::TimerPtr flush_timer_;
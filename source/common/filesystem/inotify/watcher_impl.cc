@@ -1,7 +1,10 @@
 #include <sys/inotify.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
@@ -51,11 +54,14 @@ void WatcherImpl::addWatch(const std::string& path, uint32_t events, OnChangedCb
 }
 
 void WatcherImpl::onInotifyEvent() {
+  // A burst of changes to a file, such as several link swaps in a row, is read in one go and
+  // raised once, with all of its events, after the whole queue has been read.
+  std::vector<std::pair<FileWatch*, uint32_t>> pending;
   while (true) {
     uint8_t buffer[sizeof(inotify_event) + NAME_MAX + 1];
     ssize_t rc = read(inotify_fd_, &buffer, sizeof(buffer));
     if (rc == -1 && errno == EAGAIN) {
-      return;
+      break;
     }
     RELEASE_ASSERT(rc >= 0);
 
@@ -81,13 +87,26 @@ void WatcherImpl::onInotifyEvent() {
       for (FileWatch& watch : callback_map_[file_event->wd].watches_) {
         if (watch.file_ == file && (watch.events_ & events)) {
           ENVOY_LOG(debug, "matched callback: file: {}", file);
-          watch.cb_(events);
+          auto it = std::find_if(pending.begin(), pending.end(),
+                                 [&watch](const std::pair<FileWatch*, uint32_t>& entry) -> bool {
+                                   return entry.first == &watch;
+                                 });
+          if (it == pending.end()) {
+            pending.emplace_back(&watch, watch.events_ & events);
+          } else {
+            it->second |= watch.events_ & events;
+          }
         }
       }
 
       index += sizeof(inotify_event) + file_event->len;
     }
   }
+
+  // Watches are only ever added, so the pointers stay valid while the callbacks run.
+  for (const auto& entry : pending) {
+    entry.first->cb_(entry.second);
+  }
 }
 
 } // namespace Filesystem
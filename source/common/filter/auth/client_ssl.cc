@@ -1,7 +1,10 @@
 #include "common/filter/auth/client_ssl.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "envoy/network/connection.h"
@@ -21,12 +24,118 @@ namespace Filter {
 namespace Auth {
 namespace ClientSsl {
 
+namespace {
+
+const std::array<uint8_t, 32> ZeroDigest{};
+
+} // namespace
+
+void AllowedPrincipals::add(const std::string& sha256_digest) {
+  Digest digest;
+  if (!parseDigest(sha256_digest, digest) || contains(digest)) {
+    return;
+  }
+
+  if (digest == ZeroDigest) {
+    zero_digest_ = true;
+  } else {
+    // Keep the table at most half full so that probe sequences stay short.
+    if ((size_ + 1) * 2 > slots_.size()) {
+      std::vector<Digest> old_slots(std::max<size_t>(16, slots_.size() * 2));
+      old_slots.swap(slots_);
+      for (const Digest& old_digest : old_slots) {
+        if (old_digest != ZeroDigest) {
+          insert(old_digest);
+        }
+      }
+    }
+    insert(digest);
+  }
+  size_++;
+}
+
+bool AllowedPrincipals::allowed(const std::string& sha256_digest) const {
+  Digest digest;
+  return parseDigest(sha256_digest, digest) && contains(digest);
+}
+
+bool AllowedPrincipals::sameAs(const AllowedPrincipals& other) const {
+  if (size_ != other.size_ || zero_digest_ != other.zero_digest_) {
+    return false;
+  }
+
+  for (const Digest& digest : slots_) {
+    if (digest != ZeroDigest && !other.contains(digest)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AllowedPrincipals::parseDigest(const std::string& sha256_digest, Digest& digest) {
+  if (sha256_digest.size() != digest.size() * 2) {
+    return false;
+  }
+
+  for (size_t i = 0; i < sha256_digest.size(); i++) {
+    const char c = sha256_digest[i];
+    uint8_t nibble;
+    if (c >= '0' && c <= '9') {
+      nibble = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      nibble = c - 'a' + 10;
+    } else {
+      return false;
+    }
+    if (i % 2 == 0) {
+      digest[i / 2] = nibble << 4;
+    } else {
+      digest[i / 2] |= nibble;
+    }
+  }
+  return true;
+}
+
+bool AllowedPrincipals::contains(const Digest& digest) const {
+  if (digest == ZeroDigest) {
+    return zero_digest_;
+  }
+  if (slots_.empty()) {
+    return false;
+  }
+
+  // The digests are uniformly distributed, so their first bytes are as good as any hash.
+  uint64_t hash;
+  memcpy(&hash, digest.data(), sizeof(hash));
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    if (slots_[i] == digest) {
+      return true;
+    }
+    if (slots_[i] == ZeroDigest) {
+      return false;
+    }
+  }
+}
+
+void AllowedPrincipals::insert(const Digest& digest) {
+  uint64_t hash;
+  memcpy(&hash, digest.data(), sizeof(hash));
+  const size_t mask = slots_.size() - 1;
+  size_t i = hash & mask;
+  while (slots_[i] != ZeroDigest) {
+    i = (i + 1) & mask;
+  }
+  slots_[i] = digest;
+}
+
 Config::Config(const Json::Object& config, ThreadLocal::SlotAllocator& tls,
                Upstream::ClusterManager& cm, Event::Dispatcher& dispatcher, Stats::Scope& scope,
                Runtime::RandomGenerator& random)
     : RestApiFetcher(cm, config.getString("auth_api_cluster"), dispatcher, random,
                      std::chrono::milliseconds(config.getInteger("refresh_delay_ms", 60000))),
-      tls_(tls.allocateSlot()), ip_white_list_(config, "ip_white_list"),
+      tls_(tls.allocateSlot()), principals_(new AllowedPrincipals()),
+      ip_white_list_(config, "ip_white_list"),
       stats_(generateStats(scope, config.getString("stat_prefix"))) {
 
   config.validateSchema(Json::Schema::CLIENT_SSL_NETWORK_FILTER_SCHEMA);
@@ -36,7 +145,7 @@ Config::Config(const Json::Object& config, ThreadLocal::SlotAllocator& tls,
         fmt::format("unknown cluster '{}' in client ssl auth config", remote_cluster_name_));
   }
 
-  AllowedPrincipalsSharedPtr empty(new AllowedPrincipals());
+  AllowedPrincipalsSharedPtr empty = principals_;
   tls_->set(
       [empty](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr { return empty; });
 }
@@ -65,9 +174,13 @@ void Config::parseResponse(const Http::Message& message) {
     new_principals->add(certificate->getString("fingerprint_sha256"));
   }
 
-  tls_->set([new_principals](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-    return new_principals;
-  });
+  // Most refreshes return the same list. The workers then keep the snapshot they have.
+  if (!new_principals->sameAs(*principals_)) {
+    principals_ = new_principals;
+    tls_->set([new_principals](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+      return new_principals;
+    });
+  }
 
   stats_.update_success_.inc();
   stats_.total_principals_.set(new_principals->size());
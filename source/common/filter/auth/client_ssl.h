@@ -1,9 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
-#include <unordered_set>
+#include <vector>
 
 #include "envoy/network/filter.h"
 #include "envoy/runtime/runtime.h"
@@ -43,22 +44,43 @@ struct GlobalStats {
 };
 
 /**
- * Wraps the principals currently allowed to authenticate.
+ * Wraps the principals currently allowed to authenticate. The SHA-256 digests are kept as 32
+ * bytes in an open addressing table rather than as hex strings, so that large lists stay compact.
+ * A snapshot is built on the main thread and shared read only by every worker.
  */
 class AllowedPrincipals : public ThreadLocal::ThreadLocalObject {
 public:
-  void add(const std::string& sha256_digest) {
-    if (!sha256_digest.empty()) {
-      allowed_sha256_digests_.emplace(sha256_digest);
-    }
-  }
-  bool allowed(const std::string& sha256_digest) const {
-    return allowed_sha256_digests_.count(sha256_digest) != 0;
-  }
-  size_t size() const { return allowed_sha256_digests_.size(); }
+  /**
+   * Allow a principal. Only digests of 64 lowercase hex digits, as computed for the peer
+   * certificates, are kept, as no other could ever match.
+   * @param sha256_digest supplies the hex SHA-256 digest of the principal's certificate.
+   */
+  void add(const std::string& sha256_digest);
+
+  /**
+   * @return bool whether a principal is allowed.
+   * @param sha256_digest supplies the hex SHA-256 digest of the principal's certificate.
+   */
+  bool allowed(const std::string& sha256_digest) const;
+
+  /**
+   * @return bool whether the same principals are allowed as by another set.
+   */
+  bool sameAs(const AllowedPrincipals& other) const;
+
+  size_t size() const { return size_; }
 
 private:
-  std::unordered_set<std::string> allowed_sha256_digests_;
+  typedef std::array<uint8_t, 32> Digest;
+
+  static bool parseDigest(const std::string& sha256_digest, Digest& digest);
+  bool contains(const Digest& digest) const;
+  void insert(const Digest& digest);
+
+  // Unused slots are all zero. The all zero digest itself is tracked on the side.
+  std::vector<Digest> slots_;
+  bool zero_digest_{};
+  size_t size_{};
 };
 
 typedef std::shared_ptr<AllowedPrincipals> AllowedPrincipalsSharedPtr;
@@ -90,10 +112,13 @@ private:
   // Http::RestApiFetcher
   void createRequest(Http::Message& request) override;
   void parseResponse(const Http::Message& response) override;
+  void onResponseUnchanged() override { stats_.update_success_.inc(); }
   void onFetchComplete() override {}
   void onFetchFailure(const EnvoyException* e) override;
 
   ThreadLocal::SlotPtr tls_;
+  // The snapshot shared by the workers, kept to tell whether a new list changes anything.
+  AllowedPrincipalsSharedPtr principals_;
   Network::Address::IpList ip_white_list_;
   GlobalStats stats_;
 };
@@ -32,10 +32,6 @@ TcpProxyConfig::Route::Route(const Json::Object& config) {
     Network::Utility::parsePortRangeList(source_ports, source_port_ranges_);
   }
 
-  if (config.hasObject("destination_ip_list")) {
-    destination_ips_ = Network::Address::IpList(config.getStringArray("destination_ip_list"));
-  }
-
   if (config.hasObject("destination_ports")) {
     const std::string destination_ports = config.getString("destination_ports");
     Network::Utility::parsePortRangeList(destination_ports, destination_port_ranges_);
@@ -44,9 +40,11 @@ TcpProxyConfig::Route::Route(const Json::Object& config) {
 
 TcpProxyConfig::TcpProxyConfig(const Json::Object& config,
                                Upstream::ClusterManager& cluster_manager, Stats::Scope& scope)
-    : stats_(generateStats(config.getString("stat_prefix"), scope)) {
+    : stats_(generateStats(config.getString("stat_prefix"), scope)),
+      splice_(config.getBoolean("splice", false)) {
   config.validateSchema(Json::Schema::TCP_PROXY_NETWORK_FILTER_SCHEMA);
 
+  std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> destinations;
   for (const Json::ObjectSharedPtr& route_desc :
        config.getObject("route_config")->getObjectArray("routes")) {
     routes_.emplace_back(Route(*route_desc));
@@ -55,33 +53,61 @@ TcpProxyConfig::TcpProxyConfig(const Json::Object& config,
       throw EnvoyException(fmt::format("tcp proxy: unknown cluster '{}' in TCP route",
                                        route_desc->getString("cluster")));
     }
+
+    destinations.emplace_back(routes_.back().cluster_name_,
+                              std::vector<Network::Address::CidrRange>());
+    if (route_desc->hasObject("destination_ip_list")) {
+      destinations.back().second = Network::Address::IpList::parseRanges(
+          route_desc->getStringArray("destination_ip_list"));
+    }
+    if (destinations.back().second.empty()) {
+      any_destination_routes_.push_back(routes_.size() - 1);
+    }
   }
+
+  destination_trie_ = Network::Address::LpmTrie(destinations);
 }
 
-const std::string& TcpProxyConfig::getRouteFromEntries(Network::Connection& connection) {
-  for (const TcpProxyConfig::Route& route : routes_) {
-    if (!route.source_port_ranges_.empty() &&
-        !Network::Utility::portInRangeList(connection.remoteAddress(), route.source_port_ranges_)) {
-      continue;
-    }
+bool TcpProxyConfig::Route::matches(Network::Connection& connection) const {
+  if (!source_port_ranges_.empty() &&
+      !Network::Utility::portInRangeList(connection.remoteAddress(), source_port_ranges_)) {
+    return false;
+  }
 
-    if (!route.source_ips_.empty() && !route.source_ips_.contains(connection.remoteAddress())) {
-      continue;
-    }
+  if (!source_ips_.empty() && !source_ips_.contains(connection.remoteAddress())) {
+    return false;
+  }
 
-    if (!route.destination_port_ranges_.empty() &&
-        !Network::Utility::portInRangeList(connection.localAddress(),
-                                           route.destination_port_ranges_)) {
-      continue;
-    }
+  if (!destination_port_ranges_.empty() &&
+      !Network::Utility::portInRangeList(connection.localAddress(), destination_port_ranges_)) {
+    return false;
+  }
+
+  return true;
+}
 
-    if (!route.destination_ips_.empty() &&
-        !route.destination_ips_.contains(connection.localAddress())) {
-      continue;
+const std::string& TcpProxyConfig::getRouteFromEntries(Network::Connection& connection) {
+  // The candidates are the routes whose destination ranges contain the local address, and the
+  // routes without destination ranges. Both lists are in route order, so walking them together
+  // keeps the first matching route first.
+  const std::vector<uint32_t>& destination_routes =
+      destination_trie_.getTagIndexes(connection.localAddress());
+  auto destination_route = destination_routes.begin();
+  auto any_destination_route = any_destination_routes_.begin();
+  while (destination_route != destination_routes.end() ||
+         any_destination_route != any_destination_routes_.end()) {
+    uint32_t index;
+    if (any_destination_route == any_destination_routes_.end() ||
+        (destination_route != destination_routes.end() &&
+         *destination_route < *any_destination_route)) {
+      index = *destination_route++;
+    } else {
+      index = *any_destination_route++;
     }
 
-    // if we made it past all checks, the route matches
-    return route.cluster_name_;
+    if (routes_[index].matches(connection)) {
+      return routes_[index].cluster_name_;
+    }
   }
 
   // no match, no more routes to try
@@ -210,11 +236,11 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
     onInitFailure();
     return Network::FilterStatus::StopIteration;
   }
-  Upstream::Host::CreateConnectionData conn_info =
-      cluster_manager_.tcpConnForCluster(cluster_name, this);
+  Upstream::PooledTcpConnectionData conn_info =
+      cluster_manager_.pooledTcpConnForCluster(cluster_name, this);
 
-  upstream_connection_ = std::move(conn_info.connection_);
-  read_callbacks_->upstreamHost(conn_info.host_description_);
+  upstream_connection_ = std::move(conn_info.data_.connection_);
+  read_callbacks_->upstreamHost(conn_info.data_.host_description_);
   if (!upstream_connection_) {
     onInitFailure();
     return Network::FilterStatus::StopIteration;
@@ -230,21 +256,30 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_total_,
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_buffered_,
        &read_callbacks_->upstreamHost()->cluster().stats().bind_errors_});
-  upstream_connection_->connect();
-  upstream_connection_->noDelay(true);
+  if (!conn_info.pooled_) {
+    upstream_connection_->connect();
+    upstream_connection_->noDelay(true);
 
-  connect_timeout_timer_ = read_callbacks_->connection().dispatcher().createTimer(
-      [this]() -> void { onConnectTimeout(); });
-  connect_timeout_timer_->enableTimer(cluster->connectTimeout());
+    connect_timeout_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+        [this]() -> void { onConnectTimeout(); });
+    connect_timeout_timer_->enableTimer(cluster->connectTimeout());
+  }
 
   read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_total_.inc();
   read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_active_.inc();
   read_callbacks_->upstreamHost()->stats().cx_total_.inc();
   read_callbacks_->upstreamHost()->stats().cx_active_.inc();
-  connect_timespan_.reset(new Stats::Timespan(
-      read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_connect_ms_));
   connected_timespan_.reset(new Stats::Timespan(
       read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_length_ms_));
+  if (conn_info.pooled_) {
+    // The pooled connection was set up ahead of time, so there is no connect time to record and
+    // no Connected event to wait for.
+    spliceIfEnabled();
+    onConnectionSuccess();
+  } else {
+    connect_timespan_.reset(new Stats::Timespan(
+        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_connect_ms_));
+  }
 
   return Network::FilterStatus::Continue;
 }
@@ -257,6 +292,20 @@ void TcpProxy::onConnectTimeout() {
   onConnectTimeoutError();
 }
 
+void TcpProxy::spliceIfEnabled() {
+  // The WsHandlerImpl class uses TCP Proxy code with a null config.
+  if (!config_ || !config_->splice()) {
+    return;
+  }
+
+  // From here on the data moves between the connections in the kernel, and onData() and
+  // onUpstreamData() only see what either connection reads if the other one closes.
+  if (upstream_connection_->spliceWith(read_callbacks_->connection())) {
+    ENVOY_CONN_LOG(debug, "splicing with upstream connection", read_callbacks_->connection());
+    config_->stats().downstream_cx_spliced_total_.inc();
+  }
+}
+
 Network::FilterStatus TcpProxy::onData(Buffer::Instance& data) {
   ENVOY_CONN_LOG(trace, "received {} bytes", read_callbacks_->connection(), data.length());
   upstream_connection_->write(data);
@@ -294,6 +343,7 @@ void TcpProxy::onUpstreamEvent(Network::ConnectionEvent event) {
     read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_destroy_local_.inc();
   } else if (event == Network::ConnectionEvent::Connected) {
     connect_timespan_->complete();
+    spliceIfEnabled();
     onConnectionSuccess();
   }
 
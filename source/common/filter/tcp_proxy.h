@@ -33,6 +33,7 @@ namespace Filter {
   GAUGE  (downstream_cx_tx_bytes_buffered)                                                         \
   COUNTER(downstream_cx_total)                                                                     \
   COUNTER(downstream_cx_no_route)                                                                  \
+  COUNTER(downstream_cx_spliced_total)                                                             \
   COUNTER(downstream_flow_control_paused_reading_total)                                            \
   COUNTER(downstream_flow_control_resumed_reading_total)
 // clang-format on
@@ -64,13 +65,26 @@ public:
 
   const TcpProxyStats& stats() { return stats_; }
 
+  /**
+   * @return bool whether the data of plaintext connections is spliced between the downstream and
+   *         upstream sockets rather than copied through their buffers.
+   */
+  bool splice() const { return splice_; }
+
 private:
+  /**
+   * A route. Its destination ranges are kept in destination_trie_ rather than in the route.
+   */
   struct Route {
     Route(const Json::Object& config);
 
+    /**
+     * @return whether the route matches a connection on everything but the destination ranges.
+     */
+    bool matches(Network::Connection& connection) const;
+
     Network::Address::IpList source_ips_;
     Network::PortRangeList source_port_ranges_;
-    Network::Address::IpList destination_ips_;
     Network::PortRangeList destination_port_ranges_;
     std::string cluster_name_;
   };
@@ -78,7 +92,13 @@ private:
   static TcpProxyStats generateStats(const std::string& name, Stats::Scope& scope);
 
   std::vector<Route> routes_;
+  // The destination ranges of all routes, tagged with the index of their route, so that the
+  // routes which may match a connection are found without walking all of them.
+  Network::Address::LpmTrie destination_trie_;
+  // The indexes of the routes without destination ranges, which match any destination.
+  std::vector<uint32_t> any_destination_routes_;
   const TcpProxyStats stats_;
+  const bool splice_;
 };
 
 typedef std::shared_ptr<TcpProxyConfig> TcpProxyConfigSharedPtr;
@@ -166,8 +186,9 @@ protected:
 
   Network::FilterStatus initializeUpstreamConnection();
   void onConnectTimeout();
+  void spliceIfEnabled();
   void onDownstreamEvent(Network::ConnectionEvent event);
-  void onUpstreamData(Buffer::Instance& data);
+  virtual void onUpstreamData(Buffer::Instance& data);
   void onUpstreamEvent(Network::ConnectionEvent event);
 
   TcpProxyConfigSharedPtr config_;
@@ -38,8 +38,9 @@ public:
 
   // Decodes the given buffer with GRPC data frame. Drains the input buffer when
   // decoding succeeded (returns true). If the input is not sufficient to make a
-  // complete GRPC data frame, it will be buffered in the decoder. If a decoding
-  // error happened, the input buffer remains unchanged.
+  // complete GRPC data frame, it will be buffered in the decoder. The data of the
+  // frames is moved out of the input rather than copied. If a decoding error
+  // happened, the input buffer is left with the data from the invalid frame on.
   // @param input supplies the binary octets wrapped in a GRPC data frame.
   // @param output supplies the buffer to store the decoded data.
   // @return bool whether the decoding succeeded or not.
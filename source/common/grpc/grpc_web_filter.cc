@@ -91,10 +91,8 @@ Http::FilterDataStatus GrpcWebFilter::decodeData(Buffer::Instance& data, bool) {
   const uint64_t needed =
       (data.length() + decoding_buffer_.length()) / 4 * 4 - decoding_buffer_.length();
   decoding_buffer_.move(data, needed);
-  const std::string decoded = Base64::decode(
-      std::string(static_cast<const char*>(decoding_buffer_.linearize(decoding_buffer_.length())),
-                  decoding_buffer_.length()));
-  if (decoded.empty()) {
+  Buffer::OwnedImpl decoded;
+  if (!Base64::decode(decoding_buffer_, decoded)) {
     // Error happened when decoding base64.
     Http::Utility::sendLocalReply(*decoder_callbacks_, stream_destroyed_, Http::Code::BadRequest,
                                   "Bad gRPC-web request, invalid base64 data.");
@@ -103,7 +101,7 @@ Http::FilterDataStatus GrpcWebFilter::decodeData(Buffer::Instance& data, bool) {
 
   decoding_buffer_.drain(decoding_buffer_.length());
   decoding_buffer_.move(data);
-  data.add(decoded);
+  data.move(decoded);
   // Any block of 4 bytes or more should have been decoded and passed through.
   ASSERT(decoding_buffer_.length() < 4);
   return Http::FilterDataStatus::Continue;
@@ -155,9 +153,9 @@ Http::FilterDataStatus GrpcWebFilter::encodeData(Buffer::Instance& data, bool) {
     const uint32_t length = htonl(frame.length_);
     temp.add(&length, 4);
     if (frame.length_ > 0) {
-      temp.add(*frame.data_);
+      temp.move(*frame.data_);
     }
-    data.add(Base64::encode(temp, temp.length()));
+    Base64::encode(temp, temp.length(), data);
   }
   return Http::FilterDataStatus::Continue;
 }
@@ -192,7 +190,8 @@ Http::FilterTrailersStatus GrpcWebFilter::encodeTrailers(Http::HeaderMap& traile
   buffer.add(&length, 4);
   buffer.move(temp);
   if (is_text_response_) {
-    Buffer::OwnedImpl encoded(Base64::encode(buffer, buffer.length()));
+    Buffer::OwnedImpl encoded;
+    Base64::encode(buffer, buffer.length(), encoded);
     encoder_callbacks_->addEncodedData(encoded, true);
   } else {
     encoder_callbacks_->addEncodedData(buffer, true);
@@ -210,7 +209,7 @@ void GrpcWebFilter::setupStatTracking(const Http::HeaderMap& headers) {
 }
 
 void GrpcWebFilter::chargeStat(const Http::HeaderMap& headers) {
-  Common::chargeStat(*cluster_, "grpc-web", grpc_service_, grpc_method_, headers.GrpcStatus());
+  stats_cache_.chargeStat(cluster_, grpc_service_, grpc_method_, headers.GrpcStatus());
 }
 
 } // namespace Grpc
@@ -8,6 +8,7 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/non_copyable.h"
 #include "common/grpc/codec.h"
+#include "common/grpc/stats_cache.h"
 
 namespace Envoy {
 namespace Grpc {
@@ -17,7 +18,8 @@ namespace Grpc {
  */
 class GrpcWebFilter : public Http::StreamFilter, NonCopyable {
 public:
-  GrpcWebFilter(Upstream::ClusterManager& cm) : cm_(cm) {}
+  GrpcWebFilter(Upstream::ClusterManager& cm, StatsCache& stats_cache)
+      : cm_(cm), stats_cache_(stats_cache) {}
   virtual ~GrpcWebFilter(){};
 
   // Http::StreamFilterBase
@@ -52,6 +54,7 @@ private:
   const std::unordered_set<std::string>& gRpcWebContentTypes() const;
 
   Upstream::ClusterManager& cm_;
+  StatsCache& stats_cache_;
   Upstream::ClusterInfoConstSharedPtr cluster_;
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
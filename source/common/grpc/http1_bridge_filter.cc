@@ -17,7 +17,7 @@ namespace Envoy {
 namespace Grpc {
 
 void Http1BridgeFilter::chargeStat(const Http::HeaderMap& headers) {
-  Common::chargeStat(*cluster_, "grpc", grpc_service_, grpc_method_, headers.GrpcStatus());
+  stats_cache_.chargeStat(cluster_, grpc_service_, grpc_method_, headers.GrpcStatus());
 }
 
 Http::FilterHeadersStatus Http1BridgeFilter::decodeHeaders(Http::HeaderMap& headers, bool) {
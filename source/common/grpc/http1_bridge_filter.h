@@ -5,6 +5,8 @@
 #include "envoy/http/filter.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/grpc/stats_cache.h"
+
 namespace Envoy {
 namespace Grpc {
 
@@ -13,7 +15,8 @@ namespace Grpc {
  */
 class Http1BridgeFilter : public Http::StreamFilter {
 public:
-  Http1BridgeFilter(Upstream::ClusterManager& cm) : cm_(cm) {}
+  Http1BridgeFilter(Upstream::ClusterManager& cm, StatsCache& stats_cache)
+      : cm_(cm), stats_cache_(stats_cache) {}
 
   // Http::StreamFilterBase
   void onDestroy() override {}
@@ -43,6 +46,7 @@ private:
   void setupStatTracking(const Http::HeaderMap& headers);
 
   Upstream::ClusterManager& cm_;
+  StatsCache& stats_cache_;
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
   Http::HeaderMap* response_headers_{};
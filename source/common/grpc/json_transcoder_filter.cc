@@ -85,7 +85,11 @@ JsonTranscoderConfig::JsonTranscoderConfig(const Json::Object& config) {
     }
   }
 
-  PathMatcherBuilder<const Protobuf::MethodDescriptor*> pmb;
+  type_helper_.reset(
+      new google::grpc::transcoding::TypeHelper(Protobuf::util::NewTypeResolverForDescriptorPool(
+          Common::typeUrlPrefix(), &descriptor_pool_)));
+
+  PathMatcherBuilder<const MethodInfo*> pmb;
 
   for (const auto& service_name : config.getStringArray("services")) {
     auto service = descriptor_pool_.FindServiceByName(service_name);
@@ -95,20 +99,20 @@ JsonTranscoderConfig::JsonTranscoderConfig(const Json::Object& config) {
     }
     for (int i = 0; i < service->method_count(); ++i) {
       auto method = service->method(i);
-      if (!PathMatcherUtility::RegisterByHttpRule(
-              pmb, method->options().GetExtension(google::api::http), method)) {
+      const auto& http_rule = method->options().GetExtension(google::api::http);
+      methods_.emplace_back(new MethodInfo());
+      MethodInfo& method_info = *methods_.back();
+      method_info.descriptor_ = method;
+      if (!PathMatcherUtility::RegisterByHttpRule(pmb, http_rule, &method_info)) {
         throw EnvoyException("transcoding_filter: Cannot register '" + method->full_name() +
                              "' to path matcher");
       }
+      resolveMethodInfo(method_info, http_rule);
     }
   }
 
   path_matcher_ = pmb.Build();
 
-  type_helper_.reset(
-      new google::grpc::transcoding::TypeHelper(Protobuf::util::NewTypeResolverForDescriptorPool(
-          Common::typeUrlPrefix(), &descriptor_pool_)));
-
   const auto print_config = config.getObject("print_options", true);
   print_options_.add_whitespace = print_config->getBoolean("add_whitespace", false);
   print_options_.always_print_primitive_fields =
@@ -117,12 +121,52 @@ JsonTranscoderConfig::JsonTranscoderConfig(const Json::Object& config) {
       print_config->getBoolean("always_print_enums_as_ints", false);
   print_options_.preserve_proto_field_names =
       print_config->getBoolean("preserve_proto_field_names", false);
+
+  stream_flush_threshold_bytes_ = config.getInteger("stream_flush_threshold_bytes", 0);
+}
+
+void JsonTranscoderConfig::resolveMethodInfo(MethodInfo& method_info,
+                                             const google::api::HttpRule& http_rule) {
+  const Protobuf::MethodDescriptor* method = method_info.descriptor_;
+  method_info.grpc_path_ = "/" + method->service()->full_name() + "/" + method->name();
+  method_info.response_type_url_ = Common::typeUrl(method->output_type()->full_name());
+  method_info.request_type_ =
+      type_helper_->Info()->GetTypeByTypeUrl(Common::typeUrl(method->input_type()->full_name()));
+  if (method_info.request_type_ == nullptr) {
+    ENVOY_LOG(debug, "Cannot resolve input-type: {}", method->input_type()->full_name());
+    return;
+  }
+
+  // Variables look like "{shelf}" or "{book.name=shelves/*/books/*}". A variable which does not
+  // resolve is left out, and fails the requests which bind it, as any other unknown field does.
+  std::vector<const google::api::HttpRule*> rules{&http_rule};
+  for (const auto& additional_binding : http_rule.additional_bindings()) {
+    rules.push_back(&additional_binding);
+  }
+  for (const auto* rule : rules) {
+    const std::string path_template = rule->get() + rule->put() + rule->post() +
+                                      rule->delete_() + rule->patch() + rule->custom().path();
+    size_t start = path_template.find('{');
+    while (start != std::string::npos) {
+      const size_t end = path_template.find_first_of("=}", start);
+      if (end == std::string::npos) {
+        break;
+      }
+      const std::vector<ProtobufTypes::String> field_path =
+          StringUtil::split(path_template.substr(start + 1, end - start - 1), '.');
+      std::vector<const Protobuf::Field*> fields;
+      if (type_helper_->ResolveFieldPath(*method_info.request_type_, field_path, &fields).ok()) {
+        method_info.template_fields_.emplace(field_path, std::move(fields));
+      }
+      start = path_template.find('{', end);
+    }
+  }
 }
 
 ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
     const Http::HeaderMap& headers, ZeroCopyInputStream& request_input,
     google::grpc::transcoding::TranscoderInputStream& response_input,
-    std::unique_ptr<Transcoder>& transcoder, const Protobuf::MethodDescriptor*& method_descriptor) {
+    std::unique_ptr<Transcoder>& transcoder, const MethodInfo*& method_info) {
   const ProtobufTypes::String method = headers.Method()->value().c_str();
   ProtobufTypes::String path = headers.Path()->value().c_str();
   ProtobufTypes::String args;
@@ -135,58 +179,51 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
 
   RequestInfo request_info;
   std::vector<VariableBinding> variable_bindings;
-  method_descriptor =
+  method_info =
       path_matcher_->Lookup(method, path, args, &variable_bindings, &request_info.body_field_path);
-  if (!method_descriptor) {
+  if (!method_info) {
     return ProtobufUtil::Status(Code::NOT_FOUND, "Could not resolve " + path + " to a method");
   }
 
-  auto status = methodToRequestInfo(method_descriptor, &request_info);
-  if (!status.ok()) {
-    return status;
+  if (method_info->request_type_ == nullptr) {
+    return ProtobufUtil::Status(Code::NOT_FOUND,
+                                "Could not resolve type: " +
+                                    method_info->descriptor_->input_type()->full_name());
   }
+  request_info.message_type = method_info->request_type_;
 
-  for (const auto& binding : variable_bindings) {
+  for (auto& binding : variable_bindings) {
     google::grpc::transcoding::RequestWeaver::BindingInfo resolved_binding;
-    status = type_helper_->ResolveFieldPath(*request_info.message_type, binding.field_path,
-                                            &resolved_binding.field_path);
-    if (!status.ok()) {
-      return status;
+    auto template_field = method_info->template_fields_.find(binding.field_path);
+    if (template_field != method_info->template_fields_.end()) {
+      resolved_binding.field_path = template_field->second;
+    } else {
+      const auto status = type_helper_->ResolveFieldPath(
+          *request_info.message_type, binding.field_path, &resolved_binding.field_path);
+      if (!status.ok()) {
+        return status;
+      }
     }
 
-    resolved_binding.value = binding.value;
+    resolved_binding.value = std::move(binding.value);
 
     request_info.variable_bindings.emplace_back(std::move(resolved_binding));
   }
 
+  const Protobuf::MethodDescriptor* method_descriptor = method_info->descriptor_;
   std::unique_ptr<JsonRequestTranslator> request_translator{
       new JsonRequestTranslator(type_helper_->Resolver(), &request_input, request_info,
                                 method_descriptor->client_streaming(), true)};
 
-  const auto response_type_url = Common::typeUrl(method_descriptor->output_type()->full_name());
   std::unique_ptr<ResponseToJsonTranslator> response_translator{new ResponseToJsonTranslator(
-      type_helper_->Resolver(), response_type_url, method_descriptor->server_streaming(),
-      &response_input, print_options_)};
+      type_helper_->Resolver(), method_info->response_type_url_,
+      method_descriptor->server_streaming(), &response_input, print_options_)};
 
   transcoder.reset(
       new TranscoderImpl(std::move(request_translator), std::move(response_translator)));
   return ProtobufUtil::Status();
 }
 
-ProtobufUtil::Status
-JsonTranscoderConfig::methodToRequestInfo(const Protobuf::MethodDescriptor* method,
-                                          google::grpc::transcoding::RequestInfo* info) {
-  auto request_type_url = Common::typeUrl(method->input_type()->full_name());
-  info->message_type = type_helper_->Info()->GetTypeByTypeUrl(request_type_url);
-  if (info->message_type == nullptr) {
-    ENVOY_LOG(debug, "Cannot resolve input-type: {}", method->input_type()->full_name());
-    return ProtobufUtil::Status(Code::NOT_FOUND,
-                                "Could not resolve type: " + method->input_type()->full_name());
-  }
-
-  return ProtobufUtil::Status();
-}
-
 JsonTranscoderFilter::JsonTranscoderFilter(JsonTranscoderConfig& config) : config_(config) {}
 
 Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::HeaderMap& headers,
@@ -203,7 +240,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::HeaderMap& h
   headers.removeContentLength();
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Grpc);
   headers.insertEnvoyOriginalPath().value(*headers.Path());
-  headers.insertPath().value("/" + method_->service()->full_name() + "/" + method_->name());
+  headers.insertPath().value(method_->grpc_path_);
   headers.insertMethod().value().setReference(Http::Headers::get().MethodValues.Post);
   headers.insertTE().value().setReference(Http::Headers::get().TEValues.Trailers);
 
@@ -291,7 +328,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::encodeHeaders(Http::HeaderMap& h
 
   response_headers_ = &headers;
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Json);
-  if (!method_->server_streaming() && !end_stream) {
+  if (!method_->descriptor_->server_streaming() && !end_stream) {
     return Http::FilterHeadersStatus::StopIteration;
   }
   return Http::FilterHeadersStatus::Continue;
@@ -308,14 +345,21 @@ Http::FilterDataStatus JsonTranscoderFilter::encodeData(Buffer::Instance& data,
     response_in_.finish();
   }
 
-  readToBuffer(*transcoder_->ResponseOutput(), data);
-
-  if (!method_->server_streaming()) {
+  if (!method_->descriptor_->server_streaming()) {
+    readToBuffer(*transcoder_->ResponseOutput(), data);
     // Buffer until the response is complete.
     return Http::FilterDataStatus::StopIterationAndBuffer;
   }
   // TODO(lizan): Check ResponseStatus
 
+  // The messages are translated as soon as they are complete, and only the translated messages
+  // which are below the flush threshold are held, so the response is never buffered as a whole.
+  readToBuffer(*transcoder_->ResponseOutput(), response_out_);
+  if (!end_stream && response_out_.length() < config_.streamFlushThresholdBytes()) {
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+
+  data.move(response_out_);
   return Http::FilterDataStatus::Continue;
 }
 
@@ -326,6 +370,17 @@ Http::FilterTrailersStatus JsonTranscoderFilter::encodeTrailers(Http::HeaderMap&
 
   response_in_.finish();
 
+  if (method_->descriptor_->server_streaming()) {
+    // Flush the held messages along with the end of the response.
+    readToBuffer(*transcoder_->ResponseOutput(), response_out_);
+    if (response_out_.length()) {
+      encoder_callbacks_->addEncodedData(response_out_, true);
+    }
+
+    // For streaming case, the headers are already sent, so just continue here.
+    return Http::FilterTrailersStatus::Continue;
+  }
+
   Buffer::OwnedImpl data;
   readToBuffer(*transcoder_->ResponseOutput(), data);
 
@@ -333,11 +388,6 @@ Http::FilterTrailersStatus JsonTranscoderFilter::encodeTrailers(Http::HeaderMap&
     encoder_callbacks_->addEncodedData(data, true);
   }
 
-  if (method_->server_streaming()) {
-    // For streaming case, the headers are already sent, so just continue here.
-    return Http::FilterTrailersStatus::Continue;
-  }
-
   const Http::HeaderEntry* grpc_status_header = trailers.GrpcStatus();
   if (grpc_status_header) {
     uint64_t grpc_status_code;
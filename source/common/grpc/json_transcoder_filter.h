@@ -1,14 +1,21 @@
 #pragma once
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/filter.h"
 #include "envoy/http/header_map.h"
 #include "envoy/json/json_object.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/logger.h"
 #include "common/grpc/transcoder_input_stream_impl.h"
 #include "common/protobuf/protobuf.h"
 
+#include "google/api/http.pb.h"
 #include "grpc_transcoding/path_matcher.h"
 #include "grpc_transcoding/request_message_translator.h"
 #include "grpc_transcoding/transcoder.h"
@@ -39,6 +46,23 @@ struct VariableBinding {
  */
 class JsonTranscoderConfig : public Logger::Loggable<Logger::Id::config> {
 public:
+  /**
+   * What the transcoding of a method needs which does not depend on the request, resolved once
+   * when the config is loaded rather than for every request.
+   */
+  struct MethodInfo {
+    const Protobuf::MethodDescriptor* descriptor_;
+    // The type of the request message, or nullptr if it could not be resolved.
+    const Protobuf::Type* request_type_;
+    ProtobufTypes::String response_type_url_;
+    // The path of the gRPC request, e.g. "/bookstore.Bookstore/GetShelf".
+    std::string grpc_path_;
+    // The fields bound to the variables of the HTTP templates of the method, by field path. Fields
+    // bound from the query string of a request are resolved with the request.
+    std::map<std::vector<ProtobufTypes::String>, std::vector<const Protobuf::Field*>>
+        template_fields_;
+  };
+
   /**
    * constructor that loads protobuf descriptors from the file specified in the JSON config.
    * and construct a path matcher for HTTP path bindings.
@@ -51,27 +75,35 @@ public:
    * @param request_input a ZeroCopyInputStream reading from downstream request body
    * @param response_input a TranscoderInputStream reading from upstream response body
    * @param transcoder output parameter for the instance of Transcoder interface
-   * @param method_descriptor output parameter for the method looked up from config
+   * @param method_info output parameter for the method looked up from config
    * @return status whether the Transcoder instance are successfully created or not
    */
   ProtobufUtil::Status
   createTranscoder(const Http::HeaderMap& headers, Protobuf::io::ZeroCopyInputStream& request_input,
                    google::grpc::transcoding::TranscoderInputStream& response_input,
                    std::unique_ptr<google::grpc::transcoding::Transcoder>& transcoder,
-                   const Protobuf::MethodDescriptor*& method_descriptor);
+                   const MethodInfo*& method_info);
+
+  /**
+   * @return uint64_t the number of bytes of translated messages of a server streaming response
+   *         which are held before they are written downstream. 0 writes every message as soon as
+   *         it is translated.
+   */
+  uint64_t streamFlushThresholdBytes() const { return stream_flush_threshold_bytes_; }
 
 private:
   /**
-   * Convert method descriptor to RequestInfo that needed for transcoding library
+   * Resolve the request type and the template variable bindings of a method.
    */
-  ProtobufUtil::Status methodToRequestInfo(const Protobuf::MethodDescriptor* method,
-                                           google::grpc::transcoding::RequestInfo* info);
+  void resolveMethodInfo(MethodInfo& method_info, const google::api::HttpRule& http_rule);
 
 private:
   Protobuf::DescriptorPool descriptor_pool_;
-  google::grpc::transcoding::PathMatcherPtr<const Protobuf::MethodDescriptor*> path_matcher_;
+  std::vector<std::unique_ptr<MethodInfo>> methods_;
+  google::grpc::transcoding::PathMatcherPtr<const MethodInfo*> path_matcher_;
   std::unique_ptr<google::grpc::transcoding::TypeHelper> type_helper_;
   Protobuf::util::JsonPrintOptions print_options_;
+  uint64_t stream_flush_threshold_bytes_;
 };
 
 typedef std::shared_ptr<JsonTranscoderConfig> JsonTranscoderConfigSharedPtr;
@@ -105,9 +137,11 @@ private:
   std::unique_ptr<google::grpc::transcoding::Transcoder> transcoder_;
   TranscoderInputStreamImpl request_in_;
   TranscoderInputStreamImpl response_in_;
+  // The translated messages of a server streaming response which are not written yet.
+  Buffer::OwnedImpl response_out_;
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{nullptr};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{nullptr};
-  const Protobuf::MethodDescriptor* method_{nullptr};
+  const JsonTranscoderConfig::MethodInfo* method_{nullptr};
   Http::HeaderMap* response_headers_{nullptr};
 
   bool error_{false};
@@ -0,0 +1,113 @@
+#include "common/grpc/stats_cache.h"
+
+#include <cstdint>
+#include <string>
+
+#include "common/common/utility.h"
+#include "common/grpc/common.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Grpc {
+
+namespace {
+
+// Parse a grpc-status value only if it is spelled the way the counter of its code is named. Others,
+// such as "07", are charged to counters named after them, as Common::chargeStat() does.
+bool canonicalStatusCode(const Http::HeaderString& value, uint64_t& code) {
+  const char* digits = value.c_str();
+  if (value.empty() || value.size() > 2 || (value.size() > 1 && digits[0] == '0')) {
+    return false;
+  }
+  code = 0;
+  for (size_t i = 0; i < value.size(); i++) {
+    if (digits[i] < '0' || digits[i] > '9') {
+      return false;
+    }
+    code = code * 10 + (digits[i] - '0');
+  }
+  return true;
+}
+
+} // namespace
+
+void StatsCache::chargeStat(const Upstream::ClusterInfoConstSharedPtr& cluster,
+                            const std::string& grpc_service, const std::string& grpc_method,
+                            const Http::HeaderEntry* grpc_status) {
+  if (!grpc_status) {
+    return;
+  }
+
+  MethodStats* stats = methodStats(cluster, grpc_service, grpc_method);
+  if (stats == nullptr) {
+    Common::chargeStat(*cluster, protocol_, grpc_service, grpc_method, grpc_status);
+    return;
+  }
+
+  uint64_t grpc_status_code;
+  if (canonicalStatusCode(grpc_status->value(), grpc_status_code) &&
+      grpc_status_code < stats->status_.size()) {
+    Stats::Counter*& counter = stats->status_[grpc_status_code];
+    if (counter == nullptr) {
+      counter = &cluster->statsScope().counter(
+          fmt::format("{}.{}.{}.{}", protocol_, grpc_service, grpc_method, grpc_status_code));
+    }
+    counter->inc();
+  } else {
+    cluster->statsScope()
+        .counter(fmt::format("{}.{}.{}.{}", protocol_, grpc_service, grpc_method,
+                             grpc_status->value().c_str()))
+        .inc();
+    if (!StringUtil::atoul(grpc_status->value().c_str(), grpc_status_code)) {
+      grpc_status_code = Status::GrpcStatus::Unknown;
+    }
+  }
+
+  (grpc_status_code == 0 ? stats->success_ : stats->failure_).inc();
+  stats->total_.inc();
+}
+
+StatsCache::MethodStats* StatsCache::methodStats(const Upstream::ClusterInfoConstSharedPtr& cluster,
+                                                 const std::string& grpc_service,
+                                                 const std::string& grpc_method) {
+  auto cluster_it = clusters_.find(cluster->name());
+  if (cluster_it != clusters_.end() && cluster_it->second.cluster_.lock() != cluster) {
+    // The cluster has been updated or removed since its stats were cached.
+    size_ -= cluster_it->second.size_;
+    clusters_.erase(cluster_it);
+    cluster_it = clusters_.end();
+  }
+
+  if (cluster_it != clusters_.end()) {
+    auto service_it = cluster_it->second.services_.find(grpc_service);
+    if (service_it != cluster_it->second.services_.end()) {
+      auto method_it = service_it->second.find(grpc_method);
+      if (method_it != service_it->second.end()) {
+        return &method_it->second;
+      }
+    }
+  }
+
+  if (size_ >= max_methods_) {
+    return nullptr;
+  }
+
+  if (cluster_it == clusters_.end()) {
+    cluster_it = clusters_.emplace(cluster->name(), ClusterEntry()).first;
+    cluster_it->second.cluster_ = cluster;
+  }
+
+  Stats::Scope& scope = cluster->statsScope();
+  const std::string prefix = fmt::format("{}.{}.{}.", protocol_, grpc_service, grpc_method);
+  MethodStats stats{scope.counter(prefix + "success"),
+                    scope.counter(prefix + "failure"),
+                    scope.counter(prefix + "total"),
+                    {}};
+  size_++;
+  cluster_it->second.size_++;
+  return &cluster_it->second.services_[grpc_service].emplace(grpc_method, stats).first->second;
+}
+
+} // namespace Grpc
+} // namespace Envoy
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/grpc/status.h"
+#include "envoy/http/header_map.h"
+#include "envoy/stats/stats.h"
+#include "envoy/thread_local/thread_local.h"
+#include "envoy/upstream/upstream.h"
+
+namespace Envoy {
+namespace Grpc {
+
+/**
+ * Per worker cache of the per method stats which a gRPC filter charges, the same stats as
+ * Common::chargeStat(). Once a method has been seen on a cluster, charging its responses takes
+ * no stat name formatting or store lookups. Method names come from the request path, which the
+ * client picks, so at most max_methods of them are cached; the stats of the others are looked up
+ * by name for each response.
+ */
+class StatsCache : public ThreadLocal::ThreadLocalObject {
+public:
+  static const uint32_t DEFAULT_MAX_METHODS = 1000;
+
+  StatsCache(const std::string& protocol, uint32_t max_methods = DEFAULT_MAX_METHODS)
+      : protocol_(protocol), max_methods_(max_methods) {}
+
+  /**
+   * Charge the stats of a response.
+   * @param cluster supplies the target cluster.
+   * @param grpc_service supplies the service name.
+   * @param grpc_method supplies the method name.
+   * @param grpc_status supplies the gRPC status. Nothing is charged without it.
+   */
+  void chargeStat(const Upstream::ClusterInfoConstSharedPtr& cluster,
+                  const std::string& grpc_service, const std::string& grpc_method,
+                  const Http::HeaderEntry* grpc_status);
+
+  /**
+   * @return uint32_t the number of methods whose stats are cached.
+   */
+  uint32_t size() const { return size_; }
+
+private:
+  struct MethodStats {
+    Stats::Counter& success_;
+    Stats::Counter& failure_;
+    Stats::Counter& total_;
+    // The counters of the statuses, resolved when first charged.
+    std::array<Stats::Counter*, Status::GrpcStatus::Unauthenticated + 1> status_;
+  };
+
+  typedef std::unordered_map<std::string, MethodStats> MethodStatsMap;
+
+  struct ClusterEntry {
+    // The stats belong to the scope of the cluster, so they are only used while it is alive.
+    std::weak_ptr<const Upstream::ClusterInfo> cluster_;
+    std::unordered_map<std::string, MethodStatsMap> services_;
+    uint32_t size_{};
+  };
+
+  MethodStats* methodStats(const Upstream::ClusterInfoConstSharedPtr& cluster,
+                           const std::string& grpc_service, const std::string& grpc_method);
+
+  const std::string protocol_;
+  const uint32_t max_methods_;
+  std::unordered_map<std::string, ClusterEntry> clusters_;
+  uint32_t size_{};
+};
+
+typedef std::shared_ptr<StatsCache> StatsCacheSharedPtr;
+
+} // namespace Grpc
+} // namespace Envoy
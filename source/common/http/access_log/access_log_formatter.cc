@@ -121,17 +121,12 @@ FormatterImpl::FormatterImpl(const std::string& format) {
   formatters_ = AccessLogFormatParser::parse(format);
 }
 
-std::string FormatterImpl::format(const Http::HeaderMap& request_headers,
-                                  const Http::HeaderMap& response_headers,
-                                  const RequestInfo& request_info) const {
-  std::string log_line;
-  log_line.reserve(256);
-
+void FormatterImpl::formatInto(const Http::HeaderMap& request_headers,
+                               const Http::HeaderMap& response_headers,
+                               const RequestInfo& request_info, std::string& output) const {
   for (const FormatterPtr& formatter : formatters_) {
-    log_line += formatter->format(request_headers, response_headers, request_info);
+    formatter->formatInto(request_headers, response_headers, request_info, output);
   }
-
-  return log_line;
 }
 
 void AccessLogFormatParser::parseCommand(const std::string& token, const size_t start,
@@ -228,80 +223,87 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
 
 RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
   if (field_name == "START_TIME") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return AccessLogDateTimeFormatter::fromTime(request_info.startTime());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      output += AccessLogDateTimeFormatter::fromTime(request_info.startTime());
     };
   } else if (field_name == "REQUEST_DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                request_info.requestReceivedDuration())
-                                .count());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendNumber(std::chrono::duration_cast<std::chrono::milliseconds>(
+                       request_info.requestReceivedDuration())
+                       .count(),
+                   output);
     };
   } else if (field_name == "RESPONSE_DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                request_info.responseReceivedDuration())
-                                .count());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendNumber(std::chrono::duration_cast<std::chrono::milliseconds>(
+                       request_info.responseReceivedDuration())
+                       .count(),
+                   output);
     };
   } else if (field_name == "BYTES_RECEIVED") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(request_info.bytesReceived());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendNumber(request_info.bytesReceived(), output);
     };
   } else if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return AccessLogFormatUtils::protocolToString(request_info.protocol());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      output += AccessLogFormatUtils::protocolToString(request_info.protocol());
     };
   } else if (field_name == "RESPONSE_CODE") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return request_info.responseCode().valid()
-                 ? std::to_string(request_info.responseCode().value())
-                 : "0";
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendNumber(request_info.responseCode().valid() ? request_info.responseCode().value() : 0,
+                   output);
     };
   } else if (field_name == "BYTES_SENT") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(request_info.bytesSent());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendNumber(request_info.bytesSent(), output);
     };
   } else if (field_name == "DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(
-          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count());
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      appendNumber(
+          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count(),
+          output);
     };
   } else if (field_name == "RESPONSE_FLAGS") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return ResponseFlagUtils::toShortString(request_info);
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      output += ResponseFlagUtils::toShortString(request_info);
     };
   } else if (field_name == "UPSTREAM_HOST") {
-    field_extractor_ = [](const RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
       if (request_info.upstreamHost()) {
-        return request_info.upstreamHost()->address()->asString();
+        output += request_info.upstreamHost()->address()->asString();
       } else {
-        return std::string("-");
+        output += '-';
       }
     };
   } else if (field_name == "UPSTREAM_CLUSTER") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      std::string upstream_cluster_name;
-      if (nullptr != request_info.upstreamHost()) {
-        upstream_cluster_name = request_info.upstreamHost()->cluster().name();
+    field_extractor_ = [](const RequestInfo& request_info, std::string& output) {
+      if (nullptr != request_info.upstreamHost() &&
+          !request_info.upstreamHost()->cluster().name().empty()) {
+        output += request_info.upstreamHost()->cluster().name();
+      } else {
+        output += '-';
       }
-
-      return upstream_cluster_name.empty() ? "-" : upstream_cluster_name;
     };
   } else {
     throw EnvoyException(fmt::format("Not supported field in RequestInfo: {}", field_name));
   }
 }
 
-std::string RequestInfoFormatter::format(const HeaderMap&, const HeaderMap&,
-                                         const RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+void RequestInfoFormatter::appendNumber(uint64_t value, std::string& output) {
+  char buffer[32];
+  output.append(buffer, StringUtil::itoa(buffer, sizeof(buffer), value));
+}
+
+void RequestInfoFormatter::formatInto(const HeaderMap&, const HeaderMap&,
+                                      const RequestInfo& request_info, std::string& output) const {
+  field_extractor_(request_info, output);
 }
 
 PlainStringFormatter::PlainStringFormatter(const std::string& str) : str_(str) {}
 
-std::string PlainStringFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                         const RequestInfo&) const {
-  return str_;
+void PlainStringFormatter::formatInto(const Http::HeaderMap&, const Http::HeaderMap&,
+                                      const RequestInfo&, std::string& output) const {
+  output += str_;
 }
 
 HeaderFormatter::HeaderFormatter(const std::string& main_header,
@@ -309,25 +311,25 @@ HeaderFormatter::HeaderFormatter(const std::string& main_header,
                                  const Optional<size_t>& max_length)
     : main_header_(main_header), alternative_header_(alternative_header), max_length_(max_length) {}
 
-std::string HeaderFormatter::format(const HeaderMap& headers) const {
+void HeaderFormatter::formatInto(const HeaderMap& headers, std::string& output) const {
   const HeaderEntry* header = headers.get(main_header_);
 
   if (!header && !alternative_header_.get().empty()) {
     header = headers.get(alternative_header_);
   }
 
-  std::string header_value_string;
-  if (!header) {
-    header_value_string = "-";
-  } else {
-    header_value_string = header->value().c_str();
+  const char* value = "-";
+  size_t length = 1;
+  if (header) {
+    value = header->value().c_str();
+    length = header->value().size();
   }
 
-  if (max_length_.valid() && header_value_string.length() > max_length_.value()) {
-    return header_value_string.substr(0, max_length_.value());
+  if (max_length_.valid() && length > max_length_.value()) {
+    length = max_length_.value();
   }
 
-  return header_value_string;
+  output.append(value, length);
 }
 
 ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
@@ -335,10 +337,10 @@ ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
                                                  const Optional<size_t>& max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string ResponseHeaderFormatter::format(const Http::HeaderMap&,
-                                            const Http::HeaderMap& response_headers,
-                                            const RequestInfo&) const {
-  return HeaderFormatter::format(response_headers);
+void ResponseHeaderFormatter::formatInto(const Http::HeaderMap&,
+                                         const Http::HeaderMap& response_headers,
+                                         const RequestInfo&, std::string& output) const {
+  HeaderFormatter::formatInto(response_headers, output);
 }
 
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
@@ -346,9 +348,10 @@ RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
                                                const Optional<size_t>& max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string RequestHeaderFormatter::format(const Http::HeaderMap& request_headers,
-                                           const Http::HeaderMap&, const RequestInfo&) const {
-  return HeaderFormatter::format(request_headers);
+void RequestHeaderFormatter::formatInto(const Http::HeaderMap& request_headers,
+                                        const Http::HeaderMap&, const RequestInfo&,
+                                        std::string& output) const {
+  HeaderFormatter::formatInto(request_headers, output);
 }
 
 } // namespace AccessLog
@@ -15,6 +15,7 @@
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
+#include "common/runtime/key_registry.h"
 #include "common/runtime/uuid_util.h"
 #include "common/tracing/http_tracer_impl.h"
 
@@ -86,21 +87,38 @@ bool DurationFilter::evaluate(const RequestInfo& info, const HeaderMap&) {
 
 RuntimeFilter::RuntimeFilter(const envoy::api::v2::filter::RuntimeFilter& config,
                              Runtime::Loader& runtime)
-    : runtime_(runtime), runtime_key_(config.runtime_key()) {}
+    : runtime_(runtime), runtime_key_(Runtime::KeyRegistry::registerKey(config.runtime_key())) {}
 
 bool RuntimeFilter::evaluate(const RequestInfo&, const HeaderMap& request_header) {
   const HeaderEntry* uuid = request_header.RequestId();
   uint16_t sampled_value;
-  if (uuid && UuidUtils::uuidModBy(uuid->value().c_str(), sampled_value, 100)) {
-    uint64_t runtime_value =
-        std::min<uint64_t>(runtime_.snapshot().getInteger(runtime_key_, 0), 100);
-
-    return sampled_value < static_cast<uint16_t>(runtime_value);
+  if (uuid &&
+      UuidUtils::uuidModBy(uuid->value().c_str(), uuid->value().size(), sampled_value, 100)) {
+    return sampled(sampled_value);
   } else {
     return runtime_.snapshot().featureEnabled(runtime_key_, 0);
   }
 }
 
+bool RuntimeFilter::evaluateRequestHeaders(const HeaderMap& request_headers) {
+  // Sampling by request ID gives the same answer whenever it is evaluated, unlike the random
+  // sampling of requests without one.
+  const HeaderEntry* uuid = request_headers.RequestId();
+  uint16_t sampled_value;
+  if (uuid &&
+      UuidUtils::uuidModBy(uuid->value().c_str(), uuid->value().size(), sampled_value, 100)) {
+    return sampled(sampled_value);
+  }
+
+  return true;
+}
+
+bool RuntimeFilter::sampled(uint16_t sampled_value) {
+  uint64_t runtime_value = std::min<uint64_t>(runtime_.snapshot().getInteger(runtime_key_, 0), 100);
+
+  return sampled_value < static_cast<uint16_t>(runtime_value);
+}
+
 OperatorFilter::OperatorFilter(
     const Protobuf::RepeatedPtrField<envoy::api::v2::filter::AccessLogFilter>& configs,
     Runtime::Loader& runtime) {
@@ -128,6 +146,16 @@ bool OrFilter::evaluate(const RequestInfo& info, const HeaderMap& request_header
   return result;
 }
 
+bool OrFilter::evaluateRequestHeaders(const HeaderMap& request_headers) {
+  for (auto& filter : filters_) {
+    if (filter->evaluateRequestHeaders(request_headers)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 bool AndFilter::evaluate(const RequestInfo& info, const HeaderMap& request_headers) {
   bool result = true;
   for (auto& filter : filters_) {
@@ -141,6 +169,16 @@ bool AndFilter::evaluate(const RequestInfo& info, const HeaderMap& request_heade
   return result;
 }
 
+bool AndFilter::evaluateRequestHeaders(const HeaderMap& request_headers) {
+  for (auto& filter : filters_) {
+    if (!filter->evaluateRequestHeaders(request_headers)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool NotHealthCheckFilter::evaluate(const RequestInfo& info, const HeaderMap&) {
   return !info.healthCheck();
 }
@@ -183,11 +221,16 @@ void FileAccessLog::log(const HeaderMap* request_headers, const HeaderMap* respo
     }
   }
 
-  std::string access_log_line =
-      formatter_->format(*request_headers, *response_headers, request_info);
+  std::string access_log_line;
+  access_log_line.reserve(256);
+  formatter_->formatInto(*request_headers, *response_headers, request_info, access_log_line);
   log_file_->write(access_log_line);
 }
 
+bool FileAccessLog::mayLog(const HeaderMap& request_headers) {
+  return !filter_ || filter_->evaluateRequestHeaders(request_headers);
+}
+
 } // namespace AccessLog
 } // namespace Http
 } // namespace Envoy
@@ -37,6 +37,9 @@ protected:
   ComparisonFilter(const envoy::api::v2::filter::ComparisonFilter& config,
                    Runtime::Loader& runtime);
 
+  // Http::AccessLog::Filter
+  bool evaluateRequestHeaders(const HeaderMap&) override { return true; }
+
   bool compareAgainstValue(uint64_t lhs);
 
   envoy::api::v2::filter::ComparisonFilter config_;
@@ -88,6 +91,7 @@ public:
 
   // Http::AccessLog::Filter
   bool evaluate(const RequestInfo& info, const HeaderMap& request_headers) override;
+  bool evaluateRequestHeaders(const HeaderMap& request_headers) override;
 };
 
 /**
@@ -99,6 +103,7 @@ public:
 
   // Http::AccessLog::Filter
   bool evaluate(const RequestInfo& info, const HeaderMap& request_headers) override;
+  bool evaluateRequestHeaders(const HeaderMap& request_headers) override;
 };
 
 /**
@@ -110,6 +115,7 @@ public:
 
   // Http::AccessLog::Filter
   bool evaluate(const RequestInfo& info, const HeaderMap& request_headers) override;
+  bool evaluateRequestHeaders(const HeaderMap&) override { return true; }
 };
 
 /**
@@ -119,6 +125,7 @@ class TraceableRequestFilter : public Filter {
 public:
   // Http::AccessLog::Filter
   bool evaluate(const RequestInfo& info, const HeaderMap& request_headers) override;
+  bool evaluateRequestHeaders(const HeaderMap&) override { return true; }
 };
 
 /**
@@ -130,10 +137,13 @@ public:
 
   // Http::AccessLog::Filter
   bool evaluate(const RequestInfo& info, const HeaderMap& request_headers) override;
+  bool evaluateRequestHeaders(const HeaderMap& request_headers) override;
 
 private:
+  bool sampled(uint16_t sampled_value);
+
   Runtime::Loader& runtime_;
-  const std::string runtime_key_;
+  const Runtime::Key& runtime_key_;
 };
 
 /**
@@ -159,6 +169,7 @@ public:
   // Http::AccessLog::Instance
   void log(const HeaderMap* request_headers, const HeaderMap* response_headers,
            const RequestInfo& request_info) override;
+  bool mayLog(const HeaderMap& request_headers) override;
 
 private:
   Filesystem::FileSharedPtr log_file_;
@@ -0,0 +1,171 @@
+#include "common/http/access_log/grpc_access_log_impl.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/http/access_log/access_log_formatter.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+
+const uint64_t HttpGrpcAccessLog::DEFAULT_BUFFER_SIZE_BYTES;
+const uint64_t HttpGrpcAccessLog::DEFAULT_BUFFER_FLUSH_INTERVAL_MS;
+
+GrpcAccessLogStreamer::GrpcAccessLogStreamer(AccessLogServiceAsyncClientPtr&& client,
+                                             const std::string& log_name,
+                                             uint64_t buffer_size_bytes,
+                                             std::chrono::milliseconds flush_interval,
+                                             Event::Dispatcher& dispatcher,
+                                             const GrpcAccessLogStats& stats)
+    : client_(std::move(client)),
+      service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+          "envoy.access_log.AccessLogService.StreamAccessLogs")),
+      log_name_(log_name), buffer_size_bytes_(buffer_size_bytes), flush_interval_(flush_interval),
+      stats_(stats), flush_timer_(dispatcher.createTimer([this]() -> void { flush(); })) {}
+
+void GrpcAccessLogStreamer::log(envoy::access_log::HttpAccessLogEntry& entry) {
+  const uint64_t entry_bytes = entry.ByteSizeLong();
+  if (message_bytes_ + entry_bytes > buffer_size_bytes_ && message_.entries_size() > 0) {
+    // Try to make room before giving up on the entry.
+    flush();
+    if (message_.entries_size() > 0) {
+      stats_.logs_dropped_.inc();
+      return;
+    }
+  }
+
+  if (message_.entries_size() == 0) {
+    flush_timer_->enableTimer(flush_interval_);
+  }
+  message_.add_entries()->Swap(&entry);
+  message_bytes_ += entry_bytes;
+  if (message_bytes_ >= buffer_size_bytes_) {
+    flush();
+  }
+}
+
+void GrpcAccessLogStreamer::flush() {
+  if (message_.entries_size() == 0) {
+    return;
+  }
+
+  if (stream_ == nullptr) {
+    stream_ = client_->start(service_method_, *this);
+    if (stream_ == nullptr) {
+      // The buffer is kept, and dropped from once it is full, until a stream can be established.
+      ENVOY_LOG(debug, "unable to start access log stream {}", log_name_);
+      flush_timer_->enableTimer(flush_interval_);
+      return;
+    }
+    message_.set_log_name(log_name_);
+  }
+
+  stream_->sendMessage(message_, false);
+  stats_.logs_written_.add(message_.entries_size());
+  message_.clear_log_name();
+  message_.clear_entries();
+  message_bytes_ = 0;
+  flush_timer_->disableTimer();
+}
+
+void GrpcAccessLogStreamer::onRemoteClose(Grpc::Status::GrpcStatus status,
+                                          const std::string& message) {
+  ENVOY_LOG(debug, "access log stream {} closed: {}, {}", log_name_, status, message);
+  stats_.stream_failures_.inc();
+  stream_ = nullptr;
+}
+
+HttpGrpcAccessLog::HttpGrpcAccessLog(FilterPtr&& filter,
+                                     const envoy::access_log::HttpGrpcAccessLogConfig& config,
+                                     AccessLogServiceAsyncClientFactory client_factory,
+                                     ThreadLocal::SlotAllocator& tls, Stats::Scope& scope)
+    : filter_(std::move(filter)),
+      stats_{ALL_GRPC_ACCESS_LOG_STATS(
+          POOL_COUNTER_PREFIX(scope, "access_log.grpc." + config.log_name() + "."))},
+      tls_slot_(tls.allocateSlot()) {
+  const std::string log_name = config.log_name();
+  const uint64_t buffer_size_bytes =
+      config.buffer_size_bytes() > 0 ? config.buffer_size_bytes() : DEFAULT_BUFFER_SIZE_BYTES;
+  const std::chrono::milliseconds flush_interval(config.buffer_flush_interval_ms() > 0
+                                                     ? config.buffer_flush_interval_ms()
+                                                     : DEFAULT_BUFFER_FLUSH_INTERVAL_MS);
+  const GrpcAccessLogStats stats = stats_;
+  tls_slot_->set([client_factory, log_name, buffer_size_bytes, flush_interval,
+                  stats](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<GrpcAccessLogStreamer>(client_factory(), log_name, buffer_size_bytes,
+                                                   flush_interval, dispatcher, stats);
+  });
+}
+
+void HttpGrpcAccessLog::requestToEntry(const HeaderMap& request_headers,
+                                       const RequestInfo& request_info,
+                                       envoy::access_log::HttpAccessLogEntry& entry) {
+  entry.set_start_time_us(std::chrono::duration_cast<std::chrono::microseconds>(
+                              request_info.startTime().time_since_epoch())
+                              .count());
+  entry.set_duration_us(request_info.duration().count());
+  entry.set_protocol(AccessLogFormatUtils::protocolToString(request_info.protocol()));
+
+  const HeaderEntry* path = request_headers.EnvoyOriginalPath() != nullptr
+                                ? request_headers.EnvoyOriginalPath()
+                                : request_headers.Path();
+  if (path != nullptr) {
+    entry.set_path(path->value().c_str());
+  }
+  if (request_headers.Method() != nullptr) {
+    entry.set_method(request_headers.Method()->value().c_str());
+  }
+  if (request_headers.Host() != nullptr) {
+    entry.set_authority(request_headers.Host()->value().c_str());
+  }
+  if (request_headers.UserAgent() != nullptr) {
+    entry.set_user_agent(request_headers.UserAgent()->value().c_str());
+  }
+  if (request_headers.ForwardedFor() != nullptr) {
+    entry.set_forwarded_for(request_headers.ForwardedFor()->value().c_str());
+  }
+  if (request_headers.RequestId() != nullptr) {
+    entry.set_request_id(request_headers.RequestId()->value().c_str());
+  }
+
+  if (request_info.responseCode().valid()) {
+    entry.set_response_code(request_info.responseCode().value());
+  }
+  entry.set_response_flags(ResponseFlagUtils::toShortString(request_info));
+  entry.set_bytes_received(request_info.bytesReceived());
+  entry.set_bytes_sent(request_info.bytesSent());
+  if (request_info.upstreamHost() != nullptr) {
+    entry.set_upstream_host(request_info.upstreamHost()->address()->asString());
+    entry.set_upstream_cluster(request_info.upstreamHost()->cluster().name());
+  }
+  entry.set_downstream_address(request_info.getDownstreamAddress());
+}
+
+void HttpGrpcAccessLog::log(const HeaderMap* request_headers, const HeaderMap*,
+                            const RequestInfo& request_info) {
+  static HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+
+  if (filter_) {
+    if (!filter_->evaluate(request_info, *request_headers)) {
+      return;
+    }
+  }
+
+  envoy::access_log::HttpAccessLogEntry entry;
+  requestToEntry(*request_headers, request_info, entry);
+  tls_slot_->getTyped<GrpcAccessLogStreamer>().log(entry);
+}
+
+bool HttpGrpcAccessLog::mayLog(const HeaderMap& request_headers) {
+  return !filter_ || filter_->evaluateRequestHeaders(request_headers);
+}
+
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/grpc/async_client.h"
+#include "envoy/http/access_log.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+#include "envoy/upstream/cluster_manager.h"
+
+#include "common/common/logger.h"
+#include "common/protobuf/protobuf.h"
+
+#include "source/common/http/access_log/grpc_access_log.pb.h"
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+
+/**
+ * All gRPC access log stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_GRPC_ACCESS_LOG_STATS(COUNTER)                                                         \
+  COUNTER(logs_written)                                                                            \
+  COUNTER(logs_dropped)                                                                            \
+  COUNTER(stream_failures)
+// clang-format on
+
+/**
+ * Struct definition for all gRPC access log stats. @see stats_macros.h
+ */
+struct GrpcAccessLogStats {
+  ALL_GRPC_ACCESS_LOG_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+typedef Grpc::AsyncClient<envoy::access_log::StreamAccessLogsMessage,
+                          envoy::access_log::StreamAccessLogsResponse>
+    AccessLogServiceAsyncClient;
+typedef std::unique_ptr<AccessLogServiceAsyncClient> AccessLogServiceAsyncClientPtr;
+typedef std::function<AccessLogServiceAsyncClientPtr()> AccessLogServiceAsyncClientFactory;
+
+/**
+ * Buffers the access log entries of one worker and sends them to the access log service over a
+ * long lived stream. The buffer is flushed when it fills up or when the flush timer fires. While no
+ * stream can be established, the buffer stays full and new entries are dropped rather than queued
+ * without bound.
+ */
+class GrpcAccessLogStreamer : public ThreadLocal::ThreadLocalObject,
+                              public Grpc::AsyncStreamCallbacks<
+                                  envoy::access_log::StreamAccessLogsResponse>,
+                              Logger::Loggable<Logger::Id::http> {
+public:
+  GrpcAccessLogStreamer(AccessLogServiceAsyncClientPtr&& client, const std::string& log_name,
+                        uint64_t buffer_size_bytes, std::chrono::milliseconds flush_interval,
+                        Event::Dispatcher& dispatcher, const GrpcAccessLogStats& stats);
+
+  /**
+   * Buffer an entry, which is swapped out of the argument.
+   */
+  void log(envoy::access_log::HttpAccessLogEntry& entry);
+
+  /**
+   * Send the buffered entries, starting a new stream if there is none.
+   */
+  void flush();
+
+  // Grpc::AsyncStreamCallbacks
+  void onCreateInitialMetadata(Http::HeaderMap&) override {}
+  void onReceiveInitialMetadata(Http::HeaderMapPtr&&) override {}
+  void onReceiveMessage(std::unique_ptr<envoy::access_log::StreamAccessLogsResponse>&&) override {}
+  void onReceiveTrailingMetadata(Http::HeaderMapPtr&&) override {}
+  void onRemoteClose(Grpc::Status::GrpcStatus status, const std::string& message) override;
+
+private:
+  AccessLogServiceAsyncClientPtr client_;
+  const Protobuf::MethodDescriptor& service_method_;
+  const std::string log_name_;
+  const uint64_t buffer_size_bytes_;
+  const std::chrono::milliseconds flush_interval_;
+  GrpcAccessLogStats stats_;
+  Grpc::AsyncStream<envoy::access_log::StreamAccessLogsMessage>* stream_{};
+  envoy::access_log::StreamAccessLogsMessage message_;
+  uint64_t message_bytes_{};
+  Event::TimerPtr flush_timer_;
+};
+
+/**
+ * Access log Instance that streams entries to an access log service over gRPC, with a stream and
+ * a buffer per worker.
+ */
+class HttpGrpcAccessLog : public Instance {
+public:
+  HttpGrpcAccessLog(FilterPtr&& filter, const envoy::access_log::HttpGrpcAccessLogConfig& config,
+                    AccessLogServiceAsyncClientFactory client_factory,
+                    ThreadLocal::SlotAllocator& tls, Stats::Scope& scope);
+
+  /**
+   * Fill in an entry from a request.
+   */
+  static void requestToEntry(const HeaderMap& request_headers, const RequestInfo& request_info,
+                             envoy::access_log::HttpAccessLogEntry& entry);
+
+  // Http::AccessLog::Instance
+  void log(const HeaderMap* request_headers, const HeaderMap* response_headers,
+           const RequestInfo& request_info) override;
+  bool mayLog(const HeaderMap& request_headers) override;
+
+  static const uint64_t DEFAULT_BUFFER_SIZE_BYTES = 16384;
+  static const uint64_t DEFAULT_BUFFER_FLUSH_INTERVAL_MS = 1000;
+
+private:
+  FilterPtr filter_;
+  GrpcAccessLogStats stats_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
@@ -11,6 +11,8 @@
 namespace Envoy {
 namespace Http {
 
+const uint64_t AsyncRequestImpl::MaxCachedRequests;
+
 const std::list<std::string> AsyncStreamImpl::NullCorsPolicy::allow_origin_;
 const Optional<bool> AsyncStreamImpl::NullCorsPolicy::allow_credentials_;
 const std::vector<std::reference_wrapper<const Router::RateLimitPolicyEntry>>
@@ -68,8 +70,8 @@ AsyncStreamImpl::AsyncStreamImpl(AsyncClientImpl& parent, AsyncClient::StreamCal
                                  const Optional<std::chrono::milliseconds>& timeout,
                                  bool buffer_body_for_retry)
     : parent_(parent), stream_callbacks_(callbacks), stream_id_(parent.config_.random_.random()),
-      router_(parent.config_), request_info_(Protocol::Http11),
-      route_(std::make_shared<RouteImpl>(parent_.cluster_.name(), timeout)) {
+      route_(parent_.cluster_.name(), timeout), router_(parent.config_),
+      request_info_(Protocol::Http11) {
   if (buffer_body_for_retry) {
     buffered_body_.reset(new Buffer::OwnedImpl());
   }
@@ -21,6 +21,7 @@
 #include "envoy/tracing/http_tracer.h"
 
 #include "common/common/empty_string.h"
+#include "common/common/free_list.h"
 #include "common/common/linked_object.h"
 #include "common/http/access_log/request_info_impl.h"
 #include "common/http/message_impl.h"
@@ -88,6 +89,7 @@ private:
   struct NullCorsPolicy : public Router::CorsPolicy {
     // Router::CorsPolicy
     const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
+    bool allowsOrigin(const std::string&) const override { return false; };
     const std::string& allowMethods() const override { return EMPTY_STRING; };
     const std::string& allowHeaders() const override { return EMPTY_STRING; };
     const std::string& exposeHeaders() const override { return EMPTY_STRING; };
@@ -202,7 +204,11 @@ private:
   const Network::Connection* connection() override { return nullptr; }
   Event::Dispatcher& dispatcher() override { return parent_.dispatcher_; }
   void resetStream() override;
-  Router::RouteConstSharedPtr route() override { return route_; }
+  Router::RouteConstSharedPtr route() override {
+    // The route lives as long as the stream, so hand out a non-owning pointer to it instead of
+    // allocating a control block per stream.
+    return Router::RouteConstSharedPtr(Router::RouteConstSharedPtr(), &route_);
+  }
   void clearRouteCache() override {}
   uint64_t streamId() override { return stream_id_; }
   AccessLog::RequestInfo& requestInfo() override { return request_info_; }
@@ -223,10 +229,10 @@ private:
 
   AsyncClient::StreamCallbacks& stream_callbacks_;
   const uint64_t stream_id_;
+  const RouteImpl route_;
   Router::ProdFilter router_;
   AccessLog::RequestInfoImpl request_info_;
   Tracing::NullSpan active_span_;
-  std::shared_ptr<RouteImpl> route_;
   bool local_closed_{};
   bool remote_closed_{};
   Buffer::InstancePtr buffered_body_;
@@ -240,10 +246,28 @@ public:
   AsyncRequestImpl(MessagePtr&& request, AsyncClientImpl& parent, AsyncClient::Callbacks& callbacks,
                    const Optional<std::chrono::milliseconds>& timeout);
 
+  // The number of freed requests that are kept per thread for reuse.
+  static const uint64_t MaxCachedRequests = 64;
+
+  /**
+   * Requests are allocated from a per-thread free list, so that a worker which is steadily making
+   * internal calls (rate limit, auth, tracing) reuses the same memory instead of going through
+   * malloc for every request.
+   */
+  static void* operator new(size_t size) { return RequestFreeList::allocate(size); }
+  static void operator delete(void* p, size_t size) { RequestFreeList::release(p, size); }
+
+  /**
+   * @return the number of freed requests cached by the calling thread.
+   */
+  static uint64_t cachedRequests() { return RequestFreeList::cached(); }
+
   // AsyncClient::Request
   virtual void cancel() override;
 
 private:
+  typedef FreeList<AsyncRequestImpl, MaxCachedRequests> RequestFreeList;
+
   void initialize();
   void onComplete();
 
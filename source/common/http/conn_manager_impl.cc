@@ -28,19 +28,26 @@
 #include "common/http/http2/codec_impl.h"
 #include "common/http/utility.h"
 #include "common/network/utility.h"
+#include "common/runtime/key_registry.h"
 
 #include "fmt/format.h"
 
 namespace Envoy {
 namespace Http {
 
+// The % of WebSocket connections which drop their HTTP stream once the upgrade request has been
+// sent upstream, and go on as a bare tunnel.
+static const Runtime::Key& WebSocketCompactTunnel =
+    Runtime::KeyRegistry::registerKey("http.websocket_compact_tunnel");
+
 ConnectionManagerStats ConnectionManagerImpl::generateStats(const std::string& prefix,
                                                             Stats::Scope& scope) {
   return {
       {ALL_HTTP_CONN_MAN_STATS(POOL_COUNTER_PREFIX(scope, prefix), POOL_GAUGE_PREFIX(scope, prefix),
                                POOL_HISTOGRAM_PREFIX(scope, prefix))},
       prefix,
-      scope};
+      scope,
+      std::make_shared<UserAgentContext>(prefix, scope)};
 }
 
 ConnectionManagerTracingStats ConnectionManagerImpl::generateTracingStats(const std::string& prefix,
@@ -76,12 +83,24 @@ void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCal
 
   read_callbacks_->connection().addConnectionCallbacks(*this);
 
+  const Network::Connection::WorkerStats* worker_stats =
+      read_callbacks_->connection().workerStats();
+  if (worker_stats != nullptr) {
+    worker_rq_active_ = &worker_stats->rq_active_;
+  }
+
   if (config_.idleTimeout().valid()) {
-    idle_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+    idle_timer_ = read_callbacks_->connection().dispatcher().createCoarseTimer(
         [this]() -> void { onIdleTimeout(); });
     idle_timer_->enableTimer(config_.idleTimeout().value());
   }
 
+  read_callbacks_->connection().addMemoryReleaseCallback([this]() -> void {
+    if (codec_ && streams_.empty()) {
+      codec_->shrink();
+    }
+  });
+
   read_callbacks_->connection().setConnectionStats(
       {stats_.named_.downstream_cx_rx_bytes_total_, stats_.named_.downstream_cx_rx_bytes_buffered_,
        stats_.named_.downstream_cx_tx_bytes_total_, stats_.named_.downstream_cx_tx_bytes_buffered_,
@@ -308,13 +327,32 @@ void ConnectionManagerImpl::onGoAway() {
 void ConnectionManagerImpl::onIdleTimeout() {
   ENVOY_CONN_LOG(debug, "idle timeout", read_callbacks_->connection());
   stats_.named_.downstream_cx_idle_timeout_.inc();
-  if (!codec_) {
+  if (!codec_ || isWebSocketConnection()) {
     read_callbacks_->connection().close(Network::ConnectionCloseType::FlushWrite);
   } else if (drain_state_ == DrainState::NotDraining) {
     startDrainSequence();
   }
 }
 
+void ConnectionManagerImpl::onWebSocketUpgradeRequestSent(ActiveStream& stream) {
+  if (!runtime_.snapshot().featureEnabled(WebSocketCompactTunnel, 0)) {
+    return;
+  }
+
+  // The stream is only kept for its access logs and tracing otherwise, which now record the
+  // upgrade rather than the whole life of the connection. It goes without a reset, as the tunnel
+  // goes on.
+  ENVOY_CONN_LOG(debug, "releasing websocket stream", read_callbacks_->connection());
+  stream.response_encoder_->getStream().removeCallbacks(stream);
+  doDeferredStreamDestroy(stream);
+
+  if (config_.idleTimeout().valid()) {
+    ws_connection_->setIdleTimeout(config_.idleTimeout().value(),
+                                   [this]() -> void { onIdleTimeout(); });
+    idle_timer_.reset();
+  }
+}
+
 void ConnectionManagerImpl::onDrainTimeout() {
   ASSERT(drain_state_ != DrainState::NotDraining);
   codec_->goAway();
@@ -337,6 +375,9 @@ void ConnectionManagerImpl::chargeTracingStats(const Tracing::Reason& tracing_re
   case Tracing::Reason::ServiceForced:
     tracing_stats.service_forced_.inc();
     break;
+  case Tracing::Reason::DownstreamNotSampled:
+    tracing_stats.downstream_not_sampled_.inc();
+    break;
   default:
     throw std::invalid_argument(
         fmt::format("invalid tracing reason, value: {}", static_cast<int32_t>(tracing_reason)));
@@ -351,6 +392,9 @@ ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connect
       request_info_(connection_manager_.codec_->protocol()) {
   connection_manager_.stats_.named_.downstream_rq_total_.inc();
   connection_manager_.stats_.named_.downstream_rq_active_.inc();
+  if (connection_manager_.worker_rq_active_ != nullptr) {
+    connection_manager_.worker_rq_active_->inc();
+  }
   if (connection_manager_.codec_->protocol() == Protocol::Http2) {
     connection_manager_.stats_.named_.downstream_rq_http2_total_.inc();
   } else {
@@ -360,8 +404,15 @@ ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connect
 
 ConnectionManagerImpl::ActiveStream::~ActiveStream() {
   connection_manager_.stats_.named_.downstream_rq_active_.dec();
+  if (connection_manager_.worker_rq_active_ != nullptr) {
+    connection_manager_.worker_rq_active_->dec();
+  }
+  uint64_t access_log_bit = 1;
   for (const AccessLog::InstanceSharedPtr& access_log : connection_manager_.config_.accessLogs()) {
-    access_log->log(request_headers_.get(), response_headers_.get(), request_info_);
+    if (!(unloggable_access_logs_ & access_log_bit)) {
+      access_log->log(request_headers_.get(), response_headers_.get(), request_info_);
+    }
+    access_log_bit <<= 1;
   }
   for (const auto& log_handler : access_log_handlers_) {
     log_handler->log(request_headers_.get(), response_headers_.get(), request_info_);
@@ -381,14 +432,16 @@ void ConnectionManagerImpl::ActiveStream::addStreamDecoderFilterWorker(
     StreamDecoderFilterSharedPtr filter, bool dual_filter) {
   ActiveStreamDecoderFilterPtr wrapper(new ActiveStreamDecoderFilter(*this, filter, dual_filter));
   filter->setDecoderFilterCallbacks(*wrapper);
-  wrapper->moveIntoListBack(std::move(wrapper), decoder_filters_);
+  wrapper->index_ = decoder_filters_.size();
+  decoder_filters_.push_back(std::move(wrapper));
 }
 
 void ConnectionManagerImpl::ActiveStream::addStreamEncoderFilterWorker(
     StreamEncoderFilterSharedPtr filter, bool dual_filter) {
   ActiveStreamEncoderFilterPtr wrapper(new ActiveStreamEncoderFilter(*this, filter, dual_filter));
   filter->setEncoderFilterCallbacks(*wrapper);
-  wrapper->moveIntoListBack(std::move(wrapper), encoder_filters_);
+  wrapper->index_ = encoder_filters_.size();
+  encoder_filters_.push_back(std::move(wrapper));
 }
 
 void ConnectionManagerImpl::ActiveStream::addAccessLogHandler(
@@ -448,7 +501,7 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
 #endif
 
   connection_manager_.user_agent_.initializeFromHeaders(
-      *request_headers_, connection_manager_.stats_.prefix_, connection_manager_.stats_.scope_);
+      *request_headers_, *connection_manager_.stats_.user_agent_context_);
 
   // Make sure we are getting a codec version we support.
   Protocol protocol = connection_manager_.codec_->protocol();
@@ -461,6 +514,15 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
     return;
   }
 
+  // Shed new streams while the server is overloaded.
+  if (connection_manager_.config_.rejectNewStreams()) {
+    connection_manager_.stats_.named_.downstream_rq_overload_reject_.inc();
+    HeaderMapImpl headers{
+        {Headers::get().Status, std::to_string(enumToInt(Code::ServiceUnavailable))}};
+    encodeHeaders(nullptr, headers, true);
+    return;
+  }
+
   // Require host header. For HTTP/1.1 Host has already been translated to :authority.
   if (!request_headers_->Host()) {
     HeaderMapImpl headers{{Headers::get().Status, std::to_string(enumToInt(Code::BadRequest))}};
@@ -506,6 +568,16 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
       connection_manager_.config_, *snapped_route_config_, connection_manager_.random_generator_,
       connection_manager_.runtime_, connection_manager_.local_info_);
 
+  // The access logs which can already tell that they won't log the stream, e.g. as it was not
+  // sampled, are skipped when the stream completes.
+  uint64_t access_log_bit = 1;
+  for (const AccessLog::InstanceSharedPtr& access_log : connection_manager_.config_.accessLogs()) {
+    if (access_log_bit != 0 && !access_log->mayLog(*request_headers_)) {
+      unloggable_access_logs_ |= access_log_bit;
+    }
+    access_log_bit <<= 1;
+  }
+
   ASSERT(!cached_route_.valid());
   cached_route_.value(snapped_route_config_->route(*request_headers_, stream_id_));
 
@@ -604,12 +676,12 @@ void ConnectionManagerImpl::ActiveStream::traceRequest() {
 
 void ConnectionManagerImpl::ActiveStream::decodeHeaders(ActiveStreamDecoderFilter* filter,
                                                         HeaderMap& headers, bool end_stream) {
-  std::list<ActiveStreamDecoderFilterPtr>::iterator entry;
-  std::list<ActiveStreamDecoderFilterPtr>::iterator continue_data_entry = decoder_filters_.end();
+  std::vector<ActiveStreamDecoderFilterPtr>::iterator entry;
+  std::vector<ActiveStreamDecoderFilterPtr>::iterator continue_data_entry = decoder_filters_.end();
   if (!filter) {
     entry = decoder_filters_.begin();
   } else {
-    entry = std::next(filter->entry());
+    entry = decoder_filters_.begin() + filter->index_ + 1;
   }
 
   for (; entry != decoder_filters_.end(); entry++) {
@@ -663,11 +735,11 @@ void ConnectionManagerImpl::ActiveStream::decodeData(ActiveStreamDecoderFilter*
     return;
   }
 
-  std::list<ActiveStreamDecoderFilterPtr>::iterator entry;
+  std::vector<ActiveStreamDecoderFilterPtr>::iterator entry;
   if (!filter) {
     entry = decoder_filters_.begin();
   } else {
-    entry = std::next(filter->entry());
+    entry = decoder_filters_.begin() + filter->index_ + 1;
   }
 
   for (; entry != decoder_filters_.end(); entry++) {
@@ -694,9 +766,15 @@ void ConnectionManagerImpl::ActiveStream::addDecodedData(ActiveStreamDecoderFilt
     // Inline processing happens in the decodeHeaders() callback if necessary.
     filter.commonHandleBufferData(data);
   } else if (state_.filter_call_state_ & FilterCallState::DecodeTrailers) {
-    // In this case we need to inline dispatch the data to further filters. If those filters
-    // choose to buffer/stop iteration that's fine.
-    decodeData(&filter, data, false);
+    if (filter.stopped_) {
+      // The further filters have not seen the headers yet. The data is buffered, and is sent on
+      // with the headers and the trailers once the filter continues.
+      filter.commonHandleBufferData(data);
+    } else {
+      // In this case we need to inline dispatch the data to further filters. If those filters
+      // choose to buffer/stop iteration that's fine.
+      decodeData(&filter, data, false);
+    }
   } else {
     // TODO(mattklein123): Formalize error handling for filters and add tests. Should probably
     // throw an exception here.
@@ -718,11 +796,11 @@ void ConnectionManagerImpl::ActiveStream::decodeTrailers(ActiveStreamDecoderFilt
     return;
   }
 
-  std::list<ActiveStreamDecoderFilterPtr>::iterator entry;
+  std::vector<ActiveStreamDecoderFilterPtr>::iterator entry;
   if (!filter) {
     entry = decoder_filters_.begin();
   } else {
-    entry = std::next(filter->entry());
+    entry = decoder_filters_.begin() + filter->index_ + 1;
   }
 
   for (; entry != decoder_filters_.end(); entry++) {
@@ -738,7 +816,7 @@ void ConnectionManagerImpl::ActiveStream::decodeTrailers(ActiveStreamDecoderFilt
   }
 }
 
-std::list<ConnectionManagerImpl::ActiveStreamEncoderFilterPtr>::iterator
+std::vector<ConnectionManagerImpl::ActiveStreamEncoderFilterPtr>::iterator
 ConnectionManagerImpl::ActiveStream::commonEncodePrefix(ActiveStreamEncoderFilter* filter,
                                                         bool end_stream) {
   // Only do base state setting on the initial call. Subsequent calls for filtering do not touch
@@ -751,7 +829,7 @@ ConnectionManagerImpl::ActiveStream::commonEncodePrefix(ActiveStreamEncoderFilte
   if (!filter) {
     return encoder_filters_.begin();
   } else {
-    return std::next(filter->entry());
+    return encoder_filters_.begin() + filter->index_ + 1;
   }
 }
 
@@ -766,8 +844,8 @@ void ConnectionManagerImpl::startDrainSequence() {
 
 void ConnectionManagerImpl::ActiveStream::encodeHeaders(ActiveStreamEncoderFilter* filter,
                                                         HeaderMap& headers, bool end_stream) {
-  std::list<ActiveStreamEncoderFilterPtr>::iterator entry = commonEncodePrefix(filter, end_stream);
-  std::list<ActiveStreamEncoderFilterPtr>::iterator continue_data_entry = encoder_filters_.end();
+  auto entry = commonEncodePrefix(filter, end_stream);
+  std::vector<ActiveStreamEncoderFilterPtr>::iterator continue_data_entry = encoder_filters_.end();
 
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeHeaders));
@@ -906,7 +984,7 @@ void ConnectionManagerImpl::ActiveStream::addEncodedData(ActiveStreamEncoderFilt
 
 void ConnectionManagerImpl::ActiveStream::encodeData(ActiveStreamEncoderFilter* filter,
                                                      Buffer::Instance& data, bool end_stream) {
-  std::list<ActiveStreamEncoderFilterPtr>::iterator entry = commonEncodePrefix(filter, end_stream);
+  auto entry = commonEncodePrefix(filter, end_stream);
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeData));
     state_.filter_call_state_ |= FilterCallState::EncodeData;
@@ -929,7 +1007,7 @@ void ConnectionManagerImpl::ActiveStream::encodeData(ActiveStreamEncoderFilter*
 
 void ConnectionManagerImpl::ActiveStream::encodeTrailers(ActiveStreamEncoderFilter* filter,
                                                          HeaderMap& trailers) {
-  std::list<ActiveStreamEncoderFilterPtr>::iterator entry = commonEncodePrefix(filter, true);
+  auto entry = commonEncodePrefix(filter, true);
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeTrailers));
     state_.filter_call_state_ |= FilterCallState::EncodeTrailers;
@@ -24,6 +24,7 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/buffer/watermark_buffer.h"
+#include "common/common/free_list.h"
 #include "common/common/linked_object.h"
 #include "common/http/access_log/request_info_impl.h"
 #include "common/http/date_provider.h"
@@ -75,6 +76,7 @@ namespace Http {
   COUNTER  (downstream_rq_non_relative_path)                                                       \
   COUNTER  (downstream_rq_ws_on_non_ws_route)                                                      \
   COUNTER  (downstream_rq_too_large)                                                               \
+  COUNTER  (downstream_rq_overload_reject)                                                         \
   COUNTER  (downstream_rq_2xx)                                                                     \
   COUNTER  (downstream_rq_3xx)                                                                     \
   COUNTER  (downstream_rq_4xx)                                                                     \
@@ -94,6 +96,7 @@ struct ConnectionManagerStats {
   ConnectionManagerNamedStats named_;
   std::string prefix_;
   Stats::Scope& scope_;
+  UserAgentContextSharedPtr user_agent_context_;
 };
 
 /**
@@ -105,6 +108,7 @@ struct ConnectionManagerStats {
   COUNTER(service_forced)                                                                          \
   COUNTER(client_enabled)                                                                          \
   COUNTER(not_traceable)                                                                           \
+  COUNTER(downstream_not_sampled)                                                                  \
   COUNTER(health_check)
 // clang-format on
 
@@ -210,6 +214,11 @@ public:
    */
   virtual bool generateRequestId() PURE;
 
+  /**
+   * @return whether new streams should be rejected with a 503 because the server is overloaded.
+   */
+  virtual bool rejectNewStreams() PURE;
+
   /**
    * @return optional idle timeout for incoming connection manager connections.
    */
@@ -369,12 +378,16 @@ private:
    * Wrapper for a stream decoder filter.
    */
   struct ActiveStreamDecoderFilter : public ActiveStreamFilterBase,
-                                     public StreamDecoderFilterCallbacks,
-                                     LinkedObject<ActiveStreamDecoderFilter> {
+                                     public StreamDecoderFilterCallbacks {
     ActiveStreamDecoderFilter(ActiveStream& parent, StreamDecoderFilterSharedPtr filter,
                               bool dual_filter)
         : ActiveStreamFilterBase(parent, dual_filter), handle_(filter) {}
 
+    // Filter wrappers are created and destroyed with every stream, so they are recycled through a
+    // per-thread free list.
+    static void* operator new(size_t size) { return FreeList<ActiveStreamDecoderFilter>::allocate(size); }
+    static void operator delete(void* p, size_t size) { FreeList<ActiveStreamDecoderFilter>::release(p, size); }
+
     // ActiveStreamFilterBase
     bool canContinue() override {
       // It is possible for the connection manager to respond directly to a request even while
@@ -418,6 +431,8 @@ private:
     void requestDataDrained();
 
     StreamDecoderFilterSharedPtr handle_;
+    // The position of the filter in ActiveStream::decoder_filters_.
+    size_t index_{};
   };
 
   typedef std::unique_ptr<ActiveStreamDecoderFilter> ActiveStreamDecoderFilterPtr;
@@ -426,12 +441,15 @@ private:
    * Wrapper for a stream encoder filter.
    */
   struct ActiveStreamEncoderFilter : public ActiveStreamFilterBase,
-                                     public StreamEncoderFilterCallbacks,
-                                     LinkedObject<ActiveStreamEncoderFilter> {
+                                     public StreamEncoderFilterCallbacks {
     ActiveStreamEncoderFilter(ActiveStream& parent, StreamEncoderFilterSharedPtr filter,
                               bool dual_filter)
         : ActiveStreamFilterBase(parent, dual_filter), handle_(filter) {}
 
+    // @see ActiveStreamDecoderFilter.
+    static void* operator new(size_t size) { return FreeList<ActiveStreamEncoderFilter>::allocate(size); }
+    static void operator delete(void* p, size_t size) { FreeList<ActiveStreamEncoderFilter>::release(p, size); }
+
     // ActiveStreamFilterBase
     bool canContinue() override { return true; }
     Buffer::WatermarkBufferPtr createBuffer() override;
@@ -461,6 +479,8 @@ private:
     void responseDataDrained();
 
     StreamEncoderFilterSharedPtr handle_;
+    // The position of the filter in ActiveStream::encoder_filters_.
+    size_t index_{};
   };
 
   typedef std::unique_ptr<ActiveStreamEncoderFilter> ActiveStreamEncoderFilterPtr;
@@ -479,10 +499,14 @@ private:
     ActiveStream(ConnectionManagerImpl& connection_manager);
     ~ActiveStream();
 
+    // Streams are recycled through a per-thread free list along with their filter wrappers.
+    static void* operator new(size_t size) { return FreeList<ActiveStream>::allocate(size); }
+    static void operator delete(void* p, size_t size) { FreeList<ActiveStream>::release(p, size); }
+
     void addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr filter, bool dual_filter);
     void addStreamEncoderFilterWorker(StreamEncoderFilterSharedPtr filter, bool dual_filter);
     void chargeStats(HeaderMap& headers);
-    std::list<ActiveStreamEncoderFilterPtr>::iterator
+    std::vector<ActiveStreamEncoderFilterPtr>::iterator
     commonEncodePrefix(ActiveStreamEncoderFilter* filter, bool end_stream);
     uint64_t connectionId();
     const Network::Connection* connection();
@@ -525,6 +549,9 @@ private:
     void sendHeadersOnlyResponse(HeaderMap& headers) override {
       encodeHeaders(nullptr, headers, true);
     }
+    void onUpgradeRequestSent() override {
+      connection_manager_.onWebSocketUpgradeRequestSent(*this);
+    }
 
     // Tracing::TracingConfig
     virtual Tracing::OperationName operationName() const override;
@@ -581,12 +608,16 @@ private:
     HeaderMapPtr request_headers_;
     Buffer::WatermarkBufferPtr buffered_request_data_;
     HeaderMapPtr request_trailers_;
-    std::list<ActiveStreamDecoderFilterPtr> decoder_filters_;
-    std::list<ActiveStreamEncoderFilterPtr> encoder_filters_;
+    // The filters are kept contiguous and walked by index, as every callback of every stream
+    // iterates them.
+    std::vector<ActiveStreamDecoderFilterPtr> decoder_filters_;
+    std::vector<ActiveStreamEncoderFilterPtr> encoder_filters_;
     std::list<Http::AccessLog::InstanceSharedPtr> access_log_handlers_;
     Stats::TimespanPtr request_timer_;
     State state_;
     AccessLog::RequestInfoImpl request_info_;
+    // A bit for each of the first 64 access logs of the config, set if it won't log the stream.
+    uint64_t unloggable_access_logs_{};
     Optional<Router::RouteConstSharedPtr> cached_route_;
     DownstreamWatermarkCallbacks* watermark_callbacks_{nullptr};
     uint32_t buffer_limit_{0};
@@ -613,6 +644,12 @@ private:
    */
   void doEndStream(ActiveStream& stream);
 
+  /**
+   * Optionally release the stream of a WebSocket connection once the upgrade request has been
+   * sent upstream, leaving only the tunnel. In that case the idle timeout applies to the tunnel.
+   */
+  void onWebSocketUpgradeRequestSent(ActiveStream& stream);
+
   void resetAllStreams();
   void onIdleTimeout();
   void onDrainTimeout();
@@ -641,6 +678,8 @@ private:
   WebSocket::WsHandlerImplPtr ws_connection_{};
   Network::ReadFilterCallbacks* read_callbacks_{};
   ConnectionManagerListenerStats& listener_stats_;
+  // The active requests gauge of the worker which owns the connection, if it keeps one.
+  Stats::Gauge* worker_rq_active_{};
 };
 
 } // Http
@@ -37,12 +37,17 @@ void ConnectionManagerUtility::mutateRequestHeaders(
   // If we are "using remote address" this means that we create/append to XFF with our immediate
   // peer. Cases where we don't "use remote address" include trusted double proxy where we expect
   // our peer to have already properly set XFF, etc.
+  const Network::Address::Instance* only_xff_address = nullptr;
   if (config.useRemoteAddress()) {
-    if (Network::Utility::isLoopbackAddress(connection.remoteAddress())) {
-      Utility::appendXff(request_headers, config.localAddress());
-    } else {
-      Utility::appendXff(request_headers, connection.remoteAddress());
+    const Network::Address::Instance& xff_address =
+        Network::Utility::isLoopbackAddress(connection.remoteAddress())
+            ? config.localAddress()
+            : connection.remoteAddress();
+    if (xff_address.type() == Network::Address::Type::Ip &&
+        (!request_headers.ForwardedFor() || request_headers.ForwardedFor()->value().empty())) {
+      only_xff_address = &xff_address;
     }
+    Utility::appendXff(request_headers, xff_address);
     request_headers.insertForwardedProto().value().setReference(
         connection.ssl() ? Headers::get().SchemeValues.Https : Headers::get().SchemeValues.Http);
   }
@@ -55,8 +60,11 @@ void ConnectionManagerUtility::mutateRequestHeaders(
   }
 
   // At this point we can determine whether this is an internal or external request. This is done
-  // via XFF, which was set above or we trust.
-  bool internal_request = Utility::isInternalRequest(request_headers);
+  // via XFF, which was set above or we trust. If XFF only holds the address appended above, that
+  // address is checked directly rather than parsed back out of the header.
+  bool internal_request = only_xff_address != nullptr
+                              ? Network::Utility::isInternalAddress(*only_xff_address)
+                              : Utility::isInternalRequest(request_headers);
 
   // Edge request is the request from external clients to front Envoy.
   // Request from front Envoy to the internal service will be treated as not edge request.
@@ -83,9 +91,7 @@ void ConnectionManagerUtility::mutateRequestHeaders(
     request_headers.removeEnvoyExpectedRequestTimeoutMs();
     request_headers.removeEnvoyForceTrace();
 
-    for (const Http::LowerCaseString& header : route_config.internalOnlyHeaders()) {
-      request_headers.remove(header);
-    }
+    request_headers.remove(route_config.internalOnlyHeaders());
   }
 
   if (config.userAgent().valid()) {
@@ -111,10 +117,10 @@ void ConnectionManagerUtility::mutateRequestHeaders(
 
   // Generate x-request-id for all edge requests, or if there is none.
   if (config.generateRequestId() && (edge_request || !request_headers.RequestId())) {
-    // TODO(PiotrSikora) PERF: Write UUID directly to the header map.
-    const std::string uuid = random.uuid();
-    ASSERT(!uuid.empty());
-    request_headers.insertRequestId().value(uuid);
+    // The UUID is formatted on the stack and copied into the inline storage of the header.
+    char uuid[Runtime::RandomGenerator::UUID_LENGTH];
+    random.uuid(uuid);
+    request_headers.insertRequestId().value(uuid, sizeof(uuid));
   }
 
   if (config.tracingConfig()) {
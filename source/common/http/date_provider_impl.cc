@@ -26,7 +26,7 @@ void TlsCachingDateProviderImpl::onRefreshDate() {
 }
 
 void TlsCachingDateProviderImpl::setDateHeader(HeaderMap& headers) {
-  headers.insertDate().value(tls_->getTyped<ThreadLocalCachedDate>().date_string_);
+  headers.insertDate().value().setShared(*tls_->getTyped<ThreadLocalCachedDate>().date_value_);
 }
 
 void SlowDateProviderImpl::setDateHeader(HeaderMap& headers) {
@@ -8,6 +8,7 @@
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/utility.h"
+#include "common/http/header_value_interner.h"
 
 #include "date_provider.h"
 
@@ -24,7 +25,8 @@ protected:
 
 /**
  * A caching thread local provider. This implementation updates the date string every 500ms and
- * caches on each thread.
+ * caches on each thread. The cached value is shared by the Date header of every response rather
+ * than copied into each of them.
  */
 class TlsCachingDateProviderImpl : public DateProviderImplBase, public Singleton::Instance {
 public:
@@ -35,9 +37,12 @@ public:
 
 private:
   struct ThreadLocalCachedDate : public ThreadLocal::ThreadLocalObject {
-    ThreadLocalCachedDate(const std::string& date_string) : date_string_(date_string) {}
+    ThreadLocalCachedDate(const std::string& date_string)
+        : date_value_(SharedHeaderValue::create(date_string.c_str(), date_string.size())) {}
+    ~ThreadLocalCachedDate() { date_value_->release(); }
 
-    const std::string date_string_;
+    // Headers which still refer to the value keep it alive once the date has been refreshed.
+    SharedHeaderValue* const date_value_;
   };
 
   void onRefreshDate();
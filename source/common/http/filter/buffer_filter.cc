@@ -1,6 +1,11 @@
 #include "common/http/filter/buffer_filter.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
@@ -17,6 +22,73 @@
 namespace Envoy {
 namespace Http {
 
+namespace {
+
+/**
+ * A fragment which maps a spilled body, and unmaps it once no buffer references it.
+ */
+class MappedFragment : public Buffer::BufferFragment {
+public:
+  MappedFragment(void* data, size_t size) : data_(data), size_(size) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return data_; }
+  size_t size() const override { return size_; }
+  void done() override {
+    munmap(data_, size_);
+    delete this;
+  }
+
+private:
+  void* const data_;
+  const size_t size_;
+};
+
+} // namespace
+
+BufferFilter::SpillFile::SpillFile(const std::string& directory) {
+  std::string path = directory + "/envoy_buffer_XXXXXX";
+  std::vector<char> path_template(path.begin(), path.end());
+  path_template.push_back(0);
+  fd_ = mkstemp(path_template.data());
+  // Nothing else opens the file, so it is unlinked right away and goes with its descriptor.
+  if (fd_ != -1) {
+    unlink(path_template.data());
+  }
+}
+
+BufferFilter::SpillFile::~SpillFile() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+bool BufferFilter::SpillFile::write(Buffer::Instance& data) {
+  while (data.length() > 0) {
+    const int rc = data.write(fd_);
+    if (rc == -1) {
+      return false;
+    }
+    size_ += rc;
+  }
+
+  return true;
+}
+
+bool BufferFilter::SpillFile::moveTo(Buffer::Instance& buffer) {
+  if (size_ == 0) {
+    return true;
+  }
+
+  // The mapping keeps the contents of the file once its descriptor is closed.
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  buffer.addBufferFragment(*new MappedFragment(data, size_));
+  return true;
+}
+
 BufferFilter::BufferFilter(BufferFilterConfigConstSharedPtr config) : config_(config) {}
 
 BufferFilter::~BufferFilter() { ASSERT(!request_timeout_); }
@@ -34,7 +106,11 @@ FilterHeadersStatus BufferFilter::decodeHeaders(HeaderMap&, bool end_stream) {
   }
 }
 
-FilterDataStatus BufferFilter::decodeData(Buffer::Instance&, bool end_stream) {
+FilterDataStatus BufferFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (!config_->spill_directory_.empty()) {
+    return decodeDataSpilling(data, end_stream);
+  }
+
   if (end_stream) {
     resetInternalState();
     return FilterDataStatus::Continue;
@@ -44,11 +120,98 @@ FilterDataStatus BufferFilter::decodeData(Buffer::Instance&, bool end_stream) {
   return FilterDataStatus::StopIterationAndBuffer;
 }
 
+FilterDataStatus BufferFilter::decodeDataSpilling(Buffer::Instance& data, bool end_stream) {
+  // The connection manager only buffers the part of the body which is kept in memory, so the
+  // request size is enforced here.
+  request_bytes_ += data.length();
+  if (request_bytes_ > config_->max_request_bytes_) {
+    resetInternalState();
+    Http::Utility::sendLocalReply(*callbacks_, stream_destroyed_, Http::Code::PayloadTooLarge,
+                                  CodeUtility::toString(Http::Code::PayloadTooLarge));
+    return FilterDataStatus::StopIterationNoBuffer;
+  }
+
+  if (end_stream) {
+    resetInternalState();
+    // The spilled part of the body goes after the part in memory, which the connection manager
+    // has buffered, and before the last data.
+    Buffer::OwnedImpl spilled;
+    if (!moveSpilledData(spilled)) {
+      return FilterDataStatus::StopIterationNoBuffer;
+    }
+    data.prepend(spilled);
+    return FilterDataStatus::Continue;
+  }
+
+  // Once the body starts spilling, the rest of it spills too, to keep it in order.
+  if (!spill_file_ && keepInMemory(data.length())) {
+    return FilterDataStatus::StopIterationAndBuffer;
+  }
+
+  if (!spill_file_) {
+    spill_file_.reset(new SpillFile(config_->spill_directory_));
+    config_->stats_.rq_spilled_.inc();
+  }
+  if (spill_file_->fd() == -1 || !spill_file_->write(data)) {
+    onSpillError();
+  }
+  return FilterDataStatus::StopIterationNoBuffer;
+}
+
 FilterTrailersStatus BufferFilter::decodeTrailers(HeaderMap&) {
   resetInternalState();
+  if (spill_file_) {
+    Buffer::OwnedImpl spilled;
+    if (!moveSpilledData(spilled)) {
+      return FilterTrailersStatus::StopIteration;
+    }
+    callbacks_->addDecodedData(spilled, false);
+  }
+
   return FilterTrailersStatus::Continue;
 }
 
+bool BufferFilter::keepInMemory(uint64_t length) {
+  if (memory_bytes_ + length > config_->spill_threshold_bytes_) {
+    return false;
+  }
+
+  if (config_->worker_memory_) {
+    BufferFilterWorkerMemory& worker_memory =
+        config_->worker_memory_->getTyped<BufferFilterWorkerMemory>();
+    if (config_->max_worker_memory_bytes_ > 0 &&
+        worker_memory.bytes_ + length > config_->max_worker_memory_bytes_) {
+      return false;
+    }
+    worker_memory.bytes_ += length;
+  }
+
+  memory_bytes_ += length;
+  return true;
+}
+
+bool BufferFilter::moveSpilledData(Buffer::Instance& buffer) {
+  if (!spill_file_) {
+    return true;
+  }
+
+  if (!spill_file_->moveTo(buffer)) {
+    onSpillError();
+    return false;
+  }
+
+  spill_file_.reset();
+  return true;
+}
+
+void BufferFilter::onSpillError() {
+  resetInternalState();
+  spill_file_.reset();
+  config_->stats_.rq_spill_error_.inc();
+  Http::Utility::sendLocalReply(*callbacks_, stream_destroyed_, Http::Code::InternalServerError,
+                                "buffer spill error");
+}
+
 BufferFilterStats BufferFilter::generateStats(const std::string& prefix, Stats::Scope& scope) {
   std::string final_prefix = prefix + "buffer.";
   return {ALL_BUFFER_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
@@ -56,6 +219,7 @@ BufferFilterStats BufferFilter::generateStats(const std::string& prefix, Stats::
 
 void BufferFilter::onDestroy() {
   resetInternalState();
+  releaseMemory();
   stream_destroyed_ = true;
 }
 
@@ -67,6 +231,13 @@ void BufferFilter::onRequestTimeout() {
 
 void BufferFilter::resetInternalState() { request_timeout_.reset(); }
 
+void BufferFilter::releaseMemory() {
+  if (config_->worker_memory_ && memory_bytes_ > 0) {
+    config_->worker_memory_->getTyped<BufferFilterWorkerMemory>().bytes_ -= memory_bytes_;
+  }
+  memory_bytes_ = 0;
+}
+
 void BufferFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) {
   callbacks_ = &callbacks;
   callbacks_->setDecoderBufferLimit(config_->max_request_bytes_);
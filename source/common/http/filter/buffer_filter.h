@@ -7,6 +7,7 @@
 
 #include "envoy/http/filter.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 
 #include "common/buffer/buffer_impl.h"
 
@@ -18,7 +19,9 @@ namespace Http {
  */
 // clang-format off
 #define ALL_BUFFER_FILTER_STATS(COUNTER)                                                           \
-  COUNTER(rq_timeout)
+  COUNTER(rq_timeout)                                                                              \
+  COUNTER(rq_spilled)                                                                              \
+  COUNTER(rq_spill_error)
 // clang-format on
 
 /**
@@ -28,6 +31,13 @@ struct BufferFilterStats {
   ALL_BUFFER_FILTER_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+/**
+ * The bytes of request bodies which the buffer filters of a worker hold in memory.
+ */
+struct BufferFilterWorkerMemory : public ThreadLocal::ThreadLocalObject {
+  uint64_t bytes_{};
+};
+
 /**
  * Configuration for the buffer filter.
  */
@@ -35,6 +45,14 @@ struct BufferFilterConfig {
   BufferFilterStats stats_;
   uint64_t max_request_bytes_;
   std::chrono::seconds max_request_time_;
+  // If set, the body past spill_threshold_bytes_ is written to an unlinked file in this directory
+  // rather than held in memory, and is sent on from a memory mapping of the file.
+  std::string spill_directory_{};
+  uint64_t spill_threshold_bytes_{};
+  // With spilling, the most body bytes which the filters of a worker hold in memory together
+  // before spilling, or 0 for no limit. Tracked in worker_memory_.
+  uint64_t max_worker_memory_bytes_{};
+  ThreadLocal::SlotPtr worker_memory_{};
 };
 
 typedef std::shared_ptr<const BufferFilterConfig> BufferFilterConfigConstSharedPtr;
@@ -59,13 +77,52 @@ public:
   void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override;
 
 private:
+  /**
+   * An unlinked file which holds the spilled part of a request body.
+   */
+  class SpillFile {
+  public:
+    SpillFile(const std::string& directory);
+    ~SpillFile();
+
+    /**
+     * Append and drain data.
+     * @return bool whether all the data was written.
+     */
+    bool write(Buffer::Instance& data);
+
+    /**
+     * Map the file and move its contents to a buffer, as a fragment which unmaps the file once
+     * the buffer is done with it.
+     * @return bool whether the file could be mapped.
+     */
+    bool moveTo(Buffer::Instance& buffer);
+
+    int fd() const { return fd_; }
+
+  private:
+    int fd_;
+    uint64_t size_{};
+  };
+
+  typedef std::unique_ptr<SpillFile> SpillFilePtr;
+
+  FilterDataStatus decodeDataSpilling(Buffer::Instance& data, bool end_stream);
+  bool keepInMemory(uint64_t length);
+  bool moveSpilledData(Buffer::Instance& buffer);
+  void onSpillError();
   void onRequestTimeout();
   void resetInternalState();
+  void releaseMemory();
 
   BufferFilterConfigConstSharedPtr config_;
   StreamDecoderFilterCallbacks* callbacks_{};
   Event::TimerPtr request_timeout_;
   bool stream_destroyed_{};
+  // With spilling, the body bytes received so far, and those of them held in memory.
+  uint64_t request_bytes_{};
+  uint64_t memory_bytes_{};
+  SpillFilePtr spill_file_;
 };
 
 } // Http
@@ -0,0 +1,418 @@
+#include "common/http/filter/cache_filter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include "envoy/http/codes.h"
+
+#include "common/common/assert.h"
+#include "common/common/empty_string.h"
+#include "common/common/enum_to_int.h"
+#include "common/common/utility.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+#include "common/json/config_schemas.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+// Trim the whitespace around a header value token.
+std::string trim(const std::string& source) {
+  const size_t start = source.find_first_not_of(" \t");
+  if (start == std::string::npos) {
+    return EMPTY_STRING;
+  }
+  return source.substr(start, source.find_last_not_of(" \t") - start + 1);
+}
+
+/**
+ * A fragment which references the body of a cached response, and keeps the response alive until
+ * no buffer references it any longer.
+ */
+class CachedBodyFragment : public Buffer::BufferFragment {
+public:
+  CachedBodyFragment(const CachedResponseConstSharedPtr& response) : response_(response) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return response_->body_.data(); }
+  size_t size() const override { return response_->body_.size(); }
+  void done() override { delete this; }
+
+private:
+  const CachedResponseConstSharedPtr response_;
+};
+
+uint64_t headerBytes(const HeaderMap& headers) {
+  uint64_t bytes = 0;
+  headers.iterate(
+      [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        *static_cast<uint64_t*>(context) += header.key().size() + header.value().size();
+        return HeaderMap::Iterate::Continue;
+      },
+      &bytes);
+  return bytes;
+}
+
+// Whether an if-none-match header lists the entity tag of a response, with the weak comparison.
+// See https://tools.ietf.org/html/rfc7232#section-3.2
+bool matchesEntityTag(const HeaderEntry& if_none_match, const HeaderEntry* etag) {
+  if (etag == nullptr) {
+    return false;
+  }
+  const auto strip_weak = [](const std::string& tag) -> std::string {
+    return tag.compare(0, 2, "W/") == 0 ? tag.substr(2) : tag;
+  };
+  const std::string response_tag = strip_weak(trim(etag->value().c_str()));
+  for (const std::string& tag : StringUtil::split(if_none_match.value().c_str(), ",")) {
+    const std::string request_tag = trim(tag);
+    if (request_tag == "*" || strip_weak(request_tag) == response_tag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+CachedResponseConstSharedPtr ResponseCache::lookup(const std::string& key, MonotonicTime now) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+
+  if (now >= it->second->response_->expiry_time_) {
+    remove(it->second);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->response_;
+}
+
+uint64_t ResponseCache::insert(const std::string& key, CachedResponseConstSharedPtr response) {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    remove(it->second);
+  }
+
+  const uint64_t size = key.size() + headerBytes(*response->headers_) + response->body_.size();
+  entries_.push_front({key, std::move(response), size});
+  index_.emplace(key, entries_.begin());
+  bytes_ += size;
+
+  // The response which was just inserted is evicted too if it does not fit on its own.
+  uint64_t evicted = 0;
+  while (bytes_ > max_bytes_) {
+    remove(std::prev(entries_.end()));
+    evicted++;
+  }
+  return evicted;
+}
+
+void ResponseCache::remove(EntryList::iterator entry) {
+  bytes_ -= entry->size_;
+  index_.erase(entry->key_);
+  entries_.erase(entry);
+}
+
+bool ResponseCache::startFill(const std::string& key) {
+  return fills_.emplace(key, std::list<CacheFilter*>()).second;
+}
+
+void ResponseCache::wait(const std::string& key, CacheFilter& filter) {
+  auto it = fills_.find(key);
+  ASSERT(it != fills_.end());
+  it->second.push_back(&filter);
+}
+
+void ResponseCache::cancelWait(const std::string& key, CacheFilter& filter) {
+  auto it = fills_.find(key);
+  if (it != fills_.end()) {
+    it->second.remove(&filter);
+  }
+}
+
+void ResponseCache::completeFill(const std::string& key,
+                                 const CachedResponseConstSharedPtr& response) {
+  auto it = fills_.find(key);
+  ASSERT(it != fills_.end());
+  // The filters are called back after the fill is gone, so that those which go upstream can start
+  // a fill of their own later on.
+  std::list<CacheFilter*> waiters = std::move(it->second);
+  fills_.erase(it);
+  for (CacheFilter* filter : waiters) {
+    filter->onFillComplete(response);
+  }
+}
+
+CacheFilterConfig::CacheFilterConfig(const Json::Object& json_config,
+                                     const std::string& stats_prefix, Stats::Scope& scope,
+                                     ThreadLocal::SlotAllocator& tls,
+                                     MonotonicTimeSource& time_source)
+    : Json::Validator(json_config, Json::Schema::CACHE_HTTP_FILTER_SCHEMA),
+      stats_(generateStats(stats_prefix, scope)),
+      max_bytes_(json_config.getInteger("max_bytes", 64 * 1024 * 1024)),
+      max_entry_bytes_(json_config.getInteger("max_entry_bytes", 1024 * 1024)),
+      coalesce_requests_(json_config.getBoolean("coalesce_requests", true)),
+      time_source_(time_source), tls_slot_(tls.allocateSlot()) {
+  const uint64_t max_bytes = max_bytes_;
+  tls_slot_->set([max_bytes](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ResponseCache>(max_bytes);
+  });
+}
+
+CacheFilterStats CacheFilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  const std::string final_prefix = prefix + "cache.";
+  return {ALL_CACHE_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                 POOL_GAUGE_PREFIX(scope, final_prefix))};
+}
+
+CacheFilter::CacheFilter(CacheFilterConfigSharedPtr config) : config_(config) {}
+
+CacheFilter::~CacheFilter() {
+  ASSERT(state_ != State::Filling && state_ != State::Waiting);
+}
+
+void CacheFilter::onDestroy() {
+  if (state_ == State::Filling) {
+    finishFill(false);
+  } else if (state_ == State::Waiting) {
+    config_->cache().cancelWait(key_, *this);
+    state_ = State::PassThrough;
+  }
+}
+
+FilterHeadersStatus CacheFilter::decodeHeaders(HeaderMap& headers, bool end_stream) {
+  // Only header only GET requests which do not depend on the credentials or on a range are
+  // looked up.
+  if (!end_stream || headers.Method() == nullptr || headers.Path() == nullptr ||
+      headers.Method()->value() != Headers::get().MethodValues.Get.c_str() ||
+      headers.Authorization() != nullptr || headers.get(Headers::get().Range) != nullptr) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  // A request which asks for a response validated by the origin goes upstream, and does not fill
+  // the cache either, as its response is not one which the cache would have served.
+  const HeaderEntry* cache_control = headers.get(Headers::get().CacheControl);
+  if (cache_control != nullptr) {
+    const std::string value = cache_control->value().c_str();
+    if (value.find(Headers::get().CacheControlValues.NoCache) != std::string::npos ||
+        value.find(Headers::get().CacheControlValues.NoStore) != std::string::npos) {
+      return FilterHeadersStatus::Continue;
+    }
+  }
+
+  request_headers_ = &headers;
+  key_ = std::string(headers.Host() ? headers.Host()->value().c_str() : "") +
+         headers.Path()->value().c_str();
+  ResponseCache& cache = config_->cache();
+  CachedResponseConstSharedPtr response =
+      cache.lookup(key_, config_->timeSource().currentTime());
+  if (response != nullptr) {
+    config_->stats().hit_.inc();
+    serve(response);
+    return FilterHeadersStatus::StopIteration;
+  }
+
+  config_->stats().miss_.inc();
+  // The response to a conditional request may have no body, so it does not fill the cache.
+  if (headers.get(Headers::get().IfNoneMatch) != nullptr ||
+      headers.get(Headers::get().IfModifiedSince) != nullptr) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  if (cache.startFill(key_)) {
+    state_ = State::Filling;
+    return FilterHeadersStatus::Continue;
+  }
+
+  if (!config_->coalesceRequests()) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().coalesced_.inc();
+  state_ = State::Waiting;
+  cache.wait(key_, *this);
+  return FilterHeadersStatus::StopIteration;
+}
+
+FilterHeadersStatus CacheFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (state_ != State::Filling) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  freshness_lifetime_ = freshnessLifetime(headers);
+  if (!isCacheable(headers)) {
+    config_->stats().uncacheable_.inc();
+    finishFill(false);
+    return FilterHeadersStatus::Continue;
+  }
+
+  response_headers_.reset(new HeaderMapImpl(headers));
+  if (end_stream) {
+    finishFill(true);
+  }
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (state_ != State::Filling) {
+    return FilterDataStatus::Continue;
+  }
+
+  if (response_body_.length() + data.length() > config_->maxEntryBytes()) {
+    config_->stats().uncacheable_.inc();
+    finishFill(false);
+    return FilterDataStatus::Continue;
+  }
+
+  response_body_.add(data);
+  if (end_stream) {
+    finishFill(true);
+  }
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus CacheFilter::encodeTrailers(HeaderMap&) {
+  if (state_ == State::Filling) {
+    config_->stats().uncacheable_.inc();
+    finishFill(false);
+  }
+  return FilterTrailersStatus::Continue;
+}
+
+void CacheFilter::onFillComplete(const CachedResponseConstSharedPtr& response) {
+  ASSERT(state_ == State::Waiting);
+  state_ = State::PassThrough;
+  if (response != nullptr) {
+    serve(response);
+  } else {
+    decoder_callbacks_->continueDecoding();
+  }
+}
+
+std::chrono::seconds CacheFilter::freshnessLifetime(const HeaderMap& headers) {
+  const HeaderEntry* cache_control = headers.get(Headers::get().CacheControl);
+  if (cache_control == nullptr) {
+    return std::chrono::seconds(0);
+  }
+
+  uint64_t max_age = 0;
+  bool has_s_maxage = false;
+  for (const std::string& token : StringUtil::split(cache_control->value().c_str(), ",")) {
+    std::string directive = trim(token);
+    std::transform(directive.begin(), directive.end(), directive.begin(), ::tolower);
+    const size_t equals = directive.find('=');
+    const std::string name = trim(directive.substr(0, equals));
+    if (name == Headers::get().CacheControlValues.NoStore ||
+        name == Headers::get().CacheControlValues.NoCache ||
+        name == Headers::get().CacheControlValues.Private) {
+      return std::chrono::seconds(0);
+    }
+
+    const bool is_s_maxage = name == Headers::get().CacheControlValues.SMaxAge;
+    if ((is_s_maxage || (name == Headers::get().CacheControlValues.MaxAge && !has_s_maxage)) &&
+        equals != std::string::npos) {
+      std::string value = trim(directive.substr(equals + 1));
+      if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+      }
+      if (!StringUtil::atoul(value.c_str(), max_age)) {
+        return std::chrono::seconds(0);
+      }
+      has_s_maxage |= is_s_maxage;
+    }
+  }
+
+  uint64_t age = 0;
+  const HeaderEntry* age_header = headers.get(Headers::get().Age);
+  if (age_header != nullptr && !StringUtil::atoul(age_header->value().c_str(), age)) {
+    return std::chrono::seconds(0);
+  }
+  return std::chrono::seconds(max_age > age ? max_age - age : 0);
+}
+
+bool CacheFilter::isCacheable(const HeaderMap& headers) const {
+  // Responses which vary are not cached, as the key is only the host and path.
+  return Utility::getResponseStatus(headers) == enumToInt(Code::OK) &&
+         freshness_lifetime_.count() > 0 && headers.get(Headers::get().SetCookie) == nullptr &&
+         headers.get(Headers::get().Vary) == nullptr;
+}
+
+void CacheFilter::finishFill(bool store) {
+  ASSERT(state_ == State::Filling);
+  state_ = State::PassThrough;
+  ResponseCache& cache = config_->cache();
+
+  CachedResponseConstSharedPtr response;
+  if (store) {
+    const MonotonicTime now = config_->timeSource().currentTime();
+    const HeaderEntry* age = response_headers_->get(Headers::get().Age);
+    uint64_t initial_age = 0;
+    if (age != nullptr) {
+      StringUtil::atoul(age->value().c_str(), initial_age);
+    }
+    std::shared_ptr<CachedResponse> cached = std::make_shared<CachedResponse>();
+    cached->headers_ = std::move(response_headers_);
+    cached->headers_->remove(Headers::get().Age);
+    cached->body_.resize(response_body_.length());
+    if (!cached->body_.empty()) {
+      response_body_.copyOut(0, cached->body_.size(), &cached->body_[0]);
+    }
+    cached->stored_time_ = now;
+    cached->expiry_time_ = now + freshness_lifetime_;
+    cached->initial_age_ = std::chrono::seconds(initial_age);
+    response = cached;
+
+    const uint64_t bytes = cache.bytes();
+    config_->stats().insert_.inc();
+    config_->stats().evicted_.add(cache.insert(key_, response));
+    config_->stats().cached_bytes_.add(cache.bytes());
+    config_->stats().cached_bytes_.sub(bytes);
+  }
+  response_headers_.reset();
+  response_body_.drain(response_body_.length());
+  cache.completeFill(key_, response);
+}
+
+void CacheFilter::serve(const CachedResponseConstSharedPtr& response) {
+  state_ = State::Served;
+  const std::chrono::seconds age =
+      response->initial_age_ + std::chrono::duration_cast<std::chrono::seconds>(
+                                   config_->timeSource().currentTime() - response->stored_time_);
+
+  const HeaderEntry* if_none_match = request_headers_->get(Headers::get().IfNoneMatch);
+  const HeaderEntry* etag = response->headers_->get(Headers::get().Etag);
+  if (if_none_match != nullptr && matchesEntityTag(*if_none_match, etag)) {
+    config_->stats().not_modified_.inc();
+    HeaderMapPtr headers{new HeaderMapImpl{
+        {Headers::get().Status, std::to_string(enumToInt(Code::NotModified))},
+        {Headers::get().Etag, etag->value().c_str()}}};
+    const HeaderEntry* cache_control = response->headers_->get(Headers::get().CacheControl);
+    if (cache_control != nullptr) {
+      headers->addCopy(Headers::get().CacheControl, cache_control->value().c_str());
+    }
+    headers->addCopy(Headers::get().Age, age.count());
+    decoder_callbacks_->encodeHeaders(std::move(headers), true);
+    return;
+  }
+
+  HeaderMapPtr headers{new HeaderMapImpl(*response->headers_)};
+  headers->addCopy(Headers::get().Age, age.count());
+  if (response->body_.empty()) {
+    decoder_callbacks_->encodeHeaders(std::move(headers), true);
+    return;
+  }
+
+  decoder_callbacks_->encodeHeaders(std::move(headers), false);
+  Buffer::OwnedImpl body;
+  body.addBufferFragment(*new CachedBodyFragment(response));
+  decoder_callbacks_->encodeData(body, true);
+}
+
+} // namespace Http
+} // namespace Envoy
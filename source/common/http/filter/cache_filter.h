@@ -0,0 +1,235 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/common/time.h"
+#include "envoy/http/filter.h"
+#include "envoy/json/json_object.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/json/json_validator.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the cache filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CACHE_FILTER_STATS(COUNTER, GAUGE)                                                     \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(coalesced)                                                                               \
+  COUNTER(not_modified)                                                                            \
+  COUNTER(insert)                                                                                  \
+  COUNTER(evicted)                                                                                 \
+  COUNTER(uncacheable)                                                                             \
+  GAUGE  (cached_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for cache filter stats. @see stats_macros.h
+ */
+struct CacheFilterStats {
+  ALL_CACHE_FILTER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * A response stored by the cache filter. Its body is added to the responses served from it as a
+ * buffer fragment, without copying, and the fragment keeps it alive until the buffers are done
+ * with it, even if it is evicted in the meantime.
+ */
+struct CachedResponse {
+  HeaderMapPtr headers_;
+  std::string body_;
+  MonotonicTime stored_time_;
+  MonotonicTime expiry_time_;
+  // The age of the response when it was stored, from the age header of the origin.
+  std::chrono::seconds initial_age_;
+};
+
+typedef std::shared_ptr<const CachedResponse> CachedResponseConstSharedPtr;
+
+class CacheFilter;
+
+/**
+ * The responses cached by the cache filters of a worker, keyed by host and path. Once they take
+ * more than the configured bytes, the least recently used are evicted. It also tracks the keys
+ * being filled by a request which went upstream, along with the filters waiting for them.
+ */
+class ResponseCache : public ThreadLocal::ThreadLocalObject {
+public:
+  ResponseCache(uint64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  /**
+   * @return CachedResponseConstSharedPtr the fresh response cached for a key, or nullptr. A stale
+   *         response is evicted.
+   * @param key supplies the key.
+   * @param now supplies the current time.
+   */
+  CachedResponseConstSharedPtr lookup(const std::string& key, MonotonicTime now);
+
+  /**
+   * Cache a response, replacing the response cached for the key if any, and evict the least
+   * recently used responses until the cache fits.
+   * @return uint64_t the number of responses evicted.
+   */
+  uint64_t insert(const std::string& key, CachedResponseConstSharedPtr response);
+
+  /**
+   * Start filling a key, unless it is being filled already.
+   * @return bool whether the caller fills the key.
+   */
+  bool startFill(const std::string& key);
+
+  /**
+   * Wait for the fill of a key, which must be in progress. The filter is called back with
+   * CacheFilter::onFillComplete().
+   */
+  void wait(const std::string& key, CacheFilter& filter);
+
+  /**
+   * Stop waiting for the fill of a key.
+   */
+  void cancelWait(const std::string& key, CacheFilter& filter);
+
+  /**
+   * Complete the fill of a key, and call back the filters which wait for it.
+   * @param response supplies the response which was cached, or nullptr if none was.
+   */
+  void completeFill(const std::string& key, const CachedResponseConstSharedPtr& response);
+
+  /**
+   * @return uint64_t the bytes of the cached responses, their keys and headers included.
+   */
+  uint64_t bytes() const { return bytes_; }
+
+  /**
+   * @return size_t the number of cached responses.
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    std::string key_;
+    CachedResponseConstSharedPtr response_;
+    uint64_t size_;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  void remove(EntryList::iterator entry);
+
+  const uint64_t max_bytes_;
+  uint64_t bytes_{};
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  std::unordered_map<std::string, std::list<CacheFilter*>> fills_;
+};
+
+/**
+ * Configuration for the cache filter, which owns the cache of each worker.
+ */
+class CacheFilterConfig : Json::Validator {
+public:
+  CacheFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                    Stats::Scope& scope, ThreadLocal::SlotAllocator& tls,
+                    MonotonicTimeSource& time_source);
+
+  CacheFilterStats& stats() { return stats_; }
+  uint64_t maxEntryBytes() const { return max_entry_bytes_; }
+  bool coalesceRequests() const { return coalesce_requests_; }
+  MonotonicTimeSource& timeSource() { return time_source_; }
+
+  /**
+   * @return ResponseCache& the cache of the calling worker.
+   */
+  ResponseCache& cache() { return tls_slot_->getTyped<ResponseCache>(); }
+
+  static CacheFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+private:
+  CacheFilterStats stats_;
+  const uint64_t max_bytes_;
+  const uint64_t max_entry_bytes_;
+  const bool coalesce_requests_;
+  MonotonicTimeSource& time_source_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<CacheFilterConfig> CacheFilterConfigSharedPtr;
+
+/**
+ * A filter which serves GET requests from the responses cached by the worker, and caches the
+ * fresh responses of the origin. A request which misses while another request for the same key
+ * is upstream waits for its response rather than going upstream too.
+ */
+class CacheFilter : public StreamFilter {
+public:
+  CacheFilter(CacheFilterConfigSharedPtr config);
+  ~CacheFilter();
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks&) override {}
+
+  /**
+   * Called by the cache once the fill which the filter waits for is complete.
+   * @param response supplies the response which was cached, or nullptr if none was, in which case
+   *        the request goes upstream.
+   */
+  void onFillComplete(const CachedResponseConstSharedPtr& response);
+
+  /**
+   * @return std::chrono::seconds how long a response stays fresh in a shared cache, from the
+   *         s-maxage or max-age directive of its cache-control header, or zero if it must not be
+   *         cached. See https://tools.ietf.org/html/rfc7234#section-4.2.1
+   * @param headers supplies the response headers.
+   */
+  static std::chrono::seconds freshnessLifetime(const HeaderMap& headers);
+
+private:
+  enum class State { PassThrough, Filling, Waiting, Served };
+
+  bool isCacheable(const HeaderMap& headers) const;
+  void finishFill(bool store);
+  void serve(const CachedResponseConstSharedPtr& response);
+
+  CacheFilterConfigSharedPtr config_;
+  StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  State state_{State::PassThrough};
+  std::string key_;
+  const HeaderMap* request_headers_{};
+  // The response being filled.
+  HeaderMapPtr response_headers_;
+  Buffer::OwnedImpl response_body_;
+  std::chrono::seconds freshness_lifetime_{};
+};
+
+} // namespace Http
+} // namespace Envoy
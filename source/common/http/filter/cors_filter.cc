@@ -101,21 +101,17 @@ void CorsFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbac
 };
 
 bool CorsFilter::isOriginAllowed(const Http::HeaderString& origin) {
-  if (allowOrigins() == nullptr) {
+  const Router::CorsPolicy* policy = allowOriginsPolicy();
+  if (policy == nullptr) {
     return false;
   }
-  for (const auto& o : *allowOrigins()) {
-    if (o == "*" || origin == o.c_str()) {
-      return true;
-    }
-  }
-  return false;
+  return policy->allowsOrigin(std::string(origin.c_str(), origin.size()));
 }
 
-const std::list<std::string>* CorsFilter::allowOrigins() {
+const Router::CorsPolicy* CorsFilter::allowOriginsPolicy() {
   for (const auto policy : policies_) {
     if (policy && !policy->allowOrigins().empty()) {
-      return &policy->allowOrigins();
+      return policy;
     }
   }
   return nullptr;
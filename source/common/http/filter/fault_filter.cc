@@ -18,16 +18,23 @@
 #include "common/http/utility.h"
 #include "common/protobuf/utility.h"
 #include "common/router/config_impl.h"
+#include "common/runtime/key_registry.h"
 
 #include "fmt/format.h"
 
 namespace Envoy {
 namespace Http {
 
-const std::string FaultFilter::DELAY_PERCENT_KEY = "fault.http.delay.fixed_delay_percent";
-const std::string FaultFilter::ABORT_PERCENT_KEY = "fault.http.abort.abort_percent";
-const std::string FaultFilter::DELAY_DURATION_KEY = "fault.http.delay.fixed_duration_ms";
-const std::string FaultFilter::ABORT_HTTP_STATUS_KEY = "fault.http.abort.http_status";
+const Runtime::Key& FaultFilter::DELAY_PERCENT_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.delay.fixed_delay_percent");
+const Runtime::Key& FaultFilter::ABORT_PERCENT_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.abort.abort_percent");
+const Runtime::Key& FaultFilter::DELAY_DURATION_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.delay.fixed_duration_ms");
+const Runtime::Key& FaultFilter::ABORT_HTTP_STATUS_KEY =
+    Runtime::KeyRegistry::registerKey("fault.http.abort.http_status");
+
+const uint32_t FaultFilterConfig::MaxDownstreamClusterStats;
 
 FaultFilterConfig::FaultFilterConfig(const envoy::api::v2::filter::http::HTTPFault& fault,
                                      Runtime::Loader& runtime, const std::string& stats_prefix,
@@ -61,6 +68,18 @@ FaultFilterConfig::FaultFilterConfig(const envoy::api::v2::filter::http::HTTPFau
   }
 }
 
+bool FaultFilterConfig::runtimeFaults() {
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  const uint64_t generation = snapshot.generation();
+  uint64_t cached = runtime_faults_;
+  if (cached >> 1 != generation) {
+    cached = generation << 1 | (snapshot.hasKeyWithPrefix("fault.http.") ? 1 : 0);
+    runtime_faults_ = cached;
+  }
+
+  return cached & 1;
+}
+
 FaultFilter::FaultFilter(FaultFilterConfigSharedPtr config) : config_(config) {}
 
 FaultFilter::~FaultFilter() { ASSERT(!delay_timer_); }
@@ -70,6 +89,13 @@ FaultFilter::~FaultFilter() { ASSERT(!delay_timer_); }
 // if we inject a delay, then we will inject the abort in the delay timer
 // callback.
 FilterHeadersStatus FaultFilter::decodeHeaders(HeaderMap& headers, bool) {
+  // Without a fault in either the configuration or runtime, there is nothing to inject, and no
+  // need to match the request.
+  const bool runtime_faults = config_->runtimeFaults();
+  if (!runtime_faults && !config_->faultsConfigured()) {
+    return FilterHeadersStatus::Continue;
+  }
+
   if (!matchesTargetUpstreamCluster()) {
     return FilterHeadersStatus::Continue;
   }
@@ -86,14 +112,17 @@ FilterHeadersStatus FaultFilter::decodeHeaders(HeaderMap& headers, bool) {
   if (headers.EnvoyDownstreamServiceCluster()) {
     downstream_cluster_ = headers.EnvoyDownstreamServiceCluster()->value().c_str();
 
-    downstream_cluster_delay_percent_key_ =
-        fmt::format("fault.http.{}.delay.fixed_delay_percent", downstream_cluster_);
-    downstream_cluster_abort_percent_key_ =
-        fmt::format("fault.http.{}.abort.abort_percent", downstream_cluster_);
-    downstream_cluster_delay_duration_key_ =
-        fmt::format("fault.http.{}.delay.fixed_duration_ms", downstream_cluster_);
-    downstream_cluster_abort_http_status_key_ =
-        fmt::format("fault.http.{}.abort.http_status", downstream_cluster_);
+    // The keys of the downstream cluster can only be set if some fault key is.
+    if (runtime_faults) {
+      downstream_cluster_delay_percent_key_ =
+          fmt::format("fault.http.{}.delay.fixed_delay_percent", downstream_cluster_);
+      downstream_cluster_abort_percent_key_ =
+          fmt::format("fault.http.{}.abort.abort_percent", downstream_cluster_);
+      downstream_cluster_delay_duration_key_ =
+          fmt::format("fault.http.{}.delay.fixed_duration_ms", downstream_cluster_);
+      downstream_cluster_abort_http_status_key_ =
+          fmt::format("fault.http.{}.abort.http_status", downstream_cluster_);
+    }
   }
 
   Optional<uint64_t> duration_ms = delayDuration();
@@ -172,13 +201,30 @@ uint64_t FaultFilter::abortHttpStatus() {
   return http_status;
 }
 
+FaultFilterStats& FaultFilterConfig::downstreamClusterStats(const std::string& downstream_cluster) {
+  std::lock_guard<std::mutex> lock(downstream_cluster_stats_lock_);
+  auto it = downstream_cluster_stats_.find(downstream_cluster);
+  if (it != downstream_cluster_stats_.end()) {
+    return *it->second;
+  }
+
+  std::unique_ptr<FaultFilterStats>* stats = &other_downstream_cluster_stats_;
+  std::string prefix = stats_prefix_ + "fault._other.";
+  if (downstream_cluster_stats_.size() < MaxDownstreamClusterStats) {
+    stats = &downstream_cluster_stats_[downstream_cluster];
+    prefix = fmt::format("{}fault.{}.", stats_prefix_, downstream_cluster);
+  }
+
+  if (!*stats) {
+    stats->reset(new FaultFilterStats{ALL_FAULT_FILTER_STATS(POOL_COUNTER_PREFIX(scope_, prefix))});
+  }
+  return **stats;
+}
+
 void FaultFilter::recordDelaysInjectedStats() {
   // Downstream specific stats.
   if (!downstream_cluster_.empty()) {
-    const std::string stats_counter =
-        fmt::format("{}fault.{}.delays_injected", config_->statsPrefix(), downstream_cluster_);
-
-    config_->scope().counter(stats_counter).inc();
+    config_->downstreamClusterStats(downstream_cluster_).delays_injected_.inc();
   }
 
   // General stats.
@@ -188,10 +234,7 @@ void FaultFilter::recordDelaysInjectedStats() {
 void FaultFilter::recordAbortsInjectedStats() {
   // Downstream specific stats.
   if (!downstream_cluster_.empty()) {
-    const std::string stats_counter =
-        fmt::format("{}fault.{}.aborts_injected", config_->statsPrefix(), downstream_cluster_);
-
-    config_->scope().counter(stats_counter).inc();
+    config_->downstreamClusterStats(downstream_cluster_).aborts_injected_.inc();
   }
 
   // General stats.
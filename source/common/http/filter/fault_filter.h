@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -56,6 +59,27 @@ public:
   const std::string& statsPrefix() { return stats_prefix_; }
   Stats::Scope& scope() { return scope_; }
 
+  /**
+   * @return the stats of a downstream cluster. The first MaxDownstreamClusterStats clusters seen
+   *         get their own stats, after which further clusters share the stats of "_other", so
+   *         that the number of stats stays bounded whatever clients send.
+   */
+  FaultFilterStats& downstreamClusterStats(const std::string& downstream_cluster);
+
+  static const uint32_t MaxDownstreamClusterStats = 100;
+
+  /**
+   * @return bool whether the configuration injects any fault without help from runtime.
+   */
+  bool faultsConfigured() const { return abort_percent_ > 0 || fixed_delay_percent_ > 0; }
+
+  /**
+   * @return bool whether runtime may inject a fault, that is whether any fault.http key is set.
+   *         The answer is cached for each runtime snapshot, so that requests do not look up the
+   *         fault keys while no fault is active.
+   */
+  bool runtimeFaults();
+
 private:
   static FaultFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
 
@@ -71,6 +95,13 @@ private:
   FaultFilterStats stats_;
   const std::string stats_prefix_;
   Stats::Scope& scope_;
+  // The workers share the stats of the downstream clusters.
+  std::mutex downstream_cluster_stats_lock_;
+  std::unordered_map<std::string, std::unique_ptr<FaultFilterStats>> downstream_cluster_stats_;
+  std::unique_ptr<FaultFilterStats> other_downstream_cluster_stats_;
+  // The snapshot generation shifted left by one, with runtimeFaults() for that generation in the
+  // low bit. The workers share the cache, so both are kept in one atomic.
+  std::atomic<uint64_t> runtime_faults_{UINT64_MAX};
 };
 
 typedef std::shared_ptr<FaultFilterConfig> FaultFilterConfigSharedPtr;
@@ -117,10 +148,10 @@ private:
   std::string downstream_cluster_delay_duration_key_{};
   std::string downstream_cluster_abort_http_status_key_{};
 
-  const static std::string DELAY_PERCENT_KEY;
-  const static std::string ABORT_PERCENT_KEY;
-  const static std::string DELAY_DURATION_KEY;
-  const static std::string ABORT_HTTP_STATUS_KEY;
+  const static Runtime::Key& DELAY_PERCENT_KEY;
+  const static Runtime::Key& ABORT_PERCENT_KEY;
+  const static Runtime::Key& DELAY_DURATION_KEY;
+  const static Runtime::Key& ABORT_HTTP_STATUS_KEY;
 };
 
 } // Http
@@ -0,0 +1,361 @@
+#include "common/http/filter/gzip_filter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+#include "common/common/empty_string.h"
+#include "common/common/macros.h"
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/json/config_schemas.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+// Trim the whitespace around a header value token.
+std::string trim(const std::string& source) {
+  const size_t start = source.find_first_not_of(" \t");
+  if (start == std::string::npos) {
+    return EMPTY_STRING;
+  }
+  return source.substr(start, source.find_last_not_of(" \t") - start + 1);
+}
+
+std::string toLower(std::string source) {
+  std::transform(source.begin(), source.end(), source.begin(), ::tolower);
+  return source;
+}
+
+// The media type of a content-type value, without its parameters.
+std::string mediaType(const std::string& content_type) {
+  return toLower(trim(content_type.substr(0, content_type.find(';'))));
+}
+
+// The default content types, which are the text formats which compress well.
+const std::vector<std::string>& defaultContentTypes() {
+  CONSTRUCT_ON_FIRST_USE(std::vector<std::string>,
+                         {"text/html", "text/plain", "text/css", "application/javascript",
+                          "application/json", "application/xml", "image/svg+xml"});
+}
+
+// The coding of a content-encoding value, or identity if the filter does not support it.
+ContentCoding contentCoding(const std::string& coding) {
+  if (coding == Headers::get().ContentEncodingValues.Gzip) {
+    return ContentCoding::Gzip;
+  } else if (coding == Headers::get().ContentEncodingValues.Deflate) {
+    return ContentCoding::Deflate;
+  } else if (coding == Headers::get().ContentEncodingValues.Brotli) {
+    return ContentCoding::Brotli;
+  } else if (coding == Headers::get().ContentEncodingValues.Zstd) {
+    return ContentCoding::Zstd;
+  }
+  return ContentCoding::Identity;
+}
+
+const std::string& contentEncodingValue(ContentCoding coding) {
+  switch (coding) {
+  case ContentCoding::Gzip:
+    return Headers::get().ContentEncodingValues.Gzip;
+  case ContentCoding::Deflate:
+    return Headers::get().ContentEncodingValues.Deflate;
+  case ContentCoding::Brotli:
+    return Headers::get().ContentEncodingValues.Brotli;
+  case ContentCoding::Zstd:
+    return Headers::get().ContentEncodingValues.Zstd;
+  default:
+    NOT_REACHED;
+  }
+}
+
+// gzip and zlib (deflate) wrap the same raw deflate data. zlib selects gzip when 16 is added to
+// the window bits.
+const int8_t GZIP_WINDOW_BITS_OFFSET = 16;
+
+} // namespace
+
+const uint64_t GzipFilterConfig::MAX_POOLED_COMPRESSORS;
+
+GzipFilterConfig::GzipFilterConfig(const Json::Object& json_config,
+                                   const std::string& stats_prefix, Stats::Scope& scope,
+                                   ThreadLocal::SlotAllocator& tls)
+    : Json::Validator(json_config, Json::Schema::GZIP_HTTP_FILTER_SCHEMA),
+      stats_(generateStats(stats_prefix, scope)),
+      compression_level_(compressionLevel(json_config.getString("compression_level", "default"))),
+      compression_strategy_(
+          compressionStrategy(json_config.getString("compression_strategy", "default"))),
+      minimum_length_(json_config.getInteger("content_length", 30)),
+      window_bits_(json_config.getInteger("window_bits", 15)),
+      memory_level_(json_config.getInteger("memory_level", 8)),
+      chunk_size_(json_config.getInteger("chunk_size", 4096)),
+      brotli_quality_(json_config.getInteger("brotli_quality", 4)),
+      brotli_window_bits_(json_config.getInteger("brotli_window_bits", 20)),
+      zstd_level_(json_config.getInteger("zstd_level", 3)), tls_slot_(tls.allocateSlot()) {
+  for (const std::string& coding : json_config.getStringArray("content_encoding", true)) {
+    content_codings_.push_back(contentCoding(coding));
+    ASSERT(content_codings_.back() != ContentCoding::Identity);
+  }
+  if (content_codings_.empty()) {
+    content_codings_ = {ContentCoding::Gzip, ContentCoding::Deflate};
+  }
+
+  std::vector<std::string> content_types = json_config.getStringArray("content_type", true);
+  if (content_types.empty()) {
+    content_types = defaultContentTypes();
+  }
+  for (const std::string& content_type : content_types) {
+    content_types_.push_back(mediaType(content_type));
+  }
+
+  tls_slot_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CompressorPool>();
+  });
+}
+
+GzipFilterStats GzipFilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  const std::string final_prefix = prefix + "gzip.";
+  return {ALL_GZIP_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+Compressor::ZlibCompressorImpl::CompressionLevel
+GzipFilterConfig::compressionLevel(const std::string& level) {
+  if (level == "best") {
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Best;
+  } else if (level == "speed") {
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Speed;
+  } else {
+    ASSERT(level == "default");
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Standard;
+  }
+}
+
+Compressor::ZlibCompressorImpl::CompressionStrategy
+GzipFilterConfig::compressionStrategy(const std::string& strategy) {
+  if (strategy == "filtered") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Filtered;
+  } else if (strategy == "huffman") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Huffman;
+  } else if (strategy == "rle") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Rle;
+  } else {
+    ASSERT(strategy == "default");
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Standard;
+  }
+}
+
+bool GzipFilterConfig::isCompressibleContentType(const std::string& content_type) const {
+  return std::find(content_types_.begin(), content_types_.end(), mediaType(content_type)) !=
+         content_types_.end();
+}
+
+Compressor::CompressorPtr GzipFilterConfig::acquireCompressor(ContentCoding coding) {
+  ASSERT(coding != ContentCoding::Identity);
+  std::vector<Compressor::CompressorPtr>& compressors =
+      tls_slot_->getTyped<CompressorPool>().compressors_[static_cast<size_t>(coding)];
+  if (!compressors.empty()) {
+    Compressor::CompressorPtr compressor = std::move(compressors.back());
+    compressors.pop_back();
+    return compressor;
+  }
+
+  return createCompressor(coding);
+}
+
+Compressor::CompressorPtr GzipFilterConfig::createCompressor(ContentCoding coding) const {
+  switch (coding) {
+  case ContentCoding::Gzip:
+  case ContentCoding::Deflate: {
+    std::unique_ptr<Compressor::ZlibCompressorImpl> compressor(
+        new Compressor::ZlibCompressorImpl());
+    compressor->init(compression_level_, compression_strategy_,
+                     coding == ContentCoding::Gzip ? window_bits_ + GZIP_WINDOW_BITS_OFFSET
+                                                   : window_bits_,
+                     memory_level_);
+    compressor->setChunk(chunk_size_);
+    return std::move(compressor);
+  }
+  case ContentCoding::Brotli: {
+    std::unique_ptr<Compressor::BrotliCompressorImpl> compressor(
+        new Compressor::BrotliCompressorImpl());
+    compressor->init(brotli_quality_, brotli_window_bits_);
+    compressor->setChunk(chunk_size_);
+    return std::move(compressor);
+  }
+  case ContentCoding::Zstd: {
+    std::unique_ptr<Compressor::ZstdCompressorImpl> compressor(
+        new Compressor::ZstdCompressorImpl());
+    compressor->init(zstd_level_);
+    compressor->setChunk(chunk_size_);
+    return std::move(compressor);
+  }
+  default:
+    NOT_REACHED;
+  }
+}
+
+void GzipFilterConfig::releaseCompressor(ContentCoding coding,
+                                         Compressor::CompressorPtr&& compressor) {
+  std::vector<Compressor::CompressorPtr>& compressors =
+      tls_slot_->getTyped<CompressorPool>().compressors_[static_cast<size_t>(coding)];
+  if (compressors.size() >= MAX_POOLED_COMPRESSORS) {
+    compressor.reset();
+    return;
+  }
+
+  // Resetting keeps the allocated state of the compressor, which is what initializing it is
+  // costly for.
+  compressor->reset();
+  compressors.push_back(std::move(compressor));
+}
+
+GzipFilter::GzipFilter(GzipFilterConfigSharedPtr config) : config_(config) {}
+
+GzipFilter::~GzipFilter() { ASSERT(!compressor_); }
+
+void GzipFilter::onDestroy() { releaseCompressor(); }
+
+ContentCoding GzipFilter::acceptedCoding(const std::string& accept_encoding,
+                                         const std::vector<ContentCoding>& codings) {
+  // The quality of each coding, or a negative value when the coding is not listed.
+  double qualities[static_cast<size_t>(ContentCoding::Identity)] = {-1, -1, -1, -1};
+  double any = -1;
+  for (const std::string& element : StringUtil::split(accept_encoding, ',')) {
+    const size_t params = element.find(';');
+    const std::string coding = toLower(trim(element.substr(0, params)));
+
+    double quality = 1;
+    if (params != std::string::npos) {
+      const std::string param = trim(element.substr(params + 1));
+      if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+        quality = std::strtod(param.c_str() + 2, nullptr);
+      }
+    }
+
+    if (coding == "*") {
+      any = quality;
+    } else if (contentCoding(coding) != ContentCoding::Identity) {
+      qualities[static_cast<size_t>(contentCoding(coding))] = quality;
+    }
+  }
+
+  ContentCoding accepted = ContentCoding::Identity;
+  double accepted_quality = 0;
+  for (ContentCoding coding : codings) {
+    double quality = qualities[static_cast<size_t>(coding)];
+    if (quality < 0) {
+      quality = any;
+    }
+    if (quality > accepted_quality) {
+      accepted = coding;
+      accepted_quality = quality;
+    }
+  }
+  return accepted;
+}
+
+FilterHeadersStatus GzipFilter::decodeHeaders(HeaderMap& headers, bool) {
+  const HeaderEntry* accept_encoding = headers.get(Headers::get().AcceptEncoding);
+  if (accept_encoding == nullptr) {
+    config_->stats().no_accept_header_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  coding_ = acceptedCoding(accept_encoding->value().c_str(), config_->contentCodings());
+  return FilterHeadersStatus::Continue;
+}
+
+bool GzipFilter::isCompressible(const HeaderMap& headers) const {
+  // Responses which are already encoded, or which must not be transformed, are left alone.
+  if (headers.get(Headers::get().ContentEncoding) != nullptr) {
+    return false;
+  }
+
+  const HeaderEntry* cache_control = headers.get(Headers::get().CacheControl);
+  if (cache_control != nullptr && std::string(cache_control->value().c_str())
+                                           .find(Headers::get().CacheControlValues.NoTransform) !=
+                                       std::string::npos) {
+    return false;
+  }
+
+  if (headers.ContentType() == nullptr ||
+      !config_->isCompressibleContentType(headers.ContentType()->value().c_str())) {
+    return false;
+  }
+
+  uint64_t content_length;
+  if (headers.ContentLength() != nullptr &&
+      StringUtil::atoul(headers.ContentLength()->value().c_str(), content_length) &&
+      content_length < config_->minimumLength()) {
+    return false;
+  }
+
+  return true;
+}
+
+FilterHeadersStatus GzipFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (coding_ == ContentCoding::Identity) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  if (end_stream || !isCompressible(headers)) {
+    config_->stats().not_compressed_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().compressed_.inc();
+  headers.removeContentLength();
+  headers.addReference(Headers::get().ContentEncoding, contentEncodingValue(coding_));
+  headers.addReference(Headers::get().Vary, Headers::get().VaryValues.AcceptEncoding);
+  compressor_ = config_->acquireCompressor(coding_);
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus GzipFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!compressor_) {
+    return FilterDataStatus::Continue;
+  }
+
+  // The chunk is compressed straight from the slices of the body, and the compressed slices are
+  // moved back into it.
+  config_->stats().total_uncompressed_bytes_.add(data.length());
+  Buffer::OwnedImpl compressed;
+  compressor_->compress(data, compressed);
+  data.drain(data.length());
+  if (end_stream) {
+    compressor_->end(compressed);
+    releaseCompressor();
+  }
+
+  config_->stats().total_compressed_bytes_.add(compressed.length());
+  data.move(compressed);
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus GzipFilter::encodeTrailers(HeaderMap&) {
+  if (!compressor_) {
+    return FilterTrailersStatus::Continue;
+  }
+
+  Buffer::OwnedImpl compressed;
+  compressor_->end(compressed);
+  releaseCompressor();
+
+  config_->stats().total_compressed_bytes_.add(compressed.length());
+  encoder_callbacks_->addEncodedData(compressed, true);
+  return FilterTrailersStatus::Continue;
+}
+
+void GzipFilter::releaseCompressor() {
+  if (compressor_) {
+    config_->releaseCompressor(coding_, std::move(compressor_));
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
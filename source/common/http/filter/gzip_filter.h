@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/http/filter.h"
+#include "envoy/json/json_object.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "envoy/compressor/compressor.h"
+
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/json/json_validator.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the gzip filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_GZIP_FILTER_STATS(COUNTER)                                                             \
+  COUNTER(compressed)                                                                              \
+  COUNTER(not_compressed)                                                                          \
+  COUNTER(no_accept_header)                                                                        \
+  COUNTER(total_uncompressed_bytes)                                                                \
+  COUNTER(total_compressed_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for gzip filter stats. @see stats_macros.h
+ */
+struct GzipFilterStats {
+  ALL_GZIP_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * The content codings which the filter compresses responses with. Identity is last, so that the
+ * other codings index arrays.
+ */
+enum class ContentCoding { Gzip, Deflate, Brotli, Zstd, Identity };
+
+/**
+ * Configuration for the gzip filter. It also pools the compressors of each worker, so that a
+ * response does not pay for allocating and initializing the state of its compressor.
+ */
+class GzipFilterConfig : Json::Validator {
+public:
+  GzipFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                   Stats::Scope& scope, ThreadLocal::SlotAllocator& tls);
+
+  const GzipFilterStats& stats() const { return stats_; }
+  uint64_t minimumLength() const { return minimum_length_; }
+
+  /**
+   * @return the codings which responses are compressed with, in the order of preference.
+   */
+  const std::vector<ContentCoding>& contentCodings() const { return content_codings_; }
+
+  /**
+   * @return whether responses of a content type are compressed.
+   * @param content_type supplies the value of the content-type header, parameters included.
+   */
+  bool isCompressibleContentType(const std::string& content_type) const;
+
+  /**
+   * @return CompressorPtr a compressor ready to compress a new stream with the coding, taken from
+   *         the pool of the worker if there is one.
+   */
+  Compressor::CompressorPtr acquireCompressor(ContentCoding coding);
+
+  /**
+   * Return a compressor which is no longer used to the pool of the worker.
+   */
+  void releaseCompressor(ContentCoding coding, Compressor::CompressorPtr&& compressor);
+
+  /**
+   * The maximum number of idle compressors which each worker keeps for each coding.
+   */
+  static const uint64_t MAX_POOLED_COMPRESSORS = 32;
+
+  static GzipFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+private:
+  struct CompressorPool : public ThreadLocal::ThreadLocalObject {
+    // Indexed by ContentCoding.
+    std::vector<Compressor::CompressorPtr>
+        compressors_[static_cast<size_t>(ContentCoding::Identity)];
+  };
+
+  Compressor::CompressorPtr createCompressor(ContentCoding coding) const;
+
+  static Compressor::ZlibCompressorImpl::CompressionLevel
+  compressionLevel(const std::string& level);
+  static Compressor::ZlibCompressorImpl::CompressionStrategy
+  compressionStrategy(const std::string& strategy);
+
+  GzipFilterStats stats_;
+  const Compressor::ZlibCompressorImpl::CompressionLevel compression_level_;
+  const Compressor::ZlibCompressorImpl::CompressionStrategy compression_strategy_;
+  const uint64_t minimum_length_;
+  const int8_t window_bits_;
+  const uint8_t memory_level_;
+  const uint64_t chunk_size_;
+  const uint32_t brotli_quality_;
+  const uint32_t brotli_window_bits_;
+  const int32_t zstd_level_;
+  std::vector<ContentCoding> content_codings_;
+  std::vector<std::string> content_types_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<GzipFilterConfig> GzipFilterConfigSharedPtr;
+
+/**
+ * A filter which compresses the bodies of the responses with gzip, deflate, brotli or zstd,
+ * according to the accept-encoding header of the request. The body is compressed as it is
+ * streamed, chunk by chunk, and is never buffered.
+ */
+class GzipFilter : public StreamFilter {
+public:
+  GzipFilter(GzipFilterConfigSharedPtr config);
+  ~GzipFilter();
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks&) override {}
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+  /**
+   * @return ContentCoding the coding which an accept-encoding header gives the highest quality to
+   *         among the supported codings, the first of them on a tie, or identity if none is
+   *         acceptable. See https://tools.ietf.org/html/rfc7231#section-5.3.4
+   * @param accept_encoding supplies the value of the accept-encoding header.
+   * @param codings supplies the supported codings, in the order of preference.
+   */
+  static ContentCoding acceptedCoding(const std::string& accept_encoding,
+                                      const std::vector<ContentCoding>& codings);
+
+private:
+  bool isCompressible(const HeaderMap& headers) const;
+  void releaseCompressor();
+
+  GzipFilterConfigSharedPtr config_;
+  StreamEncoderFilterCallbacks* encoder_callbacks_{};
+  ContentCoding coding_{ContentCoding::Identity};
+  Compressor::CompressorPtr compressor_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -1,15 +1,79 @@
 #include "common/http/filter/ip_tagging_filter.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/network/cidr_range.h"
+#include "common/network/utility.h"
+
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Http {
 
+IpTaggingFilterConfig::IpTaggingFilterConfig(const Json::Object& json_config)
+    : Json::Validator(json_config, Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA),
+      request_type_(stringToType(json_config.getString("request_type", "both"))) {
+  std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> tagged_ranges;
+  for (const Json::ObjectSharedPtr& ip_tag : json_config.getObjectArray("ip_tags", true)) {
+    tagged_ranges.emplace_back(ip_tag->getString("ip_tag_name"),
+                               std::vector<Network::Address::CidrRange>());
+    for (const std::string& entry : ip_tag->getStringArray("ip_list")) {
+      // A bare address is a range of that address only: the length is capped to the length of
+      // the address.
+      Network::Address::CidrRange range = entry.find('/') == std::string::npos
+                                              ? Network::Address::CidrRange::create(entry, 128)
+                                              : Network::Address::CidrRange::create(entry);
+      if (!range.isValid()) {
+        throw EnvoyException(
+            fmt::format("invalid ip/mask combo '{}' (format is <ip>/<# mask bits>)", entry));
+      }
+      tagged_ranges.back().second.push_back(range);
+    }
+  }
+
+  trie_ = Network::Address::LpmTrie(tagged_ranges);
+}
+
 IpTaggingFilter::IpTaggingFilter(IpTaggingFilterConfigSharedPtr config) : config_(config) {}
 
 IpTaggingFilter::~IpTaggingFilter() {}
 
 void IpTaggingFilter::onDestroy() {}
 
-FilterHeadersStatus IpTaggingFilter::decodeHeaders(HeaderMap&, bool) {
+FilterHeadersStatus IpTaggingFilter::decodeHeaders(HeaderMap& headers, bool) {
+  const bool is_internal_request =
+      headers.EnvoyInternalRequest() && (headers.EnvoyInternalRequest()->value() == "true");
+  if ((is_internal_request && config_->requestType() == FilterRequestType::External) ||
+      (!is_internal_request && config_->requestType() == FilterRequestType::Internal)) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  // Only the tags of this filter are trusted.
+  headers.remove(Headers::get().EnvoyIpTags);
+
+  const std::string& downstream_address = callbacks_->downstreamAddress();
+  if (downstream_address.empty()) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  Network::Address::InstanceConstSharedPtr address;
+  try {
+    address = Network::Utility::parseInternetAddress(downstream_address);
+  } catch (const EnvoyException&) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const std::vector<std::string>& tags = config_->trie().getTags(*address);
+  if (!tags.empty()) {
+    headers.addCopy(Headers::get().EnvoyIpTags, StringUtil::join(tags, ","));
+  }
+
   return FilterHeadersStatus::Continue;
 }
 
@@ -11,6 +11,7 @@
 #include "common/common/assert.h"
 #include "common/json/config_schemas.h"
 #include "common/json/json_validator.h"
+#include "common/network/lpm_trie.h"
 
 namespace Envoy {
 namespace Http {
@@ -25,11 +26,10 @@ enum class FilterRequestType { Internal, External, Both };
  */
 class IpTaggingFilterConfig : Json::Validator {
 public:
-  IpTaggingFilterConfig(const Json::Object& json_config)
-      : Json::Validator(json_config, Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA),
-        request_type_(stringToType(json_config.getString("request_type", "both"))) {}
+  IpTaggingFilterConfig(const Json::Object& json_config);
 
   FilterRequestType requestType() const { return request_type_; }
+  const Network::Address::LpmTrie& trie() const { return trie_; }
 
 private:
   static FilterRequestType stringToType(const std::string& request_type) {
@@ -44,13 +44,15 @@ private:
   }
 
   const FilterRequestType request_type_;
+  Network::Address::LpmTrie trie_;
 };
 
 typedef std::shared_ptr<IpTaggingFilterConfig> IpTaggingFilterConfigSharedPtr;
 
 /**
  * A filter that tags requests via the x-envoy-ip-tags header based on the request's trusted XFF
- * address.
+ * address. The tags of the address are found with a trie of all the ranges, so that the cost of a
+ * request does not grow with the number of ranges.
  */
 class IpTaggingFilter : public StreamDecoderFilter {
 public:
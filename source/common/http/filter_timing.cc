@@ -0,0 +1,157 @@
+#include "common/http/filter_timing.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+/**
+ * Records the time elapsed between its construction and its destruction.
+ */
+class ScopedFilterTimer {
+public:
+  ScopedFilterTimer(Stats::Histogram& histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedFilterTimer() {
+    histogram_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count());
+  }
+
+private:
+  Stats::Histogram& histogram_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+class TimedStreamDecoderFilter : public StreamDecoderFilter {
+public:
+  TimedStreamDecoderFilter(StreamDecoderFilterSharedPtr filter, FilterTimingStats& stats)
+      : filter_(filter), stats_(stats) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override { filter_->onDestroy(); }
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.decode_headers_us_);
+    return filter_->decodeHeaders(headers, end_stream);
+  }
+  FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.decode_data_us_);
+    return filter_->decodeData(data, end_stream);
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap& trailers) override {
+    ScopedFilterTimer timer(stats_.decode_trailers_us_);
+    return filter_->decodeTrailers(trailers);
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    filter_->setDecoderFilterCallbacks(callbacks);
+  }
+
+private:
+  const StreamDecoderFilterSharedPtr filter_;
+  FilterTimingStats& stats_;
+};
+
+class TimedStreamEncoderFilter : public StreamEncoderFilter {
+public:
+  TimedStreamEncoderFilter(StreamEncoderFilterSharedPtr filter, FilterTimingStats& stats)
+      : filter_(filter), stats_(stats) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override { filter_->onDestroy(); }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.encode_headers_us_);
+    return filter_->encodeHeaders(headers, end_stream);
+  }
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.encode_data_us_);
+    return filter_->encodeData(data, end_stream);
+  }
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override {
+    ScopedFilterTimer timer(stats_.encode_trailers_us_);
+    return filter_->encodeTrailers(trailers);
+  }
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override {
+    filter_->setEncoderFilterCallbacks(callbacks);
+  }
+
+private:
+  const StreamEncoderFilterSharedPtr filter_;
+  FilterTimingStats& stats_;
+};
+
+class TimedStreamFilter : public StreamFilter {
+public:
+  TimedStreamFilter(StreamFilterSharedPtr filter, FilterTimingStats& stats)
+      : filter_(filter), stats_(stats) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override { filter_->onDestroy(); }
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.decode_headers_us_);
+    return filter_->decodeHeaders(headers, end_stream);
+  }
+  FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.decode_data_us_);
+    return filter_->decodeData(data, end_stream);
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap& trailers) override {
+    ScopedFilterTimer timer(stats_.decode_trailers_us_);
+    return filter_->decodeTrailers(trailers);
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    filter_->setDecoderFilterCallbacks(callbacks);
+  }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.encode_headers_us_);
+    return filter_->encodeHeaders(headers, end_stream);
+  }
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override {
+    ScopedFilterTimer timer(stats_.encode_data_us_);
+    return filter_->encodeData(data, end_stream);
+  }
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override {
+    ScopedFilterTimer timer(stats_.encode_trailers_us_);
+    return filter_->encodeTrailers(trailers);
+  }
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override {
+    filter_->setEncoderFilterCallbacks(callbacks);
+  }
+
+private:
+  const StreamFilterSharedPtr filter_;
+  FilterTimingStats& stats_;
+};
+
+} // namespace
+
+FilterTimingStats FilterTimingCallbacks::generateStats(const std::string& prefix,
+                                                       Stats::Scope& scope) {
+  return {ALL_HTTP_FILTER_TIMING_STATS(POOL_HISTOGRAM_PREFIX(scope, prefix))};
+}
+
+void FilterTimingCallbacks::addStreamDecoderFilter(StreamDecoderFilterSharedPtr filter) {
+  parent_.addStreamDecoderFilter(std::make_shared<TimedStreamDecoderFilter>(filter, stats_));
+}
+
+void FilterTimingCallbacks::addStreamEncoderFilter(StreamEncoderFilterSharedPtr filter) {
+  parent_.addStreamEncoderFilter(std::make_shared<TimedStreamEncoderFilter>(filter, stats_));
+}
+
+void FilterTimingCallbacks::addStreamFilter(StreamFilterSharedPtr filter) {
+  parent_.addStreamFilter(std::make_shared<TimedStreamFilter>(filter, stats_));
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/http/filter.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the timing of a filter. The values are in microseconds. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_HTTP_FILTER_TIMING_STATS(HISTOGRAM)                                                    \
+  HISTOGRAM(decode_headers_us)                                                                     \
+  HISTOGRAM(decode_data_us)                                                                        \
+  HISTOGRAM(decode_trailers_us)                                                                    \
+  HISTOGRAM(encode_headers_us)                                                                     \
+  HISTOGRAM(encode_data_us)                                                                        \
+  HISTOGRAM(encode_trailers_us)
+// clang-format on
+
+/**
+ * Struct definition for all filter timing stats. @see stats_macros.h
+ */
+struct FilterTimingStats {
+  ALL_HTTP_FILTER_TIMING_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * FilterChainFactoryCallbacks which wrap the filters added to the chain of a stream, so that the
+ * time spent in each of their callbacks is recorded. The time includes whatever a filter does
+ * inline, such as continuing the iteration or sending a local reply. The wrappers cost a few
+ * allocations and clock reads per stream, so only a sample of the streams is timed.
+ */
+class FilterTimingCallbacks : public FilterChainFactoryCallbacks {
+public:
+  FilterTimingCallbacks(FilterChainFactoryCallbacks& parent, FilterTimingStats& stats)
+      : parent_(parent), stats_(stats) {}
+
+  static FilterTimingStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  // Http::FilterChainFactoryCallbacks
+  void addStreamDecoderFilter(StreamDecoderFilterSharedPtr filter) override;
+  void addStreamEncoderFilter(StreamEncoderFilterSharedPtr filter) override;
+  void addStreamFilter(StreamFilterSharedPtr filter) override;
+  void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) override {
+    parent_.addAccessLogHandler(handler);
+  }
+
+private:
+  FilterChainFactoryCallbacks& parent_;
+  FilterTimingStats& stats_;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -1,13 +1,14 @@
 #include "common/http/header_map_impl.h"
 
 #include <cstdint>
-#include <list>
+#include <limits>
 #include <string>
 
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/singleton.h"
 #include "common/common/utility.h"
+#include "common/http/header_value_interner.h"
 
 namespace Envoy {
 namespace Http {
@@ -51,10 +52,22 @@ HeaderString::HeaderString(HeaderString&& move_value) {
     move_value.inline_buffer_[0] = 0;
     break;
   }
+  case Type::Shared: {
+    // The reference is transferred, and the moved header switches back to its default state.
+    buffer_.ref_ = move_value.buffer_.ref_;
+    shared_ = move_value.shared_;
+    move_value.type_ = Type::Inline;
+    move_value.buffer_.dynamic_ = move_value.inline_buffer_;
+    move_value.clear();
+    break;
+  }
   }
 }
 
-HeaderString::~HeaderString() { freeDynamic(); }
+HeaderString::~HeaderString() {
+  freeDynamic();
+  releaseShared();
+}
 
 void HeaderString::freeDynamic() {
   if (type_ == Type::Dynamic) {
@@ -62,7 +75,27 @@ void HeaderString::freeDynamic() {
   }
 }
 
+void HeaderString::releaseShared() {
+  if (type_ == Type::Shared) {
+    SharedHeaderValue* shared = shared_;
+    type_ = Type::Inline;
+    buffer_.dynamic_ = inline_buffer_;
+    inline_buffer_[0] = 0;
+    string_length_ = 0;
+    shared->release();
+  }
+}
+
 void HeaderString::append(const char* data, uint32_t size) {
+  if (type_ == Type::Shared) {
+    // Shared values are immutable, so copy the existing value into our own storage first.
+    SharedHeaderValue* shared = shared_;
+    shared->acquire();
+    releaseShared();
+    append(shared->data(), shared->size());
+    shared->release();
+  }
+
   switch (type_) {
   case Type::Reference: {
     // Switch back to inline and fall through. We do not actually append to the static string
@@ -114,6 +147,10 @@ void HeaderString::clear() {
   case Type::Reference: {
     break;
   }
+  case Type::Shared: {
+    releaseShared();
+    break;
+  }
   case Type::Inline: {
     inline_buffer_[0] = 0;
     FALLTHRU;
@@ -125,6 +162,7 @@ void HeaderString::clear() {
 }
 
 void HeaderString::setCopy(const char* data, uint32_t size) {
+  releaseShared();
   switch (type_) {
   case Type::Reference: {
     // Switch back to inline and fall through.
@@ -166,6 +204,7 @@ void HeaderString::setCopy(const char* data, uint32_t size) {
 }
 
 void HeaderString::setInteger(uint64_t value) {
+  releaseShared();
   switch (type_) {
   case Type::Reference: {
     // Switch back to inline and fall through.
@@ -185,11 +224,23 @@ void HeaderString::setInteger(uint64_t value) {
 
 void HeaderString::setReference(const std::string& ref_value) {
   freeDynamic();
+  releaseShared();
   type_ = Type::Reference;
   buffer_.ref_ = ref_value.c_str();
   string_length_ = ref_value.size();
 }
 
+void HeaderString::setShared(SharedHeaderValue& value) {
+  // Take the new reference first in case the string already refers to the same value.
+  value.acquire();
+  freeDynamic();
+  releaseShared();
+  type_ = Type::Shared;
+  shared_ = &value;
+  buffer_.ref_ = value.data();
+  string_length_ = value.size();
+}
+
 HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key) : key_(key) {}
 
 HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key, HeaderString&& value)
@@ -212,51 +263,282 @@ void HeaderMapImpl::HeaderEntryImpl::value(const HeaderEntry& header) {
   value(header.value().c_str(), header.value().size());
 }
 
+const uint32_t HeaderMapImpl::HeaderList::InlineCapacity;
+const uint32_t HeaderMapImpl::HeaderList::BlockCapacity;
+const uint32_t HeaderMapImpl::HeaderList::InvalidIndex;
+
+HeaderMapImpl::HeaderList& HeaderMapImpl::HeaderList::operator=(HeaderList&& rhs) {
+  clear();
+  blocks_ = std::move(rhs.blocks_);
+  used_slots_ = rhs.used_slots_;
+  free_head_ = rhs.free_head_;
+  head_ = rhs.head_;
+  tail_ = rhs.tail_;
+  size_ = rhs.size_;
+
+  // Entries and free slots in the inline slots must be physically moved. Blocks were handed over
+  // above, so nothing else moves.
+  for (uint32_t index = free_head_; index != InvalidIndex; index = nextFree(index)) {
+    if (index < InlineCapacity) {
+      nextFree(index) = rhs.nextFree(index);
+    }
+  }
+  for (uint32_t index = head_; index != InvalidIndex;) {
+    if (index >= InlineCapacity) {
+      index = at(index)->next_;
+      continue;
+    }
+
+    HeaderEntryImpl* entry = rhs.at(index);
+    HeaderEntryImpl* moved =
+        new (slot(index)) HeaderEntryImpl(std::move(entry->key_), std::move(entry->value_));
+    moved->index_ = index;
+    moved->prev_ = entry->prev_;
+    moved->next_ = entry->next_;
+    moved->next_same_key_ = entry->next_same_key_;
+    moved->inline_ = entry->inline_;
+    entry->~HeaderEntryImpl();
+    index = moved->next_;
+  }
+
+  rhs.used_slots_ = 0;
+  rhs.free_head_ = rhs.head_ = rhs.tail_ = InvalidIndex;
+  rhs.size_ = 0;
+  return *this;
+}
+
+void HeaderMapImpl::HeaderList::clear() {
+  for (HeaderEntryImpl* entry = front(); entry != nullptr;) {
+    HeaderEntryImpl* next = at(entry->next_);
+    entry->~HeaderEntryImpl();
+    entry = next;
+  }
+
+  blocks_.clear();
+  used_slots_ = 0;
+  free_head_ = head_ = tail_ = InvalidIndex;
+  size_ = 0;
+}
+
+void HeaderMapImpl::HeaderList::erase(HeaderEntryImpl& entry) {
+  const uint32_t index = entry.index_;
+  if (entry.prev_ == InvalidIndex) {
+    head_ = entry.next_;
+  } else {
+    at(entry.prev_)->next_ = entry.next_;
+  }
+  if (entry.next_ == InvalidIndex) {
+    tail_ = entry.prev_;
+  } else {
+    at(entry.next_)->prev_ = entry.prev_;
+  }
+
+  entry.~HeaderEntryImpl();
+  nextFree(index) = free_head_;
+  free_head_ = index;
+  size_--;
+}
+
+uint32_t HeaderMapImpl::HeaderList::allocateSlot() {
+  if (free_head_ != InvalidIndex) {
+    const uint32_t index = free_head_;
+    free_head_ = nextFree(index);
+    return index;
+  }
+
+  if (used_slots_ >= InlineCapacity + blocks_.size() * BlockCapacity) {
+    blocks_.emplace_back(new Slot[BlockCapacity]);
+  }
+  return used_slots_++;
+}
+
+void* HeaderMapImpl::HeaderList::slot(uint32_t index) const {
+  if (index < InlineCapacity) {
+    return const_cast<Slot*>(&inline_slots_[index]);
+  }
+
+  index -= InlineCapacity;
+  return &blocks_[index / BlockCapacity][index % BlockCapacity];
+}
+
+const uint32_t HeaderMapImpl::CustomHeaderIndex::BuildThreshold;
+const uint32_t HeaderMapImpl::CustomHeaderIndex::Empty;
+const uint32_t HeaderMapImpl::CustomHeaderIndex::Tombstone;
+
+uint32_t HeaderMapImpl::CustomHeaderIndex::hash(const char* key, uint32_t size) {
+  // FNV-1a. Header keys are short so this is cheaper than a stronger hash.
+  uint32_t hash = 2166136261U;
+  for (uint32_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(key[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+void HeaderMapImpl::CustomHeaderIndex::build(const HeaderList& headers, uint32_t num_headers) {
+  // Start with a load factor of at most one quarter so that a few more headers can be added before
+  // the table needs to grow.
+  uint32_t size = BuildThreshold * 4;
+  while (size < num_headers * 4) {
+    size *= 2;
+  }
+  rehash(headers, size);
+}
+
+void HeaderMapImpl::CustomHeaderIndex::rehash(const HeaderList& headers, uint32_t new_size) {
+  table_.assign(new_size, Empty);
+  used_ = 0;
+  for (HeaderEntryImpl* entry = headers.front(); entry != nullptr;
+       entry = headers.at(entry->next_)) {
+    if (!entry->inline_) {
+      place(headers, *entry);
+    }
+  }
+}
+
+uint32_t HeaderMapImpl::CustomHeaderIndex::findPosition(const HeaderList& headers, const char* key,
+                                                         uint32_t size) const {
+  const uint32_t mask = table_.size() - 1;
+  for (uint32_t position = hash(key, size) & mask; table_[position] != Empty;
+       position = (position + 1) & mask) {
+    if (table_[position] == Tombstone) {
+      continue;
+    }
+
+    const HeaderString& entry_key = headers.at(table_[position])->key();
+    if (entry_key.size() == size && memcmp(entry_key.c_str(), key, size) == 0) {
+      return position;
+    }
+  }
+
+  return Empty;
+}
+
+HeaderMapImpl::HeaderEntryImpl* HeaderMapImpl::CustomHeaderIndex::find(const HeaderList& headers,
+                                                                       const char* key,
+                                                                       uint32_t size) const {
+  const uint32_t position = findPosition(headers, key, size);
+  return position == Empty ? nullptr : headers.at(table_[position]);
+}
+
+void HeaderMapImpl::CustomHeaderIndex::insert(const HeaderList& headers, HeaderEntryImpl& entry) {
+  // Keep the load factor (including tombstones) at or under one half. The entry is already linked
+  // into the list, so rehash() indexes it along with everything else.
+  if ((used_ + 1) * 2 > table_.size()) {
+    rehash(headers, table_.size() * 2);
+    return;
+  }
+
+  place(headers, entry);
+}
+
+void HeaderMapImpl::CustomHeaderIndex::place(const HeaderList& headers, HeaderEntryImpl& entry) {
+  entry.next_same_key_ = HeaderList::InvalidIndex;
+  const uint32_t existing = findPosition(headers, entry.key().c_str(), entry.key().size());
+  if (existing != Empty) {
+    HeaderEntryImpl* last = headers.at(table_[existing]);
+    while (last->next_same_key_ != HeaderList::InvalidIndex) {
+      last = headers.at(last->next_same_key_);
+    }
+    last->next_same_key_ = entry.index_;
+    return;
+  }
+
+  const uint32_t mask = table_.size() - 1;
+  uint32_t position = hash(entry.key().c_str(), entry.key().size()) & mask;
+  while (table_[position] != Empty && table_[position] != Tombstone) {
+    position = (position + 1) & mask;
+  }
+  if (table_[position] == Empty) {
+    used_++;
+  }
+  table_[position] = entry.index_;
+}
+
+HeaderMapImpl::HeaderEntryImpl*
+HeaderMapImpl::CustomHeaderIndex::remove(const HeaderList& headers, const char* key,
+                                         uint32_t size) {
+  const uint32_t position = findPosition(headers, key, size);
+  if (position == Empty) {
+    return nullptr;
+  }
+
+  HeaderEntryImpl* first = headers.at(table_[position]);
+  table_[position] = Tombstone;
+  return first;
+}
+
 #define INLINE_HEADER_STATIC_MAP_ENTRY(name)                                                       \
   add(Headers::get().name.get().c_str(), [](HeaderMapImpl& h) -> StaticLookupResponse {            \
     return {&h.inline_headers_.name##_, &Headers::get().name};                                     \
   });
 
+const uint32_t HeaderMapImpl::StaticLookupTable::TableSize;
+
 HeaderMapImpl::StaticLookupTable::StaticLookupTable() {
+  entries_.emplace_back();
   ALL_INLINE_HEADERS(INLINE_HEADER_STATIC_MAP_ENTRY)
 
   // Special case where we map a legacy host header to :authority.
   add(Headers::get().HostLegacy.get().c_str(), [](HeaderMapImpl& h) -> StaticLookupResponse {
     return {&h.inline_headers_.Host_, &Headers::get().Host};
   });
-}
-
-void HeaderMapImpl::StaticLookupTable::add(const char* key, StaticLookupEntry::EntryCb cb) {
-  StaticLookupEntry* current = &root_;
-  while (uint8_t c = *key) {
-    if (!current->entries_[c]) {
-      current->entries_[c].reset(new StaticLookupEntry());
+  // Every entry must fit in a slot index.
+  RELEASE_ASSERT(entries_.size() <= std::numeric_limits<uint8_t>::max());
+
+  for (seed_ = 0;; seed_++) {
+    slots_.fill(0);
+    bool collision = false;
+    for (uint8_t i = 1; i < entries_.size(); i++) {
+      uint8_t& slot = slots_[hash(entries_[i].key_, entries_[i].size_, seed_)];
+      if (slot != 0) {
+        collision = true;
+        break;
+      }
+      slot = i;
     }
 
-    current = current->entries_[c].get();
-    key++;
+    if (!collision) {
+      break;
+    }
   }
+}
 
-  current->cb_ = cb;
+void HeaderMapImpl::StaticLookupTable::add(const char* key, StaticLookupEntry::EntryCb cb) {
+  StaticLookupEntry entry;
+  entry.key_ = key;
+  entry.size_ = strlen(key);
+  entry.cb_ = cb;
+  entries_.push_back(entry);
 }
 
-HeaderMapImpl::StaticLookupEntry::EntryCb
-HeaderMapImpl::StaticLookupTable::find(const char* key) const {
-  const StaticLookupEntry* current = &root_;
-  while (uint8_t c = *key) {
-    current = current->entries_[c].get();
-    if (current) {
-      key++;
-    } else {
-      return nullptr;
+HeaderMapImpl::HeaderMapImpl() { memset(&inline_headers_, 0, sizeof(inline_headers_)); }
+
+HeaderMapImpl::HeaderMapImpl(HeaderMapImpl&& rhs) : HeaderMapImpl() { *this = std::move(rhs); }
+
+HeaderMapImpl& HeaderMapImpl::operator=(HeaderMapImpl&& rhs) {
+  // Slot indexes are preserved by the HeaderList move, so the custom header index is still valid.
+  // Inline entries in the inline slots are relocated though, so the inline header pointers are
+  // recomputed from the static lookup table.
+  headers_ = std::move(rhs.headers_);
+  custom_index_ = std::move(rhs.custom_index_);
+  rhs.custom_index_ = CustomHeaderIndex();
+  custom_headers_ = rhs.custom_headers_;
+  rhs.custom_headers_ = 0;
+  memset(&rhs.inline_headers_, 0, sizeof(rhs.inline_headers_));
+  memset(&inline_headers_, 0, sizeof(inline_headers_));
+
+  const StaticLookupTable& table = ConstSingleton<StaticLookupTable>::get();
+  for (HeaderEntryImpl* entry = headers_.front(); entry != nullptr;
+       entry = headers_.at(entry->next_)) {
+    if (entry->inline_) {
+      *table.find(entry->key().c_str(), entry->key().size())(*this).entry_ = entry;
     }
   }
 
-  return current->cb_;
+  return *this;
 }
 
-HeaderMapImpl::HeaderMapImpl() { memset(&inline_headers_, 0, sizeof(inline_headers_)); }
-
 HeaderMapImpl::HeaderMapImpl(const HeaderMap& rhs) : HeaderMapImpl() {
   rhs.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
@@ -290,7 +572,8 @@ bool HeaderMapImpl::operator==(const HeaderMapImpl& rhs) const {
     return false;
   }
 
-  for (auto i = headers_.begin(), j = rhs.headers_.begin(); i != headers_.end(); ++i, ++j) {
+  for (const HeaderEntryImpl *i = headers_.front(), *j = rhs.headers_.front(); i != nullptr;
+       i = headers_.at(i->next_), j = rhs.headers_.at(j->next_)) {
     if (i->key() != j->key().c_str() || i->value() != j->value().c_str()) {
       return false;
     }
@@ -300,7 +583,8 @@ bool HeaderMapImpl::operator==(const HeaderMapImpl& rhs) const {
 }
 
 void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.c_str());
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.c_str(), key.size());
   if (cb) {
     // TODO(mattklein123): Currently, for all of the inline headers, we don't support appending. The
     // only inline header where we should be converting multiple headers into a comma delimited
@@ -311,9 +595,11 @@ void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     maybeCreateInline(ref_lookup_response.entry_, *ref_lookup_response.key_, std::move(value));
   } else {
-    std::list<HeaderEntryImpl>::iterator i =
-        headers_.emplace(headers_.end(), std::move(key), std::move(value));
-    i->entry_ = i;
+    HeaderEntryImpl& entry = headers_.emplaceBack(std::move(key), std::move(value));
+    custom_headers_++;
+    if (custom_index_.built()) {
+      custom_index_.insert(headers_, entry);
+    }
   }
 }
 
@@ -365,18 +651,38 @@ void HeaderMapImpl::addCopy(const LowerCaseString& key, const std::string& value
 
 uint64_t HeaderMapImpl::byteSize() const {
   uint64_t byte_size = 0;
-  for (const HeaderEntryImpl& header : headers_) {
-    byte_size += header.key().size();
-    byte_size += header.value().size();
+  for (const HeaderEntryImpl* header = headers_.front(); header != nullptr;
+       header = headers_.at(header->next_)) {
+    byte_size += header->key().size();
+    byte_size += header->value().size();
   }
 
   return byte_size;
 }
 
 const HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) const {
-  for (const HeaderEntryImpl& header : headers_) {
-    if (header.key() == key.get().c_str()) {
-      return &header;
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
+  if (cb) {
+    // The lookup callbacks only compute the address of the inline header pointer, so this does not
+    // modify the map. The key check excludes aliases such as the legacy host header, which are
+    // stored under a different key.
+    const HeaderEntryImpl* entry = *cb(const_cast<HeaderMapImpl&>(*this)).entry_;
+    return entry != nullptr && entry->key() == key.get().c_str() ? entry : nullptr;
+  }
+
+  if (!custom_index_.built() && custom_headers_ > CustomHeaderIndex::BuildThreshold) {
+    custom_index_.build(headers_, custom_headers_);
+  }
+
+  if (custom_index_.built()) {
+    return custom_index_.find(headers_, key.get().c_str(), key.get().size());
+  }
+
+  for (const HeaderEntryImpl* header = headers_.front(); header != nullptr;
+       header = headers_.at(header->next_)) {
+    if (header->key() == key.get().c_str()) {
+      return header;
     }
   }
 
@@ -384,34 +690,86 @@ const HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) const {
 }
 
 void HeaderMapImpl::iterate(ConstIterateCb cb, void* context) const {
-  for (const HeaderEntryImpl& header : headers_) {
-    if (cb(header, context) == HeaderMap::Iterate::Break) {
+  for (const HeaderEntryImpl* header = headers_.front(); header != nullptr;
+       header = headers_.at(header->next_)) {
+    if (cb(*header, context) == HeaderMap::Iterate::Break) {
       break;
     }
   }
 }
 
 void HeaderMapImpl::iterateReverse(ConstIterateCb cb, void* context) const {
-  for (auto it = headers_.rbegin(); it != headers_.rend(); it++) {
-    if (cb(*it, context) == HeaderMap::Iterate::Break) {
+  for (const HeaderEntryImpl* header = headers_.back(); header != nullptr;
+       header = headers_.at(header->prev_)) {
+    if (cb(*header, context) == HeaderMap::Iterate::Break) {
       break;
     }
   }
 }
 
 void HeaderMapImpl::remove(const LowerCaseString& key) {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.get().c_str());
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
   if (cb) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     removeInline(ref_lookup_response.entry_);
+  } else if (custom_index_.built()) {
+    HeaderEntryImpl* entry = custom_index_.remove(headers_, key.get().c_str(), key.get().size());
+    while (entry != nullptr) {
+      HeaderEntryImpl* next = headers_.at(entry->next_same_key_);
+      headers_.erase(*entry);
+      custom_headers_--;
+      entry = next;
+    }
   } else {
-    for (auto i = headers_.begin(); i != headers_.end();) {
-      if (i->key() == key.get().c_str()) {
-        i = headers_.erase(i);
-      } else {
-        ++i;
+    for (HeaderEntryImpl* header = headers_.front(); header != nullptr;) {
+      HeaderEntryImpl* next = headers_.at(header->next_);
+      if (header->key() == key.get().c_str()) {
+        headers_.erase(*header);
+        custom_headers_--;
+      }
+      header = next;
+    }
+  }
+}
+
+void HeaderMapImpl::remove(const std::list<LowerCaseString>& keys) {
+  // Inline headers are removed through their slots. The other keys are matched during a single
+  // walk over the map, unless the custom header index can find them directly.
+  std::vector<const LowerCaseString*> custom_keys;
+  uint64_t size_mask = 0;
+  for (const LowerCaseString& key : keys) {
+    StaticLookupEntry::EntryCb cb =
+        ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
+    if (cb) {
+      removeInline(cb(*this).entry_);
+    } else if (custom_index_.built()) {
+      remove(key);
+    } else {
+      custom_keys.push_back(&key);
+      size_mask |= 1ULL << (key.get().size() & 63);
+    }
+  }
+
+  if (custom_keys.empty() || custom_headers_ == 0) {
+    return;
+  }
+
+  for (HeaderEntryImpl* header = headers_.front(); header != nullptr;) {
+    HeaderEntryImpl* next = headers_.at(header->next_);
+    const uint32_t size = header->key().size();
+    // Most headers are rejected by their key size alone.
+    if (size_mask & (1ULL << (size & 63))) {
+      for (const LowerCaseString* key : custom_keys) {
+        if (key->get().size() == size &&
+            memcmp(header->key().c_str(), key->get().c_str(), size) == 0) {
+          headers_.erase(*header);
+          custom_headers_--;
+          break;
+        }
       }
     }
+    header = next;
   }
 }
 
@@ -421,9 +779,9 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.emplace(headers_.end(), key);
-  i->entry_ = i;
-  *entry = &(*i);
+  HeaderEntryImpl& new_entry = headers_.emplaceBack(key);
+  new_entry.inline_ = true;
+  *entry = &new_entry;
   return **entry;
 }
 
@@ -435,9 +793,9 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.emplace(headers_.end(), key, std::move(value));
-  i->entry_ = i;
-  *entry = &(*i);
+  HeaderEntryImpl& new_entry = headers_.emplaceBack(key, std::move(value));
+  new_entry.inline_ = true;
+  *entry = &new_entry;
   return **entry;
 }
 
@@ -448,7 +806,7 @@ void HeaderMapImpl::removeInline(HeaderEntryImpl** ptr_to_entry) {
 
   HeaderEntryImpl* entry = *ptr_to_entry;
   *ptr_to_entry = nullptr;
-  headers_.erase(entry->entry_);
+  headers_.erase(*entry);
 }
 
 } // namespace Http
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <string.h>
+
 #include <array>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "envoy/http/header_map.h"
 
+#include "common/common/free_list.h"
 #include "common/common/non_copyable.h"
 #include "common/http/headers.h"
 
@@ -40,6 +46,15 @@ public:
   HeaderMapImpl();
   HeaderMapImpl(const std::initializer_list<std::pair<LowerCaseString, std::string>>& values);
   HeaderMapImpl(const HeaderMap& rhs);
+  HeaderMapImpl(HeaderMapImpl&& rhs);
+  HeaderMapImpl& operator=(HeaderMapImpl&& rhs);
+
+  /**
+   * Header maps are created and destroyed several times per request, so they are recycled through
+   * a per-thread free list. Maps of derived classes with a different size are not cached.
+   */
+  static void* operator new(size_t size) { return FreeList<HeaderMapImpl>::allocate(size); }
+  static void operator delete(void* p, size_t size) { FreeList<HeaderMapImpl>::release(p, size); }
 
   /**
    * Add a header via full move. This is the expected high performance paths for codecs populating
@@ -65,8 +80,14 @@ public:
   void iterate(ConstIterateCb cb, void* context) const override;
   void iterateReverse(ConstIterateCb cb, void* context) const override;
   void remove(const LowerCaseString& key) override;
+  void remove(const std::list<LowerCaseString>& keys) override;
   size_t size() const override { return headers_.size(); }
 
+  /**
+   * For testing. @return whether non-inline header lookups currently go through the hash index.
+   */
+  bool customHeaderIndexBuiltForTest() const { return custom_index_.built(); }
+
 protected:
   struct HeaderEntryImpl : public HeaderEntry, NonCopyable {
     HeaderEntryImpl(const LowerCaseString& key);
@@ -84,7 +105,123 @@ protected:
 
     HeaderString key_;
     HeaderString value_;
-    std::list<HeaderEntryImpl>::iterator entry_;
+    // Slot of this entry in the HeaderList, and of the entries before and after it in insertion
+    // order.
+    uint32_t index_;
+    uint32_t prev_;
+    uint32_t next_;
+    // Slot of the next entry with the same key. Only maintained for non-inline headers while the
+    // CustomHeaderIndex is built.
+    uint32_t next_same_key_;
+    // Whether this entry is referenced from AllInlineHeaders.
+    bool inline_{};
+  };
+
+  /**
+   * Ordered storage for header entries which avoids a heap allocation per header. The first
+   * InlineCapacity entries live inside the map itself, and further entries are allocated in
+   * blocks of BlockCapacity. Each entry is a few hundred bytes because of the inline buffers of
+   * HeaderString, so only a handful are kept inline to keep small maps such as trailers small.
+   * Entries are never moved once constructed, so pointers to them remain valid until they are
+   * removed. Insertion order is kept with an intrusive doubly linked list of slot indexes, and the
+   * slots of removed entries are reused.
+   */
+  class HeaderList : NonCopyable {
+  public:
+    static const uint32_t InlineCapacity = 4;
+    static const uint32_t BlockCapacity = 16;
+    static const uint32_t InvalidIndex = UINT32_MAX;
+
+    HeaderList() {}
+    HeaderList(HeaderList&& rhs) { *this = std::move(rhs); }
+    ~HeaderList() { clear(); }
+
+    /**
+     * Take over the entries of another list. Entries stored in the other list's inline slots are
+     * moved into this list's inline slots at the same index, and all other entries keep their
+     * addresses.
+     */
+    HeaderList& operator=(HeaderList&& rhs);
+
+    template <class... Args> HeaderEntryImpl& emplaceBack(Args&&... args) {
+      const uint32_t index = allocateSlot();
+      HeaderEntryImpl* entry = new (slot(index)) HeaderEntryImpl(std::forward<Args>(args)...);
+      entry->index_ = index;
+      entry->prev_ = tail_;
+      entry->next_ = InvalidIndex;
+      entry->next_same_key_ = InvalidIndex;
+      if (tail_ == InvalidIndex) {
+        head_ = index;
+      } else {
+        at(tail_)->next_ = index;
+      }
+      tail_ = index;
+      size_++;
+      return *entry;
+    }
+
+    void erase(HeaderEntryImpl& entry);
+    void clear();
+    HeaderEntryImpl* at(uint32_t index) const {
+      return index == InvalidIndex ? nullptr : static_cast<HeaderEntryImpl*>(slot(index));
+    }
+    HeaderEntryImpl* front() const { return at(head_); }
+    HeaderEntryImpl* back() const { return at(tail_); }
+    size_t size() const { return size_; }
+
+  private:
+    typedef std::aligned_storage<sizeof(HeaderEntryImpl), alignof(HeaderEntryImpl)>::type Slot;
+
+    uint32_t allocateSlot();
+    void* slot(uint32_t index) const;
+    uint32_t& nextFree(uint32_t index) const { return *static_cast<uint32_t*>(slot(index)); }
+
+    std::array<Slot, InlineCapacity> inline_slots_;
+    std::vector<std::unique_ptr<Slot[]>> blocks_;
+    // Head of the list of free slots. The index of the next free slot is stored in the slot memory.
+    uint32_t free_head_{InvalidIndex};
+    // Number of slots that have ever been handed out.
+    uint32_t used_slots_{0};
+    uint32_t head_{InvalidIndex};
+    uint32_t tail_{InvalidIndex};
+    uint32_t size_{0};
+  };
+
+  /**
+   * Open addressing hash index from the keys of non-inline headers to the first entry with that
+   * key. Later entries with the same key are chained through HeaderEntryImpl::next_same_key_. The
+   * index is only built once a map has more than BuildThreshold non-inline headers and a lookup is
+   * done, since scanning a handful of entries is cheaper than hashing.
+   */
+  class CustomHeaderIndex {
+  public:
+    static const uint32_t BuildThreshold = 8;
+
+    bool built() const { return !table_.empty(); }
+    void build(const HeaderList& headers, uint32_t num_headers);
+    HeaderEntryImpl* find(const HeaderList& headers, const char* key, uint32_t size) const;
+    void insert(const HeaderList& headers, HeaderEntryImpl& entry);
+    /**
+     * Remove the key from the index.
+     * @return the first entry with the key, or nullptr if there is none. The caller is expected to
+     *         erase the whole chain of entries.
+     */
+    HeaderEntryImpl* remove(const HeaderList& headers, const char* key, uint32_t size);
+
+  private:
+    static const uint32_t Empty = UINT32_MAX;
+    static const uint32_t Tombstone = UINT32_MAX - 1;
+
+    static uint32_t hash(const char* key, uint32_t size);
+    // Returns the table position holding the key, or Empty if it is not present.
+    uint32_t findPosition(const HeaderList& headers, const char* key, uint32_t size) const;
+    void rehash(const HeaderList& headers, uint32_t new_size);
+    // Adds an entry without checking whether the table needs to grow.
+    void place(const HeaderList& headers, HeaderEntryImpl& entry);
+
+    std::vector<uint32_t> table_;
+    // Number of table positions that are not Empty (including tombstones).
+    uint32_t used_{0};
   };
 
   struct StaticLookupResponse {
@@ -95,20 +232,50 @@ protected:
   struct StaticLookupEntry {
     typedef StaticLookupResponse (*EntryCb)(HeaderMapImpl&);
 
+    const char* key_{""};
+    uint32_t size_{};
     EntryCb cb_{};
-    std::array<std::unique_ptr<StaticLookupEntry>, 256> entries_;
   };
 
   /**
    * This is the static lookup table that is used to determine whether a header is one of the O(1)
-   * headers. This uses a trie for lookup time at most equal to the size of the incoming string.
+   * headers. It is a perfect hash table: at startup a seed is searched for such that every inline
+   * header name hashes to a distinct slot. A lookup is then a single hash of the key, a single
+   * table load and a single compare, with no probing.
    */
   struct StaticLookupTable {
+    // Must be a power of two. With ~60 keys a table this size needs only a few seeds to be tried
+    // before a collision free one is found, while still being small enough to stay in cache.
+    static const uint32_t TableSize = 512;
+
     StaticLookupTable();
     void add(const char* key, StaticLookupEntry::EntryCb cb);
-    StaticLookupEntry::EntryCb find(const char* key) const;
+    StaticLookupEntry::EntryCb find(const char* key, uint32_t size) const {
+      const StaticLookupEntry& entry = entries_[slots_[hash(key, size, seed_)]];
+      if (entry.size_ == size && memcmp(entry.key_, key, size) == 0) {
+        return entry.cb_;
+      }
+      return nullptr;
+    }
+
+    static uint32_t hash(const char* key, uint32_t size, uint32_t seed) {
+      // FNV-1a with a seeded offset basis, followed by a finalizer so that the low bits used for
+      // the slot depend on the whole key.
+      uint32_t hash = 2166136261U ^ seed;
+      for (uint32_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(key[i]);
+        hash *= 16777619U;
+      }
+      hash ^= hash >> 15;
+      hash *= 0x85ebca6bU;
+      hash ^= hash >> 13;
+      return hash & (TableSize - 1);
+    }
 
-    StaticLookupEntry root_;
+    uint32_t seed_{};
+    // Index into entries_ for each hash slot. Entry 0 is an empty sentinel which never matches.
+    std::array<uint8_t, TableSize> slots_;
+    std::vector<StaticLookupEntry> entries_;
   };
 
   struct AllInlineHeaders {
@@ -122,7 +289,11 @@ protected:
   void removeInline(HeaderEntryImpl** entry);
 
   AllInlineHeaders inline_headers_;
-  std::list<HeaderEntryImpl> headers_;
+  HeaderList headers_;
+  // Built lazily by the const get(), hence mutable.
+  mutable CustomHeaderIndex custom_index_;
+  // Number of headers in headers_ that are not inline headers.
+  uint32_t custom_headers_{0};
 
   ALL_INLINE_HEADERS(DEFINE_INLINE_HEADER_FUNCS)
 };
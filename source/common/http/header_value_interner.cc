@@ -0,0 +1,168 @@
+#include "common/http/header_value_interner.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+
+namespace Envoy {
+namespace Http {
+
+SharedHeaderValue* SharedHeaderValue::create(const char* data, uint32_t size) {
+  void* memory = ::operator new(sizeof(SharedHeaderValue) + size + 1);
+  SharedHeaderValue* value = new (memory) SharedHeaderValue(size);
+  char* value_data = reinterpret_cast<char*>(value + 1);
+  memcpy(value_data, data, size);
+  value_data[size] = 0;
+  return value;
+}
+
+void SharedHeaderValue::release() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    this->~SharedHeaderValue();
+    ::operator delete(this);
+  }
+}
+
+const uint32_t HeaderValueInterner::MinValueSize;
+const uint32_t HeaderValueInterner::DefaultMaxEntries;
+const uint32_t HeaderValueInterner::DefaultMaxValueSize;
+
+HeaderValueInterner::HeaderValueInterner(uint32_t max_entries, uint32_t max_value_size)
+    : max_entries_(max_entries), max_value_size_(max_value_size) {
+  // Keep the load factor at or below 1/2 so probe sequences stay short.
+  uint32_t table_size = 1;
+  while (table_size < max_entries * 2) {
+    table_size <<= 1;
+  }
+  entries_.resize(table_size);
+  candidates_.resize(table_size);
+}
+
+HeaderValueInterner::~HeaderValueInterner() {
+  for (Entry& entry : entries_) {
+    if (entry.value_ != nullptr) {
+      entry.value_->release();
+    }
+  }
+}
+
+void HeaderValueInterner::setValue(HeaderString& string, const char* data, uint32_t size) {
+  SharedHeaderValue* value = lookup(data, size);
+  if (value != nullptr) {
+    string.setShared(*value);
+  } else {
+    string.setCopy(data, size);
+  }
+}
+
+void HeaderValueInterner::intern(HeaderString& string) {
+  if (string.type() != HeaderString::Type::Dynamic) {
+    return;
+  }
+
+  SharedHeaderValue* value = lookup(string.c_str(), string.size());
+  if (value != nullptr) {
+    string.setShared(*value);
+  }
+}
+
+HeaderValueInterner& HeaderValueInterner::threadLocal() {
+  static thread_local HeaderValueInterner interner;
+  return interner;
+}
+
+SharedHeaderValue* HeaderValueInterner::lookup(const char* data, uint32_t size) {
+  if (size < MinValueSize || size > max_value_size_) {
+    return nullptr;
+  }
+
+  // 0 marks an empty slot.
+  const uint64_t hash = std::max<uint64_t>(HashUtil::xxHash64(data, size), 1);
+  const uint64_t mask = entries_.size() - 1;
+  uint64_t index = hash & mask;
+  while (entries_[index].value_ != nullptr) {
+    Entry& entry = entries_[index];
+    if (entry.hash_ == hash && entry.value_->size() == size &&
+        memcmp(entry.value_->data(), data, size) == 0) {
+      entry.referenced_ = true;
+      return entry.value_;
+    }
+    index = (index + 1) & mask;
+  }
+
+  uint64_t& candidate = candidates_[hash & mask];
+  if (candidate != hash) {
+    candidate = hash;
+    return nullptr;
+  }
+
+  if (size_ == max_entries_) {
+    if (!evict()) {
+      return nullptr;
+    }
+
+    // Removing the entry may have shifted others, so find the free slot again.
+    index = hash & mask;
+    while (entries_[index].value_ != nullptr) {
+      index = (index + 1) & mask;
+    }
+  }
+
+  candidate = 0;
+  entries_[index].hash_ = hash;
+  entries_[index].value_ = SharedHeaderValue::create(data, size);
+  size_++;
+  return entries_[index].value_;
+}
+
+bool HeaderValueInterner::evict() {
+  const uint64_t mask = entries_.size() - 1;
+  // Two passes are enough to clear every referenced bit and come back to the first entry.
+  for (uint64_t i = 0; i < 2 * entries_.size(); i++) {
+    const uint64_t index = clock_hand_;
+    clock_hand_ = (clock_hand_ + 1) & mask;
+
+    Entry& entry = entries_[index];
+    if (entry.value_ == nullptr) {
+      continue;
+    }
+    if (entry.referenced_) {
+      entry.referenced_ = false;
+      continue;
+    }
+    // Only the table holds a reference, so no header can be using the value. Other threads only
+    // ever release references they already hold, so this cannot go back up.
+    if (entry.value_->refCount() == 1) {
+      entry.value_->release();
+      remove(index);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void HeaderValueInterner::remove(uint64_t index) {
+  const uint64_t mask = entries_.size() - 1;
+  uint64_t hole = index;
+  for (uint64_t next = (index + 1) & mask; entries_[next].value_ != nullptr;
+       next = (next + 1) & mask) {
+    // An entry can fill the hole if the hole is on its probe sequence, i.e. its home slot is not
+    // between the hole and where it is now.
+    const uint64_t home = entries_[next].hash_ & mask;
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      entries_[hole] = entries_[next];
+      hole = next;
+    }
+  }
+
+  entries_[hole] = Entry();
+  size_--;
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/http/header_map.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * An immutable, reference counted header value. The character data is allocated in the same block
+ * as the object and is null terminated. Instances are created with a single reference which
+ * belongs to the caller.
+ */
+class SharedHeaderValue : NonCopyable {
+public:
+  static SharedHeaderValue* create(const char* data, uint32_t size);
+
+  void acquire() { refs_.fetch_add(1, std::memory_order_relaxed); }
+  void release();
+
+  const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+  uint32_t size() const { return size_; }
+  uint32_t refCount() const { return refs_.load(std::memory_order_relaxed); }
+
+private:
+  explicit SharedHeaderValue(uint32_t size) : refs_(1), size_(size) {}
+
+  std::atomic<uint32_t> refs_;
+  const uint32_t size_;
+};
+
+/**
+ * A buffer fragment which holds a reference to a shared header value, so that codecs can write
+ * the value out without copying it. The fragment deletes itself once buffers are done with it.
+ */
+class SharedHeaderValueFragment : public Buffer::BufferFragment {
+public:
+  explicit SharedHeaderValueFragment(SharedHeaderValue& value) : value_(value) {
+    value_.acquire();
+  }
+
+  // Buffer::BufferFragment
+  const void* data() const override { return value_.data(); }
+  size_t size() const override { return value_.size(); }
+  void done() override {
+    value_.release();
+    delete this;
+  }
+
+private:
+  SharedHeaderValue& value_;
+};
+
+/**
+ * A bounded table of header values that repeat across requests (user agents, cookies shared by a
+ * client, authorization tokens, etc.). Strings that are set or interned through the table share
+ * one copy of the value instead of each owning a heap allocation.
+ *
+ * Only values that would otherwise be heap allocated are interned: smaller values fit in the
+ * HeaderString inline buffer and copying them is cheaper than the lookup. A value is admitted to
+ * the table the second time it is seen, so that one-off values (request IDs, unique cookies) do
+ * not fill it. Once the table is full, admitting a value evicts one chosen by a CLOCK sweep:
+ * entries looked up since the hand last passed get a second chance, and entries still used by a
+ * header are skipped. If every entry is in use the value is not admitted.
+ *
+ * The table itself is not thread safe and is meant to be used from a single worker thread. The
+ * values it hands out may be released on any thread.
+ */
+class HeaderValueInterner : NonCopyable {
+public:
+  // Values shorter than this are stored inline by HeaderString and are never interned.
+  static const uint32_t MinValueSize = 128;
+  static const uint32_t DefaultMaxEntries = 1024;
+  static const uint32_t DefaultMaxValueSize = 4096;
+
+  HeaderValueInterner(uint32_t max_entries = DefaultMaxEntries,
+                      uint32_t max_value_size = DefaultMaxValueSize);
+  ~HeaderValueInterner();
+
+  /**
+   * Set the value of a string, sharing storage with an identical previously seen value if
+   * possible. Otherwise the data is copied as with HeaderString::setCopy().
+   */
+  void setValue(HeaderString& string, const char* data, uint32_t size);
+
+  /**
+   * Replace the storage of an already assembled string with an identical shared value if one is
+   * available. Strings that are not heap allocated are left untouched.
+   */
+  void intern(HeaderString& string);
+
+  /**
+   * @return the number of values currently held by the table.
+   */
+  uint32_t size() const { return size_; }
+
+  /**
+   * @return the interner for the calling thread.
+   */
+  static HeaderValueInterner& threadLocal();
+
+private:
+  struct Entry {
+    uint64_t hash_{};
+    SharedHeaderValue* value_{};
+    // Set when the value is looked up, cleared when the clock hand passes over it.
+    bool referenced_{};
+  };
+
+  /**
+   * @return the shared value equal to data if there is one, after admitting it to the table if
+   *         this is the second time it is seen. nullptr otherwise.
+   */
+  SharedHeaderValue* lookup(const char* data, uint32_t size);
+
+  /**
+   * Evict the next entry the clock hand reaches that has not been looked up since the hand last
+   * passed it and is not used by any header.
+   * @return whether an entry was evicted.
+   */
+  bool evict();
+
+  /**
+   * Remove the entry at index, shifting back the entries in its probe sequence.
+   */
+  void remove(uint64_t index);
+
+  const uint32_t max_entries_;
+  const uint32_t max_value_size_;
+  std::vector<Entry> entries_;
+  // Hashes of values that have been seen once but not admitted yet. Collisions simply overwrite.
+  std::vector<uint64_t> candidates_;
+  uint32_t size_{0};
+  uint64_t clock_hand_{0};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -10,17 +10,20 @@
 #include "common/common/enum_to_int.h"
 #include "common/common/utility.h"
 #include "common/http/exception.h"
+#include "common/http/header_value_interner.h"
 #include "common/http/headers.h"
+#include "common/http/http1/parser_impl.h"
 #include "common/http/utility.h"
 
 #include "fmt/format.h"
+#include "http_parser.h"
 
 namespace Envoy {
 namespace Http {
 namespace Http1 {
 
-const std::string StreamEncoderImpl::CRLF = "\r\n";
 const std::string StreamEncoderImpl::LAST_CHUNK = "0\r\n\r\n";
+const uint32_t StreamEncoderImpl::MinFragmentValueSize;
 
 void StreamEncoderImpl::encodeHeader(const char* key, uint32_t key_size, const char* value,
                                      uint32_t value_size) {
@@ -36,6 +39,28 @@ void StreamEncoderImpl::encodeHeader(const char* key, uint32_t key_size, const c
   connection_.addCharToBuffer('\n');
 }
 
+void StreamEncoderImpl::encodeHeader(const char* key, uint32_t key_size,
+                                     const HeaderString& value) {
+  SharedHeaderValue* shared = value.shared();
+  if (shared == nullptr || shared->size() < MinFragmentValueSize) {
+    encodeHeader(key, key_size, value.c_str(), value.size());
+    return;
+  }
+
+  // The fragment holds its own reference to the value, so the header map may be destroyed before
+  // the connection has written it out.
+  connection_.reserveBuffer(key_size + 2);
+  ASSERT(key_size > 0);
+
+  connection_.copyToBuffer(key, key_size);
+  connection_.addCharToBuffer(':');
+  connection_.addCharToBuffer(' ');
+  connection_.addFragmentToBuffer(*new SharedHeaderValueFragment(*shared));
+  connection_.reserveBuffer(2);
+  connection_.addCharToBuffer('\r');
+  connection_.addCharToBuffer('\n');
+}
+
 void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
   bool saw_content_length = false;
   headers.iterate(
@@ -53,8 +78,8 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
           return HeaderMap::Iterate::Continue;
         }
 
-        static_cast<StreamEncoderImpl*>(context)->encodeHeader(
-            key_to_use, key_size_to_use, header.value().c_str(), header.value().size());
+        static_cast<StreamEncoderImpl*>(context)->encodeHeader(key_to_use, key_size_to_use,
+                                                               header.value());
         return HeaderMap::Iterate::Continue;
       },
       this);
@@ -99,14 +124,28 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
   // end_stream may be indicated with a zero length data buffer. If that is the case, so not
   // atually write the zero length buffer out.
   if (data.length() > 0) {
-    if (chunk_encoding_) {
-      connection_.buffer().add(fmt::format("{:x}\r\n", data.length()));
-    }
-
-    connection_.buffer().move(data);
+    if (chunk_encoding_ && chunk_aggregation_.count() > 0) {
+      const bool timer_enabled = aggregated_chunk_.length() > 0;
+      aggregated_chunk_.move(data);
+      if (!end_stream && aggregated_chunk_.length() < MaxAggregatedChunkSize) {
+        // Hold the data back in case more follows shortly, but no longer than the bound from the
+        // time the first of it arrived.
+        if (!timer_enabled) {
+          if (!chunk_aggregation_timer_) {
+            chunk_aggregation_timer_ = connection_.connection().dispatcher().createTimer(
+                [this]() -> void { onChunkAggregationTimeout(); });
+          }
+          chunk_aggregation_timer_->enableTimer(chunk_aggregation_);
+        }
+        return;
+      }
 
-    if (chunk_encoding_) {
-      connection_.buffer().add(CRLF);
+      if (chunk_aggregation_timer_) {
+        chunk_aggregation_timer_->disableTimer();
+      }
+      encodeBody(aggregated_chunk_);
+    } else {
+      encodeBody(data);
     }
   }
 
@@ -117,24 +156,55 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
   }
 }
 
+void StreamEncoderImpl::encodeBody(Buffer::Instance& data) {
+  if (!chunk_encoding_) {
+    connection_.moveToBuffer(data);
+    return;
+  }
+
+  // The chunk size takes at most 16 hex digits. The CRLF which ends the chunk goes into the same
+  // reservation as the size of the next chunk.
+  connection_.reserveBuffer(18);
+  connection_.addHexToBuffer(data.length());
+  connection_.addCharToBuffer('\r');
+  connection_.addCharToBuffer('\n');
+  connection_.moveToBuffer(data);
+  connection_.reserveBuffer(2);
+  connection_.addCharToBuffer('\r');
+  connection_.addCharToBuffer('\n');
+}
+
+void StreamEncoderImpl::onChunkAggregationTimeout() {
+  encodeBody(aggregated_chunk_);
+  connection_.flushOutput();
+}
+
 void StreamEncoderImpl::encodeTrailers(const HeaderMap&) { endEncode(); }
 
 void StreamEncoderImpl::endEncode() {
   if (chunk_encoding_) {
-    connection_.buffer().add(LAST_CHUNK);
+    if (aggregated_chunk_.length() > 0) {
+      chunk_aggregation_timer_->disableTimer();
+      encodeBody(aggregated_chunk_);
+    }
+    connection_.reserveBuffer(LAST_CHUNK.size());
+    connection_.copyToBuffer(LAST_CHUNK.c_str(), LAST_CHUNK.size());
   }
 
   connection_.flushOutput();
   connection_.onEncodeComplete();
 }
 
-void ConnectionImpl::flushOutput() {
+void ConnectionImpl::commitReservation() {
   if (reserved_current_) {
     reserved_iovec_.len_ = reserved_current_ - static_cast<char*>(reserved_iovec_.mem_);
     output_buffer_.commit(&reserved_iovec_, 1);
     reserved_current_ = nullptr;
   }
+}
 
+void ConnectionImpl::flushOutput() {
+  commitReservation();
   connection().write(output_buffer_);
   ASSERT(0UL == output_buffer_.length());
 }
@@ -144,6 +214,23 @@ void ConnectionImpl::addCharToBuffer(char c) {
   *reserved_current_++ = c;
 }
 
+void ConnectionImpl::addFragmentToBuffer(Buffer::BufferFragment& fragment) {
+  // Anything written into the reservation so far must precede the fragment.
+  commitReservation();
+  output_buffer_.addBufferFragment(fragment);
+}
+
+void ConnectionImpl::addHexToBuffer(uint64_t i) {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  char digits[16];
+  char* start = digits + sizeof(digits);
+  do {
+    *--start = HEX_DIGITS[i & 0xf];
+    i >>= 4;
+  } while (i > 0);
+  copyToBuffer(start, digits + sizeof(digits) - start);
+}
+
 void ConnectionImpl::addIntToBuffer(uint64_t i) {
   reserved_current_ += StringUtil::itoa(reserved_current_, bufferRemainingSize(), i);
 }
@@ -158,15 +245,18 @@ void ConnectionImpl::copyToBuffer(const char* data, uint64_t length) {
   reserved_current_ += length;
 }
 
+void ConnectionImpl::moveToBuffer(Buffer::Instance& data) {
+  // Anything written into the reservation so far must precede the data.
+  commitReservation();
+  output_buffer_.move(data);
+}
+
 void ConnectionImpl::reserveBuffer(uint64_t size) {
   if (reserved_current_ && bufferRemainingSize() >= size) {
     return;
   }
 
-  if (reserved_current_) {
-    reserved_iovec_.len_ = reserved_current_ - static_cast<char*>(reserved_iovec_.mem_);
-    output_buffer_.commit(&reserved_iovec_, 1);
-  }
+  commitReservation();
 
   // TODO PERF: It would be better to allow a split reservation. That will make fill code more
   //            complicated.
@@ -174,7 +264,20 @@ void ConnectionImpl::reserveBuffer(uint64_t size) {
   reserved_current_ = static_cast<char*>(reserved_iovec_.mem_);
 }
 
+void ConnectionImpl::shrink() {
+  // An outstanding reservation points into the output buffer's memory.
+  if (reserved_current_ == nullptr) {
+    output_buffer_.shrink();
+  }
+  parser_->shrink();
+}
+
 void StreamEncoderImpl::resetStream(StreamResetReason reason) {
+  // Data held back for aggregation is not sent once the stream is reset.
+  if (chunk_aggregation_timer_) {
+    chunk_aggregation_timer_->disableTimer();
+  }
+  aggregated_chunk_.drain(aggregated_chunk_.length());
   connection_.onResetStreamBase(reason);
 }
 
@@ -225,50 +328,37 @@ void RequestStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_
   StreamEncoderImpl::encodeHeaders(headers, end_stream);
 }
 
-http_parser_settings ConnectionImpl::settings_{
-    [](http_parser* parser) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onMessageBeginBase();
-      return 0;
-    },
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onUrl(at, length);
-      return 0;
-    },
-    nullptr, // on_status
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onHeaderField(at, length);
-      return 0;
-    },
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onHeaderValue(at, length);
-      return 0;
-    },
-    [](http_parser* parser) -> int {
-      return static_cast<ConnectionImpl*>(parser->data)->onHeadersCompleteBase();
-    },
-    [](http_parser* parser, const char* at, size_t length) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onBody(at, length);
-      return 0;
-    },
-    [](http_parser* parser) -> int {
-      static_cast<ConnectionImpl*>(parser->data)->onMessageComplete();
-      return 0;
-    },
-    nullptr, // on_chunk_header
-    nullptr  // on_chunk_complete
-};
+void RequestStreamEncoderImpl::readDisable(bool disable) {
+  if (disable) {
+    read_disable_calls_++;
+  } else if (read_disable_calls_ > 0) {
+    read_disable_calls_--;
+  } else {
+    // The calls were unwound when the response completed.
+    return;
+  }
+  StreamEncoderImpl::readDisable(disable);
+}
+
+void RequestStreamEncoderImpl::unwindReadDisable() {
+  while (read_disable_calls_ > 0) {
+    readDisable(false);
+  }
+}
 
 const ToLowerTable& ConnectionImpl::toLowerTable() {
   static ToLowerTable* table = new ToLowerTable();
   return *table;
 }
 
-ConnectionImpl::ConnectionImpl(Network::Connection& connection, http_parser_type type)
-    : connection_(connection), output_buffer_([&]() -> void { this->onBelowLowWatermark(); },
-                                              [&]() -> void { this->onAboveHighWatermark(); }) {
+ConnectionImpl::ConnectionImpl(Network::Connection& connection, MessageType type,
+                               bool fast_parser)
+    : connection_(connection),
+      parser_(fast_parser ? ParserPtr{new FastParserImpl(type, *this)}
+                          : ParserPtr{new HttpParserImpl(type, *this)}),
+      output_buffer_([&]() -> void { this->onBelowLowWatermark(); },
+                     [&]() -> void { this->onAboveHighWatermark(); }) {
   output_buffer_.setWatermarks(connection.bufferLimit());
-  http_parser_init(&parser_, type);
-  parser_.data = this;
 }
 
 void ConnectionImpl::completeLastHeader() {
@@ -276,6 +366,9 @@ void ConnectionImpl::completeLastHeader() {
                  current_header_field_.c_str(), current_header_value_.c_str());
   if (!current_header_field_.empty()) {
     toLowerTable().toLowerCase(current_header_field_.buffer(), current_header_field_.size());
+    if (header_value_interner_ != nullptr) {
+      header_value_interner_->intern(current_header_value_);
+    }
     current_header_map_->addViaMove(std::move(current_header_field_),
                                     std::move(current_header_value_));
   }
@@ -289,7 +382,7 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   ENVOY_CONN_LOG(trace, "parsing {} bytes", connection_, data.length());
 
   // Always unpause before dispatch.
-  http_parser_pause(&parser_, 0);
+  parser_->resume();
 
   ssize_t total_parsed = 0;
   if (data.length() > 0) {
@@ -308,11 +401,10 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
 }
 
 size_t ConnectionImpl::dispatchSlice(const char* slice, size_t len) {
-  ssize_t rc = http_parser_execute(&parser_, &settings_, slice, len);
-  if (HTTP_PARSER_ERRNO(&parser_) != HPE_OK && HTTP_PARSER_ERRNO(&parser_) != HPE_PAUSED) {
+  const size_t rc = parser_->execute(slice, len);
+  if (parser_->error() != nullptr) {
     sendProtocolError();
-    throw CodecProtocolException("http/1.1 protocol error: " +
-                                 std::string(http_errno_name(HTTP_PARSER_ERRNO(&parser_))));
+    throw CodecProtocolException("http/1.1 protocol error: " + std::string(parser_->error()));
   }
 
   return rc;
@@ -344,7 +436,7 @@ void ConnectionImpl::onHeaderValue(const char* data, size_t length) {
 int ConnectionImpl::onHeadersCompleteBase() {
   ENVOY_CONN_LOG(trace, "headers complete", connection_);
   completeLastHeader();
-  if (!(parser_.http_major == 1 && parser_.http_minor == 1)) {
+  if (!(parser_->httpMajor() == 1 && parser_->httpMinor() == 1)) {
     // This is not necessarily true, but it's good enough since higher layers only care if this is
     // HTTP/1.1 or not.
     protocol_ = Protocol::Http10;
@@ -372,7 +464,12 @@ void ConnectionImpl::onResetStreamBase(StreamResetReason reason) {
 ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            ServerConnectionCallbacks& callbacks,
                                            Http1Settings settings)
-    : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {}
+    : ConnectionImpl(connection, MessageType::Request, settings.fast_parser_),
+      callbacks_(callbacks), codec_settings_(settings) {
+  if (codec_settings_.intern_header_values_) {
+    header_value_interner_ = &HeaderValueInterner::threadLocal();
+  }
+}
 
 void ServerConnectionImpl::onEncodeComplete() {
   ASSERT(active_request_);
@@ -466,11 +563,11 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
   // to disconnect the connection but we shouldn't fire any more events since it doesn't make
   // sense.
   if (active_request_) {
-    const char* method_string = http_method_str(static_cast<http_method>(parser_.method));
+    const char* method_string = http_method_str(static_cast<http_method>(parser_->method()));
 
     // Currently, CONNECT is not supported, however; http_parser_parse_url needs to know about
     // CONNECT
-    handlePath(*headers, parser_.method);
+    handlePath(*headers, parser_->method());
     ASSERT(active_request_->request_url_.empty());
 
     headers->insertMethod().value(method_string, strlen(method_string));
@@ -491,14 +588,14 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
     // with message complete. This allows upper layers to behave like HTTP/2 and prevents a proxy
     // scenario where the higher layers stream through and implicitly switch to chunked transfer
     // encoding because end stream with zero body length has not yet been indicated.
-    if (parser_.flags & F_CHUNKED ||
-        (parser_.content_length > 0 && parser_.content_length != ULLONG_MAX)) {
+    if (parser_->chunked() ||
+        (parser_->contentLength() > 0 && parser_->contentLength() != ULLONG_MAX)) {
       active_request_->request_decoder_->decodeHeaders(std::move(headers), false);
 
       // If the connection has been closed (or is closing) after decoding headers, pause the parser
       // so we return control to the caller.
       if (connection_.state() != Network::Connection::State::Open) {
-        http_parser_pause(&parser_, 1);
+        parser_->pause();
       }
 
     } else {
@@ -512,7 +609,7 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
 void ServerConnectionImpl::onMessageBegin() {
   if (!resetStreamCalled()) {
     ASSERT(!active_request_);
-    active_request_.reset(new ActiveRequest(*this));
+    active_request_.reset(new ActiveRequest(*this, codec_settings_.chunk_aggregation_));
     active_request_->request_decoder_ = &callbacks_.newStream(active_request_->response_encoder_);
   }
 }
@@ -550,7 +647,7 @@ void ServerConnectionImpl::onMessageComplete() {
   // Always pause the parser so that the calling code can process 1 request at a time and apply
   // back pressure. However this means that the calling code needs to detect if there is more data
   // in the buffer and dispatch it again.
-  http_parser_pause(&parser_, 1);
+  parser_->pause();
 }
 
 void ServerConnectionImpl::onResetStream(StreamResetReason reason) {
@@ -585,11 +682,11 @@ void ServerConnectionImpl::onBelowLowWatermark() {
 }
 
 ClientConnectionImpl::ClientConnectionImpl(Network::Connection& connection, ConnectionCallbacks&)
-    : ConnectionImpl(connection, HTTP_RESPONSE) {}
+    : ConnectionImpl(connection, MessageType::Response, false) {}
 
 bool ClientConnectionImpl::cannotHaveBody() {
   if ((!pending_responses_.empty() && pending_responses_.front().head_request_) ||
-      parser_.status_code == 204 || parser_.status_code == 304) {
+      parser_->statusCode() == 204 || parser_->statusCode() == 304) {
     return true;
   } else {
     return false;
@@ -603,22 +700,32 @@ StreamEncoder& ClientConnectionImpl::newStream(StreamDecoder& response_decoder)
   // Streams are responsible for unwinding any outstanding readDisable(true)
   // calls done on the underlying connection as they are destroyed. As this is
   // the only place a HTTP/1 stream is destroyed where the Network::Connection is
-  // reused, unwind any outstanding readDisable() calls here.
-  while (!connection_.readEnabled()) {
-    connection_.readDisable(false);
+  // reused, destroy the streams whose responses are complete here. Unless requests
+  // are pipelined, that is every stream, so unwind any outstanding readDisable() calls.
+  while (request_encoders_.size() > pending_responses_.size()) {
+    request_encoders_.front()->unwindReadDisable();
+    request_encoders_.pop_front();
+  }
+  if (pending_responses_.empty()) {
+    while (!connection_.readEnabled()) {
+      connection_.readDisable(false);
+    }
   }
-  request_encoder_.reset(new RequestStreamEncoderImpl(*this));
-  pending_responses_.emplace_back(&response_decoder);
-  return *request_encoder_;
+  request_encoders_.emplace_back(new RequestStreamEncoderImpl(*this));
+  pending_responses_.emplace_back(&response_decoder, request_encoders_.back().get());
+  return *request_encoders_.back();
 }
 
 void ClientConnectionImpl::onEncodeComplete() {
   // Transfer head request state into the pending response before we reuse the encoder.
-  pending_responses_.back().head_request_ = request_encoder_->headRequest();
+  if (!pending_responses_.empty() &&
+      pending_responses_.back().encoder_ == request_encoders_.back().get()) {
+    pending_responses_.back().head_request_ = request_encoders_.back()->headRequest();
+  }
 }
 
 int ClientConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
-  headers->insertStatus().value(parser_.status_code);
+  headers->insertStatus().value(parser_->statusCode());
 
   // Handle the case where the client is closing a kept alive connection (by sending a 408
   // with a 'Connection: close' header). In this case we just let response flush out followed
@@ -652,6 +759,10 @@ void ClientConnectionImpl::onMessageComplete() {
     // After calling decodeData() with end stream set to true, we should no longer be able to reset.
     PendingResponse response = pending_responses_.front();
     pending_responses_.pop_front();
+    if (!pending_responses_.empty()) {
+      // The flow control of this response must not hold up the ones pipelined behind it.
+      response.encoder_->unwindReadDisable();
+    }
 
     if (deferred_end_stream_headers_) {
       response.decoder_->decodeHeaders(std::move(deferred_end_stream_headers_), true);
@@ -666,14 +777,26 @@ void ClientConnectionImpl::onMessageComplete() {
 void ClientConnectionImpl::onResetStream(StreamResetReason reason) {
   // Only raise reset if we did not already dispatch a complete response.
   if (!pending_responses_.empty()) {
+    // Every pipelined request goes down with the connection.
+    std::list<PendingResponse> reset_responses(std::move(pending_responses_));
     pending_responses_.clear();
-    request_encoder_->runResetCallbacks(reason);
+    for (PendingResponse& response : reset_responses) {
+      response.encoder_->runResetCallbacks(reason);
+    }
   }
 }
 
-void ClientConnectionImpl::onAboveHighWatermark() { request_encoder_->runHighWatermarkCallbacks(); }
+void ClientConnectionImpl::onAboveHighWatermark() {
+  if (!request_encoders_.empty()) {
+    request_encoders_.back()->runHighWatermarkCallbacks();
+  }
+}
 
-void ClientConnectionImpl::onBelowLowWatermark() { request_encoder_->runLowWatermarkCallbacks(); }
+void ClientConnectionImpl::onBelowLowWatermark() {
+  if (!request_encoders_.empty()) {
+    request_encoders_.back()->runLowWatermarkCallbacks();
+  }
+}
 
 } // namespace Http1
 } // namespace Http
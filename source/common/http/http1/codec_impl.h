@@ -1,11 +1,13 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
 
+#include "envoy/event/timer.h"
 #include "envoy/http/codec.h"
 #include "envoy/network/connection.h"
 
@@ -15,8 +17,8 @@
 #include "common/http/codec_helper.h"
 #include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
-
-#include "http_parser.h"
+#include "common/http/header_value_interner.h"
+#include "common/http/http1/parser.h"
 
 namespace Envoy {
 namespace Http {
@@ -46,10 +48,14 @@ public:
   uint32_t bufferLimit() override;
 
 protected:
-  StreamEncoderImpl(ConnectionImpl& connection) : connection_(connection) {}
+  StreamEncoderImpl(ConnectionImpl& connection,
+                    std::chrono::milliseconds chunk_aggregation = std::chrono::milliseconds(0))
+      : connection_(connection), chunk_aggregation_(chunk_aggregation) {}
 
-  static const std::string CRLF;
   static const std::string LAST_CHUNK;
+  // Shared header values at least this large are referenced by the output buffer rather than
+  // copied into it. Below this the fragment allocations cost more than the copy.
+  static const uint32_t MinFragmentValueSize = 1024;
 
   ConnectionImpl& connection_;
 
@@ -63,12 +69,36 @@ private:
    */
   void encodeHeader(const char* key, uint32_t key_size, const char* value, uint32_t value_size);
 
+  /**
+   * Called to encode an individual header, referencing the value's storage where possible.
+   * @param key supplies the header to encode.
+   * @param key_size supplies the byte size of the key.
+   * @param value supplies the value to encode.
+   */
+  void encodeHeader(const char* key, uint32_t key_size, const HeaderString& value);
+
+  /**
+   * Called to encode body data, as a chunk if the stream is chunk encoded.
+   */
+  void encodeBody(Buffer::Instance& data);
+
+  /**
+   * Called when aggregated chunk data has been held back for as long as it may be.
+   */
+  void onChunkAggregationTimeout();
+
   /**
    * Called to finalize a stream encode.
    */
   void endEncode();
 
+  // Aggregated chunk data is sent once there is at least this much of it.
+  static const uint64_t MaxAggregatedChunkSize = 16384;
+
   bool chunk_encoding_{true};
+  const std::chrono::milliseconds chunk_aggregation_;
+  Buffer::OwnedImpl aggregated_chunk_;
+  Event::TimerPtr chunk_aggregation_timer_;
 };
 
 /**
@@ -76,7 +106,9 @@ private:
  */
 class ResponseStreamEncoderImpl : public StreamEncoderImpl {
 public:
-  ResponseStreamEncoderImpl(ConnectionImpl& connection) : StreamEncoderImpl(connection) {}
+  ResponseStreamEncoderImpl(ConnectionImpl& connection,
+                            std::chrono::milliseconds chunk_aggregation)
+      : StreamEncoderImpl(connection, chunk_aggregation) {}
 
   bool startedResponse() { return started_response_; }
 
@@ -96,17 +128,29 @@ public:
 
   bool headRequest() { return head_request_; }
 
+  /**
+   * Undo the readDisable(true) calls of the stream which are still outstanding, so that the
+   * responses pipelined behind its own can be read.
+   */
+  void unwindReadDisable();
+
   // Http::StreamEncoder
   void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
 
+  // Http::Stream
+  void readDisable(bool disable) override;
+
 private:
   bool head_request_{};
+  uint32_t read_disable_calls_{};
 };
 
 /**
  * Base class for HTTP/1.1 client and server connections.
  */
-class ConnectionImpl : public virtual Connection, protected Logger::Loggable<Logger::Id::http> {
+class ConnectionImpl : public virtual Connection,
+                       public ParserCallbacks,
+                       protected Logger::Loggable<Logger::Id::http> {
 public:
   /**
    * @return Network::Connection& the backing network connection.
@@ -131,10 +175,13 @@ public:
   void flushOutput();
 
   void addCharToBuffer(char c);
+  void addFragmentToBuffer(Buffer::BufferFragment& fragment);
+  void addHexToBuffer(uint64_t i);
   void addIntToBuffer(uint64_t i);
   Buffer::WatermarkBuffer& buffer() { return output_buffer_; }
   uint64_t bufferRemainingSize();
   void copyToBuffer(const char* data, uint64_t length);
+  void moveToBuffer(Buffer::Instance& data);
   void reserveBuffer(uint64_t size);
 
   // Http::Connection
@@ -145,19 +192,22 @@ public:
   bool wantsToWrite() override { return false; }
   void onUnderlyingConnectionAboveWriteBufferHighWatermark() override { onAboveHighWatermark(); }
   void onUnderlyingConnectionBelowWriteBufferLowWatermark() override { onBelowLowWatermark(); }
+  void shrink() override;
 
   void readDisable(bool disable) { connection_.readDisable(disable); }
   uint32_t bufferLimit() { return connection_.bufferLimit(); }
 
 protected:
-  ConnectionImpl(Network::Connection& connection, http_parser_type type);
+  ConnectionImpl(Network::Connection& connection, MessageType type, bool fast_parser);
 
   bool resetStreamCalled() { return reset_stream_called_; }
 
   Network::Connection& connection_;
-  http_parser parser_;
+  ParserPtr parser_;
   HeaderMapPtr deferred_end_stream_headers_;
   Http::Code error_code_{Http::Code::BadRequest};
+  // Set when decoded header values should be interned.
+  HeaderValueInterner* header_value_interner_{};
 
 private:
   enum class HeaderParsingState { Field, Value, Done };
@@ -174,54 +224,38 @@ private:
    */
   size_t dispatchSlice(const char* slice, size_t len);
 
+  // Http1::ParserCallbacks. onUrl(), onBody() and onMessageComplete() are implemented by the
+  // client and server connections.
+
   /**
    * Called when a request/response is beginning. A base routine happens first then a virtual
    * dispatch is invoked.
    */
-  void onMessageBeginBase();
+  void onMessageBeginBase() override;
   virtual void onMessageBegin() PURE;
 
-  /**
-   * Called when URL data is received.
-   * @param data supplies the start address.
-   * @param lenth supplies the length.
-   */
-  virtual void onUrl(const char* data, size_t length) PURE;
-
   /**
    * Called when header field data is received.
    * @param data supplies the start address.
    * @param length supplies the length.
    */
-  void onHeaderField(const char* data, size_t length);
+  void onHeaderField(const char* data, size_t length) override;
 
   /**
    * Called when header value data is received.
    * @param data supplies the start address.
    * @param length supplies the length.
    */
-  void onHeaderValue(const char* data, size_t length);
+  void onHeaderValue(const char* data, size_t length) override;
 
   /**
    * Called when headers are complete. A base routine happens first then a virtual disaptch is
    * invoked.
    * @return 0 if no error, 1 if there should be no body.
    */
-  int onHeadersCompleteBase();
+  int onHeadersCompleteBase() override;
   virtual int onHeadersComplete(HeaderMapImplPtr&& headers) PURE;
 
-  /**
-   * Called when body data is received.
-   * @param data supplies the start address.
-   * @param length supplies the length.
-   */
-  virtual void onBody(const char* data, size_t length) PURE;
-
-  /**
-   * Called when the request/response is complete.
-   */
-  virtual void onMessageComplete() PURE;
-
   /**
    * @see onResetStreamBase().
    */
@@ -244,7 +278,11 @@ private:
    */
   virtual void onBelowLowWatermark() PURE;
 
-  static http_parser_settings settings_;
+  /**
+   * Commit the bytes written into the current reservation to output_buffer_.
+   */
+  void commitReservation();
+
   static const ToLowerTable& toLowerTable();
 
   HeaderMapImplPtr current_header_map_;
@@ -271,7 +309,8 @@ private:
    * An active HTTP/1.1 request.
    */
   struct ActiveRequest {
-    ActiveRequest(ConnectionImpl& connection) : response_encoder_(connection) {}
+    ActiveRequest(ConnectionImpl& connection, std::chrono::milliseconds chunk_aggregation)
+        : response_encoder_(connection, chunk_aggregation) {}
 
     HeaderString request_url_;
     StreamDecoder* request_decoder_{};
@@ -318,9 +357,11 @@ public:
 
 private:
   struct PendingResponse {
-    PendingResponse(StreamDecoder* decoder) : decoder_(decoder) {}
+    PendingResponse(StreamDecoder* decoder, RequestStreamEncoderImpl* encoder)
+        : decoder_(decoder), encoder_(encoder) {}
 
     StreamDecoder* decoder_;
+    RequestStreamEncoderImpl* encoder_;
     bool head_request_{};
   };
 
@@ -338,7 +379,9 @@ private:
   void onAboveHighWatermark() override;
   void onBelowLowWatermark() override;
 
-  std::unique_ptr<RequestStreamEncoderImpl> request_encoder_;
+  // The encoders of the pending responses, oldest first, preceded by those of the responses which
+  // have completed since the last newStream().
+  std::list<std::unique_ptr<RequestStreamEncoderImpl>> request_encoders_;
   std::list<PendingResponse> pending_responses_;
 };
 
@@ -1,5 +1,6 @@
 #include "common/http/http1/conn_pool.h"
 
+#include <cmath>
 #include <cstdint>
 #include <list>
 
@@ -21,6 +22,9 @@ namespace Http {
 namespace Http1 {
 
 ConnPoolImpl::~ConnPoolImpl() {
+  // Closing the ready clients must not open new ones.
+  min_ready_clients_ = 0;
+
   while (!ready_clients_.empty()) {
     ready_clients_.front()->codec_client_->close();
   }
@@ -40,9 +44,8 @@ void ConnPoolImpl::addDrainedCallback(DrainedCb cb) {
 
 void ConnPoolImpl::attachRequestToClient(ActiveClient& client, StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) {
-  ASSERT(!client.stream_wrapper_);
-  client.stream_wrapper_.reset(new StreamWrapper(response_decoder, client));
-  callbacks.onPoolReady(*client.stream_wrapper_, client.real_host_description_);
+  client.stream_wrappers_.emplace_back(new StreamWrapper(response_decoder, client));
+  callbacks.onPoolReady(*client.stream_wrappers_.back(), client.real_host_description_);
 }
 
 void ConnPoolImpl::checkForDrained() {
@@ -61,14 +64,53 @@ void ConnPoolImpl::createNewConnection() {
   ENVOY_LOG(debug, "creating a new connection");
   ActiveClientPtr client(new ActiveClient(*this));
   client->moveIntoList(std::move(client), busy_clients_);
+  connecting_clients_++;
+}
+
+void ConnPoolImpl::createReadyClients() {
+  if ((min_ready_clients_ == 0 && preconnect_ratio_ <= 1) || !drained_callbacks_.empty()) {
+    return;
+  }
+
+  Upstream::ResourceManager& resource_manager = host_->cluster().resourceManager(priority_);
+  while (needsReadyClient() && resource_manager.connections().canCreate()) {
+    ENVOY_LOG(debug, "creating a ready connection");
+    createNewConnection();
+  }
+}
+
+bool ConnPoolImpl::needsReadyClient() {
+  // Connecting clients go to the pending requests first, so only the rest will be ready.
+  if (ready_clients_.size() + connecting_clients_ < min_ready_clients_ + pending_requests_.size()) {
+    return true;
+  }
+
+  // Each connected busy client serves a request.
+  const uint64_t requests = busy_clients_.size() - connecting_clients_ + pending_requests_.size();
+  return ready_clients_.size() + busy_clients_.size() <
+         static_cast<uint64_t>(std::ceil(requests * preconnect_ratio_));
 }
 
 ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_decoder,
                                                      ConnectionPool::Callbacks& callbacks) {
   if (!ready_clients_.empty()) {
-    ready_clients_.front()->moveBetweenLists(ready_clients_, busy_clients_);
-    ENVOY_CONN_LOG(debug, "using existing connection", *busy_clients_.front()->codec_client_);
-    attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks);
+    // Idle clients are pushed onto the front, so the most recently used one is reused.
+    ActiveClient& client = *ready_clients_.front();
+    client.moveBetweenLists(ready_clients_, busy_clients_);
+    if (client.idle_timer_) {
+      client.idle_timer_->disableTimer();
+    }
+    ENVOY_CONN_LOG(debug, "using existing connection", *client.codec_client_);
+    createReadyClients();
+    attachRequestToClient(client, response_decoder, callbacks);
+    return nullptr;
+  }
+
+  ActiveClient* pipeline_client = pipelineClient();
+  if (pipeline_client != nullptr) {
+    ENVOY_CONN_LOG(debug, "pipelining on existing connection", *pipeline_client->codec_client_);
+    host_->cluster().stats().upstream_rq_pipelined_.inc();
+    attachRequestToClient(*pipeline_client, response_decoder, callbacks);
     return nullptr;
   }
 
@@ -87,7 +129,14 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     ENVOY_LOG(debug, "queueing request due to no available connections");
     PendingRequestPtr pending_request(new PendingRequest(*this, response_decoder, callbacks));
     pending_request->moveIntoList(std::move(pending_request), pending_requests_);
-    return pending_requests_.front().get();
+    PendingRequest* queued = pending_requests_.front().get();
+
+    // Only open connections ahead of the requests once some have connected to the host, so that
+    // a host which is down does not get a burst of them.
+    if (busy_clients_.size() > connecting_clients_) {
+      createReadyClients();
+    }
+    return queued;
   } else {
     ENVOY_LOG(debug, "max pending requests overflow");
     callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::Overflow, nullptr);
@@ -101,10 +150,13 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
       event == Network::ConnectionEvent::LocalClose) {
     // The client died.
     ENVOY_CONN_LOG(debug, "client disconnected", *client.codec_client_);
+    if (client.idle_timer_) {
+      client.idle_timer_->disableTimer();
+    }
     ActiveClientPtr removed;
     bool check_for_drained = true;
-    if (client.stream_wrapper_) {
-      if (!client.stream_wrapper_->decode_complete_) {
+    if (!client.stream_wrappers_.empty()) {
+      if (!client.stream_wrappers_.back()->decode_complete_) {
         if (event == Network::ConnectionEvent::LocalClose) {
           host_->cluster().stats().upstream_cx_destroy_local_with_active_rq_.inc();
         }
@@ -114,8 +166,8 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
         host_->cluster().stats().upstream_cx_destroy_with_active_rq_.inc();
       }
 
-      // There is an active request attached to this client. The underlying codec client will
-      // already have "reset" the stream to fire the reset callback. All we do here is just
+      // There are active requests attached to this client. The underlying codec client will
+      // already have "reset" the streams to fire the reset callbacks. All we do here is just
       // destroy the client.
       removed = client.removeFromList(busy_clients_);
     } else if (!client.connect_timer_) {
@@ -160,6 +212,8 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
   if (client.connect_timer_) {
     client.connect_timer_->disableTimer();
     client.connect_timer_.reset();
+    ASSERT(connecting_clients_ > 0);
+    connecting_clients_--;
   }
 
   // Note that the order in this function is important. Concretely, we must destroy the connect
@@ -186,27 +240,59 @@ void ConnPoolImpl::onPendingRequestCancel(PendingRequest& request) {
 
 void ConnPoolImpl::onResponseComplete(ActiveClient& client) {
   ENVOY_CONN_LOG(debug, "response complete", *client.codec_client_);
-  if (!client.stream_wrapper_->encode_complete_) {
+  // Responses arrive in the order of the requests, so this is the oldest one. Closing the
+  // connection resets the requests pipelined behind it.
+  StreamWrapper& stream_wrapper = *client.stream_wrappers_.front();
+  if (!stream_wrapper.encode_complete_) {
     ENVOY_CONN_LOG(debug, "response before request complete", *client.codec_client_);
     onDownstreamReset(client);
-  } else if (client.stream_wrapper_->saw_close_header_ || client.codec_client_->remoteClosed()) {
+  } else if (stream_wrapper.saw_close_header_ || client.codec_client_->remoteClosed()) {
     ENVOY_CONN_LOG(debug, "saw upstream connection: close", *client.codec_client_);
     onDownstreamReset(client);
   } else if (client.remaining_requests_ > 0 && --client.remaining_requests_ == 0) {
     ENVOY_CONN_LOG(debug, "maximum requests per connection", *client.codec_client_);
     host_->cluster().stats().upstream_cx_max_requests_.inc();
     onDownstreamReset(client);
+  } else if (client.stream_wrappers_.size() > 1) {
+    // The requests pipelined behind this one keep the client busy.
+    client.stream_wrappers_.pop_front();
   } else {
     processIdleClient(client);
   }
 }
 
+ConnPoolImpl::ActiveClient* ConnPoolImpl::pipelineClient() {
+  if (max_pipelined_requests_ <= 1) {
+    return nullptr;
+  }
+
+  // The least loaded client is picked, so that a slow response holds up as few requests as
+  // possible.
+  ActiveClient* least_loaded = nullptr;
+  for (const ActiveClientPtr& client : busy_clients_) {
+    if (client->canPipeline() &&
+        (least_loaded == nullptr ||
+         client->stream_wrappers_.size() < least_loaded->stream_wrappers_.size())) {
+      least_loaded = client.get();
+    }
+  }
+  return least_loaded;
+}
+
 void ConnPoolImpl::processIdleClient(ActiveClient& client) {
-  client.stream_wrapper_.reset();
+  client.stream_wrappers_.clear();
   if (pending_requests_.empty()) {
     // There is nothing to service so just move the connection into the ready list.
     ENVOY_CONN_LOG(debug, "moving to ready", *client.codec_client_);
     client.moveBetweenLists(busy_clients_, ready_clients_);
+    if (idle_timeout_.count() > 0) {
+      if (!client.idle_timer_) {
+        client.idle_timer_ = dispatcher_.createCoarseTimer([&client]() -> void {
+          client.onIdleTimeout();
+        });
+      }
+      client.idle_timer_->enableTimer(idle_timeout_);
+    }
   } else {
     // There is work to do so bind a request to the client and move it to the busy list. Pending
     // requests are pushed onto the front, so pull from the back.
@@ -216,6 +302,8 @@ void ConnPoolImpl::processIdleClient(ActiveClient& client) {
     pending_requests_.pop_back();
   }
 
+  // The host is up, so it is a good time to top up the ready clients.
+  createReadyClients();
   checkForDrained();
 }
 
@@ -235,6 +323,13 @@ ConnPoolImpl::StreamWrapper::~StreamWrapper() {
   parent_.parent_.host_->stats().rq_active_.dec();
 }
 
+void ConnPoolImpl::StreamWrapper::encodeHeaders(const HeaderMap& headers, bool end_stream) {
+  const HeaderEntry* method = headers.Method();
+  safe_method_ = method != nullptr && (method->value() == Headers::get().MethodValues.Get.c_str() ||
+                                       method->value() == Headers::get().MethodValues.Head.c_str());
+  StreamEncoderWrapper::encodeHeaders(headers, end_stream);
+}
+
 void ConnPoolImpl::StreamWrapper::onEncodeComplete() { encode_complete_ = true; }
 
 void ConnPoolImpl::StreamWrapper::decodeHeaders(HeaderMapPtr&& headers, bool end_stream) {
@@ -302,6 +397,27 @@ ConnPoolImpl::ActiveClient::~ActiveClient() {
   parent_.host_->cluster().resourceManager(parent_.priority_).connections().dec();
 }
 
+bool ConnPoolImpl::ActiveClient::canPipeline() {
+  // Clients which are connecting or idle have no requests to pipeline behind. The host must be
+  // allowed to answer one more request, and must not be closing the connection.
+  if (connect_timer_ || stream_wrappers_.empty() ||
+      stream_wrappers_.size() >= parent_.max_pipelined_requests_ ||
+      (remaining_requests_ > 0 && stream_wrappers_.size() >= remaining_requests_) ||
+      codec_client_->remoteClosed()) {
+    return false;
+  }
+
+  // The codec sends one request at a time, and a failure of the connection resets every request
+  // on it, so all of them must be fully sent and safe to send again.
+  for (const StreamWrapperPtr& stream_wrapper : stream_wrappers_) {
+    if (!stream_wrapper->encode_complete_ || !stream_wrapper->safe_method_ ||
+        stream_wrapper->saw_close_header_) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void ConnPoolImpl::ActiveClient::onConnectTimeout() {
   // We just close the client at this point. This will result in both a timeout and a connect
   // failure and will fold into all the normal connect failure logic.
@@ -310,6 +426,12 @@ void ConnPoolImpl::ActiveClient::onConnectTimeout() {
   codec_client_->close();
 }
 
+void ConnPoolImpl::ActiveClient::onIdleTimeout() {
+  ENVOY_CONN_LOG(debug, "idle timeout", *codec_client_);
+  parent_.host_->cluster().stats().upstream_cx_idle_timeout_.inc();
+  codec_client_->close();
+}
+
 CodecClientPtr ConnPoolImplProd::createCodecClient(Upstream::Host::CreateConnectionData& data) {
   CodecClientPtr codec{new CodecClientProd(CodecClient::Type::HTTP1, std::move(data.connection_),
                                            data.host_description_)};
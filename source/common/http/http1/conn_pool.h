@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
@@ -22,15 +23,34 @@ namespace Http1 {
 
 /**
  * A connection pool implementation for HTTP/1.1 connections.
+ * Idle connections are reused most recently used first, so that a busy pool keeps using a small
+ * set of connections and the others stay idle long enough for the idle timeout to close them.
  * NOTE: The connection pool does NOT do DNS resolution. It assumes it is being given a numeric IP
  *       address. Higher layer code should handle resolving DNS on error and creating a new pool
  *       bound to a different IP address.
  */
 class ConnPoolImpl : Logger::Loggable<Logger::Id::pool>, public ConnectionPool::Instance {
 public:
+  /**
+   * @param idle_timeout supplies how long a connection may stay idle before it is closed, or 0 to
+   *        keep idle connections open.
+   * @param min_ready_clients supplies how many idle connections the pool keeps ready for new
+   *        requests, on top of the ones it opens for pending requests, once it has connected to
+   *        the host.
+   * @param preconnect_ratio supplies how many connections the pool keeps open or connecting for
+   *        each active or pending request, once it has connected to the host. Ratios of 1 or
+   *        less only open connections for requests.
+   * @param max_pipelined_requests supplies how many requests may be outstanding on a connection.
+   *        With more than 1, a request which finds no idle connection is pipelined behind the
+   *        GET and HEAD requests of the least loaded connection which allows it.
+   */
   ConnPoolImpl(Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
-               Upstream::ResourcePriority priority)
-      : dispatcher_(dispatcher), host_(host), priority_(priority) {}
+               Upstream::ResourcePriority priority, std::chrono::milliseconds idle_timeout,
+               uint32_t min_ready_clients, double preconnect_ratio,
+               uint32_t max_pipelined_requests = 1)
+      : dispatcher_(dispatcher), host_(host), priority_(priority), idle_timeout_(idle_timeout),
+        min_ready_clients_(min_ready_clients), preconnect_ratio_(preconnect_ratio),
+        max_pipelined_requests_(max_pipelined_requests) {}
 
   ~ConnPoolImpl();
 
@@ -50,6 +70,7 @@ protected:
     ~StreamWrapper();
 
     // StreamEncoderWrapper
+    void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
     void onEncodeComplete() override;
 
     // StreamDecoderWrapper
@@ -66,6 +87,9 @@ protected:
     bool encode_complete_{};
     bool saw_close_header_{};
     bool decode_complete_{};
+    // Whether the request may be sent again if the connection fails, which requests pipelined
+    // behind it would cause.
+    bool safe_method_{};
   };
 
   typedef std::unique_ptr<StreamWrapper> StreamWrapperPtr;
@@ -76,7 +100,9 @@ protected:
     ActiveClient(ConnPoolImpl& parent);
     ~ActiveClient();
 
+    bool canPipeline();
     void onConnectTimeout();
+    void onIdleTimeout();
 
     // Network::ConnectionCallbacks
     void onEvent(Network::ConnectionEvent event) override {
@@ -88,8 +114,11 @@ protected:
     ConnPoolImpl& parent_;
     CodecClientPtr codec_client_;
     Upstream::HostDescriptionConstSharedPtr real_host_description_;
-    StreamWrapperPtr stream_wrapper_;
+    // The outstanding requests, oldest first. There is more than one only when pipelining.
+    std::list<StreamWrapperPtr> stream_wrappers_;
     Event::TimerPtr connect_timer_;
+    // Only created once the client first goes idle, if the pool has an idle timeout.
+    Event::TimerPtr idle_timer_;
     Stats::TimespanPtr conn_length_;
     uint64_t remaining_requests_;
   };
@@ -116,10 +145,13 @@ protected:
   virtual CodecClientPtr createCodecClient(Upstream::Host::CreateConnectionData& data) PURE;
   void checkForDrained();
   void createNewConnection();
+  void createReadyClients();
+  bool needsReadyClient();
   void onConnectionEvent(ActiveClient& client, Network::ConnectionEvent event);
   void onDownstreamReset(ActiveClient& client);
   void onPendingRequestCancel(PendingRequest& request);
   void onResponseComplete(ActiveClient& client);
+  ActiveClient* pipelineClient();
   void processIdleClient(ActiveClient& client);
 
   Stats::TimespanPtr conn_connect_ms_;
@@ -130,6 +162,12 @@ protected:
   std::list<PendingRequestPtr> pending_requests_;
   std::list<DrainedCb> drained_callbacks_;
   Upstream::ResourcePriority priority_;
+  const std::chrono::milliseconds idle_timeout_;
+  uint32_t min_ready_clients_;
+  const double preconnect_ratio_;
+  const uint32_t max_pipelined_requests_;
+  // The clients in busy_clients_ which are still connecting.
+  uint32_t connecting_clients_{};
 };
 
 /**
@@ -138,8 +176,11 @@ protected:
 class ConnPoolImplProd : public ConnPoolImpl {
 public:
   ConnPoolImplProd(Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host,
-                   Upstream::ResourcePriority priority)
-      : ConnPoolImpl(dispatcher, host, priority) {}
+                   Upstream::ResourcePriority priority, std::chrono::milliseconds idle_timeout,
+                   uint32_t min_ready_clients, double preconnect_ratio,
+                   uint32_t max_pipelined_requests)
+      : ConnPoolImpl(dispatcher, host, priority, idle_timeout, min_ready_clients, preconnect_ratio,
+                     max_pipelined_requests) {}
 
   // ConnPoolImpl
   CodecClientPtr createCodecClient(Upstream::Host::CreateConnectionData& data) override;
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Callbacks raised by a Parser while decoding a stream of HTTP/1.x messages. The callback names
+ * and semantics mirror http_parser's, since ConnectionImpl was originally written against it.
+ */
+class ParserCallbacks {
+public:
+  virtual ~ParserCallbacks() {}
+
+  /**
+   * Called when the first byte of a message has been received.
+   */
+  virtual void onMessageBeginBase() PURE;
+
+  /**
+   * Called with request URL data. May be called multiple times per message.
+   */
+  virtual void onUrl(const char* data, size_t length) PURE;
+
+  /**
+   * Called with header name data. May be called multiple times per header.
+   */
+  virtual void onHeaderField(const char* data, size_t length) PURE;
+
+  /**
+   * Called with header value data. May be called multiple times per header, and is called at least
+   * once (possibly with zero length) for each header.
+   */
+  virtual void onHeaderValue(const char* data, size_t length) PURE;
+
+  /**
+   * Called when all headers of a message have been received.
+   * @return 0 if no error, 1 if the message has no body regardless of its framing headers.
+   */
+  virtual int onHeadersCompleteBase() PURE;
+
+  /**
+   * Called with message body data, after any transfer coding has been removed.
+   */
+  virtual void onBody(const char* data, size_t length) PURE;
+
+  /**
+   * Called when a message is complete.
+   */
+  virtual void onMessageComplete() PURE;
+};
+
+enum class MessageType { Request, Response };
+
+/**
+ * An incremental HTTP/1.x message parser.
+ */
+class Parser {
+public:
+  virtual ~Parser() {}
+
+  /**
+   * Parse a span of data. Parsing stops early if the parser is paused by a callback or an error is
+   * found.
+   * @param data supplies the start address.
+   * @param length supplies the length. A zero length span signals the end of the stream.
+   * @return the number of bytes consumed.
+   */
+  virtual size_t execute(const char* data, size_t length) PURE;
+
+  /**
+   * Stop parsing at the current position. Subsequent execute() calls consume nothing until the
+   * parser is resumed.
+   */
+  virtual void pause() PURE;
+
+  /**
+   * Undo a previous pause().
+   */
+  virtual void resume() PURE;
+
+  /**
+   * @return the name of the error that stopped parsing in http_parser's HPE_* form, or nullptr if
+   *         no error has occurred.
+   */
+  virtual const char* error() const PURE;
+
+  /**
+   * @return the request method of the current message as an http_method value.
+   */
+  virtual unsigned int method() const PURE;
+
+  /**
+   * @return the HTTP version of the current message.
+   */
+  virtual uint16_t httpMajor() const PURE;
+  virtual uint16_t httpMinor() const PURE;
+
+  /**
+   * @return the response status code of the current message.
+   */
+  virtual uint16_t statusCode() const PURE;
+
+  /**
+   * @return whether the current message uses chunked transfer encoding.
+   */
+  virtual bool chunked() const PURE;
+
+  /**
+   * @return the content-length of the current message, or ULLONG_MAX if it has none.
+   */
+  virtual uint64_t contentLength() const PURE;
+
+  /**
+   * Release the memory the parser keeps for the next message, e.g. once the connection has been
+   * idle for a while. Does nothing in the middle of a message head.
+   */
+  virtual void shrink() PURE;
+};
+
+typedef std::unique_ptr<Parser> ParserPtr;
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,778 @@
+#include "common/http/http1/parser_impl.h"
+
+#include <string.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+#include "common/common/assert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define ENVOY_HTTP1_PARSER_SSE42
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+http_parser_settings HttpParserImpl::settings_{
+    [](http_parser* parser) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onMessageBeginBase();
+      return 0;
+    },
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onUrl(at, length);
+      return 0;
+    },
+    nullptr, // on_status
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onHeaderField(at, length);
+      return 0;
+    },
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onHeaderValue(at, length);
+      return 0;
+    },
+    [](http_parser* parser) -> int {
+      return static_cast<ParserCallbacks*>(parser->data)->onHeadersCompleteBase();
+    },
+    [](http_parser* parser, const char* at, size_t length) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onBody(at, length);
+      return 0;
+    },
+    [](http_parser* parser) -> int {
+      static_cast<ParserCallbacks*>(parser->data)->onMessageComplete();
+      return 0;
+    },
+    nullptr, // on_chunk_header
+    nullptr  // on_chunk_complete
+};
+
+HttpParserImpl::HttpParserImpl(MessageType type, ParserCallbacks& callbacks) {
+  http_parser_init(&parser_, type == MessageType::Request ? HTTP_REQUEST : HTTP_RESPONSE);
+  parser_.data = &callbacks;
+}
+
+size_t HttpParserImpl::execute(const char* data, size_t length) {
+  return http_parser_execute(&parser_, &settings_, data, length);
+}
+
+const char* HttpParserImpl::error() const {
+  const http_errno error = HTTP_PARSER_ERRNO(&parser_);
+  if (error == HPE_OK || error == HPE_PAUSED) {
+    return nullptr;
+  }
+  return http_errno_name(error);
+}
+
+namespace {
+
+struct MethodName {
+  const char* name_;
+  size_t length_;
+  unsigned int method_;
+};
+
+const MethodName METHOD_NAMES[] = {
+#define METHOD_NAME(num, name, string) {#string, sizeof(#string) - 1, num},
+    HTTP_METHOD_MAP(METHOD_NAME)
+#undef METHOD_NAME
+};
+
+// Longer than the longest method name.
+const size_t MAX_METHOD_LENGTH = 16;
+
+/**
+ * Lookup table for the characters allowed in a header name (RFC 7230 tchar).
+ */
+class TokenTable {
+public:
+  TokenTable() {
+    for (int c = 0; c < 256; c++) {
+      table_[c] = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c != 0 && strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+    }
+  }
+
+  bool isToken(char c) const { return table_[static_cast<uint8_t>(c)]; }
+
+private:
+  bool table_[256];
+};
+
+const TokenTable& tokenTable() {
+  static TokenTable* table = new TokenTable();
+  return *table;
+}
+
+// Characters that end a header value: every control character but HT.
+bool isValueEnd(char c) {
+  const uint8_t u = static_cast<uint8_t>(c);
+  return (u < 0x20 && u != '\t') || u == 0x7f;
+}
+
+// Characters that end a request URL: SP and control characters.
+bool isUrlEnd(char c) {
+  const uint8_t u = static_cast<uint8_t>(c);
+  return u <= 0x20 || u == 0x7f;
+}
+
+#ifdef ENVOY_HTTP1_PARSER_SSE42
+// The same character classes as (inclusive) range pairs for PCMPESTRI. The arrays are padded to
+// 16 bytes since they are loaded as a whole.
+const char VALUE_END_RANGES[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+const int VALUE_END_RANGES_SIZE = 6;
+const char URL_END_RANGES[16] = "\x00\x20\x7f\x7f";
+const int URL_END_RANGES_SIZE = 4;
+
+bool cpuHasSse42() {
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+}
+
+/**
+ * @return the first character at or after data that falls into one of ranges, or the start of
+ *         the last partial 16 byte block if there is none.
+ */
+__attribute__((target("sse4.2"))) const char*
+findCharSse42(const char* data, const char* end, const char* ranges, int ranges_size) {
+  const __m128i ranges16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+  while (end - data >= 16) {
+    const __m128i data16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const int index = _mm_cmpestri(ranges16, ranges_size, data16, 16,
+                                   _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+    if (index != 16) {
+      return data + index;
+    }
+    data += 16;
+  }
+  return data;
+}
+#endif
+
+const char* findValueEnd(const char* data, const char* end) {
+#ifdef ENVOY_HTTP1_PARSER_SSE42
+  if (cpuHasSse42()) {
+    data = findCharSse42(data, end, VALUE_END_RANGES, VALUE_END_RANGES_SIZE);
+  }
+#endif
+  while (data != end && !isValueEnd(*data)) {
+    data++;
+  }
+  return data;
+}
+
+const char* findUrlEnd(const char* data, const char* end) {
+#ifdef ENVOY_HTTP1_PARSER_SSE42
+  if (cpuHasSse42()) {
+    data = findCharSse42(data, end, URL_END_RANGES, URL_END_RANGES_SIZE);
+  }
+#endif
+  while (data != end && !isUrlEnd(*data)) {
+    data++;
+  }
+  return data;
+}
+
+/**
+ * @return the end of the first empty line at or after data, or nullptr if there is none. Lines
+ *         may end with either CRLF or a bare LF.
+ */
+const char* findHeadEnd(const char* data, const char* end) {
+  while (true) {
+    data = static_cast<const char*>(memchr(data, '\n', end - data));
+    if (data == nullptr || ++data == end) {
+      return nullptr;
+    }
+    if (*data == '\n') {
+      return data + 1;
+    }
+    if (*data == '\r') {
+      if (data + 1 == end) {
+        return nullptr;
+      }
+      if (data[1] == '\n') {
+        return data + 2;
+      }
+    }
+  }
+}
+
+bool equalsIgnoreCase(const char* data, size_t length, const char* lower_case, size_t size) {
+  return length == size && strncasecmp(data, lower_case, size) == 0;
+}
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t'; }
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+const size_t FastParserImpl::MaxHeadSize;
+
+FastParserImpl::FastParserImpl(MessageType type, ParserCallbacks& callbacks)
+    : callbacks_(callbacks), type_(type) {
+  resetMessage();
+}
+
+size_t FastParserImpl::execute(const char* data, size_t length) {
+  if (error_ != nullptr || paused_) {
+    return 0;
+  }
+
+  if (length == 0) {
+    if (state_ == State::BodyUntilEof) {
+      onMessageComplete();
+    } else if (state_ != State::MessageStart) {
+      setError("HPE_INVALID_EOF_STATE");
+    }
+    return 0;
+  }
+
+  upgrade_ = false;
+  const char* current = data;
+  const char* const end = data + length;
+  while (current != end && !paused_) {
+    switch (state_) {
+    case State::MessageStart:
+      // Like http_parser, tolerate empty lines between messages.
+      if (*current == '\r' || *current == '\n') {
+        current++;
+        break;
+      }
+      // Like http_parser, don't begin a message that can't have a valid start line.
+      if (!validatePartialHead(current, 1)) {
+        return 0;
+      }
+      resetMessage();
+      state_ = State::Head;
+      callbacks_.onMessageBeginBase();
+      break;
+
+    case State::Head:
+      current = consumeHead(current, end);
+      break;
+
+    case State::Body: {
+      const uint64_t size = std::min<uint64_t>(remaining_, end - current);
+      callbacks_.onBody(current, size);
+      current += size;
+      remaining_ -= size;
+      if (remaining_ == 0) {
+        onMessageComplete();
+      }
+      break;
+    }
+
+    case State::BodyUntilEof:
+      callbacks_.onBody(current, end - current);
+      current = end;
+      break;
+
+    case State::Trailers:
+      current = consumeTrailers(current, end);
+      break;
+
+    default:
+      current = consumeChunked(current, end);
+      break;
+    }
+
+    if (error_ != nullptr) {
+      return 0;
+    }
+
+    // The rest of the stream after an upgrade is in a different protocol.
+    if (upgrade_) {
+      break;
+    }
+  }
+
+  return current - data;
+}
+
+void FastParserImpl::resetMessage() {
+  content_length_ = ULLONG_MAX;
+  remaining_ = 0;
+  method_ = 0;
+  http_major_ = 0;
+  http_minor_ = 0;
+  status_code_ = 0;
+  chunked_ = false;
+  upgrade_header_ = false;
+  connection_upgrade_ = false;
+  upgrade_ = false;
+}
+
+void FastParserImpl::shrink() {
+  if (head_buffer_.empty()) {
+    // clear() keeps the capacity of the largest head seen so far, which can be up to MaxHeadSize.
+    std::string().swap(head_buffer_);
+  }
+}
+
+const char* FastParserImpl::consumeHead(const char* data, const char* end) {
+  if (head_buffer_.empty()) {
+    // Fast path: the whole head is in this span and can be parsed in place.
+    const char* head_end = findHeadEnd(data, end);
+    if (head_end != nullptr) {
+      if (static_cast<size_t>(head_end - data) > MaxHeadSize) {
+        setError("HPE_HEADER_OVERFLOW");
+        return nullptr;
+      }
+      return parseHead(data, head_end) ? head_end : nullptr;
+    }
+
+    if (static_cast<size_t>(end - data) > MaxHeadSize) {
+      setError("HPE_HEADER_OVERFLOW");
+      return nullptr;
+    }
+    if (!validatePartialHead(data, end - data)) {
+      return nullptr;
+    }
+    head_buffer_.assign(data, end - data);
+    return end;
+  }
+
+  // The head started in an earlier span. The buffered part holds no complete head, so the search
+  // only needs to start far enough back to catch a terminator that straddles the two.
+  const size_t old_size = head_buffer_.size();
+  head_buffer_.append(data, end - data);
+  const char* begin = head_buffer_.data();
+  const char* head_end =
+      findHeadEnd(begin + (old_size > 2 ? old_size - 2 : 0), begin + head_buffer_.size());
+  const size_t head_size = head_end != nullptr ? head_end - begin : head_buffer_.size();
+  if (head_size > MaxHeadSize) {
+    setError("HPE_HEADER_OVERFLOW");
+    return nullptr;
+  }
+
+  if (head_end == nullptr) {
+    return validatePartialHead(begin, head_buffer_.size()) ? end : nullptr;
+  }
+
+  ASSERT(head_size > old_size);
+  const bool parsed = parseHead(begin, head_end);
+  head_buffer_.clear();
+  return parsed ? data + (head_size - old_size) : nullptr;
+}
+
+bool FastParserImpl::validatePartialHead(const char* data, size_t length) {
+  // Reject an invalid start line as soon as possible rather than waiting for a complete head.
+  if (type_ == MessageType::Response) {
+    if (strncmp(data, "HTTP/", std::min<size_t>(length, 5)) != 0) {
+      setError("HPE_INVALID_CONSTANT");
+      return false;
+    }
+    return true;
+  }
+
+  const size_t prefix_length = std::min(length, MAX_METHOD_LENGTH);
+  const char* space = static_cast<const char*>(memchr(data, ' ', prefix_length));
+  const size_t method_length = space != nullptr ? space - data : prefix_length;
+  for (const MethodName& method : METHOD_NAMES) {
+    if (space != nullptr ? method.length_ == method_length : method.length_ >= method_length) {
+      if (memcmp(method.name_, data, method_length) == 0) {
+        return true;
+      }
+    }
+  }
+
+  setError("HPE_INVALID_METHOD");
+  return false;
+}
+
+bool FastParserImpl::parseHead(const char* data, const char* end) {
+  const char* current =
+      type_ == MessageType::Request ? parseRequestLine(data, end) : parseStatusLine(data, end);
+  if (current == nullptr) {
+    return false;
+  }
+
+  current = parseHeaders(current, end);
+  if (current == nullptr) {
+    return false;
+  }
+  ASSERT(current == end);
+
+  onHeadersComplete();
+  return error_ == nullptr;
+}
+
+const char* FastParserImpl::parseRequestLine(const char* data, const char* end) {
+  const char* current = data;
+  while (current != end && *current != ' ' && *current != '\r' && *current != '\n') {
+    current++;
+  }
+
+  const size_t method_length = current - data;
+  const MethodName* method = nullptr;
+  for (const MethodName& candidate : METHOD_NAMES) {
+    if (candidate.length_ == method_length && memcmp(candidate.name_, data, method_length) == 0) {
+      method = &candidate;
+      break;
+    }
+  }
+  if (method == nullptr || current == end || *current != ' ') {
+    setError("HPE_INVALID_METHOD");
+    return nullptr;
+  }
+  method_ = method->method_;
+
+  while (*current == ' ') {
+    current++;
+  }
+  const char* url = current;
+  current = findUrlEnd(current, end);
+  if (current == url || current == end || *current != ' ') {
+    setError(current != end && (*current == '\r' || *current == '\n') ? "HPE_INVALID_VERSION"
+                                                                      : "HPE_INVALID_URL");
+    return nullptr;
+  }
+  callbacks_.onUrl(url, current - url);
+
+  while (*current == ' ') {
+    current++;
+  }
+  current = parseVersion(current, end);
+  if (current == nullptr) {
+    return nullptr;
+  }
+
+  if (*current == '\r') {
+    current++;
+  }
+  if (*current != '\n') {
+    setError("HPE_INVALID_VERSION");
+    return nullptr;
+  }
+  return current + 1;
+}
+
+const char* FastParserImpl::parseStatusLine(const char* data, const char* end) {
+  const char* current = parseVersion(data, end);
+  if (current == nullptr) {
+    return nullptr;
+  }
+  if (*current != ' ') {
+    setError("HPE_INVALID_VERSION");
+    return nullptr;
+  }
+  current++;
+
+  const char* status_start = current;
+  uint32_t status_code = 0;
+  while (current != end && *current >= '0' && *current <= '9') {
+    status_code = status_code * 10 + (*current - '0');
+    current++;
+    if (current - status_start > 3) {
+      setError("HPE_INVALID_STATUS");
+      return nullptr;
+    }
+  }
+  if (current == status_start || current == end ||
+      (*current != ' ' && *current != '\r' && *current != '\n')) {
+    setError("HPE_INVALID_STATUS");
+    return nullptr;
+  }
+  status_code_ = status_code;
+
+  // Skip the reason phrase.
+  current = static_cast<const char*>(memchr(current, '\n', end - current));
+  ASSERT(current != nullptr);
+  return current + 1;
+}
+
+const char* FastParserImpl::parseVersion(const char* data, const char* end) {
+  if (end - data < 8 || memcmp(data, "HTTP/", 5) != 0) {
+    setError("HPE_INVALID_CONSTANT");
+    return nullptr;
+  }
+  if (data[5] < '0' || data[5] > '9' || data[6] != '.' || data[7] < '0' || data[7] > '9') {
+    setError("HPE_INVALID_VERSION");
+    return nullptr;
+  }
+  http_major_ = data[5] - '0';
+  http_minor_ = data[7] - '0';
+  return data + 8;
+}
+
+const char* FastParserImpl::parseHeaders(const char* data, const char* end) {
+  const TokenTable& tokens = tokenTable();
+  const char* current = data;
+  while (true) {
+    if (*current == '\r') {
+      if (current + 1 == end || current[1] != '\n') {
+        setError("HPE_LF_EXPECTED");
+        return nullptr;
+      }
+      return current + 2;
+    }
+    if (*current == '\n') {
+      return current + 1;
+    }
+
+    // This also rejects obsolete line folding, since a continuation line starts with whitespace.
+    const char* name = current;
+    while (tokens.isToken(*current)) {
+      current++;
+    }
+    if (current == name || *current != ':') {
+      setError("HPE_INVALID_HEADER_TOKEN");
+      return nullptr;
+    }
+    const size_t name_length = current - name;
+    current++;
+
+    while (isWhitespace(*current)) {
+      current++;
+    }
+    const char* value = current;
+    current = findValueEnd(current, end);
+    const size_t value_length = current - value;
+    // The head always ends with an LF, so the value end is found before the end of the head.
+    ASSERT(current != end);
+    if (*current == '\r') {
+      current++;
+      if (*current != '\n') {
+        setError("HPE_LF_EXPECTED");
+        return nullptr;
+      }
+    } else if (*current != '\n') {
+      setError("HPE_INVALID_HEADER_TOKEN");
+      return nullptr;
+    }
+    current++;
+
+    callbacks_.onHeaderField(name, name_length);
+    callbacks_.onHeaderValue(value, value_length);
+    onFramingHeader(name, name_length, value, value_length);
+    if (error_ != nullptr) {
+      return nullptr;
+    }
+  }
+}
+
+void FastParserImpl::onFramingHeader(const char* name, size_t name_length, const char* value,
+                                     size_t value_length) {
+  // Trailing whitespace is not part of a field value (RFC 7230 section 3.2), and must not change
+  // how the message is framed, or this parser and http_parser would frame it differently.
+  while (value_length > 0 && isWhitespace(value[value_length - 1])) {
+    value_length--;
+  }
+
+  switch (name_length) {
+  case 7:
+    if (equalsIgnoreCase(name, name_length, "upgrade", 7)) {
+      upgrade_header_ = true;
+    }
+    break;
+
+  case 10:
+    if (equalsIgnoreCase(name, name_length, "connection", 10)) {
+      const char* const value_end = value + value_length;
+      while (value != value_end) {
+        while (value != value_end && (isWhitespace(*value) || *value == ',')) {
+          value++;
+        }
+        const char* token = value;
+        while (value != value_end && !isWhitespace(*value) && *value != ',') {
+          value++;
+        }
+        if (equalsIgnoreCase(token, value - token, "upgrade", 7)) {
+          connection_upgrade_ = true;
+        }
+      }
+    }
+    break;
+
+  case 14:
+    if (equalsIgnoreCase(name, name_length, "content-length", 14)) {
+      if (content_length_ != ULLONG_MAX) {
+        setError("HPE_UNEXPECTED_CONTENT_LENGTH");
+        return;
+      }
+
+      const char* const value_end = value + value_length;
+      uint64_t content_length = 0;
+      const char* digits = value;
+      while (value != value_end && *value >= '0' && *value <= '9') {
+        if (content_length > (ULLONG_MAX - 10) / 10) {
+          setError("HPE_INVALID_CONTENT_LENGTH");
+          return;
+        }
+        content_length = content_length * 10 + (*value - '0');
+        value++;
+      }
+      while (value != value_end && isWhitespace(*value)) {
+        value++;
+      }
+      if (value == digits || value != value_end) {
+        setError("HPE_INVALID_CONTENT_LENGTH");
+        return;
+      }
+      content_length_ = content_length;
+    }
+    break;
+
+  case 17:
+    if (equalsIgnoreCase(name, name_length, "transfer-encoding", 17)) {
+      chunked_ = equalsIgnoreCase(value, value_length, "chunked", 7);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+void FastParserImpl::onHeadersComplete() {
+  if (chunked_ && content_length_ != ULLONG_MAX) {
+    setError("HPE_UNEXPECTED_CONTENT_LENGTH");
+    return;
+  }
+
+  upgrade_ = (upgrade_header_ && connection_upgrade_ &&
+              (type_ == MessageType::Request || status_code_ == 101)) ||
+             (type_ == MessageType::Request && method_ == HTTP_CONNECT);
+
+  const int rc = callbacks_.onHeadersCompleteBase();
+  if (upgrade_ || rc == 1) {
+    onMessageComplete();
+  } else if (chunked_) {
+    state_ = State::ChunkSize;
+    chunk_size_valid_ = false;
+    trailer_size_ = 0;
+    trailer_line_length_ = 0;
+  } else if (content_length_ == 0) {
+    onMessageComplete();
+  } else if (content_length_ != ULLONG_MAX) {
+    state_ = State::Body;
+    remaining_ = content_length_;
+  } else if (type_ == MessageType::Request || status_code_ / 100 == 1 || status_code_ == 204 ||
+             status_code_ == 304) {
+    onMessageComplete();
+  } else {
+    state_ = State::BodyUntilEof;
+  }
+}
+
+void FastParserImpl::onMessageComplete() {
+  state_ = State::MessageStart;
+  callbacks_.onMessageComplete();
+}
+
+const char* FastParserImpl::consumeChunked(const char* data, const char* end) {
+  switch (state_) {
+  case State::ChunkSize: {
+    const int value = hexValue(*data);
+    if (value >= 0) {
+      if (remaining_ > (ULLONG_MAX >> 4)) {
+        setError("HPE_INVALID_CONTENT_LENGTH");
+        return nullptr;
+      }
+      remaining_ = (remaining_ << 4) | value;
+      chunk_size_valid_ = true;
+      return data + 1;
+    }
+    if (!chunk_size_valid_) {
+      setError("HPE_INVALID_CHUNK_SIZE");
+      return nullptr;
+    }
+    if (*data == ';' || isWhitespace(*data)) {
+      state_ = State::ChunkExtension;
+    } else if (*data == '\r') {
+      state_ = State::ChunkSizeLf;
+    } else if (*data == '\n') {
+      state_ = remaining_ == 0 ? State::Trailers : State::ChunkData;
+    } else {
+      setError("HPE_INVALID_CHUNK_SIZE");
+      return nullptr;
+    }
+    break;
+  }
+
+  case State::ChunkExtension: {
+    const char* lf = static_cast<const char*>(memchr(data, '\n', end - data));
+    if (lf == nullptr) {
+      return end;
+    }
+    state_ = remaining_ == 0 ? State::Trailers : State::ChunkData;
+    return lf + 1;
+  }
+
+  case State::ChunkSizeLf:
+    if (*data != '\n') {
+      setError("HPE_LF_EXPECTED");
+      return nullptr;
+    }
+    state_ = remaining_ == 0 ? State::Trailers : State::ChunkData;
+    break;
+
+  case State::ChunkData: {
+    const uint64_t size = std::min<uint64_t>(remaining_, end - data);
+    callbacks_.onBody(data, size);
+    remaining_ -= size;
+    if (remaining_ == 0) {
+      state_ = State::ChunkDataCr;
+    }
+    return data + size;
+  }
+
+  case State::ChunkDataCr:
+  case State::ChunkDataLf:
+    if (*data == '\r' && state_ == State::ChunkDataCr) {
+      state_ = State::ChunkDataLf;
+    } else if (*data == '\n') {
+      state_ = State::ChunkSize;
+      chunk_size_valid_ = false;
+    } else {
+      setError("HPE_LF_EXPECTED");
+      return nullptr;
+    }
+    break;
+
+  default:
+    NOT_REACHED;
+  }
+
+  return data + 1;
+}
+
+const char* FastParserImpl::consumeTrailers(const char* data, const char* end) {
+  // Trailers are not surfaced, so just find the empty line that ends them.
+  for (const char* current = data; current != end; current++) {
+    if (++trailer_size_ > MaxHeadSize) {
+      setError("HPE_HEADER_OVERFLOW");
+      return nullptr;
+    }
+    if (*current == '\n') {
+      if (trailer_line_length_ == 0) {
+        onMessageComplete();
+        return current + 1;
+      }
+      trailer_line_length_ = 0;
+    } else if (*current != '\r') {
+      trailer_line_length_++;
+    }
+  }
+  return end;
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/http/http1/parser.h"
+
+#include "http_parser.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Parser backed by the byte at a time http_parser state machine.
+ */
+class HttpParserImpl : public Parser {
+public:
+  HttpParserImpl(MessageType type, ParserCallbacks& callbacks);
+
+  // Http1::Parser
+  size_t execute(const char* data, size_t length) override;
+  void pause() override { http_parser_pause(&parser_, 1); }
+  void resume() override { http_parser_pause(&parser_, 0); }
+  const char* error() const override;
+  unsigned int method() const override { return parser_.method; }
+  uint16_t httpMajor() const override { return parser_.http_major; }
+  uint16_t httpMinor() const override { return parser_.http_minor; }
+  uint16_t statusCode() const override { return parser_.status_code; }
+  bool chunked() const override { return parser_.flags & F_CHUNKED; }
+  uint64_t contentLength() const override { return parser_.content_length; }
+  void shrink() override {}
+
+private:
+  static http_parser_settings settings_;
+
+  http_parser parser_;
+};
+
+/**
+ * Parser which buffers the message head until it is complete and then decodes it in a single
+ * pass, picohttpparser style. Line ends and invalid characters in header values are found 16
+ * bytes at a time with SSE4.2 when the CPU supports it. Bodies are passed through without
+ * buffering.
+ *
+ * Each URL, header name and header value is delivered with a single callback. Callbacks and error
+ * names otherwise follow http_parser so that the two are interchangeable under ConnectionImpl,
+ * with two differences: obsolete header line folding is rejected (as RFC 7230 allows), and
+ * HTTP/0.9 request lines without a version are not supported.
+ */
+class FastParserImpl : public Parser {
+public:
+  FastParserImpl(MessageType type, ParserCallbacks& callbacks);
+
+  // Matches http_parser's HTTP_MAX_HEADER_SIZE.
+  static const size_t MaxHeadSize = 80 * 1024;
+
+  // Http1::Parser
+  size_t execute(const char* data, size_t length) override;
+  void pause() override { paused_ = true; }
+  void resume() override { paused_ = false; }
+  const char* error() const override { return error_; }
+  unsigned int method() const override { return method_; }
+  uint16_t httpMajor() const override { return http_major_; }
+  uint16_t httpMinor() const override { return http_minor_; }
+  uint16_t statusCode() const override { return status_code_; }
+  bool chunked() const override { return chunked_; }
+  uint64_t contentLength() const override { return content_length_; }
+  void shrink() override;
+
+private:
+  enum class State {
+    MessageStart,
+    Head,
+    Body,
+    BodyUntilEof,
+    ChunkSize,
+    ChunkExtension,
+    ChunkSizeLf,
+    ChunkData,
+    ChunkDataCr,
+    ChunkDataLf,
+    Trailers
+  };
+
+  const char* consumeHead(const char* data, const char* end);
+  bool parseHead(const char* data, const char* end);
+  const char* parseRequestLine(const char* data, const char* end);
+  const char* parseStatusLine(const char* data, const char* end);
+  const char* parseVersion(const char* data, const char* end);
+  const char* parseHeaders(const char* data, const char* end);
+  void onFramingHeader(const char* name, size_t name_length, const char* value,
+                       size_t value_length);
+  void onHeadersComplete();
+  void onMessageComplete();
+  void resetMessage();
+  const char* consumeChunked(const char* data, const char* end);
+  const char* consumeTrailers(const char* data, const char* end);
+  bool validatePartialHead(const char* data, size_t length);
+  void setError(const char* error) { error_ = error; }
+
+  ParserCallbacks& callbacks_;
+  const MessageType type_;
+  State state_{State::MessageStart};
+  // Holds a message head that has been received across several execute() calls.
+  std::string head_buffer_;
+  const char* error_{};
+  uint64_t content_length_{};
+  uint64_t remaining_{};
+  size_t trailer_size_{};
+  uint32_t trailer_line_length_{};
+  unsigned int method_{};
+  uint16_t http_major_{};
+  uint16_t http_minor_{};
+  uint16_t status_code_{};
+  bool paused_{};
+  bool chunked_{};
+  bool chunk_size_valid_{};
+  bool upgrade_header_{};
+  bool connection_upgrade_{};
+  bool upgrade_{};
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
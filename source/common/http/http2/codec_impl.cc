@@ -1,6 +1,8 @@
 #include "common/http/http2/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -37,6 +39,9 @@ bool Utility::reconstituteCrumbledCookies(const HeaderString& key, const HeaderS
   return true;
 }
 
+const uint32_t ConnectionImpl::AdaptiveHpackWindowBlocks;
+const uint8_t ConnectionImpl::BdpPingData[8] = {'e', 'n', 'v', 'o', 'y', 'b', 'd', 'p'};
+
 ConnectionImpl::Http2Callbacks ConnectionImpl::http2_callbacks_;
 ConnectionImpl::Http2Options ConnectionImpl::http2_options_;
 const std::unique_ptr<const Http::HeaderMap> ConnectionImpl::CONTINUE_HEADER{
@@ -220,9 +225,8 @@ int ConnectionImpl::StreamImpl::onDataSourceSend(const uint8_t* framehd, size_t
   // https://nghttp2.org/documentation/types.html#c.nghttp2_send_data_callback
   static const uint64_t FRAME_HEADER_SIZE = 9;
 
-  Buffer::OwnedImpl output(framehd, FRAME_HEADER_SIZE);
-  output.move(pending_send_data_, length);
-  parent_.connection_.write(output);
+  parent_.output_buffer_.add(framehd, FRAME_HEADER_SIZE);
+  parent_.output_buffer_.move(pending_send_data_, length);
   return 0;
 }
 
@@ -329,9 +333,65 @@ int ConnectionImpl::onData(int32_t stream_id, const uint8_t* data, size_t len) {
   } else {
     stream->unconsumed_bytes_ += len;
   }
+
+  if (max_adaptive_window_size_ > stream_window_size_) {
+    onBdpData(len);
+  }
   return 0;
 }
 
+void ConnectionImpl::onBdpData(size_t len) {
+  // The data received between sending a ping and receiving its ack is what the peer could send in
+  // one round trip, i.e. the bandwidth-delay product, bounded by the windows it was sent under.
+  // Timing the ping is therefore not needed.
+  if (bdp_ping_outstanding_) {
+    bdp_bytes_ += len;
+    return;
+  }
+
+  int rc = nghttp2_submit_ping(session_, NGHTTP2_FLAG_NONE, BdpPingData);
+  ASSERT(rc == 0);
+  UNREFERENCED_PARAMETER(rc);
+  bdp_ping_outstanding_ = true;
+  bdp_bytes_ = 0;
+}
+
+void ConnectionImpl::onBdpPingAck() {
+  bdp_ping_outstanding_ = false;
+
+  // Grow the windows once a round trip carries more than 2/3 of the stream window, since the peer
+  // is then likely to be held back by it. They grow to twice the estimate, so that the estimate can
+  // keep growing, up to the configured maximum.
+  if (bdp_bytes_ * 3 < static_cast<uint64_t>(stream_window_size_) * 2) {
+    return;
+  }
+
+  const uint32_t window_size = static_cast<uint32_t>(
+      std::min<uint64_t>(bdp_bytes_ * 2, max_adaptive_window_size_));
+  if (window_size <= stream_window_size_) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "growing window size to {} for a BDP estimate of {}", connection_,
+                 window_size, bdp_bytes_);
+  stream_window_size_ = window_size;
+  // The buffers of new streams match their window, as at startup. Open streams keep their buffer
+  // limit, so their window merely lets the peer fill it sooner.
+  per_stream_buffer_limit_ = window_size;
+  nghttp2_settings_entry iv = {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, window_size};
+  int rc = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, &iv, 1);
+  ASSERT(rc == 0);
+
+  if (connection_window_size_ < window_size) {
+    rc = nghttp2_submit_window_update(session_, NGHTTP2_FLAG_NONE, 0,
+                                      window_size - connection_window_size_);
+    ASSERT(rc == 0);
+    connection_window_size_ = window_size;
+  }
+  UNREFERENCED_PARAMETER(rc);
+  stats_.window_grown_.inc();
+}
+
 void ConnectionImpl::goAway() {
   int rc = nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE,
                                  nghttp2_session_get_last_proc_stream_id(session_),
@@ -350,9 +410,55 @@ void ConnectionImpl::shutdownNotice() {
   sendPendingFrames();
 }
 
+void ConnectionImpl::onBeginFrame(const nghttp2_frame_hd* hd) {
+  if (hd->type == NGHTTP2_HEADERS || hd->type == NGHTTP2_CONTINUATION) {
+    stats_.header_block_bytes_rx_.add(hd->length);
+    hpack_window_.block_bytes_ += hd->length;
+  }
+}
+
+void ConnectionImpl::onHeaderBlockReceived() {
+  // A decoder table that stays nearly full means that new entries are evicting old ones.
+  const size_t table_size = nghttp2_session_get_hd_inflate_dynamic_table_size(session_);
+  const bool table_full = hpack_table_size_ > 0 && table_size >= hpack_table_size_ / 4 * 3;
+  if (table_full) {
+    stats_.hpack_table_full_rx_.inc();
+  }
+
+  if (max_adaptive_hpack_table_size_ <= hpack_table_size_) {
+    return;
+  }
+
+  hpack_window_.full_blocks_ += table_full;
+  if (++hpack_window_.blocks_ < AdaptiveHpackWindowBlocks) {
+    return;
+  }
+
+  // Grow the table if it was full for most of the window and headers compressed by less than 4:1,
+  // i.e. the peer kept sending literals that did not fit in the table. This only helps peers whose
+  // encoder is willing to use a larger table.
+  if (hpack_window_.full_blocks_ * 2 >= hpack_window_.blocks_ &&
+      hpack_window_.block_bytes_ * 4 > hpack_window_.header_bytes_) {
+    hpack_table_size_ = std::min(std::max(hpack_table_size_ * 2, hpack_table_size_ + 1),
+                                 max_adaptive_hpack_table_size_);
+    ENVOY_CONN_LOG(debug, "growing HPACK table size to {}", connection_, hpack_table_size_);
+    nghttp2_settings_entry iv = {NGHTTP2_SETTINGS_HEADER_TABLE_SIZE, hpack_table_size_};
+    int rc = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, &iv, 1);
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+    stats_.hpack_table_grown_.inc();
+  }
+
+  hpack_window_ = HpackWindow();
+}
+
 int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
   ENVOY_CONN_LOG(trace, "recv frame type={}", connection_, static_cast<uint64_t>(frame->hd.type));
 
+  if (frame->hd.type == NGHTTP2_HEADERS) {
+    onHeaderBlockReceived();
+  }
+
   // Only raise GOAWAY once, since we don't currently expose stream information. Shutdown
   // notifications are the same as a normal GOAWAY.
   if (frame->hd.type == NGHTTP2_GOAWAY && !raised_goaway_) {
@@ -362,6 +468,13 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
     return 0;
   }
 
+  if (frame->hd.type == NGHTTP2_PING && (frame->hd.flags & NGHTTP2_FLAG_ACK) &&
+      bdp_ping_outstanding_ &&
+      memcmp(frame->ping.opaque_data, BdpPingData, sizeof(BdpPingData)) == 0) {
+    onBdpPingAck();
+    return 0;
+  }
+
   StreamImpl* stream = getStream(frame->hd.stream_id);
   if (!stream) {
     return 0;
@@ -479,7 +592,16 @@ int ConnectionImpl::onFrameSend(const nghttp2_frame* frame) {
     break;
   }
 
-  case NGHTTP2_HEADERS:
+  case NGHTTP2_HEADERS: {
+    uint64_t header_bytes = 0;
+    for (size_t i = 0; i < frame->headers.nvlen; i++) {
+      header_bytes += frame->headers.nva[i].namelen + frame->headers.nva[i].valuelen;
+    }
+    stats_.header_bytes_tx_.add(header_bytes);
+    stats_.header_block_bytes_tx_.add(frame->hd.length);
+    FALLTHRU;
+  }
+
   case NGHTTP2_DATA: {
     StreamImpl* stream = getStream(frame->hd.stream_id);
     stream->local_end_stream_sent_ = frame->hd.flags & NGHTTP2_FLAG_END_STREAM;
@@ -505,8 +627,7 @@ int ConnectionImpl::onInvalidFrame(int error_code) {
 
 ssize_t ConnectionImpl::onSend(const uint8_t* data, size_t length) {
   ENVOY_CONN_LOG(trace, "send data: bytes={}", connection_, length);
-  Buffer::OwnedImpl buffer(data, length);
-  connection_.write(buffer);
+  output_buffer_.add(data, length);
   return length;
 }
 
@@ -563,7 +684,17 @@ void ConnectionImpl::sendPendingFrames() {
     return;
   }
 
+  // nghttp2 hands over the frames one at a time. They are gathered in the output buffer, DATA
+  // payloads by moving the slices of the stream's pending data, so that the connection and its
+  // write filters see one write per send rather than one per frame.
   int rc = nghttp2_session_send(session_);
+  if (output_buffer_.length() > 0) {
+    // Writing may call back into the codec and send more frames, so the frames are written from a
+    // buffer of their own.
+    Buffer::OwnedImpl output;
+    output.move(output_buffer_);
+    connection_.write(output);
+  }
   if (rc != 0) {
     ASSERT(rc == NGHTTP2_ERR_CALLBACK_FAILURE);
     throw CodecProtocolException(fmt::format("{}", nghttp2_strerror(rc)));
@@ -672,6 +803,12 @@ ConnectionImpl::Http2Callbacks::Http2Callbacks() {
         return static_cast<StreamImpl*>(source->ptr)->onDataSourceSend(framehd, length);
       });
 
+  nghttp2_session_callbacks_set_on_begin_frame_callback(
+      callbacks_, [](nghttp2_session*, const nghttp2_frame_hd* hd, void* user_data) -> int {
+        static_cast<ConnectionImpl*>(user_data)->onBeginFrame(hd);
+        return 0;
+      });
+
   nghttp2_session_callbacks_set_on_begin_headers_callback(
       callbacks_, [](nghttp2_session*, const nghttp2_frame* frame, void* user_data) -> int {
         return static_cast<ConnectionImpl*>(user_data)->onBeginHeaders(frame);
@@ -682,13 +819,19 @@ ConnectionImpl::Http2Callbacks::Http2Callbacks() {
       [](nghttp2_session*, const nghttp2_frame* frame, const uint8_t* raw_name, size_t name_length,
          const uint8_t* raw_value, size_t value_length, uint8_t, void* user_data) -> int {
 
-        // TODO PERF: Can reference count here to avoid copies.
+        ConnectionImpl* connection = static_cast<ConnectionImpl*>(user_data);
+        connection->stats_.header_bytes_rx_.add(name_length + value_length);
+        connection->hpack_window_.header_bytes_ += name_length + value_length;
         HeaderString name;
         name.setCopy(reinterpret_cast<const char*>(raw_name), name_length);
         HeaderString value;
-        value.setCopy(reinterpret_cast<const char*>(raw_value), value_length);
-        return static_cast<ConnectionImpl*>(user_data)->onHeader(frame, std::move(name),
-                                                                 std::move(value));
+        if (connection->header_value_interner_ != nullptr) {
+          connection->header_value_interner_->setValue(
+              value, reinterpret_cast<const char*>(raw_value), value_length);
+        } else {
+          value.setCopy(reinterpret_cast<const char*>(raw_value), value_length);
+        }
+        return connection->onHeader(frame, std::move(name), std::move(value));
       });
 
   nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
@@ -730,7 +873,7 @@ ConnectionImpl::Http2Callbacks::Http2Callbacks() {
 
 ConnectionImpl::Http2Callbacks::~Http2Callbacks() { nghttp2_session_callbacks_del(callbacks_); }
 
-ConnectionImpl::Http2Options::Http2Options() {
+ConnectionImpl::Http2Options::Http2Options(uint32_t max_deflate_table_size) {
   nghttp2_option_new(&options_);
   // Currently we do not do anything with stream priority. Setting the following option prevents
   // nghttp2 from keeping around closed streams for use during stream priority dependency graph
@@ -738,16 +881,30 @@ ConnectionImpl::Http2Options::Http2Options() {
   // of kept alive HTTP/2 connections.
   nghttp2_option_set_no_closed_streams(options_, 1);
   nghttp2_option_set_no_auto_window_update(options_, 1);
+  if (max_deflate_table_size != Http2Settings::DEFAULT_HPACK_TABLE_SIZE) {
+    nghttp2_option_set_max_deflate_dynamic_table_size(options_, max_deflate_table_size);
+  }
 }
 
 ConnectionImpl::Http2Options::~Http2Options() { nghttp2_option_del(options_); }
 
+template <class SessionNew>
+void ConnectionImpl::newSession(SessionNew session_new, const Http2Settings& http2_settings) {
+  if (http2_settings.max_adaptive_hpack_table_size_ > Http2Settings::DEFAULT_HPACK_TABLE_SIZE) {
+    // Let our encoder use as large a table as the peer grows its own to. nghttp2 copies the
+    // options into the session, so they need not outlive it.
+    Http2Options options(http2_settings.max_adaptive_hpack_table_size_);
+    session_new(&session_, http2_callbacks_.callbacks(), base(), options.options());
+  } else {
+    session_new(&session_, http2_callbacks_.callbacks(), base(), http2_options_.options());
+  }
+}
+
 ClientConnectionImpl::ClientConnectionImpl(Network::Connection& connection,
                                            Http::ConnectionCallbacks& callbacks,
                                            Stats::Scope& stats, const Http2Settings& http2_settings)
     : ConnectionImpl(connection, stats, http2_settings), callbacks_(callbacks) {
-  nghttp2_session_client_new2(&session_, http2_callbacks_.callbacks(), base(),
-                              http2_options_.options());
+  newSession(nghttp2_session_client_new2, http2_settings);
   sendSettings(http2_settings, true);
 }
 
@@ -790,8 +947,7 @@ ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            Http::ServerConnectionCallbacks& callbacks,
                                            Stats::Scope& scope, const Http2Settings& http2_settings)
     : ConnectionImpl(connection, scope, http2_settings), callbacks_(callbacks) {
-  nghttp2_session_server_new2(&session_, http2_callbacks_.callbacks(), base(),
-                              http2_options_.options());
+  newSession(nghttp2_session_server_new2, http2_settings);
   sendSettings(http2_settings, false);
 }
 
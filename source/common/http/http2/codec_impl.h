@@ -19,6 +19,7 @@
 #include "common/common/logger.h"
 #include "common/http/codec_helper.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/header_value_interner.h"
 
 #include "nghttp2/nghttp2.h"
 
@@ -41,7 +42,14 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
   COUNTER(tx_reset)                                                                                \
   COUNTER(header_overflow)                                                                         \
   COUNTER(trailers)                                                                                \
-  COUNTER(headers_cb_no_stream)
+  COUNTER(headers_cb_no_stream)                                                                    \
+  COUNTER(header_bytes_rx)                                                                         \
+  COUNTER(header_block_bytes_rx)                                                                   \
+  COUNTER(header_bytes_tx)                                                                         \
+  COUNTER(header_block_bytes_tx)                                                                   \
+  COUNTER(hpack_table_full_rx)                                                                     \
+  COUNTER(hpack_table_grown)                                                                       \
+  COUNTER(window_grown)
 // clang-format on
 
 /**
@@ -73,8 +81,17 @@ public:
                  const Http2Settings& http2_settings)
       : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."))},
         connection_(connection),
-        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_), dispatching_(false),
-        raised_goaway_(false), pending_deferred_reset_(false) {}
+        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_),
+        hpack_table_size_(http2_settings.hpack_table_size_),
+        max_adaptive_hpack_table_size_(http2_settings.max_adaptive_hpack_table_size_),
+        stream_window_size_(http2_settings.initial_stream_window_size_),
+        connection_window_size_(http2_settings.initial_connection_window_size_),
+        max_adaptive_window_size_(http2_settings.max_adaptive_window_size_),
+        header_value_interner_(http2_settings.intern_header_values_
+                                   ? &HeaderValueInterner::threadLocal()
+                                   : nullptr),
+        dispatching_(false),
+        raised_goaway_(false), pending_deferred_reset_(false), bdp_ping_outstanding_(false) {}
 
   ~ConnectionImpl();
 
@@ -95,6 +112,9 @@ public:
       stream->runLowWatermarkCallbacks();
     }
   }
+  // The buffers of an HTTP/2 connection belong to its streams, and nghttp2 has no way to compact
+  // the state of a session, so there is nothing to release.
+  void shrink() override {}
 
 protected:
   /**
@@ -116,7 +136,7 @@ protected:
    */
   class Http2Options {
   public:
-    Http2Options();
+    Http2Options(uint32_t max_deflate_table_size = Http2Settings::DEFAULT_HPACK_TABLE_SIZE);
     ~Http2Options();
 
     const nghttp2_option* options() { return options_; }
@@ -232,6 +252,8 @@ protected:
   int saveHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value);
   void sendPendingFrames();
   void sendSettings(const Http2Settings& http2_settings, bool disable_push);
+  template <class SessionNew>
+  void newSession(SessionNew session_new, const Http2Settings& http2_settings);
 
   static Http2Callbacks http2_callbacks_;
   static Http2Options http2_options_;
@@ -240,24 +262,61 @@ protected:
   nghttp2_session* session_{};
   CodecStats stats_;
   Network::Connection& connection_;
+  // Frames serialized by nghttp2 during one send, written to the connection together.
+  Buffer::OwnedImpl output_buffer_;
   uint32_t per_stream_buffer_limit_;
+  // The HPACK table size most recently advertised to the peer.
+  uint32_t hpack_table_size_;
+  const uint32_t max_adaptive_hpack_table_size_;
+  // The receive windows most recently advertised to the peer.
+  uint32_t stream_window_size_;
+  uint32_t connection_window_size_;
+  const uint32_t max_adaptive_window_size_;
+  // Set when decoded header values should be interned.
+  HeaderValueInterner* const header_value_interner_;
+
+  // Number of received header blocks over which adaptive HPACK table sizing decides whether to
+  // grow the table.
+  static const uint32_t AdaptiveHpackWindowBlocks = 64;
 
 private:
   virtual ConnectionCallbacks& callbacks() PURE;
   virtual int onBeginHeaders(const nghttp2_frame* frame) PURE;
+  void onBeginFrame(const nghttp2_frame_hd* hd);
   int onData(int32_t stream_id, const uint8_t* data, size_t len);
   int onFrameReceived(const nghttp2_frame* frame);
   int onFrameSend(const nghttp2_frame* frame);
   virtual int onHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value) PURE;
+  void onHeaderBlockReceived();
+  void onBdpData(size_t len);
+  void onBdpPingAck();
   int onInvalidFrame(int error_code);
   ssize_t onSend(const uint8_t* data, size_t length);
   int onStreamClose(int32_t stream_id, uint32_t error_code);
 
   static const std::unique_ptr<const Http::HeaderMap> CONTINUE_HEADER;
 
+  /**
+   * Header compression of the header blocks received since adaptive sizing last made a decision.
+   */
+  struct HpackWindow {
+    uint64_t block_bytes_{};
+    uint64_t header_bytes_{};
+    uint32_t blocks_{};
+    uint32_t full_blocks_{};
+  };
+
+  HpackWindow hpack_window_;
+  // Bytes of data received since the outstanding BDP ping was sent.
+  uint64_t bdp_bytes_{};
+
+  // Opaque data of the pings sent to estimate the bandwidth-delay product.
+  static const uint8_t BdpPingData[8];
+
   bool dispatching_ : 1;
   bool raised_goaway_ : 1;
   bool pending_deferred_reset_ : 1;
+  bool bdp_ping_outstanding_ : 1;
 };
 
 /**
@@ -0,0 +1,346 @@
+#include "common/http/http2/shared_conn_pool.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+SharedConnPoolImpl::SharedConnPoolImpl(Event::Dispatcher& dispatcher,
+                                       Event::Dispatcher& owner_dispatcher,
+                                       OwnerPoolCb owner_pool_cb)
+    : dispatcher_(dispatcher), owner_dispatcher_(owner_dispatcher), owner_pool_cb_(owner_pool_cb) {
+}
+
+SharedConnPoolImpl::~SharedConnPoolImpl() {
+  while (!streams_.empty()) {
+    streams_.front()->terminate();
+  }
+
+  // Make sure all streams are destroyed before we are destroyed.
+  dispatcher_.clearDeferredDeleteList();
+}
+
+void SharedConnPoolImpl::addDrainedCallback(DrainedCb cb) {
+  drained_callbacks_.push_back(cb);
+  checkForDrained();
+}
+
+void SharedConnPoolImpl::checkForDrained() {
+  if (drained_callbacks_.empty() || !streams_.empty()) {
+    return;
+  }
+
+  ENVOY_LOG(debug, "invoking drained callbacks");
+  for (const DrainedCb& cb : drained_callbacks_) {
+    cb();
+  }
+}
+
+ConnectionPool::Cancellable* SharedConnPoolImpl::newStream(Http::StreamDecoder& response_decoder,
+                                                           ConnectionPool::Callbacks& callbacks) {
+  ENVOY_LOG(debug, "placing stream on the owner's pool");
+  LocalStreamPtr stream(new LocalStream(*this, response_decoder, callbacks));
+  stream->moveIntoList(std::move(stream), streams_);
+  LocalStream& local = *streams_.front();
+
+  // The owner's pool may only be used on its thread, so the stream is always pending until the
+  // owner has placed it.
+  StreamLinkSharedPtr link = local.link_;
+  Event::Dispatcher* dispatcher = &dispatcher_;
+  Event::Dispatcher* owner_dispatcher = &owner_dispatcher_;
+  OwnerPoolCb owner_pool_cb = owner_pool_cb_;
+  owner_dispatcher_.post([link, dispatcher, owner_dispatcher, owner_pool_cb]() -> void {
+    OwnerStream* owner = new OwnerStream(*dispatcher, *owner_dispatcher, link);
+    owner->start(owner_pool_cb());
+  });
+
+  return &local;
+}
+
+SharedConnPoolImpl::LocalStream::LocalStream(SharedConnPoolImpl& parent,
+                                             StreamDecoder& response_decoder,
+                                             ConnectionPool::Callbacks& callbacks)
+    : parent_(parent), link_(std::make_shared<StreamLink>()), response_decoder_(response_decoder),
+      pool_callbacks_(callbacks) {
+  link_->local_ = this;
+}
+
+void SharedConnPoolImpl::LocalStream::done() {
+  link_->local_ = nullptr;
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.streams_));
+  parent_.checkForDrained();
+}
+
+void SharedConnPoolImpl::LocalStream::postToOwner(std::function<void(OwnerStream&)> cb) {
+  StreamLinkSharedPtr link = link_;
+  parent_.owner_dispatcher_.post([link, cb]() -> void {
+    if (link->owner_ != nullptr) {
+      cb(*link->owner_);
+    }
+  });
+}
+
+void SharedConnPoolImpl::LocalStream::terminate() {
+  if (ready_) {
+    resetStream(StreamResetReason::ConnectionTermination);
+  } else {
+    // As when a connection fails, a stream which is still pending fails.
+    postToOwner([](OwnerStream& owner) -> void { owner.cancel(); });
+    pool_callbacks_.onPoolFailure(ConnectionPool::PoolFailureReason::ConnectionFailure, nullptr);
+    done();
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::onPoolReady(Upstream::HostDescriptionConstSharedPtr host,
+                                                  uint32_t buffer_limit) {
+  ready_ = true;
+  buffer_limit_ = buffer_limit;
+  pool_callbacks_.onPoolReady(*this, host);
+}
+
+void SharedConnPoolImpl::LocalStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                    Upstream::HostDescriptionConstSharedPtr host) {
+  pool_callbacks_.onPoolFailure(reason, host);
+  done();
+}
+
+void SharedConnPoolImpl::LocalStream::onRemoteReset(StreamResetReason reason) {
+  runResetCallbacks(reason);
+  done();
+}
+
+void SharedConnPoolImpl::LocalStream::onRemoteComplete() {
+  remote_complete_ = true;
+  if (local_end_stream_) {
+    done();
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::onResponseHeaders(HeaderMapPtr&& headers, bool end_stream) {
+  response_decoder_.decodeHeaders(std::move(headers), end_stream);
+  // The response may have reset the stream.
+  if (end_stream && link_->local_ != nullptr) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::onResponseData(Buffer::Instance& data, bool end_stream) {
+  response_decoder_.decodeData(data, end_stream);
+  if (end_stream && link_->local_ != nullptr) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::onResponseTrailers(HeaderMapPtr&& trailers) {
+  response_decoder_.decodeTrailers(std::move(trailers));
+  if (link_->local_ != nullptr) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::encodeHeaders(const HeaderMap& headers, bool end_stream) {
+  std::shared_ptr<HeaderMapImpl> owner_headers = std::make_shared<HeaderMapImpl>(headers);
+  postToOwner([owner_headers, end_stream](OwnerStream& owner) -> void {
+    owner.encoder_->encodeHeaders(*owner_headers, end_stream);
+    if (end_stream) {
+      owner.onLocalComplete();
+    }
+  });
+
+  if (end_stream) {
+    local_end_stream_ = true;
+    if (remote_complete_) {
+      done();
+    }
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  std::shared_ptr<Buffer::OwnedImpl> owner_data = std::make_shared<Buffer::OwnedImpl>();
+  owner_data->move(data);
+  postToOwner([owner_data, end_stream](OwnerStream& owner) -> void {
+    owner.encoder_->encodeData(*owner_data, end_stream);
+    if (end_stream) {
+      owner.onLocalComplete();
+    }
+  });
+
+  if (end_stream) {
+    local_end_stream_ = true;
+    if (remote_complete_) {
+      done();
+    }
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::encodeTrailers(const HeaderMap& trailers) {
+  std::shared_ptr<HeaderMapImpl> owner_trailers = std::make_shared<HeaderMapImpl>(trailers);
+  postToOwner([owner_trailers](OwnerStream& owner) -> void {
+    owner.encoder_->encodeTrailers(*owner_trailers);
+    owner.onLocalComplete();
+  });
+
+  local_end_stream_ = true;
+  if (remote_complete_) {
+    done();
+  }
+}
+
+void SharedConnPoolImpl::LocalStream::resetStream(StreamResetReason reason) {
+  postToOwner([](OwnerStream& owner) -> void { owner.cancel(); });
+  // As with the codecs, resetting the stream raises the reset callbacks right away.
+  runResetCallbacks(reason);
+  done();
+}
+
+void SharedConnPoolImpl::LocalStream::readDisable(bool disable) {
+  postToOwner([disable](OwnerStream& owner) -> void {
+    owner.encoder_->getStream().readDisable(disable);
+  });
+}
+
+void SharedConnPoolImpl::LocalStream::cancel() {
+  ASSERT(!ready_);
+  postToOwner([](OwnerStream& owner) -> void { owner.cancel(); });
+  done();
+}
+
+SharedConnPoolImpl::OwnerStream::OwnerStream(Event::Dispatcher& dispatcher,
+                                             Event::Dispatcher& owner_dispatcher,
+                                             StreamLinkSharedPtr link)
+    : dispatcher_(dispatcher), owner_dispatcher_(owner_dispatcher), link_(link) {
+  link_->owner_ = this;
+}
+
+void SharedConnPoolImpl::OwnerStream::start(ConnectionPool::Instance* pool) {
+  if (pool == nullptr) {
+    onPoolFailure(ConnectionPool::PoolFailureReason::ConnectionFailure, nullptr);
+    return;
+  }
+
+  // The pool may call back right away, in which case there is no handle.
+  handle_ = pool->newStream(*this, *this);
+}
+
+void SharedConnPoolImpl::OwnerStream::cancel() {
+  if (handle_ != nullptr) {
+    handle_->cancel();
+    handle_ = nullptr;
+  } else if (encoder_ != nullptr) {
+    // The reset callbacks are done with the stream.
+    encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  }
+
+  if (link_->owner_ != nullptr) {
+    done();
+  }
+}
+
+void SharedConnPoolImpl::OwnerStream::done() {
+  link_->owner_ = nullptr;
+  if (encoder_ != nullptr) {
+    encoder_->getStream().removeCallbacks(*this);
+    encoder_ = nullptr;
+  }
+
+  owner_dispatcher_.deferredDelete(Event::DeferredDeletablePtr{this});
+}
+
+void SharedConnPoolImpl::OwnerStream::postToLocal(std::function<void(LocalStream&)> cb) {
+  StreamLinkSharedPtr link = link_;
+  dispatcher_.post([link, cb]() -> void {
+    if (link->local_ != nullptr) {
+      cb(*link->local_);
+    }
+  });
+}
+
+void SharedConnPoolImpl::OwnerStream::onLocalComplete() {
+  local_complete_ = true;
+  if (remote_complete_) {
+    done();
+  }
+}
+
+void SharedConnPoolImpl::OwnerStream::onRemoteComplete() {
+  remote_complete_ = true;
+  if (local_complete_) {
+    done();
+  }
+}
+
+void SharedConnPoolImpl::OwnerStream::decodeHeaders(HeaderMapPtr&& headers, bool end_stream) {
+  std::shared_ptr<HeaderMapPtr> local_headers = std::make_shared<HeaderMapPtr>(std::move(headers));
+  postToLocal([local_headers, end_stream](LocalStream& local) -> void {
+    local.onResponseHeaders(std::move(*local_headers), end_stream);
+  });
+
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolImpl::OwnerStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  std::shared_ptr<Buffer::OwnedImpl> local_data = std::make_shared<Buffer::OwnedImpl>();
+  local_data->move(data);
+  postToLocal([local_data, end_stream](LocalStream& local) -> void {
+    local.onResponseData(*local_data, end_stream);
+  });
+
+  if (end_stream) {
+    onRemoteComplete();
+  }
+}
+
+void SharedConnPoolImpl::OwnerStream::decodeTrailers(HeaderMapPtr&& trailers) {
+  std::shared_ptr<HeaderMapPtr> local_trailers =
+      std::make_shared<HeaderMapPtr>(std::move(trailers));
+  postToLocal([local_trailers](LocalStream& local) -> void {
+    local.onResponseTrailers(std::move(*local_trailers));
+  });
+
+  onRemoteComplete();
+}
+
+void SharedConnPoolImpl::OwnerStream::onResetStream(StreamResetReason reason) {
+  // The stream is going away, so there are no callbacks to remove.
+  encoder_ = nullptr;
+  postToLocal([reason](LocalStream& local) -> void { local.onRemoteReset(reason); });
+  done();
+}
+
+void SharedConnPoolImpl::OwnerStream::onAboveWriteBufferHighWatermark() {
+  postToLocal([](LocalStream& local) -> void { local.runHighWatermarkCallbacks(); });
+}
+
+void SharedConnPoolImpl::OwnerStream::onBelowWriteBufferLowWatermark() {
+  postToLocal([](LocalStream& local) -> void { local.runLowWatermarkCallbacks(); });
+}
+
+void SharedConnPoolImpl::OwnerStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                    Upstream::HostDescriptionConstSharedPtr host) {
+  handle_ = nullptr;
+  postToLocal([reason, host](LocalStream& local) -> void { local.onPoolFailure(reason, host); });
+  done();
+}
+
+void SharedConnPoolImpl::OwnerStream::onPoolReady(StreamEncoder& encoder,
+                                                  Upstream::HostDescriptionConstSharedPtr host) {
+  handle_ = nullptr;
+  encoder_ = &encoder;
+  encoder.getStream().addCallbacks(*this);
+  const uint32_t buffer_limit = encoder.getStream().bufferLimit();
+  postToLocal([host, buffer_limit](LocalStream& local) -> void {
+    local.onPoolReady(host, buffer_limit);
+  });
+}
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
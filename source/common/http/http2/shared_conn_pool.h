@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
+#include "common/http/codec_helper.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+/**
+ * An HTTP/2 connection pool which places its streams on a pool owned by another worker, so that
+ * workers can share a few upstream connections to hosts which see little traffic. The two halves
+ * of each stream talk through dispatcher posts: the request is encoded on the owner's thread, and
+ * the response is decoded on the thread of this pool. Every stream event pays a post, so this is
+ * only meant for clusters whose connections would otherwise be mostly idle.
+ */
+class SharedConnPoolImpl : Logger::Loggable<Logger::Id::pool>, public ConnectionPool::Instance {
+public:
+  /**
+   * Supplies the pool to place a stream on. It is called on the owner's thread for each stream,
+   * and returns nullptr if there is no pool to use, e.g. if no host is healthy.
+   */
+  typedef std::function<ConnectionPool::Instance*()> OwnerPoolCb;
+
+  SharedConnPoolImpl(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                     OwnerPoolCb owner_pool_cb);
+  ~SharedConnPoolImpl();
+
+  // Http::ConnectionPool::Instance
+  Http::Protocol protocol() const override { return Http::Protocol::Http2; }
+  void addDrainedCallback(DrainedCb cb) override;
+  ConnectionPool::Cancellable* newStream(Http::StreamDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override;
+
+private:
+  struct LocalStream;
+  struct OwnerStream;
+
+  /**
+   * Links the two halves of a stream. Each half is only used on its own thread, and clears its
+   * pointer there once it is done, so that a post to a half which is done does nothing.
+   */
+  struct StreamLink {
+    LocalStream* local_{};
+    OwnerStream* owner_{};
+  };
+
+  typedef std::shared_ptr<StreamLink> StreamLinkSharedPtr;
+
+  /**
+   * The half of a stream on the thread of the pool. It is the encoder handed to the user of the
+   * pool, and forwards the request to the owner's thread.
+   */
+  struct LocalStream : LinkedObject<LocalStream>,
+                       public StreamEncoder,
+                       public Stream,
+                       public StreamCallbackHelper,
+                       public ConnectionPool::Cancellable,
+                       public Event::DeferredDeletable {
+    LocalStream(SharedConnPoolImpl& parent, StreamDecoder& response_decoder,
+                ConnectionPool::Callbacks& callbacks);
+
+    void done();
+    void postToOwner(std::function<void(OwnerStream&)> cb);
+    void terminate();
+
+    // Called through posts from the owner's thread.
+    void onPoolReady(Upstream::HostDescriptionConstSharedPtr host, uint32_t buffer_limit);
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       Upstream::HostDescriptionConstSharedPtr host);
+    void onRemoteReset(StreamResetReason reason);
+    void onRemoteComplete();
+    void onResponseHeaders(HeaderMapPtr&& headers, bool end_stream);
+    void onResponseData(Buffer::Instance& data, bool end_stream);
+    void onResponseTrailers(HeaderMapPtr&& trailers);
+
+    // Http::StreamEncoder
+    void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
+    void encodeData(Buffer::Instance& data, bool end_stream) override;
+    void encodeTrailers(const HeaderMap& trailers) override;
+    Stream& getStream() override { return *this; }
+
+    // Http::Stream
+    void addCallbacks(StreamCallbacks& callbacks) override { addCallbacks_(callbacks); }
+    void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacks_(callbacks); }
+    void resetStream(StreamResetReason reason) override;
+    void readDisable(bool disable) override;
+    uint32_t bufferLimit() override { return buffer_limit_; }
+
+    // Http::ConnectionPool::Cancellable
+    void cancel() override;
+
+    SharedConnPoolImpl& parent_;
+    StreamLinkSharedPtr link_;
+    StreamDecoder& response_decoder_;
+    ConnectionPool::Callbacks& pool_callbacks_;
+    uint32_t buffer_limit_{};
+    bool ready_{};
+    bool remote_complete_{};
+  };
+
+  typedef std::unique_ptr<LocalStream> LocalStreamPtr;
+
+  /**
+   * The half of a stream on the owner's thread. It places the stream on the owner's pool, and
+   * forwards the response to the thread of the pool. It deletes itself once the stream is done.
+   */
+  struct OwnerStream : public StreamDecoder,
+                       public StreamCallbacks,
+                       public ConnectionPool::Callbacks,
+                       public Event::DeferredDeletable {
+    OwnerStream(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                StreamLinkSharedPtr link);
+
+    void start(ConnectionPool::Instance* pool);
+    void cancel();
+    void done();
+    void postToLocal(std::function<void(LocalStream&)> cb);
+    void onLocalComplete();
+    void onRemoteComplete();
+
+    // Http::StreamDecoder
+    void decodeHeaders(HeaderMapPtr&& headers, bool end_stream) override;
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeTrailers(HeaderMapPtr&& trailers) override;
+
+    // Http::StreamCallbacks
+    void onResetStream(StreamResetReason reason) override;
+    void onAboveWriteBufferHighWatermark() override;
+    void onBelowWriteBufferLowWatermark() override;
+
+    // Http::ConnectionPool::Callbacks
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(StreamEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host) override;
+
+    Event::Dispatcher& dispatcher_;
+    Event::Dispatcher& owner_dispatcher_;
+    StreamLinkSharedPtr link_;
+    ConnectionPool::Cancellable* handle_{};
+    StreamEncoder* encoder_{};
+    bool local_complete_{};
+    bool remote_complete_{};
+  };
+
+  void checkForDrained();
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const OwnerPoolCb owner_pool_cb_;
+  std::list<LocalStreamPtr> streams_;
+  std::list<DrainedCb> drained_callbacks_;
+};
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
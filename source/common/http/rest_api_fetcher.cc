@@ -5,6 +5,8 @@
 #include <string>
 
 #include "common/common/enum_to_int.h"
+#include "common/common/hash.h"
+#include "common/http/headers.h"
 #include "common/http/message_impl.h"
 #include "common/http/utility.h"
 
@@ -28,13 +30,38 @@ void RestApiFetcher::initialize() { refresh(); }
 
 void RestApiFetcher::onSuccess(Http::MessagePtr&& response) {
   uint64_t response_code = Http::Utility::getResponseStatus(response->headers());
+  if (response_code == enumToInt(Http::Code::NotModified) && !last_response_etag_.empty()) {
+    onResponseUnchanged();
+    requestComplete();
+    return;
+  }
+
   if (response_code != enumToInt(Http::Code::OK)) {
     onFailure(Http::AsyncClient::FailureReason::Reset);
     return;
   }
 
+  // Compare the raw body with the last accepted one before paying for any parsing, since most
+  // polls return the same response.
+  const uint64_t response_hash = HashUtil::xxHash64(response->bodyAsString());
+  if (last_response_hash_.valid() && last_response_hash_.value() == response_hash) {
+    onResponseUnchanged();
+    requestComplete();
+    return;
+  }
+
+  last_response_hash_ = Optional<uint64_t>();
+  last_response_etag_.clear();
+  response_accepted_ = true;
   try {
     parseResponse(*response);
+    if (response_accepted_) {
+      last_response_hash_.value(response_hash);
+      const HeaderEntry* etag = response->headers().get(Http::Headers::get().Etag);
+      if (etag != nullptr) {
+        last_response_etag_ = etag->value().c_str();
+      }
+    }
   } catch (EnvoyException& e) {
     onFetchFailure(&e);
   }
@@ -51,6 +78,9 @@ void RestApiFetcher::refresh() {
   MessagePtr message(new RequestMessageImpl());
   createRequest(*message);
   message->headers().insertHost().value(remote_cluster_name_);
+  if (!last_response_etag_.empty()) {
+    message->headers().addReferenceKey(Http::Headers::get().IfNoneMatch, last_response_etag_);
+  }
   active_request_ = cm_.httpAsyncClientForCluster(remote_cluster_name_)
                         .send(std::move(message), *this,
                               Optional<std::chrono::milliseconds>(std::chrono::milliseconds(1000)));
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <string>
 
+#include "envoy/common/optional.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/cluster_manager.h"
@@ -13,6 +14,10 @@ namespace Http {
 /**
  * A helper base class used to fetch a REST API at a jittered periodic interval. Once initialize()
  * is called, the API will be fetched and events raised.
+ *
+ * Fetches are conditional: the ETag of the last accepted response is sent as If-None-Match, and a
+ * 304 response or a 200 response whose body hashes the same as the last accepted one is reported
+ * through onResponseUnchanged() without being parsed again.
  */
 class RestApiFetcher : public Http::AsyncClient::Callbacks {
 protected:
@@ -37,6 +42,12 @@ protected:
    */
   virtual void parseResponse(const Message& response) PURE;
 
+  /**
+   * This will be called instead of parseResponse() when the API returns the same response as the
+   * last one which was parsed and accepted.
+   */
+  virtual void onResponseUnchanged() PURE;
+
   /**
    * This will be called either in the success case or in the failure case for each fetch. It can
    * be used to hold common post request logic.
@@ -49,6 +60,12 @@ protected:
    */
   virtual void onFetchFailure(const EnvoyException* e) PURE;
 
+  /**
+   * Called from parseResponse() when the response was not accepted without an exception being
+   * thrown, so that it will be parsed again if it is returned again.
+   */
+  void rejectResponse() { response_accepted_ = false; }
+
 protected:
   const std::string remote_cluster_name_;
   Upstream::ClusterManager& cm_;
@@ -65,6 +82,10 @@ private:
   const std::chrono::milliseconds refresh_interval_;
   Event::TimerPtr refresh_timer_;
   Http::AsyncClient::Request* active_request_{};
+  // The hash of the body and the ETag of the last accepted response.
+  Optional<uint64_t> last_response_hash_;
+  std::string last_response_etag_;
+  bool response_accepted_{};
 };
 
 } // namespace Http
@@ -11,19 +11,26 @@
 namespace Envoy {
 namespace Http {
 
-void UserAgent::completeConnectionLength(Stats::Timespan& span) {
+UserAgentStats& UserAgentContext::stats(std::once_flag& once,
+                                        std::unique_ptr<UserAgentStats>& stats,
+                                        const std::string& type_prefix) {
+  std::call_once(once, [this, &stats, &type_prefix]() -> void {
+    const std::string prefix = prefix_ + type_prefix;
+    stats.reset(new UserAgentStats{ALL_USER_AGENTS_STATS(POOL_COUNTER_PREFIX(scope_, prefix),
+                                                         POOL_HISTOGRAM_PREFIX(scope_, prefix))});
+  });
+  return *stats;
+}
 
-  // Note: stats_ and scope_ are set together, so it's assumed that scope_ will be non-nullptr if
-  // stats_ is.
+void UserAgent::completeConnectionLength(Stats::Timespan& span) {
   if (!stats_) {
     return;
   }
 
-  scope_->histogram(prefix_ + "downstream_cx_length_ms").recordValue(span.getRawDuration().count());
+  stats_->downstream_cx_length_ms_.recordValue(span.getRawDuration().count());
 }
 
-void UserAgent::initializeFromHeaders(const HeaderMap& headers, const std::string& prefix,
-                                      Stats::Scope& scope) {
+void UserAgent::initializeFromHeaders(const HeaderMap& headers, UserAgentContext& context) {
   // We assume that the user-agent is consistent based on the first request.
   if (type_ != Type::NotInitialized) {
     return;
@@ -33,21 +40,18 @@ void UserAgent::initializeFromHeaders(const HeaderMap& headers, const std::strin
 
   const HeaderEntry* user_agent = headers.UserAgent();
   if (user_agent) {
-    prefix_ = prefix;
     if (user_agent->value().find("iOS")) {
       type_ = Type::iOS;
-      prefix_ += "user_agent.ios.";
+      stats_ = &context.iosStats();
     } else if (user_agent->value().find("android")) {
       type_ = Type::Android;
-      prefix_ += "user_agent.android.";
+      stats_ = &context.androidStats();
     }
   }
 
-  if (type_ != Type::Unknown) {
-    stats_.reset(new UserAgentStats{ALL_USER_AGENTS_STATS(POOL_COUNTER_PREFIX(scope, prefix_))});
+  if (stats_) {
     stats_->downstream_cx_total_.inc();
     stats_->downstream_rq_total_.inc();
-    scope_ = &scope;
   }
 }
 
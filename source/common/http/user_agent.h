@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "envoy/http/header_map.h"
@@ -14,21 +15,51 @@ namespace Envoy {
  * All stats for user agents. @see stats_macros.h
  */
 // clang-format off
-#define ALL_USER_AGENTS_STATS(COUNTER)                                                             \
+#define ALL_USER_AGENTS_STATS(COUNTER, HISTOGRAM)                                                  \
   COUNTER(downstream_cx_total)                                                                     \
   COUNTER(downstream_cx_destroy_remote_active_rq)                                                  \
-  COUNTER(downstream_rq_total)
+  COUNTER(downstream_rq_total)                                                                     \
+  HISTOGRAM(downstream_cx_length_ms)
 // clang-format on
 
 /**
  * Wrapper struct for user agent stats. @see stats_macros.h
  */
 struct UserAgentStats {
-  ALL_USER_AGENTS_STATS(GENERATE_COUNTER_STRUCT)
+  ALL_USER_AGENTS_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
 namespace Http {
 
+/**
+ * The stats of each user agent type under one stat prefix. It is shared by all the connections
+ * which use the prefix, on any thread. The stats of a type are looked up the first time a
+ * connection of that type is seen, and connections use them without further lookups by name.
+ */
+class UserAgentContext {
+public:
+  UserAgentContext(const std::string& prefix, Stats::Scope& scope)
+      : prefix_(prefix), scope_(scope) {}
+
+  UserAgentStats& iosStats() { return stats(ios_once_, ios_stats_, "user_agent.ios."); }
+  UserAgentStats& androidStats() {
+    return stats(android_once_, android_stats_, "user_agent.android.");
+  }
+
+private:
+  UserAgentStats& stats(std::once_flag& once, std::unique_ptr<UserAgentStats>& stats,
+                        const std::string& type_prefix);
+
+  const std::string prefix_;
+  Stats::Scope& scope_;
+  std::once_flag ios_once_;
+  std::unique_ptr<UserAgentStats> ios_stats_;
+  std::once_flag android_once_;
+  std::unique_ptr<UserAgentStats> android_stats_;
+};
+
+typedef std::shared_ptr<UserAgentContext> UserAgentContextSharedPtr;
+
 /**
  * Stats support for specific user agents.
  */
@@ -44,11 +75,9 @@ public:
    * Initialize the user agent from request headers. This is only done once and the user-agent
    * is assumed to be the same for further requests.
    * @param headers supplies the request headers.
-   * @param prefix supplies the stat prefix for the UA stats.
-   * @param scope supplies the backing stat scope.
+   * @param context supplies the stats of the user agent types.
    */
-  void initializeFromHeaders(const HeaderMap& headers, const std::string& prefix,
-                             Stats::Scope& scope);
+  void initializeFromHeaders(const HeaderMap& headers, UserAgentContext& context);
 
   /**
    * Called when a connection is being destroyed.
@@ -61,9 +90,7 @@ private:
   enum class Type { NotInitialized, iOS, Android, Unknown };
 
   Type type_{Type::NotInitialized};
-  std::unique_ptr<UserAgentStats> stats_;
-  std::string prefix_;
-  Stats::Scope* scope_{};
+  UserAgentStats* stats_{};
 };
 
 } // namespace Http
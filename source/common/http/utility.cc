@@ -1,6 +1,7 @@
 #include "common/http/utility.h"
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -58,7 +59,7 @@ Utility::QueryParams Utility::parseQueryString(const std::string& url) {
     }
 
     size_t equal = url.find('=', start);
-    if (equal != std::string::npos) {
+    if (equal != std::string::npos && equal < end) {
       params.emplace(StringUtil::subspan(url, start, equal),
                      StringUtil::subspan(url, equal + 1, end));
     } else {
@@ -76,50 +77,80 @@ const char* Utility::findQueryStringStart(const HeaderString& path) {
 }
 
 std::string Utility::parseCookieValue(const HeaderMap& headers, const std::string& key) {
+  const char* value;
+  size_t size;
+  if (!findCookieValue(headers, key, &value, &size)) {
+    return "";
+  }
+  return std::string(value, size);
+}
 
+bool Utility::findCookieValue(const HeaderMap& headers, const std::string& key,
+                              const char** value, size_t* size) {
   struct State {
-    std::string key_;
-    std::string ret_;
+    const std::string& key_;
+    const char* value_;
+    size_t size_;
   };
 
-  State state;
-  state.key_ = key;
+  State state{key, nullptr, 0};
 
   headers.iterateReverse(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
         // Find the cookie headers in the request (typically, there's only one).
-        if (header.key() == Http::Headers::get().Cookie.get().c_str()) {
-          // Split the cookie header into individual cookies.
-          for (const std::string& s : StringUtil::split(std::string{header.value().c_str()}, ';')) {
+        if (header.key() != Http::Headers::get().Cookie.get().c_str()) {
+          return HeaderMap::Iterate::Continue;
+        }
+
+        // Scan the individual cookies in place.
+        State* state = static_cast<State*>(context);
+        const char* cookie = header.value().c_str();
+        const char* end = cookie + header.value().size();
+        while (cookie < end) {
+          const char* cookie_end = static_cast<const char*>(memchr(cookie, ';', end - cookie));
+          if (cookie_end == nullptr) {
+            cookie_end = end;
+          }
+
+          // The cookie is malformed if it does not have an `=`. Continue checking other cookies
+          // in this header.
+          const char* equals = static_cast<const char*>(memchr(cookie, '=', cookie_end - cookie));
+          if (equals != nullptr) {
             // Find the key part of the cookie (i.e. the name of the cookie).
-            size_t first_non_space = s.find_first_not_of(" ");
-            size_t equals_index = s.find('=');
-            if (equals_index == std::string::npos) {
-              // The cookie is malformed if it does not have an `=`. Continue
-              // checking other cookies in this header.
-              continue;
+            const char* name = cookie;
+            while (name < equals && *name == ' ') {
+              name++;
             }
-            std::string k = s.substr(first_non_space, equals_index - first_non_space);
-            State* state = static_cast<State*>(context);
-            // If the key matches, parse the value from the rest of the cookie string.
-            if (k == state->key_) {
-              std::string v = s.substr(equals_index + 1, s.size() - 1);
+
+            // If the key matches, the value is the rest of the cookie.
+            if (static_cast<size_t>(equals - name) == state->key_.size() &&
+                memcmp(name, state->key_.c_str(), state->key_.size()) == 0) {
+              state->value_ = equals + 1;
+              state->size_ = cookie_end - state->value_;
 
               // Cookie values may be wrapped in double quotes.
               // https://tools.ietf.org/html/rfc6265#section-4.1.1
-              if (v.size() >= 2 && v.back() == '"' && v[0] == '"') {
-                v = v.substr(1, v.size() - 2);
+              if (state->size_ >= 2 && state->value_[0] == '"' &&
+                  state->value_[state->size_ - 1] == '"') {
+                state->value_++;
+                state->size_ -= 2;
               }
-              state->ret_ = v;
               return HeaderMap::Iterate::Break;
             }
           }
+
+          cookie = cookie_end + 1;
         }
         return HeaderMap::Iterate::Continue;
       },
       &state);
 
-  return state.ret_;
+  if (state.value_ == nullptr) {
+    return false;
+  }
+  *value = state.value_;
+  *size = state.size_;
+  return true;
 }
 
 std::string Utility::makeSetCookieValue(const std::string& key, const std::string& value,
@@ -58,6 +58,19 @@ public:
    **/
   static std::string parseCookieValue(const HeaderMap& headers, const std::string& key);
 
+  /**
+   * Find a particular value in a cookie without copying it, following the same rules as
+   * parseCookieValue().
+   * @param headers supplies the headers to get the cookie from.
+   * @param key the key for the particular cookie value to find.
+   * @param value supplies where to store the start of the value. It points into the headers and is
+   *        only valid until they are modified.
+   * @param size supplies where to store the size of the value.
+   * @return bool whether the cookie value was found.
+   */
+  static bool findCookieValue(const HeaderMap& headers, const std::string& key,
+                              const char** value, size_t* size);
+
   /**
    * Check whether a Set-Cookie header for the given cookie name exists
    * @param headers supplies the headers to search for the cookie
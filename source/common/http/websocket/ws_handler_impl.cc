@@ -24,6 +24,26 @@ WsHandlerImpl::WsHandlerImpl(HeaderMap& request_headers, const AccessLog::Reques
   read_callbacks_->connection().addConnectionCallbacks(downstream_callbacks_);
 }
 
+void WsHandlerImpl::setIdleTimeout(std::chrono::milliseconds timeout, Event::TimerCb cb) {
+  idle_timeout_ = timeout;
+  idle_timer_ = read_callbacks_->connection().dispatcher().createCoarseTimer(cb);
+  idle_timer_->enableTimer(idle_timeout_);
+}
+
+Network::FilterStatus WsHandlerImpl::onData(Buffer::Instance& data) {
+  if (idle_timer_) {
+    idle_timer_->enableTimer(idle_timeout_);
+  }
+  return TcpProxy::onData(data);
+}
+
+void WsHandlerImpl::onUpstreamData(Buffer::Instance& data) {
+  if (idle_timer_) {
+    idle_timer_->enableTimer(idle_timeout_);
+  }
+  TcpProxy::onUpstreamData(data);
+}
+
 void WsHandlerImpl::onInitFailure() {
   HeaderMapImpl headers{
       {Headers::get().Status, std::to_string(enumToInt(Code::ServiceUnavailable))}};
@@ -78,6 +98,9 @@ void WsHandlerImpl::onConnectionSuccess() {
   Http1::ClientConnectionImpl upstream_http(*upstream_connection_, http_conn_callbacks_);
   Http1::RequestStreamEncoderImpl upstream_request = Http1::RequestStreamEncoderImpl(upstream_http);
   upstream_request.encodeHeaders(request_headers_, false);
+
+  // This may destroy the stream which owns the request headers and request info.
+  ws_callbacks_.onUpgradeRequestSent();
 }
 
 } // namespace WebSocket
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
+#include "envoy/event/timer.h"
 #include "envoy/http/codec.h"
 #include "envoy/http/header_map.h"
 #include "envoy/http/websocket.h"
@@ -30,9 +32,21 @@ public:
                 Upstream::ClusterManager& cluster_manager,
                 Network::ReadFilterCallbacks* read_callbacks);
 
+  /**
+   * Time the connection out once no data has gone through the tunnel in either direction for a
+   * while. The timer is a coarse timer, so that idle tunnels cost no libevent timer each.
+   * @param timeout supplies the idle timeout.
+   * @param cb supplies the callback to invoke on idle timeout.
+   */
+  void setIdleTimeout(std::chrono::milliseconds timeout, Event::TimerCb cb);
+
+  // Network::ReadFilter
+  Network::FilterStatus onData(Buffer::Instance& data) override;
+
 protected:
   // Filter::TcpProxy
   const std::string& getUpstreamCluster() override { return route_entry_.clusterName(); }
+  void onUpstreamData(Buffer::Instance& data) override;
 
   void onInitFailure() override;
   void onUpstreamHostReady() override;
@@ -51,6 +65,8 @@ private:
   const Router::RouteEntry& route_entry_;
   WsHandlerCallbacks& ws_callbacks_;
   NullHttpConnectionCallbacks http_conn_callbacks_;
+  Event::TimerPtr idle_timer_;
+  std::chrono::milliseconds idle_timeout_{};
 };
 
 typedef std::unique_ptr<WsHandlerImpl> WsHandlerImplPtr;
@@ -423,13 +423,62 @@ const std::string Json::Schema::RATELIMIT_NETWORK_FILTER_SCHEMA(R"EOF(
         "type" : "integer",
         "minimum" : 0,
         "exclusiveMinimum" : true
-      }
+      },
+      "local_rate_limit" : {"type" : "object"}
     },
     "required": ["stat_prefix", "descriptors", "domain"],
     "additionalProperties": false
   }
   )EOF");
 
+const std::string Json::Schema::LOCAL_RATE_LIMIT_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "rules" : {
+        "type" : "array",
+        "minItems" : 1,
+        "items" : {
+          "type" : "object",
+          "properties" : {
+            "descriptor" : {
+              "type" : "array",
+              "minItems" : 1,
+              "items" : {
+                "type" : "object",
+                "properties" : {
+                  "key" : {"type" : "string"},
+                  "value" : {"type" : "string"}
+                },
+                "required" : ["key"],
+                "additionalProperties" : false
+              }
+            },
+            "max_tokens" : {
+              "type" : "integer",
+              "minimum" : 1
+            },
+            "tokens_per_fill" : {
+              "type" : "integer",
+              "minimum" : 1
+            },
+            "fill_interval_ms" : {
+              "type" : "integer",
+              "minimum" : 1
+            }
+          },
+          "required" : ["descriptor", "max_tokens", "fill_interval_ms"],
+          "additionalProperties" : false
+        }
+      },
+      "global_sync" : {"type" : "boolean"}
+    },
+    "required" : ["rules"],
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::REDIS_PROXY_NETWORK_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -453,6 +502,28 @@ const std::string Json::Schema::REDIS_CONN_POOL_SCHEMA(R"EOF(
         "type" : "integer",
         "minimum" : 0,
         "exclusiveMinimum" : true
+      },
+      "batch_writes" : {"type" : "boolean"},
+      "cluster_mode" : {"type" : "boolean"},
+      "collapse_reads" : {"type" : "boolean"},
+      "hot_keys" : {
+        "type" : "object",
+        "properties" : {
+          "top_n" : {
+            "type" : "integer",
+            "minimum" : 1,
+            "maximum" : 1000
+          },
+          "cached_keys" : {
+            "type" : "array",
+            "items" : {"type" : "string"}
+          },
+          "cache_ttl_ms" : {
+            "type" : "integer",
+            "minimum" : 0
+          }
+        },
+        "additionalProperties" : false
       }
     },
     "required": ["op_timeout_ms"],
@@ -466,6 +537,7 @@ const std::string Json::Schema::TCP_PROXY_NETWORK_FILTER_SCHEMA(R"EOF(
       "type" : "object",
       "properties": {
         "stat_prefix": {"type" : "string"},
+        "splice": {"type" : "boolean"},
         "route_config": {
           "type": "object",
           "properties": {
@@ -905,13 +977,29 @@ const std::string Json::Schema::BUFFER_HTTP_FILTER_SCHEMA(R"EOF(
     "type" : "object",
     "properties" : {
       "max_request_bytes" : {"type" : "integer"},
-      "max_request_time_s" : {"type" : "integer"}
+      "max_request_time_s" : {"type" : "integer"},
+      "spill_directory" : {"type" : "string", "minLength" : 1},
+      "spill_threshold_bytes" : {"type" : "integer", "minimum" : 0},
+      "max_worker_memory_bytes" : {"type" : "integer", "minimum" : 0}
     },
     "required" : ["max_request_bytes", "max_request_time_s"],
     "additionalProperties" : false
   }
   )EOF");
 
+const std::string Json::Schema::CACHE_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "max_bytes" : {"type" : "integer", "minimum" : 1},
+      "max_entry_bytes" : {"type" : "integer", "minimum" : 0},
+      "coalesce_requests" : {"type" : "boolean"}
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::FAULT_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -996,6 +1084,10 @@ const std::string Json::Schema::GRPC_JSON_TRANSCODER_FILTER_SCHEMA(R"EOF(
           "preserve_proto_field_names": {"type" : "boolean"}
         },
         "additionalProperties" : false
+      },
+      "stream_flush_threshold_bytes" : {
+        "type" : "integer",
+        "minimum" : 0
       }
     },
     "required" : ["proto_descriptor", "services"],
@@ -1003,6 +1095,71 @@ const std::string Json::Schema::GRPC_JSON_TRANSCODER_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::GZIP_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "compression_level" : {
+        "type" : "string",
+        "enum" : ["best", "speed", "default"]
+      },
+      "compression_strategy" : {
+        "type" : "string",
+        "enum" : ["default", "filtered", "huffman", "rle"]
+      },
+      "content_length" : {
+        "type" : "integer",
+        "minimum" : 0
+      },
+      "content_type" : {
+        "type" : "array",
+        "uniqueItems" : true,
+        "items" : {"type" : "string"}
+      },
+      "window_bits" : {
+        "type" : "integer",
+        "minimum" : 9,
+        "maximum" : 15
+      },
+      "memory_level" : {
+        "type" : "integer",
+        "minimum" : 1,
+        "maximum" : 9
+      },
+      "chunk_size" : {
+        "type" : "integer",
+        "minimum" : 64,
+        "maximum" : 65536
+      },
+      "content_encoding" : {
+        "type" : "array",
+        "uniqueItems" : true,
+        "items" : {
+          "type" : "string",
+          "enum" : ["gzip", "deflate", "br", "zstd"]
+        }
+      },
+      "brotli_quality" : {
+        "type" : "integer",
+        "minimum" : 0,
+        "maximum" : 11
+      },
+      "brotli_window_bits" : {
+        "type" : "integer",
+        "minimum" : 10,
+        "maximum" : 24
+      },
+      "zstd_level" : {
+        "type" : "integer",
+        "minimum" : 1,
+        "maximum" : 22
+      }
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -1069,7 +1226,8 @@ const std::string Json::Schema::RATE_LIMIT_HTTP_FILTER_SCHEMA(R"EOF(
         "type" : "integer",
         "minimum" : 0,
         "exclusiveMinimum" : true
-      }
+      },
+      "local_rate_limit" : {"type" : "object"}
     },
     "required" : ["domain"],
     "additionalProperties" : false
@@ -1210,7 +1368,11 @@ const std::string Json::Schema::TOP_LEVEL_CONFIG_SCHEMA(R"EOF(
             "type" : "object",
             "properties" : {
               "collector_cluster" : {"type" : "string"},
-              "collector_endpoint": {"type": "string"}
+              "collector_endpoint": {"type": "string"},
+              "collector_encoding": {
+                "type": "string",
+                "enum": ["json", "thrift"]
+              }
             },
             "required": ["collector_cluster"],
             "additionalProperties" : false
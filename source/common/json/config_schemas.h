@@ -23,6 +23,9 @@ public:
   static const std::string REDIS_PROXY_NETWORK_FILTER_SCHEMA;
   static const std::string TCP_PROXY_NETWORK_FILTER_SCHEMA;
 
+  // Rate limit filter schemas shared by the network and HTTP filters
+  static const std::string LOCAL_RATE_LIMIT_SCHEMA;
+
   // HTTP Connection Manager Schemas
   static const std::string ROUTE_CONFIGURATION_SCHEMA;
   static const std::string VIRTUAL_HOST_CONFIGURATION_SCHEMA;
@@ -33,8 +36,10 @@ public:
 
   // HTTP Filter Schemas
   static const std::string BUFFER_HTTP_FILTER_SCHEMA;
+  static const std::string CACHE_HTTP_FILTER_SCHEMA;
   static const std::string FAULT_HTTP_FILTER_SCHEMA;
   static const std::string GRPC_JSON_TRANSCODER_FILTER_SCHEMA;
+  static const std::string GZIP_HTTP_FILTER_SCHEMA;
   static const std::string HEALTH_CHECK_HTTP_FILTER_SCHEMA;
   static const std::string IP_TAGGING_HTTP_FILTER_SCHEMA;
   static const std::string RATE_LIMIT_HTTP_FILTER_SCHEMA;
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <fstream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -168,9 +170,12 @@ private:
     return value_.integer_value_;
   }
 
-  rapidjson::Document asRapidJsonDocument() const;
-  static void buildRapidJsonDocument(const Field& field, rapidjson::Value& value,
-                                     rapidjson::Document::AllocatorType& allocator);
+  /**
+   * Feed the SAX events of this field and everything nested in it to a rapidjson handler, so that
+   * it can be written or validated without first building a rapidjson::Document copy of the tree.
+   * @return false if the handler stopped the walk.
+   */
+  template <class Handler> bool accept(Handler& handler) const;
 
   uint64_t line_number_start_ = 0;
   uint64_t line_number_end_ = 0;
@@ -178,6 +183,57 @@ private:
   Value value_;
 };
 
+/**
+ * Compiled schemas, keyed by the schema text. The set of schemas is the fixed one in
+ * config_schemas.cc, and config loading validates thousands of objects against the same few, so
+ * each is parsed and compiled once and then shared. A SchemaDocument is immutable once built and
+ * may be used by validators on several threads at once.
+ */
+class SchemaCache {
+public:
+  static const rapidjson::SchemaDocument& get(const std::string& schema) {
+    // Schemas are passed as the same Json::Schema constants over and over, so each thread first
+    // looks them up by address. That avoids hashing the schema text and taking the lock on every
+    // validation. As the string at an address may change, the text is still compared, which fails
+    // fast on the length when it did.
+    static thread_local std::unordered_map<const std::string*, const Entry*> by_address;
+    auto it = by_address.find(&schema);
+    if (it != by_address.end() && it->second->first == schema) {
+      return *it->second->second;
+    }
+
+    const Entry& entry = getOrCompile(schema);
+    by_address[&schema] = &entry;
+    return *entry.second;
+  }
+
+private:
+  typedef std::pair<const std::string, std::unique_ptr<rapidjson::SchemaDocument>> Entry;
+
+  static const Entry& getOrCompile(const std::string& schema) {
+    static std::mutex* lock = new std::mutex();
+    static auto* compiled_schemas =
+        new std::unordered_map<std::string, std::unique_ptr<rapidjson::SchemaDocument>>();
+
+    std::unique_lock<std::mutex> guard(*lock);
+    auto it = compiled_schemas->find(schema);
+    if (it != compiled_schemas->end()) {
+      return *it;
+    }
+
+    rapidjson::Document schema_document;
+    if (schema_document.Parse<0>(schema.c_str()).HasParseError()) {
+      throw std::invalid_argument(fmt::format(
+          "Schema supplied to validateSchema is not valid JSON\n Error(offset {}) : {}\n",
+          schema_document.GetErrorOffset(), GetParseError_En(schema_document.GetParseError())));
+    }
+
+    std::unique_ptr<rapidjson::SchemaDocument> schema_document_for_validator(
+        new rapidjson::SchemaDocument(schema_document));
+    return *compiled_schemas->emplace(schema, std::move(schema_document_for_validator)).first;
+  }
+};
+
 /**
  * Custom stream to allow access to the line number for each object.
  */
@@ -241,89 +297,50 @@ private:
   FieldSharedPtr root_;
 };
 
-void Field::buildRapidJsonDocument(const Field& field, rapidjson::Value& value,
-                                   rapidjson::Document::AllocatorType& allocator) {
-
-  switch (field.type_) {
+template <class Handler> bool Field::accept(Handler& handler) const {
+  switch (type_) {
   case Type::Array: {
-    value.SetArray();
-    value.Reserve(field.value_.array_value_.size(), allocator);
-    for (const auto& element : field.value_.array_value_) {
-      switch (element->type_) {
-      case Type::Array:
-      case Type::Object: {
-        rapidjson::Value nested_value;
-        buildRapidJsonDocument(*element, nested_value, allocator);
-        value.PushBack(nested_value, allocator);
-        break;
-      }
-      case Type::Boolean:
-        value.PushBack(element->value_.boolean_value_, allocator);
-        break;
-      case Type::Double:
-        value.PushBack(element->value_.double_value_, allocator);
-        break;
-      case Type::Integer:
-        value.PushBack(element->value_.integer_value_, allocator);
-        break;
-      case Type::Null:
-        value.PushBack(rapidjson::Value(), allocator);
-        break;
-      case Type::String:
-        value.PushBack(rapidjson::StringRef(element->value_.string_value_.c_str()), allocator);
+    if (!handler.StartArray()) {
+      return false;
+    }
+    for (const auto& element : value_.array_value_) {
+      if (!element->accept(handler)) {
+        return false;
       }
     }
-    break;
-  }
+    return handler.EndArray(static_cast<rapidjson::SizeType>(value_.array_value_.size()));
+  }
+  case Type::Boolean:
+    return handler.Bool(value_.boolean_value_);
+  case Type::Double:
+    return handler.Double(value_.double_value_);
+  case Type::Integer:
+    return handler.Int64(value_.integer_value_);
+  case Type::Null:
+    return handler.Null();
   case Type::Object: {
-    value.SetObject();
-    for (const auto& item : field.value_.object_value_) {
-      auto name = rapidjson::StringRef(item.first.c_str());
-
-      switch (item.second->type_) {
-      case Type::Array:
-      case Type::Object: {
-        rapidjson::Value nested_value;
-        buildRapidJsonDocument(*item.second, nested_value, allocator);
-        value.AddMember(name, nested_value, allocator);
-        break;
-      }
-      case Type::Boolean:
-        value.AddMember(name, item.second->value_.boolean_value_, allocator);
-        break;
-      case Type::Double:
-        value.AddMember(name, item.second->value_.double_value_, allocator);
-        break;
-      case Type::Integer:
-        value.AddMember(name, item.second->value_.integer_value_, allocator);
-        break;
-      case Type::Null:
-        value.AddMember(name, rapidjson::Value(), allocator);
-        break;
-      case Type::String:
-        value.AddMember(name, rapidjson::StringRef(item.second->value_.string_value_.c_str()),
-                        allocator);
-        break;
+    if (!handler.StartObject()) {
+      return false;
+    }
+    for (const auto& item : value_.object_value_) {
+      if (!handler.Key(item.first.c_str(), item.first.size(), false) ||
+          !item.second->accept(handler)) {
+        return false;
       }
     }
-    break;
+    return handler.EndObject(static_cast<rapidjson::SizeType>(value_.object_value_.size()));
   }
-  default:
-    NOT_REACHED;
+  case Type::String:
+    return handler.String(value_.string_value_.c_str(), value_.string_value_.size(), false);
   }
-}
 
-rapidjson::Document Field::asRapidJsonDocument() const {
-  rapidjson::Document document;
-  rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
-  buildRapidJsonDocument(*this, document, allocator);
-  return document;
+  NOT_REACHED;
 }
 
 uint64_t Field::hash() const {
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-  asRapidJsonDocument().Accept(writer);
+  accept(writer);
   return HashUtil::xxHash64(buffer.GetString());
 }
 
@@ -474,8 +491,7 @@ std::vector<ObjectSharedPtr> Field::asObjectArray() const {
 std::string Field::asJsonString() const {
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-  rapidjson::Document document = asRapidJsonDocument();
-  document.Accept(writer);
+  accept(writer);
   return buffer.GetString();
 }
 
@@ -507,17 +523,9 @@ void Field::iterate(const ObjectCallback& callback) const {
 }
 
 void Field::validateSchema(const std::string& schema) const {
-  rapidjson::Document schema_document;
-  if (schema_document.Parse<0>(schema.c_str()).HasParseError()) {
-    throw std::invalid_argument(fmt::format(
-        "Schema supplied to validateSchema is not valid JSON\n Error(offset {}) : {}\n",
-        schema_document.GetErrorOffset(), GetParseError_En(schema_document.GetParseError())));
-  }
-
-  rapidjson::SchemaDocument schema_document_for_validator(schema_document);
-  rapidjson::SchemaValidator schema_validator(schema_document_for_validator);
+  rapidjson::SchemaValidator schema_validator(SchemaCache::get(schema));
 
-  if (!asRapidJsonDocument().Accept(schema_validator)) {
+  if (!accept(schema_validator)) {
     rapidjson::StringBuffer schema_string_buffer;
     rapidjson::StringBuffer document_string_buffer;
 
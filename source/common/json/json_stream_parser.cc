@@ -0,0 +1,366 @@
+#include "common/json/json_stream_parser.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Json {
+
+namespace {
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+int hexValue(char c) {
+  if (isDigit(c)) {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// The halves of a surrogate pair are encoded separately, which is enough to compare keys.
+void appendUtf8(std::string& output, uint32_t code_unit) {
+  if (code_unit < 0x80) {
+    output.push_back(code_unit);
+  } else if (code_unit < 0x800) {
+    output.push_back(0xc0 | (code_unit >> 6));
+    output.push_back(0x80 | (code_unit & 0x3f));
+  } else {
+    output.push_back(0xe0 | (code_unit >> 12));
+    output.push_back(0x80 | ((code_unit >> 6) & 0x3f));
+    output.push_back(0x80 | (code_unit & 0x3f));
+  }
+}
+
+void throwUnexpected(char c) {
+  throw Exception(fmt::format("unexpected character '{}' in JSON document", c));
+}
+
+} // namespace
+
+void StreamParser::parse(const Buffer::Instance& data) {
+  uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (Buffer::RawSlice& slice : slices) {
+    parse(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+}
+
+void StreamParser::parse(const char* data, uint64_t length) {
+  uint64_t i = 0;
+  while (i < length && state_ != State::Stopped) {
+    // The character which ends a number is parsed again after the number.
+    if (parseChar(data[i])) {
+      i++;
+    }
+  }
+}
+
+void StreamParser::finish() {
+  if (state_ == State::Number && containers_.empty() && numberComplete()) {
+    endScalar(false);
+  }
+
+  if (state_ != State::Done && state_ != State::Stopped) {
+    throw Exception("truncated JSON document");
+  }
+}
+
+bool StreamParser::parseChar(char c) {
+  switch (state_) {
+  case State::String:
+    parseStringChar(c);
+    return true;
+
+  case State::Number:
+    if (parseNumberChar(c)) {
+      return true;
+    }
+    endScalar(false);
+    return false;
+
+  case State::Literal:
+    if (c != *literal_) {
+      throwUnexpected(c);
+    }
+    if (*++literal_ == '\0') {
+      endValue();
+    }
+    return true;
+
+  default:
+    break;
+  }
+
+  if (isWhitespace(c)) {
+    return true;
+  }
+
+  switch (state_) {
+  case State::ValueOrArrayEnd:
+    if (c == ']') {
+      endContainer();
+      return true;
+    }
+    FALLTHRU;
+  case State::Value:
+    startValue(c);
+    return true;
+
+  case State::KeyOrObjectEnd:
+    if (c == '}') {
+      endContainer();
+      return true;
+    }
+    FALLTHRU;
+  case State::Key:
+    if (c != '"') {
+      throwUnexpected(c);
+    }
+    state_ = State::String;
+    string_is_key_ = true;
+    capture_ = array_depth_ == 0;
+    token_.clear();
+    return true;
+
+  case State::Colon:
+    if (c != ':') {
+      throwUnexpected(c);
+    }
+    state_ = State::Value;
+    return true;
+
+  case State::CommaOrEnd:
+    if (c == ',') {
+      state_ = containers_.back().object_ ? State::Key : State::Value;
+    } else if (c == (containers_.back().object_ ? '}' : ']')) {
+      endContainer();
+    } else {
+      throwUnexpected(c);
+    }
+    return true;
+
+  case State::Done:
+    throw Exception("unexpected data after JSON document");
+
+  default:
+    NOT_REACHED;
+  }
+}
+
+void StreamParser::parseStringChar(char c) {
+  if (unicode_digits_ > 0) {
+    int value = hexValue(c);
+    if (value < 0) {
+      throwUnexpected(c);
+    }
+    code_unit_ = (code_unit_ << 4) | value;
+    if (--unicode_digits_ == 0 && capture_) {
+      appendUtf8(token_, code_unit_);
+    }
+    return;
+  }
+
+  if (escaped_) {
+    escaped_ = false;
+    char unescaped;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      unescaped = c;
+      break;
+    case 'b':
+      unescaped = '\b';
+      break;
+    case 'f':
+      unescaped = '\f';
+      break;
+    case 'n':
+      unescaped = '\n';
+      break;
+    case 'r':
+      unescaped = '\r';
+      break;
+    case 't':
+      unescaped = '\t';
+      break;
+    case 'u':
+      unicode_digits_ = 4;
+      code_unit_ = 0;
+      return;
+    default:
+      throw Exception(fmt::format("invalid escape '\\{}' in JSON string", c));
+    }
+    if (capture_) {
+      token_.push_back(unescaped);
+    }
+    return;
+  }
+
+  if (c == '\\') {
+    escaped_ = true;
+  } else if (c == '"') {
+    if (!string_is_key_) {
+      endScalar(true);
+      return;
+    }
+
+    state_ = State::Colon;
+    want_value_ = false;
+    if (capture_) {
+      key_.swap(token_);
+      want_value_ = callbacks_.onKey(path_, key_);
+    }
+  } else if (static_cast<uint8_t>(c) < 0x20) {
+    throw Exception("control character in JSON string");
+  } else if (capture_) {
+    token_.push_back(c);
+  }
+}
+
+bool StreamParser::parseNumberChar(char c) {
+  switch (number_part_) {
+  case NumberPart::Minus:
+    if (!isDigit(c)) {
+      throwUnexpected(c);
+    }
+    number_part_ = c == '0' ? NumberPart::Zero : NumberPart::Integer;
+    break;
+
+  case NumberPart::Integer:
+    if (isDigit(c)) {
+      break;
+    }
+    FALLTHRU;
+  case NumberPart::Zero:
+    if (c == '.') {
+      number_part_ = NumberPart::FractionStart;
+    } else if (c == 'e' || c == 'E') {
+      number_part_ = NumberPart::ExponentSign;
+    } else {
+      return false;
+    }
+    break;
+
+  case NumberPart::FractionStart:
+    if (!isDigit(c)) {
+      throwUnexpected(c);
+    }
+    number_part_ = NumberPart::Fraction;
+    break;
+
+  case NumberPart::Fraction:
+    if (c == 'e' || c == 'E') {
+      number_part_ = NumberPart::ExponentSign;
+    } else if (!isDigit(c)) {
+      return false;
+    }
+    break;
+
+  case NumberPart::ExponentSign:
+    if (c == '+' || c == '-') {
+      number_part_ = NumberPart::ExponentStart;
+      break;
+    }
+    FALLTHRU;
+  case NumberPart::ExponentStart:
+    if (!isDigit(c)) {
+      throwUnexpected(c);
+    }
+    number_part_ = NumberPart::Exponent;
+    break;
+
+  case NumberPart::Exponent:
+    if (!isDigit(c)) {
+      return false;
+    }
+    break;
+  }
+
+  if (capture_) {
+    token_.push_back(c);
+  }
+  return true;
+}
+
+bool StreamParser::numberComplete() const {
+  return number_part_ == NumberPart::Zero || number_part_ == NumberPart::Integer ||
+         number_part_ == NumberPart::Fraction || number_part_ == NumberPart::Exponent;
+}
+
+void StreamParser::startValue(char c) {
+  capture_ = want_value_;
+  want_value_ = false;
+  token_.clear();
+
+  if (c == '"') {
+    state_ = State::String;
+    string_is_key_ = false;
+  } else if (c == '{' || c == '[') {
+    startContainer(c == '{');
+  } else if (c == '-' || isDigit(c)) {
+    state_ = State::Number;
+    number_part_ = c == '-' ? NumberPart::Minus : c == '0' ? NumberPart::Zero : NumberPart::Integer;
+    if (capture_) {
+      token_.push_back(c);
+    }
+  } else if (c == 't' || c == 'f' || c == 'n') {
+    state_ = State::Literal;
+    literal_ = c == 't' ? "rue" : c == 'f' ? "alse" : "ull";
+  } else {
+    throwUnexpected(c);
+  }
+}
+
+void StreamParser::startContainer(bool object) {
+  const bool keyed = !containers_.empty() && containers_.back().object_ && array_depth_ == 0;
+  if (keyed) {
+    path_.push_back(key_);
+  }
+  if (!object) {
+    array_depth_++;
+  }
+
+  containers_.push_back({object, keyed});
+  state_ = object ? State::KeyOrObjectEnd : State::ValueOrArrayEnd;
+}
+
+void StreamParser::endContainer() {
+  const Container container = containers_.back();
+  containers_.pop_back();
+  if (!container.object_) {
+    array_depth_--;
+  }
+  if (container.keyed_) {
+    path_.pop_back();
+  }
+
+  endValue();
+}
+
+void StreamParser::endScalar(bool is_string) {
+  endValue();
+  if (capture_) {
+    callbacks_.onValue(token_, is_string);
+  }
+}
+
+void StreamParser::endValue() {
+  state_ = containers_.empty() ? State::Done : State::CommaOrEnd;
+}
+
+} // namespace Json
+} // namespace Envoy
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+#include "envoy/json/json_object.h"
+
+namespace Envoy {
+namespace Json {
+
+/**
+ * Callbacks of a StreamParser.
+ */
+class StreamParserCallbacks {
+public:
+  virtual ~StreamParserCallbacks() {}
+
+  /**
+   * Called for each key of an object which is not nested in an array.
+   * @param path supplies the keys of the enclosing objects, outermost first. It is empty for the
+   *        keys of the root object.
+   * @param key supplies the unescaped key.
+   * @return bool whether the value of the key is wanted. A wanted string or number is passed to
+   *         onValue().
+   */
+  virtual bool onKey(const std::vector<std::string>& path, const std::string& key) PURE;
+
+  /**
+   * Called for the value of a wanted key.
+   * @param value supplies the unescaped string, or the text of the number.
+   * @param is_string supplies whether the value is a string rather than a number.
+   */
+  virtual void onValue(const std::string& value, bool is_string) PURE;
+};
+
+/**
+ * Incremental JSON parser, which is fed a document in chunks and reports the keys of its objects
+ * and the values which are asked for. Unlike Factory::loadFromString(), neither the document nor a
+ * DOM is held: only the key or the wanted value being parsed, and the keys of the enclosing
+ * objects.
+ */
+class StreamParser {
+public:
+  StreamParser(StreamParserCallbacks& callbacks) : callbacks_(callbacks) {}
+
+  /**
+   * Parse the next chunk of the document. Does nothing once the parsing has been stopped.
+   * @throw Exception if the document is not valid JSON.
+   */
+  void parse(const Buffer::Instance& data);
+  void parse(const char* data, uint64_t length);
+
+  /**
+   * Check that the document is complete, once all of it has been parsed.
+   * @throw Exception if the document is empty or truncated.
+   */
+  void finish();
+
+  /**
+   * Stop the parsing, when the callbacks have found what they need. The rest of the document is
+   * neither parsed nor checked.
+   */
+  void stop() { state_ = State::Stopped; }
+
+  bool stopped() const { return state_ == State::Stopped; }
+
+private:
+  enum class State {
+    Value,
+    ValueOrArrayEnd,
+    KeyOrObjectEnd,
+    Key,
+    Colon,
+    CommaOrEnd,
+    String,
+    Number,
+    Literal,
+    Done,
+    Stopped
+  };
+
+  // The part of a number which is being parsed, see https://tools.ietf.org/html/rfc7159#section-6
+  enum class NumberPart {
+    Minus,
+    Zero,
+    Integer,
+    FractionStart,
+    Fraction,
+    ExponentSign,
+    ExponentStart,
+    Exponent
+  };
+
+  struct Container {
+    bool object_;
+    // Whether the key of the container was pushed on path_.
+    bool keyed_;
+  };
+
+  bool parseChar(char c);
+  void parseStringChar(char c);
+  bool parseNumberChar(char c);
+  bool numberComplete() const;
+  void startValue(char c);
+  void startContainer(bool object);
+  void endContainer();
+  void endScalar(bool is_string);
+  void endValue();
+
+  StreamParserCallbacks& callbacks_;
+  State state_{State::Value};
+  std::vector<Container> containers_;
+  std::vector<std::string> path_;
+  // The number of arrays in containers_. The keys nested in arrays are not reported.
+  uint32_t array_depth_{};
+  std::string key_;
+  bool want_value_{};
+
+  // The string, number or literal being parsed. Only the reported keys and the wanted values are
+  // accumulated in token_.
+  std::string token_;
+  bool capture_{};
+  bool string_is_key_{};
+  bool escaped_{};
+  uint32_t unicode_digits_{};
+  uint32_t code_unit_{};
+  NumberPart number_part_{};
+  const char* literal_{};
+};
+
+} // namespace Json
+} // namespace Envoy
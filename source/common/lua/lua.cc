@@ -7,6 +7,8 @@
 namespace Envoy {
 namespace Lua {
 
+const uint64_t ThreadLocalState::MAX_POOLED_COROUTINES;
+
 Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state)
     : coroutine_state_(new_thread_state, false) {}
 
@@ -36,25 +38,42 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
     yield_callback();
   } else {
     state_ = State::Finished;
+    failed_ = true;
     const char* error = lua_tostring(coroutine_state_.get(), -1);
     throw LuaException(error);
   }
 }
 
+void Coroutine::reset() {
+  ASSERT(reusable());
+
+  // A thread which returned normally is back at its base call level, so once its stack is cleared
+  // it can be started with a new function just like a new thread.
+  lua_settop(coroutine_state_.get(), 0);
+  state_ = State::NotStarted;
+}
+
 ThreadLocalState::ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls)
     : tls_slot_(tls.allocateSlot()) {
 
-  // First verify that the supplied code can be parsed.
+  // First verify that the supplied code can be parsed. The code is compiled only once, and the
+  // workers load its bytecode rather than parsing it again.
   CSmartPtr<lua_State, lua_close> state(lua_open());
   luaL_openlibs(state.get());
 
-  if (0 != luaL_dostring(state.get(), code.c_str())) {
+  std::string bytecode;
+  if (0 == luaL_loadstring(state.get(), code.c_str())) {
+    int rc = lua_dump(state.get(), writeBytecode, &bytecode);
+    ASSERT(rc == 0);
+    UNREFERENCED_PARAMETER(rc);
+  }
+  if (bytecode.empty() || 0 != lua_pcall(state.get(), 0, LUA_MULTRET, 0)) {
     throw LuaException(fmt::format("script load error: {}", lua_tostring(state.get(), -1)));
   }
 
   // Now initialize on all threads.
-  tls_slot_->set([code](Event::Dispatcher&) {
-    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(code)};
+  tls_slot_->set([code, bytecode](Event::Dispatcher&) {
+    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(code, bytecode)};
   });
 }
 
@@ -81,13 +100,43 @@ uint64_t ThreadLocalState::registerGlobal(const std::string& global) {
 }
 
 CoroutinePtr ThreadLocalState::createCoroutine() {
-  lua_State* state = tls_slot_->getTyped<LuaThreadLocal>().state_.get();
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  if (!tls.coroutine_pool_.empty()) {
+    CoroutinePtr coroutine = std::move(tls.coroutine_pool_.back());
+    tls.coroutine_pool_.pop_back();
+    return coroutine;
+  }
+
+  lua_State* state = tls.state_.get();
   return CoroutinePtr{new Coroutine({lua_newthread(state), state})};
 }
 
-ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& code) : state_(lua_open()) {
+void ThreadLocalState::releaseCoroutine(CoroutinePtr&& coroutine) {
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  if (!coroutine->reusable() || tls.coroutine_pool_.size() >= MAX_POOLED_COROUTINES) {
+    coroutine.reset();
+    return;
+  }
+
+  coroutine->reset();
+  tls.coroutine_pool_.push_back(std::move(coroutine));
+}
+
+int ThreadLocalState::writeBytecode(lua_State*, const void* data, size_t size, void* bytecode) {
+  static_cast<std::string*>(bytecode)->append(static_cast<const char*>(data), size);
+  return 0;
+}
+
+ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& code,
+                                                 const std::string& bytecode)
+    : state_(lua_open()) {
   luaL_openlibs(state_.get());
-  int rc = luaL_dostring(state_.get(), code.c_str());
+  // The chunk is named after the code, as luaL_dostring() does, so that the errors of the script
+  // read the same.
+  int rc = luaL_loadbuffer(state_.get(), bytecode.data(), bytecode.size(), code.c_str());
+  if (rc == 0) {
+    rc = lua_pcall(state_.get(), 0, LUA_MULTRET, 0);
+  }
   ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
@@ -312,9 +312,21 @@ public:
    */
   void resume(int num_args, const std::function<void()>& yield_callback);
 
+  /**
+   * @return whether the coroutine ran to completion without an error, in which case its Lua thread
+   *         can be started again after reset().
+   */
+  bool reusable() { return state_ == State::Finished && !failed_; }
+
+  /**
+   * Clear the stack of a reusable coroutine, so that it can be started again.
+   */
+  void reset();
+
 private:
   LuaRef<lua_State> coroutine_state_;
   State state_{State::NotStarted};
+  bool failed_{};
 };
 
 typedef std::unique_ptr<Coroutine> CoroutinePtr;
@@ -329,10 +341,19 @@ public:
   ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls);
 
   /**
-   * @return CoroutinePtr a new coroutine.
+   * @return CoroutinePtr a coroutine which is not started, either new or taken from the pool of
+   *         the worker.
    */
   CoroutinePtr createCoroutine();
 
+  /**
+   * Return a coroutine which is no longer used to the pool of the worker. The coroutine is pooled
+   * only if it ran to completion without an error, and if the pool is not full. Otherwise it is
+   * destroyed.
+   * @param coroutine supplies the coroutine, which must have been created on this worker.
+   */
+  void releaseCoroutine(CoroutinePtr&& coroutine);
+
   /**
    * @return a global reference previously registered via registerGlobal(). This may return
    *         LUA_REFNIL if there was no such global.
@@ -356,12 +377,21 @@ public:
         [this]() { T::registerType(tls_slot_->getTyped<LuaThreadLocal>().state_.get()); });
   }
 
+  /**
+   * The maximum number of finished coroutines which each worker keeps for reuse.
+   */
+  static const uint64_t MAX_POOLED_COROUTINES = 128;
+
 private:
+  static int writeBytecode(lua_State* state, const void* data, size_t size, void* bytecode);
+
   struct LuaThreadLocal : public ThreadLocal::ThreadLocalObject {
-    LuaThreadLocal(const std::string& code);
+    LuaThreadLocal(const std::string& code, const std::string& bytecode);
 
     CSmartPtr<lua_State, lua_close> state_;
     std::vector<int> global_slots_;
+    // Declared after state_ so that the pooled coroutines are unreferenced before it is closed.
+    std::vector<CoroutinePtr> coroutine_pool_;
   };
 
   ThreadLocal::SlotPtr tls_slot_;
@@ -1,5 +1,8 @@
 #include "common/lua/wrappers.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Envoy {
 namespace Lua {
 
@@ -23,5 +26,73 @@ int BufferWrapper::luaGetBytes(lua_State* state) {
   return 1;
 }
 
+int BufferWrapper::luaFind(lua_State* state) {
+  size_t size;
+  const char* needle = luaL_checklstring(state, 2, &size);
+  const int start = luaL_optint(state, 3, 0);
+  if (start < 0) {
+    luaL_error(state, "index must be >= 0");
+  }
+
+  const ssize_t index = data_.search(needle, size, start);
+  if (index < 0) {
+    lua_pushnil(state);
+  } else {
+    lua_pushnumber(state, index);
+  }
+  return 1;
+}
+
+int BufferWrapper::luaStartsWith(lua_State* state) {
+  size_t size;
+  const char* prefix = luaL_checklstring(state, 2, &size);
+  if (size > data_.length()) {
+    lua_pushboolean(state, false);
+    return 1;
+  }
+
+  uint64_t num_slices = data_.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data_.getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    if (size == 0) {
+      break;
+    }
+
+    const size_t compared = std::min<size_t>(size, slice.len_);
+    if (memcmp(slice.mem_, prefix, compared) != 0) {
+      lua_pushboolean(state, false);
+      return 1;
+    }
+    prefix += compared;
+    size -= compared;
+  }
+
+  lua_pushboolean(state, true);
+  return 1;
+}
+
+int BufferWrapper::luaRawSlices(lua_State* state) {
+  lua_pushvalue(state, 1);
+  lua_pushnumber(state, 0);
+  lua_pushcclosure(state, static_luaRawSlicesIterator, 2);
+  return 1;
+}
+
+int BufferWrapper::luaRawSlicesIterator(lua_State* state) {
+  const uint64_t index = lua_tonumber(state, lua_upvalueindex(2));
+  uint64_t num_slices = data_.getRawSlices(nullptr, 0);
+  if (index >= num_slices) {
+    return 0;
+  }
+
+  Buffer::RawSlice slices[num_slices];
+  data_.getRawSlices(slices, num_slices);
+  lua_pushnumber(state, index + 1);
+  lua_replace(state, lua_upvalueindex(2));
+  lua_pushlstring(state, static_cast<const char*>(slices[index].mem_), slices[index].len_);
+  return 1;
+}
+
 } // namespace Lua
 } // namespace Envoy
@@ -15,7 +15,11 @@ public:
   BufferWrapper(const Buffer::Instance& data) : data_(data) {}
 
   static ExportedFunctions exportedFunctions() {
-    return {{"length", static_luaLength}, {"getBytes", static_luaGetBytes}};
+    return {{"length", static_luaLength},
+            {"getBytes", static_luaGetBytes},
+            {"find", static_luaFind},
+            {"startsWith", static_luaStartsWith},
+            {"rawSlices", static_luaRawSlices}};
   }
 
 private:
@@ -32,6 +36,33 @@ private:
    */
   DECLARE_LUA_FUNCTION(BufferWrapper, luaGetBytes);
 
+  /**
+   * Search the buffer in place, without copying it out.
+   * @param 1 (string) the bytes to search for.
+   * @param 2 (int) optional starting index of the search. Defaults to 0.
+   * @return int the index of the first occurrence, or nil if the bytes are not found.
+   */
+  DECLARE_LUA_FUNCTION(BufferWrapper, luaFind);
+
+  /**
+   * Compare the start of the buffer in place, without copying it out.
+   * @param 1 (string) the prefix to compare.
+   * @return bool whether the buffer starts with the prefix.
+   */
+  DECLARE_LUA_FUNCTION(BufferWrapper, luaStartsWith);
+
+  /**
+   * Iterate over the slices of the buffer, e.g. "for slice in buffer:rawSlices() do". Only one
+   * slice at a time is copied into a Lua string, rather than the whole buffer.
+   * @return function an iterator which returns the bytes of the next slice.
+   */
+  DECLARE_LUA_FUNCTION(BufferWrapper, luaRawSlices);
+
+  /**
+   * The iterator returned by rawSlices(). The index of the next slice is in upvalue slot 2.
+   */
+  DECLARE_LUA_CLOSURE(BufferWrapper, luaRawSlicesIterator);
+
   const Buffer::Instance& data_;
 };
 
@@ -1,7 +1,30 @@
 #include "common/memory/stats.h"
 
+#include <atomic>
 #include <cstdint>
 
+namespace Envoy {
+namespace Memory {
+
+namespace {
+// Buffer slabs are allocated and freed on every worker, so this is a single relaxed atomic rather
+// than anything heavier. Readers only need an approximate value.
+std::atomic<uint64_t> buffer_slab_bytes{0};
+} // namespace
+
+uint64_t Stats::totalBufferSlabBytes() { return buffer_slab_bytes.load(std::memory_order_relaxed); }
+
+void Stats::addBufferSlabBytes(uint64_t bytes) {
+  buffer_slab_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Stats::subtractBufferSlabBytes(uint64_t bytes) {
+  buffer_slab_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+} // namespace Memory
+} // namespace Envoy
+
 #ifdef TCMALLOC
 
 #include "gperftools/malloc_extension.h"
@@ -21,6 +44,18 @@ uint64_t Stats::totalCurrentlyReserved() {
   return value;
 }
 
+uint64_t Stats::totalPageHeapFree() {
+  size_t value = 0;
+  MallocExtension::instance()->GetNumericProperty("tcmalloc.pageheap_free_bytes", &value);
+  return value;
+}
+
+uint64_t Stats::totalPageHeapUnmapped() {
+  size_t value = 0;
+  MallocExtension::instance()->GetNumericProperty("tcmalloc.pageheap_unmapped_bytes", &value);
+  return value;
+}
+
 } // namespace Memory
 } // namespace Envoy
 
@@ -31,6 +66,8 @@ namespace Memory {
 
 uint64_t Stats::totalCurrentlyAllocated() { return 0; }
 uint64_t Stats::totalCurrentlyReserved() { return 0; }
+uint64_t Stats::totalPageHeapFree() { return 0; }
+uint64_t Stats::totalPageHeapUnmapped() { return 0; }
 
 } // namespace Memory
 } // namespace Envoy
@@ -20,6 +20,32 @@ public:
    *                  allocated.
    */
   static uint64_t totalCurrentlyReserved();
+
+  /**
+   * @return uint64_t the memory reserved by the heap which is free and mapped, and so is still
+   *                  counted in the resident size of the process.
+   */
+  static uint64_t totalPageHeapFree();
+
+  /**
+   * @return uint64_t the memory reserved by the heap which is free and was returned to the
+   *                  operating system.
+   */
+  static uint64_t totalPageHeapUnmapped();
+
+  /**
+   * @return uint64_t the total slab memory currently held by data buffers (connection, codec and
+   *                  filter buffers). This does not include slabs cached for reuse.
+   */
+  static uint64_t totalBufferSlabBytes();
+
+  /**
+   * Account for slab memory handed to or returned from a buffer. Only called by the buffer slab
+   * allocator.
+   * @param bytes supplies the number of bytes.
+   */
+  static void addBufferSlabBytes(uint64_t bytes);
+  static void subtractBufferSlabBytes(uint64_t bytes);
 };
 
 } // namespace Memory
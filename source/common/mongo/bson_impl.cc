@@ -4,6 +4,7 @@
 #include <sstream>
 #include <string>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/byte_order.h"
 #include "common/common/hex.h"
@@ -355,6 +356,144 @@ std::string FieldImpl::toString() const {
   NOT_REACHED;
 }
 
+namespace {
+
+int32_t encodedInt32(const std::string& encoded, uint64_t offset) {
+  if (offset + sizeof(int32_t) > encoded.size()) {
+    throw EnvoyException("invalid buffer size");
+  }
+
+  int32_t val;
+  std::memcpy(reinterpret_cast<void*>(&val), encoded.data() + offset, sizeof(int32_t));
+  return le32toh(val);
+}
+
+uint64_t encodedCStringEnd(const std::string& encoded, uint64_t offset) {
+  const size_t end = encoded.find('\0', offset);
+  if (end == std::string::npos) {
+    throw EnvoyException("invalid CString");
+  }
+
+  return end + 1;
+}
+
+/**
+ * @return uint64_t the offset which follows the value of an encoded field.
+ */
+uint64_t encodedValueEnd(Field::Type type, const std::string& encoded, uint64_t offset) {
+  switch (type) {
+  case Field::Type::DOUBLE:
+  case Field::Type::DATETIME:
+  case Field::Type::TIMESTAMP:
+  case Field::Type::INT64:
+    return offset + 8;
+
+  case Field::Type::STRING:
+  case Field::Type::BINARY: {
+    const int32_t length = encodedInt32(encoded, offset);
+    if (length < 0) {
+      throw EnvoyException("invalid BSON string length");
+    }
+    // The binary subtype follows the length.
+    return offset + sizeof(int32_t) + length + (type == Field::Type::BINARY ? 1 : 0);
+  }
+
+  case Field::Type::DOCUMENT:
+  case Field::Type::ARRAY: {
+    const int32_t length = encodedInt32(encoded, offset);
+    if (length < 5) {
+      throw EnvoyException("invalid BSON message length");
+    }
+    return offset + length;
+  }
+
+  case Field::Type::OBJECT_ID:
+    return offset + sizeof(Field::ObjectId);
+
+  case Field::Type::BOOLEAN:
+    return offset + 1;
+
+  case Field::Type::NULL_VALUE:
+    return offset;
+
+  case Field::Type::REGEX:
+    return encodedCStringEnd(encoded, encodedCStringEnd(encoded, offset));
+
+  case Field::Type::INT32:
+    return offset + sizeof(int32_t);
+  }
+
+  throw EnvoyException(fmt::format("invalid BSON element type: {:#x}", static_cast<uint8_t>(type)));
+}
+
+} // namespace
+
+DocumentSharedPtr DocumentImpl::createLazy(Buffer::Instance& data) {
+  const int32_t message_length = BufferHelper::peakInt32(data);
+  if (message_length < 5 || static_cast<uint64_t>(message_length) > data.length()) {
+    throw EnvoyException("invalid BSON message length");
+  }
+
+  std::shared_ptr<DocumentImpl> new_doc{new DocumentImpl()};
+  new_doc->encoded_.resize(message_length);
+  data.copyOut(0, message_length, &new_doc->encoded_[0]);
+  data.drain(message_length);
+  if (new_doc->encoded_.back() != 0) {
+    throw EnvoyException("invalid document");
+  }
+
+  return new_doc;
+}
+
+void DocumentImpl::decode() const {
+  if (encoded_.empty()) {
+    return;
+  }
+
+  Buffer::OwnedImpl data(encoded_.data(), encoded_.size());
+  encoded_.clear();
+  // Decoding fills the fields through the add*() functions, which are not const.
+  const_cast<DocumentImpl*>(this)->fromBuffer(data);
+}
+
+const Field* DocumentImpl::findEncoded(const std::string& name, const Field::Type* type) const {
+  for (const FieldPtr& field : found_fields_) {
+    if (field->key() == name && (!type || field->type() == *type)) {
+      return field.get();
+    }
+  }
+
+  // Skip over the fields until one matches, the last byte is the terminator of the document.
+  const uint64_t end = encoded_.size() - 1;
+  uint64_t offset = sizeof(int32_t);
+  while (offset < end) {
+    const uint64_t field_start = offset;
+    const Field::Type field_type = static_cast<Field::Type>(encoded_[offset]);
+    const uint64_t key_start = offset + 1;
+    const uint64_t key_end = encodedCStringEnd(encoded_, key_start);
+    offset = encodedValueEnd(field_type, encoded_, key_end);
+    if (offset > end) {
+      throw EnvoyException("invalid document");
+    }
+
+    if ((!type || field_type == *type) &&
+        encoded_.compare(key_start, key_end - key_start - 1, name) == 0) {
+      // Decode the field alone, as the only field of a document.
+      Buffer::OwnedImpl data;
+      BufferHelper::writeInt32(data, sizeof(int32_t) + (offset - field_start) + 1);
+      data.add(encoded_.data() + field_start, offset - field_start);
+      uint8_t done = 0;
+      data.add(&done, sizeof(done));
+      std::shared_ptr<DocumentImpl> document{new DocumentImpl()};
+      document->fromBuffer(data);
+      found_fields_.splice(found_fields_.end(), document->fields_);
+      return found_fields_.back().get();
+    }
+  }
+
+  return nullptr;
+}
+
 void DocumentImpl::fromBuffer(Buffer::Instance& data) {
   uint64_t original_buffer_length = data.length();
   int32_t message_length = BufferHelper::removeInt32(data);
@@ -479,6 +618,10 @@ void DocumentImpl::fromBuffer(Buffer::Instance& data) {
 }
 
 int32_t DocumentImpl::byteSize() const {
+  if (!encoded_.empty()) {
+    return encoded_.size();
+  }
+
   // Minimum size is 5.
   int32_t total_size = sizeof(int32_t) + 1;
   for (const FieldPtr& field : fields_) {
@@ -489,6 +632,11 @@ int32_t DocumentImpl::byteSize() const {
 }
 
 void DocumentImpl::encode(Buffer::Instance& output) const {
+  if (!encoded_.empty()) {
+    output.add(encoded_.data(), encoded_.size());
+    return;
+  }
+
   BufferHelper::writeInt32(output, byteSize());
   for (const FieldPtr& field : fields_) {
     field->encode(output);
@@ -519,7 +667,7 @@ std::string DocumentImpl::toString() const {
   out << "{";
 
   bool first = true;
-  for (const FieldPtr& field : fields_) {
+  for (const FieldPtr& field : values()) {
     if (!first) {
       out << ", ";
     }
@@ -533,6 +681,10 @@ std::string DocumentImpl::toString() const {
 }
 
 const Field* DocumentImpl::find(const std::string& name) const {
+  if (!encoded_.empty()) {
+    return findEncoded(name, nullptr);
+  }
+
   for (const FieldPtr& field : fields_) {
     if (field->key() == name) {
       return field.get();
@@ -543,6 +695,10 @@ const Field* DocumentImpl::find(const std::string& name) const {
 }
 
 const Field* DocumentImpl::find(const std::string& name, Field::Type type) const {
+  if (!encoded_.empty()) {
+    return findEncoded(name, &type);
+  }
+
   for (const FieldPtr& field : fields_) {
     if (field->key() == name && field->type() == type) {
       return field.get();
@@ -179,68 +179,90 @@ public:
     return new_doc;
   }
 
+  /**
+   * Create a document which keeps its encoded bytes and only decodes its fields when they are
+   * accessed: find() decodes the field which is found, while values(), toString() and operator==
+   * decode all of them. byteSize() and encode() do not decode anything. Only the length and the
+   * terminator of the document are checked when it is created, so an invalid field throws when
+   * it is decoded.
+   */
+  static DocumentSharedPtr createLazy(Buffer::Instance& data);
+
   // Mongo::Document
   DocumentSharedPtr addDouble(const std::string& key, double value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addString(const std::string& key, std::string&& value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::STRING, key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addDocument(const std::string& key, DocumentSharedPtr value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::DOCUMENT, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addArray(const std::string& key, DocumentSharedPtr value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::ARRAY, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addBinary(const std::string& key, std::string&& value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::BINARY, key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addObjectId(const std::string& key, Field::ObjectId&& value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addBoolean(const std::string& key, bool value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addDatetime(const std::string& key, int64_t value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::DATETIME, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addNull(const std::string& key) override {
+    decode();
     fields_.emplace_back(new FieldImpl(key));
     return shared_from_this();
   }
 
   DocumentSharedPtr addRegex(const std::string& key, Field::Regex&& value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(key, std::move(value)));
     return shared_from_this();
   }
 
   DocumentSharedPtr addInt32(const std::string& key, int32_t value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addTimestamp(const std::string& key, int64_t value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::TIMESTAMP, key, value));
     return shared_from_this();
   }
 
   DocumentSharedPtr addInt64(const std::string& key, int64_t value) override {
+    decode();
     fields_.emplace_back(new FieldImpl(Field::Type::INT64, key, value));
     return shared_from_this();
   }
@@ -251,14 +273,24 @@ public:
   const Field* find(const std::string& name) const override;
   const Field* find(const std::string& name, Field::Type type) const override;
   std::string toString() const override;
-  const std::list<FieldPtr>& values() const override { return fields_; }
+  const std::list<FieldPtr>& values() const override {
+    decode();
+    return fields_;
+  }
 
 private:
   DocumentImpl() {}
 
   void fromBuffer(Buffer::Instance& data);
-
-  std::list<FieldPtr> fields_;
+  void decode() const;
+  const Field* findEncoded(const std::string& name, const Field::Type* type) const;
+
+  // The fields, once decoded.
+  mutable std::list<FieldPtr> fields_;
+  // The encoded document, until it is decoded.
+  mutable std::string encoded_;
+  // The fields decoded by find() before the document is decoded.
+  mutable std::list<FieldPtr> found_fields_;
 };
 
 } // namespace Bson
@@ -1,5 +1,6 @@
 #include "common/mongo/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <list>
 #include <memory>
@@ -10,6 +11,7 @@
 #include "envoy/common/exception.h"
 
 #include "common/common/assert.h"
+#include "common/common/byte_order.h"
 #include "common/mongo/bson_impl.h"
 
 #include "fmt/format.h"
@@ -42,7 +44,9 @@ void GetMoreMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
   full_collection_name_ = Bson::BufferHelper::removeCString(data);
   number_to_return_ = Bson::BufferHelper::removeInt32(data);
   cursor_id_ = Bson::BufferHelper::removeInt64(data);
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool GetMoreMessageImpl::operator==(const GetMoreMessage& rhs) const {
@@ -66,10 +70,12 @@ void InsertMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& da
   flags_ = Bson::BufferHelper::removeInt32(data);
   full_collection_name_ = Bson::BufferHelper::removeCString(data);
   while (data.length() - (original_buffer_length - message_length) > 0) {
-    documents_.emplace_back(Bson::DocumentImpl::create(data));
+    documents_.emplace_back(Bson::DocumentImpl::createLazy(data));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool InsertMessageImpl::operator==(const InsertMessage& rhs) const {
@@ -105,7 +111,9 @@ void KillCursorsMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
     cursor_ids_.push_back(Bson::BufferHelper::removeInt64(data));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool KillCursorsMessageImpl::operator==(const KillCursorsMessage& rhs) const {
@@ -140,13 +148,15 @@ void QueryMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& dat
   full_collection_name_ = Bson::BufferHelper::removeCString(data);
   number_to_skip_ = Bson::BufferHelper::removeInt32(data);
   number_to_return_ = Bson::BufferHelper::removeInt32(data);
-  query_ = Bson::DocumentImpl::create(data);
+  query_ = Bson::DocumentImpl::createLazy(data);
 
   if (data.length() - (original_buffer_length - message_length) > 0) {
-    return_fields_selector_ = Bson::DocumentImpl::create(data);
+    return_fields_selector_ = Bson::DocumentImpl::createLazy(data);
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool QueryMessageImpl::operator==(const QueryMessage& rhs) const {
@@ -181,6 +191,20 @@ std::string QueryMessageImpl::toString(bool full) const {
       return_fields_selector_ ? return_fields_selector_->toString() : "{}");
 }
 
+const uint32_t ReplyMessageImpl::HEADER_SIZE;
+
+void ReplyMessageImpl::headerFromBuffer(uint32_t message_length, Buffer::Instance& data) {
+  if (message_length < HEADER_SIZE) {
+    throw EnvoyException("invalid reply message length");
+  }
+
+  flags_ = Bson::BufferHelper::removeInt32(data);
+  cursor_id_ = Bson::BufferHelper::removeInt64(data);
+  starting_from_ = Bson::BufferHelper::removeInt32(data);
+  number_returned_ = Bson::BufferHelper::removeInt32(data);
+  skipped_documents_byte_size_ = message_length - HEADER_SIZE;
+}
+
 void ReplyMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
   ENVOY_LOG(trace, "decoding reply message");
   flags_ = Bson::BufferHelper::removeInt32(data);
@@ -188,10 +212,20 @@ void ReplyMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
   starting_from_ = Bson::BufferHelper::removeInt32(data);
   number_returned_ = Bson::BufferHelper::removeInt32(data);
   for (int32_t i = 0; i < number_returned_; i++) {
-    documents_.emplace_back(Bson::DocumentImpl::create(data));
+    documents_.emplace_back(Bson::DocumentImpl::createLazy(data));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
+}
+
+uint64_t ReplyMessageImpl::documentsByteSize() const {
+  uint64_t byte_size = skipped_documents_byte_size_;
+  for (const Bson::DocumentSharedPtr& document : documents_) {
+    byte_size += document->byteSize();
+  }
+  return byte_size;
 }
 
 bool ReplyMessageImpl::operator==(const ReplyMessage& rhs) const {
@@ -229,7 +263,7 @@ bool DecoderImpl::decode(Buffer::Instance& data) {
 
   uint32_t message_length = Bson::BufferHelper::peakInt32(data);
   ENVOY_LOG(trace, "message is {} bytes", message_length);
-  if (data.length() < message_length) {
+  if (data.length() < message_length && !replyHeaderBuffered(data)) {
     return false;
   }
 
@@ -246,7 +280,12 @@ bool DecoderImpl::decode(Buffer::Instance& data) {
   switch (op_code) {
   case Message::OpCode::OP_REPLY: {
     std::unique_ptr<ReplyMessageImpl> message(new ReplyMessageImpl(request_id, response_to));
-    message->fromBuffer(message_length, data);
+    if (decode_reply_documents_) {
+      message->fromBuffer(message_length, data);
+    } else {
+      message->headerFromBuffer(message_length, data);
+      reply_bytes_to_skip_ = message->documentsByteSize();
+    }
     callbacks_.decodeReply(std::move(message));
     break;
   }
@@ -288,9 +327,27 @@ bool DecoderImpl::decode(Buffer::Instance& data) {
   return true;
 }
 
+bool DecoderImpl::replyHeaderBuffered(Buffer::Instance& data) {
+  if (decode_reply_documents_ || data.length() < 16 + ReplyMessageImpl::HEADER_SIZE) {
+    return false;
+  }
+
+  int32_t op_code;
+  data.copyOut(12, sizeof(int32_t), &op_code);
+  return static_cast<Message::OpCode>(le32toh(op_code)) == Message::OpCode::OP_REPLY;
+}
+
 void DecoderImpl::onData(Buffer::Instance& data) {
-  while (data.length() > 0 && decode(data))
-    ;
+  while (data.length() > 0) {
+    if (reply_bytes_to_skip_ > 0) {
+      uint64_t skipped = std::min<uint64_t>(reply_bytes_to_skip_, data.length());
+      ENVOY_LOG(trace, "skipping {} bytes of reply documents", skipped);
+      data.drain(skipped);
+      reply_bytes_to_skip_ -= skipped;
+    } else if (!decode(data)) {
+      break;
+    }
+  }
 }
 
 void EncoderImpl::encodeCommonHeader(int32_t total_size, const Message& message,
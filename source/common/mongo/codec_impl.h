@@ -161,6 +161,12 @@ public:
   // MessageImpl
   void fromBuffer(uint32_t message_length, Buffer::Instance& data) override;
 
+  /**
+   * Decode the header of the reply, leaving its documents in the buffer.
+   * @param message_length supplies the length of the message without the common header.
+   */
+  void headerFromBuffer(uint32_t message_length, Buffer::Instance& data);
+
   // Mongo::Message
   std::string toString(bool full) const override;
 
@@ -176,6 +182,10 @@ public:
   void numberReturned(int32_t number_returned) override { number_returned_ = number_returned; }
   const std::list<Bson::DocumentSharedPtr>& documents() const override { return documents_; }
   std::list<Bson::DocumentSharedPtr>& documents() override { return documents_; }
+  uint64_t documentsByteSize() const override;
+
+  // The size of the header which precedes the documents.
+  static const uint32_t HEADER_SIZE = 20;
 
 private:
   int32_t flags_{};
@@ -183,19 +193,30 @@ private:
   int32_t starting_from_{};
   int32_t number_returned_{};
   std::list<Bson::DocumentSharedPtr> documents_;
+  // Set by headerFromBuffer(), as the documents are not decoded.
+  uint64_t skipped_documents_byte_size_{};
 };
 
 class DecoderImpl : public Decoder, Logger::Loggable<Logger::Id::mongo> {
 public:
-  DecoderImpl(DecoderCallbacks& callbacks) : callbacks_(callbacks) {}
+  /**
+   * @param decode_reply_documents supplies whether the documents of replies are decoded. If not,
+   *        the replies are delivered as soon as their header is buffered, without documents, and
+   *        the documents are drained as they arrive instead of being buffered.
+   */
+  DecoderImpl(DecoderCallbacks& callbacks, bool decode_reply_documents = true)
+      : callbacks_(callbacks), decode_reply_documents_(decode_reply_documents) {}
 
   // Mongo::Decoder
   void onData(Buffer::Instance& data) override;
 
 private:
   bool decode(Buffer::Instance& data);
+  bool replyHeaderBuffered(Buffer::Instance& data);
 
   DecoderCallbacks& callbacks_;
+  const bool decode_reply_documents_;
+  uint64_t reply_bytes_to_skip_{};
 };
 
 class EncoderImpl : public Encoder, Logger::Loggable<Logger::Id::mongo> {
@@ -58,7 +58,9 @@ void ProxyFilter::decodeGetMore(GetMoreMessagePtr&& message) {
 
   stats_.op_get_more_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded GET_MORE: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded GET_MORE: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeInsert(InsertMessagePtr&& message) {
@@ -66,7 +68,9 @@ void ProxyFilter::decodeInsert(InsertMessagePtr&& message) {
 
   stats_.op_insert_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded INSERT: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded INSERT: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeKillCursors(KillCursorsMessagePtr&& message) {
@@ -74,7 +78,9 @@ void ProxyFilter::decodeKillCursors(KillCursorsMessagePtr&& message) {
 
   stats_.op_kill_cursors_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded KILL_CURSORS: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded KILL_CURSORS: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
@@ -82,7 +88,9 @@ void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
 
   stats_.op_query_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded QUERY: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded QUERY: {}", message->toString(true));
+  }
 
   if (message->flags() & QueryMessage::Flags::TailableCursor) {
     stats_.op_query_tailable_cursor_.inc();
@@ -144,7 +152,9 @@ void ProxyFilter::chargeQueryStats(const std::string& prefix,
 void ProxyFilter::decodeReply(ReplyMessagePtr&& message) {
   stats_.op_reply_.inc();
   logMessage(*message, false);
-  ENVOY_LOG(debug, "decoded REPLY: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded REPLY: {}", message->toString(true));
+  }
 
   if (message->cursorId() != 0) {
     stats_.op_reply_valid_cursor_.inc();
@@ -210,14 +220,13 @@ void ProxyFilter::onDrainClose() {
 
 void ProxyFilter::chargeReplyStats(ActiveQuery& active_query, const std::string& prefix,
                                    const ReplyMessage& message) {
-  uint64_t reply_documents_byte_size = 0;
-  for (const Bson::DocumentSharedPtr& document : message.documents()) {
-    reply_documents_byte_size += document->byteSize();
-  }
+  // The documents are not decoded if the decoder skips them, in which case the header of the reply
+  // supplies their number.
+  uint64_t reply_num_docs =
+      message.documents().empty() ? message.numberReturned() : message.documents().size();
 
-  scope_.histogram(fmt::format("{}.reply_num_docs", prefix))
-      .recordValue(message.documents().size());
-  scope_.histogram(fmt::format("{}.reply_size", prefix)).recordValue(reply_documents_byte_size);
+  scope_.histogram(fmt::format("{}.reply_num_docs", prefix)).recordValue(reply_num_docs);
+  scope_.histogram(fmt::format("{}.reply_size", prefix)).recordValue(message.documentsByteSize());
   scope_.histogram(fmt::format("{}.reply_time_ms", prefix))
       .recordValue(std::chrono::duration_cast<std::chrono::milliseconds>(
                        std::chrono::steady_clock::now() - active_query.start_time_)
@@ -290,7 +299,9 @@ Network::FilterStatus ProxyFilter::onWrite(Buffer::Instance& data) {
 }
 
 DecoderPtr ProdProxyFilter::createDecoder(DecoderCallbacks& callbacks) {
-  return DecoderPtr{new DecoderImpl(callbacks)};
+  return DecoderPtr{new DecoderImpl(
+      callbacks,
+      runtime().snapshot().featureEnabled(MongoRuntimeConfig::get().DecodeReplyDocuments, 100))};
 }
 
 Optional<uint64_t> ProxyFilter::delayDuration() {
@@ -0,0 +1,150 @@
+#include "common/network/caching_dns_resolver_impl.h"
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include "common/common/assert.h"
+#include "common/common/enum_to_int.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Network {
+
+const std::chrono::milliseconds CachingDnsResolverImpl::NEGATIVE_TTL{1000};
+
+CachingDnsResolverImpl::CachingDnsResolverImpl(Event::Dispatcher& dispatcher,
+                                               DnsResolverSharedPtr resolver,
+                                               std::chrono::milliseconds ttl, Stats::Scope& scope,
+                                               MonotonicTimeSource& time_source)
+    : resolver_(resolver), ttl_(ttl),
+      stats_({ALL_DNS_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "dns_cache."))}),
+      time_source_(time_source),
+      ready_timer_(dispatcher.createTimer([this]() -> void { deliverReadyQueries(); })) {}
+
+CachingDnsResolverImpl::~CachingDnsResolverImpl() {
+  for (auto& entry : cache_) {
+    if (entry.second.active_query_ != nullptr) {
+      entry.second.active_query_->cancel();
+    }
+  }
+}
+
+ActiveDnsQuery* CachingDnsResolverImpl::resolve(const std::string& dns_name,
+                                                DnsLookupFamily dns_lookup_family,
+                                                ResolveCb callback) {
+  const MonotonicTime now = time_source_.currentTime();
+  removeExpiredEntries(now);
+
+  const std::string key = fmt::format("{}/{}", enumToInt(dns_lookup_family), dns_name);
+  CacheEntry& entry = cache_[key];
+
+  if (entry.resolved_ && now < entry.expiry_time_) {
+    stats_.cache_hit_.inc();
+    if (now >= entry.refresh_time_ && !entry.resolving_) {
+      stats_.prefetch_.inc();
+      startResolve(key, entry, dns_name, dns_lookup_family);
+    }
+
+    PendingQueryPtr query(new PendingQuery(ready_queries_, callback));
+    query->address_list_ = entry.address_list_;
+    PendingQuery* ret = query.get();
+    query->moveIntoListBack(std::move(query), ready_queries_);
+    ready_timer_->enableTimer(std::chrono::milliseconds(0));
+    return ret;
+  }
+
+  PendingQueryPtr query(new PendingQuery(entry.waiters_, callback));
+  PendingQuery* ret = query.get();
+  query->moveIntoListBack(std::move(query), entry.waiters_);
+  if (entry.resolving_) {
+    stats_.query_coalesced_.inc();
+    return ret;
+  }
+
+  stats_.cache_miss_.inc();
+  const uint64_t completions = entry.completions_;
+  startResolve(key, entry, dns_name, dns_lookup_family);
+  // The wrapped resolver may have completed inline, in which case the query was delivered.
+  return entry.completions_ == completions ? ret : nullptr;
+}
+
+void CachingDnsResolverImpl::startResolve(const std::string& key, CacheEntry& entry,
+                                          const std::string& dns_name,
+                                          DnsLookupFamily dns_lookup_family) {
+  ASSERT(!entry.resolving_);
+  ENVOY_LOG(debug, "dns cache: resolving '{}'", key);
+  entry.resolving_ = true;
+  const uint64_t completions = entry.completions_;
+  nesting_++;
+  ActiveDnsQuery* active_query = resolver_->resolve(
+      dns_name, dns_lookup_family,
+      [this, &entry](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+        onResolved(entry, std::move(address_list));
+      });
+  nesting_--;
+  if (entry.completions_ == completions) {
+    entry.active_query_ = active_query;
+  }
+}
+
+void CachingDnsResolverImpl::onResolved(CacheEntry& entry,
+                                        std::list<Address::InstanceConstSharedPtr>&& address_list) {
+  const MonotonicTime now = time_source_.currentTime();
+  const std::chrono::milliseconds ttl = address_list.empty() ? std::min(ttl_, NEGATIVE_TTL) : ttl_;
+  entry.address_list_ = std::move(address_list);
+  entry.expiry_time_ = now + ttl;
+  entry.refresh_time_ = now + ttl * 3 / 4;
+  entry.resolved_ = true;
+  entry.resolving_ = false;
+  entry.active_query_ = nullptr;
+
+  entry.completions_++;
+
+  // The waiters are taken off the entry first: a callback may resolve the same name again, which
+  // may start another query. It may also cancel one of the other waiters.
+  const std::list<Address::InstanceConstSharedPtr> entry_address_list = entry.address_list_;
+  std::list<PendingQueryPtr> waiters;
+  waiters.swap(entry.waiters_);
+  for (PendingQueryPtr& query : waiters) {
+    query->list_ = &waiters;
+  }
+  nesting_++;
+  while (!waiters.empty()) {
+    PendingQueryPtr query = waiters.front()->removeFromList(waiters);
+    std::list<Address::InstanceConstSharedPtr> address_list = entry_address_list;
+    query->callback_(std::move(address_list));
+  }
+  nesting_--;
+}
+
+void CachingDnsResolverImpl::deliverReadyQueries() {
+  // Queries which become ready while delivering are delivered by the next run of the timer.
+  std::list<PendingQueryPtr>::size_type ready = ready_queries_.size();
+  while (ready-- > 0 && !ready_queries_.empty()) {
+    PendingQueryPtr query = ready_queries_.front()->removeFromList(ready_queries_);
+    query->callback_(std::move(query->address_list_));
+  }
+}
+
+void CachingDnsResolverImpl::removeExpiredEntries(MonotonicTime now) {
+  // Entries are only removed when no caller up the stack may still use one.
+  if (nesting_ > 0) {
+    return;
+  }
+
+  for (auto it = cache_.begin(); it != cache_.end();) {
+    const CacheEntry& entry = it->second;
+    if (entry.resolved_ && now >= entry.expiry_time_ && !entry.resolving_ &&
+        entry.waiters_.empty()) {
+      it = cache_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+} // namespace Network
+} // namespace Envoy
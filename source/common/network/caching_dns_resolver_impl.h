@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/dns.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All DNS cache stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DNS_CACHE_STATS(COUNTER)                                                               \
+  COUNTER(cache_hit)                                                                               \
+  COUNTER(cache_miss)                                                                              \
+  COUNTER(query_coalesced)                                                                         \
+  COUNTER(prefetch)
+// clang-format on
+
+/**
+ * Struct definition for all DNS cache stats. @see stats_macros.h
+ */
+struct DnsCacheStats {
+  ALL_DNS_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * DnsResolver which caches the results of another resolver, so that the many clusters which
+ * resolve the same names share the lookups:
+ * - A resolution is cached for the configured TTL. Failed resolutions are cached as well, for at
+ *   most NEGATIVE_TTL, so that a name which does not resolve is not queried again by every
+ *   cluster.
+ * - The resolutions of a name which is already being resolved wait for the pending query rather
+ *   than starting another one.
+ * - A cached resolution which is used in the last quarter of its TTL is refreshed in the
+ *   background, so that the names resolved periodically do not miss the cache.
+ * The wrapped resolver does not report the TTL of the DNS records, so all names get the same TTL.
+ * With a TTL of zero nothing is cached and only concurrent resolutions are shared. Cached results
+ * are delivered from the dispatcher rather than from resolve(). All calls and callbacks happen on
+ * the thread that owns the dispatcher.
+ */
+class CachingDnsResolverImpl : public DnsResolver,
+                               protected Logger::Loggable<Logger::Id::upstream> {
+public:
+  CachingDnsResolverImpl(Event::Dispatcher& dispatcher, DnsResolverSharedPtr resolver,
+                         std::chrono::milliseconds ttl, Stats::Scope& scope,
+                         MonotonicTimeSource& time_source);
+  ~CachingDnsResolverImpl();
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+
+  static const std::chrono::milliseconds NEGATIVE_TTL;
+
+private:
+  struct PendingQuery;
+  typedef std::unique_ptr<PendingQuery> PendingQueryPtr;
+
+  struct PendingQuery : public ActiveDnsQuery, public LinkedObject<PendingQuery> {
+    PendingQuery(std::list<PendingQueryPtr>& list, ResolveCb callback)
+        : list_(&list), callback_(callback) {}
+
+    // Network::ActiveDnsQuery
+    void cancel() override { removeFromList(*list_); }
+
+    // The list which owns the query: the waiters of a cache entry, or the ready queries.
+    std::list<PendingQueryPtr>* list_;
+    const ResolveCb callback_;
+    // The cached result, for the ready queries.
+    std::list<Address::InstanceConstSharedPtr> address_list_;
+  };
+
+  struct CacheEntry {
+    std::list<Address::InstanceConstSharedPtr> address_list_;
+    MonotonicTime expiry_time_;
+    MonotonicTime refresh_time_;
+    bool resolved_{};
+    bool resolving_{};
+    // The number of queries of the wrapped resolver which completed.
+    uint64_t completions_{};
+    ActiveDnsQuery* active_query_{};
+    std::list<PendingQueryPtr> waiters_;
+  };
+
+  void startResolve(const std::string& key, CacheEntry& entry, const std::string& dns_name,
+                    DnsLookupFamily dns_lookup_family);
+  void onResolved(CacheEntry& entry, std::list<Address::InstanceConstSharedPtr>&& address_list);
+  void deliverReadyQueries();
+  void removeExpiredEntries(MonotonicTime now);
+
+  const DnsResolverSharedPtr resolver_;
+  const std::chrono::milliseconds ttl_;
+  DnsCacheStats stats_;
+  MonotonicTimeSource& time_source_;
+  Event::TimerPtr ready_timer_;
+  std::list<PendingQueryPtr> ready_queries_;
+  // The depth of the calls into the wrapped resolver and into the callbacks of the waiters.
+  uint32_t nesting_{};
+  // Keyed by the lookup family and the name.
+  std::unordered_map<std::string, CacheEntry> cache_;
+};
+
+} // namespace Network
+} // namespace Envoy
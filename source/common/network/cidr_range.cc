@@ -224,24 +224,23 @@ InstanceConstSharedPtr CidrRange::truncateIpAddressAndLength(InstanceConstShared
 }
 
 IpList::IpList(const std::vector<std::string>& subnets) {
+  std::vector<CidrRange> ip_list = parseRanges(subnets);
+  empty_ = ip_list.empty();
+  trie_ = LpmTrie({{"", std::move(ip_list)}});
+}
+
+std::vector<CidrRange> IpList::parseRanges(const std::vector<std::string>& subnets) {
+  std::vector<CidrRange> ranges;
   for (const std::string& entry : subnets) {
-    CidrRange list_entry = CidrRange::create(entry);
-    if (list_entry.isValid()) {
-      ip_list_.push_back(list_entry);
+    CidrRange range = CidrRange::create(entry);
+    if (range.isValid()) {
+      ranges.push_back(range);
     } else {
       throw EnvoyException(
           fmt::format("invalid ip/mask combo '{}' (format is <ip>/<# mask bits>)", entry));
     }
   }
-}
-
-bool IpList::contains(const Instance& address) const {
-  for (const CidrRange& entry : ip_list_) {
-    if (entry.isInRange(address)) {
-      return true;
-    }
-  }
-  return false;
+  return ranges;
 }
 
 IpList::IpList(const Json::Object& config, const std::string& member_name)
@@ -6,6 +6,8 @@
 #include "envoy/json/json_object.h"
 #include "envoy/network/address.h"
 
+#include "common/network/lpm_trie.h"
+
 namespace Envoy {
 namespace Network {
 namespace Address {
@@ -121,7 +123,8 @@ private:
 
 /**
  * Class for keeping a list of CidrRanges, and then determining whether an
- * IP address is in the CidrRange list.
+ * IP address is in the CidrRange list. The ranges are kept in an LpmTrie, so that the cost of
+ * contains() does not grow with the length of the list.
  */
 class IpList {
 public:
@@ -129,11 +132,19 @@ public:
   IpList(const Json::Object& config, const std::string& member_name);
   IpList(){};
 
-  bool contains(const Instance& address) const;
-  bool empty() const { return ip_list_.empty(); }
+  bool contains(const Instance& address) const { return trie_.contains(address); }
+  bool empty() const { return empty_; }
+
+  /**
+   * @param subnets supplies ranges in the format accepted by CidrRange::create().
+   * @return the parsed ranges.
+   * @throw EnvoyException if a range is invalid.
+   */
+  static std::vector<CidrRange> parseRanges(const std::vector<std::string>& subnets);
 
 private:
-  std::vector<CidrRange> ip_list_;
+  LpmTrie trie_;
+  bool empty_{true};
 };
 
 } // namespace Address
@@ -0,0 +1,85 @@
+#include "common/network/connection_balancer_impl.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "envoy/event/dispatcher.h"
+
+namespace Envoy {
+namespace Network {
+
+void ConnectionBalancerImpl::registerHandler(BalancedConnectionHandler& handler) {
+  std::unique_lock<std::mutex> lock(lock_);
+  targets_.push_back({&handler, next_id_++, 0});
+}
+
+void ConnectionBalancerImpl::unregisterHandler(BalancedConnectionHandler& handler) {
+  std::unique_lock<std::mutex> lock(lock_);
+  targets_.remove_if([&handler](const Target& target) { return target.handler_ == &handler; });
+}
+
+bool ConnectionBalancerImpl::balance(BalancedConnectionHandler& handler, int fd,
+                                     const sockaddr_storage& remote_addr,
+                                     socklen_t remote_addr_len) {
+  std::unique_lock<std::mutex> lock(lock_);
+  Target* least = nullptr;
+  uint64_t least_load = 0;
+  uint64_t current_load = 0;
+  bool registered = false;
+  for (Target& target : targets_) {
+    const uint64_t load = target.handler_->numConnections() + target.pending_;
+    if (target.handler_ == &handler) {
+      current_load = load;
+      registered = true;
+    }
+    if (least == nullptr || load < least_load) {
+      least = &target;
+      least_load = load;
+    }
+  }
+
+  if (!registered || least_load >= current_load) {
+    return false;
+  }
+
+  // A listener is unregistered before it is destroyed, and its dispatcher outlives it, so the
+  // dispatcher can be posted to while the lock is held.
+  least->pending_++;
+  const uint64_t id = least->id_;
+  std::shared_ptr<ConnectionBalancerImpl> self = shared_from_this();
+  least->handler_->dispatcher().post([self, id, fd, remote_addr, remote_addr_len]() -> void {
+    self->onHandedOver(id, fd, remote_addr, remote_addr_len);
+  });
+  return true;
+}
+
+void ConnectionBalancerImpl::onHandedOver(uint64_t id, int fd, const sockaddr_storage& remote_addr,
+                                          socklen_t remote_addr_len) {
+  BalancedConnectionHandler* handler = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (Target& target : targets_) {
+      if (target.id_ == id) {
+        target.pending_--;
+        handler = target.handler_;
+        break;
+      }
+    }
+  }
+
+  // This runs on the thread of the listener, which is the only thread that destroys it, so the
+  // listener stays alive once the lock is released.
+  if (handler == nullptr) {
+    ::close(fd);
+    return;
+  }
+
+  handler->onBalancedConnection(fd, remote_addr, remote_addr_len);
+}
+
+} // namespace Network
+} // namespace Envoy
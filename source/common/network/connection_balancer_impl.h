@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "envoy/network/listener.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Connection balancer which hands each accepted socket over to the registered listener whose worker
+ * owns the fewest connections, counting the sockets already posted to a worker which it did not
+ * take over yet. Ties go to the listener which accepted the socket, so sockets only change threads
+ * when the load is uneven.
+ */
+class ConnectionBalancerImpl : public ConnectionBalancer,
+                               public std::enable_shared_from_this<ConnectionBalancerImpl>,
+                               NonCopyable {
+public:
+  // Network::ConnectionBalancer
+  void registerHandler(BalancedConnectionHandler& handler) override;
+  void unregisterHandler(BalancedConnectionHandler& handler) override;
+  bool balance(BalancedConnectionHandler& handler, int fd, const sockaddr_storage& remote_addr,
+               socklen_t remote_addr_len) override;
+
+private:
+  struct Target {
+    BalancedConnectionHandler* handler_;
+    // Sockets are posted to a target by id rather than by pointer, so that a socket which arrives
+    // after its listener went away is closed rather than given to a new listener at the same
+    // address.
+    uint64_t id_;
+    uint64_t pending_;
+  };
+
+  void onHandedOver(uint64_t id, int fd, const sockaddr_storage& remote_addr,
+                    socklen_t remote_addr_len);
+
+  std::mutex lock_;
+  std::list<Target> targets_;
+  uint64_t next_id_{};
+};
+
+} // namespace Network
+} // namespace Envoy
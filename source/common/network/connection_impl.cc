@@ -1,10 +1,12 @@
 #include "common/network/connection_impl.h"
 
+#include <fcntl.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 
@@ -52,6 +54,22 @@ void ConnectionImplUtility::updateBufferStats(uint64_t delta, uint64_t new_total
   }
 }
 
+const uint64_t AdaptiveReadSize::MIN_SIZE;
+const uint64_t AdaptiveReadSize::INITIAL_SIZE;
+const uint64_t AdaptiveReadSize::MAX_SIZE;
+
+void AdaptiveReadSize::onRead(uint64_t bytes_read) {
+  if (bytes_read >= size_) {
+    size_ = std::min(size_ * 2, MAX_SIZE);
+  }
+}
+
+void AdaptiveReadSize::onReadEventDone(uint64_t bytes_read) {
+  if (bytes_read < size_ / 4) {
+    size_ = std::max(size_ / 2, MIN_SIZE);
+  }
+}
+
 std::atomic<uint64_t> ConnectionImpl::next_global_id_;
 
 ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
@@ -64,21 +82,31 @@ ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
           dispatcher.getWatermarkFactory().create([this]() -> void { this->onLowWatermark(); },
                                                   [this]() -> void { this->onHighWatermark(); })),
       dispatcher_(dispatcher), fd_(fd), id_(++next_global_id_),
-      using_original_dst_(using_original_dst) {
+      using_original_dst_(using_original_dst),
+      stop_on_short_read_(dispatcher.earlyCloseSupported()) {
 
   // Treat the lack of a valid fd (which in practice only happens if we run out of FDs) as an OOM
   // condition and just crash.
   RELEASE_ASSERT(fd_ != -1);
 
+#ifdef SO_BUSY_POLL
+  if (dispatcher_.busyPollBudget().count() > 0) {
+    // Raising the budget above net.core.busy_read needs CAP_NET_ADMIN. The event loop busy polls
+    // either way, so a failure only loses the polling of the device queue.
+    const int busy_poll_us = dispatcher_.busyPollBudget().count();
+    if (setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us)) != 0) {
+      ENVOY_CONN_LOG(debug, "unable to set SO_BUSY_POLL: {}", *this, strerror(errno));
+    }
+  }
+#endif
+
   if (!connected) {
     state_ |= InternalState::Connecting;
   }
 
-  // We never ask for both early close and read at the same time. If we are reading, we want to
-  // consume all available data.
   file_event_ = dispatcher_.createFileEvent(
       fd_, [this](uint32_t events) -> void { onFileEvent(events); }, Event::FileTriggerType::Edge,
-      Event::FileReadyType::Read | Event::FileReadyType::Write);
+      readEnabledEvents());
 
   if (bind_to_address != nullptr) {
     int rc = bind_to_address->bind(fd);
@@ -122,13 +150,16 @@ void ConnectionImpl::close(ConnectionCloseType type) {
     return;
   }
 
-  uint64_t data_to_write = write_buffer_->length();
+  uint64_t data_to_write = write_buffer_->length() + splice_pipe_length_;
   ENVOY_CONN_LOG(debug, "closing data_to_write={} type={}", *this, data_to_write, enumToInt(type));
   if (data_to_write == 0 || type == ConnectionCloseType::NoFlush) {
     if (data_to_write > 0) {
       // We aren't going to wait to flush, but try to write as much as we can if there is pending
       // data.
       doWriteToSocket();
+      if (write_buffer_->length() == 0 && splice_pipe_length_ > 0) {
+        doSpliceToSocket();
+      }
     }
 
     closeSocket(ConnectionEvent::LocalClose);
@@ -163,7 +194,19 @@ void ConnectionImpl::closeSocket(ConnectionEvent close_type) {
   updateWriteBufferStats(0, 0);
   connection_stats_.reset();
 
+  if (splice_peer_ != nullptr) {
+    // The peer keeps its pipe until it has flushed it, but reads into its read buffer from now on.
+    splice_peer_->splice_peer_ = nullptr;
+    splice_peer_->splice_read_blocked_ = false;
+    if (splice_peer_->readEnabled()) {
+      splice_peer_->setReadBufferReady();
+    }
+    splice_peer_ = nullptr;
+  }
+  closeSplicePipe();
+
   file_event_.reset();
+  idle_memory_timer_.reset();
   ::close(fd_);
   fd_ = -1;
 
@@ -259,13 +302,12 @@ void ConnectionImpl::readDisable(bool disable) {
     }
     ASSERT(!read_enabled);
     state_ |= InternalState::ReadEnabled;
-    // We never ask for both early close and read at the same time. If we are reading, we want to
-    // consume all available data.
-    file_event_->setEnabled(Event::FileReadyType::Read | Event::FileReadyType::Write);
+    file_event_->setEnabled(readEnabledEvents());
     // If the connection has data buffered there's no guarantee there's also data in the kernel
     // which will kick off the filter chain.  Instead fake an event to make sure the buffered data
-    // gets processed regardless.
-    if (read_buffer_.length() > 0) {
+    // gets processed regardless. The same goes for a spliced connection which may have stopped
+    // reading because its peer's pipe was full.
+    if (read_buffer_.length() > 0 || splice_peer_ != nullptr) {
       file_event_->activate(Event::FileReadyType::Read);
     }
   }
@@ -281,6 +323,78 @@ void ConnectionImpl::raiseEvent(ConnectionEvent event) {
 
 bool ConnectionImpl::readEnabled() const { return state_ & InternalState::ReadEnabled; }
 
+uint32_t ConnectionImpl::readEnabledEvents() const {
+  // While reading, a remote close is only asked for when reads stop short, so that a close which
+  // arrives along with the last of the data is still seen. It then comes with the read event, and
+  // all the available data is consumed before the read which returns 0.
+  return Event::FileReadyType::Read | Event::FileReadyType::Write |
+         (stop_on_short_read_ ? Event::FileReadyType::Closed : 0);
+}
+
+bool ConnectionImpl::spliceWith(Connection& peer) {
+#ifdef __linux__
+  ConnectionImpl* peer_impl = dynamic_cast<ConnectionImpl*>(&peer);
+  if (peer_impl == nullptr || !canSplice() || !peer_impl->canSplice()) {
+    return false;
+  }
+
+  if (!openSplicePipe() || !peer_impl->openSplicePipe()) {
+    closeSplicePipe();
+    peer_impl->closeSplicePipe();
+    return false;
+  }
+
+  ENVOY_CONN_LOG(debug, "splicing with connection {}", *this, peer_impl->id());
+  splice_peer_ = peer_impl;
+  peer_impl->splice_peer_ = this;
+
+  // Data which arrived since the last reads is still in the sockets, and the edge triggered read
+  // events do not fire for it again.
+  for (ConnectionImpl* connection : {this, peer_impl}) {
+    if (connection->readEnabled()) {
+      connection->setReadBufferReady();
+    }
+  }
+  return true;
+#else
+  UNREFERENCED_PARAMETER(peer);
+  return false;
+#endif
+}
+
+bool ConnectionImpl::canSplice() const {
+  return state() == State::Open && !(state_ & InternalState::Connecting) && ssl() == nullptr &&
+         splice_peer_ == nullptr && read_buffer_.length() == 0 &&
+         filter_manager_.singleReadFilter();
+}
+
+bool ConnectionImpl::openSplicePipe() {
+#ifdef __linux__
+  if (::pipe2(splice_pipe_, O_NONBLOCK | O_CLOEXEC) != 0) {
+    ENVOY_CONN_LOG(debug, "unable to create splice pipe: {}", *this, strerror(errno));
+    splice_pipe_[0] = splice_pipe_[1] = -1;
+    return false;
+  }
+
+  // A pipe holds 64KiB by default. A larger one lets a read move as much as the largest read into
+  // the read buffer does. This is best effort, as the size is capped by fs.pipe-max-size.
+  ::fcntl(splice_pipe_[1], F_SETPIPE_SZ, AdaptiveReadSize::MAX_SIZE);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ConnectionImpl::closeSplicePipe() {
+  for (int& fd : splice_pipe_) {
+    if (fd != -1) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  splice_pipe_length_ = 0;
+}
+
 void ConnectionImpl::addConnectionCallbacks(ConnectionCallbacks& cb) { callbacks_.push_back(&cb); }
 
 void ConnectionImpl::write(Buffer::Instance& data) {
@@ -358,6 +472,28 @@ void ConnectionImpl::onHighWatermark() {
   }
 }
 
+void ConnectionImpl::enableIdleMemoryRelease(std::chrono::milliseconds period) {
+  idle_memory_period_ = period;
+  idle_memory_timer_ = dispatcher_.createCoarseTimer([this]() -> void { onIdleMemoryTimeout(); });
+  idle_memory_timer_->enableTimer(idle_memory_period_);
+}
+
+void ConnectionImpl::onIdleMemoryTimeout() {
+  // The timer is not enabled again until the next socket event, so an idle connection releases
+  // its memory once rather than every period. A connection which is blocked on a full socket keeps
+  // its data, and is picked up again once the socket becomes writable.
+  if (read_buffer_.length() > 0 || write_buffer_->length() > 0) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(trace, "releasing idle memory", *this);
+  read_buffer_.shrink();
+  write_buffer_->shrink();
+  for (const std::function<void()>& callback : memory_release_callbacks_) {
+    callback();
+  }
+}
+
 void ConnectionImpl::onFileEvent(uint32_t events) {
   ENVOY_CONN_LOG(trace, "socket event: {}", *this, events);
 
@@ -379,12 +515,13 @@ void ConnectionImpl::onFileEvent(uint32_t events) {
   }
 
   if (events & Event::FileReadyType::Closed) {
-    // We never ask for both early close and read at the same time. If we are reading, we want to
-    // consume all available data.
-    ASSERT(!(events & Event::FileReadyType::Read));
-    ENVOY_CONN_LOG(debug, "remote early close", *this);
-    closeSocket(ConnectionEvent::RemoteClose);
-    return;
+    // If we are reading, we want to consume all available data before the close.
+    if (!(events & Event::FileReadyType::Read)) {
+      ENVOY_CONN_LOG(debug, "remote early close", *this);
+      closeSocket(ConnectionEvent::RemoteClose);
+      return;
+    }
+    remote_closed_ = true;
   }
 
   if (events & Event::FileReadyType::Write) {
@@ -396,18 +533,24 @@ void ConnectionImpl::onFileEvent(uint32_t events) {
   if (fd_ != -1 && (events & Event::FileReadyType::Read)) {
     onReadReady();
   }
+
+  if (fd_ != -1 && idle_memory_timer_) {
+    idle_memory_timer_->enableTimer(idle_memory_period_);
+  }
 }
 
 ConnectionImpl::IoResult ConnectionImpl::doReadFromSocket() {
   PostIoAction action = PostIoAction::KeepOpen;
   uint64_t bytes_read = 0;
   do {
-    // 16K read is arbitrary. IIRC, libevent will currently clamp this to 4K. libevent will also
-    // use an ioctl() before every read to figure out how much data there is to read.
-    //
-    // TODO(mattklein123) PERF: Tune the read size and figure out a way of getting rid of the
-    // ioctl(). The extra syscall is not worth it.
-    int rc = read_buffer_.read(fd_, 16384);
+    // The buffer limit caps reads too, and reads stop at the limit unless it was already reached.
+    uint64_t max_length = read_size_.size();
+    if (read_buffer_limit_ > 0) {
+      max_length = std::min<uint64_t>(max_length, read_buffer_.length() < read_buffer_limit_
+                                                      ? read_buffer_limit_ - read_buffer_.length()
+                                                      : read_buffer_limit_);
+    }
+    int rc = read_buffer_.read(fd_, max_length);
     ENVOY_CONN_LOG(trace, "read returns: {}", *this, rc);
 
     // Remote close. Might need to raise data before raising close.
@@ -424,12 +567,52 @@ ConnectionImpl::IoResult ConnectionImpl::doReadFromSocket() {
       break;
     } else {
       bytes_read += rc;
+      read_size_.onRead(rc);
       if (shouldDrainReadBuffer()) {
         setReadBufferReady();
         break;
       }
+      // A short read emptied the socket. The edge triggered read event fires again once more data
+      // or the remote close arrives, so the read which would only return EAGAIN is skipped.
+      if (stop_on_short_read_ && !remote_closed_ && static_cast<uint64_t>(rc) < max_length) {
+        break;
+      }
+    }
+  } while (true);
+
+  read_size_.onReadEventDone(bytes_read);
+  return {action, bytes_read};
+}
+
+ConnectionImpl::IoResult ConnectionImpl::doSpliceFromSocket() {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+#ifdef __linux__
+  do {
+    ssize_t rc = ::splice(fd_, nullptr, splice_peer_->splice_pipe_[1], nullptr,
+                          AdaptiveReadSize::MAX_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    ENVOY_CONN_LOG(trace, "splice from socket returns: {}", *this, rc);
+
+    if (rc == 0) {
+      action = PostIoAction::Close;
+      break;
+    } else if (rc == -1) {
+      ENVOY_CONN_LOG(trace, "splice error: {}", *this, errno);
+      if (errno != EAGAIN) {
+        action = PostIoAction::Close;
+      } else if (splice_peer_->splice_pipe_length_ > 0) {
+        // Either the socket is empty or the peer's pipe is full. Reading carries on once the peer
+        // has flushed its pipe, in case it was the pipe.
+        splice_read_blocked_ = true;
+      }
+
+      break;
+    } else {
+      bytes_read += rc;
+      splice_peer_->splice_pipe_length_ += rc;
     }
   } while (true);
+#endif
 
   return {action, bytes_read};
 }
@@ -439,9 +622,12 @@ void ConnectionImpl::onReadReady() {
 
   ASSERT(!(state_ & InternalState::Connecting));
 
-  IoResult result = doReadFromSocket();
+  IoResult result = splice_peer_ != nullptr ? doSpliceFromSocket() : doReadFromSocket();
   uint64_t new_buffer_size = read_buffer_.length();
   updateReadBufferStats(result.bytes_processed_, new_buffer_size);
+  if (splice_peer_ != nullptr && result.bytes_processed_ > 0) {
+    splice_peer_->setWriteReady();
+  }
   onRead(new_buffer_size);
 
   // The read callback may have already closed the connection.
@@ -478,6 +664,38 @@ ConnectionImpl::IoResult ConnectionImpl::doWriteToSocket() {
   return {action, bytes_written};
 }
 
+ConnectionImpl::IoResult ConnectionImpl::doSpliceToSocket() {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_written = 0;
+#ifdef __linux__
+  while (splice_pipe_length_ > 0) {
+    ssize_t rc = ::splice(splice_pipe_[0], nullptr, fd_, nullptr, splice_pipe_length_,
+                          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    ENVOY_CONN_LOG(trace, "splice to socket returns: {}", *this, rc);
+    if (rc == -1) {
+      ENVOY_CONN_LOG(trace, "splice error: {}", *this, errno);
+      if (errno != EAGAIN) {
+        action = PostIoAction::Close;
+      }
+
+      break;
+    }
+
+    bytes_written += rc;
+    splice_pipe_length_ -= rc;
+  }
+
+  if (splice_pipe_length_ == 0 && splice_peer_ != nullptr && splice_peer_->splice_read_blocked_) {
+    splice_peer_->splice_read_blocked_ = false;
+    if (splice_peer_->readEnabled()) {
+      splice_peer_->setReadBufferReady();
+    }
+  }
+#endif
+
+  return {action, bytes_written};
+}
+
 void ConnectionImpl::onConnected() { raiseEvent(ConnectionEvent::Connected); }
 
 void ConnectionImpl::onWriteReady() {
@@ -508,6 +726,11 @@ void ConnectionImpl::onWriteReady() {
 
   IoResult result = doWriteToSocket();
   uint64_t new_buffer_size = write_buffer_->length();
+  if (result.action_ == PostIoAction::KeepOpen && new_buffer_size == 0 && splice_pipe_length_ > 0) {
+    // The spliced data goes after anything which was written before the connections were spliced.
+    const IoResult splice_result = doSpliceToSocket();
+    result = {splice_result.action_, result.bytes_processed_ + splice_result.bytes_processed_};
+  }
   updateWriteBufferStats(result.bytes_processed_, new_buffer_size);
 
   if (result.action_ == PostIoAction::Close) {
@@ -515,7 +738,8 @@ void ConnectionImpl::onWriteReady() {
     // write callback. This can happen if we manage to complete the SSL handshake in the write
     // callback, raise a connected event, and close the connection.
     closeSocket(ConnectionEvent::RemoteClose);
-  } else if ((state_ & InternalState::CloseWithFlush) && new_buffer_size == 0) {
+  } else if ((state_ & InternalState::CloseWithFlush) && new_buffer_size == 0 &&
+             splice_pipe_length_ == 0) {
     ENVOY_CONN_LOG(debug, "write flush complete", *this);
     closeSocket(ConnectionEvent::LocalClose);
   }
@@ -546,7 +770,15 @@ void ConnectionImpl::setConnectionStats(const ConnectionStats& stats) {
   connection_stats_.reset(new ConnectionStats(stats));
 }
 
+void ConnectionImpl::setWorkerStats(const WorkerStats& stats) {
+  ASSERT(!worker_stats_);
+  worker_stats_.reset(new WorkerStats(stats));
+}
+
 void ConnectionImpl::updateReadBufferStats(uint64_t num_read, uint64_t new_size) {
+  if (worker_stats_ && num_read > 0) {
+    worker_stats_->read_total_.add(num_read);
+  }
   if (!connection_stats_) {
     return;
   }
@@ -557,6 +789,9 @@ void ConnectionImpl::updateReadBufferStats(uint64_t num_read, uint64_t new_size)
 }
 
 void ConnectionImpl::updateWriteBufferStats(uint64_t num_written, uint64_t new_size) {
+  if (worker_stats_ && num_written > 0) {
+    worker_stats_->write_total_.add(num_written);
+  }
   if (!connection_stats_) {
     return;
   }
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
 
 #include "envoy/common/optional.h"
+#include "envoy/event/timer.h"
 #include "envoy/network/connection.h"
 
 #include "common/buffer/watermark_buffer.h"
@@ -37,6 +40,36 @@ public:
                                 Stats::Counter& stat_total, Stats::Gauge& stat_current);
 };
 
+/**
+ * Picks how much a connection reads from its socket at once. The size doubles, up to MAX_SIZE,
+ * whenever a read fills it and halves, down to MIN_SIZE, whenever a whole read event returns less
+ * than a quarter of it. Connections moving a lot of data then need fewer syscalls, while
+ * connections which only ever have a little to read do not reserve buffer space they never use.
+ */
+class AdaptiveReadSize {
+public:
+  static const uint64_t MIN_SIZE = 4096;
+  static const uint64_t INITIAL_SIZE = 16384;
+  static const uint64_t MAX_SIZE = 256 * 1024;
+
+  uint64_t size() const { return size_; }
+
+  /**
+   * Called after each read of at most size() bytes.
+   * @param bytes_read supplies the number of bytes the read returned.
+   */
+  void onRead(uint64_t bytes_read);
+
+  /**
+   * Called once a read event is done with.
+   * @param bytes_read supplies the number of bytes read during the event.
+   */
+  void onReadEventDone(uint64_t bytes_read);
+
+private:
+  uint64_t size_{INITIAL_SIZE};
+};
+
 /**
  * Implementation of Network::Connection.
  */
@@ -71,6 +104,8 @@ public:
   const Address::Instance& remoteAddress() const override { return *remote_address_; }
   const Address::Instance& localAddress() const override { return *local_address_; }
   void setConnectionStats(const ConnectionStats& stats) override;
+  void setWorkerStats(const WorkerStats& stats) override;
+  const WorkerStats* workerStats() const override { return worker_stats_.get(); }
   Ssl::Connection* ssl() override { return nullptr; }
   const Ssl::Connection* ssl() const override { return nullptr; }
   State state() const override;
@@ -79,6 +114,11 @@ public:
   uint32_t bufferLimit() const override { return read_buffer_limit_; }
   bool usingOriginalDst() const override { return using_original_dst_; }
   bool aboveHighWatermark() const override { return above_high_watermark_; }
+  void enableIdleMemoryRelease(std::chrono::milliseconds period) override;
+  void addMemoryReleaseCallback(std::function<void()> cb) override {
+    memory_release_callbacks_.push_back(cb);
+  }
+  bool spliceWith(Connection& peer) override;
 
   // Network::BufferSource
   Buffer::Instance& getReadBuffer() override { return read_buffer_; }
@@ -93,8 +133,11 @@ protected:
   };
 
   virtual void closeSocket(ConnectionEvent close_type);
+  virtual IoResult doReadFromSocket();
+  virtual IoResult doWriteToSocket();
   void doConnect();
   void raiseEvent(ConnectionEvent event);
+  int fd() const { return fd_; }
   // Should the read buffer be drained?
   bool shouldDrainReadBuffer() {
     return read_buffer_limit_ > 0 && read_buffer_.length() >= read_buffer_limit_;
@@ -105,6 +148,9 @@ protected:
   // fair sharing of CPU resources, the underlying event loop does not make any fairness guarantees.
   // Reconsider how to make fairness happen.
   void setReadBufferReady() { file_event_->activate(Event::FileReadyType::Read); }
+  // Mark the socket ready to write in the event loop, so that I/O which waited on something other
+  // than the socket, such as the handshake of a TLS connection, carries on.
+  void setWriteReady() { file_event_->activate(Event::FileReadyType::Write); }
 
   void onLowWatermark();
   void onHighWatermark();
@@ -129,13 +175,18 @@ private:
   };
   // clang-format on
 
-  virtual IoResult doReadFromSocket();
-  virtual IoResult doWriteToSocket();
   virtual void onConnected();
   void onFileEvent(uint32_t events);
+  void onIdleMemoryTimeout();
   void onRead(uint64_t read_buffer_size);
   void onReadReady();
   void onWriteReady();
+  uint32_t readEnabledEvents() const;
+  bool canSplice() const;
+  bool openSplicePipe();
+  void closeSplicePipe();
+  IoResult doSpliceFromSocket();
+  IoResult doSpliceToSocket();
   void updateReadBufferStats(uint64_t num_read, uint64_t new_size);
   void updateWriteBufferStats(uint64_t num_written, uint64_t new_size);
 
@@ -148,16 +199,36 @@ private:
   std::list<ConnectionCallbacks*> callbacks_;
   uint32_t state_{InternalState::ReadEnabled};
   Buffer::Instance* current_write_buffer_{};
+  AdaptiveReadSize read_size_;
   uint64_t last_read_buffer_size_{};
   uint64_t last_write_buffer_size_{};
   std::unique_ptr<ConnectionStats> connection_stats_;
+  std::unique_ptr<WorkerStats> worker_stats_;
   // Tracks the number of times reads have been disabled.  If N different components call
   // readDisabled(true) this allows the connection to only resume reads when readDisabled(false)
   // has been called N times.
   uint32_t read_disable_count_{0};
   const bool using_original_dst_;
+  // Set if the event backend reports remote closes while reading, so that a read which returns less
+  // than asked for can end the read event without another read to see EAGAIN.
+  const bool stop_on_short_read_;
   bool above_high_watermark_{false};
   bool detect_early_close_{true};
+  // Set once the remote close has been reported, after which reads carry on until they return 0.
+  bool remote_closed_{false};
+  // The connection which the data read on this connection is spliced to, and which splices the
+  // data it reads to this connection. @see spliceWith().
+  ConnectionImpl* splice_peer_{};
+  // The pipe which holds the data spliced from the peer until this connection's socket takes it,
+  // in place of the write buffer. It is kept after the peer closes, until it has been flushed.
+  int splice_pipe_[2]{-1, -1};
+  uint64_t splice_pipe_length_{};
+  // Set when a read stopped because the peer's pipe was full, so that reading carries on once the
+  // peer has flushed it.
+  bool splice_read_blocked_{false};
+  Event::TimerPtr idle_memory_timer_;
+  std::chrono::milliseconds idle_memory_period_{};
+  std::list<std::function<void()>> memory_release_callbacks_;
 };
 
 /**
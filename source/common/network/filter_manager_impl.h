@@ -44,6 +44,14 @@ public:
   void onRead();
   FilterStatus onWrite();
 
+  /**
+   * @return bool whether there are no write filters and at most one read filter, so that no
+   *         filter but that read filter sees the data of the connection.
+   */
+  bool singleReadFilter() const {
+    return upstream_filters_.size() <= 1 && downstream_filters_.empty();
+  }
+
 private:
   struct ActiveReadFilter : public ReadFilterCallbacks, LinkedObject<ActiveReadFilter> {
     ActiveReadFilter(FilterManagerImpl& parent, ReadFilterSharedPtr filter)
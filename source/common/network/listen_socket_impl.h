@@ -39,7 +39,8 @@ protected:
  */
 class TcpListenSocket : public ListenSocketImpl {
 public:
-  TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port);
+  TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port,
+                  bool reuse_port = false);
   TcpListenSocket(int fd, Address::InstanceConstSharedPtr address);
 };
 
@@ -30,6 +30,26 @@ Address::InstanceConstSharedPtr ListenerImpl::getOriginalDst(int fd) {
 void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
                                   int remote_addr_len, void* arg) {
   ListenerImpl* listener = static_cast<ListenerImpl*>(arg);
+  listener->dispatcher_.runCallback(Event::DispatcherImpl::CallbackType::Io, [&]() -> void {
+    // libevent accepts into a sockaddr_storage, so remote_addr can be copied as one.
+    const ConnectionBalancerSharedPtr& balancer = listener->options_.connection_balancer_;
+    if (balancer != nullptr &&
+        balancer->balance(*listener, fd, *reinterpret_cast<const sockaddr_storage*>(remote_addr),
+                          remote_addr_len)) {
+      return;
+    }
+
+    listener->onAccept(fd, remote_addr, remote_addr_len);
+  });
+}
+
+void ListenerImpl::onBalancedConnection(int fd, const sockaddr_storage& remote_addr,
+                                        socklen_t remote_addr_len) {
+  onAccept(fd, reinterpret_cast<const sockaddr*>(&remote_addr), remote_addr_len);
+}
+
+void ListenerImpl::onAccept(int fd, const sockaddr* remote_addr, int remote_addr_len) {
+  ListenerImpl* listener = this;
   Address::InstanceConstSharedPtr final_local_address = listener->socket_.localAddress();
   bool using_original_dst = false;
 
@@ -101,6 +121,28 @@ ListenerImpl::ListenerImpl(Network::ConnectionHandler& conn_handler,
     }
 
     evconnlistener_set_error_cb(listener_.get(), errorCallback);
+
+    if (options_.connection_balancer_ != nullptr) {
+      options_.connection_balancer_->registerHandler(*this);
+    }
+  }
+}
+
+ListenerImpl::~ListenerImpl() {
+  if (listener_ && options_.connection_balancer_ != nullptr) {
+    options_.connection_balancer_->unregisterHandler(*this);
+  }
+}
+
+void ListenerImpl::disable() {
+  if (listener_) {
+    evconnlistener_disable(listener_.get());
+  }
+}
+
+void ListenerImpl::enable() {
+  if (listener_) {
+    evconnlistener_enable(listener_.get());
   }
 }
 
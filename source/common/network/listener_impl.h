@@ -16,11 +16,22 @@ namespace Network {
 /**
  * libevent implementation of Network::Listener.
  */
-class ListenerImpl : public Listener {
+class ListenerImpl : public Listener, public BalancedConnectionHandler {
 public:
   ListenerImpl(Network::ConnectionHandler& conn_handler, Event::DispatcherImpl& dispatcher,
                ListenSocket& socket, ListenerCallbacks& cb, Stats::Scope& scope,
                const ListenerOptions& listener_options);
+  ~ListenerImpl();
+
+  // Network::Listener
+  void disable() override;
+  void enable() override;
+
+  // Network::BalancedConnectionHandler
+  uint64_t numConnections() override { return connection_handler_.numConnections(); }
+  Event::Dispatcher& dispatcher() override { return dispatcher_; }
+  void onBalancedConnection(int fd, const sockaddr_storage& remote_addr,
+                            socklen_t remote_addr_len) override;
 
   /**
    * Accept/process a new connection.
@@ -49,6 +60,7 @@ protected:
   const ListenerOptions options_;
 
 private:
+  void onAccept(int fd, const sockaddr* remote_addr, int remote_addr_len);
   static void errorCallback(evconnlistener* listener, void* context);
   static void listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
                              int remote_addr_len, void* arg);
@@ -0,0 +1,76 @@
+#include "common/network/lpm_trie.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/network/cidr_range.h"
+
+namespace Envoy {
+namespace Network {
+namespace Address {
+
+LpmTrie::LpmTrie() : tag_sets_(1), tag_index_sets_(1) {}
+
+LpmTrie::LpmTrie(const std::vector<std::pair<std::string, std::vector<CidrRange>>>& tagged_ranges)
+    : tag_sets_(1), tag_index_sets_(1) {
+  std::vector<Poptrie<4>::Prefix> ipv4_prefixes;
+  std::vector<Poptrie<16>::Prefix> ipv6_prefixes;
+  for (uint32_t tag = 0; tag < tagged_ranges.size(); tag++) {
+    for (const CidrRange& range : tagged_ranges[tag].second) {
+      ASSERT(range.isValid());
+      if (range.version() == IpVersion::v4) {
+        Poptrie<4>::Prefix prefix{{}, static_cast<uint32_t>(range.length()), tag};
+        const uint32_t address = range.ipv4()->address();
+        memcpy(prefix.key_.data(), &address, prefix.key_.size());
+        ipv4_prefixes.push_back(prefix);
+      } else {
+        ipv6_prefixes.push_back(
+            {range.ipv6()->address(), static_cast<uint32_t>(range.length()), tag});
+      }
+    }
+  }
+
+  // Both tries share the sets of tags, so that each distinct set is stored once.
+  std::map<std::vector<uint32_t>, uint32_t> tag_set_ids{{{}, 0}};
+  Poptrie<4>::LeafValueCb leaf_value_cb = [&](const std::vector<uint32_t>& tags) -> uint32_t {
+    auto inserted = tag_set_ids.emplace(tags, tag_sets_.size());
+    if (inserted.second) {
+      tag_sets_.emplace_back();
+      tag_index_sets_.push_back(tags);
+      for (uint32_t tag : tags) {
+        tag_sets_.back().push_back(tagged_ranges[tag].first);
+      }
+    }
+    return inserted.first->second;
+  };
+
+  ipv4_ = Poptrie<4>(ipv4_prefixes, leaf_value_cb);
+  ipv6_ = Poptrie<16>(ipv6_prefixes, leaf_value_cb);
+}
+
+uint32_t LpmTrie::lookup(const Instance& address) const {
+  if (address.type() != Type::Ip) {
+    return 0;
+  }
+
+  switch (address.ip()->version()) {
+  case IpVersion::v4: {
+    Poptrie<4>::Key key;
+    const uint32_t ipv4 = address.ip()->ipv4()->address();
+    memcpy(key.data(), &ipv4, key.size());
+    return ipv4_.lookup(key);
+  }
+  case IpVersion::v6:
+    return ipv6_.lookup(address.ip()->ipv6()->address());
+  }
+
+  NOT_REACHED;
+}
+
+} // namespace Address
+} // namespace Network
+} // namespace Envoy
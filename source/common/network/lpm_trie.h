@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/network/address.h"
+
+namespace Envoy {
+namespace Network {
+namespace Address {
+
+class CidrRange;
+
+/**
+ * A multibit trie of the prefixes of one IP version, for longest prefix match lookups. The layout
+ * follows Poptrie (Asai and Ohara, SIGCOMM 2015): each node consumes 6 bits of the address and
+ * has 64 slots, which are either a child node or a leaf. Two bit vectors tell which slots are
+ * children and where each run of identical leaves starts, and the children and the leaf runs of a
+ * node are stored contiguously, so that a slot is found with a popcount. A lookup touches one node
+ * per 6 bits of the longest prefix under the address, whatever the number of prefixes.
+ *
+ * The value of a leaf is assigned when the trie is built from the values of all the prefixes which
+ * contain the addresses of the leaf, not just from the longest of them.
+ * @tparam Bytes the length of the addresses: 4 for IPv4 and 16 for IPv6.
+ */
+template <size_t Bytes> class Poptrie {
+public:
+  // An address or a prefix, in network byte order.
+  typedef std::array<uint8_t, Bytes> Key;
+
+  struct Prefix {
+    Key key_;
+    uint32_t length_;
+    uint32_t value_;
+  };
+
+  /**
+   * Returns the leaf value for a set of prefix values, given sorted and without duplicates. The
+   * empty set must map to 0.
+   */
+  typedef std::function<uint32_t(const std::vector<uint32_t>& values)> LeafValueCb;
+
+  /**
+   * Constructs an empty trie, whose lookups all return 0.
+   */
+  Poptrie() : nodes_(1, Node{0, 1, 0, 0}), leaves_(1, 0) {}
+
+  Poptrie(const std::vector<Prefix>& prefixes, LeafValueCb leaf_value_cb) {
+    std::vector<uint32_t> indexes(prefixes.size());
+    for (uint32_t i = 0; i < indexes.size(); i++) {
+      indexes[i] = i;
+    }
+    nodes_.emplace_back();
+    build(0, 0, indexes, {}, prefixes, leaf_value_cb);
+  }
+
+  /**
+   * @return the value of the leaf which contains an address.
+   */
+  uint32_t lookup(const Key& key) const {
+    const Node* node = &nodes_[0];
+    uint32_t offset = 0;
+    uint32_t slot = extract(key, offset);
+    while (node->children_ & (1ULL << slot)) {
+      node = &nodes_[node->first_child_ + popcount(node->children_ & mask(slot)) - 1];
+      offset += Stride;
+      slot = extract(key, offset);
+    }
+    return leaves_[node->first_leaf_ + popcount(node->leaf_runs_ & mask(slot)) - 1];
+  }
+
+  size_t nodes() const { return nodes_.size(); }
+
+private:
+  static const uint32_t Stride = 6;
+  static const uint32_t Slots = 1 << Stride;
+
+  struct Node {
+    // The slots which are child nodes.
+    uint64_t children_;
+    // The leaf slots which start a run of identical leaves.
+    uint64_t leaf_runs_;
+    uint32_t first_leaf_;
+    uint32_t first_child_;
+  };
+
+  static uint32_t popcount(uint64_t value) { return __builtin_popcountll(value); }
+
+  // The slots up to and including slot.
+  static uint64_t mask(uint32_t slot) { return (2ULL << slot) - 1; }
+
+  // The Stride bits of a key from offset on, as a slot. The bits past the end of the key are zero.
+  static uint32_t extract(const Key& key, uint32_t offset) {
+    const uint32_t byte = offset / 8;
+    const uint32_t word =
+        (byte < Bytes ? key[byte] << 8 : 0) | (byte + 1 < Bytes ? key[byte + 1] : 0);
+    return (word >> (16 - Stride - offset % 8)) & (Slots - 1);
+  }
+
+  void build(uint32_t node_index, uint32_t depth, const std::vector<uint32_t>& indexes,
+             const std::vector<uint32_t>& inherited_values, const std::vector<Prefix>& prefixes,
+             const LeafValueCb& leaf_value_cb) {
+    // The values of the prefixes which end within the node are expanded over the slots they
+    // cover, and the longer prefixes are handed down to the child of their slot.
+    std::array<std::vector<uint32_t>, Slots> values;
+    std::array<std::vector<uint32_t>, Slots> deeper;
+    values.fill(inherited_values);
+    for (uint32_t index : indexes) {
+      const Prefix& prefix = prefixes[index];
+      const uint32_t slot = extract(prefix.key_, depth);
+      if (prefix.length_ > depth + Stride) {
+        deeper[slot].push_back(index);
+        continue;
+      }
+
+      const uint32_t free_bits = depth + Stride - prefix.length_;
+      const uint32_t first = (slot >> free_bits) << free_bits;
+      for (uint32_t i = first; i < first + (1U << free_bits); i++) {
+        values[i].push_back(prefix.value_);
+      }
+    }
+
+    Node node{0, 0, static_cast<uint32_t>(leaves_.size()), static_cast<uint32_t>(nodes_.size())};
+    std::vector<uint32_t> child_slots;
+    const std::vector<uint32_t>* last_leaf_values = nullptr;
+    for (uint32_t slot = 0; slot < Slots; slot++) {
+      std::sort(values[slot].begin(), values[slot].end());
+      values[slot].erase(std::unique(values[slot].begin(), values[slot].end()),
+                         values[slot].end());
+      if (!deeper[slot].empty()) {
+        node.children_ |= 1ULL << slot;
+        child_slots.push_back(slot);
+        continue;
+      }
+
+      // Most slots continue the run of the previous leaf.
+      if (last_leaf_values != nullptr && *last_leaf_values == values[slot]) {
+        continue;
+      }
+      const uint32_t leaf = leaf_value_cb(values[slot]);
+      if (last_leaf_values == nullptr || leaf != leaves_.back()) {
+        node.leaf_runs_ |= 1ULL << slot;
+        leaves_.push_back(leaf);
+      }
+      last_leaf_values = &values[slot];
+    }
+
+    // The children of a node are allocated together, before any of their own children.
+    nodes_[node_index] = node;
+    nodes_.resize(nodes_.size() + child_slots.size());
+    for (uint32_t i = 0; i < child_slots.size(); i++) {
+      build(node.first_child_ + i, depth + Stride, deeper[child_slots[i]], values[child_slots[i]],
+            prefixes, leaf_value_cb);
+    }
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> leaves_;
+};
+
+/**
+ * Tags IP addresses with the tags of all the CIDR ranges which contain them, with one Poptrie per
+ * IP version. Building the trie is linear in the number of ranges, and a lookup does not depend on
+ * it, which suits lists of hundreds of thousands of ranges.
+ */
+class LpmTrie {
+public:
+  /**
+   * Constructs an empty trie, which tags no address.
+   */
+  LpmTrie();
+
+  /**
+   * @param tagged_ranges supplies each tag along with its ranges. A tag may have any number of
+   *        ranges, and ranges may be nested or shared between tags.
+   */
+  LpmTrie(const std::vector<std::pair<std::string, std::vector<CidrRange>>>& tagged_ranges);
+
+  /**
+   * @return the tags of the ranges which contain the address, in the order of the tags given at
+   *         construction. An address which is not an IP address has no tags.
+   */
+  const std::vector<std::string>& getTags(const Instance& address) const {
+    return tag_sets_[lookup(address)];
+  }
+
+  /**
+   * @return the indexes, in the vector given at construction, of the tags of the ranges which
+   *         contain the address, in increasing order.
+   */
+  const std::vector<uint32_t>& getTagIndexes(const Instance& address) const {
+    return tag_index_sets_[lookup(address)];
+  }
+
+  /**
+   * @return true if any range contains the address.
+   */
+  bool contains(const Instance& address) const { return lookup(address) != 0; }
+
+private:
+  uint32_t lookup(const Instance& address) const;
+
+  // The distinct sets of tags of the leaves, by name and by index. The first one is the empty set.
+  std::vector<std::vector<std::string>> tag_sets_;
+  std::vector<std::vector<uint32_t>> tag_index_sets_;
+  Poptrie<4> ipv4_;
+  Poptrie<16> ipv6_;
+};
+
+} // namespace Address
+} // namespace Network
+} // namespace Envoy
@@ -1,8 +1,14 @@
 #include "common/network/proxy_protocol.h"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -20,6 +26,62 @@
 namespace Envoy {
 namespace Network {
 
+namespace {
+
+const char PROXY_PROTO_V2_SIGNATURE[] = {'\r', '\n', '\r', '\n', '\0', '\r',
+                                         '\n', 'Q',  'U',  'I',  'T',  '\n'};
+const uint8_t PROXY_PROTO_V2_VERSION = 0x20;
+const uint8_t PROXY_PROTO_V2_LOCAL = 0x0;
+const uint8_t PROXY_PROTO_V2_PROXY = 0x1;
+// AF_INET and AF_INET6 over SOCK_STREAM.
+const uint8_t PROXY_PROTO_V2_TCP4 = 0x11;
+const uint8_t PROXY_PROTO_V2_TCP6 = 0x21;
+const size_t PROXY_PROTO_V2_TCP4_ADDRESSES_LEN = 12;
+const size_t PROXY_PROTO_V2_TCP6_ADDRESSES_LEN = 36;
+
+/**
+ * A field of a version 1 line, which points into the line.
+ */
+struct V1Field {
+  bool equals(const char* value) const {
+    return size_ == strlen(value) && memcmp(data_, value, size_) == 0;
+  }
+
+  bool parseAddress(int family, void* address) const {
+    char str[INET6_ADDRSTRLEN];
+    if (size_ >= sizeof(str)) {
+      return false;
+    }
+    memcpy(str, data_, size_);
+    str[size_] = 0;
+    return inet_pton(family, str, address) == 1;
+  }
+
+  // The port is stored in network byte order, as in a sockaddr.
+  bool parsePort(in_port_t& port) const {
+    if (size_ == 0 || size_ > 5) {
+      return false;
+    }
+    uint32_t value = 0;
+    for (size_t i = 0; i < size_; i++) {
+      if (data_[i] < '0' || data_[i] > '9') {
+        return false;
+      }
+      value = value * 10 + (data_[i] - '0');
+    }
+    if (value > 65535) {
+      return false;
+    }
+    port = htons(value);
+    return true;
+  }
+
+  const char* data_;
+  size_t size_;
+};
+
+} // namespace
+
 ProxyProtocol::ProxyProtocol(Stats::Scope& scope)
     : stats_{ALL_PROXY_PROTOCOL_STATS(POOL_COUNTER(scope))} {}
 
@@ -58,50 +120,155 @@ void ProxyProtocol::ActiveConnection::onRead() {
 }
 
 void ProxyProtocol::ActiveConnection::onReadWorker() {
-  std::string proxy_line;
-  if (!readLine(fd_, proxy_line)) {
-    return;
+  if (!v2_) {
+    if (readLine(fd_)) {
+      parseV1();
+      return;
+    }
+    if (!v2_) {
+      return;
+    }
   }
 
-  // Remove the line feed at the end
-  StringUtil::rtrim(proxy_line);
+  if (readV2(fd_)) {
+    parseV2();
+  }
+}
 
+void ProxyProtocol::ActiveConnection::parseV1() {
   // Parse proxy protocol line with format: PROXY TCP4/TCP6 SOURCE_ADDRESS DESTINATION_ADDRESS
-  // SOURCE_PORT DESTINATION_PORT.
-  const auto line_parts = StringUtil::split(proxy_line, " ", true);
+  // SOURCE_PORT DESTINATION_PORT. The fields are taken in place, without the line feed at the end.
+  const char* end = buf_ + buf_off_;
+  while (end > buf_ && isspace(static_cast<unsigned char>(end[-1]))) {
+    end--;
+  }
 
-  if (line_parts.size() != 6 || line_parts[0] != "PROXY") {
+  std::array<V1Field, 6> fields;
+  size_t num_fields = 0;
+  const char* field_start = buf_;
+  for (const char* p = buf_;; p++) {
+    if (p == end || *p == ' ') {
+      if (num_fields == fields.size()) {
+        throw EnvoyException("failed to read proxy protocol");
+      }
+      fields[num_fields++] = {field_start, static_cast<size_t>(p - field_start)};
+      if (p == end) {
+        break;
+      }
+      field_start = p + 1;
+    }
+  }
+
+  if (num_fields != fields.size() || !fields[0].equals("PROXY")) {
     throw EnvoyException("failed to read proxy protocol");
   }
 
-  Address::IpVersion protocol_version;
+  // Most errors are caught by the address parsing, which only accepts addresses of the protocol's
+  // version. Remote address refers to the source address.
   Address::InstanceConstSharedPtr remote_address;
   Address::InstanceConstSharedPtr local_address;
-  if (line_parts[1] == "TCP4") {
-    protocol_version = Address::IpVersion::v4;
-    remote_address = Utility::parseInternetAddressAndPort(line_parts[2] + ":" + line_parts[4]);
-    local_address = Utility::parseInternetAddressAndPort(line_parts[3] + ":" + line_parts[5]);
-  } else if (line_parts[1] == "TCP6") {
-    protocol_version = Address::IpVersion::v6;
-    remote_address =
-        Utility::parseInternetAddressAndPort("[" + line_parts[2] + "]:" + line_parts[4]);
-    local_address =
-        Utility::parseInternetAddressAndPort("[" + line_parts[3] + "]:" + line_parts[5]);
+  if (fields[1].equals("TCP4")) {
+    sockaddr_in remote{};
+    sockaddr_in local{};
+    remote.sin_family = local.sin_family = AF_INET;
+    if (!fields[2].parseAddress(AF_INET, &remote.sin_addr) ||
+        !fields[3].parseAddress(AF_INET, &local.sin_addr) ||
+        !fields[4].parsePort(remote.sin_port) || !fields[5].parsePort(local.sin_port)) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    remote_address = std::make_shared<Address::Ipv4Instance>(&remote);
+    local_address = std::make_shared<Address::Ipv4Instance>(&local);
+  } else if (fields[1].equals("TCP6")) {
+    sockaddr_in6 remote{};
+    sockaddr_in6 local{};
+    remote.sin6_family = local.sin6_family = AF_INET6;
+    if (!fields[2].parseAddress(AF_INET6, &remote.sin6_addr) ||
+        !fields[3].parseAddress(AF_INET6, &local.sin6_addr) ||
+        !fields[4].parsePort(remote.sin6_port) || !fields[5].parsePort(local.sin6_port)) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    remote_address = std::make_shared<Address::Ipv6Instance>(remote);
+    local_address = std::make_shared<Address::Ipv6Instance>(local);
   } else {
     throw EnvoyException("failed to read proxy protocol");
   }
 
-  // Error check the source and destination fields.  Most errors are cought by the address
-  // parsing above, but a malformed IPv6 address may combine with a malformed port and parse as
-  // an IPv6 address when parsing for an IPv4 address.  Remote address refers to the source
-  // address.
-  const auto remote_version = remote_address->ip()->version();
-  const auto local_version = local_address->ip()->version();
-  if (remote_version != protocol_version || local_version != protocol_version) {
+  handOver(remote_address, local_address, true);
+}
+
+void ProxyProtocol::ActiveConnection::parseV2Header() {
+  if (memcmp(buf_, PROXY_PROTO_V2_SIGNATURE, sizeof(PROXY_PROTO_V2_SIGNATURE)) != 0) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  const uint8_t version_command = buf_[12];
+  const uint8_t family_protocol = buf_[13];
+  const size_t length = (static_cast<uint8_t>(buf_[14]) << 8) | static_cast<uint8_t>(buf_[15]);
+  if ((version_command & 0xf0) != PROXY_PROTO_V2_VERSION) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  // The addresses of a LOCAL header are skipped along with the TLVs.
+  size_t addresses_length = 0;
+  switch (version_command & 0x0f) {
+  case PROXY_PROTO_V2_LOCAL:
+    break;
+  case PROXY_PROTO_V2_PROXY:
+    if (family_protocol == PROXY_PROTO_V2_TCP4) {
+      addresses_length = PROXY_PROTO_V2_TCP4_ADDRESSES_LEN;
+    } else if (family_protocol == PROXY_PROTO_V2_TCP6) {
+      addresses_length = PROXY_PROTO_V2_TCP6_ADDRESSES_LEN;
+    } else {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    break;
+  default:
     throw EnvoyException("failed to read proxy protocol");
   }
+
+  if (length < addresses_length) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+  v2_addresses_end_ = PROXY_PROTO_V2_HEADER_LEN + addresses_length;
+  v2_skip_ = length - addresses_length;
+}
+
+void ProxyProtocol::ActiveConnection::parseV2() {
+  const uint8_t family_protocol = buf_[13];
+  const char* addresses = buf_ + PROXY_PROTO_V2_HEADER_LEN;
+  if (v2_addresses_end_ == PROXY_PROTO_V2_HEADER_LEN) {
+    // A LOCAL header, sent by the proxy for its own connections, such as health checks, so the
+    // connection keeps its own addresses.
+    handOver(Address::peerAddressFromFd(fd_), Address::addressFromFd(fd_), false);
+  } else if (family_protocol == PROXY_PROTO_V2_TCP4) {
+    sockaddr_in remote{};
+    sockaddr_in local{};
+    remote.sin_family = local.sin_family = AF_INET;
+    memcpy(&remote.sin_addr, addresses, 4);
+    memcpy(&local.sin_addr, addresses + 4, 4);
+    memcpy(&remote.sin_port, addresses + 8, 2);
+    memcpy(&local.sin_port, addresses + 10, 2);
+    handOver(std::make_shared<Address::Ipv4Instance>(&remote),
+             std::make_shared<Address::Ipv4Instance>(&local), true);
+  } else {
+    sockaddr_in6 remote{};
+    sockaddr_in6 local{};
+    remote.sin6_family = local.sin6_family = AF_INET6;
+    memcpy(&remote.sin6_addr, addresses, 16);
+    memcpy(&local.sin6_addr, addresses + 16, 16);
+    memcpy(&remote.sin6_port, addresses + 32, 2);
+    memcpy(&local.sin6_port, addresses + 34, 2);
+    handOver(std::make_shared<Address::Ipv6Instance>(remote),
+             std::make_shared<Address::Ipv6Instance>(local), true);
+  }
+}
+
+void ProxyProtocol::ActiveConnection::handOver(Address::InstanceConstSharedPtr remote_address,
+                                               Address::InstanceConstSharedPtr local_address,
+                                               bool restored) {
   // Check that both addresses are valid unicast addresses, as required for TCP
-  if (!remote_address->ip()->isUnicastAddress() || !local_address->ip()->isUnicastAddress()) {
+  if (restored &&
+      (!remote_address->ip()->isUnicastAddress() || !local_address->ip()->isUnicastAddress())) {
     throw EnvoyException("failed to read proxy protocol");
   }
   ListenerImpl& listener = listener_;
@@ -110,7 +277,7 @@ void ProxyProtocol::ActiveConnection::onReadWorker() {
 
   removeFromList(parent_.connections_);
 
-  listener.newConnection(fd, remote_address, local_address, true);
+  listener.newConnection(fd, remote_address, local_address, restored);
 }
 
 void ProxyProtocol::ActiveConnection::close() {
@@ -119,7 +286,7 @@ void ProxyProtocol::ActiveConnection::close() {
   removeFromList(parent_.connections_);
 }
 
-bool ProxyProtocol::ActiveConnection::readLine(int fd, std::string& s) {
+bool ProxyProtocol::ActiveConnection::readLine(int fd) {
   while (buf_off_ < MAX_PROXY_PROTO_LEN) {
     ssize_t nread = recv(fd, buf_ + buf_off_, MAX_PROXY_PROTO_LEN - buf_off_, MSG_PEEK);
 
@@ -129,6 +296,12 @@ bool ProxyProtocol::ActiveConnection::readLine(int fd, std::string& s) {
       throw EnvoyException("failed to read proxy protocol");
     }
 
+    // A line cannot start with '\r', the first byte of the version 2 signature.
+    if (buf_off_ == 0 && buf_[0] == PROXY_PROTO_V2_SIGNATURE[0]) {
+      v2_ = true;
+      return false;
+    }
+
     bool found = false;
     // continue searching buf_ from where we left off
     for (; search_index_ < buf_off_ + nread; search_index_++) {
@@ -148,7 +321,6 @@ bool ProxyProtocol::ActiveConnection::readLine(int fd, std::string& s) {
     buf_off_ += nread;
 
     if (found) {
-      s.assign(buf_, buf_off_);
       return true;
     }
   }
@@ -156,5 +328,32 @@ bool ProxyProtocol::ActiveConnection::readLine(int fd, std::string& s) {
   throw EnvoyException("failed to read proxy protocol");
 }
 
+bool ProxyProtocol::ActiveConnection::readV2(int fd) {
+  // The length of the header is known up front, so unlike a line it is read without peeking.
+  while (buf_off_ < v2_addresses_end_ || v2_skip_ > 0) {
+    const bool skipping = buf_off_ == v2_addresses_end_;
+    const size_t length = skipping ? std::min(v2_skip_, MAX_PROXY_PROTO_LEN - buf_off_)
+                                   : v2_addresses_end_ - buf_off_;
+    const ssize_t nread = recv(fd, buf_ + buf_off_, length, 0);
+
+    if (nread == -1 && errno == EAGAIN) {
+      return false;
+    } else if (nread < 1) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+
+    if (skipping) {
+      v2_skip_ -= nread;
+    } else {
+      buf_off_ += nread;
+      if (buf_off_ == PROXY_PROTO_V2_HEADER_LEN) {
+        parseV2Header();
+      }
+    }
+  }
+
+  return true;
+}
+
 } // namespace Network
 } // namespace Envoy
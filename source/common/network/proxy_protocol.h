@@ -5,6 +5,7 @@
 #include <string>
 
 #include "envoy/event/dispatcher.h"
+#include "envoy/network/address.h"
 #include "envoy/stats/stats_macros.h"
 
 #include "common/common/linked_object.h"
@@ -30,8 +31,8 @@ struct ProxyProtocolStats {
 };
 
 /**
- * Implementation the PROXY Protocol V1
- * (http://www.haproxy.org/download/1.5/doc/proxy-protocol.txt)
+ * Implementation of the PROXY protocol, versions 1 and 2
+ * (http://www.haproxy.org/download/1.8/doc/proxy-protocol.txt)
  */
 class ProxyProtocol {
 public:
@@ -43,16 +44,32 @@ public:
 
   private:
     static const size_t MAX_PROXY_PROTO_LEN = 108;
+    static const size_t PROXY_PROTO_V2_HEADER_LEN = 16;
 
     void onRead();
     void onReadWorker();
 
     /**
-     * Helper function that attempts to read a line (delimited by '\r\n') from the socket.
+     * Helper function that attempts to read a line (delimited by '\r\n') from the socket into
+     * buf_. throws EnvoyException on any socket errors.
+     * @return bool true if a line should be read, false if more data is needed or the data turns
+     *         out to be a version 2 header, in which case v2_ is set.
+     */
+    bool readLine(int fd);
+
+    /**
+     * Helper function that attempts to read a version 2 header from the socket. The fixed part of
+     * the header and the addresses are read into buf_, and the TLVs after them are skipped.
      * throws EnvoyException on any socket errors.
-     * @return bool true if a line should be read, false if more data is needed.
+     * @return bool true if the header has been read, false if more data is needed.
      */
-    bool readLine(int fd, std::string& s);
+    bool readV2(int fd);
+
+    void parseV1();
+    void parseV2Header();
+    void parseV2();
+    void handOver(Address::InstanceConstSharedPtr remote_address,
+                  Address::InstanceConstSharedPtr local_address, bool restored);
     void close();
 
     ProxyProtocol& parent_;
@@ -66,7 +83,15 @@ public:
     // The index in buf_ where the search for '\r\n' should continue from
     size_t search_index_;
 
-    // Stores the portion of the first line that has been read so far.
+    // Whether the connection starts with a version 2 header.
+    bool v2_{};
+
+    // The offset in buf_ where the addresses of a version 2 header end, and how many bytes of TLVs
+    // are left to skip after them.
+    size_t v2_addresses_end_{PROXY_PROTO_V2_HEADER_LEN};
+    size_t v2_skip_{};
+
+    // Stores the portion of the first line, or of the version 2 header, that has been read so far.
     char buf_[MAX_PROXY_PROTO_LEN];
   };
 
@@ -10,6 +10,7 @@
 #include <netinet/ip.h>
 #include <sys/socket.h>
 
+#include <array>
 #include <cstdint>
 #include <list>
 #include <sstream>
@@ -233,6 +234,21 @@ bool Utility::isInternalAddress(const char* address) {
   return false;
 }
 
+bool Utility::isInternalAddress(const Address::Instance& address) {
+  if (address.type() != Address::Type::Ip) {
+    return false;
+  }
+
+  if (address.ip()->version() == Address::IpVersion::v4) {
+    const uint32_t addr = ntohl(address.ip()->ipv4()->address());
+    return (addr >> 24) == 10 || (addr >> 16) == 0xc0a8 || (addr >> 20) == 0xac1 ||
+           addr == INADDR_LOOPBACK;
+  }
+
+  const std::array<uint8_t, 16> addr6 = address.ip()->ipv6()->address();
+  return addr6[0] == 0xfd || memcmp(addr6.data(), &in6addr_loopback, sizeof(in6addr_loopback)) == 0;
+}
+
 bool Utility::isLoopbackAddress(const Address::Instance& address) {
   if (address.type() != Address::Type::Ip) {
     return false;
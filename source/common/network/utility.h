@@ -114,6 +114,14 @@ public:
    */
   static bool isInternalAddress(const char* address);
 
+  /**
+   * Determine whether this is an internal (RFC1918) address, without going through its string
+   * form. The same ranges are internal as for the string version.
+   * @param address supplies the address to check.
+   * @return bool the address is an RFC1918 address.
+   */
+  static bool isInternalAddress(const Address::Instance& address);
+
   /**
    * Check if address is loopback address.
    * @param address IP address to check.
@@ -5,6 +5,7 @@
 #ifdef TCMALLOC
 
 #include "gperftools/heap-profiler.h"
+#include "gperftools/malloc_extension.h"
 #include "gperftools/profiler.h"
 
 namespace Envoy {
@@ -18,11 +19,23 @@ bool Cpu::startProfiler(const std::string& output_path) {
 
 void Cpu::stopProfiler() { ProfilerStop(); }
 
-void Heap::forceLink() {
-  // Currently this is here to force the inclusion of the heap profiler during static linking.
-  // Without this call the heap profiler will not be included and cannot be started via env
-  // variable. In the future we can add admin support.
-  HeapProfilerDump("");
+bool Heap::profilerEnabled() { return IsHeapProfilerRunning(); }
+
+bool Heap::startProfiler(const std::string& output_prefix) {
+  // HeapProfilerStart() does not report failure, its output files are only opened when dumping.
+  HeapProfilerStart(output_prefix.c_str());
+  return IsHeapProfilerRunning();
+}
+
+void Heap::stopProfiler() {
+  HeapProfilerDump("admin");
+  HeapProfilerStop();
+}
+
+std::string Heap::sample() {
+  std::string sample;
+  MallocExtension::instance()->GetHeapSample(&sample);
+  return sample;
 }
 
 } // namespace Profiler
@@ -37,6 +50,11 @@ bool Cpu::profilerEnabled() { return false; }
 bool Cpu::startProfiler(const std::string&) { return false; }
 void Cpu::stopProfiler() {}
 
+bool Heap::profilerEnabled() { return false; }
+bool Heap::startProfiler(const std::string&) { return false; }
+void Heap::stopProfiler() {}
+std::string Heap::sample() { return ""; }
+
 } // namespace Profiler
 } // namespace Envoy
 
@@ -28,11 +28,35 @@ public:
 };
 
 /**
- * Process wide heap profiling
+ * Process wide heap profiling.
  */
 class Heap {
-private:
-  static void forceLink();
+public:
+  /**
+   * @return whether the heap profiler is running or not.
+   */
+  static bool profilerEnabled();
+
+  /**
+   * Start the heap profiler, which periodically writes profiles to files whose names start with
+   * the specified prefix. The heap profiler tracks every allocation, so it is expensive.
+   * @return bool whether the call to start the profiler succeeded.
+   */
+  static bool startProfiler(const std::string& output_prefix);
+
+  /**
+   * Write a last profile and stop the heap profiler.
+   */
+  static void stopProfiler();
+
+  /**
+   * Sampled allocations are only recorded when the process is started with
+   * TCMALLOC_SAMPLE_PARAMETER set to the average number of bytes between samples. Sampling is
+   * cheap enough to be left on, so the sample can be taken at any time.
+   * @return std::string the stacks of the sampled allocations which are still live, in the
+   *         format read by pprof, or an empty string if heap sampling is not available.
+   */
+  static std::string sample();
 };
 
 } // namespace Profiler
@@ -6,14 +6,62 @@
 #include "common/protobuf/protobuf.h"
 
 #include "fmt/format.h"
+#include "xxhash.h"
 
 namespace Envoy {
 
+namespace {
+
+/**
+ * Output stream that feeds everything written to it to an xxHash64 state through a fixed buffer.
+ */
+class HashOutputStream : public Protobuf::io::ZeroCopyOutputStream {
+public:
+  HashOutputStream() { XXH64_reset(&state_, 0); }
+
+  uint64_t digest() {
+    XXH64_update(&state_, buffer_, used_);
+    byte_count_ += used_;
+    used_ = 0;
+    return XXH64_digest(&state_);
+  }
+
+  // Protobuf::io::ZeroCopyOutputStream
+  bool Next(void** data, int* size) override {
+    XXH64_update(&state_, buffer_, used_);
+    byte_count_ += used_;
+    *data = buffer_;
+    *size = used_ = sizeof(buffer_);
+    return true;
+  }
+  void BackUp(int count) override { used_ -= count; }
+  Protobuf::int64 ByteCount() const override { return byte_count_ + used_; }
+
+private:
+  XXH64_state_t state_;
+  char buffer_[1024];
+  int used_{};
+  Protobuf::int64 byte_count_{};
+};
+
+} // namespace
+
 MissingFieldException::MissingFieldException(const std::string& field_name,
                                              const Protobuf::Message& message)
     : EnvoyException(
           fmt::format("Field '{}' is missing in: {}", field_name, message.DebugString())) {}
 
+std::size_t MessageUtil::hash(const Protobuf::Message& message) {
+  HashOutputStream hash_stream;
+  {
+    // The CodedOutputStream hands unused buffer back to hash_stream when destroyed.
+    Protobuf::io::CodedOutputStream coded_stream(&hash_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    message.SerializeToCodedStream(&coded_stream);
+  }
+  return hash_stream.digest();
+}
+
 void MessageUtil::loadFromJson(const std::string& json, Protobuf::Message& message) {
   const auto status = Protobuf::util::JsonStringToMessage(json, &message);
   if (!status.ok()) {
@@ -64,20 +64,14 @@ public:
 
 class MessageUtil {
 public:
-  static std::size_t hash(const Protobuf::Message& message) {
-    // Use Protobuf::io::CodedOutputStream to force deterministic serialization, so that the same
-    // message doesn't hash to different values.
-    ProtobufTypes::String text;
-    {
-      // For memory safety, the StringOutputStream needs to be destroyed before
-      // we read the string.
-      Protobuf::io::StringOutputStream string_stream(&text);
-      Protobuf::io::CodedOutputStream coded_stream(&string_stream);
-      coded_stream.SetSerializationDeterministic(true);
-      message.SerializeToCodedStream(&coded_stream);
-    }
-    return HashUtil::xxHash64(text);
-  }
+  /**
+   * Hash a message. The message is deterministically serialized, so that the same message doesn't
+   * hash to different values, straight into an xxHash64 state without building the serialized
+   * string. The result is the xxHash64 of the serialized message.
+   * @param message supplies the message to hash.
+   * @return std::size_t the hash.
+   */
+  static std::size_t hash(const Protobuf::Message& message);
 
   static void loadFromJson(const std::string& json, Protobuf::Message& message);
   static void loadFromYaml(const std::string& yaml, Protobuf::Message& message);
@@ -91,12 +85,22 @@ public:
   template <class MessageType>
   static inline MessageType anyConvert(const ProtobufWkt::Any& message) {
     MessageType typed_message;
-    if (!message.UnpackTo(&typed_message)) {
-      throw EnvoyException("Unable to unpack " + message.DebugString());
-    }
+    unpackTo(message, typed_message);
     return typed_message;
   };
 
+  /**
+   * Unpack a google.protobuf.Any into an existing typed message, e.g. a repeated field element.
+   * @param any_message source google.protobuf.Any message.
+   * @param message destination typed message.
+   * @throw EnvoyException if the Any does not hold a message of the destination type.
+   */
+  static inline void unpackTo(const ProtobufWkt::Any& any_message, Protobuf::Message& message) {
+    if (!any_message.UnpackTo(&message)) {
+      throw EnvoyException("Unable to unpack " + any_message.DebugString());
+    }
+  }
+
   /**
    * Convert between two protobufs via a JSON round-trip. This is used to translate arbitrary
    * messages to/from google.protobuf.Struct.
@@ -0,0 +1,153 @@
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/json/config_schemas.h"
+#include "common/tracing/http_tracer_impl.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+TokenBucket::TokenBucket(uint64_t max_tokens, uint64_t tokens_per_fill,
+                         std::chrono::milliseconds fill_interval, MonotonicTime now)
+    : max_tokens_(max_tokens), tokens_per_fill_(tokens_per_fill), fill_interval_(fill_interval),
+      tokens_(max_tokens), last_fill_(now) {}
+
+bool TokenBucket::consume(MonotonicTime now) {
+  if (tokens_ == 0) {
+    refill(now);
+    if (tokens_ == 0) {
+      return false;
+    }
+  } else if (tokens_ < max_tokens_) {
+    refill(now);
+  }
+
+  tokens_--;
+  return true;
+}
+
+void TokenBucket::refill(MonotonicTime now) {
+  if (now < last_fill_ + fill_interval_) {
+    return;
+  }
+
+  const uint64_t fills = (now - last_fill_) / fill_interval_;
+  last_fill_ += fills * fill_interval_;
+  // Saturate rather than overflow after a long idle period.
+  if (fills >= (max_tokens_ - tokens_) / tokens_per_fill_ + 1) {
+    tokens_ = max_tokens_;
+  } else {
+    tokens_ = std::min(max_tokens_, tokens_ + fills * tokens_per_fill_);
+  }
+}
+
+bool LocalRateLimitRule::matches(const Descriptor& descriptor) const {
+  if (descriptor.entries_.size() != entries_.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].key_ != descriptor.entries_[i].key_ ||
+        (!entries_[i].value_.empty() && entries_[i].value_ != descriptor.entries_[i].value_)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+LocalRateLimitConfig::LocalRateLimitConfig(const Json::Object& config,
+                                           ThreadLocal::SlotAllocator& tls,
+                                           MonotonicTimeSource& time_source,
+                                           ClientCreateCb remote_client_cb)
+    : Json::Validator(config, Json::Schema::LOCAL_RATE_LIMIT_SCHEMA),
+      global_sync_(config.getBoolean("global_sync", false)), time_source_(time_source),
+      remote_client_cb_(remote_client_cb), tls_slot_(tls.allocateSlot()) {
+  for (const Json::ObjectSharedPtr& rule : config.getObjectArray("rules")) {
+    LocalRateLimitRule new_rule;
+    for (const Json::ObjectSharedPtr& entry : rule->getObjectArray("descriptor")) {
+      new_rule.entries_.push_back({entry->getString("key"), entry->getString("value", "")});
+    }
+    new_rule.max_tokens_ = rule->getInteger("max_tokens");
+    new_rule.tokens_per_fill_ = rule->getInteger("tokens_per_fill", new_rule.max_tokens_);
+    new_rule.fill_interval_ = std::chrono::milliseconds(rule->getInteger("fill_interval_ms"));
+    rules_.push_back(std::move(new_rule));
+  }
+
+  const std::vector<LocalRateLimitRule> rules = rules_;
+  tls_slot_->set(
+      [rules, &time_source](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+        return std::make_shared<ThreadLocalLimiter>(rules, time_source.currentTime());
+      });
+}
+
+LimitStatus LocalRateLimitConfig::limit(const std::string& domain,
+                                        const std::vector<Descriptor>& descriptors) {
+  ThreadLocalLimiter& limiter = tls_slot_->getTyped<ThreadLocalLimiter>();
+  const MonotonicTime now = time_source_.currentTime();
+
+  LimitStatus status = LimitStatus::OK;
+  std::vector<size_t> matched_rules;
+  for (const Descriptor& descriptor : descriptors) {
+    for (size_t i = 0; i < rules_.size(); i++) {
+      if (rules_[i].matches(descriptor)) {
+        matched_rules.push_back(i);
+        if (!limiter.buckets_[i].consume(now)) {
+          status = LimitStatus::OverLimit;
+        }
+      }
+    }
+  }
+
+  if (status == LimitStatus::OK && global_sync_ && !matched_rules.empty() && !limiter.syncing_) {
+    sync(limiter, domain, descriptors, std::move(matched_rules));
+  }
+
+  return status;
+}
+
+void LocalRateLimitConfig::sync(ThreadLocalLimiter& limiter, const std::string& domain,
+                                const std::vector<Descriptor>& descriptors,
+                                std::vector<size_t>&& matched_rules) {
+  if (!limiter.remote_client_) {
+    limiter.remote_client_ = remote_client_cb_();
+  }
+
+  limiter.syncing_ = true;
+  limiter.syncing_rules_ = std::move(matched_rules);
+  // The answer may come inline, which completes the sync before limit() returns.
+  limiter.remote_client_->limit(limiter, domain, descriptors, Tracing::NullSpan::instance());
+}
+
+LocalRateLimitConfig::ThreadLocalLimiter::ThreadLocalLimiter(
+    const std::vector<LocalRateLimitRule>& rules, MonotonicTime now) {
+  buckets_.reserve(rules.size());
+  for (const LocalRateLimitRule& rule : rules) {
+    buckets_.emplace_back(rule.max_tokens_, rule.tokens_per_fill_, rule.fill_interval_, now);
+  }
+}
+
+LocalRateLimitConfig::ThreadLocalLimiter::~ThreadLocalLimiter() {
+  if (syncing_) {
+    remote_client_->cancel();
+  }
+}
+
+void LocalRateLimitConfig::ThreadLocalLimiter::complete(LimitStatus status) {
+  syncing_ = false;
+  // The rate limit service has the global view: the worker stops letting requests through for the
+  // rules which are over the global limit until its buckets are next refilled.
+  if (status == LimitStatus::OverLimit) {
+    for (size_t rule : syncing_rules_) {
+      buckets_[rule].drain();
+    }
+  }
+}
+
+} // namespace RateLimit
+} // namespace Envoy
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/json/json_object.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/json/json_validator.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+/**
+ * A token bucket which holds up to max_tokens tokens and gains tokens_per_fill tokens every
+ * fill_interval. It is refilled lazily, when a token is consumed, so it needs neither a timer nor
+ * a lock as long as it is only used by one thread.
+ */
+class TokenBucket {
+public:
+  TokenBucket(uint64_t max_tokens, uint64_t tokens_per_fill,
+              std::chrono::milliseconds fill_interval, MonotonicTime now);
+
+  /**
+   * Consume a token, if there is one once the bucket has been refilled.
+   * @return bool whether a token was consumed.
+   */
+  bool consume(MonotonicTime now);
+
+  /**
+   * Remove all the tokens of the bucket, until it is next refilled.
+   */
+  void drain() { tokens_ = 0; }
+
+  uint64_t tokens() const { return tokens_; }
+
+private:
+  void refill(MonotonicTime now);
+
+  const uint64_t max_tokens_;
+  const uint64_t tokens_per_fill_;
+  const std::chrono::milliseconds fill_interval_;
+  uint64_t tokens_;
+  MonotonicTime last_fill_;
+};
+
+/**
+ * A rule of the local rate limiter: the descriptor which it applies to, and its bucket.
+ */
+struct LocalRateLimitRule {
+  /**
+   * @return bool whether the rule applies to a descriptor. An entry of the rule without a value
+   *         matches any value of its key.
+   */
+  bool matches(const Descriptor& descriptor) const;
+
+  std::vector<DescriptorEntry> entries_;
+  uint64_t max_tokens_;
+  uint64_t tokens_per_fill_;
+  std::chrono::milliseconds fill_interval_;
+};
+
+/**
+ * Creates the client of the rate limit service which the local limiter reconciles with.
+ */
+typedef std::function<ClientPtr()> ClientCreateCb;
+
+/**
+ * Configuration of the local rate limiter. Each worker has its own token buckets, so that a
+ * request is decided without a lock and without a call to the rate limit service. With global
+ * sync, each worker also reports the descriptors of the requests which it lets through to the
+ * rate limit service in the background, one request at a time, and drains the buckets of the
+ * rules which the service says are over limit.
+ */
+class LocalRateLimitConfig : Json::Validator {
+public:
+  LocalRateLimitConfig(const Json::Object& config, ThreadLocal::SlotAllocator& tls,
+                       MonotonicTimeSource& time_source, ClientCreateCb remote_client_cb);
+
+  /**
+   * Decide whether a request is over the limit of the worker, consuming a token of the bucket of
+   * each rule which applies to its descriptors.
+   */
+  LimitStatus limit(const std::string& domain, const std::vector<Descriptor>& descriptors);
+
+  const std::vector<LocalRateLimitRule>& rules() const { return rules_; }
+  bool globalSync() const { return global_sync_; }
+
+private:
+  struct ThreadLocalLimiter : public ThreadLocal::ThreadLocalObject, public RequestCallbacks {
+    ThreadLocalLimiter(const std::vector<LocalRateLimitRule>& rules, MonotonicTime now);
+    ~ThreadLocalLimiter();
+
+    // RateLimit::RequestCallbacks
+    void complete(LimitStatus status) override;
+
+    std::vector<TokenBucket> buckets_;
+    ClientPtr remote_client_;
+    bool syncing_{};
+    // The rules which applied to the request being reconciled with the rate limit service.
+    std::vector<size_t> syncing_rules_;
+  };
+
+  void sync(ThreadLocalLimiter& limiter, const std::string& domain,
+            const std::vector<Descriptor>& descriptors, std::vector<size_t>&& matched_rules);
+
+  std::vector<LocalRateLimitRule> rules_;
+  const bool global_sync_;
+  MonotonicTimeSource& time_source_;
+  ClientCreateCb remote_client_cb_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<LocalRateLimitConfig> LocalRateLimitConfigSharedPtr;
+
+/**
+ * A client which decides the requests with the local rate limiter of the worker. It completes
+ * every request inline.
+ */
+class LocalClientImpl : public Client {
+public:
+  LocalClientImpl(LocalRateLimitConfigSharedPtr config) : config_(config) {}
+
+  // RateLimit::Client
+  void cancel() override {}
+  void limit(RequestCallbacks& callbacks, const std::string& domain,
+             const std::vector<Descriptor>& descriptors, Tracing::Span&) override {
+    callbacks.complete(config_->limit(domain, descriptors));
+  }
+
+private:
+  LocalRateLimitConfigSharedPtr config_;
+};
+
+} // namespace RateLimit
+} // namespace Envoy
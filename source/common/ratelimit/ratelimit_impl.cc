@@ -14,11 +14,132 @@
 namespace Envoy {
 namespace RateLimit {
 
+namespace {
+
+// The cache key of a descriptor. Each part is prefixed with its length so that distinct
+// descriptors never share a key.
+void appendKeyPart(std::string& key, const std::string& part) {
+  key.append(std::to_string(part.size()));
+  key.push_back(':');
+  key.append(part);
+}
+
+std::string descriptorKey(const std::string& domain, const Descriptor& descriptor) {
+  std::string key;
+  appendKeyPart(key, domain);
+  for (const DescriptorEntry& entry : descriptor.entries_) {
+    appendKeyPart(key, entry.key_);
+    appendKeyPart(key, entry.value_);
+  }
+  return key;
+}
+
+std::string descriptorKey(const std::string& domain,
+                          const pb::lyft::ratelimit::RateLimitDescriptor& descriptor) {
+  std::string key;
+  appendKeyPart(key, domain);
+  for (const pb::lyft::ratelimit::RateLimitDescriptor::Entry& entry : descriptor.entries()) {
+    appendKeyPart(key, entry.key());
+    appendKeyPart(key, entry.value());
+  }
+  return key;
+}
+
+} // namespace
+
+CacheStats DescriptorCache::generateStats(Stats::Scope& scope) {
+  const std::string final_prefix = "ratelimit.cache.";
+  return {ALL_RATELIMIT_CACHE_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+bool DescriptorCache::lookup(const std::string& domain,
+                             const std::vector<Descriptor>& descriptors) {
+  if (runtime_.snapshot().getInteger(Constants::get().CacheTtlKey, 0) == 0 ||
+      descriptors.empty()) {
+    return false;
+  }
+
+  const MonotonicTime now = time_source_.currentTime();
+  std::vector<std::unordered_map<std::string, Entry>::iterator> hits;
+  hits.reserve(descriptors.size());
+  for (const Descriptor& descriptor : descriptors) {
+    auto it = entries_.find(descriptorKey(domain, descriptor));
+    if (it == entries_.end() || it->second.expiry_ <= now) {
+      if (it != entries_.end()) {
+        entries_.erase(it);
+      }
+      stats_.miss_.inc();
+      return false;
+    }
+    // An entry which has run out is kept until it is answered for again or expires.
+    if (it->second.limit_remaining_ == 0) {
+      stats_.miss_.inc();
+      return false;
+    }
+    hits.push_back(it);
+  }
+
+  stats_.hit_.inc();
+  for (auto it : hits) {
+    // A descriptor may be in the request more than once.
+    if (it->second.limit_remaining_ > 0) {
+      it->second.limit_remaining_--;
+    }
+  }
+  return true;
+}
+
+void DescriptorCache::update(const pb::lyft::ratelimit::RateLimitRequest& request,
+                             const pb::lyft::ratelimit::RateLimitResponse& response) {
+  const uint64_t ttl = runtime_.snapshot().getInteger(Constants::get().CacheTtlKey, 0);
+  if (ttl == 0 || response.statuses_size() != request.descriptors_size()) {
+    return;
+  }
+
+  const MonotonicTime now = time_source_.currentTime();
+  const uint64_t max_entries =
+      runtime_.snapshot().getInteger(Constants::get().CacheMaxEntriesKey, 10000);
+  for (int i = 0; i < request.descriptors_size(); i++) {
+    const pb::lyft::ratelimit::RateLimitResponse::DescriptorStatus& status = response.statuses(i);
+    std::string key = descriptorKey(request.domain(), request.descriptors(i));
+    if (status.code() != pb::lyft::ratelimit::RateLimitResponse_Code_OK ||
+        status.limit_remaining() == 0) {
+      entries_.erase(key);
+      continue;
+    }
+
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      if (entries_.size() >= max_entries) {
+        removeExpired(now);
+      }
+      if (entries_.size() >= max_entries) {
+        stats_.overflow_.inc();
+        continue;
+      }
+      it = entries_.emplace(std::move(key), Entry()).first;
+    }
+    it->second.expiry_ = now + std::chrono::milliseconds(ttl);
+    it->second.limit_remaining_ = status.limit_remaining();
+  }
+}
+
+void DescriptorCache::removeExpired(MonotonicTime now) {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.expiry_ <= now) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 GrpcClientImpl::GrpcClientImpl(RateLimitAsyncClientPtr&& async_client,
-                               const Optional<std::chrono::milliseconds>& timeout)
+                               const Optional<std::chrono::milliseconds>& timeout,
+                               DescriptorCacheSharedPtr cache)
     : service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
           "pb.lyft.ratelimit.RateLimitService.ShouldRateLimit")),
-      async_client_(std::move(async_client)), timeout_(timeout) {}
+      async_client_(std::move(async_client)), timeout_(timeout), cache_(cache) {}
 
 GrpcClientImpl::~GrpcClientImpl() { ASSERT(!callbacks_); }
 
@@ -45,12 +166,17 @@ void GrpcClientImpl::createRequest(pb::lyft::ratelimit::RateLimitRequest& reques
 void GrpcClientImpl::limit(RequestCallbacks& callbacks, const std::string& domain,
                            const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) {
   ASSERT(callbacks_ == nullptr);
+  if (cache_ && cache_->lookup(domain, descriptors)) {
+    callbacks.complete(LimitStatus::OK);
+    return;
+  }
+
   callbacks_ = &callbacks;
 
-  pb::lyft::ratelimit::RateLimitRequest request;
-  createRequest(request, domain, descriptors);
+  pending_request_.Clear();
+  createRequest(pending_request_, domain, descriptors);
 
-  request_ = async_client_->send(service_method_, request, *this, parent_span, timeout_);
+  request_ = async_client_->send(service_method_, pending_request_, *this, parent_span, timeout_);
 }
 
 void GrpcClientImpl::onSuccess(std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse>&& response,
@@ -64,6 +190,10 @@ void GrpcClientImpl::onSuccess(std::unique_ptr<pb::lyft::ratelimit::RateLimitRes
     span.setTag(Constants::get().TraceStatus, Constants::get().TraceOk);
   }
 
+  if (cache_) {
+    cache_->update(pending_request_, *response);
+  }
+
   callbacks_->complete(status);
   callbacks_ = nullptr;
 }
@@ -76,20 +206,220 @@ void GrpcClientImpl::onFailure(Grpc::Status::GrpcStatus status, const std::strin
   callbacks_ = nullptr;
 }
 
+GrpcBatcher::GrpcBatcher(RateLimitAsyncClientPtr&& async_client, Event::Dispatcher& dispatcher,
+                         Runtime::Loader& runtime, DescriptorCacheSharedPtr cache)
+    : service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+          "pb.lyft.ratelimit.RateLimitService.ShouldRateLimit")),
+      async_client_(std::move(async_client)), runtime_(runtime), cache_(cache),
+      flush_timer_(dispatcher.createTimer([this]() -> void { flush(); })) {}
+
+GrpcBatcher::~GrpcBatcher() {
+  // Every client has completed or cancelled its request by now, and an empty batch is dropped.
+  ASSERT(pending_batches_.empty());
+  ASSERT(sent_batches_.empty());
+}
+
+void GrpcBatcher::limit(BatchedGrpcClientImpl& client, const std::string& domain,
+                        const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span,
+                        const Optional<std::chrono::milliseconds>& timeout) {
+  Batch* batch = nullptr;
+  for (const BatchPtr& pending_batch : pending_batches_) {
+    if (pending_batch->request_.domain() == domain && pending_batch->timeout_ == timeout) {
+      batch = pending_batch.get();
+      break;
+    }
+  }
+
+  if (batch == nullptr) {
+    if (pending_batches_.empty()) {
+      // With the default window of 0 the batch holds the requests made within the same iteration
+      // of the event loop.
+      flush_timer_->enableTimer(std::chrono::milliseconds(
+          runtime_.snapshot().getInteger(Constants::get().BatchWindowKey, 0)));
+    }
+    BatchPtr new_batch(new Batch(*this, timeout));
+    batch = new_batch.get();
+    new_batch->moveIntoListBack(std::move(new_batch), pending_batches_);
+  }
+
+  GrpcClientImpl::createRequest(batch->request_, domain, descriptors);
+  batch->entries_.push_back({&client, &parent_span, descriptors.size()});
+  batch->live_entries_++;
+  client_batches_[&client] = batch;
+}
+
+void GrpcBatcher::cancel(BatchedGrpcClientImpl& client) {
+  auto it = client_batches_.find(&client);
+  ASSERT(it != client_batches_.end());
+  Batch& batch = *it->second;
+  client_batches_.erase(it);
+
+  for (Batch::Entry& entry : batch.entries_) {
+    if (entry.client_ == &client) {
+      entry.client_ = nullptr;
+      entry.parent_span_ = nullptr;
+    }
+  }
+
+  // A batch which is completing its clients is destroyed once it is done.
+  batch.live_entries_--;
+  if (batch.live_entries_ > 0 || batch.completing_) {
+    return;
+  }
+
+  if (batch.sent_) {
+    batch.async_request_->cancel();
+    batch.removeFromList(sent_batches_);
+  } else {
+    batch.removeFromList(pending_batches_);
+  }
+}
+
+void GrpcBatcher::flush() {
+  while (!pending_batches_.empty()) {
+    Batch& batch = *pending_batches_.front();
+    batch.moveBetweenLists(pending_batches_, sent_batches_);
+    batch.sent_ = true;
+
+    // The span of the batch is a child of the span of its first request.
+    Tracing::Span* parent_span = nullptr;
+    for (const Batch::Entry& entry : batch.entries_) {
+      if (entry.parent_span_ != nullptr) {
+        parent_span = entry.parent_span_;
+        break;
+      }
+    }
+    ASSERT(parent_span != nullptr);
+
+    // The batch is destroyed before send() returns when it fails inline.
+    Grpc::AsyncRequest* async_request =
+        async_client_->send(service_method_, batch.request_, batch, *parent_span, batch.timeout_);
+    if (async_request != nullptr) {
+      batch.async_request_ = async_request;
+    }
+  }
+}
+
+void GrpcBatcher::Batch::onSuccess(
+    std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse>&& response, Tracing::Span& span) {
+  ASSERT(response->overall_code() != pb::lyft::ratelimit::RateLimitResponse_Code_UNKNOWN);
+  if (response->overall_code() == pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT) {
+    span.setTag(Constants::get().TraceStatus, Constants::get().TraceOverLimit);
+  } else {
+    span.setTag(Constants::get().TraceStatus, Constants::get().TraceOk);
+  }
+
+  if (parent_.cache_) {
+    parent_.cache_->update(request_, *response);
+  }
+
+  complete(response.get());
+}
+
+void GrpcBatcher::Batch::onFailure(Grpc::Status::GrpcStatus status, const std::string&,
+                                   Tracing::Span&) {
+  ASSERT(status != Grpc::Status::GrpcStatus::Ok);
+  UNREFERENCED_PARAMETER(status);
+  complete(nullptr);
+}
+
+void GrpcBatcher::Batch::complete(const pb::lyft::ratelimit::RateLimitResponse* response) {
+  // Without a status per descriptor, every request of the batch gets the overall code.
+  const bool per_descriptor =
+      response != nullptr && response->statuses_size() == request_.descriptors_size();
+
+  completing_ = true;
+  int first_descriptor = 0;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    // A client may cancel the request of another client of the batch from its callbacks.
+    BatchedGrpcClientImpl* client = entries_[i].client_;
+    const int descriptors = entries_[i].descriptors_;
+    if (client != nullptr) {
+      LimitStatus status = LimitStatus::OK;
+      if (response == nullptr) {
+        status = LimitStatus::Error;
+      } else if (per_descriptor) {
+        for (int j = first_descriptor; j < first_descriptor + descriptors; j++) {
+          if (response->statuses(j).code() ==
+              pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT) {
+            status = LimitStatus::OverLimit;
+          }
+        }
+      } else if (response->overall_code() ==
+                 pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT) {
+        status = LimitStatus::OverLimit;
+      }
+
+      entries_[i].client_ = nullptr;
+      parent_.client_batches_.erase(client);
+      client->complete(status);
+    }
+    first_descriptor += descriptors;
+  }
+
+  removeFromList(parent_.sent_batches_);
+}
+
+BatchedGrpcClientImpl::~BatchedGrpcClientImpl() { ASSERT(!callbacks_); }
+
+void BatchedGrpcClientImpl::cancel() {
+  ASSERT(callbacks_ != nullptr);
+  batcher_->cancel(*this);
+  callbacks_ = nullptr;
+}
+
+void BatchedGrpcClientImpl::limit(RequestCallbacks& callbacks, const std::string& domain,
+                                  const std::vector<Descriptor>& descriptors,
+                                  Tracing::Span& parent_span) {
+  ASSERT(callbacks_ == nullptr);
+  if (cache_ && cache_->lookup(domain, descriptors)) {
+    callbacks.complete(LimitStatus::OK);
+    return;
+  }
+
+  callbacks_ = &callbacks;
+  batcher_->limit(*this, domain, descriptors, parent_span, timeout_);
+}
+
+void BatchedGrpcClientImpl::complete(LimitStatus status) {
+  RequestCallbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  callbacks->complete(status);
+}
+
 GrpcFactoryImpl::GrpcFactoryImpl(const envoy::api::v2::RateLimitServiceConfig& config,
-                                 Upstream::ClusterManager& cm)
-    : cluster_name_(config.cluster_name()), cm_(cm) {
+                                 Upstream::ClusterManager& cm, ThreadLocal::SlotAllocator& tls,
+                                 Runtime::Loader& runtime, Stats::Scope& scope,
+                                 MonotonicTimeSource& time_source)
+    : cluster_name_(config.cluster_name()), cm_(cm), runtime_(runtime),
+      cache_stats_(DescriptorCache::generateStats(scope)), tls_slot_(tls.allocateSlot()) {
   if (!cm_.get(cluster_name_)) {
     throw EnvoyException(fmt::format("unknown rate limit service cluster '{}'", cluster_name_));
   }
+
+  tls_slot_->set([this, &time_source](
+                     Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    std::shared_ptr<ThreadLocalState> state = std::make_shared<ThreadLocalState>();
+    state->cache_ = std::make_shared<DescriptorCache>(cache_stats_, runtime_, time_source);
+    state->batcher_ =
+        std::make_shared<GrpcBatcher>(createAsyncClient(), dispatcher, runtime_, state->cache_);
+    return state;
+  });
 }
 
 ClientPtr GrpcFactoryImpl::create(const Optional<std::chrono::milliseconds>& timeout) {
-  return ClientPtr{new GrpcClientImpl(
-      RateLimitAsyncClientPtr{
-          new Grpc::AsyncClientImpl<pb::lyft::ratelimit::RateLimitRequest,
-                                    pb::lyft::ratelimit::RateLimitResponse>(cm_, cluster_name_)},
-      timeout)};
+  ThreadLocalState& state = tls_slot_->getTyped<ThreadLocalState>();
+  if (runtime_.snapshot().featureEnabled(Constants::get().BatchingEnabledKey, 0)) {
+    return ClientPtr{new BatchedGrpcClientImpl(state.batcher_, timeout, state.cache_)};
+  }
+
+  return ClientPtr{new GrpcClientImpl(createAsyncClient(), timeout, state.cache_)};
+}
+
+RateLimitAsyncClientPtr GrpcFactoryImpl::createAsyncClient() {
+  return RateLimitAsyncClientPtr{
+      new Grpc::AsyncClientImpl<pb::lyft::ratelimit::RateLimitRequest,
+                                pb::lyft::ratelimit::RateLimitResponse>(cm_, cluster_name_)};
 }
 
 } // namespace RateLimit
@@ -2,14 +2,24 @@
 
 #include <chrono>
 #include <cstdint>
+#include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
 #include "envoy/grpc/async_client.h"
 #include "envoy/ratelimit/ratelimit.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/tracing/http_tracer.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/common/linked_object.h"
 #include "common/common/singleton.h"
 
 #include "source/common/ratelimit/ratelimit.pb.h"
@@ -30,17 +40,85 @@ struct ConstantValues {
   const std::string TraceStatus = "ratelimit_status";
   const std::string TraceOverLimit = "over_limit";
   const std::string TraceOk = "ok";
+  const std::string BatchingEnabledKey = "ratelimit.batching_enabled";
+  const std::string BatchWindowKey = "ratelimit.batch_window_ms";
+  const std::string CacheTtlKey = "ratelimit.cache_ttl_ms";
+  const std::string CacheMaxEntriesKey = "ratelimit.cache_max_entries";
 };
 
 typedef ConstSingleton<ConstantValues> Constants;
 
-// TODO(htuch): We should have only one client per thread, but today we create one per filter stack.
-// This will require support for more than one outstanding request per client (limit() assumes only
-// one today).
+/**
+ * All rate limit client cache stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_RATELIMIT_CACHE_STATS(COUNTER)                                                         \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(overflow)
+// clang-format on
+
+/**
+ * Struct definition for all rate limit client cache stats. @see stats_macros.h
+ */
+struct CacheStats {
+  ALL_RATELIMIT_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Caches, per worker, the descriptors which the rate limit service has said are OK along with
+ * the limit which they have left. A request whose descriptors all have some limit left is decided
+ * without calling the rate limit service, using up one of the limit left of each descriptor, until
+ * the limit left runs out or the entries expire. The entries are kept for the
+ * ratelimit.cache_ttl_ms runtime setting, and the cache is disabled when it is 0.
+ */
+class DescriptorCache : public ThreadLocal::ThreadLocalObject {
+public:
+  DescriptorCache(CacheStats& stats, Runtime::Loader& runtime, MonotonicTimeSource& time_source)
+      : stats_(stats), runtime_(runtime), time_source_(time_source) {}
+
+  static CacheStats generateStats(Stats::Scope& scope);
+
+  /**
+   * Decide a request from the cache.
+   * @return bool whether all the descriptors of the request have some limit left, in which case
+   *         the request is OK and one of the limit left of each descriptor has been used up.
+   */
+  bool lookup(const std::string& domain, const std::vector<Descriptor>& descriptors);
+
+  /**
+   * Cache the OK descriptors of a response which have some limit left, and remove the others.
+   */
+  void update(const pb::lyft::ratelimit::RateLimitRequest& request,
+              const pb::lyft::ratelimit::RateLimitResponse& response);
+
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    MonotonicTime expiry_;
+    uint32_t limit_remaining_;
+  };
+
+  void removeExpired(MonotonicTime now);
+
+  CacheStats& stats_;
+  Runtime::Loader& runtime_;
+  MonotonicTimeSource& time_source_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+typedef std::shared_ptr<DescriptorCache> DescriptorCacheSharedPtr;
+
+/**
+ * A client with its own gRPC client, which allows one outstanding request at a time. See
+ * BatchedGrpcClientImpl for the clients which share the gRPC client of the worker.
+ */
 class GrpcClientImpl : public Client, public RateLimitAsyncCallbacks {
 public:
   GrpcClientImpl(RateLimitAsyncClientPtr&& async_client,
-                 const Optional<std::chrono::milliseconds>& timeout);
+                 const Optional<std::chrono::milliseconds>& timeout,
+                 DescriptorCacheSharedPtr cache = nullptr);
   ~GrpcClientImpl();
 
   static void createRequest(pb::lyft::ratelimit::RateLimitRequest& request,
@@ -63,20 +141,149 @@ private:
   RateLimitAsyncClientPtr async_client_;
   Grpc::AsyncRequest* request_{};
   Optional<std::chrono::milliseconds> timeout_;
+  DescriptorCacheSharedPtr cache_;
+  // The outstanding request, kept to update the cache with its response.
+  pb::lyft::ratelimit::RateLimitRequest pending_request_;
   RequestCallbacks* callbacks_{};
 };
 
+class BatchedGrpcClientImpl;
+
+/**
+ * Batches the requests of all the clients of a worker over the one gRPC client of the worker. The
+ * requests for the same domain and with the same timeout which are made within the batch window
+ * are merged into one RateLimitRequest, and each request is completed with the statuses of its own
+ * descriptors. Any number of batches can be outstanding at a time.
+ */
+class GrpcBatcher : public ThreadLocal::ThreadLocalObject {
+public:
+  GrpcBatcher(RateLimitAsyncClientPtr&& async_client, Event::Dispatcher& dispatcher,
+              Runtime::Loader& runtime, DescriptorCacheSharedPtr cache = nullptr);
+  ~GrpcBatcher();
+
+  /**
+   * Add the request of a client to the pending batch for its domain and timeout. The client is
+   * completed once the batch has been answered.
+   */
+  void limit(BatchedGrpcClientImpl& client, const std::string& domain,
+             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span,
+             const Optional<std::chrono::milliseconds>& timeout);
+
+  /**
+   * Remove the outstanding request of a client from its batch. A batch without any request left is
+   * not sent, or is cancelled if it has already been sent.
+   */
+  void cancel(BatchedGrpcClientImpl& client);
+
+private:
+  struct Batch : public RateLimitAsyncCallbacks, public LinkedObject<Batch> {
+    Batch(GrpcBatcher& parent, const Optional<std::chrono::milliseconds>& timeout)
+        : parent_(parent), timeout_(timeout) {}
+
+    // Grpc::AsyncRequestCallbacks
+    void onCreateInitialMetadata(Http::HeaderMap&) override {}
+    void onSuccess(std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse>&& response,
+                   Tracing::Span& span) override;
+    void onFailure(Grpc::Status::GrpcStatus status, const std::string& message,
+                   Tracing::Span& span) override;
+
+    /**
+     * Complete the clients of the batch and destroy it. Without a response, every client is
+     * completed with an error.
+     */
+    void complete(const pb::lyft::ratelimit::RateLimitResponse* response);
+
+    struct Entry {
+      // Null once the client has cancelled its request.
+      BatchedGrpcClientImpl* client_;
+      Tracing::Span* parent_span_;
+      // The number of descriptors of the request in the batch.
+      size_t descriptors_;
+    };
+
+    GrpcBatcher& parent_;
+    const Optional<std::chrono::milliseconds> timeout_;
+    pb::lyft::ratelimit::RateLimitRequest request_;
+    std::vector<Entry> entries_;
+    size_t live_entries_{};
+    bool sent_{};
+    bool completing_{};
+    Grpc::AsyncRequest* async_request_{};
+  };
+
+  typedef std::unique_ptr<Batch> BatchPtr;
+
+  void flush();
+
+  const Protobuf::MethodDescriptor& service_method_;
+  RateLimitAsyncClientPtr async_client_;
+  Runtime::Loader& runtime_;
+  DescriptorCacheSharedPtr cache_;
+  Event::TimerPtr flush_timer_;
+  std::list<BatchPtr> pending_batches_;
+  std::list<BatchPtr> sent_batches_;
+  std::unordered_map<BatchedGrpcClientImpl*, Batch*> client_batches_;
+};
+
+typedef std::shared_ptr<GrpcBatcher> GrpcBatcherSharedPtr;
+
+/**
+ * A client which hands its requests to the batcher of the worker, so that any number of clients
+ * share one gRPC client, and their requests share RPCs to the rate limit service.
+ */
+class BatchedGrpcClientImpl : public Client {
+public:
+  BatchedGrpcClientImpl(GrpcBatcherSharedPtr batcher,
+                        const Optional<std::chrono::milliseconds>& timeout,
+                        DescriptorCacheSharedPtr cache = nullptr)
+      : batcher_(batcher), timeout_(timeout), cache_(cache) {}
+  ~BatchedGrpcClientImpl();
+
+  /**
+   * Called by the batcher once the batch of the outstanding request has been answered.
+   */
+  void complete(LimitStatus status);
+
+  // RateLimit::Client
+  void cancel() override;
+  void limit(RequestCallbacks& callbacks, const std::string& domain,
+             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) override;
+
+private:
+  GrpcBatcherSharedPtr batcher_;
+  const Optional<std::chrono::milliseconds> timeout_;
+  DescriptorCacheSharedPtr cache_;
+  RequestCallbacks* callbacks_{};
+};
+
+/**
+ * Creates the clients of the rate limit service. When the ratelimit.batching_enabled runtime
+ * feature is enabled, the clients share the batcher of their worker, otherwise each client has its
+ * own gRPC client. Either way the clients of a worker share its descriptor cache.
+ */
 class GrpcFactoryImpl : public ClientFactory {
 public:
   GrpcFactoryImpl(const envoy::api::v2::RateLimitServiceConfig& config,
-                  Upstream::ClusterManager& cm);
+                  Upstream::ClusterManager& cm, ThreadLocal::SlotAllocator& tls,
+                  Runtime::Loader& runtime, Stats::Scope& scope,
+                  MonotonicTimeSource& time_source);
 
   // RateLimit::ClientFactory
   ClientPtr create(const Optional<std::chrono::milliseconds>& timeout) override;
 
 private:
+  struct ThreadLocalState : public ThreadLocal::ThreadLocalObject {
+    DescriptorCacheSharedPtr cache_;
+    GrpcBatcherSharedPtr batcher_;
+  };
+
+  RateLimitAsyncClientPtr createAsyncClient();
+
   const std::string cluster_name_;
   Upstream::ClusterManager& cm_;
+  Runtime::Loader& runtime_;
+  CacheStats cache_stats_;
+  ThreadLocal::SlotPtr tls_slot_;
 };
 
 class NullClientImpl : public Client {
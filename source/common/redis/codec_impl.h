@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <forward_list>
 #include <string>
 #include <vector>
 
@@ -16,6 +15,8 @@ namespace Redis {
  * Decoder implementation of https://redis.io/topics/protocol
  *
  * This implementation buffers when needed and will always consume all bytes passed for decoding.
+ * The stack of the values being decoded keeps its storage from one value to the next, so that
+ * decoding a value only allocates the value itself.
  */
 class DecoderImpl : public Decoder, Logger::Loggable<Logger::Id::redis> {
 public:
@@ -55,11 +56,16 @@ private:
 
   void parseSlice(const Buffer::RawSlice& slice);
 
+  // The declared length of a bulk string is only trusted up to this many bytes when reserving
+  // its storage, larger strings grow as their bytes arrive.
+  static const uint64_t MAX_BULK_STRING_RESERVE = 64 * 1024;
+
   DecoderCallbacks& callbacks_;
   State state_{State::ValueRootStart};
   PendingInteger pending_integer_;
   RespValuePtr pending_value_root_;
-  std::forward_list<PendingValue> pending_value_stack_;
+  // Used as a stack, the value being decoded is at the back.
+  std::vector<PendingValue> pending_value_stack_;
 };
 
 /**
@@ -1,5 +1,6 @@
 #include "common/redis/conn_pool_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -7,8 +8,12 @@
 
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
+#include "common/common/utility.h"
 #include "common/http/codes.h"
 #include "common/json/config_schemas.h"
+#include "common/redis/supported_commands.h"
+
+#include "fmt/format.h"
 
 namespace Envoy {
 namespace Redis {
@@ -16,7 +21,65 @@ namespace ConnPool {
 
 ConfigImpl::ConfigImpl(const Json::Object& config)
     : Validator(config, Json::Schema::REDIS_CONN_POOL_SCHEMA),
-      op_timeout_(config.getInteger("op_timeout_ms")) {}
+      op_timeout_(config.getInteger("op_timeout_ms")),
+      batch_writes_(config.getBoolean("batch_writes", false)),
+      cluster_mode_(config.getBoolean("cluster_mode", false)),
+      collapse_reads_(config.getBoolean("collapse_reads", false)),
+      hot_keys_enabled_(config.hasObject("hot_keys")) {
+  const Json::ObjectSharedPtr hot_keys = config.getObject("hot_keys", true);
+  hot_keys_top_n_ = hot_keys->getInteger("top_n", 10);
+  for (const std::string& key : hot_keys->getStringArray("cached_keys", true)) {
+    cached_keys_.insert(key);
+  }
+  cache_ttl_ = std::chrono::milliseconds(hot_keys->getInteger("cache_ttl_ms", 100));
+}
+
+const uint32_t ClusterUtility::NUM_SLOTS;
+
+uint32_t ClusterUtility::hashSlot(const std::string& key) {
+  size_t start = 0;
+  size_t length = key.size();
+  const size_t open = key.find('{');
+  if (open != std::string::npos) {
+    const size_t close = key.find('}', open + 1);
+    if (close != std::string::npos && close != open + 1) {
+      start = open + 1;
+      length = close - start;
+    }
+  }
+
+  // CRC16-CCITT (XMODEM), as used by Redis Cluster.
+  uint16_t crc = 0;
+  for (size_t i = start; i < start + length; i++) {
+    crc ^= static_cast<uint16_t>(static_cast<uint8_t>(key[i])) << 8;
+    for (uint32_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+
+  return crc % NUM_SLOTS;
+}
+
+bool ClusterUtility::parseRedirection(const RespValue& value, Redirection& redirection) {
+  if (value.type() != RespType::Error) {
+    return false;
+  }
+
+  const std::vector<std::string> parts = StringUtil::split(value.asString(), ' ');
+  if (parts.size() != 3 || (parts[0] != "MOVED" && parts[0] != "ASK")) {
+    return false;
+  }
+
+  uint64_t slot;
+  if (!StringUtil::atoul(parts[1].c_str(), slot) || slot >= NUM_SLOTS) {
+    return false;
+  }
+
+  redirection.ask_ = parts[0] == "ASK";
+  redirection.slot_ = slot;
+  redirection.address_ = parts[2];
+  return true;
+}
 
 ClientPtr ClientImpl::create(Upstream::HostConstSharedPtr host, Event::Dispatcher& dispatcher,
                              EncoderPtr&& encoder, DecoderFactory& decoder_factory,
@@ -36,6 +99,9 @@ ClientImpl::ClientImpl(Upstream::HostConstSharedPtr host, Event::Dispatcher& dis
                        EncoderPtr&& encoder, DecoderFactory& decoder_factory, const Config& config)
     : host_(host), encoder_(std::move(encoder)), decoder_(decoder_factory.create(*this)),
       config_(config),
+      flush_timer_(config.batchWrites()
+                       ? dispatcher.createTimer([this]() -> void { flushBuffer(); })
+                       : nullptr),
       connect_or_op_timer_(dispatcher.createTimer([this]() -> void { onConnectOrOpTimeout(); })) {
   host->cluster().stats().upstream_cx_total_.inc();
   host->cluster().stats().upstream_cx_active_.inc();
@@ -57,8 +123,17 @@ PoolRequest* ClientImpl::makeRequest(const RespValue& request, PoolCallbacks& ca
   ASSERT(connection_->state() == Network::Connection::State::Open);
 
   pending_requests_.emplace_back(*this, callbacks);
-  encoder_->encode(request, encoder_buffer_);
-  connection_->write(encoder_buffer_);
+  if (flush_timer_) {
+    // The first command of the batch schedules the write of all the commands encoded before the
+    // dispatcher gets back to its timers.
+    if (encoder_buffer_.length() == 0) {
+      flush_timer_->enableTimer(std::chrono::milliseconds(0));
+    }
+    encoder_->encode(request, encoder_buffer_);
+  } else {
+    encoder_->encode(request, encoder_buffer_);
+    connection_->write(encoder_buffer_);
+  }
 
   // Only boost the op timeout if:
   // - We are not already connected. Otherwise, we are governed by the connect timeout and the timer
@@ -84,6 +159,13 @@ void ClientImpl::onConnectOrOpTimeout() {
   connection_->close(Network::ConnectionCloseType::NoFlush);
 }
 
+void ClientImpl::flushBuffer() {
+  if (encoder_buffer_.length() > 0 &&
+      connection_->state() == Network::Connection::State::Open) {
+    connection_->write(encoder_buffer_);
+  }
+}
+
 void ClientImpl::onData(Buffer::Instance& data) {
   try {
     decoder_->decode(data);
@@ -119,6 +201,10 @@ void ClientImpl::onEvent(Network::ConnectionEvent event) {
     }
 
     connect_or_op_timer_->disableTimer();
+    if (flush_timer_) {
+      flush_timer_->disableTimer();
+      encoder_buffer_.drain(encoder_buffer_.length());
+    }
   } else if (event == Network::ConnectionEvent::Connected) {
     connected_ = true;
     ASSERT(!pending_requests_.empty());
@@ -180,10 +266,16 @@ ClientPtr ClientFactoryImpl::create(Upstream::HostConstSharedPtr host,
                             config);
 }
 
+const uint32_t InstanceImpl::MAX_REDIRECTIONS;
+const std::chrono::milliseconds InstanceImpl::HOT_KEY_INTERVAL{1000};
+
 InstanceImpl::InstanceImpl(const std::string& cluster_name, Upstream::ClusterManager& cm,
                            ClientFactory& client_factory, ThreadLocal::SlotAllocator& tls,
                            const Json::Object& config)
-    : cm_(cm), client_factory_(client_factory), tls_(tls.allocateSlot()), config_(config) {
+    : cm_(cm), client_factory_(client_factory), tls_(tls.allocateSlot()), config_(config),
+      hot_key_collector_(config_.hotKeysEnabled()
+                             ? std::make_shared<HotKeyCollector>(config_.hotKeysTopN())
+                             : nullptr) {
   tls_->set([this, cluster_name](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return std::make_shared<ThreadLocalPool>(*this, dispatcher, cluster_name);
@@ -197,7 +289,8 @@ PoolRequest* InstanceImpl::makeRequest(const std::string& hash_key, const RespVa
 
 InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Dispatcher& dispatcher,
                                                const std::string& cluster_name)
-    : parent_(parent), dispatcher_(dispatcher), cluster_(parent_.cm_.get(cluster_name)) {
+    : parent_(parent), dispatcher_(dispatcher), cluster_(parent_.cm_.get(cluster_name)),
+      slots_refresh_callbacks_(*this) {
 
   // TODO(mattklein123): Redis is not currently safe for use with CDS. In order to make this work
   //                     we will need to add thread local cluster removal callbacks so that we can
@@ -208,13 +301,36 @@ InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Disp
              const std::vector<Upstream::HostSharedPtr>& hosts_removed) -> void {
         onHostsRemoved(hosts_removed);
       });
+
+  if (parent_.config_.clusterMode()) {
+    slots_.resize(ClusterUtility::NUM_SLOTS);
+    updateHostsByAddress();
+  }
+
+  if (parent_.hot_key_collector_) {
+    hot_key_collector_ = parent_.hot_key_collector_;
+    hot_key_tracker_.reset(new HotKeyTracker(parent_.config_.hotKeysTopN()));
+    hot_key_timer_ = dispatcher_.createTimer([this]() -> void { onHotKeyTimer(); });
+    hot_key_timer_->enableTimer(HOT_KEY_INTERVAL);
+  }
+
+  if (!parent_.config_.cachedKeys().empty()) {
+    cached_response_timer_ = dispatcher_.createTimer([this]() -> void { deliverCachedResponses(); });
+  }
 }
 
 InstanceImpl::ThreadLocalPool::~ThreadLocalPool() {
+  if (hot_key_collector_) {
+    hot_key_collector_->remove(this);
+  }
   local_host_set_member_update_cb_handle_->remove();
   while (!client_map_.empty()) {
     client_map_.begin()->second->redis_client_->close();
   }
+  while (!cached_responses_.empty()) {
+    CachedResponsePtr response = cached_responses_.front()->removeFromList(cached_responses_);
+    response->callbacks_.onFailure();
+  }
 }
 
 void InstanceImpl::ThreadLocalPool::onHostsRemoved(
@@ -227,17 +343,375 @@ void InstanceImpl::ThreadLocalPool::onHostsRemoved(
       it->second->redis_client_->close();
     }
   }
+
+  if (parent_.config_.clusterMode()) {
+    // The slots of the removed hosts fall back to the load balancer until the next refresh.
+    for (Upstream::HostConstSharedPtr& host : slots_) {
+      if (host && std::find(hosts_removed.begin(), hosts_removed.end(), host) !=
+                      hosts_removed.end()) {
+        host = nullptr;
+      }
+    }
+    updateHostsByAddress();
+  }
+}
+
+void InstanceImpl::ThreadLocalPool::updateHostsByAddress() {
+  hosts_by_address_.clear();
+  for (const Upstream::HostSharedPtr& host : cluster_->hostSet().hosts()) {
+    hosts_by_address_[host->address()->asString()] = host;
+  }
 }
 
 PoolRequest* InstanceImpl::ThreadLocalPool::makeRequest(const std::string& hash_key,
                                                         const RespValue& request,
                                                         PoolCallbacks& callbacks) {
+  if (hot_key_tracker_) {
+    hot_key_tracker_->recordAccess(hash_key);
+  }
+
+  if (!parent_.config_.cachedKeys().empty() && parent_.config_.cachedKeys().count(hash_key) > 0) {
+    return makeCachedRequest(hash_key, request, callbacks);
+  }
+
+  if (parent_.config_.collapseReads()) {
+    return makeCollapsedRequest(hash_key, request, callbacks);
+  }
+
+  return routeRequest(hash_key, request, callbacks);
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeCachedRequest(const std::string& hash_key,
+                                                              const RespValue& request,
+                                                              PoolCallbacks& callbacks) {
+  CacheEntry& entry = cache_[hash_key];
+  const std::vector<RespValue>& values = request.asArray();
+  if (values.size() != 2 || StringUtil::caseInsensitiveCompare(values[0].asString().c_str(),
+                                                               "get") != 0) {
+    // Any other command may modify the key.
+    entry.valid_ = false;
+    entry.generation_++;
+    return routeRequest(hash_key, request, callbacks);
+  }
+
+  if (entry.valid_ && ProdMonotonicTimeSource::instance_.currentTime() < entry.expiry_time_) {
+    CachedResponsePtr response(new CachedResponse(*this, entry.value_, callbacks));
+    response->moveIntoListBack(std::move(response), cached_responses_);
+    cached_response_timer_->enableTimer(std::chrono::milliseconds(0));
+    return cached_responses_.back().get();
+  }
+
+  CacheFillRequestPtr fill_request(
+      new CacheFillRequest(*this, hash_key, entry.generation_, callbacks));
+  fill_request->handle_ = routeRequest(hash_key, request, *fill_request);
+  if (!fill_request->handle_) {
+    return nullptr;
+  }
+
+  fill_request->moveIntoList(std::move(fill_request), cache_fill_requests_);
+  return cache_fill_requests_.front().get();
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeCollapsedRequest(const std::string& hash_key,
+                                                                 const RespValue& request,
+                                                                 PoolCallbacks& callbacks) {
+  const std::vector<RespValue>& values = request.asArray();
+  std::string name(values[0].asString());
+  parent_.to_lower_table_.toLowerCase(name);
+  auto reads = collapsed_reads_.find(hash_key);
+  if (SupportedCommands::readOnlyCommands().count(name) == 0) {
+    // The reads in flight may have been answered before this command, so later reads do not
+    // join them.
+    if (reads != collapsed_reads_.end()) {
+      for (const CollapsedReadPtr& read : reads->second) {
+        read->joinable_ = false;
+      }
+    }
+    return routeRequest(hash_key, request, callbacks);
+  }
+
+  std::string command;
+  for (size_t i = 0; i < values.size(); i++) {
+    const std::string& value = i == 0 ? name : values[i].asString();
+    command.append(std::to_string(value.size()));
+    command.push_back(':');
+    command.append(value);
+  }
+
+  CollapsedRead* collapsed_read = nullptr;
+  if (reads != collapsed_reads_.end()) {
+    for (const CollapsedReadPtr& read : reads->second) {
+      if (read->joinable_ && read->command_ == command) {
+        collapsed_read = read.get();
+        break;
+      }
+    }
+  }
+
+  if (!collapsed_read) {
+    CollapsedReadPtr read(new CollapsedRead(*this, hash_key, std::move(command)));
+    read->handle_ = routeRequest(hash_key, request, *read);
+    if (!read->handle_) {
+      return nullptr;
+    }
+    collapsed_read = read.get();
+    read->moveIntoListBack(std::move(read), collapsed_reads_[hash_key]);
+  }
+
+  ReadWaiterPtr waiter(new ReadWaiter(*collapsed_read, callbacks));
+  waiter->moveIntoListBack(std::move(waiter), collapsed_read->waiters_);
+  return collapsed_read->waiters_.back().get();
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::routeRequest(const std::string& hash_key,
+                                                         const RespValue& request,
+                                                         PoolCallbacks& callbacks) {
+  if (parent_.config_.clusterMode()) {
+    return makeClusterRequest(hash_key, request, callbacks);
+  }
+
   LbContextImpl lb_context(hash_key);
   Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(&lb_context);
   if (!host) {
     return nullptr;
   }
 
+  return makeRequestToHost(host, request, callbacks);
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeClusterRequest(const std::string& hash_key,
+                                                               const RespValue& request,
+                                                               PoolCallbacks& callbacks) {
+  Upstream::HostConstSharedPtr host = slots_[ClusterUtility::hashSlot(hash_key)];
+  if (!host) {
+    refreshSlots();
+    LbContextImpl lb_context(hash_key);
+    host = cluster_->loadBalancer().chooseHost(&lb_context);
+    if (!host) {
+      return nullptr;
+    }
+  }
+
+  RedirectingRequestPtr redirecting_request(new RedirectingRequest(*this, request, callbacks));
+  redirecting_request->handle_ = makeRequestToHost(host, request, *redirecting_request);
+  if (!redirecting_request->handle_) {
+    return nullptr;
+  }
+
+  redirecting_request->moveIntoList(std::move(redirecting_request), redirecting_requests_);
+  return redirecting_requests_.front().get();
+}
+
+void InstanceImpl::ThreadLocalPool::refreshSlots() {
+  if (slots_refresh_pending_) {
+    return;
+  }
+
+  Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(nullptr);
+  if (!host) {
+    return;
+  }
+
+  ENVOY_LOG(debug, "redis: refreshing the cluster slots from {}", host->address()->asString());
+  std::vector<RespValue> values(2);
+  values[0].type(RespType::BulkString);
+  values[0].asString() = "CLUSTER";
+  values[1].type(RespType::BulkString);
+  values[1].asString() = "SLOTS";
+  RespValue request;
+  request.type(RespType::Array);
+  request.asArray().swap(values);
+  slots_refresh_pending_ =
+      makeRequestToHost(host, request, slots_refresh_callbacks_) != nullptr;
+}
+
+void InstanceImpl::ThreadLocalPool::onSlots(const RespValue& value) {
+  // Each entry is [start slot, end slot, [master ip, master port, ...], replicas...].
+  if (value.type() != RespType::Array) {
+    ENVOY_LOG(debug, "redis: invalid cluster slots response: {}", value.toString());
+    return;
+  }
+
+  std::vector<Upstream::HostConstSharedPtr> slots(ClusterUtility::NUM_SLOTS);
+  for (const RespValue& entry : value.asArray()) {
+    if (entry.type() != RespType::Array || entry.asArray().size() < 3 ||
+        entry.asArray()[0].type() != RespType::Integer ||
+        entry.asArray()[1].type() != RespType::Integer ||
+        entry.asArray()[2].type() != RespType::Array ||
+        entry.asArray()[2].asArray().size() < 2 ||
+        entry.asArray()[2].asArray()[0].type() != RespType::BulkString ||
+        entry.asArray()[2].asArray()[1].type() != RespType::Integer) {
+      ENVOY_LOG(debug, "redis: invalid cluster slots entry: {}", entry.toString());
+      continue;
+    }
+
+    const std::string& ip = entry.asArray()[2].asArray()[0].asString();
+    const std::string address =
+        fmt::format(ip.find(':') == std::string::npos ? "{}:{}" : "[{}]:{}", ip,
+                    entry.asArray()[2].asArray()[1].asInteger());
+    auto host = hosts_by_address_.find(address);
+    if (host == hosts_by_address_.end()) {
+      ENVOY_LOG(debug, "redis: cluster slots master {} is not a host of the cluster", address);
+      continue;
+    }
+
+    const int64_t start = std::max<int64_t>(entry.asArray()[0].asInteger(), 0);
+    const int64_t end =
+        std::min<int64_t>(entry.asArray()[1].asInteger(), ClusterUtility::NUM_SLOTS - 1);
+    for (int64_t slot = start; slot <= end; slot++) {
+      slots[slot] = host->second;
+    }
+  }
+
+  slots_.swap(slots);
+}
+
+void InstanceImpl::SlotsRefreshCallbacks::onResponse(RespValuePtr&& value) {
+  parent_.slots_refresh_pending_ = false;
+  parent_.onSlots(*value);
+}
+
+void InstanceImpl::SlotsRefreshCallbacks::onFailure() { parent_.slots_refresh_pending_ = false; }
+
+void InstanceImpl::RedirectingRequest::cancel() {
+  handle_->cancel();
+  handle_ = nullptr;
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.redirecting_requests_));
+}
+
+void InstanceImpl::RedirectingRequest::onResponse(RespValuePtr&& value) {
+  handle_ = nullptr;
+
+  ClusterUtility::Redirection redirection;
+  if (redirections_ < MAX_REDIRECTIONS &&
+      ClusterUtility::parseRedirection(*value, redirection)) {
+    auto host = parent_.hosts_by_address_.find(redirection.address_);
+    if (host != parent_.hosts_by_address_.end()) {
+      redirections_++;
+      if (redirection.ask_) {
+        // The slot is being migrated, only this command goes to the importing host.
+        std::vector<RespValue> values(1);
+        values[0].type(RespType::BulkString);
+        values[0].asString() = "ASKING";
+        RespValue asking;
+        asking.type(RespType::Array);
+        asking.asArray().swap(values);
+        parent_.makeRequestToHost(host->second, asking, parent_.discard_callbacks_);
+      } else {
+        parent_.slots_[redirection.slot_] = host->second;
+        parent_.refreshSlots();
+      }
+
+      handle_ = parent_.makeRequestToHost(host->second, request_, *this);
+      if (handle_) {
+        return;
+      }
+    }
+  }
+
+  callbacks_.onResponse(std::move(value));
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.redirecting_requests_));
+}
+
+void InstanceImpl::RedirectingRequest::onFailure() {
+  handle_ = nullptr;
+  callbacks_.onFailure();
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.redirecting_requests_));
+}
+
+void InstanceImpl::ThreadLocalPool::onHotKeyTimer() {
+  hot_key_collector_->publish(this, hot_key_tracker_->topKeys());
+  hot_key_tracker_->decay();
+  hot_key_timer_->enableTimer(HOT_KEY_INTERVAL);
+}
+
+void InstanceImpl::ThreadLocalPool::deliverCachedResponses() {
+  // Responses which are cached while delivering are delivered by the next run of the timer.
+  std::list<CachedResponsePtr>::size_type ready = cached_responses_.size();
+  while (ready-- > 0 && !cached_responses_.empty()) {
+    CachedResponsePtr response = cached_responses_.front()->removeFromList(cached_responses_);
+    response->callbacks_.onResponse(std::move(response->value_));
+  }
+}
+
+void InstanceImpl::CacheFillRequest::cancel() {
+  handle_->cancel();
+  handle_ = nullptr;
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cache_fill_requests_));
+}
+
+void InstanceImpl::CacheFillRequest::onResponse(RespValuePtr&& value) {
+  handle_ = nullptr;
+
+  // Errors, such as a key of the wrong type, are not cached.
+  auto entry = parent_.cache_.find(key_);
+  if (entry != parent_.cache_.end() && entry->second.generation_ == generation_ &&
+      (value->type() == RespType::BulkString || value->type() == RespType::Null)) {
+    entry->second.value_ = *value;
+    entry->second.expiry_time_ =
+        ProdMonotonicTimeSource::instance_.currentTime() + parent_.parent_.config_.cacheTtl();
+    entry->second.valid_ = true;
+  }
+
+  callbacks_.onResponse(std::move(value));
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cache_fill_requests_));
+}
+
+void InstanceImpl::CacheFillRequest::onFailure() {
+  handle_ = nullptr;
+  callbacks_.onFailure();
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cache_fill_requests_));
+}
+
+void InstanceImpl::ReadWaiter::cancel() {
+  CollapsedRead& read = parent_;
+  removeFromList(read.waiters_);
+  if (read.waiters_.empty() && read.handle_) {
+    read.handle_->cancel();
+    read.handle_ = nullptr;
+    read.removeFromParent();
+  }
+}
+
+void InstanceImpl::CollapsedRead::onResponse(RespValuePtr&& value) {
+  handle_ = nullptr;
+  removeFromParent();
+
+  // A waiter may cancel the others, e.g. by closing their downstream connection, so each is
+  // removed before it is called. The last one gets the response itself.
+  while (!waiters_.empty()) {
+    ReadWaiterPtr waiter = waiters_.front()->removeFromList(waiters_);
+    if (waiters_.empty()) {
+      waiter->callbacks_.onResponse(std::move(value));
+    } else {
+      waiter->callbacks_.onResponse(RespValuePtr{new RespValue(*value)});
+    }
+  }
+}
+
+void InstanceImpl::CollapsedRead::onFailure() {
+  handle_ = nullptr;
+  removeFromParent();
+
+  while (!waiters_.empty()) {
+    ReadWaiterPtr waiter = waiters_.front()->removeFromList(waiters_);
+    waiter->callbacks_.onFailure();
+  }
+}
+
+void InstanceImpl::CollapsedRead::removeFromParent() {
+  auto reads = parent_.collapsed_reads_.find(hash_key_);
+  ASSERT(reads != parent_.collapsed_reads_.end());
+  parent_.dispatcher_.deferredDelete(removeFromList(reads->second));
+  if (reads->second.empty()) {
+    parent_.collapsed_reads_.erase(reads);
+  }
+}
+
+PoolRequest*
+InstanceImpl::ThreadLocalPool::makeRequestToHost(const Upstream::HostConstSharedPtr& host,
+                                                 const RespValue& request,
+                                                 PoolCallbacks& callbacks) {
   ThreadLocalActiveClientPtr& client = client_map_[host];
   if (!client) {
     client.reset(new ThreadLocalActiveClient(*this));
@@ -6,16 +6,22 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/redis/conn_pool.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
+#include "common/common/to_lower_table.h"
 #include "common/json/json_validator.h"
 #include "common/network/filter_impl.h"
 #include "common/redis/codec_impl.h"
+#include "common/redis/hot_key_impl.h"
 
 namespace Envoy {
 namespace Redis {
@@ -28,9 +34,75 @@ public:
   ConfigImpl(const Json::Object& config);
 
   std::chrono::milliseconds opTimeout() const override { return op_timeout_; }
+  bool batchWrites() const override { return batch_writes_; }
+
+  /**
+   * @return bool whether the backends form a Redis Cluster, whose slot map is used to route the
+   *         commands.
+   */
+  bool clusterMode() const { return cluster_mode_; }
+
+  /**
+   * @return bool whether a read only command is collapsed with an identical command the worker
+   *         has in flight, and answered with a copy of its response.
+   */
+  bool collapseReads() const { return collapse_reads_; }
+
+  /**
+   * @return bool whether the most frequent keys are tracked.
+   */
+  bool hotKeysEnabled() const { return hot_keys_enabled_; }
+
+  /**
+   * @return uint32_t the number of most frequent keys which are reported.
+   */
+  uint32_t hotKeysTopN() const { return hot_keys_top_n_; }
+
+  /**
+   * @return const std::unordered_set<std::string>& the keys whose GETs are served from a cache.
+   */
+  const std::unordered_set<std::string>& cachedKeys() const { return cached_keys_; }
+
+  /**
+   * @return std::chrono::milliseconds how long a cached value is served.
+   */
+  std::chrono::milliseconds cacheTtl() const { return cache_ttl_; }
 
 private:
   const std::chrono::milliseconds op_timeout_;
+  const bool batch_writes_;
+  const bool cluster_mode_;
+  const bool collapse_reads_;
+  const bool hot_keys_enabled_;
+  uint32_t hot_keys_top_n_;
+  std::unordered_set<std::string> cached_keys_;
+  std::chrono::milliseconds cache_ttl_;
+};
+
+/**
+ * Helpers for Redis Cluster, see https://redis.io/topics/cluster-spec
+ */
+class ClusterUtility {
+public:
+  static const uint32_t NUM_SLOTS = 16384;
+
+  /**
+   * @return uint32_t the slot of a key: the CRC16 of its hash tag, the part between the first '{'
+   *         and the following '}' if it is not empty, or of the whole key.
+   */
+  static uint32_t hashSlot(const std::string& key);
+
+  struct Redirection {
+    bool ask_;
+    uint32_t slot_;
+    std::string address_;
+  };
+
+  /**
+   * Parse a "MOVED <slot> <ip>:<port>" or "ASK <slot> <ip>:<port>" error.
+   * @return bool whether the value is a redirection.
+   */
+  static bool parseRedirection(const RespValue& value, Redirection& redirection);
 };
 
 class ClientImpl : public Client, public DecoderCallbacks, public Network::ConnectionCallbacks {
@@ -77,6 +149,7 @@ private:
              DecoderFactory& decoder_factory, const Config& config);
   void onConnectOrOpTimeout();
   void onData(Buffer::Instance& data);
+  void flushBuffer();
 
   // Redis::DecoderCallbacks
   void onRespValue(RespValuePtr&& value) override;
@@ -93,6 +166,8 @@ private:
   DecoderPtr decoder_;
   const Config& config_;
   std::list<PendingRequest> pending_requests_;
+  // Only created when writes are batched. Must be created before connect_or_op_timer_.
+  Event::TimerPtr flush_timer_;
   Event::TimerPtr connect_or_op_timer_;
   bool connected_{};
 };
@@ -109,6 +184,22 @@ private:
   DecoderFactoryImpl decoder_factory_;
 };
 
+/**
+ * Connection pool which maintains a connection to each host of a cluster, per worker. The host of
+ * a command is chosen by the load balancer from the hash of its key. In cluster mode, the host is
+ * the master of the slot of the key instead, from a slot map which each worker fetches with
+ * CLUSTER SLOTS and updates from the MOVED redirections. The MOVED and ASK redirections are
+ * followed up to MAX_REDIRECTIONS times, to the hosts of the cluster only.
+ *
+ * Optionally, each worker tracks its most frequent keys, which it publishes to the collector of
+ * the pool every HOT_KEY_INTERVAL, and serves the GETs of the configured keys from a cache. A
+ * cached value is served for the configured TTL, or until another command with the same key is
+ * sent by the same worker. The writes sent by the other workers, or by other clients of Redis,
+ * are only seen once the value expires.
+ *
+ * Optionally, a read only command which is identical to a command the worker has in flight is
+ * not sent, and is answered with a copy of the response of the command in flight.
+ */
 class InstanceImpl : public Instance {
 public:
   InstanceImpl(const std::string& cluster_name, Upstream::ClusterManager& cm,
@@ -119,9 +210,162 @@ public:
   PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                            PoolCallbacks& callbacks) override;
 
+  /**
+   * @return HotKeyCollectorSharedPtr the collector of the most frequent keys of the workers, or
+   *         nullptr if they are not tracked.
+   */
+  HotKeyCollectorSharedPtr hotKeyCollector() { return hot_key_collector_; }
+
+  static const uint32_t MAX_REDIRECTIONS = 3;
+  static const std::chrono::milliseconds HOT_KEY_INTERVAL;
+
 private:
   struct ThreadLocalPool;
 
+  /**
+   * A request made in cluster mode, which keeps a copy of the command to follow redirections.
+   */
+  struct RedirectingRequest : public PoolRequest,
+                              public PoolCallbacks,
+                              public Event::DeferredDeletable,
+                              LinkedObject<RedirectingRequest> {
+    RedirectingRequest(ThreadLocalPool& parent, const RespValue& request,
+                       PoolCallbacks& callbacks)
+        : parent_(parent), request_(request), callbacks_(callbacks) {}
+
+    // Redis::ConnPool::PoolRequest
+    void cancel() override;
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
+
+    ThreadLocalPool& parent_;
+    const RespValue request_;
+    PoolCallbacks& callbacks_;
+    PoolRequest* handle_{};
+    uint32_t redirections_{};
+  };
+
+  typedef std::unique_ptr<RedirectingRequest> RedirectingRequestPtr;
+
+  struct SlotsRefreshCallbacks : public PoolCallbacks {
+    SlotsRefreshCallbacks(ThreadLocalPool& parent) : parent_(parent) {}
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
+
+    ThreadLocalPool& parent_;
+  };
+
+  /**
+   * A GET of a cached key which missed the cache, which fills the cache with the response.
+   */
+  struct CacheFillRequest : public PoolRequest,
+                            public PoolCallbacks,
+                            public Event::DeferredDeletable,
+                            LinkedObject<CacheFillRequest> {
+    CacheFillRequest(ThreadLocalPool& parent, const std::string& key, uint64_t generation,
+                     PoolCallbacks& callbacks)
+        : parent_(parent), key_(key), generation_(generation), callbacks_(callbacks) {}
+
+    // Redis::ConnPool::PoolRequest
+    void cancel() override;
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
+
+    ThreadLocalPool& parent_;
+    const std::string key_;
+    // The generation of the cache entry when the GET was sent.
+    const uint64_t generation_;
+    PoolCallbacks& callbacks_;
+    PoolRequest* handle_{};
+  };
+
+  typedef std::unique_ptr<CacheFillRequest> CacheFillRequestPtr;
+
+  /**
+   * A GET served from the cache, whose response is delivered by the dispatcher.
+   */
+  struct CachedResponse : public PoolRequest, LinkedObject<CachedResponse> {
+    CachedResponse(ThreadLocalPool& parent, const RespValue& value, PoolCallbacks& callbacks)
+        : parent_(parent), value_(new RespValue(value)), callbacks_(callbacks) {}
+
+    // Redis::ConnPool::PoolRequest
+    void cancel() override { removeFromList(parent_.cached_responses_); }
+
+    ThreadLocalPool& parent_;
+    RespValuePtr value_;
+    PoolCallbacks& callbacks_;
+  };
+
+  typedef std::unique_ptr<CachedResponse> CachedResponsePtr;
+
+  struct CacheEntry {
+    RespValue value_;
+    MonotonicTime expiry_time_;
+    bool valid_{};
+    // Incremented whenever the entry is invalidated, so that the responses of the GETs sent
+    // before do not fill it.
+    uint64_t generation_{};
+  };
+
+  struct CollapsedRead;
+
+  /**
+   * A read only command waiting for the response of an identical command in flight, itself
+   * included.
+   */
+  struct ReadWaiter : public PoolRequest, LinkedObject<ReadWaiter> {
+    ReadWaiter(CollapsedRead& parent, PoolCallbacks& callbacks)
+        : parent_(parent), callbacks_(callbacks) {}
+
+    // Redis::ConnPool::PoolRequest
+    void cancel() override;
+
+    CollapsedRead& parent_;
+    PoolCallbacks& callbacks_;
+  };
+
+  typedef std::unique_ptr<ReadWaiter> ReadWaiterPtr;
+
+  /**
+   * A read only command in flight, whose response is fanned out to all the commands waiting for
+   * it. It is canceled once none is left.
+   */
+  struct CollapsedRead : public PoolCallbacks,
+                         public Event::DeferredDeletable,
+                         LinkedObject<CollapsedRead> {
+    CollapsedRead(ThreadLocalPool& parent, const std::string& hash_key, std::string&& command)
+        : parent_(parent), hash_key_(hash_key), command_(std::move(command)) {}
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
+
+    void removeFromParent();
+
+    ThreadLocalPool& parent_;
+    const std::string hash_key_;
+    // The command and its arguments, each prefixed by its length.
+    const std::string command_;
+    PoolRequest* handle_{};
+    std::list<ReadWaiterPtr> waiters_;
+    // Cleared once another command is sent with the same key, as the response may not reflect it.
+    bool joinable_{true};
+  };
+
+  typedef std::unique_ptr<CollapsedRead> CollapsedReadPtr;
+
+  struct DiscardCallbacks : public PoolCallbacks {
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&&) override {}
+    void onFailure() override {}
+  };
+
   struct ThreadLocalActiveClient : public Network::ConnectionCallbacks {
     ThreadLocalActiveClient(ThreadLocalPool& parent) : parent_(parent) {}
 
@@ -137,19 +381,53 @@ private:
 
   typedef std::unique_ptr<ThreadLocalActiveClient> ThreadLocalActiveClientPtr;
 
-  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject {
+  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject,
+                           Logger::Loggable<Logger::Id::redis> {
     ThreadLocalPool(InstanceImpl& parent, Event::Dispatcher& dispatcher,
                     const std::string& cluster_name);
     ~ThreadLocalPool();
     PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                              PoolCallbacks& callbacks);
+    PoolRequest* makeRequestToHost(const Upstream::HostConstSharedPtr& host,
+                                   const RespValue& request, PoolCallbacks& callbacks);
+    PoolRequest* makeClusterRequest(const std::string& hash_key, const RespValue& request,
+                                    PoolCallbacks& callbacks);
     void onHostsRemoved(const std::vector<Upstream::HostSharedPtr>& hosts_removed);
+    void updateHostsByAddress();
+    PoolRequest* makeCachedRequest(const std::string& hash_key, const RespValue& request,
+                                   PoolCallbacks& callbacks);
+    PoolRequest* makeCollapsedRequest(const std::string& hash_key, const RespValue& request,
+                                      PoolCallbacks& callbacks);
+    PoolRequest* routeRequest(const std::string& hash_key, const RespValue& request,
+                              PoolCallbacks& callbacks);
+    void refreshSlots();
+    void onSlots(const RespValue& value);
+    void onHotKeyTimer();
+    void deliverCachedResponses();
 
     InstanceImpl& parent_;
     Event::Dispatcher& dispatcher_;
     Upstream::ThreadLocalCluster* cluster_;
     std::unordered_map<Upstream::HostConstSharedPtr, ThreadLocalActiveClientPtr> client_map_;
     Common::CallbackHandle* local_host_set_member_update_cb_handle_;
+    // The following are only used in cluster mode. An empty slot falls back to the load balancer.
+    std::vector<Upstream::HostConstSharedPtr> slots_;
+    std::unordered_map<std::string, Upstream::HostConstSharedPtr> hosts_by_address_;
+    std::list<RedirectingRequestPtr> redirecting_requests_;
+    SlotsRefreshCallbacks slots_refresh_callbacks_;
+    bool slots_refresh_pending_{};
+    DiscardCallbacks discard_callbacks_;
+    // The following are only used when the hot keys are tracked or cached.
+    // The pool may be destroyed on the worker after its parent, so it keeps the collector alive.
+    HotKeyCollectorSharedPtr hot_key_collector_;
+    std::unique_ptr<HotKeyTracker> hot_key_tracker_;
+    Event::TimerPtr hot_key_timer_;
+    std::unordered_map<std::string, CacheEntry> cache_;
+    std::list<CacheFillRequestPtr> cache_fill_requests_;
+    std::list<CachedResponsePtr> cached_responses_;
+    Event::TimerPtr cached_response_timer_;
+    // The read only commands in flight when reads are collapsed, by key.
+    std::unordered_map<std::string, std::list<CollapsedReadPtr>> collapsed_reads_;
   };
 
   struct LbContextImpl : public Upstream::LoadBalancerContext {
@@ -167,6 +445,8 @@ private:
   ClientFactory& client_factory_;
   ThreadLocal::SlotPtr tls_;
   ConfigImpl config_;
+  HotKeyCollectorSharedPtr hot_key_collector_;
+  const ToLowerTable to_lower_table_;
 };
 
 } // namespace ConnPool
@@ -0,0 +1,220 @@
+#include "common/redis/hot_key_impl.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/common/hash.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Redis {
+
+namespace {
+
+uint32_t roundUpToPowerOfTwo(uint32_t value) {
+  uint32_t power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+
+void sortByCount(std::vector<HotKey>& keys) {
+  std::sort(keys.begin(), keys.end(), [](const HotKey& lhs, const HotKey& rhs) -> bool {
+    return lhs.count_ > rhs.count_ || (lhs.count_ == rhs.count_ && lhs.key_ < rhs.key_);
+  });
+}
+
+} // namespace
+
+const uint32_t CountMinSketch::DEPTH;
+
+CountMinSketch::CountMinSketch(uint32_t width)
+    : mask_(roundUpToPowerOfTwo(width) - 1), counters_(DEPTH * (mask_ + 1)) {}
+
+void CountMinSketch::indexes(const std::string& key, uint32_t (&indexes)[DEPTH]) const {
+  // The rows are indexed by combinations of the two halves of a single hash.
+  const uint64_t hash = HashUtil::xxHash64(key);
+  const uint32_t low = hash;
+  const uint32_t high = hash >> 32;
+  for (uint32_t row = 0; row < DEPTH; row++) {
+    indexes[row] = row * (mask_ + 1) + ((low + row * high) & mask_);
+  }
+}
+
+uint32_t CountMinSketch::increment(const std::string& key) {
+  uint32_t key_indexes[DEPTH];
+  indexes(key, key_indexes);
+
+  uint32_t count = UINT32_MAX;
+  for (uint32_t index : key_indexes) {
+    count = std::min(count, counters_[index]);
+  }
+  if (count == UINT32_MAX) {
+    return count;
+  }
+
+  count++;
+  for (uint32_t index : key_indexes) {
+    counters_[index] = std::max(counters_[index], count);
+  }
+  return count;
+}
+
+uint32_t CountMinSketch::estimate(const std::string& key) const {
+  uint32_t key_indexes[DEPTH];
+  indexes(key, key_indexes);
+
+  uint32_t count = UINT32_MAX;
+  for (uint32_t index : key_indexes) {
+    count = std::min(count, counters_[index]);
+  }
+  return count;
+}
+
+void CountMinSketch::decay() {
+  for (uint32_t& counter : counters_) {
+    counter >>= 1;
+  }
+}
+
+const uint32_t HotKeyTracker::SKETCH_WIDTH;
+
+HotKeyTracker::HotKeyTracker(uint32_t top_n) : top_n_(top_n), sketch_(SKETCH_WIDTH) {}
+
+void HotKeyTracker::recordAccess(const std::string& key) {
+  const uint32_t count = sketch_.increment(key);
+
+  auto top_key = top_keys_.find(key);
+  if (top_key != top_keys_.end()) {
+    top_key->second = count;
+    return;
+  }
+
+  if (top_keys_.size() < top_n_) {
+    top_keys_.emplace(key, count);
+    min_count_ = std::min(min_count_, count);
+    return;
+  }
+
+  if (count <= min_count_) {
+    return;
+  }
+
+  // The estimates of the top keys only grow between two decays, so the bound may be stale.
+  auto min_key = std::min_element(
+      top_keys_.begin(), top_keys_.end(),
+      [](const std::pair<const std::string, uint32_t>& lhs,
+         const std::pair<const std::string, uint32_t>& rhs) -> bool {
+        return lhs.second < rhs.second;
+      });
+  if (count <= min_key->second) {
+    min_count_ = min_key->second;
+    return;
+  }
+
+  top_keys_.erase(min_key);
+  top_keys_.emplace(key, count);
+  min_count_ = count;
+  for (const auto& top_key : top_keys_) {
+    min_count_ = std::min(min_count_, top_key.second);
+  }
+}
+
+void HotKeyTracker::decay() {
+  sketch_.decay();
+  min_count_ = 0;
+  for (auto it = top_keys_.begin(); it != top_keys_.end();) {
+    it->second >>= 1;
+    if (it->second == 0) {
+      it = top_keys_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::vector<HotKey> HotKeyTracker::topKeys() const {
+  std::vector<HotKey> keys;
+  keys.reserve(top_keys_.size());
+  for (const auto& top_key : top_keys_) {
+    keys.push_back({top_key.first, top_key.second});
+  }
+  sortByCount(keys);
+  return keys;
+}
+
+void HotKeyCollector::publish(const void* source, std::vector<HotKey>&& keys) {
+  std::unique_lock<std::mutex> lock(lock_);
+  keys_by_source_[source] = std::move(keys);
+}
+
+void HotKeyCollector::remove(const void* source) {
+  std::unique_lock<std::mutex> lock(lock_);
+  keys_by_source_.erase(source);
+}
+
+std::vector<HotKey> HotKeyCollector::topKeys() const {
+  std::unordered_map<std::string, uint64_t> counts;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (const auto& source : keys_by_source_) {
+      for (const HotKey& key : source.second) {
+        counts[key.key_] += key.count_;
+      }
+    }
+  }
+
+  std::vector<HotKey> keys;
+  keys.reserve(counts.size());
+  for (const auto& count : counts) {
+    keys.push_back({count.first, count.second});
+  }
+  sortByCount(keys);
+  if (keys.size() > top_n_) {
+    keys.resize(top_n_);
+  }
+  return keys;
+}
+
+HotKeyAdmin::HotKeyAdmin(Server::Admin& admin) : admin_(admin) {
+  admin_.addHandler("/redis/hot_keys", "print out the most frequent keys of the redis proxies",
+                    MAKE_ADMIN_HANDLER(handlerHotKeys), true);
+}
+
+HotKeyAdmin::~HotKeyAdmin() { admin_.removeHandler("/redis/hot_keys"); }
+
+void HotKeyAdmin::addCollector(const std::string& name, HotKeyCollectorSharedPtr collector) {
+  removeExpiredCollectors();
+  collectors_.emplace_back(name, collector);
+}
+
+void HotKeyAdmin::removeExpiredCollectors() {
+  collectors_.remove_if(
+      [](const std::pair<std::string, std::weak_ptr<HotKeyCollector>>& collector) -> bool {
+        return collector.second.expired();
+      });
+}
+
+Http::Code HotKeyAdmin::handlerHotKeys(const std::string&, Buffer::Instance& response) {
+  removeExpiredCollectors();
+  for (const auto& collector : collectors_) {
+    HotKeyCollectorSharedPtr shared_collector = collector.second.lock();
+    if (!shared_collector) {
+      continue;
+    }
+
+    response.add(fmt::format("{}\n", collector.first));
+    for (const HotKey& key : shared_collector->topKeys()) {
+      response.add(fmt::format("  {}: {}\n", key.key_, key.count_));
+    }
+  }
+
+  return Http::Code::OK;
+}
+
+} // namespace Redis
+} // namespace Envoy
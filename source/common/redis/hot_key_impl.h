@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/http/codes.h"
+#include "envoy/server/admin.h"
+#include "envoy/singleton/instance.h"
+
+namespace Envoy {
+namespace Redis {
+
+/**
+ * Count-min sketch, which estimates the number of times each key was seen in a fixed amount of
+ * memory. An estimate is never lower than the actual count; it is higher when the keys which
+ * share its counters are frequent. See https://en.wikipedia.org/wiki/Count%E2%80%93min_sketch
+ */
+class CountMinSketch {
+public:
+  /**
+   * @param width supplies the number of counters of each row, rounded up to a power of two.
+   */
+  CountMinSketch(uint32_t width);
+
+  /**
+   * Count one occurrence of a key. Only the lowest counters of the key are incremented
+   * (conservative update), which reduces the overestimation.
+   * @return uint32_t the estimate of the key, including this occurrence.
+   */
+  uint32_t increment(const std::string& key);
+
+  /**
+   * @return uint32_t the estimate of a key.
+   */
+  uint32_t estimate(const std::string& key) const;
+
+  /**
+   * Halve all the counters, so that the estimates favor the recent occurrences.
+   */
+  void decay();
+
+  static const uint32_t DEPTH = 4;
+
+private:
+  void indexes(const std::string& key, uint32_t (&indexes)[DEPTH]) const;
+
+  const uint32_t mask_;
+  // DEPTH rows of mask_ + 1 counters.
+  std::vector<uint32_t> counters_;
+};
+
+struct HotKey {
+  std::string key_;
+  uint64_t count_;
+};
+
+/**
+ * Tracks the most frequent keys of a worker. The frequencies are estimated with a count-min
+ * sketch, and only the top N keys are kept with their estimates. Not thread safe.
+ */
+class HotKeyTracker {
+public:
+  HotKeyTracker(uint32_t top_n);
+
+  void recordAccess(const std::string& key);
+
+  /**
+   * Halve the estimates, so that a key which is no longer accessed leaves the top keys.
+   */
+  void decay();
+
+  /**
+   * @return std::vector<HotKey> the top keys, most frequent first.
+   */
+  std::vector<HotKey> topKeys() const;
+
+  static const uint32_t SKETCH_WIDTH = 1024;
+
+private:
+  const uint32_t top_n_;
+  CountMinSketch sketch_;
+  std::unordered_map<std::string, uint32_t> top_keys_;
+  // A lower bound of the lowest estimate of the top keys, so that the keys which are not hot do
+  // not scan the top keys.
+  uint32_t min_count_{};
+};
+
+/**
+ * Merges the top keys which the workers publish periodically. Thread safe.
+ */
+class HotKeyCollector {
+public:
+  HotKeyCollector(uint32_t top_n) : top_n_(top_n) {}
+
+  /**
+   * Replace the top keys of a worker.
+   * @param source supplies the identity of the worker, such as its tracker.
+   * @param keys supplies the top keys of the worker.
+   */
+  void publish(const void* source, std::vector<HotKey>&& keys);
+
+  /**
+   * Forget the top keys of a worker which is going away.
+   */
+  void remove(const void* source);
+
+  /**
+   * @return std::vector<HotKey> the top keys of all workers, with the estimates of the workers
+   *         summed, most frequent first.
+   */
+  std::vector<HotKey> topKeys() const;
+
+private:
+  const uint32_t top_n_;
+  mutable std::mutex lock_;
+  std::unordered_map<const void*, std::vector<HotKey>> keys_by_source_;
+};
+
+typedef std::shared_ptr<HotKeyCollector> HotKeyCollectorSharedPtr;
+
+/**
+ * Serves the hot keys of all Redis proxies on the /redis/hot_keys admin endpoint. Shared by the
+ * proxies through the singleton manager.
+ */
+class HotKeyAdmin : public Singleton::Instance {
+public:
+  HotKeyAdmin(Server::Admin& admin);
+  ~HotKeyAdmin();
+
+  /**
+   * Add the collector of a proxy, which is listed until it is destroyed.
+   * @param name supplies the name of the proxy, such as its stat prefix.
+   */
+  void addCollector(const std::string& name, HotKeyCollectorSharedPtr collector);
+
+private:
+  Http::Code handlerHotKeys(const std::string& url, Buffer::Instance& response);
+  void removeExpiredCollectors();
+
+  Server::Admin& admin_;
+  std::list<std::pair<std::string, std::weak_ptr<HotKeyCollector>>> collectors_;
+};
+
+} // namespace Redis
+} // namespace Envoy
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "common/common/macros.h"
@@ -28,6 +29,20 @@ struct SupportedCommands {
         "zrevrangebylex", "zrevrangebyscore", "zrevrank", "zscan", "zscore");
   }
 
+  /**
+   * @return simple commands which only read, and can be collapsed with identical commands in
+   *         flight
+   */
+  static const std::unordered_set<std::string>& readOnlyCommands() {
+    CONSTRUCT_ON_FIRST_USE(
+        std::unordered_set<std::string>, "bitcount", "bitpos", "dump", "geodist", "geohash",
+        "geopos", "get", "getbit", "getrange", "hexists", "hget", "hgetall", "hkeys", "hlen",
+        "hmget", "hstrlen", "hvals", "lindex", "llen", "lrange", "pttl", "scard", "sismember",
+        "smembers", "strlen", "ttl", "type", "zcard", "zcount", "zlexcount", "zrange",
+        "zrangebylex", "zrangebyscore", "zrank", "zrevrange", "zrevrangebylex", "zrevrangebyscore",
+        "zrevrank", "zscore");
+  }
+
   /**
    * @return commands which hash on the fourth argument
    */
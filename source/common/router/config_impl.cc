@@ -5,7 +5,6 @@
 #include <cstdint>
 #include <map>
 #include <memory>
-#include <regex>
 #include <string>
 #include <vector>
 
@@ -50,6 +49,11 @@ RetryPolicyImpl::RetryPolicyImpl(const envoy::api::v2::RouteAction& config) {
 CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config) {
   for (const auto& origin : config.allow_origin()) {
     allow_origin_.push_back(origin);
+    if (origin == "*") {
+      allow_any_origin_ = true;
+    } else {
+      allowed_origins_.insert(origin);
+    }
   }
   allow_methods_ = config.allow_methods();
   allow_headers_ = config.allow_headers();
@@ -80,7 +84,7 @@ public:
 
     const Http::HeaderEntry* header = headers.get(header_name_);
     if (header) {
-      hash.value(HashUtil::xxHash64(header->value().c_str()));
+      hash.value(HashUtil::xxHash64(header->value().c_str(), header->value().size()));
     }
     return hash;
   }
@@ -96,14 +100,14 @@ public:
   Optional<uint64_t> evaluate(const std::string&, const Http::HeaderMap& headers,
                               const HashPolicy::AddCookieCallback add_cookie) const override {
     Optional<uint64_t> hash;
-    std::string value = Http::Utility::parseCookieValue(headers, key_);
-
-    if (value.empty() && ttl_ != std::chrono::seconds(0)) {
-      value = add_cookie(key_, ttl_);
-      hash.value(HashUtil::xxHash64(value));
-
-    } else if (!value.empty()) {
-      hash.value(HashUtil::xxHash64(value));
+    const char* value;
+    size_t size;
+
+    // The cookie is hashed in place in the header, so that no copy of it is made.
+    if (Http::Utility::findCookieValue(headers, key_, &value, &size) && size > 0) {
+      hash.value(HashUtil::xxHash64(value, size));
+    } else if (ttl_ != std::chrono::seconds(0)) {
+      hash.value(HashUtil::xxHash64(add_cookie(key_, ttl_)));
     }
     return hash;
   }
@@ -268,11 +272,11 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
       }
 
       std::unique_ptr<WeightedClusterEntry> cluster_entry(
-          new WeightedClusterEntry(this, runtime_key_prefix + "." + cluster_name, loader_,
-                                   cluster_name, PROTOBUF_GET_WRAPPED_REQUIRED(cluster, weight),
+          new WeightedClusterEntry(this, runtime_key_prefix + "." + cluster_name, cluster_name,
+                                   PROTOBUF_GET_WRAPPED_REQUIRED(cluster, weight),
                                    std::move(cluster_metadata_match_criteria)));
       weighted_clusters_.emplace_back(std::move(cluster_entry));
-      total_weight += weighted_clusters_.back()->clusterWeight();
+      total_weight += weighted_clusters_.back()->clusterWeight(loader_.snapshot());
     }
 
     if (total_weight != WeightedClusterEntry::MAX_CLUSTER_WEIGHT) {
@@ -326,7 +330,7 @@ void RouteEntryImplBase::finalizeRequestHeaders(
   // virtual host level headers and finally global connection manager level headers.
   request_headers_parser_->evaluateRequestHeaders(headers, request_info);
   vhost_.requestHeaderParser().evaluateRequestHeaders(headers, request_info);
-  vhost_.globalRouteConfig().requestHeaderParser().evaluateRequestHeaders(headers, request_info);
+  vhost_.globalRequestHeaderParser().evaluateRequestHeaders(headers, request_info);
   if (host_rewrite_.empty()) {
     return;
   }
@@ -448,27 +452,36 @@ RouteConstSharedPtr RouteEntryImplBase::clusterEntry(const Http::HeaderMap& head
     }
   }
 
-  uint64_t selected_value = random_value % WeightedClusterEntry::MAX_CLUSTER_WEIGHT;
-  uint64_t begin = 0UL;
-  uint64_t end = 0UL;
+  // Find the right cluster to route to based on the interval in which the selected value falls,
+  // that is the first cluster whose interval ends after it. When runtime sets invalid weights
+  // which add up to more than MAX_CLUSTER_WEIGHT, the cluster whose weight caused the overflow
+  // takes the rest of the range. When they add up to less, the last cluster takes the rest.
+  const uint64_t selected_value = random_value % WeightedClusterEntry::MAX_CLUSTER_WEIGHT;
+  const std::vector<uint64_t>& ends = weightedClusterWeights()->ends_;
+  const size_t index = std::upper_bound(ends.begin(), ends.end(), selected_value) - ends.begin();
+  return weighted_clusters_[std::min(index, weighted_clusters_.size() - 1)];
+}
+
+RouteEntryImplBase::WeightedClusterWeightsConstSharedPtr
+RouteEntryImplBase::weightedClusterWeights() const {
+  const Runtime::Snapshot& snapshot = loader_.snapshot();
+  WeightedClusterWeightsConstSharedPtr weights = std::atomic_load(&weighted_cluster_weights_);
+  if (weights && weights->generation_ == snapshot.generation()) {
+    return weights;
+  }
 
-  // Find the right cluster to route to based on the interval in which
-  // the selected value falls.  The intervals are determined as
-  // [0, cluster1_weight), [cluster1_weight, cluster1_weight+cluster2_weight),..
+  std::shared_ptr<WeightedClusterWeights> new_weights = std::make_shared<WeightedClusterWeights>();
+  new_weights->generation_ = snapshot.generation();
+  new_weights->ends_.reserve(weighted_clusters_.size());
+  uint64_t end = 0;
   for (const WeightedClusterEntrySharedPtr& cluster : weighted_clusters_) {
-    end = begin + cluster->clusterWeight();
-    if (((selected_value >= begin) && (selected_value < end)) ||
-        (end >= WeightedClusterEntry::MAX_CLUSTER_WEIGHT)) {
-      // end > WeightedClusterEntry::MAX_CLUSTER_WEIGHT : This case can only occur
-      // with Runtimes, when the user specifies invalid weights such that
-      // sum(weights) > WeightedClusterEntry::MAX_CLUSTER_WEIGHT.
-      // In this case, terminate the search and just return the cluster
-      // whose weight cased the overflow
-      return cluster;
-    }
-    begin = end;
+    end += cluster->clusterWeight(snapshot);
+    new_weights->ends_.push_back(end);
   }
-  NOT_REACHED;
+
+  weights = std::move(new_weights);
+  std::atomic_store(&weighted_cluster_weights_, weights);
+  return weights;
 }
 
 void RouteEntryImplBase::validateClusters(Upstream::ClusterManager& cm) const {
@@ -560,7 +573,7 @@ RegexRouteEntryImpl::RegexRouteEntryImpl(const VirtualHostImpl& vhost,
                                          const envoy::api::v2::Route& route,
                                          Runtime::Loader& loader)
     : RouteEntryImplBase(vhost, route, loader),
-      regex_(std::regex{route.match().regex().c_str(), std::regex::optimize}) {}
+      regex_(Regex::Utility::parseRegex(route.match().regex())) {}
 
 void RegexRouteEntryImpl::finalizeRequestHeaders(
     Http::HeaderMap& headers, const Http::AccessLog::RequestInfo& request_info) const {
@@ -568,7 +581,7 @@ void RegexRouteEntryImpl::finalizeRequestHeaders(
 
   const Http::HeaderString& path = headers.Path()->value();
   const char* query_string_start = Http::Utility::findQueryStringStart(path);
-  ASSERT(std::regex_match(path.c_str(), query_string_start, regex_));
+  ASSERT(regex_->fullMatch(path.c_str(), query_string_start));
   std::string matched_path(path.c_str(), query_string_start);
   finalizePathHeader(headers, matched_path);
 }
@@ -578,7 +591,7 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
   if (RouteEntryImplBase::matchRoute(headers, random_value)) {
     const Http::HeaderString& path = headers.Path()->value();
     const char* query_string_start = Http::Utility::findQueryStringStart(path);
-    if (std::regex_match(path.c_str(), query_string_start, regex_)) {
+    if (regex_->fullMatch(path.c_str(), query_string_start)) {
       return clusterEntry(headers, random_value);
     }
   }
@@ -586,10 +599,11 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
 }
 
 VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host,
-                                 const ConfigImpl& global_route_config, Runtime::Loader& runtime,
-                                 Upstream::ClusterManager& cm, bool validate_clusters)
+                                 RequestHeaderParserConstSharedPtr global_request_headers_parser,
+                                 Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+                                 bool validate_clusters)
     : name_(virtual_host.name()), rate_limit_policy_(virtual_host.rate_limits()),
-      global_route_config_(global_route_config),
+      global_request_headers_parser_(global_request_headers_parser),
       request_headers_parser_(RequestHeaderParser::parse(virtual_host.request_headers_to_add())) {
   switch (virtual_host.require_tls()) {
   case envoy::api::v2::VirtualHost::NONE:
@@ -616,25 +630,25 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host
     const bool has_path = route.match().path_specifier_case() == envoy::api::v2::RouteMatch::kPath;
     const bool has_regex =
         route.match().path_specifier_case() == envoy::api::v2::RouteMatch::kRegex;
+    const bool case_sensitive =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.match(), case_sensitive, true);
+    const uint32_t index = routes_.size();
     if (has_prefix) {
       routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, runtime));
+      route_trie_.addPrefix(route.match().prefix(), case_sensitive, index);
     } else if (has_path) {
       routes_.emplace_back(new PathRouteEntryImpl(*this, route, runtime));
+      route_trie_.addPath(route.match().path(), case_sensitive, index);
     } else {
       ASSERT(has_regex);
       UNREFERENCED_PARAMETER(has_regex);
       routes_.emplace_back(new RegexRouteEntryImpl(*this, route, runtime));
+      route_trie_.addCatchAll(index);
     }
+  }
 
-    if (validate_clusters) {
-      routes_.back()->validateClusters(cm);
-      if (!routes_.back()->shadowPolicy().cluster().empty()) {
-        if (!cm.get(routes_.back()->shadowPolicy().cluster())) {
-          throw EnvoyException(fmt::format("route: unknown shadow cluster '{}'",
-                                           routes_.back()->shadowPolicy().cluster()));
-        }
-      }
-    }
+  if (validate_clusters) {
+    validateClusters(cm);
   }
 
   for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
@@ -646,43 +660,99 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host
   }
 }
 
+void VirtualHostImpl::validateClusters(Upstream::ClusterManager& cm) const {
+  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
+    route->validateClusters(cm);
+    if (!route->shadowPolicy().cluster().empty()) {
+      if (!cm.get(route->shadowPolicy().cluster())) {
+        throw EnvoyException(
+            fmt::format("route: unknown shadow cluster '{}'", route->shadowPolicy().cluster()));
+      }
+    }
+  }
+}
+
 VirtualHostImpl::VirtualClusterEntry::VirtualClusterEntry(
     const envoy::api::v2::VirtualCluster& virtual_cluster) {
   if (virtual_cluster.method() != envoy::api::v2::RequestMethod::METHOD_UNSPECIFIED) {
     method_ = envoy::api::v2::RequestMethod_Name(virtual_cluster.method());
   }
 
-  const std::string pattern = virtual_cluster.pattern();
-  pattern_ = std::regex{pattern, std::regex::optimize};
+  pattern_ = Regex::Utility::parseRegex(virtual_cluster.pattern());
   name_ = virtual_cluster.name();
 }
 
-const VirtualHostImpl* RouteMatcher::findWildcardVirtualHost(const std::string& host) const {
+void RouteMatcher::WildcardSuffixTrie::add(const std::string& suffix,
+                                          VirtualHostSharedPtr virtual_host) {
+  Node* node = &root_;
+  for (auto it = suffix.rbegin(); it != suffix.rend(); it++) {
+    const char c = *it;
+    auto child = std::lower_bound(node->children_.begin(), node->children_.end(), c,
+                                  [](const std::pair<char, std::unique_ptr<Node>>& entry,
+                                     char value) -> bool { return entry.first < value; });
+    if (child == node->children_.end() || child->first != c) {
+      child = node->children_.emplace(child, c, std::unique_ptr<Node>(new Node()));
+    }
+    node = child->second.get();
+  }
+
+  if (!node->virtual_host_) {
+    node->virtual_host_ = virtual_host;
+  }
+}
+
+const RouteMatcher::WildcardSuffixTrie::Node*
+RouteMatcher::WildcardSuffixTrie::Node::child(char c) const {
+  auto child = std::lower_bound(children_.begin(), children_.end(), c,
+                                [](const std::pair<char, std::unique_ptr<Node>>& entry,
+                                   char value) -> bool { return entry.first < value; });
+  return child != children_.end() && child->first == c ? child->second.get() : nullptr;
+}
+
+const VirtualHostImpl* RouteMatcher::WildcardSuffixTrie::find(const char* host,
+                                                              size_t length) const {
   // We do a longest wildcard suffix match against the host that's passed in.
   // (e.g. foo-bar.baz.com should match *-bar.baz.com before matching *.baz.com)
-  // This is done by scanning the length => wildcards map looking for every
-  // wildcard whose size is < length.
-  for (const auto& iter : wildcard_virtual_host_suffixes_) {
-    const uint32_t wildcard_length = iter.first;
-    const auto& wildcard_map = iter.second;
-    // >= because *.foo.com shouldn't match .foo.com.
-    if (wildcard_length >= host.size()) {
-      continue;
+  // Suffixes must be shorter than the host because *.foo.com shouldn't match .foo.com.
+  const VirtualHostImpl* match = nullptr;
+  const Node* node = &root_;
+  for (size_t matched = 0; matched < length; matched++) {
+    if (node->virtual_host_) {
+      match = node->virtual_host_.get();
     }
-    const auto& match = wildcard_map.find(host.substr(host.size() - wildcard_length));
-    if (match != wildcard_map.end()) {
-      return match->second.get();
+    node = node->child(host[length - matched - 1]);
+    if (node == nullptr) {
+      break;
     }
   }
-  return nullptr;
+  return match;
 }
 
 RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_config,
-                           const ConfigImpl& global_route_config, Runtime::Loader& runtime,
-                           Upstream::ClusterManager& cm, bool validate_clusters) {
+                           RequestHeaderParserConstSharedPtr global_request_headers_parser,
+                           Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+                           bool validate_clusters, const RouteMatcher* previous_route_matcher) {
   for (const auto& virtual_host_config : route_config.virtual_hosts()) {
-    VirtualHostSharedPtr virtual_host(new VirtualHostImpl(virtual_host_config, global_route_config,
-                                                          runtime, cm, validate_clusters));
+    const uint64_t hash = MessageUtil::hash(virtual_host_config);
+    VirtualHostSharedPtr virtual_host;
+    if (previous_route_matcher != nullptr) {
+      auto previous = previous_route_matcher->virtual_hosts_by_hash_.find(hash);
+      if (previous != previous_route_matcher->virtual_hosts_by_hash_.end()) {
+        // The virtual host is immutable once built, so it can be shared with the previous
+        // configuration, which workers may still be using. Clusters may have gone away since it
+        // was built, so validate them again.
+        virtual_host = previous->second;
+        if (validate_clusters) {
+          virtual_host->validateClusters(cm);
+        }
+      }
+    }
+    if (!virtual_host) {
+      virtual_host.reset(new VirtualHostImpl(virtual_host_config, global_request_headers_parser,
+                                             runtime, cm, validate_clusters));
+    }
+    virtual_hosts_by_hash_.emplace(hash, virtual_host);
+
     for (const std::string& domain : virtual_host_config.domains()) {
       if ("*" == domain) {
         if (default_virtual_host_) {
@@ -690,7 +760,7 @@ RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_confi
         }
         default_virtual_host_ = virtual_host;
       } else if (domain.size() > 0 && '*' == domain[0]) {
-        wildcard_virtual_host_suffixes_[domain.size() - 1].emplace(domain.substr(1), virtual_host);
+        wildcard_virtual_host_suffixes_.add(domain.substr(1), virtual_host);
       } else {
         if (virtual_hosts_.find(domain) != virtual_hosts_.end()) {
           throw EnvoyException(fmt::format(
@@ -713,9 +783,20 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
     return SSL_REDIRECT_ROUTE;
   }
 
-  // Check for a route that matches the request.
-  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
-    RouteConstSharedPtr route_entry = route->matches(headers, random_value);
+  if (routes_.empty()) {
+    return nullptr;
+  }
+
+  // Check for a route that matches the request, among those whose path specifier may match.
+  const Http::HeaderString& path = headers.Path()->value();
+  const char* query_string_start = Http::Utility::findQueryStringStart(path);
+  const size_t path_length =
+      query_string_start != nullptr ? query_string_start - path.c_str() : path.size();
+  RouteTrie::Candidates candidates;
+  route_trie_.candidates(path.c_str(), path.size(), path_length, candidates);
+  uint32_t index;
+  while (candidates.next(index)) {
+    RouteConstSharedPtr route_entry = routes_[index]->matches(headers, random_value);
     if (nullptr != route_entry) {
       return route_entry;
     }
@@ -726,19 +807,19 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
 
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::HeaderMap& headers) const {
   // Fast path the case where we only have a default virtual host.
-  if (virtual_hosts_.empty() && default_virtual_host_) {
+  if (virtual_hosts_.empty() && wildcard_virtual_host_suffixes_.empty() && default_virtual_host_) {
     return default_virtual_host_.get();
   }
 
   // TODO (@rshriram) Match Origin header in WebSocket
   // request with VHost, using wildcard match
-  const char* host = headers.Host()->value().c_str();
-  const auto& iter = virtual_hosts_.find(host);
+  const Http::HeaderString& host = headers.Host()->value();
+  const auto& iter = virtual_hosts_.find(host.c_str());
   if (iter != virtual_hosts_.end()) {
     return iter->second.get();
   }
   if (!wildcard_virtual_host_suffixes_.empty()) {
-    const VirtualHostImpl* vhost = findWildcardVirtualHost(host);
+    const VirtualHostImpl* vhost = wildcard_virtual_host_suffixes_.find(host.c_str(), host.size());
     if (vhost != nullptr) {
       return vhost;
     }
@@ -767,7 +848,8 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
     bool method_matches =
         !entry.method_.valid() || headers.Method()->value().c_str() == entry.method_.value();
 
-    if (method_matches && std::regex_match(headers.Path()->value().c_str(), entry.pattern_)) {
+    const Http::HeaderString& path = headers.Path()->value();
+    if (method_matches && entry.pattern_->fullMatch(path.c_str(), path.c_str() + path.size())) {
       return &entry;
     }
   }
@@ -780,10 +862,31 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
 }
 
 ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config, Runtime::Loader& runtime,
-                       Upstream::ClusterManager& cm, bool validate_clusters_default) {
+                       Upstream::ClusterManager& cm, bool validate_clusters_default,
+                       const ConfigImpl* previous_config) {
+  for (const auto& header_value_option : config.request_headers_to_add()) {
+    request_headers_to_add_.push_back({Http::LowerCaseString(header_value_option.header().key()),
+                                       header_value_option.header().value()});
+  }
+
+  // Every virtual host evaluates the global request headers, so virtual hosts can only be shared
+  // with the previous configuration if those are unchanged, in which case so is the parser.
+  envoy::api::v2::RouteConfiguration request_headers_to_add;
+  request_headers_to_add.mutable_request_headers_to_add()->CopyFrom(
+      config.request_headers_to_add());
+  request_headers_to_add_hash_ = MessageUtil::hash(request_headers_to_add);
+  if (previous_config != nullptr &&
+      previous_config->request_headers_to_add_hash_ != request_headers_to_add_hash_) {
+    previous_config = nullptr;
+  }
+  request_headers_parser_ = previous_config != nullptr
+                                ? previous_config->request_headers_parser_
+                                : RequestHeaderParser::parse(config.request_headers_to_add());
+
   route_matcher_.reset(new RouteMatcher(
-      config, *this, runtime, cm,
-      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default)));
+      config, request_headers_parser_, runtime, cm,
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default),
+      previous_config != nullptr ? previous_config->route_matcher_.get() : nullptr));
 
   for (const std::string& header : config.internal_only_headers()) {
     internal_only_headers_.push_back(Http::LowerCaseString(header));
@@ -797,12 +900,6 @@ ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config, Runtime
   for (const std::string& header : config.response_headers_to_remove()) {
     response_headers_to_remove_.push_back(Http::LowerCaseString(header));
   }
-
-  for (const auto& header_value_option : config.request_headers_to_add()) {
-    request_headers_to_add_.push_back({Http::LowerCaseString(header_value_option.header().key()),
-                                       header_value_option.header().value()});
-  }
-  request_headers_parser_ = RequestHeaderParser::parse(config.request_headers_to_add());
 }
 
 } // namespace Router
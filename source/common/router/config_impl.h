@@ -5,9 +5,9 @@
 #include <list>
 #include <map>
 #include <memory>
-#include <regex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/common/optional.h"
@@ -15,9 +15,12 @@
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/common/regex.h"
 #include "common/router/config_utility.h"
 #include "common/router/req_header_formatter.h"
+#include "common/router/route_trie.h"
 #include "common/router/router_ratelimit.h"
+#include "common/runtime/key_registry.h"
 
 #include "api/rds.pb.h"
 
@@ -74,6 +77,9 @@ public:
 
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
+  bool allowsOrigin(const std::string& origin) const override {
+    return allow_any_origin_ || allowed_origins_.count(origin) > 0;
+  }
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -83,6 +89,9 @@ public:
 
 private:
   std::list<std::string> allow_origin_;
+  // allow_origin_ indexed for matching, since a policy may list hundreds of origins.
+  std::unordered_set<std::string> allowed_origins_;
+  bool allow_any_origin_{};
   std::string allow_methods_;
   std::string allow_headers_;
   std::string expose_headers_;
@@ -91,15 +100,16 @@ private:
   bool enabled_;
 };
 
-class ConfigImpl;
 /**
- * Holds all routing configuration for an entire virtual host.
+ * Holds all routing configuration for an entire virtual host. A virtual host does not refer to the
+ * route configuration that built it, so an unchanged virtual host can be shared by the route
+ * configuration that replaces it.
  */
 class VirtualHostImpl : public VirtualHost {
 public:
   VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host,
-                  const ConfigImpl& global_route_config, Runtime::Loader& runtime,
-                  Upstream::ClusterManager& cm, bool validate_clusters);
+                  RequestHeaderParserConstSharedPtr global_request_headers_parser,
+                  Runtime::Loader& runtime, Upstream::ClusterManager& cm, bool validate_clusters);
 
   RouteConstSharedPtr getRouteFromEntries(const Http::HeaderMap& headers,
                                           uint64_t random_value) const;
@@ -107,9 +117,18 @@ public:
   const std::list<std::pair<Http::LowerCaseString, std::string>>& requestHeadersToAdd() const {
     return request_headers_to_add_;
   }
-  const ConfigImpl& globalRouteConfig() const { return global_route_config_; }
+  const RequestHeaderParser& globalRequestHeaderParser() const {
+    return *global_request_headers_parser_;
+  }
   const RequestHeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
 
+  /**
+   * Check that every cluster the routes of the virtual host refer to is known to the cluster
+   * manager.
+   * @throw EnvoyException if a cluster is unknown.
+   */
+  void validateClusters(Upstream::ClusterManager& cm) const;
+
   // Router::VirtualHost
   const CorsPolicy* corsPolicy() const override { return cors_policy_.get(); }
   const std::string& name() const override { return name_; }
@@ -124,7 +143,7 @@ private:
     // Router::VirtualCluster
     const std::string& name() const override { return name_; }
 
-    std::regex pattern_;
+    Regex::CompiledMatcherSharedPtr pattern_;
     Optional<std::string> method_;
     std::string name_;
   };
@@ -141,12 +160,14 @@ private:
 
   const std::string name_;
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  // Index over the path specifiers of routes_ so that lookups only evaluate the routes whose path
+  // can match. Candidates are still checked in configuration order.
+  RouteTrie route_trie_;
   std::vector<VirtualClusterEntry> virtual_clusters_;
   SslRequirements ssl_requirements_;
   const RateLimitPolicyImpl rate_limit_policy_;
   std::unique_ptr<const CorsPolicyImpl> cors_policy_;
-  const ConfigImpl& global_route_config_; // See note in RouteEntryImplBase::clusterEntry() on why
-                                          // raw ref to the top level config is currently safe.
+  const RequestHeaderParserConstSharedPtr global_request_headers_parser_;
   std::list<std::pair<Http::LowerCaseString, std::string>> request_headers_to_add_;
   RequestHeaderParserPtr request_headers_parser_;
 };
@@ -408,15 +429,15 @@ private:
    */
   class WeightedClusterEntry : public DynamicRouteEntry {
   public:
-    WeightedClusterEntry(const RouteEntryImplBase* parent, const std::string runtime_key,
-                         Runtime::Loader& loader, const std::string& name, uint64_t weight,
+    WeightedClusterEntry(const RouteEntryImplBase* parent, const std::string& runtime_key,
+                         const std::string& name, uint64_t weight,
                          MetadataMatchCriteriaImplConstPtr cluster_metadata_match_criteria)
-        : DynamicRouteEntry(parent, name), runtime_key_(runtime_key), loader_(loader),
-          cluster_weight_(weight),
+        : DynamicRouteEntry(parent, name),
+          runtime_key_(Runtime::KeyRegistry::registerKey(runtime_key)), cluster_weight_(weight),
           cluster_metadata_match_criteria_(std::move(cluster_metadata_match_criteria)) {}
 
-    uint64_t clusterWeight() const {
-      return loader_.snapshot().getInteger(runtime_key_, cluster_weight_);
+    uint64_t clusterWeight(const Runtime::Snapshot& snapshot) const {
+      return snapshot.getInteger(runtime_key_, cluster_weight_);
     }
 
     const MetadataMatchCriteria* metadataMatchCriteria() const override {
@@ -429,14 +450,26 @@ private:
     static const uint64_t MAX_CLUSTER_WEIGHT;
 
   private:
-    const std::string runtime_key_;
-    Runtime::Loader& loader_;
+    const Runtime::Key& runtime_key_;
     const uint64_t cluster_weight_;
     MetadataMatchCriteriaImplConstPtr cluster_metadata_match_criteria_;
   };
 
   typedef std::shared_ptr<WeightedClusterEntry> WeightedClusterEntrySharedPtr;
 
+  /**
+   * The cumulative weights of the weighted clusters for one runtime snapshot. The interval of the
+   * i-th cluster is [ends_[i - 1], ends_[i]).
+   */
+  struct WeightedClusterWeights {
+    uint64_t generation_;
+    std::vector<uint64_t> ends_;
+  };
+
+  typedef std::shared_ptr<const WeightedClusterWeights> WeightedClusterWeightsConstSharedPtr;
+
+  WeightedClusterWeightsConstSharedPtr weightedClusterWeights() const;
+
   static Optional<RuntimeData> loadRuntimeData(const envoy::api::v2::RouteMatch& route);
 
   static std::multimap<std::string, std::string>
@@ -465,6 +498,9 @@ private:
   const Upstream::ResourcePriority priority_;
   std::vector<ConfigUtility::HeaderData> config_headers_;
   std::vector<WeightedClusterEntrySharedPtr> weighted_clusters_;
+  // Rebuilt by the first request which sees a new runtime snapshot. The workers share the route
+  // table, so the pointer is only loaded and stored atomically.
+  mutable WeightedClusterWeightsConstSharedPtr weighted_cluster_weights_;
   std::unique_ptr<const HashPolicyImpl> hash_policy_;
   MetadataMatchCriteriaImplConstPtr metadata_match_criteria_;
   std::list<std::pair<Http::LowerCaseString, std::string>> request_headers_to_add_;
@@ -530,7 +566,7 @@ public:
   RouteConstSharedPtr matches(const Http::HeaderMap& headers, uint64_t random_value) const override;
 
 private:
-  const std::regex regex_;
+  const Regex::CompiledMatcherPtr regex_;
 };
 
 /**
@@ -539,28 +575,55 @@ private:
  */
 class RouteMatcher {
 public:
+  /**
+   * @param previous_route_matcher supplies the matcher being replaced, whose virtual hosts are
+   *        reused if their configuration is unchanged, or nullptr.
+   */
   RouteMatcher(const envoy::api::v2::RouteConfiguration& config,
-               const ConfigImpl& global_http_config, Runtime::Loader& runtime,
-               Upstream::ClusterManager& cm, bool validate_clusters);
+               RequestHeaderParserConstSharedPtr global_request_headers_parser,
+               Runtime::Loader& runtime, Upstream::ClusterManager& cm, bool validate_clusters,
+               const RouteMatcher* previous_route_matcher);
 
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const;
 
 private:
+  /**
+   * Trie over the reversed suffixes of wildcard domains (the part after the '*'), so that the
+   * longest wildcard matching a host is found in one walk back from the end of the host.
+   */
+  class WildcardSuffixTrie {
+  public:
+    /**
+     * Add a wildcard suffix. If the suffix has already been added the first virtual host is kept.
+     */
+    void add(const std::string& suffix, VirtualHostSharedPtr virtual_host);
+
+    /**
+     * @return the virtual host with the longest suffix of host which is shorter than host, since
+     *         the wildcard matches at least one character. nullptr if there is none.
+     */
+    const VirtualHostImpl* find(const char* host, size_t length) const;
+
+    bool empty() const { return root_.children_.empty(); }
+
+  private:
+    struct Node {
+      // Sorted by character.
+      std::vector<std::pair<char, std::unique_ptr<Node>>> children_;
+      VirtualHostSharedPtr virtual_host_;
+
+      const Node* child(char c) const;
+    };
+
+    Node root_;
+  };
+
   const VirtualHostImpl* findVirtualHost(const Http::HeaderMap& headers) const;
-  const VirtualHostImpl* findWildcardVirtualHost(const std::string& host) const;
 
   std::unordered_map<std::string, VirtualHostSharedPtr> virtual_hosts_;
-  // std::greater as a minor optimization to iterate from more to less specific
-  //
-  // A note on using an unordered_map versus a vector of (string, VirtualHostSharedPtr) pairs:
-  //
-  // Based on local benchmarks, each vector entry costs around 20ns for recall and (string)
-  // comparison with a fixed cost of about 25ns. For unordered_map, the empty map costs about 65ns
-  // and climbs to about 110ns once there are any entries.
-  //
-  // The break-even is 4 entries.
-  std::map<int64_t, std::unordered_map<std::string, VirtualHostSharedPtr>, std::greater<int64_t>>
-      wildcard_virtual_host_suffixes_;
+  // All virtual hosts keyed by the hash of their configuration, for reuse by the next matcher.
+  std::unordered_map<uint64_t, VirtualHostSharedPtr> virtual_hosts_by_hash_;
+  WildcardSuffixTrie wildcard_virtual_host_suffixes_;
   VirtualHostSharedPtr default_virtual_host_;
 };
 
@@ -569,8 +632,14 @@ private:
  */
 class ConfigImpl : public Config {
 public:
+  /**
+   * @param previous_config supplies the configuration being replaced, or nullptr. Virtual hosts
+   *        whose configuration is unchanged are shared with it rather than built again, as long as
+   *        the global request headers to add are also unchanged.
+   */
   ConfigImpl(const envoy::api::v2::RouteConfiguration& config, Runtime::Loader& runtime,
-             Upstream::ClusterManager& cm, bool validate_clusters_default);
+             Upstream::ClusterManager& cm, bool validate_clusters_default,
+             const ConfigImpl* previous_config = nullptr);
 
   const std::list<std::pair<Http::LowerCaseString, std::string>>& requestHeadersToAdd() const {
     return request_headers_to_add_;
@@ -602,9 +671,12 @@ private:
   std::list<std::pair<Http::LowerCaseString, std::string>> response_headers_to_add_;
   std::list<Http::LowerCaseString> response_headers_to_remove_;
   std::list<std::pair<Http::LowerCaseString, std::string>> request_headers_to_add_;
-  RequestHeaderParserPtr request_headers_parser_;
+  uint64_t request_headers_to_add_hash_;
+  RequestHeaderParserConstSharedPtr request_headers_parser_;
 };
 
+typedef std::shared_ptr<const ConfigImpl> ConfigImplConstSharedPtr;
+
 /**
  * Implementation of Config that is empty.
  */
@@ -1,6 +1,5 @@
 #include "common/router/config_utility.h"
 
-#include <regex>
 #include <string>
 #include <vector>
 
@@ -34,7 +33,8 @@ bool ConfigUtility::matchHeaders(const Http::HeaderMap& request_headers,
         matches &= (header != nullptr) && (header->value() == cfg_header_data.value_.c_str());
       } else {
         matches &= (header != nullptr) &&
-                   std::regex_match(header->value().c_str(), cfg_header_data.regex_pattern_);
+                   cfg_header_data.regex_pattern_->fullMatch(
+                       header->value().c_str(), header->value().c_str() + header->value().size());
       }
       if (!matches) {
         break;
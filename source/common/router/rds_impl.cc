@@ -9,7 +9,6 @@
 #include "common/config/rds_json.h"
 #include "common/config/subscription_factory.h"
 #include "common/config/utility.h"
-#include "common/router/config_impl.h"
 #include "common/router/rds_subscription.h"
 
 #include "fmt/format.h"
@@ -111,7 +110,10 @@ void RdsRouteConfigProviderImpl::onConfigUpdate(const ResourceVector& resources)
   }
   const uint64_t new_hash = MessageUtil::hash(route_config);
   if (new_hash != last_config_hash_ || !initialized_) {
-    ConfigConstSharedPtr new_config(new ConfigImpl(route_config, runtime_, cm_, false));
+    // Build on the previous configuration so that unchanged virtual hosts are shared with it.
+    ConfigImplConstSharedPtr new_config(
+        new ConfigImpl(route_config, runtime_, cm_, false, config_.get()));
+    config_ = new_config;
     initialized_ = true;
     last_config_hash_ = new_hash;
     stats_.config_reload_.inc();
@@ -17,6 +17,7 @@
 
 #include "common/common/logger.h"
 #include "common/protobuf/utility.h"
+#include "common/router/config_impl.h"
 
 #include "api/filter/http/http_connection_manager.pb.h"
 #include "api/rds.pb.h"
@@ -134,6 +135,8 @@ private:
   const std::string route_config_name_;
   bool initialized_{};
   uint64_t last_config_hash_{};
+  // The latest configuration, kept on the main thread to build the next one from.
+  ConfigImplConstSharedPtr config_;
   Stats::ScopePtr scope_;
   RdsStats stats_;
   std::function<void()> initialize_callback_;
@@ -39,18 +39,28 @@ RequestHeaderParserPtr RequestHeaderParser::parse(
 void RequestHeaderParser::evaluateRequestHeaders(
     Http::HeaderMap& headers, const Http::AccessLog::RequestInfo& request_info) const {
   for (const auto& formatter : header_formatters_) {
-    headers.addReferenceKey(formatter.first, formatter.second->format(request_info));
+    const std::string* static_value = formatter.second->staticValue();
+    if (static_value != nullptr) {
+      // The parser lives as long as the route, which outlives the requests that use it.
+      headers.addReference(formatter.first, *static_value);
+    } else {
+      // The value is copied straight from where the request info keeps it into the header.
+      headers.addReferenceKey(formatter.first, formatter.second->format(request_info));
+    }
   }
 }
 
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& field_name) {
+  // The extractors return references, so that formatting a header allocates nothing.
   if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const Envoy::Http::AccessLog::RequestInfo& request_info) {
+    field_extractor_ =
+        [](const Envoy::Http::AccessLog::RequestInfo& request_info) -> const std::string& {
       return Envoy::Http::AccessLog::AccessLogFormatUtils::protocolToString(
           request_info.protocol());
     };
   } else if (field_name == "CLIENT_IP") {
-    field_extractor_ = [](const Envoy::Http::AccessLog::RequestInfo& request_info) {
+    field_extractor_ =
+        [](const Envoy::Http::AccessLog::RequestInfo& request_info) -> const std::string& {
       return request_info.getDownstreamAddress();
     };
   } else {
@@ -59,10 +69,5 @@ RequestHeaderFormatter::RequestHeaderFormatter(const std::string& field_name) {
   }
 }
 
-const std::string
-RequestHeaderFormatter::format(const Envoy::Http::AccessLog::RequestInfo& request_info) const {
-  return field_extractor_(request_info);
-}
-
 } // namespace Router
 } // namespace Envoy
@@ -18,8 +18,18 @@ class HeaderFormatter {
 public:
   virtual ~HeaderFormatter() {}
 
-  virtual const std::string
+  /**
+   * @return const std::string& the value of the header for a request. It is owned by the formatter
+   *         or by the request info, and is copied straight into the header.
+   */
+  virtual const std::string&
   format(const Envoy::Http::AccessLog::RequestInfo& request_info) const PURE;
+
+  /**
+   * @return the value if it does not depend on the request, so that headers can refer to it rather
+   *         than each holding a copy. nullptr otherwise.
+   */
+  virtual const std::string* staticValue() const PURE;
 };
 
 typedef std::unique_ptr<HeaderFormatter> HeaderFormatterPtr;
@@ -32,10 +42,16 @@ public:
   RequestHeaderFormatter(const std::string& field_name);
 
   // HeaderFormatter::format
-  const std::string format(const Envoy::Http::AccessLog::RequestInfo& request_info) const override;
+  const std::string&
+  format(const Envoy::Http::AccessLog::RequestInfo& request_info) const override {
+    return field_extractor_(request_info);
+  }
+  const std::string* staticValue() const override { return nullptr; }
 
 private:
-  std::function<std::string(const Envoy::Http::AccessLog::RequestInfo&)> field_extractor_;
+  typedef const std::string& (*FieldExtractor)(const Envoy::Http::AccessLog::RequestInfo&);
+
+  FieldExtractor field_extractor_;
 };
 
 /**
@@ -47,9 +63,10 @@ public:
       : static_value_(static_header_value){};
 
   // HeaderFormatter::format
-  const std::string format(const Envoy::Http::AccessLog::RequestInfo&) const override {
+  const std::string& format(const Envoy::Http::AccessLog::RequestInfo&) const override {
     return static_value_;
   };
+  const std::string* staticValue() const override { return &static_value_; }
 
 private:
   const std::string static_value_;
@@ -57,6 +74,7 @@ private:
 
 class RequestHeaderParser;
 typedef std::unique_ptr<RequestHeaderParser> RequestHeaderParserPtr;
+typedef std::shared_ptr<const RequestHeaderParser> RequestHeaderParserConstSharedPtr;
 
 /**
  * This class holds the parsing logic required during configuration build and
@@ -71,7 +71,12 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy, Http::HeaderMap&
   retries_remaining_ = std::max(retries_remaining_, route_policy.numRetries());
 }
 
-RetryStateImpl::~RetryStateImpl() { resetRetry(); }
+RetryStateImpl::~RetryStateImpl() {
+  resetRetry();
+  if (hedged_) {
+    cluster_.resourceManager(priority_).retries().dec();
+  }
+}
 
 void RetryStateImpl::enableBackoffTimer() {
   // We use a fully jittered exponential backoff algorithm.
@@ -165,6 +170,23 @@ RetryStatus RetryStateImpl::shouldRetry(const Http::HeaderMap* response_headers,
   return RetryStatus::Yes;
 }
 
+bool RetryStateImpl::shouldHedge() {
+  if (hedged_ || retries_remaining_ == 0) {
+    return false;
+  }
+
+  if (!cluster_.resourceManager(priority_).retries().canCreate()) {
+    cluster_.stats().upstream_rq_retry_overflow_.inc();
+    return false;
+  }
+
+  retries_remaining_--;
+  hedged_ = true;
+  cluster_.resourceManager(priority_).retries().inc();
+  cluster_.stats().upstream_rq_hedge_.inc();
+  return true;
+}
+
 bool RetryStateImpl::wouldRetry(const Http::HeaderMap* response_headers,
                                 const Optional<Http::StreamResetReason>& reset_reason) {
   // We never retry if the overloaded header is set.
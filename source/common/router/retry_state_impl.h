@@ -35,6 +35,7 @@ public:
   RetryStatus shouldRetry(const Http::HeaderMap* response_headers,
                           const Optional<Http::StreamResetReason>& reset_reason,
                           DoRetryCallback callback) override;
+  bool shouldHedge() override;
 
 private:
   RetryStateImpl(const RetryPolicy& route_policy, Http::HeaderMap& request_headers,
@@ -57,6 +58,7 @@ private:
   DoRetryCallback callback_;
   Event::TimerPtr retry_timer_;
   Upstream::ResourcePriority priority_;
+  bool hedged_{};
 };
 
 } // namespace Router
@@ -0,0 +1,179 @@
+#include "common/router/route_trie.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Router {
+
+namespace {
+
+std::string toLower(const std::string& value) {
+  std::string lower(value);
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  return lower;
+}
+
+char lookupChar(char c, bool case_sensitive) {
+  return case_sensitive ? c : static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+}
+
+void insertSorted(std::vector<uint32_t>& list, uint32_t index) {
+  list.insert(std::upper_bound(list.begin(), list.end(), index), index);
+}
+
+} // namespace
+
+const size_t RouteTrie::Candidates::MaxLists;
+
+bool RouteTrie::Candidates::next(uint32_t& index) {
+  size_t min_list = MaxLists;
+  for (size_t i = 0; i < num_lists_; i++) {
+    if (begin_[i] != end_[i] && (min_list == MaxLists || *begin_[i] < *begin_[min_list])) {
+      min_list = i;
+    }
+  }
+
+  if (min_list == MaxLists) {
+    return false;
+  }
+
+  index = *begin_[min_list]++;
+  return true;
+}
+
+void RouteTrie::Candidates::add(const std::vector<uint32_t>& list) {
+  if (list.empty()) {
+    return;
+  }
+
+  ASSERT(num_lists_ < MaxLists);
+  begin_[num_lists_] = list.data();
+  end_[num_lists_] = list.data() + list.size();
+  num_lists_++;
+}
+
+void RouteTrie::addPrefix(const std::string& prefix, bool case_sensitive, uint32_t index) {
+  if (case_sensitive) {
+    addPrefixRoute(insert(case_sensitive_root_, prefix), index);
+  } else {
+    addPrefixRoute(insert(case_insensitive_root_, toLower(prefix)), index);
+  }
+}
+
+void RouteTrie::addPath(const std::string& path, bool case_sensitive, uint32_t index) {
+  if (case_sensitive) {
+    insertSorted(insert(case_sensitive_root_, path).path_routes_, index);
+  } else {
+    insertSorted(insert(case_insensitive_root_, toLower(path)).path_routes_, index);
+  }
+}
+
+void RouteTrie::addCatchAll(uint32_t index) { insertSorted(catch_all_routes_, index); }
+
+void RouteTrie::addPrefixRoute(Node& node, uint32_t index) {
+  // A prefix route is a candidate for every path which reaches this node or any node below it.
+  insertSorted(node.prefix_routes_, index);
+  for (const auto& child : node.children_) {
+    addPrefixRoute(*child, index);
+  }
+}
+
+void RouteTrie::candidates(const char* path, size_t length, size_t path_length,
+                           Candidates& candidates) const {
+  candidates.num_lists_ = 0;
+  candidates.add(catch_all_routes_);
+  lookup(case_sensitive_root_, true, path, length, path_length, candidates);
+  lookup(case_insensitive_root_, false, path, length, path_length, candidates);
+}
+
+size_t RouteTrie::childIndex(const Node& node, char c) {
+  const auto it = std::lower_bound(
+      node.children_.begin(), node.children_.end(), c,
+      [](const std::unique_ptr<Node>& child, char c) -> bool { return child->label_[0] < c; });
+  return it - node.children_.begin();
+}
+
+RouteTrie::Node& RouteTrie::insert(Node& root, const std::string& key) {
+  Node* node = &root;
+  size_t position = 0;
+  while (position < key.size()) {
+    const size_t index = childIndex(*node, key[position]);
+    if (index == node->children_.size() || node->children_[index]->label_[0] != key[position]) {
+      std::unique_ptr<Node> leaf(new Node());
+      leaf->label_ = key.substr(position);
+      leaf->prefix_routes_ = node->prefix_routes_;
+      Node& result = *leaf;
+      node->children_.insert(node->children_.begin() + index, std::move(leaf));
+      return result;
+    }
+
+    std::unique_ptr<Node>& child = node->children_[index];
+    size_t common = 1;
+    while (common < child->label_.size() && position + common < key.size() &&
+           child->label_[common] == key[position + common]) {
+      common++;
+    }
+
+    if (common < child->label_.size()) {
+      // Split the edge so that the key ends at or branches off from a node.
+      std::unique_ptr<Node> middle(new Node());
+      middle->label_ = child->label_.substr(0, common);
+      middle->prefix_routes_ = node->prefix_routes_;
+      child->label_.erase(0, common);
+      middle->children_.push_back(std::move(child));
+      child = std::move(middle);
+    }
+
+    node = child.get();
+    position += common;
+  }
+
+  return *node;
+}
+
+void RouteTrie::lookup(const Node& root, bool case_sensitive, const char* path, size_t length,
+                       size_t path_length, Candidates& candidates) {
+  const Node* node = &root;
+  size_t position = 0;
+  while (true) {
+    if (position == path_length) {
+      candidates.add(node->path_routes_);
+    }
+
+    if (position == length) {
+      break;
+    }
+
+    const char c = lookupChar(path[position], case_sensitive);
+    const size_t index = childIndex(*node, c);
+    if (index == node->children_.size() || node->children_[index]->label_[0] != c) {
+      break;
+    }
+
+    const Node& child = *node->children_[index];
+    const std::string& label = child.label_;
+    if (label.size() > length - position) {
+      break;
+    }
+
+    bool matched = true;
+    for (size_t i = 1; i < label.size() && matched; i++) {
+      matched = lookupChar(path[position + i], case_sensitive) == label[i];
+    }
+    if (!matched) {
+      break;
+    }
+
+    node = &child;
+    position += label.size();
+  }
+
+  // The deepest node reached holds the prefix routes of all the nodes on the way to it.
+  candidates.add(node->prefix_routes_);
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Radix trie over the prefix and exact path matches of a virtual host's routes. Routes are
+ * identified by their index in the route table. A lookup returns, in route table order, every route
+ * whose path specifier can match a request path, so that header and runtime predicates only need
+ * to be evaluated for those. Routes that cannot be indexed (regex routes) are returned by every
+ * lookup.
+ *
+ * Case insensitive routes are kept in a separate trie with lower cased keys.
+ */
+class RouteTrie : NonCopyable {
+public:
+  /**
+   * Add a route which matches any path starting with prefix.
+   */
+  void addPrefix(const std::string& prefix, bool case_sensitive, uint32_t index);
+
+  /**
+   * Add a route which matches a path equal to path, ignoring any query string.
+   */
+  void addPath(const std::string& path, bool case_sensitive, uint32_t index);
+
+  /**
+   * Add a route which must be checked for every path.
+   */
+  void addCatchAll(uint32_t index);
+
+  /**
+   * The routes that may match a request path. These are kept as a few sorted lists of route
+   * indices owned by the trie, which next() merges as it goes, so a lookup neither allocates nor
+   * sorts. Only valid for as long as the trie is.
+   */
+  class Candidates {
+  public:
+    /**
+     * @param index receives the next candidate route index. Indices are returned in ascending
+     *        order.
+     * @return false once all candidates have been returned.
+     */
+    bool next(uint32_t& index);
+
+  private:
+    friend class RouteTrie;
+
+    // The catch all routes, plus the prefix and the path routes found in each of the two tries.
+    static const size_t MaxLists = 5;
+
+    void add(const std::vector<uint32_t>& list);
+
+    std::array<const uint32_t*, MaxLists> begin_;
+    std::array<const uint32_t*, MaxLists> end_;
+    size_t num_lists_{0};
+  };
+
+  /**
+   * Find the routes that may match a request path.
+   * @param path supplies the request path, including any query string.
+   * @param length supplies the length of the path.
+   * @param path_length supplies the length of the path without its query string.
+   * @param candidates receives the candidate routes.
+   */
+  void candidates(const char* path, size_t length, size_t path_length,
+                  Candidates& candidates) const;
+
+private:
+  struct Node {
+    // Label of the edge leading into this node.
+    std::string label_;
+    // Sorted by the first character of their labels, which are distinct.
+    std::vector<std::unique_ptr<Node>> children_;
+    // The prefix routes of this node and of all of its ancestors, sorted. Merged when routes are
+    // added, so that a lookup only needs the list of the deepest node it reaches.
+    std::vector<uint32_t> prefix_routes_;
+    // Sorted.
+    std::vector<uint32_t> path_routes_;
+  };
+
+  static Node& insert(Node& root, const std::string& key);
+  static void addPrefixRoute(Node& node, uint32_t index);
+  static void lookup(const Node& root, bool case_sensitive, const char* path, size_t length,
+                     size_t path_length, Candidates& candidates);
+  // @return the position of the child whose label starts with c, or of where it would be inserted.
+  static size_t childIndex(const Node& node, char c);
+
+  Node case_sensitive_root_;
+  Node case_insensitive_root_;
+  std::vector<uint32_t> catch_all_routes_;
+};
+
+} // namespace Router
+} // namespace Envoy
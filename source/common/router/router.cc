@@ -1,8 +1,10 @@
 #include "common/router/router.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <utility>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
@@ -218,7 +220,7 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
 
   // A route entry matches for the request.
   route_entry_ = route_->routeEntry();
-  Upstream::ThreadLocalCluster* cluster = config_.cm_.get(route_entry_->clusterName());
+  Upstream::ThreadLocalCluster* cluster = threadLocalCluster();
   if (!cluster) {
     config_.stats_.no_cluster_.inc();
     ENVOY_STREAM_LOG(debug, "unknown cluster '{}'", *callbacks_, route_entry_->clusterName());
@@ -274,6 +276,18 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   do_shadowing_ = FilterUtility::shouldShadow(route_entry_->shadowPolicy(), config_.runtime_,
                                               callbacks_->streamId());
 
+  // The body of a request which may be retried is kept to be replayed, up to the retry buffer
+  // limit. A request whose body is known to be larger is streamed without retries from the start.
+  retry_buffer_limit_ =
+      config_.runtime_.snapshot().getInteger("upstream.retry_buffer_limit_bytes", buffer_limit_);
+  uint64_t content_length;
+  if (!end_stream && retry_buffer_limit_ > 0 && headers.ContentLength() &&
+      StringUtil::atoul(headers.ContentLength()->value().c_str(), content_length) &&
+      content_length > retry_buffer_limit_ && retry_state_ && retry_state_->enabled()) {
+    cluster_->stats().retry_or_shadow_abandoned_.inc();
+    retry_state_.reset();
+  }
+
 #ifndef NVLOG
   headers.iterate(
       [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
@@ -303,8 +317,19 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
 }
 
 Http::ConnectionPool::Instance* Filter::getConnPool() {
-  return config_.cm_.httpConnPoolForCluster(route_entry_->clusterName(), route_entry_->priority(),
-                                            this);
+  Upstream::ThreadLocalCluster* cluster = threadLocalCluster();
+  return cluster ? cluster->httpConnPool(route_entry_->priority(), this) : nullptr;
+}
+
+Upstream::ThreadLocalCluster* Filter::threadLocalCluster() {
+  // The cluster is only looked up by name again once a cluster update on this worker may have
+  // destroyed it.
+  const uint64_t generation = config_.cm_.threadLocalGeneration();
+  if (thread_local_cluster_ == nullptr || generation != thread_local_cluster_generation_) {
+    thread_local_cluster_ = config_.cm_.get(route_entry_->clusterName());
+    thread_local_cluster_generation_ = generation;
+  }
+  return thread_local_cluster_;
 }
 
 void Filter::sendNoHealthyUpstreamResponse() {
@@ -314,9 +339,17 @@ void Filter::sendNoHealthyUpstreamResponse() {
 }
 
 Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_stream) {
+  const uint64_t buffered_length = getLength(callbacks_->decodingBuffer()) + data.length();
+  if (retry_buffer_limit_ > 0 && buffered_length > retry_buffer_limit_ && retry_state_ &&
+      retry_state_->enabled()) {
+    // The body is too large to be replayed, so the request can no longer be retried. It keeps
+    // streaming upstream, and is only buffered further if it is shadowed.
+    cluster_->stats().retry_or_shadow_abandoned_.inc();
+    retry_state_.reset();
+  }
+
   bool buffering = (retry_state_ && retry_state_->enabled()) || do_shadowing_;
-  if (buffering && buffer_limit_ > 0 &&
-      getLength(callbacks_->decodingBuffer()) + data.length() > buffer_limit_) {
+  if (buffering && buffer_limit_ > 0 && buffered_length > buffer_limit_) {
     // The request is larger than we should buffer.  Give up on the retry/shadow
     cluster_->stats().retry_or_shadow_abandoned_.inc();
     retry_state_.reset();
@@ -324,10 +357,11 @@ Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_strea
     do_shadowing_ = false;
   }
 
-  // If we are going to buffer for retries or shadowing, we need to make a copy before encoding
-  // since it's all moves from here on.
+  // If we are going to buffer for retries or shadowing, we need a second reference to the data
+  // before encoding since it's all moves from here on. The slices are shared rather than copied.
   if (buffering) {
-    Buffer::OwnedImpl copy(data);
+    Buffer::OwnedImpl copy;
+    copy.addShared(data);
     upstream_request_->encodeData(copy, end_stream);
   } else {
     upstream_request_->encodeData(data, end_stream);
@@ -361,6 +395,14 @@ void Filter::setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callb
 
 void Filter::cleanup() {
   upstream_request_.reset();
+  if (hedged_request_) {
+    hedged_request_->resetStream();
+    hedged_request_.reset();
+  }
+  if (hedge_timer_) {
+    hedge_timer_->disableTimer();
+    hedge_timer_.reset();
+  }
   retry_state_.reset();
   if (response_timeout_) {
     response_timeout_->disableTimer();
@@ -377,7 +419,10 @@ void Filter::maybeDoShadowing() {
   Http::MessagePtr request(new Http::RequestMessageImpl(
       Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_headers_)}));
   if (callbacks_->decodingBuffer()) {
-    request->body().reset(new Buffer::OwnedImpl(*callbacks_->decodingBuffer()));
+    // The shadow shares the slices of the buffered body rather than copying them.
+    Buffer::OwnedImpl* body = new Buffer::OwnedImpl();
+    body->addShared(*callbacks_->decodingBuffer());
+    request->body().reset(body);
   }
   if (downstream_trailers_) {
     request->trailers(Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_trailers_)});
@@ -407,7 +452,87 @@ void Filter::onRequestComplete() {
           callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeout(); });
       response_timeout_->enableTimer(timeout_.global_timeout_);
     }
+    maybeSetupHedge();
+  }
+}
+
+void Filter::maybeSetupHedge() {
+  // Only requests which may be retried are hedged, as both copies of the request may be processed
+  // upstream.
+  if (!retry_state_ || !config_.runtime_.snapshot().featureEnabled("upstream.use_hedging", 0) ||
+      !retry_state_->enabled()) {
+    return;
+  }
+
+  Upstream::ThreadLocalCluster* cluster = threadLocalCluster();
+  if (!cluster) {
+    return;
+  }
+
+  // The request is hedged once it is slower than most responses of the cluster on this worker.
+  const uint64_t percentile = std::min<uint64_t>(
+      100, config_.runtime_.snapshot().getInteger("upstream.hedge_percentile", 95));
+  const Optional<std::chrono::milliseconds> delay =
+      cluster->responseTimes().responseTimeQuantile(percentile / 100.0);
+  if (!delay.valid()) {
+    return;
+  }
+
+  hedge_timer_ = callbacks_->dispatcher().createTimer([this]() -> void { onHedgeTimeout(); });
+  hedge_timer_->enableTimer(delay.value());
+}
+
+void Filter::onHedgeTimeout() {
+  // The request may be in a retry back off, or the response may have started.
+  if (!upstream_request_ || downstream_response_started_ || !retry_state_ ||
+      !retry_state_->shouldHedge()) {
+    return;
   }
+
+  Http::ConnectionPool::Instance* conn_pool = getConnPool();
+  if (!conn_pool) {
+    return;
+  }
+
+  ENVOY_STREAM_LOG(debug, "hedging request", *callbacks_);
+  hedged_ = true;
+  sendBufferedRequest(hedged_request_, *conn_pool);
+}
+
+void Filter::onUpstreamRequestHeaders(UpstreamRequest& request) {
+  if (!hedged_request_) {
+    return;
+  }
+
+  if (&request == hedged_request_.get()) {
+    cluster_->stats().upstream_rq_hedge_win_.inc();
+    std::swap(upstream_request_, hedged_request_);
+    callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+  }
+
+  hedged_request_->resetStream();
+  hedged_request_.reset();
+}
+
+void Filter::onUpstreamRequestReset(UpstreamRequest& request, UpstreamResetType type,
+                                    const Optional<Http::StreamResetReason>& reset_reason) {
+  if (!hedged_request_) {
+    onUpstreamReset(type, reset_reason);
+    return;
+  }
+
+  // Of the original and the hedged request, the one still outstanding carries on alone.
+  if (&request == upstream_request_.get()) {
+    std::swap(upstream_request_, hedged_request_);
+    callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+  }
+
+  if (hedged_request_->upstream_host_) {
+    hedged_request_->upstream_host_->outlierDetector().putHttpResponseCode(
+        enumToInt(type == UpstreamResetType::Reset ? Http::Code::ServiceUnavailable
+                                                   : timeout_response_code_));
+  }
+  hedged_request_.reset();
 }
 
 void Filter::onDestroy() {
@@ -641,6 +766,21 @@ void Filter::onUpstreamComplete() {
     upstream_request_->resetStream();
   }
 
+  // Hedge delays follow the response times of the cluster on this worker, and the adaptive request
+  // limit of the cluster follows its latencies. The response time of a hedged request is left
+  // out, as it includes the hedge delay.
+  if (!hedged_ && DateUtil::timePointValid(downstream_request_complete_time_)) {
+    const std::chrono::steady_clock::duration response_time =
+        std::chrono::steady_clock::now() - downstream_request_complete_time_;
+    Upstream::ThreadLocalCluster* cluster = threadLocalCluster();
+    if (cluster) {
+      cluster->responseTimes().recordResponseTime(
+          std::chrono::duration_cast<std::chrono::milliseconds>(response_time));
+    }
+    cluster_->resourceManager(route_entry_->priority())
+        .onRequestLatency(std::chrono::duration_cast<std::chrono::microseconds>(response_time));
+  }
+
   if (config_.emit_dynamic_stats_ && !callbacks_->requestInfo().healthCheck() &&
       DateUtil::timePointValid(downstream_request_complete_time_)) {
     std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -717,21 +857,27 @@ void Filter::doRetry() {
 
   ASSERT(response_timeout_ || timeout_.global_timeout_.count() == 0);
   ASSERT(!upstream_request_);
-  upstream_request_.reset(new UpstreamRequest(*this, *conn_pool));
-  upstream_request_->encodeHeaders(!callbacks_->decodingBuffer() && !downstream_trailers_);
+  sendBufferedRequest(upstream_request_, *conn_pool);
+}
+
+void Filter::sendBufferedRequest(UpstreamRequestPtr& request,
+                                 Http::ConnectionPool::Instance& conn_pool) {
+  request.reset(new UpstreamRequest(*this, conn_pool));
+  request->encodeHeaders(!callbacks_->decodingBuffer() && !downstream_trailers_);
   // It's possible we got immediately reset.
-  if (upstream_request_) {
+  if (request) {
     if (callbacks_->decodingBuffer()) {
-      // If we are doing a retry we need to make a copy.
-      Buffer::OwnedImpl copy(*callbacks_->decodingBuffer());
-      upstream_request_->encodeData(copy, !downstream_trailers_);
+      // The buffered body may be sent again, so we send a buffer which shares its slices.
+      Buffer::OwnedImpl copy;
+      copy.addShared(*callbacks_->decodingBuffer());
+      request->encodeData(copy, !downstream_trailers_);
     }
 
     if (downstream_trailers_) {
-      upstream_request_->encodeTrailers(*downstream_trailers_);
+      request->encodeTrailers(*downstream_trailers_);
     }
 
-    upstream_request_->setupPerTryTimeout();
+    request->setupPerTryTimeout();
   }
 }
 
@@ -769,6 +915,7 @@ void Filter::UpstreamRequest::decodeHeaders(Http::HeaderMapPtr&& headers, bool e
   upstream_headers_ = headers.get();
   const uint64_t response_code = Http::Utility::getResponseStatus(*headers);
   request_info_.response_code_.value(static_cast<uint32_t>(response_code));
+  parent_.onUpstreamRequestHeaders(*this);
   parent_.onUpstreamHeaders(response_code, std::move(headers), end_stream);
 }
 
@@ -832,7 +979,8 @@ void Filter::UpstreamRequest::onResetStream(Http::StreamResetReason reason) {
   clearRequestEncoder();
   if (!calling_encode_headers_) {
     request_info_.setResponseFlag(parent_.streamResetReasonToResponseFlag(reason));
-    parent_.onUpstreamReset(UpstreamResetType::Reset, Optional<Http::StreamResetReason>(reason));
+    parent_.onUpstreamRequestReset(*this, UpstreamResetType::Reset,
+                                   Optional<Http::StreamResetReason>(reason));
   } else {
     deferred_reset_reason_ = reason;
   }
@@ -870,8 +1018,9 @@ void Filter::UpstreamRequest::onPerTryTimeout() {
   }
   resetStream();
   request_info_.setResponseFlag(Http::AccessLog::ResponseFlag::UpstreamRequestTimeout);
-  parent_.onUpstreamReset(UpstreamResetType::PerTryTimeout,
-                          Optional<Http::StreamResetReason>(Http::StreamResetReason::LocalReset));
+  parent_.onUpstreamRequestReset(
+      *this, UpstreamResetType::PerTryTimeout,
+      Optional<Http::StreamResetReason>(Http::StreamResetReason::LocalReset));
 }
 
 void Filter::UpstreamRequest::onPoolFailure(Http::ConnectionPool::PoolFailureReason reason,
@@ -17,6 +17,7 @@
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/buffer/watermark_buffer.h"
+#include "common/common/free_list.h"
 #include "common/common/hash.h"
 #include "common/common/hex.h"
 #include "common/common/logger.h"
@@ -203,6 +204,13 @@ private:
     UpstreamRequest(Filter& parent, Http::ConnectionPool::Instance& pool);
     ~UpstreamRequest();
 
+    // Every upstream attempt creates a request, so they are recycled through a per-thread free
+    // list.
+    static void* operator new(size_t size) { return FreeList<UpstreamRequest>::allocate(size); }
+    static void operator delete(void* p, size_t size) {
+      FreeList<UpstreamRequest>::release(p, size);
+    }
+
     void encodeHeaders(bool end_stream);
     void encodeData(Buffer::Instance& data, bool end_stream);
     void encodeTrailers(const Http::HeaderMap& trailers);
@@ -289,6 +297,12 @@ private:
   void chargeUpstreamCode(Http::Code code, Upstream::HostDescriptionConstSharedPtr upstream_host,
                           bool dropped);
   void cleanup();
+  void maybeSetupHedge();
+  void onHedgeTimeout();
+  void onUpstreamRequestHeaders(UpstreamRequest& request);
+  void onUpstreamRequestReset(UpstreamRequest& request, UpstreamResetType type,
+                              const Optional<Http::StreamResetReason>& reset_reason);
+  void sendBufferedRequest(UpstreamRequestPtr& request, Http::ConnectionPool::Instance& conn_pool);
   virtual RetryStatePtr createRetryState(const RetryPolicy& policy,
                                          Http::HeaderMap& request_headers,
                                          const Upstream::ClusterInfo& cluster,
@@ -296,6 +310,7 @@ private:
                                          Event::Dispatcher& dispatcher,
                                          Upstream::ResourcePriority priority) PURE;
   Http::ConnectionPool::Instance* getConnPool();
+  Upstream::ThreadLocalCluster* threadLocalCluster();
   void maybeDoShadowing();
   void onRequestComplete();
   void onResponseTimeout();
@@ -318,17 +333,29 @@ private:
   RouteConstSharedPtr route_;
   const RouteEntry* route_entry_{};
   Upstream::ClusterInfoConstSharedPtr cluster_;
+  // The thread local cluster of the route, kept across callbacks while the cluster manager
+  // generation it was found in is current. @see Upstream::ClusterManager::threadLocalGeneration().
+  Upstream::ThreadLocalCluster* thread_local_cluster_{};
+  uint64_t thread_local_cluster_generation_{};
   std::string alt_stat_prefix_;
   const VirtualCluster* request_vcluster_;
   Event::TimerPtr response_timeout_;
   FilterUtility::TimeoutData timeout_;
   Http::Code timeout_response_code_ = Http::Code::GatewayTimeout;
   UpstreamRequestPtr upstream_request_;
+  // A copy of the request sent to another host when upstream_request_ is slow to respond. The
+  // first of the two to respond becomes upstream_request_, and the other one is cancelled.
+  UpstreamRequestPtr hedged_request_;
+  Event::TimerPtr hedge_timer_;
+  bool hedged_{};
   bool grpc_request_{};
   Http::HeaderMap* downstream_headers_{};
   Http::HeaderMap* downstream_trailers_{};
   MonotonicTime downstream_request_complete_time_;
   uint32_t buffer_limit_{0};
+  // The most of the request body which is buffered to replay it on a retry. 0 means no limit
+  // other than buffer_limit_.
+  uint64_t retry_buffer_limit_{0};
   bool stream_destroyed_{};
 
   // list of cookies to add to upstream headers
@@ -11,6 +11,19 @@ namespace Router {
 
 void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& request,
                               std::chrono::milliseconds timeout) {
+  // A shadow is best effort: if the shadow cluster is out of requests, the request is dropped
+  // here rather than queued behind or failed against the cluster's own traffic.
+  Upstream::ThreadLocalCluster* shadow_cluster = cm_.get(cluster);
+  if (shadow_cluster != nullptr) {
+    Upstream::ClusterInfoConstSharedPtr info = shadow_cluster->info();
+    Upstream::ResourceManager& resources =
+        info->resourceManager(Upstream::ResourcePriority::Default);
+    if (!resources.requests().canCreate() || !resources.pendingRequests().canCreate()) {
+      info->stats().upstream_rq_shadow_overflow_.inc();
+      return;
+    }
+  }
+
   // Switch authority to add a shadow postfix. This allows upstream logging to make a more sense.
   // TODO PERF: Avoid copy.
   std::string host = request->headers().Host()->value().c_str();
@@ -0,0 +1,54 @@
+#include "common/runtime/key_registry.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Envoy {
+namespace Runtime {
+
+namespace {
+
+struct Registry {
+  std::mutex lock_;
+  // A deque never moves its elements, so references to registered keys stay valid.
+  std::deque<Key> keys_;
+  std::unordered_map<std::string, const Key*> keys_by_name_;
+};
+
+Registry& getRegistry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+} // namespace
+
+const Key& KeyRegistry::registerKey(const std::string& name) {
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> guard(registry.lock_);
+  auto existing = registry.keys_by_name_.find(name);
+  if (existing != registry.keys_by_name_.end()) {
+    return *existing->second;
+  }
+
+  registry.keys_.emplace_back(name, registry.keys_.size());
+  registry.keys_by_name_[name] = &registry.keys_.back();
+  return registry.keys_.back();
+}
+
+std::vector<std::string> KeyRegistry::keys() {
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> guard(registry.lock_);
+  std::vector<std::string> names;
+  names.reserve(registry.keys_.size());
+  for (const Key& key : registry.keys_) {
+    names.push_back(key.name_);
+  }
+
+  return names;
+}
+
+} // namespace Runtime
+} // namespace Envoy
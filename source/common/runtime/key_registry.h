@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "envoy/runtime/runtime.h"
+
+namespace Envoy {
+namespace Runtime {
+
+/**
+ * Process wide registry of runtime keys. Each distinct name is given the next index, and the
+ * returned key lives for the rest of the process. Snapshots copy the values of all the keys which
+ * are registered when they are loaded into an array indexed by key.
+ */
+class KeyRegistry {
+public:
+  /**
+   * Register a key, or return the key which was already registered under the same name. This is
+   * thread safe, but is meant to be called while loading configuration rather than per request.
+   * @param name supplies the name of the key.
+   * @return const Key& the registered key.
+   */
+  static const Key& registerKey(const std::string& name);
+
+  /**
+   * @return std::vector<std::string> the names of all registered keys, ordered by index.
+   */
+  static std::vector<std::string> keys();
+};
+
+} // namespace Runtime
+} // namespace Envoy
@@ -3,9 +3,13 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <random>
 #include <string>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/stats/stats.h"
@@ -14,14 +18,65 @@
 #include "common/common/assert.h"
 #include "common/common/utility.h"
 #include "common/filesystem/filesystem_impl.h"
+#include "common/runtime/key_registry.h"
 
 #include "fmt/format.h"
 #include "openssl/rand.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define ENVOY_RUNTIME_UUID_SSSE3
+#endif
+
 namespace Envoy {
 namespace Runtime {
 
-const size_t RandomGeneratorImpl::UUID_LENGTH = 36;
+const size_t RandomGenerator::UUID_LENGTH;
+
+static const Key& ReloadQuietPeriodMs = KeyRegistry::registerKey("runtime.reload_quiet_period_ms");
+
+namespace {
+
+#ifdef ENVOY_RUNTIME_UUID_SSSE3
+bool cpuHasSsse3() {
+  static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+  return has_ssse3;
+}
+
+/**
+ * Formats 16 bytes as 32 hex digits, looking up the digits of all the nibbles with PSHUFB.
+ */
+__attribute__((target("ssse3"))) void hexDigitsSsse3(const uint8_t* data, char* digits) {
+  const __m128i hex = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b',
+                                    'c', 'd', 'e', 'f');
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  const __m128i high = _mm_shuffle_epi8(hex, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+  const __m128i low = _mm_shuffle_epi8(hex, _mm_and_si128(bytes, mask));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(digits), _mm_unpacklo_epi8(high, low));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + 16), _mm_unpackhi_epi8(high, low));
+}
+#endif
+
+/**
+ * Formats 16 bytes as 32 hex digits.
+ */
+void hexDigits(const uint8_t* data, char* digits) {
+#ifdef ENVOY_RUNTIME_UUID_SSSE3
+  if (cpuHasSsse3()) {
+    hexDigitsSsse3(data, digits);
+    return;
+  }
+#endif
+
+  static const char* const hex = "0123456789abcdef";
+  for (uint8_t i = 0; i < 16; i++) {
+    digits[2 * i] = hex[data[i] >> 4];
+    digits[2 * i + 1] = hex[data[i] & 0x0f];
+  }
+}
+
+} // namespace
 
 uint64_t RandomGeneratorImpl::random() {
   // Prefetch 256 * sizeof(uint64_t) bytes of randomness. buffered_idx is initialized to 256,
@@ -62,6 +117,12 @@ uint64_t RandomGeneratorImpl::random() {
 }
 
 std::string RandomGeneratorImpl::uuid() {
+  std::string out(UUID_LENGTH, '\0');
+  uuid(&out[0]);
+  return out;
+}
+
+void RandomGeneratorImpl::uuid(char* out) {
   // Prefetch 2048 bytes of randomness. buffered_idx is initialized to sizeof(buffered),
   // i.e. out-of-range value, so the buffer will be filled with randomness on the first
   // call to this function.
@@ -103,58 +164,28 @@ std::string RandomGeneratorImpl::uuid() {
   rand[8] = (rand[8] & 0x3f) | 0x80; // UUID variant 1 (RFC4122)
 
   // Convert UUID to a string representation, e.g. a121e9e1-feae-4136-9e0e-6fac343d56c9.
-  static const char* const hex = "0123456789abcdef";
-  char uuid[UUID_LENGTH];
-
-  for (uint8_t i = 0; i < 4; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i] = hex[d >> 4];
-    uuid[2 * i + 1] = hex[d & 0x0f];
-  }
-
-  uuid[8] = '-';
-
-  for (uint8_t i = 4; i < 6; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 1] = hex[d >> 4];
-    uuid[2 * i + 2] = hex[d & 0x0f];
-  }
-
-  uuid[13] = '-';
-
-  for (uint8_t i = 6; i < 8; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 2] = hex[d >> 4];
-    uuid[2 * i + 3] = hex[d & 0x0f];
-  }
-
-  uuid[18] = '-';
-
-  for (uint8_t i = 8; i < 10; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 3] = hex[d >> 4];
-    uuid[2 * i + 4] = hex[d & 0x0f];
-  }
-
-  uuid[23] = '-';
-
-  for (uint8_t i = 10; i < 16; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 4] = hex[d >> 4];
-    uuid[2 * i + 5] = hex[d & 0x0f];
-  }
-
-  return std::string(uuid, UUID_LENGTH);
+  char digits[32];
+  hexDigits(rand, digits);
+
+  memcpy(out, digits, 8);
+  out[8] = '-';
+  memcpy(out + 9, digits + 8, 4);
+  out[13] = '-';
+  memcpy(out + 14, digits + 12, 4);
+  out[18] = '-';
+  memcpy(out + 19, digits + 16, 4);
+  out[23] = '-';
+  memcpy(out + 24, digits + 20, 12);
 }
 
 SnapshotImpl::SnapshotImpl(const std::string& root_path, const std::string& override_path,
                            RuntimeStats& stats, RandomGenerator& generator,
-                           Api::OsSysCalls& os_sys_calls)
-    : generator_(generator), os_sys_calls_(os_sys_calls) {
+                           Api::OsSysCalls& os_sys_calls, const SnapshotImpl* previous)
+    : generator_(generator), os_sys_calls_(os_sys_calls), generation_(nextGeneration()) {
   try {
-    walkDirectory(root_path, "");
+    loadLayer(root_path, previous);
     if (Filesystem::directoryExists(override_path)) {
-      walkDirectory(override_path, "");
+      loadLayer(override_path, previous);
       stats.override_dir_exists_.inc();
     } else {
       stats.override_dir_not_exists_.inc();
@@ -166,28 +197,112 @@ SnapshotImpl::SnapshotImpl(const std::string& root_path, const std::string& over
     ENVOY_LOG(debug, "error creating runtime snapshot: {}", e.what());
   }
 
-  stats.num_keys_.set(values_.size());
+  uint64_t num_keys = 0;
+  for (size_t i = 0; i < layers_.size(); i++) {
+    for (const auto& value : *layers_[i]) {
+      // Only count the keys which are not overridden by a later layer.
+      bool overridden = false;
+      for (size_t j = i + 1; j < layers_.size() && !overridden; j++) {
+        overridden = layers_[j]->count(value.first) > 0;
+      }
+      if (!overridden) {
+        num_keys++;
+      }
+    }
+  }
+  stats.num_keys_.set(num_keys);
+
+  const std::vector<std::string> keys = KeyRegistry::keys();
+  keyed_entries_.reserve(keys.size());
+  for (const std::string& key : keys) {
+    keyed_entries_.push_back(find(key));
+  }
+}
+
+const SnapshotImpl::Entry* SnapshotImpl::find(const std::string& key) const {
+  for (auto layer = layers_.rbegin(); layer != layers_.rend(); layer++) {
+    auto entry = (*layer)->find(key);
+    if (entry != (*layer)->end()) {
+      return &entry->second;
+    }
+  }
+
+  return nullptr;
 }
 
 const std::string& SnapshotImpl::get(const std::string& key) const {
-  auto entry = values_.find(key);
-  if (entry == values_.end()) {
+  const Entry* entry = find(key);
+  if (entry == nullptr) {
     return EMPTY_STRING;
   } else {
-    return entry->second.string_value_;
+    return entry->string_value_;
   }
 }
 
 uint64_t SnapshotImpl::getInteger(const std::string& key, uint64_t default_value) const {
-  auto entry = values_.find(key);
-  if (entry == values_.end() || !entry->second.uint_value_.valid()) {
+  const Entry* entry = find(key);
+  if (entry == nullptr || !entry->uint_value_.valid()) {
+    return default_value;
+  } else {
+    return entry->uint_value_.value();
+  }
+}
+
+uint64_t SnapshotImpl::getInteger(const Key& key, uint64_t default_value) const {
+  if (key.index_ >= keyed_entries_.size()) {
+    return getInteger(key.name_, default_value);
+  }
+
+  const Entry* entry = keyed_entries_[key.index_];
+  if (entry == nullptr || !entry->uint_value_.valid()) {
     return default_value;
   } else {
-    return entry->second.uint_value_.value();
+    return entry->uint_value_.value();
   }
 }
 
-void SnapshotImpl::walkDirectory(const std::string& path, const std::string& prefix) {
+bool SnapshotImpl::hasKeyWithPrefix(const std::string& prefix) const {
+  for (const LayerConstSharedPtr& layer : layers_) {
+    for (const auto& entry : *layer) {
+      if (entry.first.compare(0, prefix.size(), prefix) == 0) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+uint64_t SnapshotImpl::nextGeneration() {
+  // Generation 0 is left to the null snapshot.
+  static std::atomic<uint64_t> next_generation{1};
+  return next_generation++;
+}
+
+void SnapshotImpl::loadLayer(const std::string& path, const SnapshotImpl* previous) {
+  const size_t index = layers_.size();
+  const Layer* previous_layer = nullptr;
+  if (previous != nullptr && index < previous->layers_.size()) {
+    previous_layer = previous->layers_[index].get();
+  }
+
+  // The layer is added before it is walked so that it is kept, like the rest of the snapshot, if
+  // loading fails part of the way through.
+  std::shared_ptr<Layer> layer = std::make_shared<Layer>();
+  layers_.push_back(layer);
+  uint64_t reused = 0;
+  walkDirectory(path, "", *layer, previous_layer, reused);
+  ENVOY_LOG(debug, "loaded {} runtime entries from {}, {} of them unchanged", layer->size(), path,
+            reused);
+
+  if (previous_layer != nullptr && reused == layer->size() &&
+      reused == previous_layer->size()) {
+    layers_[index] = previous->layers_[index];
+  }
+}
+
+void SnapshotImpl::walkDirectory(const std::string& path, const std::string& prefix,
+                                 Layer& layer, const Layer* previous_layer, uint64_t& reused) {
   ENVOY_LOG(debug, "walking directory: {}", path);
   Directory current_dir(path);
   while (true) {
@@ -217,13 +332,33 @@ void SnapshotImpl::walkDirectory(const std::string& path, const std::string& pre
 
     if (S_ISDIR(stat_result.st_mode) && std::string(entry->d_name) != "." &&
         std::string(entry->d_name) != "..") {
-      walkDirectory(full_path, full_prefix);
+      walkDirectory(full_path, full_prefix, layer, previous_layer, reused);
     } else if (S_ISREG(stat_result.st_mode)) {
+      if (previous_layer != nullptr) {
+        // A file which is still the same file, with the same size and modification time, is assumed
+        // to be unchanged. This keeps a reload of a large tree which mostly links to the files of
+        // the previous tree from reading every file again.
+        auto previous_entry = previous_layer->find(full_prefix);
+        if (previous_entry != previous_layer->end() &&
+            previous_entry->second.device_ == stat_result.st_dev &&
+            previous_entry->second.inode_ == stat_result.st_ino &&
+            previous_entry->second.modified_ == stat_result.st_mtime &&
+            previous_entry->second.size_ == stat_result.st_size) {
+          layer[full_prefix] = previous_entry->second;
+          reused++;
+          continue;
+        }
+      }
+
       // Suck the file into a string. This is not very efficient but it should be good enough
       // for small files. Also, as noted elsewhere, none of this is non-blocking which could
       // theoretically lead to issues.
       ENVOY_LOG(debug, "reading file: {}", full_path);
       Entry entry;
+      entry.device_ = stat_result.st_dev;
+      entry.inode_ = stat_result.st_ino;
+      entry.modified_ = stat_result.st_mtime;
+      entry.size_ = stat_result.st_size;
       entry.string_value_ = Filesystem::fileReadToEnd(full_path);
       StringUtil::rtrim(entry.string_value_);
 
@@ -234,7 +369,7 @@ void SnapshotImpl::walkDirectory(const std::string& path, const std::string& pre
         entry.uint_value_.value(converted);
       }
 
-      values_[full_prefix] = entry;
+      layer[full_prefix] = entry;
     }
   }
 }
@@ -243,12 +378,13 @@ LoaderImpl::LoaderImpl(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator
                        const std::string& root_symlink_path, const std::string& subdir,
                        const std::string& override_dir, Stats::Store& store,
                        RandomGenerator& generator, Api::OsSysCallsPtr os_sys_calls)
-    : watcher_(dispatcher.createFilesystemWatcher()), tls_(tls.allocateSlot()),
+    : dispatcher_(dispatcher), watcher_(dispatcher.createFilesystemWatcher()),
+      tls_(tls.allocateSlot()),
       generator_(generator), root_path_(root_symlink_path + "/" + subdir),
       override_path_(root_symlink_path + "/" + override_dir), stats_(generateStats(store)),
       os_sys_calls_(std::move(os_sys_calls)) {
   watcher_->addWatch(root_symlink_path, Filesystem::Watcher::Events::MovedTo,
-                     [this](uint32_t) -> void { onSymlinkSwap(); });
+                     [this](uint32_t) -> void { onSymlinkSwapEvent(); });
 
   onSymlinkSwap();
 }
@@ -260,16 +396,36 @@ RuntimeStats LoaderImpl::generateStats(Stats::Store& store) {
   return stats;
 }
 
+void LoaderImpl::onSymlinkSwapEvent() {
+  // Tools which deploy runtime trees often swap the link several times in a row. With a quiet
+  // period, the tree is loaded once the link has been left alone for that long.
+  const uint64_t quiet_period_ms = current_snapshot_->getInteger(ReloadQuietPeriodMs, 0);
+  if (quiet_period_ms == 0) {
+    onSymlinkSwap();
+    return;
+  }
+
+  if (!reload_timer_) {
+    reload_timer_ = dispatcher_.createTimer([this]() -> void { onSymlinkSwap(); });
+  }
+  if (reload_pending_) {
+    stats_.load_coalesced_.inc();
+  }
+  reload_pending_ = true;
+  reload_timer_->enableTimer(std::chrono::milliseconds(quiet_period_ms));
+}
+
 void LoaderImpl::onSymlinkSwap() {
-  current_snapshot_.reset(
-      new SnapshotImpl(root_path_, override_path_, stats_, generator_, *os_sys_calls_));
+  reload_pending_ = false;
+  current_snapshot_.reset(new SnapshotImpl(root_path_, override_path_, stats_, generator_,
+                                           *os_sys_calls_, current_snapshot_.get()));
   ThreadLocal::ThreadLocalObjectSharedPtr ptr_copy = current_snapshot_;
   tls_->set([ptr_copy](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return ptr_copy;
   });
 }
 
-Snapshot& LoaderImpl::snapshot() { return tls_->getTyped<Snapshot>(); }
+Snapshot& LoaderImpl::snapshot() { return tls_->getTyped<SnapshotImpl>(); }
 
 } // namespace Runtime
 } // namespace Envoy
@@ -1,15 +1,19 @@
 #pragma once
 
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/common/exception.h"
 #include "envoy/common/optional.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/thread_local/thread_local.h"
@@ -32,8 +36,7 @@ public:
   // Runtime::RandomGenerator
   uint64_t random() override;
   std::string uuid() override;
-
-  static const size_t UUID_LENGTH;
+  void uuid(char* out) override;
 };
 
 /**
@@ -45,6 +48,7 @@ public:
   COUNTER(override_dir_not_exists)                                                                 \
   COUNTER(override_dir_exists)                                                                     \
   COUNTER(load_success)                                                                            \
+  COUNTER(load_coalesced)                                                                          \
   GAUGE  (num_keys)
 // clang-format on
 
@@ -56,32 +60,27 @@ struct RuntimeStats {
 };
 
 /**
- * Implementation of Snapshot that reads from disk.
+ * Implementation of Snapshot that reads from disk. The root and override directories are loaded
+ * into separate layers, and a lookup checks the override layer first. A snapshot can be loaded
+ * from the previous one, in which case files which did not change are not read again and a layer
+ * without any change is shared with the previous snapshot.
  */
 class SnapshotImpl : public Snapshot,
                      public ThreadLocal::ThreadLocalObject,
                      Logger::Loggable<Logger::Id::runtime> {
 public:
   SnapshotImpl(const std::string& root_path, const std::string& override_path, RuntimeStats& stats,
-               RandomGenerator& generator, Api::OsSysCalls& os_sys_calls);
+               RandomGenerator& generator, Api::OsSysCalls& os_sys_calls,
+               const SnapshotImpl* previous = nullptr);
 
   // Runtime::Snapshot
   bool featureEnabled(const std::string& key, uint64_t default_value, uint64_t random_value,
                       uint16_t num_buckets) const override {
-    return random_value % static_cast<uint64_t>(num_buckets) <
-           std::min(getInteger(key, default_value), static_cast<uint64_t>(num_buckets));
+    return sampled(getInteger(key, default_value), random_value, num_buckets);
   }
 
   bool featureEnabled(const std::string& key, uint64_t default_value) const override {
-    // Avoid PNRG if we know we don't need it.
-    uint64_t cutoff = std::min(getInteger(key, default_value), static_cast<uint64_t>(100));
-    if (cutoff == 0) {
-      return false;
-    } else if (cutoff == 100) {
-      return true;
-    } else {
-      return generator_.random() % 100 < cutoff;
-    }
+    return enabled(getInteger(key, default_value));
   }
 
   bool featureEnabled(const std::string& key, uint64_t default_value,
@@ -92,6 +91,24 @@ public:
   const std::string& get(const std::string& key) const override;
   uint64_t getInteger(const std::string&, uint64_t default_value) const override;
 
+  bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                      uint16_t num_buckets) const override {
+    return sampled(getInteger(key, default_value), random_value, num_buckets);
+  }
+
+  bool featureEnabled(const Key& key, uint64_t default_value) const override {
+    return enabled(getInteger(key, default_value));
+  }
+
+  bool featureEnabled(const Key& key, uint64_t default_value,
+                      uint64_t random_value) const override {
+    return featureEnabled(key, default_value, random_value, 100);
+  }
+
+  uint64_t getInteger(const Key& key, uint64_t default_value) const override;
+  uint64_t generation() const override { return generation_; }
+  bool hasKeyWithPrefix(const std::string& prefix) const override;
+
 private:
   struct Directory {
     Directory(const std::string& path) {
@@ -109,13 +126,47 @@ private:
   struct Entry {
     std::string string_value_;
     Optional<uint64_t> uint_value_;
+    // Identifies the file the entry was read from, to tell whether it changed since.
+    dev_t device_{};
+    ino_t inode_{};
+    time_t modified_{};
+    off_t size_{};
   };
 
-  void walkDirectory(const std::string& path, const std::string& prefix);
+  typedef std::unordered_map<std::string, Entry> Layer;
+  typedef std::shared_ptr<const Layer> LayerConstSharedPtr;
+
+  static bool sampled(uint64_t value, uint64_t random_value, uint16_t num_buckets) {
+    return random_value % static_cast<uint64_t>(num_buckets) <
+           std::min(value, static_cast<uint64_t>(num_buckets));
+  }
 
-  std::unordered_map<std::string, Entry> values_;
+  bool enabled(uint64_t value) const {
+    // Avoid PNRG if we know we don't need it.
+    uint64_t cutoff = std::min(value, static_cast<uint64_t>(100));
+    if (cutoff == 0) {
+      return false;
+    } else if (cutoff == 100) {
+      return true;
+    } else {
+      return generator_.random() % 100 < cutoff;
+    }
+  }
+
+  static uint64_t nextGeneration();
+  const Entry* find(const std::string& key) const;
+  void loadLayer(const std::string& path, const SnapshotImpl* previous);
+  void walkDirectory(const std::string& path, const std::string& prefix, Layer& layer,
+                     const Layer* previous_layer, uint64_t& reused);
+
+  // The root layer followed by the override layer, if the override directory exists.
+  std::vector<LayerConstSharedPtr> layers_;
+  // The entry of each registered key indexed by key, or nullptr if the key has no value. Keys
+  // registered after the snapshot was loaded are past the end and looked up by name instead.
+  std::vector<const Entry*> keyed_entries_;
   RandomGenerator& generator_;
   Api::OsSysCalls& os_sys_calls_;
+  const uint64_t generation_;
 };
 
 /**
@@ -136,9 +187,13 @@ public:
 
 private:
   RuntimeStats generateStats(Stats::Store& store);
+  void onSymlinkSwapEvent();
   void onSymlinkSwap();
 
+  Event::Dispatcher& dispatcher_;
   Filesystem::WatcherPtr watcher_;
+  Event::TimerPtr reload_timer_;
+  bool reload_pending_{};
   ThreadLocal::SlotPtr tls_;
   RandomGenerator& generator_;
   std::string root_path_;
@@ -190,6 +245,27 @@ private:
       return default_value;
     }
 
+    bool featureEnabled(const Key& key, uint64_t default_value) const override {
+      return featureEnabled(key.name_, default_value);
+    }
+
+    bool featureEnabled(const Key& key, uint64_t default_value,
+                        uint64_t random_value) const override {
+      return featureEnabled(key.name_, default_value, random_value);
+    }
+
+    bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                        uint16_t num_buckets) const override {
+      return featureEnabled(key.name_, default_value, random_value, num_buckets);
+    }
+
+    uint64_t getInteger(const Key&, uint64_t default_value) const override {
+      return default_value;
+    }
+
+    uint64_t generation() const override { return 0; }
+    bool hasKeyWithPrefix(const std::string&) const override { return false; }
+
     RandomGenerator& generator_;
   };
 
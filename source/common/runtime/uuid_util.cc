@@ -3,26 +3,37 @@
 #include <cstdint>
 #include <string>
 
-#include "common/common/utility.h"
-#include "common/runtime/runtime_impl.h"
+#include "envoy/runtime/runtime.h"
 
 namespace Envoy {
-bool UuidUtils::uuidModBy(const std::string& uuid, uint16_t& out, uint16_t mod) {
-  if (uuid.length() < 8) {
+bool UuidUtils::uuidModBy(const char* uuid, size_t length, uint16_t& out, uint16_t mod) {
+  if (length < 8) {
     return false;
   }
 
-  uint64_t value;
-  if (!StringUtil::atoul(uuid.substr(0, 8).c_str(), value, 16)) {
-    return false;
+  // The first 8 hex digits are parsed in place, since this runs for every sampled request.
+  uint32_t value = 0;
+  for (size_t i = 0; i < 8; i++) {
+    const char c = uuid[i];
+    uint32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    value = (value << 4) | digit;
   }
 
   out = value % mod;
   return true;
 }
 
-UuidTraceStatus UuidUtils::isTraceableUuid(const std::string& uuid) {
-  if (uuid.length() != Runtime::RandomGeneratorImpl::UUID_LENGTH) {
+UuidTraceStatus UuidUtils::isTraceableUuid(const char* uuid, size_t length) {
+  if (length != Runtime::RandomGenerator::UUID_LENGTH) {
     return UuidTraceStatus::NoTrace;
   }
 
@@ -38,8 +49,8 @@ UuidTraceStatus UuidUtils::isTraceableUuid(const std::string& uuid) {
   }
 }
 
-bool UuidUtils::setTraceableUuid(std::string& uuid, UuidTraceStatus trace_status) {
-  if (uuid.length() != Runtime::RandomGeneratorImpl::UUID_LENGTH) {
+bool UuidUtils::setTraceableUuid(char* uuid, size_t length, UuidTraceStatus trace_status) {
+  if (length != Runtime::RandomGenerator::UUID_LENGTH) {
     return false;
   }
 
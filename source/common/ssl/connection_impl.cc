@@ -1,6 +1,11 @@
 #include "common/ssl/connection_impl.h"
 
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -12,6 +17,23 @@
 #include "openssl/err.h"
 #include "openssl/x509v3.h"
 
+// Kernel TLS needs the headers of Linux 4.13 or later.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#define ENVOY_KERNEL_TLS
+#endif
+#endif
+
+#ifdef ENVOY_KERNEL_TLS
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
 namespace Envoy {
 namespace Ssl {
 
@@ -47,16 +69,108 @@ ConnectionImpl::ConnectionImpl(Event::DispatcherImpl& dispatcher, int fd,
   } else {
     ASSERT(state == InitialState::Server);
     SSL_set_accept_state(ssl_.get());
+    if (ctx_.asyncPrivateKeyEnabled()) {
+      SSL_set_ex_data(ssl_.get(), sslConnectionIndex(), this);
+      SSL_set_private_key_method(ssl_.get(), &asyncPrivateKeyMethod());
+    }
   }
 }
 
 ConnectionImpl::~ConnectionImpl() {
+  cancelPrivateKeyOperation();
   // Filters may care about whether this connection is an SSL connection or not in their
   // destructors for stat reasons. We destroy the filters here vs. the base class destructors
   // to make sure they have the chance to still inspect SSL specific data via virtual functions.
   filter_manager_.destroyFilters();
 }
 
+int ConnectionImpl::sslConnectionIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, []() -> int {
+    int ssl_connection_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    RELEASE_ASSERT(ssl_connection_index >= 0);
+    return ssl_connection_index;
+  }());
+}
+
+const SSL_PRIVATE_KEY_METHOD& ConnectionImpl::asyncPrivateKeyMethod() {
+  CONSTRUCT_ON_FIRST_USE(SSL_PRIVATE_KEY_METHOD, []() -> SSL_PRIVATE_KEY_METHOD {
+    SSL_PRIVATE_KEY_METHOD method{};
+    method.sign = [](SSL* ssl, uint8_t*, size_t*, size_t, uint16_t signature_algorithm,
+                     const uint8_t* in, size_t in_len) -> ssl_private_key_result_t {
+      return static_cast<ConnectionImpl*>(SSL_get_ex_data(ssl, sslConnectionIndex()))
+          ->startPrivateKeyOperation(PrivateKeyOperation::Type::Sign, signature_algorithm, in,
+                                     in_len);
+    };
+    method.decrypt = [](SSL* ssl, uint8_t*, size_t*, size_t, const uint8_t* in,
+                        size_t in_len) -> ssl_private_key_result_t {
+      return static_cast<ConnectionImpl*>(SSL_get_ex_data(ssl, sslConnectionIndex()))
+          ->startPrivateKeyOperation(PrivateKeyOperation::Type::Decrypt, 0, in, in_len);
+    };
+    method.complete = [](SSL* ssl, uint8_t* out, size_t* out_len,
+                         size_t max_out) -> ssl_private_key_result_t {
+      return static_cast<ConnectionImpl*>(SSL_get_ex_data(ssl, sslConnectionIndex()))
+          ->completePrivateKeyOperation(out, out_len, max_out);
+    };
+    return method;
+  }());
+}
+
+ssl_private_key_result_t ConnectionImpl::startPrivateKeyOperation(PrivateKeyOperation::Type type,
+                                                                  uint16_t signature_algorithm,
+                                                                  const uint8_t* in,
+                                                                  size_t in_len) {
+  ASSERT(private_key_operation_ == nullptr);
+  EVP_PKEY* key = SSL_get_privatekey(ssl_.get());
+  if (key == nullptr) {
+    return ssl_private_key_failure;
+  }
+
+  // The operation holds a reference to the key as it may outlive the connection and the context.
+  EVP_PKEY_up_ref(key);
+  private_key_operation_ = std::make_shared<PrivateKeyOperation>(
+      type, bssl::UniquePtr<EVP_PKEY>(key), signature_algorithm, in, in_len, dispatcher(),
+      [this]() -> void {
+        // Carry on with the handshake on the next run of the event loop.
+        ENVOY_CONN_LOG(debug, "private key operation done", *this);
+        setWriteReady();
+      });
+  ctx_.privateKeyThreadPool().submit(private_key_operation_);
+  ctx_.stats().async_private_key_.inc();
+  return ssl_private_key_retry;
+}
+
+ssl_private_key_result_t ConnectionImpl::completePrivateKeyOperation(uint8_t* out,
+                                                                     size_t* out_len,
+                                                                     size_t max_out) {
+  ASSERT(private_key_operation_ != nullptr);
+  switch (private_key_operation_->status()) {
+  case PrivateKeyOperation::Status::Pending:
+    return ssl_private_key_retry;
+  case PrivateKeyOperation::Status::Failed:
+    private_key_operation_.reset();
+    return ssl_private_key_failure;
+  case PrivateKeyOperation::Status::Succeeded:
+    break;
+  }
+
+  const std::vector<uint8_t>& output = private_key_operation_->output();
+  if (output.size() > max_out) {
+    private_key_operation_.reset();
+    return ssl_private_key_failure;
+  }
+  memcpy(out, output.data(), output.size());
+  *out_len = output.size();
+  private_key_operation_.reset();
+  return ssl_private_key_success;
+}
+
+void ConnectionImpl::cancelPrivateKeyOperation() {
+  if (private_key_operation_ != nullptr) {
+    private_key_operation_->cancel();
+    private_key_operation_.reset();
+  }
+}
+
 Network::ConnectionImpl::IoResult ConnectionImpl::doReadFromSocket() {
   if (!handshake_complete_) {
     PostIoAction action = doHandshake();
@@ -118,6 +232,11 @@ Network::ConnectionImpl::PostIoAction ConnectionImpl::doHandshake() {
     ENVOY_CONN_LOG(debug, "handshake complete", *this);
     handshake_complete_ = true;
     ctx_.logHandshake(ssl_.get());
+    if (ctx_.kernelTlsTxEnabled() && enableKernelTlsTx()) {
+      ENVOY_CONN_LOG(debug, "kernel TLS transmit enabled", *this);
+      kernel_tls_tx_ = true;
+      ctx_.stats().kernel_tls_tx_.inc();
+    }
     raiseEvent(Network::ConnectionEvent::Connected);
 
     // It's possible that we closed during the handshake callback.
@@ -128,6 +247,8 @@ Network::ConnectionImpl::PostIoAction ConnectionImpl::doHandshake() {
     switch (err) {
     case SSL_ERROR_WANT_READ:
     case SSL_ERROR_WANT_WRITE:
+    // The handshake carries on once the private key operation is done.
+    case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
       return PostIoAction::KeepOpen;
     default:
       drainErrorQueue();
@@ -136,6 +257,96 @@ Network::ConnectionImpl::PostIoAction ConnectionImpl::doHandshake() {
   }
 }
 
+bool ConnectionImpl::enableKernelTlsTx() {
+#ifdef ENVOY_KERNEL_TLS
+  // The kernel only implements TLS 1.2 with AES-128-GCM.
+  const uint32_t cipher = SSL_CIPHER_get_id(SSL_get_current_cipher(ssl_.get()));
+  if (SSL_version(ssl_.get()) != TLS1_2_VERSION ||
+      (cipher != TLS1_CK_ECDHE_RSA_WITH_AES_128_GCM_SHA256 &&
+       cipher != TLS1_CK_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256 &&
+       cipher != TLS1_CK_RSA_WITH_AES_128_GCM_SHA256)) {
+    return false;
+  }
+
+  // For AES-GCM the key block is the client and server write keys followed by the client and
+  // server salts, the implicit parts of their nonces.
+  const size_t key_size = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+  const size_t salt_size = TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+  uint8_t key_block[2 * (key_size + salt_size)];
+  if (SSL_get_key_block_len(ssl_.get()) != sizeof(key_block) ||
+      !SSL_generate_key_block(ssl_.get(), key_block, sizeof(key_block))) {
+    drainErrorQueue();
+    return false;
+  }
+
+  const bool server = SSL_is_server(ssl_.get());
+  tls12_crypto_info_aes_gcm_128 crypto_info;
+  memset(&crypto_info, 0, sizeof(crypto_info));
+  crypto_info.info.version = TLS_1_2_VERSION;
+  crypto_info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+  memcpy(crypto_info.key, key_block + (server ? key_size : 0), key_size);
+  memcpy(crypto_info.salt, key_block + 2 * key_size + (server ? salt_size : 0), salt_size);
+  OPENSSL_cleanse(key_block, sizeof(key_block));
+
+  // BoringSSL uses the sequence number of a record as the explicit part of its nonce, and the
+  // kernel increments both from where BoringSSL left off.
+  uint64_t sequence = SSL_get_write_sequence(ssl_.get());
+  for (size_t i = TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE; i > 0; i--) {
+    crypto_info.rec_seq[i - 1] = sequence & 0xff;
+    sequence >>= 8;
+  }
+  memcpy(crypto_info.iv, crypto_info.rec_seq, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+
+  // If attaching the ULP works but setting the keys does not, the socket keeps sending plaintext
+  // as is and BoringSSL carries on encrypting.
+  bool enabled = setsockopt(fd(), SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0 &&
+                 setsockopt(fd(), SOL_TLS, TLS_TX, &crypto_info, sizeof(crypto_info)) == 0;
+  OPENSSL_cleanse(&crypto_info, sizeof(crypto_info));
+  if (!enabled) {
+    ENVOY_CONN_LOG(debug, "kernel TLS transmit not available: {}", *this, strerror(errno));
+    return false;
+  }
+
+  // BoringSSL still decrypts what is received, but anything it writes from now on, such as an
+  // alert, would go out with stale keys. Send that to a memory BIO which is never read instead.
+  SSL_set0_wbio(ssl_.get(), BIO_new(BIO_s_mem()));
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ConnectionImpl::sendKernelTlsCloseNotify() {
+#ifdef ENVOY_KERNEL_TLS
+  // The kernel sends the data of a single sendmsg() as a record of the content type given in its
+  // control message, here a warning level close_notify alert.
+  const uint8_t record_type = 21;
+  uint8_t alert[] = {1, 0};
+  iovec iov;
+  iov.iov_base = alert;
+  iov.iov_len = sizeof(alert);
+
+  uint8_t control_buffer[CMSG_SPACE(sizeof(record_type))];
+  memset(control_buffer, 0, sizeof(control_buffer));
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control_buffer;
+  message.msg_controllen = sizeof(control_buffer);
+
+  cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+  control_message->cmsg_level = SOL_TLS;
+  control_message->cmsg_type = TLS_SET_RECORD_TYPE;
+  control_message->cmsg_len = CMSG_LEN(sizeof(record_type));
+  memcpy(CMSG_DATA(control_message), &record_type, sizeof(record_type));
+
+  const ssize_t rc = sendmsg(fd(), &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+  ENVOY_CONN_LOG(debug, "kernel TLS close notify: rc={}", *this, rc);
+  UNREFERENCED_PARAMETER(rc);
+#endif
+}
+
 void ConnectionImpl::drainErrorQueue() {
   bool saw_error = false;
   bool saw_counted_error = false;
@@ -167,6 +378,11 @@ Network::ConnectionImpl::IoResult ConnectionImpl::doWriteToSocket() {
     }
   }
 
+  if (kernel_tls_tx_) {
+    // The kernel encrypts whatever is written to the socket.
+    return Network::ConnectionImpl::doWriteToSocket();
+  }
+
   uint64_t original_buffer_length = write_buffer_->length();
   uint64_t total_bytes_written = 0;
   bool keep_writing = true;
@@ -227,16 +443,37 @@ bool ConnectionImpl::peerCertificatePresented() const {
   return cert != nullptr;
 }
 
-std::string ConnectionImpl::uriSanLocalCertificate() {
-  // The cert object is not owned.
-  X509* cert = SSL_get_certificate(ssl_.get());
-  if (!cert) {
-    return "";
+std::string ConnectionImpl::cachedCertificateValue(Optional<std::string>& cache,
+                                                   std::function<std::string()> compute) const {
+  if (cache.valid()) {
+    return cache.value();
   }
-  return getUriSanFromCertificate(cert);
+
+  std::string value = compute();
+  if (handshake_complete_) {
+    cache.value(value);
+  }
+  return value;
+}
+
+std::string ConnectionImpl::uriSanLocalCertificate() {
+  return cachedCertificateValue(uri_san_local_certificate_, [this]() -> std::string {
+    // The cert object is not owned.
+    X509* cert = SSL_get_certificate(ssl_.get());
+    if (!cert) {
+      return "";
+    }
+    return getUriSanFromCertificate(cert);
+  });
 }
 
 std::string ConnectionImpl::sha256PeerCertificateDigest() {
+  return cachedCertificateValue(sha256_peer_certificate_digest_, [this]() -> std::string {
+    return computeSha256PeerCertificateDigest();
+  });
+}
+
+std::string ConnectionImpl::computeSha256PeerCertificateDigest() const {
   bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
   if (!cert) {
     return "";
@@ -250,6 +487,12 @@ std::string ConnectionImpl::sha256PeerCertificateDigest() {
 }
 
 std::string ConnectionImpl::subjectPeerCertificate() const {
+  return cachedCertificateValue(subject_peer_certificate_, [this]() -> std::string {
+    return computeSubjectPeerCertificate();
+  });
+}
+
+std::string ConnectionImpl::computeSubjectPeerCertificate() const {
   bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
   if (!cert) {
     return "";
@@ -270,11 +513,13 @@ std::string ConnectionImpl::subjectPeerCertificate() const {
 }
 
 std::string ConnectionImpl::uriSanPeerCertificate() {
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
-  if (!cert) {
-    return "";
-  }
-  return getUriSanFromCertificate(cert.get());
+  return cachedCertificateValue(uri_san_peer_certificate_, [this]() -> std::string {
+    bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl_.get()));
+    if (!cert) {
+      return "";
+    }
+    return getUriSanFromCertificate(cert.get());
+  });
 }
 
 std::string ConnectionImpl::getUriSanFromCertificate(X509* cert) {
@@ -315,14 +560,19 @@ ClientConnectionImpl::ClientConnectionImpl(Event::DispatcherImpl& dispatcher, Co
 void ClientConnectionImpl::connect() { doConnect(); }
 
 void ConnectionImpl::closeSocket(Network::ConnectionEvent close_type) {
+  cancelPrivateKeyOperation();
   if (handshake_complete_ && state() != State::Closed) {
     // Attempt to send a shutdown before closing the socket. It's possible this won't go out if
     // there is no room on the socket. We can extend the state machine to handle this at some point
     // if needed.
-    int rc = SSL_shutdown(ssl_.get());
-    ENVOY_CONN_LOG(debug, "SSL shutdown: rc={}", *this, rc);
-    UNREFERENCED_PARAMETER(rc);
-    drainErrorQueue();
+    if (kernel_tls_tx_) {
+      sendKernelTlsCloseNotify();
+    } else {
+      int rc = SSL_shutdown(ssl_.get());
+      ENVOY_CONN_LOG(debug, "SSL shutdown: rc={}", *this, rc);
+      UNREFERENCED_PARAMETER(rc);
+      drainErrorQueue();
+    }
   }
 
   Network::ConnectionImpl::closeSocket(close_type);
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <string>
 
+#include "envoy/common/optional.h"
+
 #include "common/network/connection_impl.h"
 #include "common/ssl/context_impl.h"
+#include "common/ssl/private_key_thread_pool.h"
 
 #include "openssl/ssl.h"
 
@@ -37,9 +41,33 @@ public:
   SSL* rawSslForTest() { return ssl_.get(); }
 
 private:
+  /**
+   * The global SSL-library index used for storing a pointer to the connection in the SSL instance,
+   * for retrieval in the private key callbacks.
+   */
+  static int sslConnectionIndex();
+  static const SSL_PRIVATE_KEY_METHOD& asyncPrivateKeyMethod();
+
   PostIoAction doHandshake();
+  ssl_private_key_result_t startPrivateKeyOperation(PrivateKeyOperation::Type type,
+                                                    uint16_t signature_algorithm,
+                                                    const uint8_t* in, size_t in_len);
+  ssl_private_key_result_t completePrivateKeyOperation(uint8_t* out, size_t* out_len,
+                                                       size_t max_out);
+  void cancelPrivateKeyOperation();
   void drainErrorQueue();
+  bool enableKernelTlsTx();
+  void sendKernelTlsCloseNotify();
   std::string getUriSanFromCertificate(X509* cert);
+  std::string computeSha256PeerCertificateDigest() const;
+  std::string computeSubjectPeerCertificate() const;
+
+  /**
+   * @return the cached value, computing it first if needed. The certificates do not change once
+   *         the handshake is complete, so from then on each value is computed once per connection.
+   */
+  std::string cachedCertificateValue(Optional<std::string>& cache,
+                                     std::function<std::string()> compute) const;
 
   // Network::ConnectionImpl
   void closeSocket(Network::ConnectionEvent close_type) override;
@@ -50,6 +78,14 @@ private:
   ContextImpl& ctx_;
   bssl::UniquePtr<SSL> ssl_;
   bool handshake_complete_{};
+  // Whether the kernel encrypts the records sent, in which case writes bypass BoringSSL.
+  bool kernel_tls_tx_{};
+  // The private key operation the handshake waits on, if any.
+  PrivateKeyOperationSharedPtr private_key_operation_;
+  mutable Optional<std::string> uri_san_local_certificate_;
+  mutable Optional<std::string> sha256_peer_certificate_digest_;
+  mutable Optional<std::string> subject_peer_certificate_;
+  mutable Optional<std::string> uri_san_peer_certificate_;
 };
 
 class ClientConnectionImpl final : public ConnectionImpl, public Network::ClientConnection {
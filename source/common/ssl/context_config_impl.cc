@@ -112,8 +112,17 @@ ServerContextConfigImpl::ServerContextConfigImpl(const envoy::api::v2::Downstrea
 
         return ret;
       }()) {
-  // TODO(PiotrSikora): Support multiple TLS certificates.
-  ASSERT(config.common_tls_context().tls_certificates().size() == 1);
+  ASSERT(config.common_tls_context().tls_certificates().size() >= 1);
+  for (int i = 1; i < config.common_tls_context().tls_certificates().size(); i++) {
+    const auto& tls_certificate = config.common_tls_context().tls_certificates()[i];
+    // TODO(htuch): Support inline cert material delivery.
+    ASSERT(tls_certificate.certificate_chain().specifier_case() ==
+           envoy::api::v2::DataSource::kFilename);
+    ASSERT(tls_certificate.private_key().specifier_case() ==
+           envoy::api::v2::DataSource::kFilename);
+    sni_certificates_.push_back(
+        {tls_certificate.certificate_chain().filename(), tls_certificate.private_key().filename()});
+  }
 }
 
 ServerContextConfigImpl::ServerContextConfigImpl(const Json::Object& config)
@@ -67,10 +67,14 @@ public:
   const std::vector<SessionTicketKey>& sessionTicketKeys() const override {
     return session_ticket_keys_;
   }
+  const std::vector<TlsCertificate>& sniCertificates() const override {
+    return sni_certificates_;
+  }
 
 private:
   const bool require_client_certificate_;
   const std::vector<SessionTicketKey> session_ticket_keys_;
+  std::vector<TlsCertificate> sni_certificates_;
 
   static void validateAndAppendKey(std::vector<ServerContextConfig::SessionTicketKey>& keys,
                                    const std::string& key_data);
@@ -47,13 +47,17 @@ ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, Contex
   int verify_mode = SSL_VERIFY_NONE;
 
   if (!config.caCertFile().empty()) {
-    ca_cert_ = loadCert(config.caCertFile());
+    // The parsed CA bundle is shared with every other context using the same bundle. Adding the
+    // certificates to the store only takes references to them.
+    ca_certs_ = parent_.loadCertificates(config.caCertFile());
+    ca_cert_ = upRef(ca_certs_->front().get());
     ca_file_path_ = config.caCertFile();
-    // set CA certificate
-    int rc = SSL_CTX_load_verify_locations(ctx_.get(), config.caCertFile().c_str(), nullptr);
-    if (0 == rc) {
-      throw EnvoyException(
-          fmt::format("Failed to load verify locations file {}", config.caCertFile()));
+    X509_STORE* store = SSL_CTX_get_cert_store(ctx_.get());
+    for (const bssl::UniquePtr<X509>& ca_cert : *ca_certs_) {
+      if (!X509_STORE_add_cert(store, ca_cert.get())) {
+        throw EnvoyException(
+            fmt::format("Failed to load verify locations file {}", config.caCertFile()));
+      }
     }
     verify_mode = SSL_VERIFY_PEER;
   }
@@ -77,9 +81,14 @@ ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope, Contex
   }
 
   if (!config.certChainFile().empty()) {
-    cert_chain_ = loadCert(config.certChainFile());
+    // The leaf certificate comes first, followed by its intermediates.
+    cert_chain_certs_ = parent_.loadCertificates(config.certChainFile());
+    cert_chain_ = upRef(cert_chain_certs_->front().get());
     cert_chain_file_path_ = config.certChainFile();
-    int rc = SSL_CTX_use_certificate_chain_file(ctx_.get(), config.certChainFile().c_str());
+    int rc = SSL_CTX_use_certificate(ctx_.get(), cert_chain_.get());
+    for (size_t i = 1; i < cert_chain_certs_->size() && rc != 0; i++) {
+      rc = SSL_CTX_add1_chain_cert(ctx_.get(), (*cert_chain_certs_)[i].get());
+    }
     if (0 == rc) {
       throw EnvoyException(
           fmt::format("Failed to load certificate chain file {}", config.certChainFile()));
@@ -196,6 +205,14 @@ void ContextImpl::logHandshake(SSL* ssl) const {
   }
 }
 
+bool ContextImpl::kernelTlsTxEnabled() const {
+  return parent_.runtime().snapshot().featureEnabled("ssl.kernel_tls_tx", 0);
+}
+
+bool ContextImpl::asyncPrivateKeyEnabled() const {
+  return parent_.runtime().snapshot().featureEnabled("ssl.async_private_key", 0);
+}
+
 bool ContextImpl::verifySubjectAltName(X509* cert,
                                        const std::vector<std::string>& subject_alt_names) {
   bool verified = false;
@@ -321,14 +338,10 @@ std::string ContextImpl::getSerialNumber(X509* cert) {
   return "";
 }
 
-bssl::UniquePtr<X509> ContextImpl::loadCert(const std::string& cert_file) {
-  X509* cert = nullptr;
-  std::unique_ptr<FILE, decltype(&fclose)> fp(fopen(cert_file.c_str(), "r"), &fclose);
-  if (!fp.get() || !PEM_read_X509(fp.get(), &cert, nullptr, nullptr)) {
-    throw EnvoyException(fmt::format("Failed to load certificate '{}'", cert_file.c_str()));
-  }
+bssl::UniquePtr<X509> ContextImpl::upRef(X509* cert) {
+  X509_up_ref(cert);
   return bssl::UniquePtr<X509>(cert);
-};
+}
 
 ClientContextImpl::ClientContextImpl(ContextManagerImpl& parent, Stats::Scope& scope,
                                      ClientContextConfig& config)
@@ -355,6 +368,8 @@ bssl::UniquePtr<SSL> ClientContextImpl::newSsl() const {
   return ssl_con;
 }
 
+const uint64_t ServerContextImpl::SNI_CERTIFICATE_CACHE_SIZE;
+
 ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, Stats::Scope& scope,
                                      ServerContextConfig& config, Runtime::Loader& runtime)
     : ContextImpl(parent, scope, config), runtime_(runtime),
@@ -389,15 +404,43 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, Stats::Scope& s
         ctx_.get(),
         [](SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx, HMAC_CTX* hmac_ctx,
            int encrypt) -> int {
-          ContextImpl* context_impl = static_cast<ContextImpl*>(
-              SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex()));
-          ServerContextImpl* server_context_impl = dynamic_cast<ServerContextImpl*>(context_impl);
-          RELEASE_ASSERT(server_context_impl != nullptr); // for Coverity
-          return server_context_impl->sessionTicketProcess(ssl, key_name, iv, ctx, hmac_ctx,
-                                                           encrypt);
+          return fromSsl(ssl)->sessionTicketProcess(ssl, key_name, iv, ctx, hmac_ctx, encrypt);
         });
   }
 
+  // Sessions resumed by ID are kept in the cache of the context manager rather than in one of the
+  // context's own, so they are not lost when a listener update replaces the context.
+  SSL_CTX_set_session_cache_mode(ctx_.get(), SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+  SSL_CTX_sess_set_new_cb(ctx_.get(), [](SSL* ssl, SSL_SESSION* session) -> int {
+    fromSsl(ssl)->parent_.sessionCache().insert(session);
+    // The cache took a reference of its own.
+    return 0;
+  });
+  SSL_CTX_sess_set_get_cb(
+      ctx_.get(), [](SSL* ssl, const uint8_t* id, int id_len, int* out_copy) -> SSL_SESSION* {
+        // The returned session carries a reference for the connection already.
+        *out_copy = 0;
+        return fromSsl(ssl)->getSession(id, id_len);
+      });
+
+  X509* cert = SSL_CTX_get0_certificate(ctx_.get());
+  RELEASE_ASSERT(cert != nullptr);
+  const std::vector<uint8_t> session_context = sessionContext(cert);
+  int rc = SSL_CTX_set_session_id_context(ctx_.get(), session_context.data(),
+                                          session_context.size());
+  RELEASE_ASSERT(rc == 1);
+
+  if (!config.sniCertificates().empty()) {
+    sni_certificates_.reset(new SniCertificateStore(
+        config.sniCertificates(), SNI_CERTIFICATE_CACHE_SIZE,
+        [this](X509* cert) -> std::vector<uint8_t> { return sessionContext(cert); }));
+    SSL_CTX_set_tlsext_servername_callback(ctx_.get(), [](SSL* ssl, int*, void*) -> int {
+      return fromSsl(ssl)->selectSniCertificate(ssl);
+    });
+  }
+}
+
+std::vector<uint8_t> ServerContextImpl::sessionContext(X509* cert) const {
   uint8_t session_context_buf[EVP_MAX_MD_SIZE] = {};
   unsigned session_context_len = 0;
   EVP_MD_CTX md;
@@ -408,8 +451,6 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, Stats::Scope& s
   // sessions can only be resumed to a certificate for the same name, but allows
   // resuming to unique certs in the case that different Envoy instances each have
   // their own certs.
-  X509* cert = SSL_CTX_get0_certificate(ctx_.get());
-  RELEASE_ASSERT(cert != nullptr);
   X509_NAME* cert_subject = X509_get_subject_name(cert);
   RELEASE_ASSERT(cert_subject != nullptr);
   int cn_index = X509_NAME_get_index_by_NID(cert_subject, NID_commonName, -1);
@@ -471,8 +512,32 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, Stats::Scope& s
 
   rc = EVP_DigestFinal(&md, session_context_buf, &session_context_len);
   RELEASE_ASSERT(rc == 1);
-  rc = SSL_CTX_set_session_id_context(ctx_.get(), session_context_buf, session_context_len);
-  RELEASE_ASSERT(rc == 1);
+  return std::vector<uint8_t>(session_context_buf, session_context_buf + session_context_len);
+}
+
+int ServerContextImpl::selectSniCertificate(SSL* ssl) {
+  const char* server_name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+  if (server_name == nullptr) {
+    return SSL_TLSEXT_ERR_OK;
+  }
+
+  // Without a match, the handshake goes on with the default certificate.
+  SniCertificateStore::CertificateConstSharedPtr certificate =
+      sni_certificates_->find(server_name);
+  if (certificate == nullptr) {
+    return SSL_TLSEXT_ERR_OK;
+  }
+
+  // The connection takes references of its own, so the certificate can be unloaded meanwhile.
+  if (!SSL_use_certificate(ssl, certificate->cert_.get()) ||
+      !SSL_set1_chain(ssl, certificate->chain_.get()) ||
+      !SSL_use_PrivateKey(ssl, certificate->key_.get()) ||
+      !SSL_set_session_id_context(ssl, certificate->session_context_.data(),
+                                  certificate->session_context_.size())) {
+    return SSL_TLSEXT_ERR_ALERT_FATAL;
+  }
+  stats_.sni_certificate_selected_.inc();
+  return SSL_TLSEXT_ERR_OK;
 }
 
 int ServerContextImpl::sessionTicketProcess(SSL*, uint8_t* key_name, uint8_t* iv,
@@ -536,5 +601,25 @@ int ServerContextImpl::sessionTicketProcess(SSL*, uint8_t* key_name, uint8_t* iv
   }
 }
 
+SSL_SESSION* ServerContextImpl::getSession(const uint8_t* id, int id_len) {
+  bssl::UniquePtr<SSL_SESSION> session =
+      parent_.sessionCache().lookup(std::string(reinterpret_cast<const char*>(id), id_len));
+  if (session == nullptr) {
+    stats_.session_cache_miss_.inc();
+    return nullptr;
+  }
+
+  stats_.session_cache_hit_.inc();
+  return session.release();
+}
+
+ServerContextImpl* ServerContextImpl::fromSsl(SSL* ssl) {
+  ContextImpl* context_impl =
+      static_cast<ContextImpl*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex()));
+  ServerContextImpl* server_context_impl = dynamic_cast<ServerContextImpl*>(context_impl);
+  RELEASE_ASSERT(server_context_impl != nullptr); // for Coverity
+  return server_context_impl;
+}
+
 } // namespace Ssl
 } // namespace Envoy
@@ -11,6 +11,7 @@
 
 #include "common/ssl/context_impl.h"
 #include "common/ssl/context_manager_impl.h"
+#include "common/ssl/sni_certificate_store.h"
 
 #include "openssl/ssl.h"
 
@@ -30,7 +31,12 @@ namespace Ssl {
   COUNTER(fail_verify_no_cert)                                                                     \
   COUNTER(fail_verify_error)                                                                       \
   COUNTER(fail_verify_san)                                                                         \
-  COUNTER(fail_verify_cert_hash)
+  COUNTER(fail_verify_cert_hash)                                                                   \
+  COUNTER(session_cache_hit)                                                                       \
+  COUNTER(session_cache_miss)                                                                      \
+  COUNTER(kernel_tls_tx)                                                                           \
+  COUNTER(async_private_key)                                                                       \
+  COUNTER(sni_certificate_selected)
 // clang-format on
 
 /**
@@ -52,6 +58,20 @@ public:
    */
   void logHandshake(SSL* ssl) const;
 
+  /**
+   * @return bool whether connections should hand the encryption of the records they send over to
+   *         the kernel once the handshake is done, where the kernel and the cipher allow it.
+   */
+  bool kernelTlsTxEnabled() const;
+
+  /**
+   * @return bool whether a server connection should run the private key operation of its handshake
+   *         on the private key thread pool rather than on the worker.
+   */
+  bool asyncPrivateKeyEnabled() const;
+
+  PrivateKeyThreadPool& privateKeyThreadPool() { return parent_.privateKeyThreadPool(); }
+
   /**
    * Performs subjectAltName verification
    * @param ssl the certificate to verify
@@ -103,7 +123,7 @@ protected:
   std::vector<uint8_t> parseAlpnProtocols(const std::string& alpn_protocols);
   static SslStats generateStats(Stats::Scope& scope);
   int32_t getDaysUntilExpiration(const X509* cert);
-  bssl::UniquePtr<X509> loadCert(const std::string& cert_file);
+  static bssl::UniquePtr<X509> upRef(X509* cert);
   static std::string getSerialNumber(X509* cert);
   std::string getCaFileName() { return ca_file_path_; };
   std::string getCertChainFileName() { return cert_chain_file_path_; };
@@ -115,6 +135,9 @@ protected:
   Stats::Scope& scope_;
   SslStats stats_;
   std::vector<uint8_t> parsed_alpn_protocols_;
+  // Held so that the parsed files stay shared with contexts created later.
+  CertificateListConstSharedPtr ca_certs_;
+  CertificateListConstSharedPtr cert_chain_certs_;
   bssl::UniquePtr<X509> ca_cert_;
   bssl::UniquePtr<X509> cert_chain_;
   std::string ca_file_path_;
@@ -141,10 +164,18 @@ private:
                          unsigned int inlen);
   int sessionTicketProcess(SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx,
                            HMAC_CTX* hmac_ctx, int encrypt);
+  SSL_SESSION* getSession(const uint8_t* id, int id_len);
+  std::vector<uint8_t> sessionContext(X509* cert) const;
+  int selectSniCertificate(SSL* ssl);
+  static ServerContextImpl* fromSsl(SSL* ssl);
+
+  // The number of certificates picked by server name which are kept loaded at a time.
+  static const uint64_t SNI_CERTIFICATE_CACHE_SIZE = 1024;
 
   Runtime::Loader& runtime_;
   std::vector<uint8_t> parsed_alt_alpn_protocols_;
   const std::vector<ServerContextConfig::SessionTicketKey> session_ticket_keys_;
+  SniCertificateStorePtr sni_certificates_;
 };
 
 } // Ssl
@@ -1,14 +1,26 @@
 #include "common/ssl/context_manager_impl.h"
 
+#include <algorithm>
 #include <functional>
 #include <mutex>
+#include <thread>
+
+#include "envoy/common/exception.h"
 
 #include "common/common/assert.h"
+#include "common/filesystem/filesystem_impl.h"
 #include "common/ssl/context_impl.h"
 
+#include "fmt/format.h"
+#include "openssl/err.h"
+#include "openssl/pem.h"
+#include "openssl/sha.h"
+
 namespace Envoy {
 namespace Ssl {
 
+const uint64_t ContextManagerImpl::DEFAULT_SESSION_CACHE_SIZE;
+
 ContextManagerImpl::~ContextManagerImpl() { ASSERT(contexts_.empty()); }
 
 void ContextManagerImpl::releaseContext(Context* context) {
@@ -46,6 +58,53 @@ size_t ContextManagerImpl::daysUntilFirstCertExpires() {
   return ret;
 }
 
+PrivateKeyThreadPool& ContextManagerImpl::privateKeyThreadPool() {
+  std::call_once(private_key_thread_pool_once_, [this]() -> void {
+    const uint64_t num_threads = runtime_.snapshot().getInteger(
+        "ssl.async_private_key_threads", std::thread::hardware_concurrency());
+    private_key_thread_pool_.reset(new PrivateKeyThreadPool(std::max<uint64_t>(1, num_threads)));
+  });
+  return *private_key_thread_pool_;
+}
+
+CertificateListConstSharedPtr ContextManagerImpl::loadCertificates(const std::string& path) {
+  if (!Filesystem::fileExists(path)) {
+    throw EnvoyException(fmt::format("Failed to load certificate '{}'", path));
+  }
+  const std::string contents = Filesystem::fileReadToEnd(path);
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const uint8_t*>(contents.data()), contents.size(), digest);
+  const std::string key(reinterpret_cast<const char*>(digest), sizeof(digest));
+
+  std::unique_lock<std::mutex> lock(certificates_lock_);
+  auto it = certificates_.find(key);
+  if (it != certificates_.end()) {
+    CertificateListConstSharedPtr certificates = it->second.lock();
+    if (certificates != nullptr) {
+      return certificates;
+    }
+  }
+
+  std::shared_ptr<CertificateList> certificates = std::make_shared<CertificateList>();
+  bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(contents.data(), contents.size()));
+  RELEASE_ASSERT(bio != nullptr);
+  while (X509* certificate = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) {
+    certificates->emplace_back(certificate);
+  }
+  // Reading stops with an error at the end of the data.
+  ERR_clear_error();
+  if (certificates->empty()) {
+    throw EnvoyException(fmt::format("Failed to load certificate '{}'", path));
+  }
+
+  // Drop the entries of files no context uses anymore.
+  for (auto entry = certificates_.begin(); entry != certificates_.end();) {
+    entry = entry->second.expired() ? certificates_.erase(entry) : std::next(entry);
+  }
+  certificates_[key] = certificates;
+  return certificates;
+}
+
 void ContextManagerImpl::iterateContexts(std::function<void(Context&)> callback) {
   std::unique_lock<std::mutex> lock(contexts_lock_);
   for (Context* context : contexts_) {
@@ -2,14 +2,26 @@
 
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context_manager.h"
 
+#include "common/ssl/private_key_thread_pool.h"
+#include "common/ssl/session_cache_impl.h"
+
+#include "openssl/ssl.h"
+
 namespace Envoy {
 namespace Ssl {
 
+typedef std::vector<bssl::UniquePtr<X509>> CertificateList;
+typedef std::shared_ptr<const CertificateList> CertificateListConstSharedPtr;
+
 /**
  * The SSL context manager has the following threading model:
  * Contexts can be allocated via any thread (through in practice they are only allocated on the main
@@ -19,7 +31,8 @@ namespace Ssl {
  */
 class ContextManagerImpl final : public ContextManager {
 public:
-  ContextManagerImpl(Runtime::Loader& runtime) : runtime_(runtime) {}
+  ContextManagerImpl(Runtime::Loader& runtime)
+      : runtime_(runtime), session_cache_(DEFAULT_SESSION_CACHE_SIZE) {}
   ~ContextManagerImpl();
 
   /**
@@ -29,6 +42,32 @@ public:
    */
   void releaseContext(Context* context);
 
+  Runtime::Loader& runtime() { return runtime_; }
+
+  /**
+   * @return SessionCacheImpl& the session cache shared by all server contexts.
+   */
+  SessionCacheImpl& sessionCache() { return session_cache_; }
+
+  /**
+   * @return PrivateKeyThreadPool& the threads which run private key operations off the workers,
+   *         started on first use.
+   */
+  PrivateKeyThreadPool& privateKeyThreadPool();
+
+  /**
+   * Parse the PEM certificates in a file, e.g. a CA bundle or a certificate chain. Files with the
+   * same contents share a single parsed copy for as long as any context holds it, so a CA bundle
+   * which many clusters use is parsed and held in memory once rather than once per context.
+   * @param path supplies the path of the file.
+   * @return the certificates in the file, in order.
+   * @throw EnvoyException if the file cannot be read or holds no certificate.
+   */
+  CertificateListConstSharedPtr loadCertificates(const std::string& path);
+
+  // Matches the size of the cache BoringSSL keeps for each context by default.
+  static const uint64_t DEFAULT_SESSION_CACHE_SIZE = 20 * 1024;
+
   // Ssl::ContextManager
   Ssl::ClientContextPtr createSslClientContext(Stats::Scope& scope,
                                                ClientContextConfig& config) override;
@@ -41,6 +80,12 @@ private:
   Runtime::Loader& runtime_;
   std::list<Context*> contexts_;
   std::mutex contexts_lock_;
+  SessionCacheImpl session_cache_;
+  PrivateKeyThreadPoolPtr private_key_thread_pool_;
+  std::once_flag private_key_thread_pool_once_;
+  // Parsed certificate files, keyed by the SHA-256 of their contents.
+  std::unordered_map<std::string, std::weak_ptr<const CertificateList>> certificates_;
+  std::mutex certificates_lock_;
 };
 
 } // namespace Ssl
@@ -0,0 +1,176 @@
+#include "common/ssl/private_key_thread_pool.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "common/common/assert.h"
+
+#include "openssl/digest.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/rsa.h"
+
+namespace Envoy {
+namespace Ssl {
+
+PrivateKeyOperation::PrivateKeyOperation(Type type, bssl::UniquePtr<EVP_PKEY> key,
+                                         uint16_t signature_algorithm, const uint8_t* in,
+                                         size_t in_len, Event::Dispatcher& dispatcher,
+                                         std::function<void()> completion_cb)
+    : type_(type), key_(std::move(key)), signature_algorithm_(signature_algorithm),
+      in_(in, in + in_len), dispatcher_(dispatcher), completion_cb_(completion_cb) {}
+
+void PrivateKeyOperation::run() {
+  const bool succeeded = type_ == Type::Sign ? sign() : decrypt();
+  // The error queue belongs to the thread of the pool, which nothing else looks at.
+  ERR_clear_error();
+
+  std::unique_lock<std::mutex> lock(lock_);
+  status_ = succeeded ? Status::Succeeded : Status::Failed;
+  if (!cancelled_) {
+    PrivateKeyOperationSharedPtr self = shared_from_this();
+    dispatcher_.post([self]() -> void {
+      // Cancelling happens on this thread, so it can't happen while the callback runs.
+      if (!self->cancelled_) {
+        self->completion_cb_();
+      }
+    });
+  }
+}
+
+void PrivateKeyOperation::cancel() {
+  std::unique_lock<std::mutex> lock(lock_);
+  cancelled_ = true;
+}
+
+PrivateKeyOperation::Status PrivateKeyOperation::status() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return status_;
+}
+
+bool PrivateKeyOperation::sign() {
+  const EVP_MD* md;
+  bool pss = false;
+  switch (signature_algorithm_) {
+  case SSL_SIGN_RSA_PKCS1_MD5_SHA1:
+    md = EVP_md5_sha1();
+    break;
+  case SSL_SIGN_RSA_PKCS1_SHA1:
+  case SSL_SIGN_ECDSA_SHA1:
+    md = EVP_sha1();
+    break;
+  case SSL_SIGN_RSA_PKCS1_SHA256:
+  case SSL_SIGN_ECDSA_SECP256R1_SHA256:
+    md = EVP_sha256();
+    break;
+  case SSL_SIGN_RSA_PKCS1_SHA384:
+  case SSL_SIGN_ECDSA_SECP384R1_SHA384:
+    md = EVP_sha384();
+    break;
+  case SSL_SIGN_RSA_PKCS1_SHA512:
+  case SSL_SIGN_ECDSA_SECP521R1_SHA512:
+    md = EVP_sha512();
+    break;
+  case SSL_SIGN_RSA_PSS_SHA256:
+    md = EVP_sha256();
+    pss = true;
+    break;
+  case SSL_SIGN_RSA_PSS_SHA384:
+    md = EVP_sha384();
+    pss = true;
+    break;
+  case SSL_SIGN_RSA_PSS_SHA512:
+    md = EVP_sha512();
+    pss = true;
+    break;
+  default:
+    return false;
+  }
+
+  bssl::ScopedEVP_MD_CTX ctx;
+  EVP_PKEY_CTX* pkey_ctx;
+  if (!EVP_DigestSignInit(ctx.get(), &pkey_ctx, md, nullptr, key_.get())) {
+    return false;
+  }
+  // TLS uses a salt as long as the digest.
+  if (pss && (!EVP_PKEY_CTX_set_rsa_padding(pkey_ctx, RSA_PKCS1_PSS_PADDING) ||
+              !EVP_PKEY_CTX_set_rsa_pss_saltlen(pkey_ctx, -1))) {
+    return false;
+  }
+
+  size_t length = 0;
+  if (!EVP_DigestSignUpdate(ctx.get(), in_.data(), in_.size()) ||
+      !EVP_DigestSignFinal(ctx.get(), nullptr, &length)) {
+    return false;
+  }
+  output_.resize(length);
+  if (!EVP_DigestSignFinal(ctx.get(), output_.data(), &length)) {
+    return false;
+  }
+  output_.resize(length);
+  return true;
+}
+
+bool PrivateKeyOperation::decrypt() {
+  // BoringSSL removes the padding itself.
+  RSA* rsa = EVP_PKEY_get0_RSA(key_.get());
+  if (rsa == nullptr) {
+    return false;
+  }
+
+  size_t length = 0;
+  output_.resize(RSA_size(rsa));
+  if (!RSA_decrypt(rsa, &length, output_.data(), output_.size(), in_.data(), in_.size(),
+                   RSA_NO_PADDING)) {
+    return false;
+  }
+  output_.resize(length);
+  return true;
+}
+
+PrivateKeyThreadPool::PrivateKeyThreadPool(uint32_t num_threads) {
+  ASSERT(num_threads > 0);
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(new Thread::Thread([this]() -> void { threadRoutine(); }));
+  }
+}
+
+PrivateKeyThreadPool::~PrivateKeyThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  for (const Thread::ThreadPtr& thread : threads_) {
+    thread->join();
+  }
+}
+
+void PrivateKeyThreadPool::submit(PrivateKeyOperationSharedPtr operation) {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    queue_.emplace_back(std::move(operation));
+  }
+  queue_cv_.notify_one();
+}
+
+void PrivateKeyThreadPool::threadRoutine() {
+  while (true) {
+    PrivateKeyOperationSharedPtr operation;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      queue_cv_.wait(lock, [this]() -> bool { return shutdown_ || !queue_.empty(); });
+      if (shutdown_) {
+        return;
+      }
+      operation = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    operation->run();
+  }
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+
+#include "common/common/non_copyable.h"
+#include "common/common/thread.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * A private key operation of a handshake, which a PrivateKeyThreadPool runs off the thread of the
+ * connection. The completion callback is posted to the connection's dispatcher unless the operation
+ * was cancelled first.
+ */
+class PrivateKeyOperation : public std::enable_shared_from_this<PrivateKeyOperation>,
+                            NonCopyable {
+public:
+  enum class Type { Sign, Decrypt };
+  enum class Status { Pending, Succeeded, Failed };
+
+  /**
+   * @param type supplies whether to sign or to decrypt.
+   * @param key supplies the private key.
+   * @param signature_algorithm supplies the TLS signature algorithm when signing.
+   * @param in supplies the input, the message to sign or the data to decrypt without padding.
+   * @param in_len supplies the length of the input.
+   * @param dispatcher supplies the dispatcher to post the completion callback to.
+   * @param completion_cb supplies the callback to invoke once the operation is done.
+   */
+  PrivateKeyOperation(Type type, bssl::UniquePtr<EVP_PKEY> key, uint16_t signature_algorithm,
+                      const uint8_t* in, size_t in_len, Event::Dispatcher& dispatcher,
+                      std::function<void()> completion_cb);
+
+  /**
+   * Run the operation and post the completion callback. Called on a thread of the pool.
+   */
+  void run();
+
+  /**
+   * Make sure the completion callback is not invoked. Called on the thread of the dispatcher,
+   * before the dispatcher is destroyed.
+   */
+  void cancel();
+
+  /**
+   * @return Status whether the operation is done and whether it succeeded.
+   */
+  Status status();
+
+  /**
+   * @return const std::vector<uint8_t>& the signature or the decrypted data, once the operation
+   *         succeeded.
+   */
+  const std::vector<uint8_t>& output() const { return output_; }
+
+private:
+  bool sign();
+  bool decrypt();
+
+  const Type type_;
+  const bssl::UniquePtr<EVP_PKEY> key_;
+  const uint16_t signature_algorithm_;
+  const std::vector<uint8_t> in_;
+  Event::Dispatcher& dispatcher_;
+  const std::function<void()> completion_cb_;
+  std::vector<uint8_t> output_;
+  std::mutex lock_;
+  Status status_{Status::Pending};
+  bool cancelled_{};
+};
+
+typedef std::shared_ptr<PrivateKeyOperation> PrivateKeyOperationSharedPtr;
+
+/**
+ * Threads which run the private key operations of handshakes, so that the workers keep serving
+ * other connections meanwhile. Operations are run in the order they are submitted. Thread safe.
+ */
+class PrivateKeyThreadPool : NonCopyable {
+public:
+  explicit PrivateKeyThreadPool(uint32_t num_threads);
+
+  /**
+   * Stops the threads. Operations which did not start are dropped without completing.
+   */
+  ~PrivateKeyThreadPool();
+
+  /**
+   * Queue an operation to run on one of the threads.
+   * @param operation supplies the operation.
+   */
+  void submit(PrivateKeyOperationSharedPtr operation);
+
+private:
+  void threadRoutine();
+
+  std::vector<Thread::ThreadPtr> threads_;
+  std::list<PrivateKeyOperationSharedPtr> queue_;
+  std::mutex lock_;
+  std::condition_variable queue_cv_;
+  bool shutdown_{};
+};
+
+typedef std::unique_ptr<PrivateKeyThreadPool> PrivateKeyThreadPoolPtr;
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,63 @@
+#include "common/ssl/session_cache_impl.h"
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Ssl {
+
+SessionCacheImpl::SessionCacheImpl(uint64_t capacity) : capacity_(capacity) {
+  ASSERT(capacity_ > 0);
+}
+
+void SessionCacheImpl::insert(SSL_SESSION* session) {
+  unsigned id_len = 0;
+  const uint8_t* id = SSL_SESSION_get_id(session, &id_len);
+  std::string key(reinterpret_cast<const char*>(id), id_len);
+  SSL_SESSION_up_ref(session);
+  bssl::UniquePtr<SSL_SESSION> reference(session);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  auto existing = index_.find(key);
+  if (existing != index_.end()) {
+    sessions_.erase(existing->second);
+    index_.erase(existing);
+  } else if (sessions_.size() >= capacity_) {
+    index_.erase(sessions_.back().first);
+    sessions_.pop_back();
+  }
+
+  sessions_.emplace_front(key, std::move(reference));
+  index_.emplace(std::move(key), sessions_.begin());
+}
+
+bssl::UniquePtr<SSL_SESSION> SessionCacheImpl::lookup(const std::string& id) {
+  std::unique_lock<std::mutex> lock(lock_);
+  auto entry = index_.find(id);
+  if (entry == index_.end()) {
+    return nullptr;
+  }
+
+  SSL_SESSION* session = entry->second->second.get();
+  if (time(nullptr) >= SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session)) {
+    sessions_.erase(entry->second);
+    index_.erase(entry);
+    return nullptr;
+  }
+
+  sessions_.splice(sessions_.begin(), sessions_, entry->second);
+  SSL_SESSION_up_ref(session);
+  return bssl::UniquePtr<SSL_SESSION>(session);
+}
+
+uint64_t SessionCacheImpl::size() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return sessions_.size();
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/common/non_copyable.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * Cache of the TLS sessions of server contexts, by session ID. A single cache is shared by all the
+ * server contexts of a context manager, so sessions are resumed on any worker and survive the
+ * listener updates which replace contexts. BoringSSL only resumes a session from the cache on a
+ * context with the same session ID context as the one which created it. Once the cache is full,
+ * the least recently used session is evicted. Thread safe.
+ */
+class SessionCacheImpl : NonCopyable {
+public:
+  explicit SessionCacheImpl(uint64_t capacity);
+
+  /**
+   * Add a session, replacing any session with the same ID. The cache takes a reference to the
+   * session rather than the caller's.
+   * @param session supplies the session to add.
+   */
+  void insert(SSL_SESSION* session);
+
+  /**
+   * Find a session. Sessions which timed out are removed rather than returned.
+   * @param id supplies the session ID.
+   * @return bssl::UniquePtr<SSL_SESSION> a new reference to the session, or nullptr on a miss.
+   */
+  bssl::UniquePtr<SSL_SESSION> lookup(const std::string& id);
+
+  /**
+   * @return uint64_t the number of sessions in the cache.
+   */
+  uint64_t size();
+
+private:
+  typedef std::list<std::pair<std::string, bssl::UniquePtr<SSL_SESSION>>> SessionList;
+
+  const uint64_t capacity_;
+  // Most recently used first.
+  SessionList sessions_;
+  std::unordered_map<std::string, SessionList::iterator> index_;
+  std::mutex lock_;
+};
+
+} // namespace Ssl
+} // namespace Envoy
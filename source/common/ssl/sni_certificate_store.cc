@@ -0,0 +1,186 @@
+#include "common/ssl/sni_certificate_store.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+
+#include "fmt/format.h"
+#include "openssl/err.h"
+#include "openssl/pem.h"
+#include "openssl/x509v3.h"
+
+namespace Envoy {
+namespace Ssl {
+
+namespace {
+std::string toLower(std::string name) {
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) -> char { return std::tolower(c); });
+  return name;
+}
+} // namespace
+
+SniCertificateStore::SniCertificateStore(
+    const std::vector<ServerContextConfig::TlsCertificate>& certificates, uint64_t cache_size,
+    SessionContextCb session_context_cb)
+    : cache_size_(cache_size), session_context_cb_(session_context_cb) {
+  ASSERT(cache_size_ > 0);
+  entries_.resize(certificates.size());
+  for (size_t i = 0; i < certificates.size(); i++) {
+    entries_[i].files_ = certificates[i];
+    entries_[i].lru_position_ = lru_.end();
+
+    // Only the leaf certificate is read, for its names.
+    bssl::UniquePtr<BIO> bio(BIO_new_file(certificates[i].cert_chain_file_.c_str(), "r"));
+    bssl::UniquePtr<X509> cert(
+        bio == nullptr ? nullptr : PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr));
+    if (cert == nullptr) {
+      ERR_clear_error();
+      throw EnvoyException(
+          fmt::format("Failed to load certificate '{}'", certificates[i].cert_chain_file_));
+    }
+
+    const std::vector<std::string> names = dnsNames(cert.get());
+    if (names.empty()) {
+      throw EnvoyException(fmt::format("Certificate '{}' has no DNS name to be picked by",
+                                       certificates[i].cert_chain_file_));
+    }
+    for (const std::string& name : names) {
+      // The first certificate with a name keeps it.
+      if (name.size() > 2 && name[0] == '*' && name[1] == '.') {
+        wildcard_names_.emplace(name.substr(2), i);
+      } else {
+        exact_names_.emplace(name, i);
+      }
+    }
+  }
+}
+
+SniCertificateStore::CertificateConstSharedPtr
+SniCertificateStore::find(const std::string& server_name) {
+  const std::string name = toLower(server_name);
+  auto match = exact_names_.find(name);
+  if (match == exact_names_.end()) {
+    const size_t first_label_end = name.find('.');
+    if (first_label_end == std::string::npos) {
+      return nullptr;
+    }
+    match = wildcard_names_.find(name.substr(first_label_end + 1));
+    if (match == wildcard_names_.end()) {
+      return nullptr;
+    }
+  }
+
+  const size_t index = match->second;
+  Entry& entry = entries_[index];
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (entry.loaded_ != nullptr) {
+      lru_.splice(lru_.begin(), lru_, entry.lru_position_);
+      return entry.loaded_;
+    }
+  }
+
+  // Reading the files is slow, so other threads carry on meanwhile. Two threads may both load the
+  // same certificate, in which case the first to finish wins.
+  CertificateConstSharedPtr certificate = load(entry.files_);
+  if (certificate == nullptr) {
+    return nullptr;
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (entry.loaded_ != nullptr) {
+    lru_.splice(lru_.begin(), lru_, entry.lru_position_);
+    return entry.loaded_;
+  }
+
+  if (lru_.size() >= cache_size_) {
+    // Connections which use the evicted certificate keep their own references to it.
+    Entry& evicted = entries_[lru_.back()];
+    evicted.loaded_.reset();
+    evicted.lru_position_ = lru_.end();
+    lru_.pop_back();
+  }
+  entry.loaded_ = certificate;
+  lru_.push_front(index);
+  entry.lru_position_ = lru_.begin();
+  return certificate;
+}
+
+uint64_t SniCertificateStore::numLoaded() {
+  std::unique_lock<std::mutex> lock(lock_);
+  return lru_.size();
+}
+
+std::vector<std::string> SniCertificateStore::dnsNames(X509* cert) {
+  std::vector<std::string> names;
+  bssl::UniquePtr<GENERAL_NAMES> san_names(
+      static_cast<GENERAL_NAMES*>(X509_get_ext_d2i(cert, NID_subject_alt_name, nullptr, nullptr)));
+  if (san_names != nullptr) {
+    for (size_t i = 0; i < sk_GENERAL_NAME_num(san_names.get()); i++) {
+      const GENERAL_NAME* san = sk_GENERAL_NAME_value(san_names.get(), i);
+      if (san->type == GEN_DNS) {
+        names.push_back(toLower(std::string(reinterpret_cast<const char*>(
+                                                ASN1_STRING_data(san->d.dNSName)),
+                                            ASN1_STRING_length(san->d.dNSName))));
+      }
+    }
+    return names;
+  }
+
+  X509_NAME* subject = X509_get_subject_name(cert);
+  const int cn_index = X509_NAME_get_index_by_NID(subject, NID_commonName, -1);
+  if (cn_index >= 0) {
+    ASN1_STRING* cn = X509_NAME_ENTRY_get_data(X509_NAME_get_entry(subject, cn_index));
+    names.push_back(toLower(
+        std::string(reinterpret_cast<const char*>(ASN1_STRING_data(cn)), ASN1_STRING_length(cn))));
+  }
+  return names;
+}
+
+SniCertificateStore::CertificateConstSharedPtr
+SniCertificateStore::load(const ServerContextConfig::TlsCertificate& files) {
+  std::shared_ptr<Certificate> certificate = std::make_shared<Certificate>();
+  bssl::UniquePtr<BIO> bio(BIO_new_file(files.cert_chain_file_.c_str(), "r"));
+  if (bio != nullptr) {
+    certificate->cert_.reset(PEM_read_bio_X509_AUX(bio.get(), nullptr, nullptr, nullptr));
+  }
+  if (certificate->cert_ == nullptr) {
+    ERR_clear_error();
+    ENVOY_LOG(warn, "failed to load certificate chain file {}", files.cert_chain_file_);
+    return nullptr;
+  }
+
+  // The intermediate certificates follow the leaf up to the end of the file.
+  certificate->chain_.reset(sk_X509_new_null());
+  RELEASE_ASSERT(certificate->chain_ != nullptr);
+  while (X509* intermediate = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) {
+    RELEASE_ASSERT(sk_X509_push(certificate->chain_.get(), intermediate));
+  }
+  ERR_clear_error();
+
+  bio.reset(BIO_new_file(files.private_key_file_.c_str(), "r"));
+  if (bio != nullptr) {
+    certificate->key_.reset(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+  }
+  if (certificate->key_ == nullptr ||
+      !X509_check_private_key(certificate->cert_.get(), certificate->key_.get())) {
+    ERR_clear_error();
+    ENVOY_LOG(warn, "failed to load private key file {}", files.private_key_file_);
+    return nullptr;
+  }
+
+  certificate->session_context_ = session_context_cb_(certificate->cert_.get());
+  return certificate;
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/ssl/context_config.h"
+
+#include "common/common/logger.h"
+#include "common/common/non_copyable.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * The certificates a server context picks from by the server name a client indicates. Each
+ * certificate is indexed at startup by the DNS names of its subjectAltNames, or by its CommonName
+ * when it has none, exact names and wildcards apart. A certificate with its chain and key is only
+ * loaded when a server name first matches it, and the least recently used ones are unloaded once
+ * more than cache_size are loaded. Thread safe.
+ */
+class SniCertificateStore : NonCopyable, Logger::Loggable<Logger::Id::connection> {
+public:
+  struct Certificate {
+    bssl::UniquePtr<X509> cert_;
+    bssl::UniquePtr<STACK_OF(X509)> chain_;
+    bssl::UniquePtr<EVP_PKEY> key_;
+    std::vector<uint8_t> session_context_;
+  };
+
+  typedef std::shared_ptr<const Certificate> CertificateConstSharedPtr;
+
+  /**
+   * Computes the session ID context of connections which present a certificate.
+   */
+  typedef std::function<std::vector<uint8_t>(X509* cert)> SessionContextCb;
+
+  /**
+   * @param certificates supplies the certificates, in order of preference for names which more than
+   *        one of them matches.
+   * @param cache_size supplies the number of certificates to keep loaded.
+   * @param session_context_cb supplies the callback which computes the session ID context of each
+   *        certificate as it is loaded.
+   * Throws EnvoyException if a certificate can't be read.
+   */
+  SniCertificateStore(const std::vector<ServerContextConfig::TlsCertificate>& certificates,
+                      uint64_t cache_size, SessionContextCb session_context_cb);
+
+  /**
+   * Find the certificate for a server name, loading it if needed. A wildcard only matches the
+   * leftmost label of a name, and only when no certificate has the exact name.
+   * @param server_name supplies the server name.
+   * @return CertificateConstSharedPtr the certificate, or nullptr if none matches or it could not
+   *         be loaded.
+   */
+  CertificateConstSharedPtr find(const std::string& server_name);
+
+  /**
+   * @return uint64_t the number of certificates loaded.
+   */
+  uint64_t numLoaded();
+
+  /**
+   * @return std::vector<std::string> the DNS names a certificate is valid for, lower case.
+   */
+  static std::vector<std::string> dnsNames(X509* cert);
+
+private:
+  struct Entry {
+    ServerContextConfig::TlsCertificate files_;
+    CertificateConstSharedPtr loaded_;
+    std::list<size_t>::iterator lru_position_;
+  };
+
+  CertificateConstSharedPtr load(const ServerContextConfig::TlsCertificate& files);
+
+  const uint64_t cache_size_;
+  const SessionContextCb session_context_cb_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, size_t> exact_names_;
+  // Keyed by the name a wildcard stands for the first label of, e.g. example.com for *.example.com.
+  std::unordered_map<std::string, size_t> wildcard_names_;
+  // Indexes of the loaded entries, most recently used first.
+  std::list<size_t> lru_;
+  std::mutex lock_;
+};
+
+typedef std::unique_ptr<SniCertificateStore> SniCertificateStorePtr;
+
+} // namespace Ssl
+} // namespace Envoy
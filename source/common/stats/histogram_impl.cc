@@ -0,0 +1,118 @@
+#include "common/stats/histogram_impl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Stats {
+
+const uint32_t HistogramBuckets::SUB_BUCKET_BITS;
+const uint32_t HistogramBuckets::SUB_BUCKETS;
+const uint32_t HistogramBuckets::NUM_BUCKETS;
+
+uint32_t HistogramBuckets::index(uint64_t value) {
+  if (value < SUB_BUCKETS) {
+    return value;
+  }
+
+  // The position of the highest set bit picks the power of two and the bits below it pick the
+  // sub-bucket.
+  const uint32_t exponent = 63 - __builtin_clzll(value);
+  const uint32_t sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+  return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t HistogramBuckets::lowerBound(uint32_t index) {
+  ASSERT(index < NUM_BUCKETS);
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+
+  const uint32_t exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS;
+  const uint64_t sub_bucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+  return (SUB_BUCKETS + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+uint64_t HistogramBuckets::upperBound(uint32_t index) {
+  return index + 1 < NUM_BUCKETS ? lowerBound(index + 1) - 1
+                                 : std::numeric_limits<uint64_t>::max();
+}
+
+HistogramStatisticsImpl::HistogramStatisticsImpl()
+    : computed_quantiles_(supportedQuantiles().size(), std::nan("")) {}
+
+const std::vector<double>& HistogramStatisticsImpl::supportedQuantiles() const {
+  static const std::vector<double> supported_quantiles{0,    0.25, 0.5,   0.75, 0.9,
+                                                       0.95, 0.99, 0.999, 1};
+  return supported_quantiles;
+}
+
+void HistogramStatisticsImpl::refresh(const std::vector<uint64_t>& buckets, uint64_t sample_sum) {
+  ASSERT(buckets.size() == HistogramBuckets::NUM_BUCKETS);
+  sample_count_ = 0;
+  for (uint64_t count : buckets) {
+    sample_count_ += count;
+  }
+  sample_sum_ = sample_sum;
+
+  const std::vector<double>& quantiles = supportedQuantiles();
+  if (sample_count_ == 0) {
+    computed_quantiles_.assign(quantiles.size(), std::nan(""));
+    return;
+  }
+
+  // Find the bucket holding the value of each quantile and interpolate linearly within it, on the
+  // assumption that values are spread evenly over the bucket.
+  uint32_t index = 0;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    const double rank = quantiles[i] * sample_count_;
+    while (buckets[index] == 0 || seen + buckets[index] < rank) {
+      seen += buckets[index];
+      index++;
+    }
+
+    const double lower = HistogramBuckets::lowerBound(index);
+    const double width = HistogramBuckets::upperBound(index) - lower;
+    computed_quantiles_[i] = lower + width * std::max(0.0, rank - seen) / buckets[index];
+  }
+}
+
+std::string HistogramStatisticsImpl::summary() const {
+  const std::vector<double>& quantiles = supportedQuantiles();
+  std::string summary;
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    if (i > 0) {
+      summary += ", ";
+    }
+    summary += fmt::format("P{:g}: {:g}", 100 * quantiles[i], computed_quantiles_[i]);
+  }
+  return summary;
+}
+
+ThreadLocalHistogramImpl::ThreadLocalHistogramImpl() : sample_sum_(0) {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void ThreadLocalHistogramImpl::drain(std::vector<uint64_t>& buckets, uint64_t& sample_sum) {
+  ASSERT(buckets.size() == HistogramBuckets::NUM_BUCKETS);
+  for (uint32_t i = 0; i < HistogramBuckets::NUM_BUCKETS; i++) {
+    if (buckets_[i].load(std::memory_order_relaxed) != 0) {
+      buckets[i] += buckets_[i].exchange(0, std::memory_order_relaxed);
+    }
+  }
+  sample_sum += sample_sum_.exchange(0, std::memory_order_relaxed);
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Log-linear bucket layout shared by all histograms. Values below SUB_BUCKETS have a bucket each.
+ * Above that, each power of two is split into SUB_BUCKETS buckets of equal width, so a bucket is
+ * never wider than 1 / SUB_BUCKETS of its lower bound.
+ */
+class HistogramBuckets {
+public:
+  static const uint32_t SUB_BUCKET_BITS = 3;
+  static const uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static const uint32_t NUM_BUCKETS = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+  /**
+   * @return the index of the bucket which value belongs to.
+   */
+  static uint32_t index(uint64_t value);
+
+  /**
+   * @return the smallest value which belongs to a bucket.
+   */
+  static uint64_t lowerBound(uint32_t index);
+
+  /**
+   * @return the largest value which belongs to a bucket.
+   */
+  static uint64_t upperBound(uint32_t index);
+};
+
+/**
+ * Statistics computed from a set of histogram buckets.
+ */
+class HistogramStatisticsImpl : public HistogramStatistics, NonCopyable {
+public:
+  HistogramStatisticsImpl();
+
+  /**
+   * Recompute the statistics.
+   * @param buckets supplies the number of values in each of the HistogramBuckets.
+   * @param sample_sum supplies the sum of the values.
+   */
+  void refresh(const std::vector<uint64_t>& buckets, uint64_t sample_sum);
+
+  // Stats::HistogramStatistics
+  std::string summary() const override;
+  const std::vector<double>& supportedQuantiles() const override;
+  const std::vector<double>& computedQuantiles() const override { return computed_quantiles_; }
+  uint64_t sampleCount() const override { return sample_count_; }
+  uint64_t sampleSum() const override { return sample_sum_; }
+
+private:
+  std::vector<double> computed_quantiles_;
+  uint64_t sample_count_{};
+  uint64_t sample_sum_{};
+};
+
+/**
+ * The values recorded into a histogram by one thread. Recording and draining do not lock, so the
+ * main thread can drain the values while the owning thread records more.
+ */
+class ThreadLocalHistogramImpl : NonCopyable {
+public:
+  ThreadLocalHistogramImpl();
+
+  void recordValue(uint64_t value) {
+    buckets_[HistogramBuckets::index(value)].fetch_add(1, std::memory_order_relaxed);
+    sample_sum_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * Move the values recorded since the last drain into buckets and sample_sum.
+   * @param buckets supplies HistogramBuckets::NUM_BUCKETS counts to add the values to.
+   * @param sample_sum supplies the sum to add the values to.
+   */
+  void drain(std::vector<uint64_t>& buckets, uint64_t& sample_sum);
+
+private:
+  std::atomic<uint64_t> buckets_[HistogramBuckets::NUM_BUCKETS];
+  std::atomic<uint64_t> sample_sum_;
+};
+
+typedef std::shared_ptr<ThreadLocalHistogramImpl> ThreadLocalHistogramSharedPtr;
+
+} // namespace Stats
+} // namespace Envoy
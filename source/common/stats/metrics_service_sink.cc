@@ -0,0 +1,90 @@
+#include "common/stats/metrics_service_sink.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Envoy {
+namespace Stats {
+namespace MetricsService {
+
+MetricsServiceSink::MetricsServiceSink(MetricsServiceAsyncClientPtr&& client,
+                                       const LocalInfo::LocalInfo& local_info,
+                                       SystemTimeSource& time_source, Scope& scope)
+    : client_(std::move(client)),
+      service_method_(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+          "envoy.metrics.MetricsService.StreamMetrics")),
+      local_info_(local_info), time_source_(time_source),
+      stats_{ALL_METRICS_SERVICE_STATS(POOL_COUNTER_PREFIX(scope, "metrics_service."))} {}
+
+void MetricsServiceSink::beginFlush() {
+  message_.Clear();
+  message_.set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                time_source_.currentTime().time_since_epoch())
+                                .count());
+}
+
+void MetricsServiceSink::flushCounter(const Counter& counter, uint64_t delta) {
+  envoy::metrics::Metric* metric = message_.add_metrics();
+  metric->set_name(counter.name());
+  metric->set_type(envoy::metrics::Metric::COUNTER);
+  metric->set_value(delta);
+}
+
+void MetricsServiceSink::flushGauge(const Gauge& gauge, uint64_t value) {
+  envoy::metrics::Metric* metric = message_.add_metrics();
+  metric->set_name(gauge.name());
+  metric->set_type(envoy::metrics::Metric::GAUGE);
+  metric->set_value(value);
+}
+
+void MetricsServiceSink::flushHistogram(const ParentHistogram& histogram) {
+  const HistogramStatistics& statistics = histogram.intervalStatistics();
+  if (statistics.sampleCount() == 0) {
+    return;
+  }
+
+  envoy::metrics::Metric* metric = message_.add_metrics();
+  metric->set_name(histogram.name());
+  metric->set_type(envoy::metrics::Metric::HISTOGRAM);
+  metric->set_sample_count(statistics.sampleCount());
+  metric->set_sample_sum(statistics.sampleSum());
+  const std::vector<double>& quantiles = statistics.supportedQuantiles();
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    envoy::metrics::Quantile* quantile = metric->add_quantiles();
+    quantile->set_quantile(quantiles[i]);
+    quantile->set_value(statistics.computedQuantiles()[i]);
+  }
+}
+
+void MetricsServiceSink::endFlush() {
+  if (stream_ == nullptr) {
+    stream_ = client_->start(service_method_, *this);
+    if (stream_ == nullptr) {
+      ENVOY_LOG(debug, "unable to start metrics service stream");
+      stats_.flushes_dropped_.inc();
+      message_.Clear();
+      return;
+    }
+    envoy::metrics::StreamMetricsMessage::Identifier* identifier =
+        message_.mutable_identifier();
+    identifier->set_node_id(local_info_.nodeName());
+    identifier->set_cluster(local_info_.clusterName());
+  }
+
+  stream_->sendMessage(message_, false);
+  stats_.flushes_sent_.inc();
+  message_.Clear();
+}
+
+void MetricsServiceSink::onRemoteClose(Grpc::Status::GrpcStatus status,
+                                       const std::string& message) {
+  ENVOY_LOG(debug, "metrics service stream closed: {}, {}", status, message);
+  stats_.stream_failures_.inc();
+  stream_ = nullptr;
+}
+
+} // namespace MetricsService
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/grpc/async_client.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+#include "common/protobuf/protobuf.h"
+
+#include "source/common/stats/metrics_service.pb.h"
+
+namespace Envoy {
+namespace Stats {
+namespace MetricsService {
+
+/**
+ * All metrics service sink stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_METRICS_SERVICE_STATS(COUNTER)                                                         \
+  COUNTER(flushes_sent)                                                                            \
+  COUNTER(flushes_dropped)                                                                         \
+  COUNTER(stream_failures)
+// clang-format on
+
+/**
+ * Struct definition for all metrics service sink stats. @see stats_macros.h
+ */
+struct MetricsServiceStats {
+  ALL_METRICS_SERVICE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+typedef Grpc::AsyncClient<envoy::metrics::StreamMetricsMessage,
+                          envoy::metrics::StreamMetricsResponse>
+    MetricsServiceAsyncClient;
+typedef std::unique_ptr<MetricsServiceAsyncClient> MetricsServiceAsyncClientPtr;
+
+/**
+ * Stats sink which sends each flush as a single binary message on a long lived gRPC stream to a
+ * metrics service, instead of formatting a text line per metric. Flushes happen on the main
+ * thread, so there is one stream for the whole server. A flush which finds no stream and cannot
+ * start one is dropped; the counter deltas it held are not carried over to the next flush.
+ */
+class MetricsServiceSink : public Sink,
+                           public Grpc::AsyncStreamCallbacks<envoy::metrics::StreamMetricsResponse>,
+                           Logger::Loggable<Logger::Id::upstream> {
+public:
+  MetricsServiceSink(MetricsServiceAsyncClientPtr&& client, const LocalInfo::LocalInfo& local_info,
+                     SystemTimeSource& time_source, Scope& scope);
+
+  // Stats::Sink
+  void beginFlush() override;
+  void flushCounter(const Counter& counter, uint64_t delta) override;
+  void flushGauge(const Gauge& gauge, uint64_t value) override;
+  void flushHistogram(const ParentHistogram& histogram) override;
+  void endFlush() override;
+  // Histograms are sent from their merged interval statistics by flushHistogram().
+  void onHistogramComplete(const Histogram&, uint64_t) override {}
+
+  // Grpc::AsyncStreamCallbacks
+  void onCreateInitialMetadata(Http::HeaderMap&) override {}
+  void onReceiveInitialMetadata(Http::HeaderMapPtr&&) override {}
+  void onReceiveMessage(std::unique_ptr<envoy::metrics::StreamMetricsResponse>&&) override {}
+  void onReceiveTrailingMetadata(Http::HeaderMapPtr&&) override {}
+  void onRemoteClose(Grpc::Status::GrpcStatus status, const std::string& message) override;
+
+private:
+  MetricsServiceAsyncClientPtr client_;
+  const Protobuf::MethodDescriptor& service_method_;
+  const LocalInfo::LocalInfo& local_info_;
+  SystemTimeSource& time_source_;
+  MetricsServiceStats stats_;
+  Grpc::AsyncStream<envoy::metrics::StreamMetricsMessage>* stream_{};
+  envoy::metrics::StreamMetricsMessage message_;
+};
+
+} // namespace MetricsService
+} // namespace Stats
+} // namespace Envoy
@@ -3,8 +3,10 @@
 #include <string.h>
 
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <string>
+#include <unordered_set>
 
 #include "envoy/common/exception.h"
 
@@ -25,6 +27,69 @@ size_t roundUpMultipleNaturalAlignment(size_t val) {
   return (val + multiple - 1) & ~(multiple - 1);
 }
 
+/**
+ * The full name and tags of a stat of a StatsBlock, which keeps the block alive.
+ */
+class StatsBlockMetric : public virtual Metric {
+public:
+  StatsBlockMetric(const StatsBlockSharedPtr& block, const std::string& name,
+                   const StatsBlockList::TagExtractFn& extract_tags)
+      : block_(block), name_(block->prefix() + name),
+        tag_extracted_name_(extract_tags(name_, tags_)) {}
+
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::vector<Tag> tags() const override { return tags_; }
+  std::string tagExtractedName() const override { return tag_extracted_name_; }
+
+private:
+  const StatsBlockSharedPtr block_;
+  const std::string name_;
+  std::vector<Tag> tags_;
+  const std::string tag_extracted_name_;
+};
+
+class StatsBlockCounter : public Counter, public StatsBlockMetric {
+public:
+  StatsBlockCounter(const StatsBlockSharedPtr& block, Counter& counter,
+                    const StatsBlockList::TagExtractFn& extract_tags, uint64_t latched)
+      : StatsBlockMetric(block, counter.name(), extract_tags), counter_(counter),
+        latched_(latched) {}
+
+  // Stats::Counter
+  void add(uint64_t amount) override { counter_.add(amount); }
+  void inc() override { counter_.inc(); }
+  uint64_t latch() override { return latched_.exchange(0) + counter_.latch(); }
+  void reset() override { counter_.reset(); }
+  bool used() const override { return counter_.used(); }
+  uint64_t value() const override { return counter_.value(); }
+
+private:
+  Counter& counter_;
+  std::atomic<uint64_t> latched_;
+};
+
+class StatsBlockGauge : public Gauge, public StatsBlockMetric {
+public:
+  StatsBlockGauge(const StatsBlockSharedPtr& block, Gauge& gauge,
+                  const StatsBlockList::TagExtractFn& extract_tags)
+      : StatsBlockMetric(block, gauge.name(), extract_tags), gauge_(gauge) {}
+
+  // Stats::Gauge
+  void add(uint64_t amount) override { gauge_.add(amount); }
+  void dec() override { gauge_.dec(); }
+  void inc() override { gauge_.inc(); }
+  void set(uint64_t value) override { gauge_.set(value); }
+  void sub(uint64_t amount) override { gauge_.sub(amount); }
+  bool used() const override { return gauge_.used(); }
+  uint64_t value() const override { return gauge_.value(); }
+
+private:
+  Gauge& gauge_;
+};
+
+std::string noTags(const std::string& name, std::vector<Tag>&) { return name; }
+
 } // namespace
 
 size_t RawStatData::size() {
@@ -55,6 +120,100 @@ void RawStatData::configureForTestsOnly(Server::Options& options) {
   initializeAndGetMutableMaxObjNameLength(configured) = configured;
 }
 
+const size_t StatShard::CACHE_LINE_SIZE;
+
+uint32_t StatShard::threadIndex() {
+  static std::atomic<uint32_t> next_index{0};
+  static thread_local const uint32_t index = next_index++;
+  return index;
+}
+
+CounterImpl::CounterImpl(RawStatData& data, RawStatDataAllocator& alloc,
+                         DirtyCounterList& dirty_counters, std::string&& tag_extracted_name,
+                         std::vector<Tag>&& tags, SymbolTable& symbol_table)
+    : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table), data_(data),
+      alloc_(alloc), dirty_counters_(dirty_counters), num_shards_(configuredShards()),
+      shards_(num_shards_ > 1 ? new StatShard[num_shards_] : nullptr) {}
+
+CounterImpl::~CounterImpl() {
+  // The stat data may outlive the counter, as in the shared memory of a hot restart.
+  fold();
+  alloc_.free(data_);
+}
+
+std::atomic<uint32_t>& CounterImpl::configuredShards() {
+  // Like CONSTRUCT_ON_FIRST_USE, but non-const so that the value can be configured.
+  static std::atomic<uint32_t> num_shards{1};
+  return num_shards;
+}
+
+void CounterImpl::configure(Server::Options& options) {
+  const uint32_t configured = options.counterShards();
+  RELEASE_ASSERT(configured > 0);
+  configuredShards() = configured;
+}
+
+void CounterImpl::configureForTestsOnly(uint32_t num_shards) { configuredShards() = num_shards; }
+
+void CounterImpl::fold() {
+  if (!shards_) {
+    return;
+  }
+
+  uint64_t increment = 0;
+  for (uint32_t i = 0; i < num_shards_; i++) {
+    increment += shards_[i].value_.exchange(0, std::memory_order_relaxed);
+  }
+  if (increment > 0) {
+    data_.value_ += increment;
+    data_.pending_increment_ += increment;
+  }
+}
+
+uint64_t CounterImpl::value() const {
+  uint64_t value = data_.value_;
+  for (uint32_t i = 0; shards_ && i < num_shards_; i++) {
+    value += shards_[i].value_.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+ShardedPrimitiveGauge::ShardedPrimitiveGauge(const char* name)
+    : name_(name), num_shards_(configuredShards()), shards_(new StatShard[num_shards_]) {}
+
+std::atomic<uint32_t>& ShardedPrimitiveGauge::configuredShards() {
+  // Like CONSTRUCT_ON_FIRST_USE, but non-const so that the value can be configured.
+  static std::atomic<uint32_t> num_shards{1};
+  return num_shards;
+}
+
+void ShardedPrimitiveGauge::configure(Server::Options& options) {
+  const uint32_t configured = options.hostStatsShards();
+  RELEASE_ASSERT(configured > 0);
+  configuredShards() = configured;
+}
+
+void ShardedPrimitiveGauge::configureForTestsOnly(uint32_t num_shards) {
+  configuredShards() = num_shards;
+}
+
+void ShardedPrimitiveGauge::set(uint64_t value) {
+  shards_[0].value_ = value;
+  for (uint32_t i = 1; i < num_shards_; i++) {
+    shards_[i].value_ = 0;
+  }
+  markUsed();
+}
+
+uint64_t ShardedPrimitiveGauge::value() const {
+  // The shards wrap around when they go below zero, so their sum does too.
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < num_shards_; i++) {
+    value += shards_[i].value_.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
 std::string Utility::sanitizeStatsName(const std::string& name) {
   std::string stats_name = name;
   std::replace(stats_name.begin(), stats_name.end(), ':', '_');
@@ -62,7 +221,68 @@ std::string Utility::sanitizeStatsName(const std::string& name) {
 }
 
 TagExtractorImpl::TagExtractorImpl(const std::string& name, const std::string& regex)
-    : name_(name), regex_(regex) {}
+    : name_(name), regex_(Regex::Utility::parseRegex(regex)),
+      prefix_(literalPrefix(regex, anchored_)) {}
+
+std::string TagExtractorImpl::literalPrefix(const std::string& regex, bool& anchored) {
+  static const std::string METACHARACTERS = "\\^$.|?*+()[]{}";
+  anchored = !regex.empty() && regex[0] == '^';
+
+  // A top level alternation means that a match need not start with the first branch.
+  uint32_t depth = 0;
+  for (size_t i = 0; i < regex.size(); i++) {
+    if (regex[i] == '\\') {
+      i++;
+    } else if (regex[i] == '[') {
+      // Skip the character class, in which parentheses and '|' are literal.
+      for (i++; i < regex.size() && regex[i] != ']'; i++) {
+        if (regex[i] == '\\') {
+          i++;
+        }
+      }
+    } else if (regex[i] == '(') {
+      depth++;
+    } else if (regex[i] == ')') {
+      depth--;
+    } else if (regex[i] == '|' && depth == 0) {
+      return "";
+    }
+  }
+
+  std::string prefix;
+  size_t i = anchored ? 1 : 0;
+  while (i < regex.size()) {
+    char c;
+    size_t next;
+    if (regex[i] == '\\' && i + 1 < regex.size() && !isalnum(regex[i + 1])) {
+      // An escaped punctuation character stands for itself. Other escapes are classes or
+      // assertions.
+      c = regex[i + 1];
+      next = i + 2;
+    } else if (METACHARACTERS.find(regex[i]) == std::string::npos) {
+      c = regex[i];
+      next = i + 1;
+    } else {
+      break;
+    }
+
+    if (next < regex.size()) {
+      const char quantifier = regex[next];
+      if (quantifier == '?' || quantifier == '*' || quantifier == '{') {
+        // The character may be absent.
+        break;
+      }
+      if (quantifier == '+') {
+        // The character is present, but may be repeated.
+        prefix.push_back(c);
+        break;
+      }
+    }
+    prefix.push_back(c);
+    i = next;
+  }
+  return prefix;
+}
 
 TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
                                                      const std::string& regex) {
@@ -91,17 +311,24 @@ TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
 
 std::string TagExtractorImpl::extractTag(const std::string& tag_extracted_name,
                                          std::vector<Tag>& tags) const {
-  std::smatch match;
+  if (anchored_ ? tag_extracted_name.compare(0, prefix_.size(), prefix_) != 0
+                : tag_extracted_name.find(prefix_) == std::string::npos) {
+    return tag_extracted_name;
+  }
+
+  const char* begin = tag_extracted_name.data();
+  const char* end = begin + tag_extracted_name.size();
+  std::vector<Regex::MatchGroup> match;
   // The regex must match and contain one or more subexpressions (all after the first are ignored).
-  if (std::regex_search(tag_extracted_name, match, regex_) && match.size() > 1) {
+  if (regex_->search(begin, end, match) && match.size() > 1 && match[1].matched()) {
     // remove_subexpr is the first submatch. It represents the portion of the string to be removed.
-    const auto& remove_subexpr = match[1];
+    const Regex::MatchGroup& remove_subexpr = match[1];
 
     // value_subexpr is the optional second submatch. It is usually inside the first submatch
     // (remove_subexpr) to allow the expression to strip off extra characters that should be removed
     // from the string but also not necessary in the tag value ("." for example). If there is no
     // second submatch, then the value_subexpr is the same as the remove_subexpr.
-    const auto& value_subexpr = match.size() > 2 ? match[2] : remove_subexpr;
+    const Regex::MatchGroup& value_subexpr = match.size() > 2 ? match[2] : remove_subexpr;
 
     tags.emplace_back();
     Tag& tag = tags.back();
@@ -109,8 +336,7 @@ std::string TagExtractorImpl::extractTag(const std::string& tag_extracted_name,
     tag.value_ = value_subexpr.str();
 
     // Reconstructs the tag_extracted_name without remove_subexpr.
-    return std::string(match.prefix().first, remove_subexpr.first)
-        .append(remove_subexpr.second, match.suffix().second);
+    return std::string(begin, remove_subexpr.begin_).append(remove_subexpr.end_, end);
   }
   return tag_extracted_name;
 }
@@ -128,6 +354,135 @@ void HeapRawStatDataAllocator::free(RawStatData& data) {
   ::free(&data);
 }
 
+MetricImpl::MetricImpl(std::string&& tag_extracted_name, std::vector<Tag>&& tags,
+                       SymbolTable& symbol_table)
+    : symbol_table_(symbol_table), tag_extracted_name_(symbol_table.encode(tag_extracted_name)) {
+  tags_.reserve(tags.size() * 2);
+  for (const Tag& tag : tags) {
+    tags_.push_back(symbol_table.encode(tag.name_));
+    tags_.push_back(symbol_table.encode(tag.value_));
+  }
+}
+
+MetricImpl::~MetricImpl() {
+  symbol_table_.free(tag_extracted_name_);
+  for (StatName& tag : tags_) {
+    symbol_table_.free(tag);
+  }
+}
+
+std::string MetricImpl::tagExtractedName() const {
+  return symbol_table_.decode(tag_extracted_name_);
+}
+
+std::vector<Tag> MetricImpl::tags() const {
+  std::vector<Tag> tags;
+  tags.reserve(tags_.size() / 2);
+  for (size_t i = 0; i < tags_.size(); i += 2) {
+    tags.push_back({symbol_table_.decode(tags_[i]), symbol_table_.decode(tags_[i + 1])});
+  }
+  return tags;
+}
+
+void DirtyCounterList::add(std::shared_ptr<CounterImpl>&& counter) {
+  std::unique_lock<std::mutex> lock(lock_);
+  counters_.push_back(std::move(counter));
+}
+
+std::list<CounterSharedPtr> DirtyCounterList::take() {
+  std::vector<std::shared_ptr<CounterImpl>> counters;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    counters.swap(counters_);
+  }
+
+  // Clearing the flag lets the next increment add the counter again. An increment which lands in
+  // between is still seen by the caller, which latches the counter after this.
+  std::list<CounterSharedPtr> ret;
+  for (std::shared_ptr<CounterImpl>& counter : counters) {
+    counter->dirty_ = false;
+    ret.push_back(std::move(counter));
+  }
+  return ret;
+}
+
+void StatsBlockList::add(StatsBlockSharedPtr&& block) {
+  std::unique_lock<std::mutex> lock(lock_);
+  blocks_.emplace_back(block);
+}
+
+std::vector<StatsBlockSharedPtr> StatsBlockList::liveBlocks() const {
+  std::vector<StatsBlockSharedPtr> live;
+  std::unique_lock<std::mutex> lock(lock_);
+  auto kept = blocks_.begin();
+  for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+    StatsBlockSharedPtr block = it->lock();
+    if (block) {
+      *kept++ = *it;
+      live.push_back(std::move(block));
+    }
+  }
+  blocks_.erase(kept, blocks_.end());
+  std::reverse(live.begin(), live.end());
+  return live;
+}
+
+void StatsBlockList::counters(std::list<CounterSharedPtr>& list,
+                              const TagExtractFn& extract_tags) const {
+  std::unordered_set<std::string> prefixes;
+  for (const StatsBlockSharedPtr& block : liveBlocks()) {
+    if (prefixes.insert(block->prefix()).second) {
+      block->forEachCounter([&](Counter& counter) -> void {
+        list.push_back(std::make_shared<StatsBlockCounter>(block, counter, extract_tags, 0));
+      });
+    }
+  }
+}
+
+void StatsBlockList::dirtyCounters(std::list<CounterSharedPtr>& list,
+                                   const TagExtractFn& extract_tags) {
+  // Unlike counters(), the blocks which share a prefix are all visited, so that no increment is
+  // lost. Each sink then sees one delta per block under the same name.
+  for (const StatsBlockSharedPtr& block : liveBlocks()) {
+    block->forEachCounter([&](Counter& counter) -> void {
+      const uint64_t delta = counter.latch();
+      if (delta > 0) {
+        list.push_back(std::make_shared<StatsBlockCounter>(block, counter, extract_tags, delta));
+      }
+    });
+  }
+}
+
+void StatsBlockList::gauges(std::list<GaugeSharedPtr>& list,
+                            const TagExtractFn& extract_tags) const {
+  std::unordered_set<std::string> prefixes;
+  for (const StatsBlockSharedPtr& block : liveBlocks()) {
+    if (prefixes.insert(block->prefix()).second) {
+      block->forEachGauge([&](Gauge& gauge) -> void {
+        list.push_back(std::make_shared<StatsBlockGauge>(block, gauge, extract_tags));
+      });
+    }
+  }
+}
+
+std::list<CounterSharedPtr> IsolatedStoreImpl::counters() const {
+  std::list<CounterSharedPtr> list = counters_.toList();
+  blocks_.counters(list, noTags);
+  return list;
+}
+
+std::list<CounterSharedPtr> IsolatedStoreImpl::dirtyCounters() {
+  std::list<CounterSharedPtr> list = dirty_counters_.take();
+  blocks_.dirtyCounters(list, noTags);
+  return list;
+}
+
+std::list<GaugeSharedPtr> IsolatedStoreImpl::gauges() const {
+  std::list<GaugeSharedPtr> list = gauges_.toList();
+  blocks_.gauges(list, noTags);
+  return list;
+}
+
 void RawStatData::initialize(const std::string& name) {
   ASSERT(!initialized());
   ASSERT(name.size() <= maxNameLength());
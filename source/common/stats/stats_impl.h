@@ -6,17 +6,20 @@
 #include <functional>
 #include <list>
 #include <memory>
-#include <regex>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "envoy/common/time.h"
 #include "envoy/server/options.h"
 #include "envoy/stats/stats.h"
 
 #include "common/common/assert.h"
+#include "common/common/regex.h"
 #include "common/common/singleton.h"
 #include "common/protobuf/protobuf.h"
+#include "common/stats/symbol_table.h"
 
 #include "api/bootstrap.pb.h"
 
@@ -39,9 +42,22 @@ public:
   std::string extractTag(const std::string& tag_extracted_name,
                          std::vector<Tag>& tags) const override;
 
+  /**
+   * Find the literal text that every match of a regex starts with.
+   * @param regex supplies the regex.
+   * @param anchored receives whether the regex is anchored to the start of the subject, in which
+   *        case the subject must start with the literal rather than merely contain it.
+   * @return std::string the literal, which is empty if the regex does not start with one.
+   */
+  static std::string literalPrefix(const std::string& regex, bool& anchored);
+
 private:
   const std::string name_;
-  const std::regex regex_;
+  const Regex::CompiledMatcherPtr regex_;
+  // Names which cannot match are rejected with a plain string comparison, so that the regex only
+  // runs on names which start with (or contain, if the regex is not anchored) this literal.
+  bool anchored_;
+  const std::string prefix_;
 };
 
 /**
@@ -159,7 +175,8 @@ private:
 };
 
 /**
- * Abstract interface for allocating a RawStatData.
+ * Abstract interface for allocating a RawStatData. Implementations must be thread safe, as stats
+ * are allocated and freed from any thread.
  */
 class RawStatDataAllocator {
 public:
@@ -186,46 +203,185 @@ public:
  */
 class MetricImpl : public virtual Metric {
 public:
-  MetricImpl(const std::string& name, std::string&& tag_extracted_name, std::vector<Tag>&& tags)
-      : name_(name), tag_extracted_name_(std::move(tag_extracted_name)), tags_(std::move(tags)) {}
+  /**
+   * The tag extracted name and tags are kept encoded in symbol_table, which must outlive the
+   * metric.
+   */
+  MetricImpl(std::string&& tag_extracted_name, std::vector<Tag>&& tags,
+             SymbolTable& symbol_table);
+  ~MetricImpl();
 
-  const std::string& name() const override { return name_; }
-  const std::string& tagExtractedName() const override { return tag_extracted_name_; }
-  const std::vector<Tag>& tags() const override { return tags_; }
+  std::string tagExtractedName() const override;
+  std::vector<Tag> tags() const override;
+
+protected:
+  SymbolTable& symbolTable() const { return symbol_table_; }
 
 private:
-  const std::string name_;
-  const std::string tag_extracted_name_;
-  const std::vector<Tag> tags_;
+  SymbolTable& symbol_table_;
+  StatName tag_extracted_name_;
+  // The name and then the value of each tag.
+  std::vector<StatName> tags_;
 };
 
+class CounterImpl;
+
 /**
- * Counter implementation that wraps a RawStatData.
+ * A shard of a sharded stat, padded so that the values of two shards are never on the same cache
+ * line.
  */
-class CounterImpl : public Counter, public MetricImpl {
+struct StatShard {
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  /**
+   * @return uint32_t the index of the calling thread. Threads are numbered in the order in which
+   *         they first update a sharded stat, and update the shard of their index modulo the
+   *         number of shards.
+   */
+  static uint32_t threadIndex();
+
+  std::atomic<uint64_t> value_{};
+  char padding_[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+};
+
+/**
+ * The counters of a store which have been incremented since they were last taken from the list, so
+ * that a flush only visits the counters which changed. The list holds a reference to each counter,
+ * so that the last increments of a counter which is released before the flush are not lost.
+ */
+class DirtyCounterList {
 public:
-  CounterImpl(RawStatData& data, RawStatDataAllocator& alloc, std::string&& tag_extracted_name,
-              std::vector<Tag>&& tags)
-      : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
-        alloc_(alloc) {}
-  ~CounterImpl() { alloc_.free(data_); }
+  void add(std::shared_ptr<CounterImpl>&& counter);
+
+  /**
+   * @return the counters added since the last call, each once. A counter is added again by its
+   *         next increment.
+   */
+  std::list<CounterSharedPtr> take();
+
+private:
+  std::mutex lock_;
+  std::vector<std::shared_ptr<CounterImpl>> counters_;
+};
+
+/**
+ * The stats blocks added to a store. Blocks are kept as weak pointers, and dropped from the list
+ * once released. The stats of a block are listed wrapped in a metric which holds a reference to
+ * the block, with the full name and its tags. The increments of a released block which were not
+ * yet taken as dirty counters are lost.
+ */
+class StatsBlockList {
+public:
+  /**
+   * Extracts the tags of a full stat name, @see TagExtractor.
+   * @return std::string the name with the tags removed.
+   */
+  typedef std::function<std::string(const std::string& name, std::vector<Tag>& tags)>
+      TagExtractFn;
+
+  void add(StatsBlockSharedPtr&& block);
+
+  /**
+   * Append the counters of all blocks. When blocks share a prefix, such as the blocks of two
+   * versions of a cluster, only the counters of the block added last are listed.
+   */
+  void counters(std::list<CounterSharedPtr>& list, const TagExtractFn& extract_tags) const;
+
+  /**
+   * Append the counters of all blocks which were incremented since the last call. Their pending
+   * increments are latched here, and returned by the next latch() of the listed counter.
+   */
+  void dirtyCounters(std::list<CounterSharedPtr>& list, const TagExtractFn& extract_tags);
+
+  /**
+   * Append the gauges of all blocks, @see counters().
+   */
+  void gauges(std::list<GaugeSharedPtr>& list, const TagExtractFn& extract_tags) const;
+
+private:
+  // Newest first, pruning the released blocks.
+  std::vector<StatsBlockSharedPtr> liveBlocks() const;
+
+  mutable std::mutex lock_;
+  mutable std::vector<std::weak_ptr<StatsBlock>> blocks_;
+};
+
+/**
+ * Counter implementation that wraps a RawStatData. It must be owned by a shared_ptr, as it adds
+ * itself to the store's DirtyCounterList. When counters are sharded, increments go to the shard
+ * of the calling thread rather than to the RawStatData, so that the threads incrementing a hot
+ * counter do not contend on its cache line. latch() folds the shards into the RawStatData, and
+ * value() adds the increments not folded yet.
+ */
+class CounterImpl : public Counter,
+                    public MetricImpl,
+                    public std::enable_shared_from_this<CounterImpl> {
+public:
+  CounterImpl(RawStatData& data, RawStatDataAllocator& alloc, DirtyCounterList& dirty_counters,
+              std::string&& tag_extracted_name, std::vector<Tag>&& tags, SymbolTable& symbol_table);
+  ~CounterImpl();
+
+  /**
+   * Configure the number of shards of the counters constructed afterwards. This MUST be called
+   * before any counter is constructed, or the counters constructed before are not sharded.
+   */
+  static void configure(Server::Options& options);
+
+  /**
+   * Allow tests to change the number of shards of the counters constructed afterwards.
+   */
+  static void configureForTestsOnly(uint32_t num_shards);
+
+  // Stats::Metric
+  std::string name() const override { return data_.name_; }
 
   // Stats::Counter
   void add(uint64_t amount) override {
-    data_.value_ += amount;
-    data_.pending_increment_ += amount;
-    data_.flags_ |= RawStatData::Flags::Used;
+    if (shards_) {
+      shards_[StatShard::threadIndex() % num_shards_].value_.fetch_add(amount,
+                                                                       std::memory_order_relaxed);
+      // Only written once, so that the cache line stays shared between the threads.
+      if (!(data_.flags_.load(std::memory_order_relaxed) & RawStatData::Flags::Used)) {
+        data_.flags_ |= RawStatData::Flags::Used;
+      }
+    } else {
+      data_.value_ += amount;
+      data_.pending_increment_ += amount;
+      data_.flags_ |= RawStatData::Flags::Used;
+    }
+    // Only the first increment since the counter was taken from the list takes the list's lock.
+    if (!dirty_.load(std::memory_order_relaxed) && !dirty_.exchange(true)) {
+      dirty_counters_.add(shared_from_this());
+    }
   }
 
   void inc() override { add(1); }
-  uint64_t latch() override { return data_.pending_increment_.exchange(0); }
-  void reset() override { data_.value_ = 0; }
+  uint64_t latch() override {
+    fold();
+    return data_.pending_increment_.exchange(0);
+  }
+  void reset() override {
+    fold();
+    data_.value_ = 0;
+  }
   bool used() const override { return data_.flags_ & RawStatData::Flags::Used; }
-  uint64_t value() const override { return data_.value_; }
+  uint64_t value() const override;
 
 private:
+  static std::atomic<uint32_t>& configuredShards();
+
+  // Moves the increments of the shards to the RawStatData.
+  void fold();
+
   RawStatData& data_;
   RawStatDataAllocator& alloc_;
+  DirtyCounterList& dirty_counters_;
+  std::atomic<bool> dirty_{};
+  const uint32_t num_shards_;
+  // Only allocated with more than one shard.
+  std::unique_ptr<StatShard[]> shards_;
+
+  friend class DirtyCounterList;
 };
 
 /**
@@ -234,11 +390,14 @@ private:
 class GaugeImpl : public Gauge, public MetricImpl {
 public:
   GaugeImpl(RawStatData& data, RawStatDataAllocator& alloc, std::string&& tag_extracted_name,
-            std::vector<Tag>&& tags)
-      : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
+            std::vector<Tag>&& tags, SymbolTable& symbol_table)
+      : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table), data_(data),
         alloc_(alloc) {}
   ~GaugeImpl() { alloc_.free(data_); }
 
+  // Stats::Metric
+  std::string name() const override { return data_.name_; }
+
   // Stats::Gauge
   virtual void add(uint64_t amount) override {
     data_.value_ += amount;
@@ -263,19 +422,183 @@ private:
   RawStatDataAllocator& alloc_;
 };
 
+/**
+ * Counter which does not belong to a store: only the values, with a name which must outlive it,
+ * typically a string literal. For stats which exist in large numbers under the same names, such
+ * as the per host stats of a cluster, where a store per instance would cost far more than the
+ * values. Not flushed to sinks.
+ */
+class PrimitiveCounter : public Counter {
+public:
+  explicit PrimitiveCounter(const char* name) : name_(name) {}
+
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::vector<Tag> tags() const override { return {}; }
+  std::string tagExtractedName() const override { return name_; }
+
+  // Stats::Counter
+  void add(uint64_t amount) override {
+    value_ += amount;
+    pending_increment_ += amount;
+    used_ = true;
+  }
+  void inc() override { add(1); }
+  uint64_t latch() override {
+    // Most counters are not incremented between two flushes: only write when there is something
+    // to take, so that latching does not take the cache line from the threads updating it.
+    if (pending_increment_.load(std::memory_order_relaxed) == 0) {
+      return 0;
+    }
+    return pending_increment_.exchange(0);
+  }
+  void reset() override { value_ = 0; }
+  bool used() const override { return used_; }
+  uint64_t value() const override { return value_; }
+
+private:
+  const char* const name_;
+  std::atomic<uint64_t> value_{};
+  std::atomic<uint64_t> pending_increment_{};
+  std::atomic<bool> used_{};
+};
+
+/**
+ * Gauge which does not belong to a store. @see PrimitiveCounter.
+ */
+class PrimitiveGauge : public Gauge {
+public:
+  explicit PrimitiveGauge(const char* name) : name_(name) {}
+
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::vector<Tag> tags() const override { return {}; }
+  std::string tagExtractedName() const override { return name_; }
+
+  // Stats::Gauge
+  void add(uint64_t amount) override {
+    value_ += amount;
+    used_ = true;
+  }
+  void dec() override { sub(1); }
+  void inc() override { add(1); }
+  void set(uint64_t value) override {
+    value_ = value;
+    used_ = true;
+  }
+  void sub(uint64_t amount) override {
+    ASSERT(value_ >= amount);
+    ASSERT(used());
+    value_ -= amount;
+  }
+  bool used() const override { return used_; }
+  uint64_t value() const override { return value_; }
+
+private:
+  const char* const name_;
+  std::atomic<uint64_t> value_{};
+  std::atomic<bool> used_{};
+};
+
+/**
+ * Gauge which does not belong to a store, with its value split into shards on separate cache lines.
+ * Each thread updates the shard picked when it first used a sharded gauge, so that threads which
+ * all update the same gauge, such as the workers updating the active requests of a host, do not
+ * contend on a single cache line. Reading the value sums the shards: it is slower than reading a
+ * PrimitiveGauge and, while other threads update the gauge, approximate. A shard can go below zero
+ * when a thread decrements what another incremented: only the sum is meaningful.
+ */
+class ShardedPrimitiveGauge : public Gauge {
+public:
+  explicit ShardedPrimitiveGauge(const char* name);
+
+  /**
+   * Configure the number of shards of the gauges constructed afterwards. This MUST be called before
+   * any gauge is constructed, gauges have a single shard otherwise.
+   */
+  static void configure(Server::Options& options);
+
+  /**
+   * Allow tests to change the number of shards of the gauges constructed afterwards.
+   */
+  static void configureForTestsOnly(uint32_t num_shards);
+
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::vector<Tag> tags() const override { return {}; }
+  std::string tagExtractedName() const override { return name_; }
+
+  // Stats::Gauge
+  void add(uint64_t amount) override {
+    shard().value_.fetch_add(amount, std::memory_order_relaxed);
+    markUsed();
+  }
+  void dec() override { sub(1); }
+  void inc() override { add(1); }
+  void set(uint64_t value) override;
+  void sub(uint64_t amount) override {
+    ASSERT(used());
+    shard().value_.fetch_sub(amount, std::memory_order_relaxed);
+  }
+  bool used() const override { return used_; }
+  uint64_t value() const override;
+
+private:
+  static std::atomic<uint32_t>& configuredShards();
+
+  StatShard& shard() {
+    return shards_[num_shards_ == 1 ? 0 : StatShard::threadIndex() % num_shards_];
+  }
+  void markUsed() {
+    // Only written once, so that the cache line stays shared between the threads updating shards.
+    if (!used_.load(std::memory_order_relaxed)) {
+      used_ = true;
+    }
+  }
+
+  const char* const name_;
+  const uint32_t num_shards_;
+  std::unique_ptr<StatShard[]> shards_;
+  std::atomic<bool> used_{};
+};
+
+/**
+ * Helpers for a struct of primitive stats, and for instantiating a stats struct from it.
+ *   struct MyCoolPrimitiveStats {
+ *     MY_COOL_STATS(GENERATE_PRIMITIVE_COUNTER_STRUCT, GENERATE_PRIMITIVE_GAUGE_STRUCT)
+ *   };
+ *   MyCoolStats stats{MY_COOL_STATS(PRIMITIVE_STAT(primitive_stats), PRIMITIVE_STAT(...))};
+ */
+#define GENERATE_PRIMITIVE_COUNTER_STRUCT(NAME) Stats::PrimitiveCounter NAME##_{#NAME};
+#define GENERATE_PRIMITIVE_GAUGE_STRUCT(NAME) Stats::PrimitiveGauge NAME##_{#NAME};
+#define GENERATE_SHARDED_PRIMITIVE_GAUGE_STRUCT(NAME) Stats::ShardedPrimitiveGauge NAME##_{#NAME};
+// For the kinds of stats, such as histograms, which are left out of a struct of primitive stats.
+#define IGNORE_PRIMITIVE_STAT(NAME)
+
+#define FINISH_PRIMITIVE_STAT_DECL_(X) X##_,
+#define PRIMITIVE_STAT(STATS) (STATS).FINISH_PRIMITIVE_STAT_DECL_
+
 /**
  * Histogram implementation for the heap.
  */
 class HistogramImpl : public Histogram, public MetricImpl {
 public:
   HistogramImpl(const std::string& name, Store& parent, std::string&& tag_extracted_name,
-                std::vector<Tag>&& tags)
-      : MetricImpl(name, std::move(tag_extracted_name), std::move(tags)), parent_(parent) {}
+                std::vector<Tag>&& tags, SymbolTable& symbol_table)
+      : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table),
+        parent_(parent), name_(symbol_table.encode(name)) {}
+  ~HistogramImpl() { symbolTable().free(name_); }
+
+  // Stats::Metric
+  std::string name() const override { return symbolTable().decode(name_); }
 
   // Stats::Histogram
   void recordValue(uint64_t value) override { parent_.deliverHistogramToSinks(*this, value); }
 
   Store& parent_;
+
+private:
+  StatName name_;
 };
 
 /**
@@ -330,14 +653,16 @@ class IsolatedStoreImpl : public Store {
 public:
   IsolatedStoreImpl()
       : counters_([this](const std::string& name) -> CounterImpl* {
-          return new CounterImpl(*alloc_.alloc(name), alloc_, std::string(name),
-                                 std::vector<Tag>());
+          return new CounterImpl(*alloc_.alloc(name), alloc_, dirty_counters_, std::string(name),
+                                 std::vector<Tag>(), symbol_table_);
         }),
         gauges_([this](const std::string& name) -> GaugeImpl* {
-          return new GaugeImpl(*alloc_.alloc(name), alloc_, std::string(name), std::vector<Tag>());
+          return new GaugeImpl(*alloc_.alloc(name), alloc_, std::string(name), std::vector<Tag>(),
+                               symbol_table_);
         }),
         histograms_([this](const std::string& name) -> HistogramImpl* {
-          return new HistogramImpl(name, *this, std::string(name), std::vector<Tag>());
+          return new HistogramImpl(name, *this, std::string(name), std::vector<Tag>(),
+                                   symbol_table_);
         }) {}
 
   // Stats::Scope
@@ -353,8 +678,11 @@ public:
   }
 
   // Stats::Store
-  std::list<CounterSharedPtr> counters() const override { return counters_.toList(); }
-  std::list<GaugeSharedPtr> gauges() const override { return gauges_.toList(); }
+  std::list<CounterSharedPtr> counters() const override;
+  std::list<CounterSharedPtr> dirtyCounters() override;
+  std::list<GaugeSharedPtr> gauges() const override;
+  std::list<ParentHistogramSharedPtr> histograms() const override { return {}; }
+  void addStatsBlock(StatsBlockSharedPtr block) override { blocks_.add(std::move(block)); }
 
 private:
   struct ScopeImpl : public Scope {
@@ -376,10 +704,13 @@ private:
     const std::string prefix_;
   };
 
+  SymbolTable symbol_table_;
   HeapRawStatDataAllocator alloc_;
+  DirtyCounterList dirty_counters_;
   IsolatedStatsCache<Counter, CounterImpl> counters_;
   IsolatedStatsCache<Gauge, GaugeImpl> gauges_;
   IsolatedStatsCache<Histogram, HistogramImpl> histograms_;
+  StatsBlockList blocks_;
 };
 
 } // namespace Stats
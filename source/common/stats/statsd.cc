@@ -1,8 +1,12 @@
 #include "common/stats/statsd.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
@@ -18,6 +22,31 @@ namespace Envoy {
 namespace Stats {
 namespace Statsd {
 
+namespace {
+
+/**
+ * Flush the interval quantiles of a histogram as one gauge per quantile, e.g. "foo.p99_9" for the
+ * 99.9th percentile of "foo". Nothing is flushed if no values were recorded during the interval.
+ */
+void flushHistogramQuantiles(const ParentHistogram& histogram,
+                             std::function<void(const std::string&, uint64_t)> flush_gauge) {
+  const HistogramStatistics& statistics = histogram.intervalStatistics();
+  if (statistics.sampleCount() == 0) {
+    return;
+  }
+
+  const std::string name = histogram.name();
+  const std::vector<double>& quantiles = statistics.supportedQuantiles();
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    std::string quantile = fmt::format("{:g}", 100 * quantiles[i]);
+    std::replace(quantile.begin(), quantile.end(), '.', '_');
+    flush_gauge(fmt::format("{}.p{}", name, quantile),
+                std::llround(statistics.computedQuantiles()[i]));
+  }
+}
+
+} // namespace
+
 Writer::Writer(Network::Address::InstanceConstSharedPtr address) {
   fd_ = address->socket(Network::Address::SocketType::Datagram);
   ASSERT(fd_ != -1);
@@ -48,8 +77,31 @@ void Writer::writeTimer(const std::string& name, const std::chrono::milliseconds
   send(message);
 }
 
+void Writer::endBatch() {
+  sendBuffer();
+  batching_ = false;
+}
+
 void Writer::send(const std::string& message) {
-  ::send(fd_, message.c_str(), message.size(), MSG_DONTWAIT);
+  if (!batching_) {
+    ::send(fd_, message.c_str(), message.size(), MSG_DONTWAIT);
+    return;
+  }
+
+  if (!buffer_.empty() && buffer_.size() + 1 + message.size() > MAX_DATAGRAM_BYTES) {
+    sendBuffer();
+  }
+  if (!buffer_.empty()) {
+    buffer_.push_back('\n');
+  }
+  buffer_.append(message);
+}
+
+void Writer::sendBuffer() {
+  if (!buffer_.empty()) {
+    ::send(fd_, buffer_.c_str(), buffer_.size(), MSG_DONTWAIT);
+    buffer_.clear();
+  }
 }
 
 UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
@@ -68,6 +120,13 @@ void UdpStatsdSink::flushGauge(const Gauge& gauge, uint64_t value) {
   tls_->getTyped<Writer>().writeGauge(gauge.name(), value);
 }
 
+void UdpStatsdSink::flushHistogram(const ParentHistogram& histogram) {
+  Writer& writer = tls_->getTyped<Writer>();
+  flushHistogramQuantiles(histogram, [&writer](const std::string& name, uint64_t value) -> void {
+    writer.writeGauge(name, value);
+  });
+}
+
 void UdpStatsdSink::onHistogramComplete(const Histogram& histogram, uint64_t value) {
   // For statsd histograms are all timers.
   tls_->getTyped<Writer>().writeTimer(histogram.name(), std::chrono::milliseconds(value));
@@ -89,6 +148,13 @@ TcpStatsdSink::TcpStatsdSink(const LocalInfo::LocalInfo& local_info,
   });
 }
 
+void TcpStatsdSink::flushHistogram(const ParentHistogram& histogram) {
+  TlsSink& sink = tls_->getTyped<TlsSink>();
+  flushHistogramQuantiles(histogram, [&sink](const std::string& name, uint64_t value) -> void {
+    sink.flushGauge(name, value);
+  });
+}
+
 TcpStatsdSink::TlsSink::TlsSink(TcpStatsdSink& parent, Event::Dispatcher& dispatcher)
     : parent_(parent), dispatcher_(dispatcher) {}
 
@@ -17,7 +17,9 @@ namespace Stats {
 namespace Statsd {
 
 /**
- * This is a simple UDP localhost writer for statsd messages.
+ * This is a simple UDP localhost writer for statsd messages. Between beginBatch() and endBatch()
+ * messages are buffered and sent newline separated, as many to a datagram as fit in
+ * MAX_DATAGRAM_BYTES. Outside of a batch each message is sent immediately.
  */
 class Writer : public ThreadLocal::ThreadLocalObject {
 public:
@@ -28,13 +30,23 @@ public:
   void writeGauge(const std::string& name, uint64_t value);
   void writeTimer(const std::string& name, const std::chrono::milliseconds& ms);
 
+  void beginBatch() { batching_ = true; }
+  void endBatch();
+
   // Called in unit test to validate address.
   int getFdForTests() const { return fd_; };
 
+  // Largest datagram that fits in a 1500 byte Ethernet MTU once IP and UDP headers are added,
+  // which is what statsd servers conventionally expect.
+  static constexpr uint32_t MAX_DATAGRAM_BYTES = 1432;
+
 private:
   void send(const std::string& message);
+  void sendBuffer();
 
   int fd_;
+  bool batching_{};
+  std::string buffer_;
 };
 
 /**
@@ -45,10 +57,11 @@ public:
   UdpStatsdSink(ThreadLocal::SlotAllocator& tls, Network::Address::InstanceConstSharedPtr address);
 
   // Stats::Sink
-  void beginFlush() override {}
+  void beginFlush() override { tls_->getTyped<Writer>().beginBatch(); }
   void flushCounter(const Counter& counter, uint64_t delta) override;
   void flushGauge(const Gauge& gauge, uint64_t value) override;
-  void endFlush() override {}
+  void flushHistogram(const ParentHistogram& histogram) override;
+  void endFlush() override { tls_->getTyped<Writer>().endBatch(); }
   void onHistogramComplete(const Histogram& histogram, uint64_t value) override;
 
   // Called in unit test to validate writer construction and address.
@@ -79,6 +92,8 @@ public:
     tls_->getTyped<TlsSink>().flushGauge(gauge.name(), value);
   }
 
+  void flushHistogram(const ParentHistogram& histogram) override;
+
   void endFlush() override { tls_->getTyped<TlsSink>().endFlush(true); }
 
   void onHistogramComplete(const Histogram& histogram, uint64_t value) override {
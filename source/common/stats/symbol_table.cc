@@ -0,0 +1,123 @@
+#include "common/stats/symbol_table.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Envoy {
+namespace Stats {
+
+namespace {
+
+void appendVarint(uint32_t value, std::vector<uint8_t>& bytes) {
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t readVarint(const uint8_t*& data) {
+  uint32_t value = 0;
+  for (uint32_t shift = 0;; shift += 7) {
+    const uint8_t byte = *data++;
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+}
+
+} // namespace
+
+StatName SymbolTable::encode(const std::string& name) {
+  // The encoding is the number of segments followed by the symbol of each segment.
+  std::vector<uint8_t> bytes;
+  uint32_t num_segments = 1;
+  for (char c : name) {
+    num_segments += c == '.';
+  }
+  appendVarint(num_segments, bytes);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  size_t start = 0;
+  while (true) {
+    const size_t end = name.find('.', start);
+    appendVarint(toSymbol(name.substr(start, end - start)), bytes);
+    if (end == std::string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+
+  StatName stat_name;
+  stat_name.data_.reset(new uint8_t[bytes.size()]);
+  std::copy(bytes.begin(), bytes.end(), stat_name.data_.get());
+  return stat_name;
+}
+
+std::string SymbolTable::decode(const StatName& stat_name) const {
+  ASSERT(!stat_name.empty());
+  const uint8_t* data = stat_name.data_.get();
+  const uint32_t num_segments = readVarint(data);
+
+  std::string name;
+  std::unique_lock<std::mutex> lock(lock_);
+  for (uint32_t i = 0; i < num_segments; i++) {
+    if (i > 0) {
+      name.push_back('.');
+    }
+    name.append(*decode_map_[readVarint(data)]);
+  }
+  return name;
+}
+
+void SymbolTable::free(StatName& stat_name) {
+  ASSERT(!stat_name.empty());
+  const uint8_t* data = stat_name.data_.get();
+  const uint32_t num_segments = readVarint(data);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  for (uint32_t i = 0; i < num_segments; i++) {
+    const Symbol symbol = readVarint(data);
+    auto shared_symbol = encode_map_.find(*decode_map_[symbol]);
+    ASSERT(shared_symbol != encode_map_.end());
+    if (--shared_symbol->second.ref_count_ == 0) {
+      decode_map_[symbol] = nullptr;
+      free_symbols_.push_back(symbol);
+      encode_map_.erase(shared_symbol);
+    }
+  }
+
+  stat_name.data_.reset();
+}
+
+size_t SymbolTable::size() const {
+  std::unique_lock<std::mutex> lock(lock_);
+  return encode_map_.size();
+}
+
+SymbolTable::Symbol SymbolTable::toSymbol(const std::string& segment) {
+  auto shared_symbol = encode_map_.find(segment);
+  if (shared_symbol != encode_map_.end()) {
+    shared_symbol->second.ref_count_++;
+    return shared_symbol->second.symbol_;
+  }
+
+  Symbol symbol;
+  if (free_symbols_.empty()) {
+    symbol = decode_map_.size();
+    decode_map_.push_back(nullptr);
+  } else {
+    symbol = free_symbols_.back();
+    free_symbols_.pop_back();
+  }
+
+  shared_symbol = encode_map_.emplace(segment, SharedSymbol{symbol, 1}).first;
+  decode_map_[symbol] = &shared_symbol->first;
+  return symbol;
+}
+
+} // namespace Stats
+} // namespace Envoy
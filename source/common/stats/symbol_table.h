@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * A stat name encoded by a SymbolTable: the '.' separated segments of the name, each replaced by a
+ * varint encoded symbol. Stat names repeat the same segments (cluster names, "upstream_rq" etc.)
+ * across many stats, so an encoded name is a few bytes regardless of the length of its segments.
+ * A StatName must be freed by the table which encoded it before it is destroyed.
+ */
+class StatName {
+public:
+  StatName() {}
+  StatName(StatName&&) = default;
+  StatName& operator=(StatName&&) = default;
+  ~StatName() { ASSERT(data_ == nullptr); }
+
+  bool empty() const { return data_ == nullptr; }
+
+private:
+  std::unique_ptr<uint8_t[]> data_;
+
+  friend class SymbolTable;
+};
+
+/**
+ * Reference counted table of the segments of stat names. Thread safe.
+ */
+class SymbolTable : NonCopyable {
+public:
+  ~SymbolTable() { ASSERT(encode_map_.empty()); }
+
+  /**
+   * Encode a stat name, taking a reference on each of its segments.
+   * @param name supplies the name to encode.
+   * @return StatName the encoded name.
+   */
+  StatName encode(const std::string& name);
+
+  /**
+   * @param stat_name supplies a name encoded by this table.
+   * @return std::string the name that was encoded.
+   */
+  std::string decode(const StatName& stat_name) const;
+
+  /**
+   * Release the references on the segments of an encoded name. The name is left empty.
+   * @param stat_name supplies a name encoded by this table.
+   */
+  void free(StatName& stat_name);
+
+  /**
+   * @return size_t the number of distinct segments in the table.
+   */
+  size_t size() const;
+
+private:
+  typedef uint32_t Symbol;
+
+  struct SharedSymbol {
+    Symbol symbol_;
+    uint32_t ref_count_;
+  };
+
+  Symbol toSymbol(const std::string& segment);
+
+  mutable std::mutex lock_;
+  std::unordered_map<std::string, SharedSymbol> encode_map_;
+  // Indexed by symbol. Points at the keys of encode_map_, whose addresses are stable.
+  std::vector<const std::string*> decode_map_;
+  // Symbols of segments which have been released, for reuse before growing decode_map_.
+  std::vector<Symbol> free_symbols_;
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -27,6 +27,7 @@ std::list<CounterSharedPtr> ThreadLocalStoreImpl::counters() const {
   std::unordered_set<std::string> names;
   std::unique_lock<std::mutex> lock(lock_);
   for (ScopeImpl* scope : scopes_) {
+    std::unique_lock<std::mutex> scope_lock(scope->central_cache_lock_);
     for (auto counter : scope->central_cache_.counters_) {
       if (names.insert(counter.first).second) {
         ret.push_back(counter.second);
@@ -34,6 +35,35 @@ std::list<CounterSharedPtr> ThreadLocalStoreImpl::counters() const {
     }
   }
 
+  blocks_.counters(ret, [this](const std::string& name, std::vector<Tag>& tags) -> std::string {
+    return getTagsForName(name, tags);
+  });
+  return ret;
+}
+
+std::list<CounterSharedPtr> ThreadLocalStoreImpl::dirtyCounters() {
+  std::list<CounterSharedPtr> ret = dirty_counters_.take();
+  blocks_.dirtyCounters(ret,
+                        [this](const std::string& name, std::vector<Tag>& tags) -> std::string {
+                          return getTagsForName(name, tags);
+                        });
+  return ret;
+}
+
+std::list<ParentHistogramSharedPtr> ThreadLocalStoreImpl::histograms() const {
+  // Handle de-dup due to overlapping scopes.
+  std::list<ParentHistogramSharedPtr> ret;
+  std::unordered_set<std::string> names;
+  std::unique_lock<std::mutex> lock(lock_);
+  for (ScopeImpl* scope : scopes_) {
+    std::unique_lock<std::mutex> scope_lock(scope->central_cache_lock_);
+    for (auto histogram : scope->central_cache_.histograms_) {
+      if (names.insert(histogram.first).second) {
+        ret.push_back(histogram.second);
+      }
+    }
+  }
+
   return ret;
 }
 
@@ -50,6 +80,7 @@ std::list<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
   std::unordered_set<std::string> names;
   std::unique_lock<std::mutex> lock(lock_);
   for (ScopeImpl* scope : scopes_) {
+    std::unique_lock<std::mutex> scope_lock(scope->central_cache_lock_);
     for (auto gauge : scope->central_cache_.gauges_) {
       if (names.insert(gauge.first).second) {
         ret.push_back(gauge.second);
@@ -57,6 +88,9 @@ std::list<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
     }
   }
 
+  blocks_.gauges(ret, [this](const std::string& name, std::vector<Tag>& tags) -> std::string {
+    return getTagsForName(name, tags);
+  });
   return ret;
 }
 
@@ -86,7 +120,8 @@ void ThreadLocalStoreImpl::releaseScopeCrossThread(ScopeImpl* scope) {
   }
 }
 
-std::string ThreadLocalStoreImpl::getTagsForName(const std::string& name, std::vector<Tag>& tags) {
+std::string ThreadLocalStoreImpl::getTagsForName(const std::string& name,
+                                                 std::vector<Tag>& tags) const {
   std::string tag_extracted_name = name;
   if (tag_extractors_ != nullptr) {
     for (const TagExtractorPtr& tag_extractor : *tag_extractors_) {
@@ -122,37 +157,38 @@ ThreadLocalStoreImpl::SafeAllocData ThreadLocalStoreImpl::safeAlloc(const std::s
 ThreadLocalStoreImpl::ScopeImpl::~ScopeImpl() { parent_.releaseScopeCrossThread(this); }
 
 Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
-  // Determine the final name based on the prefix and the passed name.
-  std::string final_name = prefix_ + name;
-
-  // We now try to acquire a *reference* to the TLS cache shared pointer. This might remain null
-  // if we don't have TLS initialized currently. The de-referenced pointer might be null if there
-  // is no cache entry.
-  CounterSharedPtr* tls_ref = nullptr;
+  // We now try to acquire a pointer to the TLS cache for this scope. This might remain null if we
+  // don't have TLS initialized currently. The TLS cache is keyed by the unprefixed name, so that
+  // a hit does not allocate.
+  TlsCacheEntry* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].counters_[final_name];
+    tls_cache = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this];
+    auto tls_entry = tls_cache->counters_.find(name);
+    // If we have a valid cache entry, return it.
+    if (tls_entry != tls_cache->counters_.end()) {
+      return *tls_entry->second;
+    }
   }
 
-  // If we have a valid cache entry, return it.
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
-  }
+  // Determine the final name based on the prefix and the passed name.
+  std::string final_name = prefix_ + name;
 
   // We must now look in the central store so we must be locked. We grab a reference to the
   // central store location. It might contain nothing. In this case, we allocate a new stat.
-  std::unique_lock<std::mutex> lock(parent_.lock_);
+  std::unique_lock<std::mutex> lock(central_cache_lock_);
   CounterSharedPtr& central_ref = central_cache_.counters_[final_name];
   if (!central_ref) {
     SafeAllocData alloc = parent_.safeAlloc(final_name);
     std::vector<Tag> tags;
     std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
     central_ref.reset(
-        new CounterImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags)));
+        new CounterImpl(alloc.data_, alloc.free_, parent_.dirty_counters_,
+                        std::move(tag_extracted_name), std::move(tags), parent_.symbol_table_));
   }
 
-  // If we have a TLS location to store or allocation into, do it.
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  // If we have a TLS cache to store the allocation into, do it.
+  if (tls_cache) {
+    tls_cache->counters_.emplace(name, central_ref);
   }
 
   // Finally we return the reference.
@@ -178,28 +214,29 @@ void ThreadLocalStoreImpl::ScopeImpl::deliverHistogramToSinks(const Histogram& h
 Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
-  std::string final_name = prefix_ + name;
-  GaugeSharedPtr* tls_ref = nullptr;
+  TlsCacheEntry* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].gauges_[final_name];
-  }
-
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+    tls_cache = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this];
+    auto tls_entry = tls_cache->gauges_.find(name);
+    if (tls_entry != tls_cache->gauges_.end()) {
+      return *tls_entry->second;
+    }
   }
 
-  std::unique_lock<std::mutex> lock(parent_.lock_);
+  std::string final_name = prefix_ + name;
+  std::unique_lock<std::mutex> lock(central_cache_lock_);
   GaugeSharedPtr& central_ref = central_cache_.gauges_[final_name];
   if (!central_ref) {
     SafeAllocData alloc = parent_.safeAlloc(final_name);
     std::vector<Tag> tags;
     std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
     central_ref.reset(
-        new GaugeImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags)));
+        new GaugeImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags),
+                      parent_.symbol_table_));
   }
 
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  if (tls_cache) {
+    tls_cache->gauges_.emplace(name, central_ref);
   }
 
   return *central_ref;
@@ -208,31 +245,85 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
 Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
-  std::string final_name = prefix_ + name;
-  HistogramSharedPtr* tls_ref = nullptr;
+  TlsCacheEntry* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].histograms_[final_name];
-  }
-
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+    tls_cache = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this];
+    auto tls_entry = tls_cache->histograms_.find(name);
+    if (tls_entry != tls_cache->histograms_.end()) {
+      return *tls_entry->second;
+    }
   }
 
-  std::unique_lock<std::mutex> lock(parent_.lock_);
-  HistogramSharedPtr& central_ref = central_cache_.histograms_[final_name];
+  std::string final_name = prefix_ + name;
+  std::unique_lock<std::mutex> lock(central_cache_lock_);
+  ParentHistogramImplSharedPtr& central_ref = central_cache_.histograms_[final_name];
   if (!central_ref) {
     std::vector<Tag> tags;
     std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(
-        new HistogramImpl(final_name, parent_, std::move(tag_extracted_name), std::move(tags)));
+    central_ref.reset(new ParentHistogramImpl(final_name, parent_, *this,
+                                              std::move(tag_extracted_name), std::move(tags)));
   }
 
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  if (tls_cache) {
+    tls_cache->histograms_.emplace(name, central_ref);
   }
 
   return *central_ref;
 }
 
+ThreadLocalStoreImpl::ParentHistogramImpl::ParentHistogramImpl(const std::string& name,
+                                                               ThreadLocalStoreImpl& parent,
+                                                               ScopeImpl& scope,
+                                                               std::string&& tag_extracted_name,
+                                                               std::vector<Tag>&& tags)
+    : MetricImpl(std::move(tag_extracted_name), std::move(tags), parent.symbol_table_),
+      parent_(parent), scope_(scope), name_(parent.symbol_table_.encode(name)) {}
+
+void ThreadLocalStoreImpl::ParentHistogramImpl::recordValue(uint64_t value) {
+  if (parent_.shutting_down_ || !parent_.tls_) {
+    std::unique_lock<std::mutex> lock(tls_histograms_lock_);
+    if (!fallback_histogram_) {
+      fallback_histogram_ = std::make_shared<ThreadLocalHistogramImpl>();
+      tls_histograms_.push_back(fallback_histogram_);
+    }
+    fallback_histogram_->recordValue(value);
+    return;
+  }
+
+  // The first value a thread records allocates its buckets, which are registered with the parent
+  // so that they are merged. After that recording only touches this thread's buckets.
+  ThreadLocalHistogramSharedPtr& tls_histogram =
+      parent_.tls_->getTyped<TlsCache>().scope_cache_[&scope_].tls_histograms_[this];
+  if (!tls_histogram) {
+    tls_histogram = std::make_shared<ThreadLocalHistogramImpl>();
+    std::unique_lock<std::mutex> lock(tls_histograms_lock_);
+    tls_histograms_.push_back(tls_histogram);
+  }
+  tls_histogram->recordValue(value);
+}
+
+void ThreadLocalStoreImpl::ParentHistogramImpl::merge() {
+  std::vector<uint64_t> interval_buckets(HistogramBuckets::NUM_BUCKETS);
+  uint64_t interval_sum = 0;
+  {
+    std::unique_lock<std::mutex> lock(tls_histograms_lock_);
+    for (const ThreadLocalHistogramSharedPtr& tls_histogram : tls_histograms_) {
+      tls_histogram->drain(interval_buckets, interval_sum);
+    }
+  }
+
+  interval_statistics_.refresh(interval_buckets, interval_sum);
+  if (interval_statistics_.sampleCount() == 0) {
+    return;
+  }
+
+  cumulative_buckets_.resize(HistogramBuckets::NUM_BUCKETS);
+  for (uint32_t i = 0; i < HistogramBuckets::NUM_BUCKETS; i++) {
+    cumulative_buckets_[i] += interval_buckets[i];
+  }
+  cumulative_sum_ += interval_sum;
+  cumulative_statistics_.refresh(cumulative_buckets_, cumulative_sum_);
+}
+
 } // namespace Stats
 } // namespace Envoy
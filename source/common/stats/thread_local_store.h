@@ -11,6 +11,7 @@
 
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/stats/histogram_impl.h"
 #include "common/stats/stats_impl.h"
 
 namespace Envoy {
@@ -31,6 +32,11 @@ namespace Stats {
  * - Scopes can be deleted from any thread, and they are in practice as scopes are likely to be
  *   shared across all worker threads.
  * - Per thread caches are checked, and if empty, they are populated from the central cache.
+ *   Per thread caches are keyed by the name without the scope prefix, so that a cache hit does
+ *   not need to build the final name.
+ * - Each scope's central cache has its own lock, so that cache misses in different scopes (e.g.
+ *   dynamic per cluster stats) do not contend with each other. The store lock only protects the
+ *   set of scopes. When both are held, the store lock is taken first.
  * - Scopes are entirely owned by the caller. The store only keeps weak pointers.
  * - When a scope is destroyed, a cache flush operation is run on all threads to flush any cached
  *   data owned by the destroyed scope.
@@ -40,6 +46,13 @@ namespace Stats {
  *         repopulated on the next access.
  * - Since it's possible to have overlapping scopes, we de-dup stats when counters() or gauges() is
  *   called since these are very uncommon operations.
+ * - The first increment of a counter since the last flush adds it to a list of dirty counters, so
+ *   that flushing does not visit every counter.
+ * - Stats blocks are not cached per thread: their stats are updated directly, and only listed
+ *   with names and tags when counters(), gauges() or dirtyCounters() is called.
+ * - Histograms record into per thread buckets without locking. The main thread merges the buckets
+ *   of all threads when stats are flushed. Values recorded before threading is initialized or
+ *   after it is shut down go to buckets owned by the histogram itself.
  * - Though this implementation is designed to work with a fixed shared memory space, it will fall
  *   back to heap allocated stats if needed. NOTE: In this case, overlapping scopes will not share
  *   the same backing store. This is to keep things simple, it could be done in the future if
@@ -63,7 +76,10 @@ public:
 
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override;
+  std::list<CounterSharedPtr> dirtyCounters() override;
   std::list<GaugeSharedPtr> gauges() const override;
+  std::list<ParentHistogramSharedPtr> histograms() const override;
+  void addStatsBlock(StatsBlockSharedPtr block) override { blocks_.add(std::move(block)); }
 
   // Stats::StoreRoot
   void addSink(Sink& sink) override { timer_sinks_.push_back(sink); }
@@ -75,10 +91,49 @@ public:
   void shutdownThreading() override;
 
 private:
+  struct ScopeImpl;
+
+  struct ParentHistogramImpl : public ParentHistogram, public MetricImpl {
+    ParentHistogramImpl(const std::string& name, ThreadLocalStoreImpl& parent, ScopeImpl& scope,
+                        std::string&& tag_extracted_name, std::vector<Tag>&& tags);
+    ~ParentHistogramImpl() { symbolTable().free(name_); }
+
+    // Stats::Metric
+    std::string name() const override { return symbolTable().decode(name_); }
+
+    // Stats::Histogram
+    void recordValue(uint64_t value) override;
+
+    // Stats::ParentHistogram
+    void merge() override;
+    const HistogramStatistics& intervalStatistics() const override { return interval_statistics_; }
+    const HistogramStatistics& cumulativeStatistics() const override {
+      return cumulative_statistics_;
+    }
+    bool used() const override { return cumulative_statistics_.sampleCount() > 0; }
+
+    ThreadLocalStoreImpl& parent_;
+    ScopeImpl& scope_;
+    StatName name_;
+    std::mutex tls_histograms_lock_;
+    std::list<ThreadLocalHistogramSharedPtr> tls_histograms_;
+    // Buckets for values recorded without threading, allocated on first use.
+    ThreadLocalHistogramSharedPtr fallback_histogram_;
+    // Allocated on the first merge of any values.
+    std::vector<uint64_t> cumulative_buckets_;
+    uint64_t cumulative_sum_{};
+    HistogramStatisticsImpl interval_statistics_;
+    HistogramStatisticsImpl cumulative_statistics_;
+  };
+
+  typedef std::shared_ptr<ParentHistogramImpl> ParentHistogramImplSharedPtr;
+
   struct TlsCacheEntry {
     std::unordered_map<std::string, CounterSharedPtr> counters_;
     std::unordered_map<std::string, GaugeSharedPtr> gauges_;
-    std::unordered_map<std::string, HistogramSharedPtr> histograms_;
+    std::unordered_map<std::string, ParentHistogramImplSharedPtr> histograms_;
+    // The buckets this thread records into for each histogram of the scope.
+    std::unordered_map<const ParentHistogramImpl*, ThreadLocalHistogramSharedPtr> tls_histograms_;
   };
 
   struct ScopeImpl : public Scope {
@@ -97,6 +152,7 @@ private:
 
     ThreadLocalStoreImpl& parent_;
     const std::string prefix_;
+    std::mutex central_cache_lock_;
     TlsCacheEntry central_cache_;
   };
 
@@ -109,11 +165,13 @@ private:
     RawStatDataAllocator& free_;
   };
 
-  std::string getTagsForName(const std::string& name, std::vector<Tag>& tags);
+  std::string getTagsForName(const std::string& name, std::vector<Tag>& tags) const;
   void clearScopeFromCaches(ScopeImpl* scope);
   void releaseScopeCrossThread(ScopeImpl* scope);
   SafeAllocData safeAlloc(const std::string& name);
 
+  // Declared first so that it outlives every metric of the store.
+  SymbolTable symbol_table_;
   RawStatDataAllocator& alloc_;
   Event::Dispatcher* main_thread_dispatcher_{};
   ThreadLocal::SlotPtr tls_;
@@ -125,6 +183,9 @@ private:
   std::atomic<bool> shutting_down_{};
   Counter& num_last_resort_stats_;
   HeapRawStatDataAllocator heap_allocator_;
+  // Declared after the allocators, as it may hold the last references to counters.
+  DirtyCounterList dirty_counters_;
+  StatsBlockList blocks_;
 };
 
 } // namespace Stats
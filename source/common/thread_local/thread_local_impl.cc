@@ -2,7 +2,10 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
+#include <memory>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 
@@ -37,7 +40,7 @@ SlotPtr InstanceImpl::allocateSlot() {
   return std::move(slot);
 }
 
-ThreadLocalObjectSharedPtr InstanceImpl::SlotImpl::get() {
+ThreadLocalObjectSharedPtr& InstanceImpl::SlotImpl::get() {
   ASSERT(thread_local_data_.data_.size() > index_);
   return thread_local_data_.data_[index_];
 }
@@ -54,6 +57,44 @@ void InstanceImpl::registerThread(Event::Dispatcher& dispatcher, bool main_threa
   }
 }
 
+void InstanceImpl::startBatch() {
+  ASSERT(std::this_thread::get_id() == main_thread_id_);
+  batch_depth_++;
+}
+
+void InstanceImpl::endBatch() {
+  ASSERT(std::this_thread::get_id() == main_thread_id_);
+  ASSERT(batch_depth_ > 0);
+  if (--batch_depth_ > 0) {
+    return;
+  }
+
+  // All the workers run the same callbacks, so they share them.
+  std::shared_ptr<std::vector<WorkerCb>> callbacks(new std::vector<WorkerCb>());
+  callbacks->swap(batched_callbacks_);
+  if (callbacks->empty() || shutdown_) {
+    return;
+  }
+  for (Event::Dispatcher& dispatcher : registered_threads_) {
+    dispatcher.post([callbacks, &dispatcher]() -> void {
+      for (const WorkerCb& cb : *callbacks) {
+        cb(dispatcher);
+      }
+    });
+  }
+}
+
+void InstanceImpl::postToWorkers(WorkerCb cb) {
+  if (batch_depth_ > 0) {
+    batched_callbacks_.push_back(cb);
+    return;
+  }
+
+  for (Event::Dispatcher& dispatcher : registered_threads_) {
+    dispatcher.post([cb, &dispatcher]() -> void { cb(dispatcher); });
+  }
+}
+
 void InstanceImpl::removeSlot(SlotImpl& slot) {
   ASSERT(std::this_thread::get_id() == main_thread_id_);
 
@@ -81,9 +122,7 @@ void InstanceImpl::runOnAllThreads(Event::PostCb cb) {
   ASSERT(std::this_thread::get_id() == main_thread_id_);
   ASSERT(!shutdown_);
 
-  for (Event::Dispatcher& dispatcher : registered_threads_) {
-    dispatcher.post(cb);
-  }
+  postToWorkers([cb](Event::Dispatcher&) -> void { cb(); });
 
   // Handle main thread.
   cb();
@@ -93,10 +132,10 @@ void InstanceImpl::SlotImpl::set(InitializeCb cb) {
   ASSERT(std::this_thread::get_id() == parent_.main_thread_id_);
   ASSERT(!parent_.shutdown_);
 
-  for (Event::Dispatcher& dispatcher : parent_.registered_threads_) {
-    const uint32_t index = index_;
-    dispatcher.post([index, cb, &dispatcher]() -> void { setThreadLocal(index, cb(dispatcher)); });
-  }
+  const uint32_t index = index_;
+  parent_.postToWorkers([index, cb](Event::Dispatcher& dispatcher) -> void {
+    setThreadLocal(index, cb(dispatcher));
+  });
 
   // Handle main thread.
   setThreadLocal(index_, cb(*parent_.main_thread_dispatcher_));
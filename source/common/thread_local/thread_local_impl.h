@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <vector>
 
@@ -23,6 +24,8 @@ public:
   // ThreadLocal::Instance
   SlotPtr allocateSlot() override;
   void registerThread(Event::Dispatcher& dispatcher, bool main_thread) override;
+  void startBatch() override;
+  void endBatch() override;
   void shutdownGlobalThreading() override;
   void shutdownThread() override;
 
@@ -32,7 +35,7 @@ private:
     ~SlotImpl() { parent_.removeSlot(*this); }
 
     // ThreadLocal::Slot
-    ThreadLocalObjectSharedPtr get() override;
+    ThreadLocalObjectSharedPtr& get() override;
     void runOnAllThreads(Event::PostCb cb) override { parent_.runOnAllThreads(cb); }
     void set(InitializeCb cb) override;
 
@@ -44,6 +47,9 @@ private:
     std::vector<ThreadLocalObjectSharedPtr> data_;
   };
 
+  typedef std::function<void(Event::Dispatcher& dispatcher)> WorkerCb;
+
+  void postToWorkers(WorkerCb cb);
   void removeSlot(SlotImpl& slot);
   void runOnAllThreads(Event::PostCb cb);
   static void setThreadLocal(uint32_t index, ThreadLocalObjectSharedPtr object);
@@ -53,6 +59,8 @@ private:
   std::list<std::reference_wrapper<Event::Dispatcher>> registered_threads_;
   std::thread::id main_thread_id_;
   Event::Dispatcher* main_thread_dispatcher_{};
+  uint32_t batch_depth_{};
+  std::vector<WorkerCb> batched_callbacks_;
   std::atomic<bool> shutdown_{};
 };
 
@@ -1,5 +1,6 @@
 #include "common/tracing/http_tracer_impl.h"
 
+#include <cstring>
 #include <string>
 
 #include "common/common/assert.h"
@@ -10,6 +11,7 @@
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
+#include "common/runtime/key_registry.h"
 #include "common/runtime/uuid_util.h"
 
 #include "fmt/format.h"
@@ -17,6 +19,13 @@
 namespace Envoy {
 namespace Tracing {
 
+static const Runtime::Key& TracingClientEnabled =
+    Runtime::KeyRegistry::registerKey("tracing.client_enabled");
+static const Runtime::Key& TracingRandomSampling =
+    Runtime::KeyRegistry::registerKey("tracing.random_sampling");
+static const Runtime::Key& TracingGlobalEnabled =
+    Runtime::KeyRegistry::registerKey("tracing.global_enabled");
+
 // TODO(mattklein123) PERF: Avoid string creations/copies in this entire file.
 static std::string buildResponseCode(const Http::AccessLog::RequestInfo& info) {
   return info.responseCode().valid() ? std::to_string(info.responseCode().value()) : "0";
@@ -44,32 +53,42 @@ void HttpTracerUtility::mutateHeaders(Http::HeaderMap& request_headers, Runtime:
     return;
   }
 
-  // TODO PERF: Avoid copy.
-  std::string x_request_id = request_headers.RequestId()->value().c_str();
+  const Http::HeaderString& value = request_headers.RequestId()->value();
 
   uint16_t result;
   // Skip if x-request-id is corrupted.
-  if (!UuidUtils::uuidModBy(x_request_id, result, 10000)) {
+  if (!UuidUtils::uuidModBy(value.c_str(), value.size(), result, 10000)) {
     return;
   }
 
+  // Only a well formed uuid4 can be made traceable, so anything else is left alone.
+  if (value.size() != Runtime::RandomGenerator::UUID_LENGTH) {
+    return;
+  }
+
+  char x_request_id[Runtime::RandomGenerator::UUID_LENGTH];
+  memcpy(x_request_id, value.c_str(), sizeof(x_request_id));
+
   // Do not apply tracing transformations if we are currently tracing.
-  if (UuidTraceStatus::NoTrace == UuidUtils::isTraceableUuid(x_request_id)) {
+  if (UuidTraceStatus::NoTrace == UuidUtils::isTraceableUuid(x_request_id, sizeof(x_request_id))) {
     if (request_headers.ClientTraceId() &&
-        runtime.snapshot().featureEnabled("tracing.client_enabled", 100)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Client);
+        runtime.snapshot().featureEnabled(TracingClientEnabled, 100)) {
+      UuidUtils::setTraceableUuid(x_request_id, sizeof(x_request_id), UuidTraceStatus::Client);
     } else if (request_headers.EnvoyForceTrace()) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Forced);
-    } else if (runtime.snapshot().featureEnabled("tracing.random_sampling", 10000, result, 10000)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Sampled);
+      UuidUtils::setTraceableUuid(x_request_id, sizeof(x_request_id), UuidTraceStatus::Forced);
+    } else if (runtime.snapshot().featureEnabled(TracingRandomSampling, 10000, result, 10000)) {
+      UuidUtils::setTraceableUuid(x_request_id, sizeof(x_request_id), UuidTraceStatus::Sampled);
     }
   }
 
-  if (!runtime.snapshot().featureEnabled("tracing.global_enabled", 100, result)) {
-    UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::NoTrace);
+  if (!runtime.snapshot().featureEnabled(TracingGlobalEnabled, 100, result)) {
+    UuidUtils::setTraceableUuid(x_request_id, sizeof(x_request_id), UuidTraceStatus::NoTrace);
   }
 
-  request_headers.RequestId()->value(x_request_id);
+  // The header is only rewritten if its trace status changed.
+  if (memcmp(x_request_id, value.c_str(), sizeof(x_request_id)) != 0) {
+    request_headers.RequestId()->value(x_request_id, sizeof(x_request_id));
+  }
 }
 
 const std::string HttpTracerUtility::INGRESS_OPERATION = "ingress";
@@ -97,9 +116,8 @@ Decision HttpTracerUtility::isTracing(const Http::AccessLog::RequestInfo& reques
     return {Reason::NotTraceableRequestId, false};
   }
 
-  // TODO PERF: Avoid copy.
-  UuidTraceStatus trace_status =
-      UuidUtils::isTraceableUuid(request_headers.RequestId()->value().c_str());
+  const Http::HeaderString& request_id = request_headers.RequestId()->value();
+  UuidTraceStatus trace_status = UuidUtils::isTraceableUuid(request_id.c_str(), request_id.size());
 
   switch (trace_status) {
   case UuidTraceStatus::Client:
@@ -107,6 +125,11 @@ Decision HttpTracerUtility::isTracing(const Http::AccessLog::RequestInfo& reques
   case UuidTraceStatus::Forced:
     return {Reason::ServiceForced, true};
   case UuidTraceStatus::Sampled:
+    // Head-based sampling: a caller which propagates the B3 decision not to sample the trace is
+    // followed, so that no span is built for the request. Forced tracing still wins.
+    if (request_headers.XB3Sampled() && request_headers.XB3Sampled()->value() == "0") {
+      return {Reason::DownstreamNotSampled, false};
+    }
     return {Reason::Sampling, true};
   case UuidTraceStatus::NoTrace:
     return {Reason::NotTraceableRequestId, false};
@@ -118,20 +141,21 @@ Decision HttpTracerUtility::isTracing(const Http::AccessLog::RequestInfo& reques
 void HttpTracerUtility::finalizeSpan(Span& span, const Http::HeaderMap* request_headers,
                                      const Http::AccessLog::RequestInfo& request_info,
                                      const Config& tracing_config) {
+  const TagValues& tags = Tags::get();
+
   // Pre response data.
   if (request_headers) {
-    span.setTag("guid:x-request-id", std::string(request_headers->RequestId()->value().c_str()));
-    span.setTag("http.url", buildUrl(*request_headers));
-    span.setTag("http.method", request_headers->Method()->value().c_str());
-    span.setTag("downstream_cluster",
+    span.setTag(tags.GuidXRequestId, request_headers->RequestId()->value().c_str());
+    span.setTag(tags.HttpUrl, buildUrl(*request_headers));
+    span.setTag(tags.HttpMethod, request_headers->Method()->value().c_str());
+    span.setTag(tags.DownstreamCluster,
                 valueOrDefault(request_headers->EnvoyDownstreamServiceCluster(), "-"));
-    span.setTag("user_agent", valueOrDefault(request_headers->UserAgent(), "-"));
-    span.setTag("http.protocol",
+    span.setTag(tags.UserAgent, valueOrDefault(request_headers->UserAgent(), "-"));
+    span.setTag(tags.HttpProtocol,
                 Http::AccessLog::AccessLogFormatUtils::protocolToString(request_info.protocol()));
 
     if (request_headers->ClientTraceId()) {
-      span.setTag("guid:x-client-trace-id",
-                  std::string(request_headers->ClientTraceId()->value().c_str()));
+      span.setTag(tags.GuidXClientTraceId, request_headers->ClientTraceId()->value().c_str());
     }
 
     // Build tags based on the custom headers.
@@ -142,20 +166,20 @@ void HttpTracerUtility::finalizeSpan(Span& span, const Http::HeaderMap* request_
       }
     }
   }
-  span.setTag("request_size", std::to_string(request_info.bytesReceived()));
+  span.setTag(tags.RequestSize, std::to_string(request_info.bytesReceived()));
 
   if (nullptr != request_info.upstreamHost()) {
-    span.setTag("upstream_cluster", request_info.upstreamHost()->cluster().name());
+    span.setTag(tags.UpstreamCluster, request_info.upstreamHost()->cluster().name());
   }
 
   // Post response data.
-  span.setTag("http.status_code", buildResponseCode(request_info));
-  span.setTag("response_size", std::to_string(request_info.bytesSent()));
-  span.setTag("response_flags", Http::AccessLog::ResponseFlagUtils::toShortString(request_info));
+  span.setTag(tags.HttpStatusCode, buildResponseCode(request_info));
+  span.setTag(tags.ResponseSize, std::to_string(request_info.bytesSent()));
+  span.setTag(tags.ResponseFlags, Http::AccessLog::ResponseFlagUtils::toShortString(request_info));
 
   if (!request_info.responseCode().valid() ||
       Http::CodeUtility::is5xx(request_info.responseCode().value())) {
-    span.setTag("error", "true");
+    span.setTag(tags.Error, tags.True);
   }
 
   span.finishSpan();
@@ -166,18 +190,21 @@ HttpTracerImpl::HttpTracerImpl(DriverPtr&& driver, const LocalInfo::LocalInfo& l
 
 SpanPtr HttpTracerImpl::startSpan(const Config& config, Http::HeaderMap& request_headers,
                                   const Http::AccessLog::RequestInfo& request_info) {
-  std::string span_name = HttpTracerUtility::toString(config.operationName());
-
+  SpanPtr active_span;
   if (config.operationName() == OperationName::Egress) {
+    std::string span_name = HttpTracerUtility::EGRESS_OPERATION;
     span_name.append(" ");
     span_name.append(request_headers.Host()->value().c_str());
+    active_span = driver_->startSpan(config, request_headers, span_name, request_info.startTime());
+  } else {
+    // The name of an ingress span is constant, so it is not copied.
+    active_span = driver_->startSpan(config, request_headers, HttpTracerUtility::INGRESS_OPERATION,
+                                     request_info.startTime());
   }
 
-  SpanPtr active_span =
-      driver_->startSpan(config, request_headers, span_name, request_info.startTime());
   if (active_span) {
-    active_span->setTag("node_id", local_info_.nodeName());
-    active_span->setTag("zone", local_info_.zoneName());
+    active_span->setTag(Tags::get().NodeId, local_info_.nodeName());
+    active_span->setTag(Tags::get().Zone, local_info_.zoneName());
   }
 
   return active_span;
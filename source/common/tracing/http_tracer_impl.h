@@ -20,8 +20,35 @@ enum class Reason {
   Sampling,
   ServiceForced,
   ClientForced,
+  DownstreamNotSampled,
 };
 
+/**
+ * The keys of the tags which Envoy sets on its spans, and their well known values. They are
+ * constructed once, rather than for each tag of each traced request.
+ */
+class TagValues {
+public:
+  const std::string GuidXRequestId = "guid:x-request-id";
+  const std::string GuidXClientTraceId = "guid:x-client-trace-id";
+  const std::string HttpUrl = "http.url";
+  const std::string HttpMethod = "http.method";
+  const std::string HttpProtocol = "http.protocol";
+  const std::string HttpStatusCode = "http.status_code";
+  const std::string DownstreamCluster = "downstream_cluster";
+  const std::string UpstreamCluster = "upstream_cluster";
+  const std::string UserAgent = "user_agent";
+  const std::string RequestSize = "request_size";
+  const std::string ResponseSize = "response_size";
+  const std::string ResponseFlags = "response_flags";
+  const std::string NodeId = "node_id";
+  const std::string Zone = "zone";
+  const std::string Error = "error";
+  const std::string True = "true";
+};
+
+typedef ConstSingleton<TagValues> Tags;
+
 struct Decision {
   Reason reason;
   bool is_tracing;
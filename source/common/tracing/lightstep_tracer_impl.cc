@@ -56,11 +56,18 @@ LightStepRecorder::LightStepRecorder(const lightstep::TracerImpl& tracer, LightS
 }
 
 void LightStepRecorder::RecordSpan(lightstep::collector::Span&& span) {
-  builder_.addSpan(std::move(span));
+  const uint64_t max_buffered_spans =
+      driver_.runtime().snapshot().getInteger("tracing.lightstep.max_buffered_spans", 5000U);
+  while (!spans_.empty() && spans_.size() >= max_buffered_spans) {
+    driver_.tracerStats().spans_dropped_.inc();
+    driver_.tracerStats().bytes_dropped_.add(spans_.front().ByteSizeLong());
+    spans_.pop_front();
+  }
+  spans_.push_back(std::move(span));
 
   uint64_t min_flush_spans =
       driver_.runtime().snapshot().getInteger("tracing.lightstep.min_flush_spans", 5U);
-  if (builder_.pendingSpans() == min_flush_spans) {
+  if (spans_.size() >= min_flush_spans) {
     flushSpans();
   }
 }
@@ -84,8 +91,14 @@ void LightStepRecorder::enableTimer() {
 }
 
 void LightStepRecorder::flushSpans() {
-  if (builder_.pendingSpans() != 0) {
-    driver_.tracerStats().spans_sent_.add(builder_.pendingSpans());
+  if (!spans_.empty() &&
+      pending_reports_ < driver_.runtime().snapshot().getInteger(
+                             "tracing.lightstep.max_pending_reports", 10U)) {
+    driver_.tracerStats().spans_sent_.add(spans_.size());
+    for (lightstep::collector::Span& span : spans_) {
+      builder_.addSpan(std::move(span));
+    }
+    spans_.clear();
     lightstep::collector::ReportRequest request;
     std::swap(request, builder_.pending());
 
@@ -97,6 +110,8 @@ void LightStepRecorder::flushSpans() {
 
     uint64_t timeout =
         driver_.runtime().snapshot().getInteger("tracing.lightstep.request_timeout", 5000U);
+    // The report may fail inline, so it is counted first.
+    pending_reports_++;
     driver_.clusterManager()
         .httpAsyncClientForCluster(driver_.cluster()->name())
         .send(std::move(message), *this, std::chrono::milliseconds(timeout));
@@ -163,12 +178,20 @@ SpanPtr LightStepDriver::startSpan(const Config&, Http::HeaderMap& request_heade
   return std::move(active_span);
 }
 
+void LightStepRecorder::onReportComplete() {
+  if (pending_reports_ > 0) {
+    pending_reports_--;
+  }
+}
+
 void LightStepRecorder::onFailure(Http::AsyncClient::FailureReason) {
+  onReportComplete();
   Grpc::Common::chargeStat(*driver_.cluster(), lightstep::CollectorServiceFullName(),
                            lightstep::CollectorMethodName(), false);
 }
 
 void LightStepRecorder::onSuccess(Http::MessagePtr&& msg) {
+  onReportComplete();
   try {
     Grpc::Common::validateResponse(*msg);
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 
@@ -21,6 +22,8 @@ namespace Tracing {
 
 #define LIGHTSTEP_TRACER_STATS(COUNTER)                                                            \
   COUNTER(spans_sent)                                                                              \
+  COUNTER(spans_dropped)                                                                           \
+  COUNTER(bytes_dropped)                                                                           \
   COUNTER(timer_flushed)
 
 struct LightstepTracerStats {
@@ -84,6 +87,12 @@ private:
   std::unique_ptr<lightstep::TracerOptions> options_;
 };
 
+/**
+ * Records the spans of a worker and reports them to the collectors. While the collectors fall
+ * behind, at most tracing.lightstep.max_pending_reports reports are outstanding and at most
+ * tracing.lightstep.max_buffered_spans spans wait for the next report, the oldest being dropped
+ * first, so that tracing does not take memory from proxying.
+ */
 class LightStepRecorder : public lightstep::Recorder, Http::AsyncClient::Callbacks {
 public:
   LightStepRecorder(const lightstep::TracerImpl& tracer, LightStepDriver& driver,
@@ -104,10 +113,14 @@ public:
 private:
   void enableTimer();
   void flushSpans();
+  void onReportComplete();
 
   lightstep::ReportBuilder builder_;
   LightStepDriver& driver_;
   Event::TimerPtr flush_timer_;
+  // The spans waiting for the next report, oldest first.
+  std::deque<lightstep::collector::Span> spans_;
+  uint64_t pending_reports_{};
 };
 
 } // Tracing
@@ -3,8 +3,7 @@
 namespace Envoy {
 namespace Zipkin {
 
-// TODO(fabolive): Need to avoid the copy to improve performance.
-bool SpanBuffer::addSpan(const Span& span) {
+bool SpanBuffer::addSpan(Span&& span) {
   if (span_buffer_.size() == span_buffer_.capacity()) {
     // Buffer full
     return false;
@@ -29,5 +28,23 @@ std::string SpanBuffer::toStringifiedJsonArray() {
 
   return stringified_json_array;
 }
+
+void SpanBuffer::serializeJsonArray(Buffer::Instance& output) {
+  output.add("[", 1);
+  for (uint64_t i = 0; i < span_buffer_.size(); i++) {
+    if (i > 0) {
+      output.add(",", 1);
+    }
+    output.add(span_buffer_[i].toJson());
+  }
+  output.add("]", 1);
+}
+
+void SpanBuffer::serializeThriftList(Buffer::Instance& output) const {
+  Util::addThriftListHeader(output, Util::ThriftType::Struct, span_buffer_.size());
+  for (const Span& span : span_buffer_) {
+    span.toThrift(output);
+  }
+}
 } // namespace Zipkin
 } // namespace Envoy
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
+
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
 namespace Envoy {
@@ -32,13 +34,13 @@ public:
   void allocateBuffer(uint64_t size) { span_buffer_.reserve(size); }
 
   /**
-   * Adds the given Zipkin span to the buffer.
+   * Adds the given Zipkin span to the buffer. The span is moved into the buffer.
    *
    * @param span The span to be added to the buffer.
    *
    * @return true if the span was successfully added, or false if the buffer was full.
    */
-  bool addSpan(const Span& span);
+  bool addSpan(Span&& span);
 
   /**
    * Empties the buffer. This method is supposed to be called when all buffered spans
@@ -57,6 +59,23 @@ public:
    */
   std::string toStringifiedJsonArray();
 
+  /**
+   * Appends the contents of the buffer to an output buffer as a JSON array, span by span, without
+   * building the whole array as a string.
+   *
+   * @param output The buffer which the array is appended to.
+   */
+  void serializeJsonArray(Buffer::Instance& output);
+
+  /**
+   * Appends the contents of the buffer to an output buffer as a Thrift list of spans, in the
+   * binary protocol. This is what Zipkin's collector accepts with the application/x-thrift
+   * content type, and is several times smaller and cheaper to write than JSON.
+   *
+   * @param output The buffer which the list is appended to.
+   */
+  void serializeThriftList(Buffer::Instance& output) const;
+
 private:
   // We use a pre-allocated vector to improve performance
   std::vector<Span> span_buffer_;
@@ -1,5 +1,6 @@
 #include "common/tracing/zipkin/span_context.h"
 
+#include "common/common/hex.h"
 #include "common/common/macros.h"
 #include "common/common/utility.h"
 #include "common/tracing/zipkin/zipkin_core_constants.h"
@@ -72,11 +73,17 @@ const std::string SpanContext::serializeToString() {
     return unitializedSpanContext();
   }
 
-  std::string result;
-  result = traceIdAsHexString() + fieldSeparator() + idAsHexString() + fieldSeparator() +
-           parentIdAsHexString();
+  char result[SERIALIZED_LENGTH];
+  serializeTo(result);
+  return std::string(result, sizeof(result));
+}
 
-  return result;
+void SpanContext::serializeTo(char* output) const {
+  Hex::uint64ToHex(trace_id_, output);
+  output[16] = ';';
+  Hex::uint64ToHex(id_, output + 17);
+  output[33] = ';';
+  Hex::uint64ToHex(parent_id_, output + 34);
 }
 
 void SpanContext::populateFromString(const std::string& span_context_str) {
@@ -58,6 +58,18 @@ public:
    */
   const std::string serializeToString();
 
+  /**
+   * The length of a SpanContext serialized by serializeTo(): three 16-hex-string ids separated by
+   * semicolons.
+   */
+  static const size_t SERIALIZED_LENGTH = 3 * 16 + 2;
+
+  /**
+   * Serializes the ids of the SpanContext object as serializeToString() does, but into a
+   * caller-supplied buffer of SERIALIZED_LENGTH characters, without allocating a string.
+   */
+  void serializeTo(char* output) const;
+
   /**
    * Initializes a SpanContext object based on the given string.
    *
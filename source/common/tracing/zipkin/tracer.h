@@ -28,9 +28,9 @@ public:
    * Method that a concrete Reporter class must implement to handle finished spans.
    * For example, a span-buffer management policy could be implemented.
    *
-   * @param span The span that needs action.
+   * @param span The span that needs action. It may be moved from.
    */
-  virtual void reportSpan(const Span& span) PURE;
+  virtual void reportSpan(Span&& span) PURE;
 };
 
 typedef std::unique_ptr<Reporter> ReporterPtr;
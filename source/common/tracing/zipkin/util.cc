@@ -1,5 +1,7 @@
 #include "common/tracing/zipkin/util.h"
 
+#include <arpa/inet.h>
+
 #include <chrono>
 #include <random>
 #include <regex>
@@ -47,6 +49,43 @@ void Util::addArrayToJson(std::string& target, const std::vector<std::string>& j
   mergeJsons(target, stringified_json_array, field_name);
 }
 
+void Util::addThriftFieldHeader(Buffer::Instance& output, ThriftType type, int16_t id) {
+  const uint8_t type_byte = static_cast<uint8_t>(type);
+  output.add(&type_byte, sizeof(type_byte));
+  addThriftI16(output, id);
+}
+
+void Util::addThriftStop(Buffer::Instance& output) {
+  const uint8_t stop = static_cast<uint8_t>(ThriftType::Stop);
+  output.add(&stop, sizeof(stop));
+}
+
+void Util::addThriftListHeader(Buffer::Instance& output, ThriftType type, uint32_t size) {
+  const uint8_t type_byte = static_cast<uint8_t>(type);
+  output.add(&type_byte, sizeof(type_byte));
+  addThriftI32(output, size);
+}
+
+void Util::addThriftI16(Buffer::Instance& output, int16_t value) {
+  const uint16_t network_value = htons(value);
+  output.add(&network_value, sizeof(network_value));
+}
+
+void Util::addThriftI32(Buffer::Instance& output, int32_t value) {
+  const uint32_t network_value = htonl(value);
+  output.add(&network_value, sizeof(network_value));
+}
+
+void Util::addThriftI64(Buffer::Instance& output, int64_t value) {
+  addThriftI32(output, static_cast<uint64_t>(value) >> 32);
+  addThriftI32(output, value);
+}
+
+void Util::addThriftString(Buffer::Instance& output, const void* data, uint32_t length) {
+  addThriftI32(output, length);
+  output.add(data, length);
+}
+
 uint64_t Util::generateRandom64() {
   uint64_t seed = std::chrono::duration_cast<std::chrono::nanoseconds>(
                       ProdSystemTimeSource::instance_.currentTime().time_since_epoch())
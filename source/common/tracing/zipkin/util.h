@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
+
 namespace Envoy {
 namespace Zipkin {
 
@@ -36,6 +39,50 @@ public:
   static void addArrayToJson(std::string& target, const std::vector<std::string>& json_array,
                              const std::string& field_name);
 
+  // ====
+  // Thrift binary protocol
+  // ====
+
+  /**
+   * The Thrift types of the fields of the Zipkin structs.
+   */
+  enum class ThriftType : uint8_t {
+    Stop = 0,
+    Bool = 2,
+    I16 = 6,
+    I32 = 8,
+    I64 = 10,
+    String = 11,
+    Struct = 12,
+    List = 15,
+  };
+
+  /**
+   * Appends the header of a field of a struct: the type of the field, then its id.
+   */
+  static void addThriftFieldHeader(Buffer::Instance& output, ThriftType type, int16_t id);
+
+  /**
+   * Appends the stop marker which ends a struct.
+   */
+  static void addThriftStop(Buffer::Instance& output);
+
+  /**
+   * Appends the header of a list: the type of its elements, then their number.
+   */
+  static void addThriftListHeader(Buffer::Instance& output, ThriftType type, uint32_t size);
+
+  /**
+   * Append big-endian integers, and length-prefixed strings.
+   */
+  static void addThriftI16(Buffer::Instance& output, int16_t value);
+  static void addThriftI32(Buffer::Instance& output, int32_t value);
+  static void addThriftI64(Buffer::Instance& output, int64_t value);
+  static void addThriftString(Buffer::Instance& output, const void* data, uint32_t length);
+  static void addThriftString(Buffer::Instance& output, const std::string& value) {
+    addThriftString(output, value.data(), value.size());
+  }
+
   // ====
   // Miscellaneous
   // ====
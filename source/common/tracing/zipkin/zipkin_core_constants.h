@@ -37,6 +37,11 @@ public:
   const std::string ALWAYS_SAMPLE = "1";
 
   const std::string DEFAULT_COLLECTOR_ENDPOINT = "/api/v1/spans";
+
+  // Encodings of the spans sent to the collector
+  const std::string JSON_ENCODING = "json";
+  const std::string THRIFT_ENCODING = "thrift";
+  const std::string THRIFT_CONTENT_TYPE = "application/x-thrift";
 };
 
 typedef ConstSingleton<ZipkinCoreConstantValues> ZipkinCoreConstants;
@@ -1,5 +1,9 @@
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
+#include <arpa/inet.h>
+
+#include <array>
+
 #include "common/common/utility.h"
 #include "common/tracing/zipkin/span_context.h"
 #include "common/tracing/zipkin/util.h"
@@ -54,6 +58,30 @@ const std::string Endpoint::toJson() {
   return json_string;
 }
 
+void Endpoint::toThrift(Buffer::Instance& output) const {
+  uint32_t ipv4 = 0;
+  uint32_t port = 0;
+  if (address_) {
+    port = address_->ip()->port();
+    if (address_->ip()->version() == Network::Address::IpVersion::v4) {
+      ipv4 = ntohl(address_->ip()->ipv4()->address());
+    }
+  }
+
+  Util::addThriftFieldHeader(output, Util::ThriftType::I32, 1);
+  Util::addThriftI32(output, ipv4);
+  Util::addThriftFieldHeader(output, Util::ThriftType::I16, 2);
+  Util::addThriftI16(output, port);
+  Util::addThriftFieldHeader(output, Util::ThriftType::String, 3);
+  Util::addThriftString(output, service_name_);
+  if (address_ && address_->ip()->version() == Network::Address::IpVersion::v6) {
+    const std::array<uint8_t, 16> ipv6 = address_->ip()->ipv6()->address();
+    Util::addThriftFieldHeader(output, Util::ThriftType::String, 4);
+    Util::addThriftString(output, ipv6.data(), ipv6.size());
+  }
+  Util::addThriftStop(output);
+}
+
 Annotation::Annotation(const Annotation& ann) {
   timestamp_ = ann.timestamp();
   value_ = ann.value();
@@ -98,6 +126,18 @@ const std::string Annotation::toJson() {
   return json_string;
 }
 
+void Annotation::toThrift(Buffer::Instance& output) const {
+  Util::addThriftFieldHeader(output, Util::ThriftType::I64, 1);
+  Util::addThriftI64(output, timestamp_);
+  Util::addThriftFieldHeader(output, Util::ThriftType::String, 2);
+  Util::addThriftString(output, value_);
+  if (endpoint_.valid()) {
+    Util::addThriftFieldHeader(output, Util::ThriftType::Struct, 3);
+    endpoint_.value().toThrift(output);
+  }
+  Util::addThriftStop(output);
+}
+
 BinaryAnnotation::BinaryAnnotation(const BinaryAnnotation& ann) {
   key_ = ann.key();
   value_ = ann.value();
@@ -138,6 +178,24 @@ const std::string BinaryAnnotation::toJson() {
   return json_string;
 }
 
+void BinaryAnnotation::toThrift(Buffer::Instance& output) const {
+  // The values of Zipkin's Thrift AnnotationType enum.
+  const int32_t THRIFT_BOOL = 0;
+  const int32_t THRIFT_STRING = 6;
+
+  Util::addThriftFieldHeader(output, Util::ThriftType::String, 1);
+  Util::addThriftString(output, key_);
+  Util::addThriftFieldHeader(output, Util::ThriftType::String, 2);
+  Util::addThriftString(output, value_);
+  Util::addThriftFieldHeader(output, Util::ThriftType::I32, 3);
+  Util::addThriftI32(output, annotation_type_ == BOOL ? THRIFT_BOOL : THRIFT_STRING);
+  if (endpoint_.valid()) {
+    Util::addThriftFieldHeader(output, Util::ThriftType::Struct, 4);
+    endpoint_.value().toThrift(output);
+  }
+  Util::addThriftStop(output);
+}
+
 const std::string Span::EMPTY_HEX_STRING_ = "0000000000000000";
 
 Span::Span(const Span& span) {
@@ -217,6 +275,54 @@ const std::string Span::toJson() {
   return json_string;
 }
 
+void Span::toThrift(Buffer::Instance& output) const {
+  Util::addThriftFieldHeader(output, Util::ThriftType::I64, 1);
+  Util::addThriftI64(output, trace_id_);
+  Util::addThriftFieldHeader(output, Util::ThriftType::String, 3);
+  Util::addThriftString(output, name_);
+  Util::addThriftFieldHeader(output, Util::ThriftType::I64, 4);
+  Util::addThriftI64(output, id_);
+
+  if (parent_id_.valid() && parent_id_.value()) {
+    Util::addThriftFieldHeader(output, Util::ThriftType::I64, 5);
+    Util::addThriftI64(output, parent_id_.value());
+  }
+
+  Util::addThriftFieldHeader(output, Util::ThriftType::List, 6);
+  Util::addThriftListHeader(output, Util::ThriftType::Struct, annotations_.size());
+  for (const Annotation& annotation : annotations_) {
+    annotation.toThrift(output);
+  }
+
+  Util::addThriftFieldHeader(output, Util::ThriftType::List, 8);
+  Util::addThriftListHeader(output, Util::ThriftType::Struct, binary_annotations_.size());
+  for (const BinaryAnnotation& binary_annotation : binary_annotations_) {
+    binary_annotation.toThrift(output);
+  }
+
+  if (debug_) {
+    const uint8_t debug = 1;
+    Util::addThriftFieldHeader(output, Util::ThriftType::Bool, 9);
+    output.add(&debug, sizeof(debug));
+  }
+
+  if (timestamp_.valid()) {
+    Util::addThriftFieldHeader(output, Util::ThriftType::I64, 10);
+    Util::addThriftI64(output, timestamp_.value());
+  }
+
+  if (duration_.valid()) {
+    Util::addThriftFieldHeader(output, Util::ThriftType::I64, 11);
+    Util::addThriftI64(output, duration_.value());
+  }
+
+  if (trace_id_high_.valid()) {
+    Util::addThriftFieldHeader(output, Util::ThriftType::I64, 12);
+    Util::addThriftI64(output, trace_id_high_.value());
+  }
+  Util::addThriftStop(output);
+}
+
 void Span::finish() {
   // Assumption: Span will have only one annotation when this method is called
   SpanContext context(*this);
@@ -254,7 +360,7 @@ void Span::finish() {
 
 void Span::setTag(const std::string& name, const std::string& value) {
   if (name.size() > 0 && value.size() > 0) {
-    addBinaryAnnotation(BinaryAnnotation(name, value));
+    binary_annotations_.emplace_back(name, value);
   }
 }
 } // namespace Zipkin
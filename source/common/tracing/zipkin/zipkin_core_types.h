@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/optional.h"
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -29,6 +30,14 @@ public:
    * the corresponding abstraction to a Zipkin-compliant JSON.
    */
   virtual const std::string toJson() PURE;
+
+  /**
+   * All classes defining Zipkin abstractions need to implement this method to write the
+   * corresponding abstraction as a Zipkin-compliant Thrift struct, in the binary protocol.
+   *
+   * @param output The buffer which the struct is appended to.
+   */
+  virtual void toThrift(Buffer::Instance& output) const PURE;
 };
 
 /**
@@ -47,6 +56,12 @@ public:
    */
   Endpoint& operator=(const Endpoint&);
 
+  /**
+   * Move constructor and assignment operator, which take the strings over rather than copy them.
+   */
+  Endpoint(Endpoint&&) = default;
+  Endpoint& operator=(Endpoint&&) = default;
+
   /**
    * Default constructor. Creates an empty Endpoint.
    */
@@ -88,6 +103,11 @@ public:
    */
   const std::string toJson() override;
 
+  /**
+   * Serializes the endpoint as a Thrift struct, in the binary protocol.
+   */
+  void toThrift(Buffer::Instance& output) const override;
+
 private:
   std::string service_name_;
   Network::Address::InstanceConstSharedPtr address_;
@@ -109,6 +129,12 @@ public:
    */
   Annotation& operator=(const Annotation&);
 
+  /**
+   * Move constructor and assignment operator, which take the strings over rather than copy them.
+   */
+  Annotation(Annotation&&) = default;
+  Annotation& operator=(Annotation&&) = default;
+
   /**
    * Default constructor. Creates an empty annotation.
    */
@@ -138,7 +164,7 @@ public:
   /**
    * Sets the annotation's endpoint attribute (move semantics).
    */
-  void setEndpoint(const Endpoint&& endpoint) { endpoint_.value(endpoint); }
+  void setEndpoint(Endpoint&& endpoint) { endpoint_.value(std::move(endpoint)); }
 
   /**
    * Replaces the endpoint's service-name attribute value with the given value.
@@ -180,6 +206,11 @@ public:
    */
   const std::string toJson() override;
 
+  /**
+   * Serializes the annotation as a Thrift struct, in the binary protocol.
+   */
+  void toThrift(Buffer::Instance& output) const override;
+
 private:
   uint64_t timestamp_;
   std::string value_;
@@ -208,6 +239,12 @@ public:
    */
   BinaryAnnotation& operator=(const BinaryAnnotation&);
 
+  /**
+   * Move constructor and assignment operator, which take the strings over rather than copy them.
+   */
+  BinaryAnnotation(BinaryAnnotation&&) = default;
+  BinaryAnnotation& operator=(BinaryAnnotation&&) = default;
+
   /**
    * Default constructor. Creates an empty binary annotation.
    */
@@ -245,7 +282,7 @@ public:
   /**
    * Sets the annotation's endpoint attribute (move semantics).
    */
-  void setEndpoint(const Endpoint&& endpoint) { endpoint_.value(endpoint); }
+  void setEndpoint(Endpoint&& endpoint) { endpoint_.value(std::move(endpoint)); }
 
   /**
    * @return true of the endpoint attribute has been set, or false otherwise.
@@ -279,6 +316,11 @@ public:
    */
   const std::string toJson() override;
 
+  /**
+   * Serializes the binary annotation as a Thrift struct, in the binary protocol.
+   */
+  void toThrift(Buffer::Instance& output) const override;
+
 private:
   std::string key_;
   std::string value_;
@@ -298,6 +340,18 @@ public:
    */
   Span(const Span&);
 
+  /**
+   * Assignment operator.
+   */
+  Span& operator=(const Span&) = default;
+
+  /**
+   * Move constructor and assignment operator. A finished span is moved to the reporter rather
+   * than copied, along with its annotations.
+   */
+  Span(Span&&) = default;
+  Span& operator=(Span&&) = default;
+
   /**
    * Default constructor. Creates an empty span.
    */
@@ -347,7 +401,7 @@ public:
   /**
    * Adds an annotation to the span (move semantics).
    */
-  void addAnnotation(const Annotation&& ann) { annotations_.push_back(ann); }
+  void addAnnotation(Annotation&& ann) { annotations_.push_back(std::move(ann)); }
 
   /**
    * Sets the span's binary annotations all at once.
@@ -362,7 +416,9 @@ public:
   /**
    * Adds a binary annotation to the span (move semantics).
    */
-  void addBinaryAnnotation(const BinaryAnnotation&& bann) { binary_annotations_.push_back(bann); }
+  void addBinaryAnnotation(BinaryAnnotation&& bann) {
+    binary_annotations_.push_back(std::move(bann));
+  }
 
   /**
    * Sets the span's debug attribute.
@@ -496,6 +552,11 @@ public:
    */
   const std::string toJson() override;
 
+  /**
+   * Serializes the span as a Thrift struct, in the binary protocol.
+   */
+  void toThrift(Buffer::Instance& output) const override;
+
   /**
    * Associates a Tracer object with the span. The tracer's reportSpan() method is invoked
    * by the span's finish() method so that the tracer can decide what to do with the span
@@ -1,6 +1,7 @@
 #include "common/tracing/zipkin/zipkin_tracer_impl.h"
 
 #include "common/common/enum_to_int.h"
+#include "common/common/hex.h"
 #include "common/common/utility.h"
 #include "common/http/headers.h"
 #include "common/http/message_impl.h"
@@ -13,7 +14,8 @@
 namespace Envoy {
 namespace Zipkin {
 
-ZipkinSpan::ZipkinSpan(Zipkin::Span& span, Zipkin::Tracer& tracer) : span_(span), tracer_(tracer) {}
+ZipkinSpan::ZipkinSpan(Zipkin::Span&& span, Zipkin::Tracer& tracer)
+    : span_(std::move(span)), tracer_(tracer) {}
 
 void ZipkinSpan::finishSpan() { span_.finish(); }
 
@@ -24,28 +26,36 @@ void ZipkinSpan::setTag(const std::string& name, const std::string& value) {
 }
 
 void ZipkinSpan::injectContext(Http::HeaderMap& request_headers) {
+  // This runs for each upstream request of a traced request, so the ids are written straight into
+  // the header values rather than through intermediate strings.
+  char hex[16];
+
   // Set the trace-id and span-id headers properly, based on the newly-created span structure.
-  request_headers.insertXB3TraceId().value(span_.traceIdAsHexString());
-  request_headers.insertXB3SpanId().value(span_.idAsHexString());
+  Hex::uint64ToHex(span_.traceId(), hex);
+  request_headers.insertXB3TraceId().value(hex, sizeof(hex));
+  Hex::uint64ToHex(span_.id(), hex);
+  request_headers.insertXB3SpanId().value(hex, sizeof(hex));
 
   // Set the parent-span header properly, based on the newly-created span structure.
   if (span_.isSetParentId()) {
-    request_headers.insertXB3ParentSpanId().value(span_.parentIdAsHexString());
+    Hex::uint64ToHex(span_.parentId(), hex);
+    request_headers.insertXB3ParentSpanId().value(hex, sizeof(hex));
   }
 
   // Set the sampled header.
   request_headers.insertXB3Sampled().value().setReference(ZipkinCoreConstants::get().ALWAYS_SAMPLE);
 
   // Set the ot-span-context header with the new context.
-  SpanContext context(span_);
-  request_headers.insertOtSpanContext().value(context.serializeToString());
+  char context[SpanContext::SERIALIZED_LENGTH];
+  SpanContext(span_).serializeTo(context);
+  request_headers.insertOtSpanContext().value(context, sizeof(context));
 }
 
 Tracing::SpanPtr ZipkinSpan::spawnChild(const Tracing::Config& config, const std::string& name,
                                         SystemTime start_time) {
   SpanContext context(span_);
   return Tracing::SpanPtr{
-      new ZipkinSpan(*tracer_.startSpan(config, name, start_time, context), tracer_)};
+      new ZipkinSpan(std::move(*tracer_.startSpan(config, name, start_time, context)), tracer_)};
 }
 
 Driver::TlsTracer::TlsTracer(TracerPtr&& tracer, Driver& driver)
@@ -67,13 +77,16 @@ Driver::Driver(const Json::Object& config, Upstream::ClusterManager& cluster_man
 
   const std::string collector_endpoint =
       config.getString("collector_endpoint", ZipkinCoreConstants::get().DEFAULT_COLLECTOR_ENDPOINT);
+  const bool thrift_encoding =
+      config.getString("collector_encoding", ZipkinCoreConstants::get().JSON_ENCODING) ==
+      ZipkinCoreConstants::get().THRIFT_ENCODING;
 
-  tls_->set([this, collector_endpoint, &random_generator](
+  tls_->set([this, collector_endpoint, thrift_encoding, &random_generator](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     TracerPtr tracer(
         new Tracer(local_info_.clusterName(), local_info_.address(), random_generator));
-    tracer->setReporter(
-        ReporterImpl::NewInstance(std::ref(*this), std::ref(dispatcher), collector_endpoint));
+    tracer->setReporter(ReporterImpl::NewInstance(std::ref(*this), std::ref(dispatcher),
+                                                  collector_endpoint, thrift_encoding));
     return ThreadLocal::ThreadLocalObjectSharedPtr{new TlsTracer(std::move(tracer), *this)};
   });
 }
@@ -125,13 +138,13 @@ Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config, Http::HeaderMa
     new_zipkin_span = tracer.startSpan(config, request_headers.Host()->value().c_str(), start_time);
   }
 
-  ZipkinSpanPtr active_span(new ZipkinSpan(*new_zipkin_span, tracer));
+  ZipkinSpanPtr active_span(new ZipkinSpan(std::move(*new_zipkin_span), tracer));
   return std::move(active_span);
 }
 
 ReporterImpl::ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
-                           const std::string& collector_endpoint)
-    : driver_(driver), collector_endpoint_(collector_endpoint) {
+                           const std::string& collector_endpoint, bool thrift_encoding)
+    : driver_(driver), collector_endpoint_(collector_endpoint), thrift_encoding_(thrift_encoding) {
   flush_timer_ = dispatcher.createTimer([this]() -> void {
     driver_.tracerStats().timer_flushed_.inc();
     flushSpans();
@@ -146,13 +159,12 @@ ReporterImpl::ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
 }
 
 ReporterPtr ReporterImpl::NewInstance(Driver& driver, Event::Dispatcher& dispatcher,
-                                      const std::string& collector_endpoint) {
-  return ReporterPtr(new ReporterImpl(driver, dispatcher, collector_endpoint));
+                                      const std::string& collector_endpoint, bool thrift_encoding) {
+  return ReporterPtr(new ReporterImpl(driver, dispatcher, collector_endpoint, thrift_encoding));
 }
 
-// TODO(fabolive): Need to avoid the copy to improve performance.
-void ReporterImpl::reportSpan(const Span& span) {
-  span_buffer_.addSpan(span);
+void ReporterImpl::reportSpan(Span&& span) {
+  span_buffer_.addSpan(std::move(span));
 
   const uint64_t min_flush_spans =
       driver_.runtime().snapshot().getInteger("tracing.zipkin.min_flush_spans", 5U);
@@ -172,16 +184,21 @@ void ReporterImpl::flushSpans() {
   if (span_buffer_.pendingSpans()) {
     driver_.tracerStats().spans_sent_.add(span_buffer_.pendingSpans());
 
-    const std::string request_body = span_buffer_.toStringifiedJsonArray();
     Http::MessagePtr message(new Http::RequestMessageImpl());
     message->headers().insertMethod().value().setReference(Http::Headers::get().MethodValues.Post);
     message->headers().insertPath().value(collector_endpoint_);
     message->headers().insertHost().value(driver_.cluster()->name());
-    message->headers().insertContentType().value().setReference(
-        Http::Headers::get().ContentTypeValues.Json);
 
     Buffer::InstancePtr body(new Buffer::OwnedImpl());
-    body->add(request_body);
+    if (thrift_encoding_) {
+      message->headers().insertContentType().value().setReference(
+          ZipkinCoreConstants::get().THRIFT_CONTENT_TYPE);
+      span_buffer_.serializeThriftList(*body);
+    } else {
+      message->headers().insertContentType().value().setReference(
+          Http::Headers::get().ContentTypeValues.Json);
+      span_buffer_.serializeJsonArray(*body);
+    }
     message->body() = std::move(body);
 
     const uint64_t timeout =
@@ -31,11 +31,11 @@ struct ZipkinTracerStats {
 class ZipkinSpan : public Tracing::Span {
 public:
   /**
-   * Constructor. Wraps a Zipkin::Span object.
+   * Constructor. Wraps a Zipkin::Span object, which is moved into the wrapper rather than copied.
    *
    * @param span to be wrapped.
    */
-  ZipkinSpan(Zipkin::Span& span, Zipkin::Tracer& tracer);
+  ZipkinSpan(Zipkin::Span&& span, Zipkin::Tracer& tracer);
 
   /**
    * Calls Zipkin::Span::finishSpan() to perform all actions needed to finalize the span.
@@ -129,7 +129,8 @@ private:
 /**
  * This class derives from the abstract Zipkin::Reporter.
  * It buffers spans and relies on Http::AsyncClient to send spans to
- * Zipkin using JSON over HTTP.
+ * Zipkin using JSON or Thrift over HTTP. Either way the spans are written straight into the body
+ * of the request.
  *
  * Two runtime parameters control the span buffering/flushing behavior, namely:
  * tracing.zipkin.min_flush_spans and tracing.zipkin.flush_interval_ms.
@@ -150,18 +151,19 @@ public:
    * @param collector_endpoint String representing the Zipkin endpoint to be used
    * when making HTTP POST requests carrying spans. This value comes from the
    * Zipkin-related tracing configuration.
+   * @param thrift_encoding Whether the spans are sent as a Thrift list rather than as a JSON array.
    */
-  ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
-               const std::string& collector_endpoint);
+  ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher, const std::string& collector_endpoint,
+               bool thrift_encoding);
 
   /**
    * Implementation of Zipkin::Reporter::reportSpan().
    *
    * Buffers the given span and calls flushSpans() if the buffer is full.
    *
-   * @param span The span to be buffered.
+   * @param span The span to be buffered. It is moved into the buffer.
    */
-  void reportSpan(const Span& span) override;
+  void reportSpan(Span&& span) override;
 
   // Http::AsyncClient::Callbacks.
   // The callbacks below record Zipkin-span-related stats.
@@ -176,11 +178,12 @@ public:
    * @param collector_endpoint String representing the Zipkin endpoint to be used
    * when making HTTP POST requests carrying spans. This value comes from the
    * Zipkin-related tracing configuration.
+   * @param thrift_encoding Whether the spans are sent as a Thrift list rather than as a JSON array.
    *
    * @return Pointer to the newly-created ZipkinReporter.
    */
   static ReporterPtr NewInstance(Driver& driver, Event::Dispatcher& dispatcher,
-                                 const std::string& collector_endpoint);
+                                 const std::string& collector_endpoint, bool thrift_encoding);
 
 private:
   /**
@@ -197,6 +200,7 @@ private:
   Event::TimerPtr flush_timer_;
   SpanBuffer span_buffer_;
   const std::string collector_endpoint_;
+  const bool thrift_encoding_;
 };
 } // Zipkin
 } // namespace Envoy
@@ -13,18 +13,19 @@ namespace Upstream {
 
 CdsApiPtr CdsApiImpl::create(const envoy::api::v2::ConfigSource& cds_config,
                              const Optional<envoy::api::v2::ConfigSource>& eds_config,
-                             ClusterManager& cm, Event::Dispatcher& dispatcher,
-                             Runtime::RandomGenerator& random,
+                             ClusterManager& cm, ThreadLocal::Instance& tls,
+                             Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
                              const LocalInfo::LocalInfo& local_info, Stats::Scope& scope) {
   return CdsApiPtr{
-      new CdsApiImpl(cds_config, eds_config, cm, dispatcher, random, local_info, scope)};
+      new CdsApiImpl(cds_config, eds_config, cm, tls, dispatcher, random, local_info, scope)};
 }
 
 CdsApiImpl::CdsApiImpl(const envoy::api::v2::ConfigSource& cds_config,
                        const Optional<envoy::api::v2::ConfigSource>& eds_config, ClusterManager& cm,
-                       Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
-                       const LocalInfo::LocalInfo& local_info, Stats::Scope& scope)
-    : cm_(cm), scope_(scope.createScope("cluster_manager.cds.")) {
+                       ThreadLocal::Instance& tls, Event::Dispatcher& dispatcher,
+                       Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
+                       Stats::Scope& scope)
+    : cm_(cm), tls_(tls), scope_(scope.createScope("cluster_manager.cds.")) {
   Config::Utility::checkLocalInfo("cds", local_info);
   subscription_ =
       Config::SubscriptionFactory::subscriptionFromConfigSource<envoy::api::v2::Cluster>(
@@ -41,6 +42,9 @@ CdsApiImpl::CdsApiImpl(const envoy::api::v2::ConfigSource& cds_config,
 void CdsApiImpl::onConfigUpdate(const ResourceVector& resources) {
   cm_.adsMux().pause(Config::TypeUrl::get().ClusterLoadAssignment);
   Cleanup eds_resume([this] { cm_.adsMux().resume(Config::TypeUrl::get().ClusterLoadAssignment); });
+  // Workers pick up all the cluster changes of the update at once.
+  tls_.startBatch();
+  Cleanup tls_batch([this] { tls_.endBatch(); });
   // We need to keep track of which clusters we might need to remove.
   ClusterManager::ClusterInfoMap clusters_to_remove = cm_.clusters();
   for (auto& cluster : resources) {
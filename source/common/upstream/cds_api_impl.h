@@ -5,6 +5,7 @@
 #include "envoy/config/subscription.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/local_info/local_info.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/common/logger.h"
@@ -23,9 +24,9 @@ class CdsApiImpl : public CdsApi,
 public:
   static CdsApiPtr create(const envoy::api::v2::ConfigSource& cds_config,
                           const Optional<envoy::api::v2::ConfigSource>& eds_config,
-                          ClusterManager& cm, Event::Dispatcher& dispatcher,
-                          Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
-                          Stats::Scope& scope);
+                          ClusterManager& cm, ThreadLocal::Instance& tls,
+                          Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
+                          const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
 
   // Upstream::CdsApi
   void initialize() override { subscription_->start({}, *this); }
@@ -37,8 +38,9 @@ public:
 private:
   CdsApiImpl(const envoy::api::v2::ConfigSource& cds_config,
              const Optional<envoy::api::v2::ConfigSource>& eds_config, ClusterManager& cm,
-             Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
-             const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
+             ThreadLocal::Instance& tls, Event::Dispatcher& dispatcher,
+             Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
+             Stats::Scope& scope);
   void runInitializeCallbackIfAny();
 
   // Config::SubscriptionCallbacks
@@ -46,6 +48,7 @@ private:
   void onConfigUpdateFailed(const EnvoyException* e) override;
 
   ClusterManager& cm_;
+  ThreadLocal::Instance& tls_;
   std::unique_ptr<Config::Subscription<envoy::api::v2::Cluster>> subscription_;
   std::function<void()> initialize_callback_;
   Stats::ScopePtr scope_;
@@ -51,6 +51,7 @@ private:
   // Http::RestApiFetcher
   void createRequest(Http::Message& request) override;
   void parseResponse(const Http::Message& response) override;
+  void onResponseUnchanged() override { stats_.update_success_.inc(); }
   void onFetchComplete() override;
   void onFetchFailure(const EnvoyException* e) override;
 
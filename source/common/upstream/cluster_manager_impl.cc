@@ -1,5 +1,6 @@
 #include "common/upstream/cluster_manager_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -18,13 +19,16 @@
 #include "common/http/async_client_impl.h"
 #include "common/http/http1/conn_pool.h"
 #include "common/http/http2/conn_pool.h"
+#include "common/http/http2/shared_conn_pool.h"
 #include "common/json/config_schemas.h"
 #include "common/network/resolver_impl.h"
 #include "common/network/utility.h"
 #include "common/protobuf/utility.h"
 #include "common/router/shadow_writer_impl.h"
+#include "common/runtime/key_registry.h"
 #include "common/upstream/cds_api_impl.h"
 #include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
 #include "common/upstream/original_dst_cluster.h"
 #include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/subset_lb.h"
@@ -34,9 +38,14 @@
 namespace Envoy {
 namespace Upstream {
 
+static const Runtime::Key& RuntimeUseHttp2 =
+    Runtime::KeyRegistry::registerKey("upstream.use_http2");
+static const Runtime::Key& RuntimeMaxInitializingClusters =
+    Runtime::KeyRegistry::registerKey("upstream.max_initializing_clusters");
+
 void ClusterManagerInitHelper::addCluster(Cluster& cluster) {
   if (state_ == State::AllClustersInitialized) {
-    cluster.initialize([] {});
+    initializeCluster(cluster, [] {});
     return;
   }
 
@@ -47,14 +56,14 @@ void ClusterManagerInitHelper::addCluster(Cluster& cluster) {
 
   if (cluster.initializePhase() == Cluster::InitializePhase::Primary) {
     primary_init_clusters_.push_back(&cluster);
-    cluster.initialize(initialize_cb);
+    initializeCluster(cluster, initialize_cb);
   } else {
     ASSERT(cluster.initializePhase() == Cluster::InitializePhase::Secondary);
     secondary_init_clusters_.push_back(&cluster);
     if (started_secondary_initialize_) {
       // This can happen if we get a second CDS update that adds new clusters after we have
       // already started secondary init. In this case, just immediately initialize.
-      cluster.initialize(initialize_cb);
+      initializeCluster(cluster, initialize_cb);
     }
   }
 
@@ -63,6 +72,18 @@ void ClusterManagerInitHelper::addCluster(Cluster& cluster) {
 }
 
 void ClusterManagerInitHelper::removeCluster(Cluster& cluster) {
+  // A removed cluster gives up its initialization slot, or its place in the queue for one.
+  if (initializing_clusters_.erase(&cluster) > 0) {
+    stats_.initializing_clusters_.set(initializing_clusters_.size());
+    startPendingInitialize();
+  } else {
+    pending_initialize_clusters_.remove_if(
+        [&cluster](const std::pair<Cluster*, std::function<void()>>& pending) -> bool {
+          return pending.first == &cluster;
+        });
+    stats_.pending_initialize_clusters_.set(pending_initialize_clusters_.size());
+  }
+
   if (state_ == State::AllClustersInitialized) {
     return;
   }
@@ -85,6 +106,50 @@ void ClusterManagerInitHelper::removeCluster(Cluster& cluster) {
   maybeFinishInitialize();
 }
 
+void ClusterManagerInitHelper::initializeCluster(Cluster& cluster,
+                                                 std::function<void()> callback) {
+  // 0 means no limit.
+  const uint64_t max_initializing =
+      runtime_.snapshot().getInteger(RuntimeMaxInitializingClusters, 0);
+  if (max_initializing > 0 && initializing_clusters_.size() >= max_initializing) {
+    pending_initialize_clusters_.emplace_back(&cluster, callback);
+    stats_.pending_initialize_clusters_.set(pending_initialize_clusters_.size());
+    return;
+  }
+
+  startInitialize(cluster, callback);
+}
+
+void ClusterManagerInitHelper::startInitialize(Cluster& cluster, std::function<void()> callback) {
+  initializing_clusters_[&cluster] = ProdMonotonicTimeSource::instance_.currentTime();
+  stats_.initializing_clusters_.set(initializing_clusters_.size());
+  cluster.initialize([this, &cluster, callback]() -> void {
+    auto it = initializing_clusters_.find(&cluster);
+    if (it != initializing_clusters_.end()) {
+      stats_.cluster_initialize_ms_.recordValue(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              ProdMonotonicTimeSource::instance_.currentTime() - it->second)
+              .count());
+      initializing_clusters_.erase(it);
+      stats_.initializing_clusters_.set(initializing_clusters_.size());
+    }
+    callback();
+    startPendingInitialize();
+  });
+}
+
+void ClusterManagerInitHelper::startPendingInitialize() {
+  const uint64_t max_initializing =
+      runtime_.snapshot().getInteger(RuntimeMaxInitializingClusters, 0);
+  while (!pending_initialize_clusters_.empty() &&
+         (max_initializing == 0 || initializing_clusters_.size() < max_initializing)) {
+    auto pending = pending_initialize_clusters_.front();
+    pending_initialize_clusters_.pop_front();
+    stats_.pending_initialize_clusters_.set(pending_initialize_clusters_.size());
+    startInitialize(*pending.first, pending.second);
+  }
+}
+
 void ClusterManagerInitHelper::maybeFinishInitialize() {
   // Do not do anything if we are still doing the initial static load or if we are waiting for
   // CDS initialize.
@@ -110,7 +175,7 @@ void ClusterManagerInitHelper::maybeFinishInitialize() {
       for (auto iter = secondary_init_clusters_.begin(); iter != secondary_init_clusters_.end();) {
         Cluster* cluster = *iter;
         ++iter;
-        cluster->initialize([cluster, this] {
+        initializeCluster(*cluster, [cluster, this] {
           ASSERT(state_ != State::AllClustersInitialized);
           removeCluster(*cluster);
         });
@@ -168,9 +233,12 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
                                        Runtime::RandomGenerator& random,
                                        const LocalInfo::LocalInfo& local_info,
                                        AccessLog::AccessLogManager& log_manager,
-                                       Event::Dispatcher& primary_dispatcher)
+                                       Event::Dispatcher& primary_dispatcher,
+                                       bool create_load_balancers)
     : factory_(factory), runtime_(runtime), stats_(stats), tls_(tls.allocateSlot()),
-      random_(random), local_info_(local_info), cm_stats_(generateStats(stats)) {
+      random_(random), local_info_(local_info), cm_stats_(generateStats(stats)),
+      init_helper_(cm_stats_, runtime), main_thread_dispatcher_(primary_dispatcher),
+      create_load_balancers_(create_load_balancers) {
   const auto& ads_config = bootstrap.dynamic_resources().ads_config();
   if (ads_config.cluster_name().empty()) {
     ENVOY_LOG(debug, "No ADS clusters defined, ADS will not be initialized.");
@@ -207,7 +275,8 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
   }
 
   for (const auto& cluster : bootstrap.static_resources().clusters()) {
-    loadCluster(cluster, false);
+    // Static clusters can't be updated, so their config is never hashed.
+    loadCluster(cluster, 0, false);
   }
 
   // We can now potentially create the CDS API once the backing cluster exists.
@@ -229,6 +298,10 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
 
   tls_->set([this, local_cluster_name](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    if (&dispatcher != &main_thread_dispatcher_) {
+      std::lock_guard<std::mutex> guard(worker_dispatchers_lock_);
+      worker_dispatchers_.push_back(&dispatcher);
+    }
     return ThreadLocal::ThreadLocalObjectSharedPtr{
         new ThreadLocalClusterManagerImpl(*this, dispatcher, local_cluster_name)};
   });
@@ -260,7 +333,8 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
 ClusterManagerStats ClusterManagerImpl::generateStats(Stats::Scope& scope) {
   const std::string final_prefix = "cluster_manager.";
   return {ALL_CLUSTER_MANAGER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
-                                    POOL_GAUGE_PREFIX(scope, final_prefix))};
+                                    POOL_GAUGE_PREFIX(scope, final_prefix),
+                                    POOL_HISTOGRAM_PREFIX(scope, final_prefix))};
 }
 
 void ClusterManagerImpl::postInitializeCluster(Cluster& cluster) {
@@ -276,9 +350,12 @@ bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster
   // We don't allow updates to statically configured clusters in the main configuration.
   const std::string cluster_name = cluster.name();
   auto existing_cluster = primary_clusters_.find(cluster_name);
+  if (existing_cluster != primary_clusters_.end() && !existing_cluster->second.added_via_api_) {
+    return false;
+  }
+  const uint64_t config_hash = MessageUtil::hash(cluster);
   if (existing_cluster != primary_clusters_.end() &&
-      (!existing_cluster->second.added_via_api_ ||
-       existing_cluster->second.config_hash_ == MessageUtil::hash(cluster))) {
+      existing_cluster->second.config_hash_ == config_hash) {
     return false;
   }
 
@@ -286,21 +363,26 @@ bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster
     init_helper_.removeCluster(*existing_cluster->second.cluster_);
   }
 
-  loadCluster(cluster, true);
+  loadCluster(cluster, config_hash, true);
   ClusterInfoConstSharedPtr new_cluster = primary_clusters_.at(cluster_name).cluster_->info();
+  ClusterSharedPtr original_dst_cluster = originalDstCluster(cluster_name);
   ENVOY_LOG(info, "add/update cluster {}", cluster_name);
-  tls_->runOnAllThreads([this, new_cluster]() -> void {
+  tls_->runOnAllThreads([this, new_cluster, original_dst_cluster]() -> void {
     ThreadLocalClusterManagerImpl& cluster_manager =
         tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-    if (cluster_manager.thread_local_clusters_.count(new_cluster->name()) > 0) {
+    // Replacing the slot drops any entry built for the old cluster along with its connection
+    // pools. The new cluster's entry is built on first use.
+    if (cluster_manager.thread_local_clusters_.erase(new_cluster->name()) > 0) {
       ENVOY_LOG(debug, "updating TLS cluster {}", new_cluster->name());
+      cluster_manager.generation_++;
     } else {
       ENVOY_LOG(debug, "adding TLS cluster {}", new_cluster->name());
     }
 
-    cluster_manager.thread_local_clusters_[new_cluster->name()].reset(
-        new ThreadLocalClusterManagerImpl::ClusterEntry(cluster_manager, new_cluster));
+    cluster_manager.thread_local_clusters_.emplace(
+        new_cluster->name(),
+        ThreadLocalClusterManagerImpl::ClusterSlot(new_cluster, original_dst_cluster));
   });
 
   postInitializeCluster(*primary_clusters_.at(cluster_name).cluster_);
@@ -325,12 +407,19 @@ bool ClusterManagerImpl::removePrimaryCluster(const std::string& cluster_name) {
     ASSERT(cluster_manager.thread_local_clusters_.count(cluster_name) == 1);
     ENVOY_LOG(debug, "removing TLS cluster {}", cluster_name);
     cluster_manager.thread_local_clusters_.erase(cluster_name);
+    cluster_manager.generation_++;
   });
 
   return true;
 }
 
-void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, bool added_via_api) {
+ClusterSharedPtr ClusterManagerImpl::originalDstCluster(const std::string& name) {
+  const ClusterSharedPtr& cluster = primary_clusters_.at(name).cluster_;
+  return cluster->info()->lbType() == LoadBalancerType::OriginalDst ? cluster : nullptr;
+}
+
+void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, uint64_t config_hash,
+                                     bool added_via_api) {
   ClusterSharedPtr new_cluster =
       factory_.clusterFromProto(cluster, *this, outlier_event_logger_, added_via_api);
 
@@ -355,7 +444,7 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, boo
   size_t num_erased = primary_clusters_.erase(primary_cluster_reference.info()->name());
   primary_clusters_.emplace(
       primary_cluster_reference.info()->name(),
-      PrimaryClusterData{MessageUtil::hash(cluster), added_via_api, std::move(new_cluster)});
+      PrimaryClusterData{config_hash, added_via_api, std::move(new_cluster)});
 
   cm_stats_.total_clusters_.set(primary_clusters_.size());
   if (num_erased) {
@@ -367,13 +456,17 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, boo
 
 ThreadLocalCluster* ClusterManagerImpl::get(const std::string& cluster) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
+  return cluster_manager.getOrCreateEntry(cluster);
+}
 
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry != cluster_manager.thread_local_clusters_.end()) {
-    return entry->second.get();
-  } else {
-    return nullptr;
-  }
+bool ClusterManagerImpl::threadLocalClusterBuiltForTest(const std::string& cluster) {
+  ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
+  auto it = cluster_manager.thread_local_clusters_.find(cluster);
+  return it != cluster_manager.thread_local_clusters_.end() && it->second.entry_ != nullptr;
+}
+
+uint64_t ClusterManagerImpl::threadLocalGeneration() {
+  return tls_->getTyped<ThreadLocalClusterManagerImpl>().generation_;
 }
 
 Http::ConnectionPool::Instance*
@@ -381,13 +474,13 @@ ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourceP
                                            LoadBalancerContext* context) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry == cluster_manager.thread_local_clusters_.end()) {
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getOrCreateEntry(cluster);
+  if (entry == nullptr) {
     return nullptr;
   }
 
   // Select a host and create a connection pool for it if it does not already exist.
-  return entry->second->connPool(priority, context);
+  return entry->connPool(priority, context);
 }
 
 void ClusterManagerImpl::postThreadLocalClusterUpdate(
@@ -399,46 +492,98 @@ void ClusterManagerImpl::postThreadLocalClusterUpdate(
     return;
   }
 
+  // The primary cluster never modifies its host vectors once they are installed, so all workers
+  // share them instead of each update copying them. Workers only act on the added and removed
+  // hosts.
   const std::string& name = primary_cluster.info()->name();
-  HostVectorConstSharedPtr hosts_copy(new std::vector<HostSharedPtr>(primary_cluster.hosts()));
-  HostVectorConstSharedPtr healthy_hosts_copy(
-      new std::vector<HostSharedPtr>(primary_cluster.healthyHosts()));
-  HostListsConstSharedPtr hosts_per_locality_copy(
-      new std::vector<std::vector<HostSharedPtr>>(primary_cluster.hostsPerLocality()));
-  HostListsConstSharedPtr healthy_hosts_per_locality_copy(
-      new std::vector<std::vector<HostSharedPtr>>(primary_cluster.healthyHostsPerLocality()));
-
-  tls_->runOnAllThreads([this, name, hosts_copy, healthy_hosts_copy, hosts_per_locality_copy,
-                         healthy_hosts_per_locality_copy, hosts_added, hosts_removed]() -> void {
+  HostVectorConstSharedPtr hosts = primary_cluster.hostsPtr();
+  HostVectorConstSharedPtr healthy_hosts = primary_cluster.healthyHostsPtr();
+  HostListsConstSharedPtr hosts_per_locality = primary_cluster.hostsPerLocalityPtr();
+  HostListsConstSharedPtr healthy_hosts_per_locality =
+      primary_cluster.healthyHostsPerLocalityPtr();
+
+  tls_->runOnAllThreads([this, name, hosts, healthy_hosts, hosts_per_locality,
+                         healthy_hosts_per_locality, hosts_added, hosts_removed]() -> void {
     ThreadLocalClusterManagerImpl::updateClusterMembership(
-        name, hosts_copy, healthy_hosts_copy, hosts_per_locality_copy,
-        healthy_hosts_per_locality_copy, hosts_added, hosts_removed, *tls_);
+        name, hosts, healthy_hosts, hosts_per_locality, healthy_hosts_per_locality, hosts_added,
+        hosts_removed, *tls_);
   });
 }
 
+Event::Dispatcher* ClusterManagerImpl::sharedConnPoolOwner(Event::Dispatcher& dispatcher,
+                                                           uint64_t owners) {
+  std::lock_guard<std::mutex> guard(worker_dispatchers_lock_);
+  auto it = std::find(worker_dispatchers_.begin(), worker_dispatchers_.end(), &dispatcher);
+  if (it == worker_dispatchers_.end()) {
+    // The main thread keeps its own connections.
+    return nullptr;
+  }
+
+  // The first workers own the connections, and each of the others places its streams on one of
+  // them.
+  const uint64_t index = it - worker_dispatchers_.begin();
+  return index < owners ? nullptr : worker_dispatchers_[index % owners];
+}
+
 Host::CreateConnectionData ClusterManagerImpl::tcpConnForCluster(const std::string& cluster,
                                                                  LoadBalancerContext* context) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry == cluster_manager.thread_local_clusters_.end()) {
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getOrCreateEntry(cluster);
+  if (entry == nullptr) {
     throw EnvoyException(fmt::format("unknown cluster '{}'", cluster));
   }
 
-  HostConstSharedPtr logical_host = entry->second->lb_->chooseHost(context);
+  HostConstSharedPtr logical_host = entry->lb_->chooseHost(context);
   if (logical_host) {
     return logical_host->createConnection(cluster_manager.thread_local_dispatcher_);
   } else {
-    entry->second->cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    entry->cluster_info_->stats().upstream_cx_none_healthy_.inc();
     return {nullptr, nullptr};
   }
 }
 
+PooledTcpConnectionData ClusterManagerImpl::pooledTcpConnForCluster(const std::string& cluster,
+                                                                    LoadBalancerContext* context) {
+  ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
+
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getOrCreateEntry(cluster);
+  if (entry == nullptr) {
+    throw EnvoyException(fmt::format("unknown cluster '{}'", cluster));
+  }
+
+  HostConstSharedPtr logical_host = entry->lb_->chooseHost(context);
+  if (!logical_host) {
+    entry->cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    return {{nullptr, nullptr}, false};
+  }
+
+  if (entry->tcp_pool_size_ == 0) {
+    return {logical_host->createConnection(cluster_manager.thread_local_dispatcher_), false};
+  }
+
+  TcpConnPoolPtr& pool = cluster_manager.host_tcp_conn_pool_map_[logical_host];
+  if (!pool) {
+    pool.reset(new TcpConnPool(cluster_manager.thread_local_dispatcher_, logical_host));
+  }
+
+  // Whether or not a connection is taken, the pool is topped up for the next ones.
+  Host::CreateConnectionData data = pool->take();
+  pool->fill(entry->tcp_pool_size_);
+  if (data.connection_) {
+    entry->cluster_info_->stats().upstream_cx_pool_hit_.inc();
+    return {std::move(data), true};
+  }
+
+  entry->cluster_info_->stats().upstream_cx_pool_miss_.inc();
+  return {logical_host->createConnection(cluster_manager.thread_local_dispatcher_), false};
+}
+
 Http::AsyncClient& ClusterManagerImpl::httpAsyncClientForCluster(const std::string& cluster) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry != cluster_manager.thread_local_clusters_.end()) {
-    return entry->second->http_async_client_;
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getOrCreateEntry(cluster);
+  if (entry != nullptr) {
+    return entry->http_async_client_;
   } else {
     throw EnvoyException(fmt::format("unknown cluster '{}'", cluster));
   }
@@ -452,14 +597,13 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
   if (local_cluster_name.valid()) {
     ENVOY_LOG(debug, "adding TLS local cluster {}", local_cluster_name.value());
     auto& local_cluster = parent.primary_clusters_.at(local_cluster_name.value()).cluster_;
-    thread_local_clusters_[local_cluster_name.value()].reset(
-        new ClusterEntry(*this, local_cluster->info()));
+    thread_local_clusters_.emplace(
+        local_cluster_name.value(),
+        ClusterSlot(local_cluster->info(), parent.originalDstCluster(local_cluster_name.value())));
+    // Other clusters' load balancers follow the local cluster's hosts, so it is built up front.
+    local_host_set_ = &getOrCreateEntry(local_cluster_name.value())->host_set_;
   }
 
-  local_host_set_ = local_cluster_name.valid()
-                        ? &thread_local_clusters_[local_cluster_name.value()]->host_set_
-                        : nullptr;
-
   for (auto& cluster : parent.primary_clusters_) {
     // If local cluster name is set then we already initialized this cluster.
     if (local_cluster_name.valid() && local_cluster_name.value() == cluster.first) {
@@ -468,8 +612,9 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
 
     ENVOY_LOG(debug, "adding TLS initial cluster {}", cluster.first);
     ASSERT(thread_local_clusters_.count(cluster.first) == 0);
-    thread_local_clusters_[cluster.first].reset(
-        new ClusterEntry(*this, cluster.second.cluster_->info()));
+    thread_local_clusters_.emplace(
+        cluster.first,
+        ClusterSlot(cluster.second.cluster_->info(), parent.originalDstCluster(cluster.first)));
   }
 }
 
@@ -482,17 +627,39 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   //                     redis/conn_pool_impl.cc. Will fix at the same time.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
   host_http_conn_pool_map_.clear();
+  host_tcp_conn_pool_map_.clear();
   for (auto& cluster : thread_local_clusters_) {
-    if (&cluster.second->host_set_ != local_host_set_) {
-      cluster.second.reset();
+    if (cluster.second.entry_ && &cluster.second.entry_->host_set_ != local_host_set_) {
+      cluster.second.entry_.reset();
     }
   }
   thread_local_clusters_.clear();
 }
 
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::getOrCreateEntry(const std::string& name) {
+  auto it = thread_local_clusters_.find(name);
+  if (it == thread_local_clusters_.end()) {
+    return nullptr;
+  }
+
+  ClusterSlot& slot = it->second;
+  if (!slot.entry_) {
+    ENVOY_LOG(debug, "creating TLS cluster {} on first use", name);
+    slot.entry_.reset(new ClusterEntry(*this, slot.info_, slot.original_dst_cluster_));
+    if (slot.hosts_) {
+      slot.entry_->host_set_.updateHosts(slot.hosts_, slot.healthy_hosts_,
+                                         slot.hosts_per_locality_,
+                                         slot.healthy_hosts_per_locality_, *slot.hosts_, {});
+    }
+  }
+  return slot.entry_.get();
+}
+
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::drainConnPools(
     const std::vector<HostSharedPtr>& hosts) {
   for (const HostSharedPtr& host : hosts) {
+    host_tcp_conn_pool_map_.erase(host);
     auto container = host_http_conn_pool_map_.find(host);
     if (container != host_http_conn_pool_map_.end()) {
       drainConnPools(host, container->second);
@@ -542,20 +709,32 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::updateClusterMembership(
 
   ThreadLocalClusterManagerImpl& config = tls.getTyped<ThreadLocalClusterManagerImpl>();
 
-  ASSERT(config.thread_local_clusters_.find(name) != config.thread_local_clusters_.end());
-  config.thread_local_clusters_[name]->host_set_.updateHosts(
-      std::move(hosts), std::move(healthy_hosts), std::move(hosts_per_locality),
-      std::move(healthy_hosts_per_locality), hosts_added, hosts_removed);
+  auto it = config.thread_local_clusters_.find(name);
+  ASSERT(it != config.thread_local_clusters_.end());
+  ClusterSlot& slot = it->second;
+  slot.hosts_ = hosts;
+  slot.healthy_hosts_ = healthy_hosts;
+  slot.hosts_per_locality_ = hosts_per_locality;
+  slot.healthy_hosts_per_locality_ = healthy_hosts_per_locality;
+  if (slot.entry_) {
+    slot.entry_->host_set_.updateHosts(std::move(hosts), std::move(healthy_hosts),
+                                       std::move(hosts_per_locality),
+                                       std::move(healthy_hosts_per_locality), hosts_added,
+                                       hosts_removed);
+  }
 }
 
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
-    ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster)
+    ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster,
+    ClusterSharedPtr original_dst_cluster)
     : parent_(parent), cluster_info_(cluster),
       http_async_client_(*cluster, parent.parent_.stats_, parent.thread_local_dispatcher_,
                          parent.parent_.local_info_, parent.parent_, parent.parent_.runtime_,
                          parent.parent_.random_,
                          Router::ShadowWriterPtr{new Router::ShadowWriterImpl(parent.parent_)}) {
-  if (cluster->lbSubsetInfo().isEnabled()) {
+  if (!parent.parent_.create_load_balancers_) {
+    // Leave lb_ empty. The owner of the cluster manager never asks for a host.
+  } else if (cluster->lbSubsetInfo().isEnabled()) {
     lb_.reset(new SubsetLoadBalancer(cluster->lbType(), host_set_, parent.local_host_set_,
                                      cluster->stats(), parent.parent_.runtime_,
                                      parent.parent_.random_, cluster->lbSubsetInfo()));
@@ -581,14 +760,40 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
                                          parent.parent_.random_));
       break;
     }
+    case LoadBalancerType::Maglev: {
+      lb_.reset(new MaglevLoadBalancer(host_set_, cluster->stats(), parent.parent_.runtime_,
+                                       parent.parent_.random_));
+      break;
+    }
     case LoadBalancerType::OriginalDst: {
-      lb_.reset(new OriginalDstCluster::LoadBalancer(
-          host_set_, parent.parent_.primary_clusters_.at(cluster->name()).cluster_));
+      lb_.reset(new OriginalDstCluster::LoadBalancer(host_set_, original_dst_cluster));
       break;
     }
     }
   }
 
+  // Runtime can have a few workers own the HTTP/2 connections to the hosts of the cluster, so
+  // that the other workers do not each keep mostly idle connections of their own. The owner
+  // chooses the host without the request's load balancer context, so this is refused for load
+  // balancers which choose hosts based on the request.
+  const uint64_t shared_conn_pool_owners = parent.parent_.runtime_.snapshot().getInteger(
+      fmt::format("upstream.http2_shared_connection_workers.{}", cluster->name()), 0);
+  if (shared_conn_pool_owners > 0 && (cluster->features() & ClusterInfo::Features::HTTP2) &&
+      parent.parent_.runtime_.snapshot().featureEnabled(RuntimeUseHttp2, 100)) {
+    if (loadBalancerUsesContext(*cluster)) {
+      ENVOY_LOG(warn,
+                "not sharing HTTP/2 connections across workers for cluster {}: its load balancer "
+                "chooses hosts based on the request",
+                cluster->name());
+    } else {
+      shared_conn_pool_owner_ = parent.parent_.sharedConnPoolOwner(
+          parent.thread_local_dispatcher_, shared_conn_pool_owners);
+    }
+  }
+
+  tcp_pool_size_ = parent.parent_.runtime_.snapshot().getInteger(
+      fmt::format("upstream.tcp_idle_connections.{}", cluster->name()), 0);
+
   host_set_.addMemberUpdateCb([this](const std::vector<HostSharedPtr>&,
                                      const std::vector<HostSharedPtr>& hosts_removed) -> void {
     // We need to go through and purge any connection pools for hosts that got deleted.
@@ -598,6 +803,26 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
   });
 }
 
+bool ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::loadBalancerUsesContext(
+    const ClusterInfo& cluster) {
+  if (cluster.lbSubsetInfo().isEnabled()) {
+    return true;
+  }
+
+  switch (cluster.lbType()) {
+  case LoadBalancerType::RingHash:
+  case LoadBalancerType::Maglev:
+  case LoadBalancerType::OriginalDst:
+    return true;
+  case LoadBalancerType::LeastRequest:
+  case LoadBalancerType::Random:
+  case LoadBalancerType::RoundRobin:
+    return false;
+  }
+
+  NOT_REACHED;
+}
+
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::~ClusterEntry() {
   // We need to drain all connection pools for the cluster being removed. Then we can remove the
   // cluster.
@@ -611,6 +836,33 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::~ClusterEntry()
 Http::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
     ResourcePriority priority, LoadBalancerContext* context) {
+  if (shared_conn_pool_owner_ == nullptr) {
+    return localConnPool(priority, context);
+  }
+
+  Http::ConnectionPool::InstancePtr& pool = shared_conn_pools_[enumToInt(priority)];
+  if (!pool) {
+    ClusterManagerImpl& cluster_manager = parent_.parent_;
+    const std::string name = cluster_info_->name();
+    pool.reset(new Http::Http2::SharedConnPoolImpl(
+        parent_.thread_local_dispatcher_, *shared_conn_pool_owner_,
+        [&cluster_manager, name, priority]() -> Http::ConnectionPool::Instance* {
+          // This runs on the owner, which chooses the host itself. The request's load balancer
+          // context stays on the worker it came from, which is why sharing is refused for load
+          // balancers that use it.
+          ClusterEntry* entry =
+              cluster_manager.tls_->getTyped<ThreadLocalClusterManagerImpl>().getOrCreateEntry(
+                  name);
+          return entry != nullptr ? entry->localConnPool(priority, nullptr) : nullptr;
+        }));
+  }
+
+  return pool.get();
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::localConnPool(
+    ResourcePriority priority, LoadBalancerContext* context) {
   HostConstSharedPtr host = lb_->chooseHost(context);
   if (!host) {
     cluster_info_->stats().upstream_cx_none_healthy_.inc();
@@ -632,19 +884,40 @@ ClusterManagerPtr ProdClusterManagerFactory::clusterManagerFromProto(
     Runtime::Loader& runtime, Runtime::RandomGenerator& random,
     const LocalInfo::LocalInfo& local_info, AccessLog::AccessLogManager& log_manager) {
   return ClusterManagerPtr{new ClusterManagerImpl(bootstrap, *this, stats, tls, runtime, random,
-                                                  local_info, log_manager, primary_dispatcher_)};
+                                                  local_info, log_manager, primary_dispatcher_,
+                                                  true)};
 }
 
 Http::ConnectionPool::InstancePtr
 ProdClusterManagerFactory::allocateConnPool(Event::Dispatcher& dispatcher, HostConstSharedPtr host,
                                             ResourcePriority priority) {
   if ((host->cluster().features() & ClusterInfo::Features::HTTP2) &&
-      runtime_.snapshot().featureEnabled("upstream.use_http2", 100)) {
-    return Http::ConnectionPool::InstancePtr{
-        new Http::Http2::ProdConnPoolImpl(dispatcher, host, priority)};
+      runtime_.snapshot().featureEnabled(RuntimeUseHttp2, 100)) {
+    // By default all streams to a host share one connection. Runtime can spread them over more
+    // connections, opening another once the least loaded one reaches the stream threshold.
+    const std::string& cluster_name = host->cluster().name();
+    const uint64_t max_connections = runtime_.snapshot().getInteger(
+        fmt::format("upstream.http2_max_connections.{}", cluster_name), 1);
+    const uint64_t stream_threshold = runtime_.snapshot().getInteger(
+        fmt::format("upstream.http2_connection_stream_threshold.{}", cluster_name), 100);
+    return Http::ConnectionPool::InstancePtr{new Http::Http2::ProdConnPoolImpl(
+        dispatcher, host, priority, max_connections, stream_threshold)};
   } else {
-    return Http::ConnectionPool::InstancePtr{
-        new Http::Http1::ConnPoolImplProd(dispatcher, host, priority)};
+    // By default idle connections stay open until the host closes them, and connections are only
+    // opened for requests, each serving one request at a time. Runtime can close idle connections,
+    // open some ahead of requests and pipeline requests.
+    const std::string& cluster_name = host->cluster().name();
+    const std::chrono::milliseconds idle_timeout(runtime_.snapshot().getInteger(
+        fmt::format("upstream.http1_idle_timeout_ms.{}", cluster_name), 0));
+    const uint64_t min_ready_connections = runtime_.snapshot().getInteger(
+        fmt::format("upstream.http1_min_ready_connections.{}", cluster_name), 0);
+    const uint64_t preconnect_percent = runtime_.snapshot().getInteger(
+        fmt::format("upstream.http1_preconnect_percent.{}", cluster_name), 100);
+    const uint64_t pipeline_depth = runtime_.snapshot().getInteger(
+        fmt::format("upstream.http1_pipeline_depth.{}", cluster_name), 1);
+    return Http::ConnectionPool::InstancePtr{new Http::Http1::ConnPoolImplProd(
+        dispatcher, host, priority, idle_timeout, min_ready_connections,
+        preconnect_percent / 100.0, pipeline_depth)};
   }
 }
 
@@ -660,8 +933,8 @@ CdsApiPtr
 ProdClusterManagerFactory::createCds(const envoy::api::v2::ConfigSource& cds_config,
                                      const Optional<envoy::api::v2::ConfigSource>& eds_config,
                                      ClusterManager& cm) {
-  return CdsApiImpl::create(cds_config, eds_config, cm, primary_dispatcher_, random_, local_info_,
-                            stats_);
+  return CdsApiImpl::create(cds_config, eds_config, cm, tls_, primary_dispatcher_, random_,
+                            local_info_, stats_);
 }
 
 } // namespace Upstream
@@ -5,6 +5,7 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -19,6 +20,8 @@
 #include "common/config/grpc_mux_impl.h"
 #include "common/http/async_client_impl.h"
 #include "common/upstream/load_stats_reporter.h"
+#include "common/upstream/response_time_tracker_impl.h"
+#include "common/upstream/tcp_conn_pool.h"
 #include "common/upstream/upstream_impl.h"
 
 #include "api/bootstrap.pb.h"
@@ -71,12 +74,41 @@ private:
   const LocalInfo::LocalInfo& local_info_;
 };
 
+/**
+ * All cluster manager stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CLUSTER_MANAGER_STATS(COUNTER, GAUGE, HISTOGRAM)                                       \
+  COUNTER(cluster_added)                                                                           \
+  COUNTER(cluster_modified)                                                                        \
+  COUNTER(cluster_removed)                                                                         \
+  GAUGE  (total_clusters)                                                                          \
+  GAUGE  (initializing_clusters)                                                                   \
+  GAUGE  (pending_initialize_clusters)                                                             \
+  HISTOGRAM(cluster_initialize_ms)
+// clang-format on
+
+/**
+ * Struct definition for all cluster manager stats. @see stats_macros.h
+ */
+struct ClusterManagerStats {
+  ALL_CLUSTER_MANAGER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT,
+                            GENERATE_HISTOGRAM_STRUCT)
+};
+
 /**
  * This is a helper class used during cluster management initialization. Dealing with primary
  * clusters, secondary clusters, and CDS, is quite complicated, so this makes it easier to test.
+ * All cluster initialization, including that of clusters added after the cluster manager is
+ * initialized, goes through the helper, which limits how many clusters initialize at once so that
+ * a large CDS update doesn't start every DNS resolution, EDS subscription and health check at the
+ * same time.
  */
 class ClusterManagerInitHelper : Logger::Loggable<Logger::Id::upstream> {
 public:
+  ClusterManagerInitHelper(ClusterManagerStats& stats, Runtime::Loader& runtime)
+      : stats_(stats), runtime_(runtime) {}
+
   enum class State {
     // Initial state. During this state all static clusters are loaded. Any phase 1 clusters
     // are immediately initialized.
@@ -102,32 +134,23 @@ public:
   State state() const { return state_; }
 
 private:
+  void initializeCluster(Cluster& cluster, std::function<void()> callback);
+  void startInitialize(Cluster& cluster, std::function<void()> callback);
+  void startPendingInitialize();
   void maybeFinishInitialize();
 
+  ClusterManagerStats& stats_;
+  Runtime::Loader& runtime_;
   CdsApi* cds_{};
   std::function<void()> initialized_callback_;
   std::list<Cluster*> primary_init_clusters_;
   std::list<Cluster*> secondary_init_clusters_;
   State state_{State::Loading};
   bool started_secondary_initialize_{};
-};
-
-/**
- * All cluster manager stats. @see stats_macros.h
- */
-// clang-format off
-#define ALL_CLUSTER_MANAGER_STATS(COUNTER, GAUGE)                                                  \
-  COUNTER(cluster_added)                                                                           \
-  COUNTER(cluster_modified)                                                                        \
-  COUNTER(cluster_removed)                                                                         \
-  GAUGE  (total_clusters)
-// clang-format on
-
-/**
- * Struct definition for all cluster manager stats. @see stats_macros.h
- */
-struct ClusterManagerStats {
-  ALL_CLUSTER_MANAGER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+  // Clusters whose initialize() was called and has not yet completed, with its start time.
+  std::unordered_map<Cluster*, MonotonicTime> initializing_clusters_;
+  // Clusters waiting for a free initialization slot, in the order they were added.
+  std::list<std::pair<Cluster*, std::function<void()>>> pending_initialize_clusters_;
 };
 
 /**
@@ -136,11 +159,13 @@ struct ClusterManagerStats {
  */
 class ClusterManagerImpl : public ClusterManager, Logger::Loggable<Logger::Id::upstream> {
 public:
+  static ClusterManagerStats generateStats(Stats::Scope& scope);
+
   ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstrap, ClusterManagerFactory& factory,
                      Stats::Store& stats, ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
                      Runtime::RandomGenerator& random, const LocalInfo::LocalInfo& local_info,
                      AccessLog::AccessLogManager& log_manager,
-                     Event::Dispatcher& primary_dispatcher);
+                     Event::Dispatcher& primary_dispatcher, bool create_load_balancers);
 
   // Upstream::ClusterManager
   bool addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster& cluster) override;
@@ -156,11 +181,14 @@ public:
     return clusters_map;
   }
   ThreadLocalCluster* get(const std::string& cluster) override;
+  uint64_t threadLocalGeneration() override;
   Http::ConnectionPool::Instance* httpConnPoolForCluster(const std::string& cluster,
                                                          ResourcePriority priority,
                                                          LoadBalancerContext* context) override;
   Host::CreateConnectionData tcpConnForCluster(const std::string& cluster,
                                                LoadBalancerContext* context) override;
+  PooledTcpConnectionData pooledTcpConnForCluster(const std::string& cluster,
+                                                  LoadBalancerContext* context) override;
   Http::AsyncClient& httpAsyncClientForCluster(const std::string& cluster) override;
   bool removePrimaryCluster(const std::string& cluster) override;
   void shutdown() override {
@@ -174,6 +202,11 @@ public:
 
   Config::GrpcMux& adsMux() override { return *ads_mux_; }
 
+  /**
+   * For testing. @return whether the calling thread has built its ClusterEntry for a cluster.
+   */
+  bool threadLocalClusterBuiltForTest(const std::string& cluster);
+
 private:
   /**
    * Thread local cached cluster data. Each thread local cluster gets updates from the parent
@@ -189,29 +222,72 @@ private:
     };
 
     struct ClusterEntry : public ThreadLocalCluster {
-      ClusterEntry(ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster);
+      ClusterEntry(ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster,
+                   ClusterSharedPtr original_dst_cluster);
       ~ClusterEntry();
 
       Http::ConnectionPool::Instance* connPool(ResourcePriority priority,
                                                LoadBalancerContext* context);
+      Http::ConnectionPool::Instance* localConnPool(ResourcePriority priority,
+                                                    LoadBalancerContext* context);
+      // @return whether the cluster's load balancer chooses hosts based on the request, in which
+      // case its HTTP/2 connections are never shared across workers.
+      static bool loadBalancerUsesContext(const ClusterInfo& cluster);
 
       // Upstream::ThreadLocalCluster
       const HostSet& hostSet() override { return host_set_; }
       ClusterInfoConstSharedPtr info() override { return cluster_info_; }
-      LoadBalancer& loadBalancer() override { return *lb_; }
+      LoadBalancer& loadBalancer() override {
+        ASSERT(lb_ != nullptr);
+        return *lb_;
+      }
+      ResponseTimeTracker& responseTimes() override { return response_times_; }
+      Http::ConnectionPool::Instance* httpConnPool(ResourcePriority priority,
+                                                   LoadBalancerContext* context) override {
+        return connPool(priority, context);
+      }
 
       ThreadLocalClusterManagerImpl& parent_;
       HostSetImpl host_set_;
       LoadBalancerPtr lb_;
       ClusterInfoConstSharedPtr cluster_info_;
       Http::AsyncClientImpl http_async_client_;
+      ResponseTimeHistogram response_times_;
+      // Set if the worker places its HTTP/2 streams on the connections of another worker.
+      Event::Dispatcher* shared_conn_pool_owner_{};
+      std::array<Http::ConnectionPool::InstancePtr, NumResourcePriorities> shared_conn_pools_;
+      // How many established TCP connections the worker keeps to each host. 0 disables the pool.
+      uint32_t tcp_pool_size_{};
     };
 
     typedef std::unique_ptr<ClusterEntry> ClusterEntryPtr;
 
+    /**
+     * A worker's view of a cluster. The ClusterEntry with its load balancer and async client is
+     * only built when the cluster is first used on the worker, since many clusters never see
+     * traffic on most workers. Until then, membership updates only replace the shared host
+     * vectors, which seed the entry when it is built.
+     */
+    struct ClusterSlot {
+      ClusterSlot(ClusterInfoConstSharedPtr info, ClusterSharedPtr original_dst_cluster)
+          : info_(info), original_dst_cluster_(original_dst_cluster) {}
+
+      ClusterInfoConstSharedPtr info_;
+      // Only set for original destination clusters, whose load balancer needs the primary
+      // cluster. It is captured on the main thread as the primary cluster map may not be read
+      // from workers.
+      ClusterSharedPtr original_dst_cluster_;
+      HostVectorConstSharedPtr hosts_;
+      HostVectorConstSharedPtr healthy_hosts_;
+      HostListsConstSharedPtr hosts_per_locality_;
+      HostListsConstSharedPtr healthy_hosts_per_locality_;
+      ClusterEntryPtr entry_;
+    };
+
     ThreadLocalClusterManagerImpl(ClusterManagerImpl& parent, Event::Dispatcher& dispatcher,
                                   const Optional<std::string>& local_cluster_name);
     ~ThreadLocalClusterManagerImpl();
+    ClusterEntry* getOrCreateEntry(const std::string& name);
     void drainConnPools(const std::vector<HostSharedPtr>& hosts);
     void drainConnPools(HostSharedPtr old_host, ConnPoolsContainer& container);
     static void updateClusterMembership(const std::string& name, HostVectorConstSharedPtr hosts,
@@ -224,8 +300,11 @@ private:
 
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
-    std::unordered_map<std::string, ClusterEntryPtr> thread_local_clusters_;
+    std::unordered_map<std::string, ClusterSlot> thread_local_clusters_;
+    // Bumped whenever a slot is replaced or removed, which destroys the entry it held.
+    uint64_t generation_{};
     std::unordered_map<HostConstSharedPtr, ConnPoolsContainer> host_http_conn_pool_map_;
+    std::unordered_map<HostConstSharedPtr, TcpConnPoolPtr> host_tcp_conn_pool_map_;
     const HostSet* local_host_set_{};
   };
 
@@ -238,12 +317,14 @@ private:
     ClusterSharedPtr cluster_;
   };
 
-  static ClusterManagerStats generateStats(Stats::Scope& scope);
-  void loadCluster(const envoy::api::v2::Cluster& cluster, bool added_via_api);
+  void loadCluster(const envoy::api::v2::Cluster& cluster, uint64_t config_hash,
+                   bool added_via_api);
   void postInitializeCluster(Cluster& cluster);
+  ClusterSharedPtr originalDstCluster(const std::string& name);
   void postThreadLocalClusterUpdate(const Cluster& primary_cluster,
                                     const std::vector<HostSharedPtr>& hosts_added,
                                     const std::vector<HostSharedPtr>& hosts_removed);
+  Event::Dispatcher* sharedConnPoolOwner(Event::Dispatcher& dispatcher, uint64_t owners);
 
   ClusterManagerFactory& factory_;
   Runtime::Loader& runtime_;
@@ -260,6 +341,13 @@ private:
   ClusterManagerInitHelper init_helper_;
   Config::GrpcMuxPtr ads_mux_;
   LoadStatsReporterPtr load_stats_reporter_;
+  Event::Dispatcher& main_thread_dispatcher_;
+  // False when nothing will ever choose a host, e.g. during config validation. The thread local
+  // clusters then have no load balancer, which saves building rings and locality state.
+  const bool create_load_balancers_;
+  // The dispatchers of the workers, in the order their thread local cluster managers were built.
+  std::vector<Event::Dispatcher*> worker_dispatchers_;
+  std::mutex worker_dispatchers_lock_;
 };
 
 } // namespace Upstream
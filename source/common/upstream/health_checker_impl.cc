@@ -1,5 +1,6 @@
 #include "common/upstream/health_checker_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -216,9 +217,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess() {
   parent_.stats_.success_.inc();
   first_check_ = false;
   parent_.runCallbacks(host_, changed_state);
-
-  timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval());
+  scheduleNextCheck();
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(FailureType type) {
@@ -247,8 +246,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(FailureType t
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleFailure(FailureType type) {
   setUnhealthy(type);
-  timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval());
+  scheduleNextCheck();
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::onIntervalBase() {
@@ -262,6 +260,26 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onTimeoutBase() {
   handleFailure(FailureType::Network);
 }
 
+void HealthCheckerImplBase::ActiveHealthCheckSession::scheduleNextCheck() {
+  timeout_timer_->disableTimer();
+  const std::chrono::milliseconds interval = parent_.interval();
+  if (!spread_) {
+    spread_ = true;
+    // The hosts of a cluster are all checked when the health checker starts, or when they are
+    // added, and each host is then checked an interval after its previous check, so their checks
+    // stay in bursts. Checking each host a second time at a random point of the interval spreads
+    // the checks evenly over the interval from then on.
+    if (interval.count() > 0 &&
+        parent_.runtime_.snapshot().featureEnabled("health_check.spread_checks", 0)) {
+      interval_timer_->enableTimer(
+          std::chrono::milliseconds(parent_.random_.random() % interval.count()));
+      return;
+    }
+  }
+
+  interval_timer_->enableTimer(interval);
+}
+
 HttpHealthCheckerImpl::HttpHealthCheckerImpl(const Cluster& cluster,
                                              const envoy::api::v2::HealthCheck& config,
                                              Event::Dispatcher& dispatcher,
@@ -404,14 +422,26 @@ TcpHealthCheckMatcher::MatchSegments TcpHealthCheckMatcher::loadProtoBytes(
 }
 
 bool TcpHealthCheckMatcher::match(const MatchSegments& expected, const Buffer::Instance& buffer) {
-  uint64_t start_index = 0;
-  for (const std::vector<uint8_t>& segment : expected) {
-    ssize_t search_result = buffer.search(&segment[0], segment.size(), start_index);
+  MatchState state;
+  return match(expected, buffer, state);
+}
+
+bool TcpHealthCheckMatcher::match(const MatchSegments& expected, const Buffer::Instance& buffer,
+                                  MatchState& state) {
+  auto segment = expected.begin();
+  std::advance(segment, state.matched_segments_);
+  for (; segment != expected.end(); ++segment) {
+    ssize_t search_result = buffer.search(&(*segment)[0], segment->size(), state.search_index_);
     if (search_result == -1) {
+      // Any later occurrence must end in data which has not arrived yet.
+      if (buffer.length() >= segment->size()) {
+        state.search_index_ = std::max(state.search_index_, buffer.length() - segment->size() + 1);
+      }
       return false;
     }
 
-    start_index = search_result + segment.size();
+    state.matched_segments_++;
+    state.search_index_ = search_result + segment->size();
   }
 
   return true;
@@ -438,8 +468,9 @@ TcpHealthCheckerImpl::TcpActiveHealthCheckSession::~TcpActiveHealthCheckSession(
 
 void TcpHealthCheckerImpl::TcpActiveHealthCheckSession::onData(Buffer::Instance& data) {
   ENVOY_CONN_LOG(trace, "total pending buffer={}", *client_, data.length());
-  if (TcpHealthCheckMatcher::match(parent_.receive_bytes_, data)) {
+  if (TcpHealthCheckMatcher::match(parent_.receive_bytes_, data, match_state_)) {
     data.drain(data.length());
+    match_state_ = {};
     handleSuccess();
   }
 }
@@ -476,6 +507,7 @@ void TcpHealthCheckerImpl::TcpActiveHealthCheckSession::onEvent(Network::Connect
 
 void TcpHealthCheckerImpl::TcpActiveHealthCheckSession::onInterval() {
   if (!client_) {
+    match_state_ = {};
     client_ = host_->createConnection(parent_.dispatcher_).connection_;
     session_callbacks_.reset(new TcpSessionCallbacks(*this));
     client_->addConnectionCallbacks(*session_callbacks_);
@@ -551,6 +583,13 @@ void RedisHealthCheckerImpl::RedisActiveHealthCheckSession::onResponse(
   } else {
     handleFailure(FailureType::Active);
   }
+
+  // Unless the connection is kept for the next check, close it so that it does not sit idle on
+  // the server for the rest of the interval. The client is deleted once the close is raised.
+  if (client_ &&
+      parent_.runtime_.snapshot().getInteger("health_check.redis.reuse_connection", 1) == 0) {
+    client_->close();
+  }
 }
 
 void RedisHealthCheckerImpl::RedisActiveHealthCheckSession::onFailure() {
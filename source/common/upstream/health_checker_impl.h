@@ -100,6 +100,7 @@ protected:
     void onIntervalBase();
     virtual void onTimeout() PURE;
     void onTimeoutBase();
+    void scheduleNextCheck();
 
     HealthCheckerImplBase& parent_;
     Event::TimerPtr interval_timer_;
@@ -107,6 +108,7 @@ protected:
     uint32_t num_unhealthy_{};
     uint32_t num_healthy_{};
     bool first_check_{true};
+    bool spread_{};
   };
 
   typedef std::unique_ptr<ActiveHealthCheckSession> ActiveHealthCheckSessionPtr;
@@ -289,9 +291,27 @@ class TcpHealthCheckMatcher {
 public:
   typedef std::list<std::vector<uint8_t>> MatchSegments;
 
+  /**
+   * Progress of a match over a buffer which is searched again as more data arrives.
+   */
+  struct MatchState {
+    // Number of segments found so far.
+    uint32_t matched_segments_{0};
+    // Where the search for the next segment resumes.
+    uint64_t search_index_{0};
+  };
+
   static MatchSegments loadProtoBytes(
       const Protobuf::RepeatedPtrField<envoy::api::v2::HealthCheck::Payload>& byte_array);
   static bool match(const MatchSegments& expected, const Buffer::Instance& buffer);
+
+  /**
+   * Match as above, resuming from the segments found by previous calls so that the data searched
+   * by them is not searched again. The buffer must only have been added to since the previous
+   * call with the same state, which must be reset when the buffer is drained.
+   */
+  static bool match(const MatchSegments& expected, const Buffer::Instance& buffer,
+                    MatchState& state);
 };
 
 /**
@@ -339,6 +359,7 @@ private:
     TcpHealthCheckerImpl& parent_;
     Network::ClientConnectionPtr client_;
     std::shared_ptr<TcpSessionCallbacks> session_callbacks_;
+    TcpHealthCheckMatcher::MatchState match_state_;
   };
 
   typedef std::unique_ptr<TcpActiveHealthCheckSession> TcpActiveHealthCheckSessionPtr;
@@ -384,6 +405,7 @@ private:
       // Allow the main HC infra to control timeout.
       return parent_.timeout_ * 2;
     }
+    bool batchWrites() const override { return false; }
 
     // Redis::ConnPool::PoolCallbacks
     void onResponse(Redis::RespValuePtr&& value) override;
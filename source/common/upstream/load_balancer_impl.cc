@@ -9,13 +9,21 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/common/assert.h"
+#include "common/runtime/key_registry.h"
 
 namespace Envoy {
 namespace Upstream {
 
-static const std::string RuntimeZoneEnabled = "upstream.zone_routing.enabled";
-static const std::string RuntimeMinClusterSize = "upstream.zone_routing.min_cluster_size";
-static const std::string RuntimePanicThreshold = "upstream.healthy_panic_threshold";
+static const Runtime::Key& RuntimeZoneEnabled =
+    Runtime::KeyRegistry::registerKey("upstream.zone_routing.enabled");
+static const Runtime::Key& RuntimeMinClusterSize =
+    Runtime::KeyRegistry::registerKey("upstream.zone_routing.min_cluster_size");
+static const Runtime::Key& RuntimePanicThreshold =
+    Runtime::KeyRegistry::registerKey("upstream.healthy_panic_threshold");
+static const Runtime::Key& RuntimeWeightEnabled =
+    Runtime::KeyRegistry::registerKey("upstream.weight_enabled");
+static const Runtime::Key& RuntimePeakEwmaEnabled =
+    Runtime::KeyRegistry::registerKey("upstream.least_request.peak_ewma_enabled");
 
 LoadBalancerBase::LoadBalancerBase(const HostSet& host_set, const HostSet* local_host_set,
                                    ClusterStats& stats, Runtime::Loader& runtime,
@@ -53,11 +61,13 @@ void LoadBalancerBase::regenerateLocalityRoutingStructures() {
   size_t num_localities = host_set_.healthyHostsPerLocality().size();
   ASSERT(num_localities > 0);
 
-  uint64_t local_percentage[num_localities];
-  calculateLocalityPercentage(local_host_set_->healthyHostsPerLocality(), local_percentage);
-
-  uint64_t upstream_percentage[num_localities];
-  calculateLocalityPercentage(host_set_.healthyHostsPerLocality(), upstream_percentage);
+  // The locality percentages are computed once per membership update by the host sets, and are
+  // shared by all of the load balancers routing based on them. In particular the local cluster's
+  // are not recomputed by the load balancer of every upstream cluster on each local update.
+  const std::vector<uint64_t>& local_percentage = local_host_set_->healthyLocalityPercentages();
+  const std::vector<uint64_t>& upstream_percentage = host_set_.healthyLocalityPercentages();
+  ASSERT(local_percentage.size() == num_localities);
+  ASSERT(upstream_percentage.size() == num_localities);
 
   // If we have lower percent of hosts in the local cluster in the same locality,
   // we can push all of the requests directly to upstream cluster in the same locality.
@@ -78,33 +88,22 @@ void LoadBalancerBase::regenerateLocalityRoutingStructures() {
   // locality we should route. Percentage of requests routed cross locality to a specific locality
   // needed be proportional to the residual capacity upstream locality has.
   //
-  // residual_capacity contains capacity left in a given locality, we keep accumulating residual
-  // capacity to make search for sampled value easier.
   // For example, if we have the following upstream and local percentage:
   // local_percentage: 40000 40000 20000
   // upstream_percentage: 25000 50000 25000
-  // Residual capacity would look like: 0 10000 5000. Now we need to sample proportionally to
-  // bucket sizes (residual capacity). For simplicity of finding where specific
-  // sampled value is, we accumulate values in residual capacity. This is what it will look like:
-  // residual_capacity: 0 10000 15000
-  // Now to find a locality to route (bucket) we could simply iterate over residual_capacity
-  // searching where sampled value is placed.
-  residual_capacity_.resize(num_localities);
+  // Residual capacity would look like: 0 10000 5000. We sample proportionally to these through
+  // an alias table, so that picking a locality is O(1) however many localities there are.
+  std::vector<uint64_t> residual_capacity(num_localities);
 
   // Local locality (index 0) does not have residual capacity as we have routed all we could.
-  residual_capacity_[0] = 0;
   for (size_t i = 1; i < num_localities; ++i) {
     // Only route to the localities that have additional capacity.
     if (upstream_percentage[i] > local_percentage[i]) {
-      residual_capacity_[i] =
-          residual_capacity_[i - 1] + upstream_percentage[i] - local_percentage[i];
-    } else {
-      // Locality with index "i" does not have residual capacity, but we keep accumulating previous
-      // values to make search easier on the next step.
-      residual_capacity_[i] = residual_capacity_[i - 1];
+      residual_capacity[i] = upstream_percentage[i] - local_percentage[i];
     }
   }
-};
+  residual_capacity_.build(residual_capacity);
+}
 
 bool LoadBalancerBase::earlyExitNonLocalityRouting() {
   if (host_set_.healthyHostsPerLocality().size() < 2) {
@@ -132,6 +131,51 @@ bool LoadBalancerBase::earlyExitNonLocalityRouting() {
   return false;
 }
 
+void AliasTable::build(const std::vector<uint64_t>& weights) {
+  columns_.clear();
+  total_weight_ = 0;
+  for (uint64_t weight : weights) {
+    total_weight_ += weight;
+  }
+  if (total_weight_ == 0) {
+    return;
+  }
+
+  // Each column holds total_weight_ of probability mass. Scaling the weights by the number of
+  // columns keeps everything in integers: a column is full when its scaled weight reaches
+  // total_weight_. Under-full columns are topped up from over-full ones, which become their alias.
+  const size_t n = weights.size();
+  columns_.resize(n);
+  std::vector<uint64_t> scaled(n);
+  std::vector<size_t> small;
+  std::vector<size_t> large;
+  for (size_t i = 0; i < n; i++) {
+    scaled[i] = weights[i] * n;
+    columns_[i] = {total_weight_, i};
+    (scaled[i] < total_weight_ ? small : large).push_back(i);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    const size_t under = small.back();
+    small.pop_back();
+    const size_t over = large.back();
+    large.pop_back();
+
+    columns_[under] = {scaled[under], over};
+    scaled[over] = scaled[over] + scaled[under] - total_weight_;
+    (scaled[over] < total_weight_ ? small : large).push_back(over);
+  }
+
+  // Whatever is left is full up to rounding, and always picks itself (set above).
+}
+
+size_t AliasTable::pick(uint64_t random) const {
+  ASSERT(!empty());
+  const size_t index = random % columns_.size();
+  const Column& column = columns_[index];
+  return (random / columns_.size()) % total_weight_ < column.threshold_ ? index : column.alias_;
+}
+
 bool LoadBalancerUtility::isGlobalPanic(const HostSet& host_set, Runtime::Loader& runtime) {
   uint64_t global_panic_threshold =
       std::min<uint64_t>(100, runtime.snapshot().getInteger(RuntimePanicThreshold, 50));
@@ -147,19 +191,6 @@ bool LoadBalancerUtility::isGlobalPanic(const HostSet& host_set, Runtime::Loader
   return false;
 }
 
-void LoadBalancerBase::calculateLocalityPercentage(
-    const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality, uint64_t* ret) {
-  uint64_t total_hosts = 0;
-  for (const auto& locality_hosts : hosts_per_locality) {
-    total_hosts += locality_hosts.size();
-  }
-
-  size_t i = 0;
-  for (const auto& locality_hosts : hosts_per_locality) {
-    ret[i++] = total_hosts > 0 ? 10000ULL * locality_hosts.size() / total_hosts : 0;
-  }
-}
-
 const std::vector<HostSharedPtr>& LoadBalancerBase::tryChooseLocalLocalityHosts() {
   ASSERT(locality_routing_state_ != LocalityRoutingState::NoLocalityRouting);
 
@@ -190,23 +221,14 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::tryChooseLocalLocalityHosts(
 
   // This is *extremely* unlikely but possible due to rounding errors when calculating
   // locality percentages. In this case just select random locality.
-  if (residual_capacity_[number_of_localities - 1] == 0) {
+  if (residual_capacity_.empty()) {
     stats_.lb_zone_no_capacity_left_.inc();
     return host_set_.healthyHostsPerLocality()[random_.random() % number_of_localities];
   }
 
   // Random sampling to select specific locality for cross locality traffic based on the additional
   // capacity in localities.
-  uint64_t threshold = random_.random() % residual_capacity_[number_of_localities - 1];
-
-  // This potentially can be optimized to be O(log(N)) where N is the number of localities.
-  // Linear scan should be faster for smaller N, in most of the scenarios N will be small.
-  int i = 0;
-  while (threshold > residual_capacity_[i]) {
-    i++;
-  }
-
-  return host_set_.healthyHostsPerLocality()[i];
+  return host_set_.healthyHostsPerLocality()[residual_capacity_.pick(random_.random())];
 }
 
 const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
@@ -233,13 +255,42 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
   return tryChooseLocalLocalityHosts();
 }
 
+RoundRobinLoadBalancer::RoundRobinLoadBalancer(const HostSet& host_set,
+                                               const HostSet* local_host_set,
+                                               ClusterStats& stats, Runtime::Loader& runtime,
+                                               Runtime::RandomGenerator& random)
+    : LoadBalancerBase(host_set, local_host_set, stats, runtime, random) {
+  host_set.addMemberUpdateCb(
+      [this](const std::vector<HostSharedPtr>&, const std::vector<HostSharedPtr>&) -> void {
+        // The host vectors which the schedules index into, and the weights of their hosts, may
+        // have changed.
+        schedulers_.clear();
+      });
+}
+
 HostConstSharedPtr RoundRobinLoadBalancer::chooseHost(LoadBalancerContext*) {
   const std::vector<HostSharedPtr>& hosts_to_use = hostsToUse();
   if (hosts_to_use.empty()) {
     return nullptr;
   }
 
-  return hosts_to_use[rr_index_++ % hosts_to_use.size()];
+  if (stats_.max_host_weight_.value() <= 1 ||
+      runtime_.snapshot().getInteger(RuntimeWeightEnabled, 1UL) == 0) {
+    return hosts_to_use[rr_index_++ % hosts_to_use.size()];
+  }
+
+  EdfScheduler& scheduler = schedulers_[&hosts_to_use];
+  if (scheduler.empty()) {
+    for (size_t i = 0; i < hosts_to_use.size(); i++) {
+      scheduler.push({1.0 / hosts_to_use[i]->weight(), i});
+    }
+  }
+
+  const EdfEntry entry = scheduler.top();
+  scheduler.pop();
+  const HostSharedPtr& host = hosts_to_use[entry.index_];
+  scheduler.push({entry.deadline_ + 1.0 / host->weight(), entry.index_});
+  return host;
 }
 
 LeastRequestLoadBalancer::LeastRequestLoadBalancer(const HostSet& host_set,
@@ -264,7 +315,7 @@ LeastRequestLoadBalancer::LeastRequestLoadBalancer(const HostSet& host_set,
 
 HostConstSharedPtr LeastRequestLoadBalancer::chooseHost(LoadBalancerContext*) {
   bool is_weight_imbalanced = stats_.max_host_weight_.value() != 1;
-  bool is_weight_enabled = runtime_.snapshot().getInteger("upstream.weight_enabled", 1UL) != 0;
+  bool is_weight_enabled = runtime_.snapshot().getInteger(RuntimeWeightEnabled, 1UL) != 0;
 
   if (is_weight_imbalanced && hits_left_ > 0 && is_weight_enabled) {
     --hits_left_;
@@ -290,6 +341,18 @@ HostConstSharedPtr LeastRequestLoadBalancer::chooseHost(LoadBalancerContext*) {
   } else {
     HostSharedPtr host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
     HostSharedPtr host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
+    const double response_time1 = host1->outlierDetector().peakEwmaResponseTime();
+    const double response_time2 = host2->outlierDetector().peakEwmaResponseTime();
+    if (response_time1 >= 0 && response_time2 >= 0 &&
+        runtime_.snapshot().getInteger(RuntimePeakEwmaEnabled, 0) != 0) {
+      // The cost of a host is its expected response time scaled by the requests a new request
+      // would queue behind. Response times are whole milliseconds, so one is added to keep the
+      // active requests of fast hosts from multiplying to nothing.
+      const double cost1 = (response_time1 + 1) * (host1->stats().rq_active_.value() + 1);
+      const double cost2 = (response_time2 + 1) * (host2->stats().rq_active_.value() + 1);
+      return cost1 < cost2 ? host1 : host2;
+    }
+
     if (host1->stats().rq_active_.value() < host2->stats().rq_active_.value()) {
       return host1;
     } else {
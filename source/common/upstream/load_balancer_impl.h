@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <queue>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
@@ -26,6 +28,42 @@ public:
   static bool isGlobalPanic(const HostSet& host_set, Runtime::Loader& runtime);
 };
 
+/**
+ * Alias table (Vose's method) for sampling an index in proportion to its weight in O(1), however
+ * many weights there are. Building the table is O(n).
+ */
+class AliasTable {
+public:
+  /**
+   * Rebuild the table.
+   * @param weights supplies the weight of each index. Indices with a 0 weight are never picked.
+   */
+  void build(const std::vector<uint64_t>& weights);
+
+  /**
+   * @return whether there is anything to pick, i.e. any index has a non 0 weight.
+   */
+  bool empty() const { return total_weight_ == 0; }
+
+  /**
+   * Pick an index. The table must not be empty.
+   * @param random supplies a random value. A single value selects both the column and the coin
+   *        flip of the column.
+   * @return the picked index.
+   */
+  size_t pick(uint64_t random) const;
+
+private:
+  struct Column {
+    // The column's own index is picked if the coin flip falls below this, else the alias is.
+    uint64_t threshold_;
+    size_t alias_;
+  };
+
+  std::vector<Column> columns_;
+  uint64_t total_weight_{};
+};
+
 /**
  * Base class for all LB implementations.
  */
@@ -58,15 +96,6 @@ private:
    */
   const std::vector<HostSharedPtr>& tryChooseLocalLocalityHosts();
 
-  /**
-   * @return (number of hosts in a given locality)/(total number of hosts) in ret param.
-   * The result is stored as integer number and scaled by 10000 multiplier for better precision.
-   * Caller is responsible for allocation/de-allocation of ret.
-   */
-  void
-  calculateLocalityPercentage(const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality,
-                              uint64_t* ret);
-
   /**
    * Regenerate locality aware routing structures for fast decisions on upstream locality selection.
    */
@@ -76,25 +105,46 @@ private:
   const HostSet* local_host_set_;
   uint64_t local_percent_to_route_{};
   LocalityRoutingState locality_routing_state_{LocalityRoutingState::NoLocalityRouting};
-  std::vector<uint64_t> residual_capacity_;
+  // Picks the locality for cross locality traffic in proportion to its residual capacity.
+  AliasTable residual_capacity_;
   Common::CallbackHandle* local_host_set_member_update_cb_handle_{};
 };
 
 /**
  * Implementation of LoadBalancer that performs RR selection across the hosts in the cluster.
+ *
+ * When any of the hosts have non 1 weight, hosts are selected by an earliest deadline first
+ * schedule: each host has a deadline which moves on by 1 / weight whenever it is selected, and the
+ * host with the earliest deadline is selected next. Hosts are selected in proportion to their
+ * weight and interleaved with each other, at O(log n) per selection.
  */
 class RoundRobinLoadBalancer : public LoadBalancer, LoadBalancerBase {
 public:
   RoundRobinLoadBalancer(const HostSet& host_set, const HostSet* local_host_set_,
                          ClusterStats& stats, Runtime::Loader& runtime,
-                         Runtime::RandomGenerator& random)
-      : LoadBalancerBase(host_set, local_host_set_, stats, runtime, random) {}
+                         Runtime::RandomGenerator& random);
 
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
 private:
+  struct EdfEntry {
+    // Orders the entries of a priority_queue by earliest deadline, then by host index so that hosts
+    // with equal deadlines take turns in order.
+    bool operator<(const EdfEntry& rhs) const {
+      return deadline_ != rhs.deadline_ ? deadline_ > rhs.deadline_ : index_ > rhs.index_;
+    }
+
+    double deadline_;
+    size_t index_;
+  };
+
+  typedef std::priority_queue<EdfEntry> EdfScheduler;
+
   size_t rr_index_{};
+  // A schedule for each host vector hostsToUse() has returned since the last membership update,
+  // holding indices into the vector.
+  std::unordered_map<const std::vector<HostSharedPtr>*, EdfScheduler> schedulers_;
 };
 
 /**
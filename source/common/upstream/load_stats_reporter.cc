@@ -50,8 +50,8 @@ void LoadStatsReporter::establishNewStream() {
 
 void LoadStatsReporter::sendLoadStatsRequest() {
   request_.mutable_cluster_stats()->Clear();
+  auto cluster_info_map = cm_.clusters();
   for (const std::string& cluster_name : clusters_) {
-    auto cluster_info_map = cm_.clusters();
     auto it = cluster_info_map.find(cluster_name);
     if (it == cluster_info_map.end()) {
       ENVOY_LOG(debug, "Cluster {} does not exist", cluster_name);
@@ -64,17 +64,11 @@ void LoadStatsReporter::sendLoadStatsRequest() {
       auto* locality_stats = cluster_stats->add_upstream_locality_stats();
       ASSERT(hosts.size() > 0);
       locality_stats->mutable_locality()->MergeFrom(hosts[0]->locality());
-      uint64_t rq_success = 0;
-      uint64_t rq_error = 0;
-      uint64_t rq_active = 0;
-      for (auto host : hosts) {
-        rq_success += host->stats().rq_success_.latch();
-        rq_error += host->stats().rq_error_.latch();
-        rq_active += host->stats().rq_active_.value();
-      }
-      locality_stats->set_total_successful_requests(rq_success);
-      locality_stats->set_total_error_requests(rq_error);
-      locality_stats->set_total_requests_in_progress(rq_active);
+      // The hosts total their load report stats per locality as they update them.
+      LocalityLoadStats& stats = cluster.info()->localityLoadStats(hosts[0]->locality());
+      locality_stats->set_total_successful_requests(stats.rq_success_.latch());
+      locality_stats->set_total_error_requests(stats.rq_error_.latch());
+      locality_stats->set_total_requests_in_progress(stats.rq_active_.value());
     }
     cluster_stats->set_total_dropped_requests(
         cluster.info()->loadReportStats().upstream_rq_dropped_.latch());
@@ -104,18 +98,20 @@ void LoadStatsReporter::onReceiveMessage(
     std::unique_ptr<envoy::api::v2::LoadStatsResponse>&& message) {
   ENVOY_LOG(debug, "New load report epoch: {}", message->DebugString());
   clusters_.clear();
-  // Reset stats for all hosts in clusters we are tracking.
+  // Reset stats for all localities in clusters we are tracking.
+  auto cluster_info_map = cm_.clusters();
   for (const std::string& cluster_name : message->clusters()) {
     clusters_.emplace_back(cluster_name);
-    auto cluster_info_map = cm_.clusters();
     auto it = cluster_info_map.find(cluster_name);
     if (it == cluster_info_map.end()) {
       continue;
     }
     auto& cluster = it->second.get();
-    for (auto host : cluster.hosts()) {
-      host->stats().rq_success_.latch();
-      host->stats().rq_error_.latch();
+    for (auto& hosts : cluster.hostsPerLocality()) {
+      ASSERT(hosts.size() > 0);
+      LocalityLoadStats& stats = cluster.info()->localityLoadStats(hosts[0]->locality());
+      stats.rq_success_.latch();
+      stats.rq_error_.latch();
     }
     cluster.info()->loadReportStats().upstream_rq_dropped_.latch();
   }
@@ -0,0 +1,96 @@
+#include "common/upstream/maglev_lb.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/common/hash.h"
+#include "common/upstream/load_balancer_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+const uint64_t MaglevLoadBalancer::TABLE_SIZE;
+
+MaglevLoadBalancer::MaglevLoadBalancer(HostSet& host_set, ClusterStats& stats,
+                                       Runtime::Loader& runtime, Runtime::RandomGenerator& random)
+    : host_set_(host_set), stats_(stats), runtime_(runtime), random_(random) {
+  host_set_.addMemberUpdateCb([this](const std::vector<HostSharedPtr>&,
+                                     const std::vector<HostSharedPtr>&) -> void { refresh(); });
+
+  refresh();
+}
+
+HostConstSharedPtr MaglevLoadBalancer::chooseHost(LoadBalancerContext* context) {
+  // If there is no hash in the context, just choose a random value (this effectively becomes
+  // the random LB but it won't crash if someone configures it this way).
+  Optional<uint64_t> hash;
+  if (context) {
+    hash = context->computeHashKey();
+  }
+  const uint64_t h = hash.valid() ? hash.value() : random_.random();
+
+  if (LoadBalancerUtility::isGlobalPanic(host_set_, runtime_)) {
+    stats_.lb_healthy_panic_.inc();
+    return all_hosts_table_.chooseHost(h);
+  } else {
+    return healthy_hosts_table_.chooseHost(h);
+  }
+}
+
+HostConstSharedPtr MaglevLoadBalancer::Table::chooseHost(uint64_t hash) const {
+  if (slots_.empty()) {
+    return nullptr;
+  }
+
+  return hosts_[slots_[hash % TABLE_SIZE]];
+}
+
+void MaglevLoadBalancer::Table::create(const std::vector<HostSharedPtr>& hosts) {
+  ENVOY_LOG(trace, "maglev: building table");
+  hosts_.assign(hosts.begin(), hosts.end());
+  slots_.clear();
+  if (hosts.empty()) {
+    return;
+  }
+
+  // The permutation of a host visits the slots offset, offset + skip, offset + 2 * skip, ... modulo
+  // the table size. The hosts take turns to claim the next free slot of their permutation until
+  // the table is full, so the number of slots of any two hosts differs by at most one.
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> skips;
+  offsets.reserve(hosts.size());
+  skips.reserve(hosts.size());
+  for (const auto& host : hosts) {
+    const std::string& address = host->address()->asString();
+    offsets.push_back(HashUtil::xxHash64(address, 0) % TABLE_SIZE);
+    skips.push_back(HashUtil::xxHash64(address, 1) % (TABLE_SIZE - 1) + 1);
+  }
+
+  const uint32_t free_slot = std::numeric_limits<uint32_t>::max();
+  std::vector<uint64_t> next(hosts.size(), 0);
+  slots_.assign(TABLE_SIZE, free_slot);
+  uint64_t claimed = 0;
+  while (true) {
+    for (uint32_t i = 0; i < hosts.size(); i++) {
+      uint64_t slot;
+      do {
+        slot = (offsets[i] + next[i]++ * skips[i]) % TABLE_SIZE;
+      } while (slots_[slot] != free_slot);
+
+      slots_[slot] = i;
+      if (++claimed == TABLE_SIZE) {
+        return;
+      }
+    }
+  }
+}
+
+void MaglevLoadBalancer::refresh() {
+  all_hosts_table_.create(host_set_.hosts());
+  healthy_hosts_table_.create(host_set_.healthyHosts());
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "envoy/runtime/runtime.h"
+#include "envoy/upstream/load_balancer.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A load balancer that implements Maglev consistent hashing
+ * (https://research.google.com/pubs/pub44824.html). Each host claims slots of a fixed size lookup
+ * table in the order of its own permutation of the slots, so choosing a host is a single table
+ * lookup and a host change moves few slots other than those of the host. As with the ring hash load
+ * balancer, a table is kept for all hosts as well as a table for healthy hosts, and unless we are
+ * in panic mode the healthy host table is used. Weighting and zone aware routing are not supported.
+ */
+class MaglevLoadBalancer : public LoadBalancer, Logger::Loggable<Logger::Id::upstream> {
+public:
+  MaglevLoadBalancer(HostSet& host_set, ClusterStats& stats, Runtime::Loader& runtime,
+                     Runtime::RandomGenerator& random);
+
+  // Upstream::LoadBalancer
+  HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+
+  // The number of slots in a table. It must be prime for every permutation to visit every slot.
+  static const uint64_t TABLE_SIZE = 65537;
+
+private:
+  struct Table {
+    HostConstSharedPtr chooseHost(uint64_t hash) const;
+    void create(const std::vector<HostSharedPtr>& hosts);
+
+    std::vector<HostConstSharedPtr> hosts_;
+    // The index into hosts_ of the host of each slot. Storing indices rather than hosts keeps the
+    // table small enough to stay in cache.
+    std::vector<uint32_t> slots_;
+  };
+
+  void refresh();
+
+  HostSet& host_set_;
+  ClusterStats& stats_;
+  Runtime::Loader& runtime_;
+  Runtime::RandomGenerator& random_;
+  Table all_hosts_table_;
+  Table healthy_hosts_table_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
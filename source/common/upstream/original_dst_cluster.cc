@@ -1,6 +1,7 @@
 #include "common/upstream/original_dst_cluster.h"
 
 #include <chrono>
+#include <cstring>
 #include <list>
 #include <string>
 #include <vector>
@@ -21,7 +22,8 @@ namespace Upstream {
 
 OriginalDstCluster::LoadBalancer::LoadBalancer(HostSet& host_set, ClusterSharedPtr& parent)
     : host_set_(host_set), parent_(std::static_pointer_cast<OriginalDstCluster>(parent)),
-      info_(parent->info()) {
+      info_(parent->info()),
+      shared_host_map_(std::static_pointer_cast<OriginalDstCluster>(parent)->shared_host_map_) {
   // host_set_ is initially empty.
   host_set_.addMemberUpdateCb([this](const std::vector<HostSharedPtr>& hosts_added,
                                      const std::vector<HostSharedPtr>& hosts_removed) -> void {
@@ -54,6 +56,14 @@ HostConstSharedPtr OriginalDstCluster::LoadBalancer::chooseHost(LoadBalancerCont
         host->used(true); // Mark as used.
         return std::move(host);
       }
+      // Check if another thread has already created a host for the destination address.
+      host = shared_host_map_->find(dst_addr);
+      if (host) {
+        ENVOY_LOG(debug, "Using shared host {}.", host->address()->asString());
+        host->used(true); // Mark as used.
+        host_map_.insert(host, false);
+        return std::move(host);
+      }
       // Add a new host
       const Network::Address::Ip* dst_ip = dst_addr.ip();
       if (dst_ip) {
@@ -64,6 +74,16 @@ HostConstSharedPtr OriginalDstCluster::LoadBalancer::chooseHost(LoadBalancerCont
                                 envoy::api::v2::Metadata::default_instance(), 1,
                                 envoy::api::v2::Locality().default_instance()));
 
+        // Another thread may have created a host for the address since the lookup above. If so,
+        // use that one, which that thread has already handed to the main thread.
+        HostSharedPtr shared_host = shared_host_map_->insert(host);
+        if (shared_host != host) {
+          ENVOY_LOG(debug, "Using shared host {}.", shared_host->address()->asString());
+          shared_host->used(true); // Mark as used.
+          host_map_.insert(shared_host, false);
+          return std::move(shared_host);
+        }
+
         ENVOY_LOG(debug, "Created host {}.", host->address()->asString());
         // Add the new host to the map.  We just failed to find it in
         // our local map above, so insert without checking (2nd arg == false).
@@ -99,11 +119,72 @@ OriginalDstCluster::OriginalDstCluster(const envoy::api::v2::Cluster& config,
                       added_via_api),
       dispatcher_(dispatcher), cleanup_interval_ms_(std::chrono::milliseconds(
                                    PROTOBUF_GET_MS_OR_DEFAULT(config, cleanup_interval, 5000))),
-      cleanup_timer_(dispatcher.createTimer([this]() -> void { cleanup(); })) {
+      cleanup_timer_(dispatcher.createTimer([this]() -> void { cleanup(); })),
+      shared_host_map_(std::make_shared<SharedHostMap>()) {
 
   cleanup_timer_->enableTimer(cleanup_interval_ms_);
 }
 
+const uint32_t OriginalDstCluster::SharedHostMap::NumShards;
+
+HostSharedPtr OriginalDstCluster::SharedHostMap::find(const Network::Address::Instance& address) {
+  Key key;
+  if (!makeKey(address, key)) {
+    return nullptr;
+  }
+
+  Shard& key_shard = shard(key);
+  std::lock_guard<std::mutex> lock(key_shard.lock_);
+  auto it = key_shard.hosts_.find(key);
+  return it != key_shard.hosts_.end() ? it->second : nullptr;
+}
+
+HostSharedPtr OriginalDstCluster::SharedHostMap::insert(const HostSharedPtr& host) {
+  Key key;
+  if (!makeKey(*host->address(), key)) {
+    return host;
+  }
+
+  Shard& key_shard = shard(key);
+  std::lock_guard<std::mutex> lock(key_shard.lock_);
+  return key_shard.hosts_.emplace(key, host).first->second;
+}
+
+void OriginalDstCluster::SharedHostMap::remove(const HostSharedPtr& host) {
+  Key key;
+  if (!makeKey(*host->address(), key)) {
+    return;
+  }
+
+  Shard& key_shard = shard(key);
+  std::lock_guard<std::mutex> lock(key_shard.lock_);
+  auto it = key_shard.hosts_.find(key);
+  if (it != key_shard.hosts_.end() && it->second == host) {
+    key_shard.hosts_.erase(it);
+  }
+}
+
+bool OriginalDstCluster::SharedHostMap::makeKey(const Network::Address::Instance& address,
+                                               Key& key) {
+  const Network::Address::Ip* ip = address.ip();
+  if (ip == nullptr) {
+    return false;
+  }
+
+  key.fill(0);
+  if (ip->version() == Network::Address::IpVersion::v4) {
+    const uint32_t ipv4 = ip->ipv4()->address();
+    memcpy(&key[1], &ipv4, sizeof(ipv4));
+  } else {
+    key[0] = 1;
+    const auto ipv6 = ip->ipv6()->address();
+    memcpy(&key[1], ipv6.data(), ipv6.size());
+  }
+  const uint16_t port = ip->port();
+  memcpy(&key[17], &port, sizeof(port));
+  return true;
+}
+
 void OriginalDstCluster::addHost(HostSharedPtr& host) {
   HostVectorSharedPtr new_hosts(new std::vector<HostSharedPtr>(hosts()));
   new_hosts->emplace_back(host);
@@ -124,6 +205,7 @@ void OriginalDstCluster::cleanup() {
       host->used(false); // Mark to be removed during the next round.
     } else {
       ENVOY_LOG(debug, "Removing stale host {}.", host->address()->asString());
+      shared_host_map_->remove(host);
       to_be_removed.emplace_back(host);
     }
   }
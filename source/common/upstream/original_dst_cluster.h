@@ -1,13 +1,17 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/empty_string.h"
+#include "common/common/hash.h"
 #include "common/common/logger.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -29,6 +33,56 @@ public:
   // Upstream::Cluster
   InitializePhase initializePhase() const override { return InitializePhase::Primary; }
 
+  /**
+   * Map from a binary host IP address/port to the host created for it, shared by the load
+   * balancers of all workers. A worker which sees a destination for the first time can then pick
+   * up the host another worker has already created, rather than creating its own. The map is split
+   * into shards with their own lock, so that workers adding different hosts rarely contend. Hosts
+   * are removed by the main thread's cleanup sweep.
+   */
+  class SharedHostMap {
+  public:
+    static const uint32_t NumShards = 16;
+
+    /**
+     * @return the host for an address, or nullptr if there is none.
+     */
+    HostSharedPtr find(const Network::Address::Instance& address);
+
+    /**
+     * Adds a host unless the map already has a host for its address.
+     * @return the host in the map for the address, which is the given host if it was added.
+     */
+    HostSharedPtr insert(const HostSharedPtr& host);
+
+    /**
+     * Removes a host, if it is the host in the map for its address.
+     */
+    void remove(const HostSharedPtr& host);
+
+  private:
+    // Address family, IP address (IPv4 in the first 4 bytes) and port.
+    typedef std::array<uint8_t, 19> Key;
+
+    struct KeyHash {
+      size_t operator()(const Key& key) const {
+        return HashUtil::xxHash64(reinterpret_cast<const char*>(key.data()), key.size());
+      }
+    };
+
+    struct Shard {
+      std::mutex lock_;
+      std::unordered_map<Key, HostSharedPtr, KeyHash> hosts_;
+    };
+
+    static bool makeKey(const Network::Address::Instance& address, Key& key);
+    Shard& shard(const Key& key) { return shards_[KeyHash()(key) % NumShards]; }
+
+    std::array<Shard, NumShards> shards_;
+  };
+
+  typedef std::shared_ptr<SharedHostMap> SharedHostMapSharedPtr;
+
   /**
    * Special Load Balancer for Original Dst Cluster.
    *
@@ -36,9 +90,9 @@ public:
    * Original Dst cluster has a Host for the original destination.  Normally load balancers can't
    * modify clusters, but in this case we access a singleton OriginalDstCluster that we can ask to
    * add hosts on demand.  Additions are synced with all other threads so that the host set in the
-   * cluster remains (eventually) consistent.  If multiple threads add a host to the same upstream
-   * address then two distinct HostSharedPtr's (with the same upstream IP address) will be added,
-   * and both of them will eventually time out.
+   * cluster remains (eventually) consistent.  A host created by one thread is found by the others
+   * through the SharedHostMap before their host sets are updated, so that each upstream address
+   * normally has a single host.
    */
   class LoadBalancer : public Upstream::LoadBalancer {
   public:
@@ -95,6 +149,7 @@ public:
     std::weak_ptr<OriginalDstCluster> parent_; // Primary cluster managed by the main thread.
     ClusterInfoConstSharedPtr info_;
     HostMap host_map_;
+    SharedHostMapSharedPtr shared_host_map_; // Hosts created by the load balancers of all workers.
   };
 
 private:
@@ -107,6 +162,7 @@ private:
   Event::Dispatcher& dispatcher_;
   const std::chrono::milliseconds cleanup_interval_ms_;
   Event::TimerPtr cleanup_timer_;
+  const SharedHostMapSharedPtr shared_host_map_;
 };
 
 } // namespace Upstream
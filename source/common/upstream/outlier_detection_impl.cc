@@ -1,6 +1,8 @@
 #include "common/upstream/outlier_detection_impl.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -19,6 +21,8 @@ namespace Envoy {
 namespace Upstream {
 namespace Outlier {
 
+const size_t LatencyAccumulatorBucket::NumBuckets;
+
 DetectorSharedPtr DetectorImplFactory::createForCluster(
     Cluster& cluster, const envoy::api::v2::Cluster& cluster_config, Event::Dispatcher& dispatcher,
     Runtime::Loader& runtime, EventLoggerSharedPtr event_logger) {
@@ -45,6 +49,10 @@ void DetectorHostMonitorImpl::updateCurrentSuccessRateBucket() {
   success_rate_accumulator_bucket_.store(success_rate_accumulator_.updateCurrentWriter());
 }
 
+void DetectorHostMonitorImpl::updateCurrentLatencyBucket() {
+  latency_accumulator_bucket_.store(latency_accumulator_.updateCurrentWriter());
+}
+
 void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
   success_rate_accumulator_bucket_.load()->total_request_counter_++;
   if (Http::CodeUtility::is5xx(response_code)) {
@@ -65,6 +73,28 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
   }
 }
 
+void DetectorHostMonitorImpl::putResponseTime(std::chrono::milliseconds time) {
+  // Weight of a response time below the average, which decays the average over about 10 responses.
+  static const double EWMA_WEIGHT = 0.1;
+
+  const double response_time = time.count();
+  const double average = peak_ewma_response_time_.load(std::memory_order_relaxed);
+  peak_ewma_response_time_.store(response_time > average
+                                     ? response_time
+                                     : average + EWMA_WEIGHT * (response_time - average),
+                                 std::memory_order_relaxed);
+  response_time_added_.store(true, std::memory_order_relaxed);
+  latency_accumulator_bucket_.load()
+      ->counts_[LatencyAccumulator::bucketIndex(time.count())]
+      .fetch_add(1, std::memory_order_relaxed);
+}
+
+void DetectorHostMonitorImpl::expireResponseTime() {
+  if (!response_time_added_.exchange(false)) {
+    peak_ewma_response_time_ = -1;
+  }
+}
+
 DetectorConfig::DetectorConfig(const envoy::api::v2::Cluster::OutlierDetection& config)
     : interval_ms_(static_cast<uint64_t>(PROTOBUF_GET_MS_OR_DEFAULT(config, interval, 10000))),
       base_ejection_time_ms_(
@@ -91,8 +121,8 @@ DetectorImpl::DetectorImpl(const Cluster& cluster,
     : config_(config), dispatcher_(dispatcher), runtime_(runtime), time_source_(time_source),
       stats_(generateStats(cluster.info()->statsScope())),
       interval_timer_(dispatcher.createTimer([this]() -> void { onIntervalTimer(); })),
-      event_logger_(event_logger), success_rate_average_(-1), success_rate_ejection_threshold_(-1) {
-}
+      event_logger_(event_logger), success_rate_average_(-1), success_rate_ejection_threshold_(-1),
+      p99_response_time_average_(-1), p99_response_time_ejection_threshold_(-1) {}
 
 DetectorImpl::~DetectorImpl() {
   for (auto host : host_monitors_) {
@@ -151,8 +181,8 @@ void DetectorImpl::armIntervalTimer() {
       runtime_.snapshot().getInteger("outlier_detection.interval_ms", config_.intervalMs())));
 }
 
-void DetectorImpl::checkHostForUneject(HostSharedPtr host, DetectorHostMonitorImpl* monitor,
-                                       MonotonicTime now) {
+void DetectorImpl::checkHostForUneject(const HostSharedPtr& host,
+                                       DetectorHostMonitorImpl* monitor, MonotonicTime now) {
   if (!host->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
     return;
   }
@@ -181,6 +211,8 @@ bool DetectorImpl::enforceEjection(EjectionType type) {
   case EjectionType::SuccessRate:
     return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_success_rate",
                                               config_.enforcingSuccessRate());
+  case EjectionType::Latency:
+    return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_latency", 100);
   }
 
   NOT_REACHED;
@@ -214,7 +246,8 @@ void DetectorImpl::ejectHost(HostSharedPtr host, EjectionType type) {
 DetectionStats DetectorImpl::generateStats(Stats::Scope& scope) {
   std::string prefix("outlier_detection.");
   return {ALL_OUTLIER_DETECTION_STATS(POOL_COUNTER_PREFIX(scope, prefix),
-                                      POOL_GAUGE_PREFIX(scope, prefix))};
+                                      POOL_GAUGE_PREFIX(scope, prefix),
+                                      POOL_HISTOGRAM_PREFIX(scope, prefix))};
 }
 
 void DetectorImpl::onConsecutive5xx(HostSharedPtr host) {
@@ -278,51 +311,23 @@ Utility::EjectionPair Utility::successRateEjectionThreshold(
   // threshold returned = 52
   double mean = success_rate_sum / valid_success_rate_hosts.size();
   double variance = 0;
-  std::for_each(valid_success_rate_hosts.begin(), valid_success_rate_hosts.end(),
-                [&variance, mean](HostSuccessRatePair v) {
-                  variance += std::pow(v.success_rate_ - mean, 2);
-                });
+  for (const HostSuccessRatePair& host_success_rate_pair : valid_success_rate_hosts) {
+    const double difference = host_success_rate_pair.success_rate_ - mean;
+    variance += difference * difference;
+  }
   variance /= valid_success_rate_hosts.size();
   double stdev = std::sqrt(variance);
 
   return {mean, (mean - (success_rate_stdev_factor * stdev))};
 }
 
-void DetectorImpl::processSuccessRateEjections() {
-  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
-      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
-  uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
-      "outlier_detection.success_rate_request_volume", config_.successRateRequestVolume());
-  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
-  double success_rate_sum = 0;
-
+void DetectorImpl::processSuccessRateEjections(
+    const std::vector<HostSuccessRatePair>& valid_success_rate_hosts, double success_rate_sum,
+    uint64_t success_rate_minimum_hosts) {
   // Reset the Detector's success rate mean and stdev.
   success_rate_average_ = -1;
   success_rate_ejection_threshold_ = -1;
 
-  // Exit early if there are not enough hosts.
-  if (host_monitors_.size() < success_rate_minimum_hosts) {
-    return;
-  }
-
-  // reserve upper bound of vector size to avoid reallocation.
-  valid_success_rate_hosts.reserve(host_monitors_.size());
-
-  for (const auto& host : host_monitors_) {
-    // Don't do work if the host is already ejected.
-    if (!host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
-      Optional<double> host_success_rate =
-          host.second->successRateAccumulator().getSuccessRate(success_rate_request_volume);
-
-      if (host_success_rate.valid()) {
-        valid_success_rate_hosts.emplace_back(
-            HostSuccessRatePair(host.first, host_success_rate.value()));
-        success_rate_sum += host_success_rate.value();
-        host.second->successRate(host_success_rate.value());
-      }
-    }
-  }
-
   if (valid_success_rate_hosts.size() >= success_rate_minimum_hosts) {
     double success_rate_stdev_factor =
         runtime_.snapshot().getInteger("outlier_detection.success_rate_stdev_factor",
@@ -341,21 +346,126 @@ void DetectorImpl::processSuccessRateEjections() {
   }
 }
 
+Utility::LatencyEjectionPair
+Utility::latencyEjectionThreshold(double p99_response_time_sum,
+                                  const std::vector<HostLatencyPair>& valid_latency_hosts,
+                                  double latency_stdev_factor) {
+  // As for success rate, but hosts are outliers above the mean rather than below it.
+  const double mean = p99_response_time_sum / valid_latency_hosts.size();
+  double variance = 0;
+  for (const HostLatencyPair& host_latency_pair : valid_latency_hosts) {
+    const double difference = host_latency_pair.p99_response_time_ - mean;
+    variance += difference * difference;
+  }
+  variance /= valid_latency_hosts.size();
+  const double stdev = std::sqrt(variance);
+
+  return {mean, std::max(mean + latency_stdev_factor * stdev, mean * 1.5)};
+}
+
+void DetectorImpl::processLatencyEjections(const std::vector<HostLatencyPair>& valid_latency_hosts,
+                                           double p99_response_time_sum,
+                                           uint64_t latency_minimum_hosts,
+                                           double latency_stdev_factor) {
+  p99_response_time_average_ = -1;
+  p99_response_time_ejection_threshold_ = -1;
+
+  if (latency_stdev_factor > 0 && valid_latency_hosts.size() >= latency_minimum_hosts) {
+    Utility::LatencyEjectionPair ejection_pair = Utility::latencyEjectionThreshold(
+        p99_response_time_sum, valid_latency_hosts, latency_stdev_factor);
+    p99_response_time_average_ = ejection_pair.p99_response_time_average_;
+    p99_response_time_ejection_threshold_ = ejection_pair.ejection_threshold_;
+    for (const auto& host_latency_pair : valid_latency_hosts) {
+      if (host_latency_pair.p99_response_time_ > p99_response_time_ejection_threshold_) {
+        stats_.ejections_latency_.inc();
+        ejectHost(host_latency_pair.host_, EjectionType::Latency);
+      }
+    }
+  }
+}
+
 void DetectorImpl::onIntervalTimer() {
+  // The time taken is measured with the real clock, the time source only drives ejections.
+  const MonotonicTime start_time = ProdMonotonicTimeSource::instance_.currentTime();
   MonotonicTime now = time_source_.currentTime();
 
-  for (auto host : host_monitors_) {
+  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
+  uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_request_volume", config_.successRateRequestVolume());
+  // Success rates are only worth collecting if there are enough hosts.
+  const bool collect_success_rates = host_monitors_.size() >= success_rate_minimum_hosts;
+  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
+  double success_rate_sum = 0;
+  if (collect_success_rates) {
+    // reserve upper bound of vector size to avoid reallocation.
+    valid_success_rate_hosts.reserve(host_monitors_.size());
+  }
+
+  // Latency ejection is opted into by setting its standard deviation factor, as the response times
+  // of some clusters legitimately differ across hosts (e.g. hosts of different sizes).
+  const double latency_stdev_factor =
+      runtime_.snapshot().getInteger("outlier_detection.latency_stdev_factor", 0) / 1000.0;
+  const uint64_t latency_minimum_hosts =
+      runtime_.snapshot().getInteger("outlier_detection.latency_minimum_hosts", 5);
+  const uint64_t latency_request_volume =
+      runtime_.snapshot().getInteger("outlier_detection.latency_request_volume", 100);
+  const bool collect_latencies =
+      latency_stdev_factor > 0 && host_monitors_.size() >= latency_minimum_hosts;
+  std::vector<HostLatencyPair> valid_latency_hosts;
+  double p99_response_time_sum = 0;
+  if (collect_latencies) {
+    valid_latency_hosts.reserve(host_monitors_.size());
+  }
+
+  // A single pass over the hosts both rotates the success rate buckets and collects the success
+  // rates of the interval which just ended, as large clusters make each pass costly.
+  for (const auto& host : host_monitors_) {
     checkHostForUneject(host.first, host.second, now);
 
     // Need to update the writer bucket to keep the data valid.
     host.second->updateCurrentSuccessRateBucket();
     // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
-    // will get updated in processSuccessRateEjections().
+    // is set below.
     host.second->successRate(-1);
+    host.second->expireResponseTime();
+    host.second->updateCurrentLatencyBucket();
+    host.second->p99ResponseTime(-1);
+
+    // Don't do work if the host is already ejected.
+    if (collect_success_rates &&
+        !host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      Optional<double> host_success_rate =
+          host.second->successRateAccumulator().getSuccessRate(success_rate_request_volume);
+
+      if (host_success_rate.valid()) {
+        valid_success_rate_hosts.emplace_back(host.first, host_success_rate.value());
+        success_rate_sum += host_success_rate.value();
+        host.second->successRate(host_success_rate.value());
+      }
+    }
+
+    if (collect_latencies && !host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      Optional<double> host_p99_response_time =
+          host.second->latencyAccumulator().getP99ResponseTime(latency_request_volume);
+
+      if (host_p99_response_time.valid()) {
+        valid_latency_hosts.emplace_back(host.first, host_p99_response_time.value());
+        p99_response_time_sum += host_p99_response_time.value();
+        host.second->p99ResponseTime(host_p99_response_time.value());
+      }
+    }
   }
 
-  processSuccessRateEjections();
+  processSuccessRateEjections(valid_success_rate_hosts, success_rate_sum,
+                              success_rate_minimum_hosts);
+  processLatencyEjections(valid_latency_hosts, p99_response_time_sum, latency_minimum_hosts,
+                          latency_stdev_factor);
 
+  stats_.detection_time_us_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                                            ProdMonotonicTimeSource::instance_.currentTime() -
+                                            start_time)
+                                            .count());
   armIntervalTimer();
 }
 
@@ -395,6 +505,21 @@ void EventLoggerImpl::logEject(HostDescriptionConstSharedPtr host, Detector& det
     "\"cluster_average_success_rate\": \"{}\", " +
     "\"cluster_success_rate_ejection_threshold\": \"{}\"" +
     "}}\n";
+
+  static const std::string json_latency =
+    std::string("{{") +
+    "\"time\": \"{}\", " +
+    "\"secs_since_last_action\": \"{}\", " +
+    "\"cluster\": \"{}\", " +
+    "\"upstream_url\": \"{}\", " +
+    "\"action\": \"eject\", " +
+    "\"type\": \"{}\", " +
+    "\"num_ejections\": \"{}\", " +
+    "\"enforced\": \"{}\", " +
+    "\"host_p99_response_time_ms\": \"{}\", " +
+    "\"cluster_average_p99_response_time_ms\": \"{}\", " +
+    "\"cluster_p99_response_time_ejection_threshold_ms\": \"{}\"" +
+    "}}\n";
   // clang-format on
   SystemTime now = time_source_.currentTime();
   MonotonicTime monotonic_now = monotonic_time_source_.currentTime();
@@ -415,6 +540,15 @@ void EventLoggerImpl::logEject(HostDescriptionConstSharedPtr host, Detector& det
         host->outlierDetector().numEjections(), enforced, host->outlierDetector().successRate(),
         detector.successRateAverage(), detector.successRateEjectionThreshold()));
     break;
+  case EjectionType::Latency:
+    file_->write(fmt::format(
+        json_latency, AccessLogDateTimeFormatter::fromTime(now),
+        secsSinceLastAction(host->outlierDetector().lastUnejectionTime(), monotonic_now),
+        host->cluster().name(), host->address()->asString(), typeToString(type),
+        host->outlierDetector().numEjections(), enforced,
+        host->outlierDetector().p99ResponseTime(), detector.p99ResponseTimeAverage(),
+        detector.p99ResponseTimeEjectionThreshold()));
+    break;
   }
 }
 
@@ -445,6 +579,8 @@ std::string EventLoggerImpl::typeToString(EjectionType type) {
     return "5xx";
   case EjectionType::SuccessRate:
     return "SuccessRate";
+  case EjectionType::Latency:
+    return "Latency";
   }
 
   NOT_REACHED;
@@ -477,6 +613,59 @@ Optional<double> SuccessRateAccumulator::getSuccessRate(uint64_t success_rate_re
                           backup_success_rate_bucket_->total_request_counter_);
 }
 
+LatencyAccumulatorBucket* LatencyAccumulator::updateCurrentWriter() {
+  // As with success rates, current is being written to and backup is not.
+  for (std::atomic<uint32_t>& count : backup_latency_bucket_->counts_) {
+    count = 0;
+  }
+
+  current_latency_bucket_.swap(backup_latency_bucket_);
+
+  return current_latency_bucket_.get();
+}
+
+Optional<double> LatencyAccumulator::getP99ResponseTime(uint64_t latency_request_volume) {
+  uint64_t total = 0;
+  for (const std::atomic<uint32_t>& count : backup_latency_bucket_->counts_) {
+    total += count;
+  }
+  if (total == 0 || total < latency_request_volume) {
+    return Optional<double>();
+  }
+
+  // The rank of the 99th percentile, rounded up.
+  const uint64_t rank = (total * 99 + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LatencyAccumulatorBucket::NumBuckets; i++) {
+    seen += backup_latency_bucket_->counts_[i];
+    if (seen >= rank) {
+      return Optional<double>(bucketUpperBound(i));
+    }
+  }
+
+  NOT_REACHED;
+}
+
+size_t LatencyAccumulator::bucketIndex(uint64_t time_ms) {
+  if (time_ms < 4) {
+    return time_ms;
+  }
+
+  // The 2 bits below the highest set bit pick one of the 4 buckets of each power of two.
+  const uint32_t exponent = 63 - __builtin_clzll(time_ms);
+  const size_t index = 4 * (exponent - 1) + ((time_ms >> (exponent - 2)) & 3);
+  return std::min(index, LatencyAccumulatorBucket::NumBuckets - 1);
+}
+
+uint64_t LatencyAccumulator::bucketUpperBound(size_t index) {
+  if (index < 4) {
+    return index;
+  }
+
+  const uint32_t shift = index / 4 - 1;
+  return ((4 + index % 4 + 1) << shift) - 1;
+}
+
 } // namespace Outlier
 } // namespace Upstream
 } // namespace Envoy
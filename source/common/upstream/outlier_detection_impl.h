@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -33,6 +34,8 @@ public:
   const Optional<MonotonicTime>& lastEjectionTime() override { return time_; }
   const Optional<MonotonicTime>& lastUnejectionTime() override { return time_; }
   double successRate() const override { return -1; }
+  double peakEwmaResponseTime() const override { return -1; }
+  double p99ResponseTime() const override { return -1; }
 
 private:
   const Optional<MonotonicTime> time_;
@@ -96,6 +99,69 @@ private:
   std::unique_ptr<SuccessRateAccumulatorBucket> backup_success_rate_bucket_;
 };
 
+/**
+ * Thin struct to facilitate calculations for latency outlier detection.
+ */
+struct HostLatencyPair {
+  HostLatencyPair(HostSharedPtr host, double p99_response_time)
+      : host_(host), p99_response_time_(p99_response_time) {}
+  HostSharedPtr host_;
+  double p99_response_time_;
+};
+
+/**
+ * Counts of response times in milliseconds. Below 4ms each bucket holds one value, above the
+ * bounds of the buckets grow by a quarter of a power of two, so that a percentile read from them
+ * is off by less than 25%. Response times above about 2 minutes share the last bucket.
+ */
+struct LatencyAccumulatorBucket {
+  static const size_t NumBuckets = 64;
+
+  std::array<std::atomic<uint32_t>, NumBuckets> counts_;
+};
+
+/**
+ * The LatencyAccumulator uses the LatencyAccumulatorBucket to get per host response time
+ * percentiles, with the same fixed windows as the SuccessRateAccumulator.
+ */
+class LatencyAccumulator {
+public:
+  LatencyAccumulator()
+      : current_latency_bucket_(new LatencyAccumulatorBucket()),
+        backup_latency_bucket_(new LatencyAccumulatorBucket()) {}
+
+  /**
+   * This function updates the bucket to write data to.
+   * @return a pointer to the LatencyAccumulatorBucket.
+   */
+  LatencyAccumulatorBucket* updateCurrentWriter();
+  /**
+   * This function returns the 99th percentile of the response times of a host over a window of
+   * time if the request volume is high enough. It is rounded up to the upper bound of its bucket.
+   * @param latency_request_volume the threshold of requests an accumulator has to have in order to
+   *                               be able to return a significant percentile.
+   * @return a valid Optional<double> with the percentile in milliseconds. If there were not enough
+   *         requests, an invalid Optional<double> is returned.
+   */
+  Optional<double> getP99ResponseTime(uint64_t latency_request_volume);
+
+  /**
+   * @return size_t the index of the bucket which counts a response time.
+   * @param time_ms supplies the response time in milliseconds.
+   */
+  static size_t bucketIndex(uint64_t time_ms);
+
+  /**
+   * @return uint64_t the largest response time in milliseconds counted by a bucket.
+   * @param index supplies the index of the bucket.
+   */
+  static uint64_t bucketUpperBound(size_t index);
+
+private:
+  std::unique_ptr<LatencyAccumulatorBucket> current_latency_bucket_;
+  std::unique_ptr<LatencyAccumulatorBucket> backup_latency_bucket_;
+};
+
 class DetectorImpl;
 
 /**
@@ -105,8 +171,10 @@ class DetectorHostMonitorImpl : public DetectorHostMonitor {
 public:
   DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector, HostSharedPtr host)
       : detector_(detector), host_(host), success_rate_(-1) {
-    // Point the success_rate_accumulator_bucket_ pointer to a bucket.
+    // Point the success_rate_accumulator_bucket_ and latency_accumulator_bucket_ pointers to a
+    // bucket.
     updateCurrentSuccessRateBucket();
+    updateCurrentLatencyBucket();
   }
 
   void eject(MonotonicTime ejection_time);
@@ -114,15 +182,25 @@ public:
   void updateCurrentSuccessRateBucket();
   SuccessRateAccumulator& successRateAccumulator() { return success_rate_accumulator_; }
   void successRate(double new_success_rate) { success_rate_ = new_success_rate; }
+  void updateCurrentLatencyBucket();
+  LatencyAccumulator& latencyAccumulator() { return latency_accumulator_; }
+  void p99ResponseTime(double new_p99_response_time) { p99_response_time_ = new_p99_response_time; }
   void resetConsecutive5xx() { consecutive_5xx_ = 0; }
+  /**
+   * Forget the response time average if no response time was added since the last call, so that a
+   * host which the load balancer stopped choosing because of a peak gets requests again.
+   */
+  void expireResponseTime();
 
   // Upstream::Outlier::DetectorHostMonitor
   uint32_t numEjections() override { return num_ejections_; }
   void putHttpResponseCode(uint64_t response_code) override;
-  void putResponseTime(std::chrono::milliseconds) override {}
+  void putResponseTime(std::chrono::milliseconds time) override;
   const Optional<MonotonicTime>& lastEjectionTime() override { return last_ejection_time_; }
   const Optional<MonotonicTime>& lastUnejectionTime() override { return last_unejection_time_; }
   double successRate() const override { return success_rate_; }
+  double peakEwmaResponseTime() const override { return peak_ewma_response_time_; }
+  double p99ResponseTime() const override { return p99_response_time_; }
 
 private:
   std::weak_ptr<DetectorImpl> detector_;
@@ -134,25 +212,34 @@ private:
   SuccessRateAccumulator success_rate_accumulator_;
   std::atomic<SuccessRateAccumulatorBucket*> success_rate_accumulator_bucket_;
   double success_rate_;
+  // Written by all workers without synchronization, so an update racing with another may be lost.
+  std::atomic<double> peak_ewma_response_time_{-1};
+  std::atomic<bool> response_time_added_{false};
+  LatencyAccumulator latency_accumulator_;
+  std::atomic<LatencyAccumulatorBucket*> latency_accumulator_bucket_;
+  double p99_response_time_{-1};
 };
 
 /**
  * All outlier detection stats. @see stats_macros.h
  */
 // clang-format off
-#define ALL_OUTLIER_DETECTION_STATS(COUNTER, GAUGE)                                                \
-  COUNTER(ejections_total)                                                                         \
-  GAUGE  (ejections_active)                                                                        \
-  COUNTER(ejections_overflow)                                                                      \
-  COUNTER(ejections_consecutive_5xx)                                                               \
-  COUNTER(ejections_success_rate)
+#define ALL_OUTLIER_DETECTION_STATS(COUNTER, GAUGE, HISTOGRAM)                                     \
+  COUNTER  (ejections_total)                                                                       \
+  GAUGE    (ejections_active)                                                                      \
+  COUNTER  (ejections_overflow)                                                                    \
+  COUNTER  (ejections_consecutive_5xx)                                                             \
+  COUNTER  (ejections_success_rate)                                                                \
+  COUNTER  (ejections_latency)                                                                     \
+  HISTOGRAM(detection_time_us)
 // clang-format on
 
 /**
  * Struct definition for all outlier detection stats. @see stats_macros.h
  */
 struct DetectionStats {
-  ALL_OUTLIER_DETECTION_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+  ALL_OUTLIER_DETECTION_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT,
+                              GENERATE_HISTOGRAM_STRUCT)
 };
 
 /**
@@ -205,6 +292,10 @@ public:
   void addChangedStateCb(ChangeStateCb cb) override { callbacks_.push_back(cb); }
   double successRateAverage() const override { return success_rate_average_; }
   double successRateEjectionThreshold() const override { return success_rate_ejection_threshold_; }
+  double p99ResponseTimeAverage() const override { return p99_response_time_average_; }
+  double p99ResponseTimeEjectionThreshold() const override {
+    return p99_response_time_ejection_threshold_;
+  }
 
 private:
   DetectorImpl(const Cluster& cluster, const envoy::api::v2::Cluster::OutlierDetection& config,
@@ -213,7 +304,8 @@ private:
 
   void addHostMonitor(HostSharedPtr host);
   void armIntervalTimer();
-  void checkHostForUneject(HostSharedPtr host, DetectorHostMonitorImpl* monitor, MonotonicTime now);
+  void checkHostForUneject(const HostSharedPtr& host, DetectorHostMonitorImpl* monitor,
+                           MonotonicTime now);
   void ejectHost(HostSharedPtr host, EjectionType type);
   static DetectionStats generateStats(Stats::Scope& scope);
   void initialize(const Cluster& cluster);
@@ -221,7 +313,11 @@ private:
   void onIntervalTimer();
   void runCallbacks(HostSharedPtr host);
   bool enforceEjection(EjectionType type);
-  void processSuccessRateEjections();
+  void processSuccessRateEjections(const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
+                                   double success_rate_sum, uint64_t success_rate_minimum_hosts);
+  void processLatencyEjections(const std::vector<HostLatencyPair>& valid_latency_hosts,
+                               double p99_response_time_sum, uint64_t latency_minimum_hosts,
+                               double latency_stdev_factor);
 
   DetectorConfig config_;
   Event::Dispatcher& dispatcher_;
@@ -234,6 +330,8 @@ private:
   EventLoggerSharedPtr event_logger_;
   double success_rate_average_;
   double success_rate_ejection_threshold_;
+  double p99_response_time_average_;
+  double p99_response_time_ejection_threshold_;
 };
 
 class EventLoggerImpl : public EventLogger {
@@ -280,6 +378,26 @@ public:
   successRateEjectionThreshold(double success_rate_sum,
                                const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
                                double success_rate_stdev_factor);
+
+  struct LatencyEjectionPair {
+    double p99_response_time_average_;
+    double ejection_threshold_;
+  };
+
+  /**
+   * This function returns a LatencyEjectionPair for latency outlier detection. The pair contains
+   * the average 99th percentile response time of all valid hosts in the cluster and the ejection
+   * threshold. If a host's 99th percentile response time is above this threshold, the host is an
+   * outlier. The threshold is at least 50% above the average, so that hosts whose response times
+   * barely differ are not ejected when the response times of the others are close together.
+   * @param p99_response_time_sum is the sum of the data in the valid_latency_hosts vector.
+   * @param valid_latency_hosts is the vector containing the individual latency data points.
+   * @return LatencyEjectionPair.
+   */
+  static LatencyEjectionPair
+  latencyEjectionThreshold(double p99_response_time_sum,
+                           const std::vector<HostLatencyPair>& valid_latency_hosts,
+                           double latency_stdev_factor);
 };
 
 } // namespace Outlier
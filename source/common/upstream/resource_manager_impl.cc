@@ -0,0 +1,79 @@
+#include "common/upstream/resource_manager_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+namespace Envoy {
+namespace Upstream {
+
+namespace {
+// How much the latency of a window may exceed the long term latency before the limit shrinks.
+const double Tolerance = 1.5;
+// How much of the new limit is taken in at each window.
+const double Smoothing = 0.2;
+// The number of windows which the long term latency averages over.
+const double LongWindows = 20;
+} // namespace
+
+AdaptiveConcurrencyLimit::AdaptiveConcurrencyLimit(uint64_t initial_limit,
+                                                   Stats::Gauge* limit_gauge)
+    : limit_(initial_limit), limit_gauge_(limit_gauge), estimated_limit_(initial_limit) {
+  if (limit_gauge_) {
+    limit_gauge_->set(initial_limit);
+  }
+}
+
+bool AdaptiveConcurrencyLimit::addSample(std::chrono::microseconds latency) {
+  latency_sum_ += latency.count();
+  return ++samples_ % SampleWindow == 0;
+}
+
+void AdaptiveConcurrencyLimit::update(uint64_t in_flight, uint64_t min_limit,
+                                      uint64_t max_limit) {
+  // Samples added by other workers while the window closes may land in either window.
+  double window_latency = static_cast<double>(latency_sum_.exchange(0)) / SampleWindow;
+  std::lock_guard<std::mutex> guard(lock_);
+  window_latency = std::max(window_latency, 1.0);
+  if (long_latency_ == 0) {
+    long_latency_ = window_latency;
+  } else {
+    long_latency_ += (window_latency - long_latency_) / LongWindows;
+    // Once the latency falls back after a long overload, let the long term latency catch up
+    // quickly rather than hold the limit up.
+    if (long_latency_ > 2 * window_latency) {
+      long_latency_ *= 0.95;
+    }
+  }
+
+  // Unless the requests use a good part of the limit, the latency says nothing about whether the
+  // upstream could take more of them.
+  if (in_flight >= estimated_limit_ / 2) {
+    const double gradient =
+        std::max(0.5, std::min(1.0, Tolerance * long_latency_ / window_latency));
+    const double new_limit = estimated_limit_ * gradient + std::sqrt(estimated_limit_);
+    estimated_limit_ = estimated_limit_ * (1 - Smoothing) + new_limit * Smoothing;
+  }
+
+  min_limit = std::min(min_limit, max_limit);
+  estimated_limit_ = std::max<double>(min_limit, std::min<double>(max_limit, estimated_limit_));
+  limit_ = static_cast<uint64_t>(estimated_limit_);
+  if (limit_gauge_) {
+    limit_gauge_->set(limit_);
+  }
+}
+
+void ResourceManagerImpl::RequestsResourceImpl::onRequestLatency(
+    std::chrono::microseconds latency) {
+  if (!adaptive() || !adaptive_.addSample(latency)) {
+    return;
+  }
+
+  adaptive_.update(current_, runtime_.snapshot().getInteger(adaptive_min_key_, 10),
+                   ResourceImpl::max());
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats.h"
 #include "envoy/upstream/resource_manager.h"
 
 #include "common/common/assert.h"
@@ -13,6 +17,52 @@
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * A limit on the concurrent requests to a cluster which follows their latency, after the gradient
+ * algorithm of Netflix's concurrency-limits library. Latencies are averaged over windows of
+ * SampleWindow requests. At the end of each window the limit is scaled by the ratio of the long
+ * term latency to the latency of the window, within [0.5, 1], and a queue allowance of the square
+ * root of the limit is added. The limit thus grows while the latency holds, and shrinks as soon as
+ * requests start to queue upstream.
+ *
+ * Samples are added from all the workers. They are accumulated with atomics and the limit is only
+ * updated under a lock once per window, so that the limit is loosely synchronized, like the rest
+ * of the resource manager.
+ */
+class AdaptiveConcurrencyLimit {
+public:
+  AdaptiveConcurrencyLimit(uint64_t initial_limit, Stats::Gauge* limit_gauge);
+
+  /**
+   * Add the latency of a request.
+   * @param latency supplies the latency of the request.
+   * @return bool whether the request closes a window, in which case update() must be called.
+   */
+  bool addSample(std::chrono::microseconds latency);
+
+  /**
+   * Update the limit from the latency of the window which was just closed.
+   * @param in_flight supplies the number of requests currently outstanding.
+   * @param min_limit supplies the lowest the limit may go.
+   * @param max_limit supplies the highest the limit may go.
+   */
+  void update(uint64_t in_flight, uint64_t min_limit, uint64_t max_limit);
+
+  uint64_t limit() const { return limit_; }
+
+  static const uint64_t SampleWindow = 100;
+
+private:
+  std::atomic<uint64_t> samples_{};
+  std::atomic<uint64_t> latency_sum_{};
+  std::atomic<uint64_t> limit_;
+  Stats::Gauge* limit_gauge_;
+  std::mutex lock_;
+  // The state of the limit, only touched under lock_.
+  double estimated_limit_;
+  double long_latency_{};
+};
+
 /**
  * Implementation of ResourceManager.
  * NOTE: This implementation makes some assumptions which favor simplicity over correctness.
@@ -26,10 +76,11 @@ class ResourceManagerImpl : public ResourceManager {
 public:
   ResourceManagerImpl(Runtime::Loader& runtime, const std::string& runtime_key,
                       uint64_t max_connections, uint64_t max_pending_requests,
-                      uint64_t max_requests, uint64_t max_retries)
+                      uint64_t max_requests, uint64_t max_retries,
+                      Stats::Gauge* requests_limit_gauge = nullptr)
       : connections_(max_connections, runtime, runtime_key + "max_connections"),
         pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests"),
-        requests_(max_requests, runtime, runtime_key + "max_requests"),
+        requests_(max_requests, runtime, runtime_key, requests_limit_gauge),
         retries_(max_retries, runtime, runtime_key + "max_retries") {}
 
   // Upstream::ResourceManager
@@ -37,6 +88,9 @@ public:
   Resource& pendingRequests() override { return pending_requests_; }
   Resource& requests() override { return requests_; }
   Resource& retries() override { return retries_; }
+  void onRequestLatency(std::chrono::microseconds latency) override {
+    requests_.onRequestLatency(latency);
+  }
 
 private:
   struct ResourceImpl : public Resource {
@@ -59,9 +113,34 @@ private:
     const std::string runtime_key_;
   };
 
+  /**
+   * The active requests, whose maximum follows the request latency when adaptive_max_requests is
+   * set in runtime. The configured maximum then caps the adaptive limit.
+   */
+  struct RequestsResourceImpl : public ResourceImpl {
+    RequestsResourceImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key,
+                         Stats::Gauge* limit_gauge)
+        : ResourceImpl(max, runtime, runtime_key + "max_requests"),
+          adaptive_key_(runtime_key + "adaptive_max_requests"),
+          adaptive_min_key_(runtime_key + "adaptive_min_requests"), adaptive_(max, limit_gauge) {}
+
+    // Upstream::Resource
+    uint64_t max() override {
+      const uint64_t configured_max = ResourceImpl::max();
+      return adaptive() ? std::min(configured_max, adaptive_.limit()) : configured_max;
+    }
+
+    bool adaptive() { return runtime_.snapshot().getInteger(adaptive_key_, 0) != 0; }
+    void onRequestLatency(std::chrono::microseconds latency);
+
+    const std::string adaptive_key_;
+    const std::string adaptive_min_key_;
+    AdaptiveConcurrencyLimit adaptive_;
+  };
+
   ResourceImpl connections_;
   ResourceImpl pending_requests_;
-  ResourceImpl requests_;
+  RequestsResourceImpl requests_;
   ResourceImpl retries_;
 };
 
@@ -0,0 +1,68 @@
+#include "common/upstream/response_time_tracker_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+uint32_t ResponseTimeHistogram::bucket(uint64_t value) {
+  if (value < ExactBuckets) {
+    return value;
+  }
+
+  const uint32_t exponent = 63 - __builtin_clzll(value);
+  if (exponent > MaxExponent) {
+    return Buckets - 1;
+  }
+  return ExactBuckets + (exponent - 4) * SubBuckets + ((value >> (exponent - 3)) & 7);
+}
+
+uint64_t ResponseTimeHistogram::bucketUpperBound(uint32_t bucket) {
+  if (bucket < ExactBuckets) {
+    return bucket;
+  }
+
+  const uint32_t exponent = 4 + (bucket - ExactBuckets) / SubBuckets;
+  const uint64_t sub_bucket = (bucket - ExactBuckets) % SubBuckets;
+  return ((SubBuckets + sub_bucket + 1) << (exponent - 3)) - 1;
+}
+
+void ResponseTimeHistogram::recordResponseTime(std::chrono::milliseconds response_time) {
+  counts_[bucket(std::max<int64_t>(response_time.count(), 0))]++;
+  total_++;
+
+  if (--until_decay_ == 0) {
+    until_decay_ = DecayInterval;
+    total_ = 0;
+    for (uint64_t& count : counts_) {
+      count /= 2;
+      total_ += count;
+    }
+  }
+}
+
+Optional<std::chrono::milliseconds> ResponseTimeHistogram::responseTimeQuantile(double quantile) {
+  if (total_ < MinSamples) {
+    return {};
+  }
+
+  const uint64_t rank =
+      std::max<uint64_t>(1, std::ceil(std::min(std::max(quantile, 0.0), 1.0) * total_));
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < Buckets; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::chrono::milliseconds(bucketUpperBound(i));
+    }
+  }
+
+  NOT_REACHED;
+}
+
+} // namespace Upstream
+} // namespace Envoy
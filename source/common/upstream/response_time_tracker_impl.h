@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/upstream/response_time_tracker.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A log-linear histogram of response times: each power of two milliseconds is split into 8
+ * buckets, which bounds the error of an estimate to 12.5%. Every DecayInterval response times the
+ * counts are halved, so that a quantile mostly reflects the last few thousand responses. It is not
+ * thread safe: each worker has its own, with no locking.
+ */
+class ResponseTimeHistogram : public ResponseTimeTracker {
+public:
+  // The fewest response times from which a quantile is estimated.
+  static const uint64_t MinSamples = 100;
+  static const uint64_t DecayInterval = 1024;
+
+  // Upstream::ResponseTimeTracker
+  void recordResponseTime(std::chrono::milliseconds response_time) override;
+  Optional<std::chrono::milliseconds> responseTimeQuantile(double quantile) override;
+
+private:
+  static const uint32_t ExactBuckets = 16;
+  static const uint32_t SubBuckets = 8;
+  // Response times of 2^36ms and more all fall in the last bucket.
+  static const uint32_t MaxExponent = 35;
+  static const uint32_t Buckets = ExactBuckets + (MaxExponent - 3) * SubBuckets;
+
+  static uint32_t bucket(uint64_t value);
+  // The largest response time which falls in a bucket.
+  static uint64_t bucketUpperBound(uint32_t bucket);
+
+  std::array<uint64_t, Buckets> counts_{};
+  uint64_t total_{};
+  uint64_t until_decay_{DecayInterval};
+};
+
+} // namespace Upstream
+} // namespace Envoy
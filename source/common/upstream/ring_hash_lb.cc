@@ -1,7 +1,10 @@
 #include "common/upstream/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -31,7 +34,7 @@ HostConstSharedPtr RingHashLoadBalancer::chooseHost(LoadBalancerContext* context
 
 HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* context,
                                                           Runtime::RandomGenerator& random) {
-  if (ring_.empty()) {
+  if (hashes_.empty()) {
     return nullptr;
   }
 
@@ -44,43 +47,21 @@ HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* c
   }
   const uint64_t h = hash.valid() ? hash.value() : random.random();
 
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
-  // I've generally kept the variable names to make the code easier to compare.
-  // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
-  //       change them!
-  int64_t lowp = 0;
-  int64_t highp = ring_.size();
-  while (true) {
-    int64_t midp = (lowp + highp) / 2;
-
-    if (midp == static_cast<int64_t>(ring_.size())) {
-      return ring_[0].host_;
-    }
-
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
-
-    if (h <= midval && h > midval1) {
-      return ring_[midp].host_;
-    }
-
-    if (midval < h) {
-      lowp = midp + 1;
-    } else {
-      highp = midp - 1;
-    }
-
-    if (lowp > highp) {
-      return ring_[0].host_;
-    }
-  }
+  // The host for a hash is the one of the first entry with an equal or greater hash, wrapping
+  // around to the first entry. This is the same choice as ketama_get_server() in
+  // https://github.com/RJ/ketama/blob/master/libketama/ketama.c.
+  const auto entry = std::lower_bound(hashes_.begin(), hashes_.end(), h);
+  return hosts_[entry == hashes_.end() ? 0 : entry - hashes_.begin()];
 }
 
 void RingHashLoadBalancer::Ring::create(Runtime::Loader& runtime,
                                         const std::vector<HostSharedPtr>& hosts) {
   ENVOY_LOG(trace, "ring hash: building ring");
-  ring_.clear();
   if (hosts.empty()) {
+    hashes_.clear();
+    hosts_.clear();
+    members_.clear();
+    hashes_per_host_ = 0;
     return;
   }
 
@@ -104,23 +85,67 @@ void RingHashLoadBalancer::Ring::create(Runtime::Loader& runtime,
 
   ENVOY_LOG(trace, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size,
             hashes_per_host);
-  ring_.reserve(hosts.size() * hashes_per_host);
+  if (hashes_per_host != hashes_per_host_) {
+    // None of the current entries can be kept when each host needs a different number of them.
+    hashes_.clear();
+    hosts_.clear();
+    members_.clear();
+    hashes_per_host_ = hashes_per_host;
+  }
+
+  // Only the hosts which are not already in the ring are hashed. The current ring holds a reference
+  // to each of its members, so a new host can't have the address of a current member.
+  std::unordered_set<const Host*> members;
+  std::vector<std::pair<uint64_t, HostConstSharedPtr>> new_entries;
   for (const auto& host : hosts) {
+    if (!members.insert(host.get()).second || members_.count(host.get()) != 0) {
+      continue;
+    }
+
     for (uint64_t i = 0; i < hashes_per_host; i++) {
       std::string hash_key(host->address()->asString() + "_" + std::to_string(i));
       // TODO(danielhochman): convert to HashUtil::xxHash64 when we have a migration strategy.
       uint64_t hash = std::hash<std::string>()(hash_key);
       ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key, hash);
-      ring_.push_back({hash, host});
+      new_entries.emplace_back(hash, host);
     }
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
+  std::sort(new_entries.begin(), new_entries.end(),
+            [](const std::pair<uint64_t, HostConstSharedPtr>& lhs,
+               const std::pair<uint64_t, HostConstSharedPtr>& rhs) -> bool {
+              return lhs.first < rhs.first;
+            });
+
+  // Merge the new entries with the entries of the members which are still in the host set.
+  std::vector<uint64_t> hashes;
+  std::vector<HostConstSharedPtr> ring_hosts;
+  hashes.reserve(members.size() * hashes_per_host);
+  ring_hosts.reserve(members.size() * hashes_per_host);
+  auto new_entry = new_entries.begin();
+  for (size_t i = 0; i < hashes_.size(); i++) {
+    if (members.count(hosts_[i].get()) == 0) {
+      continue;
+    }
+
+    for (; new_entry != new_entries.end() && new_entry->first < hashes_[i]; new_entry++) {
+      hashes.push_back(new_entry->first);
+      ring_hosts.push_back(std::move(new_entry->second));
+    }
+    hashes.push_back(hashes_[i]);
+    ring_hosts.push_back(std::move(hosts_[i]));
+  }
+  for (; new_entry != new_entries.end(); new_entry++) {
+    hashes.push_back(new_entry->first);
+    ring_hosts.push_back(std::move(new_entry->second));
+  }
+
+  hashes_ = std::move(hashes);
+  hosts_ = std::move(ring_hosts);
+  members_ = std::move(members);
 #ifndef NVLOG
-  for (auto entry : ring_) {
-    ENVOY_LOG(trace, "ring hash: host={} hash={}", entry.host_->address()->asString(), entry.hash_);
+  for (size_t i = 0; i < hashes_.size(); i++) {
+    ENVOY_LOG(trace, "ring hash: host={} hash={}", hosts_[i]->address()->asString(), hashes_[i]);
   }
 #endif
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
@@ -29,18 +30,19 @@ public:
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
 private:
-  struct RingEntry {
-    uint64_t hash_;
-    HostConstSharedPtr host_;
-  };
-
   struct Ring {
     HostConstSharedPtr chooseHost(LoadBalancerContext* context, Runtime::RandomGenerator& random);
     void create(Runtime::Loader& runtime, const std::vector<HostSharedPtr>& hosts);
 
-    std::vector<RingEntry> ring_;
+    // The sorted hashes of the ring entries, and the host of each entry. The hashes are kept apart
+    // from the hosts so that the binary search of a lookup touches as few cache lines as possible.
+    std::vector<uint64_t> hashes_;
+    std::vector<HostConstSharedPtr> hosts_;
+    // The hosts in the ring and the number of entries each of them has. Hosts which stay in the
+    // host set when the ring is recreated keep their entries rather than being hashed again.
+    std::unordered_set<const Host*> members_;
+    uint64_t hashes_per_host_{};
   };
-
   void refresh();
 
   HostSet& host_set_;
@@ -9,6 +9,7 @@
 #include "common/config/well_known_names.h"
 #include "common/protobuf/utility.h"
 #include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
 
 #include "api/cds.pb.h"
@@ -67,7 +68,7 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   }
 
   // Route has metadata match criteria defined, see if we have a matching subset.
-  LbSubsetEntryPtr entry = findSubset(match_criteria->metadataMatchCriteria());
+  LbSubsetEntryPtr entry = findCachedSubset(*match_criteria);
   if (entry == nullptr || !entry->active()) {
     // No matching subset or subset not active: use fallback policy.
     return nullptr;
@@ -78,6 +79,28 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   return entry->lb_->chooseHost(context);
 }
 
+SubsetLoadBalancer::LbSubsetEntryPtr
+SubsetLoadBalancer::findCachedSubset(const Router::MetadataMatchCriteria& match_criteria) {
+  // Bounds the cache when route configurations are replaced often and the criteria of old routes
+  // are never looked up again.
+  static const size_t MAX_CACHED_SUBSETS = 1024;
+
+  const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& criteria =
+      match_criteria.metadataMatchCriteria();
+  auto cached = subset_cache_.find(&match_criteria);
+  if (cached != subset_cache_.end() && cached->second.criteria_ == criteria) {
+    return cached->second.entry_;
+  }
+
+  if (cached == subset_cache_.end() && subset_cache_.size() >= MAX_CACHED_SUBSETS) {
+    subset_cache_.clear();
+  }
+
+  LbSubsetEntryPtr entry = findSubset(criteria);
+  subset_cache_[&match_criteria] = {criteria, entry};
+  return entry;
+}
+
 // Iterates over the given metadata match criteria (which must be lexically sorted by key) and find
 // a matching LbSubsetEnryPtr, if any.
 SubsetLoadBalancer::LbSubsetEntryPtr SubsetLoadBalancer::findSubset(
@@ -184,6 +207,7 @@ void SubsetLoadBalancer::processSubsets(
 // necessary.
 void SubsetLoadBalancer::update(const std::vector<HostSharedPtr>& hosts_added,
                                 const std::vector<HostSharedPtr>& hosts_removed) {
+  subset_cache_.clear();
   updateFallbackSubset(hosts_added, hosts_removed);
 
   processSubsets(hosts_added, hosts_removed,
@@ -340,6 +364,11 @@ void SubsetLoadBalancer::LbSubsetEntry::initLoadBalancer(const SubsetLoadBalance
                                        subset_lb.random_));
     break;
 
+  case LoadBalancerType::Maglev:
+    lb_.reset(new MaglevLoadBalancer(*host_subset_, subset_lb.stats_, subset_lb.runtime_,
+                                     subset_lb.random_));
+    break;
+
   case LoadBalancerType::OriginalDst:
     NOT_REACHED;
   }
@@ -4,6 +4,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/common/optional.h"
 #include "envoy/runtime/runtime.h"
@@ -86,6 +88,7 @@ private:
   bool hostMatchesDefaultSubset(const Host& host);
   bool hostMatches(const SubsetMetadata& kvs, const Host& host);
 
+  LbSubsetEntryPtr findCachedSubset(const Router::MetadataMatchCriteria& match_criteria);
   LbSubsetEntryPtr
   findSubset(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& matches);
 
@@ -112,6 +115,17 @@ private:
 
   // Forms a trie-like structure. Requires lexically sorted Host and Route metadata.
   LbSubsetMap subsets_;
+
+  struct CachedSubset {
+    // Holding on to the criteria keeps a different criteria allocated at the address of a
+    // destroyed one from having the same criterion pointers.
+    std::vector<Router::MetadataMatchCriterionConstSharedPtr> criteria_;
+    LbSubsetEntryPtr entry_;
+  };
+
+  // The result of findSubset() for the match criteria of routes, which live as long as the route
+  // configuration. Cleared on membership updates, which may create new subsets.
+  std::unordered_map<const Router::MetadataMatchCriteria*, CachedSubset> subset_cache_;
 };
 
 } // namespace Upstream
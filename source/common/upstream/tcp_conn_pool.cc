@@ -0,0 +1,111 @@
+#include "common/upstream/tcp_conn_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+TcpConnPool::TcpConnPool(Event::Dispatcher& dispatcher, HostConstSharedPtr host)
+    : dispatcher_(dispatcher), host_(host) {}
+
+TcpConnPool::~TcpConnPool() {
+  while (!connections_.empty()) {
+    remove(*connections_.front().watcher_);
+  }
+}
+
+Host::CreateConnectionData TcpConnPool::take() {
+  for (auto it = connections_.begin(); it != connections_.end(); it++) {
+    if (!it->watcher_->connected_) {
+      continue;
+    }
+
+    // From here on the connection belongs to the caller, and the watcher stays out of the way.
+    it->watcher_->pool_ = nullptr;
+    Host::CreateConnectionData data = std::move(it->data_);
+    connections_.erase(it);
+    data.connection_->readDisable(false);
+    return data;
+  }
+
+  return {nullptr, nullptr};
+}
+
+void TcpConnPool::fill(uint32_t size) {
+  while (connections_.size() < size) {
+    WatcherSharedPtr watcher = std::make_shared<Watcher>(*this);
+    Watcher* raw_watcher = watcher.get();
+    connections_.push_back({host_->createConnection(dispatcher_), watcher});
+    Network::ClientConnection& connection = *connections_.back().data_.connection_;
+    ENVOY_CONN_LOG(debug, "connecting pooled connection", connection);
+
+    watcher->connection_ = &connection;
+    watcher->connect_timer_ = dispatcher_.createTimer([this, raw_watcher]() -> void {
+      host_->cluster().stats().upstream_cx_connect_timeout_.inc();
+      remove(*raw_watcher);
+    });
+    watcher->connect_timer_->enableTimer(host_->cluster().connectTimeout());
+    connection.addConnectionCallbacks(*watcher);
+    connection.addReadFilter(watcher);
+    connection.connect();
+    connection.noDelay(true);
+  }
+}
+
+void TcpConnPool::onConnected(Watcher& watcher) {
+  ENVOY_CONN_LOG(debug, "pooled connection ready", *watcher.connection_);
+  watcher.connected_ = true;
+  watcher.connect_timer_->disableTimer();
+  // Anything the host sends first stays in the socket until the connection is handed over. Reads
+  // stay disabled while idle, but a close by the host is still noticed.
+  watcher.connection_->readDisable(true);
+}
+
+void TcpConnPool::remove(Watcher& watcher) {
+  auto it = std::find_if(connections_.begin(), connections_.end(),
+                         [&watcher](const PooledConnection& pooled) -> bool {
+                           return pooled.watcher_.get() == &watcher;
+                         });
+  ASSERT(it != connections_.end());
+
+  // The timer may be running this, so it is only disabled. It goes away with the connection.
+  watcher.pool_ = nullptr;
+  watcher.connect_timer_->disableTimer();
+  Network::ClientConnectionPtr connection = std::move(it->data_.connection_);
+  connections_.erase(it);
+  ENVOY_CONN_LOG(debug, "removing pooled connection", *connection);
+  if (connection->state() != Network::Connection::State::Closed) {
+    connection->close(Network::ConnectionCloseType::NoFlush);
+  }
+  dispatcher_.deferredDelete(std::move(connection));
+}
+
+Network::FilterStatus TcpConnPool::Watcher::onData(Buffer::Instance&) {
+  if (pool_ == nullptr) {
+    return Network::FilterStatus::Continue;
+  }
+
+  // Data on a connection which is not handed over yet can only arrive before it is connected, as
+  // during a TLS handshake, and there is nobody to give it to.
+  pool_->remove(*this);
+  return Network::FilterStatus::StopIteration;
+}
+
+void TcpConnPool::Watcher::onEvent(Network::ConnectionEvent event) {
+  if (pool_ == nullptr) {
+    return;
+  }
+
+  if (event == Network::ConnectionEvent::Connected) {
+    pool_->onConnected(*this);
+  } else {
+    pool_->remove(*this);
+  }
+}
+
+} // namespace Upstream
+} // namespace Envoy
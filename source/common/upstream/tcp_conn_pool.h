@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/connection.h"
+#include "envoy/network/filter.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/logger.h"
+#include "common/network/filter_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Per worker pool of established TCP connections to one host, which are handed over to new
+ * downstream connections so that they do not wait for a connection (and TLS handshake) to be set
+ * up. A pooled connection which is closed by the host, or which receives data while idle, is
+ * dropped. Connections are only replaced when fill() is called, so a pool which is not used does
+ * not keep reconnecting to a host which closes idle connections.
+ */
+class TcpConnPool : Logger::Loggable<Logger::Id::upstream> {
+public:
+  TcpConnPool(Event::Dispatcher& dispatcher, HostConstSharedPtr host);
+  ~TcpConnPool();
+
+  /**
+   * @return Host::CreateConnectionData a pooled connection, which is connected and reading, along
+   *         with the host that backs it. Both are nullptr if no pooled connection is connected.
+   */
+  Host::CreateConnectionData take();
+
+  /**
+   * Start connecting new connections until the pool holds the given number of connections,
+   * including those which are still connecting.
+   * @param size supplies the number of connections to keep.
+   */
+  void fill(uint32_t size);
+
+  /**
+   * @return size_t the number of pooled connections, including those which are still connecting.
+   */
+  size_t size() const { return connections_.size(); }
+
+private:
+  /**
+   * Watches a pooled connection. The connection owns the watcher as a read filter, so that the
+   * watcher lives as long as the connection, which keeps calling it after it is handed over. It
+   * is detached from the pool at that point and lets everything through.
+   */
+  struct Watcher : public Network::ReadFilterBaseImpl, public Network::ConnectionCallbacks {
+    Watcher(TcpConnPool& pool) : pool_(&pool) {}
+
+    // Network::ReadFilter
+    Network::FilterStatus onData(Buffer::Instance& data) override;
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    TcpConnPool* pool_;
+    Network::ClientConnection* connection_{};
+    Event::TimerPtr connect_timer_;
+    bool connected_{};
+  };
+
+  typedef std::shared_ptr<Watcher> WatcherSharedPtr;
+
+  struct PooledConnection {
+    Host::CreateConnectionData data_;
+    WatcherSharedPtr watcher_;
+  };
+
+  void onConnected(Watcher& watcher);
+  void remove(Watcher& watcher);
+
+  Event::Dispatcher& dispatcher_;
+  const HostConstSharedPtr host_;
+  std::list<PooledConnection> connections_;
+};
+
+typedef std::unique_ptr<TcpConnPool> TcpConnPoolPtr;
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,10 +1,12 @@
 #include "common/upstream/upstream_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -48,8 +50,39 @@ getSourceAddress(const envoy::api::v2::Cluster& cluster,
   // If there's no source address in the cluster config, use any default from the bootstrap proto.
   return source_address;
 }
+
+Http::Http2Settings getHttp2Settings(const envoy::api::v2::Cluster& config,
+                                     Runtime::Loader& runtime) {
+  Http::Http2Settings http2_settings =
+      Http::Utility::parseHttp2Settings(config.http2_protocol_options());
+  // Growing the receive windows to the bandwidth-delay product of each connection is opted into
+  // through runtime, read when the cluster is created.
+  http2_settings.max_adaptive_window_size_ = std::min<uint64_t>(
+      runtime.snapshot().getInteger(
+          fmt::format("upstream.http2_max_window_size.{}", config.name()), 0),
+      Http::Http2Settings::MAX_INITIAL_STREAM_WINDOW_SIZE);
+  return http2_settings;
+}
 } // namespace
 
+std::list<Stats::CounterSharedPtr> HostImpl::counters() const {
+  // The stats are members of the host, so the pointers share ownership of the host.
+  std::shared_ptr<const HostImpl> self = shared_from_this();
+  std::list<Stats::CounterSharedPtr> counters;
+#define HOST_COUNTER_TO_LIST(NAME) counters.emplace_back(self, &stats_.NAME##_);
+#define IGNORE_HOST_STAT(NAME)
+  ALL_HOST_STATS(HOST_COUNTER_TO_LIST, IGNORE_HOST_STAT)
+  return counters;
+}
+
+std::list<Stats::GaugeSharedPtr> HostImpl::gauges() const {
+  std::shared_ptr<const HostImpl> self = shared_from_this();
+  std::list<Stats::GaugeSharedPtr> gauges;
+#define HOST_GAUGE_TO_LIST(NAME) gauges.emplace_back(self, &stats_.NAME##_);
+  ALL_HOST_STATS(IGNORE_HOST_STAT, HOST_GAUGE_TO_LIST)
+  return gauges;
+}
+
 Host::CreateConnectionData HostImpl::createConnection(Event::Dispatcher& dispatcher) const {
   return {createConnection(dispatcher, *cluster_, address_), shared_from_this()};
 }
@@ -67,10 +100,54 @@ HostImpl::createConnection(Event::Dispatcher& dispatcher, const ClusterInfo& clu
 
 void HostImpl::weight(uint32_t new_weight) { weight_ = std::max(1U, std::min(100U, new_weight)); }
 
+void HostSetImpl::calculateLocalityPercentages(
+    const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality,
+    std::vector<uint64_t>& percentages) {
+  uint64_t total_hosts = 0;
+  for (const auto& locality_hosts : hosts_per_locality) {
+    total_hosts += locality_hosts.size();
+  }
+
+  percentages.clear();
+  percentages.reserve(hosts_per_locality.size());
+  for (const auto& locality_hosts : hosts_per_locality) {
+    percentages.push_back(total_hosts > 0 ? 10000ULL * locality_hosts.size() / total_hosts : 0);
+  }
+}
+
 ClusterStats ClusterInfoImpl::generateStats(Stats::Scope& scope) {
   return {ALL_CLUSTER_STATS(POOL_COUNTER(scope), POOL_GAUGE(scope), POOL_HISTOGRAM(scope))};
 }
 
+ClusterStats ClusterInfoImpl::generateStats(ClusterStatsBlock& block, Stats::Scope& scope) {
+  return {ALL_CLUSTER_STATS(PRIMITIVE_STAT(block), PRIMITIVE_STAT(block), POOL_HISTOGRAM(scope))};
+}
+
+ClusterStatsBlock::ClusterStatsBlock(const std::string& cluster_name)
+    : prefix_(Stats::Utility::sanitizeStatsName(fmt::format("cluster.{}.", cluster_name))) {}
+
+#define CALL_STATS_BLOCK_CB(NAME) cb(NAME##_);
+
+void ClusterStatsBlock::forEachCounter(const std::function<void(Stats::Counter&)>& cb) {
+  ALL_CLUSTER_STATS(CALL_STATS_BLOCK_CB, IGNORE_PRIMITIVE_STAT, IGNORE_PRIMITIVE_STAT)
+}
+
+void ClusterStatsBlock::forEachGauge(const std::function<void(Stats::Gauge&)>& cb) {
+  ALL_CLUSTER_STATS(IGNORE_PRIMITIVE_STAT, CALL_STATS_BLOCK_CB, IGNORE_PRIMITIVE_STAT)
+}
+
+std::atomic<bool>& ClusterInfoImpl::compactStats() {
+  // Like CONSTRUCT_ON_FIRST_USE, but non-const so that the value can be configured.
+  static std::atomic<bool> compact_stats{false};
+  return compact_stats;
+}
+
+void ClusterInfoImpl::configure(Server::Options& options) {
+  compactStats() = options.compactClusterStats();
+}
+
+void ClusterInfoImpl::configureForTestsOnly(bool compact_stats) { compactStats() = compact_stats; }
+
 ClusterLoadReportStats ClusterInfoImpl::generateLoadReportStats(Stats::Scope& scope) {
   return {ALL_CLUSTER_LOAD_REPORT_STATS(POOL_COUNTER(scope))};
 }
@@ -87,14 +164,20 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
       stats_scope_(stats.createScope(fmt::format("cluster.{}.", name_))),
-      stats_(generateStats(*stats_scope_)),
+      stats_block_(compactStats() ? std::make_shared<ClusterStatsBlock>(name_) : nullptr),
+      stats_(stats_block_ ? generateStats(*stats_block_, *stats_scope_)
+                          : generateStats(*stats_scope_)),
       load_report_stats_(generateLoadReportStats(load_report_stats_store_)),
       features_(parseFeatures(config)),
-      http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
-      resource_managers_(config, runtime, name_),
+      http2_settings_(getHttp2Settings(config, runtime)),
+      resource_managers_(config, runtime, name_, *stats_scope_),
       maintenance_mode_runtime_key_(fmt::format("upstream.maintenance_mode.{}", name_)),
       source_address_(getSourceAddress(config, source_address)), added_via_api_(added_via_api),
       lb_subset_(LoadBalancerSubsetInfoImpl(config.lb_subset_config())) {
+  if (stats_block_) {
+    stats.addStatsBlock(stats_block_);
+  }
+
   ssl_ctx_ = nullptr;
   if (config.has_tls_context()) {
     Ssl::ClientContextConfigImpl context_config(config.tls_context());
@@ -262,6 +345,16 @@ ResourceManager& ClusterInfoImpl::resourceManager(ResourcePriority priority) con
   return *resource_managers_.managers_[enumToInt(priority)];
 }
 
+LocalityLoadStats&
+ClusterInfoImpl::localityLoadStats(const envoy::api::v2::Locality& locality) const {
+  std::lock_guard<std::mutex> lock(locality_load_stats_lock_);
+  LocalityLoadStatsImplPtr& stats = locality_load_stats_[locality.SerializeAsString()];
+  if (!stats) {
+    stats.reset(new LocalityLoadStatsImpl());
+  }
+  return stats->stats_;
+}
+
 void ClusterImplBase::initialize(std::function<void()> callback) {
   ASSERT(!initialization_started_);
   ASSERT(initialization_complete_callback_ == nullptr);
@@ -362,16 +455,18 @@ void ClusterImplBase::reloadHealthyHosts() {
 
 ClusterInfoImpl::ResourceManagers::ResourceManagers(const envoy::api::v2::Cluster& config,
                                                     Runtime::Loader& runtime,
-                                                    const std::string& cluster_name) {
+                                                    const std::string& cluster_name,
+                                                    Stats::Scope& scope) {
   managers_[enumToInt(ResourcePriority::Default)] =
-      load(config, runtime, cluster_name, envoy::api::v2::RoutingPriority::DEFAULT);
+      load(config, runtime, cluster_name, scope, envoy::api::v2::RoutingPriority::DEFAULT);
   managers_[enumToInt(ResourcePriority::High)] =
-      load(config, runtime, cluster_name, envoy::api::v2::RoutingPriority::HIGH);
+      load(config, runtime, cluster_name, scope, envoy::api::v2::RoutingPriority::HIGH);
 }
 
 ResourceManagerImplPtr
 ClusterInfoImpl::ResourceManagers::load(const envoy::api::v2::Cluster& config,
                                         Runtime::Loader& runtime, const std::string& cluster_name,
+                                        Stats::Scope& scope,
                                         const envoy::api::v2::RoutingPriority& priority) {
   uint64_t max_connections = 1024;
   uint64_t max_pending_requests = 1024;
@@ -407,7 +502,8 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::api::v2::Cluster& config,
     max_retries = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_retries, max_retries);
   }
   return ResourceManagerImplPtr{new ResourceManagerImpl(
-      runtime, runtime_prefix, max_connections, max_pending_requests, max_requests, max_retries)};
+      runtime, runtime_prefix, max_connections, max_pending_requests, max_requests, max_retries,
+      &scope.gauge(fmt::format("circuit_breakers.{}.rq_concurrency_limit", priority_name)))};
 }
 
 StaticClusterImpl::StaticClusterImpl(const envoy::api::v2::Cluster& cluster,
@@ -450,41 +546,39 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const std::vector<HostSharedP
   uint64_t max_host_weight = 1;
 
   // Go through and see if the list we have is different from what we just got. If it is, we
-  // make a new host list and raise a change notification. This uses an N^2 search given that
-  // this does not happen very often and the list sizes should be small. We also check for
-  // duplicates here. It's possible for DNS to return the same address multiple times, and a bad
-  // SDS implementation could do the same thing.
+  // make a new host list and raise a change notification. The current hosts are indexed by
+  // address, which is what addresses compare by, so that lists of thousands of hosts are matched
+  // in linear time. We also check for duplicates here. It's possible for DNS to return the same
+  // address multiple times, and a bad SDS implementation could do the same thing.
+  std::unordered_map<std::string, size_t> current_host_indices;
+  current_host_indices.reserve(current_hosts.size());
+  for (size_t i = 0; i < current_hosts.size(); i++) {
+    current_host_indices.emplace(current_hosts[i]->address()->asString(), i);
+  }
+
   std::unordered_set<std::string> host_addresses;
+  host_addresses.reserve(new_hosts.size());
   std::vector<HostSharedPtr> final_hosts;
+  final_hosts.reserve(new_hosts.size());
   for (const HostSharedPtr& host : new_hosts) {
-    if (host_addresses.count(host->address()->asString())) {
+    const std::string& address = host->address()->asString();
+    if (!host_addresses.emplace(address).second) {
       continue;
     }
-    host_addresses.emplace(host->address()->asString());
-
-    bool found = false;
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      // If we find a host matched based on address, we keep it. However we do change weight inline
-      // so do that here.
-      if (*(*i)->address() == *host->address()) {
-        if (host->weight() > max_host_weight) {
-          max_host_weight = host->weight();
-        }
 
-        (*i)->weight(host->weight());
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
-        found = true;
-      } else {
-        i++;
-      }
+    if (host->weight() > max_host_weight) {
+      max_host_weight = host->weight();
     }
 
-    if (!found) {
-      if (host->weight() > max_host_weight) {
-        max_host_weight = host->weight();
-      }
-
+    // If we find a host matched based on address, we keep it. However we do change weight inline
+    // so do that here. Its slot in the current hosts is left empty, and dropped below.
+    auto current = current_host_indices.find(address);
+    if (current != current_host_indices.end()) {
+      HostSharedPtr& existing_host = current_hosts[current->second];
+      existing_host->weight(host->weight());
+      final_hosts.push_back(std::move(existing_host));
+      current_host_indices.erase(current);
+    } else {
       final_hosts.push_back(host);
       hosts_added.push_back(host);
 
@@ -495,21 +589,25 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const std::vector<HostSharedP
     }
   }
 
-  // If there are removed hosts, check to see if we should only delete if unhealthy.
-  if (!current_hosts.empty() && depend_on_hc) {
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      if (!(*i)->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
-        if ((*i)->weight() > max_host_weight) {
-          max_host_weight = (*i)->weight();
-        }
+  // What is left of the current hosts are the hosts which are gone. If we are depending on a
+  // health checker, only the unhealthy ones are deleted.
+  std::vector<HostSharedPtr> removed;
+  for (HostSharedPtr& host : current_hosts) {
+    if (host == nullptr) {
+      continue;
+    }
 
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
-      } else {
-        i++;
+    if (depend_on_hc && !host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
+      if (host->weight() > max_host_weight) {
+        max_host_weight = host->weight();
       }
+
+      final_hosts.push_back(std::move(host));
+    } else {
+      removed.push_back(std::move(host));
     }
   }
+  current_hosts = std::move(removed);
 
   info_->stats().max_host_weight_.set(max_host_weight);
 
@@ -7,7 +7,9 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -15,6 +17,7 @@
 #include "envoy/local_info/local_info.h"
 #include "envoy/network/dns.h"
 #include "envoy/runtime/runtime.h"
+#include "envoy/server/options.h"
 #include "envoy/ssl/context_manager.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
@@ -74,9 +77,12 @@ public:
         canary_(Config::Metadata::metadataValue(metadata, Config::MetadataFilters::get().ENVOY_LB,
                                                 Config::MetadataEnvoyLbKeys::get().CANARY)
                     .bool_value()),
-        metadata_(metadata), locality_(locality), stats_{ALL_HOST_STATS(POOL_COUNTER(stats_store_),
-                                                                        POOL_GAUGE(stats_store_))} {
-  }
+        metadata_(metadata), locality_(locality),
+        primitive_load_stats_(cluster->localityLoadStats(locality)),
+        stats_{ALL_HOST_BASE_STATS(PRIMITIVE_STAT(primitive_stats_),
+                                   PRIMITIVE_STAT(primitive_stats_))
+                   ALL_HOST_LOAD_STATS(PRIMITIVE_STAT(primitive_load_stats_),
+                                       PRIMITIVE_STAT(primitive_load_stats_))} {}
 
   // Upstream::HostDescription
   bool canary() const override { return canary_; }
@@ -112,7 +118,66 @@ protected:
   const bool canary_;
   const envoy::api::v2::Metadata metadata_;
   const envoy::api::v2::Locality locality_;
-  Stats::IsolatedStoreImpl stats_store_;
+  // Hosts do not have a store of their own, as clusters can have many thousands of them. The
+  // gauges are updated by every worker sending requests to the host, so they are sharded.
+  struct PrimitiveHostStats {
+    ALL_HOST_BASE_STATS(GENERATE_PRIMITIVE_COUNTER_STRUCT, GENERATE_SHARDED_PRIMITIVE_GAUGE_STRUCT)
+  };
+
+  /**
+   * Counter which also adds to the total of the host's locality.
+   */
+  class LocalityCounter : public Stats::PrimitiveCounter {
+  public:
+    LocalityCounter(const char* name, Stats::Counter& locality)
+        : Stats::PrimitiveCounter(name), locality_(locality) {}
+
+    // Stats::Counter
+    void add(uint64_t amount) override {
+      Stats::PrimitiveCounter::add(amount);
+      locality_.add(amount);
+    }
+
+  private:
+    Stats::Counter& locality_;
+  };
+
+  /**
+   * Gauge which also updates the total of the host's locality.
+   */
+  class LocalityGauge : public Stats::ShardedPrimitiveGauge {
+  public:
+    LocalityGauge(const char* name, Stats::Gauge& locality)
+        : Stats::ShardedPrimitiveGauge(name), locality_(locality) {}
+
+    // Stats::Gauge
+    void add(uint64_t amount) override {
+      Stats::ShardedPrimitiveGauge::add(amount);
+      locality_.add(amount);
+    }
+    void sub(uint64_t amount) override {
+      Stats::ShardedPrimitiveGauge::sub(amount);
+      locality_.sub(amount);
+    }
+
+  private:
+    Stats::Gauge& locality_;
+  };
+
+  // The load report stats are totalled per locality as they are updated, so that the load reporter
+  // does not have to walk every host of the clusters it reports on.
+  struct PrimitiveHostLoadStats {
+    PrimitiveHostLoadStats(LocalityLoadStats& locality)
+        : rq_success_("rq_success", locality.rq_success_),
+          rq_error_("rq_error", locality.rq_error_), rq_active_("rq_active", locality.rq_active_) {}
+
+    LocalityCounter rq_success_;
+    LocalityCounter rq_error_;
+    LocalityGauge rq_active_;
+  };
+
+  PrimitiveHostStats primitive_stats_;
+  PrimitiveHostLoadStats primitive_load_stats_;
   HostStats stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
@@ -134,9 +199,9 @@ public:
   }
 
   // Upstream::Host
-  std::list<Stats::CounterSharedPtr> counters() const override { return stats_store_.counters(); }
+  std::list<Stats::CounterSharedPtr> counters() const override;
   CreateConnectionData createConnection(Event::Dispatcher& dispatcher) const override;
-  std::list<Stats::GaugeSharedPtr> gauges() const override { return stats_store_.gauges(); }
+  std::list<Stats::GaugeSharedPtr> gauges() const override;
   void healthFlagClear(HealthFlag flag) override { health_flags_ &= ~enumToInt(flag); }
   bool healthFlagGet(HealthFlag flag) const override { return health_flags_ & enumToInt(flag); }
   void healthFlagSet(HealthFlag flag) override { health_flags_ |= enumToInt(flag); }
@@ -163,11 +228,6 @@ private:
   std::atomic<bool> used_;
 };
 
-typedef std::shared_ptr<std::vector<HostSharedPtr>> HostVectorSharedPtr;
-typedef std::shared_ptr<const std::vector<HostSharedPtr>> HostVectorConstSharedPtr;
-typedef std::shared_ptr<std::vector<std::vector<HostSharedPtr>>> HostListsSharedPtr;
-typedef std::shared_ptr<const std::vector<std::vector<HostSharedPtr>>> HostListsConstSharedPtr;
-
 /**
  * Base class for all clusters as well as thread local host sets.
  */
@@ -187,6 +247,7 @@ public:
     healthy_hosts_ = std::move(healthy_hosts);
     hosts_per_locality_ = std::move(hosts_per_locality);
     healthy_hosts_per_locality_ = std::move(healthy_hosts_per_locality);
+    calculateLocalityPercentages(*healthy_hosts_per_locality_, healthy_locality_percentages_);
     runUpdateCallbacks(hosts_added, hosts_removed);
   }
 
@@ -199,10 +260,28 @@ public:
   const std::vector<std::vector<HostSharedPtr>>& healthyHostsPerLocality() const override {
     return *healthy_hosts_per_locality_;
   }
+  const std::vector<uint64_t>& healthyLocalityPercentages() const override {
+    return healthy_locality_percentages_;
+  }
+  HostVectorConstSharedPtr hostsPtr() const override { return hosts_; }
+  HostVectorConstSharedPtr healthyHostsPtr() const override { return healthy_hosts_; }
+  HostListsConstSharedPtr hostsPerLocalityPtr() const override { return hosts_per_locality_; }
+  HostListsConstSharedPtr healthyHostsPerLocalityPtr() const override {
+    return healthy_hosts_per_locality_;
+  }
   Common::CallbackHandle* addMemberUpdateCb(MemberUpdateCb callback) const override {
     return member_update_cb_helper_.add(callback);
   }
 
+  /**
+   * Calculate the share of the hosts in each locality, scaled by 10000 for better precision.
+   * @param hosts_per_locality supplies the hosts of each locality.
+   * @param percentages supplies the vector to fill with one entry per locality.
+   */
+  static void calculateLocalityPercentages(
+      const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality,
+      std::vector<uint64_t>& percentages);
+
 protected:
   virtual void runUpdateCallbacks(const std::vector<HostSharedPtr>& hosts_added,
                                   const std::vector<HostSharedPtr>& hosts_removed) {
@@ -214,6 +293,7 @@ private:
   HostVectorConstSharedPtr healthy_hosts_;
   HostListsConstSharedPtr hosts_per_locality_;
   HostListsConstSharedPtr healthy_hosts_per_locality_;
+  std::vector<uint64_t> healthy_locality_percentages_;
   mutable Common::CallbackManager<const std::vector<HostSharedPtr>&,
                                   const std::vector<HostSharedPtr>&>
       member_update_cb_helper_;
@@ -221,6 +301,26 @@ private:
 
 typedef std::unique_ptr<HostSetImpl> HostSetImplPtr;
 
+/**
+ * The counters and gauges of a cluster, as a block of primitive stats added to the store rather
+ * than stats of the cluster's scope. @see Server::Options::compactClusterStats().
+ */
+class ClusterStatsBlock : public Stats::StatsBlock {
+public:
+  explicit ClusterStatsBlock(const std::string& cluster_name);
+
+  // Stats::StatsBlock
+  const std::string& prefix() const override { return prefix_; }
+  void forEachCounter(const std::function<void(Stats::Counter&)>& cb) override;
+  void forEachGauge(const std::function<void(Stats::Gauge&)>& cb) override;
+
+  ALL_CLUSTER_STATS(GENERATE_PRIMITIVE_COUNTER_STRUCT, GENERATE_PRIMITIVE_GAUGE_STRUCT,
+                    IGNORE_PRIMITIVE_STAT)
+
+private:
+  const std::string prefix_;
+};
+
 /**
  * Implementation of ClusterInfo that reads from JSON.
  */
@@ -232,8 +332,20 @@ public:
                   Ssl::ContextManager& ssl_context_manager, bool added_via_api);
 
   static ClusterStats generateStats(Stats::Scope& scope);
+  static ClusterStats generateStats(ClusterStatsBlock& block, Stats::Scope& scope);
   static ClusterLoadReportStats generateLoadReportStats(Stats::Scope& scope);
 
+  /**
+   * Configure whether the clusters constructed afterwards keep their counters and gauges in a
+   * ClusterStatsBlock.
+   */
+  static void configure(Server::Options& options);
+
+  /**
+   * Allow tests to configure the stats of the clusters constructed afterwards.
+   */
+  static void configureForTestsOnly(bool compact_stats);
+
   // Upstream::ClusterInfo
   bool addedViaApi() const override { return added_via_api_; }
   std::chrono::milliseconds connectTimeout() const override { return connect_timeout_; }
@@ -251,6 +363,7 @@ public:
   ClusterStats& stats() const override { return stats_; }
   Stats::Scope& statsScope() const override { return *stats_scope_; }
   ClusterLoadReportStats& loadReportStats() const override { return load_report_stats_; }
+  LocalityLoadStats& localityLoadStats(const envoy::api::v2::Locality& locality) const override;
   const Network::Address::InstanceConstSharedPtr& sourceAddress() const override {
     return source_address_;
   };
@@ -259,9 +372,9 @@ public:
 private:
   struct ResourceManagers {
     ResourceManagers(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
-                     const std::string& cluster_name);
+                     const std::string& cluster_name, Stats::Scope& scope);
     ResourceManagerImplPtr load(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
-                                const std::string& cluster_name,
+                                const std::string& cluster_name, Stats::Scope& scope,
                                 const envoy::api::v2::RoutingPriority& priority);
 
     typedef std::array<ResourceManagerImplPtr, NumResourcePriorities> Managers;
@@ -269,7 +382,23 @@ private:
     Managers managers_;
   };
 
+  // The load report stats of the cluster's hosts in one locality. The gauge is updated by every
+  // worker sending requests to the locality, so it is sharded like the host gauges.
+  struct LocalityLoadStatsImpl {
+    struct PrimitiveLocalityLoadStats {
+      ALL_HOST_LOAD_STATS(GENERATE_PRIMITIVE_COUNTER_STRUCT,
+                          GENERATE_SHARDED_PRIMITIVE_GAUGE_STRUCT)
+    };
+
+    PrimitiveLocalityLoadStats primitive_stats_;
+    LocalityLoadStats stats_{ALL_HOST_LOAD_STATS(PRIMITIVE_STAT(primitive_stats_),
+                                                 PRIMITIVE_STAT(primitive_stats_))};
+  };
+
+  typedef std::unique_ptr<LocalityLoadStatsImpl> LocalityLoadStatsImplPtr;
+
   static uint64_t parseFeatures(const envoy::api::v2::Cluster& config);
+  static std::atomic<bool>& compactStats();
 
   Runtime::Loader& runtime_;
   const std::string name_;
@@ -277,9 +406,15 @@ private:
   const std::chrono::milliseconds connect_timeout_;
   const uint32_t per_connection_buffer_limit_bytes_;
   Stats::ScopePtr stats_scope_;
+  // Only set with compact stats. The store keeps a weak reference.
+  std::shared_ptr<ClusterStatsBlock> stats_block_;
   mutable ClusterStats stats_;
   Stats::IsolatedStoreImpl load_report_stats_store_;
   mutable ClusterLoadReportStats load_report_stats_;
+  // Hosts can be created on any thread, e.g. by the original destination cluster. The map is
+  // keyed by the serialized locality.
+  mutable std::mutex locality_load_stats_lock_;
+  mutable std::unordered_map<std::string, LocalityLoadStatsImplPtr> locality_load_stats_;
   Ssl::ClientContextPtr ssl_ctx_;
   const uint64_t features_;
   const Http::Http2Settings http2_settings_;
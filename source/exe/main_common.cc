@@ -1,11 +1,14 @@
 #include <iostream>
 #include <memory>
 
+#include "common/common/cleanup.h"
 #include "common/common/compiler_requirements.h"
+#include "common/common/utility.h"
 #include "common/event/libevent.h"
 #include "common/network/utility.h"
 #include "common/stats/stats_impl.h"
 #include "common/stats/thread_local_store.h"
+#include "common/upstream/upstream_impl.h"
 
 #include "server/config_validation/server.h"
 #include "server/drain_manager_impl.h"
@@ -28,7 +31,7 @@ class ProdComponentFactory : public ComponentFactory {
 public:
   // Server::DrainManagerFactory
   DrainManagerPtr createDrainManager(Instance& server) override {
-    return DrainManagerPtr{new DrainManagerImpl(server)};
+    return DrainManagerPtr{new DrainManagerImpl(server, ProdMonotonicTimeSource::instance_)};
   }
 
   Runtime::LoaderPtr createRuntime(Server::Instance& server,
@@ -41,6 +44,9 @@ public:
 
 int main_common(OptionsImpl& options) {
   Stats::RawStatData::configure(options);
+  Stats::ShardedPrimitiveGauge::configure(options);
+  Stats::CounterImpl::configure(options);
+  Upstream::ClusterInfoImpl::configure(options);
 
 #ifdef ENVOY_HOT_RESTART
   Api::OsSysCallsImpl os_sys_calls_impl;
@@ -78,6 +84,12 @@ int main_common(OptionsImpl& options) {
   ares_library_init(ARES_LIB_INIT_ALL);
 
   Logger::Registry::initialize(options.logLevel(), log_lock);
+  if (options.asyncLogBufferSize() > 0) {
+    Logger::Registry::getSink()->enableAsync(options.asyncLogBufferSize());
+  }
+  // The sink is never destroyed, so the messages still waiting at exit, including those logged
+  // while the server shuts down, are written out here.
+  Cleanup async_log_cleanup([]() -> void { Logger::Registry::getSink()->disableAsync(); });
   DefaultTestHooks default_test_hooks;
   ThreadLocal::InstanceImpl tls;
   Stats::ThreadLocalStoreImpl stats_store(stats_allocator);
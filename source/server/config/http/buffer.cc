@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/registry/registry.h"
@@ -18,10 +19,20 @@ HttpFilterFactoryCb BufferFilterConfig::createFilterFactory(const Json::Object&
                                                             FactoryContext& context) {
   json_config.validateSchema(Json::Schema::BUFFER_HTTP_FILTER_SCHEMA);
 
-  Http::BufferFilterConfigConstSharedPtr config(new Http::BufferFilterConfig{
+  std::shared_ptr<Http::BufferFilterConfig> config(new Http::BufferFilterConfig{
       Http::BufferFilter::generateStats(stats_prefix, context.scope()),
       static_cast<uint64_t>(json_config.getInteger("max_request_bytes")),
       std::chrono::seconds(json_config.getInteger("max_request_time_s"))});
+  config->spill_directory_ = json_config.getString("spill_directory", "");
+  if (!config->spill_directory_.empty()) {
+    config->spill_threshold_bytes_ = json_config.getInteger("spill_threshold_bytes", 0);
+    config->max_worker_memory_bytes_ = json_config.getInteger("max_worker_memory_bytes", 0);
+    config->worker_memory_ = context.threadLocal().allocateSlot();
+    config->worker_memory_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+      return std::make_shared<Http::BufferFilterWorkerMemory>();
+    });
+  }
+
   return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamDecoderFilter(
         Http::StreamDecoderFilterSharedPtr{new Http::BufferFilter(config)});
@@ -0,0 +1,32 @@
+#include "server/config/http/cache.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/common/utility.h"
+#include "common/http/filter/cache_filter.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb CacheFilterConfig::createFilterFactory(const Json::Object& json_config,
+                                                           const std::string& stats_prefix,
+                                                           FactoryContext& context) {
+  Http::CacheFilterConfigSharedPtr config(
+      new Http::CacheFilterConfig(json_config, stats_prefix, context.scope(),
+                                  context.threadLocal(), ProdMonotonicTimeSource::instance_));
+  return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(Http::StreamFilterSharedPtr{new Http::CacheFilter(config)});
+  };
+}
+
+/**
+ * Static registration for the cache filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<CacheFilterConfig, NamedHttpFilterConfigFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,54 @@
+#include "server/config/http/grpc_access_log.h"
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+#include "common/grpc/async_client_impl.h"
+#include "common/http/access_log/grpc_access_log_impl.h"
+#include "common/protobuf/protobuf.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+Http::AccessLog::InstanceSharedPtr HttpGrpcAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, Http::AccessLog::FilterPtr&& filter, FactoryContext& context) {
+  const auto& proto_config =
+      dynamic_cast<const envoy::access_log::HttpGrpcAccessLogConfig&>(config);
+  Upstream::ClusterManager& cm = context.clusterManager();
+  const std::string cluster_name = proto_config.cluster_name();
+  if (!cm.get(cluster_name)) {
+    throw EnvoyException(fmt::format("unknown access log service cluster '{}'", cluster_name));
+  }
+
+  return Http::AccessLog::InstanceSharedPtr{new Http::AccessLog::HttpGrpcAccessLog(
+      std::move(filter), proto_config,
+      [&cm, cluster_name]() -> Http::AccessLog::AccessLogServiceAsyncClientPtr {
+        return Http::AccessLog::AccessLogServiceAsyncClientPtr{
+            new Grpc::AsyncClientImpl<envoy::access_log::StreamAccessLogsMessage,
+                                      envoy::access_log::StreamAccessLogsResponse>(cm,
+                                                                                   cluster_name)};
+      },
+      context.threadLocal(), context.scope())};
+}
+
+ProtobufTypes::MessagePtr HttpGrpcAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::access_log::HttpGrpcAccessLogConfig()};
+}
+
+std::string HttpGrpcAccessLogFactory::name() const {
+  return Config::AccessLogNames::get().HTTP_GRPC;
+}
+
+/**
+ * Static registration for the gRPC access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<HttpGrpcAccessLogFactory, AccessLogInstanceFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
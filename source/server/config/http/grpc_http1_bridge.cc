@@ -1,10 +1,12 @@
 #include "server/config/http/grpc_http1_bridge.h"
 
+#include <memory>
 #include <string>
 
 #include "envoy/registry/registry.h"
 
 #include "common/grpc/http1_bridge_filter.h"
+#include "common/grpc/stats_cache.h"
 
 namespace Envoy {
 namespace Server {
@@ -13,9 +15,13 @@ namespace Configuration {
 HttpFilterFactoryCb GrpcHttp1BridgeFilterConfig::createFilterFactory(const Json::Object&,
                                                                      const std::string&,
                                                                      FactoryContext& context) {
-  return [&context](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-    callbacks.addStreamFilter(
-        Http::StreamFilterSharedPtr{new Grpc::Http1BridgeFilter(context.clusterManager())});
+  std::shared_ptr<ThreadLocal::Slot> stats_cache_slot = context.threadLocal().allocateSlot();
+  stats_cache_slot->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<Grpc::StatsCache>("grpc");
+  });
+  return [&context, stats_cache_slot](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(Http::StreamFilterSharedPtr{new Grpc::Http1BridgeFilter(
+        context.clusterManager(), stats_cache_slot->getTyped<Grpc::StatsCache>())});
   };
 }
 
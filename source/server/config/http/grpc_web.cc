@@ -1,8 +1,11 @@
 #include "server/config/http/grpc_web.h"
 
+#include <memory>
+
 #include "envoy/registry/registry.h"
 
 #include "common/grpc/grpc_web_filter.h"
+#include "common/grpc/stats_cache.h"
 
 namespace Envoy {
 namespace Server {
@@ -11,9 +14,13 @@ namespace Configuration {
 HttpFilterFactoryCb GrpcWebFilterConfig::createFilterFactory(const Json::Object&,
                                                              const std::string&,
                                                              FactoryContext& context) {
-  return [&context](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-    callbacks.addStreamFilter(
-        Http::StreamFilterSharedPtr{new Grpc::GrpcWebFilter(context.clusterManager())});
+  std::shared_ptr<ThreadLocal::Slot> stats_cache_slot = context.threadLocal().allocateSlot();
+  stats_cache_slot->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<Grpc::StatsCache>("grpc-web");
+  });
+  return [&context, stats_cache_slot](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(Http::StreamFilterSharedPtr{new Grpc::GrpcWebFilter(
+        context.clusterManager(), stats_cache_slot->getTyped<Grpc::StatsCache>())});
   };
 }
 
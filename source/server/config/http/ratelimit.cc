@@ -5,7 +5,9 @@
 
 #include "envoy/registry/registry.h"
 
+#include "common/common/utility.h"
 #include "common/http/filter/ratelimit.h"
+#include "common/ratelimit/local_ratelimit_impl.h"
 
 namespace Envoy {
 namespace Server {
@@ -17,6 +19,19 @@ HttpFilterFactoryCb RateLimitFilterConfig::createFilterFactory(const Json::Objec
   Http::RateLimit::FilterConfigSharedPtr filter_config(new Http::RateLimit::FilterConfig(
       config, context.localInfo(), context.scope(), context.runtime(), context.clusterManager()));
   const uint32_t timeout_ms = config.getInteger("timeout_ms", 20);
+
+  if (config.hasObject("local_rate_limit")) {
+    RateLimit::LocalRateLimitConfigSharedPtr local_config(new RateLimit::LocalRateLimitConfig(
+        *config.getObject("local_rate_limit"), context.threadLocal(),
+        ProdMonotonicTimeSource::instance_, [timeout_ms, &context]() -> RateLimit::ClientPtr {
+          return context.rateLimitClient(std::chrono::milliseconds(timeout_ms));
+        }));
+    return [filter_config, local_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+      callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{new Http::RateLimit::Filter(
+          filter_config, RateLimit::ClientPtr{new RateLimit::LocalClientImpl(local_config)})});
+    };
+  }
+
   return [filter_config, timeout_ms,
           &context](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{new Http::RateLimit::Filter(
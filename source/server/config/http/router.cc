@@ -4,6 +4,7 @@
 
 #include "envoy/registry/registry.h"
 
+#include "common/common/free_list.h"
 #include "common/config/filter_json.h"
 #include "common/json/config_schemas.h"
 #include "common/router/router.h"
@@ -22,8 +23,11 @@ HttpFilterFactoryCb createRouterFilterFactory(const envoy::api::v2::filter::http
       stat_prefix, context,
       Router::ShadowWriterPtr{new Router::ShadowWriterImpl(context.clusterManager())}, router));
 
+  // Every request creates a router filter, so the filters are recycled through a per-thread free
+  // list.
   return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-    callbacks.addStreamDecoderFilter(std::make_shared<Router::ProdFilter>(*config));
+    callbacks.addStreamDecoderFilter(std::allocate_shared<Router::ProdFilter>(
+        FreeListAllocator<Router::ProdFilter>(), *config));
   };
 }
 
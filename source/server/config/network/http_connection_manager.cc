@@ -1,5 +1,6 @@
 #include "server/config/network/http_connection_manager.h"
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <string>
@@ -22,6 +23,7 @@
 #include "common/json/config_schemas.h"
 #include "common/protobuf/utility.h"
 #include "common/router/rds_impl.h"
+#include "common/runtime/key_registry.h"
 
 #include "fmt/format.h"
 
@@ -35,6 +37,10 @@ const std::string HttpConnectionManagerConfig::DEFAULT_SERVER_STRING = "envoy";
 SINGLETON_MANAGER_REGISTRATION(date_provider);
 SINGLETON_MANAGER_REGISTRATION(route_config_provider_manager);
 
+// The fraction of the streams, in units of 0.01%, whose filter chain is timed.
+static const Runtime::Key& FilterTimingSampling =
+    Runtime::KeyRegistry::registerKey("http.filter_timing_sampling");
+
 namespace {
 
 NetworkFilterFactoryCb createHttpConnectionManagerFilterFactory(
@@ -132,6 +138,33 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
       config, context_.runtime(), context_.clusterManager(), context_.scope(), stats_prefix_,
       context_.initManager(), route_config_provider_manager_);
 
+  // Header value interning is not part of the protocol options yet so it is opted into through
+  // runtime. Codecs pick the setting up when they are created.
+  const bool intern_header_values =
+      context_.runtime().snapshot().getInteger("http.intern_header_values", 0) != 0;
+  http1_settings_.intern_header_values_ = intern_header_values;
+  http2_settings_.intern_header_values_ = intern_header_values;
+
+  // The HTTP/1 parser backend is selected per connection manager, keyed by its stat prefix (e.g.
+  // http.ingress_http.http1_fast_parser).
+  http1_settings_.fast_parser_ =
+      context_.runtime().snapshot().getInteger(stats_prefix_ + "http1_fast_parser", 0) != 0;
+
+  // Likewise for aggregating the chunks of HTTP/1 responses over a bounded delay
+  // (e.g. http.ingress_http.http1_chunk_aggregation_ms).
+  http1_settings_.chunk_aggregation_ = std::chrono::milliseconds(
+      context_.runtime().snapshot().getInteger(stats_prefix_ + "http1_chunk_aggregation_ms", 0));
+
+  // Likewise for adaptive HPACK table sizing (e.g. http.ingress_http.http2_max_hpack_table_size).
+  http2_settings_.max_adaptive_hpack_table_size_ =
+      context_.runtime().snapshot().getInteger(stats_prefix_ + "http2_max_hpack_table_size", 0);
+
+  // And for growing the HTTP/2 receive windows to the bandwidth-delay product of the connection
+  // (e.g. http.ingress_http.http2_max_window_size).
+  http2_settings_.max_adaptive_window_size_ = std::min<uint64_t>(
+      context_.runtime().snapshot().getInteger(stats_prefix_ + "http2_max_window_size", 0),
+      Http::Http2Settings::MAX_INITIAL_STREAM_WINDOW_SIZE);
+
   switch (config.forward_client_cert_details()) {
   case envoy::api::v2::filter::http::HttpConnectionManager::SANITIZE:
     forward_client_cert_ = Http::ForwardClientCertType::Sanitize;
@@ -241,7 +274,9 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
           Config::Utility::translateToFactoryConfig(proto_config, factory);
       callback = factory.createFilterFactoryFromProto(*message, stats_prefix_, context);
     }
-    filter_factories_.push_back(callback);
+    filter_factories_.push_back(
+        {callback, Http::FilterTimingCallbacks::generateStats(
+                       fmt::format("{}filter.{}.", stats_prefix_, string_name), context_.scope())});
   }
 }
 
@@ -271,8 +306,17 @@ HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
 }
 
 void HttpConnectionManagerConfig::createFilterChain(Http::FilterChainFactoryCallbacks& callbacks) {
-  for (const HttpFilterFactoryCb& factory : filter_factories_) {
-    factory(callbacks);
+  if (!context_.runtime().snapshot().featureEnabled(FilterTimingSampling, 0,
+                                                    context_.random().random(), 10000)) {
+    for (const FilterFactory& factory : filter_factories_) {
+      factory.callback_(callbacks);
+    }
+    return;
+  }
+
+  for (FilterFactory& factory : filter_factories_) {
+    Http::FilterTimingCallbacks timing_callbacks(callbacks, factory.timing_stats_);
+    factory.callback_(timing_callbacks);
   }
 }
 
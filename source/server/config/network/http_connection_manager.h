@@ -13,6 +13,7 @@
 #include "common/common/logger.h"
 #include "common/config/well_known_names.h"
 #include "common/http/conn_manager_impl.h"
+#include "common/http/filter_timing.h"
 #include "common/json/json_loader.h"
 
 namespace Envoy {
@@ -77,6 +78,7 @@ public:
   std::chrono::milliseconds drainTimeout() override { return drain_timeout_; }
   FilterChainFactory& filterFactory() override { return *this; }
   bool generateRequestId() override { return generate_request_id_; }
+  bool rejectNewStreams() override { return context_.overloadManager().rejectNewStreams(); }
   const Optional<std::chrono::milliseconds>& idleTimeout() override { return idle_timeout_; }
   Router::RouteConfigProvider& routeConfigProvider() override { return *route_config_provider_; }
   const std::string& serverName() override { return server_name_; }
@@ -99,8 +101,13 @@ public:
 private:
   enum class CodecType { HTTP1, HTTP2, AUTO };
 
+  struct FilterFactory {
+    HttpFilterFactoryCb callback_;
+    Http::FilterTimingStats timing_stats_;
+  };
+
   FactoryContext& context_;
-  std::list<HttpFilterFactoryCb> filter_factories_;
+  std::list<FilterFactory> filter_factories_;
   std::list<Http::AccessLog::InstanceSharedPtr> access_logs_;
   const std::string stats_prefix_;
   Http::ConnectionManagerStats stats_;
@@ -110,8 +117,8 @@ private:
   std::vector<Http::ClientCertDetailsType> set_current_client_cert_details_;
   Router::RouteConfigProviderManager& route_config_provider_manager_;
   CodecType codec_type_;
-  const Http::Http2Settings http2_settings_;
-  const Http::Http1Settings http1_settings_;
+  Http::Http2Settings http2_settings_;
+  Http::Http1Settings http1_settings_;
   std::string server_name_;
   Http::TracingConnectionManagerConfigPtr tracing_config_;
   Optional<std::string> user_agent_;
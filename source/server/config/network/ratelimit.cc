@@ -6,7 +6,9 @@
 #include "envoy/network/connection.h"
 #include "envoy/registry/registry.h"
 
+#include "common/common/utility.h"
 #include "common/filter/ratelimit.h"
+#include "common/ratelimit/local_ratelimit_impl.h"
 
 namespace Envoy {
 namespace Server {
@@ -17,6 +19,19 @@ NetworkFilterFactoryCb RateLimitConfigFactory::createFilterFactory(const Json::O
   RateLimit::TcpFilter::ConfigSharedPtr config(
       new RateLimit::TcpFilter::Config(json_config, context.scope(), context.runtime()));
   const uint32_t timeout_ms = json_config.getInteger("timeout_ms", 20);
+
+  if (json_config.hasObject("local_rate_limit")) {
+    RateLimit::LocalRateLimitConfigSharedPtr local_config(new RateLimit::LocalRateLimitConfig(
+        *json_config.getObject("local_rate_limit"), context.threadLocal(),
+        ProdMonotonicTimeSource::instance_, [timeout_ms, &context]() -> RateLimit::ClientPtr {
+          return context.rateLimitClient(std::chrono::milliseconds(timeout_ms));
+        }));
+    return [config, local_config](Network::FilterManager& filter_manager) -> void {
+      filter_manager.addReadFilter(Network::ReadFilterSharedPtr{new RateLimit::TcpFilter::Instance(
+          config, RateLimit::ClientPtr{new RateLimit::LocalClientImpl(local_config)})});
+    };
+  }
+
   return [config, timeout_ms, &context](Network::FilterManager& filter_manager) -> void {
     filter_manager.addReadFilter(Network::ReadFilterSharedPtr{new RateLimit::TcpFilter::Instance(
         config, context.rateLimitClient(std::chrono::milliseconds(timeout_ms)))});
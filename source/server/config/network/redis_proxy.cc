@@ -4,29 +4,43 @@
 #include <string>
 
 #include "envoy/registry/registry.h"
+#include "envoy/singleton/manager.h"
 
 #include "common/redis/codec_impl.h"
 #include "common/redis/command_splitter_impl.h"
 #include "common/redis/conn_pool_impl.h"
+#include "common/redis/hot_key_impl.h"
 #include "common/redis/proxy_filter.h"
 
 namespace Envoy {
 namespace Server {
 namespace Configuration {
 
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(redis_hot_key_admin);
+
 NetworkFilterFactoryCb
 RedisProxyFilterConfigFactory::createFilterFactory(const Json::Object& config,
                                                    FactoryContext& context) {
   Redis::ProxyFilterConfigSharedPtr filter_config(std::make_shared<Redis::ProxyFilterConfig>(
       config, context.clusterManager(), context.scope()));
-  Redis::ConnPool::InstancePtr conn_pool(
+  std::unique_ptr<Redis::ConnPool::InstanceImpl> conn_pool(
       new Redis::ConnPool::InstanceImpl(filter_config->clusterName(), context.clusterManager(),
                                         Redis::ConnPool::ClientFactoryImpl::instance_,
                                         context.threadLocal(), *config.getObject("conn_pool")));
+
+  std::shared_ptr<Redis::HotKeyAdmin> hot_key_admin;
+  if (conn_pool->hotKeyCollector()) {
+    hot_key_admin = context.singletonManager().getTyped<Redis::HotKeyAdmin>(
+        SINGLETON_MANAGER_REGISTERED_NAME(redis_hot_key_admin),
+        [&context] { return std::make_shared<Redis::HotKeyAdmin>(context.admin()); });
+    hot_key_admin->addCollector(filter_config->statPrefix(), conn_pool->hotKeyCollector());
+  }
+
   std::shared_ptr<Redis::CommandSplitter::Instance> splitter(
       new Redis::CommandSplitter::InstanceImpl(std::move(conn_pool), context.scope(),
                                                filter_config->statPrefix()));
-  return [splitter, filter_config](Network::FilterManager& filter_manager) -> void {
+  return [splitter, filter_config, hot_key_admin](Network::FilterManager& filter_manager) -> void {
     Redis::DecoderFactoryImpl factory;
     filter_manager.addReadFilter(std::make_shared<Redis::ProxyFilter>(
         factory, Redis::EncoderPtr{new Redis::EncoderImpl()}, *splitter, filter_config));
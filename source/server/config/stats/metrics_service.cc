@@ -0,0 +1,50 @@
+#include "server/config/stats/metrics_service.h"
+
+#include <string>
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+
+#include "common/common/utility.h"
+#include "common/config/well_known_names.h"
+#include "common/grpc/async_client_impl.h"
+#include "common/stats/metrics_service_sink.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+Stats::SinkPtr MetricsServiceSinkFactory::createStatsSink(const Protobuf::Message& config,
+                                                          Server::Instance& server) {
+  const auto& sink_config = dynamic_cast<const envoy::metrics::MetricsServiceConfig&>(config);
+  const std::string& cluster_name = sink_config.cluster_name();
+  if (!server.clusterManager().get(cluster_name)) {
+    throw EnvoyException(fmt::format("unknown metrics service cluster '{}'", cluster_name));
+  }
+
+  return Stats::SinkPtr{new Stats::MetricsService::MetricsServiceSink(
+      Stats::MetricsService::MetricsServiceAsyncClientPtr{
+          new Grpc::AsyncClientImpl<envoy::metrics::StreamMetricsMessage,
+                                    envoy::metrics::StreamMetricsResponse>(
+              server.clusterManager(), cluster_name)},
+      server.localInfo(), ProdSystemTimeSource::instance_, server.stats())};
+}
+
+ProtobufTypes::MessagePtr MetricsServiceSinkFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::metrics::MetricsServiceConfig()};
+}
+
+std::string MetricsServiceSinkFactory::name() {
+  return Config::StatsSinkNames::get().METRICS_SERVICE;
+}
+
+/**
+ * Static registration for the metrics service sink factory. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<MetricsServiceSinkFactory, StatsSinkFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -35,7 +35,7 @@ ValidationClusterManager::ValidationClusterManager(
     const LocalInfo::LocalInfo& local_info, AccessLog::AccessLogManager& log_manager,
     Event::Dispatcher& primary_dispatcher)
     : ClusterManagerImpl(bootstrap, factory, stats, tls, runtime, random, local_info, log_manager,
-                         primary_dispatcher) {}
+                         primary_dispatcher, false) {}
 
 Http::ConnectionPool::Instance*
 ValidationClusterManager::httpConnPoolForCluster(const std::string&, ResourcePriority,
@@ -48,6 +48,11 @@ Host::CreateConnectionData ValidationClusterManager::tcpConnForCluster(const std
   return Host::CreateConnectionData{nullptr, nullptr};
 }
 
+PooledTcpConnectionData
+ValidationClusterManager::pooledTcpConnForCluster(const std::string&, LoadBalancerContext*) {
+  return PooledTcpConnectionData{{nullptr, nullptr}, false};
+}
+
 Http::AsyncClient& ValidationClusterManager::httpAsyncClientForCluster(const std::string&) {
   return async_client_;
 }
@@ -38,6 +38,7 @@ public:
 
 /**
  * Config-validation-only implementation of ClusterManager, which opens no upstream connections.
+ * Since no host is ever chosen, its thread local clusters are built without load balancers.
  */
 class ValidationClusterManager : public ClusterManagerImpl {
 public:
@@ -50,6 +51,8 @@ public:
   Http::ConnectionPool::Instance* httpConnPoolForCluster(const std::string&, ResourcePriority,
                                                          LoadBalancerContext*) override;
   Host::CreateConnectionData tcpConnForCluster(const std::string&, LoadBalancerContext*) override;
+  PooledTcpConnectionData pooledTcpConnForCluster(const std::string&,
+                                                  LoadBalancerContext*) override;
   Http::AsyncClient& httpAsyncClientForCluster(const std::string&) override;
 
 private:
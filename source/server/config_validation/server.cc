@@ -87,6 +87,9 @@ void ValidationInstance::initialize(Options& options,
   thread_local_.registerThread(*dispatcher_, true);
   runtime_loader_ = component_factory.createRuntime(*this, initial_config);
   ssl_context_manager_.reset(new Ssl::ContextManagerImpl(*runtime_loader_));
+  overload_manager_.reset(new OverloadManagerImpl(*dispatcher_, *runtime_loader_, stats_store_,
+                                                  listener_manager_,
+                                                  ProdMonotonicTimeSource::instance_));
   cluster_manager_factory_.reset(new Upstream::ValidationClusterManagerFactory(
       runtime(), stats(), threadLocal(), random(), dnsResolver(), sslContextManager(), dispatcher(),
       localInfo()));
@@ -22,6 +22,7 @@
 #include "server/config_validation/dns.h"
 #include "server/http/admin.h"
 #include "server/listener_manager_impl.h"
+#include "server/overload_manager_impl.h"
 #include "server/server.h"
 
 namespace Envoy {
@@ -81,6 +82,7 @@ public:
   Singleton::Manager& singletonManager() override { return *singleton_manager_; }
   bool healthCheckFailed() override { NOT_IMPLEMENTED; }
   Options& options() override { return options_; }
+  OverloadManager& overloadManager() override { return *overload_manager_; }
   time_t startTimeCurrentEpoch() override { NOT_IMPLEMENTED; }
   time_t startTimeFirstEpoch() override { NOT_IMPLEMENTED; }
   Stats::Store& stats() override { return stats_store_; }
@@ -100,6 +102,10 @@ public:
     // validation mock.
     return nullptr;
   }
+  Network::ListenSocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr, uint32_t) override {
+    return nullptr;
+  }
   DrainManagerPtr createDrainManager() override { return nullptr; }
   uint64_t nextListenerTag() override { return 0; }
 
@@ -132,6 +138,8 @@ private:
   std::unique_ptr<Upstream::ValidationClusterManagerFactory> cluster_manager_factory_;
   InitManagerImpl init_manager_;
   ListenerManagerImpl listener_manager_;
+  // Never started, so that no action is ever in effect.
+  std::unique_ptr<OverloadManagerImpl> overload_manager_;
 };
 
 } // namespace Server
@@ -11,12 +11,24 @@ namespace Server {
 ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher)
     : logger_(logger), dispatcher_(dispatcher) {}
 
+ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                                             Stats::Gauge& connections)
+    : logger_(logger), dispatcher_(dispatcher), connections_gauge_(&connections) {}
+
+ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                                             const WorkerStats& stats)
+    : logger_(logger), dispatcher_(dispatcher), connections_gauge_(&stats.downstream_cx_active_),
+      worker_stats_(new WorkerStats(stats)) {}
+
 void ConnectionHandlerImpl::addListener(Network::FilterChainFactory& factory,
                                         Network::ListenSocket& socket, Stats::Scope& scope,
                                         uint64_t listener_tag,
                                         const Network::ListenerOptions& listener_options) {
   ActiveListenerPtr l(
       new ActiveListener(*this, socket, factory, scope, listener_tag, listener_options));
+  if (listeners_disabled_) {
+    l->listener_->disable();
+  }
   listeners_.emplace_back(socket.localAddress(), std::move(l));
 }
 
@@ -27,6 +39,9 @@ void ConnectionHandlerImpl::addSslListener(Network::FilterChainFactory& factory,
                                            const Network::ListenerOptions& listener_options) {
   ActiveListenerPtr l(new SslActiveListener(*this, ssl_ctx, socket, factory, scope, listener_tag,
                                             listener_options));
+  if (listeners_disabled_) {
+    l->listener_->disable();
+  }
   listeners_.emplace_back(socket.localAddress(), std::move(l));
 }
 
@@ -54,6 +69,24 @@ void ConnectionHandlerImpl::stopListeners() {
   }
 }
 
+void ConnectionHandlerImpl::disableListeners() {
+  listeners_disabled_ = true;
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_) {
+      listener.second->listener_->disable();
+    }
+  }
+}
+
+void ConnectionHandlerImpl::enableListeners() {
+  listeners_disabled_ = false;
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_) {
+      listener.second->listener_->enable();
+    }
+  }
+}
+
 void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& connection) {
   ENVOY_CONN_LOG_TO_LOGGER(parent_.logger_, info, "adding to cleanup list",
                            *connection.connection_);
@@ -61,6 +94,9 @@ void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& c
   parent_.dispatcher_.deferredDelete(std::move(removed));
   ASSERT(parent_.num_connections_ > 0);
   parent_.num_connections_--;
+  if (parent_.connections_gauge_ != nullptr) {
+    parent_.connections_gauge_->dec();
+  }
 }
 
 ConnectionHandlerImpl::ActiveListener::ActiveListener(
@@ -127,6 +163,14 @@ ConnectionHandlerImpl::findListenerByAddress(const Network::Address::Instance& a
 void ConnectionHandlerImpl::ActiveListener::onNewConnection(
     Network::ConnectionPtr&& new_connection) {
   ENVOY_CONN_LOG_TO_LOGGER(parent_.logger_, info, "new connection", *new_connection);
+  // The worker stats are set before the filters, so that the filters can find them.
+  const WorkerStats* worker_stats = parent_.worker_stats_.get();
+  if (worker_stats != nullptr) {
+    worker_stats->downstream_cx_total_.inc();
+    new_connection->setWorkerStats({worker_stats->downstream_cx_rx_bytes_total_,
+                                    worker_stats->downstream_cx_tx_bytes_total_,
+                                    worker_stats->downstream_rq_active_});
+  }
   bool empty_filter_chain = !factory_.createFilterChain(*new_connection);
 
   // If the connection is already closed, we can just let this connection immediately die.
@@ -141,6 +185,9 @@ void ConnectionHandlerImpl::ActiveListener::onNewConnection(
       ActiveConnectionPtr active_connection(new ActiveConnection(*this, std::move(new_connection)));
       active_connection->moveIntoList(std::move(active_connection), connections_);
       parent_.num_connections_++;
+      if (parent_.connections_gauge_ != nullptr) {
+        parent_.connections_gauge_->inc();
+      }
     }
   }
 }
@@ -153,6 +200,9 @@ ConnectionHandlerImpl::ActiveConnection::ActiveConnection(ActiveListener& listen
   // to make this configurable.
   connection_->noDelay(true);
   connection_->addConnectionCallbacks(*this);
+  if (listener_.parent_.idle_memory_release_.count() > 0) {
+    connection_->enableIdleMemoryRelease(listener_.parent_.idle_memory_release_);
+  }
   listener_.stats_.downstream_cx_total_.inc();
   listener_.stats_.downstream_cx_active_.inc();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
@@ -12,6 +13,8 @@
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/network/listener.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/stats/timespan.h"
 
 #include "common/common/linked_object.h"
@@ -37,6 +40,22 @@ struct ListenerStats {
   ALL_LISTENER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
+// clang-format off
+#define ALL_WORKER_STATS(COUNTER, GAUGE)                                                           \
+  COUNTER(downstream_cx_total)                                                                     \
+  GAUGE  (downstream_cx_active)                                                                    \
+  COUNTER(downstream_cx_rx_bytes_total)                                                            \
+  COUNTER(downstream_cx_tx_bytes_total)                                                            \
+  GAUGE  (downstream_rq_active)
+// clang-format on
+
+/**
+ * Wrapper struct for the stats of a worker, over all its listeners. @see stats_macros.h
+ */
+struct WorkerStats {
+  ALL_WORKER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
 /**
  * Server side connection handler. This is used both by workers as well as the
  * main thread for non-threaded listeners.
@@ -45,6 +64,26 @@ class ConnectionHandlerImpl : public Network::ConnectionHandler, NonCopyable {
 public:
   ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher);
 
+  /**
+   * @param connections supplies a gauge which the handler keeps at the number of connections it
+   *        owns, such as the gauge of the worker it belongs to.
+   */
+  ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                        Stats::Gauge& connections);
+
+  /**
+   * @param stats supplies the stats of the worker the handler belongs to, which it keeps for the
+   *        connections it owns.
+   */
+  ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                        const WorkerStats& stats);
+
+  /**
+   * Make the connections accepted from now on release their memory whenever they have been idle
+   * for the supplied period. @see Network::Connection::enableIdleMemoryRelease().
+   */
+  void setIdleMemoryRelease(std::chrono::milliseconds period) { idle_memory_release_ = period; }
+
   // Network::ConnectionHandler
   uint64_t numConnections() override { return num_connections_; }
   void addListener(Network::FilterChainFactory& factory, Network::ListenSocket& socket,
@@ -57,6 +96,8 @@ public:
   void removeListeners(uint64_t listener_tag) override;
   void stopListeners(uint64_t listener_tag) override;
   void stopListeners() override;
+  void disableListeners() override;
+  void enableListeners() override;
 
 private:
   struct ActiveConnection;
@@ -136,6 +177,10 @@ private:
   Event::Dispatcher& dispatcher_;
   std::list<std::pair<Network::Address::InstanceConstSharedPtr, ActiveListenerPtr>> listeners_;
   std::atomic<uint64_t> num_connections_{};
+  Stats::Gauge* connections_gauge_{};
+  std::unique_ptr<WorkerStats> worker_stats_;
+  std::chrono::milliseconds idle_memory_release_{};
+  bool listeners_disabled_{};
 };
 
 } // Server
@@ -1,5 +1,6 @@
 #include "server/drain_manager_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -14,7 +15,8 @@
 namespace Envoy {
 namespace Server {
 
-DrainManagerImpl::DrainManagerImpl(Instance& server) : server_(server) {}
+DrainManagerImpl::DrainManagerImpl(Instance& server, MonotonicTimeSource& time_source)
+    : server_(server), time_source_(time_source) {}
 
 bool DrainManagerImpl::drainClose() const {
   // If we are actively HC failed, always drain close.
@@ -27,13 +29,40 @@ bool DrainManagerImpl::drainClose() const {
     return true;
   }
 
+  // While the server is overloaded, connections are closed rather than kept alive so that their
+  // resources are released.
+  if (server_.overloadManager().disableKeepalive()) {
+    return true;
+  }
+
   if (!draining()) {
     return false;
   }
 
   // We use the tick time as in increasing chance that we shutdown connections.
   return static_cast<uint64_t>(drain_time_completed_.load()) >
-         (server_.random().random() % server_.options().drainTime().count());
+             (server_.random().random() % server_.options().drainTime().count()) &&
+         drainRateAllows();
+}
+
+bool DrainManagerImpl::drainRateAllows() const {
+  const uint64_t rate = server_.options().drainRate();
+  if (rate == 0) {
+    return true;
+  }
+
+  // The workers share the budget of the current second. Connections which are not closed now are
+  // considered again on their next response, so they are spread over the following seconds.
+  const uint64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+                              time_source_.currentTime().time_since_epoch())
+                              .count();
+  uint64_t current_second = drain_rate_second_.load();
+  if (current_second != second &&
+      drain_rate_second_.compare_exchange_strong(current_second, second)) {
+    drain_rate_closes_ = 0;
+  }
+
+  return drain_rate_closes_++ < rate * std::max<uint64_t>(server_.options().concurrency(), 1);
 }
 
 void DrainManagerImpl::drainSequenceTick() {
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 
+#include "envoy/common/time.h"
 #include "envoy/server/drain_manager.h"
 #include "envoy/server/instance.h"
 
@@ -16,10 +19,12 @@ namespace Server {
  * 1) Terminates the parent process after 15 minutes.
  * 2) Drains the parent process over a period of 10 minutes where drain close becomes more
  *    likely each second that passes.
+ * 3) Optionally caps the number of drain closes per second, so that the clients of the drained
+ *    connections do not all reconnect at once. @see Options::drainRate().
  */
 class DrainManagerImpl : Logger::Loggable<Logger::Id::main>, public DrainManager {
 public:
-  DrainManagerImpl(Instance& server);
+  DrainManagerImpl(Instance& server, MonotonicTimeSource& time_source);
 
   // Server::DrainManager
   bool drainClose() const override;
@@ -28,9 +33,14 @@ public:
 
 private:
   bool draining() const { return drain_tick_timer_ != nullptr; }
+  bool drainRateAllows() const;
   void drainSequenceTick();
 
   Instance& server_;
+  MonotonicTimeSource& time_source_;
+  // The second, and the number of drain closes in it, counted over all the workers.
+  mutable std::atomic<uint64_t> drain_rate_second_{};
+  mutable std::atomic<uint64_t> drain_rate_closes_{};
   Event::TimerPtr drain_tick_timer_;
   std::atomic<uint32_t> drain_time_completed_{};
   Event::TimerPtr parent_shutdown_timer_;
@@ -4,8 +4,12 @@
 #include <sys/prctl.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "envoy/event/dispatcher.h"
@@ -13,6 +17,7 @@
 #include "envoy/server/instance.h"
 #include "envoy/server/options.h"
 
+#include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/network/utility.h"
 
@@ -23,11 +28,31 @@ namespace Server {
 
 // Increment this whenever there is a shared memory / RPC change that will prevent a hot restart
 // from working. Operations code can then cope with this and do a full restart.
-const uint64_t SharedMemory::VERSION = 9;
+const uint64_t SharedMemory::VERSION = 12;
+
+const uint32_t SharedMemory::EMPTY;
+const uint32_t SharedMemory::DELETED;
+const uint32_t SharedMemory::FIRST_SLOT;
+
+const uint32_t HotRestartImpl::MAX_SOCKETS_PER_REPLY;
+
+uint64_t SharedMemory::indexSize(uint64_t num_stats) {
+  uint64_t index_size = 1;
+  while (index_size < num_stats * 2) {
+    index_size *= 2;
+  }
+
+  return index_size;
+}
+
+uint64_t SharedMemory::totalSize(uint64_t num_stats, uint64_t entry_size) {
+  return sizeof(SharedMemory) + (entry_size * num_stats) +
+         (sizeof(uint32_t) * (indexSize(num_stats) + num_stats));
+}
 
 SharedMemory& SharedMemory::initialize(Options& options, Api::OsSysCalls& os_sys_calls) {
   const uint64_t entry_size = Stats::RawStatData::size();
-  const uint64_t total_size = sizeof(SharedMemory) + (entry_size * options.maxStats());
+  const uint64_t total_size = totalSize(options.maxStats(), entry_size);
 
   int flags = O_RDWR;
   const std::string shmem_name = fmt::format("/envoy_shared_memory_{}", options.baseId());
@@ -60,6 +85,12 @@ SharedMemory& SharedMemory::initialize(Options& options, Api::OsSysCalls& os_sys
     shmem->version_ = VERSION;
     shmem->num_stats_ = options.maxStats();
     shmem->entry_size_ = entry_size;
+    // The index starts out with every bucket EMPTY, as the segment is zero filled.
+    shmem->index_size_ = indexSize(options.maxStats());
+    shmem->num_free_slots_ = options.maxStats();
+    for (uint64_t i = 0; i < shmem->num_free_slots_; i++) {
+      shmem->freeSlots()[i] = shmem->num_free_slots_ - 1 - i;
+    }
     shmem->initializeMutex(shmem->log_lock_);
     shmem->initializeMutex(shmem->access_log_lock_);
     shmem->initializeMutex(shmem->stat_lock_);
@@ -124,27 +155,48 @@ HotRestartImpl::HotRestartImpl(Options& options, Api::OsSysCalls& os_sys_calls)
   UNREFERENCED_PARAMETER(rc);
 }
 
+uint64_t HotRestartImpl::firstBucket(const char* name, size_t length) {
+  return HashUtil::xxHash64(name, std::min(length, Stats::RawStatData::maxNameLength())) &
+         (shmem_.index_size_ - 1);
+}
+
 Stats::RawStatData* HotRestartImpl::alloc(const std::string& name) {
-  // Try to find the existing slot in shared memory, otherwise allocate a new one.
-  Stats::RawStatData* unused = nullptr;
+  // Try to find the existing slot in shared memory, otherwise allocate a new one. The index is
+  // probed linearly from the bucket of the name up to the first EMPTY bucket.
   std::unique_lock<Thread::BasicLockable> lock(stat_lock_);
-  for (uint64_t i = 0; i < shmem_.num_stats_; i++) {
-    const size_t offset = shmem_.entry_size_ * i;
-    Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(shmem_.stats_slots_ + offset);
-    if (!data->initialized()) {
-      unused = data;
-    } else if (data->matches(name)) {
-      data->ref_count_++;
-      return data;
+  uint32_t* index = shmem_.index();
+  const uint64_t mask = shmem_.index_size_ - 1;
+  uint64_t bucket = firstBucket(name.c_str(), name.size());
+  uint32_t* unused_bucket = nullptr;
+  for (uint64_t i = 0; i < shmem_.index_size_; i++, bucket = (bucket + 1) & mask) {
+    if (index[bucket] == SharedMemory::EMPTY || index[bucket] == SharedMemory::DELETED) {
+      if (unused_bucket == nullptr) {
+        unused_bucket = &index[bucket];
+      }
+      if (index[bucket] == SharedMemory::EMPTY) {
+        break;
+      }
+      continue;
+    }
+
+    Stats::RawStatData& data = shmem_.slot(index[bucket] - SharedMemory::FIRST_SLOT);
+    if (data.matches(name)) {
+      data.ref_count_++;
+      return &data;
     }
   }
 
-  if (unused != nullptr) {
-    unused->initialize(name);
-    return unused;
+  if (shmem_.num_free_slots_ == 0) {
+    return nullptr;
   }
 
-  return nullptr;
+  // The index is never more than half full, so there is always a bucket left.
+  ASSERT(unused_bucket != nullptr);
+  const uint32_t slot = shmem_.freeSlots()[--shmem_.num_free_slots_];
+  *unused_bucket = slot + SharedMemory::FIRST_SLOT;
+  Stats::RawStatData& data = shmem_.slot(slot);
+  data.initialize(name);
+  return &data;
 }
 
 void HotRestartImpl::free(Stats::RawStatData& data) {
@@ -155,6 +207,30 @@ void HotRestartImpl::free(Stats::RawStatData& data) {
     return;
   }
 
+  const uint32_t slot = (reinterpret_cast<uint8_t*>(&data) - shmem_.stats_slots_) /
+                        shmem_.entry_size_;
+  uint32_t* index = shmem_.index();
+  const uint64_t mask = shmem_.index_size_ - 1;
+  uint64_t bucket = firstBucket(data.name_, strlen(data.name_));
+  while (index[bucket] != slot + SharedMemory::FIRST_SLOT) {
+    ASSERT(index[bucket] != SharedMemory::EMPTY);
+    bucket = (bucket + 1) & mask;
+  }
+
+  // A bucket followed by an EMPTY one does not need to be kept DELETED, and neither do the DELETED
+  // buckets just before it. This keeps lookups short when stats come and go.
+  if (index[(bucket + 1) & mask] == SharedMemory::EMPTY) {
+    index[bucket] = SharedMemory::EMPTY;
+    bucket = (bucket - 1) & mask;
+    while (index[bucket] == SharedMemory::DELETED) {
+      index[bucket] = SharedMemory::EMPTY;
+      bucket = (bucket - 1) & mask;
+    }
+  } else {
+    index[bucket] = SharedMemory::DELETED;
+  }
+
+  shmem_.freeSlots()[shmem_.num_free_slots_++] = slot;
   memset(&data, 0, Stats::RawStatData::size());
 }
 
@@ -204,18 +280,77 @@ void HotRestartImpl::drainParentListeners() {
   shmem_.flags_ &= ~SharedMemory::Flags::INITIALIZING;
 }
 
-int HotRestartImpl::duplicateParentListenSocket(const std::string& address) {
+int HotRestartImpl::duplicateParentListenSocket(const std::string& address,
+                                                uint32_t worker_index) {
   if (options_.restartEpoch() == 0 || parent_terminated_) {
     return -1;
   }
 
-  RpcGetListenSocketRequest rpc;
-  ASSERT(address.length() < sizeof(rpc.address_));
-  StringUtil::strlcpy(rpc.address_, address.c_str(), sizeof(rpc.address_));
-  sendMessage(parent_address_, rpc);
-  RpcGetListenSocketReply* reply =
-      receiveTypedRpc<RpcGetListenSocketReply, RpcMessageType::GetListenSocketReply>();
-  return reply->fd_;
+  // All the sockets of the parent are fetched on the first call, rather than one exchange with
+  // the parent per listener and worker.
+  if (!parent_listen_sockets_fetched_) {
+    getParentListenSockets();
+  }
+
+  auto sockets = parent_listen_sockets_.find(Network::Utility::resolveUrl(address)->asString());
+  if (sockets == parent_listen_sockets_.end()) {
+    return -1;
+  }
+
+  // Like Listener::workerSocket(), indexes past the number of sockets of the parent wrap around.
+  // The fetched sockets are kept until the parent is terminated, so each caller gets its own fd.
+  return dup(sockets->second[worker_index % sockets->second.size()]);
+}
+
+void HotRestartImpl::getParentListenSockets() {
+  parent_listen_sockets_fetched_ = true;
+  const MonotonicTime start_time = ProdMonotonicTimeSource::instance_.currentTime();
+  RpcGetListenSocketsRequest rpc;
+  uint32_t num_sockets = 0;
+  bool more = true;
+  while (more) {
+    // Each reply is requested on its own, as the domain socket only queues a few datagrams.
+    rpc.first_socket_ = num_sockets;
+    sendMessage(parent_address_, rpc);
+    RpcGetListenSocketsReply* reply =
+        receiveTypedRpc<RpcGetListenSocketsReply, RpcMessageType::GetListenSocketsReply>();
+    RELEASE_ASSERT(reply->num_sockets_ <= MAX_SOCKETS_PER_REPLY);
+
+    const uint8_t* entry = reply->sockets_;
+    for (uint32_t i = 0; i < reply->num_sockets_; i++) {
+      uint32_t worker_index;
+      uint16_t length;
+      memcpy(&worker_index, entry, sizeof(worker_index));
+      memcpy(&length, entry + sizeof(worker_index), sizeof(length));
+      entry += sizeof(worker_index) + sizeof(length);
+      RELEASE_ASSERT(entry + length <= reply->sockets_ + sizeof(reply->sockets_));
+      std::vector<int>& sockets =
+          parent_listen_sockets_[std::string(reinterpret_cast<const char*>(entry), length)];
+      entry += length;
+      RELEASE_ASSERT(worker_index == sockets.size());
+      int fd;
+      memcpy(&fd, reply->fds_ + sizeof(int) * i, sizeof(int));
+      sockets.push_back(fd);
+    }
+
+    num_sockets += reply->num_sockets_;
+    more = reply->more_ != 0;
+  }
+
+  ENVOY_LOG(info, "obtained {} listen sockets from parent in {}ms", num_sockets,
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                ProdMonotonicTimeSource::instance_.currentTime() - start_time)
+                .count());
+}
+
+void HotRestartImpl::closeParentListenSockets() {
+  for (const auto& sockets : parent_listen_sockets_) {
+    for (int fd : sockets.second) {
+      close(fd);
+    }
+  }
+
+  parent_listen_sockets_.clear();
 }
 
 void HotRestartImpl::getParentStats(GetParentStatsInfo& info) {
@@ -274,16 +409,16 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
   iov[0].iov_base = &rpc_buffer_[0];
   iov[0].iov_len = rpc_buffer_.size();
 
-  // We always setup to receive an FD even though most messages do not pass one.
-  uint8_t control_buffer[CMSG_SPACE(sizeof(int))];
-  memset(control_buffer, 0, CMSG_SPACE(sizeof(int)));
+  // We always setup to receive FDs even though most messages do not pass any.
+  uint8_t control_buffer[CMSG_SPACE(sizeof(int) * MAX_SOCKETS_PER_REPLY)];
+  memset(control_buffer, 0, sizeof(control_buffer));
 
   msghdr message;
   memset(&message, 0, sizeof(message));
   message.msg_iov = iov;
   message.msg_iovlen = 1;
   message.msg_control = control_buffer;
-  message.msg_controllen = CMSG_SPACE(sizeof(int));
+  message.msg_controllen = sizeof(control_buffer);
 
   int rc = recvmsg(my_domain_socket_, &message, 0);
   if (!block && rc == -1 && errno == EAGAIN) {
@@ -303,17 +438,18 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
   RpcBase* rpc = reinterpret_cast<RpcBase*>(&rpc_buffer_[0]);
   RELEASE_ASSERT(static_cast<uint64_t>(rc) == rpc->length_);
 
-  // We should only get control data in a GetListenSocketReply. If that's the case, pull the
-  // cloned fd out of the control data and stick it into the RPC so that higher level code does
+  // We should only get control data in a GetListenSocketsReply. If that's the case, pull the
+  // cloned fds out of the control data and stick them into the RPC so that higher level code does
   // need to deal with any of this.
   for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
        cmsg = CMSG_NXTHDR(&message, cmsg)) {
 
     if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
-        rpc->type_ == RpcMessageType::GetListenSocketReply) {
+        rpc->type_ == RpcMessageType::GetListenSocketsReply) {
 
-      reinterpret_cast<RpcGetListenSocketReply*>(rpc)->fd_ =
-          *reinterpret_cast<int*>(CMSG_DATA(cmsg));
+      RpcGetListenSocketsReply* reply = reinterpret_cast<RpcGetListenSocketsReply*>(rpc);
+      RELEASE_ASSERT(cmsg->cmsg_len == CMSG_LEN(sizeof(int) * reply->num_sockets_));
+      memcpy(reply->fds_, CMSG_DATA(cmsg), sizeof(int) * reply->num_sockets_);
     } else {
       RELEASE_ASSERT(false);
     }
@@ -338,49 +474,86 @@ void HotRestartImpl::sendMessage(sockaddr_un& address, RpcBase& rpc) {
   UNREFERENCED_PARAMETER(rc);
 }
 
-void HotRestartImpl::onGetListenSocket(RpcGetListenSocketRequest& rpc) {
-  RpcGetListenSocketReply reply;
-  reply.fd_ = -1;
-
-  Network::Address::InstanceConstSharedPtr addr =
-      Network::Utility::resolveUrl(std::string(rpc.address_));
+void HotRestartImpl::onGetListenSockets(RpcGetListenSocketsRequest& rpc) {
+  // Collect the distinct sockets of every listener, in order of listener and worker. Worker
+  // sockets wrap around, so those of a listener end where the first one comes up again.
+  std::vector<std::pair<std::string, int>> sockets;
   for (const auto& listener : server_->listenerManager().listeners()) {
-    if (*listener.get().socket().localAddress() == *addr) {
-      reply.fd_ = listener.get().socket().fd();
+    const std::string address = listener.get().socket().localAddress()->asString();
+    const int first_fd = listener.get().workerSocket(0).fd();
+    if (first_fd == -1) {
+      continue;
+    }
+
+    sockets.emplace_back(address, first_fd);
+    for (uint32_t worker_index = 1;; worker_index++) {
+      const int fd = listener.get().workerSocket(worker_index).fd();
+      if (fd == first_fd) {
+        break;
+      }
+      sockets.emplace_back(address, fd);
+    }
+  }
+
+  // Pack as many sockets as fit into the reply, with the worker index of each.
+  RpcGetListenSocketsReply reply;
+  uint8_t* entry = reply.sockets_;
+  uint32_t worker_index = 0;
+  uint32_t i;
+  for (i = 0; i < sockets.size(); i++) {
+    worker_index = (i > 0 && sockets[i].first == sockets[i - 1].first) ? worker_index + 1 : 0;
+    if (i < rpc.first_socket_) {
+      continue;
+    }
+
+    const std::string& address = sockets[i].first;
+    const uint16_t length = address.size();
+    if (reply.num_sockets_ == MAX_SOCKETS_PER_REPLY ||
+        entry + sizeof(worker_index) + sizeof(length) + length >
+            reply.sockets_ + sizeof(reply.sockets_)) {
       break;
     }
+
+    memcpy(entry, &worker_index, sizeof(worker_index));
+    memcpy(entry + sizeof(worker_index), &length, sizeof(length));
+    memcpy(entry + sizeof(worker_index) + sizeof(length), address.c_str(), length);
+    entry += sizeof(worker_index) + sizeof(length) + length;
+    memcpy(reply.fds_ + sizeof(int) * reply.num_sockets_, &sockets[i].second, sizeof(int));
+    reply.num_sockets_++;
   }
+  reply.more_ = i < sockets.size();
 
-  if (reply.fd_ == -1) {
+  if (reply.num_sockets_ == 0) {
     // In this case there is no fd to duplicate so we just send a normal message.
     sendMessage(child_address_, reply);
-  } else {
-    iovec iov[1];
-    iov[0].iov_base = &reply;
-    iov[0].iov_len = reply.length_;
-
-    uint8_t control_buffer[CMSG_SPACE(sizeof(int))];
-    memset(control_buffer, 0, CMSG_SPACE(sizeof(int)));
-
-    msghdr message;
-    memset(&message, 0, sizeof(message));
-    message.msg_name = &child_address_;
-    message.msg_namelen = sizeof(child_address_);
-    message.msg_iov = iov;
-    message.msg_iovlen = 1;
-    message.msg_control = control_buffer;
-    message.msg_controllen = CMSG_SPACE(sizeof(int));
-
-    cmsghdr* control_message = CMSG_FIRSTHDR(&message);
-    control_message->cmsg_level = SOL_SOCKET;
-    control_message->cmsg_type = SCM_RIGHTS;
-    control_message->cmsg_len = CMSG_LEN(sizeof(int));
-    *reinterpret_cast<int*>(CMSG_DATA(control_message)) = reply.fd_;
-
-    int rc = sendmsg(my_domain_socket_, &message, 0);
-    RELEASE_ASSERT(rc != -1);
-    UNREFERENCED_PARAMETER(rc);
+    return;
   }
+
+  iovec iov[1];
+  iov[0].iov_base = &reply;
+  iov[0].iov_len = reply.length_;
+
+  uint8_t control_buffer[CMSG_SPACE(sizeof(int) * MAX_SOCKETS_PER_REPLY)];
+  memset(control_buffer, 0, sizeof(control_buffer));
+
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_name = &child_address_;
+  message.msg_namelen = sizeof(child_address_);
+  message.msg_iov = iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control_buffer;
+  message.msg_controllen = CMSG_SPACE(sizeof(int) * reply.num_sockets_);
+
+  cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+  control_message->cmsg_level = SOL_SOCKET;
+  control_message->cmsg_type = SCM_RIGHTS;
+  control_message->cmsg_len = CMSG_LEN(sizeof(int) * reply.num_sockets_);
+  memcpy(CMSG_DATA(control_message), reply.fds_, sizeof(int) * reply.num_sockets_);
+
+  int rc = sendmsg(my_domain_socket_, &message, 0);
+  RELEASE_ASSERT(rc != -1);
+  UNREFERENCED_PARAMETER(rc);
 }
 
 void HotRestartImpl::onSocketEvent() {
@@ -399,10 +572,10 @@ void HotRestartImpl::onSocketEvent() {
       break;
     }
 
-    case RpcMessageType::GetListenSocketRequest: {
-      RpcGetListenSocketRequest* message =
-          reinterpret_cast<RpcGetListenSocketRequest*>(base_message);
-      onGetListenSocket(*message);
+    case RpcMessageType::GetListenSocketsRequest: {
+      RpcGetListenSocketsRequest* message =
+          reinterpret_cast<RpcGetListenSocketsRequest*>(base_message);
+      onGetListenSockets(*message);
       break;
     }
 
@@ -458,9 +631,13 @@ void HotRestartImpl::terminateParent() {
   RpcBase rpc(RpcMessageType::TerminateRequest);
   sendMessage(parent_address_, rpc);
   parent_terminated_ = true;
+  closeParentListenSockets();
 }
 
-void HotRestartImpl::shutdown() { socket_event_.reset(); }
+void HotRestartImpl::shutdown() {
+  socket_event_.reset();
+  closeParentListenSockets();
+}
 
 std::string HotRestartImpl::version() { return shmem_.version(); }
 
@@ -7,6 +7,8 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/server/hot_restart.h"
@@ -20,7 +22,9 @@ namespace Server {
 
 /**
  * Shared memory segment. This structure is laid directly into shared memory and is used amongst
- * all running envoy processes.
+ * all running envoy processes. The stat slots are followed by a hash index from stat names to
+ * slots, and by a stack of the unused slots, so that allocating a stat does not need to scan all
+ * the slots.
  */
 class SharedMemory {
 public:
@@ -33,6 +37,13 @@ private:
     static const uint64_t INITIALIZING = 0x1;
   };
 
+  // Values of the index buckets other than a slot, which is stored as slot + FIRST_SLOT. A bucket
+  // of a freed stat is DELETED, rather than EMPTY, while later buckets may hold stats which had
+  // collided with it.
+  static const uint32_t EMPTY = 0;
+  static const uint32_t DELETED = 1;
+  static const uint32_t FIRST_SLOT = 2;
+
   // Due to the flexible-array-length of stats_slots_, c-style allocation
   // and initialization are neccessary.
   SharedMemory() = delete;
@@ -49,12 +60,31 @@ private:
    */
   void initializeMutex(pthread_mutex_t& mutex);
 
+  /**
+   * @return the number of index buckets for a number of stats, a power of 2 which keeps the index
+   *         at most half full.
+   */
+  static uint64_t indexSize(uint64_t num_stats);
+
+  /**
+   * @return the size of the segment for a number of stats of a given size.
+   */
+  static uint64_t totalSize(uint64_t num_stats, uint64_t entry_size);
+
+  Stats::RawStatData& slot(uint64_t index) {
+    return *reinterpret_cast<Stats::RawStatData*>(stats_slots_ + entry_size_ * index);
+  }
+  uint32_t* index() { return reinterpret_cast<uint32_t*>(stats_slots_ + entry_size_ * num_stats_); }
+  uint32_t* freeSlots() { return index() + index_size_; }
+
   static const uint64_t VERSION;
 
   uint64_t size_;
   uint64_t version_;
   uint64_t num_stats_;
   uint64_t entry_size_;
+  uint64_t index_size_;
+  uint64_t num_free_slots_;
   std::atomic<uint64_t> flags_;
   pthread_mutex_t log_lock_;
   pthread_mutex_t access_log_lock_;
@@ -123,7 +153,7 @@ public:
 
   // Server::HotRestart
   void drainParentListeners() override;
-  int duplicateParentListenSocket(const std::string& address) override;
+  int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) override;
   void getParentStats(GetParentStatsInfo& info) override;
   void initialize(Event::Dispatcher& dispatcher, Server::Instance& server) override;
   void shutdownParentAdmin(ShutdownParentAdminInfo& info) override;
@@ -136,10 +166,16 @@ public:
   void free(Stats::RawStatData& data) override;
 
 private:
+  /**
+   * @return the index bucket at which to start looking for a stat name, truncated like the names
+   *         of the stats.
+   */
+  uint64_t firstBucket(const char* name, size_t length);
+
   enum class RpcMessageType {
     DrainListenersRequest = 1,
-    GetListenSocketRequest = 2,
-    GetListenSocketReply = 3,
+    GetListenSocketsRequest = 2,
+    GetListenSocketsReply = 3,
     ShutdownAdminRequest = 4,
     ShutdownAdminReply = 5,
     TerminateRequest = 6,
@@ -156,16 +192,27 @@ private:
     uint64_t length_;
   } __attribute__((packed));
 
-  struct RpcGetListenSocketRequest : public RpcBase {
-    RpcGetListenSocketRequest() : RpcBase(RpcMessageType::GetListenSocketRequest, sizeof(*this)) {}
+  // The most sockets passed by one GetListenSocketsReply.
+  static const uint32_t MAX_SOCKETS_PER_REPLY = 64;
 
-    char address_[256]{0};
-  } __attribute__((packed));
+  struct RpcGetListenSocketsRequest : public RpcBase {
+    RpcGetListenSocketsRequest()
+        : RpcBase(RpcMessageType::GetListenSocketsRequest, sizeof(*this)) {}
 
-  struct RpcGetListenSocketReply : public RpcBase {
-    RpcGetListenSocketReply() : RpcBase(RpcMessageType::GetListenSocketReply, sizeof(*this)) {}
+    uint32_t first_socket_{0};
+  } __attribute__((packed));
 
-    int fd_{0};
+  struct RpcGetListenSocketsReply : public RpcBase {
+    RpcGetListenSocketsReply() : RpcBase(RpcMessageType::GetListenSocketsReply, sizeof(*this)) {}
+
+    uint8_t more_{0};
+    uint32_t num_sockets_{0};
+    // num_sockets_ entries, each a uint32_t worker index, followed by a uint16_t address length and
+    // the address.
+    uint8_t sockets_[3072]{0};
+    // The fds of the entries, filled in from the control data by receiveRpc(). These are bytes
+    // rather than ints, which would not be aligned.
+    uint8_t fds_[sizeof(int) * MAX_SOCKETS_PER_REPLY]{0};
   } __attribute__((packed));
 
   struct RpcShutdownAdminReply : public RpcBase {
@@ -192,7 +239,9 @@ private:
   int bindDomainSocket(uint64_t id, Api::OsSysCalls& os_sys_calls);
   void initDomainSocketAddress(sockaddr_un* address);
   sockaddr_un createDomainSocketAddress(uint64_t id);
-  void onGetListenSocket(RpcGetListenSocketRequest& rpc);
+  void closeParentListenSockets();
+  void getParentListenSockets();
+  void onGetListenSockets(RpcGetListenSocketsRequest& rpc);
   void onSocketEvent();
   RpcBase* receiveRpc(bool block);
   void sendMessage(sockaddr_un& address, RpcBase& rpc);
@@ -210,6 +259,9 @@ private:
   std::array<uint8_t, 4096> rpc_buffer_;
   Server::Instance* server_{};
   bool parent_terminated_{};
+  bool parent_listen_sockets_fetched_{};
+  // The sockets of the parent by address, each with the sockets of its workers in order.
+  std::unordered_map<std::string, std::vector<int>> parent_listen_sockets_;
 };
 
 } // namespace Server
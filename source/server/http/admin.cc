@@ -1,9 +1,15 @@
 #include "server/http/admin.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstdint>
 #include <fstream>
+#include <list>
+#include <map>
 #include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "envoy/filesystem/filesystem.h"
 #include "envoy/server/hot_restart.h"
@@ -25,6 +31,7 @@
 #include "common/http/headers.h"
 #include "common/http/http1/codec_impl.h"
 #include "common/json/json_loader.h"
+#include "common/memory/stats.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/profiler/profiler.h"
 #include "common/router/config_impl.h"
@@ -40,6 +47,7 @@
 #include "rapidjson/schema.h"
 #include "rapidjson/stream.h"
 #include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 #include "spdlog/spdlog.h"
 
 using namespace rapidjson;
@@ -47,6 +55,123 @@ using namespace rapidjson;
 namespace Envoy {
 namespace Server {
 
+namespace {
+
+// Replaces the characters which are not allowed in Prometheus metric and label names.
+std::string sanitizePrometheusName(const std::string& name) {
+  std::string sanitized = name;
+  for (char& c : sanitized) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+      c = '_';
+    }
+  }
+  return sanitized;
+}
+
+std::string escapePrometheusLabelValue(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (c == '\n') {
+      escaped.append("\\n");
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+// The stats of a host, sorted by name.
+std::vector<std::pair<std::string, uint64_t>> hostStats(const Upstream::Host& host) {
+  std::vector<std::pair<std::string, uint64_t>> all_stats;
+  for (const Stats::CounterSharedPtr& counter : host.counters()) {
+    all_stats.emplace_back(counter->name(), counter->value());
+  }
+  for (const Stats::GaugeSharedPtr& gauge : host.gauges()) {
+    all_stats.emplace_back(gauge->name(), gauge->value());
+  }
+  std::sort(all_stats.begin(), all_stats.end());
+  return all_stats;
+}
+
+void addCircuitSettingsJson(const char* priority, Upstream::ResourceManager& resource_manager,
+                            rapidjson::Writer<rapidjson::StringBuffer>& writer) {
+  writer.Key(priority);
+  writer.StartObject();
+  writer.Key("max_connections");
+  writer.Uint64(resource_manager.connections().max());
+  writer.Key("max_pending_requests");
+  writer.Uint64(resource_manager.pendingRequests().max());
+  writer.Key("max_requests");
+  writer.Uint64(resource_manager.requests().max());
+  writer.Key("max_retries");
+  writer.Uint64(resource_manager.retries().max());
+  writer.EndObject();
+}
+
+void addClusterJson(const Upstream::Cluster& cluster,
+                    const std::vector<Upstream::HostSharedPtr>& hosts,
+                    rapidjson::Writer<rapidjson::StringBuffer>& writer) {
+  writer.StartObject();
+  writer.Key("name");
+  writer.String(cluster.info()->name().c_str());
+  writer.Key("added_via_api");
+  writer.Bool(cluster.info()->addedViaApi());
+  if (cluster.outlierDetector() != nullptr) {
+    writer.Key("outlier");
+    writer.StartObject();
+    writer.Key("success_rate_average");
+    writer.Double(cluster.outlierDetector()->successRateAverage());
+    writer.Key("success_rate_ejection_threshold");
+    writer.Double(cluster.outlierDetector()->successRateEjectionThreshold());
+    writer.EndObject();
+  }
+  writer.Key("circuit_breakers");
+  writer.StartObject();
+  addCircuitSettingsJson(
+      "default", cluster.info()->resourceManager(Upstream::ResourcePriority::Default), writer);
+  addCircuitSettingsJson("high", cluster.info()->resourceManager(Upstream::ResourcePriority::High),
+                         writer);
+  writer.EndObject();
+
+  writer.Key("hosts");
+  writer.StartArray();
+  for (const Upstream::HostSharedPtr& host : hosts) {
+    writer.StartObject();
+    writer.Key("address");
+    writer.String(host->address()->asString().c_str());
+    writer.Key("stats");
+    writer.StartObject();
+    for (const auto& stat : hostStats(*host)) {
+      writer.Key(stat.first.c_str());
+      writer.Uint64(stat.second);
+    }
+    writer.EndObject();
+    writer.Key("health_flags");
+    writer.String(Upstream::HostUtility::healthFlagsToString(*host).c_str());
+    writer.Key("weight");
+    writer.Uint(host->weight());
+    writer.Key("region");
+    writer.String(host->locality().region().c_str());
+    writer.Key("zone");
+    writer.String(host->locality().zone().c_str());
+    writer.Key("sub_zone");
+    writer.String(host->locality().sub_zone().c_str());
+    writer.Key("canary");
+    writer.Bool(host->canary());
+    writer.Key("success_rate");
+    writer.Double(host->outlierDetector().successRate());
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+}
+
+} // namespace
+
 AdminFilter::AdminFilter(AdminImpl& parent) : parent_(parent) {}
 
 Http::FilterHeadersStatus AdminFilter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
@@ -142,53 +267,125 @@ void AdminImpl::addCircuitSettings(const std::string& cluster_name, const std::s
                            resource_manager.retries().max()));
 }
 
-Http::Code AdminImpl::handlerClusters(const std::string&, Buffer::Instance& response) {
-  for (auto& cluster : server_.clusterManager().clusters()) {
-    addOutlierInfo(cluster.second.get().info()->name(), cluster.second.get().outlierDetector(),
-                   response);
+void AdminImpl::addClusterText(const Upstream::Cluster& cluster,
+                               const std::vector<Upstream::HostSharedPtr>& hosts,
+                               Buffer::Instance& response) {
+  const std::string& cluster_name = cluster.info()->name();
+  addOutlierInfo(cluster_name, cluster.outlierDetector(), response);
 
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "default",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::Default),
-        response);
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "high",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::High), response);
+  addCircuitSettings(cluster_name, "default",
+                     cluster.info()->resourceManager(Upstream::ResourcePriority::Default),
+                     response);
+  addCircuitSettings(cluster_name, "high",
+                     cluster.info()->resourceManager(Upstream::ResourcePriority::High), response);
 
-    response.add(fmt::format("{}::added_via_api::{}\n", cluster.second.get().info()->name(),
-                             cluster.second.get().info()->addedViaApi()));
+  response.add(fmt::format("{}::added_via_api::{}\n", cluster_name, cluster.info()->addedViaApi()));
 
-    for (auto& host : cluster.second.get().hosts()) {
-      std::map<std::string, uint64_t> all_stats;
-      for (const Stats::CounterSharedPtr& counter : host->counters()) {
-        all_stats[counter->name()] = counter->value();
-      }
+  for (const Upstream::HostSharedPtr& host : hosts) {
+    const std::string address = host->address()->asString();
+    for (const auto& stat : hostStats(*host)) {
+      response.add(fmt::format("{}::{}::{}::{}\n", cluster_name, address, stat.first, stat.second));
+    }
 
-      for (const Stats::GaugeSharedPtr& gauge : host->gauges()) {
-        all_stats[gauge->name()] = gauge->value();
-      }
+    response.add(fmt::format("{}::{}::health_flags::{}\n", cluster_name, address,
+                             Upstream::HostUtility::healthFlagsToString(*host)));
+    response.add(fmt::format("{}::{}::weight::{}\n", cluster_name, address, host->weight()));
+    response.add(
+        fmt::format("{}::{}::region::{}\n", cluster_name, address, host->locality().region()));
+    response.add(fmt::format("{}::{}::zone::{}\n", cluster_name, address, host->locality().zone()));
+    response.add(
+        fmt::format("{}::{}::sub_zone::{}\n", cluster_name, address, host->locality().sub_zone()));
+    response.add(fmt::format("{}::{}::canary::{}\n", cluster_name, address, host->canary()));
+    response.add(fmt::format("{}::{}::success_rate::{}\n", cluster_name, address,
+                             host->outlierDetector().successRate()));
+  }
+}
 
-      for (auto stat : all_stats) {
-        response.add(fmt::format("{}::{}::{}::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), stat.first, stat.second));
+Http::Code AdminImpl::handlerClusters(const std::string& url, Buffer::Instance& response) {
+  const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
+  bool json = false;
+  std::string prefix;
+  std::string health;
+  uint64_t offset = 0;
+  uint64_t limit = std::numeric_limits<uint64_t>::max();
+  for (const auto& param : params) {
+    if (param.first == "format" && param.second == "json") {
+      json = true;
+    } else if (param.first == "prefix") {
+      prefix = param.second;
+    } else if (param.first == "health" &&
+               (param.second == "healthy" || param.second == "unhealthy")) {
+      health = param.second;
+    } else if (!((param.first == "offset" && StringUtil::atoul(param.second.c_str(), offset)) ||
+                 (param.first == "limit" && StringUtil::atoul(param.second.c_str(), limit)))) {
+      response.add("usage: /clusters?format=json&prefix=<cluster name prefix>"
+                   "&health=(healthy|unhealthy)&offset=<host>&limit=<hosts>\n");
+      response.add("\n");
+      return Http::Code::NotFound;
+    }
+  }
+  const uint64_t end = limit > std::numeric_limits<uint64_t>::max() - offset
+                           ? std::numeric_limits<uint64_t>::max()
+                           : offset + limit;
+
+  // Pages are taken over the selected hosts of the selected clusters in cluster name order.
+  std::vector<std::reference_wrapper<const Upstream::Cluster>> clusters;
+  for (const auto& cluster : server_.clusterManager().clusters()) {
+    if (StringUtil::startsWith(cluster.first.c_str(), prefix)) {
+      clusters.push_back(cluster.second);
+    }
+  }
+  std::sort(clusters.begin(), clusters.end(),
+            [](const Upstream::Cluster& lhs, const Upstream::Cluster& rhs) -> bool {
+              return lhs.info()->name() < rhs.info()->name();
+            });
+
+  // The JSON output is written cluster by cluster, so that only the response holds all of it.
+  rapidjson::StringBuffer json_buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(json_buffer);
+  if (json) {
+    writer.StartObject();
+    writer.Key("clusters");
+    writer.StartArray();
+  }
+
+  uint64_t position = 0;
+  std::vector<Upstream::HostSharedPtr> page_hosts;
+  for (const Upstream::Cluster& cluster : clusters) {
+    const uint64_t first = position;
+    page_hosts.clear();
+    for (const Upstream::HostSharedPtr& host : cluster.hosts()) {
+      if (!health.empty() && host->healthy() != (health == "healthy")) {
+        continue;
+      }
+      if (position >= offset && position < end) {
+        page_hosts.push_back(host);
       }
+      position++;
+    }
+
+    // A cluster without any selected host is listed by the page its position falls in.
+    if (page_hosts.empty() && !(position == first && first >= offset && first < end)) {
+      continue;
+    }
+
+    if (json) {
+      addClusterJson(cluster, page_hosts, writer);
+      response.add(json_buffer.GetString(), json_buffer.GetSize());
+      json_buffer.Clear();
+    } else {
+      addClusterText(cluster, page_hosts, response);
+    }
+  }
 
-      response.add(fmt::format("{}::{}::health_flags::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(),
-                               Upstream::HostUtility::healthFlagsToString(*host)));
-      response.add(fmt::format("{}::{}::weight::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(), host->weight()));
-      response.add(fmt::format("{}::{}::region::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(), host->locality().region()));
-      response.add(fmt::format("{}::{}::zone::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(), host->locality().zone()));
-      response.add(fmt::format("{}::{}::sub_zone::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(), host->locality().sub_zone()));
-      response.add(fmt::format("{}::{}::canary::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(), host->canary()));
-      response.add(fmt::format("{}::{}::success_rate::{}\n", cluster.second.get().info()->name(),
-                               host->address()->asString(), host->outlierDetector().successRate()));
+  if (json) {
+    writer.EndArray();
+    if (position > end) {
+      writer.Key("next_offset");
+      writer.Uint64(end);
     }
+    writer.EndObject();
+    response.add(json_buffer.GetString(), json_buffer.GetSize());
   }
 
   return Http::Code::OK;
@@ -217,6 +414,49 @@ Http::Code AdminImpl::handlerCpuProfiler(const std::string& url, Buffer::Instanc
   return Http::Code::OK;
 }
 
+Http::Code AdminImpl::handlerHeapProfiler(const std::string& url, Buffer::Instance& response) {
+  Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
+  if (query_params.size() != 1 || query_params.begin()->first != "enable" ||
+      (query_params.begin()->second != "y" && query_params.begin()->second != "n")) {
+    response.add("?enable=<y|n>\n");
+    return Http::Code::BadRequest;
+  }
+
+  bool enable = query_params.begin()->second == "y";
+  if (enable && !Profiler::Heap::profilerEnabled()) {
+    if (!Profiler::Heap::startProfiler(profile_path_ + ".heap")) {
+      response.add("failure to start the heap profiler");
+      return Http::Code::InternalServerError;
+    }
+
+  } else if (!enable && Profiler::Heap::profilerEnabled()) {
+    Profiler::Heap::stopProfiler();
+  }
+
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
+Http::Code AdminImpl::handlerHeapSample(const std::string&, Buffer::Instance& response) {
+  const std::string sample = Profiler::Heap::sample();
+  if (sample.empty()) {
+    response.add("heap sampling is not available\n");
+    return Http::Code::NotImplemented;
+  }
+
+  response.add(sample);
+  return Http::Code::OK;
+}
+
+Http::Code AdminImpl::handlerMemory(const std::string&, Buffer::Instance& response) {
+  response.add(fmt::format("allocated: {}\n", Memory::Stats::totalCurrentlyAllocated()));
+  response.add(fmt::format("heap_size: {}\n", Memory::Stats::totalCurrentlyReserved()));
+  response.add(fmt::format("pageheap_free: {}\n", Memory::Stats::totalPageHeapFree()));
+  response.add(fmt::format("pageheap_unmapped: {}\n", Memory::Stats::totalPageHeapUnmapped()));
+  response.add(fmt::format("buffer_slabs: {}\n", Memory::Stats::totalBufferSlabBytes()));
+  return Http::Code::OK;
+}
+
 Http::Code AdminImpl::handlerHealthcheckFail(const std::string&, Buffer::Instance& response) {
   server_.failHealthcheck(true);
   response.add("OK\n");
@@ -279,44 +519,89 @@ Http::Code AdminImpl::handlerServerInfo(const std::string&, Buffer::Instance& re
 }
 
 Http::Code AdminImpl::handlerStats(const std::string& url, Buffer::Instance& response) {
-  // We currently don't support timers locally (only via statsd) so just group all the counters
-  // and gauges together, alpha sort them, and spit them out.
-  Http::Code rc = Http::Code::OK;
   const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
-  std::map<std::string, uint64_t> all_stats;
-  for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
-    all_stats.emplace(counter->name(), counter->value());
+  std::string format;
+  std::string prefix;
+  bool used_only = false;
+  for (const auto& param : params) {
+    if (param.first == "format" && (param.second == "json" || param.second == "prometheus")) {
+      format = param.second;
+    } else if (param.first == "prefix") {
+      prefix = param.second;
+    } else if (param.first == "usedonly") {
+      used_only = true;
+    } else {
+      response.add("usage: /stats?format=(json|prometheus)&prefix=<stat prefix>&usedonly\n");
+      response.add("\n");
+      return Http::Code::NotFound;
+    }
   }
 
-  for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
-    all_stats.emplace(gauge->name(), gauge->value());
+  // Filter before formatting, so that a narrow request over many stats only pays for names.
+  auto include = [&prefix, used_only](const Stats::Metric& metric, bool used) -> bool {
+    if (used_only && !used) {
+      return false;
+    }
+    return prefix.empty() || StringUtil::startsWith(metric.name().c_str(), prefix);
+  };
+  std::list<Stats::CounterSharedPtr> counters = server_.stats().counters();
+  counters.remove_if([&include](const Stats::CounterSharedPtr& counter) -> bool {
+    return !include(*counter, counter->used());
+  });
+  std::list<Stats::GaugeSharedPtr> gauges = server_.stats().gauges();
+  gauges.remove_if([&include](const Stats::GaugeSharedPtr& gauge) -> bool {
+    return !include(*gauge, gauge->used());
+  });
+  std::list<Stats::ParentHistogramSharedPtr> histograms = server_.stats().histograms();
+  histograms.remove_if([&include](const Stats::ParentHistogramSharedPtr& histogram) -> bool {
+    return !histogram->used() || !include(*histogram, true);
+  });
+
+  if (format == "prometheus") {
+    PrometheusStatsFormatter::statsAsPrometheus(counters, gauges, histograms, response);
+    return Http::Code::OK;
   }
 
-  if (params.size() == 0) {
-    // No Arguments so use the standard.
-    for (auto stat : all_stats) {
-      response.add(fmt::format("{}: {}\n", stat.first, stat.second));
-    }
-  } else {
-    const std::string format_key = params.begin()->first;
-    const std::string format_value = params.begin()->second;
-    if (format_key == "format" && format_value == "json") {
-      response.add(statsAsJson(all_stats));
-    } else {
-      response.add("usage: /stats?format=json \n");
-      response.add("\n");
-      rc = Http::Code::NotFound;
-    }
+  // Group all the counters and gauges together, alpha sort them, and spit them out. Sorting a
+  // vector avoids a map node allocation per stat.
+  std::vector<std::pair<std::string, uint64_t>> all_stats;
+  all_stats.reserve(counters.size() + gauges.size());
+  for (const Stats::CounterSharedPtr& counter : counters) {
+    all_stats.emplace_back(counter->name(), counter->value());
   }
-  return rc;
+  for (const Stats::GaugeSharedPtr& gauge : gauges) {
+    all_stats.emplace_back(gauge->name(), gauge->value());
+  }
+  std::sort(all_stats.begin(), all_stats.end());
+
+  if (format == "json") {
+    response.add(statsAsJson(all_stats));
+    return Http::Code::OK;
+  }
+
+  for (const auto& stat : all_stats) {
+    response.add(fmt::format("{}: {}\n", stat.first, stat.second));
+  }
+
+  // Histograms follow with the quantiles of all the values merged as of the last stats flush.
+  std::vector<std::pair<std::string, std::string>> all_histograms;
+  for (const Stats::ParentHistogramSharedPtr& histogram : histograms) {
+    all_histograms.emplace_back(histogram->name(), histogram->cumulativeStatistics().summary());
+  }
+  std::sort(all_histograms.begin(), all_histograms.end());
+  for (const auto& histogram : all_histograms) {
+    response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
+  }
+  return Http::Code::OK;
 }
 
-std::string AdminImpl::statsAsJson(const std::map<std::string, uint64_t>& all_stats) {
+std::string
+AdminImpl::statsAsJson(const std::vector<std::pair<std::string, uint64_t>>& all_stats) {
   rapidjson::Document document;
   document.SetObject();
   rapidjson::Value stats_array(rapidjson::kArrayType);
   rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
-  for (auto stat : all_stats) {
+  for (const auto& stat : all_stats) {
     Value stat_obj;
     stat_obj.SetObject();
     Value stat_name;
@@ -399,6 +684,10 @@ AdminImpl::AdminImpl(const std::string& access_log_path, const std::string& prof
           {"/clusters", "upstream cluster status", MAKE_ADMIN_HANDLER(handlerClusters), false},
           {"/cpuprofiler", "enable/disable the CPU profiler",
            MAKE_ADMIN_HANDLER(handlerCpuProfiler), false},
+          {"/heapprofiler", "enable/disable the heap profiler",
+           MAKE_ADMIN_HANDLER(handlerHeapProfiler), false},
+          {"/heap_sample", "print the sampled live allocations",
+           MAKE_ADMIN_HANDLER(handlerHeapSample), false},
           {"/healthcheck/fail", "cause the server to fail health checks",
            MAKE_ADMIN_HANDLER(handlerHealthcheckFail), false},
           {"/healthcheck/ok", "cause the server to pass health checks",
@@ -406,6 +695,8 @@ AdminImpl::AdminImpl(const std::string& access_log_path, const std::string& prof
           {"/hot_restart_version", "print the hot restart compatability version",
            MAKE_ADMIN_HANDLER(handlerHotRestartVersion), false},
           {"/logging", "query/change logging levels", MAKE_ADMIN_HANDLER(handlerLogging), false},
+          {"/memory", "print memory allocation statistics", MAKE_ADMIN_HANDLER(handlerMemory),
+           false},
           {"/quitquitquit", "exit the server", MAKE_ADMIN_HANDLER(handlerQuitQuitQuit), false},
           {"/reset_counters", "reset all counters to zero",
            MAKE_ADMIN_HANDLER(handlerResetCounters), false},
@@ -504,5 +795,77 @@ bool AdminImpl::removeHandler(const std::string& prefix) {
   return false;
 }
 
+std::string PrometheusStatsFormatter::metricName(const std::string& tag_extracted_name) {
+  return "envoy_" + sanitizePrometheusName(tag_extracted_name);
+}
+
+std::string PrometheusStatsFormatter::formattedTags(const std::vector<Stats::Tag>& tags) {
+  std::string formatted;
+  for (const Stats::Tag& tag : tags) {
+    if (!formatted.empty()) {
+      formatted.push_back(',');
+    }
+    formatted.append(fmt::format("{}=\"{}\"", sanitizePrometheusName(tag.name_),
+                                 escapePrometheusLabelValue(tag.value_)));
+  }
+  return formatted;
+}
+
+uint64_t PrometheusStatsFormatter::statsAsPrometheus(
+    const std::list<Stats::CounterSharedPtr>& counters,
+    const std::list<Stats::GaugeSharedPtr>& gauges,
+    const std::list<Stats::ParentHistogramSharedPtr>& histograms, Buffer::Instance& response) {
+  // All the samples of a metric must follow its TYPE line, so they are grouped by metric first.
+  struct Metric {
+    std::string type_;
+    std::string samples_;
+  };
+  std::map<std::string, Metric> metrics;
+  auto add_sample = [&metrics](const std::string& metric_name, const char* type,
+                               const std::string& name, const std::string& labels,
+                               const std::string& value) -> void {
+    Metric& metric = metrics[metric_name];
+    metric.type_ = type;
+    metric.samples_.append(labels.empty() ? fmt::format("{} {}\n", name, value)
+                                          : fmt::format("{}{{{}}} {}\n", name, labels, value));
+  };
+
+  for (const Stats::CounterSharedPtr& counter : counters) {
+    const std::string metric_name = metricName(counter->tagExtractedName());
+    add_sample(metric_name, "counter", metric_name, formattedTags(counter->tags()),
+               std::to_string(counter->value()));
+  }
+
+  for (const Stats::GaugeSharedPtr& gauge : gauges) {
+    const std::string metric_name = metricName(gauge->tagExtractedName());
+    add_sample(metric_name, "gauge", metric_name, formattedTags(gauge->tags()),
+               std::to_string(gauge->value()));
+  }
+
+  // Histograms are summaries over all the values merged as of the last stats flush.
+  for (const Stats::ParentHistogramSharedPtr& histogram : histograms) {
+    const std::string metric_name = metricName(histogram->tagExtractedName());
+    const std::string tags = formattedTags(histogram->tags());
+    const Stats::HistogramStatistics& statistics = histogram->cumulativeStatistics();
+    const std::vector<double>& quantiles = statistics.supportedQuantiles();
+    for (size_t i = 0; i < quantiles.size(); i++) {
+      const std::string quantile = fmt::format("quantile=\"{:g}\"", quantiles[i]);
+      add_sample(metric_name, "summary", metric_name,
+                 tags.empty() ? quantile : tags + "," + quantile,
+                 fmt::format("{:g}", statistics.computedQuantiles()[i]));
+    }
+    add_sample(metric_name, "summary", metric_name + "_sum", tags,
+               std::to_string(statistics.sampleSum()));
+    add_sample(metric_name, "summary", metric_name + "_count", tags,
+               std::to_string(statistics.sampleCount()));
+  }
+
+  for (const auto& metric : metrics) {
+    response.add(fmt::format("# TYPE {} {}\n", metric.first, metric.second.type_));
+    response.add(metric.second.samples_);
+  }
+  return metrics.size();
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -3,6 +3,8 @@
 #include <chrono>
 #include <list>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "envoy/http/filter.h"
 #include "envoy/network/listen_socket.h"
@@ -10,6 +12,7 @@
 #include "envoy/server/instance.h"
 #include "envoy/upstream/outlier_detection.h"
 #include "envoy/upstream/resource_manager.h"
+#include "envoy/upstream/upstream.h"
 
 #include "common/common/logger.h"
 #include "common/common/macros.h"
@@ -61,6 +64,8 @@ public:
   std::chrono::milliseconds drainTimeout() override { return std::chrono::milliseconds(100); }
   Http::FilterChainFactory& filterFactory() override { return *this; }
   bool generateRequestId() override { return false; }
+  // Admin stays reachable while the server sheds load so that it can be inspected.
+  bool rejectNewStreams() override { return false; }
   const Optional<std::chrono::milliseconds>& idleTimeout() override { return idle_timeout_; }
   Router::RouteConfigProvider& routeConfigProvider() override { return route_config_provider_; }
   const std::string& serverName() override {
@@ -110,12 +115,15 @@ private:
    * @return TRUE if level change succeeded, FALSE otherwise.
    */
   bool changeLogLevel(const Http::Utility::QueryParams& params);
+  void addClusterText(const Upstream::Cluster& cluster,
+                      const std::vector<Upstream::HostSharedPtr>& hosts,
+                      Buffer::Instance& response);
   void addCircuitSettings(const std::string& cluster_name, const std::string& priority_str,
                           Upstream::ResourceManager& resource_manager, Buffer::Instance& response);
   void addOutlierInfo(const std::string& cluster_name,
                       const Upstream::Outlier::Detector* outlier_detector,
                       Buffer::Instance& response);
-  std::string statsAsJson(const std::map<std::string, uint64_t>& all_stats);
+  std::string statsAsJson(const std::vector<std::pair<std::string, uint64_t>>& all_stats);
 
   /**
    * URL handlers.
@@ -123,10 +131,13 @@ private:
   Http::Code handlerCerts(const std::string& url, Buffer::Instance& response);
   Http::Code handlerClusters(const std::string& url, Buffer::Instance& response);
   Http::Code handlerCpuProfiler(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerHeapProfiler(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerHeapSample(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckFail(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckOk(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHotRestartVersion(const std::string& url, Buffer::Instance& response);
   Http::Code handlerLogging(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerMemory(const std::string& url, Buffer::Instance& response);
   Http::Code handlerResetCounters(const std::string& url, Buffer::Instance& response);
   Http::Code handlerServerInfo(const std::string& url, Buffer::Instance& response);
   Http::Code handlerStats(const std::string& url, Buffer::Instance& response);
@@ -177,5 +188,33 @@ private:
   Http::HeaderMap* request_headers_{};
 };
 
+/**
+ * Formats stats in the Prometheus text exposition format. Metric names are the tag extracted
+ * names of the stats and the extracted tags become labels, so that e.g. the upstream_rq_total
+ * counters of all clusters are the samples of a single metric.
+ */
+class PrometheusStatsFormatter {
+public:
+  /**
+   * Append the stats to response.
+   * @return uint64_t the number of metrics written.
+   */
+  static uint64_t statsAsPrometheus(const std::list<Stats::CounterSharedPtr>& counters,
+                                    const std::list<Stats::GaugeSharedPtr>& gauges,
+                                    const std::list<Stats::ParentHistogramSharedPtr>& histograms,
+                                    Buffer::Instance& response);
+
+  /**
+   * @return std::string the metric name for a tag extracted name, prefixed with "envoy_" and with
+   *         the characters Prometheus does not allow replaced by '_'.
+   */
+  static std::string metricName(const std::string& tag_extracted_name);
+
+  /**
+   * @return std::string the tags as comma separated name="value" labels.
+   */
+  static std::string formattedTags(const std::vector<Stats::Tag>& tags);
+};
+
 } // namespace Server
 } // namespace Envoy
@@ -1,9 +1,14 @@
 #include "server/listener_manager_impl.h"
 
+#include <sys/socket.h>
+
 #include "envoy/registry/registry.h"
 
 #include "common/common/assert.h"
+#include "common/common/utility.h"
 #include "common/config/utility.h"
+#include "common/network/cidr_range.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/utility.h"
 #include "common/protobuf/utility.h"
@@ -56,7 +61,7 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   // TODO(mattklein123): UDS support.
   ASSERT(address->type() == Network::Address::Type::Ip);
   const std::string addr = fmt::format("tcp://{}", address->asString());
-  const int fd = server_.hotRestart().duplicateParentListenSocket(addr);
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, 0);
   if (fd != -1) {
     ENVOY_LOG(info, "obtained socket for address {} from parent", addr);
     return std::make_shared<Network::TcpListenSocket>(fd, address);
@@ -65,8 +70,39 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   }
 }
 
+Network::ListenSocketSharedPtr ProdListenerComponentFactory::createReusePortListenSocket(
+    Network::Address::InstanceConstSharedPtr address, uint32_t worker_index) {
+  ASSERT(address->type() == Network::Address::Type::Ip);
+  const std::string addr = fmt::format("tcp://{}", address->asString());
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, worker_index);
+  Network::ListenSocketSharedPtr socket;
+  if (fd != -1) {
+    ENVOY_LOG(info, "obtained socket {} for address {} from parent", worker_index, addr);
+    socket = std::make_shared<Network::TcpListenSocket>(fd, address);
+  } else {
+    socket = std::make_shared<Network::TcpListenSocket>(address, true, true);
+  }
+
+  // Among the SO_REUSEPORT sockets of an address, the kernel prefers the one whose incoming CPU is
+  // the CPU that received the connection, so with the NIC's receive queues steered to the CPUs of
+  // the workers a connection stays on one CPU from the interrupt to the worker.
+  const std::vector<uint32_t>& cpus = server_.options().workerCpus();
+  if (server_.options().reusePortIncomingCpu() && !cpus.empty()) {
+#ifdef SO_INCOMING_CPU
+    const int cpu = cpus[worker_index % cpus.size()];
+    if (setsockopt(socket->fd(), SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1) {
+      ENVOY_LOG(warn, "cannot set SO_INCOMING_CPU on socket {} for address {}: {}", worker_index,
+                addr, strerror(errno));
+    }
+#else
+    ENVOY_LOG(warn, "SO_INCOMING_CPU is not supported on this platform");
+#endif
+  }
+  return socket;
+}
+
 DrainManagerPtr ProdListenerComponentFactory::createDrainManager() {
-  return DrainManagerPtr{new DrainManagerImpl(server_)};
+  return DrainManagerPtr{new DrainManagerImpl(server_, ProdMonotonicTimeSource::instance_)};
 }
 
 ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManagerImpl& parent,
@@ -86,21 +122,75 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManag
       listener_tag_(parent_.factory_.nextListenerTag()), name_(name),
       workers_started_(workers_started), hash_(hash),
       local_drain_manager_(parent.factory_.createDrainManager()) {
-  // TODO(htuch): Support multiple filter chains #1280, add constraint to ensure we have at least on
-  // filter chain #1308.
-  ASSERT(config.filter_chains().size() == 1);
-  const auto& filter_chain = config.filter_chains()[0];
+  // TODO(htuch): add constraint to ensure we have at least on filter chain #1308.
+  ASSERT(config.filter_chains().size() >= 1);
+  const auto& first_filter_chain = config.filter_chains()[0];
 
   listener_scope_ =
       parent_.server_.stats().createScope(fmt::format("listener.{}.", address_->asString()));
 
-  if (filter_chain.has_tls_context()) {
-    Ssl::ServerContextConfigImpl context_config(filter_chain.tls_context());
+  // The TLS context is set up when the connection is accepted, before its destination picks a
+  // filter chain, so all the filter chains share it. Certificates are picked by SNI through the SNI
+  // certificates of the TLS context.
+  if (first_filter_chain.has_tls_context()) {
+    Ssl::ServerContextConfigImpl context_config(first_filter_chain.tls_context());
     ssl_context_ = parent_.server_.sslContextManager().createSslServerContext(*listener_scope_,
                                                                               context_config);
   }
 
-  filter_factories_ = parent_.factory_.createFilterFactoryList(filter_chain.filters(), *this);
+  if (bind_to_port_ && parent_.server_.options().balanceConnections()) {
+    connection_balancer_ = std::make_shared<Network::ConnectionBalancerImpl>();
+  }
+
+  std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> destinations;
+  for (const auto& filter_chain : config.filter_chains()) {
+    if (filter_chain.tls_context().SerializeAsString() !=
+        first_filter_chain.tls_context().SerializeAsString()) {
+      throw EnvoyException(fmt::format(
+          "error adding listener '{}': all filter chains must have the same TLS context",
+          address_->asString()));
+    }
+
+    const auto& filter_chain_match = filter_chain.filter_chain_match();
+    if (filter_chain_match.sni_domains_size() > 0) {
+      throw EnvoyException(fmt::format(
+          "error adding listener '{}': filter chains can not be matched by SNI, use the SNI "
+          "certificates of the TLS context",
+          address_->asString()));
+    }
+
+    const uint32_t index = filter_chains_.size();
+    filter_chains_.emplace_back();
+    filter_chains_.back().destination_port_ =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(filter_chain_match, destination_port, 0);
+
+    destinations.emplace_back(std::to_string(index), std::vector<Network::Address::CidrRange>());
+    for (const auto& prefix_range : filter_chain_match.prefix_ranges()) {
+      Network::Address::CidrRange range = Network::Address::CidrRange::create(
+          prefix_range.address_prefix(),
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(prefix_range, prefix_len, 0));
+      if (!range.isValid()) {
+        throw EnvoyException(fmt::format("error adding listener '{}': invalid prefix range '{}/{}'",
+                                         address_->asString(), prefix_range.address_prefix(),
+                                         prefix_range.prefix_len().value()));
+      }
+      destinations.back().second.push_back(range);
+    }
+    if (destinations.back().second.empty()) {
+      any_destination_filter_chains_.push_back(index);
+    }
+
+    filter_chains_.back().filter_factories_ =
+        parent_.factory_.createFilterFactoryList(filter_chain.filters(), *this);
+  }
+
+  destination_trie_ = Network::Address::LpmTrie(destinations);
+
+  envoy::api::v2::Listener listener_config(config);
+  for (auto& filter_chain : *listener_config.mutable_filter_chains()) {
+    filter_chain.clear_filters();
+  }
+  listener_hash_ = MessageUtil::hash(listener_config);
 }
 
 ListenerImpl::~ListenerImpl() {
@@ -110,17 +200,82 @@ ListenerImpl::~ListenerImpl() {
   // active. This is done here explicitly by setting a boolean and then clearing the factory
   // vector for clarity.
   initialize_canceled_ = true;
-  filter_factories_.clear();
+  filter_chains_.clear();
+}
+
+const ListenerImpl::FilterChain*
+ListenerImpl::findFilterChain(const Network::Connection& connection) const {
+  // The candidates are the filter chains whose destination ranges contain the local address, and
+  // the filter chains without destination ranges. Both lists are in config order, so walking them
+  // together keeps the first matching filter chain first.
+  const std::vector<uint32_t>& destination_filter_chains =
+      destination_trie_.getTagIndexes(connection.localAddress());
+  auto destination_filter_chain = destination_filter_chains.begin();
+  auto any_destination_filter_chain = any_destination_filter_chains_.begin();
+  while (destination_filter_chain != destination_filter_chains.end() ||
+         any_destination_filter_chain != any_destination_filter_chains_.end()) {
+    uint32_t index;
+    if (any_destination_filter_chain == any_destination_filter_chains_.end() ||
+        (destination_filter_chain != destination_filter_chains.end() &&
+         *destination_filter_chain < *any_destination_filter_chain)) {
+      index = *destination_filter_chain++;
+    } else {
+      index = *any_destination_filter_chain++;
+    }
+
+    const FilterChain& filter_chain = filter_chains_[index];
+    if (filter_chain.destination_port_ == 0 ||
+        (connection.localAddress().ip() != nullptr &&
+         connection.localAddress().ip()->port() == filter_chain.destination_port_)) {
+      return &filter_chain;
+    }
+  }
+
+  return nullptr;
+}
+
+bool ListenerImpl::buildFilterChain(Network::Connection& connection,
+                                    const std::shared_ptr<ListenerImpl>& update) {
+  const FilterChain* filter_chain = findFilterChain(connection);
+  if (filter_chain == nullptr) {
+    // An empty filter chain closes the connection.
+    ENVOY_LOG(debug, "listener {}: no filter chain matches {}", name_,
+              connection.localAddress().asString());
+    return false;
+  }
+
+  if (update == nullptr || filter_chain->filter_factories_.empty()) {
+    return Configuration::FilterChainUtility::buildFilterChain(connection,
+                                                               filter_chain->filter_factories_);
+  }
+
+  for (const Configuration::NetworkFilterFactoryCb& factory : filter_chain->filter_factories_) {
+    factory(connection);
+  }
+  connection.addReadFilter(std::make_shared<UpdateHandle>(update));
+  return connection.initializeReadFilters();
 }
 
 bool ListenerImpl::createFilterChain(Network::Connection& connection) {
-  return Configuration::FilterChainUtility::buildFilterChain(connection, filter_factories_);
+  std::shared_ptr<ListenerImpl> update;
+  {
+    std::lock_guard<std::mutex> lock(update_lock_);
+    update = update_;
+  }
+
+  if (update != nullptr) {
+    return update->buildFilterChain(connection, update);
+  }
+  return buildFilterChain(connection, nullptr);
 }
 
 bool ListenerImpl::drainClose() const {
   // When a listener is draining, the "drain close" decision is the union of the per-listener drain
   // manager and the server wide drain manager. This allows individual listeners to be drained and
   // removed independently of a server-wide drain event (e.g., /healthcheck/fail or hot restart).
+  if (drain_parent_ != nullptr) {
+    return drain_parent_->drainClose();
+  }
   return local_drain_manager_->drainClose() || parent_.server_.drainManager().drainClose();
 }
 
@@ -150,9 +305,26 @@ Init::Manager& ListenerImpl::initManager() {
   }
 }
 
-void ListenerImpl::setSocket(const Network::ListenSocketSharedPtr& socket) {
-  ASSERT(!socket_);
-  socket_ = socket;
+void ListenerImpl::updateInPlace(ListenerImplPtr&& update) {
+  ASSERT(update->listenerHash() == listener_hash_);
+  update->drain_parent_ = this;
+
+  // The last connection using the update may close on a worker, so the update is destroyed
+  // through a post to the main thread.
+  Event::Dispatcher& dispatcher = parent_.server_.dispatcher();
+  std::shared_ptr<ListenerImpl> shared_update(
+      update.release(), [&dispatcher](ListenerImpl* listener) -> void {
+        dispatcher.post([listener]() -> void { delete listener; });
+      });
+
+  std::lock_guard<std::mutex> lock(update_lock_);
+  update_ = std::move(shared_update);
+}
+
+void ListenerImpl::setSockets(const std::vector<Network::ListenSocketSharedPtr>& sockets) {
+  ASSERT(sockets_.empty());
+  ASSERT(!sockets.empty());
+  sockets_ = sockets;
 }
 
 ListenerManagerImpl::ListenerManagerImpl(Instance& server,
@@ -217,12 +389,12 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     // In this case we can just replace inline.
     ASSERT(workers_started_);
     new_listener->infoLog("update warming listener");
-    new_listener->setSocket((*existing_warming_listener)->getSocket());
+    new_listener->setSockets((*existing_warming_listener)->getSockets());
     *existing_warming_listener = std::move(new_listener);
   } else if (existing_active_listener != active_listeners_.end()) {
     // In this case we have no warming listener, so what we do depends on whether workers
     // have been started or not. Either way we get the socket from the existing listener.
-    new_listener->setSocket((*existing_active_listener)->getSocket());
+    new_listener->setSockets((*existing_active_listener)->getSockets());
     if (workers_started_) {
       new_listener->infoLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -251,20 +423,19 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     // to see if there is a listener that has a socket bound to the address we are configured for.
     // This is an edge case, but may happen if a listener is removed and then added back with a same
     // or different name and intended to listen on the same address. This should work and not fail.
-    Network::ListenSocketSharedPtr draining_listener_socket;
+    std::vector<Network::ListenSocketSharedPtr> draining_listener_sockets;
     auto existing_draining_listener = std::find_if(
         draining_listeners_.cbegin(), draining_listeners_.cend(),
         [&new_listener](const DrainingListener& listener) {
           return *new_listener->address() == *listener.listener_->socket().localAddress();
         });
     if (existing_draining_listener != draining_listeners_.cend()) {
-      draining_listener_socket = existing_draining_listener->listener_->getSocket();
+      draining_listener_sockets = existing_draining_listener->listener_->getSockets();
     }
 
-    new_listener->setSocket(
-        draining_listener_socket
-            ? draining_listener_socket
-            : factory_.createListenSocket(new_listener->address(), new_listener->bindToPort()));
+    new_listener->setSockets(!draining_listener_sockets.empty()
+                                 ? draining_listener_sockets
+                                 : createListenSockets(*new_listener));
     if (workers_started_) {
       new_listener->infoLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -386,15 +557,51 @@ void ListenerManagerImpl::addListenerToWorker(Worker& worker, ListenerImpl& list
   });
 }
 
+std::vector<Network::ListenSocketSharedPtr>
+ListenerManagerImpl::createListenSockets(ListenerImpl& listener) {
+  std::vector<Network::ListenSocketSharedPtr> sockets;
+  if (!server_.options().reusePort() || !listener.bindToPort()) {
+    sockets.push_back(factory_.createListenSocket(listener.address(), listener.bindToPort()));
+    return sockets;
+  }
+
+  // The kernel spreads new connections over all the SO_REUSEPORT sockets bound to an address, so
+  // that each worker only wakes up for its own share. The others bind to the address of the first
+  // one, in case the port it was configured with is zero. No socket is created when only the
+  // configuration is validated.
+  Network::Address::InstanceConstSharedPtr address = listener.address();
+  for (uint32_t i = 0; i < workers_.size(); i++) {
+    sockets.push_back(factory_.createReusePortListenSocket(address, i));
+    if (sockets[0]) {
+      address = sockets[0]->localAddress();
+    }
+  }
+  return sockets;
+}
+
 void ListenerManagerImpl::onListenerWarmed(ListenerImpl& listener) {
+  auto existing_active_listener = getListenerByName(active_listeners_, listener.name());
+  auto existing_warming_listener = getListenerByName(warming_listeners_, listener.name());
+
+  // An update which only changes filters is handed to the active listener, which keeps its
+  // connections and gives the new ones the filters of the update.
+  if (server_.options().inPlaceListenerUpdates() &&
+      existing_active_listener != active_listeners_.end() &&
+      (*existing_active_listener)->listenerHash() == listener.listenerHash()) {
+    (*existing_warming_listener)->infoLog("warm complete. updating active listener in place");
+    (*existing_active_listener)->updateInPlace(std::move(*existing_warming_listener));
+    warming_listeners_.erase(existing_warming_listener);
+    stats_.listener_in_place_updated_.inc();
+    updateWarmingActiveGauges();
+    return;
+  }
+
   // The warmed listener should be added first so that the worker will accept new connections
   // when it stops listening on the old listener.
   for (const auto& worker : workers_) {
     addListenerToWorker(*worker, listener);
   }
 
-  auto existing_active_listener = getListenerByName(active_listeners_, listener.name());
-  auto existing_warming_listener = getListenerByName(warming_listeners_, listener.name());
   (*existing_warming_listener)->infoLog("warm complete. updating active listener");
   if (existing_active_listener != active_listeners_.end()) {
     drainListener(std::move(*existing_active_listener));
@@ -463,6 +670,24 @@ void ListenerManagerImpl::stopListeners() {
   }
 }
 
+void ListenerManagerImpl::disableListeners() {
+  if (!workers_started_) {
+    return;
+  }
+  for (const auto& worker : workers_) {
+    worker->disableListeners();
+  }
+}
+
+void ListenerManagerImpl::enableListeners() {
+  if (!workers_started_) {
+    return;
+  }
+  for (const auto& worker : workers_) {
+    worker->enableListeners();
+  }
+}
+
 void ListenerManagerImpl::stopWorkers() {
   ASSERT(workers_started_);
   for (const auto& worker : workers_) {
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+
+#include "envoy/network/filter.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/server/instance.h"
 #include "envoy/server/listener_manager.h"
 #include "envoy/server/worker.h"
 
 #include "common/common/logger.h"
+#include "common/network/lpm_trie.h"
 
 #include "server/init_manager_impl.h"
 
@@ -39,6 +44,9 @@ public:
   }
   Network::ListenSocketSharedPtr
   createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port) override;
+  Network::ListenSocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr address,
+                              uint32_t worker_index) override;
   DrainManagerPtr createDrainManager() override;
   uint64_t nextListenerTag() override { return next_listener_tag_++; }
 
@@ -57,6 +65,7 @@ typedef std::unique_ptr<ListenerImpl> ListenerImplPtr;
 #define ALL_LISTENER_MANAGER_STATS(COUNTER, GAUGE)                                                 \
   COUNTER(listener_added)                                                                          \
   COUNTER(listener_modified)                                                                       \
+  COUNTER(listener_in_place_updated)                                                               \
   COUNTER(listener_removed)                                                                        \
   COUNTER(listener_create_success)                                                                 \
   COUNTER(listener_create_failure)                                                                 \
@@ -89,6 +98,8 @@ public:
   bool removeListener(const std::string& listener_name) override;
   void startWorkers(GuardDog& guard_dog) override;
   void stopListeners() override;
+  void disableListeners() override;
+  void enableListeners() override;
   void stopWorkers() override;
 
   Instance& server_;
@@ -106,6 +117,7 @@ private:
   };
 
   void addListenerToWorker(Worker& worker, ListenerImpl& listener);
+  std::vector<Network::ListenSocketSharedPtr> createListenSockets(ListenerImpl& listener);
   static ListenerManagerStats generateStats(Stats::Scope& scope);
   static bool hasListenerWithAddress(const ListenerList& list,
                                      const Network::Address::Instance& address);
@@ -151,7 +163,8 @@ private:
 //                     initializing all listeners after workers are started.
 
 /**
- * Maps proto config to runtime config for a listener with a network filter chain.
+ * Maps proto config to runtime config for a listener with one or more network filter chains. Each
+ * connection gets the first filter chain, in config order, which matches its destination.
  */
 class ListenerImpl : public Listener,
                      public Configuration::FactoryContext,
@@ -183,16 +196,36 @@ public:
   }
 
   Network::Address::InstanceConstSharedPtr address() const { return address_; }
-  const Network::ListenSocketSharedPtr& getSocket() const { return socket_; }
-  uint64_t hash() const { return hash_; }
+  const std::vector<Network::ListenSocketSharedPtr>& getSockets() const { return sockets_; }
+  uint64_t hash() const { return update_ ? update_->hash() : hash_; }
+  /**
+   * @return the hash of the listener's config without the filters of its filter chains. Listeners
+   *         with the same name and listener hash only differ in the filters of their connections.
+   */
+  uint64_t listenerHash() const { return listener_hash_; }
   void infoLog(const std::string& message);
   void initialize();
   DrainManager& localDrainManager() const { return *local_drain_manager_; }
-  void setSocket(const Network::ListenSocketSharedPtr& socket);
+  void setSockets(const std::vector<Network::ListenSocketSharedPtr>& sockets);
+
+  /**
+   * Update the listener in place with a warmed listener with the same listener hash. New
+   * connections get the filter chains of the update, and the existing connections keep theirs.
+   * The update is destroyed on the main thread once it has been replaced and the last connection
+   * using its filter chains has closed.
+   * @param update supplies the warmed listener.
+   */
+  void updateInPlace(ListenerImplPtr&& update);
 
   // Server::Listener
   Network::FilterChainFactory& filterChainFactory() override { return *this; }
-  Network::ListenSocket& socket() override { return *socket_; }
+  Network::ListenSocket& socket() override { return *sockets_[0]; }
+  Network::ListenSocket& workerSocket(uint32_t worker_index) override {
+    return *sockets_[worker_index % sockets_.size()];
+  }
+  Network::ConnectionBalancerSharedPtr connectionBalancer() override {
+    return connection_balancer_;
+  }
   bool bindToPort() override { return bind_to_port_; }
   Ssl::ServerContext* sslContext() override { return ssl_context_.get(); }
   bool useProxyProto() override { return use_proxy_proto_; }
@@ -213,6 +246,7 @@ public:
   Tracing::HttpTracer& httpTracer() override { return parent_.server_.httpTracer(); }
   Init::Manager& initManager() override;
   const LocalInfo::LocalInfo& localInfo() override { return parent_.server_.localInfo(); }
+  OverloadManager& overloadManager() override { return parent_.server_.overloadManager(); }
   Envoy::Runtime::RandomGenerator& random() override { return parent_.server_.random(); }
   RateLimit::ClientPtr
   rateLimitClient(const Optional<std::chrono::milliseconds>& timeout) override {
@@ -231,9 +265,43 @@ public:
   bool createFilterChain(Network::Connection& connection) override;
 
 private:
+  /**
+   * A filter chain and the destination port it matches, 0 for any port. The destination ranges it
+   * matches are indexed in destination_trie_.
+   */
+  struct FilterChain {
+    uint32_t destination_port_{};
+    std::vector<Configuration::NetworkFilterFactoryCb> filter_factories_;
+  };
+
+  /**
+   * Read filter added last to the connections which get the filter chains of an in place update.
+   * It is destroyed after the other filters of the connection, and only then releases the update.
+   */
+  class UpdateHandle : public Network::ReadFilter {
+  public:
+    UpdateHandle(std::shared_ptr<ListenerImpl> update) : update_(std::move(update)) {}
+
+    // Network::ReadFilter
+    Network::FilterStatus onData(Buffer::Instance&) override {
+      return Network::FilterStatus::Continue;
+    }
+    Network::FilterStatus onNewConnection() override { return Network::FilterStatus::Continue; }
+    void initializeReadFilterCallbacks(Network::ReadFilterCallbacks&) override {}
+
+  private:
+    const std::shared_ptr<ListenerImpl> update_;
+  };
+
+  const FilterChain* findFilterChain(const Network::Connection& connection) const;
+  bool buildFilterChain(Network::Connection& connection,
+                        const std::shared_ptr<ListenerImpl>& update);
+
   ListenerManagerImpl& parent_;
   Network::Address::InstanceConstSharedPtr address_;
-  Network::ListenSocketSharedPtr socket_;
+  // Either one socket shared by all workers or a SO_REUSEPORT socket for each worker.
+  std::vector<Network::ListenSocketSharedPtr> sockets_;
+  Network::ConnectionBalancerSharedPtr connection_balancer_;
   Stats::ScopePtr global_scope_;   // Stats with global named scope, but needed for LDS cleanup.
   Stats::ScopePtr listener_scope_; // Stats with listener named scope.
   Ssl::ServerContextPtr ssl_context_;
@@ -245,11 +313,23 @@ private:
   const std::string name_;
   const bool workers_started_;
   const uint64_t hash_;
+  uint64_t listener_hash_;
   InitManagerImpl dynamic_init_manager_;
   bool initialize_canceled_{};
-  std::vector<Configuration::NetworkFilterFactoryCb> filter_factories_;
+  std::vector<FilterChain> filter_chains_;
+  // The filter chains by the destination ranges they match, tagged by their index.
+  Network::Address::LpmTrie destination_trie_;
+  // The indexes of the filter chains without destination ranges, in config order.
+  std::vector<uint32_t> any_destination_filter_chains_;
   DrainManagerPtr local_drain_manager_;
   bool saw_listener_create_failure_{};
+  // The latest in place update, which gives the new connections their filter chains. It is only
+  // set on the main thread, and read by the workers under the lock.
+  std::mutex update_lock_;
+  std::shared_ptr<ListenerImpl> update_;
+  // Set on an in place update: the listener whose sockets the update's connections came from, and
+  // which decides when they are drained.
+  const ListenerImpl* drain_parent_{};
 };
 
 } // namespace Server
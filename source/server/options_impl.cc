@@ -3,9 +3,11 @@
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <string>
 
 #include "common/common/macros.h"
+#include "common/common/utility.h"
 #include "common/common/version.h"
 #include "common/stats/stats_impl.h"
 
@@ -30,6 +32,31 @@
 #endif
 
 namespace Envoy {
+namespace {
+
+/**
+ * Parse a list of CPUs such as "0-15,32-47" into their indexes.
+ * @return bool whether the list is valid.
+ */
+bool parseCpuList(const std::string& list, std::vector<uint32_t>& cpus) {
+  for (const std::string& range : StringUtil::split(list, ',')) {
+    const std::vector<std::string> bounds = StringUtil::split(range, "-", true);
+    uint64_t first;
+    uint64_t last;
+    if (bounds.size() > 2 || !StringUtil::atoul(bounds[0].c_str(), first) ||
+        !StringUtil::atoul(bounds.back().c_str(), last) || first > last ||
+        last > std::numeric_limits<uint16_t>::max()) {
+      return false;
+    }
+    for (uint64_t cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_restart_version_cb,
                          spdlog::level::level_enum default_log_level) {
   std::string log_levels_string = "Log levels: ";
@@ -74,6 +101,10 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
                                                      10000, "uint32_t", cmd);
   TCLAP::ValueArg<uint32_t> drain_time_s("", "drain-time-s", "Hot restart drain time in seconds",
                                          false, 600, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> drain_rate("", "drain-rate",
+                                       "Maximum number of connections each worker drain closes "
+                                       "per second (0 for no limit)",
+                                       false, 0, "uint32_t", cmd);
   TCLAP::ValueArg<uint32_t> parent_shutdown_time_s("", "parent-shutdown-time-s",
                                                    "Hot restart parent shutdown time in seconds",
                                                    false, 900, "uint32_t", cmd);
@@ -91,6 +122,58 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
                                              " the cluster name)",
                                              false, ENVOY_DEFAULT_MAX_OBJ_NAME_LENGTH, "uint64_t",
                                              cmd);
+  TCLAP::ValueArg<uint32_t> host_stats_shards("", "host-stats-shards",
+                                              "Number of shards of the active connection and "
+                                              "request gauges of each upstream host",
+                                              false, 1, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> counter_shards("", "counter-shards",
+                                           "Number of shards of each counter", false, 1,
+                                           "uint32_t", cmd);
+  TCLAP::SwitchArg compact_cluster_stats(
+      "", "compact-cluster-stats",
+      "Keep the counters and gauges of each cluster in a compact block of stats", cmd);
+  TCLAP::ValueArg<uint32_t> dns_cache_ttl_ms("", "dns-cache-ttl-ms",
+                                             "How long DNS resolutions are cached in msec", false,
+                                             0, "uint32_t", cmd);
+  TCLAP::SwitchArg reuse_port("", "reuse-port",
+                              "Give each worker a SO_REUSEPORT socket of its own for each listener",
+                              cmd);
+  TCLAP::SwitchArg balance_connections(
+      "", "balance-connections",
+      "Hand each accepted connection over to the worker with the fewest connections", cmd);
+  TCLAP::SwitchArg dispatcher_stats(
+      "", "dispatcher-stats",
+      "Record histograms of the event loop iterations of the main thread and of each worker", cmd);
+  TCLAP::SwitchArg worker_stats(
+      "", "worker-stats",
+      "Keep stats of the connections, requests and bytes of each worker over all its listeners", cmd);
+  TCLAP::SwitchArg in_place_listener_updates(
+      "", "in-place-listener-updates",
+      "Apply listener updates which only change filters without draining the listener", cmd);
+  TCLAP::ValueArg<uint32_t> idle_memory_release_ms(
+      "", "idle-memory-release-ms",
+      "Idle time in milliseconds after which downstream connections release their buffer memory "
+      "(0 to keep it)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> busy_poll_us(
+      "", "busy-poll-us",
+      "Time in microseconds the workers keep polling for events before they block (0 to block)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> deferred_delete_budget_us(
+      "", "deferred-delete-budget-us",
+      "Time in microseconds the workers may spend on deferred deletions in one go (0 for no limit)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<std::string> worker_cpus(
+      "", "worker-cpus", "CPUs to pin the workers to, in order (e.g. 0-15,32-47)", false, "",
+      "string", cmd);
+  TCLAP::SwitchArg reuse_port_incoming_cpu(
+      "", "reuse-port-incoming-cpu",
+      "Steer connections to the reuse-port sockets of the worker pinned to the CPU receiving them",
+      cmd);
+  TCLAP::ValueArg<uint64_t> async_log_buffer_size(
+      "", "async-log-buffer-size",
+      "Bytes of log messages buffered for a background writer thread (0 to log synchronously)",
+      false, 0, "uint64_t", cmd);
 
   try {
     cmd.parse(argc, argv);
@@ -105,6 +188,22 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
     exit(1);
   }
 
+  if (host_stats_shards.getValue() == 0) {
+    std::cerr << "error: the 'host-stats-shards' value must be at least 1" << std::endl;
+    exit(1);
+  }
+
+  if (counter_shards.getValue() == 0) {
+    std::cerr << "error: the 'counter-shards' value must be at least 1" << std::endl;
+    exit(1);
+  }
+
+  if (!parseCpuList(worker_cpus.getValue(), worker_cpus_)) {
+    std::cerr << "error: invalid 'worker-cpus' value '" << worker_cpus.getValue() << "'"
+              << std::endl;
+    exit(1);
+  }
+
   if (hot_restart_version_option.getValue()) {
     std::cerr << hot_restart_version_cb(max_stats.getValue(),
                                         max_obj_name_len.getValue() +
@@ -150,8 +249,23 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   service_zone_ = service_zone.getValue();
   file_flush_interval_msec_ = std::chrono::milliseconds(file_flush_interval_msec.getValue());
   drain_time_ = std::chrono::seconds(drain_time_s.getValue());
+  drain_rate_ = drain_rate.getValue();
   parent_shutdown_time_ = std::chrono::seconds(parent_shutdown_time_s.getValue());
   max_stats_ = max_stats.getValue();
   max_obj_name_length_ = max_obj_name_len.getValue();
+  host_stats_shards_ = host_stats_shards.getValue();
+  counter_shards_ = counter_shards.getValue();
+  compact_cluster_stats_ = compact_cluster_stats.getValue();
+  dns_cache_ttl_ = std::chrono::milliseconds(dns_cache_ttl_ms.getValue());
+  reuse_port_ = reuse_port.getValue();
+  balance_connections_ = balance_connections.getValue();
+  dispatcher_stats_ = dispatcher_stats.getValue();
+  worker_stats_ = worker_stats.getValue();
+  in_place_listener_updates_ = in_place_listener_updates.getValue();
+  idle_memory_release_ = std::chrono::milliseconds(idle_memory_release_ms.getValue());
+  busy_poll_ = std::chrono::microseconds(busy_poll_us.getValue());
+  deferred_delete_budget_ = std::chrono::microseconds(deferred_delete_budget_us.getValue());
+  reuse_port_incoming_cpu_ = reuse_port_incoming_cpu.getValue();
+  async_log_buffer_size_ = async_log_buffer_size.getValue();
 }
 } // namespace Envoy
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/server/options.h"
 
@@ -26,6 +27,7 @@ public:
   const std::string& adminAddressPath() override { return admin_address_path_; }
   Network::Address::IpVersion localAddressIpVersion() override { return local_address_ip_version_; }
   std::chrono::seconds drainTime() override { return drain_time_; }
+  uint32_t drainRate() override { return drain_rate_; }
   spdlog::level::level_enum logLevel() override { return log_level_; }
   const std::string& logPath() override { return log_path_; }
   std::chrono::seconds parentShutdownTime() override { return parent_shutdown_time_; }
@@ -37,6 +39,21 @@ public:
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return max_stats_; }
   uint64_t maxObjNameLength() override { return max_obj_name_length_; }
+  uint32_t hostStatsShards() override { return host_stats_shards_; }
+  uint32_t counterShards() override { return counter_shards_; }
+  bool compactClusterStats() override { return compact_cluster_stats_; }
+  std::chrono::milliseconds dnsCacheTtl() override { return dns_cache_ttl_; }
+  bool reusePort() override { return reuse_port_; }
+  bool balanceConnections() override { return balance_connections_; }
+  bool dispatcherStats() override { return dispatcher_stats_; }
+  bool workerStats() override { return worker_stats_; }
+  bool inPlaceListenerUpdates() override { return in_place_listener_updates_; }
+  std::chrono::milliseconds idleMemoryRelease() override { return idle_memory_release_; }
+  std::chrono::microseconds busyPoll() override { return busy_poll_; }
+  std::chrono::microseconds deferredDeleteBudget() override { return deferred_delete_budget_; }
+  const std::vector<uint32_t>& workerCpus() override { return worker_cpus_; }
+  bool reusePortIncomingCpu() override { return reuse_port_incoming_cpu_; }
+  uint64_t asyncLogBufferSize() override { return async_log_buffer_size_; }
 
 private:
   uint64_t base_id_;
@@ -52,9 +69,25 @@ private:
   std::string service_zone_;
   std::chrono::milliseconds file_flush_interval_msec_;
   std::chrono::seconds drain_time_;
+  uint32_t drain_rate_;
   std::chrono::seconds parent_shutdown_time_;
   Server::Mode mode_;
   uint64_t max_stats_;
   uint64_t max_obj_name_length_;
+  uint32_t host_stats_shards_;
+  uint32_t counter_shards_;
+  bool compact_cluster_stats_;
+  std::chrono::milliseconds dns_cache_ttl_;
+  bool reuse_port_;
+  bool balance_connections_;
+  bool dispatcher_stats_;
+  bool worker_stats_;
+  bool in_place_listener_updates_;
+  std::chrono::milliseconds idle_memory_release_;
+  std::chrono::microseconds busy_poll_;
+  std::chrono::microseconds deferred_delete_budget_;
+  std::vector<uint32_t> worker_cpus_;
+  bool reuse_port_incoming_cpu_;
+  uint64_t async_log_buffer_size_;
 };
 } // namespace Envoy
@@ -0,0 +1,91 @@
+#include "server/overload_manager_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "common/common/assert.h"
+#include "common/memory/stats.h"
+
+namespace Envoy {
+namespace Server {
+
+OverloadManagerImpl::OverloadManagerImpl(Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
+                                         Stats::Scope& scope, ListenerManager& listener_manager,
+                                         MonotonicTimeSource& time_source)
+    : dispatcher_(dispatcher), runtime_(runtime), listener_manager_(listener_manager),
+      time_source_(time_source),
+      stats_{ALL_OVERLOAD_MANAGER_STATS(POOL_GAUGE_PREFIX(scope, "overload."))} {}
+
+void OverloadManagerImpl::start() {
+  ASSERT(!timer_);
+  timer_ = dispatcher_.createTimer([this]() -> void { onTimer(); });
+  scheduleCheck();
+}
+
+uint64_t OverloadManagerImpl::resourcePressure(uint64_t used, uint64_t limit) {
+  return limit == 0 ? 0 : used * 100 / limit;
+}
+
+void OverloadManagerImpl::check(uint64_t event_loop_lag_ms) {
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  uint64_t pressure = 0;
+  pressure =
+      std::max(pressure, resourcePressure(Memory::Stats::totalCurrentlyAllocated(),
+                                          snapshot.getInteger("overload.max_heap_bytes", 0)));
+  pressure =
+      std::max(pressure, resourcePressure(Memory::Stats::totalBufferSlabBytes(),
+                                          snapshot.getInteger("overload.max_buffer_bytes", 0)));
+  pressure = std::max(pressure,
+                      resourcePressure(listener_manager_.numConnections(),
+                                       snapshot.getInteger("overload.max_active_connections", 0)));
+  pressure = std::max(pressure,
+                      resourcePressure(event_loop_lag_ms,
+                                       snapshot.getInteger("overload.max_event_loop_lag_ms", 0)));
+  stats_.pressure_.set(pressure);
+
+  // The actions default to shedding progressively more as the pressure rises.
+  const bool active = pressure > 0;
+  disable_keepalive_ =
+      active && pressure >= snapshot.getInteger("overload.disable_keepalive_percent", 80);
+  reject_new_streams_ =
+      active && pressure >= snapshot.getInteger("overload.reject_new_streams_percent", 95);
+  const bool stop_accepting_connections =
+      active && pressure >= snapshot.getInteger("overload.stop_accepting_percent", 100);
+  stats_.keepalive_disabled_.set(disable_keepalive_);
+  stats_.new_streams_rejected_.set(reject_new_streams_);
+  stats_.accept_disabled_.set(stop_accepting_connections);
+
+  if (stop_accepting_connections != stop_accepting_connections_) {
+    stop_accepting_connections_ = stop_accepting_connections;
+    if (stop_accepting_connections) {
+      ENVOY_LOG(warn, "overload: pressure at {}%, no longer accepting connections", pressure);
+      listener_manager_.disableListeners();
+    } else {
+      ENVOY_LOG(warn, "overload: pressure at {}%, accepting connections again", pressure);
+      listener_manager_.enableListeners();
+    }
+  }
+}
+
+void OverloadManagerImpl::onTimer() {
+  // The timer firing late means that the event loop is falling behind.
+  const MonotonicTime now = time_source_.currentTime();
+  const uint64_t event_loop_lag_ms =
+      now > next_check_
+          ? std::chrono::duration_cast<std::chrono::milliseconds>(now - next_check_).count()
+          : 0;
+  stats_.event_loop_lag_ms_.set(event_loop_lag_ms);
+  check(event_loop_lag_ms);
+  scheduleCheck();
+}
+
+void OverloadManagerImpl::scheduleCheck() {
+  const std::chrono::milliseconds interval(std::max<uint64_t>(
+      1, runtime_.snapshot().getInteger("overload.check_interval_ms", 1000)));
+  next_check_ = time_source_.currentTime() + interval;
+  timer_->enableTimer(interval);
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/server/listener_manager.h"
+#include "envoy/server/overload_manager.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * All overload manager stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_OVERLOAD_MANAGER_STATS(GAUGE)                                                          \
+  GAUGE(pressure)                                                                                  \
+  GAUGE(event_loop_lag_ms)                                                                         \
+  GAUGE(keepalive_disabled)                                                                        \
+  GAUGE(accept_disabled)                                                                           \
+  GAUGE(new_streams_rejected)
+// clang-format on
+
+/**
+ * Struct definition for all overload manager stats. @see stats_macros.h
+ */
+struct OverloadManagerStats {
+  ALL_OVERLOAD_MANAGER_STATS(GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Overload manager which periodically samples, on the main thread, the heap, the memory held by
+ * buffers, the number of connections and the lag of the main event loop. Each resource with a
+ * limit set in runtime contributes its usage as a percentage of the limit, and the highest of
+ * these is the pressure of the server. Each action is in effect while the pressure is at or above
+ * the action's runtime threshold. All limits default to 0, which disables the resource, so nothing
+ * is shed unless configured.
+ */
+class OverloadManagerImpl : Logger::Loggable<Logger::Id::main>, public OverloadManager {
+public:
+  OverloadManagerImpl(Event::Dispatcher& dispatcher, Runtime::Loader& runtime, Stats::Scope& scope,
+                      ListenerManager& listener_manager, MonotonicTimeSource& time_source);
+
+  /**
+   * Start the periodic checks. This should be called once the workers have been started. Until
+   * then, no action is in effect.
+   */
+  void start();
+
+  // Server::OverloadManager
+  bool disableKeepalive() const override { return disable_keepalive_; }
+  bool stopAcceptingConnections() const override { return stop_accepting_connections_; }
+  bool rejectNewStreams() const override { return reject_new_streams_; }
+
+private:
+  static uint64_t resourcePressure(uint64_t used, uint64_t limit);
+  void check(uint64_t event_loop_lag_ms);
+  void onTimer();
+  void scheduleCheck();
+
+  Event::Dispatcher& dispatcher_;
+  Runtime::Loader& runtime_;
+  ListenerManager& listener_manager_;
+  MonotonicTimeSource& time_source_;
+  OverloadManagerStats stats_;
+  Event::TimerPtr timer_;
+  // When the timer is due to fire. How late it fires is the lag of the event loop.
+  MonotonicTime next_check_;
+  std::atomic<bool> disable_keepalive_{};
+  std::atomic<bool> stop_accepting_connections_{};
+  std::atomic<bool> reject_new_streams_{};
+};
+
+} // namespace Server
+} // namespace Envoy
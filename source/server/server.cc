@@ -2,6 +2,7 @@
 
 #include <signal.h>
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <string>
@@ -23,6 +24,7 @@
 #include "common/local_info/local_info_impl.h"
 #include "common/memory/stats.h"
 #include "common/network/address_impl.h"
+#include "common/network/caching_dns_resolver_impl.h"
 #include "common/protobuf/utility.h"
 #include "common/router/rds_impl.h"
 #include "common/runtime/runtime_impl.h"
@@ -45,12 +47,17 @@ InstanceImpl::InstanceImpl(Options& options, Network::Address::InstanceConstShar
                            Thread::BasicLockable& access_log_lock,
                            ComponentFactory& component_factory, ThreadLocal::Instance& tls)
     : options_(options), restarter_(restarter), start_time_(time(nullptr)),
-      original_start_time_(start_time_), stats_store_(store), thread_local_(tls),
+      original_start_time_(start_time_),
+      start_monotonic_time_(ProdMonotonicTimeSource::instance_.currentTime()), stats_store_(store),
+      thread_local_(tls),
       api_(new Api::Impl(options.fileFlushIntervalMsec())), dispatcher_(api_->allocateDispatcher()),
       singleton_manager_(new Singleton::ManagerImpl()),
       handler_(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher_)),
-      listener_component_factory_(*this), worker_factory_(thread_local_, *api_, hooks),
-      dns_resolver_(dispatcher_->createDnsResolver({})),
+      listener_component_factory_(*this),
+      worker_factory_(thread_local_, *api_, hooks, store, options),
+      dns_resolver_(new Network::CachingDnsResolverImpl(
+          *dispatcher_, dispatcher_->createDnsResolver({}), options.dnsCacheTtl(), store,
+          ProdMonotonicTimeSource::instance_)),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store) {
 
   try {
@@ -98,18 +105,16 @@ void InstanceImpl::failHealthcheck(bool fail) {
   server_stats_->live_.set(!fail);
 }
 
-void InstanceUtil::flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                                 Stats::Store& store) {
+void InstanceUtil::flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks,
+                                       Stats::Store& store) {
   for (const auto& sink : sinks) {
     sink->beginFlush();
   }
 
-  for (const Stats::CounterSharedPtr& counter : store.counters()) {
+  for (const Stats::CounterSharedPtr& counter : store.dirtyCounters()) {
     uint64_t delta = counter->latch();
-    if (counter->used()) {
-      for (const auto& sink : sinks) {
-        sink->flushCounter(*counter, delta);
-      }
+    for (const auto& sink : sinks) {
+      sink->flushCounter(*counter, delta);
     }
   }
 
@@ -121,6 +126,15 @@ void InstanceUtil::flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>
     }
   }
 
+  for (const Stats::ParentHistogramSharedPtr& histogram : store.histograms()) {
+    histogram->merge();
+    if (histogram->used()) {
+      for (const auto& sink : sinks) {
+        sink->flushHistogram(*histogram);
+      }
+    }
+  }
+
   for (const auto& sink : sinks) {
     sink->endFlush();
   }
@@ -134,12 +148,14 @@ void InstanceImpl::flushStats() {
   server_stats_->memory_allocated_.set(Memory::Stats::totalCurrentlyAllocated() +
                                        info.memory_allocated_);
   server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
+  server_stats_->memory_buffered_.set(Memory::Stats::totalBufferSlabBytes());
   server_stats_->parent_connections_.set(info.num_connections_);
   server_stats_->total_connections_.set(numConnections() + info.num_connections_);
   server_stats_->days_until_first_cert_expiring_.set(
       sslContextManager().daysUntilFirstCertExpires());
+  server_stats_->log_messages_dropped_.set(Logger::Registry::getSink()->droppedMessages());
 
-  InstanceUtil::flushCountersAndGaugesToSinks(config_->statsSinks(), stats_store_);
+  InstanceUtil::flushMetricsToSinks(config_->statsSinks(), stats_store_);
   stat_flush_timer_->enableTimer(config_->statsFlushInterval());
 }
 
@@ -218,6 +234,9 @@ void InstanceImpl::initialize(Options& options,
 
   // We can now initialize stats for threading.
   stats_store_.initializeThreading(*dispatcher_, thread_local_);
+  if (options.dispatcherStats()) {
+    dispatcher_->initializeStats(stats_store_, "server.dispatcher.");
+  }
 
   // Runtime gets initialized before the main configuration since during main configuration
   // load things may grab a reference to the loader for later use.
@@ -226,6 +245,10 @@ void InstanceImpl::initialize(Options& options,
   // Once we have runtime we can initialize the SSL context manager.
   ssl_context_manager_.reset(new Ssl::ContextManagerImpl(*runtime_loader_));
 
+  overload_manager_.reset(new OverloadManagerImpl(*dispatcher_, *runtime_loader_, stats_store_,
+                                                  *listener_manager_,
+                                                  ProdMonotonicTimeSource::instance_));
+
   cluster_manager_factory_.reset(new Upstream::ProdClusterManagerFactory(
       runtime(), stats(), threadLocal(), random(), dnsResolver(), sslContextManager(), dispatcher(),
       localInfo()));
@@ -249,10 +272,21 @@ void InstanceImpl::initialize(Options& options,
   // started and before our own run() loop runs.
   guard_dog_.reset(
       new Server::GuardDogImpl(stats_store_, *config_, ProdMonotonicTimeSource::instance_));
+
+  server_stats_->initialization_time_ms_.set(msSinceStart());
+}
+
+uint64_t InstanceImpl::msSinceStart() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             ProdMonotonicTimeSource::instance_.currentTime() - start_monotonic_time_)
+      .count();
 }
 
 void InstanceImpl::startWorkers() {
   listener_manager_->startWorkers(*guard_dog_);
+  overload_manager_->start();
+  server_stats_->workers_started_time_ms_.set(msSinceStart());
+  ENVOY_LOG(info, "workers started {}ms after startup", msSinceStart());
 
   // At this point we are ready to take traffic and all listening ports are up. Notify our parent
   // if applicable that they can stop listening and drain.
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "envoy/common/optional.h"
+#include "envoy/common/time.h"
 #include "envoy/server/configuration.h"
 #include "envoy/server/drain_manager.h"
 #include "envoy/server/guarddog.h"
@@ -24,6 +25,7 @@
 #include "server/http/admin.h"
 #include "server/init_manager_impl.h"
 #include "server/listener_manager_impl.h"
+#include "server/overload_manager_impl.h"
 #include "server/test_hooks.h"
 #include "server/worker_impl.h"
 
@@ -38,11 +40,15 @@ namespace Server {
   GAUGE(uptime)                                                                                    \
   GAUGE(memory_allocated)                                                                          \
   GAUGE(memory_heap_size)                                                                          \
+  GAUGE(memory_buffered)                                                                           \
   GAUGE(live)                                                                                      \
   GAUGE(parent_connections)                                                                        \
   GAUGE(total_connections)                                                                         \
   GAUGE(version)                                                                                   \
-  GAUGE(days_until_first_cert_expiring)
+  GAUGE(days_until_first_cert_expiring)                                                            \
+  GAUGE(initialization_time_ms)                                                                    \
+  GAUGE(workers_started_time_ms)                                                                   \
+  GAUGE(log_messages_dropped)
 // clang-format on
 
 struct ServerStats {
@@ -79,13 +85,13 @@ public:
   static Runtime::LoaderPtr createRuntime(Instance& server, Server::Configuration::Initial& config);
 
   /**
-   * Helper for flushing counters and gauges to sinks. This takes care of calling beginFlush(),
-   * latching of counters and flushing, flushing of gauges, and calling endFlush(), on each sink.
+   * Helper for flushing counters, gauges and histograms to sinks. This takes care of calling
+   * beginFlush(), latching of counters and flushing, flushing of gauges, merging of histograms and
+   * flushing, and calling endFlush(), on each sink.
    * @param sinks supplies the list of sinks.
    * @param store supplies the store to flush.
    */
-  static void flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                            Stats::Store& store);
+  static void flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store);
 };
 
 /**
@@ -145,6 +151,7 @@ public:
   Singleton::Manager& singletonManager() override { return *singleton_manager_; }
   bool healthCheckFailed() override;
   Options& options() override { return options_; }
+  OverloadManager& overloadManager() override { return *overload_manager_; }
   time_t startTimeCurrentEpoch() override { return start_time_; }
   time_t startTimeFirstEpoch() override { return original_start_time_; }
   Stats::Store& stats() override { return stats_store_; }
@@ -157,6 +164,7 @@ private:
   void initialize(Options& options, Network::Address::InstanceConstSharedPtr local_address,
                   ComponentFactory& component_factory);
   void loadServerFlags(const Optional<std::string>& flags_path);
+  uint64_t msSinceStart();
   uint64_t numConnections();
   void startWorkers();
 
@@ -164,6 +172,7 @@ private:
   HotRestart& restarter_;
   const time_t start_time_;
   time_t original_start_time_;
+  const MonotonicTime start_monotonic_time_;
   Stats::StoreRoot& stats_store_;
   std::vector<Stats::TagExtractorPtr> tag_extractors_;
   std::unique_ptr<ServerStats> server_stats_;
@@ -179,6 +188,7 @@ private:
   ProdListenerComponentFactory listener_component_factory_;
   ProdWorkerFactory worker_factory_;
   std::unique_ptr<ListenerManager> listener_manager_;
+  std::unique_ptr<OverloadManagerImpl> overload_manager_;
   std::unique_ptr<Configuration::Main> config_;
   Stats::ScopePtr admin_scope_;
   Network::DnsResolverSharedPtr dns_resolver_;
@@ -1,6 +1,8 @@
 #include "server/worker_impl.h"
 
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
@@ -11,19 +13,51 @@
 
 #include "server/connection_handler_impl.h"
 
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Server {
 
 WorkerPtr ProdWorkerFactory::createWorker() {
+  const std::string prefix = fmt::format("server.worker_{}.", next_worker_index_);
   Event::DispatcherPtr dispatcher(api_.allocateDispatcher());
-  return WorkerPtr{new WorkerImpl(
-      tls_, hooks_, std::move(dispatcher),
-      Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher)})};
+  if (options_.dispatcherStats()) {
+    dispatcher->initializeStats(stats_, prefix + "dispatcher.");
+  }
+  if (options_.busyPoll().count() > 0) {
+    dispatcher->enableBusyPoll(options_.busyPoll(), stats_, prefix + "dispatcher.");
+  }
+  if (options_.deferredDeleteBudget().count() > 0) {
+    dispatcher->setDeferredDeleteBudget(options_.deferredDeleteBudget());
+  }
+
+  std::unique_ptr<ConnectionHandlerImpl> handler;
+  if (options_.workerStats()) {
+    handler.reset(new ConnectionHandlerImpl(
+        ENVOY_LOGGER(), *dispatcher,
+        WorkerStats{ALL_WORKER_STATS(POOL_COUNTER_PREFIX(stats_, prefix),
+                                     POOL_GAUGE_PREFIX(stats_, prefix))}));
+  } else {
+    handler.reset(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher,
+                                            stats_.gauge(prefix + "downstream_cx_active")));
+  }
+  handler->setIdleMemoryRelease(options_.idleMemoryRelease());
+
+  const uint32_t index = next_worker_index_++;
+  std::unique_ptr<WorkerImpl> worker(
+      new WorkerImpl(tls_, hooks_, std::move(dispatcher), std::move(handler), index));
+  const std::vector<uint32_t>& cpus = options_.workerCpus();
+  if (!cpus.empty()) {
+    worker->setCpu(cpus[index % cpus.size()]);
+  }
+  return WorkerPtr{worker.release()};
 }
 
 WorkerImpl::WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks,
-                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler)
-    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)) {
+                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler,
+                       uint32_t index)
+    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)),
+      index_(index) {
   tls_.registerThread(*dispatcher_, false);
 }
 
@@ -47,13 +81,15 @@ void WorkerImpl::addListenerWorker(Listener& listener) {
                                                      .use_proxy_proto_ = listener.useProxyProto(),
                                                      .use_original_dst_ = listener.useOriginalDst(),
                                                      .per_connection_buffer_limit_bytes_ =
-                                                         listener.perConnectionBufferLimitBytes()};
+                                                         listener.perConnectionBufferLimitBytes(),
+                                                     .connection_balancer_ =
+                                                         listener.connectionBalancer()};
   if (listener.sslContext()) {
     handler_->addSslListener(listener.filterChainFactory(), *listener.sslContext(),
-                             listener.socket(), listener.listenerScope(), listener.listenerTag(),
-                             listener_options);
+                             listener.workerSocket(index_), listener.listenerScope(),
+                             listener.listenerTag(), listener_options);
   } else {
-    handler_->addListener(listener.filterChainFactory(), listener.socket(),
+    handler_->addListener(listener.filterChainFactory(), listener.workerSocket(index_),
                           listener.listenerScope(), listener.listenerTag(), listener_options);
   }
 
@@ -103,7 +139,25 @@ void WorkerImpl::stopListeners() {
   dispatcher_->post([this]() -> void { handler_->stopListeners(); });
 }
 
+void WorkerImpl::disableListeners() {
+  ASSERT(thread_);
+  dispatcher_->post([this]() -> void { handler_->disableListeners(); });
+}
+
+void WorkerImpl::enableListeners() {
+  ASSERT(thread_);
+  dispatcher_->post([this]() -> void { handler_->enableListeners(); });
+}
+
 void WorkerImpl::threadRoutine(GuardDog& guard_dog) {
+  if (cpu_.valid()) {
+    if (Thread::pinCurrentThread(cpu_.value())) {
+      ENVOY_LOG(info, "worker {} pinned to cpu {}", index_, cpu_.value());
+    } else {
+      ENVOY_LOG(warn, "worker {} could not be pinned to cpu {}", index_, cpu_.value());
+    }
+  }
+
   ENVOY_LOG(info, "worker entering dispatch loop");
   auto watchdog = guard_dog.createWatchDog(Thread::Thread::currentThreadId());
   watchdog->startWatchdog(*dispatcher_);
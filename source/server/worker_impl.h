@@ -4,10 +4,13 @@
 #include <memory>
 
 #include "envoy/api/api.h"
+#include "envoy/common/optional.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/server/guarddog.h"
 #include "envoy/server/listener_manager.h"
+#include "envoy/server/options.h"
 #include "envoy/server/worker.h"
+#include "envoy/stats/stats.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
@@ -20,8 +23,9 @@ namespace Server {
 
 class ProdWorkerFactory : public WorkerFactory, Logger::Loggable<Logger::Id::main> {
 public:
-  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks)
-      : tls_(tls), api_(api), hooks_(hooks) {}
+  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks,
+                    Stats::Scope& stats, Options& options)
+      : tls_(tls), api_(api), hooks_(hooks), stats_(stats), options_(options) {}
 
   // Server::WorkerFactory
   WorkerPtr createWorker() override;
@@ -30,6 +34,9 @@ private:
   ThreadLocal::Instance& tls_;
   Api::Api& api_;
   TestHooks& hooks_;
+  Stats::Scope& stats_;
+  Options& options_;
+  uint32_t next_worker_index_{};
 };
 
 /**
@@ -37,8 +44,12 @@ private:
  */
 class WorkerImpl : public Worker, Logger::Loggable<Logger::Id::main> {
 public:
+  /**
+   * @param index supplies the index of the worker, which picks the socket it listens on for
+   *        listeners which give each worker a socket of its own. @see Listener::workerSocket().
+   */
   WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks, Event::DispatcherPtr&& dispatcher,
-             Network::ConnectionHandlerPtr handler);
+             Network::ConnectionHandlerPtr handler, uint32_t index);
 
   // Server::Worker
   void addListener(Listener& listener, AddListenerCompletion completion) override;
@@ -48,6 +59,14 @@ public:
   void stop() override;
   void stopListener(Listener& listener) override;
   void stopListeners() override;
+  void disableListeners() override;
+  void enableListeners() override;
+
+  /**
+   * Pin the worker's thread to a CPU once it starts.
+   * @param cpu supplies the index of the CPU.
+   */
+  void setCpu(uint32_t cpu) { cpu_.value(cpu); }
 
 private:
   void addListenerWorker(Listener& listener);
@@ -58,6 +77,8 @@ private:
   Event::DispatcherPtr dispatcher_;
   Network::ConnectionHandlerPtr handler_;
   Thread::ThreadPtr thread_;
+  const uint32_t index_;
+  Optional<uint32_t> cpu_;
 };
 
 } // namespace Server
@@ -0,0 +1,69 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Buffer {
+
+// Adds a chunk of the given size and drains it, as a connection does for every read.
+static void BM_BufferAddDrain(benchmark::State& state) {
+  const std::string data(state.range(0), 'a');
+  OwnedImpl buffer;
+  while (state.KeepRunning()) {
+    buffer.add(data);
+    buffer.drain(buffer.length());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferAddDrain)->Arg(16)->Arg(4096)->Arg(65536);
+
+// Moves a whole buffer into another, as data passes from a read buffer through the filters.
+static void BM_BufferMove(benchmark::State& state) {
+  const std::string data(state.range(0), 'a');
+  OwnedImpl source;
+  OwnedImpl destination;
+  while (state.KeepRunning()) {
+    source.add(data);
+    destination.move(source);
+    destination.drain(destination.length());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferMove)->Arg(16)->Arg(4096)->Arg(65536);
+
+// Moves part of a buffer into another, as the codecs do when framing a body.
+static void BM_BufferMovePartial(benchmark::State& state) {
+  const std::string data(65536, 'a');
+  const uint64_t length = state.range(0);
+  OwnedImpl source;
+  OwnedImpl destination;
+  while (state.KeepRunning()) {
+    if (source.length() < length) {
+      source.add(data);
+    }
+    destination.move(source, length);
+    destination.drain(destination.length());
+  }
+  state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_BufferMovePartial)->Arg(16)->Arg(4096)->Arg(16384);
+
+// Drains a large buffer in small steps, as a parser consumes its input.
+static void BM_BufferDrainPartial(benchmark::State& state) {
+  const std::string data(65536, 'a');
+  const uint64_t length = state.range(0);
+  OwnedImpl buffer;
+  while (state.KeepRunning()) {
+    if (buffer.length() < length) {
+      buffer.add(data);
+    }
+    buffer.drain(length);
+  }
+  state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_BufferDrainPartial)->Arg(16)->Arg(4096);
+
+} // namespace Buffer
+} // namespace Envoy
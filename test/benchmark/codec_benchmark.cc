@@ -0,0 +1,158 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http1/codec_impl.h"
+#include "common/http/http2/codec_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/network/mocks.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+const char REQUEST[] = "GET /api/v1/users/12345?include=profile HTTP/1.1\r\n"
+                       "host: api.example.com\r\n"
+                       "user-agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+                       "accept: application/json\r\n"
+                       "accept-encoding: gzip, deflate\r\n"
+                       "x-forwarded-for: 10.0.0.1\r\n"
+                       "x-request-id: a121e9e1-feae-4136-9e0e-6fac343d56c9\r\n"
+                       "\r\n";
+
+HeaderMapImpl requestHeaders() {
+  return HeaderMapImpl{{Headers::get().Method, "GET"},
+                       {Headers::get().Path, "/api/v1/users/12345?include=profile"},
+                       {Headers::get().Host, "api.example.com"},
+                       {Headers::get().Scheme, "https"},
+                       {Headers::get().UserAgent, "Mozilla/5.0 (X11; Linux x86_64)"},
+                       {LowerCaseString("accept"), "application/json"},
+                       {Headers::get().RequestId, "a121e9e1-feae-4136-9e0e-6fac343d56c9"}};
+}
+
+HeaderMapImpl responseHeaders() {
+  return HeaderMapImpl{{Headers::get().Status, "200"},
+                       {Headers::get().ContentType, "application/json"},
+                       {Headers::get().ContentLength, "2"},
+                       {Headers::get().EnvoyUpstreamServiceTime, "3"}};
+}
+
+/**
+ * The parts of a connection which the codecs need. The network connections are mocks, so they
+ * cost the same for every change that is measured.
+ */
+struct ServerFixture {
+  ServerFixture() {
+    ON_CALL(callbacks_, newStream(_))
+        .WillByDefault(Invoke([this](StreamEncoder& encoder) -> StreamDecoder& {
+          response_encoder_ = &encoder;
+          return request_decoder_;
+        }));
+  }
+
+  NiceMock<Network::MockConnection> connection_;
+  NiceMock<MockServerConnectionCallbacks> callbacks_;
+  NiceMock<MockStreamDecoder> request_decoder_;
+  StreamEncoder* response_encoder_{};
+};
+
+} // namespace
+
+// Decodes a request and encodes its response on a keep-alive HTTP/1.1 server connection.
+static void BM_Http1ServerRequestResponse(benchmark::State& state) {
+  ServerFixture fixture;
+  ON_CALL(fixture.connection_, write(_)).WillByDefault(Invoke([](Buffer::Instance& data) -> void {
+    data.drain(data.length());
+  }));
+  Http1Settings settings;
+  settings.fast_parser_ = state.range(0) != 0;
+  Http1::ServerConnectionImpl codec(fixture.connection_, fixture.callbacks_, settings);
+
+  HeaderMapImpl response_headers = responseHeaders();
+  while (state.KeepRunning()) {
+    Buffer::OwnedImpl request(REQUEST, sizeof(REQUEST) - 1);
+    codec.dispatch(request);
+
+    Buffer::OwnedImpl body("{}");
+    fixture.response_encoder_->encodeHeaders(response_headers, false);
+    fixture.response_encoder_->encodeData(body, true);
+  }
+}
+// Argument 1 decodes with the fast parser.
+BENCHMARK(BM_Http1ServerRequestResponse)->Arg(0)->Arg(1);
+
+namespace {
+
+/**
+ * Passes the data that one end of an HTTP/2 connection writes to the other end.
+ */
+struct ConnectionWrapper {
+  void dispatch(Buffer::Instance& data, Http2::ConnectionImpl& connection) {
+    buffer_.move(data);
+    if (!dispatching_) {
+      while (buffer_.length() > 0) {
+        dispatching_ = true;
+        connection.dispatch(buffer_);
+        dispatching_ = false;
+      }
+    }
+  }
+
+  bool dispatching_{};
+  Buffer::OwnedImpl buffer_;
+};
+
+} // namespace
+
+// Encodes a request on an HTTP/2 client connection, decodes it on a server connection and sends
+// the response back, so that both HPACK directions and the framing are measured.
+static void BM_Http2RequestResponse(benchmark::State& state) {
+  Stats::IsolatedStoreImpl stats_store;
+  Http2Settings settings;
+
+  NiceMock<Network::MockConnection> client_connection;
+  NiceMock<MockConnectionCallbacks> client_callbacks;
+  Http2::ClientConnectionImpl client(client_connection, client_callbacks, stats_store, settings);
+  ConnectionWrapper client_wrapper;
+
+  ServerFixture server_fixture;
+  Http2::ServerConnectionImpl server(server_fixture.connection_, server_fixture.callbacks_,
+                                     stats_store, settings);
+  ConnectionWrapper server_wrapper;
+
+  ON_CALL(client_connection, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+    server_wrapper.dispatch(data, server);
+  }));
+  ON_CALL(server_fixture.connection_, write(_))
+      .WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+        client_wrapper.dispatch(data, client);
+      }));
+
+  NiceMock<MockStreamDecoder> response_decoder;
+  HeaderMapImpl request_headers = requestHeaders();
+  HeaderMapImpl response_headers = responseHeaders();
+  while (state.KeepRunning()) {
+    StreamEncoder& request_encoder = client.newStream(response_decoder);
+    request_encoder.encodeHeaders(request_headers, true);
+
+    Buffer::OwnedImpl body("{}");
+    server_fixture.response_encoder_->encodeHeaders(response_headers, false);
+    server_fixture.response_encoder_->encodeData(body, true);
+
+    // Closed streams are deferred deleted, which the mock dispatchers leave to the test.
+    client_connection.dispatcher_.to_delete_.clear();
+    server_fixture.connection_.dispatcher_.to_delete_.clear();
+  }
+}
+BENCHMARK(BM_Http2RequestResponse);
+
+} // namespace Http
+} // namespace Envoy
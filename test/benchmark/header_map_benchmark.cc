@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Adds the headers of a typical proxied request, followed by custom headers which have no inline
+ * slot.
+ */
+static void addRequestHeaders(HeaderMap& headers, const std::vector<LowerCaseString>& custom) {
+  headers.insertMethod().value(std::string("GET"));
+  headers.insertPath().value(std::string("/api/v1/users/12345?include=profile"));
+  headers.insertHost().value(std::string("api.example.com"));
+  headers.insertScheme().value(std::string("https"));
+  headers.insertUserAgent().value(std::string("Mozilla/5.0 (X11; Linux x86_64)"));
+  headers.insertForwardedProto().value(std::string("https"));
+  headers.insertForwardedFor().value(std::string("10.0.0.1"));
+  headers.insertRequestId().value(std::string("a121e9e1-feae-4136-9e0e-6fac343d56c9"));
+  for (const LowerCaseString& key : custom) {
+    headers.addCopy(key, "value");
+  }
+}
+
+static std::vector<LowerCaseString> customHeaders(int64_t count) {
+  std::vector<LowerCaseString> custom;
+  for (int64_t i = 0; i < count; i++) {
+    custom.emplace_back(fmt::format("x-custom-header-{}", i));
+  }
+  return custom;
+}
+
+// Builds a request header map from scratch, as a codec does for every request.
+static void BM_HeaderMapInsert(benchmark::State& state) {
+  const std::vector<LowerCaseString> custom = customHeaders(state.range(0));
+  while (state.KeepRunning()) {
+    HeaderMapImpl headers;
+    addRequestHeaders(headers, custom);
+    benchmark::DoNotOptimize(headers.size());
+  }
+}
+BENCHMARK(BM_HeaderMapInsert)->Arg(0)->Arg(8)->Arg(32);
+
+// Looks up a header with an inline slot.
+static void BM_HeaderMapLookupInline(benchmark::State& state) {
+  const std::vector<LowerCaseString> custom = customHeaders(state.range(0));
+  HeaderMapImpl headers;
+  addRequestHeaders(headers, custom);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(headers.Host());
+  }
+}
+BENCHMARK(BM_HeaderMapLookupInline)->Arg(0)->Arg(32);
+
+// Looks up the last custom header by name, which walks the headers without an inline slot.
+static void BM_HeaderMapLookupByName(benchmark::State& state) {
+  const std::vector<LowerCaseString> custom = customHeaders(state.range(0));
+  HeaderMapImpl headers;
+  addRequestHeaders(headers, custom);
+  const LowerCaseString& key = custom.back();
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(headers.get(key));
+  }
+}
+BENCHMARK(BM_HeaderMapLookupByName)->Arg(1)->Arg(8)->Arg(32);
+
+static HeaderMap::Iterate countHeader(const HeaderEntry& header, void* context) {
+  *static_cast<size_t*>(context) += header.value().size();
+  return HeaderMap::Iterate::Continue;
+}
+
+// Visits every header, as the codecs do when encoding.
+static void BM_HeaderMapIterate(benchmark::State& state) {
+  const std::vector<LowerCaseString> custom = customHeaders(state.range(0));
+  HeaderMapImpl headers;
+  addRequestHeaders(headers, custom);
+  while (state.KeepRunning()) {
+    size_t size = 0;
+    headers.iterate(countHeader, &size);
+    benchmark::DoNotOptimize(size);
+  }
+}
+BENCHMARK(BM_HeaderMapIterate)->Arg(0)->Arg(8)->Arg(32);
+
+// Copies a request header map, as the router does for every retry and shadow.
+static void BM_HeaderMapCopy(benchmark::State& state) {
+  const std::vector<LowerCaseString> custom = customHeaders(state.range(0));
+  HeaderMapImpl headers;
+  addRequestHeaders(headers, custom);
+  while (state.KeepRunning()) {
+    HeaderMapImpl copy(static_cast<const HeaderMap&>(headers));
+    benchmark::DoNotOptimize(copy.size());
+  }
+}
+BENCHMARK(BM_HeaderMapCopy)->Arg(0)->Arg(32);
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,22 @@
+// NOLINT(namespace-envoy)
+#include "common/common/logger.h"
+#include "common/common/thread.h"
+#include "common/event/libevent.h"
+
+#include "benchmark/benchmark.h"
+#include "spdlog/spdlog.h"
+
+// The main entry point for the benchmark binaries under test/benchmark. Logging is kept at warn,
+// so that debug logging on the data path does not end up in the numbers.
+int main(int argc, char** argv) {
+  Envoy::Event::Libevent::Global::initialize();
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Registry::initialize(spdlog::level::warn, lock);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <string>
+
+#include "common/upstream/ring_hash_lb.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+class TestLoadBalancerContext : public LoadBalancerContext {
+public:
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return hash_key_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+  const Network::Connection* downstreamConnection() const override { return nullptr; }
+
+  Optional<uint64_t> hash_key_;
+};
+
+} // namespace
+
+// Picks a host for a new hash key every time, so that the ring lookup is not served from cache.
+static void BM_RingHashLoadBalancerChooseHost(benchmark::State& state) {
+  NiceMock<MockCluster> cluster;
+  Stats::IsolatedStoreImpl stats_store;
+  ClusterStats stats(ClusterInfoImpl::generateStats(stats_store));
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Runtime::MockRandomGenerator> random;
+  RingHashLoadBalancer lb(cluster, stats, runtime, random);
+
+  for (int64_t i = 0; i < state.range(0); i++) {
+    cluster.hosts_.push_back(
+        makeTestHost(cluster.info_, fmt::format("tcp://10.0.{}.{}:80", i / 256, i % 256)));
+  }
+  cluster.healthy_hosts_ = cluster.hosts_;
+  cluster.runCallbacks({}, {});
+
+  TestLoadBalancerContext context;
+  uint64_t hash = 0;
+  while (state.KeepRunning()) {
+    // Consecutive keys would walk the ring in order, so they are spread with a large odd step.
+    hash += 0x9e3779b97f4a7c15;
+    context.hash_key_.value(hash);
+    benchmark::DoNotOptimize(lb.chooseHost(&context));
+  }
+}
+BENCHMARK(BM_RingHashLoadBalancerChooseHost)->Arg(10)->Arg(100)->Arg(1000);
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,65 @@
+#include <string>
+
+#include "common/config/rds_json.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+#include "common/router/config_impl.h"
+
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+/**
+ * @return a route table of virtual_hosts virtual hosts, each with routes prefix routes.
+ */
+envoy::api::v2::RouteConfiguration routeConfiguration(int64_t virtual_hosts, int64_t routes) {
+  std::string json = R"EOF({"virtual_hosts": [)EOF";
+  for (int64_t i = 0; i < virtual_hosts; i++) {
+    json += fmt::format(R"EOF({}{{"name": "vhost{}", "domains": ["service{}.example.com"], )EOF",
+                        i == 0 ? "" : ",", i, i);
+    json += R"EOF("routes": [)EOF";
+    for (int64_t j = 0; j < routes; j++) {
+      json += fmt::format(R"EOF({}{{"prefix": "/route{}/", "cluster": "cluster{}"}})EOF",
+                          j == 0 ? "" : ",", j, j);
+    }
+    json += "]}";
+  }
+  json += "]}";
+
+  envoy::api::v2::RouteConfiguration route_config;
+  Envoy::Config::RdsJson::translateRouteConfiguration(*Json::Factory::loadFromString(json),
+                                                      route_config);
+  return route_config;
+}
+
+} // namespace
+
+// Routes a request which matches the last route of a virtual host in the middle of the table,
+// which is the worst case of the linear route match.
+static void BM_RouteMatcherRoute(benchmark::State& state) {
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  const int64_t virtual_hosts = state.range(0);
+  const int64_t routes = state.range(1);
+  ConfigImpl config(routeConfiguration(virtual_hosts, routes), runtime, cm, false);
+
+  Http::HeaderMapImpl headers{
+      {Http::Headers::get().Host, fmt::format("service{}.example.com", virtual_hosts / 2)},
+      {Http::Headers::get().Path, fmt::format("/route{}/users/12345", routes - 1)},
+      {Http::Headers::get().Method, "GET"}};
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(config.route(headers, 0));
+  }
+}
+BENCHMARK(BM_RouteMatcherRoute)->Args({1, 1})->Args({1, 100})->Args({100, 10})->Args({1000, 10});
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,67 @@
+#include <string>
+#include <vector>
+
+#include "common/stats/stats_impl.h"
+#include "common/stats/thread_local_store.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Stats {
+
+// Looks up counters which already exist by name, as code which does not keep a reference to its
+// counters does for every request. Argument 1 goes through the per-thread cache.
+static void BM_ThreadLocalStoreCounter(benchmark::State& state) {
+  HeapRawStatDataAllocator alloc;
+  NiceMock<Event::MockDispatcher> main_thread_dispatcher;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  ThreadLocalStoreImpl store(alloc);
+  if (state.range(0)) {
+    store.initializeThreading(main_thread_dispatcher, tls);
+  }
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < 100; i++) {
+    names.push_back(fmt::format("cluster.service_{}.upstream_rq_total", i));
+    store.counter(names.back());
+  }
+
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    store.counter(names[i++ % names.size()]).inc();
+  }
+
+  store.shutdownThreading();
+  tls.shutdownThread();
+}
+BENCHMARK(BM_ThreadLocalStoreCounter)->Arg(0)->Arg(1);
+
+// Looks up counters through a scope, which prefixes every name first.
+static void BM_ThreadLocalStoreScopeCounter(benchmark::State& state) {
+  HeapRawStatDataAllocator alloc;
+  NiceMock<Event::MockDispatcher> main_thread_dispatcher;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  ThreadLocalStoreImpl store(alloc);
+  store.initializeThreading(main_thread_dispatcher, tls);
+
+  {
+    ScopePtr scope = store.createScope("cluster.service_0.");
+    scope->counter("upstream_rq_total");
+    while (state.KeepRunning()) {
+      scope->counter("upstream_rq_total").inc();
+    }
+  }
+
+  store.shutdownThreading();
+  tls.shutdownThread();
+}
+BENCHMARK(BM_ThreadLocalStoreScopeCounter);
+
+} // namespace Stats
+} // namespace Envoy
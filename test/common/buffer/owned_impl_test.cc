@@ -0,0 +1,304 @@
+#include <unistd.h>
+
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+std::string toString(const Instance& buffer) {
+  std::string output;
+  uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  RawSlice slices[num_slices];
+  buffer.getRawSlices(slices, num_slices);
+  for (RawSlice& slice : slices) {
+    output.append(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+  return output;
+}
+
+TEST(OwnedImplTest, AddAndDrain) {
+  OwnedImpl buffer;
+  buffer.add("hello");
+  buffer.add(std::string(" world"));
+  EXPECT_EQ(11, buffer.length());
+  EXPECT_EQ("hello world", toString(buffer));
+
+  buffer.drain(6);
+  EXPECT_EQ("world", toString(buffer));
+  buffer.drain(5);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(0, buffer.getRawSlices(nullptr, 0));
+}
+
+TEST(OwnedImplTest, AddLargerThanSlab) {
+  const std::string large(Slice::DefaultSlabSize * 2 + 7, 'a');
+  OwnedImpl buffer("b");
+  buffer.add(large);
+  EXPECT_EQ(large.size() + 1, buffer.length());
+  EXPECT_EQ("b" + large, toString(buffer));
+
+  buffer.drain(Slice::DefaultSlabSize);
+  EXPECT_EQ(large.size() + 1 - Slice::DefaultSlabSize, buffer.length());
+}
+
+TEST(OwnedImplTest, Prepend) {
+  OwnedImpl buffer;
+  buffer.prepend("world");
+  buffer.prepend("hello ");
+  EXPECT_EQ("hello world", toString(buffer));
+
+  OwnedImpl other("> ");
+  buffer.prepend(other);
+  EXPECT_EQ(0, other.length());
+  EXPECT_EQ("> hello world", toString(buffer));
+  buffer.add("!");
+  EXPECT_EQ("> hello world!", toString(buffer));
+}
+
+TEST(OwnedImplTest, MoveAll) {
+  const std::string large(Slice::DefaultSlabSize, 'x');
+  OwnedImpl source(large);
+  RawSlice slice;
+  source.getRawSlices(&slice, 1);
+
+  OwnedImpl dest("y");
+  dest.move(source);
+  EXPECT_EQ(0, source.length());
+  EXPECT_EQ(large.size() + 1, dest.length());
+
+  // The large slice is transferred to the destination without copying.
+  RawSlice dest_slices[2];
+  EXPECT_EQ(2, dest.getRawSlices(dest_slices, 2));
+  EXPECT_EQ(slice.mem_, dest_slices[1].mem_);
+}
+
+TEST(OwnedImplTest, MovePartialSharesSlab) {
+  const std::string large(Slice::DefaultSlabSize, 'x');
+  OwnedImpl source(large);
+  source.add("tail");
+  RawSlice slice;
+  source.getRawSlices(&slice, 1);
+
+  OwnedImpl dest;
+  dest.move(source, 1000);
+  EXPECT_EQ(1000, dest.length());
+  EXPECT_EQ(large.size() + 4 - 1000, source.length());
+
+  RawSlice dest_slice;
+  EXPECT_EQ(1, dest.getRawSlices(&dest_slice, 1));
+  EXPECT_EQ(slice.mem_, dest_slice.mem_);
+
+  // Appending to either buffer must not clobber the other's data.
+  dest.add("abc");
+  source.add("def");
+  EXPECT_EQ(std::string(1000, 'x') + "abc", toString(dest));
+  EXPECT_EQ(std::string(large.size() - 1000, 'x') + "taildef", toString(source));
+}
+
+TEST(OwnedImplTest, MoveSmall) {
+  OwnedImpl dest("hello");
+  OwnedImpl source(" world");
+  dest.move(source);
+  EXPECT_EQ(0, source.length());
+  EXPECT_EQ(2, dest.getRawSlices(nullptr, 0));
+  EXPECT_EQ("hello world", toString(dest));
+}
+
+class TestFragment : public BufferFragment {
+public:
+  TestFragment(const std::string& data) : data_(data) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return data_.data(); }
+  size_t size() const override { return data_.size(); }
+  void done() override { done_count_++; }
+
+  const std::string data_;
+  uint32_t done_count_{};
+};
+
+TEST(OwnedImplTest, AddBufferFragment) {
+  TestFragment fragment("fragment");
+  {
+    OwnedImpl buffer("a ");
+    buffer.addBufferFragment(fragment);
+    buffer.add("!");
+    EXPECT_EQ("a fragment!", toString(buffer));
+
+    // The fragment is referenced in place and is never written to.
+    RawSlice slices[3];
+    EXPECT_EQ(3, buffer.getRawSlices(slices, 3));
+    EXPECT_EQ(fragment.data(), slices[1].mem_);
+    buffer.prepend("> ");
+    EXPECT_EQ("> a fragment!", toString(buffer));
+
+    // Moving part of the fragment keeps it referenced until both buffers are done with it.
+    OwnedImpl other;
+    other.move(buffer, 8);
+    EXPECT_EQ("> a frag", toString(other));
+    other.drain(other.length());
+    EXPECT_EQ(0, fragment.done_count_);
+    buffer.drain(2);
+    EXPECT_EQ(0, fragment.done_count_);
+    buffer.drain(2);
+    EXPECT_EQ(1, fragment.done_count_);
+    EXPECT_EQ("!", toString(buffer));
+  }
+  EXPECT_EQ(1, fragment.done_count_);
+
+  // Fragments still referenced when the buffer is destroyed are released.
+  TestFragment fragment2("fragment2");
+  { OwnedImpl(fragment2.data_).addBufferFragment(fragment2); }
+  EXPECT_EQ(1, fragment2.done_count_);
+
+  TestFragment empty("");
+  OwnedImpl buffer;
+  buffer.addBufferFragment(empty);
+  EXPECT_EQ(1, empty.done_count_);
+  EXPECT_EQ(0, buffer.length());
+}
+
+TEST(OwnedImplTest, AddShared) {
+  const std::string large(Slice::DefaultSlabSize, 'x');
+  TestFragment fragment("fragment");
+  {
+    OwnedImpl source("a ");
+    source.addBufferFragment(fragment);
+    source.add(large);
+
+    OwnedImpl shared;
+    shared.addShared(source);
+    EXPECT_EQ(source.length(), shared.length());
+    EXPECT_EQ(toString(source), toString(shared));
+
+    RawSlice source_slices[3];
+    RawSlice shared_slices[3];
+    EXPECT_EQ(3, source.getRawSlices(source_slices, 3));
+    EXPECT_EQ(3, shared.getRawSlices(shared_slices, 3));
+    for (uint32_t i = 0; i < 3; i++) {
+      EXPECT_EQ(source_slices[i].mem_, shared_slices[i].mem_);
+    }
+
+    // Writing to either buffer must not clobber the other's data.
+    source.prepend("> ");
+    source.add("!");
+    shared.prepend("< ");
+    shared.add("?");
+    EXPECT_EQ("> a fragment" + large + "!", toString(source));
+    EXPECT_EQ("< a fragment" + large + "?", toString(shared));
+
+    // The fragment is released once neither buffer references it.
+    source.drain(source.length());
+    EXPECT_EQ(0, fragment.done_count_);
+    EXPECT_EQ("< a fragment" + large + "?", toString(shared));
+  }
+  EXPECT_EQ(1, fragment.done_count_);
+}
+
+TEST(OwnedImplTest, ReserveCommit) {
+  OwnedImpl buffer("hello");
+  RawSlice iovecs[2];
+  uint64_t num_iovecs = buffer.reserve(100, iovecs, 2);
+  EXPECT_EQ(1, num_iovecs);
+  EXPECT_GE(iovecs[0].len_, 100);
+  memcpy(iovecs[0].mem_, " world", 6);
+  iovecs[0].len_ = 6;
+  buffer.commit(iovecs, 1);
+  EXPECT_EQ("hello world", toString(buffer));
+
+  // A single iovec reservation larger than the remaining space gets a fresh slab.
+  num_iovecs = buffer.reserve(Slice::DefaultSlabSize, iovecs, 1);
+  EXPECT_EQ(1, num_iovecs);
+  EXPECT_GE(iovecs[0].len_, Slice::DefaultSlabSize);
+  iovecs[0].len_ = 0;
+  buffer.commit(iovecs, 1);
+  EXPECT_EQ(11, buffer.length());
+
+  // A split reservation uses the remaining tail space plus a new slab.
+  num_iovecs = buffer.reserve(Slice::DefaultSlabSize * 2, iovecs, 2);
+  EXPECT_EQ(2, num_iovecs);
+  memset(iovecs[0].mem_, 'a', iovecs[0].len_);
+  memset(iovecs[1].mem_, 'b', 1);
+  const uint64_t first_len = iovecs[0].len_;
+  iovecs[1].len_ = 1;
+  buffer.commit(iovecs, 2);
+  EXPECT_EQ(11 + first_len + 1, buffer.length());
+  EXPECT_EQ('b', toString(buffer).back());
+}
+
+TEST(OwnedImplTest, CopyOutAndLinearize) {
+  OwnedImpl buffer("hello ");
+  OwnedImpl other(std::string(Slice::DefaultSlabSize, 'w'));
+  buffer.move(other);
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+
+  char out[8];
+  buffer.copyOut(4, 4, out);
+  EXPECT_EQ("o ww", std::string(out, 4));
+
+  const char* linear = static_cast<const char*>(buffer.linearize(8));
+  EXPECT_EQ("hello ww", std::string(linear, 8));
+  EXPECT_EQ(Slice::DefaultSlabSize + 6, buffer.length());
+}
+
+TEST(OwnedImplTest, Search) {
+  OwnedImpl buffer("abc");
+  OwnedImpl other(std::string(Slice::DefaultSlabSize, 'd') + "efabc");
+  buffer.move(other);
+
+  EXPECT_EQ(0, buffer.search("abc", 3, 0));
+  EXPECT_EQ(2, buffer.search("cdd", 3, 0));
+  EXPECT_EQ(Slice::DefaultSlabSize + 5, buffer.search("abc", 3, 1));
+  EXPECT_EQ(-1, buffer.search("abcd", 4, 1));
+  EXPECT_EQ(-1, buffer.search("x", 1, 0));
+}
+
+TEST(OwnedImplTest, Shrink) {
+  SlabPool::releaseCachedSlabs();
+  OwnedImpl buffer("hello");
+
+  // A buffer with data keeps it.
+  buffer.shrink();
+  EXPECT_EQ("hello", toString(buffer));
+  EXPECT_EQ(0, SlabPool::cachedSlabs());
+
+  // Draining the last of the data gives the slab back to the pool.
+  buffer.drain(5);
+  EXPECT_EQ(1, SlabPool::cachedSlabs());
+  buffer.shrink();
+  EXPECT_EQ(1, SlabPool::cachedSlabs());
+
+  buffer.add("world");
+  EXPECT_EQ("world", toString(buffer));
+  EXPECT_EQ(0, SlabPool::cachedSlabs());
+}
+
+TEST(OwnedImplTest, ReadWrite) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  OwnedImpl out("hello");
+  OwnedImpl more(std::string(100, 'a'));
+  out.move(more);
+  EXPECT_EQ(105, out.write(fds[1]));
+  EXPECT_EQ(0, out.length());
+
+  OwnedImpl in;
+  EXPECT_EQ(5, in.read(fds[0], 5));
+  EXPECT_EQ("hello", toString(in));
+  EXPECT_EQ(100, in.read(fds[0], 1000));
+  EXPECT_EQ(105, in.length());
+
+  close(fds[1]);
+  EXPECT_EQ(0, in.read(fds[0], 1000));
+  close(fds[0]);
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,122 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/buffer/slab_pool.h"
+#include "common/memory/stats.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+class SlabPoolTest : public testing::Test {
+public:
+  SlabPoolTest() { SlabPool::releaseCachedSlabs(); }
+  ~SlabPoolTest() { SlabPool::releaseCachedSlabs(); }
+};
+
+TEST_F(SlabPoolTest, SizeClasses) {
+  uint64_t capacity;
+  {
+    auto slab = SlabPool::allocate(1, capacity);
+    EXPECT_EQ(SlabPool::MinSlabSize, capacity);
+  }
+  {
+    auto slab = SlabPool::allocate(SlabPool::MinSlabSize + 1, capacity);
+    EXPECT_EQ(SlabPool::MinSlabSize * 2, capacity);
+  }
+  {
+    auto slab = SlabPool::allocate(4000, capacity);
+    EXPECT_EQ(4096, capacity);
+  }
+  {
+    auto slab = SlabPool::allocate(SlabPool::MaxPooledSlabSize, capacity);
+    EXPECT_EQ(SlabPool::MaxPooledSlabSize, capacity);
+  }
+  EXPECT_EQ(4, SlabPool::cachedSlabs());
+
+  {
+    // Slabs bigger than the largest size class are not pooled.
+    auto slab = SlabPool::allocate(SlabPool::MaxPooledSlabSize + 1, capacity);
+    EXPECT_EQ(SlabPool::MaxPooledSlabSize + 1, capacity);
+  }
+  EXPECT_EQ(4, SlabPool::cachedSlabs());
+}
+
+TEST_F(SlabPoolTest, Reuse) {
+  uint64_t capacity;
+  uint8_t* first;
+  {
+    auto slab = SlabPool::allocate(100, capacity);
+    first = slab.get();
+  }
+  EXPECT_EQ(1, SlabPool::cachedSlabs());
+
+  auto slab = SlabPool::allocate(200, capacity);
+  EXPECT_EQ(first, slab.get());
+  EXPECT_EQ(0, SlabPool::cachedSlabs());
+}
+
+TEST_F(SlabPoolTest, CacheIsBounded) {
+  std::vector<std::shared_ptr<uint8_t>> slabs;
+  uint64_t capacity;
+  for (uint64_t i = 0; i < SlabPool::MaxCachedSlabsPerClass + 4; i++) {
+    slabs.push_back(SlabPool::allocate(1, capacity));
+  }
+  slabs.clear();
+  EXPECT_EQ(SlabPool::MaxCachedSlabsPerClass, SlabPool::cachedSlabs());
+}
+
+TEST_F(SlabPoolTest, BufferAccounting) {
+  const uint64_t initial = Memory::Stats::totalBufferSlabBytes();
+  {
+    // A small write gets a slab from the smallest size class.
+    OwnedImpl buffer("hello");
+    EXPECT_EQ(initial + SlabPool::MinSlabSize, Memory::Stats::totalBufferSlabBytes());
+
+    OwnedImpl other;
+    other.move(buffer, 2);
+    // The slab is shared, not copied.
+    EXPECT_EQ(initial + SlabPool::MinSlabSize, Memory::Stats::totalBufferSlabBytes());
+
+    buffer.add(std::string(Slice::DefaultSlabSize, 'a'));
+    EXPECT_EQ(initial + SlabPool::MinSlabSize + Slice::DefaultSlabSize,
+              Memory::Stats::totalBufferSlabBytes());
+  }
+  EXPECT_EQ(initial, Memory::Stats::totalBufferSlabBytes());
+}
+
+TEST_F(SlabPoolTest, SlabsSizedToWrites) {
+  const uint64_t initial = Memory::Stats::totalBufferSlabBytes();
+  OwnedImpl buffer;
+  buffer.add(std::string(1000, 'a'));
+  EXPECT_EQ(initial + 1024, Memory::Stats::totalBufferSlabBytes());
+
+  // Once a buffer has grown, new slabs grow with it rather than staying at the size of the write.
+  buffer.add(std::string(100, 'b'));
+  EXPECT_EQ(initial + 1024 + 2048, Memory::Stats::totalBufferSlabBytes());
+  for (uint64_t i = 0; i < 100; i++) {
+    buffer.add(std::string(100, 'c'));
+  }
+  EXPECT_EQ(1100 + 100 * 100, buffer.length());
+  // 1024 + 2048 + 4096 + 8192 bytes of slabs.
+  EXPECT_EQ(4, buffer.getRawSlices(nullptr, 0));
+}
+
+TEST_F(SlabPoolTest, DrainReleasesLastSlab) {
+  const uint64_t initial = Memory::Stats::totalBufferSlabBytes();
+  OwnedImpl buffer("hello");
+  buffer.drain(2);
+  EXPECT_EQ(initial + SlabPool::MinSlabSize, Memory::Stats::totalBufferSlabBytes());
+
+  // An idle, drained buffer holds no slab memory. Refilling it reuses the cached slab.
+  buffer.drain(3);
+  EXPECT_EQ(initial, Memory::Stats::totalBufferSlabBytes());
+  EXPECT_EQ(1, SlabPool::cachedSlabs());
+  buffer.add("world");
+  EXPECT_EQ(0, SlabPool::cachedSlabs());
+  EXPECT_EQ(initial + SlabPool::MinSlabSize, Memory::Stats::totalBufferSlabBytes());
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
@@ -71,6 +71,23 @@ TEST_F(ZeroCopyInputStreamTest, BackUpFull) {
   EXPECT_EQ(4, stream_.ByteCount());
 }
 
+TEST_F(ZeroCopyInputStreamTest, Skip) {
+  EXPECT_TRUE(stream_.Next(&data_, &size_));
+  stream_.BackUp(3);
+  EXPECT_TRUE(stream_.Skip(2));
+  EXPECT_EQ(3, stream_.ByteCount());
+
+  EXPECT_TRUE(stream_.Next(&data_, &size_));
+  EXPECT_EQ(1, size_);
+  EXPECT_EQ(0, memcmp("d", data_, size_));
+
+  // Skipping past the available data skips all of it.
+  Buffer::OwnedImpl buffer("efgh");
+  stream_.move(buffer);
+  EXPECT_FALSE(stream_.Skip(5));
+  EXPECT_EQ(8, stream_.ByteCount());
+}
+
 TEST_F(ZeroCopyInputStreamTest, ByteCount) {
   EXPECT_EQ(0, stream_.ByteCount());
   EXPECT_TRUE(stream_.Next(&data_, &size_));
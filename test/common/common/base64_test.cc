@@ -4,10 +4,23 @@
 #include "common/common/base64.h"
 
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
 namespace Envoy {
+namespace {
+
+// Builds a buffer with a slice of its own for every slice_length bytes of the data.
+void addSlices(Buffer::Instance& buffer, const std::string& data, uint64_t slice_length) {
+  for (uint64_t i = 0; i < data.length(); i += slice_length) {
+    Buffer::OwnedImpl slice(data.substr(i, slice_length));
+    buffer.move(slice);
+  }
+}
+
+} // namespace
+
 TEST(Base64Test, EmptyBufferEncode) {
   {
     Buffer::OwnedImpl buffer;
@@ -108,4 +121,44 @@ TEST(Base64Test, BinaryBufferEncode) {
   EXPECT_EQ("AAECAwgKCQCqvA==", Base64::encode(buffer, 10));
   EXPECT_EQ("AAECAwgKCQCqvN4=", Base64::encode(buffer, 30));
 }
+
+// Groups which span slices are encoded and decoded the same as within one slice.
+TEST(Base64Test, BufferRoundTrip) {
+  std::string data;
+  for (uint32_t i = 0; i < 1000; i++) {
+    data.push_back(static_cast<char>(i * 7));
+  }
+
+  for (uint64_t length : {0UL, 1UL, 2UL, 3UL, 4UL, 5UL, 999UL, 1000UL}) {
+    const std::string input = data.substr(0, length);
+    const std::string expected = Base64::encode(input.data(), input.length());
+    for (uint64_t slice_length : {1UL, 2UL, 5UL, 1000UL}) {
+      Buffer::OwnedImpl buffer;
+      addSlices(buffer, input, slice_length);
+      EXPECT_EQ(expected, Base64::encode(buffer, buffer.length()));
+
+      Buffer::OwnedImpl encoded("prefix");
+      Base64::encode(buffer, buffer.length(), encoded);
+      EXPECT_EQ("prefix" + expected, TestUtility::bufferToString(encoded));
+
+      Buffer::OwnedImpl encoded_slices;
+      addSlices(encoded_slices, expected, slice_length);
+      Buffer::OwnedImpl decoded("prefix");
+      EXPECT_TRUE(Base64::decode(encoded_slices, decoded));
+      EXPECT_EQ("prefix" + input, TestUtility::bufferToString(decoded));
+    }
+  }
+}
+
+TEST(Base64Test, BufferDecodeFailure) {
+  for (const std::string& input : {"Zm9", "Zm9vZ===", "Zm=vYmFy", "Zm9vYh==", "Zm9v.mFy"}) {
+    for (uint64_t slice_length : {1UL, 3UL, 100UL}) {
+      Buffer::OwnedImpl buffer;
+      addSlices(buffer, input, slice_length);
+      Buffer::OwnedImpl decoded;
+      EXPECT_FALSE(Base64::decode(buffer, decoded));
+      EXPECT_EQ(0U, decoded.length());
+    }
+  }
+}
 } // namespace Envoy
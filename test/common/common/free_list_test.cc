@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <memory>
+
+#include "common/common/free_list.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+namespace {
+
+struct Pooled {
+  static void* operator new(size_t size) { return FreeList<Pooled>::allocate(size); }
+  static void operator delete(void* p, size_t size) { FreeList<Pooled>::release(p, size); }
+
+  uint64_t value_[4];
+};
+
+struct Capped {
+  static void* operator new(size_t size) { return FreeList<Capped, 2>::allocate(size); }
+  static void operator delete(void* p, size_t size) { FreeList<Capped, 2>::release(p, size); }
+
+  uint64_t value_[4];
+};
+
+struct Shared {
+  uint64_t value_[4];
+};
+
+} // namespace
+
+TEST(FreeListTest, ReuseFreedObjects) {
+  EXPECT_EQ(0U, FreeList<Pooled>::cached());
+
+  Pooled* first = new Pooled();
+  delete first;
+  EXPECT_EQ(1U, FreeList<Pooled>::cached());
+
+  Pooled* second = new Pooled();
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(0U, FreeList<Pooled>::cached());
+  delete second;
+}
+
+TEST(FreeListTest, MaxCached) {
+  Capped* objects[3] = {new Capped(), new Capped(), new Capped()};
+  for (Capped* object : objects) {
+    delete object;
+  }
+  EXPECT_EQ(2U, (FreeList<Capped, 2>::cached()));
+}
+
+TEST(FreeListTest, AllocateShared) {
+  std::shared_ptr<Shared> first = std::allocate_shared<Shared>(FreeListAllocator<Shared>());
+  Shared* first_address = first.get();
+  first.reset();
+
+  std::shared_ptr<Shared> second = std::allocate_shared<Shared>(FreeListAllocator<Shared>());
+  EXPECT_EQ(first_address, second.get());
+}
+
+} // namespace Envoy
@@ -34,4 +34,12 @@ TEST(Hex, UIntToHex) {
   EXPECT_EQ("25c6f38dd0600e78", base16_string);
   EXPECT_EQ("0000000000000000", Hex::uint64ToHex(0ULL));
 }
+
+TEST(Hex, UIntToHexBuffer) {
+  char output[17] = "xxxxxxxxxxxxxxxx";
+  Hex::uint64ToHex(2722130815203937912ULL, output);
+  EXPECT_STREQ("25c6f38dd0600e78", output);
+  Hex::uint64ToHex(0xffffffffffffffffULL, output);
+  EXPECT_STREQ("ffffffffffffffff", output);
+}
 } // namespace Envoy
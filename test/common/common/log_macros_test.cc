@@ -1,14 +1,22 @@
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "common/common/logger.h"
 
+#include "test/mocks/access_log/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/network/mocks.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
 namespace Envoy {
 
 class TestFilterLog : public Logger::Loggable<Logger::Id::filter> {
@@ -37,4 +45,55 @@ TEST(Logger, All) {
   // Misc logging with no facility.
   ENVOY_LOG_MISC(info, "fake message");
 }
+
+class AsyncSinkTest : public testing::Test {
+public:
+  AsyncSinkTest()
+      : sink_(new Logger::LockingStderrOrFileSink()), logger_("async", sink_),
+        file_(access_log_manager_.file_) {
+    logger_.set_pattern("%v");
+    EXPECT_CALL(access_log_manager_, createAccessLog("log")).WillOnce(Return(file_));
+    ON_CALL(*file_, write(_)).WillByDefault(Invoke([this](const std::string& data) -> void {
+      std::lock_guard<std::mutex> guard(written_lock_);
+      written_ += data;
+    }));
+    sink_->logToFile("log", access_log_manager_);
+  }
+
+  std::shared_ptr<Logger::LockingStderrOrFileSink> sink_;
+  spdlog::logger logger_;
+  NiceMock<AccessLog::MockAccessLogManager> access_log_manager_;
+  std::shared_ptr<Filesystem::MockFile> file_;
+  std::mutex written_lock_;
+  std::string written_;
+};
+
+// Messages go out through the writer thread, and flush() writes those it has not got to yet.
+TEST_F(AsyncSinkTest, WritesMessages) {
+  sink_->enableAsync(1024);
+  logger_.info("first");
+  logger_.info("second");
+  sink_->flush();
+  {
+    std::lock_guard<std::mutex> guard(written_lock_);
+    EXPECT_NE(std::string::npos, written_.find("first"));
+    EXPECT_NE(std::string::npos, written_.find("second"));
+  }
+
+  sink_->disableAsync();
+  logger_.info("third");
+  EXPECT_NE(std::string::npos, written_.find("third"));
+  EXPECT_EQ(0U, sink_->droppedMessages());
+}
+
+// Messages which do not fit are dropped, and the drops are reported with the next write.
+TEST_F(AsyncSinkTest, DropsWhenFull) {
+  sink_->enableAsync(0);
+  logger_.info("first");
+  logger_.info("second");
+  EXPECT_EQ(2U, sink_->droppedMessages());
+
+  sink_->disableAsync();
+  EXPECT_EQ("[2 log messages dropped]\n", written_);
+}
 } // namespace Envoy
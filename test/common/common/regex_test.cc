@@ -0,0 +1,200 @@
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/regex.h"
+#include "common/config/well_known_names.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Regex {
+
+// Check the RE2 matcher against std::regex for a pattern and subject.
+void expectSameAsStdRegex(const std::string& pattern, const std::string& subject) {
+  CompiledMatcherPtr matcher = Utility::parseRegex(pattern);
+  const std::regex regex(pattern);
+
+  EXPECT_EQ(std::regex_match(subject, regex), matcher->fullMatch(subject))
+      << "pattern '" << pattern << "' subject '" << subject << "'";
+
+  std::smatch expected;
+  std::vector<MatchGroup> groups;
+  const bool found = std::regex_search(subject, expected, regex);
+  ASSERT_EQ(found, matcher->search(subject.data(), subject.data() + subject.size(), groups))
+      << "pattern '" << pattern << "' subject '" << subject << "'";
+  if (found) {
+    ASSERT_EQ(expected.size(), groups.size());
+    for (size_t i = 0; i < groups.size(); i++) {
+      EXPECT_EQ(expected[i].matched, groups[i].matched())
+          << "pattern '" << pattern << "' subject '" << subject << "' group " << i;
+      if (expected[i].matched) {
+        EXPECT_EQ(expected.position(i), groups[i].begin_ - subject.data())
+            << "pattern '" << pattern << "' subject '" << subject << "' group " << i;
+        EXPECT_EQ(expected[i].str(), groups[i].str())
+            << "pattern '" << pattern << "' subject '" << subject << "' group " << i;
+      }
+    }
+  }
+}
+
+TEST(RegexTest, Basic) {
+  const std::vector<std::string> subjects{"",     "a",     "ab",    "abc",   "aab", "abab",
+                                          "b",    "ba",    "a.b",   "a_b9",  "9",   "a b",
+                                          "xaby", "aaaaa", "abbbc", "ab\nc", "A",   "-"};
+  const std::vector<std::string> patterns{"a",
+                                          "ab",
+                                          "a|b",
+                                          "a*",
+                                          "a+",
+                                          "a?b",
+                                          "a*?",
+                                          "a+?b",
+                                          "(a)(b)?",
+                                          "(a|ab)(c|bcd)?",
+                                          "(a*)(a*)",
+                                          "(a*?)(a*)",
+                                          "(?:ab)+",
+                                          "(ab|a)*",
+                                          "^a",
+                                          "b$",
+                                          "^$",
+                                          "a{2}",
+                                          "a{1,2}",
+                                          "a{2,}",
+                                          "a{0,1}?b",
+                                          ".",
+                                          ".*",
+                                          "a.b",
+                                          "\\.",
+                                          "\\d",
+                                          "\\w+",
+                                          "\\W",
+                                          "\\s",
+                                          "\\S+",
+                                          "[abc]+",
+                                          "[^a]",
+                                          "[a-c]*",
+                                          "[\\d_]",
+                                          "[a\\-]",
+                                          "[-a]",
+                                          "\\ba",
+                                          "b\\b",
+                                          "\\Bb",
+                                          "(a(b(c)))",
+                                          "x?(a|b)*?c",
+                                          "()",
+                                          "[.]",
+                                          "\\/"};
+  for (const std::string& pattern : patterns) {
+    for (const std::string& subject : subjects) {
+      expectSameAsStdRegex(pattern, subject);
+    }
+  }
+}
+
+TEST(RegexTest, TagExtraction) {
+  const std::vector<std::string> subjects{
+      "http.dynamodb.table.locations.upstream_rq_time",
+      "http.egress_dynamodb_iad.dynamodb.operation.Query.upstream_rq_time",
+      "http.egress_dynamodb_iad.dynamodb.table.locations.capacity.Query.__partition_id=ef2b2b8e",
+      "cluster.ratelimit.upstream_rq_429",
+      "cluster.ratelimit.upstream_rq_4xx",
+      "cluster.grpc.lightstep.collector.CollectorService.Report.success",
+      "http.admin.user_agent.ios.downstream_cx_total",
+      "vhost.vhost_1.vcluster.vcluster_1.upstream_rq_2xx",
+      "listener.127.0.0.1_3012.ssl.cipher.AES256-SHA",
+      "mongo.mongo_filter.cmd.foo_cmd.reply_size",
+      "auth.clientssl.clientssl_prefix.auth_ip_white_list",
+      "tcp.tcp_prefix.downstream_flow_control_resumed_reading_total",
+      "listener.[__1]_0.http.http_prefix.downstream_rq_5xx",
+      "http.fault_connection_manager.fault.fault_cluster.aborts_injected",
+      "cluster.",
+      "",
+  };
+  for (const auto& name_regex : Config::TagNames::get().name_regex_pairs_) {
+    for (const std::string& subject : subjects) {
+      expectSameAsStdRegex(name_regex.second, subject);
+    }
+  }
+}
+
+// Random patterns over a small alphabet, so that alternatives overlap and captures compete. Groups
+// are at most optional: where a group is repeated, std::regex resets the captures inside it on each
+// iteration and RE2 keeps the last ones which participated, and where it can match the empty
+// string, std::regex may take an extra empty iteration.
+TEST(RegexTest, MatchesStdRegex) {
+  std::mt19937 random(1);
+  const std::vector<std::string> atoms{"a", "b", ".", "[ab]", "[^a]", "\\w", "^", "$", "\\b"};
+  const std::vector<std::string> quantifiers{"", "", "", "*", "+", "?", "*?", "+?", "??", "{1,2}"};
+  const std::vector<std::string> group_quantifiers{"", "", "?", "??"};
+
+  std::function<std::string(uint32_t)> pattern = [&](uint32_t depth) -> std::string {
+    std::string result;
+    const uint32_t length = 1 + random() % 3;
+    for (uint32_t i = 0; i < length; i++) {
+      if (depth < 2 && random() % 4 == 0) {
+        result += (random() % 2 == 0 ? "(" : "(?:") + pattern(depth + 1) +
+                  (random() % 2 == 0 ? "|" + pattern(depth + 1) : "") + ")" +
+                  group_quantifiers[random() % group_quantifiers.size()];
+      } else {
+        const std::string& atom = atoms[random() % atoms.size()];
+        const bool assertion = atom == "^" || atom == "$" || atom == "\\b";
+        result += atom + (assertion ? "" : quantifiers[random() % quantifiers.size()]);
+      }
+    }
+    return result;
+  };
+
+  for (uint32_t i = 0; i < 500; i++) {
+    const std::string regex = pattern(0);
+    for (uint32_t j = 0; j < 10; j++) {
+      std::string subject;
+      const uint32_t length = random() % 6;
+      for (uint32_t k = 0; k < length; k++) {
+        subject.push_back("ab_."[random() % 4]);
+      }
+      expectSameAsStdRegex(regex, subject);
+    }
+  }
+}
+
+// Backreferences and lookaround are rejected rather than run by a backtracking engine.
+TEST(RegexTest, Unsupported) {
+  for (const std::string& pattern : {"(a)\\1", "(?=ab)a", "a(?!b)", "(?<=a)b"}) {
+    EXPECT_THROW(Utility::parseRegex(pattern), EnvoyException) << pattern;
+  }
+}
+
+TEST(RegexTest, UnmatchedGroup) {
+  CompiledMatcherPtr matcher = Utility::parseRegex("(a)|(b)");
+  std::vector<MatchGroup> groups;
+  const std::string subject = "xb";
+  EXPECT_TRUE(matcher->search(subject.data(), subject.data() + subject.size(), groups));
+  ASSERT_EQ(3, groups.size());
+  EXPECT_EQ("b", groups[0].str());
+  EXPECT_FALSE(groups[1].matched());
+  EXPECT_EQ("b", groups[2].str());
+  EXPECT_EQ(1, groups[2].begin_ - subject.data());
+}
+
+TEST(RegexTest, Invalid) {
+  EXPECT_THROW(Utility::parseRegex("a{2,1}"), EnvoyException);
+  EXPECT_THROW(Utility::parseRegex("(a"), EnvoyException);
+  EXPECT_THROW(Utility::parseRegex("[a"), EnvoyException);
+}
+
+// RE2 does not backtrack, so patterns which are exponential for backtracking engines run in linear
+// time.
+TEST(RegexTest, NoBacktracking) {
+  CompiledMatcherPtr matcher = Utility::parseRegex("(a*)*b");
+  EXPECT_FALSE(matcher->fullMatch(std::string(10000, 'a')));
+}
+
+} // namespace Regex
+} // namespace Envoy
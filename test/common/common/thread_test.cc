@@ -0,0 +1,68 @@
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "common/common/thread.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Thread {
+
+TEST(ParallelForTest, RunsEveryIndexOnce) {
+  for (uint32_t num_threads : {1U, 2U, 8U}) {
+    std::vector<std::atomic<uint32_t>> runs(1000);
+    parallelFor(runs.size(), num_threads, [&](uint32_t i) -> void { runs[i]++; });
+    for (const std::atomic<uint32_t>& count : runs) {
+      EXPECT_EQ(1U, count);
+    }
+  }
+
+  // Nothing to run.
+  parallelFor(0, 4, [](uint32_t) -> void { FAIL(); });
+}
+
+// The exception of the lowest failing index is rethrown once every index ran.
+TEST(ParallelForTest, RethrowsFirstException) {
+  std::atomic<uint32_t> runs{0};
+  try {
+    parallelFor(100, 4, [&](uint32_t i) -> void {
+      runs++;
+      if (i == 10 || i == 90) {
+        throw std::runtime_error(std::to_string(i));
+      }
+    });
+    FAIL();
+  } catch (const std::runtime_error& e) {
+    EXPECT_STREQ("10", e.what());
+  }
+  EXPECT_EQ(100U, runs);
+}
+
+#ifdef __linux__
+// A pinned thread only runs on its CPU. The CPU is picked from those the test may run on.
+TEST(PinCurrentThreadTest, RunsOnCpu) {
+  cpu_set_t allowed;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+  uint32_t cpu = CPU_SETSIZE - 1;
+  while (!CPU_ISSET(cpu, &allowed)) {
+    cpu--;
+  }
+
+  Thread thread([cpu]() -> void {
+    EXPECT_TRUE(pinCurrentThread(cpu));
+    EXPECT_EQ(static_cast<int>(cpu), sched_getcpu());
+  });
+  thread.join();
+
+  EXPECT_FALSE(pinCurrentThread(CPU_SETSIZE));
+}
+#endif
+
+} // namespace Thread
+} // namespace Envoy
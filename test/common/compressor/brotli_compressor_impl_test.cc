@@ -0,0 +1,81 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/brotli_compressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "brotli/decode.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Compressor {
+namespace {
+
+class BrotliCompressorImplTest : public testing::Test {
+protected:
+  static std::string decompress(const std::string& compressed) {
+    std::string output;
+    BrotliDecoderState* state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+    size_t avail_in = compressed.size();
+    const uint8_t* next_in = reinterpret_cast<const uint8_t*>(compressed.data());
+    BrotliDecoderResult result;
+    do {
+      uint8_t chunk[4096];
+      size_t avail_out = sizeof(chunk);
+      uint8_t* next_out = chunk;
+      result = BrotliDecoderDecompressStream(state, &avail_in, &next_in, &avail_out, &next_out,
+                                             nullptr);
+      output.append(reinterpret_cast<char*>(chunk), sizeof(chunk) - avail_out);
+    } while (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+    EXPECT_EQ(BROTLI_DECODER_RESULT_SUCCESS, result);
+    BrotliDecoderDestroyInstance(state);
+    return output;
+  }
+};
+
+TEST_F(BrotliCompressorImplTest, CompressStreamEndAndReset) {
+  BrotliCompressorImpl compressor;
+  compressor.init(4, 20);
+  compressor.setChunk(64);
+
+  std::string body;
+  for (uint32_t i = 0; i < 100; i++) {
+    body.append("Sed ut perspiciatis unde omnis iste natus error sit voluptatem ");
+    body.append(std::to_string(i));
+  }
+
+  for (uint32_t stream = 0; stream < 2; stream++) {
+    // Each chunk of the body is compressed into a buffer of its own.
+    std::string compressed;
+    for (uint64_t offset = 0; offset < body.size(); offset += 1000) {
+      Buffer::OwnedImpl in(body.substr(offset, 1000));
+      Buffer::OwnedImpl out;
+      compressor.compress(in, out);
+      compressed += TestUtility::bufferToString(out);
+    }
+    Buffer::OwnedImpl out;
+    compressor.end(out);
+    compressed += TestUtility::bufferToString(out);
+
+    EXPECT_GT(body.size(), compressed.size());
+    EXPECT_EQ(body, decompress(compressed));
+    compressor.reset();
+  }
+}
+
+TEST_F(BrotliCompressorImplTest, EmptyStream) {
+  BrotliCompressorImpl compressor;
+  compressor.init(11, 24);
+
+  Buffer::OwnedImpl in;
+  Buffer::OwnedImpl out;
+  compressor.compress(in, out);
+  compressor.end(out);
+  EXPECT_NE(0U, out.length());
+  EXPECT_EQ("", decompress(TestUtility::bufferToString(out)));
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Envoy
@@ -7,6 +7,8 @@
 #include "common/common/hex.h"
 #include "common/compressor/zlib_compressor_impl.h"
 
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -126,6 +128,51 @@ TEST_F(ZlibCompressorImplTest, CompressWithSmallChunk) {
   EXPECT_EQ("0000ffff", footer_hex_str.substr(footer_hex_str.size() - 8, 10));
 }
 
+TEST_F(ZlibCompressorImplTest, CompressStreamEndAndReset) {
+  Envoy::Compressor::ZlibCompressorImpl compressor;
+  compressor.init(ZlibCompressorImpl::CompressionLevel::Standard,
+                  ZlibCompressorImpl::CompressionStrategy::Standard, gzip_window_bits,
+                  memory_level);
+  compressor.setChunk(256);
+
+  const auto compressStream = [&compressor]() -> std::string {
+    // Each chunk is compressed into its own output buffer, as when streaming a body.
+    std::string compressed;
+    for (uint64_t i = 0; i < 100; i++) {
+      Buffer::OwnedImpl in(multiply32BytesText(i % 16));
+      Buffer::OwnedImpl out;
+      compressor.compress(in, out);
+      compressed += TestUtility::bufferToString(out);
+    }
+    Buffer::OwnedImpl out;
+    compressor.end(out);
+    return compressed + TestUtility::bufferToString(out);
+  };
+
+  std::string expected;
+  for (uint64_t i = 0; i < 100; i++) {
+    expected += multiply32BytesText(i % 16);
+  }
+
+  const std::string compressed = compressStream();
+  z_stream zstream{};
+  ASSERT_EQ(Z_OK, inflateInit2(&zstream, gzip_window_bits));
+  std::string decompressed(expected.size() + 1, '\0');
+  zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  zstream.avail_in = compressed.size();
+  zstream.next_out = reinterpret_cast<Bytef*>(&decompressed[0]);
+  zstream.avail_out = decompressed.size();
+  // The gzip trailer is complete, so the stream ends with all of the data.
+  EXPECT_EQ(Z_STREAM_END, inflate(&zstream, Z_FINISH));
+  decompressed.resize(zstream.total_out);
+  inflateEnd(&zstream);
+  EXPECT_EQ(expected, decompressed);
+
+  // A reset compressor produces the same stream again.
+  compressor.reset();
+  EXPECT_EQ(compressed, compressStream());
+}
+
 } // namespace
 } // namespace Compressor
 } // namespace Envoy
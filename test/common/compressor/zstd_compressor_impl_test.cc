@@ -0,0 +1,81 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+#include "zstd.h"
+
+namespace Envoy {
+namespace Compressor {
+namespace {
+
+class ZstdCompressorImplTest : public testing::Test {
+protected:
+  static std::string decompress(const std::string& compressed) {
+    std::string output;
+    ZSTD_DStream* dstream = ZSTD_createDStream();
+    ZSTD_initDStream(dstream);
+    ZSTD_inBuffer input{compressed.data(), compressed.size(), 0};
+    size_t result;
+    do {
+      char chunk[4096];
+      ZSTD_outBuffer out{chunk, sizeof(chunk), 0};
+      result = ZSTD_decompressStream(dstream, &out, &input);
+      EXPECT_FALSE(ZSTD_isError(result));
+      output.append(chunk, out.pos);
+    } while (result != 0 && !ZSTD_isError(result));
+    // The whole frame is decoded, and nothing follows it.
+    EXPECT_EQ(input.size, input.pos);
+    ZSTD_freeDStream(dstream);
+    return output;
+  }
+};
+
+TEST_F(ZstdCompressorImplTest, CompressStreamEndAndReset) {
+  ZstdCompressorImpl compressor;
+  compressor.init(3);
+  compressor.setChunk(64);
+
+  std::string body;
+  for (uint32_t i = 0; i < 100; i++) {
+    body.append("Sed ut perspiciatis unde omnis iste natus error sit voluptatem ");
+    body.append(std::to_string(i));
+  }
+
+  for (uint32_t stream = 0; stream < 2; stream++) {
+    // Each chunk of the body is compressed into a buffer of its own.
+    std::string compressed;
+    for (uint64_t offset = 0; offset < body.size(); offset += 1000) {
+      Buffer::OwnedImpl in(body.substr(offset, 1000));
+      Buffer::OwnedImpl out;
+      compressor.compress(in, out);
+      compressed += TestUtility::bufferToString(out);
+    }
+    Buffer::OwnedImpl out;
+    compressor.end(out);
+    compressed += TestUtility::bufferToString(out);
+
+    EXPECT_GT(body.size(), compressed.size());
+    EXPECT_EQ(body, decompress(compressed));
+    compressor.reset();
+  }
+}
+
+TEST_F(ZstdCompressorImplTest, EmptyStream) {
+  ZstdCompressorImpl compressor;
+  compressor.init(19);
+
+  Buffer::OwnedImpl in;
+  Buffer::OwnedImpl out;
+  compressor.compress(in, out);
+  compressor.end(out);
+  EXPECT_NE(0U, out.length());
+  EXPECT_EQ("", decompress(TestUtility::bufferToString(out)));
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Envoy
@@ -280,6 +280,54 @@ TEST_F(GrpcMuxImplTest, WatchDemux) {
   expectSendMessage(type_url, {}, "2");
 }
 
+// Validate that watches on named resources are only handed resources that changed.
+TEST_F(GrpcMuxImplTest, WatchUnchangedResources) {
+  InSequence s;
+  const std::string& type_url = Config::TypeUrl::get().ClusterLoadAssignment;
+  MockGrpcMuxCallbacks foo_callbacks;
+  auto foo_sub = grpc_mux_->subscribe(type_url, {"x"}, foo_callbacks);
+  MockGrpcMuxCallbacks bar_callbacks;
+  auto bar_sub = grpc_mux_->subscribe(type_url, {"y"}, bar_callbacks);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage(type_url, {"y", "x"}, "");
+  grpc_mux_->start();
+
+  auto respond = [this, &type_url](const std::string& version, uint32_t y_localities) {
+    std::unique_ptr<envoy::api::v2::DiscoveryResponse> response(
+        new envoy::api::v2::DiscoveryResponse());
+    response->set_type_url(type_url);
+    response->set_version_info(version);
+    envoy::api::v2::ClusterLoadAssignment load_assignment_x;
+    load_assignment_x.set_cluster_name("x");
+    response->add_resources()->PackFrom(load_assignment_x);
+    envoy::api::v2::ClusterLoadAssignment load_assignment_y;
+    load_assignment_y.set_cluster_name("y");
+    for (uint32_t i = 0; i < y_localities; i++) {
+      load_assignment_y.add_endpoints();
+    }
+    response->add_resources()->PackFrom(load_assignment_y);
+    expectSendMessage(type_url, {"y", "x"}, version);
+    grpc_mux_->onReceiveMessage(std::move(response));
+  };
+
+  EXPECT_CALL(foo_callbacks, onConfigUpdate(_, "1"));
+  EXPECT_CALL(bar_callbacks, onConfigUpdate(_, "1"));
+  respond("1", 1);
+
+  // Only y changed.
+  EXPECT_CALL(foo_callbacks, onConfigUnchanged("2"));
+  EXPECT_CALL(bar_callbacks, onConfigUpdate(_, "2"));
+  respond("2", 2);
+
+  // Nothing changed.
+  EXPECT_CALL(foo_callbacks, onConfigUnchanged("3"));
+  EXPECT_CALL(bar_callbacks, onConfigUnchanged("3"));
+  respond("3", 2);
+
+  expectSendMessage(type_url, {"x"}, "3");
+  expectSendMessage(type_url, {}, "3");
+}
+
 } // namespace
 } // namespace Config
 } // namespace Envoy
@@ -83,17 +83,27 @@ public:
     response->set_nonce(last_response_nonce_);
     response->set_type_url(Config::TypeUrl::get().ClusterLoadAssignment);
     Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> typed_resources;
+    std::vector<std::string> delivered_cluster_names;
     for (const auto& cluster : cluster_names) {
       if (std::find(last_cluster_names_.begin(), last_cluster_names_.end(), cluster) !=
           last_cluster_names_.end()) {
         envoy::api::v2::ClusterLoadAssignment* load_assignment = typed_resources.Add();
         load_assignment->set_cluster_name(cluster);
         response->add_resources()->PackFrom(*load_assignment);
+        delivered_cluster_names.push_back(cluster);
       }
     }
-    EXPECT_CALL(callbacks_, onConfigUpdate(RepeatedProtoEq(typed_resources)))
-        .WillOnce(ThrowOnRejectedConfig(accept));
+    // Resources identical to the last accepted ones are not handed to the callbacks again.
+    if (accepted_ && delivered_cluster_names == accepted_cluster_names_) {
+      EXPECT_CALL(callbacks_, onConfigUpdate(_)).Times(0);
+      accept = true;
+    } else {
+      EXPECT_CALL(callbacks_, onConfigUpdate(RepeatedProtoEq(typed_resources)))
+          .WillOnce(ThrowOnRejectedConfig(accept));
+    }
     if (accept) {
+      accepted_ = true;
+      accepted_cluster_names_ = delivered_cluster_names;
       expectSendMessage(last_cluster_names_, version);
       version_ = version;
     } else {
@@ -113,6 +123,7 @@ public:
     expectSendMessage(cluster_names, version_);
     subscription_->updateResources(cluster_names);
     last_cluster_names_ = cluster_names;
+    accepted_ = false;
   }
 
   std::string version_;
@@ -128,6 +139,8 @@ public:
   std::unique_ptr<GrpcEdsSubscriptionImpl> subscription_;
   std::string last_response_nonce_;
   std::vector<std::string> last_cluster_names_;
+  bool accepted_{};
+  std::vector<std::string> accepted_cluster_names_;
 };
 
 // TODO(danielhochman): test with RDS and ensure version_info is same as what API returned
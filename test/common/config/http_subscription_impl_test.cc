@@ -40,6 +40,64 @@ TEST_F(HttpSubscriptionImplTest, BadJsonRecovery) {
   verifyStats(3, 1, 0, 1, 7148434200721666028);
 }
 
+// Validate that a response identical to the last accepted one is not parsed again.
+TEST_F(HttpSubscriptionImplTest, UnchangedResponse) {
+  startSubscription({"cluster0", "cluster1"});
+  deliverConfigUpdate({"cluster0", "cluster1"}, "0", true);
+  verifyStats(2, 1, 0, 0, 7148434200721666028);
+
+  const std::string response_json = "{\"version_info\":\"0\",\"resources\":[{\"@type\":"
+                                    "\"type.googleapis.com/envoy.api.v2.ClusterLoadAssignment\","
+                                    "\"cluster_name\":\"cluster0\"},{\"@type\":"
+                                    "\"type.googleapis.com/envoy.api.v2.ClusterLoadAssignment\","
+                                    "\"cluster_name\":\"cluster1\"}]}";
+  Http::HeaderMapPtr response_headers{new Http::TestHeaderMapImpl{{":status", "200"}}};
+  Http::MessagePtr message{new Http::ResponseMessageImpl(std::move(response_headers))};
+  message->body().reset(new Buffer::OwnedImpl(response_json));
+  EXPECT_CALL(callbacks_, onConfigUpdate(_)).Times(0);
+  EXPECT_CALL(random_gen_, random()).WillOnce(Return(0));
+  EXPECT_CALL(*timer_, enableTimer(_));
+  http_callbacks_->onSuccess(std::move(message));
+  verifyStats(2, 2, 0, 0, 7148434200721666028);
+  request_in_progress_ = false;
+}
+
+// Validate that the ETag of an accepted response is sent back, and that a 304 response is treated
+// as an unchanged response.
+TEST_F(HttpSubscriptionImplTest, NotModified) {
+  startSubscription({"cluster0"});
+  Http::HeaderMapPtr response_headers{
+      new Http::TestHeaderMapImpl{{":status", "200"}, {"etag", "\"abc\""}}};
+  Http::MessagePtr message{new Http::ResponseMessageImpl(std::move(response_headers))};
+  message->body().reset(new Buffer::OwnedImpl("{\"version_info\":\"0\",\"resources\":[]}"));
+  EXPECT_CALL(callbacks_, onConfigUpdate(_));
+  EXPECT_CALL(random_gen_, random()).WillOnce(Return(0));
+  EXPECT_CALL(*timer_, enableTimer(_));
+  http_callbacks_->onSuccess(std::move(message));
+  verifyStats(1, 1, 0, 0, 7148434200721666028);
+
+  EXPECT_CALL(cm_, httpAsyncClientForCluster("eds_cluster"));
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .WillOnce(Invoke([this](Http::MessagePtr& request, Http::AsyncClient::Callbacks& callbacks,
+                              const Optional<std::chrono::milliseconds>&) {
+        const Http::HeaderEntry* if_none_match =
+            request->headers().get(Http::LowerCaseString("if-none-match"));
+        EXPECT_STREQ("\"abc\"", if_none_match->value().c_str());
+        http_callbacks_ = &callbacks;
+        return &http_request_;
+      }));
+  timer_cb_();
+
+  response_headers.reset(new Http::TestHeaderMapImpl{{":status", "304"}});
+  message.reset(new Http::ResponseMessageImpl(std::move(response_headers)));
+  EXPECT_CALL(callbacks_, onConfigUpdate(_)).Times(0);
+  EXPECT_CALL(random_gen_, random()).WillOnce(Return(0));
+  EXPECT_CALL(*timer_, enableTimer(_));
+  http_callbacks_->onSuccess(std::move(message));
+  verifyStats(2, 2, 0, 0, 7148434200721666028);
+  request_in_progress_ = false;
+}
+
 } // namespace
 } // namespace Config
 } // namespace Envoy
@@ -1,6 +1,7 @@
 #include <string>
 #include <vector>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/http/header_map_impl.h"
 #include "common/json/json_loader.h"
@@ -261,5 +262,110 @@ TEST(DynamoRequestParser, parsePartitionIds) {
   }
 }
 
+TEST(DynamoRequestBodyParser, SingleTable) {
+  {
+    RequestBodyParser parser("GetItem");
+    Buffer::OwnedImpl data("{\"Key\": {\"TableName\": \"nested\"}, \"TableName\": \"loc");
+    parser.parse(data);
+    // The rest of the body is not parsed once the table is known.
+    Buffer::OwnedImpl rest("ations\", not json");
+    parser.parse(rest);
+    RequestParser::TableDescriptor table = parser.finish();
+    EXPECT_EQ("locations", table.table_name);
+    EXPECT_TRUE(table.is_single_table);
+  }
+
+  {
+    RequestBodyParser parser("GetItem");
+    Buffer::OwnedImpl data("{\"TableName\": 1}");
+    EXPECT_THROW(parser.parse(data), Json::Exception);
+  }
+
+  {
+    RequestBodyParser parser("GetItem");
+    Buffer::OwnedImpl data("{\"Key\": {}");
+    parser.parse(data);
+    EXPECT_THROW(parser.finish(), Json::Exception);
+  }
+
+  {
+    RequestBodyParser parser("GetItem");
+    RequestParser::TableDescriptor table = parser.finish();
+    EXPECT_EQ("", table.table_name);
+    EXPECT_TRUE(table.is_single_table);
+  }
+}
+
+TEST(DynamoRequestBodyParser, BatchOperation) {
+  {
+    RequestBodyParser parser("BatchGetItem");
+    Buffer::OwnedImpl data(R"EOF({
+      "RequestItems": {
+        "table_1": { "Keys": [{"table_2": {}}] },
+        "table_1": { "test1" : "something" }
+      }
+    })EOF");
+    parser.parse(data);
+    RequestParser::TableDescriptor table = parser.finish();
+    EXPECT_EQ("table_1", table.table_name);
+    EXPECT_TRUE(table.is_single_table);
+  }
+
+  {
+    RequestBodyParser parser("BatchWriteItem");
+    Buffer::OwnedImpl data(R"EOF({
+      "RequestItems": {
+        "table_1": [],
+        "table_2": [], "truncated)EOF");
+    parser.parse(data);
+    RequestParser::TableDescriptor table = parser.finish();
+    EXPECT_EQ("", table.table_name);
+    EXPECT_FALSE(table.is_single_table);
+  }
+}
+
+TEST(DynamoResponseBodyParser, All) {
+  ResponseBodyParser parser;
+  EXPECT_TRUE(parser.empty());
+  std::string body = R"EOF({
+    "__type": "com.amazonaws.dynamodb.v20120810#ValidationException",
+    "UnprocessedKeys": {"table_1": {"Keys": [{"a": 1}]}, "table_2": {}},
+    "ConsumedCapacity": {
+      "Partitions": {"partition_1": 0.5, "partition_2": 3},
+      "Table": {"partition_3": 1}
+    }
+  })EOF";
+  // Parse the body one byte at a time.
+  for (char c : body) {
+    Buffer::OwnedImpl data(std::string(1, c));
+    parser.parse(data);
+  }
+  parser.finish();
+
+  EXPECT_FALSE(parser.empty());
+  EXPECT_EQ("ValidationException", parser.errorType());
+  EXPECT_EQ((std::vector<std::string>{"table_1", "table_2"}), parser.unprocessedTables());
+  ASSERT_EQ(2U, parser.partitions().size());
+  EXPECT_EQ("partition_1", parser.partitions()[0].partition_id_);
+  EXPECT_EQ(1U, parser.partitions()[0].capacity_);
+  EXPECT_EQ("partition_2", parser.partitions()[1].partition_id_);
+  EXPECT_EQ(3U, parser.partitions()[1].capacity_);
+}
+
+TEST(DynamoResponseBodyParser, Invalid) {
+  {
+    ResponseBodyParser parser;
+    Buffer::OwnedImpl data("{\"ConsumedCapacity\": {\"Partitions\": {\"partition_1\": \"1\"}}}");
+    EXPECT_THROW(parser.parse(data), Json::Exception);
+  }
+
+  {
+    ResponseBodyParser parser;
+    Buffer::OwnedImpl data("{\"__type\": \"ValidationException\"");
+    parser.parse(data);
+    EXPECT_THROW(parser.finish(), Json::Exception);
+  }
+}
+
 } // namespace Dynamo
 } // namespace Envoy
@@ -1,13 +1,24 @@
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "common/common/thread.h"
 #include "common/event/dispatcher_impl.h"
 
 #include "test/mocks/common.h"
+#include "test/mocks/stats/mocks.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::AtLeast;
 using testing::InSequence;
+using testing::NiceMock;
+using testing::Property;
+using testing::_;
 
 namespace Envoy {
 namespace Event {
@@ -51,5 +62,148 @@ TEST(DispatcherImplTest, DeferredDelete) {
   dispatcher.clearDeferredDeleteList();
 }
 
+// With a budget, a pass over the deferred deletion list stops once the budget is spent and the
+// loop deletes the rest on its next iterations, in the order they were submitted, while it handles
+// other events.
+TEST(DispatcherImplTest, DeferredDeleteBudget) {
+  DispatcherImpl dispatcher;
+  dispatcher.setDeferredDeleteBudget(std::chrono::microseconds(1));
+  std::vector<uint32_t> deleted;
+  size_t deleted_when_posted_run = 0;
+  for (uint32_t i = 0; i < 64; i++) {
+    dispatcher.deferredDelete(DeferredDeletablePtr{new TestDeferredDeletable([&, i]() -> void {
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+      deleted.push_back(i);
+      if (i == 0) {
+        dispatcher.post([&]() -> void { deleted_when_posted_run = deleted.size(); });
+      }
+    })});
+  }
+
+  // The clock is read every 16 items, so the first pass deletes 16 of them and the callback posted
+  // by the first runs before the last ones are deleted.
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(64U, deleted.size());
+  for (uint32_t i = 0; i < 64; i++) {
+    EXPECT_EQ(i, deleted[i]);
+  }
+  EXPECT_LE(16U, deleted_when_posted_run);
+  EXPECT_GT(64U, deleted_when_posted_run);
+  EXPECT_EQ(0U, deleted_when_posted_run % 16);
+}
+
+// Clearing the list explicitly deletes everything, the items left by a pass out of budget first.
+TEST(DispatcherImplTest, DeferredDeleteBudgetClear) {
+  DispatcherImpl dispatcher;
+  dispatcher.setDeferredDeleteBudget(std::chrono::microseconds(1));
+  std::vector<uint32_t> deleted;
+  for (uint32_t i = 0; i < 32; i++) {
+    dispatcher.deferredDelete(DeferredDeletablePtr{new TestDeferredDeletable([&, i]() -> void {
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+      deleted.push_back(i);
+      if (i == 0) {
+        // Stop the loop after the first pass.
+        dispatcher.exit();
+      }
+    })});
+  }
+
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_EQ(16U, deleted.size());
+  dispatcher.deferredDelete(DeferredDeletablePtr{
+      new TestDeferredDeletable([&]() -> void { deleted.push_back(32); })});
+  dispatcher.clearDeferredDeleteList();
+  ASSERT_EQ(33U, deleted.size());
+  for (uint32_t i = 0; i < 33; i++) {
+    EXPECT_EQ(i, deleted[i]);
+  }
+}
+
+// Callbacks run in the order they are posted, including the ones posted by other callbacks.
+TEST(DispatcherImplTest, Post) {
+  InSequence s;
+  DispatcherImpl dispatcher;
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  ReadyWatcher watcher3;
+
+  dispatcher.post([&]() -> void {
+    watcher1.ready();
+    dispatcher.post([&]() -> void { watcher3.ready(); });
+  });
+  dispatcher.post([&]() -> void { watcher2.ready(); });
+
+  EXPECT_CALL(watcher1, ready());
+  EXPECT_CALL(watcher2, ready());
+  EXPECT_CALL(watcher3, ready());
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+}
+
+TEST(DispatcherImplTest, PostFromThreads) {
+  DispatcherImpl dispatcher;
+  uint32_t num_run = 0;
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < 4; i++) {
+    threads.emplace_back(new Thread::Thread([&]() -> void {
+      for (uint32_t j = 0; j < 1000; j++) {
+        dispatcher.post([&]() -> void { num_run++; });
+      }
+    }));
+  }
+  for (const Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(4000U, num_run);
+}
+
+TEST(DispatcherImplTest, Stats) {
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  DispatcherImpl dispatcher;
+  dispatcher.initializeStats(store, "test.dispatcher.");
+
+  EXPECT_CALL(store, deliverHistogramToSinks(
+                         Property(&Stats::Metric::name, "test.dispatcher.deferred_deletes"), 2));
+  dispatcher.deferredDelete(DeferredDeletablePtr{new TestDeferredDeletable([]() -> void {})});
+  dispatcher.deferredDelete(DeferredDeletablePtr{new TestDeferredDeletable([]() -> void {})});
+  dispatcher.clearDeferredDeleteList();
+
+  EXPECT_CALL(store, deliverHistogramToSinks(
+                         Property(&Stats::Metric::name, "test.dispatcher.post_callbacks"), 3));
+  for (uint32_t i = 0; i < 3; i++) {
+    dispatcher.post([]() -> void {});
+  }
+  TimerPtr timer = dispatcher.createTimer([&]() -> void { dispatcher.exit(); });
+  timer->enableTimer(std::chrono::milliseconds(0));
+
+  for (const std::string& name : {"loop_duration_us", "poll_duration_us", "io_duration_us",
+                                  "timer_duration_us", "post_duration_us"}) {
+    EXPECT_CALL(store, deliverHistogramToSinks(
+                           Property(&Stats::Metric::name, "test.dispatcher." + name), _))
+        .Times(AtLeast(1));
+  }
+  dispatcher.run(Dispatcher::RunType::Block);
+}
+
+TEST(DispatcherImplTest, BusyPoll) {
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  DispatcherImpl dispatcher;
+  dispatcher.enableBusyPoll(std::chrono::microseconds(1000), store, "test.dispatcher.");
+  EXPECT_EQ(std::chrono::microseconds(1000), dispatcher.busyPollBudget());
+
+  // The first timer is found by polling. The loop then polls for the budget without finding
+  // anything, and blocks until the second timer fires.
+  TimerPtr first = dispatcher.createTimer([]() -> void {});
+  first->enableTimer(std::chrono::milliseconds(0));
+  TimerPtr second = dispatcher.createTimer([&]() -> void { dispatcher.exit(); });
+  second->enableTimer(std::chrono::milliseconds(20));
+  dispatcher.run(Dispatcher::RunType::Block);
+
+  EXPECT_LE(1U, store.counter("test.dispatcher.busy_poll_wakeups").value());
+  EXPECT_LE(1U, store.counter("test.dispatcher.busy_poll_sleeps").value());
+  EXPECT_LE(1000U, store.counter("test.dispatcher.busy_poll_spin_us").value());
+}
+
 } // namespace Event
 } // namespace Envoy
@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstdint>
+
+#include "common/event/timer_wheel.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnPointee;
+using testing::_;
+
+namespace Envoy {
+namespace Event {
+
+class TimerWheelTest : public testing::Test {
+public:
+  TimerWheelTest()
+      : ticker_(new NiceMock<MockTimer>(&dispatcher_)),
+        wheel_(dispatcher_, time_source_, std::chrono::milliseconds(100), 4) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+  }
+
+  // Move the time forward and run the ticker, as the dispatcher would.
+  void advance(uint64_t ms) {
+    now_ += std::chrono::milliseconds(ms);
+    ticker_->callback_();
+  }
+
+  NiceMock<MockDispatcher> dispatcher_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  MonotonicTime now_;
+  MockTimer* ticker_;
+  TimerWheel wheel_;
+};
+
+TEST_F(TimerWheelTest, FiresOnTheTickAfterExpiry) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_.createTimer([&]() -> void { watcher.ready(); });
+
+  EXPECT_CALL(*ticker_, enableTimer(std::chrono::milliseconds(101)));
+  timer->enableTimer(std::chrono::milliseconds(250));
+  EXPECT_EQ(1U, wheel_.numEnabled());
+
+  EXPECT_CALL(watcher, ready()).Times(0);
+  EXPECT_CALL(*ticker_, enableTimer(std::chrono::milliseconds(96)));
+  advance(105);
+  EXPECT_CALL(*ticker_, enableTimer(_));
+  advance(100);
+
+  // The ticker stops once no timer is enabled.
+  EXPECT_CALL(watcher, ready());
+  EXPECT_CALL(*ticker_, enableTimer(_)).Times(0);
+  advance(100);
+  EXPECT_EQ(0U, wheel_.numEnabled());
+}
+
+TEST_F(TimerWheelTest, Disable) {
+  ReadyWatcher watcher;
+  TimerPtr timer1 = wheel_.createTimer([&]() -> void { watcher.ready(); });
+  TimerPtr timer2 = wheel_.createTimer([&]() -> void { watcher.ready(); });
+  timer1->enableTimer(std::chrono::milliseconds(100));
+  timer2->enableTimer(std::chrono::milliseconds(100));
+  timer1->disableTimer();
+  timer1->disableTimer();
+  EXPECT_EQ(1U, wheel_.numEnabled());
+
+  // Destroying an enabled timer disables it.
+  timer2.reset();
+  EXPECT_EQ(0U, wheel_.numEnabled());
+
+  EXPECT_CALL(watcher, ready()).Times(0);
+  advance(100);
+}
+
+// Timers which expire after a turn of the wheel stay in their slot until their own tick, and
+// enabling a timer again moves it.
+TEST_F(TimerWheelTest, LaterTurns) {
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  TimerPtr timer1 = wheel_.createTimer([&]() -> void { watcher1.ready(); });
+  TimerPtr timer2 = wheel_.createTimer([&]() -> void { watcher2.ready(); });
+  timer1->enableTimer(std::chrono::milliseconds(200));
+  timer2->enableTimer(std::chrono::milliseconds(1000));
+
+  EXPECT_CALL(watcher1, ready());
+  advance(200);
+  timer1->enableTimer(std::chrono::milliseconds(600));
+
+  EXPECT_CALL(watcher1, ready()).Times(0);
+  EXPECT_CALL(watcher2, ready()).Times(0);
+  for (uint32_t i = 0; i < 5; i++) {
+    advance(100);
+  }
+
+  EXPECT_CALL(watcher1, ready());
+  advance(100);
+
+  // The ticker fell behind by more than a turn of the wheel.
+  EXPECT_CALL(watcher2, ready());
+  advance(700);
+  EXPECT_EQ(0U, wheel_.numEnabled());
+}
+
+// Callbacks can enable and destroy timers which expired on the same tick.
+TEST_F(TimerWheelTest, CallbacksChangeTimers) {
+  TimerPtr timer1;
+  TimerPtr timer2;
+  uint32_t fired = 0;
+  timer1 = wheel_.createTimer([&]() -> void {
+    fired++;
+    timer1->enableTimer(std::chrono::milliseconds(100));
+    timer2.reset();
+  });
+  timer2 = wheel_.createTimer([&]() -> void {
+    fired++;
+    timer2->enableTimer(std::chrono::milliseconds(100));
+    timer1.reset();
+  });
+  timer1->enableTimer(std::chrono::milliseconds(100));
+  timer2->enableTimer(std::chrono::milliseconds(100));
+
+  EXPECT_CALL(*ticker_, enableTimer(_));
+  advance(100);
+  EXPECT_EQ(1U, fired);
+  EXPECT_EQ(1U, wheel_.numEnabled());
+
+  advance(100);
+  EXPECT_EQ(2U, fired);
+}
+
+} // namespace Event
+} // namespace Envoy
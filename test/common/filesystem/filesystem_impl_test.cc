@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include "common/api/os_sys_calls_impl.h"
 #include "common/common/thread.h"
@@ -365,4 +367,41 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
     }
   }
 }
+
+// Writes from several threads go to separate write buffers, which flush() gathers into one write.
+TEST(FilesystemImpl, writesFromThreadsAreGathered) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+
+  Filesystem::FileImpl file("", dispatcher, mutex, os_sys_calls, stats_store,
+                            std::chrono::milliseconds(40));
+
+  std::string written;
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .WillRepeatedly(Invoke([&](int, const void* buffer, size_t num_bytes) -> ssize_t {
+        written.append(reinterpret_cast<const char*>(buffer), num_bytes);
+        return num_bytes;
+      }));
+
+  std::vector<Thread::ThreadPtr> threads;
+  for (char c = 'a'; c < 'e'; c++) {
+    threads.emplace_back(new Thread::Thread([&file, c]() -> void {
+      for (uint32_t i = 0; i < 100; i++) {
+        file.write(std::string(1, c));
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+  file.flush();
+
+  std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
+  std::sort(written.begin(), written.end());
+  EXPECT_EQ(std::string(100, 'a') + std::string(100, 'b') + std::string(100, 'c') +
+                std::string(100, 'd'),
+            written);
+}
 } // namespace Envoy
@@ -92,6 +92,41 @@ TEST(WatcherImplTest, Create) {
   dispatcher.run(Event::Dispatcher::RunType::Block);
 }
 
+#ifdef __linux__
+// Swaps which are queued up by the time the watcher reads them are raised once.
+TEST(WatcherImplTest, Burst) {
+  Event::DispatcherImpl dispatcher;
+  Filesystem::WatcherPtr watcher = dispatcher.createFilesystemWatcher();
+
+  unlink(TestEnvironment::temporaryPath("envoy_test/watcher_target").c_str());
+  unlink(TestEnvironment::temporaryPath("envoy_test/watcher_link").c_str());
+  unlink(TestEnvironment::temporaryPath("envoy_test/watcher_new_link").c_str());
+
+  mkdir(TestEnvironment::temporaryPath("envoy_test").c_str(), S_IRWXU);
+  { std::ofstream file(TestEnvironment::temporaryPath("envoy_test/watcher_target")); }
+
+  WatchCallback callback;
+  EXPECT_CALL(callback, called(Watcher::Events::MovedTo));
+  watcher->addWatch(TestEnvironment::temporaryPath("envoy_test/watcher_link"),
+                    Watcher::Events::MovedTo, [&](uint32_t events) -> void {
+                      callback.called(events);
+                      dispatcher.exit();
+                    });
+
+  for (int i = 0; i < 3; i++) {
+    int rc = symlink(TestEnvironment::temporaryPath("envoy_test/watcher_target").c_str(),
+                     TestEnvironment::temporaryPath("envoy_test/watcher_new_link").c_str());
+    EXPECT_EQ(0, rc);
+    rc = rename(TestEnvironment::temporaryPath("envoy_test/watcher_new_link").c_str(),
+                TestEnvironment::temporaryPath("envoy_test/watcher_link").c_str());
+    EXPECT_EQ(0, rc);
+  }
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+  dispatcher.run(Event::Dispatcher::RunType::NonBlock);
+}
+#endif
+
 TEST(WatcherImplTest, BadPath) {
   Event::DispatcherImpl dispatcher;
   Filesystem::WatcherPtr watcher = dispatcher.createFilesystemWatcher();
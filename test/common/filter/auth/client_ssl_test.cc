@@ -16,6 +16,7 @@
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -38,6 +39,51 @@ TEST(ClientSslAuthAllowedPrincipalsTest, EmptyString) {
   EXPECT_EQ(0UL, principals.size());
 }
 
+// Only digests spelled the way the peer certificate digests are can be allowed.
+TEST(ClientSslAuthAllowedPrincipalsTest, InvalidDigest) {
+  AllowedPrincipals principals;
+  principals.add("digest");
+  principals.add("1B7D42EF0025AD89C1C911D6C10D7E86A4CB7C5863B2980ABCBAD1895F8B5314");
+  principals.add("1b7d42ef0025ad89c1c911d6c10d7e86a4cb7c5863b2980abcbad1895f8b531");
+  principals.add("1b7d42ef0025ad89c1c911d6c10d7e86a4cb7c5863b2980abcbad1895f8b5314z");
+  EXPECT_EQ(0UL, principals.size());
+  EXPECT_FALSE(principals.allowed("digest"));
+}
+
+TEST(ClientSslAuthAllowedPrincipalsTest, Allowed) {
+  AllowedPrincipals principals;
+  for (uint64_t i = 0; i < 1000; i++) {
+    principals.add(fmt::format("{:064x}", i * 7919));
+  }
+  principals.add(fmt::format("{:064x}", 7919));
+  EXPECT_EQ(1000UL, principals.size());
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    EXPECT_TRUE(principals.allowed(fmt::format("{:064x}", i * 7919)));
+    EXPECT_FALSE(principals.allowed(fmt::format("{:064x}", i * 7919 + 1)));
+  }
+  EXPECT_TRUE(principals.allowed(std::string(64, '0')));
+  EXPECT_FALSE(principals.allowed(std::string(64, 'f')));
+}
+
+TEST(ClientSslAuthAllowedPrincipalsTest, SameAs) {
+  AllowedPrincipals principals1;
+  AllowedPrincipals principals2;
+  EXPECT_TRUE(principals1.sameAs(principals2));
+
+  principals1.add(std::string(64, 'a'));
+  principals1.add(std::string(64, 'b'));
+  principals2.add(std::string(64, 'b'));
+  EXPECT_FALSE(principals1.sameAs(principals2));
+  principals2.add(std::string(64, 'a'));
+  EXPECT_TRUE(principals1.sameAs(principals2));
+
+  principals2.add(std::string(64, '0'));
+  EXPECT_FALSE(principals1.sameAs(principals2));
+  principals1.add(std::string(64, 'c'));
+  EXPECT_FALSE(principals1.sameAs(principals2));
+}
+
 class ClientSslAuthFilterTest : public testing::Test {
 public:
   ClientSslAuthFilterTest()
@@ -20,6 +20,7 @@
 #include "gtest/gtest.h"
 
 using testing::NiceMock;
+using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
 using testing::SaveArg;
@@ -326,6 +327,65 @@ TEST(TcpProxyConfigTest, Routes) {
   }
 }
 
+// Test that the first matching route wins when routes with and without destination ranges overlap.
+TEST(TcpProxyConfigTest, RouteOrder) {
+  std::string json = R"EOF(
+    {
+      "stat_prefix": "name",
+      "route_config": {
+        "routes": [
+          {
+            "destination_ip_list": [
+              "10.0.0.0/8"
+            ],
+            "source_ports": "1000",
+            "cluster": "with_source_port"
+          },
+          {
+            "destination_ports": "80",
+            "cluster": "with_destination_port"
+          },
+          {
+            "destination_ip_list": [
+              "10.1.0.0/16"
+            ],
+            "cluster": "inner"
+          },
+          {
+            "destination_ip_list": [
+              "10.0.0.0/8"
+            ],
+            "cluster": "outer"
+          }
+        ]
+      }
+    }
+    )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json);
+  NiceMock<Upstream::MockClusterManager> cm_;
+
+  TcpProxyConfig config_obj(*json_config, cm_,
+                            cm_.thread_local_cluster_.cluster_.info_->stats_store_);
+
+  const auto route = [&](const std::string& local, uint32_t local_port,
+                         uint32_t remote_port) -> std::string {
+    NiceMock<Network::MockConnection> connection;
+    Network::Address::Ipv4Instance local_address(local, local_port);
+    EXPECT_CALL(connection, localAddress()).WillRepeatedly(ReturnRef(local_address));
+    Network::Address::Ipv4Instance remote_address("20.0.0.1", remote_port);
+    EXPECT_CALL(connection, remoteAddress()).WillRepeatedly(ReturnRef(remote_address));
+    return config_obj.getRouteFromEntries(connection);
+  };
+
+  EXPECT_EQ("with_source_port", route("10.1.2.3", 80, 1000));
+  EXPECT_EQ("with_destination_port", route("10.1.2.3", 80, 2000));
+  EXPECT_EQ("with_destination_port", route("11.0.0.1", 80, 2000));
+  EXPECT_EQ("inner", route("10.1.2.3", 443, 2000));
+  EXPECT_EQ("outer", route("10.2.0.1", 443, 2000));
+  EXPECT_EQ("", route("11.0.0.1", 443, 2000));
+}
+
 TEST(TcpProxyConfigTest, EmptyRouteConfig) {
   std::string json = R"EOF(
     {
@@ -411,6 +471,7 @@ public:
 
 TEST_F(TcpProxyTest, UpstreamDisconnect) {
   setup(true);
+  EXPECT_CALL(*upstream_connection_, spliceWith(_)).Times(0);
 
   Buffer::OwnedImpl buffer("hello");
   EXPECT_CALL(*upstream_connection_, write(BufferEqual(&buffer)));
@@ -528,6 +589,74 @@ TEST_F(TcpProxyTest, UpstreamConnectFailure) {
                     .value());
 }
 
+// A pooled upstream connection is already connected, so it is used right away.
+TEST_F(TcpProxyTest, PooledUpstreamConnection) {
+  cluster_manager_.tcp_conn_pooled_ = true;
+  upstream_connection_ = new NiceMock<Network::MockClientConnection>();
+  Upstream::MockHost::MockCreateConnectionData conn_info;
+  conn_info.connection_ = upstream_connection_;
+  conn_info.host_description_ = Upstream::makeTestHost(
+      cluster_manager_.thread_local_cluster_.cluster_.info_, "tcp://127.0.0.1:80");
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", _)).WillOnce(Return(conn_info));
+  EXPECT_CALL(*upstream_connection_, addReadFilter(_)).WillOnce(SaveArg<0>(&upstream_read_filter_));
+  EXPECT_CALL(*upstream_connection_, connect()).Times(0);
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, createTimer_(_)).Times(0);
+
+  filter_.reset(new TcpProxy(config_, cluster_manager_));
+  filter_->initializeReadFilterCallbacks(filter_callbacks_);
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_->onNewConnection());
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connection_, write(BufferEqual(&buffer)));
+  filter_->onData(buffer);
+
+  Buffer::OwnedImpl response("world");
+  EXPECT_CALL(filter_callbacks_.connection_, write(BufferEqual(&response)));
+  upstream_read_filter_->onData(response);
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(0U, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_cx_connect_fail")
+                    .value());
+}
+
+// With splice enabled, the connections are spliced once the upstream connection is established.
+TEST_F(TcpProxyTest, Splice) {
+  std::string json = R"EOF(
+    {
+      "stat_prefix": "name",
+      "splice": true,
+      "route_config": {
+        "routes": [
+          {
+            "cluster": "fake_cluster"
+          }
+        ]
+      }
+    }
+    )EOF";
+
+  Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+  config_.reset(
+      new TcpProxyConfig(*config, cluster_manager_,
+                         cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_));
+  setup(true);
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connection_, write(BufferEqual(&buffer)));
+  filter_->onData(buffer);
+
+  EXPECT_CALL(*connect_timer_, disableTimer());
+  EXPECT_CALL(*upstream_connection_, spliceWith(Ref(filter_callbacks_.connection_)))
+      .WillOnce(Return(true));
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(1U, config_->stats().downstream_cx_spliced_total_.value());
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
 TEST_F(TcpProxyTest, UpstreamConnectionLimit) {
   cluster_manager_.thread_local_cluster_.cluster_.info_->resource_manager_.reset(
       new Upstream::ResourceManagerImpl(runtime_, "fake_key", 0, 0, 0, 0));
@@ -8,6 +8,7 @@
 
 #include "test/proto/helloworld.pb.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -136,6 +137,33 @@ TEST(GrpcCodecTest, decodeSingleFrame) {
   EXPECT_EQ("hello", result.name());
 }
 
+TEST(GrpcCodecTest, decodeFrameWithoutCopy) {
+  std::string payload(16384, 'a');
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, payload.size(), header);
+  buffer.add(std::string(header.begin(), header.end()) + payload);
+  // The header of the next frame.
+  buffer.add(header.data(), 5);
+  Buffer::RawSlice input_slice;
+  buffer.getRawSlices(&input_slice, 1);
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  EXPECT_TRUE(decoder.decode(buffer, frames));
+  ASSERT_EQ(1U, frames.size());
+  EXPECT_EQ(payload.size(), frames[0].data_->length());
+  EXPECT_EQ(payload, TestUtility::bufferToString(*frames[0].data_));
+
+  // The payload still lives in the memory of the input.
+  Buffer::RawSlice frame_slice;
+  frames[0].data_->getRawSlices(&frame_slice, 1);
+  EXPECT_EQ(static_cast<uint8_t*>(input_slice.mem_) + 5, frame_slice.mem_);
+  EXPECT_EQ(0U, buffer.length());
+  EXPECT_EQ(payload.size(), decoder.length());
+}
+
 TEST(GrpcCodecTest, decodeMultipleFrame) {
   helloworld::HelloRequest request;
   request.set_name("hello");
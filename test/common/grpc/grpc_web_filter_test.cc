@@ -40,7 +40,7 @@ const size_t TRAILERS_SIZE = sizeof(TRAILERS) - 1;
 
 class GrpcWebFilterTest : public testing::TestWithParam<std::tuple<std::string, std::string>> {
 public:
-  GrpcWebFilterTest() : filter_(cm_) {
+  GrpcWebFilterTest() : filter_(cm_, stats_cache_) {
     filter_.setDecoderFilterCallbacks(decoder_callbacks_);
     filter_.setEncoderFilterCallbacks(encoder_callbacks_);
   }
@@ -73,6 +73,7 @@ public:
 
   bool doStatTracking() const { return filter_.do_stat_tracking_; }
 
+  StatsCache stats_cache_{"grpc-web"};
   GrpcWebFilter filter_;
   NiceMock<Upstream::MockClusterManager> cm_;
   NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
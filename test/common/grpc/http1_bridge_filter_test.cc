@@ -21,7 +21,7 @@ namespace Grpc {
 
 class GrpcHttp1BridgeFilterTest : public testing::Test {
 public:
-  GrpcHttp1BridgeFilterTest() : filter_(cm_) {
+  GrpcHttp1BridgeFilterTest() : filter_(cm_, stats_cache_) {
     filter_.setDecoderFilterCallbacks(decoder_callbacks_);
     filter_.setEncoderFilterCallbacks(encoder_callbacks_);
     ON_CALL(decoder_callbacks_.request_info_, protocol()).WillByDefault(ReturnPointee(&protocol_));
@@ -30,6 +30,7 @@ public:
   ~GrpcHttp1BridgeFilterTest() { filter_.onDestroy(); }
 
   NiceMock<Upstream::MockClusterManager> cm_;
+  StatsCache stats_cache_{"grpc"};
   Http1BridgeFilter filter_;
   NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
   NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
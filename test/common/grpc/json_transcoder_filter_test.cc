@@ -26,8 +26,6 @@ using testing::ReturnPointee;
 using testing::ReturnRef;
 using testing::_;
 
-using Envoy::Protobuf::MethodDescriptor;
-
 using Envoy::Protobuf::FileDescriptorProto;
 using Envoy::Protobuf::FileDescriptorSet;
 using Envoy::Protobuf::util::MessageDifferencer;
@@ -147,13 +145,13 @@ TEST_F(GrpcJsonTranscoderConfigTest, CreateTranscoder) {
 
   TranscoderInputStreamImpl request_in, response_in;
   std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  const JsonTranscoderConfig::MethodInfo* method_info;
+  auto status = config.createTranscoder(headers, request_in, response_in, transcoder, method_info);
 
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(transcoder);
-  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_descriptor->full_name());
+  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_info->descriptor_->full_name());
+  EXPECT_EQ("/bookstore.Bookstore/ListShelves", method_info->grpc_path_);
 }
 
 TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
@@ -167,9 +165,8 @@ TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
 
   TranscoderInputStreamImpl request_in, response_in;
   std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  const JsonTranscoderConfig::MethodInfo* method_info;
+  auto status = config.createTranscoder(headers, request_in, response_in, transcoder, method_info);
 
   EXPECT_EQ(Code::INVALID_ARGUMENT, status.error_code());
   EXPECT_EQ("Could not find field \"b\" in the type \"bookstore.GetBookRequest\".",
@@ -291,6 +288,28 @@ TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryPost) {
   EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.decodeTrailers(response_trailers));
 }
 
+// The shelf is bound by the fields resolved when the config was loaded.
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingTemplateBinding) {
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/shelves/123"}};
+
+  Buffer::OwnedImpl request_data;
+  EXPECT_CALL(decoder_callbacks_, addDecodedData(_, true))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) { request_data.move(data); }));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+  EXPECT_EQ("/bookstore.Bookstore/GetShelf", request_headers.get_(":path"));
+
+  Decoder decoder;
+  std::vector<Frame> frames;
+  decoder.decode(request_data, frames);
+  EXPECT_EQ(1, frames.size());
+
+  bookstore::GetShelfRequest expected_request;
+  expected_request.set_shelf(123);
+  bookstore::GetShelfRequest request;
+  request.ParseFromString(TestUtility::bufferToString(*frames[0].data_));
+  EXPECT_TRUE(MessageDifferencer::Equals(expected_request, request));
+}
+
 TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryError) {
   Http::TestHeaderMapImpl request_headers{
       {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
@@ -313,6 +332,92 @@ TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryError) {
   EXPECT_EQ(0, request_data.length());
 }
 
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingServerStreaming) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", "/shelves/1/books"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+  EXPECT_EQ("/bookstore.Bookstore/ListBooks", request_headers.get_(":path"));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+  EXPECT_EQ("application/json", response_headers.get_("content-type"));
+
+  bookstore::Book book;
+  book.set_id(1);
+  book.set_title("Hamlet");
+  auto response_data = Common::serializeBody(book);
+  book.set_id(2);
+  book.set_title("Macbeth");
+  response_data->add(*Common::serializeBody(book));
+
+  // Both messages are written as soon as they are translated.
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(*response_data, false));
+  EXPECT_EQ("[{\"id\":\"1\",\"title\":\"Hamlet\"},{\"id\":\"2\",\"title\":\"Macbeth\"}",
+            TestUtility::bufferToString(*response_data));
+
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) {
+        EXPECT_EQ("]", TestUtility::bufferToString(data));
+      }));
+  Http::TestHeaderMapImpl response_trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.encodeTrailers(response_trailers));
+}
+
+TEST(GrpcJsonTranscoderFilterStreamTest, FlushThreshold) {
+  JsonTranscoderConfig config(*Json::Factory::loadFromString(TestEnvironment::substitute(R"({
+     "proto_descriptor": "{{ test_rundir }}/test/proto/bookstore.descriptor",
+     "services": ["bookstore.Bookstore"],
+     "stream_flush_threshold_bytes": 40
+    })")));
+  EXPECT_EQ(40, config.streamFlushThresholdBytes());
+
+  JsonTranscoderFilter filter(config);
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks;
+  filter.setDecoderFilterCallbacks(decoder_callbacks);
+  filter.setEncoderFilterCallbacks(encoder_callbacks);
+
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", "/shelves/1/books"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter.decodeHeaders(request_headers, true));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter.encodeHeaders(response_headers, false));
+
+  bookstore::Book book;
+  book.set_id(1);
+  book.set_title("Hamlet");
+  auto response_data = Common::serializeBody(book);
+
+  // The first message is held until the threshold is reached.
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter.encodeData(*response_data, false));
+  EXPECT_EQ(0, response_data->length());
+
+  book.set_id(2);
+  book.set_title("Macbeth");
+  response_data = Common::serializeBody(book);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter.encodeData(*response_data, false));
+  EXPECT_EQ("[{\"id\":\"1\",\"title\":\"Hamlet\"},{\"id\":\"2\",\"title\":\"Macbeth\"}",
+            TestUtility::bufferToString(*response_data));
+
+  book.set_id(3);
+  book.set_title("Othello");
+  response_data = Common::serializeBody(book);
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter.encodeData(*response_data, false));
+
+  // The held message is flushed with the end of the response.
+  EXPECT_CALL(encoder_callbacks, addEncodedData(_, true))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) {
+        EXPECT_EQ(",{\"id\":\"3\",\"title\":\"Othello\"}]", TestUtility::bufferToString(data));
+      }));
+  Http::TestHeaderMapImpl response_trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter.encodeTrailers(response_trailers));
+}
+
 struct GrpcJsonTranscoderFilterPrintTestParam {
   std::string config_json_;
   std::string expected_response_;
@@ -0,0 +1,108 @@
+#include <memory>
+#include <string>
+
+#include "common/grpc/stats_cache.h"
+#include "common/http/header_map_impl.h"
+
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Grpc {
+
+class GrpcStatsCacheTest : public testing::Test {
+public:
+  void chargeStat(StatsCache& cache, const std::string& method, const std::string& status) {
+    Http::TestHeaderMapImpl trailers{{"grpc-status", status}};
+    cache.chargeStat(cluster_, "lyft.users.BadCompanions", method, trailers.GrpcStatus());
+  }
+
+  uint64_t counter(const std::string& name) {
+    return cluster_->stats_store_.counter("grpc.lyft.users.BadCompanions." + name).value();
+  }
+
+  std::shared_ptr<NiceMock<Upstream::MockClusterInfo>> cluster_{
+      new NiceMock<Upstream::MockClusterInfo>()};
+};
+
+TEST_F(GrpcStatsCacheTest, Charge) {
+  StatsCache cache("grpc");
+  chargeStat(cache, "GetBadCompanions", "0");
+  chargeStat(cache, "GetBadCompanions", "0");
+  chargeStat(cache, "GetBadCompanions", "14");
+  EXPECT_EQ(1U, cache.size());
+
+  EXPECT_EQ(2U, counter("GetBadCompanions.0"));
+  EXPECT_EQ(1U, counter("GetBadCompanions.14"));
+  EXPECT_EQ(2U, counter("GetBadCompanions.success"));
+  EXPECT_EQ(1U, counter("GetBadCompanions.failure"));
+  EXPECT_EQ(3U, counter("GetBadCompanions.total"));
+}
+
+// Statuses which are not spelled the way the counter of their code is named are charged to
+// counters named after them.
+TEST_F(GrpcStatsCacheTest, OddStatus) {
+  StatsCache cache("grpc");
+  chargeStat(cache, "GetBadCompanions", "00");
+  chargeStat(cache, "GetBadCompanions", "bad");
+  chargeStat(cache, "GetBadCompanions", "99");
+
+  EXPECT_EQ(1U, counter("GetBadCompanions.00"));
+  EXPECT_EQ(1U, counter("GetBadCompanions.bad"));
+  EXPECT_EQ(1U, counter("GetBadCompanions.99"));
+  EXPECT_EQ(0U, counter("GetBadCompanions.0"));
+  EXPECT_EQ(1U, counter("GetBadCompanions.success"));
+  EXPECT_EQ(2U, counter("GetBadCompanions.failure"));
+  EXPECT_EQ(3U, counter("GetBadCompanions.total"));
+}
+
+TEST_F(GrpcStatsCacheTest, NoStatus) {
+  StatsCache cache("grpc");
+  cache.chargeStat(cluster_, "lyft.users.BadCompanions", "GetBadCompanions", nullptr);
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_EQ(0U, counter("GetBadCompanions.total"));
+}
+
+// Methods past the limit are still charged, only without being cached.
+TEST_F(GrpcStatsCacheTest, MaxMethods) {
+  StatsCache cache("grpc", 1);
+  chargeStat(cache, "GetBadCompanions", "0");
+  chargeStat(cache, "GetGoodCompanions", "0");
+  chargeStat(cache, "GetGoodCompanions", "2");
+  EXPECT_EQ(1U, cache.size());
+
+  EXPECT_EQ(1U, counter("GetBadCompanions.total"));
+  EXPECT_EQ(1U, counter("GetGoodCompanions.success"));
+  EXPECT_EQ(1U, counter("GetGoodCompanions.failure"));
+  EXPECT_EQ(2U, counter("GetGoodCompanions.total"));
+}
+
+// The stats of a cluster which has been replaced are not charged from the cache.
+TEST_F(GrpcStatsCacheTest, ClusterUpdated) {
+  StatsCache cache("grpc");
+  chargeStat(cache, "GetBadCompanions", "0");
+  EXPECT_EQ(1U, counter("GetBadCompanions.total"));
+
+  cluster_.reset(new NiceMock<Upstream::MockClusterInfo>());
+  chargeStat(cache, "GetBadCompanions", "0");
+  EXPECT_EQ(1U, cache.size());
+  EXPECT_EQ(1U, counter("GetBadCompanions.0"));
+  EXPECT_EQ(1U, counter("GetBadCompanions.total"));
+}
+
+TEST_F(GrpcStatsCacheTest, Protocol) {
+  StatsCache cache("grpc-web");
+  chargeStat(cache, "GetBadCompanions", "0");
+  EXPECT_EQ(1U, cluster_->stats_store_
+                    .counter("grpc-web.lyft.users.BadCompanions.GetBadCompanions.total")
+                    .value());
+  EXPECT_EQ(0U, counter("GetBadCompanions.total"));
+}
+
+} // namespace Grpc
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -259,6 +260,16 @@ TEST(AccessLogFormatterTest, CompositeFormatterSuccess) {
 
     EXPECT_EQ("GET|G|PU|GET", formatter.format(request_header, response_header, request_info));
   }
+
+  {
+    FormatterImpl formatter("%REQ(first)% %BYTES_SENT%");
+
+    EXPECT_CALL(request_info, bytesSent())
+        .WillRepeatedly(Return(std::numeric_limits<uint64_t>::max()));
+    std::string output = "prefix ";
+    formatter.formatInto(request_header, response_header, request_info, output);
+    EXPECT_EQ("prefix GET 18446744073709551615", output);
+  }
 }
 
 TEST(AccessLogFormatterTest, ParserFailures) {
@@ -274,6 +274,37 @@ TEST_F(AccessLogImplTest, RuntimeFilter) {
   log->log(&request_headers_, &response_headers_, request_info_);
 }
 
+// Sampling by request ID can be decided from the request headers, while random sampling and the
+// filters on the outcome of the request can't.
+TEST_F(AccessLogImplTest, MayLog) {
+  const std::string json = R"EOF(
+  {
+    "path": "/dev/null",
+    "filter": {"type": "logical_and", "filters": [
+        {"type": "runtime", "key": "access_log.test_key"},
+        {"type": "logical_or", "filters": [
+            {"type": "status_code", "op": ">=", "value": 500},
+            {"type": "runtime", "key": "access_log.other_key"}
+          ]
+        }
+      ]
+    }
+  }
+  )EOF";
+
+  InstanceSharedPtr log = AccessLogFactory::fromProto(parseAccessLogFromJson(json), context_);
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled(_, _)).Times(0);
+  EXPECT_TRUE(log->mayLog(request_headers_));
+
+  request_headers_.addCopy("x-request-id", "000000ff-0000-0000-0000-000000000000");
+  EXPECT_CALL(runtime_.snapshot_, getInteger("access_log.test_key", 0)).WillOnce(Return(56));
+  EXPECT_TRUE(log->mayLog(request_headers_));
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("access_log.test_key", 0)).WillOnce(Return(55));
+  EXPECT_FALSE(log->mayLog(request_headers_));
+}
+
 TEST_F(AccessLogImplTest, PathRewrite) {
   request_headers_ = {{":method", "GET"}, {":path", "/foo"}, {"x-envoy-original-path", "/bar"}};
 
@@ -0,0 +1,176 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/http/access_log/grpc_access_log_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/grpc/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+
+typedef Grpc::MockAsyncClient<envoy::access_log::StreamAccessLogsMessage,
+                              envoy::access_log::StreamAccessLogsResponse>
+    MockAccessLogServiceAsyncClient;
+
+class GrpcAccessLogStreamerTest : public testing::Test {
+public:
+  GrpcAccessLogStreamerTest()
+      : flush_timer_(new NiceMock<Event::MockTimer>(&dispatcher_)),
+        async_client_(new MockAccessLogServiceAsyncClient()),
+        stats_{ALL_GRPC_ACCESS_LOG_STATS(POOL_COUNTER_PREFIX(stats_store_, "grpc."))},
+        streamer_(AccessLogServiceAsyncClientPtr{async_client_}, "test_log", 100,
+                  std::chrono::milliseconds(1000), dispatcher_, stats_) {}
+
+  // Log an entry of about 30 bytes.
+  void log(const std::string& path) {
+    envoy::access_log::HttpAccessLogEntry entry;
+    entry.set_path(path + std::string(30 - path.size(), '_'));
+    streamer_.log(entry);
+  }
+
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Event::MockTimer>* flush_timer_;
+  MockAccessLogServiceAsyncClient* async_client_;
+  Grpc::MockAsyncStream<envoy::access_log::StreamAccessLogsMessage> async_stream_;
+  Stats::IsolatedStoreImpl stats_store_;
+  GrpcAccessLogStats stats_;
+  GrpcAccessLogStreamer streamer_;
+};
+
+// Entries are sent when the flush timer fires, on a stream which is kept for later flushes.
+TEST_F(GrpcAccessLogStreamerTest, FlushedByTimer) {
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(1000)));
+  log("/a");
+  log("/b");
+
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  flush_timer_->callback_();
+  EXPECT_EQ("test_log", message.log_name());
+  ASSERT_EQ(2, message.entries_size());
+  EXPECT_EQ(0U, message.entries(1).path().find("/b"));
+  EXPECT_EQ(2U, stats_.logs_written_.value());
+
+  // The log name is only sent on the first message of a stream.
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(1000)));
+  log("/c");
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  streamer_.flush();
+  EXPECT_EQ("", message.log_name());
+  EXPECT_EQ(1, message.entries_size());
+
+  // Nothing is sent when nothing is buffered.
+  flush_timer_->callback_();
+}
+
+// A full buffer is sent right away.
+TEST_F(GrpcAccessLogStreamerTest, FlushedWhenFull) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false));
+  for (uint32_t i = 0; i < 4; i++) {
+    log("/");
+  }
+  EXPECT_EQ(3U, stats_.logs_written_.value());
+}
+
+// Entries are dropped once the buffer is full and no stream can be established, and a new stream
+// is started after the previous one was closed.
+TEST_F(GrpcAccessLogStreamerTest, DroppedWithoutStream) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillRepeatedly(Return(nullptr));
+  for (uint32_t i = 0; i < 5; i++) {
+    log("/");
+  }
+  EXPECT_EQ(0U, stats_.logs_written_.value());
+  EXPECT_EQ(2U, stats_.logs_dropped_.value());
+
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false));
+  flush_timer_->callback_();
+  EXPECT_EQ(3U, stats_.logs_written_.value());
+
+  streamer_.onRemoteClose(Grpc::Status::GrpcStatus::Unavailable, "");
+  EXPECT_EQ(1U, stats_.stream_failures_.value());
+
+  envoy::access_log::StreamAccessLogsMessage message;
+  log("/");
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  flush_timer_->callback_();
+  EXPECT_EQ("test_log", message.log_name());
+}
+
+TEST(HttpGrpcAccessLogTest, Log) {
+  NiceMock<ThreadLocal::MockInstance> tls;
+  Stats::IsolatedStoreImpl stats_store;
+  Grpc::MockAsyncStream<envoy::access_log::StreamAccessLogsMessage> async_stream;
+  envoy::access_log::HttpGrpcAccessLogConfig config;
+  config.set_log_name("test_log");
+  config.set_buffer_size_bytes(1);
+
+  HttpGrpcAccessLog access_log(nullptr, config,
+                               [&]() -> AccessLogServiceAsyncClientPtr {
+                                 auto* async_client = new MockAccessLogServiceAsyncClient();
+                                 EXPECT_CALL(*async_client, start(_, _))
+                                     .WillOnce(Return(&async_stream));
+                                 return AccessLogServiceAsyncClientPtr{async_client};
+                               },
+                               tls, stats_store);
+
+  NiceMock<MockRequestInfo> request_info;
+  Optional<uint32_t> response_code{200};
+  const std::string downstream_address = "127.0.0.1";
+  ON_CALL(request_info, responseCode()).WillByDefault(ReturnRef(response_code));
+  ON_CALL(request_info, bytesSent()).WillByDefault(Return(42));
+  ON_CALL(request_info, duration()).WillByDefault(Return(std::chrono::microseconds(1500)));
+  ON_CALL(request_info, protocol()).WillByDefault(Return(Protocol::Http2));
+  ON_CALL(request_info, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address));
+
+  TestHeaderMapImpl request_headers{{":method", "GET"},
+                                    {":path", "/rewritten"},
+                                    {"x-envoy-original-path", "/original"},
+                                    {":authority", "host"},
+                                    {"x-request-id", "id"}};
+  envoy::access_log::StreamAccessLogsMessage message;
+  EXPECT_CALL(async_stream, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  access_log.log(&request_headers, nullptr, request_info);
+
+  ASSERT_EQ(1, message.entries_size());
+  const envoy::access_log::HttpAccessLogEntry& entry = message.entries(0);
+  EXPECT_EQ("GET", entry.method());
+  EXPECT_EQ("/original", entry.path());
+  EXPECT_EQ("host", entry.authority());
+  EXPECT_EQ("id", entry.request_id());
+  EXPECT_EQ("HTTP/2", entry.protocol());
+  EXPECT_EQ(200U, entry.response_code());
+  EXPECT_EQ("-", entry.response_flags());
+  EXPECT_EQ(42U, entry.bytes_sent());
+  EXPECT_EQ(1500U, entry.duration_us());
+  EXPECT_EQ("10.0.0.1:443", entry.upstream_host());
+  EXPECT_EQ("fake_cluster", entry.upstream_cluster());
+  EXPECT_EQ("127.0.0.1", entry.downstream_address());
+  EXPECT_EQ(1U, stats_store.counter("access_log.grpc.test_log.logs_written").value());
+}
+
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
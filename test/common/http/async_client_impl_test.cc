@@ -347,6 +347,38 @@ TEST_F(AsyncClientImplTest, MultipleRequests) {
   response_decoder_->decodeData(data, true);
 }
 
+TEST_F(AsyncClientImplTest, ReuseFreedRequests) {
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](StreamDecoder& decoder, ConnectionPool::Callbacks& callbacks)
+                                 -> ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(stream_encoder_, cm_.conn_pool_.host_);
+        response_decoder_ = &decoder;
+        return nullptr;
+      }));
+
+  HttpTestUtility::addDefaultHeaders(message_->headers());
+  AsyncClient::Request* request1 =
+      client_.send(std::move(message_), callbacks_, Optional<std::chrono::milliseconds>());
+  EXPECT_NE(nullptr, request1);
+  expectSuccess(200);
+  response_decoder_->decodeHeaders(HeaderMapPtr(new TestHeaderMapImpl{{":status", "200"}}), true);
+
+  // Freeing the request puts it on the free list, and the next request reuses it.
+  const uint64_t cached = AsyncRequestImpl::cachedRequests();
+  dispatcher_.to_delete_.clear();
+  EXPECT_EQ(cached + 1, AsyncRequestImpl::cachedRequests());
+
+  MessagePtr message2{new RequestMessageImpl()};
+  HttpTestUtility::addDefaultHeaders(message2->headers());
+  AsyncClient::Request* request2 =
+      client_.send(std::move(message2), callbacks_, Optional<std::chrono::milliseconds>());
+  EXPECT_EQ(request1, request2);
+  EXPECT_EQ(cached, AsyncRequestImpl::cachedRequests());
+  expectSuccess(200);
+  response_decoder_->decodeHeaders(HeaderMapPtr(new TestHeaderMapImpl{{":status", "200"}}), true);
+}
+
 TEST_F(AsyncClientImplTest, StreamAndRequest) {
   // Send request
   message_->body().reset(new Buffer::OwnedImpl("test body"));
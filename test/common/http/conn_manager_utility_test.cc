@@ -19,6 +19,7 @@
 #include "gtest/gtest.h"
 
 using testing::InSequence;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::ReturnRef;
@@ -79,6 +80,29 @@ TEST_F(ConnectionManagerUtilityTest, UseLocalAddressWhenLocalHostRemoteAddress)
   EXPECT_EQ(local_address.ip()->addressAsString(), headers.get_(Headers::get().ForwardedFor));
 }
 
+TEST_F(ConnectionManagerUtilityTest, InternalRemoteAddressAppendedToXff) {
+  Network::Address::Ipv4Instance internal_remote_address("10.0.0.1");
+  EXPECT_CALL(config_, useRemoteAddress()).WillRepeatedly(Return(true));
+  EXPECT_CALL(connection_, remoteAddress()).WillRepeatedly(ReturnRef(internal_remote_address));
+
+  // The remote address alone makes the request internal.
+  {
+    TestHeaderMapImpl headers{};
+    ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
+                                                   route_config_, random_, runtime_, local_info_);
+    EXPECT_EQ("true", headers.get_(Headers::get().EnvoyInternalRequest));
+  }
+
+  // Appending it to an existing XFF does not.
+  {
+    TestHeaderMapImpl headers{{"x-forwarded-for", "10.0.0.2"}};
+    ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
+                                                   route_config_, random_, runtime_, local_info_);
+    EXPECT_EQ("10.0.0.2, 10.0.0.1", headers.get_(Headers::get().ForwardedFor));
+    EXPECT_FALSE(headers.has(Headers::get().EnvoyInternalRequest));
+  }
+}
+
 TEST_F(ConnectionManagerUtilityTest, UserAgentDontSet) {
   Network::Address::Ipv4Instance internal_remote_address("10.0.0.1");
 
@@ -122,7 +146,7 @@ TEST_F(ConnectionManagerUtilityTest, InternalServiceForceTrace) {
     // Internal request, make traceable
     TestHeaderMapImpl headers{
         {"x-forwarded-for", "10.0.0.1"}, {"x-request-id", uuid}, {"x-envoy-force-trace", "true"}};
-    EXPECT_CALL(random_, uuid()).Times(0);
+    EXPECT_CALL(random_, uuid(_)).Times(0);
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.global_enabled", 100, _))
         .WillOnce(Return(true));
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
@@ -136,7 +160,7 @@ TEST_F(ConnectionManagerUtilityTest, InternalServiceForceTrace) {
     // Not internal request, force trace header should be cleaned.
     TestHeaderMapImpl headers{
         {"x-forwarded-for", "34.0.0.1"}, {"x-request-id", uuid}, {"x-envoy-force-trace", "true"}};
-    EXPECT_CALL(random_, uuid()).Times(0);
+    EXPECT_CALL(random_, uuid(_)).Times(0);
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.global_enabled", 100, _))
         .WillOnce(Return(true));
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
@@ -157,7 +181,7 @@ TEST_F(ConnectionManagerUtilityTest, EdgeRequestRegenerateRequestIdAndWipeDownst
   {
     TestHeaderMapImpl headers{{"x-envoy-downstream-service-cluster", "foo"},
                               {"x-request-id", "will_be_regenerated"}};
-    EXPECT_CALL(random_, uuid());
+    EXPECT_CALL(random_, uuid(_));
 
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.client_enabled", _)).Times(0);
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
@@ -174,7 +198,7 @@ TEST_F(ConnectionManagerUtilityTest, EdgeRequestRegenerateRequestIdAndWipeDownst
     TestHeaderMapImpl headers{{"x-envoy-downstream-service-cluster", "foo"},
                               {"x-request-id", "will_be_regenerated"},
                               {"x-client-trace-id", "trace-id"}};
-    EXPECT_CALL(random_, uuid());
+    EXPECT_CALL(random_, uuid(_));
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.client_enabled", 100))
         .WillOnce(Return(false));
 
@@ -191,7 +215,7 @@ TEST_F(ConnectionManagerUtilityTest, EdgeRequestRegenerateRequestIdAndWipeDownst
     TestHeaderMapImpl headers{{"x-envoy-downstream-service-cluster", "foo"},
                               {"x-request-id", "will_be_regenerated"},
                               {"x-client-trace-id", "trace-id"}};
-    EXPECT_CALL(random_, uuid());
+    EXPECT_CALL(random_, uuid(_));
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.client_enabled", 100))
         .WillOnce(Return(true));
 
@@ -259,11 +283,11 @@ TEST_F(ConnectionManagerUtilityTest, UserAgentSetNoIncomingUserAgent) {
 TEST_F(ConnectionManagerUtilityTest, RequestIdGeneratedWhenItsNotPresent) {
   {
     TestHeaderMapImpl headers{{":authority", "host"}, {":path", "/"}};
-    EXPECT_CALL(random_, uuid()).WillOnce(Return("generated_uuid"));
+    EXPECT_CALL(random_, uuid(_));
 
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                    route_config_, random_, runtime_, local_info_);
-    EXPECT_EQ("generated_uuid", headers.get_("x-request-id"));
+    EXPECT_EQ(random_.uuid_, headers.get_("x-request-id"));
   }
 
   {
@@ -271,7 +295,9 @@ TEST_F(ConnectionManagerUtilityTest, RequestIdGeneratedWhenItsNotPresent) {
     TestHeaderMapImpl headers{{"x-client-trace-id", "trace-id"}};
     std::string uuid = rand.uuid();
 
-    EXPECT_CALL(random_, uuid()).WillOnce(Return(uuid));
+    EXPECT_CALL(random_, uuid(_)).WillOnce(Invoke([&uuid](char* out) -> void {
+      uuid.copy(out, uuid.size());
+    }));
 
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                    route_config_, random_, runtime_, local_info_);
@@ -286,7 +312,7 @@ TEST_F(ConnectionManagerUtilityTest, DoNotOverrideRequestIdIfPresentWhenInternal
   EXPECT_CALL(connection_, remoteAddress()).WillRepeatedly(ReturnRef(local_remote_address));
 
   TestHeaderMapImpl headers{{"x-request-id", "original_request_id"}};
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, uuid(_)).Times(0);
 
   ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                  route_config_, random_, runtime_, local_info_);
@@ -298,12 +324,12 @@ TEST_F(ConnectionManagerUtilityTest, OverrideRequestIdForExternalRequests) {
   EXPECT_CALL(connection_, remoteAddress()).WillRepeatedly(ReturnRef(external_ip));
   TestHeaderMapImpl headers{{"x-request-id", "original"}};
 
-  EXPECT_CALL(random_, uuid()).WillOnce(Return("override"));
+  EXPECT_CALL(random_, uuid(_));
   ON_CALL(config_, useRemoteAddress()).WillByDefault(Return(true));
 
   ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                  route_config_, random_, runtime_, local_info_);
-  EXPECT_EQ("override", headers.get_("x-request-id"));
+  EXPECT_EQ(random_.uuid_, headers.get_("x-request-id"));
 }
 
 TEST_F(ConnectionManagerUtilityTest, ExternalAddressExternalRequestUseRemote) {
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <string>
 
 #include "common/http/date_provider_impl.h"
 #include "common/http/header_map_impl.h"
@@ -25,13 +26,24 @@ TEST(DateProviderImplTest, All) {
   HeaderMapImpl headers;
   provider.setDateHeader(headers);
   EXPECT_NE(nullptr, headers.Date());
+  EXPECT_EQ(HeaderString::Type::Shared, headers.Date()->value().type());
+  EXPECT_EQ(29U, headers.Date()->value().size());
+
+  // Headers share the cached value, and keep it once the date has been refreshed.
+  HeaderMapImpl other_headers;
+  provider.setDateHeader(other_headers);
+  EXPECT_EQ(headers.Date()->value().shared(), other_headers.Date()->value().shared());
+  const std::string old_date = headers.Date()->value().c_str();
 
   EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(500)));
   timer->callback_();
+  EXPECT_EQ(old_date, headers.Date()->value().c_str());
+  EXPECT_EQ(2U, headers.Date()->value().shared()->refCount());
 
   headers.removeDate();
   provider.setDateHeader(headers);
   EXPECT_NE(nullptr, headers.Date());
+  EXPECT_NE(headers.Date()->value().shared(), other_headers.Date()->value().shared());
 }
 
 } // namespace Http
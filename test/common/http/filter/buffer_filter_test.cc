@@ -9,7 +9,10 @@
 
 #include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -35,8 +38,23 @@ public:
 
   void expectTimerCreate() { timer_ = new NiceMock<Event::MockTimer>(&callbacks_.dispatcher_); }
 
+  void setupSpilling(uint64_t spill_threshold_bytes, uint64_t max_worker_memory_bytes) {
+    config_->spill_directory_ = TestEnvironment::temporaryDirectory();
+    config_->spill_threshold_bytes_ = spill_threshold_bytes;
+    config_->max_worker_memory_bytes_ = max_worker_memory_bytes;
+    config_->worker_memory_ = tls_.allocateSlot();
+    config_->worker_memory_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+      return std::make_shared<BufferFilterWorkerMemory>();
+    });
+  }
+
+  uint64_t workerMemory() {
+    return config_->worker_memory_->getTyped<BufferFilterWorkerMemory>().bytes_;
+  }
+
   NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
   Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
   std::shared_ptr<BufferFilterConfig> config_;
   BufferFilter filter_;
   Event::MockTimer* timer_{};
@@ -99,5 +117,111 @@ TEST_F(BufferFilterTest, TxResetAfterEndStream) {
   filter_.onDestroy();
 }
 
+TEST_F(BufferFilterTest, SpillRequest) {
+  setupSpilling(5, 0);
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationAndBuffer, filter_.decodeData(data1, false));
+  EXPECT_EQ(5U, workerMemory());
+
+  // Past the threshold, the body goes to the spill file, even when the data would fit again.
+  Buffer::OwnedImpl data2(" big");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data2, false));
+  EXPECT_EQ(0U, data2.length());
+  Buffer::OwnedImpl data3(" ");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data3, false));
+  EXPECT_EQ(0U, data3.length());
+
+  // The spilled body comes back before the last data.
+  Buffer::OwnedImpl data4("world");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_.decodeData(data4, true));
+  EXPECT_EQ(" big world", TestUtility::bufferToString(data4));
+  EXPECT_EQ(1U, config_->stats_.rq_spilled_.value());
+
+  filter_.onDestroy();
+  EXPECT_EQ(0U, workerMemory());
+}
+
+TEST_F(BufferFilterTest, SpillRequestWithTrailers) {
+  setupSpilling(0, 0);
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data, false));
+
+  EXPECT_CALL(callbacks_, addDecodedData(BufferStringEqual("hello"), false));
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_.decodeTrailers(headers));
+  filter_.onDestroy();
+}
+
+// The streams of a worker share the memory limit: once it is used up, the body of other streams
+// spills.
+TEST_F(BufferFilterTest, SpillWorkerMemory) {
+  setupSpilling(100, 8);
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationAndBuffer, filter_.decodeData(data1, false));
+
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks2;
+  BufferFilter filter2(config_);
+  filter2.setDecoderFilterCallbacks(callbacks2);
+  new NiceMock<Event::MockTimer>(&callbacks2.dispatcher_);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter2.decodeHeaders(headers, false));
+  Buffer::OwnedImpl data2("world");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter2.decodeData(data2, false));
+  EXPECT_EQ(5U, workerMemory());
+
+  filter_.onDestroy();
+  EXPECT_EQ(0U, workerMemory());
+  filter2.onDestroy();
+  EXPECT_EQ(1U, config_->stats_.rq_spilled_.value());
+}
+
+TEST_F(BufferFilterTest, SpillRequestTooLarge) {
+  setupSpilling(0, 0);
+  config_->max_request_bytes_ = 8;
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data1, false));
+
+  TestHeaderMapImpl response_headers{
+      {":status", "413"}, {"content-length", "17"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  Buffer::OwnedImpl data2("world");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data2, false));
+  filter_.onDestroy();
+}
+
+TEST_F(BufferFilterTest, SpillError) {
+  setupSpilling(0, 0);
+  config_->spill_directory_ = "/nonexistent/dir";
+  expectTimerCreate();
+
+  TestHeaderMapImpl headers;
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  TestHeaderMapImpl response_headers{
+      {":status", "500"}, {"content-length", "18"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_.decodeData(data, false));
+  EXPECT_EQ(1U, config_->stats_.rq_spill_error_.value());
+  filter_.onDestroy();
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,320 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnPointee;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class CacheFilterTest : public testing::Test {
+public:
+  CacheFilterTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+    setUpConfig("{}");
+  }
+
+  void setUpConfig(const std::string& json) {
+    Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+    config_.reset(new CacheFilterConfig(*config, "test.", store_, tls_, time_source_));
+  }
+
+  struct Stream {
+    Stream(CacheFilterConfigSharedPtr config) : filter_(config) {
+      filter_.setDecoderFilterCallbacks(callbacks_);
+    }
+
+    NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+    CacheFilter filter_;
+  };
+
+  typedef std::unique_ptr<Stream> StreamPtr;
+
+  StreamPtr request(const std::string& path, FilterHeadersStatus expected_status,
+                    const HeaderMap& headers = TestHeaderMapImpl()) {
+    StreamPtr stream(new Stream(config_));
+    request_headers_.emplace_back(new TestHeaderMapImpl(headers));
+    TestHeaderMapImpl& request_headers = *request_headers_.back();
+    request_headers.addCopy(":method", "GET");
+    request_headers.addCopy(":authority", "host");
+    request_headers.addCopy(":path", path);
+    EXPECT_EQ(expected_status, stream->filter_.decodeHeaders(request_headers, true));
+    return stream;
+  }
+
+  void respond(Stream& stream, const HeaderMap& headers, const std::string& body) {
+    TestHeaderMapImpl response_headers(headers);
+    EXPECT_EQ(FilterHeadersStatus::Continue,
+              stream.filter_.encodeHeaders(response_headers, body.empty()));
+    if (!body.empty()) {
+      Buffer::OwnedImpl data(body);
+      EXPECT_EQ(FilterDataStatus::Continue, stream.filter_.encodeData(data, true));
+    }
+    stream.filter_.onDestroy();
+  }
+
+  // Expects a response served from the cache.
+  void expectServed(Stream& stream, const std::string& status, const std::string& age,
+                    const std::string& body) {
+    EXPECT_CALL(stream.callbacks_, encodeHeaders_(_, body.empty()))
+        .WillOnce(Invoke([status, age](HeaderMap& headers, bool) -> void {
+          EXPECT_STREQ(status.c_str(), headers.Status()->value().c_str());
+          EXPECT_STREQ(age.c_str(), headers.get(Headers::get().Age)->value().c_str());
+        }));
+    if (!body.empty()) {
+      EXPECT_CALL(stream.callbacks_, encodeData(_, true))
+          .WillOnce(Invoke([body](Buffer::Instance& data, bool) -> void {
+            EXPECT_EQ(body, TestUtility::bufferToString(data));
+          }));
+    }
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("test.cache." + name).value(); }
+
+  TestHeaderMapImpl cacheable_headers_{
+      {":status", "200"}, {"cache-control", "public, max-age=60"}, {"etag", "\"v1\""}};
+  MonotonicTime now_{std::chrono::seconds(1000)};
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  CacheFilterConfigSharedPtr config_;
+  std::vector<std::unique_ptr<TestHeaderMapImpl>> request_headers_;
+};
+
+TEST_F(CacheFilterTest, Hit) {
+  StreamPtr fill = request("/a", FilterHeadersStatus::Continue);
+  respond(*fill, cacheable_headers_, "hello");
+  EXPECT_EQ(1U, counter("miss"));
+  EXPECT_EQ(1U, counter("insert"));
+  EXPECT_LT(0U, store_.gauge("test.cache.cached_bytes").value());
+
+  now_ += std::chrono::seconds(5);
+  StreamPtr hit(new Stream(config_));
+  expectServed(*hit, "200", "5", "hello");
+  TestHeaderMapImpl headers{{":method", "GET"}, {":authority", "host"}, {":path", "/a"}};
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, hit->filter_.decodeHeaders(headers, true));
+  hit->filter_.onDestroy();
+  EXPECT_EQ(1U, counter("hit"));
+
+  // The key includes the host.
+  StreamPtr other(new Stream(config_));
+  TestHeaderMapImpl other_headers{{":method", "GET"}, {":authority", "other"}, {":path", "/a"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, other->filter_.decodeHeaders(other_headers, true));
+  other->filter_.onDestroy();
+}
+
+TEST_F(CacheFilterTest, Expired) {
+  respond(*request("/a", FilterHeadersStatus::Continue), cacheable_headers_, "hello");
+
+  // The age given by the origin counts against the freshness lifetime.
+  respond(*request("/b", FilterHeadersStatus::Continue),
+          TestHeaderMapImpl{{":status", "200"}, {"cache-control", "max-age=60"}, {"age", "50"}},
+          "hello");
+
+  now_ += std::chrono::seconds(10);
+  StreamPtr hit = request("/a", FilterHeadersStatus::StopIteration);
+  request("/b", FilterHeadersStatus::Continue)->filter_.onDestroy();
+
+  now_ += std::chrono::seconds(50);
+  request("/a", FilterHeadersStatus::Continue)->filter_.onDestroy();
+  EXPECT_EQ(4U, counter("miss"));
+}
+
+TEST_F(CacheFilterTest, Uncacheable) {
+  const std::vector<std::vector<std::pair<std::string, std::string>>> responses{
+      {{":status", "200"}},
+      {{":status", "200"}, {"cache-control", "no-store, max-age=60"}},
+      {{":status", "200"}, {"cache-control", "private, max-age=60"}},
+      {{":status", "200"}, {"cache-control", "max-age=60"}, {"set-cookie", "a=b"}},
+      {{":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "accept-encoding"}},
+      {{":status", "503"}, {"cache-control", "max-age=60"}}};
+  for (const auto& response : responses) {
+    TestHeaderMapImpl headers;
+    for (const auto& header : response) {
+      headers.addCopy(header.first, header.second);
+    }
+    respond(*request("/a", FilterHeadersStatus::Continue), headers, "hello");
+    request("/a", FilterHeadersStatus::Continue)->filter_.onDestroy();
+  }
+  EXPECT_EQ(0U, counter("insert"));
+  EXPECT_EQ(responses.size(), counter("uncacheable"));
+}
+
+TEST_F(CacheFilterTest, MaxEntryBytes) {
+  setUpConfig("{\"max_entry_bytes\": 4}");
+  respond(*request("/a", FilterHeadersStatus::Continue), cacheable_headers_, "hello");
+  request("/a", FilterHeadersStatus::Continue)->filter_.onDestroy();
+  EXPECT_EQ(1U, counter("uncacheable"));
+
+  // Trailers are not cached either.
+  StreamPtr stream = request("/b", FilterHeadersStatus::Continue);
+  EXPECT_EQ(FilterHeadersStatus::Continue,
+            stream->filter_.encodeHeaders(cacheable_headers_, false));
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, stream->filter_.encodeTrailers(trailers));
+  stream->filter_.onDestroy();
+  request("/b", FilterHeadersStatus::Continue)->filter_.onDestroy();
+}
+
+TEST_F(CacheFilterTest, Bypass) {
+  respond(*request("/a", FilterHeadersStatus::Continue), cacheable_headers_, "hello");
+
+  const std::vector<std::pair<std::string, std::string>> bypassing_headers{
+      {":method", "POST"}, {"authorization", "x"}, {"range", "bytes=0-1"},
+      {"cache-control", "no-cache"}};
+  for (const auto& header : bypassing_headers) {
+    Stream stream(config_);
+    TestHeaderMapImpl request_headers{{":authority", "host"}, {":path", "/a"}};
+    request_headers.addCopy(header.first, header.second);
+    if (header.first != ":method") {
+      request_headers.addCopy(":method", "GET");
+    }
+    EXPECT_EQ(FilterHeadersStatus::Continue, stream.filter_.decodeHeaders(request_headers, true));
+    stream.filter_.onDestroy();
+  }
+
+  // A request with a body is not looked up.
+  Stream stream(config_);
+  TestHeaderMapImpl request_headers{{":method", "GET"}, {":authority", "host"}, {":path", "/a"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, stream.filter_.decodeHeaders(request_headers, false));
+  stream.filter_.onDestroy();
+  EXPECT_EQ(0U, counter("hit"));
+}
+
+TEST_F(CacheFilterTest, NotModified) {
+  respond(*request("/a", FilterHeadersStatus::Continue), cacheable_headers_, "hello");
+
+  StreamPtr stream(new Stream(config_));
+  expectServed(*stream, "304", "0", "");
+  TestHeaderMapImpl headers{{":method", "GET"},
+                            {":authority", "host"},
+                            {":path", "/a"},
+                            {"if-none-match", "\"v0\", W/\"v1\""}};
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, stream->filter_.decodeHeaders(headers, true));
+  stream->filter_.onDestroy();
+  EXPECT_EQ(1U, counter("not_modified"));
+
+  // A conditional request which misses goes upstream without filling the cache.
+  request("/b", FilterHeadersStatus::Continue, TestHeaderMapImpl{{"if-none-match", "\"v1\""}})
+      ->filter_.onDestroy();
+  request("/b", FilterHeadersStatus::Continue)->filter_.onDestroy();
+  EXPECT_EQ(1U, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, Coalesced) {
+  StreamPtr fill = request("/a", FilterHeadersStatus::Continue);
+  StreamPtr waiter1 = request("/a", FilterHeadersStatus::StopIteration);
+  StreamPtr waiter2 = request("/a", FilterHeadersStatus::StopIteration);
+  EXPECT_EQ(2U, counter("coalesced"));
+
+  // A waiter which goes away is not called back.
+  EXPECT_CALL(waiter2->callbacks_, encodeHeaders_(_, _)).Times(0);
+  waiter2->filter_.onDestroy();
+
+  expectServed(*waiter1, "200", "0", "hello");
+  respond(*fill, cacheable_headers_, "hello");
+  waiter1->filter_.onDestroy();
+}
+
+TEST_F(CacheFilterTest, CoalescedUncacheable) {
+  StreamPtr fill = request("/a", FilterHeadersStatus::Continue);
+  StreamPtr waiter = request("/a", FilterHeadersStatus::StopIteration);
+
+  // Without a response to serve, the waiter goes upstream.
+  EXPECT_CALL(waiter->callbacks_, continueDecoding());
+  respond(*fill, TestHeaderMapImpl{{":status", "503"}}, "");
+  waiter->filter_.onDestroy();
+
+  // So do the waiters of a request which is reset.
+  fill = request("/a", FilterHeadersStatus::Continue);
+  waiter = request("/a", FilterHeadersStatus::StopIteration);
+  EXPECT_CALL(waiter->callbacks_, continueDecoding());
+  fill->filter_.onDestroy();
+  waiter->filter_.onDestroy();
+}
+
+TEST_F(CacheFilterTest, NotCoalesced) {
+  setUpConfig("{\"coalesce_requests\": false}");
+  StreamPtr fill = request("/a", FilterHeadersStatus::Continue);
+  request("/a", FilterHeadersStatus::Continue)->filter_.onDestroy();
+  fill->filter_.onDestroy();
+  EXPECT_EQ(0U, counter("coalesced"));
+}
+
+TEST_F(CacheFilterTest, FreshnessLifetime) {
+  EXPECT_EQ(std::chrono::seconds(0), CacheFilter::freshnessLifetime(TestHeaderMapImpl{}));
+  EXPECT_EQ(std::chrono::seconds(60), CacheFilter::freshnessLifetime(TestHeaderMapImpl{
+                                          {"cache-control", "Public, Max-Age=\"60\""}}));
+  EXPECT_EQ(std::chrono::seconds(10),
+            CacheFilter::freshnessLifetime(
+                TestHeaderMapImpl{{"cache-control", "s-maxage=10, max-age=60"}}));
+  EXPECT_EQ(std::chrono::seconds(10),
+            CacheFilter::freshnessLifetime(
+                TestHeaderMapImpl{{"cache-control", "max-age=60, s-maxage=10"}}));
+  EXPECT_EQ(std::chrono::seconds(0), CacheFilter::freshnessLifetime(TestHeaderMapImpl{
+                                         {"cache-control", "max-age=60"}, {"age", "90"}}));
+  EXPECT_EQ(std::chrono::seconds(0), CacheFilter::freshnessLifetime(
+                                         TestHeaderMapImpl{{"cache-control", "max-age=abc"}}));
+  EXPECT_EQ(std::chrono::seconds(0), CacheFilter::freshnessLifetime(TestHeaderMapImpl{
+                                         {"cache-control", "no-cache, max-age=60"}}));
+}
+
+TEST(ResponseCacheTest, LeastRecentlyUsed) {
+  const MonotonicTime now{};
+  auto make_response = [now](const std::string& body) -> CachedResponseConstSharedPtr {
+    std::shared_ptr<CachedResponse> response = std::make_shared<CachedResponse>();
+    response->headers_.reset(new TestHeaderMapImpl{{":status", "200"}});
+    response->body_ = body;
+    response->stored_time_ = now;
+    response->expiry_time_ = now + std::chrono::seconds(60);
+    return response;
+  };
+
+  // Each response takes 1 byte of key, 10 bytes of headers and 9 bytes of body.
+  ResponseCache cache(60);
+  EXPECT_EQ(0U, cache.insert("a", make_response("123456789")));
+  EXPECT_EQ(0U, cache.insert("b", make_response("123456789")));
+  EXPECT_EQ(0U, cache.insert("c", make_response("123456789")));
+  EXPECT_EQ(60U, cache.bytes());
+
+  EXPECT_NE(nullptr, cache.lookup("a", now));
+  EXPECT_EQ(1U, cache.insert("d", make_response("123456789")));
+  EXPECT_EQ(nullptr, cache.lookup("b", now));
+  EXPECT_NE(nullptr, cache.lookup("a", now));
+  EXPECT_EQ(3U, cache.size());
+
+  // Replacing a response does not evict another.
+  EXPECT_EQ(0U, cache.insert("a", make_response("123456789")));
+  EXPECT_EQ(3U, cache.size());
+
+  // A response larger than the cache is not kept.
+  EXPECT_EQ(4U, cache.insert("e", make_response(std::string(100, 'x'))));
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_EQ(0U, cache.bytes());
+
+  // Stale responses are evicted when looked up.
+  cache.insert("a", make_response("1"));
+  EXPECT_EQ(nullptr, cache.lookup("a", now + std::chrono::seconds(60)));
+  EXPECT_EQ(0U, cache.size());
+}
+
+} // namespace Http
+} // namespace Envoy
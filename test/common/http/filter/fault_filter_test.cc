@@ -388,6 +388,23 @@ TEST_F(FaultFilterTest, DelayForDownstreamCluster) {
   EXPECT_EQ(0UL, stats_.counter("prefix.fault.cluster.aborts_injected").value());
 }
 
+TEST_F(FaultFilterTest, DownstreamClusterStatsBounded) {
+  SetUpTest(fixed_delay_only_json);
+
+  for (uint32_t i = 0; i < FaultFilterConfig::MaxDownstreamClusterStats; i++) {
+    config_->downstreamClusterStats("cluster" + std::to_string(i)).delays_injected_.inc();
+  }
+  config_->downstreamClusterStats("cluster0").delays_injected_.inc();
+  EXPECT_EQ(2UL, stats_.counter("prefix.fault.cluster0.delays_injected").value());
+
+  // Clusters past the limit share one set of stats.
+  config_->downstreamClusterStats("late1").delays_injected_.inc();
+  config_->downstreamClusterStats("late2").aborts_injected_.inc();
+  EXPECT_EQ(1UL, stats_.counter("prefix.fault._other.delays_injected").value());
+  EXPECT_EQ(1UL, stats_.counter("prefix.fault._other.aborts_injected").value());
+  EXPECT_EQ(0UL, stats_.counter("prefix.fault.late1.delays_injected").value());
+}
+
 TEST_F(FaultFilterTest, FixedDelayAndAbortDownstream) {
   SetUpTest(fixed_delay_and_abort_json);
 
@@ -725,5 +742,49 @@ TEST_F(FaultFilterTest, FaultWithTargetClusterNullRoute) {
   EXPECT_EQ(0UL, config_->stats().aborts_injected_.value());
 }
 
+// With no fault configured and no fault key in runtime, requests are not looked at.
+TEST_F(FaultFilterTest, NoFaultActive) {
+  const std::string json = R"EOF(
+    {
+      "abort" : {
+        "abort_percent" : 0,
+        "http_status" : 503
+      }
+    }
+    )EOF";
+  SetUpTest(json);
+  request_headers_.addCopy("x-envoy-downstream-service-cluster", "cluster");
+
+  EXPECT_CALL(runtime_.snapshot_, generation()).WillRepeatedly(Return(1));
+  EXPECT_CALL(runtime_.snapshot_, hasKeyWithPrefix("fault.http.")).WillOnce(Return(false));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled(_, _)).Times(0);
+  EXPECT_CALL(runtime_.snapshot_, getInteger(_, _)).Times(0);
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(_, _)).Times(0);
+
+  // The answer is cached for the snapshot.
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  }
+
+  // A new snapshot may bring a fault.
+  EXPECT_CALL(runtime_.snapshot_, generation()).WillRepeatedly(Return(2));
+  EXPECT_CALL(runtime_.snapshot_, hasKeyWithPrefix("fault.http.")).WillOnce(Return(true));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("fault.http.delay.fixed_delay_percent", 0))
+      .WillOnce(Return(false));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("fault.http.cluster.delay.fixed_delay_percent", 0))
+      .WillOnce(Return(false));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("fault.http.abort.abort_percent", 0))
+      .WillOnce(Return(false));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("fault.http.cluster.abort.abort_percent", 0))
+      .WillOnce(Return(true));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.abort.http_status", 503))
+      .WillOnce(Return(503));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("fault.http.cluster.abort.http_status", 503))
+      .WillOnce(Return(503));
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(_, false));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ(1UL, config_->stats().aborts_injected_.value());
+}
+
 } // namespace Http
 } // namespace Envoy
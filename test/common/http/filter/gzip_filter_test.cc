@@ -0,0 +1,261 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/gzip_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zlib.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class GzipFilterTest : public testing::Test {
+public:
+  GzipFilterTest() { setUpFilter("{}"); }
+
+  void setUpFilter(const std::string& json) {
+    Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+    config_.reset(new GzipFilterConfig(*config, "test.", store_, tls_));
+    newFilter();
+  }
+
+  void newFilter() {
+    filter_.reset(new GzipFilter(config_));
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  // Inflate a gzip or deflate body, checking that it is complete.
+  std::string inflate(const Buffer::Instance& compressed) {
+    const std::string input = TestUtility::bufferToString(compressed);
+    z_stream stream{};
+    // Adding 32 to the window bits detects either wrapper.
+    EXPECT_EQ(Z_OK, inflateInit2(&stream, 15 + 32));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = input.size();
+
+    std::string output;
+    int result;
+    do {
+      char chunk[4096];
+      stream.next_out = reinterpret_cast<Bytef*>(chunk);
+      stream.avail_out = sizeof(chunk);
+      result = ::inflate(&stream, Z_NO_FLUSH);
+      EXPECT_TRUE(result == Z_OK || result == Z_STREAM_END);
+      output.append(chunk, sizeof(chunk) - stream.avail_out);
+    } while (result == Z_OK && stream.avail_in > 0);
+    EXPECT_EQ(Z_STREAM_END, result);
+    inflateEnd(&stream);
+    return output;
+  }
+
+  void expectNotCompressed(TestHeaderMapImpl& headers) {
+    newFilter();
+    requestWith("gzip");
+    const bool encoded = headers.has("content-encoding");
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_EQ(encoded, headers.has("content-encoding"));
+
+    Buffer::OwnedImpl data("hello");
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    EXPECT_EQ("hello", TestUtility::bufferToString(data));
+    filter_->onDestroy();
+  }
+
+  void requestWith(const std::string& accept_encoding) {
+    TestHeaderMapImpl request_headers{{"accept-encoding", accept_encoding}};
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Stats::IsolatedStoreImpl store_;
+  GzipFilterConfigSharedPtr config_;
+  std::unique_ptr<GzipFilter> filter_;
+  NiceMock<MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+};
+
+TEST_F(GzipFilterTest, AcceptedCoding) {
+  const std::vector<ContentCoding> zlib{ContentCoding::Gzip, ContentCoding::Deflate};
+  EXPECT_EQ(ContentCoding::Gzip, GzipFilter::acceptedCoding("gzip", zlib));
+  EXPECT_EQ(ContentCoding::Gzip, GzipFilter::acceptedCoding("deflate, GZIP", zlib));
+  EXPECT_EQ(ContentCoding::Gzip, GzipFilter::acceptedCoding("*", zlib));
+  EXPECT_EQ(ContentCoding::Deflate, GzipFilter::acceptedCoding("deflate", zlib));
+  EXPECT_EQ(ContentCoding::Deflate, GzipFilter::acceptedCoding("gzip;q=0, deflate;q=0.5", zlib));
+  EXPECT_EQ(ContentCoding::Deflate, GzipFilter::acceptedCoding("gzip; q=0, *", zlib));
+  EXPECT_EQ(ContentCoding::Deflate, GzipFilter::acceptedCoding("gzip;q=0.5, deflate", zlib));
+  EXPECT_EQ(ContentCoding::Identity, GzipFilter::acceptedCoding("identity", zlib));
+  EXPECT_EQ(ContentCoding::Identity, GzipFilter::acceptedCoding("gzip;q=0, deflate;q=0", zlib));
+  EXPECT_EQ(ContentCoding::Identity, GzipFilter::acceptedCoding("*;q=0", zlib));
+  EXPECT_EQ(ContentCoding::Identity, GzipFilter::acceptedCoding("", zlib));
+  EXPECT_EQ(ContentCoding::Identity, GzipFilter::acceptedCoding("br, zstd", zlib));
+
+  const std::vector<ContentCoding> all{ContentCoding::Zstd, ContentCoding::Brotli,
+                                       ContentCoding::Gzip, ContentCoding::Deflate};
+  EXPECT_EQ(ContentCoding::Zstd, GzipFilter::acceptedCoding("gzip, br, zstd", all));
+  EXPECT_EQ(ContentCoding::Brotli, GzipFilter::acceptedCoding("gzip, deflate, br", all));
+  EXPECT_EQ(ContentCoding::Gzip, GzipFilter::acceptedCoding("gzip, br;q=0.8", all));
+  EXPECT_EQ(ContentCoding::Zstd, GzipFilter::acceptedCoding("*", all));
+}
+
+TEST_F(GzipFilterTest, CompressStreamedBody) {
+  requestWith("gzip, deflate");
+
+  TestHeaderMapImpl headers{
+      {":status", "200"}, {"content-type", "text/html; charset=utf-8"}, {"content-length", "4000"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ(nullptr, headers.ContentLength());
+  EXPECT_EQ("gzip", headers.get_("content-encoding"));
+  EXPECT_EQ("Accept-Encoding", headers.get_("vary"));
+
+  std::string body;
+  std::string compressed;
+  for (uint32_t i = 0; i < 4; i++) {
+    Buffer::OwnedImpl data(std::string(1000, 'a' + i));
+    body += TestUtility::bufferToString(data);
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, i == 3));
+    compressed += TestUtility::bufferToString(data);
+  }
+
+  Buffer::OwnedImpl compressed_buffer(compressed);
+  EXPECT_EQ(body, inflate(compressed_buffer));
+  EXPECT_EQ(1U, store_.counter("test.gzip.compressed").value());
+  EXPECT_EQ(4000U, store_.counter("test.gzip.total_uncompressed_bytes").value());
+  EXPECT_EQ(compressed.size(), store_.counter("test.gzip.total_compressed_bytes").value());
+  filter_->onDestroy();
+}
+
+TEST_F(GzipFilterTest, CompressWithTrailers) {
+  requestWith("deflate");
+
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "application/json"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ("deflate", headers.get_("content-encoding"));
+
+  Buffer::OwnedImpl data("{\"hello\": \"world\"}");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, false));
+  Buffer::OwnedImpl compressed;
+  compressed.move(data);
+
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) -> void { compressed.move(data); }));
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->encodeTrailers(trailers));
+  EXPECT_EQ("{\"hello\": \"world\"}", inflate(compressed));
+  filter_->onDestroy();
+}
+
+TEST_F(GzipFilterTest, CompressorPooled) {
+  for (uint32_t i = 0; i < 2; i++) {
+    newFilter();
+    requestWith("gzip");
+    TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+
+    // The second response reuses the compressor which the first released, after a reset.
+    Buffer::OwnedImpl data("hello world, hello world");
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    EXPECT_EQ("hello world, hello world", inflate(data));
+    filter_->onDestroy();
+  }
+}
+
+TEST_F(GzipFilterTest, CompressWithBrotliAndZstd) {
+  setUpFilter("{\"content_encoding\": [\"br\", \"zstd\", \"gzip\"]}");
+  const std::string body(10000, 'x');
+
+  for (const std::string& coding : {"br", "zstd"}) {
+    newFilter();
+    requestWith("gzip, deflate, " + coding);
+    TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_EQ(coding, headers.get_("content-encoding"));
+
+    Buffer::OwnedImpl data(body);
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    EXPECT_NE(0U, data.length());
+    EXPECT_GT(body.size(), data.length());
+    filter_->onDestroy();
+  }
+  EXPECT_EQ(2U, store_.counter("test.gzip.compressed").value());
+}
+
+TEST_F(GzipFilterTest, NotCompressed) {
+  // No accept-encoding header.
+  {
+    TestHeaderMapImpl request_headers;
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+    TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_FALSE(headers.has("content-encoding"));
+    EXPECT_EQ(1U, store_.counter("test.gzip.no_accept_header").value());
+    filter_->onDestroy();
+  }
+
+  TestHeaderMapImpl png{{":status", "200"}, {"content-type", "image/png"}};
+  expectNotCompressed(png);
+  TestHeaderMapImpl encoded{
+      {":status", "200"}, {"content-type", "text/plain"}, {"content-encoding", "br"}};
+  expectNotCompressed(encoded);
+  EXPECT_EQ("br", encoded.get_("content-encoding"));
+  TestHeaderMapImpl no_transform{
+      {":status", "200"}, {"content-type", "text/plain"}, {"cache-control", "no-transform"}};
+  expectNotCompressed(no_transform);
+  TestHeaderMapImpl short_body{
+      {":status", "200"}, {"content-type", "text/plain"}, {"content-length", "10"}};
+  expectNotCompressed(short_body);
+  TestHeaderMapImpl no_content_type{{":status", "200"}};
+  expectNotCompressed(no_content_type);
+
+  EXPECT_EQ(5U, store_.counter("test.gzip.not_compressed").value());
+  EXPECT_EQ(0U, store_.counter("test.gzip.compressed").value());
+}
+
+TEST_F(GzipFilterTest, ConfiguredContentTypes) {
+  setUpFilter(R"EOF(
+  {
+    "compression_level": "best",
+    "compression_strategy": "rle",
+    "content_length": 0,
+    "content_type": ["image/png"],
+    "window_bits": 12,
+    "memory_level": 9,
+    "chunk_size": 256
+  }
+  )EOF");
+  EXPECT_TRUE(config_->isCompressibleContentType("IMAGE/PNG"));
+  EXPECT_FALSE(config_->isCompressibleContentType("text/html"));
+  EXPECT_EQ(0U, config_->minimumLength());
+
+  requestWith("gzip");
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "image/png"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  const std::string body(10000, 'x');
+  Buffer::OwnedImpl data(body);
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+  EXPECT_EQ(body, inflate(data));
+  filter_->onDestroy();
+}
+
+TEST_F(GzipFilterTest, BadConfig) {
+  EXPECT_THROW(setUpFilter("{\"compression_level\": \"fast\"}"), Json::Exception);
+  EXPECT_THROW(setUpFilter("{\"window_bits\": 16}"), Json::Exception);
+  EXPECT_THROW(setUpFilter("{\"unknown\": 1}"), Json::Exception);
+  EXPECT_THROW(setUpFilter("{\"content_encoding\": [\"compress\"]}"), Json::Exception);
+  EXPECT_THROW(setUpFilter("{\"brotli_quality\": 12}"), Json::Exception);
+}
+
+} // namespace Http
+} // namespace Envoy
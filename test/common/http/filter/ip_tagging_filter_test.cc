@@ -22,8 +22,8 @@ public:
       "request_type" : "internal",
       "ip_tags" : [
         {
-          "ip_tag_name" : "test_internal",
-          "ip_list" : ["1.2.3.4"]
+          "ip_tag_name" : "internal_request",
+          "ip_list" : ["1.2.3.0/24"]
         }
       ]
     }
@@ -34,7 +34,7 @@ public:
       "request_type" : "external",
       "ip_tags" : [
         {
-          "ip_tag_name" : "test_external",
+          "ip_tag_name" : "external_request",
           "ip_list" : ["1.2.3.4"]
         }
       ]
@@ -48,6 +48,10 @@ public:
         {
           "ip_tag_name" : "test_both",
           "ip_list" : ["1.2.3.4"]
+        },
+        {
+          "ip_tag_name" : "test_nested",
+          "ip_list" : ["1.2.0.0/16", "2001:db8::/32"]
         }
       ]
     }
@@ -71,26 +75,76 @@ public:
 
 TEST_F(IpTaggingFilterTest, InternalRequest) {
   SetUpTest(internal_request_json);
+  filter_callbacks_.downstream_address_ = "1.2.3.5";
+
+  // Only internal requests are tagged.
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
 
+  request_headers_.addCopy(Headers::get().EnvoyInternalRequest, "true");
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("internal_request", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+
+  // An address without tags has no header.
+  filter_callbacks_.downstream_address_ = "1.2.4.1";
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
 }
 
 TEST_F(IpTaggingFilterTest, ExternalRequest) {
   SetUpTest(external_request_json);
+  filter_callbacks_.downstream_address_ = "1.2.3.4";
 
+  // The tags sent by the client are replaced.
+  request_headers_.addCopy(Headers::get().EnvoyIpTags, "spoofed");
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("external_request", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+
+  TestHeaderMapImpl internal_headers{{"x-envoy-internal", "true"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(internal_headers, false));
+  EXPECT_FALSE(internal_headers.has(Headers::get().EnvoyIpTags));
 }
 
 TEST_F(IpTaggingFilterTest, BothRequest) {
   SetUpTest(both_request_json);
 
+  filter_callbacks_.downstream_address_ = "1.2.3.4";
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("test_both,test_nested", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+
+  TestHeaderMapImpl internal_headers{{"x-envoy-internal", "true"}};
+  filter_callbacks_.downstream_address_ = "2001:db8::1";
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(internal_headers, false));
+  EXPECT_EQ("test_nested", internal_headers.get_(Headers::get().EnvoyIpTags));
+}
+
+TEST_F(IpTaggingFilterTest, NoDownstreamAddress) {
+  SetUpTest(both_request_json);
+
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
+}
+
+TEST(IpTaggingFilterConfigTest, BadIpList) {
+  std::string json = R"EOF(
+    {
+      "ip_tags" : [
+        {
+          "ip_tag_name" : "test",
+          "ip_list" : ["1.2.3.4/33"]
+        }
+      ]
+    }
+  )EOF";
+
+  Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+  EXPECT_THROW(IpTaggingFilterConfig{*config}, EnvoyException);
 }
 
 } // namespace Http
@@ -0,0 +1,87 @@
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter_timing.h"
+#include "common/http/header_map_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/stats/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Property;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class FilterTimingCallbacksTest : public testing::Test {
+public:
+  FilterTimingCallbacksTest()
+      : stats_(FilterTimingCallbacks::generateStats("filter.foo.", store_)),
+        callbacks_(parent_, stats_) {}
+
+  void expectTimed(const std::string& name) {
+    EXPECT_CALL(store_, deliverHistogramToSinks(Property(&Stats::Metric::name, name), _));
+  }
+
+  NiceMock<Stats::MockStore> store_;
+  FilterTimingStats stats_;
+  MockFilterChainFactoryCallbacks parent_;
+  FilterTimingCallbacks callbacks_;
+};
+
+TEST_F(FilterTimingCallbacksTest, DecoderFilter) {
+  std::shared_ptr<MockStreamDecoderFilter> filter(new NiceMock<MockStreamDecoderFilter>());
+  StreamDecoderFilterSharedPtr timed;
+  EXPECT_CALL(parent_, addStreamDecoderFilter(_)).WillOnce(SaveArg<0>(&timed));
+  callbacks_.addStreamDecoderFilter(filter);
+  ASSERT_NE(filter, timed);
+
+  TestHeaderMapImpl headers;
+  Buffer::OwnedImpl data;
+  EXPECT_CALL(*filter, decodeHeaders(_, false))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+  expectTimed("filter.foo.decode_headers_us");
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, timed->decodeHeaders(headers, false));
+
+  EXPECT_CALL(*filter, decodeData(_, false)).WillOnce(Return(FilterDataStatus::Continue));
+  expectTimed("filter.foo.decode_data_us");
+  EXPECT_EQ(FilterDataStatus::Continue, timed->decodeData(data, false));
+
+  EXPECT_CALL(*filter, decodeTrailers(_)).WillOnce(Return(FilterTrailersStatus::Continue));
+  expectTimed("filter.foo.decode_trailers_us");
+  EXPECT_EQ(FilterTrailersStatus::Continue, timed->decodeTrailers(headers));
+
+  EXPECT_CALL(*filter, onDestroy());
+  timed->onDestroy();
+}
+
+TEST_F(FilterTimingCallbacksTest, DualFilter) {
+  std::shared_ptr<MockStreamFilter> filter(new NiceMock<MockStreamFilter>());
+  StreamFilterSharedPtr timed;
+  EXPECT_CALL(parent_, addStreamFilter(_)).WillOnce(SaveArg<0>(&timed));
+  callbacks_.addStreamFilter(filter);
+
+  NiceMock<MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  EXPECT_CALL(*filter, setDecoderFilterCallbacks(_));
+  timed->setDecoderFilterCallbacks(decoder_callbacks);
+
+  TestHeaderMapImpl headers;
+  EXPECT_CALL(*filter, encodeHeaders(_, true)).WillOnce(Return(FilterHeadersStatus::Continue));
+  expectTimed("filter.foo.encode_headers_us");
+  EXPECT_EQ(FilterHeadersStatus::Continue, timed->encodeHeaders(headers, true));
+}
+
+TEST_F(FilterTimingCallbacksTest, AccessLogHandler) {
+  EXPECT_CALL(parent_, addAccessLogHandler(_));
+  callbacks_.addAccessLogHandler(nullptr);
+}
+
+} // namespace Http
+} // namespace Envoy
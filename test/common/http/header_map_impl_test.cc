@@ -1,15 +1,29 @@
 #include <string>
 
 #include "common/http/header_map_impl.h"
+#include "common/http/header_value_interner.h"
 
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
 namespace Http {
 
+namespace {
+
+// Exposes the sizes of the protected HeaderMapImpl storage types.
+class HeaderMapImplSizes : public HeaderMapImpl {
+public:
+  static uint32_t inlineCapacity() { return HeaderList::InlineCapacity; }
+  static size_t headerList() { return sizeof(HeaderList); }
+  static size_t headerEntry() { return sizeof(HeaderEntryImpl); }
+};
+
+} // namespace
+
 TEST(HeaderStringTest, All) {
   // Static LowerCaseString constructor
   {
@@ -260,6 +274,73 @@ TEST(HeaderStringTest, All) {
   }
 }
 
+TEST(HeaderStringTest, Shared) {
+  const std::string data(200, 'a');
+  SharedHeaderValue* value = SharedHeaderValue::create(data.c_str(), data.size());
+
+  // Set and move.
+  {
+    HeaderString string;
+    string.setShared(*value);
+    EXPECT_EQ(HeaderString::Type::Shared, string.type());
+    EXPECT_EQ(value->data(), string.c_str());
+    EXPECT_EQ(200U, string.size());
+    EXPECT_EQ(2U, value->refCount());
+
+    HeaderString string2(std::move(string));
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+    EXPECT_TRUE(string.empty());
+    EXPECT_EQ(HeaderString::Type::Shared, string2.type());
+    EXPECT_EQ(value->data(), string2.c_str());
+    EXPECT_EQ(2U, value->refCount());
+
+    // Setting the same value again does not drop the reference.
+    string2.setShared(*value);
+    EXPECT_EQ(2U, value->refCount());
+  }
+  EXPECT_EQ(1U, value->refCount());
+
+  // Append copies the value.
+  {
+    HeaderString string;
+    string.setShared(*value);
+    string.append("b", 1);
+    EXPECT_EQ(HeaderString::Type::Dynamic, string.type());
+    EXPECT_EQ(data + "b", string.c_str());
+    EXPECT_EQ(1U, value->refCount());
+    EXPECT_EQ(data, value->data());
+  }
+
+  // Overwrites drop the reference.
+  {
+    HeaderString string;
+    string.setShared(*value);
+    string.setCopy("hello", 5);
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+    EXPECT_STREQ("hello", string.c_str());
+    EXPECT_EQ(1U, value->refCount());
+
+    string.setShared(*value);
+    string.setInteger(5);
+    EXPECT_STREQ("5", string.c_str());
+    EXPECT_EQ(1U, value->refCount());
+
+    std::string static_string("hello");
+    string.setShared(*value);
+    string.setReference(static_string);
+    EXPECT_EQ(HeaderString::Type::Reference, string.type());
+    EXPECT_EQ(1U, value->refCount());
+
+    string.setShared(*value);
+    string.clear();
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+    EXPECT_TRUE(string.empty());
+    EXPECT_EQ(1U, value->refCount());
+  }
+
+  value->release();
+}
+
 TEST(HeaderMapImplTest, InlineInsert) {
   HeaderMapImpl headers;
   EXPECT_EQ(nullptr, headers.Host());
@@ -280,6 +361,40 @@ TEST(HeaderMapImplTest, MoveIntoInline) {
   EXPECT_STREQ("hello", headers.Host()->value().c_str());
 }
 
+TEST(HeaderMapImplTest, RemoveList) {
+  HeaderMapImpl headers;
+  LowerCaseString foo("foo");
+  LowerCaseString bar("bar");
+  LowerCaseString baz("baz");
+  LowerCaseString other("other");
+  headers.addCopy(foo, "1");
+  headers.insertContentLength().value(5);
+  headers.addCopy(bar, "2");
+  headers.addCopy(other, "3");
+  headers.addCopy(foo, "4");
+  EXPECT_EQ(5UL, headers.size());
+
+  headers.remove(std::list<LowerCaseString>{foo, Headers::get().ContentLength, bar, baz});
+  EXPECT_EQ(nullptr, headers.get(foo));
+  EXPECT_EQ(nullptr, headers.get(bar));
+  EXPECT_EQ(nullptr, headers.ContentLength());
+  EXPECT_STREQ("3", headers.get(other)->value().c_str());
+  EXPECT_EQ(1UL, headers.size());
+
+  // Once the custom header index is built, keys are removed through it.
+  for (int i = 0; i < 16; i++) {
+    headers.addCopy(LowerCaseString("x-header-" + std::to_string(i)), "value");
+  }
+  headers.addCopy(foo, "5");
+  EXPECT_NE(nullptr, headers.get(foo));
+  EXPECT_TRUE(headers.customHeaderIndexBuiltForTest());
+  headers.remove(std::list<LowerCaseString>{foo, LowerCaseString("x-header-3")});
+  EXPECT_EQ(nullptr, headers.get(foo));
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("x-header-3")));
+  EXPECT_NE(nullptr, headers.get(LowerCaseString("x-header-4")));
+  EXPECT_EQ(16UL, headers.size());
+}
+
 TEST(HeaderMapImplTest, Remove) {
   HeaderMapImpl headers;
 
@@ -446,5 +561,139 @@ TEST(HeaderMapImplTest, IterateReverse) {
       &cb);
 }
 
+TEST(HeaderMapImplTest, ManyHeaders) {
+  // Enough headers to spill out of the inline slots into several blocks.
+  TestHeaderMapImpl headers;
+  std::vector<const HeaderEntry*> entries;
+  for (int i = 0; i < 100; i++) {
+    headers.addCopy(fmt::format("header-{}", i), fmt::format("{}", i));
+    entries.push_back(headers.get(LowerCaseString(fmt::format("header-{}", i))));
+  }
+  EXPECT_EQ(100UL, headers.size());
+  EXPECT_TRUE(headers.customHeaderIndexBuiltForTest());
+
+  // Entries never move once added.
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(entries[i], headers.get(LowerCaseString(fmt::format("header-{}", i))));
+    EXPECT_EQ(std::to_string(i), entries[i]->value().c_str());
+  }
+
+  for (int i = 0; i < 100; i += 2) {
+    headers.remove(LowerCaseString(fmt::format("header-{}", i)));
+  }
+  EXPECT_EQ(50UL, headers.size());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(i % 2 == 0, headers.get(LowerCaseString(fmt::format("header-{}", i))) == nullptr);
+  }
+
+  // Removed slots are reused, and insertion order is kept.
+  headers.addCopy("new-header", "value");
+  EXPECT_EQ(51UL, headers.size());
+  std::vector<std::string> keys;
+  headers.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        static_cast<std::vector<std::string>*>(context)->push_back(header.key().c_str());
+        return HeaderMap::Iterate::Continue;
+      },
+      &keys);
+  ASSERT_EQ(51UL, keys.size());
+  EXPECT_EQ("header-1", keys.front());
+  EXPECT_EQ("header-99", keys[49]);
+  EXPECT_EQ("new-header", keys.back());
+}
+
+TEST(HeaderMapImplTest, DuplicateCustomHeaders) {
+  TestHeaderMapImpl headers;
+  for (int i = 0; i < 20; i++) {
+    headers.addCopy("dup", std::to_string(i));
+    headers.addCopy(fmt::format("other-{}", i), "value");
+  }
+
+  // The first header with the key is returned, both before and after the index is built.
+  EXPECT_STREQ("0", headers.get(LowerCaseString("dup"))->value().c_str());
+  EXPECT_TRUE(headers.customHeaderIndexBuiltForTest());
+  headers.addCopy("dup", "20");
+  EXPECT_STREQ("0", headers.get(LowerCaseString("dup"))->value().c_str());
+
+  headers.remove(LowerCaseString("dup"));
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("dup")));
+  EXPECT_EQ(20UL, headers.size());
+
+  headers.addCopy("dup", "again");
+  EXPECT_STREQ("again", headers.get(LowerCaseString("dup"))->value().c_str());
+}
+
+TEST(HeaderMapImplTest, GetInlineByName) {
+  TestHeaderMapImpl headers{{"host", "foo"}, {"content-length", "5"}};
+  EXPECT_STREQ("foo", headers.get(Headers::get().Host)->value().c_str());
+  EXPECT_EQ(headers.ContentLength(), headers.get(Headers::get().ContentLength));
+  // The legacy host header is stored as :authority.
+  EXPECT_EQ(nullptr, headers.get(Headers::get().HostLegacy));
+  EXPECT_EQ(nullptr, headers.get(Headers::get().Path));
+}
+
+TEST(HeaderMapImplTest, AllInlineHeadersAreInline) {
+  HeaderMapImpl headers;
+#define ADD_AND_CHECK_INLINE(name)                                                                 \
+  headers.addCopy(Headers::get().name, "value");                                                   \
+  EXPECT_NE(nullptr, headers.name()) << Headers::get().name.get();
+
+  ALL_INLINE_HEADERS(ADD_AND_CHECK_INLINE)
+#undef ADD_AND_CHECK_INLINE
+
+  // Near misses of inline header names are not inline.
+  HeaderMapImpl other;
+  other.addCopy(LowerCaseString(":pat"), "value");
+  other.addCopy(LowerCaseString(":paths"), "value");
+  other.addCopy(LowerCaseString(""), "value");
+  EXPECT_EQ(nullptr, other.Path());
+  EXPECT_EQ(3UL, other.size());
+}
+
+TEST(HeaderMapImplTest, Move) {
+  TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}, {"x-foo", "bar"}};
+  for (int i = 0; i < 20; i++) {
+    headers.addCopy(fmt::format("header-{}", i), "value");
+  }
+  EXPECT_NE(nullptr, headers.get(LowerCaseString("x-foo")));
+
+  TestHeaderMapImpl moved(std::move(headers));
+  EXPECT_EQ(0UL, headers.size());
+  EXPECT_EQ(nullptr, headers.Method());
+  EXPECT_EQ(23UL, moved.size());
+  EXPECT_STREQ("GET", moved.Method()->value().c_str());
+  EXPECT_STREQ("/", moved.Path()->value().c_str());
+  EXPECT_STREQ("bar", moved.get(LowerCaseString("x-foo"))->value().c_str());
+  EXPECT_STREQ("value", moved.get(LowerCaseString("header-19"))->value().c_str());
+
+  moved = TestHeaderMapImpl{{":method", "POST"}};
+  EXPECT_EQ(1UL, moved.size());
+  EXPECT_STREQ("POST", moved.Method()->value().c_str());
+  EXPECT_EQ(nullptr, moved.Path());
+  moved.removeMethod();
+  EXPECT_EQ(0UL, moved.size());
+}
+
+TEST(HeaderMapImplTest, InlineStorageSize) {
+  // Every map carries its inline entry slots, so only a few entries are stored inline.
+  EXPECT_EQ(4U, HeaderMapImplSizes::inlineCapacity());
+  EXPECT_LE(HeaderMapImplSizes::headerList(),
+            4 * HeaderMapImplSizes::headerEntry() + 64 /* bookkeeping */);
+}
+
+TEST(HeaderMapImplTest, ReuseFreedMaps) {
+  // Take a map from the free list first so that there is room on it for the map freed below.
+  HeaderMapPtr room{new HeaderMapImpl()};
+  HeaderMapPtr headers{new HeaderMapImpl{{Headers::get().Method, "GET"}}};
+  HeaderMap* first = headers.get();
+  headers.reset();
+
+  // A freed map's memory is handed to the next map allocated on this thread, which starts empty.
+  headers.reset(new HeaderMapImpl());
+  EXPECT_EQ(first, headers.get());
+  EXPECT_EQ(0UL, headers->size());
+  EXPECT_EQ(nullptr, headers->Method());
+}
+
 } // namespace Http
 } // namespace Envoy
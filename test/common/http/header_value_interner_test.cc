@@ -0,0 +1,151 @@
+#include <list>
+#include <string>
+
+#include "common/http/header_value_interner.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(HeaderValueInternerTest, SmallValuesAreCopied) {
+  HeaderValueInterner interner;
+  for (int i = 0; i < 3; i++) {
+    HeaderString string;
+    interner.setValue(string, "hello", 5);
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+    EXPECT_STREQ("hello", string.c_str());
+  }
+  EXPECT_EQ(0U, interner.size());
+}
+
+TEST(HeaderValueInternerTest, AdmittedOnSecondUse) {
+  HeaderValueInterner interner;
+  const std::string value(300, 'a');
+
+  HeaderString first;
+  interner.setValue(first, value.c_str(), value.size());
+  EXPECT_EQ(HeaderString::Type::Dynamic, first.type());
+  EXPECT_EQ(0U, interner.size());
+
+  HeaderString second;
+  interner.setValue(second, value.c_str(), value.size());
+  EXPECT_EQ(HeaderString::Type::Shared, second.type());
+  EXPECT_EQ(value, second.c_str());
+  EXPECT_EQ(1U, interner.size());
+
+  HeaderString third;
+  interner.setValue(third, value.c_str(), value.size());
+  EXPECT_EQ(HeaderString::Type::Shared, third.type());
+  EXPECT_EQ(second.c_str(), third.c_str());
+  EXPECT_EQ(1U, interner.size());
+
+  // Interning an assembled dynamic string switches it to the shared storage.
+  interner.intern(first);
+  EXPECT_EQ(HeaderString::Type::Shared, first.type());
+  EXPECT_EQ(second.c_str(), first.c_str());
+
+  HeaderString different;
+  interner.setValue(different, std::string(300, 'b').c_str(), 300);
+  EXPECT_EQ(HeaderString::Type::Dynamic, different.type());
+}
+
+TEST(HeaderValueInternerTest, Limits) {
+  HeaderValueInterner interner(2, 1000);
+
+  const std::string too_large(1001, 'a');
+  for (int i = 0; i < 2; i++) {
+    HeaderString string;
+    interner.setValue(string, too_large.c_str(), too_large.size());
+    EXPECT_EQ(HeaderString::Type::Dynamic, string.type());
+  }
+
+  // While every entry is used by a header, nothing can be evicted to admit a new value.
+  std::list<HeaderString> held;
+  for (char c : {'a', 'b', 'c'}) {
+    const std::string value(200, c);
+    for (int i = 0; i < 2; i++) {
+      held.emplace_back();
+      interner.setValue(held.back(), value.c_str(), value.size());
+      EXPECT_EQ(value, held.back().c_str());
+    }
+  }
+  EXPECT_EQ(2U, interner.size());
+
+  HeaderString string;
+  interner.setValue(string, std::string(200, 'c').c_str(), 200);
+  EXPECT_EQ(HeaderString::Type::Dynamic, string.type());
+}
+
+TEST(HeaderValueInternerTest, EvictsUnusedValues) {
+  HeaderValueInterner interner(16, 1000);
+
+  // Fill the table with values which are no longer used by any header.
+  for (int i = 0; i < 16; i++) {
+    const std::string value = std::to_string(i) + std::string(200, 'a');
+    for (int j = 0; j < 2; j++) {
+      HeaderString string;
+      interner.setValue(string, value.c_str(), value.size());
+    }
+  }
+  EXPECT_EQ(16U, interner.size());
+
+  // Keep one of them hot.
+  const std::string hot_old = "0" + std::string(200, 'a');
+  HeaderString old_string;
+  interner.setValue(old_string, hot_old.c_str(), hot_old.size());
+  EXPECT_EQ(HeaderString::Type::Shared, old_string.type());
+
+  // A new hot value is still admitted, and keeps being shared.
+  const std::string hot_new(200, 'b');
+  HeaderString first;
+  interner.setValue(first, hot_new.c_str(), hot_new.size());
+  EXPECT_EQ(HeaderString::Type::Dynamic, first.type());
+  HeaderString second;
+  interner.setValue(second, hot_new.c_str(), hot_new.size());
+  EXPECT_EQ(HeaderString::Type::Shared, second.type());
+  HeaderString third;
+  interner.setValue(third, hot_new.c_str(), hot_new.size());
+  EXPECT_EQ(HeaderString::Type::Shared, third.type());
+  EXPECT_EQ(second.c_str(), third.c_str());
+  EXPECT_EQ(16U, interner.size());
+
+  // The value still used by a header was not the one evicted.
+  HeaderString old_again;
+  interner.setValue(old_again, hot_old.c_str(), hot_old.size());
+  EXPECT_EQ(HeaderString::Type::Shared, old_again.type());
+  EXPECT_EQ(old_string.c_str(), old_again.c_str());
+
+  // Keep admitting new values. The table stays bounded, and every remaining value can still be
+  // found after the entries around it were removed.
+  for (int i = 0; i < 100; i++) {
+    const std::string value = std::to_string(i) + std::string(200, 'c');
+    for (int j = 0; j < 2; j++) {
+      HeaderString string;
+      interner.setValue(string, value.c_str(), value.size());
+      EXPECT_EQ(j == 0 ? HeaderString::Type::Dynamic : HeaderString::Type::Shared, string.type());
+    }
+  }
+  EXPECT_EQ(16U, interner.size());
+  HeaderString old_last;
+  interner.setValue(old_last, hot_old.c_str(), hot_old.size());
+  EXPECT_EQ(old_string.c_str(), old_last.c_str());
+  HeaderString new_last;
+  interner.setValue(new_last, hot_new.c_str(), hot_new.size());
+  EXPECT_EQ(second.c_str(), new_last.c_str());
+}
+
+TEST(HeaderValueInternerTest, ValuesOutliveInterner) {
+  HeaderString string;
+  {
+    HeaderValueInterner interner;
+    const std::string value(200, 'a');
+    interner.setValue(string, value.c_str(), value.size());
+    interner.setValue(string, value.c_str(), value.size());
+    EXPECT_EQ(HeaderString::Type::Shared, string.type());
+  }
+  EXPECT_EQ(std::string(200, 'a'), string.c_str());
+}
+
+} // namespace Http
+} // namespace Envoy
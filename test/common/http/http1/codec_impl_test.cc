@@ -1,3 +1,4 @@
+#include <chrono>
 #include <string>
 
 #include "envoy/buffer/buffer.h"
@@ -6,9 +7,11 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/http/exception.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/header_value_interner.h"
 #include "common/http/http1/codec_impl.h"
 
 #include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/test_common/printers.h"
@@ -27,9 +30,11 @@ namespace Envoy {
 namespace Http {
 namespace Http1 {
 
-class Http1ServerConnectionImplTest : public ::testing::Test {
+// Parameterized on whether the fast parser is used.
+class Http1ServerConnectionImplTest : public ::testing::TestWithParam<bool> {
 public:
   void initialize() {
+    codec_settings_.fast_parser_ = GetParam();
     codec_.reset(new ServerConnectionImpl(connection_, callbacks_, codec_settings_));
   }
 
@@ -83,7 +88,9 @@ void Http1ServerConnectionImplTest::expectHeadersTest(Protocol p, bool allow_abs
   EXPECT_EQ(p, codec_->protocol());
 }
 
-TEST_F(Http1ServerConnectionImplTest, EmptyHeader) {
+INSTANTIATE_TEST_CASE_P(Parsers, Http1ServerConnectionImplTest, testing::Bool());
+
+TEST_P(Http1ServerConnectionImplTest, EmptyHeader) {
   initialize();
 
   InSequence sequence;
@@ -104,7 +111,7 @@ TEST_F(Http1ServerConnectionImplTest, EmptyHeader) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http10) {
+TEST_P(Http1ServerConnectionImplTest, Http10) {
   initialize();
 
   InSequence sequence;
@@ -121,7 +128,7 @@ TEST_F(Http1ServerConnectionImplTest, Http10) {
   EXPECT_EQ(Protocol::Http10, codec_->protocol());
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http10AbsoluteNoOp) {
+TEST_P(Http1ServerConnectionImplTest, Http10AbsoluteNoOp) {
   initialize();
 
   TestHeaderMapImpl expected_headers{{":path", "/"}, {":method", "GET"}};
@@ -129,7 +136,7 @@ TEST_F(Http1ServerConnectionImplTest, Http10AbsoluteNoOp) {
   expectHeadersTest(Protocol::Http10, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http10Absolute) {
+TEST_P(Http1ServerConnectionImplTest, Http10Absolute) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -138,7 +145,7 @@ TEST_F(Http1ServerConnectionImplTest, Http10Absolute) {
   expectHeadersTest(Protocol::Http10, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath1) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePath1) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -147,7 +154,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath1) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath2) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePath2) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -156,7 +163,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePath2) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathWithPort) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePathWithPort) {
   TestHeaderMapImpl expected_headers{
       {":authority", "www.somewhere.com:4532"}, {":path", "/foo/bar"}, {":method", "GET"}};
   Buffer::OwnedImpl buffer(
@@ -164,7 +171,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathWithPort) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsoluteEnabledNoOp) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsoluteEnabledNoOp) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -173,7 +180,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsoluteEnabledNoOp) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11InvalidRequest) {
+TEST_P(Http1ServerConnectionImplTest, Http11InvalidRequest) {
   initialize();
 
   // Invalid because www.somewhere.com is not an absolute path nor an absolute url
@@ -181,7 +188,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11InvalidRequest) {
   expect400(Protocol::Http11, true, buffer);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathNoSlash) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePathNoSlash) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -190,21 +197,21 @@ TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathNoSlash) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePathBad) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePathBad) {
   initialize();
 
   Buffer::OwnedImpl buffer("GET * HTTP/1.1\r\nHost: bah\r\n\r\n");
   expect400(Protocol::Http11, true, buffer);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11AbsolutePortTooLarge) {
+TEST_P(Http1ServerConnectionImplTest, Http11AbsolutePortTooLarge) {
   initialize();
 
   Buffer::OwnedImpl buffer("GET http://foobar.com:1000000 HTTP/1.1\r\nHost: bah\r\n\r\n");
   expect400(Protocol::Http11, true, buffer);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11RelativeOnly) {
+TEST_P(Http1ServerConnectionImplTest, Http11RelativeOnly) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -213,7 +220,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11RelativeOnly) {
   expectHeadersTest(Protocol::Http11, false, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, Http11Options) {
+TEST_P(Http1ServerConnectionImplTest, Http11Options) {
   initialize();
 
   TestHeaderMapImpl expected_headers{
@@ -222,7 +229,7 @@ TEST_F(Http1ServerConnectionImplTest, Http11Options) {
   expectHeadersTest(Protocol::Http11, true, buffer, expected_headers);
 }
 
-TEST_F(Http1ServerConnectionImplTest, SimpleGet) {
+TEST_P(Http1ServerConnectionImplTest, SimpleGet) {
   initialize();
 
   InSequence sequence;
@@ -238,7 +245,7 @@ TEST_F(Http1ServerConnectionImplTest, SimpleGet) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, BadRequestNoStream) {
+TEST_P(Http1ServerConnectionImplTest, BadRequestNoStream) {
   initialize();
 
   std::string output;
@@ -249,7 +256,7 @@ TEST_F(Http1ServerConnectionImplTest, BadRequestNoStream) {
   EXPECT_EQ("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, BadRequestStartedStream) {
+TEST_P(Http1ServerConnectionImplTest, BadRequestStartedStream) {
   initialize();
 
   std::string output;
@@ -266,7 +273,7 @@ TEST_F(Http1ServerConnectionImplTest, BadRequestStartedStream) {
   EXPECT_EQ("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, HostHeaderTranslation) {
+TEST_P(Http1ServerConnectionImplTest, HostHeaderTranslation) {
   initialize();
 
   InSequence sequence;
@@ -282,7 +289,7 @@ TEST_F(Http1ServerConnectionImplTest, HostHeaderTranslation) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
+TEST_P(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
   initialize();
 
   InSequence sequence;
@@ -302,7 +309,7 @@ TEST_F(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
   EXPECT_NE(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, PostWithContentLength) {
+TEST_P(Http1ServerConnectionImplTest, PostWithContentLength) {
   initialize();
 
   InSequence sequence;
@@ -324,7 +331,7 @@ TEST_F(Http1ServerConnectionImplTest, PostWithContentLength) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
+TEST_P(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -347,7 +354,67 @@ TEST_F(Http1ServerConnectionImplTest, HeaderOnlyResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
+TEST_P(Http1ServerConnectionImplTest, SharedHeaderValueResponse) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+
+  Buffer::OwnedImpl output;
+  ON_CALL(connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+    output.move(data);
+  }));
+
+  const std::string large_value(2048, 'a');
+  const std::string small_value(200, 'b');
+  SharedHeaderValue* large = SharedHeaderValue::create(large_value.c_str(), large_value.size());
+  SharedHeaderValue* small = SharedHeaderValue::create(small_value.c_str(), small_value.size());
+  const std::string large_name("large");
+  const std::string small_name("small");
+  {
+    TestHeaderMapImpl headers{{":status", "200"}};
+    HeaderString large_key(large_name);
+    HeaderString large_string;
+    large_string.setShared(*large);
+    headers.addViaMove(std::move(large_key), std::move(large_string));
+    HeaderString small_key(small_name);
+    HeaderString small_string;
+    small_string.setShared(*small);
+    headers.addViaMove(std::move(small_key), std::move(small_string));
+    response_encoder->encodeHeaders(headers, true);
+  }
+
+  EXPECT_EQ("HTTP/1.1 200 OK\r\nlarge: " + large_value + "\r\nsmall: " + small_value +
+                "\r\ncontent-length: 0\r\n\r\n",
+            TestUtility::bufferToString(output));
+
+  // The large value is referenced by the output rather than copied, and outlives the header map.
+  uint64_t num_slices = output.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  output.getRawSlices(slices, num_slices);
+  bool referenced = false;
+  for (const Buffer::RawSlice& slice : slices) {
+    referenced |= slice.mem_ == large->data();
+  }
+  EXPECT_TRUE(referenced);
+  EXPECT_EQ(2U, large->refCount());
+  EXPECT_EQ(1U, small->refCount());
+
+  output.drain(output.length());
+  EXPECT_EQ(1U, large->refCount());
+  large->release();
+  small->release();
+}
+
+TEST_P(Http1ServerConnectionImplTest, ChunkedResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -374,7 +441,115 @@ TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
             output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, ContentLengthResponse) {
+TEST_P(Http1ServerConnectionImplTest, ChunkedResponseMultipleChunks) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  TestHeaderMapImpl headers{{":status", "200"}};
+  response_encoder->encodeHeaders(headers, false);
+
+  Buffer::OwnedImpl data1("Hello");
+  response_encoder->encodeData(data1, false);
+  Buffer::OwnedImpl data2(std::string(300, 'a'));
+  response_encoder->encodeData(data2, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n5\r\nHello\r\n12c\r\n" +
+                std::string(300, 'a') + "\r\n0\r\n\r\n",
+            output);
+}
+
+TEST_P(Http1ServerConnectionImplTest, ChunkedResponseAggregation) {
+  codec_settings_.chunk_aggregation_ = std::chrono::milliseconds(5);
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  TestHeaderMapImpl headers{{":status", "200"}};
+  response_encoder->encodeHeaders(headers, false);
+  const std::string headers_output = "HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n";
+  EXPECT_EQ(headers_output, output);
+
+  // The first two events are held back, and go out as one chunk when the timer fires.
+  Event::MockTimer* timer = new Event::MockTimer(&connection_.dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(5)));
+  Buffer::OwnedImpl event1("data: 1\n\n");
+  response_encoder->encodeData(event1, false);
+  Buffer::OwnedImpl event2("data: 2\n\n");
+  response_encoder->encodeData(event2, false);
+  EXPECT_EQ(headers_output, output);
+
+  timer->callback_();
+  EXPECT_EQ(headers_output + "12\r\ndata: 1\n\ndata: 2\n\n\r\n", output);
+
+  // The end of the stream sends whatever is held back.
+  output.clear();
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(5)));
+  Buffer::OwnedImpl event3("data: 3\n\n");
+  response_encoder->encodeData(event3, false);
+  EXPECT_EQ("", output);
+  Buffer::OwnedImpl empty;
+  response_encoder->encodeData(empty, true);
+  EXPECT_EQ("9\r\ndata: 3\n\n\r\n0\r\n\r\n", output);
+}
+
+TEST_P(Http1ServerConnectionImplTest, ChunkedResponseAggregationMaxSize) {
+  codec_settings_.chunk_aggregation_ = std::chrono::milliseconds(5);
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  TestHeaderMapImpl headers{{":status", "200"}};
+  response_encoder->encodeHeaders(headers, false);
+  output.clear();
+
+  // Enough data is sent at once, without waiting for the timer.
+  Event::MockTimer* timer = new Event::MockTimer(&connection_.dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(_));
+  Buffer::OwnedImpl data1("a");
+  response_encoder->encodeData(data1, false);
+  EXPECT_CALL(*timer, disableTimer());
+  Buffer::OwnedImpl data2(std::string(16384, 'b'));
+  response_encoder->encodeData(data2, false);
+  EXPECT_EQ("4001\r\na" + std::string(16384, 'b') + "\r\n", output);
+}
+
+TEST_P(Http1ServerConnectionImplTest, ContentLengthResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -400,7 +575,7 @@ TEST_F(Http1ServerConnectionImplTest, ContentLengthResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 11\r\n\r\nHello World", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, HeadRequestResponse) {
+TEST_P(Http1ServerConnectionImplTest, HeadRequestResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -423,7 +598,7 @@ TEST_F(Http1ServerConnectionImplTest, HeadRequestResponse) {
   EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 5\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, ExpectContinueResponse) {
+TEST_P(Http1ServerConnectionImplTest, ExpectContinueResponse) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -448,7 +623,7 @@ TEST_F(Http1ServerConnectionImplTest, ExpectContinueResponse) {
   EXPECT_EQ("HTTP/1.1 100 Continue\r\n\r\n", output);
 }
 
-TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
+TEST_P(Http1ServerConnectionImplTest, DoubleRequest) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -473,7 +648,7 @@ TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
+TEST_P(Http1ServerConnectionImplTest, RequestWithTrailers) {
   initialize();
 
   NiceMock<Http::MockStreamDecoder> decoder;
@@ -490,7 +665,7 @@ TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
   EXPECT_EQ(0U, buffer.length());
 }
 
-TEST_F(Http1ServerConnectionImplTest, WatermarkTest) {
+TEST_P(Http1ServerConnectionImplTest, WatermarkTest) {
   EXPECT_CALL(connection_, bufferLimit()).Times(1).WillOnce(Return(10));
   initialize();
 
@@ -588,6 +763,10 @@ TEST_F(Http1ClientConnectionImplTest, MultipleHeaderOnlyThenNoContentLength) {
   EXPECT_EQ("GET / HTTP/1.1\r\nhost: host\r\ncontent-length: 0\r\n\r\n", output);
   output.clear();
 
+  EXPECT_CALL(response_decoder, decodeHeaders_(_, true));
+  Buffer::OwnedImpl response("HTTP/1.1 204 No Content\r\n\r\n");
+  codec_->dispatch(response);
+
   // Simulate the underlying connection being backed up.  Ensure that it is
   // read-enabled as the new stream is created.
   EXPECT_CALL(connection_, readEnabled())
@@ -604,6 +783,59 @@ TEST_F(Http1ClientConnectionImplTest, MultipleHeaderOnlyThenNoContentLength) {
   EXPECT_EQ("GET / HTTP/1.1\r\nhost: host\r\ntransfer-encoding: chunked\r\n\r\n0\r\n\r\n", output);
 }
 
+TEST_F(Http1ClientConnectionImplTest, Pipelined) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> response_decoder1;
+  Http::StreamEncoder& request_encoder1 = codec_->newStream(response_decoder1);
+  TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}, {":authority", "host"}};
+  request_encoder1.encodeHeaders(headers, true);
+
+  // The first stream stays usable while the second is outstanding.
+  NiceMock<Http::MockStreamDecoder> response_decoder2;
+  EXPECT_CALL(connection_, readDisable(_)).Times(0);
+  Http::StreamEncoder& request_encoder2 = codec_->newStream(response_decoder2);
+  EXPECT_NE(&request_encoder1, &request_encoder2);
+  request_encoder2.encodeHeaders(headers, true);
+
+  // The flow control of the first response is unwound once it completes, so that the second one
+  // can be read.
+  EXPECT_CALL(connection_, readDisable(true));
+  request_encoder1.getStream().readDisable(true);
+  EXPECT_CALL(connection_, readDisable(false));
+  EXPECT_CALL(response_decoder1, decodeHeaders_(_, true));
+  EXPECT_CALL(response_decoder2, decodeHeaders_(_, _)).Times(0);
+  Buffer::OwnedImpl response1("HTTP/1.1 204 No Content\r\n\r\n");
+  codec_->dispatch(response1);
+
+  // Late calls of the first stream no longer reach the connection.
+  request_encoder1.getStream().readDisable(false);
+
+  EXPECT_CALL(response_decoder2, decodeHeaders_(_, true));
+  Buffer::OwnedImpl response2("HTTP/1.1 204 No Content\r\n\r\n");
+  codec_->dispatch(response2);
+}
+
+TEST_F(Http1ClientConnectionImplTest, PipelinedReset) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> response_decoder;
+  TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/"}, {":authority", "host"}};
+  Http::StreamEncoder& request_encoder1 = codec_->newStream(response_decoder);
+  request_encoder1.encodeHeaders(headers, true);
+  Http::StreamEncoder& request_encoder2 = codec_->newStream(response_decoder);
+  request_encoder2.encodeHeaders(headers, true);
+
+  // Resetting either stream resets both.
+  Http::MockStreamCallbacks callbacks1;
+  request_encoder1.getStream().addCallbacks(callbacks1);
+  Http::MockStreamCallbacks callbacks2;
+  request_encoder2.getStream().addCallbacks(callbacks2);
+  EXPECT_CALL(callbacks1, onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks2, onResetStream(StreamResetReason::LocalReset));
+  request_encoder2.getStream().resetStream(StreamResetReason::LocalReset);
+}
+
 TEST_F(Http1ClientConnectionImplTest, PrematureResponse) {
   initialize();
 
@@ -729,7 +961,7 @@ TEST_F(Http1ClientConnectionImplTest, WatermarkTest) {
 }
 
 // For issue #1421 regression test that Envoy's HTTP parser applies header limits early.
-TEST_F(Http1ServerConnectionImplTest, TestCodecHeaderLimits) {
+TEST_P(Http1ServerConnectionImplTest, TestCodecHeaderLimits) {
   initialize();
 
   std::string exception_reason;
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -41,9 +43,13 @@ namespace Http1 {
 class ConnPoolImplForTest : public ConnPoolImpl {
 public:
   ConnPoolImplForTest(Event::MockDispatcher& dispatcher,
-                      Upstream::ClusterInfoConstSharedPtr cluster)
+                      Upstream::ClusterInfoConstSharedPtr cluster,
+                      std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0),
+                      uint32_t min_ready_clients = 0, double preconnect_ratio = 1,
+                      uint32_t max_pipelined_requests = 1)
       : ConnPoolImpl(dispatcher, Upstream::makeTestHost(cluster, "tcp://127.0.0.1:9000"),
-                     Upstream::ResourcePriority::Default),
+                     Upstream::ResourcePriority::Default, idle_timeout, min_ready_clients,
+                     preconnect_ratio, max_pipelined_requests),
         mock_dispatcher_(dispatcher) {}
 
   ~ConnPoolImplForTest() {
@@ -105,7 +111,11 @@ public:
  */
 class Http1ConnPoolImplTest : public testing::Test {
 public:
-  Http1ConnPoolImplTest() : conn_pool_(dispatcher_, cluster_) {}
+  Http1ConnPoolImplTest(std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0),
+                        uint32_t min_ready_clients = 0, double preconnect_ratio = 1,
+                        uint32_t max_pipelined_requests = 1)
+      : conn_pool_(dispatcher_, cluster_, idle_timeout, min_ready_clients, preconnect_ratio,
+                   max_pipelined_requests) {}
 
   ~Http1ConnPoolImplTest() {
     // Make sure all gauges are 0.
@@ -173,6 +183,10 @@ struct ActiveTestRequest {
 
   void startRequest() { callbacks_.outer_encoder_->encodeHeaders(TestHeaderMapImpl{}, true); }
 
+  void startRequest(const std::string& method) {
+    callbacks_.outer_encoder_->encodeHeaders(TestHeaderMapImpl{{":method", method}}, true);
+  }
+
   Http1ConnPoolImplTest& parent_;
   size_t client_index_;
   NiceMock<Http::MockStreamDecoder> outer_decoder_;
@@ -603,6 +617,269 @@ TEST_F(Http1ConnPoolImplTest, RemoteCloseToCompleteResponse) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Test that the most recently used ready connection is the one that gets reused.
+ */
+TEST_F(Http1ConnPoolImplTest, ReuseMostRecentlyUsed) {
+  InSequence s;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::CreateConnection);
+  r2.startRequest();
+
+  // Client 1 goes idle last, so it is used first.
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+
+  ActiveTestRequest r3(*this, 1, ActiveTestRequest::Type::Immediate);
+  r3.startRequest();
+  r3.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+class Http1ConnPoolImplIdleTimeoutTest : public Http1ConnPoolImplTest {
+public:
+  Http1ConnPoolImplIdleTimeoutTest() : Http1ConnPoolImplTest(std::chrono::milliseconds(1000)) {}
+};
+
+/**
+ * Test that a ready connection is closed once it has been idle for the idle timeout, and that
+ * reusing it in the meantime stops the timer.
+ */
+TEST_F(Http1ConnPoolImplIdleTimeoutTest, IdleTimeout) {
+  InSequence s;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+
+  Event::MockTimer* idle_timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  r1.completeResponse(false);
+
+  EXPECT_CALL(*idle_timer, disableTimer());
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest();
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  r2.completeResponse(false);
+
+  EXPECT_CALL(*conn_pool_.test_clients_[0].connection_,
+              close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(*idle_timer, disableTimer());
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  idle_timer->callback_();
+  dispatcher_.clearDeferredDeleteList();
+
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_idle_timeout_.value());
+}
+
+class Http1ConnPoolImplMinReadyTest : public Http1ConnPoolImplTest {
+public:
+  Http1ConnPoolImplMinReadyTest() : Http1ConnPoolImplTest(std::chrono::milliseconds(0), 2) {}
+};
+
+/**
+ * Test that the pool opens connections ahead of the requests once the host has connected, and
+ * replaces a ready connection when it is taken.
+ */
+TEST_F(Http1ConnPoolImplMinReadyTest, MinReadyClients) {
+  InSequence s;
+
+  NiceMock<Http::MockStreamDecoder> outer_decoder;
+  ConnPoolCallbacks callbacks;
+  conn_pool_.expectClientCreate();
+  Http::ConnectionPool::Cancellable* handle = conn_pool_.newStream(outer_decoder, callbacks);
+  EXPECT_NE(nullptr, handle);
+
+  // The first connection takes the request, and two more are opened to be ready.
+  NiceMock<Http::MockStreamEncoder> request_encoder;
+  Http::StreamDecoder* inner_decoder;
+  EXPECT_CALL(*conn_pool_.test_clients_[0].connect_timer_, disableTimer());
+  EXPECT_CALL(*conn_pool_.test_clients_[0].codec_, newStream(_))
+      .WillOnce(DoAll(SaveArgAddress(&inner_decoder), ReturnRef(request_encoder)));
+  EXPECT_CALL(callbacks.pool_ready_, ready());
+  conn_pool_.expectClientCreate();
+  conn_pool_.expectClientCreate();
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(3U, cluster_->stats_.upstream_cx_total_.value());
+
+  EXPECT_CALL(*conn_pool_.test_clients_[1].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*conn_pool_.test_clients_[2].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[2].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(3U, cluster_->stats_.upstream_cx_total_.value());
+
+  // Taking the most recent ready connection opens another one in its place.
+  NiceMock<Http::MockStreamDecoder> outer_decoder2;
+  ConnPoolCallbacks callbacks2;
+  NiceMock<Http::MockStreamEncoder> request_encoder2;
+  Http::StreamDecoder* inner_decoder2;
+  conn_pool_.expectClientCreate();
+  EXPECT_CALL(*conn_pool_.test_clients_[2].codec_, newStream(_))
+      .WillOnce(DoAll(SaveArgAddress(&inner_decoder2), ReturnRef(request_encoder2)));
+  EXPECT_CALL(callbacks2.pool_ready_, ready());
+  EXPECT_EQ(nullptr, conn_pool_.newStream(outer_decoder2, callbacks2));
+  EXPECT_EQ(4U, cluster_->stats_.upstream_cx_total_.value());
+
+  callbacks.outer_encoder_->encodeHeaders(TestHeaderMapImpl{}, true);
+  inner_decoder->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, true);
+  callbacks2.outer_encoder_->encodeHeaders(TestHeaderMapImpl{}, true);
+  inner_decoder2->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, true);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(4);
+  for (auto& test_client : conn_pool_.test_clients_) {
+    test_client.connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  }
+  dispatcher_.clearDeferredDeleteList();
+}
+
+class Http1ConnPoolImplPreconnectTest : public Http1ConnPoolImplTest {
+public:
+  Http1ConnPoolImplPreconnectTest() : Http1ConnPoolImplTest(std::chrono::milliseconds(0), 0, 2) {}
+};
+
+/**
+ * Test that the pool keeps two connections per request once it has connected to the host.
+ */
+TEST_F(Http1ConnPoolImplPreconnectTest, Preconnect) {
+  InSequence s;
+
+  // The first connection takes the request, and another one is opened for the next request.
+  NiceMock<Http::MockStreamDecoder> outer_decoder;
+  ConnPoolCallbacks callbacks;
+  conn_pool_.expectClientCreate();
+  Http::ConnectionPool::Cancellable* handle = conn_pool_.newStream(outer_decoder, callbacks);
+  EXPECT_NE(nullptr, handle);
+
+  NiceMock<Http::MockStreamEncoder> request_encoder;
+  Http::StreamDecoder* inner_decoder;
+  EXPECT_CALL(*conn_pool_.test_clients_[0].connect_timer_, disableTimer());
+  EXPECT_CALL(*conn_pool_.test_clients_[0].codec_, newStream(_))
+      .WillOnce(DoAll(SaveArgAddress(&inner_decoder), ReturnRef(request_encoder)));
+  EXPECT_CALL(callbacks.pool_ready_, ready());
+  conn_pool_.expectClientCreate();
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+
+  EXPECT_CALL(*conn_pool_.test_clients_[1].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+
+  // The second request takes the ready connection, and two more are opened.
+  NiceMock<Http::MockStreamDecoder> outer_decoder2;
+  ConnPoolCallbacks callbacks2;
+  NiceMock<Http::MockStreamEncoder> request_encoder2;
+  Http::StreamDecoder* inner_decoder2;
+  conn_pool_.expectClientCreate();
+  conn_pool_.expectClientCreate();
+  EXPECT_CALL(*conn_pool_.test_clients_[1].codec_, newStream(_))
+      .WillOnce(DoAll(SaveArgAddress(&inner_decoder2), ReturnRef(request_encoder2)));
+  EXPECT_CALL(callbacks2.pool_ready_, ready());
+  EXPECT_EQ(nullptr, conn_pool_.newStream(outer_decoder2, callbacks2));
+  EXPECT_EQ(4U, cluster_->stats_.upstream_cx_total_.value());
+
+  callbacks.outer_encoder_->encodeHeaders(TestHeaderMapImpl{}, true);
+  inner_decoder->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, true);
+  callbacks2.outer_encoder_->encodeHeaders(TestHeaderMapImpl{}, true);
+  inner_decoder2->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, true);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(4);
+  for (auto& test_client : conn_pool_.test_clients_) {
+    test_client.connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  }
+  dispatcher_.clearDeferredDeleteList();
+}
+
+class Http1ConnPoolImplPipelineTest : public Http1ConnPoolImplTest {
+public:
+  Http1ConnPoolImplPipelineTest() : Http1ConnPoolImplTest(std::chrono::milliseconds(0), 0, 1, 2) {}
+};
+
+/**
+ * Test that requests are pipelined behind fully sent GET and HEAD requests, up to the depth.
+ */
+TEST_F(Http1ConnPoolImplPipelineTest, Pipeline) {
+  InSequence s;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest("GET");
+
+  // r2 is pipelined behind r1.
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest("HEAD");
+  EXPECT_EQ(1U, cluster_->stats_.upstream_rq_pipelined_.value());
+
+  // The first connection is at the depth, so r3 gets a new one.
+  ActiveTestRequest r3(*this, 1, ActiveTestRequest::Type::CreateConnection);
+  r3.startRequest("POST");
+
+  // Nothing is pipelined behind the POST, so r4 waits for a connection.
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r4(*this, 0, ActiveTestRequest::Type::Pending);
+
+  // The first connection stays busy until r2 completes too, which then takes r4.
+  r1.completeResponse(false);
+  r4.expectNewStream();
+  r2.completeResponse(false);
+  r4.startRequest("GET");
+  EXPECT_EQ(1U, cluster_->stats_.upstream_rq_pipelined_.value());
+
+  r3.completeResponse(false);
+  r4.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(3);
+  for (auto& test_client : conn_pool_.test_clients_) {
+    test_client.connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  }
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that nothing is pipelined behind a request which is still being sent.
+ */
+TEST_F(Http1ConnPoolImplPipelineTest, EncodeIncomplete) {
+  InSequence s;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.callbacks_.outer_encoder_->encodeHeaders(TestHeaderMapImpl{{":method", "GET"}}, false);
+
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::Pending);
+  EXPECT_EQ(0U, cluster_->stats_.upstream_rq_pipelined_.value());
+
+  EXPECT_CALL(r2.callbacks_.pool_failure_, ready());
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that a response with 'connection: close' resets the request pipelined behind it.
+ */
+TEST_F(Http1ConnPoolImplPipelineTest, ConnectionCloseHeader) {
+  InSequence s;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest("GET");
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest("GET");
+
+  Http::MockStreamCallbacks stream_callbacks;
+  r2.request_encoder_.getStream().addCallbacks(stream_callbacks);
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::ConnectionTermination));
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  r1.inner_decoder_->decodeHeaders(
+      HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}, {"Connection", "Close"}}}, true);
+  dispatcher_.clearDeferredDeleteList();
+
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_destroy_with_active_rq_.value());
+}
+
 } // namespace Http1
 } // namespace Http
 } // namespace Envoy
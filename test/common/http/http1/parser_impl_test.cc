@@ -0,0 +1,380 @@
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/http/http1/parser_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+/**
+ * Records parser callbacks as strings. Consecutive data callbacks of the same kind are merged so
+ * that traces do not depend on how the input was split.
+ */
+class RecordingCallbacks : public ParserCallbacks {
+public:
+  // Http1::ParserCallbacks
+  void onMessageBeginBase() override { events_.push_back("begin"); }
+  void onUrl(const char* data, size_t length) override { append("url", data, length); }
+  void onHeaderField(const char* data, size_t length) override { append("field", data, length); }
+  void onHeaderValue(const char* data, size_t length) override { append("value", data, length); }
+  int onHeadersCompleteBase() override {
+    events_.push_back("headers");
+    return headers_complete_rc_;
+  }
+  void onBody(const char* data, size_t length) override { append("body", data, length); }
+  void onMessageComplete() override {
+    events_.push_back("complete");
+    if (pause_on_complete_) {
+      parser_->pause();
+    }
+  }
+
+  void append(const std::string& kind, const char* data, size_t length) {
+    const std::string prefix = kind + ":";
+    if (events_.empty() || events_.back().compare(0, prefix.size(), prefix) != 0) {
+      events_.push_back(prefix);
+    }
+    events_.back().append(data, length);
+  }
+
+  std::vector<std::string> events_;
+  Parser* parser_{};
+  int headers_complete_rc_{};
+  bool pause_on_complete_{};
+};
+
+class FastParserImplTest : public testing::Test {
+public:
+  void initialize(MessageType type) {
+    callbacks_.events_.clear();
+    parser_.reset(new FastParserImpl(type, callbacks_));
+    callbacks_.parser_ = parser_.get();
+  }
+
+  size_t execute(const std::string& data) { return parser_->execute(data.c_str(), data.size()); }
+
+  std::vector<std::string> parseAll(MessageType type, const std::string& data) {
+    initialize(type);
+    EXPECT_EQ(data.size(), execute(data));
+    EXPECT_EQ(nullptr, parser_->error());
+    return callbacks_.events_;
+  }
+
+  void expectError(MessageType type, const std::string& data, const std::string& error) {
+    initialize(type);
+    execute(data);
+    ASSERT_NE(nullptr, parser_->error());
+    EXPECT_EQ(error, parser_->error());
+  }
+
+  RecordingCallbacks callbacks_;
+  ParserPtr parser_;
+};
+
+TEST_F(FastParserImplTest, SimpleRequest) {
+  const std::vector<std::string> expected{
+      "begin",       "url:/foo?bar", "field:Host", "value:example.com", "field:Empty", "value:",
+      "field:Space", "value:a  b ",  "headers",    "complete"};
+  EXPECT_EQ(expected, parseAll(MessageType::Request, "GET /foo?bar HTTP/1.1\r\nHost: "
+                                                     "example.com\r\nEmpty:\r\nSpace: \ta  b "
+                                                     "\r\n\r\n"));
+  EXPECT_EQ(HTTP_GET, parser_->method());
+  EXPECT_EQ(1, parser_->httpMajor());
+  EXPECT_EQ(1, parser_->httpMinor());
+  EXPECT_FALSE(parser_->chunked());
+  EXPECT_EQ(ULLONG_MAX, parser_->contentLength());
+}
+
+TEST_F(FastParserImplTest, BareLineFeeds) {
+  const std::vector<std::string> expected{
+      "begin",   "url:/",   "field:a", "value:b", "field:content-length", "value:2",
+      "headers", "body:hi", "complete"};
+  EXPECT_EQ(expected, parseAll(MessageType::Request,
+                               "POST / HTTP/1.0\na: b\ncontent-length: 2\n\nhi"));
+  EXPECT_EQ(0, parser_->httpMinor());
+  EXPECT_EQ(2, parser_->contentLength());
+}
+
+TEST_F(FastParserImplTest, LongValues) {
+  // Exercise the 16 byte scanning loop and its tail.
+  for (size_t size = 0; size < 100; size++) {
+    const std::string value(size, 'v');
+    const std::string url = "/" + std::string(size, 'u');
+    const std::vector<std::string> expected{"begin",   "url:" + url, "field:x", "value:" + value,
+                                            "headers", "complete"};
+    EXPECT_EQ(expected, parseAll(MessageType::Request,
+                                 "GET " + url + " HTTP/1.1\r\nx: " + value + "\r\n\r\n"));
+  }
+}
+
+TEST_F(FastParserImplTest, SplitInput) {
+  const std::vector<std::string> corpus{
+      "GET / HTTP/1.1\r\nHost: a\r\n\r\n",
+      "\r\nPOST /p HTTP/1.1\r\ncontent-length: 5\r\nx: y\r\n\r\nhelloGET / HTTP/1.1\r\n\r\n",
+      "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5;ext=1\r\nhello\r\nA\r\n0123456789\r\n0\r\ntrailer: value\r\n\r\n",
+      "PUT / HTTP/1.1\ntransfer-encoding: CHUNKED\n\n3\nabc\n0\n\n",
+  };
+
+  for (const std::string& message : corpus) {
+    const std::vector<std::string> expected = parseAll(MessageType::Request, message);
+    for (size_t split = 1; split < message.size(); split++) {
+      initialize(MessageType::Request);
+      EXPECT_EQ(split, execute(message.substr(0, split)));
+      EXPECT_EQ(message.size() - split, execute(message.substr(split)));
+      EXPECT_EQ(nullptr, parser_->error());
+      EXPECT_EQ(expected, callbacks_.events_) << message << " split at " << split;
+    }
+
+    initialize(MessageType::Request);
+    for (char c : message) {
+      EXPECT_EQ(1, parser_->execute(&c, 1));
+    }
+    EXPECT_EQ(expected, callbacks_.events_) << message;
+  }
+}
+
+TEST_F(FastParserImplTest, Shrink) {
+  const std::string message = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+  const std::vector<std::string> expected = parseAll(MessageType::Request, message);
+
+  // A partially received head survives shrinking, as does the parser once the message is done.
+  initialize(MessageType::Request);
+  EXPECT_EQ(10, execute(message.substr(0, 10)));
+  parser_->shrink();
+  EXPECT_EQ(message.size() - 10, execute(message.substr(10)));
+  parser_->shrink();
+  EXPECT_EQ(message.size(), execute(message));
+  EXPECT_EQ(nullptr, parser_->error());
+
+  std::vector<std::string> twice = expected;
+  twice.insert(twice.end(), expected.begin(), expected.end());
+  EXPECT_EQ(twice, callbacks_.events_);
+}
+
+TEST_F(FastParserImplTest, ChunkedRequest) {
+  const std::vector<std::string> expected{
+      "begin", "url:/", "field:transfer-encoding", "value:chunked", "headers", "body:Hello World",
+      "complete"};
+  EXPECT_EQ(expected, parseAll(MessageType::Request,
+                               "POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\nb\r\nHello "
+                               "World\r\n0\r\nhello: world\r\nsecond: header\r\n\r\n"));
+  EXPECT_TRUE(parser_->chunked());
+}
+
+TEST_F(FastParserImplTest, PauseOnComplete) {
+  initialize(MessageType::Request);
+  callbacks_.pause_on_complete_ = true;
+
+  const std::string request = "GET / HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(request.size(), execute(request + request));
+  EXPECT_EQ(0, execute(request));
+  EXPECT_EQ(4, callbacks_.events_.size());
+
+  parser_->resume();
+  EXPECT_EQ(request.size(), execute(request));
+  EXPECT_EQ(8, callbacks_.events_.size());
+}
+
+TEST_F(FastParserImplTest, Upgrade) {
+  initialize(MessageType::Request);
+  const std::string request =
+      "GET / HTTP/1.1\r\nConnection: keep-alive, Upgrade\r\nUpgrade: websocket\r\n\r\n";
+  EXPECT_EQ(request.size(), execute(request + "binary data"));
+  EXPECT_EQ("complete", callbacks_.events_.back());
+
+  initialize(MessageType::Request);
+  const std::string connect = "CONNECT host:443 HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(connect.size(), execute(connect + "tunnel"));
+  EXPECT_EQ(HTTP_CONNECT, parser_->method());
+}
+
+TEST_F(FastParserImplTest, Responses) {
+  {
+    const std::vector<std::string> expected{"begin", "headers", "body:Hello World"};
+    EXPECT_EQ(expected, parseAll(MessageType::Response, "HTTP/1.1 200 OK\r\n\r\nHello World"));
+    EXPECT_EQ(200, parser_->statusCode());
+    EXPECT_EQ(0, parser_->execute(nullptr, 0));
+    EXPECT_EQ("complete", callbacks_.events_.back());
+  }
+
+  {
+    const std::vector<std::string> expected{"begin", "headers", "complete"};
+    EXPECT_EQ(expected, parseAll(MessageType::Response, "HTTP/1.1 204 No Content\r\n\r\n"));
+  }
+
+  {
+    // A response to a HEAD request.
+    initialize(MessageType::Response);
+    callbacks_.headers_complete_rc_ = 1;
+    execute("HTTP/1.1 200 OK\r\nContent-Length: 20\r\n\r\n");
+    EXPECT_EQ("complete", callbacks_.events_.back());
+  }
+
+  {
+    const std::vector<std::string> expected{"begin", "headers", "complete", "begin",
+                                            "headers", "complete"};
+    EXPECT_EQ(expected,
+              parseAll(MessageType::Response, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 304\r\n\r\n"));
+    EXPECT_EQ(304, parser_->statusCode());
+  }
+}
+
+TEST_F(FastParserImplTest, Errors) {
+  expectError(MessageType::Request, "get / HTTP/1.1\r\n\r\n", "HPE_INVALID_METHOD");
+  expectError(MessageType::Request, "GET /\r\n\r\n", "HPE_INVALID_VERSION");
+  expectError(MessageType::Request, "GET / HTTP/1.1 \r\n\r\n", "HPE_INVALID_VERSION");
+  expectError(MessageType::Request, "GET / HTTQ/1.1\r\n\r\n", "HPE_INVALID_CONSTANT");
+  expectError(MessageType::Request, "GET /\x01 HTTP/1.1\r\n\r\n", "HPE_INVALID_URL");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nbad header: a\r\n\r\n",
+              "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nfolded: a\r\n b\r\n\r\n",
+              "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\na: \x01\r\n\r\n",
+              "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\na: b\rc\r\n\r\n", "HPE_LF_EXPECTED");
+  expectError(MessageType::Request, "POST / HTTP/1.1\r\ncontent-length: 1x\r\n\r\n",
+              "HPE_INVALID_CONTENT_LENGTH");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\ncontent-length: 99999999999999999999\r\n\r\n",
+              "HPE_INVALID_CONTENT_LENGTH");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\ncontent-length: 1\r\ncontent-length: 1\r\n\r\n",
+              "HPE_UNEXPECTED_CONTENT_LENGTH");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\ncontent-length: 1\r\ntransfer-encoding: chunked\r\n\r\n",
+              "HPE_UNEXPECTED_CONTENT_LENGTH");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\nx\r\n",
+              "HPE_INVALID_CHUNK_SIZE");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\n1\r\nab\r\n",
+              "HPE_LF_EXPECTED");
+  expectError(MessageType::Response, "HTTP/1.1 2000 OK\r\n\r\n", "HPE_INVALID_STATUS");
+  expectError(MessageType::Response, "XTTP/1.1 200 OK\r\n", "HPE_INVALID_CONSTANT");
+}
+
+TEST_F(FastParserImplTest, EarlyErrors) {
+  // An invalid start line is rejected before the head is complete, and before the message begins
+  // if possible.
+  initialize(MessageType::Request);
+  execute("bad");
+  EXPECT_STREQ("HPE_INVALID_METHOD", parser_->error());
+  EXPECT_TRUE(callbacks_.events_.empty());
+
+  initialize(MessageType::Request);
+  EXPECT_EQ(1, execute("G"));
+  EXPECT_EQ(nullptr, parser_->error());
+  execute("g");
+  EXPECT_STREQ("HPE_INVALID_METHOD", parser_->error());
+
+  // So is a head which grows too large.
+  initialize(MessageType::Request);
+  execute("GET / HTTP/1.1\r\n");
+  const std::string header = "foo: " + std::string(1024, 'q') + "\r\n";
+  for (int i = 0; i < 79; i++) {
+    execute(header);
+  }
+  EXPECT_EQ(nullptr, parser_->error());
+  execute(header);
+  EXPECT_STREQ("HPE_HEADER_OVERFLOW", parser_->error());
+
+  // And the end of the stream in the middle of a message.
+  initialize(MessageType::Request);
+  execute("POST / HTTP/1.1\r\ncontent-length: 10\r\n\r\nabc");
+  parser_->execute(nullptr, 0);
+  EXPECT_STREQ("HPE_INVALID_EOF_STATE", parser_->error());
+}
+
+// A request resembling what a browser sends, for benchmarking.
+const std::string BENCHMARK_REQUEST =
+    "GET /wp-content/uploads/2010/03/hello-kitty-darth-vader-pink.jpg HTTP/1.1\r\n"
+    "Host: www.kittyhell.com\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; U; Intel Mac OS X 10_6_8; ja-JP-mac; rv:1.9.2.3) "
+    "Gecko/20100401 Firefox/3.6.3 Pathtraq/0.9\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: ja,en-us;q=0.7,en;q=0.3\r\n"
+    "Accept-Encoding: gzip,deflate\r\n"
+    "Accept-Charset: Shift_JIS,utf-8;q=0.7,*;q=0.7\r\n"
+    "Keep-Alive: 115\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: wp_ozh_wsa_visits=2; wp_ozh_wsa_visit_lasttime=xxxxxxxxxx; "
+    "__utma=xxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.x; "
+    "__utmz=xxxxxxxxx.xxxxxxxxxx.x.x.utmccn=(referral)|utmcsr=reader.livedoor.com|utmcct=/"
+    "reader/|utmcmd=referral\r\n"
+    "\r\n";
+
+// Trailing whitespace in the framing headers must not change how a message is framed, and both
+// parsers must frame it the same way.
+TEST(ParserImplTest, FramingHeadersTrailingWhitespace) {
+  const std::vector<std::string> requests{
+      "POST / HTTP/1.1\r\ntransfer-encoding: chunked \r\n\r\nb\r\nHello World\r\n0\r\n\r\n",
+      "POST / HTTP/1.1\r\ntransfer-encoding: chunked\t\r\n\r\nb\r\nHello World\r\n0\r\n\r\n",
+      "POST / HTTP/1.1\r\ntransfer-encoding: chunked \t \r\n\r\nb\r\nHello World\r\n0\r\n\r\n",
+      "GET / HTTP/1.1\r\nConnection: Upgrade \r\nUpgrade: websocket\t\r\n\r\nbinary data",
+      "GET / HTTP/1.1\r\nConnection: keep-alive, Upgrade\t\r\nUpgrade: websocket \r\n\r\n"
+      "binary data",
+      "POST / HTTP/1.1\r\ncontent-length: 5 \r\n\r\nHello",
+      "POST / HTTP/1.1\r\ncontent-length: 5\t\r\n\r\nHello"};
+
+  for (const std::string& request : requests) {
+    RecordingCallbacks http_parser_callbacks;
+    HttpParserImpl http_parser(MessageType::Request, http_parser_callbacks);
+    http_parser_callbacks.parser_ = &http_parser;
+    RecordingCallbacks fast_parser_callbacks;
+    FastParserImpl fast_parser(MessageType::Request, fast_parser_callbacks);
+    fast_parser_callbacks.parser_ = &fast_parser;
+
+    EXPECT_EQ(http_parser.execute(request.c_str(), request.size()),
+              fast_parser.execute(request.c_str(), request.size()))
+        << request;
+    EXPECT_EQ(nullptr, http_parser.error()) << request;
+    EXPECT_EQ(nullptr, fast_parser.error()) << request;
+    EXPECT_EQ(http_parser_callbacks.events_, fast_parser_callbacks.events_) << request;
+    EXPECT_EQ("complete", fast_parser_callbacks.events_.back()) << request;
+    EXPECT_EQ(http_parser.chunked(), fast_parser.chunked()) << request;
+  }
+}
+
+class NullCallbacks : public ParserCallbacks {
+public:
+  // Http1::ParserCallbacks
+  void onMessageBeginBase() override {}
+  void onUrl(const char*, size_t) override {}
+  void onHeaderField(const char*, size_t) override {}
+  void onHeaderValue(const char*, size_t) override {}
+  int onHeadersCompleteBase() override { return 0; }
+  void onBody(const char*, size_t) override {}
+  void onMessageComplete() override {}
+};
+
+void benchmarkParser(const std::string& name, Parser& parser) {
+  const int iterations = 10000000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    parser.execute(BENCHMARK_REQUEST.c_str(), BENCHMARK_REQUEST.size());
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_EQ(nullptr, parser.error());
+  std::cout << name << ": " << iterations / elapsed.count() << " requests/s" << std::endl;
+}
+
+TEST(ParserImplTest, DISABLED_Benchmark) {
+  NullCallbacks callbacks;
+  HttpParserImpl http_parser(MessageType::Request, callbacks);
+  benchmarkParser("http_parser", http_parser);
+  FastParserImpl fast_parser(MessageType::Request, callbacks);
+  benchmarkParser("fast parser", fast_parser);
+}
+
+} // namespace
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
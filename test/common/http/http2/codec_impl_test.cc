@@ -24,6 +24,7 @@ using testing::Invoke;
 using testing::InvokeWithoutArgs;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnRef;
 using testing::_;
 
 namespace Envoy {
@@ -270,6 +271,34 @@ TEST_P(Http2CodecImplTest, TrailingHeadersLargeBody) {
   response_encoder_->encodeTrailers(TestHeaderMapImpl{{"trailing", "header"}});
 }
 
+// The frames of one send, including every DATA frame of a body, reach the connection in one write.
+TEST_P(Http2CodecImplTest, CoalescedWrites) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(server_connection_, write(_));
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
+  response_encoder_->encodeHeaders(response_headers, false);
+
+  // Several max sized DATA frames, within the initial window.
+  Buffer::OwnedImpl body(std::string(40000, 'a'));
+  uint64_t written = 0;
+  EXPECT_CALL(server_connection_, write(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    written = data.length();
+    client_wrapper_.dispatch(data, client_);
+  }));
+  EXPECT_CALL(response_decoder_, decodeData(_, false)).Times(AtLeast(1));
+  EXPECT_CALL(response_decoder_, decodeData(_, true));
+  response_encoder_->encodeData(body, true);
+  EXPECT_EQ(0U, body.length());
+  EXPECT_LT(40000U, written);
+}
+
 class Http2CodecImplDeferredResetTest : public Http2CodecImplTest {};
 
 TEST_P(Http2CodecImplDeferredResetTest, DeferredResetClient) {
@@ -648,6 +677,190 @@ TEST(Http2CodecUtility, reconstituteCrumbledCookies) {
   }
 }
 
+TEST_P(Http2CodecImplTest, HeaderCompressionStats) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  request_headers.addCopy("x-metadata", std::string(100, 'm'));
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  // The client and server share a store, so everything sent is also counted as received.
+  const uint64_t header_bytes = stats_store_.counter("http2.header_bytes_tx").value();
+  const uint64_t block_bytes = stats_store_.counter("http2.header_block_bytes_tx").value();
+  EXPECT_LT(100U, header_bytes);
+  EXPECT_LT(0U, block_bytes);
+  EXPECT_EQ(header_bytes, stats_store_.counter("http2.header_bytes_rx").value());
+  EXPECT_EQ(block_bytes, stats_store_.counter("http2.header_block_bytes_rx").value());
+
+  // Repeated headers are sent as dynamic table references if the server allows a table.
+  EXPECT_CALL(server_callbacks_, newStream(_)).WillOnce(ReturnRef(request_decoder_));
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  client_.newStream(response_decoder_).encodeHeaders(request_headers, true);
+  EXPECT_EQ(2 * header_bytes, stats_store_.counter("http2.header_bytes_tx").value());
+  const uint64_t block_bytes2 =
+      stats_store_.counter("http2.header_block_bytes_tx").value() - block_bytes;
+  if (server_http2settings_.hpack_table_size_ > 0) {
+    EXPECT_GT(block_bytes / 4, block_bytes2);
+  } else {
+    EXPECT_LE(block_bytes, block_bytes2);
+  }
+  EXPECT_EQ(0U, stats_store_.counter("http2.hpack_table_grown").value());
+}
+
+class Http2AdaptiveHpackTest : public testing::Test {
+public:
+  Http2AdaptiveHpackTest() {
+    // Both sides allow the larger table, so that the client's encoder makes use of it.
+    client_http2settings_.max_adaptive_hpack_table_size_ = 4 * 4096;
+    server_http2settings_.max_adaptive_hpack_table_size_ = 4 * 4096;
+    client_.reset(new TestClientConnectionImpl(client_connection_, client_callbacks_, stats_store_,
+                                               client_http2settings_));
+    server_.reset(new TestServerConnectionImpl(server_connection_, server_callbacks_,
+                                               stats_store_, server_http2settings_));
+    ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+      server_wrapper_.dispatch(data, *server_);
+    }));
+    ON_CALL(server_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+      client_wrapper_.dispatch(data, *client_);
+    }));
+    ON_CALL(server_callbacks_, newStream(_)).WillByDefault(ReturnRef(request_decoder_));
+  }
+
+  // Send a request whose metadata differs from every previous request.
+  void sendChurningRequest(uint32_t id) {
+    TestHeaderMapImpl request_headers;
+    HttpTestUtility::addDefaultHeaders(request_headers);
+    for (uint32_t i = 0; i < 4; i++) {
+      const std::string filler(300, 'a' + (id + i) % 26);
+      request_headers.addCopy(fmt::format("x-metadata-{}", i), fmt::format("{}-{}", id, filler));
+    }
+    client_->newStream(response_decoder_).encodeHeaders(request_headers, true);
+  }
+
+  uint32_t serverHpackTableSize() {
+    return nghttp2_session_get_local_settings(server_->session(),
+                                              NGHTTP2_SETTINGS_HEADER_TABLE_SIZE);
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Http2Settings client_http2settings_;
+  Http2Settings server_http2settings_;
+  NiceMock<Network::MockConnection> client_connection_;
+  NiceMock<MockConnectionCallbacks> client_callbacks_;
+  std::unique_ptr<TestClientConnectionImpl> client_;
+  Http2CodecImplTest::ConnectionWrapper client_wrapper_;
+  NiceMock<Network::MockConnection> server_connection_;
+  NiceMock<MockServerConnectionCallbacks> server_callbacks_;
+  std::unique_ptr<TestServerConnectionImpl> server_;
+  Http2CodecImplTest::ConnectionWrapper server_wrapper_;
+  NiceMock<MockStreamDecoder> response_decoder_;
+  NiceMock<MockStreamDecoder> request_decoder_;
+};
+
+TEST_F(Http2AdaptiveHpackTest, GrowsTableOnChurn) {
+  EXPECT_EQ(Http2Settings::DEFAULT_HPACK_TABLE_SIZE, serverHpackTableSize());
+
+  // Each window of churning requests doubles the table, up to the configured maximum.
+  for (uint32_t i = 0; i < 63; i++) {
+    sendChurningRequest(i);
+  }
+  EXPECT_EQ(0U, stats_store_.counter("http2.hpack_table_grown").value());
+  EXPECT_LT(0U, stats_store_.counter("http2.hpack_table_full_rx").value());
+  sendChurningRequest(63);
+  EXPECT_EQ(1U, stats_store_.counter("http2.hpack_table_grown").value());
+  EXPECT_EQ(2 * Http2Settings::DEFAULT_HPACK_TABLE_SIZE, serverHpackTableSize());
+
+  for (uint32_t i = 64; i < 64 * 4; i++) {
+    sendChurningRequest(i);
+  }
+  EXPECT_EQ(2U, stats_store_.counter("http2.hpack_table_grown").value());
+  EXPECT_EQ(4 * Http2Settings::DEFAULT_HPACK_TABLE_SIZE, serverHpackTableSize());
+}
+
+TEST_F(Http2AdaptiveHpackTest, NoGrowthWhenHeadersRepeat) {
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  request_headers.addCopy("x-metadata", std::string(300, 'm'));
+  for (uint32_t i = 0; i < 128; i++) {
+    client_->newStream(response_decoder_).encodeHeaders(request_headers, true);
+  }
+  EXPECT_EQ(0U, stats_store_.counter("http2.hpack_table_grown").value());
+  EXPECT_EQ(Http2Settings::DEFAULT_HPACK_TABLE_SIZE, serverHpackTableSize());
+}
+
+class Http2AdaptiveWindowTest : public testing::Test {
+public:
+  Http2AdaptiveWindowTest() {
+    server_http2settings_.initial_stream_window_size_ =
+        Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE;
+    server_http2settings_.initial_connection_window_size_ =
+        Http2Settings::MIN_INITIAL_CONNECTION_WINDOW_SIZE;
+    server_http2settings_.max_adaptive_window_size_ = 1024 * 1024;
+    client_.reset(new TestClientConnectionImpl(client_connection_, client_callbacks_, stats_store_,
+                                               client_http2settings_));
+    server_.reset(new TestServerConnectionImpl(server_connection_, server_callbacks_,
+                                               stats_store_, server_http2settings_));
+    ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+      server_wrapper_.dispatch(data, *server_);
+    }));
+    ON_CALL(server_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+      client_wrapper_.dispatch(data, *client_);
+    }));
+    ON_CALL(server_callbacks_, newStream(_)).WillByDefault(ReturnRef(request_decoder_));
+  }
+
+  // Send a request with a body of the given size.
+  void sendRequest(uint64_t body_size) {
+    TestHeaderMapImpl request_headers;
+    HttpTestUtility::addDefaultHeaders(request_headers);
+    StreamEncoder& request_encoder = client_->newStream(response_decoder_);
+    request_encoder.encodeHeaders(request_headers, false);
+    Buffer::OwnedImpl body(std::string(body_size, 'a'));
+    request_encoder.encodeData(body, true);
+  }
+
+  uint32_t serverWindowSize() {
+    return nghttp2_session_get_local_settings(server_->session(),
+                                              NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  Http2Settings client_http2settings_;
+  Http2Settings server_http2settings_;
+  NiceMock<Network::MockConnection> client_connection_;
+  NiceMock<MockConnectionCallbacks> client_callbacks_;
+  std::unique_ptr<TestClientConnectionImpl> client_;
+  Http2CodecImplTest::ConnectionWrapper client_wrapper_;
+  NiceMock<Network::MockConnection> server_connection_;
+  NiceMock<MockServerConnectionCallbacks> server_callbacks_;
+  std::unique_ptr<TestServerConnectionImpl> server_;
+  Http2CodecImplTest::ConnectionWrapper server_wrapper_;
+  NiceMock<MockStreamDecoder> response_decoder_;
+  NiceMock<MockStreamDecoder> request_decoder_;
+};
+
+// A body which fills the window within a round trip grows the window, up to the maximum.
+TEST_F(Http2AdaptiveWindowTest, GrowsWindowWhenFilled) {
+  EXPECT_EQ(Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE, serverWindowSize());
+
+  sendRequest(8 * 1024 * 1024);
+  EXPECT_LT(0U, stats_store_.counter("http2.window_grown").value());
+  EXPECT_LT(Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE, serverWindowSize());
+  EXPECT_GE(1024U * 1024U, serverWindowSize());
+  EXPECT_LE(serverWindowSize(),
+            nghttp2_session_get_effective_local_window_size(server_->session()));
+}
+
+TEST_F(Http2AdaptiveWindowTest, NoGrowthForSmallBodies) {
+  for (uint32_t i = 0; i < 16; i++) {
+    sendRequest(1024);
+  }
+  EXPECT_EQ(0U, stats_store_.counter("http2.window_grown").value());
+  EXPECT_EQ(Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE, serverWindowSize());
+}
+
 // For issue #1421 regression test that Envoy's H2 codec applies header limits early.
 TEST_P(Http2CodecImplTest, TestCodecHeaderLimits) {
   initialize();
@@ -59,7 +59,9 @@ public:
     Event::MockTimer* connect_timer_;
   };
 
-  Http2ConnPoolImplTest() : pool_(dispatcher_, host_, Upstream::ResourcePriority::Default) {}
+  Http2ConnPoolImplTest(uint32_t max_clients = 1, uint64_t client_stream_threshold = 0)
+      : pool_(dispatcher_, host_, Upstream::ResourcePriority::Default, max_clients,
+              client_stream_threshold) {}
 
   ~Http2ConnPoolImplTest() {
     // Make sure all gauges are 0.
@@ -119,6 +121,13 @@ public:
   NiceMock<Http::MockStreamEncoder> inner_encoder_;
 };
 
+void completeRequest(ActiveTestRequest& request) {
+  EXPECT_CALL(request.inner_encoder_, encodeHeaders(_, true));
+  request.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  EXPECT_CALL(request.decoder_, decodeHeaders_(_, true));
+  request.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+}
+
 TEST_F(Http2ConnPoolImplTest, VerifyConnectionTimingStats) {
   expectClientCreate();
   EXPECT_CALL(cluster_->stats_store_,
@@ -409,6 +418,93 @@ TEST_F(Http2ConnPoolImplTest, GoAway) {
   EXPECT_EQ(1U, cluster_->stats_.upstream_cx_close_notify_.value());
 }
 
+class Http2ConnPoolImplMultiClientTest : public Http2ConnPoolImplTest {
+public:
+  // Up to two clients, opening the second once the first has an active stream.
+  Http2ConnPoolImplMultiClientTest() : Http2ConnPoolImplTest(2, 1) {}
+};
+
+TEST_F(Http2ConnPoolImplMultiClientTest, LeastLoadedClient) {
+  expectClientCreate();
+  ActiveTestRequest r1(*this, 0);
+  expectClientCreate();
+  ActiveTestRequest r2(*this, 1);
+  expectClientConnect(0);
+  expectClientConnect(1);
+
+  // No more clients may be opened, so streams go to the least loaded one.
+  ActiveTestRequest r3(*this, 0);
+  completeRequest(r2);
+  ActiveTestRequest r4(*this, 1);
+  completeRequest(r1);
+  completeRequest(r3);
+  completeRequest(r4);
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(4U, cluster_->stats_.upstream_rq_total_.value());
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_)).Times(2);
+  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+TEST_F(Http2ConnPoolImplMultiClientTest, GoAwayOpensReplacement) {
+  expectClientCreate();
+  ActiveTestRequest r1(*this, 0);
+  expectClientConnect(0);
+
+  // The client that received GOAWAY keeps serving its active stream but takes no new ones.
+  test_clients_[0].codec_client_->raiseGoAway();
+  expectClientCreate();
+  ActiveTestRequest r2(*this, 1);
+  expectClientConnect(1);
+  expectClientCreate();
+  ActiveTestRequest r3(*this, 2);
+  expectClientConnect(2);
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  completeRequest(r1);
+  EXPECT_CALL(*this, onClientDestroy());
+  dispatcher_.clearDeferredDeleteList();
+
+  completeRequest(r2);
+  completeRequest(r3);
+  EXPECT_CALL(dispatcher_, deferredDelete_(_)).Times(2);
+  test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  test_clients_[2].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_close_notify_.value());
+}
+
+TEST_F(Http2ConnPoolImplMultiClientTest, DrainKeepsAllDrainingClients) {
+  pool_.max_streams_ = 1;
+
+  expectClientCreate();
+  ActiveTestRequest r1(*this, 0);
+  expectClientConnect(0);
+  expectClientCreate();
+  ActiveTestRequest r2(*this, 1);
+  expectClientConnect(1);
+  expectClientCreate();
+  ActiveTestRequest r3(*this, 2);
+  expectClientConnect(2);
+
+  // Both exhausted clients stay open until their streams complete.
+  ReadyWatcher drained;
+  pool_.addDrainedCallback([&]() -> void { drained.ready(); });
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_)).Times(3);
+  completeRequest(r1);
+  completeRequest(r2);
+  EXPECT_CALL(drained, ready());
+  completeRequest(r3);
+
+  EXPECT_CALL(*this, onClientDestroy()).Times(3);
+  dispatcher_.clearDeferredDeleteList();
+}
+
 } // namespace Http2
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,222 @@
+#include <list>
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http2/shared_conn_pool.h"
+
+#include "test/common/http/common.h"
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+/**
+ * Test fixture with a dispatcher for the worker and one for the owner. Posts are queued rather
+ * than run, so that each test runs the two threads in turn.
+ */
+class Http2SharedConnPoolImplTest : public testing::Test {
+public:
+  Http2SharedConnPoolImplTest() {
+    ON_CALL(dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      worker_posts_.push_back(cb);
+    }));
+    ON_CALL(owner_dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      owner_posts_.push_back(cb);
+    }));
+    pool_.reset(new SharedConnPoolImpl(dispatcher_, owner_dispatcher_,
+                                       [this]() -> ConnectionPool::Instance* {
+                                         return owner_pool_;
+                                       }));
+  }
+
+  void runPosts(std::list<Event::PostCb>& posts) {
+    while (!posts.empty()) {
+      Event::PostCb cb = posts.front();
+      posts.pop_front();
+      cb();
+    }
+  }
+
+  void runOwner() { runPosts(owner_posts_); }
+  void runWorker() { runPosts(worker_posts_); }
+
+  // Places a stream on the owner's pool, and hands it to the callbacks on the worker.
+  void expectReady(ConnPoolCallbacks& callbacks) {
+    EXPECT_CALL(mock_owner_pool_, newStream(_, _))
+        .WillOnce(Invoke([this](StreamDecoder& decoder,
+                                ConnectionPool::Callbacks& callbacks)
+                             -> ConnectionPool::Cancellable* {
+          owner_decoder_ = &decoder;
+          callbacks.onPoolReady(owner_encoder_, mock_owner_pool_.host_);
+          return nullptr;
+        }));
+    runOwner();
+
+    EXPECT_CALL(callbacks.pool_ready_, ready());
+    runWorker();
+  }
+
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Event::MockDispatcher> owner_dispatcher_;
+  std::list<Event::PostCb> worker_posts_;
+  std::list<Event::PostCb> owner_posts_;
+  NiceMock<ConnectionPool::MockInstance> mock_owner_pool_;
+  ConnectionPool::Instance* owner_pool_{&mock_owner_pool_};
+  NiceMock<MockStreamEncoder> owner_encoder_;
+  StreamDecoder* owner_decoder_{};
+  std::unique_ptr<SharedConnPoolImpl> pool_;
+};
+
+/**
+ * Test a request and response which cross over to the owner and back.
+ */
+TEST_F(Http2SharedConnPoolImplTest, RequestAndResponse) {
+  NiceMock<MockStreamDecoder> decoder;
+  ConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, pool_->newStream(decoder, callbacks));
+
+  ON_CALL(owner_encoder_.stream_, bufferLimit()).WillByDefault(Return(1024));
+  expectReady(callbacks);
+  EXPECT_EQ(mock_owner_pool_.host_, callbacks.host_);
+  EXPECT_EQ(1024U, callbacks.outer_encoder_->getStream().bufferLimit());
+
+  // The request is encoded on the owner.
+  TestHeaderMapImpl request_headers{{":method", "POST"}};
+  callbacks.outer_encoder_->encodeHeaders(request_headers, false);
+  Buffer::OwnedImpl request_data("request");
+  callbacks.outer_encoder_->encodeData(request_data, true);
+  EXPECT_EQ(0U, request_data.length());
+  EXPECT_CALL(owner_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  EXPECT_CALL(owner_encoder_, encodeData(BufferStringEqual("request"), true));
+  runOwner();
+
+  // The response is decoded on the worker.
+  owner_decoder_->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, false);
+  Buffer::OwnedImpl response_data("response");
+  EXPECT_CALL(owner_dispatcher_, deferredDelete_(_));
+  owner_decoder_->decodeData(response_data, true);
+  EXPECT_EQ(0U, response_data.length());
+
+  EXPECT_CALL(decoder, decodeHeaders_(_, false));
+  EXPECT_CALL(decoder, decodeData(BufferStringEqual("response"), true));
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  runWorker();
+
+  ReadyWatcher drained;
+  EXPECT_CALL(drained, ready());
+  pool_->addDrainedCallback([&]() -> void { drained.ready(); });
+}
+
+/**
+ * Test that a stream cancelled before the owner has placed it is cancelled on the owner's pool.
+ */
+TEST_F(Http2SharedConnPoolImplTest, CancelPending) {
+  NiceMock<MockStreamDecoder> decoder;
+  ConnPoolCallbacks callbacks;
+  ConnectionPool::Cancellable* handle = pool_->newStream(decoder, callbacks);
+  EXPECT_NE(nullptr, handle);
+  handle->cancel();
+
+  ConnectionPool::MockCancellable owner_handle;
+  EXPECT_CALL(mock_owner_pool_, newStream(_, _)).WillOnce(Return(&owner_handle));
+  EXPECT_CALL(owner_handle, cancel());
+  runOwner();
+  runWorker();
+}
+
+/**
+ * Test that the stream fails on the worker if the owner has no pool for it.
+ */
+TEST_F(Http2SharedConnPoolImplTest, NoOwnerPool) {
+  owner_pool_ = nullptr;
+
+  NiceMock<MockStreamDecoder> decoder;
+  ConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, pool_->newStream(decoder, callbacks));
+  runOwner();
+
+  EXPECT_CALL(callbacks.pool_failure_, ready());
+  runWorker();
+  EXPECT_EQ(nullptr, callbacks.host_);
+}
+
+/**
+ * Test that resetting the stream on the worker resets it on the owner.
+ */
+TEST_F(Http2SharedConnPoolImplTest, LocalReset) {
+  NiceMock<MockStreamDecoder> decoder;
+  ConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, pool_->newStream(decoder, callbacks));
+  expectReady(callbacks);
+
+  MockStreamCallbacks stream_callbacks;
+  callbacks.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::LocalReset));
+  callbacks.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runOwner();
+  runWorker();
+}
+
+/**
+ * Test that a reset on the owner reaches the stream callbacks on the worker, as do the watermark
+ * callbacks.
+ */
+TEST_F(Http2SharedConnPoolImplTest, RemoteReset) {
+  NiceMock<MockStreamDecoder> decoder;
+  ConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, pool_->newStream(decoder, callbacks));
+  expectReady(callbacks);
+
+  MockStreamCallbacks stream_callbacks;
+  callbacks.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+  owner_encoder_.stream_.runHighWatermarkCallbacks();
+  owner_encoder_.stream_.runLowWatermarkCallbacks();
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark());
+  runWorker();
+
+  owner_encoder_.stream_.resetStream(StreamResetReason::RemoteReset);
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::RemoteReset));
+  runWorker();
+}
+
+/**
+ * Test that destroying the pool fails the pending streams and resets the others.
+ */
+TEST_F(Http2SharedConnPoolImplTest, DestroyWithActiveStreams) {
+  NiceMock<MockStreamDecoder> decoder1;
+  ConnPoolCallbacks callbacks1;
+  EXPECT_NE(nullptr, pool_->newStream(decoder1, callbacks1));
+  expectReady(callbacks1);
+  MockStreamCallbacks stream_callbacks;
+  callbacks1.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+
+  NiceMock<MockStreamDecoder> decoder2;
+  ConnPoolCallbacks callbacks2;
+  EXPECT_NE(nullptr, pool_->newStream(decoder2, callbacks2));
+
+  EXPECT_CALL(callbacks2.pool_failure_, ready());
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::ConnectionTermination));
+  pool_.reset();
+}
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
@@ -18,8 +18,9 @@ TEST(UserAgentTest, All) {
   Stats::MockStore stat_store;
   NiceMock<Stats::MockHistogram> original_histogram;
   Stats::Timespan span(original_histogram);
+  UserAgentContext context("test.", stat_store);
 
-  EXPECT_CALL(stat_store.counter_, inc()).Times(5);
+  EXPECT_CALL(stat_store.counter_, inc()).Times(7);
   EXPECT_CALL(stat_store, counter("test.user_agent.ios.downstream_cx_total"));
   EXPECT_CALL(stat_store, counter("test.user_agent.ios.downstream_rq_total"));
   EXPECT_CALL(stat_store, counter("test.user_agent.ios.downstream_cx_destroy_remote_active_rq"));
@@ -31,12 +32,12 @@ TEST(UserAgentTest, All) {
 
   {
     UserAgent ua;
-    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa iOS bbb"}}, "test.", stat_store);
-    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, "test.",
-                             stat_store);
+    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa iOS bbb"}}, context);
+    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, context);
     ua.completeConnectionLength(span);
   }
 
+  // The stats of a type are only looked up for the first connection of that type.
   EXPECT_CALL(stat_store, counter("test.user_agent.android.downstream_cx_total"));
   EXPECT_CALL(stat_store, counter("test.user_agent.android.downstream_rq_total"));
   EXPECT_CALL(stat_store,
@@ -45,28 +46,33 @@ TEST(UserAgentTest, All) {
   EXPECT_CALL(
       stat_store,
       deliverHistogramToSinks(
-          Property(&Stats::Metric::name, "test.user_agent.android.downstream_cx_length_ms"), _));
+          Property(&Stats::Metric::name, "test.user_agent.android.downstream_cx_length_ms"), _))
+      .Times(2);
 
   {
     UserAgent ua;
-    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, "test.",
-                             stat_store);
+    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, context);
     ua.completeConnectionLength(span);
     ua.onConnectionDestroy(Network::ConnectionEvent::RemoteClose, true);
   }
 
   {
     UserAgent ua;
-    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa bbb"}}, "test.", stat_store);
-    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, "test.",
-                             stat_store);
+    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, context);
+    ua.completeConnectionLength(span);
+  }
+
+  {
+    UserAgent ua;
+    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa bbb"}}, context);
+    ua.initializeFromHeaders(TestHeaderMapImpl{{"user-agent", "aaa android bbb"}}, context);
     ua.completeConnectionLength(span);
     ua.onConnectionDestroy(Network::ConnectionEvent::RemoteClose, false);
   }
 
   {
     UserAgent ua;
-    ua.initializeFromHeaders(TestHeaderMapImpl{}, "test.", stat_store);
+    ua.initializeFromHeaders(TestHeaderMapImpl{}, context);
     ua.completeConnectionLength(span);
   }
 }
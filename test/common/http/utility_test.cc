@@ -32,6 +32,8 @@ TEST(HttpUtility, parseQueryString) {
             Utility::parseQueryString("/hello?hello=&hello2=world2"));
   EXPECT_EQ(Utility::QueryParams({{"name", "admin"}, {"level", "trace"}}),
             Utility::parseQueryString("/logging?name=admin&level=trace"));
+  EXPECT_EQ(Utility::QueryParams({{"usedonly", ""}, {"format", "json"}}),
+            Utility::parseQueryString("/stats?usedonly&format=json"));
 }
 
 TEST(HttpUtility, getResponseStatus) {
@@ -210,6 +212,19 @@ TEST(HttpUtility, TestParseCookieWithQuotes) {
   EXPECT_EQ(Utility::parseCookieValue(headers, "leadingdquote"), "\"foobar");
 }
 
+TEST(HttpUtility, TestFindCookieValue) {
+  TestHeaderMapImpl headers{{"cookie", "abc=def; token=\"abc123\""}, {"cookie", "empty="}};
+
+  const char* value;
+  size_t size;
+  EXPECT_TRUE(Utility::findCookieValue(headers, "token", &value, &size));
+  EXPECT_EQ("abc123", std::string(value, size));
+  EXPECT_TRUE(Utility::findCookieValue(headers, "empty", &value, &size));
+  EXPECT_EQ(0U, size);
+  EXPECT_FALSE(Utility::findCookieValue(headers, "tok", &value, &size));
+  EXPECT_FALSE(Utility::findCookieValue(headers, "missing", &value, &size));
+}
+
 TEST(HttpUtility, TestHasSetCookie) {
   TestHeaderMapImpl headers{{"someheader", "10.0.0.1"},
                             {"set-cookie", "somekey=somevalue"},
@@ -336,6 +336,35 @@ TEST(JsonLoaderTest, NestedSchema) {
                             "key: #/value1");
 }
 
+// The compiled schema is reused for later validations and a failed validation leaves it intact.
+TEST(JsonLoaderTest, SchemaReuse) {
+  std::string schema = R"EOF(
+  {
+    "properties": {
+      "value": {"type" : "array", "items" : {"type" : "integer"}}
+    },
+    "required": ["value"]
+  }
+  )EOF";
+
+  EXPECT_NO_THROW(Factory::loadFromString("{\"value\": [1, 2]}")->validateSchema(schema));
+  EXPECT_THROW(Factory::loadFromString("{\"value\": [1, \"2\"]}")->validateSchema(schema),
+               Exception);
+  EXPECT_THROW(Factory::loadFromString("{\"other\": []}")->validateSchema(schema), Exception);
+  EXPECT_NO_THROW(Factory::loadFromString("{\"value\": []}")->validateSchema(schema));
+}
+
+// A schema string that changes in place is compiled again rather than served from the cache.
+TEST(JsonLoaderTest, SchemaChangedInPlace) {
+  ObjectSharedPtr json = Factory::loadFromString("{\"value\": \"foo\"}");
+  std::string schema = R"EOF({"properties": {"value": {"type" : "string"}}})EOF";
+  EXPECT_NO_THROW(json->validateSchema(schema));
+  schema = R"EOF({"properties": {"value": {"type" : "number"}}})EOF";
+  EXPECT_THROW(json->validateSchema(schema), Exception);
+  schema = R"EOF({"properties": {"value": {"type" : "string"}}})EOF";
+  EXPECT_NO_THROW(json->validateSchema(schema));
+}
+
 TEST(JsonLoaderTest, MissingEnclosingDocument) {
 
   std::string json_string = R"EOF(
@@ -0,0 +1,105 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/json/json_stream_parser.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Json {
+
+// Records the keys, and the values of the keys which start with "want".
+class TestCallbacks : public StreamParserCallbacks {
+public:
+  bool onKey(const std::vector<std::string>& path, const std::string& key) override {
+    std::string full_key;
+    for (const std::string& parent : path) {
+      full_key += parent + ".";
+    }
+    events_.push_back(full_key + key);
+    return key.find("want") == 0;
+  }
+
+  void onValue(const std::string& value, bool is_string) override {
+    events_.push_back((is_string ? "string:" : "number:") + value);
+    if (value == "stop") {
+      parser_.stop();
+    }
+  }
+
+  // Parse the document one byte at a time, so that every token is split across chunks.
+  void parse(const std::string& document) {
+    for (char c : document) {
+      parser_.parse(&c, 1);
+    }
+    parser_.finish();
+  }
+
+  std::vector<std::string> events_;
+  StreamParser parser_{*this};
+};
+
+TEST(JsonStreamParserTest, KeysAndValues) {
+  TestCallbacks callbacks;
+  callbacks.parse(R"EOF(
+  {
+    "a": {"want_string": "v\"\u00e9\n", "b": [{"want_nested_in_array": 1}, 2, "x"]},
+    "want_number": -1.5e+3,
+    "want_object": {"c": true, "d": false, "e": null},
+    "want_zero": 0
+  }
+  )EOF");
+
+  EXPECT_EQ((std::vector<std::string>{"a", "a.want_string", "string:v\"\xc3\xa9\n", "a.b",
+                                      "want_number", "number:-1.5e+3", "want_object",
+                                      "want_object.c", "want_object.d", "want_object.e",
+                                      "want_zero", "number:0"}),
+            callbacks.events_);
+}
+
+TEST(JsonStreamParserTest, Stop) {
+  TestCallbacks callbacks;
+  callbacks.parse(R"EOF({"want": "stop", "ignored": 1} this is not parsed)EOF");
+  EXPECT_TRUE(callbacks.parser_.stopped());
+  EXPECT_EQ((std::vector<std::string>{"want", "string:stop"}), callbacks.events_);
+}
+
+TEST(JsonStreamParserTest, Buffer) {
+  TestCallbacks callbacks;
+  Buffer::OwnedImpl data("{\"want\": 12");
+  callbacks.parser_.parse(data);
+  data.drain(data.length());
+  data.add("3}");
+  callbacks.parser_.parse(data);
+  callbacks.parser_.finish();
+  EXPECT_EQ((std::vector<std::string>{"want", "number:123"}), callbacks.events_);
+}
+
+TEST(JsonStreamParserTest, RootScalars) {
+  for (const std::string document : {"\"a\"", "12", "-0.5", "true", "null", " [] "}) {
+    TestCallbacks callbacks;
+    EXPECT_NO_THROW(callbacks.parse(document)) << document;
+  }
+}
+
+TEST(JsonStreamParserTest, Invalid) {
+  for (const std::string document :
+       {"", " ", "{", "{\"a\"}", "{\"a\" 1}", "{\"a\":1,}", "[1,]", "[1 2]", "{\"a\":1}}",
+        "{\"a\":01}", "{\"a\":1.}", "{\"a\":-}", "{\"a\":1e}", "{\"a\":tru}", "{\"a\":\"\\x\"}",
+        "{\"a\":\"\\u12g4\"}", "{\"a\":\"\n\"}", "{a:1}", "1 2"}) {
+    TestCallbacks callbacks;
+    EXPECT_THROW(callbacks.parse(document), Exception) << document;
+  }
+}
+
+TEST(JsonStreamParserTest, ErrorMessage) {
+  TestCallbacks callbacks;
+  EXPECT_THROW_WITH_MESSAGE(callbacks.parse("{\"a\" 1}"), Exception,
+                            "unexpected character '1' in JSON document");
+}
+
+} // namespace Json
+} // namespace Envoy
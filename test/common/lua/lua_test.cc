@@ -149,5 +149,54 @@ TEST_F(LuaTest, MarkDead) {
   lua_gc(cr1->luaState(), LUA_GCCOLLECT, 0);
 }
 
+// Finished coroutines are pooled and started again, failed ones are not.
+TEST_F(LuaTest, CoroutinePool) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      object:testCall()
+    end
+
+    function fail()
+      error("failed")
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("callMe")));
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("fail")));
+
+  CoroutinePtr cr(state_->createCoroutine());
+  Coroutine* pooled = cr.get();
+  LuaRef<TestObject> ref1(TestObject::create(cr->luaState()), true);
+  EXPECT_CALL(*ref1.get(), doTestCall(_));
+  cr->start(state_->getGlobalRef(0), 1, yield_callback_);
+  EXPECT_TRUE(cr->reusable());
+  state_->releaseCoroutine(std::move(cr));
+
+  cr = state_->createCoroutine();
+  EXPECT_EQ(pooled, cr.get());
+  EXPECT_EQ(cr->state(), Coroutine::State::NotStarted);
+  EXPECT_EQ(0, lua_gettop(cr->luaState()));
+  LuaRef<TestObject> ref2(TestObject::create(cr->luaState()), true);
+  EXPECT_CALL(*ref2.get(), doTestCall(_));
+  cr->start(state_->getGlobalRef(0), 1, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Finished);
+
+  cr->reset();
+  EXPECT_THROW_WITH_MESSAGE(cr->start(state_->getGlobalRef(1), 0, yield_callback_), LuaException,
+                            "[string \"...\"]:7: failed");
+  EXPECT_FALSE(cr->reusable());
+  state_->releaseCoroutine(std::move(cr));
+  EXPECT_NE(pooled, state_->createCoroutine().get());
+
+  EXPECT_CALL(*ref1.get(), onDestroy());
+  ref1.reset();
+  lua_gc(state_->createCoroutine()->luaState(), LUA_GCCOLLECT, 0);
+  EXPECT_CALL(*ref2.get(), onDestroy());
+  ref2.reset();
+  lua_gc(state_->createCoroutine()->luaState(), LUA_GCCOLLECT, 0);
+}
+
 } // namespace Lua
 } // namespace Envoy
@@ -44,5 +44,50 @@ TEST_F(LuaBufferWrapperTest, GetBytesInvalidParams) {
       "[string \"...\"]:3: index/length must be >= 0 and (index + length) must be <= buffer size");
 }
 
+// Search and slice methods, over a buffer made of several slices.
+TEST_F(LuaBufferWrapperTest, SearchAndSlices) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      testPrint(object:find("o w"))
+      testPrint(object:find("o", 5))
+      testPrint(tostring(object:find("nope")))
+      testPrint(tostring(object:startsWith("hello wo")))
+      testPrint(tostring(object:startsWith("world")))
+      testPrint(tostring(object:startsWith("hello world!")))
+      for slice in object:rawSlices() do
+        testPrint(slice)
+      end
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  Buffer::OwnedImpl data("hello");
+  Buffer::OwnedImpl second(" world");
+  data.move(second);
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_CALL(*this, testPrint("4"));
+  EXPECT_CALL(*this, testPrint("7"));
+  EXPECT_CALL(*this, testPrint("nil"));
+  EXPECT_CALL(*this, testPrint("true"));
+  EXPECT_CALL(*this, testPrint("false")).Times(2);
+  EXPECT_CALL(*this, testPrint("hello"));
+  EXPECT_CALL(*this, testPrint(" world"));
+  start("callMe");
+}
+
+// Invalid params for the buffer wrapper find() call.
+TEST_F(LuaBufferWrapperTest, FindInvalidParams) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      object:find("o", -1)
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  Buffer::OwnedImpl data("hello world");
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_THROW_WITH_MESSAGE(start("callMe"), LuaException, "[string \"...\"]:3: index must be >= 0");
+}
+
 } // namespace Lua
 } // namespace Envoy
@@ -4,6 +4,7 @@
 #include "common/mongo/bson_impl.h"
 
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -48,6 +49,71 @@ TEST(BsonImplTest, InvalodDocumentTermination) {
   EXPECT_THROW(DocumentImpl::create(buffer), EnvoyException);
 }
 
+TEST(BsonImplTest, Lazy) {
+  DocumentSharedPtr nested = DocumentImpl::create()->addInt32("a", 1)->addString("b", "c");
+  DocumentSharedPtr doc = DocumentImpl::create()
+                              ->addString("hello", "world")
+                              ->addDocument("nested", nested)
+                              ->addRegex("regex", {"pattern", "options"})
+                              ->addBinary("binary", "\x01\x02")
+                              ->addInt64("int64", 5);
+  Buffer::OwnedImpl buffer;
+  doc->encode(buffer);
+  buffer.add("trailing");
+
+  DocumentSharedPtr lazy = DocumentImpl::createLazy(buffer);
+  EXPECT_EQ("trailing", TestUtility::bufferToString(buffer));
+  EXPECT_EQ(doc->byteSize(), lazy->byteSize());
+
+  // Fields are found without decoding the others.
+  EXPECT_EQ(5, lazy->find("int64")->asInt64());
+  EXPECT_EQ(5, lazy->find("int64", Field::Type::INT64)->asInt64());
+  EXPECT_EQ(nullptr, lazy->find("int64", Field::Type::INT32));
+  EXPECT_TRUE(*nested == lazy->find("nested", Field::Type::DOCUMENT)->asDocument());
+  EXPECT_EQ(nullptr, lazy->find("missing"));
+
+  Buffer::OwnedImpl encoded;
+  lazy->encode(encoded);
+  EXPECT_EQ(static_cast<uint64_t>(doc->byteSize()), encoded.length());
+
+  EXPECT_EQ(doc->toString(), lazy->toString());
+  EXPECT_TRUE(*doc == *lazy);
+  EXPECT_EQ("world", lazy->find("hello")->asString());
+  lazy->addBoolean("boolean", true);
+  EXPECT_EQ(6U, lazy->values().size());
+  EXPECT_EQ(doc->byteSize() + 10, lazy->byteSize());
+}
+
+TEST(BsonImplTest, LazyInvalid) {
+  {
+    Buffer::OwnedImpl buffer;
+    BufferHelper::writeInt32(buffer, 100);
+    EXPECT_THROW(DocumentImpl::createLazy(buffer), EnvoyException);
+  }
+
+  {
+    Buffer::OwnedImpl buffer;
+    BufferHelper::writeInt32(buffer, 5);
+    uint8_t invalid_document_end = 0x1;
+    buffer.add(&invalid_document_end, sizeof(invalid_document_end));
+    EXPECT_THROW(DocumentImpl::createLazy(buffer), EnvoyException);
+  }
+
+  // An invalid field throws when it is accessed.
+  auto createInvalid = []() -> DocumentSharedPtr {
+    Buffer::OwnedImpl buffer;
+    BufferHelper::writeInt32(buffer, 10);
+    uint8_t invalid_element_type = 0x20;
+    buffer.add(&invalid_element_type, sizeof(invalid_element_type));
+    BufferHelper::writeCString(buffer, "foo");
+    uint8_t document_end = 0;
+    buffer.add(&document_end, sizeof(document_end));
+    return DocumentImpl::createLazy(buffer);
+  };
+  EXPECT_THROW(createInvalid()->find("foo"), EnvoyException);
+  EXPECT_THROW(createInvalid()->values(), EnvoyException);
+}
+
 TEST(BufferHelperTest, InvalidSize) {
   Buffer::OwnedImpl buffer;
   EXPECT_THROW(BufferHelper::peakInt32(buffer), EnvoyException);
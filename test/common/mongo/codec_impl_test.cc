@@ -11,8 +11,10 @@
 #include "gtest/gtest.h"
 
 using testing::Eq;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Pointee;
+using testing::_;
 
 namespace Envoy {
 namespace Mongo {
@@ -156,6 +158,37 @@ TEST_F(MongoCodecImplTest, Reply) {
   decoder_.onData(output_);
 }
 
+TEST_F(MongoCodecImplTest, SkipReplyDocuments) {
+  DecoderImpl decoder(callbacks_, false);
+  ReplyMessageImpl reply(2, 2);
+  reply.cursorId(20000);
+  reply.numberReturned(2);
+  reply.documents().push_back(Bson::DocumentImpl::create()->addString("hello", "world"));
+  reply.documents().push_back(Bson::DocumentImpl::create());
+  encoder_.encodeReply(reply);
+  QueryMessageImpl query(3, 3);
+  query.fullCollectionName("test");
+  query.query(Bson::DocumentImpl::create());
+  encoder_.encodeQuery(query);
+
+  // The reply is delivered as soon as its header is buffered.
+  Buffer::OwnedImpl data;
+  data.move(output_, 40);
+  EXPECT_CALL(callbacks_, decodeReply_(_)).WillOnce(Invoke([&](ReplyMessagePtr& message) -> void {
+    EXPECT_EQ(20000, message->cursorId());
+    EXPECT_EQ(2, message->numberReturned());
+    EXPECT_TRUE(message->documents().empty());
+    EXPECT_EQ(reply.documentsByteSize(), message->documentsByteSize());
+  }));
+  decoder.onData(data);
+  EXPECT_EQ(0U, data.length());
+
+  // The documents are drained as they arrive, and the next message is decoded.
+  EXPECT_CALL(callbacks_, decodeQuery_(Pointee(Eq(query))));
+  decoder.onData(output_);
+  EXPECT_EQ(0U, output_.length());
+}
+
 TEST_F(MongoCodecImplTest, GetMoreEqual) {
   {
     GetMoreMessageImpl g1(0, 0);
@@ -0,0 +1,162 @@
+#include <chrono>
+#include <list>
+#include <string>
+
+#include "common/network/caching_dns_resolver_impl.h"
+#include "common/network/utility.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::DoAll;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class CachingDnsResolverImplTest : public testing::Test {
+public:
+  CachingDnsResolverImplTest()
+      : resolver_(new NiceMock<MockDnsResolver>()),
+        ready_timer_(new Event::MockTimer(&dispatcher_)),
+        cache_(dispatcher_, resolver_, std::chrono::milliseconds(10000), stats_, time_source_) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(testing::ReturnPointee(&now_));
+  }
+
+  // Resolve name, appending the first address resolved, or an empty string, to addresses.
+  ActiveDnsQuery* resolve(const std::string& name, std::list<std::string>& addresses) {
+    return cache_.resolve(
+        name, DnsLookupFamily::V4Only,
+        [&addresses](std::list<Address::InstanceConstSharedPtr>&& results) -> void {
+          addresses.push_back(results.empty() ? "" : results.front()->asString());
+        });
+  }
+
+  std::list<Address::InstanceConstSharedPtr> addressList(const std::string& address) {
+    return {Utility::resolveUrl("tcp://" + address)};
+  }
+
+  uint64_t counter(const std::string& name) { return stats_.counter("dns_cache." + name).value(); }
+
+  Event::MockDispatcher dispatcher_;
+  std::shared_ptr<NiceMock<MockDnsResolver>> resolver_;
+  Event::MockTimer* ready_timer_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  MonotonicTime now_;
+  Stats::IsolatedStoreImpl stats_;
+  CachingDnsResolverImpl cache_;
+};
+
+TEST_F(CachingDnsResolverImplTest, CoalesceAndCache) {
+  DnsResolver::ResolveCb resolve_cb;
+  EXPECT_CALL(*resolver_, resolve("foo", DnsLookupFamily::V4Only, _))
+      .WillOnce(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+  std::list<std::string> first;
+  std::list<std::string> second;
+  EXPECT_NE(nullptr, resolve("foo", first));
+  EXPECT_NE(nullptr, resolve("foo", second));
+  EXPECT_EQ(1U, counter("cache_miss"));
+  EXPECT_EQ(1U, counter("query_coalesced"));
+
+  resolve_cb(addressList("10.0.0.1:0"));
+  EXPECT_EQ(std::list<std::string>{"10.0.0.1:0"}, first);
+  EXPECT_EQ(std::list<std::string>{"10.0.0.1:0"}, second);
+
+  // A cached resolution is delivered by the dispatcher.
+  std::list<std::string> cached;
+  EXPECT_CALL(*ready_timer_, enableTimer(std::chrono::milliseconds(0)));
+  EXPECT_NE(nullptr, resolve("foo", cached));
+  EXPECT_TRUE(cached.empty());
+  ready_timer_->callback_();
+  EXPECT_EQ(std::list<std::string>{"10.0.0.1:0"}, cached);
+  EXPECT_EQ(1U, counter("cache_hit"));
+
+  // A cancelled query is not delivered.
+  std::list<std::string> cancelled;
+  EXPECT_CALL(*ready_timer_, enableTimer(_));
+  resolve("foo", cancelled)->cancel();
+  ready_timer_->callback_();
+  EXPECT_TRUE(cancelled.empty());
+}
+
+TEST_F(CachingDnsResolverImplTest, PrefetchAndExpire) {
+  DnsResolver::ResolveCb resolve_cb;
+  EXPECT_CALL(*resolver_, resolve("foo", _, _))
+      .WillRepeatedly(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+  std::list<std::string> addresses;
+  resolve("foo", addresses);
+  resolve_cb(addressList("10.0.0.1:0"));
+
+  // In the last quarter of the TTL the cached resolution is used while it is refreshed.
+  now_ += std::chrono::milliseconds(8000);
+  EXPECT_CALL(*ready_timer_, enableTimer(_));
+  resolve("foo", addresses);
+  EXPECT_EQ(1U, counter("prefetch"));
+  ready_timer_->callback_();
+  resolve_cb(addressList("10.0.0.2:0"));
+  EXPECT_EQ((std::list<std::string>{"10.0.0.1:0", "10.0.0.1:0"}), addresses);
+
+  // The refreshed resolution expires later.
+  now_ += std::chrono::milliseconds(5000);
+  EXPECT_CALL(*ready_timer_, enableTimer(_));
+  resolve("foo", addresses);
+  ready_timer_->callback_();
+  EXPECT_EQ("10.0.0.2:0", addresses.back());
+
+  now_ += std::chrono::milliseconds(10000);
+  resolve("foo", addresses);
+  EXPECT_EQ(2U, counter("cache_miss"));
+  resolve_cb(addressList("10.0.0.3:0"));
+  EXPECT_EQ("10.0.0.3:0", addresses.back());
+}
+
+TEST_F(CachingDnsResolverImplTest, NegativeCaching) {
+  DnsResolver::ResolveCb resolve_cb;
+  EXPECT_CALL(*resolver_, resolve("foo", _, _))
+      .WillRepeatedly(DoAll(SaveArg<2>(&resolve_cb), Return(&resolver_->active_query_)));
+  std::list<std::string> addresses;
+  resolve("foo", addresses);
+  resolve_cb({});
+  EXPECT_EQ(std::list<std::string>{""}, addresses);
+
+  EXPECT_CALL(*ready_timer_, enableTimer(_));
+  resolve("foo", addresses);
+  EXPECT_EQ(1U, counter("cache_hit"));
+
+  // Failures are cached for a shorter time.
+  now_ += CachingDnsResolverImpl::NEGATIVE_TTL;
+  resolve("foo", addresses);
+  EXPECT_EQ(2U, counter("cache_miss"));
+}
+
+TEST_F(CachingDnsResolverImplTest, InlineCompletion) {
+  EXPECT_CALL(*resolver_, resolve("10.0.0.1", _, _))
+      .WillOnce(testing::Invoke([this](const std::string&, DnsLookupFamily,
+                                       DnsResolver::ResolveCb callback) -> ActiveDnsQuery* {
+        callback(addressList("10.0.0.1:0"));
+        return nullptr;
+      }));
+  std::list<std::string> addresses;
+  EXPECT_EQ(nullptr, resolve("10.0.0.1", addresses));
+  EXPECT_EQ(std::list<std::string>{"10.0.0.1:0"}, addresses);
+}
+
+TEST_F(CachingDnsResolverImplTest, CancelPendingOnDestruction) {
+  new Event::MockTimer(&dispatcher_);
+  CachingDnsResolverImpl cache(dispatcher_, resolver_, std::chrono::milliseconds(0), stats_,
+                               time_source_);
+  cache.resolve("foo", DnsLookupFamily::V4Only,
+                [](std::list<Address::InstanceConstSharedPtr>&&) -> void { FAIL(); });
+  EXPECT_CALL(resolver_->active_query_, cancel());
+}
+
+} // namespace Network
+} // namespace Envoy
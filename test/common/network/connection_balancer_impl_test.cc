@@ -0,0 +1,88 @@
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include "common/network/connection_balancer_impl.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class ConnectionBalancerImplTest : public testing::Test {
+public:
+  ConnectionBalancerImplTest() {
+    balancer_->registerHandler(handler1_);
+    balancer_->registerHandler(handler2_);
+  }
+
+  std::shared_ptr<ConnectionBalancerImpl> balancer_{std::make_shared<ConnectionBalancerImpl>()};
+  NiceMock<MockBalancedConnectionHandler> handler1_;
+  NiceMock<MockBalancedConnectionHandler> handler2_;
+  sockaddr_storage remote_addr_{};
+};
+
+TEST_F(ConnectionBalancerImplTest, KeepWhenEven) {
+  ON_CALL(handler1_, numConnections()).WillByDefault(Return(2));
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(2));
+  EXPECT_CALL(handler2_.dispatcher_, post(_)).Times(0);
+  EXPECT_FALSE(balancer_->balance(handler1_, 10, remote_addr_, sizeof(remote_addr_)));
+
+  // A listener which is not registered keeps its sockets.
+  NiceMock<MockBalancedConnectionHandler> handler3;
+  EXPECT_FALSE(balancer_->balance(handler3, 10, remote_addr_, sizeof(remote_addr_)));
+}
+
+// Sockets posted to a worker count towards its load until it takes them over.
+TEST_F(ConnectionBalancerImplTest, HandOverToLeastLoaded) {
+  ON_CALL(handler1_, numConnections()).WillByDefault(Return(3));
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(1));
+
+  Event::PostCb posted1;
+  Event::PostCb posted2;
+  EXPECT_CALL(handler2_.dispatcher_, post(_))
+      .WillOnce(SaveArg<0>(&posted1))
+      .WillOnce(SaveArg<0>(&posted2));
+  EXPECT_TRUE(balancer_->balance(handler1_, 10, remote_addr_, sizeof(remote_addr_)));
+  EXPECT_TRUE(balancer_->balance(handler1_, 11, remote_addr_, sizeof(remote_addr_)));
+  EXPECT_FALSE(balancer_->balance(handler1_, 12, remote_addr_, sizeof(remote_addr_)));
+
+  EXPECT_CALL(handler2_, onBalancedConnection(10, _, sizeof(remote_addr_)));
+  posted1();
+  EXPECT_CALL(handler2_, onBalancedConnection(11, _, sizeof(remote_addr_)));
+  posted2();
+
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(2));
+  EXPECT_CALL(handler2_.dispatcher_, post(_));
+  EXPECT_TRUE(balancer_->balance(handler1_, 13, remote_addr_, sizeof(remote_addr_)));
+}
+
+// A socket which arrives after its listener went away is closed.
+TEST_F(ConnectionBalancerImplTest, CloseAfterUnregister) {
+  ON_CALL(handler1_, numConnections()).WillByDefault(Return(1));
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(0));
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  Event::PostCb posted;
+  EXPECT_CALL(handler2_.dispatcher_, post(_)).WillOnce(SaveArg<0>(&posted));
+  EXPECT_TRUE(balancer_->balance(handler1_, fd, remote_addr_, sizeof(remote_addr_)));
+
+  balancer_->unregisterHandler(handler2_);
+  EXPECT_CALL(handler2_, onBalancedConnection(_, _, _)).Times(0);
+  posted();
+  EXPECT_EQ(-1, fcntl(fd, F_GETFD));
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -13,6 +13,7 @@
 #include "common/stats/stats_impl.h"
 
 #include "test/mocks/buffer/mocks.h"
+#include "test/mocks/common.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/server/mocks.h"
 #include "test/mocks/stats/mocks.h"
@@ -62,6 +63,34 @@ TEST(ConnectionImplUtility, updateBufferStats) {
   ConnectionImplUtility::updateBufferStats(3, 3, previous_total, counter, gauge);
 }
 
+TEST(AdaptiveReadSize, GrowAndShrink) {
+  AdaptiveReadSize read_size;
+  EXPECT_EQ(AdaptiveReadSize::INITIAL_SIZE, read_size.size());
+
+  // Reads which fill the size grow it up to the maximum.
+  read_size.onRead(AdaptiveReadSize::INITIAL_SIZE - 1);
+  EXPECT_EQ(AdaptiveReadSize::INITIAL_SIZE, read_size.size());
+  while (read_size.size() < AdaptiveReadSize::MAX_SIZE) {
+    const uint64_t size = read_size.size();
+    read_size.onRead(size);
+    EXPECT_EQ(size * 2, read_size.size());
+  }
+  read_size.onRead(AdaptiveReadSize::MAX_SIZE);
+  EXPECT_EQ(AdaptiveReadSize::MAX_SIZE, read_size.size());
+
+  // Read events which return a quarter of the size or more keep it.
+  read_size.onReadEventDone(AdaptiveReadSize::MAX_SIZE / 4);
+  EXPECT_EQ(AdaptiveReadSize::MAX_SIZE, read_size.size());
+
+  // Smaller read events shrink it down to the minimum.
+  read_size.onReadEventDone(100);
+  EXPECT_EQ(AdaptiveReadSize::MAX_SIZE / 2, read_size.size());
+  for (uint32_t i = 0; i < 10; i++) {
+    read_size.onReadEventDone(0);
+  }
+  EXPECT_EQ(AdaptiveReadSize::MIN_SIZE, read_size.size());
+}
+
 class ConnectionImplDeathTest : public testing::TestWithParam<Address::IpVersion> {};
 INSTANTIATE_TEST_CASE_P(IpVersions, ConnectionImplDeathTest,
                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
@@ -266,6 +295,49 @@ TEST_P(ConnectionImplTest, ConnectionStats) {
   dispatcher_->run(Event::Dispatcher::RunType::Block);
 }
 
+// The worker stats count the bytes of a connection whether or not its filters set connection stats.
+TEST_P(ConnectionImplTest, WorkerStats) {
+  setUpBasicConnection();
+
+  StrictMock<Stats::MockCounter> client_rx_total;
+  StrictMock<Stats::MockCounter> client_tx_total;
+  StrictMock<Stats::MockGauge> rq_active;
+  EXPECT_EQ(nullptr, client_connection_->workerStats());
+  client_connection_->setWorkerStats({client_rx_total, client_tx_total, rq_active});
+  EXPECT_EQ(&rq_active, &client_connection_->workerStats()->rq_active_);
+  client_connection_->connect();
+
+  EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::Connected));
+  EXPECT_CALL(client_tx_total, add(4));
+
+  read_filter_.reset(new NiceMock<MockReadFilter>());
+  StrictMock<Stats::MockCounter> server_rx_total;
+  StrictMock<Stats::MockCounter> server_tx_total;
+  EXPECT_CALL(listener_callbacks_, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        server_connection_ = std::move(conn);
+        server_connection_->addConnectionCallbacks(server_callbacks_);
+        server_connection_->setWorkerStats({server_rx_total, server_tx_total, rq_active});
+        server_connection_->addReadFilter(read_filter_);
+      }));
+
+  EXPECT_CALL(server_rx_total, add(4));
+  EXPECT_CALL(server_callbacks_, onEvent(ConnectionEvent::LocalClose));
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        data.drain(data.length());
+        server_connection_->close(ConnectionCloseType::FlushWrite);
+        return FilterStatus::StopIteration;
+      }));
+
+  EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::RemoteClose))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { dispatcher_->exit(); }));
+
+  Buffer::OwnedImpl data("1234");
+  client_connection_->write(data);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+}
+
 // Ensure the new counter logic in ReadDisable avoids tripping asserts in ReadDisable guarding
 // against actual enabling twice in a row.
 TEST_P(ConnectionImplTest, ReadDisable) {
@@ -376,6 +448,120 @@ TEST_P(ConnectionImplTest, Watermarks) {
   disconnect(false);
 }
 
+TEST_P(ConnectionImplTest, IdleMemoryRelease) {
+  setUpBasicConnection();
+  connect();
+
+  // An idle connection runs the memory release callbacks once per quiet period.
+  ReadyWatcher released;
+  server_connection_->addMemoryReleaseCallback([&]() -> void { released.ready(); });
+  server_connection_->enableIdleMemoryRelease(std::chrono::milliseconds(1));
+  EXPECT_CALL(released, ready()).WillOnce(Invoke([&]() -> void { dispatcher_->exit(); }));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  disconnect(true);
+}
+
+// A remote close which arrives along with the last of the data is seen after the data is read.
+TEST_P(ConnectionImplTest, ReadDataThenRemoteClose) {
+  setUpBasicConnection();
+  connect();
+
+  std::string data_read;
+  ON_CALL(*read_filter_, onData(_))
+      .WillByDefault(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        data_read.append(TestUtility::bufferToString(data));
+        data.drain(data.length());
+        return FilterStatus::StopIteration;
+      }));
+  EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::LocalClose));
+  EXPECT_CALL(server_callbacks_, onEvent(ConnectionEvent::RemoteClose))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { dispatcher_->exit(); }));
+
+  Buffer::OwnedImpl data("hello world");
+  client_connection_->write(data);
+  client_connection_->close(ConnectionCloseType::FlushWrite);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ("hello world", data_read);
+}
+
+#ifdef __linux__
+// Data read on spliced connections goes straight to the peer's socket, in both directions, without
+// going through the read filters. splice() is only available on Linux.
+TEST_P(ConnectionImplTest, Splice) {
+  setUpBasicConnection();
+  connect();
+
+  // A second connection to the listener stands in for the upstream connection which the server
+  // connection splices with.
+  ClientConnectionPtr upstream_connection =
+      dispatcher_->createClientConnection(socket_.localAddress(), source_address_);
+  StrictMock<MockConnectionCallbacks> upstream_callbacks;
+  upstream_connection->addConnectionCallbacks(upstream_callbacks);
+  upstream_connection->connect();
+  ConnectionPtr upstream_server_connection;
+  std::shared_ptr<MockReadFilter> upstream_server_read_filter(new NiceMock<MockReadFilter>());
+  int expected_callbacks = 2;
+  EXPECT_CALL(listener_callbacks_, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        upstream_server_connection = std::move(conn);
+        upstream_server_connection->addReadFilter(upstream_server_read_filter);
+        if (--expected_callbacks == 0) {
+          dispatcher_->exit();
+        }
+      }));
+  EXPECT_CALL(upstream_callbacks, onEvent(ConnectionEvent::Connected))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
+        if (--expected_callbacks == 0) {
+          dispatcher_->exit();
+        }
+      }));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  ASSERT_TRUE(server_connection_->spliceWith(*upstream_connection));
+  // A connection is only spliced with one peer at a time.
+  EXPECT_FALSE(upstream_connection->spliceWith(*client_connection_));
+  EXPECT_CALL(*read_filter_, onData(_)).Times(0);
+
+  std::string upstream_data;
+  ON_CALL(*upstream_server_read_filter, onData(_))
+      .WillByDefault(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        upstream_data.append(TestUtility::bufferToString(data));
+        data.drain(data.length());
+        if (upstream_data == "hello") {
+          dispatcher_->exit();
+        }
+        return FilterStatus::StopIteration;
+      }));
+  Buffer::OwnedImpl request("hello");
+  client_connection_->write(request);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ("hello", upstream_data);
+
+  std::string downstream_data;
+  std::shared_ptr<MockReadFilter> client_read_filter(new NiceMock<MockReadFilter>());
+  client_connection_->addReadFilter(client_read_filter);
+  ON_CALL(*client_read_filter, onData(_))
+      .WillByDefault(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        downstream_data.append(TestUtility::bufferToString(data));
+        data.drain(data.length());
+        if (downstream_data == "world") {
+          dispatcher_->exit();
+        }
+        return FilterStatus::StopIteration;
+      }));
+  Buffer::OwnedImpl response("world");
+  upstream_server_connection->write(response);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ("world", downstream_data);
+
+  EXPECT_CALL(upstream_callbacks, onEvent(ConnectionEvent::LocalClose));
+  upstream_connection->close(ConnectionCloseType::NoFlush);
+  upstream_server_connection->close(ConnectionCloseType::NoFlush);
+  disconnect(true);
+}
+#endif
+
 // Write some data to the connection.  It will automatically attempt to flush
 // it to the upstream file descriptor via a write() call to buffer_, which is
 // configured to succeed and accept all bytes read.
@@ -1,4 +1,5 @@
 #include "common/network/address_impl.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/listener_impl.h"
 #include "common/network/utility.h"
 #include "common/stats/stats_impl.h"
@@ -327,5 +328,40 @@ TEST_P(ListenerImplTest, WildcardListenerUseActualDst) {
   dispatcher.run(Event::Dispatcher::RunType::Block);
 }
 
+// Whichever of two listeners on one socket accepts the connection, the less loaded one owns it.
+TEST_P(ListenerImplTest, BalanceConnections) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::MockConnectionHandler connection_handler1;
+  Network::MockConnectionHandler connection_handler2;
+  ON_CALL(connection_handler1, numConnections()).WillByDefault(Return(1));
+  ON_CALL(connection_handler2, numConnections()).WillByDefault(Return(0));
+  Network::ListenerOptions listener_options =
+      Network::ListenerOptions::listenerOptionsWithBindToPort();
+  listener_options.connection_balancer_ = std::make_shared<ConnectionBalancerImpl>();
+  Network::MockListenerCallbacks listener_callbacks1;
+  Network::MockListenerCallbacks listener_callbacks2;
+  Network::ListenerImpl listener1(connection_handler1, dispatcher, socket, listener_callbacks1,
+                                  stats_store, listener_options);
+  Network::ListenerImpl listener2(connection_handler2, dispatcher, socket, listener_callbacks2,
+                                  stats_store, listener_options);
+
+  Network::ClientConnectionPtr client_connection = dispatcher.createClientConnection(
+      socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+  client_connection->connect();
+
+  EXPECT_CALL(listener_callbacks1, onNewConnection_(_)).Times(0);
+  EXPECT_CALL(listener_callbacks2, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        EXPECT_EQ(*socket.localAddress(), conn->localAddress());
+        client_connection->close(ConnectionCloseType::NoFlush);
+        conn->close(ConnectionCloseType::NoFlush);
+        dispatcher.exit();
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+}
+
 } // namespace Network
 } // namespace Envoy
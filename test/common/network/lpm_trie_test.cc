@@ -0,0 +1,137 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/network/address_impl.h"
+#include "common/network/cidr_range.h"
+#include "common/network/lpm_trie.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+namespace Address {
+
+class LpmTrieTest : public testing::Test {
+public:
+  void setup(const std::vector<std::pair<std::string, std::vector<std::string>>>& tags) {
+    std::vector<std::pair<std::string, std::vector<CidrRange>>> tagged_ranges;
+    for (const auto& tag : tags) {
+      tagged_ranges.emplace_back(tag.first, std::vector<CidrRange>());
+      for (const std::string& range : tag.second) {
+        tagged_ranges.back().second.push_back(CidrRange::create(range));
+      }
+    }
+    trie_ = LpmTrie(tagged_ranges);
+  }
+
+  std::vector<std::string> ipv4Tags(const std::string& address) {
+    return trie_.getTags(Ipv4Instance(address));
+  }
+
+  std::vector<std::string> ipv6Tags(const std::string& address) {
+    return trie_.getTags(Ipv6Instance(address));
+  }
+
+  typedef std::vector<std::string> Tags;
+
+  LpmTrie trie_;
+};
+
+TEST_F(LpmTrieTest, Empty) {
+  EXPECT_EQ(Tags(), ipv4Tags("1.2.3.4"));
+  EXPECT_EQ(Tags(), ipv6Tags("::1"));
+  EXPECT_FALSE(trie_.contains(Ipv4Instance("0.0.0.0")));
+  EXPECT_FALSE(trie_.contains(PipeInstance("/foo")));
+
+  setup({});
+  EXPECT_FALSE(trie_.contains(Ipv4Instance("1.2.3.4")));
+}
+
+TEST_F(LpmTrieTest, Ipv4) {
+  setup({{"internal", {"10.0.0.0/8", "192.168.0.0/16"}},
+         {"office", {"10.1.0.0/16", "10.1.2.3/32"}},
+         {"host", {"10.1.2.3/32"}},
+         {"odd", {"10.1.2.0/27"}}});
+
+  EXPECT_EQ(Tags({"internal"}), ipv4Tags("10.0.0.1"));
+  EXPECT_EQ(Tags({"internal"}), ipv4Tags("10.255.255.255"));
+  EXPECT_EQ(Tags({"internal"}), ipv4Tags("192.168.7.1"));
+  EXPECT_EQ(Tags({"internal", "office"}), ipv4Tags("10.1.200.1"));
+  EXPECT_EQ(Tags({"internal", "office", "odd"}), ipv4Tags("10.1.2.31"));
+  EXPECT_EQ(Tags({"internal", "office"}), ipv4Tags("10.1.2.32"));
+  EXPECT_EQ(Tags({"internal", "office", "host", "odd"}), ipv4Tags("10.1.2.3"));
+  EXPECT_EQ(Tags(), ipv4Tags("11.0.0.0"));
+  EXPECT_EQ(Tags(), ipv4Tags("9.255.255.255"));
+
+  // IPv4 ranges do not contain IPv6 addresses.
+  EXPECT_EQ(Tags(), ipv6Tags("::ffff:10.0.0.1"));
+  EXPECT_EQ(Tags(), ipv6Tags("a00::"));
+}
+
+TEST_F(LpmTrieTest, TagIndexes) {
+  setup({{"a", {"10.0.0.0/8"}}, {"b", {}}, {"c", {"10.1.0.0/16"}}, {"a", {"10.1.2.0/24"}}});
+
+  typedef std::vector<uint32_t> Indexes;
+  EXPECT_EQ(Indexes({0}), trie_.getTagIndexes(Ipv4Instance("10.0.0.1")));
+  EXPECT_EQ(Indexes({0, 2}), trie_.getTagIndexes(Ipv4Instance("10.1.0.1")));
+  EXPECT_EQ(Indexes({0, 2, 3}), trie_.getTagIndexes(Ipv4Instance("10.1.2.1")));
+  EXPECT_EQ(Indexes(), trie_.getTagIndexes(Ipv4Instance("11.0.0.1")));
+  EXPECT_EQ(Indexes(), trie_.getTagIndexes(PipeInstance("/foo")));
+}
+
+TEST_F(LpmTrieTest, Ipv6) {
+  setup({{"all", {"::/0"}},
+         {"doc", {"2001:db8::/32"}},
+         {"host", {"2001:db8::1/128", "2001:db8:0:0:ffff::/80"}},
+         {"v4", {"0.0.0.0/0"}}});
+
+  EXPECT_EQ(Tags({"all"}), ipv6Tags("::1"));
+  EXPECT_EQ(Tags({"all", "doc"}), ipv6Tags("2001:db8::2"));
+  EXPECT_EQ(Tags({"all", "doc", "host"}), ipv6Tags("2001:db8::1"));
+  EXPECT_EQ(Tags({"all", "doc", "host"}), ipv6Tags("2001:db8::ffff:1:2:3"));
+  EXPECT_EQ(Tags({"all", "doc"}), ipv6Tags("2001:db8::fffe:1:2:3"));
+  EXPECT_EQ(Tags({"all"}), ipv6Tags("2001:db9::1"));
+  EXPECT_EQ(Tags({"v4"}), ipv4Tags("1.2.3.4"));
+}
+
+// Check the trie against a linear scan of the ranges, with many nested ranges of all lengths.
+TEST_F(LpmTrieTest, MatchesCidrRanges) {
+  std::vector<std::pair<std::string, std::vector<CidrRange>>> tagged_ranges;
+  for (int length = 0; length <= 32; length += 3) {
+    tagged_ranges.push_back({std::to_string(length),
+                             {CidrRange::create("10.20.30.40", length),
+                              CidrRange::create("10.20.128.0", length)}});
+  }
+  for (int length = 0; length <= 128; length += 5) {
+    tagged_ranges.push_back(
+        {std::to_string(length), {CidrRange::create("2001:db8:1:2:3:4:5:6", length)}});
+  }
+  trie_ = LpmTrie(tagged_ranges);
+
+  const std::vector<std::string> addresses{
+      "10.20.30.40",          "10.20.30.41",         "10.20.31.40", "10.20.128.1",
+      "10.21.0.0",            "11.20.30.40",         "0.0.0.0",     "255.255.255.255",
+      "2001:db8:1:2:3:4:5:6", "2001:db8:1:2:3:4:5:7", "2001:db8::", "2001:db8:1:2:3:4:ffff:6",
+      "::",                   "ffff::"};
+  for (const std::string& address : addresses) {
+    InstanceConstSharedPtr instance = address.find(':') == std::string::npos
+                                          ? InstanceConstSharedPtr{new Ipv4Instance(address)}
+                                          : InstanceConstSharedPtr{new Ipv6Instance(address)};
+    Tags expected;
+    for (const auto& tag : tagged_ranges) {
+      for (const CidrRange& range : tag.second) {
+        if (range.isInRange(*instance)) {
+          expected.push_back(tag.first);
+          break;
+        }
+      }
+    }
+    EXPECT_EQ(expected, trie_.getTags(*instance)) << address;
+    EXPECT_EQ(!expected.empty(), trie_.contains(*instance)) << address;
+  }
+}
+
+} // namespace Address
+} // namespace Network
+} // namespace Envoy
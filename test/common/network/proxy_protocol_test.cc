@@ -282,6 +282,162 @@ TEST_P(ProxyProtocolTest, ClosedEmpty) {
   dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
 }
 
+// The signature and the fixed part of version 2 headers.
+static const char v2_signature[] = "\x0d\x0a\x0d\x0a\x00\x0d\x0a\x51\x55\x49\x54\x0a";
+
+std::string v2Header(char version_command, char family_protocol, const std::string& rest) {
+  std::string header(v2_signature, 12);
+  header.push_back(version_command);
+  header.push_back(family_protocol);
+  header.push_back(static_cast<char>(rest.size() >> 8));
+  header.push_back(static_cast<char>(rest.size() & 0xff));
+  return header + rest;
+}
+
+// 1.2.3.4:65535 to 254.254.254.254:1234.
+static const std::string v2_tcp4_addresses("\x01\x02\x03\x04\xfe\xfe\xfe\xfe\xff\xff\x04\xd2", 12);
+
+TEST_P(ProxyProtocolTest, V2Basic) {
+  connect();
+  write(v2Header('\x21', '\x11', v2_tcp4_addresses) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1.2.3.4");
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->port(), 65535U);
+        EXPECT_EQ(server_connection_->localAddress().ip()->addressAsString(), "254.254.254.254");
+        EXPECT_TRUE(server_connection_->usingOriginalDst());
+
+        EXPECT_EQ(TestUtility::bufferToString(buffer), "more data");
+        buffer.drain(9);
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2BasicV6) {
+  connect();
+  // [1:2:3::4]:65535 to [5:6::7:8]:1234.
+  const std::string addresses("\x00\x01\x00\x02\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x04"
+                              "\x00\x05\x00\x06\x00\x00\x00\x00\x00\x00\x00\x00\x00\x07\x00\x08"
+                              "\xff\xff\x04\xd2",
+                              36);
+  write(v2Header('\x21', '\x21', addresses) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1:2:3::4");
+        EXPECT_EQ(server_connection_->localAddress().ip()->addressAsString(), "5:6::7:8");
+
+        EXPECT_EQ(TestUtility::bufferToString(buffer), "more data");
+        buffer.drain(9);
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+}
+
+// The TLVs, such as the VPC endpoint ID of an AWS NLB, are skipped.
+TEST_P(ProxyProtocolTest, V2Tlvs) {
+  connect();
+  const std::string tlvs("\xea\x00\x09\x01vpce-123\x04\x00\x02\x00\x00", 17);
+  write(v2Header('\x21', '\x11', v2_tcp4_addresses + tlvs) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1.2.3.4");
+
+        EXPECT_EQ(TestUtility::bufferToString(buffer), "more data");
+        buffer.drain(9);
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+}
+
+// A LOCAL header leaves the connection its own addresses.
+TEST_P(ProxyProtocolTest, V2Local) {
+  connect();
+  write(v2Header('\x20', '\x11', v2_tcp4_addresses) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(),
+                  Network::Test::getLoopbackAddressString(GetParam()));
+        EXPECT_FALSE(server_connection_->usingOriginalDst());
+
+        EXPECT_EQ(TestUtility::bufferToString(buffer), "more data");
+        buffer.drain(9);
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2Fragmented) {
+  connect();
+  const std::string header = v2Header('\x21', '\x11', v2_tcp4_addresses + "\x04\x00\x01\x00");
+  for (size_t i = 0; i < header.size(); i += 5) {
+    write(header.substr(i, 5));
+    dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  }
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_));
+  write("more data");
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  EXPECT_EQ(server_connection_->remoteAddress().ip()->addressAsString(), "1.2.3.4");
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2BadSignature) {
+  connectNoRead();
+  std::string header = v2Header('\x21', '\x11', v2_tcp4_addresses);
+  header[7] = 'X';
+  write(header);
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2BadVersion) {
+  connectNoRead();
+  write(v2Header('\x11', '\x11', v2_tcp4_addresses));
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2UnsupportedProto) {
+  connectNoRead();
+  write(v2Header('\x21', '\x12', v2_tcp4_addresses));
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2AddressesTruncated) {
+  connectNoRead();
+  write(v2Header('\x21', '\x21', v2_tcp4_addresses));
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2InvalidSrcAddress) {
+  connectNoRead();
+  // 230.0.0.1, a multicast address.
+  const std::string addresses("\xe6\x00\x00\x01\x0a\x01\x01\x03\x04\xd2\x16\x2e", 12);
+  write(v2Header('\x21', '\x11', addresses));
+  expectProxyProtoError();
+}
+
 class WildcardProxyProtocolTest : public testing::TestWithParam<Address::IpVersion> {
 public:
   WildcardProxyProtocolTest()
@@ -154,6 +154,23 @@ TEST(NetworkUtility, InternalAddress) {
   EXPECT_FALSE(Utility::isInternalAddress("fd00:::"));
 }
 
+TEST(NetworkUtility, InternalAddressInstance) {
+  for (const std::string address :
+       {"127.0.0.1", "127.0.0.2", "10.0.0.1", "10.255.255.255", "11.0.0.1", "172.15.255.255",
+        "172.16.0.0", "172.31.255.255", "172.32.0.0", "192.167.0.0", "192.168.0.0",
+        "192.168.255.255", "192.169.0.0"}) {
+    EXPECT_EQ(Utility::isInternalAddress(address.c_str()),
+              Utility::isInternalAddress(Address::Ipv4Instance(address)))
+        << address;
+  }
+  for (const std::string address : {"::", "::1", "::2", "fc00::", "fd00::", "fdff::", "fe00::"}) {
+    EXPECT_EQ(Utility::isInternalAddress(address.c_str()),
+              Utility::isInternalAddress(Address::Ipv6Instance(address)))
+        << address;
+  }
+  EXPECT_FALSE(Utility::isInternalAddress(Address::PipeInstance("/foo")));
+}
+
 TEST(NetworkUtility, LoopbackAddress) {
   {
     Address::Ipv4Instance address("127.0.0.1");
@@ -11,6 +11,27 @@
 
 namespace Envoy {
 
+// The streamed hash matches the hash of the whole serialized message, also for messages larger
+// than the hashing buffer.
+TEST(UtilityTest, HashSerializedMessage) {
+  envoy::api::v2::Bootstrap bootstrap;
+  EXPECT_EQ(HashUtil::xxHash64(""), MessageUtil::hash(bootstrap));
+
+  for (uint32_t i = 0; i < 200; i++) {
+    auto* cluster = bootstrap.mutable_static_resources()->add_clusters();
+    cluster->set_name("cluster_" + std::to_string(i));
+  }
+  ProtobufTypes::String text;
+  {
+    Protobuf::io::StringOutputStream string_stream(&text);
+    Protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    bootstrap.SerializeToCodedStream(&coded_stream);
+  }
+  EXPECT_GT(text.size(), 1024U);
+  EXPECT_EQ(HashUtil::xxHash64(text), MessageUtil::hash(bootstrap));
+}
+
 TEST(UtilityTest, LoadBinaryProtoFromFile) {
   envoy::api::v2::Bootstrap bootstrap;
   bootstrap.mutable_cluster_manager()
@@ -53,6 +74,22 @@ TEST(UtilityTest, LoadTextProtoFromFile_Failure) {
                                 "\" as a text protobuf (type envoy.api.v2.Bootstrap)");
 }
 
+TEST(UtilityTest, UnpackTo) {
+  envoy::api::v2::Bootstrap bootstrap;
+  bootstrap.mutable_static_resources()->add_clusters()->set_name("cluster_0");
+  ProtobufWkt::Any any;
+  any.PackFrom(bootstrap);
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::Bootstrap> unpacked;
+  MessageUtil::unpackTo(any, *unpacked.Add());
+  EXPECT_TRUE(TestUtility::protoEqual(bootstrap, unpacked[0]));
+  EXPECT_TRUE(TestUtility::protoEqual(bootstrap,
+                                      MessageUtil::anyConvert<envoy::api::v2::Bootstrap>(any)));
+
+  any.PackFrom(ProtobufWkt::Empty());
+  EXPECT_THROW(MessageUtil::unpackTo(any, unpacked[0]), EnvoyException);
+}
+
 TEST(UtilityTest, ValueUtilEqual_NullValues) {
   ProtobufWkt::Value v1, v2;
   v1.set_null_value(ProtobufWkt::NULL_VALUE);
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/json/json_loader.h"
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/ratelimit/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/tracing/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnPointee;
+using testing::WithArg;
+using testing::_;
+
+namespace Envoy {
+namespace RateLimit {
+
+TEST(TokenBucketTest, ConsumeAndRefill) {
+  MonotonicTime now;
+  TokenBucket bucket(3, 2, std::chrono::milliseconds(100), now);
+
+  EXPECT_TRUE(bucket.consume(now));
+  EXPECT_TRUE(bucket.consume(now));
+  EXPECT_TRUE(bucket.consume(now));
+  EXPECT_FALSE(bucket.consume(now));
+
+  // Not a whole fill interval yet.
+  now += std::chrono::milliseconds(99);
+  EXPECT_FALSE(bucket.consume(now));
+
+  now += std::chrono::milliseconds(1);
+  EXPECT_TRUE(bucket.consume(now));
+  EXPECT_TRUE(bucket.consume(now));
+  EXPECT_FALSE(bucket.consume(now));
+
+  // A long idle period fills the bucket up to its size only.
+  now += std::chrono::hours(24 * 365);
+  EXPECT_TRUE(bucket.consume(now));
+  EXPECT_EQ(2U, bucket.tokens());
+
+  bucket.drain();
+  EXPECT_FALSE(bucket.consume(now));
+}
+
+TEST(LocalRateLimitRuleTest, Matches) {
+  LocalRateLimitRule rule{{{"remote_address", ""}, {"path", "/foo"}}, 1, 1,
+                          std::chrono::milliseconds(1)};
+
+  EXPECT_TRUE(rule.matches({{{"remote_address", "10.0.0.1"}, {"path", "/foo"}}}));
+  EXPECT_FALSE(rule.matches({{{"remote_address", "10.0.0.1"}, {"path", "/bar"}}}));
+  EXPECT_FALSE(rule.matches({{{"remote_address", "10.0.0.1"}}}));
+  EXPECT_FALSE(rule.matches({{{"path", "/foo"}, {"remote_address", "10.0.0.1"}}}));
+}
+
+class TestRequestCallbacks : public RequestCallbacks {
+public:
+  MOCK_METHOD1(complete, void(LimitStatus status));
+};
+
+class LocalRateLimitTest : public testing::Test {
+public:
+  LocalRateLimitTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+  }
+
+  ~LocalRateLimitTest() {
+    client_.reset();
+    config_.reset();
+    if (!remote_client_created_) {
+      delete remote_client_;
+    }
+  }
+
+  void setup(bool global_sync) {
+    std::string json = R"EOF(
+    {
+      "rules": [
+        {
+          "descriptor": [{"key": "to_cluster", "value": "foo"}],
+          "max_tokens": 2,
+          "fill_interval_ms": 1000
+        },
+        {
+          "descriptor": [{"key": "remote_address"}],
+          "max_tokens": 1,
+          "tokens_per_fill": 1,
+          "fill_interval_ms": 100
+        }
+      ],
+      "global_sync": )EOF" +
+                       std::string(global_sync ? "true" : "false") + "}";
+
+    Json::ObjectSharedPtr loader = Json::Factory::loadFromString(json);
+    config_.reset(new LocalRateLimitConfig(*loader, tls_, time_source_, [this]() -> ClientPtr {
+      EXPECT_FALSE(remote_client_created_);
+      remote_client_created_ = true;
+      return ClientPtr{remote_client_};
+    }));
+    client_.reset(new LocalClientImpl(config_));
+  }
+
+  void expectLimit(LimitStatus status, const std::vector<Descriptor>& descriptors) {
+    EXPECT_CALL(callbacks_, complete(status));
+    client_->limit(callbacks_, "domain", descriptors, span_);
+  }
+
+  const std::vector<Descriptor> cluster_{{{{"to_cluster", "foo"}}}};
+  const std::vector<Descriptor> address_{{{{"remote_address", "10.0.0.1"}}}};
+  const std::vector<Descriptor> unmatched_{{{{"to_cluster", "bar"}}}};
+
+  MonotonicTime now_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  LocalRateLimitConfigSharedPtr config_;
+  ClientPtr client_;
+  MockClient* remote_client_{new MockClient()};
+  bool remote_client_created_{};
+  TestRequestCallbacks callbacks_;
+  NiceMock<Tracing::MockSpan> span_;
+};
+
+TEST_F(LocalRateLimitTest, BadConfig) {
+  std::string json = R"EOF(
+  {
+    "rules": [{"descriptor": [{"key": "to_cluster"}], "max_tokens": 0, "fill_interval_ms": 1}]
+  }
+  )EOF";
+  Json::ObjectSharedPtr loader = Json::Factory::loadFromString(json);
+  EXPECT_THROW(LocalRateLimitConfig(*loader, tls_, time_source_, nullptr), Json::Exception);
+}
+
+TEST_F(LocalRateLimitTest, Local) {
+  setup(false);
+  EXPECT_EQ(2U, config_->rules().size());
+  EXPECT_FALSE(config_->globalSync());
+
+  const std::vector<Descriptor> both{{{{"to_cluster", "foo"}}}, {{{"remote_address", "10.0.0.2"}}}};
+
+  expectLimit(LimitStatus::OK, cluster_);
+  expectLimit(LimitStatus::OK, address_);
+  expectLimit(LimitStatus::OverLimit, both);
+  expectLimit(LimitStatus::OverLimit, cluster_);
+  expectLimit(LimitStatus::OK, unmatched_);
+
+  now_ += std::chrono::milliseconds(100);
+  expectLimit(LimitStatus::OK, address_);
+  expectLimit(LimitStatus::OverLimit, cluster_);
+
+  now_ += std::chrono::milliseconds(900);
+  expectLimit(LimitStatus::OK, cluster_);
+
+  // Cancelling a local request does nothing.
+  client_->cancel();
+  EXPECT_FALSE(remote_client_created_);
+}
+
+TEST_F(LocalRateLimitTest, GlobalSync) {
+  setup(true);
+  EXPECT_TRUE(config_->globalSync());
+
+  // Requests which no rule applies to are not reported.
+  expectLimit(LimitStatus::OK, unmatched_);
+  EXPECT_FALSE(remote_client_created_);
+
+  // A request which is let through is reported, and is not waited for.
+  RequestCallbacks* remote_callbacks{};
+  EXPECT_CALL(*remote_client_, limit(_, "domain", cluster_, _))
+      .WillOnce(WithArg<0>(
+          Invoke([&](RequestCallbacks& callbacks) -> void { remote_callbacks = &callbacks; })));
+  expectLimit(LimitStatus::OK, cluster_);
+  EXPECT_TRUE(remote_client_created_);
+
+  // Only one report is in flight at a time, and an over limit answer drains the bucket.
+  expectLimit(LimitStatus::OK, cluster_);
+  remote_callbacks->complete(LimitStatus::OverLimit);
+  now_ += std::chrono::milliseconds(999);
+  expectLimit(LimitStatus::OverLimit, cluster_);
+
+  // The bucket is refilled on the next fill, and the sync starts again. An inline answer is fine.
+  now_ += std::chrono::milliseconds(1);
+  EXPECT_CALL(*remote_client_, limit(_, "domain", cluster_, _))
+      .WillOnce(Invoke([](RequestCallbacks& callbacks, const std::string&,
+                          const std::vector<Descriptor>&,
+                          Tracing::Span&) -> void { callbacks.complete(LimitStatus::OK); }));
+  expectLimit(LimitStatus::OK, cluster_);
+
+  // A report in flight is cancelled when the limiter of the worker goes away.
+  EXPECT_CALL(*remote_client_, limit(_, "domain", cluster_, _));
+  expectLimit(LimitStatus::OK, cluster_);
+  EXPECT_CALL(*remote_client_, cancel());
+  client_.reset();
+  config_.reset();
+}
+
+} // namespace RateLimit
+} // namespace Envoy
@@ -5,8 +5,14 @@
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 #include "common/ratelimit/ratelimit_impl.h"
+#include "common/stats/stats_impl.h"
 
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/grpc/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -16,8 +22,10 @@
 
 using testing::AtLeast;
 using testing::Invoke;
+using testing::NiceMock;
 using testing::Ref;
 using testing::Return;
+using testing::ReturnPointee;
 using testing::WithArg;
 using testing::_;
 
@@ -123,23 +131,358 @@ TEST_F(RateLimitGrpcClientTest, Cancel) {
   client_.cancel();
 }
 
+class RateLimitBatchedGrpcClientTest : public testing::Test {
+public:
+  typedef pb::lyft::ratelimit::RateLimitResponse_Code Code;
+
+  RateLimitBatchedGrpcClientTest()
+      : async_client_(new Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                                                pb::lyft::ratelimit::RateLimitResponse>()),
+        flush_timer_(new Event::MockTimer(&dispatcher_)),
+        batcher_(std::make_shared<GrpcBatcher>(RateLimitAsyncClientPtr{async_client_}, dispatcher_,
+                                               runtime_)),
+        client1_(batcher_, timeout_), client2_(batcher_, timeout_), client3_(batcher_, timeout_) {}
+
+  // Expect a batch to be sent, and save its callbacks.
+  void expectSend(testing::Matcher<const pb::lyft::ratelimit::RateLimitRequest&> request,
+                  Tracing::Span& parent_span) {
+    EXPECT_CALL(*async_client_, send(_, request, _, Ref(parent_span), timeout_))
+        .WillOnce(Invoke([this](const Protobuf::MethodDescriptor&,
+                                const pb::lyft::ratelimit::RateLimitRequest&,
+                                RateLimitAsyncCallbacks& callbacks, Tracing::Span&,
+                                const Optional<std::chrono::milliseconds>&) -> Grpc::AsyncRequest* {
+          batch_callbacks_ = &callbacks;
+          return &async_request_;
+        }));
+  }
+
+  std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse>
+  response(Code overall_code, const std::vector<Code>& codes) {
+    std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse> response(
+        new pb::lyft::ratelimit::RateLimitResponse());
+    response->set_overall_code(overall_code);
+    for (Code code : codes) {
+      response->add_statuses()->set_code(code);
+    }
+    return response;
+  }
+
+  const Code OK = pb::lyft::ratelimit::RateLimitResponse_Code_OK;
+  const Code OVER_LIMIT = pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT;
+
+  Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                        pb::lyft::ratelimit::RateLimitResponse>* async_client_;
+  Grpc::MockAsyncRequest async_request_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  Event::MockTimer* flush_timer_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  const Optional<std::chrono::milliseconds> timeout_{std::chrono::milliseconds(20)};
+  GrpcBatcherSharedPtr batcher_;
+  BatchedGrpcClientImpl client1_;
+  BatchedGrpcClientImpl client2_;
+  BatchedGrpcClientImpl client3_;
+  MockRequestCallbacks request_callbacks1_;
+  MockRequestCallbacks request_callbacks2_;
+  MockRequestCallbacks request_callbacks3_;
+  RateLimitAsyncCallbacks* batch_callbacks_{};
+  NiceMock<Tracing::MockSpan> parent_span1_;
+  NiceMock<Tracing::MockSpan> parent_span2_;
+  Tracing::MockSpan span_;
+};
+
+TEST_F(RateLimitBatchedGrpcClientTest, Batch) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("ratelimit.batch_window_ms", 0)).WillOnce(Return(5));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(5)));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}, {{{"baz", "qux"}}}},
+                 parent_span1_);
+  client2_.limit(request_callbacks2_, "foo", {{{{"foo", "bar2"}}}}, parent_span2_);
+  client3_.limit(request_callbacks3_, "foo", {{{{"foo", "bar3"}}}}, parent_span2_);
+
+  pb::lyft::ratelimit::RateLimitRequest request;
+  GrpcClientImpl::createRequest(request, "foo",
+                                {{{{"foo", "bar"}}}, {{{"baz", "qux"}}}, {{{"foo", "bar2"}}},
+                                 {{{"foo", "bar3"}}}});
+  expectSend(ProtoEq(request), parent_span1_);
+  flush_timer_->callback_();
+
+  // Each request gets the statuses of its own descriptors.
+  EXPECT_CALL(span_, setTag("ratelimit_status", "over_limit"));
+  EXPECT_CALL(request_callbacks1_, complete(LimitStatus::OverLimit));
+  EXPECT_CALL(request_callbacks2_, complete(LimitStatus::OK));
+  EXPECT_CALL(request_callbacks3_, complete(LimitStatus::OverLimit));
+  batch_callbacks_->onSuccess(response(OVER_LIMIT, {OK, OVER_LIMIT, OK, OVER_LIMIT}), span_);
+
+  // A client can be used again once completed, and the batches do not outlive their requests.
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}}, parent_span1_);
+  client1_.cancel();
+  EXPECT_CALL(*async_client_, send(_, _, _, _, _)).Times(0);
+  flush_timer_->callback_();
+}
+
+TEST_F(RateLimitBatchedGrpcClientTest, OverallCode) {
+  EXPECT_CALL(*flush_timer_, enableTimer(_));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}}, parent_span1_);
+  client2_.limit(request_callbacks2_, "foo", {{{{"foo", "bar2"}}}}, parent_span2_);
+
+  expectSend(_, parent_span1_);
+  flush_timer_->callback_();
+
+  // Without a status per descriptor each request gets the overall code.
+  EXPECT_CALL(span_, setTag("ratelimit_status", "ok"));
+  EXPECT_CALL(request_callbacks1_, complete(LimitStatus::OK));
+  EXPECT_CALL(request_callbacks2_, complete(LimitStatus::OK));
+  batch_callbacks_->onSuccess(response(OK, {}), span_);
+}
+
+TEST_F(RateLimitBatchedGrpcClientTest, DomainsAndFailure) {
+  EXPECT_CALL(*flush_timer_, enableTimer(_));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}}, parent_span1_);
+  client2_.limit(request_callbacks2_, "bar", {{{{"foo", "bar"}}}}, parent_span2_);
+
+  // Requests for different domains go in different batches, which are outstanding together.
+  RateLimitAsyncCallbacks* foo_callbacks{};
+  pb::lyft::ratelimit::RateLimitRequest foo_request;
+  GrpcClientImpl::createRequest(foo_request, "foo", {{{{"foo", "bar"}}}});
+  EXPECT_CALL(*async_client_, send(_, ProtoEq(foo_request), _, Ref(parent_span1_), _))
+      .WillOnce(Invoke([&](const Protobuf::MethodDescriptor&,
+                           const pb::lyft::ratelimit::RateLimitRequest&,
+                           RateLimitAsyncCallbacks& callbacks, Tracing::Span&,
+                           const Optional<std::chrono::milliseconds>&) -> Grpc::AsyncRequest* {
+        foo_callbacks = &callbacks;
+        return &async_request_;
+      }));
+  pb::lyft::ratelimit::RateLimitRequest bar_request;
+  GrpcClientImpl::createRequest(bar_request, "bar", {{{{"foo", "bar"}}}});
+  expectSend(ProtoEq(bar_request), parent_span2_);
+  flush_timer_->callback_();
+
+  EXPECT_CALL(request_callbacks2_, complete(LimitStatus::Error));
+  batch_callbacks_->onFailure(Grpc::Status::Unavailable, "", span_);
+
+  EXPECT_CALL(request_callbacks1_, complete(LimitStatus::OK));
+  EXPECT_CALL(span_, setTag("ratelimit_status", "ok"));
+  foo_callbacks->onSuccess(response(OK, {OK}), span_);
+}
+
+TEST_F(RateLimitBatchedGrpcClientTest, InlineFailure) {
+  EXPECT_CALL(*flush_timer_, enableTimer(_));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}}, parent_span1_);
+
+  EXPECT_CALL(*async_client_, send(_, _, _, _, _))
+      .WillOnce(Invoke([this](const Protobuf::MethodDescriptor&,
+                              const pb::lyft::ratelimit::RateLimitRequest&,
+                              RateLimitAsyncCallbacks& callbacks, Tracing::Span&,
+                              const Optional<std::chrono::milliseconds>&) -> Grpc::AsyncRequest* {
+        callbacks.onFailure(Grpc::Status::Unavailable, "", span_);
+        return nullptr;
+      }));
+  EXPECT_CALL(request_callbacks1_, complete(LimitStatus::Error));
+  flush_timer_->callback_();
+}
+
+TEST_F(RateLimitBatchedGrpcClientTest, Cancel) {
+  EXPECT_CALL(*flush_timer_, enableTimer(_));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}}, parent_span1_);
+  client2_.limit(request_callbacks2_, "foo", {{{{"foo", "bar2"}}}, {{{"baz", "qux"}}}},
+                 parent_span2_);
+  client3_.limit(request_callbacks3_, "foo", {{{{"foo", "bar3"}}}}, parent_span2_);
+
+  // A cancelled request stays in the batch, and its span is not used as the parent.
+  client1_.cancel();
+  pb::lyft::ratelimit::RateLimitRequest request;
+  GrpcClientImpl::createRequest(request, "foo",
+                                {{{{"foo", "bar"}}}, {{{"foo", "bar2"}}}, {{{"baz", "qux"}}},
+                                 {{{"foo", "bar3"}}}});
+  expectSend(ProtoEq(request), parent_span2_);
+  flush_timer_->callback_();
+
+  // A client may cancel another request of the batch when it is completed.
+  EXPECT_CALL(span_, setTag("ratelimit_status", "over_limit"));
+  EXPECT_CALL(request_callbacks2_, complete(LimitStatus::OverLimit))
+      .WillOnce(Invoke([this](LimitStatus) -> void { client3_.cancel(); }));
+  batch_callbacks_->onSuccess(response(OVER_LIMIT, {OVER_LIMIT, OK, OVER_LIMIT, OK}), span_);
+
+  // The batch is cancelled once all of its requests have been cancelled.
+  EXPECT_CALL(*flush_timer_, enableTimer(_));
+  client1_.limit(request_callbacks1_, "foo", {{{{"foo", "bar"}}}}, parent_span1_);
+  client2_.limit(request_callbacks2_, "foo", {{{{"foo", "bar2"}}}}, parent_span2_);
+  expectSend(_, parent_span1_);
+  flush_timer_->callback_();
+  client1_.cancel();
+  EXPECT_CALL(async_request_, cancel());
+  client2_.cancel();
+}
+
+class RateLimitDescriptorCacheTest : public testing::Test {
+public:
+  typedef pb::lyft::ratelimit::RateLimitResponse_Code Code;
+
+  RateLimitDescriptorCacheTest()
+      : stats_(DescriptorCache::generateStats(stats_store_)),
+        cache_(std::make_shared<DescriptorCache>(stats_, runtime_, time_source_)) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+    ON_CALL(runtime_.snapshot_, getInteger("ratelimit.cache_ttl_ms", 0))
+        .WillByDefault(Return(1000));
+    ON_CALL(runtime_.snapshot_, getInteger("ratelimit.cache_max_entries", 10000))
+        .WillByDefault(Return(10000));
+  }
+
+  void update(const std::vector<Descriptor>& descriptors,
+              const std::vector<std::pair<Code, uint32_t>>& statuses) {
+    pb::lyft::ratelimit::RateLimitRequest request;
+    GrpcClientImpl::createRequest(request, "foo", descriptors);
+    pb::lyft::ratelimit::RateLimitResponse response;
+    for (const std::pair<Code, uint32_t>& status : statuses) {
+      pb::lyft::ratelimit::RateLimitResponse::DescriptorStatus* new_status =
+          response.add_statuses();
+      new_status->set_code(status.first);
+      new_status->set_limit_remaining(status.second);
+    }
+    cache_->update(request, response);
+  }
+
+  const Code OK = pb::lyft::ratelimit::RateLimitResponse_Code_OK;
+  const Code OVER_LIMIT = pb::lyft::ratelimit::RateLimitResponse_Code_OVER_LIMIT;
+  const std::vector<Descriptor> foo_{{{{"foo", "bar"}}}};
+  const std::vector<Descriptor> baz_{{{{"baz", "qux"}}}};
+
+  MonotonicTime now_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  Stats::IsolatedStoreImpl stats_store_;
+  CacheStats stats_;
+  DescriptorCacheSharedPtr cache_;
+};
+
+TEST_F(RateLimitDescriptorCacheTest, Disabled) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("ratelimit.cache_ttl_ms", 0))
+      .WillRepeatedly(Return(0));
+  update(foo_, {{OK, 10}});
+  EXPECT_EQ(0U, cache_->size());
+  EXPECT_FALSE(cache_->lookup("foo", foo_));
+  EXPECT_EQ(0U, stats_store_.counter("ratelimit.cache.miss").value());
+}
+
+TEST_F(RateLimitDescriptorCacheTest, LimitRemaining) {
+  update({foo_[0], baz_[0]}, {{OK, 2}, {OVER_LIMIT, 0}});
+  EXPECT_EQ(1U, cache_->size());
+
+  // The limit left of the descriptor is used up by the requests decided from the cache.
+  EXPECT_TRUE(cache_->lookup("foo", foo_));
+  EXPECT_TRUE(cache_->lookup("foo", foo_));
+  EXPECT_FALSE(cache_->lookup("foo", foo_));
+  EXPECT_EQ(2U, stats_store_.counter("ratelimit.cache.hit").value());
+  EXPECT_EQ(1U, stats_store_.counter("ratelimit.cache.miss").value());
+
+  // A request is decided from the cache only if all its descriptors are cached, in its domain.
+  update(foo_, {{OK, 5}});
+  EXPECT_FALSE(cache_->lookup("foo", {foo_[0], baz_[0]}));
+  EXPECT_FALSE(cache_->lookup("bar", foo_));
+  EXPECT_TRUE(cache_->lookup("foo", foo_));
+
+  // An over limit answer removes the entry.
+  update(foo_, {{OVER_LIMIT, 0}});
+  EXPECT_EQ(0U, cache_->size());
+
+  // A response without a status per descriptor is ignored.
+  update({foo_[0], baz_[0]}, {{OK, 5}});
+  EXPECT_EQ(0U, cache_->size());
+}
+
+TEST_F(RateLimitDescriptorCacheTest, Expiry) {
+  update(foo_, {{OK, 100}});
+  now_ += std::chrono::milliseconds(999);
+  EXPECT_TRUE(cache_->lookup("foo", foo_));
+
+  now_ += std::chrono::milliseconds(1);
+  EXPECT_FALSE(cache_->lookup("foo", foo_));
+  EXPECT_EQ(0U, cache_->size());
+}
+
+TEST_F(RateLimitDescriptorCacheTest, Overflow) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("ratelimit.cache_max_entries", 10000))
+      .WillRepeatedly(Return(1));
+  update(foo_, {{OK, 100}});
+  update(baz_, {{OK, 100}});
+  EXPECT_EQ(1U, stats_store_.counter("ratelimit.cache.overflow").value());
+  EXPECT_FALSE(cache_->lookup("foo", baz_));
+
+  // Expired entries make room for new ones.
+  now_ += std::chrono::milliseconds(1000);
+  update(baz_, {{OK, 100}});
+  EXPECT_EQ(1U, cache_->size());
+  EXPECT_TRUE(cache_->lookup("foo", baz_));
+}
+
+TEST_F(RateLimitDescriptorCacheTest, GrpcClient) {
+  Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                        pb::lyft::ratelimit::RateLimitResponse>* async_client =
+      new Grpc::MockAsyncClient<pb::lyft::ratelimit::RateLimitRequest,
+                                pb::lyft::ratelimit::RateLimitResponse>();
+  Grpc::MockAsyncRequest async_request;
+  GrpcClientImpl client(RateLimitAsyncClientPtr{async_client},
+                        Optional<std::chrono::milliseconds>(), cache_);
+  MockRequestCallbacks request_callbacks;
+  NiceMock<Tracing::MockSpan> span;
+
+  EXPECT_CALL(*async_client, send(_, _, _, _, _)).WillOnce(Return(&async_request));
+  client.limit(request_callbacks, "foo", foo_, Tracing::NullSpan::instance());
+
+  std::unique_ptr<pb::lyft::ratelimit::RateLimitResponse> response(
+      new pb::lyft::ratelimit::RateLimitResponse());
+  response->set_overall_code(OK);
+  response->add_statuses()->set_code(OK);
+  response->mutable_statuses(0)->set_limit_remaining(1);
+  EXPECT_CALL(request_callbacks, complete(LimitStatus::OK));
+  client.onSuccess(std::move(response), span);
+
+  // The next request is decided inline from the cache.
+  EXPECT_CALL(request_callbacks, complete(LimitStatus::OK));
+  client.limit(request_callbacks, "foo", foo_, Tracing::NullSpan::instance());
+  EXPECT_EQ(1U, stats_store_.counter("ratelimit.cache.hit").value());
+
+  EXPECT_CALL(*async_client, send(_, _, _, _, _)).WillOnce(Return(&async_request));
+  client.limit(request_callbacks, "foo", foo_, Tracing::NullSpan::instance());
+  EXPECT_CALL(async_request, cancel());
+  client.cancel();
+}
+
 TEST(RateLimitGrpcFactoryTest, NoCluster) {
   envoy::api::v2::RateLimitServiceConfig config;
   config.set_cluster_name("foo");
   Upstream::MockClusterManager cm;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<MockMonotonicTimeSource> time_source;
 
   EXPECT_CALL(cm, get("foo")).WillOnce(Return(nullptr));
-  EXPECT_THROW(GrpcFactoryImpl(config, cm), EnvoyException);
+  EXPECT_THROW(GrpcFactoryImpl(config, cm, tls, runtime, stats_store, time_source),
+               EnvoyException);
 }
 
 TEST(RateLimitGrpcFactoryTest, Create) {
   envoy::api::v2::RateLimitServiceConfig config;
   config.set_cluster_name("foo");
   Upstream::MockClusterManager cm;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<MockMonotonicTimeSource> time_source;
 
   EXPECT_CALL(cm, get("foo")).Times(AtLeast(1));
-  GrpcFactoryImpl factory(config, cm);
-  factory.create(Optional<std::chrono::milliseconds>());
+  GrpcFactoryImpl factory(config, cm, tls, runtime, stats_store, time_source);
+
+  EXPECT_CALL(runtime.snapshot_, featureEnabled("ratelimit.batching_enabled", 0))
+      .WillOnce(Return(false));
+  ClientPtr client = factory.create(Optional<std::chrono::milliseconds>());
+  EXPECT_NE(nullptr, dynamic_cast<GrpcClientImpl*>(client.get()));
+
+  EXPECT_CALL(runtime.snapshot_, featureEnabled("ratelimit.batching_enabled", 0))
+      .WillOnce(Return(true));
+  client = factory.create(Optional<std::chrono::milliseconds>());
+  EXPECT_NE(nullptr, dynamic_cast<BatchedGrpcClientImpl*>(client.get()));
 }
 
 TEST(RateLimitNullFactoryTest, Basic) {
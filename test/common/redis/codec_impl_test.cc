@@ -155,6 +155,44 @@ TEST_F(RedisEncoderDecoderImplTest, NestedArray) {
   EXPECT_EQ(value, *decoded_values_[0]);
 }
 
+TEST_F(RedisEncoderDecoderImplTest, DeeplyNestedArrays) {
+  // Each level of nesting grows the stack of pending values while the enclosing arrays are still
+  // being decoded. Decode the value twice to cover reusing the stack.
+  const std::string nested = "*1\r\n*1\r\n*1\r\n*1\r\n*1\r\n*2\r\n$3\r\nfoo\r\n:1\r\n";
+  buffer_.add(nested + nested);
+  decoder_.decode(buffer_);
+  ASSERT_EQ(2UL, decoded_values_.size());
+  EXPECT_EQ("[[[[[[\"foo\", 1]]]]]]", decoded_values_[0]->toString());
+  EXPECT_EQ(*decoded_values_[0], *decoded_values_[1]);
+}
+
+TEST_F(RedisEncoderDecoderImplTest, LargeDeclaredBulkString) {
+  // The declared length is not trusted for reserving the whole string.
+  buffer_.add("$1000000000\r\nhello");
+  decoder_.decode(buffer_);
+  EXPECT_TRUE(decoded_values_.empty());
+  EXPECT_EQ(0UL, buffer_.length());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, Copy) {
+  std::vector<RespValue> values(2);
+  values[0].type(RespType::BulkString);
+  values[0].asString() = "hello";
+  values[1].type(RespType::Integer);
+  values[1].asInteger() = -5;
+  RespValue value;
+  value.type(RespType::Array);
+  value.asArray().swap(values);
+
+  RespValue copy(value);
+  EXPECT_EQ(value, copy);
+  copy.asArray()[0].asString() = "world";
+  EXPECT_EQ("[\"hello\", -5]", value.toString());
+
+  copy = copy.asArray()[0];
+  EXPECT_EQ("\"world\"", copy.toString());
+}
+
 TEST_F(RedisEncoderDecoderImplTest, NullArray) {
   buffer_.add("*-1\r\n");
   decoder_.decode(buffer_);
@@ -5,18 +5,23 @@
 #include "common/redis/conn_pool_impl.h"
 #include "common/upstream/upstream_impl.h"
 
+#include "test/common/upstream/utility.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/redis/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::Eq;
 using testing::InSequence;
 using testing::Invoke;
+using testing::Ne;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
@@ -47,12 +52,9 @@ public:
     }
   }
 
-  void setup() {
-    std::string json_string = R"EOF(
-    {
-      "op_timeout_ms": 20
-    }
-    )EOF";
+  void setup(bool batch_writes = false) {
+    std::string json_string = fmt::format(R"EOF({{"op_timeout_ms": 20, "batch_writes": {}}})EOF",
+                                          batch_writes ? "true" : "false");
 
     Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
     config_.reset(new ConfigImpl(*json_config));
@@ -323,6 +325,52 @@ TEST_F(RedisClientImplTest, OpTimeout) {
   EXPECT_EQ(1UL, host_->cluster_.stats_.upstream_rq_timeout_.value());
 }
 
+TEST_F(RedisClientImplTest, BatchWrites) {
+  InSequence s;
+
+  Event::MockTimer* flush_timer = new Event::MockTimer(&dispatcher_);
+  setup(true);
+  onConnected();
+
+  auto encode = [](const RespValue&, Buffer::Instance& out) -> void { out.add("cmd\r\n"); };
+
+  // The first command schedules the flush, the following ones are added to the batch.
+  RespValue request1;
+  MockPoolCallbacks callbacks1;
+  EXPECT_CALL(*flush_timer, enableTimer(std::chrono::milliseconds(0)));
+  EXPECT_CALL(*encoder_, encode(Ref(request1), _)).WillOnce(Invoke(encode));
+  EXPECT_CALL(*connect_or_op_timer_, enableTimer(_));
+  EXPECT_NE(nullptr, client_->makeRequest(request1, callbacks1));
+
+  RespValue request2;
+  MockPoolCallbacks callbacks2;
+  EXPECT_CALL(*encoder_, encode(Ref(request2), _)).WillOnce(Invoke(encode));
+  EXPECT_NE(nullptr, client_->makeRequest(request2, callbacks2));
+
+  EXPECT_CALL(*upstream_connection_, write(_)).WillOnce(Invoke([](Buffer::Instance& data) -> void {
+    EXPECT_EQ("cmd\r\ncmd\r\n", TestUtility::bufferToString(data));
+    data.drain(data.length());
+  }));
+  flush_timer->callback_();
+
+  // Commands which were not written yet are dropped when the connection closes.
+  RespValue request3;
+  MockPoolCallbacks callbacks3;
+  EXPECT_CALL(*flush_timer, enableTimer(_));
+  EXPECT_CALL(*encoder_, encode(Ref(request3), _)).WillOnce(Invoke(encode));
+  EXPECT_NE(nullptr, client_->makeRequest(request3, callbacks3));
+
+  EXPECT_CALL(callbacks1, onFailure());
+  EXPECT_CALL(callbacks2, onFailure());
+  EXPECT_CALL(callbacks3, onFailure());
+  EXPECT_CALL(*connect_or_op_timer_, disableTimer());
+  EXPECT_CALL(*flush_timer, disableTimer());
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+
+  EXPECT_CALL(*upstream_connection_, write(_)).Times(0);
+  flush_timer->callback_();
+}
+
 TEST(RedisClientFactoryImplTest, Basic) {
   std::string json_string = R"EOF(
   {
@@ -462,6 +510,390 @@ TEST_F(RedisConnPoolImplTest, RemoteClose) {
   tls_.shutdownThread();
 }
 
+TEST(RedisClusterUtilityTest, HashSlot) {
+  EXPECT_EQ(12182U, ClusterUtility::hashSlot("foo"));
+  EXPECT_EQ(5061U, ClusterUtility::hashSlot("bar"));
+  EXPECT_EQ(12739U, ClusterUtility::hashSlot("123456789"));
+
+  // Only the hash tag is hashed, unless it is empty.
+  EXPECT_EQ(ClusterUtility::hashSlot("user1000"),
+            ClusterUtility::hashSlot("{user1000}.following"));
+  EXPECT_EQ(ClusterUtility::hashSlot("user1000"), ClusterUtility::hashSlot("a{user1000}}{b}"));
+  EXPECT_EQ(ClusterUtility::hashSlot("{}user1000"), ClusterUtility::hashSlot("{}user1000"));
+  EXPECT_NE(ClusterUtility::hashSlot("user1000"), ClusterUtility::hashSlot("{}user1000"));
+  EXPECT_EQ(ClusterUtility::hashSlot("{user1000"), ClusterUtility::hashSlot("{user1000"));
+}
+
+TEST(RedisClusterUtilityTest, ParseRedirection) {
+  RespValue value;
+  ClusterUtility::Redirection redirection;
+  value.type(RespType::Error);
+
+  value.asString() = "MOVED 3999 127.0.0.1:6381";
+  EXPECT_TRUE(ClusterUtility::parseRedirection(value, redirection));
+  EXPECT_FALSE(redirection.ask_);
+  EXPECT_EQ(3999U, redirection.slot_);
+  EXPECT_EQ("127.0.0.1:6381", redirection.address_);
+
+  value.asString() = "ASK 12 127.0.0.1:6382";
+  EXPECT_TRUE(ClusterUtility::parseRedirection(value, redirection));
+  EXPECT_TRUE(redirection.ask_);
+  EXPECT_EQ(12U, redirection.slot_);
+
+  value.asString() = "MOVED 16384 127.0.0.1:6381";
+  EXPECT_FALSE(ClusterUtility::parseRedirection(value, redirection));
+  value.asString() = "ERR wrong number of arguments";
+  EXPECT_FALSE(ClusterUtility::parseRedirection(value, redirection));
+
+  value.type(RespType::SimpleString);
+  value.asString() = "MOVED 3999 127.0.0.1:6381";
+  EXPECT_FALSE(ClusterUtility::parseRedirection(value, redirection));
+}
+
+class RedisClusterConnPoolImplTest : public RedisConnPoolImplTest {
+public:
+  RedisClusterConnPoolImplTest() {
+    cm_.thread_local_cluster_.cluster_.hosts_ = {host1_, host2_};
+    std::string json_string = R"EOF(
+    {
+      "op_timeout_ms": 20,
+      "cluster_mode": true
+    }
+    )EOF";
+
+    Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+    conn_pool_.reset(new InstanceImpl(cluster_name_, cm_, *this, tls_, *json_config));
+  }
+
+  static RespValuePtr makeValue(RespType type, const std::string& string) {
+    RespValuePtr value(new RespValue());
+    value->type(type);
+    value->asString() = string;
+    return value;
+  }
+
+  // A CLUSTER SLOTS response which maps all the slots to host2_.
+  static RespValuePtr makeSlots() {
+    std::vector<RespValue> master(2);
+    master[0].type(RespType::BulkString);
+    master[0].asString() = "10.0.0.2";
+    master[1].type(RespType::Integer);
+    master[1].asInteger() = 6379;
+    std::vector<RespValue> entry(3);
+    entry[0].type(RespType::Integer);
+    entry[0].asInteger() = 0;
+    entry[1].type(RespType::Integer);
+    entry[1].asInteger() = 16383;
+    entry[2].type(RespType::Array);
+    entry[2].asArray().swap(master);
+    RespValuePtr slots(new RespValue());
+    slots->type(RespType::Array);
+    slots->asArray().resize(1);
+    slots->asArray()[0].type(RespType::Array);
+    slots->asArray()[0].asArray().swap(entry);
+    return slots;
+  }
+
+  Upstream::HostSharedPtr host1_{
+      Upstream::makeTestHost(cm_.thread_local_cluster_.cluster_.info_, "tcp://10.0.0.1:6379")};
+  Upstream::HostSharedPtr host2_{
+      Upstream::makeTestHost(cm_.thread_local_cluster_.cluster_.info_, "tcp://10.0.0.2:6379")};
+};
+
+TEST_F(RedisClusterConnPoolImplTest, SlotsAndRedirections) {
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+  MockPoolRequest refresh_request;
+  MockPoolRequest active_request1;
+  MockPoolRequest active_request2;
+  PoolCallbacks* refresh_callbacks{};
+  PoolCallbacks* request_callbacks{};
+  auto saveCallbacks = [](PoolCallbacks*& saved, PoolRequest* handle) {
+    return Invoke([&saved, handle](const RespValue&, PoolCallbacks& callbacks) -> PoolRequest* {
+      saved = &callbacks;
+      return handle;
+    });
+  };
+
+  {
+    InSequence s;
+
+    // The slots are unknown: they are refreshed while the load balancer picks the host.
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(nullptr)).WillOnce(Return(host1_));
+    EXPECT_CALL(*this, create_(Eq(host1_))).WillOnce(Return(client1));
+    EXPECT_CALL(*client1, makeRequest(_, _))
+        .WillOnce(saveCallbacks(refresh_callbacks, &refresh_request));
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(Ne(nullptr))).WillOnce(Return(host1_));
+    EXPECT_CALL(*client1, makeRequest(Ref(value), _))
+        .WillOnce(saveCallbacks(request_callbacks, &active_request1));
+    PoolRequest* request = conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_NE(nullptr, request);
+    refresh_callbacks->onResponse(makeSlots());
+
+    // A MOVED redirection is followed to the new master, and triggers a refresh.
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(nullptr)).WillOnce(Return(host1_));
+    EXPECT_CALL(*client1, makeRequest(_, _)).WillOnce(Return(&refresh_request));
+    EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+    EXPECT_CALL(*client2, makeRequest(Eq(value), _))
+        .WillOnce(saveCallbacks(request_callbacks, &active_request2));
+    request_callbacks->onResponse(makeValue(RespType::Error, "MOVED 12182 10.0.0.2:6379"));
+
+    EXPECT_CALL(callbacks, onResponse_(_));
+    EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+    request_callbacks->onResponse(makeValue(RespType::BulkString, "bar"));
+
+    // The slots now route to host2, which may ask for a single command to go to host1.
+    EXPECT_CALL(*client2, makeRequest(Ref(value), _))
+        .WillOnce(saveCallbacks(request_callbacks, &active_request2));
+    request = conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_NE(nullptr, request);
+
+    RespValue asking;
+    asking.type(RespType::Array);
+    asking.asArray().resize(1);
+    asking.asArray()[0].type(RespType::BulkString);
+    asking.asArray()[0].asString() = "ASKING";
+    EXPECT_CALL(*client1, makeRequest(Eq(asking), _)).WillOnce(Return(&active_request1));
+    EXPECT_CALL(*client1, makeRequest(Eq(value), _))
+        .WillOnce(saveCallbacks(request_callbacks, &active_request1));
+    request_callbacks->onResponse(makeValue(RespType::Error, "ASK 12182 10.0.0.1:6379"));
+
+    EXPECT_CALL(active_request1, cancel());
+    EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+    request->cancel();
+
+    // Redirections to hosts which are not in the cluster are returned as is.
+    EXPECT_CALL(*client2, makeRequest(Ref(value), _))
+        .WillOnce(saveCallbacks(request_callbacks, &active_request2));
+    conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_CALL(callbacks, onResponse_(_));
+    EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+    request_callbacks->onResponse(makeValue(RespType::Error, "MOVED 12182 10.0.0.3:6379"));
+  }
+
+  EXPECT_CALL(*client1, close());
+  EXPECT_CALL(*client2, close());
+  tls_.shutdownThread();
+}
+
+class RedisHotKeyConnPoolImplTest : public RedisConnPoolImplTest {
+public:
+  RedisHotKeyConnPoolImplTest() {
+    std::string json_string = R"EOF(
+    {
+      "op_timeout_ms": 20,
+      "hot_keys": {
+        "top_n": 2,
+        "cached_keys": ["foo"],
+        "cache_ttl_ms": 60000
+      }
+    }
+    )EOF";
+
+    Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+    EXPECT_CALL(*hot_key_timer_, enableTimer(InstanceImpl::HOT_KEY_INTERVAL));
+    InstanceImpl* conn_pool = new InstanceImpl(cluster_name_, cm_, *this, tls_, *json_config);
+    conn_pool_.reset(conn_pool);
+    collector_ = conn_pool->hotKeyCollector();
+  }
+
+  static RespValue makeCommand(const std::string& command, const std::string& key) {
+    std::vector<RespValue> values(2);
+    values[0].type(RespType::BulkString);
+    values[0].asString() = command;
+    values[1].type(RespType::BulkString);
+    values[1].asString() = key;
+    RespValue value;
+    value.type(RespType::Array);
+    value.asArray().swap(values);
+    return value;
+  }
+
+  static RespValuePtr makeBulkString(const std::string& string) {
+    RespValuePtr value(new RespValue());
+    value->type(RespType::BulkString);
+    value->asString() = string;
+    return value;
+  }
+
+  // The timers are created by the pool in the reverse order.
+  Event::MockTimer* cached_response_timer_{new Event::MockTimer(&tls_.dispatcher_)};
+  Event::MockTimer* hot_key_timer_{new Event::MockTimer(&tls_.dispatcher_)};
+  HotKeyCollectorSharedPtr collector_;
+};
+
+TEST_F(RedisHotKeyConnPoolImplTest, HotKeys) {
+  MockClient* client = new NiceMock<MockClient>();
+  MockPoolRequest active_request;
+  MockPoolCallbacks callbacks;
+  EXPECT_CALL(*this, create_(_)).WillOnce(Return(client));
+  EXPECT_CALL(*client, makeRequest(_, _)).WillRepeatedly(Return(&active_request));
+
+  const std::vector<std::string> keys{"bar", "bar", "baz", "qux", "bar", "qux"};
+  for (const std::string& key : keys) {
+    RespValue value = makeCommand("incr", key);
+    EXPECT_EQ(&active_request, conn_pool_->makeRequest(key, value, callbacks));
+  }
+
+  // The top keys are published periodically.
+  EXPECT_TRUE(collector_->topKeys().empty());
+  EXPECT_CALL(*hot_key_timer_, enableTimer(InstanceImpl::HOT_KEY_INTERVAL));
+  hot_key_timer_->callback_();
+  std::vector<HotKey> top_keys = collector_->topKeys();
+  ASSERT_EQ(2U, top_keys.size());
+  EXPECT_EQ("bar", top_keys[0].key_);
+  EXPECT_EQ(3U, top_keys[0].count_);
+  EXPECT_EQ("qux", top_keys[1].key_);
+  EXPECT_EQ(2U, top_keys[1].count_);
+
+  EXPECT_CALL(*client, close());
+  tls_.shutdownThread();
+  EXPECT_TRUE(collector_->topKeys().empty());
+}
+
+TEST_F(RedisHotKeyConnPoolImplTest, CachedKeys) {
+  MockClient* client = new NiceMock<MockClient>();
+  MockPoolRequest active_request;
+  MockPoolCallbacks callbacks;
+  PoolCallbacks* fill_callbacks{};
+  auto saveCallbacks = [&fill_callbacks, &active_request]() {
+    return Invoke([&fill_callbacks,
+                   &active_request](const RespValue&, PoolCallbacks& callbacks) -> PoolRequest* {
+      fill_callbacks = &callbacks;
+      return &active_request;
+    });
+  };
+  RespValue get = makeCommand("GET", "foo");
+  RespValue set = makeCommand("set", "foo");
+
+  // A miss fills the cache.
+  EXPECT_CALL(*this, create_(_)).WillOnce(Return(client));
+  EXPECT_CALL(*client, makeRequest(Ref(get), _)).WillOnce(saveCallbacks());
+  EXPECT_NE(nullptr, conn_pool_->makeRequest("foo", get, callbacks));
+  EXPECT_CALL(callbacks, onResponse_(_));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  fill_callbacks->onResponse(makeBulkString("hello"));
+
+  // A hit is delivered by the dispatcher.
+  EXPECT_CALL(*cached_response_timer_, enableTimer(std::chrono::milliseconds(0)));
+  EXPECT_NE(nullptr, conn_pool_->makeRequest("foo", get, callbacks));
+  EXPECT_CALL(callbacks, onResponse_(_)).WillOnce(Invoke([](RespValuePtr& value) -> void {
+    EXPECT_EQ("hello", value->asString());
+  }));
+  cached_response_timer_->callback_();
+
+  // A cancelled hit is not delivered.
+  EXPECT_CALL(*cached_response_timer_, enableTimer(_));
+  conn_pool_->makeRequest("foo", get, callbacks)->cancel();
+  cached_response_timer_->callback_();
+
+  // Any other command invalidates the cache, including for the GETs sent before it.
+  EXPECT_CALL(*client, makeRequest(Ref(set), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", set, callbacks));
+  EXPECT_CALL(*client, makeRequest(Ref(get), _)).WillOnce(saveCallbacks());
+  conn_pool_->makeRequest("foo", get, callbacks);
+  EXPECT_CALL(*client, makeRequest(Ref(set), Ref(callbacks))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest("foo", set, callbacks);
+  EXPECT_CALL(callbacks, onResponse_(_));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  fill_callbacks->onResponse(makeBulkString("stale"));
+
+  EXPECT_CALL(*client, makeRequest(Ref(get), _)).WillOnce(saveCallbacks());
+  PoolRequest* request = conn_pool_->makeRequest("foo", get, callbacks);
+  EXPECT_NE(&active_request, request);
+  EXPECT_CALL(active_request, cancel());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  request->cancel();
+
+  EXPECT_CALL(*client, close());
+  tls_.shutdownThread();
+}
+
+class RedisCollapsedReadsConnPoolImplTest : public RedisConnPoolImplTest {
+public:
+  RedisCollapsedReadsConnPoolImplTest() {
+    std::string json_string = R"EOF(
+    {
+      "op_timeout_ms": 20,
+      "collapse_reads": true
+    }
+    )EOF";
+
+    Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+    conn_pool_.reset(new InstanceImpl(cluster_name_, cm_, *this, tls_, *json_config));
+  }
+};
+
+TEST_F(RedisCollapsedReadsConnPoolImplTest, CollapsedReads) {
+  MockClient* client = new NiceMock<MockClient>();
+  MockPoolRequest active_request;
+  MockPoolCallbacks callbacks1;
+  MockPoolCallbacks callbacks2;
+  MockPoolCallbacks callbacks3;
+  PoolCallbacks* read_callbacks{};
+  auto saveCallbacks = [&read_callbacks, &active_request]() {
+    return Invoke([&read_callbacks,
+                   &active_request](const RespValue&, PoolCallbacks& callbacks) -> PoolRequest* {
+      read_callbacks = &callbacks;
+      return &active_request;
+    });
+  };
+  RespValue get = RedisHotKeyConnPoolImplTest::makeCommand("GET", "foo");
+  RespValue other_get = RedisHotKeyConnPoolImplTest::makeCommand("get", "foo");
+  RespValue hget = RedisHotKeyConnPoolImplTest::makeCommand("hget", "foo");
+  RespValue set = RedisHotKeyConnPoolImplTest::makeCommand("set", "foo");
+
+  // Identical reads are sent once, and each is answered with the response.
+  EXPECT_CALL(*this, create_(_)).WillOnce(Return(client));
+  EXPECT_CALL(*client, makeRequest(Ref(get), _)).WillOnce(saveCallbacks());
+  PoolRequest* request1 = conn_pool_->makeRequest("foo", get, callbacks1);
+  PoolRequest* request2 = conn_pool_->makeRequest("foo", other_get, callbacks2);
+  PoolRequest* request3 = conn_pool_->makeRequest("foo", get, callbacks3);
+  EXPECT_NE(nullptr, request1);
+  EXPECT_NE(nullptr, request2);
+  EXPECT_NE(request1, request2);
+  request3->cancel();
+
+  // Other reads with the same key are sent.
+  EXPECT_CALL(*client, makeRequest(Ref(hget), _)).WillOnce(Return(&active_request));
+  EXPECT_NE(nullptr, conn_pool_->makeRequest("foo", hget, callbacks3));
+
+  EXPECT_CALL(callbacks1, onResponse_(_)).WillOnce(Invoke([](RespValuePtr& value) -> void {
+    EXPECT_EQ("hello", value->asString());
+  }));
+  EXPECT_CALL(callbacks2, onResponse_(_)).WillOnce(Invoke([](RespValuePtr& value) -> void {
+    EXPECT_EQ("hello", value->asString());
+  }));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  read_callbacks->onResponse(RedisHotKeyConnPoolImplTest::makeBulkString("hello"));
+
+  // A read sent after a write with the same key does not join the reads sent before it.
+  EXPECT_CALL(*client, makeRequest(Ref(get), _)).WillOnce(saveCallbacks());
+  conn_pool_->makeRequest("foo", get, callbacks1);
+  PoolCallbacks* stale_callbacks = read_callbacks;
+  EXPECT_CALL(*client, makeRequest(Ref(set), Ref(callbacks3))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest("foo", set, callbacks3);
+  EXPECT_CALL(*client, makeRequest(Ref(get), _)).WillOnce(saveCallbacks());
+  PoolRequest* request4 = conn_pool_->makeRequest("foo", get, callbacks2);
+  EXPECT_NE(stale_callbacks, read_callbacks);
+
+  EXPECT_CALL(callbacks1, onFailure());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  stale_callbacks->onFailure();
+
+  // The read is canceled once every request waiting for it is.
+  PoolRequest* request5 = conn_pool_->makeRequest("foo", get, callbacks3);
+  request5->cancel();
+  EXPECT_CALL(active_request, cancel());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  request4->cancel();
+
+  EXPECT_CALL(*client, close());
+  tls_.shutdownThread();
+}
+
 } // namespace ConnPool
 } // namespace Redis
 } // namespace Envoy
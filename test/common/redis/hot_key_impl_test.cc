@@ -0,0 +1,133 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/redis/hot_key_impl.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::DoAll;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Redis {
+
+TEST(RedisCountMinSketchTest, IncrementAndDecay) {
+  CountMinSketch sketch(1000);
+  EXPECT_EQ(0U, sketch.estimate("foo"));
+  EXPECT_EQ(1U, sketch.increment("foo"));
+  EXPECT_EQ(2U, sketch.increment("foo"));
+  EXPECT_EQ(3U, sketch.increment("foo"));
+  EXPECT_EQ(1U, sketch.increment("bar"));
+  EXPECT_EQ(3U, sketch.estimate("foo"));
+
+  sketch.decay();
+  EXPECT_EQ(1U, sketch.estimate("foo"));
+  EXPECT_EQ(0U, sketch.estimate("bar"));
+}
+
+TEST(RedisCountMinSketchTest, NeverUnderestimates) {
+  // With many more keys than counters, the estimates are too high but never too low.
+  CountMinSketch sketch(16);
+  for (uint32_t i = 0; i < 100; i++) {
+    for (uint32_t j = 0; j <= i % 10; j++) {
+      sketch.increment(std::to_string(i));
+    }
+  }
+  for (uint32_t i = 0; i < 100; i++) {
+    EXPECT_LE(i % 10 + 1, sketch.estimate(std::to_string(i)));
+  }
+}
+
+TEST(RedisHotKeyTrackerTest, TopKeys) {
+  HotKeyTracker tracker(2);
+  EXPECT_TRUE(tracker.topKeys().empty());
+
+  for (const std::string& key : {"foo", "bar", "foo", "baz", "baz", "foo", "qux"}) {
+    tracker.recordAccess(key);
+  }
+  std::vector<HotKey> keys = tracker.topKeys();
+  ASSERT_EQ(2U, keys.size());
+  EXPECT_EQ("foo", keys[0].key_);
+  EXPECT_EQ(3U, keys[0].count_);
+  EXPECT_EQ("baz", keys[1].key_);
+  EXPECT_EQ(2U, keys[1].count_);
+
+  // After a decay, the keys which are accessed again replace the ones which are not.
+  tracker.decay();
+  keys = tracker.topKeys();
+  ASSERT_EQ(2U, keys.size());
+  EXPECT_EQ(1U, keys[0].count_);
+  EXPECT_EQ(1U, keys[1].count_);
+  tracker.recordAccess("foo");
+  tracker.recordAccess("qux");
+  tracker.recordAccess("qux");
+  keys = tracker.topKeys();
+  ASSERT_EQ(2U, keys.size());
+  EXPECT_EQ("foo", keys[0].key_);
+  EXPECT_EQ(2U, keys[0].count_);
+  EXPECT_EQ("qux", keys[1].key_);
+  EXPECT_EQ(2U, keys[1].count_);
+
+  tracker.decay();
+  tracker.decay();
+  EXPECT_TRUE(tracker.topKeys().empty());
+}
+
+TEST(RedisHotKeyCollectorTest, MergeWorkers) {
+  HotKeyCollector collector(2);
+  int worker1;
+  int worker2;
+  collector.publish(&worker1, {{"foo", 5}, {"bar", 3}});
+  collector.publish(&worker2, {{"bar", 4}, {"baz", 1}});
+  std::vector<HotKey> keys = collector.topKeys();
+  ASSERT_EQ(2U, keys.size());
+  EXPECT_EQ("bar", keys[0].key_);
+  EXPECT_EQ(7U, keys[0].count_);
+  EXPECT_EQ("foo", keys[1].key_);
+  EXPECT_EQ(5U, keys[1].count_);
+
+  collector.publish(&worker1, {{"baz", 2}});
+  collector.remove(&worker2);
+  keys = collector.topKeys();
+  ASSERT_EQ(1U, keys.size());
+  EXPECT_EQ("baz", keys[0].key_);
+  EXPECT_EQ(2U, keys[0].count_);
+}
+
+TEST(RedisHotKeyAdminTest, Handler) {
+  Server::MockAdmin admin;
+  Server::Admin::HandlerCb handler;
+  EXPECT_CALL(admin, addHandler("/redis/hot_keys", _, _, true))
+      .WillOnce(DoAll(SaveArg<2>(&handler), Return(true)));
+  std::unique_ptr<HotKeyAdmin> hot_key_admin(new HotKeyAdmin(admin));
+
+  HotKeyCollectorSharedPtr collector1(new HotKeyCollector(10));
+  HotKeyCollectorSharedPtr collector2(new HotKeyCollector(10));
+  hot_key_admin->addCollector("redis.foo.", collector1);
+  hot_key_admin->addCollector("redis.bar.", collector2);
+  int worker;
+  collector1->publish(&worker, {{"key1", 2}, {"key2", 1}});
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, handler("/redis/hot_keys", response));
+  EXPECT_EQ("redis.foo.\n  key1: 2\n  key2: 1\nredis.bar.\n", TestUtility::bufferToString(response));
+
+  // The collectors of the destroyed proxies are no longer listed.
+  collector1.reset();
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, handler("/redis/hot_keys", response));
+  EXPECT_EQ("redis.bar.\n", TestUtility::bufferToString(response));
+
+  EXPECT_CALL(admin, removeHandler("/redis/hot_keys"));
+}
+
+} // namespace Redis
+} // namespace Envoy
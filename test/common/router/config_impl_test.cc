@@ -203,7 +203,7 @@ TEST(RouteMatcherTest, TestRoutes) {
         {"pattern": "^/rides$", "method": "POST", "name": "ride_request"},
         {"pattern": "^/rides/\\d+$", "method": "PUT", "name": "update_ride"},
         {"pattern": "^/users/\\d+/chargeaccounts$", "method": "POST", "name": "cc_add"},
-        {"pattern": "^/users/\\d+/chargeaccounts/(?!validate)\\w+$", "method": "PUT",
+        {"pattern": "^/users/\\d+/chargeaccounts/[a-z]+\\d+$", "method": "PUT",
          "name": "cc_add"},
         {"pattern": "^/users$", "method": "POST", "name": "create_user_login"},
         {"pattern": "^/users/\\d+$", "method": "PUT", "name": "update_user"},
@@ -670,6 +670,55 @@ TEST(RouteMatcherTest, NoHostRewriteAndAutoRewrite) {
                EnvoyException);
 }
 
+// Regexes which RE2 does not support, such as ones with lookahead, are rejected when the config
+// is loaded.
+TEST(RouteMatcherTest, UnsupportedRegex) {
+  std::string route_json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "regex": "/users/(?!validate)\\w+",
+          "cluster": "local_service"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  std::string virtual_cluster_json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "local_service"
+        }
+      ],
+      "virtual_clusters": [
+        {"pattern": "^/users/(\\d+)/\\1$", "method": "PUT", "name": "users"}
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  EXPECT_THROW(ConfigImpl(parseRouteConfigurationFromJson(route_json), runtime, cm, true),
+               EnvoyException);
+  EXPECT_THROW(
+      ConfigImpl(parseRouteConfigurationFromJson(virtual_cluster_json), runtime, cm, true),
+      EnvoyException);
+}
+
 TEST(RouteMatcherTest, NoRedirectAndWebSocket) {
   std::string json = R"EOF(
 {
@@ -695,6 +744,187 @@ TEST(RouteMatcherTest, NoRedirectAndWebSocket) {
                EnvoyException);
 }
 
+// Wildcard domains are matched even when there are no exact domains.
+TEST(RouteMatcherTest, WildcardDomainsWithoutExactDomains) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "wildcard",
+      "domains": ["*.foo.com"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "wildcard"
+        }
+      ]
+    },
+    {
+      "name": "default",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "default"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  EXPECT_EQ("wildcard",
+            config.route(genHeaders("www.foo.com", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("foo.com", "/", "GET"), 0)->routeEntry()->clusterName());
+}
+
+// Routes of different kinds must still be checked in configuration order.
+TEST(RouteMatcherTest, MixedRouteOrder) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/foo",
+          "cluster": "foo_with_header",
+          "headers" : [
+            {"name": "test_header", "value": "test"}
+          ]
+        },
+        {
+          "regex": "/foo/.*",
+          "cluster": "foo_regex"
+        },
+        {
+          "path": "/foo/bar",
+          "cluster": "foo_bar_path"
+        },
+        {
+          "path": "/FOO",
+          "case_sensitive": false,
+          "cluster": "foo_path"
+        },
+        {
+          "prefix": "/",
+          "cluster": "default"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  EXPECT_EQ("foo_regex", config.route(genHeaders("www.lyft.com", "/foo/bar", "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+  EXPECT_EQ("foo_path", config.route(genHeaders("www.lyft.com", "/foo?a=b", "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("www.lyft.com", "/fo", "GET"), 0)->routeEntry()->clusterName());
+
+  Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo/bar", "GET");
+  headers.addCopy("test_header", "test");
+  EXPECT_EQ("foo_with_header", config.route(headers, 0)->routeEntry()->clusterName());
+}
+
+// Virtual hosts whose configuration is unchanged are shared with the previous configuration.
+TEST(RouteMatcherTest, ReuseUnchangedVirtualHosts) {
+  const std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "foo",
+      "domains": ["foo.lyft.com"],
+      "routes": [{"prefix": "/", "cluster": "foo"}]
+    },
+    {
+      "name": "bar",
+      "domains": ["bar.lyft.com"],
+      "routes": [{"prefix": "/", "cluster": "bar"}]
+    }
+  ]
+}
+  )EOF";
+
+  const std::string changed_json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "foo",
+      "domains": ["foo.lyft.com"],
+      "routes": [{"prefix": "/", "cluster": "foo"}]
+    },
+    {
+      "name": "bar",
+      "domains": ["bar.lyft.com"],
+      "routes": [{"prefix": "/", "cluster": "baz"}]
+    }
+  ]
+}
+  )EOF";
+
+  const std::string changed_headers_json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "foo",
+      "domains": ["foo.lyft.com"],
+      "routes": [{"prefix": "/", "cluster": "foo"}]
+    },
+    {
+      "name": "bar",
+      "domains": ["bar.lyft.com"],
+      "routes": [{"prefix": "/", "cluster": "baz"}]
+    }
+  ],
+  "request_headers_to_add": [
+    {"key": "x-global-header", "value": "global"}
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  std::unique_ptr<ConfigImpl> config(
+      new ConfigImpl(parseRouteConfigurationFromJson(json), runtime, cm, true));
+  std::unique_ptr<ConfigImpl> changed_config(new ConfigImpl(
+      parseRouteConfigurationFromJson(changed_json), runtime, cm, true, config.get()));
+
+  Http::TestHeaderMapImpl foo_headers = genHeaders("foo.lyft.com", "/", "GET");
+  Http::TestHeaderMapImpl bar_headers = genHeaders("bar.lyft.com", "/", "GET");
+  RouteConstSharedPtr foo_route = config->route(foo_headers, 0);
+  EXPECT_EQ(foo_route, changed_config->route(foo_headers, 0));
+  EXPECT_NE(config->route(bar_headers, 0), changed_config->route(bar_headers, 0));
+  EXPECT_EQ("baz", changed_config->route(bar_headers, 0)->routeEntry()->clusterName());
+
+  // The shared virtual host outlives the configuration that built it.
+  config.reset();
+  EXPECT_EQ("foo", changed_config->route(foo_headers, 0)->routeEntry()->clusterName());
+
+  // A change to the global request headers applies to every virtual host.
+  ConfigImpl changed_headers_config(parseRouteConfigurationFromJson(changed_headers_json), runtime,
+                                    cm, true, changed_config.get());
+  EXPECT_NE(foo_route, changed_headers_config.route(foo_headers, 0));
+  NiceMock<Envoy::Http::AccessLog::MockRequestInfo> request_info;
+  Http::TestHeaderMapImpl headers = genHeaders("foo.lyft.com", "/", "GET");
+  const RouteEntry* route = changed_headers_config.route(headers, 0)->routeEntry();
+  route->finalizeRequestHeaders(headers, request_info);
+  EXPECT_EQ("global", headers.get_("x-global-header"));
+}
+
 TEST(RouteMatcherTest, HeaderMatchedRouting) {
   std::string json = R"EOF(
 {
@@ -1939,6 +2169,7 @@ TEST(RouteMatcherTest, WeightedClusters) {
   // Weighted Cluster with invalid runtime values
   {
     Http::TestHeaderMapImpl headers = genHeaders("www2.lyft.com", "/foo", "GET");
+    ON_CALL(runtime.snapshot_, generation()).WillByDefault(Return(1));
     EXPECT_CALL(runtime.snapshot_, featureEnabled("www2", 100, _)).WillRepeatedly(Return(true));
     EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30))
         .WillRepeatedly(Return(10));
@@ -1954,6 +2185,21 @@ TEST(RouteMatcherTest, WeightedClusters) {
     EXPECT_EQ("cluster2", config.route(headers, 82)->routeEntry()->clusterName());
     EXPECT_EQ("cluster2", config.route(headers, 92)->routeEntry()->clusterName());
   }
+
+  // Weighted Cluster with runtime values which add up to less than 100. The weights are only
+  // looked up once for each runtime snapshot, and the last cluster takes the rest of the range.
+  {
+    Http::TestHeaderMapImpl headers = genHeaders("www2.lyft.com", "/foo", "GET");
+    ON_CALL(runtime.snapshot_, generation()).WillByDefault(Return(2));
+    EXPECT_CALL(runtime.snapshot_, featureEnabled("www2", 100, _)).WillRepeatedly(Return(true));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster1", 30)).WillOnce(Return(10));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster2", 30)).WillOnce(Return(10));
+    EXPECT_CALL(runtime.snapshot_, getInteger("www2_weights.cluster3", 40)).WillOnce(Return(10));
+
+    EXPECT_EQ("cluster2", config.route(headers, 15)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster3", config.route(headers, 25)->routeEntry()->clusterName());
+    EXPECT_EQ("cluster3", config.route(headers, 95)->routeEntry()->clusterName());
+  }
 }
 
 TEST(RouteMatcherTest, ExclusiveWeightedClustersOrClusterConfig) {
@@ -2510,6 +2756,8 @@ TEST(RoutePropertyTest, TestVHostCorsConfig) {
 
   EXPECT_EQ(cors_policy->enabled(), true);
   EXPECT_THAT(cors_policy->allowOrigins(), ElementsAreArray({"test-origin"}));
+  EXPECT_TRUE(cors_policy->allowsOrigin("test-origin"));
+  EXPECT_FALSE(cors_policy->allowsOrigin("test-origin2"));
   EXPECT_EQ(cors_policy->allowMethods(), "test-methods");
   EXPECT_EQ(cors_policy->allowHeaders(), "test-headers");
   EXPECT_EQ(cors_policy->exposeHeaders(), "test-expose-headers");
@@ -2552,6 +2800,8 @@ TEST(RoutePropertyTest, TestRouteCorsConfig) {
 
   EXPECT_EQ(cors_policy->enabled(), true);
   EXPECT_THAT(cors_policy->allowOrigins(), ElementsAreArray({"test-origin"}));
+  EXPECT_TRUE(cors_policy->allowsOrigin("test-origin"));
+  EXPECT_FALSE(cors_policy->allowsOrigin("test-origin2"));
   EXPECT_EQ(cors_policy->allowMethods(), "test-methods");
   EXPECT_EQ(cors_policy->allowHeaders(), "test-headers");
   EXPECT_EQ(cors_policy->exposeHeaders(), "test-expose-headers");
@@ -2559,6 +2809,42 @@ TEST(RoutePropertyTest, TestRouteCorsConfig) {
   EXPECT_EQ(cors_policy->allowCredentials(), true);
 }
 
+TEST(RoutePropertyTest, TestCorsWildcardOrigin) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "default",
+      "domains": ["*"],
+      "cors" : {
+        "allow_origin": ["test-origin", "*"]
+      },
+      "routes": [
+        {
+          "prefix": "/api",
+          "cluster": "ats"
+        }
+      ]
+    }
+  ]
+}
+)EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  const Router::CorsPolicy* cors_policy =
+      config.route(genHeaders("api.lyft.com", "/api", "GET"), 0)
+          ->routeEntry()
+          ->virtualHost()
+          .corsPolicy();
+
+  EXPECT_THAT(cors_policy->allowOrigins(), ElementsAreArray({"test-origin", "*"}));
+  EXPECT_TRUE(cors_policy->allowsOrigin("test-origin"));
+  EXPECT_TRUE(cors_policy->allowsOrigin("any-origin"));
+}
+
 TEST(RoutePropertyTest, TestBadCorsConfig) {
   std::string json = R"EOF(
 {
@@ -35,6 +35,8 @@ TEST(RequestHeaderFormatterTest, TestFormatWithClientIpVariable) {
   RequestHeaderFormatter requestHeaderFormatter(variable);
   const std::string formatted_string = requestHeaderFormatter.format(request_info);
   EXPECT_EQ(downstream_addr, formatted_string);
+  // The value is not copied until it is added to the headers.
+  EXPECT_EQ(&downstream_addr, &requestHeaderFormatter.format(request_info));
 }
 
 TEST(RequestHeaderFormatterTest, TestFormatWithProtocolVariable) {
@@ -121,6 +123,8 @@ TEST(RequestHeaderParserTest, EvaluateStaticHeaders) {
   req_header_parser->evaluateRequestHeaders(headerMap, request_info);
   EXPECT_TRUE(headerMap.has("static-header"));
   EXPECT_EQ("static-value", headerMap.get_("static-header"));
+  EXPECT_EQ(Http::HeaderString::Type::Reference,
+            headerMap.get(Http::LowerCaseString("static-header"))->value().type());
 }
 
 } // namespace Router
@@ -253,6 +253,40 @@ TEST_F(RouterRetryStateImplTest, NoAvailableRetries) {
   EXPECT_EQ(1UL, cluster_.stats().upstream_rq_retry_overflow_.value());
 }
 
+TEST_F(RouterRetryStateImplTest, Hedge) {
+  cluster_.resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 0, 0, 0, 1));
+
+  Http::TestHeaderMapImpl request_headers{{"x-envoy-retry-on", "5xx"},
+                                          {"x-envoy-max-retries", "1"}};
+  setup(request_headers);
+
+  // A request is hedged once at most, and the hedge holds a retry of the circuit breaker.
+  EXPECT_TRUE(state_->shouldHedge());
+  EXPECT_FALSE(state_->shouldHedge());
+  EXPECT_EQ(1UL, cluster_.stats().upstream_rq_hedge_.value());
+  EXPECT_FALSE(cluster_.resourceManager(Upstream::ResourcePriority::Default).retries().canCreate());
+
+  // The hedge used up the only retry.
+  EXPECT_EQ(RetryStatus::No, state_->shouldRetry(nullptr, remote_reset_, callback_));
+  EXPECT_EQ(0UL, cluster_.stats().upstream_rq_retry_overflow_.value());
+
+  state_.reset();
+  EXPECT_TRUE(cluster_.resourceManager(Upstream::ResourcePriority::Default).retries().canCreate());
+}
+
+TEST_F(RouterRetryStateImplTest, HedgeOverflow) {
+  cluster_.resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 0, 0, 0, 0));
+
+  Http::TestHeaderMapImpl request_headers{{"x-envoy-retry-on", "5xx"}};
+  setup(request_headers);
+
+  EXPECT_FALSE(state_->shouldHedge());
+  EXPECT_EQ(0UL, cluster_.stats().upstream_rq_hedge_.value());
+  EXPECT_EQ(1UL, cluster_.stats().upstream_rq_retry_overflow_.value());
+}
+
 TEST_F(RouterRetryStateImplTest, MaxRetriesHeader) {
   Http::TestHeaderMapImpl request_headers{{"x-envoy-retry-on", "connect-failure"},
                                           {"x-envoy-retry-grpc-on", "cancelled"},
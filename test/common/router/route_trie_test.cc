@@ -0,0 +1,152 @@
+#include <string.h>
+#include <strings.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/router/route_trie.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+
+std::vector<uint32_t> candidates(const RouteTrie& trie, const std::string& path) {
+  RouteTrie::Candidates candidates;
+  const size_t query_start = path.find('?');
+  trie.candidates(path.c_str(), path.size(),
+                  query_start == std::string::npos ? path.size() : query_start, candidates);
+  std::vector<uint32_t> result;
+  uint32_t index;
+  while (candidates.next(index)) {
+    result.push_back(index);
+  }
+  return result;
+}
+
+TEST(RouteTrieTest, Empty) {
+  RouteTrie trie;
+  EXPECT_EQ(std::vector<uint32_t>{}, candidates(trie, "/"));
+  EXPECT_EQ(std::vector<uint32_t>{}, candidates(trie, ""));
+}
+
+TEST(RouteTrieTest, Prefix) {
+  RouteTrie trie;
+  trie.addPrefix("/foo/bar", true, 0);
+  trie.addPrefix("/foo", true, 1);
+  trie.addPrefix("/", true, 2);
+  trie.addPrefix("/foobar", true, 3);
+  trie.addPrefix("", true, 4);
+
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2, 4}), candidates(trie, "/foo/bar/baz"));
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 4}), candidates(trie, "/foo/ba"));
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 3, 4}), candidates(trie, "/foobar?a=b"));
+  EXPECT_EQ((std::vector<uint32_t>{2, 4}), candidates(trie, "/fo"));
+  EXPECT_EQ((std::vector<uint32_t>{4}), candidates(trie, "foo"));
+}
+
+TEST(RouteTrieTest, PrefixIncludesQueryString) {
+  RouteTrie trie;
+  trie.addPrefix("/foo?bar", true, 0);
+
+  EXPECT_EQ((std::vector<uint32_t>{0}), candidates(trie, "/foo?bar=baz"));
+  EXPECT_EQ(std::vector<uint32_t>{}, candidates(trie, "/foo?baz"));
+}
+
+TEST(RouteTrieTest, Path) {
+  RouteTrie trie;
+  trie.addPath("/foo", true, 0);
+  trie.addPath("/foo/bar", true, 1);
+  trie.addPath("/", true, 2);
+
+  EXPECT_EQ((std::vector<uint32_t>{0}), candidates(trie, "/foo"));
+  EXPECT_EQ((std::vector<uint32_t>{0}), candidates(trie, "/foo?bar=baz"));
+  EXPECT_EQ((std::vector<uint32_t>{1}), candidates(trie, "/foo/bar"));
+  EXPECT_EQ((std::vector<uint32_t>{2}), candidates(trie, "/?foo"));
+  EXPECT_EQ(std::vector<uint32_t>{}, candidates(trie, "/foo/"));
+  EXPECT_EQ(std::vector<uint32_t>{}, candidates(trie, "/fo"));
+}
+
+TEST(RouteTrieTest, CaseInsensitive) {
+  RouteTrie trie;
+  trie.addPrefix("/Foo", false, 0);
+  trie.addPath("/FOO/bar", false, 1);
+  trie.addPrefix("/Foo", true, 2);
+
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), candidates(trie, "/foo/BAR"));
+  EXPECT_EQ((std::vector<uint32_t>{0, 2}), candidates(trie, "/Foo/baz"));
+  EXPECT_EQ(std::vector<uint32_t>{}, candidates(trie, "/fo"));
+}
+
+TEST(RouteTrieTest, CatchAll) {
+  RouteTrie trie;
+  trie.addPrefix("/foo", true, 0);
+  trie.addCatchAll(1);
+  trie.addPath("/bar", true, 2);
+  trie.addCatchAll(3);
+
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 3}), candidates(trie, "/foo"));
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 3}), candidates(trie, "/bar"));
+  EXPECT_EQ((std::vector<uint32_t>{1, 3}), candidates(trie, "/baz"));
+}
+
+// Compare against a linear scan over randomly generated routes and paths drawn from a small
+// alphabet so that keys share prefixes and edges get split.
+TEST(RouteTrieTest, MatchesLinearScan) {
+  struct Route {
+    std::string key_;
+    bool prefix_;
+    bool case_sensitive_;
+  };
+
+  std::mt19937 random(1);
+  const std::string alphabet = "/aB?";
+  auto random_string = [&](size_t max_length) -> std::string {
+    std::string value;
+    const size_t length = random() % (max_length + 1);
+    for (size_t i = 0; i < length; i++) {
+      value.push_back(alphabet[random() % alphabet.size()]);
+    }
+    return value;
+  };
+
+  std::vector<Route> routes;
+  RouteTrie trie;
+  for (uint32_t i = 0; i < 500; i++) {
+    Route route{random_string(6), random() % 2 == 0, random() % 2 == 0};
+    if (route.prefix_) {
+      trie.addPrefix(route.key_, route.case_sensitive_, i);
+    } else {
+      trie.addPath(route.key_, route.case_sensitive_, i);
+    }
+    routes.push_back(route);
+  }
+
+  for (uint32_t i = 0; i < 2000; i++) {
+    const std::string path = random_string(8);
+    const size_t query_start = path.find('?');
+    const size_t path_length = query_start == std::string::npos ? path.size() : query_start;
+
+    std::vector<uint32_t> expected;
+    for (uint32_t j = 0; j < routes.size(); j++) {
+      const Route& route = routes[j];
+      const size_t length = route.prefix_ ? route.key_.size() : path_length;
+      if ((!route.prefix_ && route.key_.size() != path_length) || route.key_.size() > path.size()) {
+        continue;
+      }
+      const int result = route.case_sensitive_
+                             ? strncmp(path.c_str(), route.key_.c_str(), length)
+                             : strncasecmp(path.c_str(), route.key_.c_str(), length);
+      if (result == 0) {
+        expected.push_back(j);
+      }
+    }
+
+    EXPECT_EQ(expected, candidates(trie, path)) << path;
+  }
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -45,6 +45,7 @@ public:
                                  Upstream::ResourcePriority) override {
     EXPECT_EQ(nullptr, retry_state_);
     retry_state_ = new NiceMock<MockRetryState>();
+    ON_CALL(*retry_state_, enabled()).WillByDefault(Return(retry_enabled_));
     return RetryStatePtr{retry_state_};
   }
 
@@ -54,6 +55,7 @@ public:
 
   NiceMock<Network::MockConnection> downstream_connection_;
   MockRetryState* retry_state_{};
+  bool retry_enabled_{};
 };
 
 class RouterTestBase : public testing::Test {
@@ -154,7 +156,7 @@ TEST_F(RouterTest, ClusterNotFound) {
 TEST_F(RouterTest, PoolFailureWithPriority) {
   ON_CALL(callbacks_.route_->route_entry_, priority())
       .WillByDefault(Return(Upstream::ResourcePriority::High));
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, Upstream::ResourcePriority::High, &router_));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(Upstream::ResourcePriority::High, &router_));
 
   EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
       .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
@@ -186,13 +188,12 @@ TEST_F(RouterTest, HashPolicy) {
       .WillByDefault(Return(&callbacks_.route_->route_entry_.hash_policy_));
   EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
       .WillOnce(Return(Optional<uint64_t>(10)));
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(10UL, context->computeHashKey().value());
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(10UL, context->computeHashKey().value());
+        return &cm_.conn_pool_;
+      }));
   EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
   expectResponseTimerCreate();
 
@@ -211,13 +212,12 @@ TEST_F(RouterTest, HashPolicyNoHash) {
       .WillByDefault(Return(&callbacks_.route_->route_entry_.hash_policy_));
   EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
       .WillOnce(Return(Optional<uint64_t>()));
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, &router_))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(false, context->computeHashKey().valid());
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, &router_))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(false, context->computeHashKey().valid());
+        return &cm_.conn_pool_;
+      }));
   EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
   expectResponseTimerCreate();
 
@@ -245,13 +245,12 @@ TEST_F(RouterTest, AddCookie) {
         return &cancellable_;
       }));
 
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(10UL, context->computeHashKey().value());
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(10UL, context->computeHashKey().value());
+        return &cm_.conn_pool_;
+      }));
 
   std::string cookie_value;
   EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
@@ -292,13 +291,12 @@ TEST_F(RouterTest, AddCookieNoDuplicate) {
         return &cancellable_;
       }));
 
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(10UL, context->computeHashKey().value());
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(10UL, context->computeHashKey().value());
+        return &cm_.conn_pool_;
+      }));
 
   EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
       .WillOnce(Invoke([&](const std::string&, const Http::HeaderMap&,
@@ -339,13 +337,12 @@ TEST_F(RouterTest, AddMultipleCookies) {
         return &cancellable_;
       }));
 
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(10UL, context->computeHashKey().value());
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(10UL, context->computeHashKey().value());
+        return &cm_.conn_pool_;
+      }));
 
   std::string choco_c, foo_c;
   EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
@@ -388,14 +385,13 @@ TEST_F(RouterTest, MetadataMatchCriteria) {
 
   ON_CALL(callbacks_.route_->route_entry_, metadataMatchCriteria())
       .WillByDefault(Return(&callbacks_.route_->route_entry_.metadata_matches_criteria_));
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(context->metadataMatchCriteria(),
-                      &callbacks_.route_->route_entry_.metadata_matches_criteria_);
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(context->metadataMatchCriteria(),
+                  &callbacks_.route_->route_entry_.metadata_matches_criteria_);
+        return &cm_.conn_pool_;
+      }));
   EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
   expectResponseTimerCreate();
 
@@ -410,13 +406,12 @@ TEST_F(RouterTest, MetadataMatchCriteria) {
 
 TEST_F(RouterTest, NoMetadataMatchCriteria) {
   ON_CALL(callbacks_.route_->route_entry_, metadataMatchCriteria()).WillByDefault(Return(nullptr));
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
-      .WillOnce(
-          Invoke([&](const std::string&, Upstream::ResourcePriority,
-                     Upstream::LoadBalancerContext* context) -> Http::ConnectionPool::Instance* {
-            EXPECT_EQ(context->metadataMatchCriteria(), nullptr);
-            return &cm_.conn_pool_;
-          }));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _))
+      .WillOnce(Invoke([&](Upstream::ResourcePriority, Upstream::LoadBalancerContext* context)
+                           -> Http::ConnectionPool::Instance* {
+        EXPECT_EQ(context->metadataMatchCriteria(), nullptr);
+        return &cm_.conn_pool_;
+      }));
   EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
   expectResponseTimerCreate();
 
@@ -444,7 +439,7 @@ TEST_F(RouterTest, CancelBeforeBoundToPool) {
 }
 
 TEST_F(RouterTest, NoHost) {
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).WillOnce(Return(nullptr));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _)).WillOnce(Return(nullptr));
 
   Http::TestHeaderMapImpl response_headers{
       {":status", "503"}, {"content-length", "19"}, {"content-type", "text/plain"}};
@@ -949,7 +944,7 @@ TEST_F(RouterTest, RetryNoneHealthy) {
   EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
   encoder1.stream_.resetStream(Http::StreamResetReason::LocalReset);
 
-  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).WillOnce(Return(nullptr));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _)).WillOnce(Return(nullptr));
   Http::TestHeaderMapImpl response_headers{
       {":status", "503"}, {"content-length", "19"}, {"content-type", "text/plain"}};
   EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
@@ -1000,6 +995,39 @@ TEST_F(RouterTest, RetryUpstreamReset) {
   EXPECT_TRUE(verifyHostUpstreamStats(1, 1));
 }
 
+TEST_F(RouterTest, RetryAfterClusterRemoved) {
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  // The cluster is looked up by name once while no cluster on this worker changes.
+  ON_CALL(cm_, threadLocalGeneration()).WillByDefault(Return(1));
+  EXPECT_CALL(cm_, get(_));
+  Http::TestHeaderMapImpl headers{{"x-envoy-retry-on", "5xx"}, {"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  router_.retry_state_->expectRetry();
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
+  encoder1.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+
+  // The cluster is removed before the retry, so it is looked up again and not found.
+  ON_CALL(cm_, threadLocalGeneration()).WillByDefault(Return(2));
+  EXPECT_CALL(cm_, get(_)).WillOnce(Return(nullptr));
+  EXPECT_CALL(cm_.thread_local_cluster_, httpConnPool(_, _)).Times(0);
+  Http::TestHeaderMapImpl response_headers{
+      {":status", "503"}, {"content-length", "19"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  router_.retry_state_->callback_();
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
+}
+
 TEST_F(RouterTest, RetryUpstreamPerTryTimeout) {
   NiceMock<Http::MockStreamEncoder> encoder1;
   Http::StreamDecoder* response_decoder = nullptr;
@@ -1199,6 +1227,140 @@ TEST_F(RouterTest, RetryTimeoutDuringRetryDelayWithUpstreamRequestNoHost) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
 }
 
+// The hedged request responds first: it becomes the upstream request, and the original request is
+// cancelled.
+TEST_F(RouterTest, HedgeWins) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("upstream.use_hedging", 0))
+      .WillByDefault(Return(true));
+  router_.retry_enabled_ = true;
+  EXPECT_CALL(cm_.thread_local_cluster_.response_times_, responseTimeQuantile(0.95))
+      .WillOnce(Return(Optional<std::chrono::milliseconds>(std::chrono::milliseconds(10))));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  // Timers match in reverse order of creation: the response timer is created first.
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableTimer(std::chrono::milliseconds(10)));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(*router_.retry_state_, shouldHedge()).WillOnce(Return(true));
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder2, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  EXPECT_CALL(encoder2, encodeHeaders(_, true));
+  hedge_timer->callback_();
+
+  // The response time of a hedged request is not tracked, as it includes the hedge delay.
+  EXPECT_CALL(encoder1.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(encoder2.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(cm_.thread_local_cluster_.response_times_, recordResponseTime(_)).Times(0);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_win")
+                    .value());
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+// The original request fails while the hedged request is outstanding: the hedged request carries
+// on alone, without a retry.
+TEST_F(RouterTest, HedgeOriginalReset) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("upstream.use_hedging", 0))
+      .WillByDefault(Return(true));
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.hedge_percentile", 95)).WillByDefault(Return(99));
+  router_.retry_enabled_ = true;
+  EXPECT_CALL(cm_.thread_local_cluster_.response_times_, responseTimeQuantile(0.99))
+      .WillOnce(Return(Optional<std::chrono::milliseconds>(std::chrono::milliseconds(20))));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  Event::MockTimer* hedge_timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timer, enableTimer(std::chrono::milliseconds(20)));
+  EXPECT_CALL(*hedge_timer, disableTimer());
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(*router_.retry_state_, shouldHedge()).WillOnce(Return(true));
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder2, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  hedge_timer->callback_();
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetry(_, _, _)).Times(0);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
+  encoder1.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetry(_, _, _)).WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(200));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_win")
+                    .value());
+}
+
+// Without enough response times to estimate a hedge delay, the request is not hedged, and its
+// response time is tracked.
+TEST_F(RouterTest, HedgeNoEstimate) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("upstream.use_hedging", 0))
+      .WillByDefault(Return(true));
+  router_.retry_enabled_ = true;
+  EXPECT_CALL(cm_.thread_local_cluster_.response_times_, responseTimeQuantile(0.95));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(cm_.thread_local_cluster_.response_times_, recordResponseTime(_));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+}
+
 TEST_F(RouterTest, RetryUpstream5xxNotComplete) {
   NiceMock<Http::MockStreamEncoder> encoder1;
   Http::StreamDecoder* response_decoder = nullptr;
@@ -1836,6 +1998,74 @@ TEST_F(WatermarkTest, RetryRequestNotComplete) {
   encoder1.stream_.resetStream(Http::StreamResetReason::RemoteReset);
 }
 
+// The body is buffered for retries up to the retry buffer limit only, and keeps streaming
+// upstream without retries past it.
+TEST_F(WatermarkTest, RetryBufferLimit) {
+  EXPECT_CALL(callbacks_, decoderBufferLimit()).WillOnce(Return(100));
+  router_.setDecoderFilterCallbacks(callbacks_);
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.retry_buffer_limit_bytes", 100))
+      .WillOnce(Return(10));
+  router_.retry_enabled_ = true;
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  EXPECT_CALL(callbacks_.request_info_,
+              setResponseFlag(Http::AccessLog::ResponseFlag::UpstreamRemoteReset));
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-retry-on", "5xx"}, {"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+
+  // Under the limit, the body is both buffered and sent upstream.
+  Buffer::OwnedImpl data1("12345");
+  EXPECT_CALL(encoder1, encodeData(BufferStringEqual("12345"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, router_.decodeData(data1, false));
+
+  // Past the limit, the request can no longer be retried but keeps streaming.
+  Buffer::OwnedImpl buffered("12345");
+  ON_CALL(callbacks_, decodingBuffer()).WillByDefault(Return(&buffered));
+  Buffer::OwnedImpl data2("678901");
+  EXPECT_CALL(encoder1, encodeData(BufferStringEqual("678901"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(data2, false));
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("retry_or_shadow_abandoned")
+                    .value());
+
+  // The retry state has been deleted, so the reset is not retried.
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
+  encoder1.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+}
+
+// A request whose content-length is over the retry buffer limit is not retried at all.
+TEST_F(WatermarkTest, RetryBufferLimitContentLength) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.retry_buffer_limit_bytes", 0))
+      .WillOnce(Return(10));
+  router_.retry_enabled_ = true;
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+
+  Http::TestHeaderMapImpl headers{
+      {"x-envoy-retry-on", "5xx"}, {"x-envoy-internal", "true"}, {"content-length", "11"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("retry_or_shadow_abandoned")
+                    .value());
+
+  Buffer::OwnedImpl data("12345678901");
+  EXPECT_CALL(encoder1, encodeData(BufferStringEqual("12345678901"), true));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(data, true));
+}
+
 class RouterTestChildSpan : public RouterTestBase {
 public:
   RouterTestChildSpan() : RouterTestBase(true) {}
@@ -4,6 +4,7 @@
 #include "common/http/headers.h"
 #include "common/http/message_impl.h"
 #include "common/router/shadow_writer_impl.h"
+#include "common/upstream/resource_manager_impl.h"
 
 #include "test/mocks/upstream/mocks.h"
 
@@ -59,5 +60,30 @@ TEST(ShadowWriterImplTest, All) {
   callback->onFailure(Http::AsyncClient::FailureReason::Reset);
 }
 
+TEST(ShadowWriterImplTest, Overflow) {
+  Upstream::MockClusterManager cm;
+  ShadowWriterImpl writer(cm);
+  Upstream::MockClusterInfo& info = *cm.thread_local_cluster_.cluster_.info_;
+
+  // No requests left in the shadow cluster.
+  info.resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(info.runtime_, "fake_key", 1, 1024, 0, 1));
+  Http::MessagePtr message(new Http::RequestMessageImpl());
+  message->headers().insertHost().value(std::string("cluster1"));
+  EXPECT_CALL(cm, get("foo"));
+  EXPECT_CALL(cm, httpAsyncClientForCluster(_)).Times(0);
+  writer.shadow("foo", std::move(message), std::chrono::milliseconds(5));
+  EXPECT_EQ(1U, info.stats_store_.counter("upstream_rq_shadow_overflow").value());
+
+  // No pending requests left in the shadow cluster.
+  info.resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(info.runtime_, "fake_key", 1, 0, 1024, 1));
+  message.reset(new Http::RequestMessageImpl());
+  message->headers().insertHost().value(std::string("cluster1"));
+  EXPECT_CALL(cm, get("foo"));
+  writer.shadow("foo", std::move(message), std::chrono::milliseconds(5));
+  EXPECT_EQ(2U, info.stats_store_.counter("upstream_rq_shadow_overflow").value());
+}
+
 } // namespace Router
 } // namespace Envoy
@@ -1,6 +1,13 @@
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <chrono>
+#include <fstream>
 #include <memory>
 #include <string>
 
+#include "common/runtime/key_registry.h"
 #include "common/runtime/runtime_impl.h"
 #include "common/stats/stats_impl.h"
 
@@ -18,6 +25,7 @@ using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::ReturnNew;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -52,6 +60,29 @@ TEST(UUID, checkLengthOfUUID) {
   EXPECT_EQ(expected_length, result.length());
 }
 
+TEST(UUID, checkFormatOfUUID) {
+  RandomGeneratorImpl random;
+
+  for (size_t i = 0; i < 1000; ++i) {
+    char result[RandomGenerator::UUID_LENGTH + 1];
+    result[RandomGenerator::UUID_LENGTH] = 'x';
+    random.uuid(result);
+    // Nothing is written past the uuid.
+    EXPECT_EQ('x', result[RandomGenerator::UUID_LENGTH]);
+
+    for (size_t j = 0; j < RandomGenerator::UUID_LENGTH; ++j) {
+      if (j == 8 || j == 13 || j == 18 || j == 23) {
+        EXPECT_EQ('-', result[j]);
+      } else {
+        const char c = result[j];
+        EXPECT_TRUE((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))
+            << std::string(result, RandomGenerator::UUID_LENGTH);
+      }
+    }
+    EXPECT_EQ('4', result[14]);
+  }
+}
+
 TEST(UUID, sanityCheckOfUniqueness) {
   std::set<std::string> uuids;
   const size_t num_of_uuids = 100000;
@@ -129,6 +160,137 @@ TEST_F(RuntimeImplTest, All) {
   EXPECT_EQ("hello override", loader->snapshot().get("file1"));
 }
 
+TEST_F(RuntimeImplTest, RegisteredKeys) {
+  const Key& file3 = KeyRegistry::registerKey("file3");
+  const Key& subdir_file3 = KeyRegistry::registerKey("subdir.file3");
+  const Key& invalid = KeyRegistry::registerKey("invalid");
+  EXPECT_EQ(&file3, &KeyRegistry::registerKey("file3"));
+  EXPECT_EQ("file3", KeyRegistry::keys()[file3.index_]);
+
+  setup();
+  run("test/common/runtime/test_data/current", "envoy_override");
+
+  EXPECT_EQ(2UL, loader->snapshot().getInteger(file3, 1));
+  EXPECT_EQ(1UL, loader->snapshot().getInteger(subdir_file3, 1));
+  EXPECT_EQ(1UL, loader->snapshot().getInteger(invalid, 1));
+
+  EXPECT_CALL(generator, random()).WillOnce(Return(1));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file3, 1));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file3, 1, 1));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(file3, 1, 3));
+
+  // A key registered after the snapshot was loaded is looked up by name.
+  const Key& file4 = KeyRegistry::registerKey("file4");
+  const Key& late_invalid = KeyRegistry::registerKey("late_invalid");
+  EXPECT_EQ(123UL, loader->snapshot().getInteger(file4, 1));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(file4, 1, 200, 300));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file4, 1, 122, 300));
+  EXPECT_EQ(1UL, loader->snapshot().getInteger(late_invalid, 1));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(late_invalid, 0));
+}
+
+// Files which are still the same, unmodified, file after the symlink is swapped are not read again.
+TEST_F(RuntimeImplTest, ReloadReusesUnchangedFiles) {
+  const std::string v1 = TestEnvironment::temporaryPath("test/common/runtime/reload/v1");
+  const std::string v2 = TestEnvironment::temporaryPath("test/common/runtime/reload/v2");
+  const std::string current = TestEnvironment::temporaryPath("test/common/runtime/reload/current");
+  TestEnvironment::writeStringToFileForTest("test/common/runtime/reload/v1/envoy/file1", "1");
+  TestEnvironment::writeStringToFileForTest("test/common/runtime/reload/v1/envoy/file2", "2");
+  unlink(current.c_str());
+  ASSERT_EQ(0, symlink(v1.c_str(), current.c_str()));
+
+  Filesystem::MockWatcher* watcher = new Filesystem::MockWatcher();
+  Filesystem::Watcher::OnChangedCb on_changed;
+  EXPECT_CALL(dispatcher, createFilesystemWatcher_()).WillOnce(Return(watcher));
+  EXPECT_CALL(*watcher, addWatch(current, _, _)).WillOnce(SaveArg<2>(&on_changed));
+  os_sys_calls_ = new NiceMock<Api::MockOsSysCalls>;
+  ON_CALL(*os_sys_calls_, stat(_, _))
+      .WillByDefault(
+          Invoke([](const char* filename, struct stat* stat) { return ::stat(filename, stat); }));
+  run("test/common/runtime/reload/current", "envoy_override");
+  EXPECT_EQ(1UL, loader->snapshot().getInteger("file1", 0));
+  const uint64_t generation = loader->snapshot().generation();
+  EXPECT_TRUE(loader->snapshot().hasKeyWithPrefix("file"));
+  EXPECT_FALSE(loader->snapshot().hasKeyWithPrefix("file3"));
+
+  // The next tree links to file1 of the previous tree. Rewriting file1 without changing its size or
+  // modification time shows that it is not read again.
+  const std::string file1 = v1 + "/envoy/file1";
+  struct stat file1_stat;
+  ASSERT_EQ(0, ::stat(file1.c_str(), &file1_stat));
+  TestEnvironment::writeStringToFileForTest("test/common/runtime/reload/v2/envoy/file2", "22");
+  TestEnvironment::writeStringToFileForTest("test/common/runtime/reload/v2/envoy/file3", "3");
+  unlink((v2 + "/envoy/file1").c_str());
+  ASSERT_EQ(0, link(file1.c_str(), (v2 + "/envoy/file1").c_str()));
+  {
+    std::ofstream out(file1);
+    out << "5";
+  }
+  struct utimbuf times;
+  times.actime = file1_stat.st_atime;
+  times.modtime = file1_stat.st_mtime;
+  ASSERT_EQ(0, utime(file1.c_str(), &times));
+
+  unlink(current.c_str());
+  ASSERT_EQ(0, symlink(v2.c_str(), current.c_str()));
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, loader->snapshot().getInteger("file1", 0));
+  EXPECT_EQ(22UL, loader->snapshot().getInteger("file2", 0));
+  EXPECT_EQ(3UL, loader->snapshot().getInteger("file3", 0));
+  EXPECT_EQ(3UL, store.gauge("runtime.num_keys").value());
+  EXPECT_LT(generation, loader->snapshot().generation());
+  EXPECT_TRUE(loader->snapshot().hasKeyWithPrefix("file3"));
+
+  // Loading the same tree again shares the layer of the previous snapshot.
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, loader->snapshot().getInteger("file1", 0));
+  EXPECT_EQ(3UL, loader->snapshot().getInteger("file3", 0));
+}
+
+// With a quiet period, swaps in quick succession are loaded once the link has been left alone.
+TEST_F(RuntimeImplTest, ReloadQuietPeriod) {
+  const std::string v1 = TestEnvironment::temporaryPath("test/common/runtime/quiet/v1");
+  const std::string v2 = TestEnvironment::temporaryPath("test/common/runtime/quiet/v2");
+  const std::string current = TestEnvironment::temporaryPath("test/common/runtime/quiet/current");
+  for (const std::string version : {"v1", "v2"}) {
+    TestEnvironment::writeStringToFileForTest(
+        "test/common/runtime/quiet/" + version + "/envoy/runtime/reload_quiet_period_ms", "100");
+    TestEnvironment::writeStringToFileForTest(
+        "test/common/runtime/quiet/" + version + "/envoy/file1", version == "v1" ? "1" : "2");
+  }
+  unlink(current.c_str());
+  ASSERT_EQ(0, symlink(v1.c_str(), current.c_str()));
+
+  Filesystem::MockWatcher* watcher = new Filesystem::MockWatcher();
+  Filesystem::Watcher::OnChangedCb on_changed;
+  EXPECT_CALL(dispatcher, createFilesystemWatcher_()).WillOnce(Return(watcher));
+  EXPECT_CALL(*watcher, addWatch(current, _, _)).WillOnce(SaveArg<2>(&on_changed));
+  os_sys_calls_ = new NiceMock<Api::MockOsSysCalls>;
+  ON_CALL(*os_sys_calls_, stat(_, _))
+      .WillByDefault(
+          Invoke([](const char* filename, struct stat* stat) { return ::stat(filename, stat); }));
+  run("test/common/runtime/quiet/current", "envoy_override");
+  EXPECT_EQ(1UL, loader->snapshot().getInteger("file1", 0));
+
+  Event::MockTimer* timer = new Event::MockTimer(&dispatcher);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(100))).Times(2);
+  unlink(current.c_str());
+  ASSERT_EQ(0, symlink(v2.c_str(), current.c_str()));
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, loader->snapshot().getInteger("file1", 0));
+  EXPECT_EQ(1UL, store.counter("runtime.load_coalesced").value());
+
+  timer->callback_();
+  EXPECT_EQ(2UL, loader->snapshot().getInteger("file1", 0));
+  EXPECT_EQ(2UL, store.counter("runtime.load_success").value());
+
+  // The next swap restarts the quiet period without counting as coalesced.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(100)));
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, store.counter("runtime.load_coalesced").value());
+}
+
 TEST_F(RuntimeImplTest, BadDirectory) {
   setup();
   run("/baddir", "/baddir");
@@ -155,6 +317,13 @@ TEST(NullRuntimeImplTest, All) {
   EXPECT_EQ(1UL, loader.snapshot().getInteger("foo", 1));
   EXPECT_CALL(generator, random()).WillOnce(Return(49));
   EXPECT_TRUE(loader.snapshot().featureEnabled("foo", 50));
+  EXPECT_EQ(0UL, loader.snapshot().generation());
+  EXPECT_FALSE(loader.snapshot().hasKeyWithPrefix(""));
+
+  const Key& key = KeyRegistry::registerKey("foo");
+  EXPECT_EQ(1UL, loader.snapshot().getInteger(key, 1));
+  EXPECT_TRUE(loader.snapshot().featureEnabled(key, 50, 49));
+  EXPECT_FALSE(loader.snapshot().featureEnabled(key, 50, 50));
 }
 
 } // namespace Runtime
@@ -33,6 +33,19 @@ TEST(UUIDUtilsTest, mod) {
 
   EXPECT_TRUE(UuidUtils::uuidModBy("ffffffff-0012-0110-00ff-0c00400600ff", result, 10000));
   EXPECT_EQ(7295, result);
+
+  EXPECT_TRUE(UuidUtils::uuidModBy("FFFFFFFF-0012-0110-00ff-0c00400600ff", result, 10000));
+  EXPECT_EQ(7295, result);
+
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000000g-0000-0000-0000-000000000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000-000-0000-0000-0000-000000000000", result, 100));
+
+  // Only the first 8 chars are looked at, so that they can be parsed in place from a header.
+  const char* uuid = "000000ff-0000-0000-0000-000000000000";
+  EXPECT_TRUE(UuidUtils::uuidModBy(uuid, 8, result, 100));
+  EXPECT_EQ(55, result);
+  EXPECT_FALSE(UuidUtils::uuidModBy(uuid, 7, result, 100));
 }
 
 TEST(UUIDUtilsTest, checkDistribution) {
@@ -91,4 +104,19 @@ TEST(UUIDUtilsTest, setAndCheckTraceable) {
   std::string invalid_uuid = "";
   EXPECT_FALSE(UuidUtils::setTraceableUuid(invalid_uuid, UuidTraceStatus::Forced));
 }
+
+TEST(UUIDUtilsTest, setAndCheckTraceableBuffer) {
+  Runtime::RandomGeneratorImpl random;
+
+  char uuid[Runtime::RandomGenerator::UUID_LENGTH];
+  random.uuid(uuid);
+  EXPECT_EQ(UuidTraceStatus::NoTrace, UuidUtils::isTraceableUuid(uuid, sizeof(uuid)));
+
+  EXPECT_TRUE(UuidUtils::setTraceableUuid(uuid, sizeof(uuid), UuidTraceStatus::Sampled));
+  EXPECT_EQ(UuidTraceStatus::Sampled, UuidUtils::isTraceableUuid(uuid, sizeof(uuid)));
+
+  EXPECT_FALSE(UuidUtils::setTraceableUuid(uuid, sizeof(uuid) - 1, UuidTraceStatus::Forced));
+  EXPECT_EQ(UuidTraceStatus::NoTrace, UuidUtils::isTraceableUuid(uuid, sizeof(uuid) - 1));
+  EXPECT_EQ(UuidTraceStatus::Sampled, UuidUtils::isTraceableUuid(uuid, sizeof(uuid)));
+}
 } // namespace Envoy
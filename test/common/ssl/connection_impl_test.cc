@@ -28,6 +28,7 @@
 #include "openssl/ssl.h"
 
 using testing::Invoke;
+using testing::Return;
 using testing::StrictMock;
 using testing::_;
 
@@ -36,15 +37,13 @@ namespace Ssl {
 
 namespace {
 
-void testUtil(const std::string& client_ctx_json, const std::string& server_ctx_json,
+void testUtil(const std::string& client_ctx_json, ServerContextConfig& server_ctx_config,
               const std::string& expected_digest, const std::string& expected_uri,
               const std::string& expected_stats, bool expect_success,
               const Network::Address::IpVersion version) {
   Stats::IsolatedStoreImpl stats_store;
   Runtime::MockLoader runtime;
 
-  Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
-  ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
   ContextManagerImpl manager(runtime);
   ServerContextPtr server_ctx(manager.createSslServerContext(stats_store, server_ctx_config));
 
@@ -76,8 +75,11 @@ void testUtil(const std::string& client_ctx_json, const std::string& server_ctx_
         .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
           if (!expected_digest.empty()) {
             EXPECT_EQ(expected_digest, server_connection->ssl()->sha256PeerCertificateDigest());
+            // Later calls return the value cached by the first.
+            EXPECT_EQ(expected_digest, server_connection->ssl()->sha256PeerCertificateDigest());
           }
           EXPECT_EQ(expected_uri, server_connection->ssl()->uriSanPeerCertificate());
+          EXPECT_EQ(expected_uri, server_connection->ssl()->uriSanPeerCertificate());
           server_connection->close(Network::ConnectionCloseType::NoFlush);
           client_connection->close(Network::ConnectionCloseType::NoFlush);
           dispatcher.exit();
@@ -98,6 +100,34 @@ void testUtil(const std::string& client_ctx_json, const std::string& server_ctx_
   }
 }
 
+void testUtil(const std::string& client_ctx_json, const std::string& server_ctx_json,
+              const std::string& expected_digest, const std::string& expected_uri,
+              const std::string& expected_stats, bool expect_success,
+              const Network::Address::IpVersion version) {
+  Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
+  ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
+  testUtil(client_ctx_json, server_ctx_config, expected_digest, expected_uri, expected_stats,
+           expect_success, version);
+}
+
+// A server with a default certificate and one picked by the server name of the client.
+envoy::api::v2::DownstreamTlsContext sniServerConfig() {
+  envoy::api::v2::DownstreamTlsContext config;
+  envoy::api::v2::TlsCertificate* default_cert =
+      config.mutable_common_tls_context()->add_tls_certificates();
+  default_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_cert.pem"));
+  default_cert->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_key.pem"));
+  envoy::api::v2::TlsCertificate* sni_cert =
+      config.mutable_common_tls_context()->add_tls_certificates();
+  sni_cert->mutable_certificate_chain()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_wildcard_dns_cert.pem"));
+  sni_cert->mutable_private_key()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_wildcard_dns_key.pem"));
+  return config;
+}
+
 } // namespace
 
 class SslConnectionImplTest : public SslCertsTest,
@@ -106,6 +136,35 @@ class SslConnectionImplTest : public SslCertsTest,
 INSTANTIATE_TEST_CASE_P(IpVersions, SslConnectionImplTest,
                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
 
+// The certificate the client verifies is the one for the name it indicates.
+TEST_P(SslConnectionImplTest, SniCertificate) {
+  std::string client_ctx_json = R"EOF(
+  {
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem",
+    "verify_subject_alt_name": [ "server.wildcard.example.com" ],
+    "sni": "server.wildcard.example.com"
+  }
+  )EOF";
+
+  ServerContextConfigImpl server_ctx_config(sniServerConfig());
+  testUtil(client_ctx_json, server_ctx_config, "", "", "ssl.sni_certificate_selected", true,
+           GetParam());
+}
+
+// Without a certificate for the name the client indicates, the server presents the default one.
+TEST_P(SslConnectionImplTest, SniCertificateNoMatch) {
+  std::string client_ctx_json = R"EOF(
+  {
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem",
+    "verify_subject_alt_name": [ "server.wildcard.example.com" ],
+    "sni": "server1.example.com"
+  }
+  )EOF";
+
+  ServerContextConfigImpl server_ctx_config(sniServerConfig());
+  testUtil(client_ctx_json, server_ctx_config, "", "", "ssl.fail_verify_san", false, GetParam());
+}
+
 TEST_P(SslConnectionImplTest, GetCertDigest) {
   std::string client_ctx_json = R"EOF(
   {
@@ -406,7 +465,8 @@ namespace {
 void testTicketSessionResumption(const std::string& server_ctx_json1,
                                  const std::string& server_ctx_json2,
                                  const std::string& client_ctx_json, bool expect_reuse,
-                                 const Network::Address::IpVersion ip_version) {
+                                 const Network::Address::IpVersion ip_version,
+                                 bool client_tickets = true) {
   Stats::IsolatedStoreImpl stats_store;
   Runtime::MockLoader runtime;
 
@@ -436,6 +496,12 @@ void testTicketSessionResumption(const std::string& server_ctx_json1,
   Network::ClientConnectionPtr client_connection = dispatcher.createSslClientConnection(
       *client_ctx, socket1.localAddress(), Network::Address::InstanceConstSharedPtr());
 
+  if (!client_tickets) {
+    // The server can only resume the session by its ID.
+    SSL_set_options(dynamic_cast<Ssl::ConnectionImpl*>(client_connection->ssl())->rawSslForTest(),
+                    SSL_OP_NO_TICKET);
+  }
+
   Network::MockConnectionCallbacks client_connection_callbacks;
   client_connection->addConnectionCallbacks(client_connection_callbacks);
   client_connection->connect();
@@ -469,6 +535,9 @@ void testTicketSessionResumption(const std::string& server_ctx_json1,
       dynamic_cast<Ssl::ConnectionImpl*>(client_connection->ssl());
   SSL_set_session(ssl_connection->rawSslForTest(), ssl_session);
   SSL_SESSION_free(ssl_session);
+  if (!client_tickets) {
+    SSL_set_options(ssl_connection->rawSslForTest(), SSL_OP_NO_TICKET);
+  }
 
   client_connection->connect();
 
@@ -502,6 +571,9 @@ void testTicketSessionResumption(const std::string& server_ctx_json1,
 
   // One for client, one for server
   EXPECT_EQ(expect_reuse ? 2UL : 0UL, stats_store.counter("ssl.session_reused").value());
+  if (!client_tickets) {
+    EXPECT_EQ(1UL, stats_store.counter("ssl.session_cache_hit").value());
+  }
 }
 } // namespace
 
@@ -667,6 +739,50 @@ TEST_P(SslConnectionImplTest, TicketSessionResumptionDifferentServerCertDifferen
                               GetParam());
 }
 
+// Sessions are resumed by ID on a listener other than the one which created them, as all the
+// server contexts of a manager share a session cache.
+TEST_P(SslConnectionImplTest, IdSessionResumption) {
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem"
+  }
+  )EOF";
+
+  std::string client_ctx_json = R"EOF(
+  {
+  }
+  )EOF";
+
+  testTicketSessionResumption(server_ctx_json, server_ctx_json, client_ctx_json, true, GetParam(),
+                              false);
+}
+
+// Sessions found by ID are not resumed when the SANs of the server certificates are not identical.
+TEST_P(SslConnectionImplTest, IdSessionResumptionDifferentServerCertDifferentSAN) {
+  std::string server_ctx_json1 = R"EOF(
+  {
+    "cert_chain_file": "{{ test_rundir }}/test/common/ssl/test_data/san_dns_cert.pem",
+    "private_key_file": "{{ test_rundir }}/test/common/ssl/test_data/san_dns_key.pem"
+  }
+  )EOF";
+
+  std::string server_ctx_json2 = R"EOF(
+  {
+    "cert_chain_file": "{{ test_rundir }}/test/common/ssl/test_data/san_multiple_dns_cert.pem",
+    "private_key_file": "{{ test_rundir }}/test/common/ssl/test_data/san_multiple_dns_key.pem"
+  }
+  )EOF";
+
+  std::string client_ctx_json = R"EOF(
+  {
+  }
+  )EOF";
+
+  testTicketSessionResumption(server_ctx_json1, server_ctx_json2, client_ctx_json, false,
+                              GetParam(), false);
+}
+
 // Test that if two listeners use the same cert and session ticket key, but
 // different client CA, that sessions cannot be resumed.
 TEST_P(SslConnectionImplTest, ClientAuthCrossListenerSessionResumption) {
@@ -1033,6 +1149,20 @@ TEST_P(SslReadBufferLimitTest, SomeLimit) {
   readBufferLimitTest(32 * 1024, 32 * 1024, 256 * 1024, 1, false);
 }
 
+// Whether or not the kernel running the test supports TLS, the data gets through intact.
+TEST_P(SslReadBufferLimitTest, KernelTlsTx) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("ssl.kernel_tls_tx", 0)).WillByDefault(Return(true));
+  readBufferLimitTest(0, 256 * 1024, 256 * 1024, 1, false);
+}
+
+// The server signs on the private key thread pool while its handshake waits.
+TEST_P(SslReadBufferLimitTest, AsyncPrivateKey) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("ssl.async_private_key", 0))
+      .WillByDefault(Return(true));
+  readBufferLimitTest(0, 256 * 1024, 256 * 1024, 1, false);
+  EXPECT_EQ(1UL, stats_store_.counter("ssl.async_private_key").value());
+}
+
 TEST_P(SslReadBufferLimitTest, WritesSmallerThanBufferLimit) { singleWriteTest(5 * 1024, 1024); }
 
 TEST_P(SslReadBufferLimitTest, WritesLargerThanBufferLimit) { singleWriteTest(1024, 5 * 1024); }
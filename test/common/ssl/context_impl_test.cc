@@ -1,6 +1,7 @@
 #include <string>
 #include <vector>
 
+#include "common/filesystem/filesystem_impl.h"
 #include "common/json/json_loader.h"
 #include "common/ssl/context_config_impl.h"
 #include "common/ssl/context_impl.h"
@@ -9,6 +10,7 @@
 #include "test/common/ssl/ssl_certs_test.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -168,6 +170,31 @@ TEST_F(SslContextImplTest, TestNoCert) {
   EXPECT_EQ("", context->getCertChainInformation());
 }
 
+TEST_F(SslContextImplTest, LoadCertificatesShared) {
+  Runtime::MockLoader runtime;
+  ContextManagerImpl manager(runtime);
+  const std::string path =
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/ca_certificates.pem");
+
+  CertificateListConstSharedPtr certificates = manager.loadCertificates(path);
+  EXPECT_EQ(2U, certificates->size());
+  EXPECT_EQ(certificates, manager.loadCertificates(path));
+
+  // Files are shared by their contents, not their paths.
+  const std::string copy_path = TestEnvironment::writeStringToFileForTest(
+      "ca_certificates_copy.pem", Filesystem::fileReadToEnd(path));
+  EXPECT_EQ(certificates, manager.loadCertificates(copy_path));
+
+  // Once no context holds the certificates they are parsed again.
+  certificates.reset();
+  EXPECT_EQ(2U, manager.loadCertificates(path)->size());
+
+  EXPECT_THROW_WITH_MESSAGE(manager.loadCertificates("/does/not/exist.pem"), EnvoyException,
+                            "Failed to load certificate '/does/not/exist.pem'");
+  const std::string empty_path = TestEnvironment::writeStringToFileForTest("empty.pem", "");
+  EXPECT_THROW(manager.loadCertificates(empty_path), EnvoyException);
+}
+
 class SslServerContextImplTicketTest : public SslContextImplTest {
 public:
   static void loadConfig(ServerContextConfigImpl& cfg) {
@@ -0,0 +1,88 @@
+#include <string>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/ssl/sni_certificate_store.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Ssl {
+
+namespace {
+ServerContextConfig::TlsCertificate testCertificate(const std::string& name) {
+  return {TestEnvironment::runfilesPath("test/common/ssl/test_data/" + name + "_cert.pem"),
+          TestEnvironment::runfilesPath("test/common/ssl/test_data/" + name + "_key.pem")};
+}
+
+std::vector<uint8_t> testSessionContext(X509*) { return {1, 2, 3}; }
+} // namespace
+
+TEST(SniCertificateStoreTest, ExactAndWildcardNames) {
+  SniCertificateStore store({testCertificate("san_multiple_dns"), testCertificate("san_dns"),
+                             testCertificate("san_wildcard_dns")},
+                            16, testSessionContext);
+  EXPECT_EQ(0U, store.numLoaded());
+
+  // The first certificate with a name is picked, whatever the case of the name.
+  SniCertificateStore::CertificateConstSharedPtr server1 = store.find("server1.example.com");
+  ASSERT_NE(nullptr, server1);
+  EXPECT_EQ(server1, store.find("SERVER2.example.com"));
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), server1->session_context_);
+  EXPECT_NE(nullptr, server1->key_);
+  EXPECT_EQ(1U, store.numLoaded());
+
+  SniCertificateStore::CertificateConstSharedPtr wildcard = store.find("a.wildcard.example.com");
+  ASSERT_NE(nullptr, wildcard);
+  EXPECT_NE(server1, wildcard);
+  EXPECT_EQ(nullptr, store.find("wildcard.example.com"));
+  EXPECT_EQ(nullptr, store.find("a.b.wildcard.example.com"));
+  EXPECT_EQ(nullptr, store.find("server3.example.com"));
+  EXPECT_EQ(nullptr, store.find("localhost"));
+  EXPECT_EQ(2U, store.numLoaded());
+}
+
+TEST(SniCertificateStoreTest, CommonNameWithoutSubjectAltNames) {
+  SniCertificateStore store({testCertificate("no_san")}, 16, testSessionContext);
+  EXPECT_NE(nullptr, store.find("Test Server"));
+}
+
+TEST(SniCertificateStoreTest, LeastRecentlyUsedUnloaded) {
+  SniCertificateStore store({testCertificate("san_dns"), testCertificate("san_wildcard_dns")}, 1,
+                            testSessionContext);
+  SniCertificateStore::CertificateConstSharedPtr server1 = store.find("server1.example.com");
+  ASSERT_NE(nullptr, server1);
+  EXPECT_EQ(server1, store.find("server1.example.com"));
+
+  // Certificates in use stay valid when unloaded, and are loaded again on the next match.
+  EXPECT_NE(nullptr, store.find("a.wildcard.example.com"));
+  EXPECT_EQ(1U, store.numLoaded());
+  EXPECT_NE(nullptr, server1->cert_);
+  SniCertificateStore::CertificateConstSharedPtr reloaded = store.find("server1.example.com");
+  ASSERT_NE(nullptr, reloaded);
+  EXPECT_NE(server1, reloaded);
+  EXPECT_EQ(1U, store.numLoaded());
+}
+
+TEST(SniCertificateStoreTest, BadCertificates) {
+  EXPECT_THROW_WITH_MESSAGE(
+      SniCertificateStore({testCertificate("san_uri")}, 16, testSessionContext), EnvoyException,
+      "Certificate '" + testCertificate("san_uri").cert_chain_file_ +
+          "' has no DNS name to be picked by");
+  EXPECT_THROW(SniCertificateStore({testCertificate("missing")}, 16, testSessionContext),
+               EnvoyException);
+
+  // A key which does not match the certificate is only found out when loading it.
+  ServerContextConfig::TlsCertificate mismatched = testCertificate("san_dns");
+  mismatched.private_key_file_ = testCertificate("san_uri").private_key_file_;
+  SniCertificateStore store({mismatched}, 16, testSessionContext);
+  EXPECT_EQ(nullptr, store.find("server1.example.com"));
+  EXPECT_EQ(0U, store.numLoaded());
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -10,6 +10,7 @@ set -e
 # openssl genrsa -out san_dns_key2.pem 1024
 # openssl genrsa -out san_multiple_dns_key.pem 1024
 # openssl genrsa -out san_uri_key.pem 1024
+# openssl genrsa -out san_wildcard_dns_key.pem 1024
 # openssl genrsa -out selfsigned_key.pem 1024
 
 # Generate ca_cert.pem.
@@ -47,6 +48,10 @@ openssl x509 -req -days 730 -in san_only_dns_cert.csr -sha256 -CA ca_cert.pem -C
 openssl req -new -key san_uri_key.pem -out san_uri_cert.csr -config san_uri_cert.cfg -batch -sha256
 openssl x509 -req -days 730 -in san_uri_cert.csr -sha256 -CA ca_cert.pem -CAkey ca_key.pem -CAcreateserial -out san_uri_cert.pem -extensions v3_ca -extfile san_uri_cert.cfg
 
+# Generate san_wildcard_dns_cert.pem.
+openssl req -new -key san_wildcard_dns_key.pem -out san_wildcard_dns_cert.csr -config san_wildcard_dns_cert.cfg -batch -sha256
+openssl x509 -req -days 730 -in san_wildcard_dns_cert.csr -sha256 -CA ca_cert.pem -CAkey ca_key.pem -CAcreateserial -out san_wildcard_dns_cert.pem -extensions v3_ca -extfile san_wildcard_dns_cert.cfg
+
 # Generate selfsigned_cert.pem.
 openssl req -new -x509 -days 730 -key selfsigned_key.pem -out selfsigned_cert.pem -config selfsigned_cert.cfg -batch -sha256
 
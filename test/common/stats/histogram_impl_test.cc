@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/stats/histogram_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(HistogramBucketsTest, Bounds) {
+  for (uint64_t value = 0; value < 8; value++) {
+    EXPECT_EQ(value, HistogramBuckets::index(value));
+  }
+  EXPECT_EQ(8, HistogramBuckets::index(8));
+  EXPECT_EQ(9, HistogramBuckets::index(9));
+  EXPECT_EQ(15, HistogramBuckets::index(15));
+  EXPECT_EQ(16, HistogramBuckets::index(16));
+  EXPECT_EQ(16, HistogramBuckets::index(17));
+  EXPECT_EQ(HistogramBuckets::NUM_BUCKETS - 1,
+            HistogramBuckets::index(std::numeric_limits<uint64_t>::max()));
+
+  // Buckets are contiguous and each value lies within the bounds of its bucket.
+  EXPECT_EQ(0, HistogramBuckets::lowerBound(0));
+  for (uint32_t index = 1; index < HistogramBuckets::NUM_BUCKETS; index++) {
+    EXPECT_EQ(HistogramBuckets::upperBound(index - 1) + 1, HistogramBuckets::lowerBound(index));
+    EXPECT_EQ(index, HistogramBuckets::index(HistogramBuckets::lowerBound(index)));
+    EXPECT_EQ(index, HistogramBuckets::index(HistogramBuckets::upperBound(index)));
+  }
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+            HistogramBuckets::upperBound(HistogramBuckets::NUM_BUCKETS - 1));
+}
+
+TEST(HistogramStatisticsImplTest, Empty) {
+  HistogramStatisticsImpl statistics;
+  EXPECT_EQ(0, statistics.sampleCount());
+  for (double value : statistics.computedQuantiles()) {
+    EXPECT_TRUE(std::isnan(value));
+  }
+
+  statistics.refresh(std::vector<uint64_t>(HistogramBuckets::NUM_BUCKETS), 0);
+  EXPECT_EQ(0, statistics.sampleCount());
+  EXPECT_TRUE(std::isnan(statistics.computedQuantiles()[0]));
+  EXPECT_EQ("P0: nan, P25: nan, P50: nan, P75: nan, P90: nan, P95: nan, P99: nan, P99.9: nan, "
+            "P100: nan",
+            statistics.summary());
+}
+
+TEST(HistogramStatisticsImplTest, ExactValues) {
+  ThreadLocalHistogramImpl histogram;
+  for (uint64_t value : {1, 2, 3, 4}) {
+    histogram.recordValue(value);
+  }
+
+  std::vector<uint64_t> buckets(HistogramBuckets::NUM_BUCKETS);
+  uint64_t sum = 0;
+  histogram.drain(buckets, sum);
+  HistogramStatisticsImpl statistics;
+  statistics.refresh(buckets, sum);
+  EXPECT_EQ(4, statistics.sampleCount());
+  EXPECT_EQ(10, statistics.sampleSum());
+  EXPECT_EQ("P0: 1, P25: 1, P50: 2, P75: 3, P90: 4, P95: 4, P99: 4, P99.9: 4, P100: 4",
+            statistics.summary());
+
+  // Drained values are not seen again.
+  std::vector<uint64_t> empty(HistogramBuckets::NUM_BUCKETS);
+  sum = 0;
+  histogram.drain(empty, sum);
+  EXPECT_EQ(std::vector<uint64_t>(HistogramBuckets::NUM_BUCKETS), empty);
+  EXPECT_EQ(0, sum);
+}
+
+// Quantiles of uniformly distributed values are within the width of a bucket of the real value.
+TEST(HistogramStatisticsImplTest, Accuracy) {
+  std::mt19937_64 random(1);
+  std::vector<uint64_t> values;
+  ThreadLocalHistogramImpl histogram;
+  for (uint32_t i = 0; i < 100000; i++) {
+    values.push_back(random() % 10000);
+    histogram.recordValue(values.back());
+  }
+  std::sort(values.begin(), values.end());
+
+  std::vector<uint64_t> buckets(HistogramBuckets::NUM_BUCKETS);
+  uint64_t sum = 0;
+  histogram.drain(buckets, sum);
+  HistogramStatisticsImpl statistics;
+  statistics.refresh(buckets, sum);
+
+  for (size_t i = 0; i < statistics.supportedQuantiles().size(); i++) {
+    const double quantile = statistics.supportedQuantiles()[i];
+    const double expected =
+        values[std::min<size_t>(values.size() - 1, quantile * values.size())];
+    EXPECT_NEAR(expected, statistics.computedQuantiles()[i], expected / 8 + 1) << quantile;
+  }
+}
+
+// Values recorded while another thread drains are counted exactly once.
+TEST(ThreadLocalHistogramImplTest, ConcurrentDrain) {
+  ThreadLocalHistogramImpl histogram;
+  const uint64_t num_values = 100000;
+  std::thread recorder([&histogram, num_values]() -> void {
+    for (uint64_t i = 0; i < num_values; i++) {
+      histogram.recordValue(i % 100);
+    }
+  });
+
+  std::vector<uint64_t> buckets(HistogramBuckets::NUM_BUCKETS);
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    histogram.drain(buckets, sum);
+  }
+  recorder.join();
+  histogram.drain(buckets, sum);
+
+  uint64_t count = 0;
+  for (uint64_t bucket : buckets) {
+    count += bucket;
+  }
+  EXPECT_EQ(num_values, count);
+  EXPECT_EQ(num_values / 100 * 4950, sum);
+}
+
+} // namespace Stats
+} // namespace Envoy
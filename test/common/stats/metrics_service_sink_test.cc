@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/stats/histogram_impl.h"
+#include "common/stats/metrics_service_sink.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/grpc/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/stats/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Stats {
+namespace MetricsService {
+
+typedef Grpc::MockAsyncClient<envoy::metrics::StreamMetricsMessage,
+                              envoy::metrics::StreamMetricsResponse>
+    MockMetricsServiceAsyncClient;
+
+class MetricsServiceSinkTest : public testing::Test {
+public:
+  MetricsServiceSinkTest()
+      : async_client_(new MockMetricsServiceAsyncClient()),
+        sink_(MetricsServiceAsyncClientPtr{async_client_}, local_info_, time_source_,
+              stats_store_) {
+    ON_CALL(time_source_, currentTime())
+        .WillByDefault(Return(SystemTime(std::chrono::milliseconds(1234))));
+  }
+
+  MockMetricsServiceAsyncClient* async_client_;
+  Grpc::MockAsyncStream<envoy::metrics::StreamMetricsMessage> async_stream_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<MockSystemTimeSource> time_source_;
+  IsolatedStoreImpl stats_store_;
+  MetricsServiceSink sink_;
+};
+
+// Each flush is sent as a single message on a stream which is kept for later flushes.
+TEST_F(MetricsServiceSinkTest, Flush) {
+  NiceMock<MockCounter> counter;
+  counter.name_ = "test_counter";
+  NiceMock<MockGauge> gauge;
+  gauge.name_ = "test_gauge";
+  NiceMock<MockParentHistogram> histogram;
+  histogram.name_ = "test_histogram";
+  NiceMock<MockParentHistogram> unused_histogram;
+  unused_histogram.name_ = "unused_histogram";
+  std::vector<uint64_t> buckets(HistogramBuckets::NUM_BUCKETS);
+  buckets[HistogramBuckets::index(5)] = 2;
+  histogram.interval_statistics_.refresh(buckets, 10);
+
+  envoy::metrics::StreamMetricsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  sink_.beginFlush();
+  sink_.flushCounter(counter, 3);
+  sink_.flushGauge(gauge, 7);
+  sink_.flushHistogram(histogram);
+  sink_.flushHistogram(unused_histogram);
+  sink_.endFlush();
+
+  EXPECT_EQ(local_info_.nodeName(), message.identifier().node_id());
+  EXPECT_EQ(local_info_.clusterName(), message.identifier().cluster());
+  EXPECT_EQ(1234U, message.timestamp_ms());
+  ASSERT_EQ(3, message.metrics_size());
+  EXPECT_EQ("test_counter", message.metrics(0).name());
+  EXPECT_EQ(envoy::metrics::Metric::COUNTER, message.metrics(0).type());
+  EXPECT_EQ(3U, message.metrics(0).value());
+  EXPECT_EQ("test_gauge", message.metrics(1).name());
+  EXPECT_EQ(envoy::metrics::Metric::GAUGE, message.metrics(1).type());
+  EXPECT_EQ(7U, message.metrics(1).value());
+  EXPECT_EQ("test_histogram", message.metrics(2).name());
+  EXPECT_EQ(envoy::metrics::Metric::HISTOGRAM, message.metrics(2).type());
+  EXPECT_EQ(2U, message.metrics(2).sample_count());
+  EXPECT_EQ(10U, message.metrics(2).sample_sum());
+  EXPECT_EQ(histogram.interval_statistics_.supportedQuantiles().size(),
+            static_cast<size_t>(message.metrics(2).quantiles_size()));
+  EXPECT_EQ(1U, stats_store_.counter("metrics_service.flushes_sent").value());
+
+  // The identifier is only sent on the first message of a stream.
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  sink_.beginFlush();
+  sink_.flushCounter(counter, 1);
+  sink_.endFlush();
+  EXPECT_FALSE(message.has_identifier());
+  EXPECT_EQ(1, message.metrics_size());
+  EXPECT_EQ(2U, stats_store_.counter("metrics_service.flushes_sent").value());
+}
+
+// A flush which cannot start a stream is dropped, and a stream is started again once the previous
+// one is closed.
+TEST_F(MetricsServiceSinkTest, StreamFailure) {
+  NiceMock<MockCounter> counter;
+  counter.name_ = "test_counter";
+
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(nullptr));
+  sink_.beginFlush();
+  sink_.flushCounter(counter, 1);
+  sink_.endFlush();
+  EXPECT_EQ(1U, stats_store_.counter("metrics_service.flushes_dropped").value());
+
+  envoy::metrics::StreamMetricsMessage message;
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  sink_.beginFlush();
+  sink_.flushCounter(counter, 2);
+  sink_.endFlush();
+  ASSERT_EQ(1, message.metrics_size());
+  EXPECT_EQ(2U, message.metrics(0).value());
+
+  sink_.onRemoteClose(Grpc::Status::Internal, "bad");
+  EXPECT_EQ(1U, stats_store_.counter("metrics_service.stream_failures").value());
+
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  sink_.beginFlush();
+  sink_.endFlush();
+  EXPECT_TRUE(message.has_identifier());
+}
+
+} // namespace MetricsService
+} // namespace Stats
+} // namespace Envoy
@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <chrono>
+#include <thread>
+#include <vector>
 
 #include "envoy/stats/stats_macros.h"
 
@@ -53,6 +55,136 @@ TEST(StatsIsolatedStoreImplTest, All) {
   EXPECT_EQ(2UL, store.gauges().size());
 }
 
+TEST(StatsIsolatedStoreImplTest, DirtyCounters) {
+  IsolatedStoreImpl store;
+  Counter& c1 = store.counter("c1");
+  Counter& c2 = store.counter("c2");
+  store.counter("c3");
+  EXPECT_TRUE(store.dirtyCounters().empty());
+
+  c1.inc();
+  c1.inc();
+  c2.add(5);
+  std::list<CounterSharedPtr> dirty = store.dirtyCounters();
+  ASSERT_EQ(2UL, dirty.size());
+  EXPECT_EQ(&c1, dirty.front().get());
+  EXPECT_EQ(&c2, dirty.back().get());
+  EXPECT_TRUE(store.dirtyCounters().empty());
+
+  // A counter is dirty again after its next increment.
+  c2.inc();
+  dirty = store.dirtyCounters();
+  ASSERT_EQ(1UL, dirty.size());
+  EXPECT_EQ(&c2, dirty.front().get());
+}
+
+TEST(StatsIsolatedStoreImplTest, ShardedCounters) {
+  CounterImpl::configureForTestsOnly(4);
+  IsolatedStoreImpl store;
+  Counter& counter = store.counter("c1");
+  CounterImpl::configureForTestsOnly(1);
+  EXPECT_FALSE(counter.used());
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < 8; i++) {
+    threads.emplace_back([&counter]() {
+      for (uint32_t j = 0; j < 1000; j++) {
+        counter.inc();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(counter.used());
+  EXPECT_EQ(8000U, counter.value());
+  ASSERT_EQ(1UL, store.dirtyCounters().size());
+
+  // The shards are folded into the value when the counter is latched.
+  EXPECT_EQ(8000U, counter.latch());
+  EXPECT_EQ(8000U, counter.value());
+  EXPECT_EQ(0U, counter.latch());
+
+  counter.add(5);
+  EXPECT_EQ(8005U, counter.value());
+  counter.reset();
+  EXPECT_EQ(0U, counter.value());
+  EXPECT_EQ(5U, counter.latch());
+}
+
+class TestStatsBlock : public StatsBlock {
+public:
+  explicit TestStatsBlock(const std::string& prefix) : prefix_(prefix) {}
+
+  // Stats::StatsBlock
+  const std::string& prefix() const override { return prefix_; }
+  void forEachCounter(const std::function<void(Counter&)>& cb) override {
+    cb(c1_);
+    cb(c2_);
+  }
+  void forEachGauge(const std::function<void(Gauge&)>& cb) override { cb(g1_); }
+
+  PrimitiveCounter c1_{"c1"};
+  PrimitiveCounter c2_{"c2"};
+  PrimitiveGauge g1_{"g1"};
+
+private:
+  const std::string prefix_;
+};
+
+TEST(StatsIsolatedStoreImplTest, StatsBlock) {
+  IsolatedStoreImpl store;
+  store.counter("c1");
+  auto block = std::make_shared<TestStatsBlock>("block.");
+  store.addStatsBlock(block);
+
+  std::list<CounterSharedPtr> counters = store.counters();
+  ASSERT_EQ(3UL, counters.size());
+  EXPECT_EQ("block.c1", (*std::next(counters.begin()))->name());
+  EXPECT_EQ("block.c2", counters.back()->name());
+  EXPECT_EQ("block.c2", counters.back()->tagExtractedName());
+  std::list<GaugeSharedPtr> gauges = store.gauges();
+  ASSERT_EQ(1UL, gauges.size());
+  EXPECT_EQ("block.g1", gauges.front()->name());
+
+  // The listed stats are views of the block's.
+  counters.back()->inc();
+  EXPECT_EQ(1U, block->c2_.value());
+  block->g1_.set(5);
+  EXPECT_EQ(5U, gauges.front()->value());
+
+  // Only the incremented counters are dirty, and latching the listed counter returns the
+  // increments taken when it was listed.
+  block->c2_.add(2);
+  std::list<CounterSharedPtr> dirty = store.dirtyCounters();
+  ASSERT_EQ(1UL, dirty.size());
+  EXPECT_EQ("block.c2", dirty.front()->name());
+  block->c2_.inc();
+  EXPECT_EQ(4U, dirty.front()->latch());
+  EXPECT_TRUE(store.dirtyCounters().empty());
+
+  // A newer block with the same prefix takes over the listing, but the increments of both are
+  // flushed.
+  auto newer_block = std::make_shared<TestStatsBlock>("block.");
+  store.addStatsBlock(newer_block);
+  newer_block->c1_.add(3);
+  block->c1_.inc();
+  counters = store.counters();
+  ASSERT_EQ(3UL, counters.size());
+  EXPECT_EQ(3U, (*std::next(counters.begin()))->value());
+  counters.clear();
+  EXPECT_EQ(2UL, store.dirtyCounters().size());
+
+  // The listed stats keep their block alive, which otherwise leaves the store when released.
+  block.reset();
+  newer_block.reset();
+  EXPECT_EQ(5U, gauges.front()->value());
+  gauges.clear();
+  dirty.clear();
+  EXPECT_EQ(1UL, store.counters().size());
+  EXPECT_TRUE(store.gauges().empty());
+}
+
 /**
  * Test stats macros. @see stats_macros.h
  */
@@ -83,6 +215,41 @@ TEST(StatsMacros, All) {
   EXPECT_EQ("test.test_histogram", histogram.name());
 }
 
+TEST(ShardedPrimitiveGaugeTest, All) {
+  ShardedPrimitiveGauge::configureForTestsOnly(4);
+  ShardedPrimitiveGauge gauge("rq_active");
+  ShardedPrimitiveGauge::configureForTestsOnly(1);
+  EXPECT_EQ("rq_active", gauge.name());
+  EXPECT_FALSE(gauge.used());
+
+  // Each thread decrements what another incremented, so the shards go below zero but not the sum.
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < 8; i++) {
+    threads.emplace_back([&gauge, i]() {
+      for (uint32_t j = 0; j < 1000; j++) {
+        if (i % 2 == 0) {
+          gauge.inc();
+        } else {
+          gauge.add(2);
+          gauge.sub(3);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(gauge.used());
+  EXPECT_EQ(0U, gauge.value());
+
+  gauge.add(5);
+  EXPECT_EQ(5U, gauge.value());
+  gauge.set(2);
+  EXPECT_EQ(2U, gauge.value());
+  gauge.dec();
+  EXPECT_EQ(1U, gauge.value());
+}
+
 TEST(TagExtractorTest, TwoSubexpressions) {
   TagExtractorImpl tag_extractor("cluster_name", "^cluster\\.((.+?)\\.)");
   std::string name = "cluster.test_cluster.upstream_cx_total";
@@ -105,6 +272,42 @@ TEST(TagExtractorTest, SingleSubexpression) {
   EXPECT_EQ("listner_port", tags.at(0).name_);
 }
 
+TEST(TagExtractorTest, LiteralPrefix) {
+  bool anchored;
+  EXPECT_EQ("cluster.", TagExtractorImpl::literalPrefix("^cluster\\.((.+?)\\.)", anchored));
+  EXPECT_TRUE(anchored);
+  EXPECT_EQ("http", TagExtractorImpl::literalPrefix("^http(?:\\..*?)??\\.fault", anchored));
+  EXPECT_TRUE(anchored);
+  EXPECT_EQ("_rq", TagExtractorImpl::literalPrefix("_rq(_(\\d{3}))$", anchored));
+  EXPECT_FALSE(anchored);
+
+  // Characters which may be absent or repeated end the literal.
+  EXPECT_EQ("ab", TagExtractorImpl::literalPrefix("^abc?d", anchored));
+  EXPECT_EQ("ab", TagExtractorImpl::literalPrefix("^abc*d", anchored));
+  EXPECT_EQ("ab", TagExtractorImpl::literalPrefix("^abc{0,2}d", anchored));
+  EXPECT_EQ("abc", TagExtractorImpl::literalPrefix("^abc+d", anchored));
+
+  // Nothing is required of the subject when the regex starts with a group, a class or an escape
+  // other than of punctuation, or has a top level alternation.
+  EXPECT_EQ("", TagExtractorImpl::literalPrefix("^(?:|listener(?:\\..*?)??\\.)http", anchored));
+  EXPECT_EQ("", TagExtractorImpl::literalPrefix("^\\d+", anchored));
+  EXPECT_EQ("", TagExtractorImpl::literalPrefix("^[ab]c", anchored));
+  EXPECT_EQ("", TagExtractorImpl::literalPrefix("^abc|def", anchored));
+  EXPECT_EQ("abc", TagExtractorImpl::literalPrefix("^abc(d|e)[|]", anchored));
+}
+
+TEST(TagExtractorTest, UnanchoredLiteral) {
+  TagExtractorImpl tag_extractor("response_code", "_rq(_(\\d{3}))$");
+  std::vector<Tag> tags;
+  EXPECT_EQ("cluster.foo.upstream_cx_total",
+            tag_extractor.extractTag("cluster.foo.upstream_cx_total", tags));
+  EXPECT_EQ(0, tags.size());
+  EXPECT_EQ("cluster.foo.upstream_rq",
+            tag_extractor.extractTag("cluster.foo.upstream_rq_200", tags));
+  ASSERT_EQ(1, tags.size());
+  EXPECT_EQ("200", tags.at(0).value_);
+}
+
 TEST(TagExtractorTest, EmptyName) {
   EXPECT_THROW_WITH_MESSAGE(TagExtractorImpl::createTagExtractor("", "^listener\\.(\\d+?\\.)"),
                             EnvoyException, "tag_name cannot be empty");
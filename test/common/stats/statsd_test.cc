@@ -1,7 +1,9 @@
 #include <chrono>
 #include <memory>
+#include <vector>
 
 #include "common/network/utility.h"
+#include "common/stats/histogram_impl.h"
 #include "common/stats/statsd.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -94,6 +96,38 @@ TEST_F(TcpStatsdSinkTest, BasicFlow) {
   tls_.shutdownThread();
 }
 
+TEST_F(TcpStatsdSinkTest, Histogram) {
+  InSequence s;
+  NiceMock<MockParentHistogram> histogram;
+  histogram.name_ = "test_histogram";
+
+  // Nothing is written for a histogram which recorded no values during the interval.
+  sink_->beginFlush();
+  sink_->flushHistogram(histogram);
+  expectCreateConnection();
+  EXPECT_CALL(*connection_, write(BufferStringEqual("")));
+  sink_->endFlush();
+
+  std::vector<uint64_t> buckets(HistogramBuckets::NUM_BUCKETS);
+  buckets[HistogramBuckets::index(5)] = 2;
+  histogram.interval_statistics_.refresh(buckets, 10);
+  sink_->beginFlush();
+  sink_->flushHistogram(histogram);
+  EXPECT_CALL(*connection_, write(BufferStringEqual("envoy.test_histogram.p0:5|g\n"
+                                                    "envoy.test_histogram.p25:5|g\n"
+                                                    "envoy.test_histogram.p50:5|g\n"
+                                                    "envoy.test_histogram.p75:5|g\n"
+                                                    "envoy.test_histogram.p90:5|g\n"
+                                                    "envoy.test_histogram.p95:5|g\n"
+                                                    "envoy.test_histogram.p99:5|g\n"
+                                                    "envoy.test_histogram.p99_9:5|g\n"
+                                                    "envoy.test_histogram.p100:5|g\n")));
+  sink_->endFlush();
+
+  EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::NoFlush));
+  tls_.shutdownThread();
+}
+
 TEST_F(TcpStatsdSinkTest, BufferReallocate) {
   InSequence s;
 
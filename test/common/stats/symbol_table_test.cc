@@ -0,0 +1,82 @@
+#include <string>
+#include <vector>
+
+#include "common/stats/symbol_table.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(SymbolTableTest, EncodeDecode) {
+  SymbolTable table;
+  const std::vector<std::string> names{"cluster.foo.upstream_rq_200",
+                                       "cluster.bar.upstream_rq_200",
+                                       "",
+                                       ".",
+                                       "a..b.",
+                                       "listener.127.0.0.1_80.downstream_cx_total"};
+  std::vector<StatName> stat_names;
+  for (const std::string& name : names) {
+    stat_names.push_back(table.encode(name));
+  }
+
+  for (size_t i = 0; i < names.size(); i++) {
+    EXPECT_EQ(names[i], table.decode(stat_names[i]));
+  }
+
+  for (StatName& stat_name : stat_names) {
+    table.free(stat_name);
+    EXPECT_TRUE(stat_name.empty());
+  }
+  EXPECT_EQ(0, table.size());
+}
+
+TEST(SymbolTableTest, SharedSegments) {
+  SymbolTable table;
+  StatName foo = table.encode("cluster.foo.upstream_rq_200");
+  StatName bar = table.encode("cluster.bar.upstream_rq_200");
+  StatName baz = table.encode("cluster.bar.upstream_rq_200");
+  EXPECT_EQ(4, table.size());
+
+  table.free(bar);
+  EXPECT_EQ(4, table.size());
+  table.free(baz);
+  EXPECT_EQ(3, table.size());
+
+  // The symbol of "bar" is reused for the next new segment.
+  StatName qux = table.encode("cluster.qux");
+  EXPECT_EQ(4, table.size());
+  EXPECT_EQ("cluster.qux", table.decode(qux));
+  EXPECT_EQ("cluster.foo.upstream_rq_200", table.decode(foo));
+
+  table.free(foo);
+  table.free(qux);
+  EXPECT_EQ(0, table.size());
+}
+
+// Symbols and segment counts which take more than one varint byte.
+TEST(SymbolTableTest, ManySymbols) {
+  SymbolTable table;
+  std::vector<StatName> stat_names;
+  for (uint32_t i = 0; i < 1000; i++) {
+    stat_names.push_back(table.encode("stat." + std::to_string(i)));
+  }
+
+  std::string long_name;
+  for (uint32_t i = 0; i < 200; i++) {
+    long_name += std::to_string(i * 1000) + ".";
+  }
+  StatName long_stat_name = table.encode(long_name);
+  EXPECT_EQ(long_name, table.decode(long_stat_name));
+
+  for (uint32_t i = 0; i < 1000; i++) {
+    EXPECT_EQ("stat." + std::to_string(i), table.decode(stat_names[i]));
+    table.free(stat_names[i]);
+  }
+  table.free(long_stat_name);
+  EXPECT_EQ(0, table.size());
+}
+
+} // namespace Stats
+} // namespace Envoy
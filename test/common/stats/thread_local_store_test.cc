@@ -1,7 +1,11 @@
 #include <chrono>
+#include <cmath>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "common/common/c_smart_ptr.h"
 #include "common/stats/thread_local_store.h"
@@ -11,6 +15,7 @@
 #include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -33,6 +38,7 @@ public:
   ~TestAllocator() { EXPECT_TRUE(stats_.empty()); }
 
   RawStatData* alloc(const std::string& name) override {
+    std::unique_lock<std::mutex> lock(lock_);
     CSmartPtr<RawStatData, freeAdapter>& stat_ref = stats_[name];
     if (!stat_ref) {
       stat_ref.reset(static_cast<RawStatData*>(::calloc(RawStatData::size(), 1)));
@@ -45,6 +51,7 @@ public:
   }
 
   void free(RawStatData& data) override {
+    std::unique_lock<std::mutex> lock(lock_);
     if (--data.ref_count_ > 0) {
       return;
     }
@@ -61,6 +68,7 @@ public:
 
 private:
   static void freeAdapter(RawStatData* data) { ::free(data); }
+  std::mutex lock_;
   std::unordered_map<std::string, CSmartPtr<RawStatData, freeAdapter>> stats_;
 };
 
@@ -102,7 +110,6 @@ TEST_F(StatsThreadLocalStoreTest, NoTls) {
 
   Histogram& h1 = store_->histogram("h1");
   EXPECT_EQ(&h1, &store_->histogram("h1"));
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 200));
   h1.recordValue(200);
   EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 100));
   store_->deliverHistogramToSinks(h1, 100);
@@ -113,6 +120,16 @@ TEST_F(StatsThreadLocalStoreTest, NoTls) {
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(2L, store_->gauges().front().use_count());
+  EXPECT_EQ(1UL, store_->histograms().size());
+
+  // Without threading the value goes to the histogram's own buckets, which are merged the same way.
+  ParentHistogramSharedPtr parent_h1 = store_->histograms().front();
+  EXPECT_FALSE(parent_h1->used());
+  parent_h1->merge();
+  EXPECT_TRUE(parent_h1->used());
+  EXPECT_EQ(1UL, parent_h1->cumulativeStatistics().sampleCount());
+  EXPECT_EQ(200UL, parent_h1->cumulativeStatistics().sampleSum());
+  parent_h1.reset();
 
   // Includes overflow stat.
   EXPECT_CALL(*this, free(_)).Times(3);
@@ -176,12 +193,12 @@ TEST_F(StatsThreadLocalStoreTest, BasicScope) {
   Histogram& h2 = scope1->histogram("h2");
   EXPECT_EQ("h1", h1.name());
   EXPECT_EQ("scope1.h2", h2.name());
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 100));
   h1.recordValue(100);
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h2), 200));
   h2.recordValue(200);
 
   store_->shutdownThreading();
+  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 100));
+  EXPECT_CALL(sink_, onHistogramComplete(Ref(h2), 200));
   scope1->deliverHistogramToSinks(h1, 100);
   scope1->deliverHistogramToSinks(h2, 200);
   tls_.shutdownThread();
@@ -190,6 +207,53 @@ TEST_F(StatsThreadLocalStoreTest, BasicScope) {
   EXPECT_CALL(*this, free(_)).Times(5);
 }
 
+TEST_F(StatsThreadLocalStoreTest, HistogramMerge) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  ScopePtr scope1 = store_->createScope("scope1.");
+  Histogram& h1 = scope1->histogram("h1");
+  EXPECT_EQ(&h1, &scope1->histogram("h1"));
+  for (uint64_t value = 1; value <= 100; value++) {
+    h1.recordValue(value);
+  }
+
+  std::list<ParentHistogramSharedPtr> histograms = store_->histograms();
+  ASSERT_EQ(1UL, histograms.size());
+  ParentHistogram& parent_h1 = *histograms.front();
+  EXPECT_EQ("scope1.h1", parent_h1.name());
+  EXPECT_FALSE(parent_h1.used());
+  EXPECT_TRUE(std::isnan(parent_h1.intervalStatistics().computedQuantiles()[0]));
+
+  parent_h1.merge();
+  EXPECT_TRUE(parent_h1.used());
+  EXPECT_EQ(100UL, parent_h1.intervalStatistics().sampleCount());
+  EXPECT_EQ(5050UL, parent_h1.intervalStatistics().sampleSum());
+  EXPECT_EQ(1, parent_h1.intervalStatistics().computedQuantiles().front());
+  // Quantiles are accurate to the width of a bucket, 1/8 of the value.
+  EXPECT_NEAR(50, parent_h1.intervalStatistics().computedQuantiles()[2], 50.0 / 8);
+  EXPECT_NEAR(100, parent_h1.intervalStatistics().computedQuantiles().back(), 100.0 / 8);
+
+  // The interval only holds what was recorded since the last merge, the cumulative statistics
+  // hold everything.
+  h1.recordValue(1000);
+  parent_h1.merge();
+  EXPECT_EQ(1UL, parent_h1.intervalStatistics().sampleCount());
+  EXPECT_EQ(101UL, parent_h1.cumulativeStatistics().sampleCount());
+  EXPECT_EQ(6050UL, parent_h1.cumulativeStatistics().sampleSum());
+
+  parent_h1.merge();
+  EXPECT_EQ(0UL, parent_h1.intervalStatistics().sampleCount());
+  EXPECT_EQ(101UL, parent_h1.cumulativeStatistics().sampleCount());
+
+  histograms.clear();
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_));
+}
+
 TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
   InSequence s;
   store_->initializeThreading(main_thread_dispatcher_, tls_);
@@ -302,6 +366,48 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   EXPECT_CALL(*this, free(_)).Times(3);
 }
 
+// Stats in different scopes are allocated concurrently under per scope locks.
+TEST_F(StatsThreadLocalStoreTest, ConcurrentScopes) {
+  const uint32_t num_scopes = 4;
+  const uint32_t num_counters = 100;
+  EXPECT_CALL(*this, alloc(_)).Times(num_scopes * num_counters);
+
+  std::vector<ScopePtr> scopes;
+  for (uint32_t i = 0; i < num_scopes; i++) {
+    scopes.push_back(store_->createScope(fmt::format("scope{}.", i)));
+  }
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < num_scopes; i++) {
+    Scope& scope = *scopes[i];
+    threads.emplace_back([&scope, num_counters]() -> void {
+      for (uint32_t j = 0; j < num_counters; j++) {
+        scope.counter(fmt::format("c{}", j)).inc();
+        scope.counter(fmt::format("c{}", j)).inc();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Includes overflow stat.
+  std::list<CounterSharedPtr> counters = store_->counters();
+  EXPECT_EQ(num_scopes * num_counters + 1, counters.size());
+  for (const CounterSharedPtr& counter : counters) {
+    EXPECT_EQ(counter->name() == "stats.overflow" ? 0 : 2, counter->value());
+  }
+  counters.clear();
+
+  EXPECT_CALL(*this, free(_)).Times(num_scopes * num_counters);
+  scopes.clear();
+
+  store_->shutdownThreading();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_));
+}
+
 TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
   InSequence s;
   store_->initializeThreading(main_thread_dispatcher_, tls_);
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <chrono>
+#include <string>
 
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
@@ -56,6 +58,59 @@ TEST_P(UdpStatsdSinkTest, InitWithIpAddress) {
   tls_.shutdownThread();
 }
 
+TEST_P(UdpStatsdSinkTest, BatchedFlush) {
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  // Bind a server socket so that the datagrams can be read back.
+  Network::Address::InstanceConstSharedPtr bind_address =
+      Network::Test::getCanonicalLoopbackAddress(GetParam());
+  int server_fd = bind_address->socket(Network::Address::SocketType::Datagram);
+  ASSERT_NE(-1, server_fd);
+  ASSERT_EQ(0, bind_address->bind(server_fd));
+  UdpStatsdSink sink(tls_, Network::Address::addressFromFd(server_fd));
+
+  auto receive = [server_fd]() -> std::string {
+    char buffer[2048];
+    ssize_t rc = ::recv(server_fd, buffer, sizeof(buffer), 0);
+    EXPECT_GT(rc, 0);
+    return std::string(buffer, std::max<ssize_t>(rc, 0));
+  };
+
+  NiceMock<MockCounter> counter;
+  counter.name_ = "test_counter";
+  NiceMock<MockGauge> gauge;
+  gauge.name_ = "test_gauge";
+
+  // Everything flushed together shares a datagram.
+  sink.beginFlush();
+  sink.flushCounter(counter, 1);
+  sink.flushGauge(gauge, 2);
+  sink.endFlush();
+  EXPECT_EQ("envoy.test_counter:1|c\nenvoy.test_gauge:2|g", receive());
+
+  // A flush which does not fit in one datagram is split between messages.
+  const std::string message = "envoy.test_counter:1|c";
+  const uint32_t max_datagram_bytes = Writer::MAX_DATAGRAM_BYTES;
+  const uint32_t per_datagram = (max_datagram_bytes + 1) / (message.size() + 1);
+  sink.beginFlush();
+  for (uint32_t i = 0; i < per_datagram + 1; i++) {
+    sink.flushCounter(counter, 1);
+  }
+  sink.endFlush();
+  const std::string first = receive();
+  EXPECT_LE(first.size(), max_datagram_bytes);
+  EXPECT_EQ(per_datagram * (message.size() + 1) - 1, first.size());
+  EXPECT_EQ(message, receive());
+
+  // Outside of a flush values are sent straight away.
+  NiceMock<MockHistogram> timer;
+  timer.name_ = "test_timer";
+  sink.onHistogramComplete(timer, 5);
+  EXPECT_EQ("envoy.test_timer:5|ms", receive());
+
+  tls_.shutdownThread();
+  EXPECT_EQ(0, ::close(server_fd));
+}
+
 } // namespace Statsd
 } // namespace Stats
 } // namespace Envoy
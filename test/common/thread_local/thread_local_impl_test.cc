@@ -1,3 +1,6 @@
+#include <cstdint>
+#include <vector>
+
 #include "common/thread_local/thread_local_impl.h"
 
 #include "test/mocks/event/mocks.h"
@@ -7,6 +10,7 @@
 using testing::InSequence;
 using testing::Ref;
 using testing::ReturnPointee;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -79,5 +83,46 @@ TEST_F(ThreadLocalInstanceImplTest, All) {
   tls_.shutdownThread();
 }
 
+// Slot objects are read in place, without taking a reference.
+TEST_F(ThreadLocalInstanceImplTest, GetTyped) {
+  SlotPtr slot = tls_.allocateSlot();
+  TestThreadLocalObject& object_ref = setObject(*slot);
+  EXPECT_EQ(&object_ref, &slot->getTyped<TestThreadLocalObject>());
+  EXPECT_EQ(&object_ref, slot->get().get());
+  EXPECT_EQ(1, slot->get().use_count());
+
+  tls_.shutdownGlobalThreading();
+  slot.reset();
+  EXPECT_CALL(object_ref, onDestroy());
+  tls_.shutdownThread();
+}
+
+// Updates made during a batch run on the main thread right away and are posted to the workers as a
+// single callback by the outermost endBatch().
+TEST_F(ThreadLocalInstanceImplTest, Batch) {
+  SlotPtr slot1 = tls_.allocateSlot();
+  SlotPtr slot2 = tls_.allocateSlot();
+  std::vector<uint32_t> runs;
+
+  tls_.startBatch();
+  tls_.startBatch();
+  EXPECT_CALL(thread_dispatcher_, post(_)).Times(0);
+  slot1->runOnAllThreads([&]() -> void { runs.push_back(1); });
+  tls_.endBatch();
+  slot2->runOnAllThreads([&]() -> void { runs.push_back(2); });
+  EXPECT_EQ(std::vector<uint32_t>({1, 2}), runs);
+
+  Event::PostCb posted;
+  EXPECT_CALL(thread_dispatcher_, post(_)).WillOnce(SaveArg<0>(&posted));
+  tls_.endBatch();
+  posted();
+  EXPECT_EQ(std::vector<uint32_t>({1, 2, 1, 2}), runs);
+
+  tls_.shutdownGlobalThreading();
+  slot1.reset();
+  slot2.reset();
+  tls_.shutdownThread();
+}
+
 } // namespace ThreadLocal
 } // namespace Envoy
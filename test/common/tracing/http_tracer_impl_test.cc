@@ -196,6 +196,26 @@ TEST(HttpTracerUtilityTest, IsTracing) {
     EXPECT_TRUE(result.is_tracing);
   }
 
+  // Sampled, but the caller does not sample the trace.
+  {
+    Http::TestHeaderMapImpl headers{{"x-request-id", sampled_guid}, {"x-b3-sampled", "0"}};
+    EXPECT_CALL(request_info, healthCheck()).WillOnce(Return(false));
+
+    Decision result = HttpTracerUtility::isTracing(request_info, headers);
+    EXPECT_EQ(Reason::DownstreamNotSampled, result.reason);
+    EXPECT_FALSE(result.is_tracing);
+  }
+
+  // Forced tracing wins over the decision of the caller.
+  {
+    Http::TestHeaderMapImpl headers{{"x-request-id", forced_guid}, {"x-b3-sampled", "0"}};
+    EXPECT_CALL(request_info, healthCheck()).WillOnce(Return(false));
+
+    Decision result = HttpTracerUtility::isTracing(request_info, headers);
+    EXPECT_EQ(Reason::ServiceForced, result.reason);
+    EXPECT_TRUE(result.is_tracing);
+  }
+
   // HC request.
   {
     Http::TestHeaderMapImpl traceable_header_hc{{"x-request-id", forced_guid}};
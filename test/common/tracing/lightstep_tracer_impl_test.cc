@@ -224,6 +224,60 @@ TEST_F(LightStepDriverTest, FlushSpansTimer) {
   EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_sent").value());
 }
 
+TEST_F(LightStepDriverTest, DropOldestSpans) {
+  setupValidDriver();
+
+  ON_CALL(runtime_.snapshot_, getInteger("tracing.lightstep.max_buffered_spans", 5000U))
+      .WillByDefault(Return(1));
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _)).Times(0);
+
+  SpanPtr first_span = driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  first_span->finishSpan();
+  SpanPtr second_span = driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  second_span->finishSpan();
+
+  EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_dropped").value());
+  EXPECT_LT(0U, stats_.counter("tracing.lightstep.bytes_dropped").value());
+
+  // Only the newest span is reported.
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _));
+  timer_->callback_();
+  EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_sent").value());
+}
+
+TEST_F(LightStepDriverTest, MaxPendingReports) {
+  setupValidDriver();
+
+  ON_CALL(runtime_.snapshot_, getInteger("tracing.lightstep.max_pending_reports", 10U))
+      .WillByDefault(Return(1));
+  ON_CALL(runtime_.snapshot_, getInteger("tracing.lightstep.min_flush_spans", 5U))
+      .WillByDefault(Return(1));
+
+  Http::AsyncClient::Callbacks* callback;
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .WillOnce(
+          Invoke([&](Http::MessagePtr&, Http::AsyncClient::Callbacks& callbacks,
+                     const Optional<std::chrono::milliseconds>&) -> Http::AsyncClient::Request* {
+            callback = &callbacks;
+            return nullptr;
+          }));
+  SpanPtr first_span = driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  first_span->finishSpan();
+
+  // The second span waits for the first report to complete.
+  SpanPtr second_span = driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  second_span->finishSpan();
+  EXPECT_EQ(1U, stats_.counter("tracing.lightstep.spans_sent").value());
+
+  callback->onFailure(Http::AsyncClient::FailureReason::Reset);
+
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _));
+  SpanPtr third_span = driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  third_span->finishSpan();
+  EXPECT_EQ(3U, stats_.counter("tracing.lightstep.spans_sent").value());
+  EXPECT_EQ(0U, stats_.counter("tracing.lightstep.spans_dropped").value());
+}
+
 TEST_F(LightStepDriverTest, FlushOneSpanGrpcFailure) {
   setupValidDriver();
 
@@ -1,5 +1,8 @@
+#include "common/buffer/buffer_impl.h"
 #include "common/tracing/zipkin/span_buffer.h"
 
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -101,5 +104,40 @@ TEST(ZipkinSpanBufferTest, sizeConstructorEndtoEnd) {
   EXPECT_EQ(0ULL, buffer.pendingSpans());
   EXPECT_EQ("[]", buffer.toStringifiedJsonArray());
 }
+TEST(ZipkinSpanBufferTest, serializeJsonArray) {
+  SpanBuffer buffer(2);
+
+  Buffer::OwnedImpl empty;
+  buffer.serializeJsonArray(empty);
+  EXPECT_EQ("[]", TestUtility::bufferToString(empty));
+
+  buffer.addSpan(Span());
+  buffer.addSpan(Span());
+  Buffer::OwnedImpl output;
+  buffer.serializeJsonArray(output);
+  EXPECT_EQ(buffer.toStringifiedJsonArray(), TestUtility::bufferToString(output));
+}
+
+TEST(ZipkinSpanBufferTest, serializeThriftList) {
+  SpanBuffer buffer(2);
+  buffer.addSpan(Span());
+
+  Buffer::OwnedImpl output;
+  buffer.serializeThriftList(output);
+
+  // clang-format off
+  const uint8_t expected[] = {
+      0x0c, 0x00, 0x00, 0x00, 0x01,                               // list<Span> of 1 element
+      0x0a, 0x00, 0x01, 0, 0, 0, 0, 0, 0, 0, 0,                   // 1: i64 trace_id
+      0x0b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00,                   // 3: string name
+      0x0a, 0x00, 0x04, 0, 0, 0, 0, 0, 0, 0, 0,                   // 4: i64 id
+      0x0f, 0x00, 0x06, 0x0c, 0x00, 0x00, 0x00, 0x00,             // 6: list<Annotation>
+      0x0f, 0x00, 0x08, 0x0c, 0x00, 0x00, 0x00, 0x00,             // 8: list<BinaryAnnotation>
+      0x00};                                                      // stop
+  // clang-format on
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(expected), sizeof(expected)),
+            TestUtility::bufferToString(output));
+}
+
 } // namespace Zipkin
 } // namespace Envoy
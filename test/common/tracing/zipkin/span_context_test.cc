@@ -75,5 +75,14 @@ TEST(ZipkinSpanContextTest, populateFromSpan) {
   EXPECT_EQ("25c6f38dd0600e78;56707c7b3e1092af;c49193ea42335d1c",
             span_context_high_id.serializeToString());
 }
+
+TEST(ZipkinSpanContextTest, serializeTo) {
+  SpanContext span_context(2722130815203937913ULL, 6228615153417491119ULL, 14164264937399213340ULL);
+  char output[SpanContext::SERIALIZED_LENGTH];
+  span_context.serializeTo(output);
+  EXPECT_EQ("25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c",
+            std::string(output, sizeof(output)));
+  EXPECT_EQ(span_context.serializeToString(), std::string(output, sizeof(output)));
+}
 } // namespace Zipkin
 } // namespace Envoy
@@ -9,6 +9,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/local_info/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -41,8 +42,8 @@ public:
     Json::ObjectSharedPtr config = Json::Factory::loadFromString(config_json);
     envoy::api::v2::ConfigSource cds_config;
     Config::Utility::translateCdsConfig(*config, cds_config);
-    cds_ =
-        CdsApiImpl::create(cds_config, eds_config_, cm_, dispatcher_, random_, local_info_, store_);
+    cds_ = CdsApiImpl::create(cds_config, eds_config_, cm_, tls_, dispatcher_, random_, local_info_,
+                              store_);
     cds_->setInitializedCb([this]() -> void { initialized_.ready(); });
 
     expectRequest();
@@ -81,6 +82,7 @@ public:
   }
 
   NiceMock<MockClusterManager> cm_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
   Event::MockDispatcher dispatcher_;
   NiceMock<Runtime::MockRandomGenerator> random_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
@@ -108,7 +110,8 @@ TEST_F(CdsApiImplTest, InvalidOptions) {
   envoy::api::v2::ConfigSource cds_config;
   Config::Utility::translateCdsConfig(*config, cds_config);
   EXPECT_THROW(
-      CdsApiImpl::create(cds_config, eds_config_, cm_, dispatcher_, random_, local_info_, store_),
+      CdsApiImpl::create(cds_config, eds_config_, cm_, tls_, dispatcher_, random_, local_info_,
+                         store_),
       EnvoyException);
 }
 
@@ -148,10 +151,12 @@ TEST_F(CdsApiImplTest, Basic) {
       Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}}));
   message->body().reset(new Buffer::OwnedImpl(response2_json));
 
+  EXPECT_CALL(tls_, startBatch());
   EXPECT_CALL(cm_, clusters()).WillOnce(Return(makeClusterMap({"cluster1", "cluster2"})));
   expectAdd("cluster1");
   expectAdd("cluster3");
   EXPECT_CALL(cm_, removePrimaryCluster("cluster2"));
+  EXPECT_CALL(tls_, endBatch());
   EXPECT_CALL(*interval_timer_, enableTimer(_));
   callbacks_->onSuccess(std::move(message));
 
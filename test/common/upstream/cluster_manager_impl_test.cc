@@ -1,4 +1,5 @@
 #include <memory>
+#include <set>
 #include <string>
 
 #include "envoy/upstream/upstream.h"
@@ -104,12 +105,24 @@ public:
   LocalInfo::MockLocalInfo local_info_;
 };
 
+class TestLoadBalancerContext : public LoadBalancerContext {
+public:
+  TestLoadBalancerContext(const Network::Connection* connection) : connection_(connection) {}
+
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return {}; }
+  const Network::Connection* downstreamConnection() const override { return connection_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+
+  const Network::Connection* connection_;
+};
+
 class ClusterManagerImplTest : public testing::Test {
 public:
   void create(const envoy::api::v2::Bootstrap& bootstrap) {
     cluster_manager_.reset(new ClusterManagerImpl(
         bootstrap, factory_, factory_.stats_, factory_.tls_, factory_.runtime_, factory_.random_,
-        factory_.local_info_, log_manager_, factory_.dispatcher_));
+        factory_.local_info_, log_manager_, factory_.dispatcher_, true));
   }
 
   NiceMock<TestClusterManagerFactory> factory_;
@@ -453,6 +466,37 @@ TEST_F(ClusterManagerImplTest, VerifyBufferLimits) {
   factory_.tls_.shutdownThread();
 }
 
+TEST_F(ClusterManagerImplTest, PooledTcpConnections) {
+  const std::string json =
+      fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("cluster_1")}));
+
+  ON_CALL(factory_.runtime_.snapshot_, getInteger("upstream.tcp_idle_connections.cluster_1", 0))
+      .WillByDefault(Return(1));
+  create(parseBootstrapFromJson(json));
+
+  // The first connection is set up on demand, and the pool starts to fill behind it.
+  Network::MockClientConnection* pooled_connection = new NiceMock<Network::MockClientConnection>();
+  Network::MockClientConnection* connection = new NiceMock<Network::MockClientConnection>();
+  EXPECT_CALL(factory_.tls_.dispatcher_, createClientConnection_(_, _))
+      .WillOnce(Return(pooled_connection))
+      .WillOnce(Return(connection));
+  PooledTcpConnectionData data = cluster_manager_->pooledTcpConnForCluster("cluster_1", nullptr);
+  EXPECT_EQ(connection, data.data_.connection_.get());
+  EXPECT_FALSE(data.pooled_);
+  EXPECT_EQ(1U, factory_.stats_.counter("cluster.cluster_1.upstream_cx_pool_miss").value());
+
+  // Once connected, the pooled connection goes to the next caller.
+  pooled_connection->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(factory_.tls_.dispatcher_, createClientConnection_(_, _))
+      .WillOnce(Return(new NiceMock<Network::MockClientConnection>()));
+  data = cluster_manager_->pooledTcpConnForCluster("cluster_1", nullptr);
+  EXPECT_EQ(pooled_connection, data.data_.connection_.get());
+  EXPECT_TRUE(data.pooled_);
+  EXPECT_EQ(1U, factory_.stats_.counter("cluster.cluster_1.upstream_cx_pool_hit").value());
+
+  factory_.tls_.shutdownThread();
+}
+
 TEST_F(ClusterManagerImplTest, ShutdownOrder) {
   const std::string json =
       fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("cluster_1")}));
@@ -588,6 +632,8 @@ TEST_F(ClusterManagerImplTest, DynamicRemoveWithLocalCluster) {
   ON_CALL(*cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(*cluster1, initialize(_));
   cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("cluster1"));
+  // Worker state, including the load balancer, is only built on first use.
+  EXPECT_NE(nullptr, cluster_manager_->get("cluster1"));
 
   // Add another update callback on foo so we make sure callbacks keep working.
   ReadyWatcher membership_updated;
@@ -633,9 +679,11 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
 
   EXPECT_EQ(cluster1->info_, cluster_manager_->get("fake_cluster")->info());
   EXPECT_EQ(1UL, factory_.stats_.gauge("cluster_manager.total_clusters").value());
+  EXPECT_EQ(0UL, cluster_manager_->threadLocalGeneration());
 
   // Now try to update again but with the same hash.
   EXPECT_FALSE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("fake_cluster")));
+  EXPECT_EQ(0UL, cluster_manager_->threadLocalGeneration());
 
   // Now do it again with a different hash.
   auto update_cluster = defaultStaticCluster("fake_cluster");
@@ -650,10 +698,13 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
 
   EXPECT_EQ(cluster2->info_, cluster_manager_->get("fake_cluster")->info());
   EXPECT_EQ(1UL, cluster_manager_->clusters().size());
+  EXPECT_EQ(1UL, cluster_manager_->threadLocalGeneration());
   Http::ConnectionPool::MockInstance* cp = new Http::ConnectionPool::MockInstance();
   EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
   EXPECT_EQ(cp, cluster_manager_->httpConnPoolForCluster("fake_cluster", ResourcePriority::Default,
                                                          nullptr));
+  EXPECT_EQ(cp, cluster_manager_->get("fake_cluster")->httpConnPool(ResourcePriority::Default,
+                                                                    nullptr));
 
   // Now remove it. This should drain the connection pool.
   Http::ConnectionPool::Instance::DrainedCb drained_cb;
@@ -661,6 +712,7 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
   EXPECT_TRUE(cluster_manager_->removePrimaryCluster("fake_cluster"));
   EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
   EXPECT_EQ(0UL, cluster_manager_->clusters().size());
+  EXPECT_EQ(2UL, cluster_manager_->threadLocalGeneration());
 
   // Remove an unknown cluster.
   EXPECT_FALSE(cluster_manager_->removePrimaryCluster("foo"));
@@ -787,6 +839,15 @@ TEST_F(ClusterManagerImplTest, DynamicHostRemove) {
   EXPECT_EQ(cp2, cp3);
   EXPECT_EQ(cp2_high, cp3_high);
 
+  // The thread local host set shares the host vectors of the primary cluster.
+  const Cluster& cluster = cluster_manager_->clusters().begin()->second;
+  const HostSet& host_set = cluster_manager_->get("cluster_1")->hostSet();
+  EXPECT_EQ(1UL, host_set.hosts().size());
+  EXPECT_EQ(&cluster.hosts(), &host_set.hosts());
+  EXPECT_EQ(&cluster.healthyHosts(), &host_set.healthyHosts());
+  EXPECT_EQ(&cluster.hostsPerLocality(), &host_set.hostsPerLocality());
+  EXPECT_EQ(&cluster.healthyHostsPerLocality(), &host_set.healthyHostsPerLocality());
+
   // Now add and remove a host that we never have a conn pool to. This should not lead to any
   // drain callbacks, etc.
   dns_timer_->callback_();
@@ -877,90 +938,185 @@ TEST_F(ClusterManagerImplTest, OriginalDstInitialization) {
   factory_.tls_.shutdownThread();
 }
 
-TEST(ClusterManagerInitHelper, ImmediateInitialize) {
-  InSequence s;
-  ClusterManagerInitHelper init_helper;
+// A membership update which arrives before a worker first uses a cluster does not build the
+// worker's state for the cluster, but seeds it once it is built.
+TEST_F(ClusterManagerImplTest, MembershipUpdateBeforeFirstUse) {
+  const std::string json = R"EOF(
+  {
+    "clusters": [
+    {
+      "name": "cluster_1",
+      "connect_timeout_ms": 250,
+      "type": "strict_dns",
+      "dns_resolvers": [ "1.2.3.4:80" ],
+      "lb_type": "round_robin",
+      "hosts": [{"url": "tcp://localhost:11001"}]
+    }]
+  }
+  )EOF";
+
+  std::shared_ptr<Network::MockDnsResolver> dns_resolver(new Network::MockDnsResolver());
+  EXPECT_CALL(factory_.dispatcher_, createDnsResolver(_)).WillOnce(Return(dns_resolver));
+
+  Network::DnsResolver::ResolveCb dns_callback;
+  Event::MockTimer* dns_timer_ = new NiceMock<Event::MockTimer>(&factory_.dispatcher_);
+  Network::MockActiveDnsQuery active_dns_query;
+  EXPECT_CALL(*dns_resolver, resolve(_, _, _))
+      .WillRepeatedly(DoAll(SaveArg<2>(&dns_callback), Return(&active_dns_query)));
+  create(parseBootstrapFromJson(json));
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterBuiltForTest("cluster_1"));
+
+  dns_callback(TestUtility::makeDnsResponse({"127.0.0.1", "127.0.0.2"}));
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterBuiltForTest("cluster_1"));
+
+  ThreadLocalCluster* cluster = cluster_manager_->get("cluster_1");
+  EXPECT_TRUE(cluster_manager_->threadLocalClusterBuiltForTest("cluster_1"));
+  EXPECT_EQ(2UL, cluster->hostSet().hosts().size());
+  EXPECT_EQ(2UL, cluster->hostSet().healthyHosts().size());
+  std::set<std::string> chosen;
+  for (int i = 0; i < 2; i++) {
+    chosen.insert(cluster->loadBalancer().chooseHost(nullptr)->address()->asString());
+  }
+  EXPECT_EQ((std::set<std::string>{"127.0.0.1:11001", "127.0.0.2:11001"}), chosen);
+
+  // Once built, the entry follows further updates.
+  dns_timer_->callback_();
+  dns_callback(TestUtility::makeDnsResponse({"127.0.0.2"}));
+  EXPECT_EQ(1UL, cluster->hostSet().hosts().size());
+  EXPECT_EQ("127.0.0.2:11001",
+            cluster->loadBalancer().chooseHost(nullptr)->address()->asString());
 
+  factory_.tls_.shutdownThread();
+}
+
+// The load balancer of an original destination cluster, built on first use, adds the hosts it
+// creates to the primary cluster captured on the main thread. They come back to the worker as a
+// membership update.
+TEST_F(ClusterManagerImplTest, OriginalDstBuiltOnFirstUse) {
+  const std::string json = R"EOF(
+  {
+    "clusters": [
+    {
+      "name": "cluster_1",
+      "connect_timeout_ms": 250,
+      "type": "original_dst",
+      "lb_type": "original_dst_lb"
+    }]
+  }
+  )EOF";
+
+  create(parseBootstrapFromJson(json));
+  EXPECT_FALSE(cluster_manager_->threadLocalClusterBuiltForTest("cluster_1"));
+
+  NiceMock<Network::MockConnection> connection;
+  Network::Address::InstanceConstSharedPtr address =
+      Network::Utility::parseInternetAddress("10.10.11.11", 6519);
+  ON_CALL(connection, usingOriginalDst()).WillByDefault(Return(true));
+  ON_CALL(connection, localAddress()).WillByDefault(ReturnRef(*address));
+  TestLoadBalancerContext context(&connection);
+
+  ThreadLocalCluster* cluster = cluster_manager_->get("cluster_1");
+  HostConstSharedPtr host = cluster->loadBalancer().chooseHost(&context);
+  ASSERT_NE(nullptr, host);
+  EXPECT_EQ("10.10.11.11:6519", host->address()->asString());
+
+  EXPECT_EQ(1UL, cluster_manager_->clusters().at("cluster_1").get().hosts().size());
+  ASSERT_EQ(1UL, cluster->hostSet().hosts().size());
+  EXPECT_EQ(host, cluster->hostSet().hosts()[0]);
+  EXPECT_EQ(host, cluster->loadBalancer().chooseHost(&context));
+
+  factory_.tls_.shutdownThread();
+}
+
+class ClusterManagerInitHelperTest : public testing::Test {
+public:
+  ClusterManagerInitHelperTest()
+      : stats_(ClusterManagerImpl::generateStats(store_)), init_helper_(stats_, runtime_) {}
+
+  Stats::IsolatedStoreImpl store_;
+  ClusterManagerStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  ClusterManagerInitHelper init_helper_;
+};
+
+TEST_F(ClusterManagerInitHelperTest, ImmediateInitialize) {
+  InSequence s;
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
   cluster1.initialize_callback_();
 
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   ReadyWatcher cm_initialized;
   EXPECT_CALL(cm_initialized, ready());
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 }
 
-TEST(ClusterManagerInitHelper, StaticSdsInitialize) {
+TEST_F(ClusterManagerInitHelperTest, StaticSdsInitialize) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
-
   NiceMock<MockCluster> sds;
   ON_CALL(sds, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(sds, initialize(_));
-  init_helper.addCluster(sds);
+  init_helper_.addCluster(sds);
   sds.initialize_callback_();
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
 
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   ReadyWatcher cm_initialized;
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 
   EXPECT_CALL(cm_initialized, ready());
   cluster1.initialize_callback_();
 }
 
-TEST(ClusterManagerInitHelper, UpdateAlreadyInitialized) {
+TEST_F(ClusterManagerInitHelperTest, UpdateAlreadyInitialized) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
 
   ReadyWatcher cm_initialized;
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
 
   NiceMock<MockCluster> cluster2;
   ON_CALL(cluster2, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster2, initialize(_));
-  init_helper.addCluster(cluster2);
+  init_helper_.addCluster(cluster2);
 
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   cluster1.initialize_callback_();
-  init_helper.removeCluster(cluster1);
+  init_helper_.removeCluster(cluster1);
 
   EXPECT_CALL(cm_initialized, ready());
   cluster2.initialize_callback_();
 }
 
-TEST(ClusterManagerInitHelper, AddSecondaryAfterSecondaryInit) {
+TEST_F(ClusterManagerInitHelperTest, AddSecondaryAfterSecondaryInit) {
   InSequence s;
-  ClusterManagerInitHelper init_helper;
 
   ReadyWatcher cm_initialized;
-  init_helper.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
 
   NiceMock<MockCluster> cluster1;
   ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
   EXPECT_CALL(cluster1, initialize(_));
-  init_helper.addCluster(cluster1);
+  init_helper_.addCluster(cluster1);
 
   NiceMock<MockCluster> cluster2;
   ON_CALL(cluster2, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
-  init_helper.addCluster(cluster2);
+  init_helper_.addCluster(cluster2);
 
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
 
   EXPECT_CALL(cluster2, initialize(_));
   cluster1.initialize_callback_();
@@ -968,33 +1124,72 @@ TEST(ClusterManagerInitHelper, AddSecondaryAfterSecondaryInit) {
   NiceMock<MockCluster> cluster3;
   ON_CALL(cluster3, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
   EXPECT_CALL(cluster3, initialize(_));
-  init_helper.addCluster(cluster3);
+  init_helper_.addCluster(cluster3);
 
   cluster3.initialize_callback_();
   EXPECT_CALL(cm_initialized, ready());
   cluster2.initialize_callback_();
 }
 
-TEST(ClusterManagerInitHelper, RemoveClusterWithinInitLoop) {
+TEST_F(ClusterManagerInitHelperTest, RemoveClusterWithinInitLoop) {
   // Tests the scenario encountered in Issue 903: The cluster was removed from
   // the secondary init list while traversing the list.
 
   InSequence s;
-  ClusterManagerInitHelper init_helper;
   NiceMock<MockCluster> cluster;
   ON_CALL(cluster, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Secondary));
-  init_helper.addCluster(cluster);
+  init_helper_.addCluster(cluster);
 
   // Set up the scenario seen in Issue 903 where initialize() ultimately results
   // in the removeCluster() call. In the real bug this was a long and complex call
   // chain.
   EXPECT_CALL(cluster, initialize(_)).WillOnce(Invoke([&](std::function<void()>) -> void {
-    init_helper.removeCluster(cluster);
+    init_helper_.removeCluster(cluster);
   }));
 
   // Now call onStaticLoadComplete which will exercise maybeFinishInitialize()
   // which calls initialize() on the members of the secondary init list.
-  init_helper.onStaticLoadComplete();
+  init_helper_.onStaticLoadComplete();
+}
+
+// Clusters beyond the initialization limit wait until others finish or are removed.
+TEST_F(ClusterManagerInitHelperTest, MaxInitializingClusters) {
+  InSequence s;
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.max_initializing_clusters", 0))
+      .WillByDefault(Return(1));
+  ReadyWatcher cm_initialized;
+  init_helper_.setInitializedCb([&]() -> void { cm_initialized.ready(); });
+
+  NiceMock<MockCluster> cluster1;
+  ON_CALL(cluster1, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
+  EXPECT_CALL(cluster1, initialize(_));
+  init_helper_.addCluster(cluster1);
+
+  NiceMock<MockCluster> cluster2;
+  ON_CALL(cluster2, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
+  EXPECT_CALL(cluster2, initialize(_)).Times(0);
+  init_helper_.addCluster(cluster2);
+
+  NiceMock<MockCluster> cluster3;
+  ON_CALL(cluster3, initializePhase()).WillByDefault(Return(Cluster::InitializePhase::Primary));
+  init_helper_.addCluster(cluster3);
+  EXPECT_EQ(1UL, stats_.initializing_clusters_.value());
+  EXPECT_EQ(2UL, stats_.pending_initialize_clusters_.value());
+
+  init_helper_.onStaticLoadComplete();
+
+  // Removing a waiting cluster gives up its place.
+  init_helper_.removeCluster(cluster2);
+  EXPECT_EQ(1UL, stats_.pending_initialize_clusters_.value());
+
+  EXPECT_CALL(cluster3, initialize(_));
+  cluster1.initialize_callback_();
+  EXPECT_EQ(1UL, stats_.initializing_clusters_.value());
+  EXPECT_EQ(0UL, stats_.pending_initialize_clusters_.value());
+
+  EXPECT_CALL(cm_initialized, ready());
+  cluster3.initialize_callback_();
+  EXPECT_EQ(0UL, stats_.initializing_clusters_.value());
 }
 
 } // namespace
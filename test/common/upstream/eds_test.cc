@@ -167,6 +167,60 @@ TEST_F(EdsTest, EndpointMetadata) {
   EXPECT_TRUE(hosts[1]->canary());
 }
 
+// Validate that onConfigUpdate() keeps the hosts whose addresses are still listed, even when the
+// list is large and reordered, and drops duplicates and the hosts which are gone.
+TEST_F(EdsTest, EndpointHostsReconciled) {
+  Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources;
+  auto* cluster_load_assignment = resources.Add();
+  cluster_load_assignment->set_cluster_name("fare");
+  auto add_hosts = [cluster_load_assignment](const std::vector<uint32_t>& ports, uint32_t weight) {
+    cluster_load_assignment->clear_endpoints();
+    auto* endpoints = cluster_load_assignment->add_endpoints();
+    for (uint32_t port : ports) {
+      auto* endpoint = endpoints->add_lb_endpoints();
+      auto* socket_address =
+          endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
+      socket_address->set_address("1.2.3.4");
+      socket_address->set_port_value(port);
+      endpoint->mutable_load_balancing_weight()->set_value(weight);
+    }
+  };
+
+  std::vector<uint32_t> ports;
+  for (uint32_t port = 1000; port < 3000; port++) {
+    ports.push_back(port);
+  }
+  add_hosts(ports, 1);
+  cluster_->initialize([] {});
+  cluster_->onConfigUpdate(resources);
+  ASSERT_EQ(2000UL, cluster_->hosts().size());
+  const std::vector<HostSharedPtr> initial_hosts = cluster_->hosts();
+
+  // The same hosts, with a new weight, are not an update.
+  add_hosts(ports, 2);
+  cluster_->onConfigUpdate(resources);
+  EXPECT_EQ(initial_hosts, cluster_->hosts());
+  EXPECT_EQ(2U, cluster_->hosts()[0]->weight());
+
+  // Reversed, with every other host gone, a duplicate and a new host.
+  std::vector<uint32_t> update;
+  for (uint32_t port = 2998; port >= 1000; port -= 2) {
+    update.push_back(port);
+  }
+  update.push_back(2998);
+  update.push_back(4000);
+  add_hosts(update, 3);
+  cluster_->onConfigUpdate(resources);
+
+  const auto& hosts = cluster_->hosts();
+  ASSERT_EQ(1001UL, hosts.size());
+  EXPECT_EQ(initial_hosts[1998], hosts[0]);
+  EXPECT_EQ(initial_hosts[0], hosts[999]);
+  EXPECT_EQ("1.2.3.4:4000", hosts[1000]->address()->asString());
+  EXPECT_EQ(3U, hosts[0]->weight());
+  EXPECT_EQ(3U, cluster_->info()->stats().max_host_weight_.value());
+}
+
 // Validate that onConfigUpdate() updates the endpoint locality.
 TEST_F(EdsTest, EndpointLocality) {
   Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources;
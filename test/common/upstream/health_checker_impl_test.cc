@@ -24,6 +24,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::AnyNumber;
 using testing::DoAll;
 using testing::InSequence;
 using testing::Invoke;
@@ -113,7 +114,11 @@ public:
 
   typedef std::unique_ptr<TestSession> TestSessionPtr;
 
-  HttpHealthCheckerImplTest() : cluster_(new NiceMock<MockCluster>()) {}
+  HttpHealthCheckerImplTest() : cluster_(new NiceMock<MockCluster>()) {
+    // Some tests expect other runtime features, which would make checking this one unexpected.
+    EXPECT_CALL(runtime_.snapshot_, featureEnabled("health_check.spread_checks", 0))
+        .Times(AnyNumber());
+  }
 
   void setupNoServiceValidationHC() {
     std::string json = R"EOF(
@@ -243,6 +248,38 @@ TEST_F(HttpHealthCheckerImplTest, Success) {
   EXPECT_TRUE(cluster_->hosts_[0]->healthy());
 }
 
+// With spreading enabled, the second check of a host is at a random point of the interval and the
+// following checks are an interval apart.
+TEST_F(HttpHealthCheckerImplTest, SpreadChecks) {
+  setupNoServiceValidationHC();
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("health_check.spread_checks", 0))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*this, onHostStatus(_, false)).Times(2);
+
+  cluster_->hosts_ = {makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+  cluster_->info_->stats().upstream_cx_total_.inc();
+  expectSessionCreate();
+  expectStreamCreate(0);
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, enableTimer(_));
+  health_checker_->start();
+
+  // The interval is 1200ms with its jitter, and the check is spread to 1700 % 1200.
+  EXPECT_CALL(random_, random()).WillOnce(Return(200)).WillOnce(Return(1700));
+  EXPECT_CALL(*test_sessions_[0]->interval_timer_, enableTimer(std::chrono::milliseconds(500)));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, disableTimer());
+  respond(0, "200", false);
+
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, enableTimer(_));
+  expectStreamCreate(0);
+  test_sessions_[0]->interval_timer_->callback_();
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(300));
+  EXPECT_CALL(*test_sessions_[0]->interval_timer_, enableTimer(std::chrono::milliseconds(1300)));
+  EXPECT_CALL(*test_sessions_[0]->timeout_timer_, disableTimer());
+  respond(0, "200", false);
+  EXPECT_TRUE(cluster_->hosts_[0]->healthy());
+}
+
 TEST_F(HttpHealthCheckerImplTest, SuccessServiceCheck) {
   setupServiceValidationHC();
   EXPECT_CALL(runtime_.snapshot_, featureEnabled("health_check.verify_cluster", 100))
@@ -713,6 +750,34 @@ TEST(TcpHealthCheckMatcher, match) {
   EXPECT_TRUE(TcpHealthCheckMatcher::match(segments, buffer));
 }
 
+TEST(TcpHealthCheckMatcher, matchIncremental) {
+  Protobuf::RepeatedPtrField<envoy::api::v2::HealthCheck::Payload> repeated_payload;
+  repeated_payload.Add()->set_text("0102");
+  repeated_payload.Add()->set_text("03");
+
+  TcpHealthCheckMatcher::MatchSegments segments =
+      TcpHealthCheckMatcher::loadProtoBytes(repeated_payload);
+  TcpHealthCheckMatcher::MatchState state;
+
+  Buffer::OwnedImpl buffer;
+  add_uint8(buffer, 0);
+  add_uint8(buffer, 0);
+  add_uint8(buffer, 1);
+  EXPECT_FALSE(TcpHealthCheckMatcher::match(segments, buffer, state));
+  EXPECT_EQ(0U, state.matched_segments_);
+  // A partial occurrence at the end of the data is searched again.
+  EXPECT_EQ(2U, state.search_index_);
+
+  add_uint8(buffer, 2);
+  EXPECT_FALSE(TcpHealthCheckMatcher::match(segments, buffer, state));
+  EXPECT_EQ(1U, state.matched_segments_);
+  EXPECT_EQ(4U, state.search_index_);
+
+  add_uint8(buffer, 1);
+  add_uint8(buffer, 3);
+  EXPECT_TRUE(TcpHealthCheckMatcher::match(segments, buffer, state));
+}
+
 class TcpHealthCheckerImplTest : public testing::Test {
 public:
   TcpHealthCheckerImplTest() : cluster_(new NiceMock<MockCluster>()) {}
@@ -1070,6 +1135,39 @@ TEST_F(RedisHealthCheckerImplTest, All) {
   EXPECT_EQ(2UL, cluster_->info_->stats_store_.counter("health_check.network_failure").value());
 }
 
+TEST_F(RedisHealthCheckerImplTest, NoConnectionReuse) {
+  InSequence s;
+  ON_CALL(runtime_.snapshot_, getInteger("health_check.redis.reuse_connection", 1))
+      .WillByDefault(Return(0));
+
+  cluster_->hosts_ = {makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+
+  expectSessionCreate();
+  expectClientCreate();
+  expectRequestCreate();
+  health_checker_->start();
+
+  // The connection is closed once the check is done, and the next check makes a new one.
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  EXPECT_CALL(*client_, close());
+  Redis::RespValuePtr response(new Redis::RespValue());
+  response->type(Redis::RespType::SimpleString);
+  response->asString() = "PONG";
+  pool_callbacks_->onResponse(std::move(response));
+
+  expectClientCreate();
+  expectRequestCreate();
+  interval_timer_->callback_();
+
+  // Shutdown with active request.
+  EXPECT_CALL(pool_request_, cancel());
+  EXPECT_CALL(*client_, close());
+
+  EXPECT_EQ(2UL, cluster_->info_->stats_store_.counter("health_check.attempt").value());
+  EXPECT_EQ(1UL, cluster_->info_->stats_store_.counter("health_check.success").value());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
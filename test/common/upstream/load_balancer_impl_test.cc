@@ -2,6 +2,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -11,6 +12,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/host.h"
 #include "test/mocks/upstream/mocks.h"
 
 #include "gmock/gmock.h"
@@ -66,6 +68,43 @@ TEST_F(RoundRobinLoadBalancerTest, Normal) {
   EXPECT_EQ(cluster_.healthy_hosts_[0], lb_->chooseHost(nullptr));
 }
 
+TEST_F(RoundRobinLoadBalancerTest, Weighted) {
+  init(false);
+  cluster_.healthy_hosts_ = {makeTestHost(cluster_.info_, "tcp://127.0.0.1:80"),
+                             makeTestHost(cluster_.info_, "tcp://127.0.0.1:81"),
+                             makeTestHost(cluster_.info_, "tcp://127.0.0.1:82")};
+  cluster_.hosts_ = cluster_.healthy_hosts_;
+  cluster_.hosts_[0]->weight(2);
+  stats_.max_host_weight_.set(2UL);
+
+  // The host of weight 2 gets half of the requests, and the others take their turns in between.
+  for (uint32_t i = 0; i < 2; i++) {
+    EXPECT_EQ(cluster_.hosts_[0], lb_->chooseHost(nullptr));
+    EXPECT_EQ(cluster_.hosts_[0], lb_->chooseHost(nullptr));
+    EXPECT_EQ(cluster_.hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(cluster_.hosts_[2], lb_->chooseHost(nullptr));
+  }
+
+  // A membership update starts a new schedule with the new weights.
+  cluster_.hosts_[0]->weight(1);
+  cluster_.hosts_[2]->weight(3);
+  stats_.max_host_weight_.set(3UL);
+  cluster_.runCallbacks({}, {});
+  std::unordered_map<HostConstSharedPtr, uint32_t> hits;
+  for (uint32_t i = 0; i < 50; i++) {
+    hits[lb_->chooseHost(nullptr)]++;
+  }
+  EXPECT_EQ(10U, hits[cluster_.hosts_[0]]);
+  EXPECT_EQ(10U, hits[cluster_.hosts_[1]]);
+  EXPECT_EQ(30U, hits[cluster_.hosts_[2]]);
+
+  // Turning weights off in runtime goes back to plain round robin.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1)).WillByDefault(Return(0));
+  EXPECT_EQ(cluster_.hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(cluster_.hosts_[1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(cluster_.hosts_[2], lb_->chooseHost(nullptr));
+}
+
 TEST_F(RoundRobinLoadBalancerTest, MaxUnhealthyPanic) {
   init(false);
   cluster_.healthy_hosts_ = {makeTestHost(cluster_.info_, "tcp://127.0.0.1:80"),
@@ -242,10 +281,18 @@ TEST_F(RoundRobinLoadBalancerTest, ZoneAwareRoutingSmallZone) {
   EXPECT_EQ(cluster_.healthy_hosts_per_locality_[0][0], lb_->chooseHost(nullptr));
   EXPECT_EQ(1U, stats_.lb_zone_routing_sampled_.value());
 
-  // Force request out of small zone.
-  EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(2));
+  // Force request out of small zone. The residual capacity is 0, 667, 667, so the alias table
+  // column 1 always picks locality 1.
+  EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(1));
   EXPECT_EQ(cluster_.healthy_hosts_per_locality_[1][1], lb_->chooseHost(nullptr));
   EXPECT_EQ(1U, stats_.lb_zone_routing_cross_zone_.value());
+
+  // Column 2 picks locality 2 for the first half of the coin flips, and locality 1 otherwise.
+  EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(2 + 3 * 666));
+  EXPECT_EQ(cluster_.healthy_hosts_per_locality_[2][0], lb_->chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(2 + 3 * 667));
+  EXPECT_EQ(cluster_.healthy_hosts_per_locality_[1][1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(3U, stats_.lb_zone_routing_cross_zone_.value());
 }
 
 TEST_F(RoundRobinLoadBalancerTest, LowPrecisionForDistribution) {
@@ -451,6 +498,38 @@ TEST_F(LeastRequestLoadBalancerTest, Normal) {
   EXPECT_EQ(cluster_.healthy_hosts_[1], lb_.chooseHost(nullptr));
 }
 
+TEST_F(LeastRequestLoadBalancerTest, PeakEwma) {
+  cluster_.healthy_hosts_ = {makeTestHost(cluster_.info_, "tcp://127.0.0.1:80"),
+                             makeTestHost(cluster_.info_, "tcp://127.0.0.1:81")};
+  stats_.max_host_weight_.set(1UL);
+  cluster_.hosts_ = cluster_.healthy_hosts_;
+  std::vector<Outlier::MockDetectorHostMonitor*> monitors;
+  for (const HostSharedPtr& host : cluster_.hosts_) {
+    monitors.push_back(new NiceMock<Outlier::MockDetectorHostMonitor>());
+    host->setOutlierDetector(Outlier::DetectorHostMonitorPtr{monitors.back()});
+  }
+
+  // The first host has fewer active requests but is much slower.
+  cluster_.healthy_hosts_[0]->stats().rq_active_.set(1);
+  cluster_.healthy_hosts_[1]->stats().rq_active_.set(2);
+  ON_CALL(*monitors[0], peakEwmaResponseTime()).WillByDefault(Return(99));
+  ON_CALL(*monitors[1], peakEwmaResponseTime()).WillByDefault(Return(9));
+
+  // Only active requests are compared unless the runtime switch is on.
+  EXPECT_CALL(random_, random()).WillOnce(Return(2)).WillOnce(Return(3));
+  EXPECT_EQ(cluster_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.peak_ewma_enabled", 0))
+      .WillByDefault(Return(1));
+  EXPECT_CALL(random_, random()).WillOnce(Return(2)).WillOnce(Return(3));
+  EXPECT_EQ(cluster_.healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  // Hosts without a response time average are compared by active requests.
+  ON_CALL(*monitors[0], peakEwmaResponseTime()).WillByDefault(Return(-1));
+  EXPECT_CALL(random_, random()).WillOnce(Return(2)).WillOnce(Return(3));
+  EXPECT_EQ(cluster_.healthy_hosts_[0], lb_.chooseHost(nullptr));
+}
+
 TEST_F(LeastRequestLoadBalancerTest, WeightImbalanceRuntimeOff) {
   // Disable weight balancing.
   EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1))
@@ -563,6 +642,28 @@ TEST_F(RandomLoadBalancerTest, Normal) {
   EXPECT_EQ(cluster_.healthy_hosts_[1], lb_.chooseHost(nullptr));
 }
 
+TEST(AliasTableTest, Empty) {
+  AliasTable table;
+  EXPECT_TRUE(table.empty());
+  table.build({0, 0});
+  EXPECT_TRUE(table.empty());
+}
+
+TEST(AliasTableTest, Distribution) {
+  AliasTable table;
+  const std::vector<uint64_t> weights{0, 10, 30, 0, 60};
+  table.build(weights);
+  EXPECT_FALSE(table.empty());
+
+  // Every column and coin flip combination is visited exactly once, so the picks are distributed
+  // exactly in proportion to the weights.
+  std::vector<uint64_t> picks(weights.size());
+  for (uint64_t random = 0; random < weights.size() * 100; random++) {
+    picks[table.pick(random)]++;
+  }
+  EXPECT_EQ((std::vector<uint64_t>{0, 50, 150, 0, 300}), picks);
+}
+
 TEST(LoadBalancerSubsetInfoImplTest, DefaultConfigIsDiabled) {
   auto subset_info =
       LoadBalancerSubsetInfoImpl(envoy::api::v2::Cluster::LbSubsetConfig::default_instance());
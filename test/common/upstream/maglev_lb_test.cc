@@ -0,0 +1,128 @@
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/router/router.h"
+
+#include "common/upstream/maglev_lb.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Upstream {
+
+class TestLoadBalancerContext : public LoadBalancerContext {
+public:
+  TestLoadBalancerContext(uint64_t hash_key) : hash_key_(hash_key) {}
+
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return hash_key_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+  const Network::Connection* downstreamConnection() const override { return nullptr; }
+
+  Optional<uint64_t> hash_key_;
+};
+
+class MaglevLoadBalancerTest : public testing::Test {
+public:
+  MaglevLoadBalancerTest() : stats_(ClusterInfoImpl::generateStats(stats_store_)) {}
+
+  void addHosts(uint32_t num_hosts) {
+    for (uint32_t i = 0; i < num_hosts; i++) {
+      cluster_.hosts_.push_back(
+          makeTestHost(cluster_.info_, fmt::format("tcp://127.0.0.1:{}", i)));
+    }
+    cluster_.healthy_hosts_ = cluster_.hosts_;
+    cluster_.runCallbacks({}, {});
+  }
+
+  // The host of every slot of the table in use.
+  std::vector<HostConstSharedPtr> table() {
+    std::vector<HostConstSharedPtr> hosts;
+    for (uint64_t i = 0; i < table_size_; i++) {
+      TestLoadBalancerContext context(i);
+      hosts.push_back(lb_.chooseHost(&context));
+    }
+    return hosts;
+  }
+
+  const uint64_t table_size_{MaglevLoadBalancer::TABLE_SIZE};
+  NiceMock<MockCluster> cluster_;
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  MaglevLoadBalancer lb_{cluster_, stats_, runtime_, random_};
+};
+
+TEST_F(MaglevLoadBalancerTest, NoHost) { EXPECT_EQ(nullptr, lb_.chooseHost(nullptr)); };
+
+// The number of slots of any two hosts differs by at most one.
+TEST_F(MaglevLoadBalancerTest, Balanced) {
+  addHosts(10);
+
+  std::unordered_map<HostConstSharedPtr, uint64_t> slots;
+  for (const HostConstSharedPtr& host : table()) {
+    ASSERT_NE(nullptr, host);
+    slots[host]++;
+  }
+  EXPECT_EQ(10UL, slots.size());
+  for (const auto& host_slots : slots) {
+    EXPECT_GE(host_slots.second, table_size_ / 10);
+    EXPECT_LE(host_slots.second, table_size_ / 10 + 1);
+  }
+
+  // The hash wraps around the table.
+  TestLoadBalancerContext context(0);
+  TestLoadBalancerContext wrapped_context(table_size_);
+  EXPECT_EQ(lb_.chooseHost(&context), lb_.chooseHost(&wrapped_context));
+
+  // Without a hash in the context a random slot is chosen.
+  EXPECT_CALL(random_, random()).WillOnce(Return(table_size_ + 1));
+  TestLoadBalancerContext slot_context(1);
+  EXPECT_EQ(lb_.chooseHost(&slot_context), lb_.chooseHost(nullptr));
+  EXPECT_EQ(0UL, stats_.lb_healthy_panic_.value());
+}
+
+// Removing a host only moves a small fraction of the slots of the other hosts.
+TEST_F(MaglevLoadBalancerTest, MinimalDisruption) {
+  addHosts(10);
+  const std::vector<HostConstSharedPtr> before = table();
+
+  const HostConstSharedPtr removed = cluster_.hosts_[3];
+  cluster_.hosts_.erase(cluster_.hosts_.begin() + 3);
+  cluster_.healthy_hosts_ = cluster_.hosts_;
+  cluster_.runCallbacks({}, {removed});
+  const std::vector<HostConstSharedPtr> after = table();
+
+  uint64_t moved = 0;
+  for (uint64_t i = 0; i < table_size_; i++) {
+    EXPECT_NE(removed, after[i]);
+    if (before[i] != removed && before[i] != after[i]) {
+      moved++;
+    }
+  }
+  EXPECT_LT(moved, table_size_ / 100);
+}
+
+TEST_F(MaglevLoadBalancerTest, Panic) {
+  addHosts(2);
+  cluster_.healthy_hosts_.clear();
+  cluster_.runCallbacks({}, {});
+
+  TestLoadBalancerContext context(0);
+  EXPECT_NE(nullptr, lb_.chooseHost(&context));
+  EXPECT_EQ(1UL, stats_.lb_healthy_panic_.value());
+}
+
+} // namespace Upstream
+} // namespace Envoy
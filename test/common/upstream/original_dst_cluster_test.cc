@@ -439,6 +439,65 @@ TEST_F(OriginalDstClusterTest, MultipleClusters) {
   EXPECT_EQ(host, second.hosts()[0]);
 }
 
+TEST_F(OriginalDstClusterTest, SharedHost) {
+  std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 1250,
+    "type": "original_dst",
+    "lb_type": "original_dst_lb"
+  }
+  )EOF";
+
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_));
+  setup(json);
+
+  NiceMock<Network::MockConnection> connection;
+  TestLoadBalancerContext lb_context(&connection);
+  Network::Address::Ipv4Instance local_address("10.10.11.11", 443);
+  EXPECT_CALL(connection, localAddress()).WillRepeatedly(ReturnRef(local_address));
+  EXPECT_CALL(connection, usingOriginalDst()).WillRepeatedly(Return(true));
+
+  // The second load balancer's host set is not updated, as if the main thread had not yet
+  // propagated the host to its worker.
+  HostSetImpl second;
+  OriginalDstCluster::LoadBalancer lb1(*cluster_, cluster_);
+  OriginalDstCluster::LoadBalancer lb2(second, cluster_);
+  Event::PostCb post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  HostConstSharedPtr host = lb1.chooseHost(&lb_context);
+  ASSERT_NE(host, nullptr);
+
+  // The second load balancer uses the same host, without another round trip to the main thread.
+  EXPECT_EQ(host, lb2.chooseHost(&lb_context));
+  EXPECT_EQ(0UL, second.hosts().size());
+
+  // A different port is a different host.
+  Network::Address::Ipv4Instance other_address("10.10.11.11", 80);
+  EXPECT_CALL(connection, localAddress()).WillRepeatedly(ReturnRef(other_address));
+  Event::PostCb other_post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&other_post_cb));
+  HostConstSharedPtr other_host = lb2.chooseHost(&lb_context);
+  ASSERT_NE(other_host, nullptr);
+  EXPECT_NE(host, other_host);
+
+  // Once the host is cleaned up, a new one is created for the address.
+  EXPECT_CALL(membership_updated_, ready());
+  post_cb();
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_)).Times(2);
+  EXPECT_CALL(membership_updated_, ready());
+  cleanup_timer_->callback_();
+  cleanup_timer_->callback_();
+  EXPECT_EQ(0UL, cluster_->hosts().size());
+
+  EXPECT_CALL(connection, localAddress()).WillRepeatedly(ReturnRef(local_address));
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  HostConstSharedPtr new_host = lb1.chooseHost(&lb_context);
+  ASSERT_NE(new_host, nullptr);
+  EXPECT_NE(host, new_host);
+}
+
 } // namespace OriginalDstClusterTest
 } // namespace Upstream
 } // namespace Envoy
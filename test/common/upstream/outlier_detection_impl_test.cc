@@ -21,6 +21,7 @@
 #include "gtest/gtest.h"
 
 using testing::NiceMock;
+using testing::Property;
 using testing::Return;
 using testing::ReturnRef;
 using testing::SaveArg;
@@ -272,6 +273,9 @@ TEST_F(OutlierDetectorImplTest, BasicFlowSuccessRate) {
   EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
   ON_CALL(runtime_.snapshot_, getInteger("outlier_detection.success_rate_stdev_factor", 1900))
       .WillByDefault(Return(1900));
+  EXPECT_CALL(cluster_.info_->stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "outlier_detection.detection_time_us"), _));
   interval_timer_->callback_();
   EXPECT_EQ(50, cluster_.hosts_[4]->outlierDetector().successRate());
   EXPECT_EQ(90, detector->successRateAverage());
@@ -406,6 +410,87 @@ TEST_F(OutlierDetectorImplTest, NotEnforcing) {
       cluster_.info_->stats_store_.counter("outlier_detection.ejections_consecutive_5xx").value());
 }
 
+TEST_F(OutlierDetectorImplTest, PeakEwmaResponseTime) {
+  EXPECT_CALL(cluster_, addMemberUpdateCb(_));
+  addHosts({"tcp://127.0.0.1:80"});
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_source_, event_logger_));
+  DetectorHostMonitor& monitor = cluster_.hosts_[0]->outlierDetector();
+  EXPECT_EQ(-1, monitor.peakEwmaResponseTime());
+
+  // A slower response replaces the average while faster ones decay it.
+  monitor.putResponseTime(std::chrono::milliseconds(10));
+  EXPECT_DOUBLE_EQ(10, monitor.peakEwmaResponseTime());
+  monitor.putResponseTime(std::chrono::milliseconds(100));
+  EXPECT_DOUBLE_EQ(100, monitor.peakEwmaResponseTime());
+  monitor.putResponseTime(std::chrono::milliseconds(0));
+  EXPECT_DOUBLE_EQ(90, monitor.peakEwmaResponseTime());
+
+  // The average is kept over an interval with responses and forgotten after one without.
+  EXPECT_CALL(time_source_, currentTime())
+      .WillRepeatedly(Return(MonotonicTime(std::chrono::milliseconds(10000))));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000))).Times(2);
+  interval_timer_->callback_();
+  EXPECT_DOUBLE_EQ(90, monitor.peakEwmaResponseTime());
+  interval_timer_->callback_();
+  EXPECT_EQ(-1, monitor.peakEwmaResponseTime());
+}
+
+TEST_F(OutlierDetectorImplTest, BasicFlowLatency) {
+  EXPECT_CALL(cluster_, addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_source_, event_logger_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+  ON_CALL(runtime_.snapshot_, getInteger("outlier_detection.latency_stdev_factor", 0))
+      .WillByDefault(Return(1900));
+  ON_CALL(runtime_.snapshot_, featureEnabled("outlier_detection.enforcing_latency", 100))
+      .WillByDefault(Return(true));
+
+  // Every host answers in 10ms, except for 2% of the responses of the last host, which take
+  // 200ms.
+  for (const HostSharedPtr& host : cluster_.hosts_) {
+    for (uint32_t i = 0; i < 200; i++) {
+      const bool slow = host == cluster_.hosts_[4] && i % 50 == 0;
+      host->outlierDetector().putResponseTime(std::chrono::milliseconds(slow ? 200 : 10));
+    }
+  }
+
+  // Percentiles are rounded up to their bucket: 10ms to 11ms and 200ms to 223ms.
+  EXPECT_CALL(time_source_, currentTime())
+      .WillRepeatedly(Return(MonotonicTime(std::chrono::milliseconds(10000))));
+  EXPECT_CALL(checker_, check(cluster_.hosts_[4]));
+  EXPECT_CALL(*event_logger_,
+              logEject(std::static_pointer_cast<const HostDescription>(cluster_.hosts_[4]), _,
+                       EjectionType::Latency, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_EQ(11, cluster_.hosts_[0]->outlierDetector().p99ResponseTime());
+  EXPECT_EQ(223, cluster_.hosts_[4]->outlierDetector().p99ResponseTime());
+  EXPECT_DOUBLE_EQ(53.4, detector->p99ResponseTimeAverage());
+  EXPECT_NEAR(214.52, detector->p99ResponseTimeEjectionThreshold(), 0.01);
+  EXPECT_TRUE(cluster_.hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_.gauge("outlier_detection.ejections_active").value());
+  EXPECT_EQ(1UL,
+            cluster_.info_->stats_store_.counter("outlier_detection.ejections_latency").value());
+
+  // Without responses there is nothing to compare.
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_EQ(-1, cluster_.hosts_[0]->outlierDetector().p99ResponseTime());
+  EXPECT_EQ(-1, detector->p99ResponseTimeAverage());
+  EXPECT_EQ(-1, detector->p99ResponseTimeEjectionThreshold());
+}
+
 TEST_F(OutlierDetectorImplTest, CrossThreadRemoveRace) {
   EXPECT_CALL(cluster_, addMemberUpdateCb(_));
   addHosts({"tcp://127.0.0.1:80"});
@@ -511,6 +596,7 @@ TEST(DetectorHostMonitorNullImplTest, All) {
   EXPECT_EQ(0UL, null_sink.numEjections());
   EXPECT_FALSE(null_sink.lastEjectionTime().valid());
   EXPECT_FALSE(null_sink.lastUnejectionTime().valid());
+  EXPECT_EQ(-1, null_sink.p99ResponseTime());
 }
 
 TEST(OutlierDetectionEventLoggerImplTest, All) {
@@ -579,6 +665,23 @@ TEST(OutlierDetectionEventLoggerImplTest, All) {
       .WillOnce(SaveArg<0>(&log4));
   event_logger.logUneject(host);
   Json::Factory::loadFromString(log4);
+
+  std::string log5;
+  EXPECT_CALL(host->outlier_detector_, lastUnejectionTime()).WillOnce(ReturnRef(monotonic_time));
+  EXPECT_CALL(host->outlier_detector_, p99ResponseTime()).WillOnce(Return(223));
+  EXPECT_CALL(detector, p99ResponseTimeAverage()).WillOnce(Return(53.4));
+  EXPECT_CALL(detector, p99ResponseTimeEjectionThreshold()).WillOnce(Return(214.5));
+  EXPECT_CALL(*file, write("{\"time\": \"1970-01-01T00:00:00.000Z\", \"secs_since_last_action\": "
+                           "\"30\", \"cluster\": "
+                           "\"fake_cluster\", \"upstream_url\": \"10.0.0.1:443\", \"action\": "
+                           "\"eject\", \"type\": \"Latency\", \"num_ejections\": \"0\", "
+                           "\"enforced\": \"true\", \"host_p99_response_time_ms\": \"223\", "
+                           "\"cluster_average_p99_response_time_ms\": \"53.4\", "
+                           "\"cluster_p99_response_time_ejection_threshold_ms\": \"214.5\""
+                           "}\n"))
+      .WillOnce(SaveArg<0>(&log5));
+  event_logger.logEject(host, detector, EjectionType::Latency, true);
+  Json::Factory::loadFromString(log5);
 }
 
 TEST(OutlierUtility, SRThreshold) {
@@ -594,6 +697,42 @@ TEST(OutlierUtility, SRThreshold) {
   EXPECT_EQ(90.0, ejection_pair.success_rate_average_);
 }
 
+TEST(OutlierUtility, LatencyThreshold) {
+  std::vector<HostLatencyPair> data = {
+      HostLatencyPair(nullptr, 10), HostLatencyPair(nullptr, 10), HostLatencyPair(nullptr, 10),
+      HostLatencyPair(nullptr, 10), HostLatencyPair(nullptr, 60),
+  };
+
+  Utility::LatencyEjectionPair ejection_pair = Utility::latencyEjectionThreshold(100, data, 1.9);
+  EXPECT_EQ(20.0, ejection_pair.p99_response_time_average_);
+  EXPECT_EQ(58.0, ejection_pair.ejection_threshold_);
+
+  // Hosts which are close to the others are not outliers, however small the deviation.
+  data = {
+      HostLatencyPair(nullptr, 10), HostLatencyPair(nullptr, 10), HostLatencyPair(nullptr, 10),
+      HostLatencyPair(nullptr, 10), HostLatencyPair(nullptr, 11),
+  };
+  ejection_pair = Utility::latencyEjectionThreshold(51, data, 1.9);
+  EXPECT_DOUBLE_EQ(15.3, ejection_pair.ejection_threshold_);
+}
+
+TEST(OutlierUtility, LatencyBuckets) {
+  for (uint64_t time_ms = 0; time_ms < 200000; time_ms++) {
+    const size_t index = LatencyAccumulator::bucketIndex(time_ms);
+    ASSERT_LT(index, LatencyAccumulatorBucket::NumBuckets);
+    if (index < LatencyAccumulatorBucket::NumBuckets - 1) {
+      // Each time falls in the bucket whose bounds hold it, and bounds are off by less than 25%.
+      ASSERT_LE(time_ms, LatencyAccumulator::bucketUpperBound(index));
+      ASSERT_LT(LatencyAccumulator::bucketUpperBound(index), time_ms * 5 / 4 + 1);
+      if (index > 0) {
+        ASSERT_GT(time_ms, LatencyAccumulator::bucketUpperBound(index - 1));
+      }
+    }
+  }
+  EXPECT_EQ(131071U,
+            LatencyAccumulator::bucketUpperBound(LatencyAccumulatorBucket::NumBuckets - 1));
+}
+
 } // namespace Outlier
 } // namespace Upstream
 } // namespace Envoy
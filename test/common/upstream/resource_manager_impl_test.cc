@@ -1,12 +1,15 @@
 #include "common/upstream/resource_manager_impl.h"
 
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/stats/mocks.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::InSequence;
 using testing::NiceMock;
 using testing::Return;
+using testing::_;
 
 namespace Envoy {
 namespace Upstream {
@@ -47,5 +50,93 @@ TEST(ResourceManagerImplTest, RuntimeResourceManager) {
   EXPECT_FALSE(resource_manager.retries().canCreate());
 }
 
+class AdaptiveConcurrencyLimitTest : public testing::Test {
+public:
+  void window(AdaptiveConcurrencyLimit& limit, uint64_t latency_us, uint64_t in_flight,
+              uint64_t min_limit) {
+    for (uint64_t i = 1; i < AdaptiveConcurrencyLimit::SampleWindow; i++) {
+      EXPECT_FALSE(limit.addSample(std::chrono::microseconds(latency_us)));
+    }
+    EXPECT_TRUE(limit.addSample(std::chrono::microseconds(latency_us)));
+    limit.update(in_flight, min_limit, 100);
+  }
+
+  NiceMock<Stats::MockGauge> gauge_;
+};
+
+TEST_F(AdaptiveConcurrencyLimitTest, FollowsLatency) {
+  InSequence s;
+  EXPECT_CALL(gauge_, set(100));
+  AdaptiveConcurrencyLimit limit(100, &gauge_);
+  EXPECT_EQ(100U, limit.limit());
+
+  // The limit does not grow past the configured maximum.
+  EXPECT_CALL(gauge_, set(100));
+  window(limit, 1000, 100, 10);
+  EXPECT_EQ(100U, limit.limit());
+
+  // The latency triples: the limit shrinks.
+  EXPECT_CALL(gauge_, set(93));
+  window(limit, 3000, 100, 10);
+  EXPECT_EQ(93U, limit.limit());
+
+  // The latency is back to normal: the limit grows again.
+  EXPECT_CALL(gauge_, set(94));
+  window(limit, 1000, 100, 10);
+  EXPECT_EQ(94U, limit.limit());
+
+  // Too few requests in flight to tell anything.
+  EXPECT_CALL(gauge_, set(94));
+  window(limit, 5000, 10, 10);
+  EXPECT_EQ(94U, limit.limit());
+
+  // The limit does not shrink past the minimum.
+  EXPECT_CALL(gauge_, set(96));
+  window(limit, 5000, 100, 96);
+  EXPECT_EQ(96U, limit.limit());
+}
+
+TEST(ResourceManagerImplTest, AdaptiveRequests) {
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Stats::MockGauge> gauge;
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.adaptive_test.default.", 0, 0,
+                                       100, 1, &gauge);
+  for (uint64_t i = 0; i < 100; i++) {
+    resource_manager.requests().inc();
+  }
+
+  // Disabled, the latencies are ignored.
+  EXPECT_CALL(gauge, set(_)).Times(0);
+  for (uint64_t i = 0; i < 2 * AdaptiveConcurrencyLimit::SampleWindow; i++) {
+    resource_manager.onRequestLatency(std::chrono::microseconds(1000));
+  }
+  EXPECT_EQ(100U, resource_manager.requests().max());
+
+  ON_CALL(runtime.snapshot_, getInteger("circuit_breakers.adaptive_test.default.max_requests", _))
+      .WillByDefault(Return(100));
+  ON_CALL(runtime.snapshot_,
+          getInteger("circuit_breakers.adaptive_test.default.adaptive_max_requests", 0))
+      .WillByDefault(Return(1));
+  EXPECT_CALL(gauge, set(100));
+  for (uint64_t i = 0; i < AdaptiveConcurrencyLimit::SampleWindow; i++) {
+    resource_manager.onRequestLatency(std::chrono::microseconds(1000));
+  }
+  EXPECT_CALL(gauge, set(93));
+  for (uint64_t i = 0; i < AdaptiveConcurrencyLimit::SampleWindow; i++) {
+    resource_manager.onRequestLatency(std::chrono::microseconds(3000));
+  }
+  EXPECT_EQ(93U, resource_manager.requests().max());
+  EXPECT_FALSE(resource_manager.requests().canCreate());
+
+  // The configured maximum still caps the limit.
+  ON_CALL(runtime.snapshot_, getInteger("circuit_breakers.adaptive_test.default.max_requests", _))
+      .WillByDefault(Return(50));
+  EXPECT_EQ(50U, resource_manager.requests().max());
+
+  for (uint64_t i = 0; i < 100; i++) {
+    resource_manager.requests().dec();
+  }
+}
+
 } // namespace Upstream
 } // namespace Envoy
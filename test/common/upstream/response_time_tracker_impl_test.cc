@@ -0,0 +1,69 @@
+#include <chrono>
+
+#include "common/upstream/response_time_tracker_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+class ResponseTimeHistogramTest : public testing::Test {
+public:
+  void record(uint64_t response_time, uint64_t times = 1) {
+    for (uint64_t i = 0; i < times; i++) {
+      histogram_.recordResponseTime(std::chrono::milliseconds(response_time));
+    }
+  }
+
+  uint64_t quantile(double quantile) {
+    return histogram_.responseTimeQuantile(quantile).value().count();
+  }
+
+  ResponseTimeHistogram histogram_;
+};
+
+TEST_F(ResponseTimeHistogramTest, TooFewSamples) {
+  EXPECT_FALSE(histogram_.responseTimeQuantile(0.5).valid());
+  record(10, ResponseTimeHistogram::MinSamples - 1);
+  EXPECT_FALSE(histogram_.responseTimeQuantile(0.5).valid());
+  record(10);
+  EXPECT_EQ(10U, quantile(0.5));
+}
+
+TEST_F(ResponseTimeHistogramTest, Quantiles) {
+  for (uint64_t response_time = 1; response_time <= 1000; response_time++) {
+    record(response_time);
+  }
+
+  // Small response times are exact, larger ones are within 12.5% above.
+  EXPECT_EQ(1U, quantile(0));
+  EXPECT_EQ(10U, quantile(0.01));
+  EXPECT_GE(quantile(0.5), 500U);
+  EXPECT_LE(quantile(0.5), 500U * 9 / 8);
+  EXPECT_GE(quantile(0.95), 950U);
+  EXPECT_LE(quantile(0.95), 950U * 9 / 8);
+  EXPECT_GE(quantile(1), 1000U);
+  EXPECT_LE(quantile(1), 1000U * 9 / 8);
+}
+
+TEST_F(ResponseTimeHistogramTest, Extremes) {
+  record(0, 50);
+  record(uint64_t(1) << 40, 50);
+  EXPECT_EQ(0U, quantile(0.5));
+  EXPECT_EQ((uint64_t(1) << 36) - 1, quantile(0.51));
+}
+
+TEST_F(ResponseTimeHistogramTest, Decay) {
+  record(1000, ResponseTimeHistogram::DecayInterval);
+  EXPECT_GE(quantile(0.5), 1000U);
+
+  // Old response times weigh less and less.
+  record(10, ResponseTimeHistogram::DecayInterval);
+  EXPECT_EQ(10U, quantile(0.5));
+  EXPECT_GE(quantile(0.9), 1000U);
+  record(10, 3 * ResponseTimeHistogram::DecayInterval);
+  EXPECT_EQ(10U, quantile(0.9));
+}
+
+} // namespace Upstream
+} // namespace Envoy
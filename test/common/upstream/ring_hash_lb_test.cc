@@ -142,6 +142,46 @@ TEST_F(RingHashLoadBalancerTest, UnevenHosts) {
   }
 }
 
+// Hosts which stay in the host set keep their ring entries, and the ring chooses the same hosts as
+// a ring built from scratch.
+TEST_F(RingHashLoadBalancerTest, IncrementalRebuild) {
+  for (uint32_t i = 0; i < 10; i++) {
+    cluster_.hosts_.push_back(makeTestHost(cluster_.info_, fmt::format("tcp://127.0.0.1:{}", i)));
+  }
+  cluster_.healthy_hosts_ = cluster_.hosts_;
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.ring_hash.min_ring_size", _))
+      .WillByDefault(Return(100));
+  cluster_.runCallbacks({}, {});
+
+  // Remove a host and add another, which keeps the number of entries per host the same.
+  cluster_.hosts_.erase(cluster_.hosts_.begin() + 3);
+  cluster_.hosts_.push_back(makeTestHost(cluster_.info_, "tcp://127.0.0.1:10"));
+  cluster_.healthy_hosts_ = cluster_.hosts_;
+  cluster_.runCallbacks({}, {});
+
+  NiceMock<MockCluster> fresh_cluster;
+  fresh_cluster.hosts_ = cluster_.hosts_;
+  fresh_cluster.healthy_hosts_ = cluster_.hosts_;
+  RingHashLoadBalancer fresh_lb{fresh_cluster, stats_, runtime_, random_};
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    TestLoadBalancerContext context(std::hash<std::string>()(std::to_string(i)));
+    HostConstSharedPtr host = lb_.chooseHost(&context);
+    EXPECT_NE("127.0.0.1:3", host->address()->asString());
+    EXPECT_EQ(fresh_lb.chooseHost(&context), host);
+  }
+
+  // Halving the ring size halves the number of entries per host, so the ring is built again.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.ring_hash.min_ring_size", _))
+      .WillByDefault(Return(50));
+  cluster_.runCallbacks({}, {});
+  fresh_cluster.runCallbacks({}, {});
+  for (uint64_t i = 0; i < 1000; i++) {
+    TestLoadBalancerContext context(std::hash<std::string>()(std::to_string(i)));
+    EXPECT_EQ(fresh_lb.chooseHost(&context), lb_.chooseHost(&context));
+  }
+}
+
 /**
  * This test is for simulation only and should not be run as part of unit tests. In order to run the
  * simulation remove the DISABLED_ prefix from the TEST_F invocation. Run bazel with
@@ -447,6 +447,36 @@ TEST_P(SubsetLoadBalancerTest, BalancesSubsetAfterUpdate) {
   EXPECT_EQ(3U, stats_.lb_subsets_created_.value());
 }
 
+// The subset found for a route's criteria is cached until the next membership update, which may
+// create the subset a lookup did not find.
+TEST_P(SubsetLoadBalancerTest, CachedSubsetAfterUpdate) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::ANY_ENDPOINT));
+
+  std::vector<std::set<std::string>> subset_keys = {{"version"}};
+  EXPECT_CALL(subset_info_, subsetKeys()).WillRepeatedly(ReturnRef(subset_keys));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}}},
+      {"tcp://127.0.0.1:81", {{"version", "1.1"}}},
+  });
+
+  TestLoadBalancerContext context_10({{"version", "1.0"}});
+  TestLoadBalancerContext context_12({{"version", "1.2"}});
+  EXPECT_EQ(cluster_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(cluster_.hosts_[0], lb_->chooseHost(&context_10));
+  lb_->chooseHost(&context_12);
+  EXPECT_EQ(2U, stats_.lb_subsets_selected_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_fallback_.value());
+
+  modifyHosts({makeHost("tcp://127.0.0.1:8000", {{"version", "1.2"}})}, {});
+
+  EXPECT_EQ(cluster_.hosts_[2], lb_->chooseHost(&context_12));
+  EXPECT_EQ(cluster_.hosts_[0], lb_->chooseHost(&context_10));
+  EXPECT_EQ(4U, stats_.lb_subsets_selected_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_fallback_.value());
+}
+
 TEST_P(SubsetLoadBalancerTest, UpdateRemovingLastSubsetHost) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::ANY_ENDPOINT));
@@ -650,9 +680,9 @@ TEST_F(SubsetLoadBalancerTest, LoadBalancerTypes) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::ANY_ENDPOINT));
 
-  auto types =
-      std::vector<LoadBalancerType>({LoadBalancerType::RoundRobin, LoadBalancerType::LeastRequest,
-                                     LoadBalancerType::Random, LoadBalancerType::RingHash});
+  auto types = std::vector<LoadBalancerType>(
+      {LoadBalancerType::RoundRobin, LoadBalancerType::LeastRequest, LoadBalancerType::Random,
+       LoadBalancerType::RingHash, LoadBalancerType::Maglev});
 
   for (const auto& it : types) {
     lb_type_ = it;
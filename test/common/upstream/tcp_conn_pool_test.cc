@@ -0,0 +1,122 @@
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/upstream/tcp_conn_pool.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Upstream {
+
+class TcpConnPoolTest : public testing::Test {
+public:
+  TcpConnPoolTest()
+      : host_(makeTestHost(cluster_, "tcp://127.0.0.1:80")), pool_(dispatcher_, host_) {
+    ON_CALL(*cluster_, connectTimeout()).WillByDefault(Return(std::chrono::milliseconds(250)));
+  }
+
+  // Expects the next pooled connection, along with its connect timer.
+  NiceMock<Network::MockClientConnection>* expectConnection() {
+    NiceMock<Network::MockClientConnection>* connection =
+        new NiceMock<Network::MockClientConnection>();
+    timers_.push_back(new NiceMock<Event::MockTimer>(&dispatcher_));
+    EXPECT_CALL(dispatcher_, createClientConnection_(_, _)).WillOnce(Return(connection));
+    EXPECT_CALL(*timers_.back(), enableTimer(std::chrono::milliseconds(250)));
+    EXPECT_CALL(*connection, connect());
+    return connection;
+  }
+
+  uint64_t counter(const std::string& name) {
+    return cluster_->stats_store_.counter(name).value();
+  }
+
+  std::shared_ptr<NiceMock<MockClusterInfo>> cluster_{new NiceMock<MockClusterInfo>()};
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  HostSharedPtr host_;
+  std::vector<NiceMock<Event::MockTimer>*> timers_;
+  TcpConnPool pool_;
+};
+
+TEST_F(TcpConnPoolTest, TakeConnected) {
+  NiceMock<Network::MockClientConnection>* connection1 = expectConnection();
+  NiceMock<Network::MockClientConnection>* connection2 = expectConnection();
+  pool_.fill(2);
+  EXPECT_EQ(2U, pool_.size());
+
+  // Nothing is handed out before it is connected.
+  EXPECT_EQ(nullptr, pool_.take().connection_);
+
+  EXPECT_CALL(*timers_[1], disableTimer());
+  EXPECT_CALL(*connection2, readDisable(true));
+  connection2->raiseEvent(Network::ConnectionEvent::Connected);
+
+  EXPECT_CALL(*connection2, readDisable(false));
+  Host::CreateConnectionData data = pool_.take();
+  EXPECT_EQ(connection2, data.connection_.get());
+  EXPECT_EQ(host_, data.host_description_);
+  EXPECT_EQ(1U, pool_.size());
+
+  // The connection is the caller's now, and its events no longer reach the pool.
+  connection2->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(1U, pool_.size());
+
+  // Filling again only replaces the connection which was taken.
+  expectConnection();
+  pool_.fill(2);
+  EXPECT_EQ(2U, pool_.size());
+
+  EXPECT_CALL(*connection1, close(Network::ConnectionCloseType::NoFlush));
+}
+
+TEST_F(TcpConnPoolTest, RemoteClose) {
+  NiceMock<Network::MockClientConnection>* connection = expectConnection();
+  pool_.fill(1);
+  connection->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // A connection closed by the host is dropped and not replaced until the next fill().
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  connection->state_ = Network::Connection::State::Closed;
+  connection->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(0U, pool_.size());
+  EXPECT_EQ(nullptr, pool_.take().connection_);
+}
+
+TEST_F(TcpConnPoolTest, ConnectTimeout) {
+  NiceMock<Network::MockClientConnection>* connection = expectConnection();
+  pool_.fill(1);
+
+  EXPECT_CALL(*connection, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  timers_[0]->callback_();
+  EXPECT_EQ(0U, pool_.size());
+  EXPECT_EQ(1U, counter("upstream_cx_connect_timeout"));
+}
+
+TEST_F(TcpConnPoolTest, DataBeforeConnected) {
+  NiceMock<Network::MockClientConnection>* connection = expectConnection();
+  Network::ReadFilterSharedPtr watcher;
+  EXPECT_CALL(*connection, addReadFilter(_)).WillOnce(SaveArg<0>(&watcher));
+  pool_.fill(1);
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(*connection, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_EQ(Network::FilterStatus::StopIteration, watcher->onData(data));
+  EXPECT_EQ(0U, pool_.size());
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -327,6 +328,40 @@ TEST(HostImplTest, Weight) {
   EXPECT_EQ(100U, host->weight());
 }
 
+TEST(HostImplTest, Stats) {
+  MockCluster cluster;
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", 1);
+  host->stats().rq_total_.inc();
+  host->stats().cx_active_.set(3);
+
+  std::list<Stats::CounterSharedPtr> counters = host->counters();
+  EXPECT_EQ(6UL, counters.size());
+  EXPECT_EQ("cx_total", counters.front()->name());
+  auto rq_total = std::find_if(counters.begin(), counters.end(),
+                               [](const Stats::CounterSharedPtr& counter) -> bool {
+                                 return counter->name() == "rq_total";
+                               });
+  ASSERT_NE(counters.end(), rq_total);
+  EXPECT_EQ(1UL, (*rq_total)->value());
+  EXPECT_TRUE((*rq_total)->used());
+  EXPECT_EQ(1UL, (*rq_total)->latch());
+  EXPECT_EQ(0UL, (*rq_total)->latch());
+
+  std::list<Stats::GaugeSharedPtr> gauges = host->gauges();
+  ASSERT_EQ(2UL, gauges.size());
+  EXPECT_EQ("cx_active", gauges.front()->name());
+  EXPECT_EQ(3UL, gauges.front()->value());
+  EXPECT_EQ("rq_active", gauges.back()->name());
+  EXPECT_FALSE(gauges.back()->used());
+
+  // The stats keep the host alive.
+  Stats::GaugeSharedPtr cx_active = gauges.front();
+  counters.clear();
+  gauges.clear();
+  host.reset();
+  EXPECT_EQ(3UL, cx_active->value());
+}
+
 TEST(HostImplTest, HostnameCanaryAndLocality) {
   MockCluster cluster;
   envoy::api::v2::Metadata metadata;
@@ -347,6 +382,30 @@ TEST(HostImplTest, HostnameCanaryAndLocality) {
   EXPECT_EQ("world", host.locality().sub_zone());
 }
 
+TEST(HostSetImplTest, HealthyLocalityPercentages) {
+  MockCluster cluster;
+  HostSharedPtr host1 = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", 1);
+  HostSharedPtr host2 = makeTestHost(cluster.info_, "tcp://10.0.0.2:1234", 1);
+  HostSharedPtr host3 = makeTestHost(cluster.info_, "tcp://10.0.0.3:1234", 1);
+  HostSharedPtr host4 = makeTestHost(cluster.info_, "tcp://10.0.0.4:1234", 1);
+  HostVectorConstSharedPtr hosts(new std::vector<HostSharedPtr>{host1, host2, host3, host4});
+  HostListsConstSharedPtr hosts_per_locality(
+      new std::vector<std::vector<HostSharedPtr>>{{host1}, {host2, host3, host4}, {}});
+
+  HostSetImpl host_set;
+  EXPECT_TRUE(host_set.healthyLocalityPercentages().empty());
+
+  host_set.updateHosts(hosts, hosts, hosts_per_locality, hosts_per_locality, {}, {});
+  EXPECT_EQ((std::vector<uint64_t>{2500, 7500, 0}), host_set.healthyLocalityPercentages());
+
+  // Without any healthy hosts, every locality is at 0.
+  HostVectorConstSharedPtr no_hosts(new std::vector<HostSharedPtr>());
+  HostListsConstSharedPtr no_hosts_per_locality(
+      new std::vector<std::vector<HostSharedPtr>>{{}, {}});
+  host_set.updateHosts(hosts, no_hosts, hosts_per_locality, no_hosts_per_locality, {}, {});
+  EXPECT_EQ((std::vector<uint64_t>{0, 0}), host_set.healthyLocalityPercentages());
+}
+
 TEST(StaticClusterImplTest, EmptyHostname) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
@@ -507,6 +566,90 @@ TEST(StaticClusterImplTest, HealthyStat) {
   EXPECT_EQ(0UL, cluster.info()->stats().membership_healthy_.value());
 }
 
+TEST(StaticClusterImplTest, CompactStats) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "compact",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "random",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  NiceMock<MockClusterManager> cm;
+  ClusterInfoImpl::configureForTestsOnly(true);
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  ClusterInfoImpl::configureForTestsOnly(false);
+  cluster.initialize([] {});
+
+  // The counters and gauges are not stats of the cluster's scope, but still listed by the store.
+  cluster.info()->stats().upstream_cx_total_.inc();
+  EXPECT_EQ(0UL, stats.counter("cluster.compact.upstream_cx_total").value());
+  uint64_t found = 0;
+  for (const Stats::CounterSharedPtr& counter : stats.dirtyCounters()) {
+    if (counter->name() == "cluster.compact.upstream_cx_total") {
+      EXPECT_EQ(1UL, counter->latch());
+      found++;
+    }
+  }
+  for (const Stats::GaugeSharedPtr& gauge : stats.gauges()) {
+    if (gauge->name() == "cluster.compact.membership_total") {
+      EXPECT_EQ(1UL, gauge->value());
+      found++;
+    }
+  }
+  EXPECT_EQ(2UL, found);
+}
+
+TEST(StaticClusterImplTest, LocalityLoadStats) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "random",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"},
+              {"url": "tcp://10.0.0.2:11002"}]
+  }
+  )EOF";
+
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  cluster.initialize([] {});
+
+  // The load report stats of the hosts are totalled for their locality.
+  cluster.hosts()[0]->stats().rq_success_.inc();
+  cluster.hosts()[1]->stats().rq_success_.add(2);
+  cluster.hosts()[1]->stats().rq_error_.inc();
+  cluster.hosts()[0]->stats().rq_active_.inc();
+  cluster.hosts()[1]->stats().rq_active_.inc();
+  cluster.hosts()[1]->stats().rq_active_.dec();
+
+  LocalityLoadStats& locality_stats =
+      cluster.info()->localityLoadStats(cluster.hosts()[0]->locality());
+  EXPECT_EQ(3UL, locality_stats.rq_success_.latch());
+  EXPECT_EQ(1UL, locality_stats.rq_error_.latch());
+  EXPECT_EQ(1UL, locality_stats.rq_active_.value());
+  EXPECT_EQ(0UL, locality_stats.rq_success_.latch());
+
+  // The hosts keep their own stats.
+  EXPECT_EQ(2UL, cluster.hosts()[1]->stats().rq_success_.value());
+
+  envoy::api::v2::Locality other;
+  other.set_zone("other");
+  EXPECT_NE(&locality_stats, &cluster.info()->localityLoadStats(other));
+  EXPECT_EQ(0UL, cluster.info()->localityLoadStats(other).rq_success_.value());
+}
+
 TEST(StaticClusterImplTest, UrlConfig) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
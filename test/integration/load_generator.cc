@@ -0,0 +1,160 @@
+#include "test/integration/load_generator.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/common/assert.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+
+namespace {
+
+std::chrono::microseconds cpuTime() {
+  struct rusage usage;
+  RELEASE_ASSERT(getrusage(RUSAGE_SELF, &usage) == 0);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+uint64_t maxRssKb() {
+  struct rusage usage;
+  RELEASE_ASSERT(getrusage(RUSAGE_SELF, &usage) == 0);
+  return usage.ru_maxrss;
+}
+
+/**
+ * @return the q quantile of sorted latencies, using the nearest rank.
+ */
+std::chrono::microseconds quantile(const std::vector<std::chrono::microseconds>& latencies,
+                                   double q) {
+  if (latencies.empty()) {
+    return std::chrono::microseconds(0);
+  }
+  const size_t rank = static_cast<size_t>(std::ceil(q * latencies.size()));
+  return latencies[std::min(latencies.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+} // namespace
+
+double LoadStats::requestsPerSecond() const {
+  return duration_.count() > 0 ? requests_ * 1000000.0 / duration_.count() : 0;
+}
+
+std::string LoadStats::toString() const {
+  return fmt::format("requests={} errors={} rps={:.0f} p50_us={} p99_us={} p999_us={} "
+                     "cpu_us_per_request={} max_rss_kb={}",
+                     requests_, errors_, requestsPerSecond(), p50_.count(), p99_.count(),
+                     p999_.count(), cpu_per_request_.count(), max_rss_kb_);
+}
+
+LoadGenerator::LoadGenerator(Event::Dispatcher& dispatcher, const Http::HeaderMap& request_headers)
+    : dispatcher_(dispatcher), request_headers_(request_headers) {}
+
+LoadStats LoadGenerator::run(ConnectionFactory factory, uint32_t connections,
+                             uint32_t streams_per_connection, uint64_t requests) {
+  std::vector<IntegrationCodecClientPtr> clients;
+  for (uint32_t i = 0; i < connections; i++) {
+    clients.push_back(factory());
+    for (uint32_t j = 0; j < streams_per_connection; j++) {
+      slots_.emplace_back(*this, *clients.back());
+    }
+  }
+
+  latencies_.clear();
+  latencies_.reserve(requests);
+  remaining_ = requests;
+  errors_ = 0;
+
+  const std::chrono::microseconds start_cpu = cpuTime();
+  const MonotonicTime start_time = std::chrono::steady_clock::now();
+  for (Slot& slot : slots_) {
+    if (remaining_ == 0) {
+      break;
+    }
+    outstanding_++;
+    remaining_--;
+    slot.start();
+  }
+  if (outstanding_ > 0) {
+    dispatcher_.run(Event::Dispatcher::RunType::Block);
+  }
+
+  LoadStats stats;
+  stats.duration_ = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_time);
+  stats.requests_ = latencies_.size();
+  stats.errors_ = errors_;
+  if (stats.requests_ > 0) {
+    stats.cpu_per_request_ = (cpuTime() - start_cpu) / stats.requests_;
+  }
+  stats.max_rss_kb_ = maxRssKb();
+
+  std::sort(latencies_.begin(), latencies_.end());
+  stats.p50_ = quantile(latencies_, 0.5);
+  stats.p99_ = quantile(latencies_, 0.99);
+  stats.p999_ = quantile(latencies_, 0.999);
+
+  for (IntegrationCodecClientPtr& client : clients) {
+    client->close();
+  }
+  slots_.clear();
+  return stats;
+}
+
+void LoadGenerator::onComplete(Slot& slot, std::chrono::microseconds latency, bool ok) {
+  latencies_.push_back(latency);
+  if (!ok) {
+    errors_++;
+  }
+
+  ASSERT(outstanding_ > 0);
+  outstanding_--;
+  if (remaining_ > 0) {
+    // The next request is started from the event loop rather than from within the codec
+    // callbacks of the one that completed.
+    outstanding_++;
+    remaining_--;
+    dispatcher_.post([&slot]() -> void { slot.start(); });
+  } else if (outstanding_ == 0) {
+    dispatcher_.exit();
+  }
+}
+
+void LoadGenerator::Slot::start() {
+  ok_ = false;
+  start_time_ = std::chrono::steady_clock::now();
+  Http::StreamEncoder& encoder = client_.newStream(*this);
+  encoder.getStream().addCallbacks(*this);
+  encoder.encodeHeaders(parent_.request_headers_, true);
+}
+
+void LoadGenerator::Slot::decodeHeaders(Http::HeaderMapPtr&& headers, bool end_stream) {
+  ok_ = headers->Status() && headers->Status()->value() == "200";
+  if (end_stream) {
+    onComplete();
+  }
+}
+
+void LoadGenerator::Slot::decodeData(Buffer::Instance&, bool end_stream) {
+  if (end_stream) {
+    onComplete();
+  }
+}
+
+void LoadGenerator::Slot::onResetStream(Http::StreamResetReason) {
+  ok_ = false;
+  onComplete();
+}
+
+void LoadGenerator::Slot::onComplete() {
+  parent_.onComplete(*this,
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start_time_),
+                     ok_);
+}
+
+} // namespace Envoy
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+
+#include "common/http/header_map_impl.h"
+
+#include "test/integration/http_integration.h"
+
+namespace Envoy {
+
+/**
+ * Results of a load run. CPU time and RSS are those of the whole test process, which includes the
+ * load generator and the fake upstreams as well as Envoy, so they are meant to be compared across
+ * builds rather than read as the cost of Envoy alone.
+ */
+struct LoadStats {
+  uint64_t requests_{};
+  uint64_t errors_{};
+  std::chrono::microseconds duration_{};
+  std::chrono::microseconds p50_{};
+  std::chrono::microseconds p99_{};
+  std::chrono::microseconds p999_{};
+  std::chrono::microseconds cpu_per_request_{};
+  uint64_t max_rss_kb_{};
+
+  double requestsPerSecond() const;
+  std::string toString() const;
+};
+
+/**
+ * Drives requests through a set of connections at a fixed concurrency: every connection keeps
+ * streams_per_connection requests outstanding until the requested number of requests has been
+ * sent. All of it runs on the dispatcher of the connections.
+ */
+class LoadGenerator {
+public:
+  typedef std::function<IntegrationCodecClientPtr()> ConnectionFactory;
+
+  LoadGenerator(Event::Dispatcher& dispatcher, const Http::HeaderMap& request_headers);
+
+  /**
+   * Run requests requests over connections connections with streams_per_connection requests in
+   * flight on each, and wait for all the responses.
+   */
+  LoadStats run(ConnectionFactory factory, uint32_t connections, uint32_t streams_per_connection,
+                uint64_t requests);
+
+private:
+  class Slot : public Http::StreamDecoder, public Http::StreamCallbacks {
+  public:
+    Slot(LoadGenerator& parent, IntegrationCodecClient& client)
+        : parent_(parent), client_(client) {}
+
+    void start();
+
+    // Http::StreamDecoder
+    void decodeHeaders(Http::HeaderMapPtr&& headers, bool end_stream) override;
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeTrailers(Http::HeaderMapPtr&&) override { onComplete(); }
+
+    // Http::StreamCallbacks
+    void onResetStream(Http::StreamResetReason) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+  private:
+    void onComplete();
+
+    LoadGenerator& parent_;
+    IntegrationCodecClient& client_;
+    MonotonicTime start_time_;
+    bool ok_{};
+  };
+
+  void onComplete(Slot& slot, std::chrono::microseconds latency, bool ok);
+
+  Event::Dispatcher& dispatcher_;
+  const Http::HeaderMapImpl request_headers_;
+  std::list<Slot> slots_;
+  std::vector<std::chrono::microseconds> latencies_;
+  uint64_t remaining_{};
+  uint64_t outstanding_{};
+  uint64_t errors_{};
+};
+
+} // namespace Envoy
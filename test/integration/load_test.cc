@@ -0,0 +1,96 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "common/common/utility.h"
+
+#include "test/integration/autonomous_upstream.h"
+#include "test/integration/http_integration.h"
+#include "test/integration/load_generator.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+// The size of a run can be changed with these environment variables, e.g. with
+// bazel test --test_env=ENVOY_LOAD_TEST_REQUESTS=100000 -c opt //test/integration:load_test
+uint64_t loadTestParameter(const char* name, uint64_t default_value) {
+  const char* value = ::getenv(name);
+  uint64_t out;
+  return value != nullptr && StringUtil::atoul(value, out) ? out : default_value;
+}
+
+uint64_t requests() { return loadTestParameter("ENVOY_LOAD_TEST_REQUESTS", 2000); }
+uint32_t concurrency() { return loadTestParameter("ENVOY_LOAD_TEST_CONCURRENCY", 10); }
+
+/**
+ * Load test of Envoy end to end, against upstreams which answer every request on their own. The
+ * results are printed, and recorded as properties of the test in its XML output, so that a build
+ * can be compared with an earlier one.
+ */
+class LoadTest : public HttpIntegrationTest,
+                 public testing::TestWithParam<Network::Address::IpVersion> {
+public:
+  LoadTest() : HttpIntegrationTest(Http::CodecClient::Type::HTTP1, GetParam()) {}
+
+  void runLoad(const std::string& name, uint32_t port, uint32_t connections,
+               uint32_t streams_per_connection) {
+    Http::TestHeaderMapImpl request_headers{{":method", "GET"},
+                                            {":path", "/test/long/url"},
+                                            {":scheme", "http"},
+                                            {":authority", "host"}};
+    LoadGenerator generator(*dispatcher_, request_headers);
+    const LoadStats stats = generator.run(
+        [this, port]() -> IntegrationCodecClientPtr { return makeHttpConnection(port); },
+        connections, streams_per_connection, requests());
+
+    std::cout << name << ": " << stats.toString() << std::endl;
+    RecordProperty("requests", std::to_string(stats.requests_));
+    RecordProperty("errors", std::to_string(stats.errors_));
+    RecordProperty("rps", std::to_string(static_cast<uint64_t>(stats.requestsPerSecond())));
+    RecordProperty("p50_us", std::to_string(stats.p50_.count()));
+    RecordProperty("p99_us", std::to_string(stats.p99_.count()));
+    RecordProperty("p999_us", std::to_string(stats.p999_.count()));
+    RecordProperty("cpu_us_per_request", std::to_string(stats.cpu_per_request_.count()));
+    RecordProperty("max_rss_kb", std::to_string(stats.max_rss_kb_));
+
+    EXPECT_EQ(requests(), stats.requests_);
+    EXPECT_EQ(0U, stats.errors_);
+  }
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, LoadTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+// HTTP/1.1 downstream, with one request in flight on each of the connections.
+TEST_P(LoadTest, Http1) {
+  autonomous_upstream_ = true;
+  initialize();
+  runLoad("http1", lookupPort("http"), concurrency(), 1);
+}
+
+// HTTP/2 downstream, with all the requests in flight on one connection.
+TEST_P(LoadTest, Http2) {
+  setDownstreamProtocol(Http::CodecClient::Type::HTTP2);
+  autonomous_upstream_ = true;
+  initialize();
+  runLoad("http2", lookupPort("http"), 1, concurrency());
+}
+
+// TCP proxy, which carries HTTP/1.1 connections to the upstreams.
+TEST_P(LoadTest, TcpProxy) {
+  fake_upstreams_.emplace_back(
+      new AutonomousUpstream(0, FakeHttpConnection::Type::HTTP1, version_));
+  registerPort("upstream_0", fake_upstreams_.back()->localAddress()->ip()->port());
+  fake_upstreams_.emplace_back(
+      new AutonomousUpstream(0, FakeHttpConnection::Type::HTTP1, version_));
+  registerPort("cluster_with_buffer_limits", fake_upstreams_.back()->localAddress()->ip()->port());
+  createTestServer("test/config/integration/tcp_proxy.json",
+                   {"tcp_proxy", "tcp_proxy_with_write_limits", "tcp_proxy_with_tls_termination"});
+  runLoad("tcp_proxy", lookupPort("tcp_proxy"), concurrency(), 1);
+}
+
+} // namespace
+} // namespace Envoy
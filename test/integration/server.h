@@ -39,6 +39,7 @@ public:
   const std::string& adminAddressPath() override { return admin_address_path_; }
   Network::Address::IpVersion localAddressIpVersion() override { return local_address_ip_version_; }
   std::chrono::seconds drainTime() override { return std::chrono::seconds(1); }
+  uint32_t drainRate() override { return 0; }
   spdlog::level::level_enum logLevel() override { NOT_IMPLEMENTED; }
   std::chrono::seconds parentShutdownTime() override { return std::chrono::seconds(2); }
   const std::string& logPath() override { return log_path_; }
@@ -52,6 +53,23 @@ public:
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return 16384; }
   uint64_t maxObjNameLength() override { return 60; }
+  uint32_t hostStatsShards() override { return 1; }
+  uint32_t counterShards() override { return 1; }
+  bool compactClusterStats() override { return false; }
+  std::chrono::milliseconds dnsCacheTtl() override { return std::chrono::milliseconds(0); }
+  bool reusePort() override { return false; }
+  bool balanceConnections() override { return false; }
+  bool dispatcherStats() override { return false; }
+  bool workerStats() override { return false; }
+  bool inPlaceListenerUpdates() override { return false; }
+  std::chrono::milliseconds idleMemoryRelease() override { return std::chrono::milliseconds(0); }
+  std::chrono::microseconds busyPoll() override { return std::chrono::microseconds(0); }
+  std::chrono::microseconds deferredDeleteBudget() override {
+    return std::chrono::microseconds(0);
+  }
+  const std::vector<uint32_t>& workerCpus() override { return worker_cpus_; }
+  bool reusePortIncomingCpu() override { return false; }
+  uint64_t asyncLogBufferSize() override { return 0; }
 
 private:
   const std::string config_path_;
@@ -61,6 +79,7 @@ private:
   const std::string service_node_name_;
   const std::string service_zone_;
   const std::string log_path_;
+  const std::vector<uint32_t> worker_cpus_;
 };
 
 class TestDrainManager : public DrainManager {
@@ -157,10 +176,22 @@ public:
     std::unique_lock<std::mutex> lock(lock_);
     return store_.counters();
   }
+  std::list<CounterSharedPtr> dirtyCounters() override {
+    std::unique_lock<std::mutex> lock(lock_);
+    return store_.dirtyCounters();
+  }
   std::list<GaugeSharedPtr> gauges() const override {
     std::unique_lock<std::mutex> lock(lock_);
     return store_.gauges();
   }
+  std::list<ParentHistogramSharedPtr> histograms() const override {
+    std::unique_lock<std::mutex> lock(lock_);
+    return store_.histograms();
+  }
+  void addStatsBlock(StatsBlockSharedPtr block) override {
+    std::unique_lock<std::mutex> lock(lock_);
+    store_.addStatsBlock(std::move(block));
+  }
 
   // Stats::StoreRoot
   void addSink(Sink&) override {}
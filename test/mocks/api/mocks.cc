@@ -1,5 +1,7 @@
 #include "mocks.h"
 
+#include <string>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -37,5 +39,15 @@ ssize_t MockOsSysCalls::write(int fd, const void* buffer, size_t num_bytes) {
   return result;
 }
 
+ssize_t MockOsSysCalls::writev(int fd, const iovec* iov, int num_iov) {
+  // Gathered writes are seen by write_() as a single write of everything they gather.
+  std::string data;
+  for (int i = 0; i < num_iov; i++) {
+    data.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+
+  return write(fd, data.data(), data.size());
+}
+
 } // namespace Api
 } // namespace Envoy
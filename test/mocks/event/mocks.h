@@ -67,6 +67,9 @@ public:
 
   TimerPtr createTimer(TimerCb cb) override { return TimerPtr{createTimer_(cb)}; }
 
+  // Coarse timers are created through createTimer_() too, so that tests need not tell them apart.
+  TimerPtr createCoarseTimer(TimerCb cb) override { return TimerPtr{createTimer_(cb)}; }
+
   void deferredDelete(DeferredDeletablePtr&& to_delete) override {
     deferredDelete_(to_delete);
     if (to_delete) {
@@ -80,6 +83,10 @@ public:
 
   // Event::Dispatcher
   MOCK_METHOD0(clearDeferredDeleteList, void());
+  MOCK_METHOD2(initializeStats, void(Stats::Scope& scope, const std::string& prefix));
+  MOCK_METHOD3(enableBusyPoll, void(std::chrono::microseconds budget, Stats::Scope& scope,
+                                    const std::string& prefix));
+  MOCK_METHOD1(setDeferredDeleteBudget, void(std::chrono::microseconds budget));
   MOCK_METHOD2(createClientConnection_,
                Network::ClientConnection*(Network::Address::InstanceConstSharedPtr address,
                                           Network::Address::InstanceConstSharedPtr source_address));
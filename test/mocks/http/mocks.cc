@@ -170,7 +170,7 @@ MockInstance::~MockInstance() {}
 namespace Http {
 namespace AccessLog {
 
-MockInstance::MockInstance() {}
+MockInstance::MockInstance() { ON_CALL(*this, mayLog(_)).WillByDefault(Return(true)); }
 MockInstance::~MockInstance() {}
 
 MockRequestInfo::MockRequestInfo() {
@@ -37,6 +37,7 @@ public:
   // Http::AccessLog::Instance
   MOCK_METHOD3(log, void(const Http::HeaderMap* request_headers,
                          const Http::HeaderMap* response_headers, const RequestInfo& request_info));
+  MOCK_METHOD1(mayLog, bool(const Http::HeaderMap& request_headers));
 };
 
 class MockRequestInfo : public RequestInfo {
@@ -91,6 +92,7 @@ public:
   MOCK_METHOD0(drainTimeout, std::chrono::milliseconds());
   MOCK_METHOD0(filterFactory, FilterChainFactory&());
   MOCK_METHOD0(generateRequestId, bool());
+  MOCK_METHOD0(rejectNewStreams, bool());
   MOCK_METHOD0(idleTimeout, const Optional<std::chrono::milliseconds>&());
   MOCK_METHOD0(routeConfigProvider, Router::RouteConfigProvider&());
   MOCK_METHOD0(serverName, const std::string&());
@@ -207,6 +209,7 @@ public:
   MOCK_METHOD0(wantsToWrite, bool());
   MOCK_METHOD0(onUnderlyingConnectionAboveWriteBufferHighWatermark, void());
   MOCK_METHOD0(onUnderlyingConnectionBelowWriteBufferLowWatermark, void());
+  MOCK_METHOD0(shrink, void());
 
   Protocol protocol_{Protocol::Http11};
 };
@@ -224,6 +227,7 @@ public:
   MOCK_METHOD0(wantsToWrite, bool());
   MOCK_METHOD0(onUnderlyingConnectionAboveWriteBufferHighWatermark, void());
   MOCK_METHOD0(onUnderlyingConnectionBelowWriteBufferLowWatermark, void());
+  MOCK_METHOD0(shrink, void());
 
   // Http::ClientConnection
   MOCK_METHOD1(newStream, StreamEncoder&(StreamDecoder& response_decoder));
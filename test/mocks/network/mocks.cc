@@ -142,5 +142,10 @@ MockListener::~MockListener() { onDestroy(); }
 MockConnectionHandler::MockConnectionHandler() {}
 MockConnectionHandler::~MockConnectionHandler() {}
 
+MockBalancedConnectionHandler::MockBalancedConnectionHandler() {
+  ON_CALL(*this, dispatcher()).WillByDefault(ReturnRef(dispatcher_));
+}
+MockBalancedConnectionHandler::~MockBalancedConnectionHandler() {}
+
 } // namespace Network
 } // namespace Envoy
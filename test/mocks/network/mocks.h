@@ -65,6 +65,8 @@ public:
   MOCK_CONST_METHOD0(remoteAddress, const Address::Instance&());
   MOCK_CONST_METHOD0(localAddress, const Address::Instance&());
   MOCK_METHOD1(setConnectionStats, void(const ConnectionStats& stats));
+  MOCK_METHOD1(setWorkerStats, void(const WorkerStats& stats));
+  MOCK_CONST_METHOD0(workerStats, const WorkerStats*());
   MOCK_METHOD0(ssl, Ssl::Connection*());
   MOCK_CONST_METHOD0(ssl, const Ssl::Connection*());
   MOCK_CONST_METHOD0(state, State());
@@ -73,6 +75,9 @@ public:
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD1(enableIdleMemoryRelease, void(std::chrono::milliseconds period));
+  MOCK_METHOD1(addMemoryReleaseCallback, void(std::function<void()> cb));
+  MOCK_METHOD1(spliceWith, bool(Connection& peer));
 };
 
 /**
@@ -101,6 +106,8 @@ public:
   MOCK_CONST_METHOD0(remoteAddress, const Address::Instance&());
   MOCK_CONST_METHOD0(localAddress, const Address::Instance&());
   MOCK_METHOD1(setConnectionStats, void(const ConnectionStats& stats));
+  MOCK_METHOD1(setWorkerStats, void(const WorkerStats& stats));
+  MOCK_CONST_METHOD0(workerStats, const WorkerStats*());
   MOCK_METHOD0(ssl, Ssl::Connection*());
   MOCK_CONST_METHOD0(ssl, const Ssl::Connection*());
   MOCK_CONST_METHOD0(state, State());
@@ -109,6 +116,9 @@ public:
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD1(enableIdleMemoryRelease, void(std::chrono::milliseconds period));
+  MOCK_METHOD1(addMemoryReleaseCallback, void(std::function<void()> cb));
+  MOCK_METHOD1(spliceWith, bool(Connection& peer));
 
   // Network::ClientConnection
   MOCK_METHOD0(connect, void());
@@ -226,6 +236,8 @@ public:
   ~MockListener();
 
   MOCK_METHOD0(onDestroy, void());
+  MOCK_METHOD0(disable, void());
+  MOCK_METHOD0(enable, void());
 };
 
 class MockConnectionHandler : public ConnectionHandler {
@@ -247,6 +259,21 @@ public:
   MOCK_METHOD1(removeListeners, void(uint64_t listener_tag));
   MOCK_METHOD1(stopListeners, void(uint64_t listener_tag));
   MOCK_METHOD0(stopListeners, void());
+  MOCK_METHOD0(disableListeners, void());
+  MOCK_METHOD0(enableListeners, void());
+};
+
+class MockBalancedConnectionHandler : public BalancedConnectionHandler {
+public:
+  MockBalancedConnectionHandler();
+  ~MockBalancedConnectionHandler();
+
+  MOCK_METHOD0(numConnections, uint64_t());
+  MOCK_METHOD0(dispatcher, Event::Dispatcher&());
+  MOCK_METHOD3(onBalancedConnection,
+               void(int fd, const sockaddr_storage& remote_addr, socklen_t remote_addr_len));
+
+  testing::NiceMock<Event::MockDispatcher> dispatcher_;
 };
 
 class MockResolvedAddress : public Address::Instance {
@@ -40,6 +40,14 @@ class TestCorsPolicy : public CorsPolicy {
 public:
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
+  bool allowsOrigin(const std::string& origin) const override {
+    for (const auto& o : allow_origin_) {
+      if (o == "*" || o == origin) {
+        return true;
+      }
+    }
+    return false;
+  }
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -79,6 +87,7 @@ public:
   MOCK_METHOD3(shouldRetry, RetryStatus(const Http::HeaderMap* response_headers,
                                         const Optional<Http::StreamResetReason>& reset_reason,
                                         DoRetryCallback callback));
+  MOCK_METHOD0(shouldHedge, bool());
 
   DoRetryCallback callback_;
 };
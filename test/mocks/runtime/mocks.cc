@@ -3,6 +3,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::Return;
 using testing::ReturnArg;
 using testing::_;
@@ -10,11 +11,20 @@ using testing::_;
 namespace Envoy {
 namespace Runtime {
 
-MockRandomGenerator::MockRandomGenerator() { ON_CALL(*this, uuid()).WillByDefault(Return(uuid_)); }
+MockRandomGenerator::MockRandomGenerator() {
+  ON_CALL(*this, uuid()).WillByDefault(Return(uuid_));
+  ON_CALL(*this, uuid(_)).WillByDefault(Invoke([this](char* out) -> void {
+    uuid_.copy(out, uuid_.size());
+  }));
+}
 
 MockRandomGenerator::~MockRandomGenerator() {}
 
-MockSnapshot::MockSnapshot() { ON_CALL(*this, getInteger(_, _)).WillByDefault(ReturnArg<1>()); }
+MockSnapshot::MockSnapshot() {
+  ON_CALL(*this, getInteger(_, _)).WillByDefault(ReturnArg<1>());
+  // Unless a test says otherwise, any key may be set.
+  ON_CALL(*this, hasKeyWithPrefix(_)).WillByDefault(Return(true));
+}
 
 MockSnapshot::~MockSnapshot() {}
 
@@ -17,6 +17,7 @@ public:
 
   MOCK_METHOD0(random, uint64_t());
   MOCK_METHOD0(uuid, std::string());
+  MOCK_METHOD1(uuid, void(char* out));
 
   const std::string uuid_{"a121e9e1-feae-4136-9e0e-6fac343d56c9"};
 };
@@ -33,6 +34,25 @@ public:
                                           uint64_t random_value, uint16_t num_buckets));
   MOCK_CONST_METHOD1(get, const std::string&(const std::string& key));
   MOCK_CONST_METHOD2(getInteger, uint64_t(const std::string& key, uint64_t default_value));
+  MOCK_CONST_METHOD0(generation, uint64_t());
+  MOCK_CONST_METHOD1(hasKeyWithPrefix, bool(const std::string& prefix));
+
+  // Registered keys are looked up by name, so that expectations do not depend on how the code
+  // under test looks up a key.
+  bool featureEnabled(const Key& key, uint64_t default_value) const override {
+    return featureEnabled(key.name_, default_value);
+  }
+  bool featureEnabled(const Key& key, uint64_t default_value,
+                      uint64_t random_value) const override {
+    return featureEnabled(key.name_, default_value, random_value);
+  }
+  bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                      uint16_t num_buckets) const override {
+    return featureEnabled(key.name_, default_value, random_value, num_buckets);
+  }
+  uint64_t getInteger(const Key& key, uint64_t default_value) const override {
+    return getInteger(key.name_, default_value);
+  }
 };
 
 class MockLoader : public Loader {
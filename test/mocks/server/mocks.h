@@ -11,6 +11,7 @@
 #include "envoy/server/filter_config.h"
 #include "envoy/server/instance.h"
 #include "envoy/server/options.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/server/worker.h"
 #include "envoy/ssl/context_manager.h"
 
@@ -49,6 +50,7 @@ public:
   MOCK_METHOD0(adminAddressPath, const std::string&());
   MOCK_METHOD0(localAddressIpVersion, Network::Address::IpVersion());
   MOCK_METHOD0(drainTime, std::chrono::seconds());
+  MOCK_METHOD0(drainRate, uint32_t());
   MOCK_METHOD0(logLevel, spdlog::level::level_enum());
   MOCK_METHOD0(logPath, const std::string&());
   MOCK_METHOD0(parentShutdownTime, std::chrono::seconds());
@@ -60,9 +62,25 @@ public:
   MOCK_METHOD0(serviceZone, const std::string&());
   MOCK_METHOD0(maxStats, uint64_t());
   MOCK_METHOD0(maxObjNameLength, uint64_t());
+  MOCK_METHOD0(hostStatsShards, uint32_t());
+  MOCK_METHOD0(counterShards, uint32_t());
+  MOCK_METHOD0(compactClusterStats, bool());
+  MOCK_METHOD0(dnsCacheTtl, std::chrono::milliseconds());
+  MOCK_METHOD0(reusePort, bool());
+  MOCK_METHOD0(balanceConnections, bool());
+  MOCK_METHOD0(dispatcherStats, bool());
+  MOCK_METHOD0(workerStats, bool());
+  MOCK_METHOD0(inPlaceListenerUpdates, bool());
+  MOCK_METHOD0(idleMemoryRelease, std::chrono::milliseconds());
+  MOCK_METHOD0(busyPoll, std::chrono::microseconds());
+  MOCK_METHOD0(deferredDeleteBudget, std::chrono::microseconds());
+  MOCK_METHOD0(workerCpus, const std::vector<uint32_t>&());
+  MOCK_METHOD0(reusePortIncomingCpu, bool());
+  MOCK_METHOD0(asyncLogBufferSize, uint64_t());
 
   std::string config_path_;
   std::string admin_address_path_;
+  std::vector<uint32_t> worker_cpus_;
   std::string service_cluster_name_;
   std::string service_node_name_;
   std::string service_zone_name_;
@@ -94,6 +112,17 @@ public:
   std::function<void()> drain_sequence_completion_;
 };
 
+class MockOverloadManager : public OverloadManager {
+public:
+  MockOverloadManager();
+  ~MockOverloadManager();
+
+  // Server::OverloadManager
+  MOCK_CONST_METHOD0(disableKeepalive, bool());
+  MOCK_CONST_METHOD0(stopAcceptingConnections, bool());
+  MOCK_CONST_METHOD0(rejectNewStreams, bool());
+};
+
 class MockWatchDog : public WatchDog {
 public:
   MockWatchDog();
@@ -125,7 +154,8 @@ public:
 
   // Server::HotRestart
   MOCK_METHOD0(drainParentListeners, void());
-  MOCK_METHOD1(duplicateParentListenSocket, int(const std::string& address));
+  MOCK_METHOD2(duplicateParentListenSocket,
+               int(const std::string& address, uint32_t worker_index));
   MOCK_METHOD1(getParentStats, void(GetParentStatsInfo& info));
   MOCK_METHOD2(initialize, void(Event::Dispatcher& dispatcher, Server::Instance& server));
   MOCK_METHOD1(shutdownParentAdmin, void(ShutdownParentAdminInfo& info));
@@ -148,6 +178,9 @@ public:
   MOCK_METHOD2(createListenSocket,
                Network::ListenSocketSharedPtr(Network::Address::InstanceConstSharedPtr address,
                                               bool bind_to_port));
+  MOCK_METHOD2(createReusePortListenSocket,
+               Network::ListenSocketSharedPtr(Network::Address::InstanceConstSharedPtr address,
+                                              uint32_t worker_index));
   MOCK_METHOD0(createDrainManager_, DrainManager*());
   MOCK_METHOD0(nextListenerTag, uint64_t());
 
@@ -165,6 +198,8 @@ public:
   MOCK_METHOD1(removeListener, bool(const std::string& listener_name));
   MOCK_METHOD1(startWorkers, void(GuardDog& guard_dog));
   MOCK_METHOD0(stopListeners, void());
+  MOCK_METHOD0(disableListeners, void());
+  MOCK_METHOD0(enableListeners, void());
   MOCK_METHOD0(stopWorkers, void());
 };
 
@@ -175,6 +210,8 @@ public:
 
   MOCK_METHOD0(filterChainFactory, Network::FilterChainFactory&());
   MOCK_METHOD0(socket, Network::ListenSocket&());
+  MOCK_METHOD1(workerSocket, Network::ListenSocket&(uint32_t worker_index));
+  MOCK_METHOD0(connectionBalancer, Network::ConnectionBalancerSharedPtr());
   MOCK_METHOD0(sslContext, Ssl::ServerContext*());
   MOCK_METHOD0(useProxyProto, bool());
   MOCK_METHOD0(bindToPort, bool());
@@ -226,6 +263,8 @@ public:
   MOCK_METHOD0(stop, void());
   MOCK_METHOD1(stopListener, void(Listener& listener));
   MOCK_METHOD0(stopListeners, void());
+  MOCK_METHOD0(disableListeners, void());
+  MOCK_METHOD0(enableListeners, void());
 
   AddListenerCompletion add_listener_completion_;
   std::function<void()> remove_listener_completion_;
@@ -257,6 +296,7 @@ public:
   MOCK_METHOD0(initManager, Init::Manager&());
   MOCK_METHOD0(listenerManager, ListenerManager&());
   MOCK_METHOD0(options, Options&());
+  MOCK_METHOD0(overloadManager, OverloadManager&());
   MOCK_METHOD0(random, Runtime::RandomGenerator&());
   MOCK_METHOD0(rateLimitClient_, RateLimit::Client*());
   MOCK_METHOD0(runtime, Runtime::Loader&());
@@ -290,6 +330,7 @@ public:
   testing::NiceMock<LocalInfo::MockLocalInfo> local_info_;
   testing::NiceMock<Init::MockManager> init_manager_;
   testing::NiceMock<MockListenerManager> listener_manager_;
+  testing::NiceMock<MockOverloadManager> overload_manager_;
   Singleton::ManagerPtr singleton_manager_;
 };
 
@@ -333,6 +374,7 @@ public:
   MOCK_METHOD0(httpTracer, Tracing::HttpTracer&());
   MOCK_METHOD0(initManager, Init::Manager&());
   MOCK_METHOD0(localInfo, const LocalInfo::LocalInfo&());
+  MOCK_METHOD0(overloadManager, Server::OverloadManager&());
   MOCK_METHOD0(random, Envoy::Runtime::RandomGenerator&());
   MOCK_METHOD0(rateLimitClient_, RateLimit::Client*());
   MOCK_METHOD0(runtime, Envoy::Runtime::Loader&());
@@ -349,6 +391,7 @@ public:
   testing::NiceMock<Tracing::MockHttpTracer> http_tracer_;
   testing::NiceMock<Init::MockManager> init_manager_;
   testing::NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  testing::NiceMock<MockOverloadManager> overload_manager_;
   testing::NiceMock<Envoy::Runtime::MockRandomGenerator> random_;
   testing::NiceMock<Envoy::Runtime::MockLoader> runtime_loader_;
   Stats::IsolatedStoreImpl scope_;
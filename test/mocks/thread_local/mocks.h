@@ -22,6 +22,8 @@ public:
   // Server::ThreadLocal
   MOCK_METHOD0(allocateSlot, SlotPtr());
   MOCK_METHOD2(registerThread, void(Event::Dispatcher& dispatcher, bool main_thread));
+  MOCK_METHOD0(startBatch, void());
+  MOCK_METHOD0(endBatch, void());
   MOCK_METHOD0(shutdownGlobalThreading, void());
   MOCK_METHOD0(shutdownThread, void());
 
@@ -50,7 +52,7 @@ public:
     }
 
     // ThreadLocal::Slot
-    ThreadLocalObjectSharedPtr get() override { return parent_.data_[index_]; }
+    ThreadLocalObjectSharedPtr& get() override { return parent_.data_[index_]; }
     void runOnAllThreads(Event::PostCb cb) override { parent_.runOnAllThreads(cb); }
     void set(InitializeCb cb) override { parent_.data_[index_] = cb(parent_.dispatcher_); }
 
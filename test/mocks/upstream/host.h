@@ -29,6 +29,8 @@ public:
   MOCK_METHOD0(lastUnejectionTime, const Optional<MonotonicTime>&());
   MOCK_CONST_METHOD0(successRate, double());
   MOCK_METHOD1(successRate, void(double new_success_rate));
+  MOCK_CONST_METHOD0(peakEwmaResponseTime, double());
+  MOCK_CONST_METHOD0(p99ResponseTime, double());
 };
 
 class MockEventLogger : public EventLogger {
@@ -55,6 +57,8 @@ public:
   MOCK_METHOD1(addChangedStateCb, void(ChangeStateCb cb));
   MOCK_CONST_METHOD0(successRateAverage, double());
   MOCK_CONST_METHOD0(successRateEjectionThreshold, double());
+  MOCK_CONST_METHOD0(p99ResponseTimeAverage, double());
+  MOCK_CONST_METHOD0(p99ResponseTimeEjectionThreshold, double());
 
   std::list<ChangeStateCb> callbacks_;
 };
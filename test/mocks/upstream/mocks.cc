@@ -74,6 +74,8 @@ MockLoadBalancerSubsetInfo::~MockLoadBalancerSubsetInfo() {}
 MockClusterInfo::MockClusterInfo()
     : stats_(ClusterInfoImpl::generateStats(stats_store_)),
       load_report_stats_(ClusterInfoImpl::generateLoadReportStats(load_report_stats_store_)),
+      locality_load_stats_{ALL_HOST_LOAD_STATS(POOL_COUNTER(load_report_stats_store_),
+                                               POOL_GAUGE(load_report_stats_store_))},
       resource_manager_(new Upstream::ResourceManagerImpl(runtime_, "fake_key", 1, 1024, 1024, 1)) {
 
   ON_CALL(*this, connectTimeout()).WillByDefault(Return(std::chrono::milliseconds(1)));
@@ -84,6 +86,7 @@ MockClusterInfo::MockClusterInfo()
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, statsScope()).WillByDefault(ReturnRef(stats_store_));
   ON_CALL(*this, loadReportStats()).WillByDefault(ReturnRef(load_report_stats_));
+  ON_CALL(*this, localityLoadStats(_)).WillByDefault(ReturnRef(locality_load_stats_));
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
   ON_CALL(*this, resourceManager(_))
       .WillByDefault(Invoke(
@@ -104,6 +107,26 @@ MockCluster::MockCluster() {
   ON_CALL(*this, healthyHosts()).WillByDefault(ReturnRef(healthy_hosts_));
   ON_CALL(*this, hostsPerLocality()).WillByDefault(ReturnRef(hosts_per_locality_));
   ON_CALL(*this, healthyHostsPerLocality()).WillByDefault(ReturnRef(healthy_hosts_per_locality_));
+  ON_CALL(*this, healthyLocalityPercentages())
+      .WillByDefault(Invoke([this]() -> const std::vector<uint64_t>& {
+        HostSetImpl::calculateLocalityPercentages(healthy_hosts_per_locality_,
+                                                  healthy_locality_percentages_);
+        return healthy_locality_percentages_;
+      }));
+  ON_CALL(*this, hostsPtr()).WillByDefault(Invoke([this]() -> HostVectorConstSharedPtr {
+    return std::make_shared<const std::vector<HostSharedPtr>>(hosts_);
+  }));
+  ON_CALL(*this, healthyHostsPtr()).WillByDefault(Invoke([this]() -> HostVectorConstSharedPtr {
+    return std::make_shared<const std::vector<HostSharedPtr>>(healthy_hosts_);
+  }));
+  ON_CALL(*this, hostsPerLocalityPtr()).WillByDefault(Invoke([this]() -> HostListsConstSharedPtr {
+    return std::make_shared<const std::vector<std::vector<HostSharedPtr>>>(hosts_per_locality_);
+  }));
+  ON_CALL(*this, healthyHostsPerLocalityPtr())
+      .WillByDefault(Invoke([this]() -> HostListsConstSharedPtr {
+        return std::make_shared<const std::vector<std::vector<HostSharedPtr>>>(
+            healthy_hosts_per_locality_);
+      }));
   ON_CALL(*this, info()).WillByDefault(Return(info_));
   ON_CALL(*this, initialize(_))
       .WillByDefault(Invoke([this](std::function<void()> callback) -> void {
@@ -118,16 +141,21 @@ MockLoadBalancer::MockLoadBalancer() { ON_CALL(*this, chooseHost(_)).WillByDefau
 
 MockLoadBalancer::~MockLoadBalancer() {}
 
+MockResponseTimeTracker::MockResponseTimeTracker() {}
+MockResponseTimeTracker::~MockResponseTimeTracker() {}
+
 MockThreadLocalCluster::MockThreadLocalCluster() {
   ON_CALL(*this, hostSet()).WillByDefault(ReturnRef(cluster_));
   ON_CALL(*this, info()).WillByDefault(Return(cluster_.info_));
   ON_CALL(*this, loadBalancer()).WillByDefault(ReturnRef(lb_));
+  ON_CALL(*this, responseTimes()).WillByDefault(ReturnRef(response_times_));
 }
 
 MockThreadLocalCluster::~MockThreadLocalCluster() {}
 
 MockClusterManager::MockClusterManager() {
   ON_CALL(*this, httpConnPoolForCluster(_, _, _)).WillByDefault(Return(&conn_pool_));
+  ON_CALL(thread_local_cluster_, httpConnPool(_, _)).WillByDefault(Return(&conn_pool_));
   ON_CALL(*this, httpAsyncClientForCluster(_)).WillByDefault(ReturnRef(async_client_));
   ON_CALL(*this, httpAsyncClientForCluster(_)).WillByDefault((ReturnRef(async_client_)));
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
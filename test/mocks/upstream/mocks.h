@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <list>
 #include <memory>
@@ -43,6 +44,11 @@ public:
   MOCK_CONST_METHOD0(healthyHosts, const std::vector<HostSharedPtr>&());
   MOCK_CONST_METHOD0(hostsPerLocality, const std::vector<std::vector<HostSharedPtr>>&());
   MOCK_CONST_METHOD0(healthyHostsPerLocality, const std::vector<std::vector<HostSharedPtr>>&());
+  MOCK_CONST_METHOD0(healthyLocalityPercentages, const std::vector<uint64_t>&());
+  MOCK_CONST_METHOD0(hostsPtr, HostVectorConstSharedPtr());
+  MOCK_CONST_METHOD0(healthyHostsPtr, HostVectorConstSharedPtr());
+  MOCK_CONST_METHOD0(hostsPerLocalityPtr, HostListsConstSharedPtr());
+  MOCK_CONST_METHOD0(healthyHostsPerLocalityPtr, HostListsConstSharedPtr());
 
   // Upstream::Cluster
   MOCK_CONST_METHOD0(info, ClusterInfoConstSharedPtr());
@@ -55,6 +61,7 @@ public:
   std::vector<HostSharedPtr> healthy_hosts_;
   std::vector<std::vector<HostSharedPtr>> hosts_per_locality_;
   std::vector<std::vector<HostSharedPtr>> healthy_hosts_per_locality_;
+  std::vector<uint64_t> healthy_locality_percentages_;
   Common::CallbackManager<const std::vector<HostSharedPtr>&, const std::vector<HostSharedPtr>&>
       member_update_cb_helper_;
   std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
@@ -73,6 +80,16 @@ public:
   std::shared_ptr<MockHost> host_{new MockHost()};
 };
 
+class MockResponseTimeTracker : public ResponseTimeTracker {
+public:
+  MockResponseTimeTracker();
+  ~MockResponseTimeTracker();
+
+  // Upstream::ResponseTimeTracker
+  MOCK_METHOD1(recordResponseTime, void(std::chrono::milliseconds response_time));
+  MOCK_METHOD1(responseTimeQuantile, Optional<std::chrono::milliseconds>(double quantile));
+};
+
 class MockThreadLocalCluster : public ThreadLocalCluster {
 public:
   MockThreadLocalCluster();
@@ -82,9 +99,13 @@ public:
   MOCK_METHOD0(hostSet, const HostSet&());
   MOCK_METHOD0(info, ClusterInfoConstSharedPtr());
   MOCK_METHOD0(loadBalancer, LoadBalancer&());
+  MOCK_METHOD0(responseTimes, ResponseTimeTracker&());
+  MOCK_METHOD2(httpConnPool, Http::ConnectionPool::Instance*(ResourcePriority priority,
+                                                             LoadBalancerContext* context));
 
   NiceMock<MockCluster> cluster_;
   NiceMock<MockLoadBalancer> lb_;
+  NiceMock<MockResponseTimeTracker> response_times_;
 };
 
 class MockClusterManager : public ClusterManager {
@@ -98,11 +119,17 @@ public:
     return {Network::ClientConnectionPtr{data.connection_}, data.host_description_};
   }
 
+  PooledTcpConnectionData pooledTcpConnForCluster(const std::string& cluster,
+                                                  LoadBalancerContext* context) override {
+    return {tcpConnForCluster(cluster, context), tcp_conn_pooled_};
+  }
+
   // Upstream::ClusterManager
   MOCK_METHOD1(addOrUpdatePrimaryCluster, bool(const envoy::api::v2::Cluster& cluster));
   MOCK_METHOD1(setInitializedCb, void(std::function<void()>));
   MOCK_METHOD0(clusters, ClusterInfoMap());
   MOCK_METHOD1(get, ThreadLocalCluster*(const std::string& cluster));
+  MOCK_METHOD0(threadLocalGeneration, uint64_t());
   MOCK_METHOD3(httpConnPoolForCluster,
                Http::ConnectionPool::Instance*(const std::string& cluster,
                                                ResourcePriority priority,
@@ -121,6 +148,7 @@ public:
   NiceMock<MockThreadLocalCluster> thread_local_cluster_;
   Network::Address::InstanceConstSharedPtr source_address_;
   NiceMock<Config::MockGrpcMux> ads_mux_;
+  bool tcp_conn_pooled_{};
 };
 
 class MockHealthChecker : public HealthChecker {
@@ -10,11 +10,13 @@
 #include "common/router/router.h"
 
 #include "server/config/http/buffer.h"
+#include "server/config/http/cache.h"
 #include "server/config/http/dynamo.h"
 #include "server/config/http/fault.h"
 #include "server/config/http/file_access_log.h"
 #include "server/config/http/grpc_http1_bridge.h"
 #include "server/config/http/grpc_web.h"
+#include "server/config/http/gzip.h"
 #include "server/config/http/ip_tagging.h"
 #include "server/config/http/ratelimit.h"
 #include "server/config/http/router.h"
@@ -55,6 +57,26 @@ TEST(HttpFilterConfigTest, BufferFilter) {
   cb(filter_callback);
 }
 
+TEST(HttpFilterConfigTest, BufferFilterSpilling) {
+  std::string json_string = R"EOF(
+  {
+    "max_request_bytes" : 1048576,
+    "max_request_time_s" : 2,
+    "spill_directory" : "/tmp",
+    "spill_threshold_bytes" : 65536,
+    "max_worker_memory_bytes" : 16777216
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  BufferFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
 TEST(HttpFilterConfigTest, BadBufferFilterConfig) {
   std::string json_string = R"EOF(
   {
@@ -86,6 +108,32 @@ TEST(HttpFilterConfigTest, RateLimitFilter) {
   cb(filter_callback);
 }
 
+TEST(HttpFilterConfigTest, LocalRateLimitFilter) {
+  std::string json_string = R"EOF(
+  {
+    "domain" : "test",
+    "local_rate_limit" : {
+      "rules" : [
+        {
+          "descriptor" : [{"key" : "remote_address"}],
+          "max_tokens" : 100,
+          "fill_interval_ms" : 1000
+        }
+      ]
+    }
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  RateLimitFilterConfig factory;
+  EXPECT_CALL(context, rateLimitClient_()).Times(0);
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
 TEST(HttpFilterConfigTest, BadRateLimitFilterConfig) {
   std::string json_string = R"EOF(
   {
@@ -278,6 +326,54 @@ TEST(HttpFilterConfigTest, RouterFilterWithEmptyProtoConfig) {
   cb(filter_callback);
 }
 
+TEST(HttpFilterConfigTest, GzipFilter) {
+  std::string json_string = R"EOF(
+  {
+    "compression_level" : "speed",
+    "content_type" : ["text/html", "application/json"]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  GzipFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, CacheFilter) {
+  std::string json_string = R"EOF(
+  {
+    "max_bytes" : 1048576,
+    "max_entry_bytes" : 65536,
+    "coalesce_requests" : false
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CacheFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, BadCacheFilterConfig) {
+  std::string json_string = R"EOF(
+  {
+    "max_bytes" : 0
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CacheFilterConfig factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
 TEST(HttpFilterConfigTest, IpTaggingFilter) {
   std::string json_string = R"EOF(
   {
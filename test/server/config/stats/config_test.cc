@@ -4,8 +4,10 @@
 
 #include "common/config/well_known_names.h"
 #include "common/protobuf/utility.h"
+#include "common/stats/metrics_service_sink.h"
 #include "common/stats/statsd.h"
 
+#include "server/config/stats/metrics_service.h"
 #include "server/config/stats/statsd.h"
 
 #include "test/mocks/server/mocks.h"
@@ -86,6 +88,34 @@ TEST(StatsConfigTest, EmptyConfig) {
       "No tcp_cluster_name or address provided for envoy.statsd Stats::Sink config");
 }
 
+TEST(StatsConfigTest, ValidMetricsService) {
+  const std::string name = Config::StatsSinkNames::get().METRICS_SERVICE;
+
+  envoy::metrics::MetricsServiceConfig sink_config;
+  sink_config.set_cluster_name("fake_cluster");
+
+  StatsSinkFactory* factory = Registry::FactoryRegistry<StatsSinkFactory>::getFactory(name);
+  ASSERT_NE(factory, nullptr);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  MessageUtil::jsonConvert(sink_config, *message);
+
+  NiceMock<MockInstance> server;
+  Stats::SinkPtr sink = factory->createStatsSink(*message, server);
+  EXPECT_NE(dynamic_cast<Stats::MetricsService::MetricsServiceSink*>(sink.get()), nullptr);
+}
+
+TEST(StatsConfigTest, MetricsServiceUnknownCluster) {
+  StatsSinkFactory* factory = Registry::FactoryRegistry<StatsSinkFactory>::getFactory(
+      Config::StatsSinkNames::get().METRICS_SERVICE);
+  ASSERT_NE(factory, nullptr);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  NiceMock<MockInstance> server;
+  EXPECT_THROW_WITH_MESSAGE(factory->createStatsSink(*message, server), EnvoyException,
+                            "unknown metrics service cluster ''");
+}
+
 } // namespace Configuration
 } // namespace Server
 } // namespace Envoy
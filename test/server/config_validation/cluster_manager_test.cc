@@ -1,6 +1,8 @@
 #include "envoy/upstream/resource_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/config/bootstrap_json.h"
+#include "common/json/json_loader.h"
 #include "common/ssl/context_manager_impl.h"
 #include "common/stats/stats_impl.h"
 
@@ -41,11 +43,58 @@ TEST(ValidationClusterManagerTest, MockedMethods) {
   Host::CreateConnectionData data = cluster_manager->tcpConnForCluster("cluster", nullptr);
   EXPECT_EQ(nullptr, data.connection_);
   EXPECT_EQ(nullptr, data.host_description_);
+  PooledTcpConnectionData pooled_data =
+      cluster_manager->pooledTcpConnForCluster("cluster", nullptr);
+  EXPECT_EQ(nullptr, pooled_data.data_.connection_);
+  EXPECT_FALSE(pooled_data.pooled_);
 
   Http::AsyncClient& client = cluster_manager->httpAsyncClientForCluster("cluster");
   Http::MockAsyncClientStreamCallbacks stream_callbacks;
   EXPECT_EQ(nullptr, client.start(stream_callbacks, Optional<std::chrono::milliseconds>(), false));
 }
 
+TEST(ValidationClusterManagerTest, NoLoadBalancers) {
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl stats;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<Runtime::MockRandomGenerator> random;
+  auto dns_resolver = std::make_shared<NiceMock<Network::MockDnsResolver>>();
+  Ssl::ContextManagerImpl ssl_context_manager{runtime};
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<LocalInfo::MockLocalInfo> local_info;
+
+  ValidationClusterManagerFactory factory(runtime, stats, tls, random, dns_resolver,
+                                          ssl_context_manager, dispatcher, local_info);
+
+  const std::string json = R"EOF(
+  {
+    "clusters": [
+    {
+      "name": "cluster_1",
+      "connect_timeout_ms": 250,
+      "type": "static",
+      "lb_type": "ring_hash",
+      "hosts": [{"url": "tcp://127.0.0.1:11001"}]
+    }]
+  }
+  )EOF";
+
+  envoy::api::v2::Bootstrap bootstrap;
+  Config::BootstrapJson::translateClusterManagerBootstrap(*Json::Factory::loadFromString(json),
+                                                          bootstrap);
+
+  AccessLog::MockAccessLogManager log_manager;
+  ClusterManagerPtr cluster_manager = factory.clusterManagerFromProto(
+      bootstrap, stats, tls, runtime, random, local_info, log_manager);
+
+  // The cluster is still known, so routes and filters which name it validate, but no ring is built
+  // for it since nothing chooses a host during validation.
+  ThreadLocalCluster* cluster = cluster_manager->get("cluster_1");
+  ASSERT_NE(nullptr, cluster);
+  EXPECT_EQ("cluster_1", cluster->info()->name());
+  EXPECT_EQ(nullptr, cluster_manager->httpConnPoolForCluster("cluster_1", ResourcePriority::Default,
+                                                             nullptr));
+}
+
 } // namespace Upstream
 } // namespace Envoy
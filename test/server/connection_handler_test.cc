@@ -69,6 +69,103 @@ TEST_F(ConnectionHandlerTest, RemoveListener) {
   handler_->removeListeners(0);
 }
 
+TEST_F(ConnectionHandlerTest, ConnectionsGauge) {
+  InSequence s;
+
+  Stats::Gauge& connections = stats_store_.gauge("server.worker_0.downstream_cx_active");
+  handler_.reset(new ConnectionHandlerImpl(ENVOY_LOGGER(), dispatcher_, connections));
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  handler_->addListener(factory_, socket_, stats_store_, 1,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+  EXPECT_EQ(1UL, connections.value());
+
+  EXPECT_CALL(*connection, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(dispatcher_, clearDeferredDeleteList());
+  EXPECT_CALL(*listener, onDestroy());
+  handler_->removeListeners(1);
+  EXPECT_EQ(0UL, connections.value());
+}
+
+TEST_F(ConnectionHandlerTest, WorkerStats) {
+  InSequence s;
+
+  WorkerStats stats{ALL_WORKER_STATS(POOL_COUNTER_PREFIX(stats_store_, "server.worker_0."),
+                                     POOL_GAUGE_PREFIX(stats_store_, "server.worker_0."))};
+  handler_.reset(new ConnectionHandlerImpl(ENVOY_LOGGER(), dispatcher_, stats));
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  handler_->addListener(factory_, socket_, stats_store_, 1,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  // The connection gets the worker stats before the filters are created.
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(*connection, setWorkerStats(_))
+      .WillOnce(Invoke([&](const Network::Connection::WorkerStats& worker_stats) -> void {
+        EXPECT_EQ(&stats.downstream_cx_rx_bytes_total_, &worker_stats.read_total_);
+        EXPECT_EQ(&stats.downstream_cx_tx_bytes_total_, &worker_stats.write_total_);
+        EXPECT_EQ(&stats.downstream_rq_active_, &worker_stats.rq_active_);
+      }));
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+  EXPECT_EQ(1UL, stats.downstream_cx_total_.value());
+  EXPECT_EQ(1UL, stats.downstream_cx_active_.value());
+
+  EXPECT_CALL(*connection, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(dispatcher_, clearDeferredDeleteList());
+  EXPECT_CALL(*listener, onDestroy());
+  handler_->removeListeners(1);
+  EXPECT_EQ(1UL, stats.downstream_cx_total_.value());
+  EXPECT_EQ(0UL, stats.downstream_cx_active_.value());
+}
+
+TEST_F(ConnectionHandlerTest, IdleMemoryRelease) {
+  InSequence s;
+
+  ConnectionHandlerImpl* handler = new ConnectionHandlerImpl(ENVOY_LOGGER(), dispatcher_);
+  handler->setIdleMemoryRelease(std::chrono::milliseconds(5000));
+  handler_.reset(handler);
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  handler_->addListener(factory_, socket_, stats_store_, 1,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  EXPECT_CALL(*connection, enableIdleMemoryRelease(std::chrono::milliseconds(5000)));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+
+  EXPECT_CALL(*connection, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(dispatcher_, clearDeferredDeleteList());
+  EXPECT_CALL(*listener, onDestroy());
+  handler_->removeListeners(1);
+}
+
 TEST_F(ConnectionHandlerTest, DestroyCloseConnections) {
   InSequence s;
 
@@ -2,13 +2,16 @@
 
 #include "server/drain_manager_impl.h"
 
+#include "test/mocks/common.h"
 #include "test/mocks/server/mocks.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::InSequence;
+using testing::NiceMock;
 using testing::Return;
+using testing::ReturnPointee;
 using testing::SaveArg;
 using testing::_;
 
@@ -21,7 +24,8 @@ TEST(DrainManagerImplTest, All) {
   NiceMock<MockInstance> server;
   ON_CALL(server.options_, drainTime()).WillByDefault(Return(std::chrono::seconds(600)));
   ON_CALL(server.options_, parentShutdownTime()).WillByDefault(Return(std::chrono::seconds(900)));
-  DrainManagerImpl drain_manager(server);
+  NiceMock<MockMonotonicTimeSource> time_source;
+  DrainManagerImpl drain_manager(server, time_source);
 
   // Test parent shutdown.
   Event::MockTimer* shutdown_timer = new Event::MockTimer(&server.dispatcher_);
@@ -57,5 +61,51 @@ TEST(DrainManagerImplTest, All) {
   EXPECT_TRUE(drain_manager.drainClose());
 }
 
+TEST(DrainManagerImplTest, DrainRate) {
+  NiceMock<MockInstance> server;
+  ON_CALL(server.options_, drainTime()).WillByDefault(Return(std::chrono::seconds(2)));
+  ON_CALL(server.options_, drainRate()).WillByDefault(Return(2));
+  ON_CALL(server.options_, concurrency()).WillByDefault(Return(2));
+  NiceMock<MockMonotonicTimeSource> time_source;
+  MonotonicTime now;
+  ON_CALL(time_source, currentTime()).WillByDefault(ReturnPointee(&now));
+  DrainManagerImpl drain_manager(server, time_source);
+
+  // Draining is complete after the first tick of a 2 second drain, so only the rate limits the
+  // drain closes.
+  Event::MockTimer* drain_timer = new Event::MockTimer(&server.dispatcher_);
+  drain_manager.startDrainSequence(nullptr);
+  drain_timer->callback_();
+
+  // 2 drain closes per second for each of the 2 workers.
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_TRUE(drain_manager.drainClose());
+  }
+  EXPECT_FALSE(drain_manager.drainClose());
+
+  now += std::chrono::milliseconds(500);
+  EXPECT_FALSE(drain_manager.drainClose());
+
+  now += std::chrono::milliseconds(500);
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_TRUE(drain_manager.drainClose());
+  }
+  EXPECT_FALSE(drain_manager.drainClose());
+
+  // The health check failure still closes all connections.
+  ON_CALL(server, healthCheckFailed()).WillByDefault(Return(true));
+  EXPECT_TRUE(drain_manager.drainClose());
+}
+
+TEST(DrainManagerImplTest, Overload) {
+  NiceMock<MockInstance> server;
+  NiceMock<MockMonotonicTimeSource> time_source;
+  DrainManagerImpl drain_manager(server, time_source);
+
+  EXPECT_FALSE(drain_manager.drainClose());
+  ON_CALL(server.overload_manager_, disableKeepalive()).WillByDefault(Return(true));
+  EXPECT_TRUE(drain_manager.drainClose());
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -1,9 +1,22 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "common/network/address_impl.h"
 #include "common/stats/stats_impl.h"
 
 #include "server/hot_restart_impl.h"
 
 #include "test/mocks/api/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
 #include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -96,6 +109,222 @@ TEST_F(HotRestartImplTest, allocFail) {
   EXPECT_EQ(s3, nullptr);
 }
 
+// Stats are still found after others which were allocated before them are freed, however often the
+// slots and index buckets get reused.
+TEST_F(HotRestartImplTest, allocAfterFree) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(4));
+  setup();
+
+  Stats::RawStatData* kept1 = hot_restart_->alloc("kept1");
+  Stats::RawStatData* kept2 = hot_restart_->alloc("kept2");
+  for (uint32_t i = 0; i < 100; i++) {
+    Stats::RawStatData* s1 = hot_restart_->alloc(fmt::format("churn{}", i));
+    Stats::RawStatData* s2 = hot_restart_->alloc(fmt::format("churn{}", i + 1000));
+    EXPECT_NE(s1, nullptr);
+    EXPECT_NE(s2, nullptr);
+    EXPECT_EQ(nullptr, hot_restart_->alloc(fmt::format("churn{}", i + 2000)));
+    EXPECT_EQ(kept1, hot_restart_->alloc("kept1"));
+    EXPECT_EQ(kept2, hot_restart_->alloc("kept2"));
+    hot_restart_->free(*kept1);
+    hot_restart_->free(*kept2);
+    hot_restart_->free(*s1);
+    hot_restart_->free(*s2);
+  }
+
+  EXPECT_EQ(kept1, hot_restart_->alloc("kept1"));
+  EXPECT_EQ(2U, kept1->ref_count_);
+  hot_restart_->free(*kept1);
+  hot_restart_->free(*kept1);
+  hot_restart_->free(*kept2);
+  hot_restart_->alloc("kept3");
+  EXPECT_NE(kept2, hot_restart_->alloc("kept2"));
+}
+
+// Hands the listen sockets of a parent over to a child through their real domain sockets. The
+// parent answers on a thread of its own while the child blocks on each reply.
+class HotRestartImplListenSocketsTest : public HotRestartImplTest {
+public:
+  HotRestartImplListenSocketsTest() {
+    // A base id of our own keeps the domain sockets clear of those of any other Envoy.
+    ON_CALL(options_, baseId()).WillByDefault(Return(getpid() * 10));
+    ON_CALL(os_sys_calls_, bind(_, _, _))
+        .WillByDefault(Invoke([](int sockfd, const sockaddr* addr, socklen_t addrlen) {
+          return ::bind(sockfd, addr, addrlen);
+        }));
+    EXPECT_CALL(dispatcher_, createFileEvent_(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([this](int fd, Event::FileReadyCb cb, Event::FileTriggerType,
+                                      uint32_t) -> Event::FileEvent* {
+          domain_sockets_.emplace_back(fd, cb);
+          return nullptr;
+        }));
+    ON_CALL(server_.listener_manager_, listeners()).WillByDefault(Invoke([this]() {
+      std::vector<std::reference_wrapper<Listener>> listeners;
+      for (auto& listener : listeners_) {
+        listeners.emplace_back(*listener);
+      }
+      return listeners;
+    }));
+    setup();
+    hot_restart_->initialize(dispatcher_, server_);
+
+    ON_CALL(child_options_, baseId()).WillByDefault(Return(getpid() * 10));
+    ON_CALL(child_options_, restartEpoch()).WillByDefault(Return(1));
+    EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _));
+    EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _)).WillOnce(Return(buffer_.data()));
+    EXPECT_CALL(os_sys_calls_, bind(_, _, _));
+    child_.reset(new HotRestartImpl(child_options_, os_sys_calls_));
+    child_->initialize(dispatcher_, server_);
+
+    // More sockets than fit into one reply, with those of the SO_REUSEPORT listener split across
+    // the first two replies.
+    for (uint32_t port = 10000; port < 10070; port++) {
+      addListener(port, port == 10062 ? 4 : 1);
+    }
+  }
+
+  ~HotRestartImplListenSocketsTest() {
+    for (const auto& domain_socket : domain_sockets_) {
+      close(domain_socket.first);
+    }
+    for (const auto& fds : listen_fds_) {
+      for (int fd : fds.second) {
+        close(fd);
+      }
+    }
+  }
+
+  // Adds a listener on the given port with the given number of sockets, those of the workers past
+  // the last wrapping around like the sockets of Listener::workerSocket().
+  void addListener(uint32_t port, uint32_t num_sockets) {
+    listeners_.emplace_back(new NiceMock<MockListener>());
+    MockListener& listener = *listeners_.back();
+    ON_CALL(listener.socket_, localAddress())
+        .WillByDefault(Return(std::make_shared<Network::Address::Ipv4Instance>("127.0.0.1", port)));
+
+    auto& sockets = worker_sockets_[port];
+    for (uint32_t i = 0; i < num_sockets; i++) {
+      const int fd = socket(AF_INET, SOCK_STREAM, 0);
+      ASSERT_NE(-1, fd);
+      listen_fds_[port].push_back(fd);
+      sockets.emplace_back(new NiceMock<Network::MockListenSocket>());
+      ON_CALL(*sockets.back(), fd()).WillByDefault(Return(fd));
+    }
+    ON_CALL(listener, workerSocket(_))
+        .WillByDefault(Invoke([&sockets](uint32_t worker_index) -> Network::ListenSocket& {
+          return *sockets[worker_index % sockets.size()];
+        }));
+  }
+
+  // The first duplicate of the child fetches all the sockets of the parent, so the parent is run
+  // for its duration.
+  int duplicateWithParentRunning(uint32_t port, uint32_t worker_index) {
+    std::atomic<bool> done(false);
+    std::thread parent([this, &done]() {
+      while (!done) {
+        pollfd poll_fd{domain_sockets_[0].first, POLLIN, 0};
+        if (poll(&poll_fd, 1, 10) > 0) {
+          domain_sockets_[0].second(Event::FileReadyType::Read);
+        }
+      }
+    });
+    const int fd = child_->duplicateParentListenSocket(url(port), worker_index);
+    done = true;
+    parent.join();
+    return fd;
+  }
+
+  static std::string url(uint32_t port) { return fmt::format("tcp://127.0.0.1:{}", port); }
+
+  static ino_t inode(int fd) {
+    struct stat stat_result;
+    EXPECT_EQ(0, fstat(fd, &stat_result));
+    return stat_result.st_ino;
+  }
+
+  // @return the number of fds open in this process on the socket with the inode of the given fd.
+  static uint32_t openFds(int fd) {
+    const ino_t socket_inode = inode(fd);
+    uint32_t count = 0;
+    for (const std::string& file_name : TestUtility::listFiles("/proc/self/fd", false)) {
+      struct stat stat_result;
+      if (::stat(file_name.c_str(), &stat_result) == 0 && S_ISSOCK(stat_result.st_mode) &&
+          stat_result.st_ino == socket_inode) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  // Fetches the sockets of the parent and checks that the child caches one fd of each.
+  void fetchParentListenSockets() {
+    const int duplicated_fd = duplicateWithParentRunning(10000, 0);
+    EXPECT_EQ(inode(listen_fds_[10000][0]), inode(duplicated_fd));
+    close(duplicated_fd);
+    for (const auto& fds : listen_fds_) {
+      for (int fd : fds.second) {
+        EXPECT_EQ(2U, openFds(fd));
+      }
+    }
+  }
+
+  // Checks that the child no longer holds any socket of the parent.
+  void expectParentListenSocketsClosed() {
+    for (const auto& fds : listen_fds_) {
+      for (int fd : fds.second) {
+        EXPECT_EQ(1U, openFds(fd));
+      }
+    }
+    EXPECT_EQ(-1, child_->duplicateParentListenSocket(url(10000), 0));
+  }
+
+  NiceMock<MockOptions> child_options_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<MockInstance> server_;
+  std::unique_ptr<HotRestartImpl> child_;
+  // The domain sockets of the parent and the child, in that order, with their file event callbacks.
+  std::vector<std::pair<int, Event::FileReadyCb>> domain_sockets_;
+  std::vector<std::unique_ptr<NiceMock<MockListener>>> listeners_;
+  std::map<uint32_t, std::vector<std::unique_ptr<NiceMock<Network::MockListenSocket>>>>
+      worker_sockets_;
+  std::map<uint32_t, std::vector<int>> listen_fds_;
+};
+
+// Every worker index of a listener is given the socket of that worker by the parent, across all the
+// replies, and later duplicates are served from the sockets cached by the child.
+TEST_F(HotRestartImplListenSocketsTest, handOverAcrossReplies) {
+  int fd = duplicateWithParentRunning(10062, 5);
+  EXPECT_EQ(inode(listen_fds_[10062][1]), inode(fd));
+  close(fd);
+
+  for (uint32_t worker_index = 0; worker_index < 8; worker_index++) {
+    fd = child_->duplicateParentListenSocket(url(10062), worker_index);
+    EXPECT_EQ(inode(listen_fds_[10062][worker_index % 4]), inode(fd));
+    close(fd);
+  }
+
+  for (uint32_t port = 10000; port < 10070; port++) {
+    fd = child_->duplicateParentListenSocket(url(port), 3);
+    EXPECT_EQ(inode(listen_fds_[port][port == 10062 ? 3 : 0]), inode(fd));
+    close(fd);
+  }
+
+  EXPECT_EQ(-1, child_->duplicateParentListenSocket(url(10070), 0));
+}
+
+TEST_F(HotRestartImplListenSocketsTest, closedOnTerminateParent) {
+  fetchParentListenSockets();
+  // The parent is no longer run, so it never acts on the terminate request.
+  child_->terminateParent();
+  expectParentListenSocketsClosed();
+}
+
+TEST_F(HotRestartImplListenSocketsTest, closedOnShutdown) {
+  fetchParentListenSockets();
+  child_->shutdown();
+  expectParentListenSocketsClosed();
+}
+
 // Because the shared memory is managed manually, make sure it meets
 // basic requirements:
 //   - Objects are correctly aligned so that std::atomic works properly
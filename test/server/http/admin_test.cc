@@ -1,11 +1,14 @@
 #include <fstream>
 
 #include "common/http/message_impl.h"
+#include "common/json/json_loader.h"
 #include "common/profiler/profiler.h"
 
 #include "server/http/admin.h"
 
+#include "test/common/upstream/utility.h"
 #include "test/mocks/server/mocks.h"
+#include "test/mocks/upstream/mocks.h"
 #include "test/test_common/environment.h"
 #include "test/test_common/network_utility.h"
 #include "test/test_common/printers.h"
@@ -15,6 +18,7 @@
 #include "gtest/gtest.h"
 
 using testing::NiceMock;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -93,6 +97,14 @@ TEST_P(AdminInstanceTest, AdminProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminHeapProfiler) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=y", data));
+  EXPECT_TRUE(Profiler::Heap::profilerEnabled());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=n", data));
+  EXPECT_FALSE(Profiler::Heap::profilerEnabled());
+}
+
 #endif
 
 TEST_P(AdminInstanceTest, AdminBadProfiler) {
@@ -104,6 +116,22 @@ TEST_P(AdminInstanceTest, AdminBadProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminBadHeapProfiler) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler?enable=x", data));
+  EXPECT_EQ("?enable=<y|n>\n", TestUtility::bufferToString(data));
+  EXPECT_FALSE(Profiler::Heap::profilerEnabled());
+}
+
+TEST_P(AdminInstanceTest, Memory) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/memory", data));
+  const std::string output = TestUtility::bufferToString(data);
+  EXPECT_NE(std::string::npos, output.find("allocated: "));
+  EXPECT_NE(std::string::npos, output.find("heap_size: "));
+  EXPECT_NE(std::string::npos, output.find("buffer_slabs: "));
+}
+
 TEST_P(AdminInstanceTest, WriteAddressToFile) {
   std::ifstream address_file(address_out_path_);
   std::string address_from_file;
@@ -146,5 +174,101 @@ TEST_P(AdminInstanceTest, CustomHandler) {
   EXPECT_EQ(Http::Code::Accepted, admin_.runCallback("/foo/bar", response));
 }
 
+TEST_P(AdminInstanceTest, StatsFilters) {
+  server_.stats_store_.counter("foo.a").inc();
+  server_.stats_store_.counter("foo.b");
+  server_.stats_store_.gauge("foo.c").set(5);
+  server_.stats_store_.counter("bar.d").inc();
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats?prefix=foo.", response));
+  EXPECT_EQ("foo.a: 1\nfoo.b: 0\nfoo.c: 5\n", TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats?usedonly&prefix=foo.", response));
+  EXPECT_EQ("foo.a: 1\nfoo.c: 5\n", TestUtility::bufferToString(response));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::NotFound, admin_.runCallback("/stats?format=xml", response));
+}
+
+TEST_P(AdminInstanceTest, StatsAsPrometheus) {
+  server_.stats_store_.counter("foo.a").add(3);
+  server_.stats_store_.gauge("foo.b").set(5);
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/stats?format=prometheus&prefix=foo.", response));
+  EXPECT_EQ("# TYPE envoy_foo_a counter\n"
+            "envoy_foo_a 3\n"
+            "# TYPE envoy_foo_b gauge\n"
+            "envoy_foo_b 5\n",
+            TestUtility::bufferToString(response));
+}
+
+TEST_P(AdminInstanceTest, ClustersFilters) {
+  NiceMock<Upstream::MockCluster> foo;
+  NiceMock<Upstream::MockCluster> bar;
+  foo.info_->name_ = "foo";
+  bar.info_->name_ = "bar";
+  foo.hosts_ = {Upstream::makeTestHost(foo.info_, "tcp://10.0.0.1:80"),
+                Upstream::makeTestHost(foo.info_, "tcp://10.0.0.2:80")};
+  foo.hosts_[1]->healthFlagSet(Upstream::Host::HealthFlag::FAILED_ACTIVE_HC);
+  ON_CALL(server_.cluster_manager_, clusters())
+      .WillByDefault(Return(Upstream::ClusterManager::ClusterInfoMap{{"foo", foo}, {"bar", bar}}));
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?format=json&health=healthy", response));
+  Json::ObjectSharedPtr json = Json::Factory::loadFromString(TestUtility::bufferToString(response));
+  std::vector<Json::ObjectSharedPtr> clusters = json->getObjectArray("clusters");
+  ASSERT_EQ(2U, clusters.size());
+  EXPECT_EQ("bar", clusters[0]->getString("name"));
+  EXPECT_EQ("foo", clusters[1]->getString("name"));
+  std::vector<Json::ObjectSharedPtr> hosts = clusters[1]->getObjectArray("hosts");
+  ASSERT_EQ(1U, hosts.size());
+  EXPECT_EQ("10.0.0.1:80", hosts[0]->getString("address"));
+  EXPECT_EQ("healthy", hosts[0]->getString("health_flags"));
+  EXPECT_FALSE(json->hasObject("next_offset"));
+
+  // Pages are taken over the hosts in cluster name order. A cluster without hosts takes no room.
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?format=json&limit=1", response));
+  json = Json::Factory::loadFromString(TestUtility::bufferToString(response));
+  clusters = json->getObjectArray("clusters");
+  ASSERT_EQ(2U, clusters.size());
+  EXPECT_EQ(1U, clusters[1]->getObjectArray("hosts").size());
+  EXPECT_EQ(1, json->getInteger("next_offset"));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?format=json&offset=1&limit=1", response));
+  json = Json::Factory::loadFromString(TestUtility::bufferToString(response));
+  clusters = json->getObjectArray("clusters");
+  ASSERT_EQ(1U, clusters.size());
+  EXPECT_EQ("10.0.0.2:80", clusters[0]->getObjectArray("hosts")[0]->getString("address"));
+  EXPECT_FALSE(json->hasObject("next_offset"));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?prefix=fo&health=unhealthy", response));
+  const std::string text = TestUtility::bufferToString(response);
+  EXPECT_EQ(std::string::npos, text.find("bar::"));
+  EXPECT_EQ(std::string::npos, text.find("10.0.0.1:80"));
+  EXPECT_NE(std::string::npos, text.find("foo::10.0.0.2:80::health_flags::/failed_active_hc\n"));
+
+  response.drain(response.length());
+  EXPECT_EQ(Http::Code::NotFound, admin_.runCallback("/clusters?limit=many", response));
+}
+
+TEST(PrometheusStatsFormatter, MetricName) {
+  EXPECT_EQ("envoy_cluster_upstream_rq_total",
+            PrometheusStatsFormatter::metricName("cluster.upstream_rq_total"));
+  EXPECT_EQ("envoy_listener_ssl_cipher_AES256_SHA",
+            PrometheusStatsFormatter::metricName("listener.ssl.cipher.AES256-SHA"));
+}
+
+TEST(PrometheusStatsFormatter, FormattedTags) {
+  std::vector<Stats::Tag> tags{{"envoy.cluster_name", "foo"}, {"a", "quote\"back\\slash"}};
+  EXPECT_EQ("envoy_cluster_name=\"foo\",a=\"quote\\\"back\\\\slash\"",
+            PrometheusStatsFormatter::formattedTags(tags));
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -1,10 +1,12 @@
 #include "envoy/registry/registry.h"
 
 #include "common/network/address_impl.h"
+#include "common/network/utility.h"
 
 #include "server/configuration_impl.h"
 #include "server/listener_manager_impl.h"
 
+#include "test/mocks/network/mocks.h"
 #include "test/mocks/server/mocks.h"
 #include "test/server/utility.h"
 #include "test/test_common/environment.h"
@@ -16,6 +18,8 @@ using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnRef;
+using testing::SaveArg;
 using testing::Throw;
 using testing::_;
 
@@ -250,6 +254,99 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, StatsScopeTest) {
   EXPECT_EQ(1UL, server_.stats_store_.counter("listener.127.0.0.1_1234.foo").value());
 }
 
+TEST_F(ListenerManagerImplTest, FilterChainMatch) {
+  const std::string yaml = R"EOF(
+address:
+  socket_address: { address: 0.0.0.0, port_value: 1234 }
+filter_chains:
+- filter_chain_match:
+    prefix_ranges: [{ address_prefix: 10.0.0.0, prefix_len: 8 }]
+    destination_port: 80
+  filters: [{ name: first }]
+- filter_chain_match:
+    prefix_ranges: [{ address_prefix: 10.1.0.0, prefix_len: 16 }]
+  filters: [{ name: second }]
+- filters: [{ name: third }]
+  )EOF";
+
+  // Each filter chain records its name as the one built.
+  std::string built;
+  EXPECT_CALL(listener_factory_, createDrainManager_());
+  EXPECT_CALL(listener_factory_, createFilterFactoryList(_, _))
+      .Times(3)
+      .WillRepeatedly(
+          Invoke([&built](const Protobuf::RepeatedPtrField<envoy::api::v2::Filter>& filters,
+                          Configuration::FactoryContext&)
+                     -> std::vector<Configuration::NetworkFilterFactoryCb> {
+            const std::string name = filters[0].name();
+            return {[&built, name](Network::FilterManager&) -> void { built = name; }};
+          }));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  manager_->addOrUpdateListener(TestUtility::parseYaml<envoy::api::v2::Listener>(yaml));
+  Network::FilterChainFactory& factory = manager_->listeners().back().get().filterChainFactory();
+
+  auto expectFilterChain = [&](const std::string& local_address, const std::string& name) {
+    NiceMock<Network::MockConnection> connection;
+    Network::Address::InstanceConstSharedPtr address =
+        Network::Utility::resolveUrl("tcp://" + local_address);
+    ON_CALL(connection, localAddress()).WillByDefault(ReturnRef(*address));
+    ON_CALL(connection, initializeReadFilters()).WillByDefault(Return(true));
+    built.clear();
+    factory.createFilterChain(connection);
+    EXPECT_EQ(name, built) << local_address;
+  };
+
+  // The first filter chain in config order which matches wins.
+  expectFilterChain("10.1.0.1:80", "first");
+  expectFilterChain("10.1.0.1:443", "second");
+  expectFilterChain("10.2.0.1:443", "third");
+  expectFilterChain("192.168.0.1:80", "third");
+}
+
+TEST_F(ListenerManagerImplTest, FilterChainMatchNone) {
+  const std::string yaml = R"EOF(
+address:
+  socket_address: { address: 0.0.0.0, port_value: 1234 }
+filter_chains:
+- filter_chain_match:
+    prefix_ranges: [{ address_prefix: 10.0.0.0, prefix_len: 8 }]
+  filters: [{ name: first }]
+  )EOF";
+
+  ListenerHandle* listener = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  manager_->addOrUpdateListener(TestUtility::parseYaml<envoy::api::v2::Listener>(yaml));
+
+  // Without a filter chain the connection is closed.
+  NiceMock<Network::MockConnection> connection;
+  Network::Address::InstanceConstSharedPtr address =
+      Network::Utility::resolveUrl("tcp://192.168.0.1:80");
+  ON_CALL(connection, localAddress()).WillByDefault(ReturnRef(*address));
+  EXPECT_CALL(connection, initializeReadFilters()).Times(0);
+  EXPECT_FALSE(
+      manager_->listeners().back().get().filterChainFactory().createFilterChain(connection));
+
+  EXPECT_CALL(*listener, onDestroy());
+}
+
+TEST_F(ListenerManagerImplTest, FilterChainMatchBySni) {
+  const std::string yaml = R"EOF(
+address:
+  socket_address: { address: 0.0.0.0, port_value: 1234 }
+filter_chains:
+- filter_chain_match:
+    sni_domains: [example.com]
+  filters: [{ name: first }]
+  )EOF";
+
+  EXPECT_CALL(listener_factory_, createDrainManager_());
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(TestUtility::parseYaml<envoy::api::v2::Listener>(yaml)),
+      EnvoyException,
+      "error adding listener '0.0.0.0:1234': filter chains can not be matched by SNI, use the SNI "
+      "certificates of the TLS context");
+}
+
 TEST_F(ListenerManagerImplTest, AddListenerAddressNotMatching) {
   InSequence s;
 
@@ -421,6 +518,96 @@ TEST_F(ListenerManagerImplTest, AddOrUpdateListener) {
   EXPECT_CALL(*listener_baz_update1, onDestroy());
 }
 
+TEST_F(ListenerManagerImplTest, InPlaceUpdate) {
+  InSequence s;
+
+  ON_CALL(server_.options_, inPlaceListenerUpdates()).WillByDefault(Return(true));
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  // Add foo listener.
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": []
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+  worker_->callAddCompletion(true);
+  checkStats(1, 0, 0, 0, 1, 0);
+
+  // Update the filters of foo. The listener is updated in place rather than drained.
+  const std::string listener_foo_update1_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": [
+      { "type" : "read", "name" : "fake", "config" : {} }
+    ]
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo_update1 = expectListenerCreate(false);
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_update1_json)));
+  checkStats(1, 1, 0, 0, 1, 0);
+  EXPECT_EQ(1UL,
+            server_.stats_store_.counter("listener_manager.listener_in_place_updated").value());
+
+  // Update duplicate should be a NOP.
+  EXPECT_FALSE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_update1_json)));
+
+  // New connections get the filters of the update, which they keep alive.
+  NiceMock<Network::MockConnection> connection;
+  Network::Address::Ipv4Instance local_address("127.0.0.1", 1234);
+  ON_CALL(connection, localAddress()).WillByDefault(ReturnRef(local_address));
+  Network::ReadFilterSharedPtr update_handle;
+  EXPECT_CALL(connection, addReadFilter(_)).WillOnce(SaveArg<0>(&update_handle));
+  EXPECT_CALL(connection, initializeReadFilters()).WillOnce(Return(true));
+  Network::FilterChainFactory& factory = manager_->listeners().front().get().filterChainFactory();
+  EXPECT_TRUE(factory.createFilterChain(connection));
+
+  ListenerHandle* listener_foo_update2 = expectListenerCreate(false);
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+  checkStats(1, 2, 0, 0, 1, 0);
+
+  EXPECT_CALL(*listener_foo_update1, onDestroy());
+  update_handle.reset();
+
+  // Any other change drains the listener, along with the connections of its updates.
+  const std::string listener_foo_update3_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": [],
+    "per_connection_buffer_limit_bytes": 8192
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo_update3 = expectListenerCreate(false);
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_CALL(*worker_, stopListener(_));
+  EXPECT_CALL(*listener_foo->drain_manager_, startDrainSequence(_));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_update3_json)));
+  worker_->callAddCompletion(true);
+  checkStats(1, 3, 0, 0, 1, 1);
+  EXPECT_EQ(2UL,
+            server_.stats_store_.counter("listener_manager.listener_in_place_updated").value());
+
+  EXPECT_CALL(*worker_, removeListener(_, _));
+  listener_foo->drain_manager_->drain_sequence_completion_();
+  EXPECT_CALL(*listener_foo, onDestroy());
+  EXPECT_CALL(*listener_foo_update2, onDestroy());
+  worker_->callRemovalCompletion();
+  checkStats(1, 3, 0, 0, 1, 0);
+
+  EXPECT_CALL(*listener_foo_update3, onDestroy());
+}
+
 TEST_F(ListenerManagerImplTest, AddDrainingListener) {
   InSequence s;
 
@@ -714,5 +901,67 @@ TEST_F(ListenerManagerImplTest, DuplicateAddressDontBind) {
   EXPECT_CALL(*listener_foo, onDestroy());
 }
 
+class ListenerManagerImplReusePortTest : public ListenerManagerImplTest {
+public:
+  ListenerManagerImplReusePortTest() {
+    ON_CALL(server_.options_, concurrency()).WillByDefault(Return(2));
+    ON_CALL(server_.options_, reusePort()).WillByDefault(Return(true));
+    EXPECT_CALL(worker_factory_, createWorker_())
+        .WillOnce(Return(worker1_))
+        .WillOnce(Return(worker2_));
+    manager_.reset(new ListenerManagerImpl(server_, listener_factory_, worker_factory_));
+  }
+
+  MockWorker* worker1_ = new MockWorker();
+  MockWorker* worker2_ = new MockWorker();
+};
+
+TEST_F(ListenerManagerImplReusePortTest, SocketPerWorker) {
+  // The second socket binds to the port picked for the first.
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:0",
+    "filters": []
+  }
+  )EOF";
+
+  auto socket1 = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  auto socket2 = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  Network::Address::InstanceConstSharedPtr local_address(
+      new Network::Address::Ipv4Instance("127.0.0.1", 1234));
+  ON_CALL(*socket1, localAddress()).WillByDefault(Return(local_address));
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, _)).Times(0);
+  EXPECT_CALL(listener_factory_, createReusePortListenSocket(_, 0)).WillOnce(Return(socket1));
+  EXPECT_CALL(listener_factory_, createReusePortListenSocket(local_address, 1))
+      .WillOnce(Return(socket2));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+
+  Listener& listener = manager_->listeners().back().get();
+  EXPECT_EQ(socket1.get(), &listener.socket());
+  EXPECT_EQ(socket1.get(), &listener.workerSocket(0));
+  EXPECT_EQ(socket2.get(), &listener.workerSocket(1));
+  EXPECT_EQ(socket1.get(), &listener.workerSocket(2));
+
+  // Listeners which do not bind share a socket.
+  const std::string listener_bar_json = R"EOF(
+  {
+    "name": "bar",
+    "address": "tcp://127.0.0.1:1235",
+    "filters": [],
+    "bind_to_port": false
+  }
+  )EOF";
+
+  ListenerHandle* listener_bar = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, false));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_bar_json)));
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+  EXPECT_CALL(*listener_bar, onDestroy());
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -40,8 +40,12 @@ TEST(OptionsImplTest, All) {
   std::unique_ptr<OptionsImpl> options = createOptionsImpl(
       "envoy --mode validate --concurrency 2 -c hello --admin-address-path path --restart-epoch 1 "
       "--local-address-ip-version v6 -l info --service-cluster cluster --service-node node "
-      "--service-zone zone --file-flush-interval-msec 9000 --drain-time-s 60 "
-      "--parent-shutdown-time-s 90 --log-path /foo/bar");
+      "--service-zone zone --file-flush-interval-msec 9000 --drain-time-s 60 --drain-rate 50 "
+      "--parent-shutdown-time-s 90 --log-path /foo/bar --host-stats-shards 3 "
+      "--counter-shards 4 --compact-cluster-stats --dns-cache-ttl-ms 30000 --reuse-port "
+      "--balance-connections --dispatcher-stats --worker-stats --in-place-listener-updates "
+      "--idle-memory-release-ms 5000 --busy-poll-us 50 --deferred-delete-budget-us 200 "
+      "--worker-cpus 0-2,8,16-17 --reuse-port-incoming-cpu --async-log-buffer-size 1048576");
   EXPECT_EQ(Server::Mode::Validate, options->mode());
   EXPECT_EQ(2U, options->concurrency());
   EXPECT_EQ("hello", options->configPath());
@@ -55,16 +59,48 @@ TEST(OptionsImplTest, All) {
   EXPECT_EQ("zone", options->serviceZone());
   EXPECT_EQ(std::chrono::milliseconds(9000), options->fileFlushIntervalMsec());
   EXPECT_EQ(std::chrono::seconds(60), options->drainTime());
+  EXPECT_EQ(50U, options->drainRate());
   EXPECT_EQ(std::chrono::seconds(90), options->parentShutdownTime());
+  EXPECT_EQ(3U, options->hostStatsShards());
+  EXPECT_EQ(4U, options->counterShards());
+  EXPECT_TRUE(options->compactClusterStats());
+  EXPECT_EQ(std::chrono::milliseconds(30000), options->dnsCacheTtl());
+  EXPECT_TRUE(options->reusePort());
+  EXPECT_TRUE(options->balanceConnections());
+  EXPECT_TRUE(options->dispatcherStats());
+  EXPECT_TRUE(options->workerStats());
+  EXPECT_TRUE(options->inPlaceListenerUpdates());
+  EXPECT_EQ(std::chrono::milliseconds(5000), options->idleMemoryRelease());
+  EXPECT_EQ(std::chrono::microseconds(50), options->busyPoll());
+  EXPECT_EQ(std::chrono::microseconds(200), options->deferredDeleteBudget());
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 8, 16, 17}), options->workerCpus());
+  EXPECT_TRUE(options->reusePortIncomingCpu());
+  EXPECT_EQ(1048576U, options->asyncLogBufferSize());
 }
 
 TEST(OptionsImplTest, DefaultParams) {
   std::unique_ptr<OptionsImpl> options = createOptionsImpl("envoy -c hello");
   EXPECT_EQ(std::chrono::seconds(600), options->drainTime());
+  EXPECT_EQ(0U, options->drainRate());
   EXPECT_EQ(std::chrono::seconds(900), options->parentShutdownTime());
   EXPECT_EQ("", options->adminAddressPath());
   EXPECT_EQ(Network::Address::IpVersion::v4, options->localAddressIpVersion());
   EXPECT_EQ(Server::Mode::Serve, options->mode());
+  EXPECT_EQ(1U, options->hostStatsShards());
+  EXPECT_EQ(1U, options->counterShards());
+  EXPECT_FALSE(options->compactClusterStats());
+  EXPECT_EQ(std::chrono::milliseconds(0), options->dnsCacheTtl());
+  EXPECT_FALSE(options->reusePort());
+  EXPECT_FALSE(options->balanceConnections());
+  EXPECT_FALSE(options->dispatcherStats());
+  EXPECT_FALSE(options->workerStats());
+  EXPECT_FALSE(options->inPlaceListenerUpdates());
+  EXPECT_EQ(std::chrono::milliseconds(0), options->idleMemoryRelease());
+  EXPECT_EQ(std::chrono::microseconds(0), options->busyPoll());
+  EXPECT_EQ(std::chrono::microseconds(0), options->deferredDeleteBudget());
+  EXPECT_TRUE(options->workerCpus().empty());
+  EXPECT_FALSE(options->reusePortIncomingCpu());
+  EXPECT_EQ(0U, options->asyncLogBufferSize());
 }
 
 TEST(OptionsImplTest, BadCliOption) {
@@ -76,4 +112,22 @@ TEST(OptionsImplTest, BadObjNameLenOption) {
   EXPECT_DEATH(createOptionsImpl("envoy --max-obj-name-len 1"),
                "error: the 'max-obj-name-len' value specified");
 }
+
+TEST(OptionsImplTest, BadHostStatsShardsOption) {
+  EXPECT_DEATH(createOptionsImpl("envoy --host-stats-shards 0"),
+               "error: the 'host-stats-shards' value must be at least 1");
+}
+
+TEST(OptionsImplTest, BadCounterShardsOption) {
+  EXPECT_DEATH(createOptionsImpl("envoy --counter-shards 0"),
+               "error: the 'counter-shards' value must be at least 1");
+}
+
+TEST(OptionsImplTest, BadWorkerCpusOption) {
+  EXPECT_DEATH(createOptionsImpl("envoy --worker-cpus 4-2"),
+               "error: invalid 'worker-cpus' value '4-2'");
+  EXPECT_DEATH(createOptionsImpl("envoy --worker-cpus 0-"), "error: invalid 'worker-cpus' value");
+  EXPECT_DEATH(createOptionsImpl("envoy --worker-cpus 1-2-3"),
+               "error: invalid 'worker-cpus' value");
+}
 } // namespace Envoy
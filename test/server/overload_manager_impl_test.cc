@@ -0,0 +1,118 @@
+#include <chrono>
+
+#include "common/stats/stats_impl.h"
+
+#include "server/overload_manager_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnPointee;
+using testing::_;
+
+namespace Envoy {
+namespace Server {
+
+class OverloadManagerImplTest : public testing::Test {
+public:
+  OverloadManagerImplTest()
+      : timer_(new NiceMock<Event::MockTimer>(&dispatcher_)),
+        overload_manager_(dispatcher_, runtime_, stats_store_, listener_manager_, time_source_) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+    ON_CALL(listener_manager_, numConnections()).WillByDefault(ReturnPointee(&connections_));
+    ON_CALL(runtime_.snapshot_, getInteger("overload.max_active_connections", _))
+        .WillByDefault(Return(100));
+    overload_manager_.start();
+  }
+
+  uint64_t gauge(const std::string& name) { return stats_store_.gauge("overload." + name).value(); }
+
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  Event::MockTimer* timer_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<MockListenerManager> listener_manager_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  MonotonicTime now_;
+  uint64_t connections_{};
+  OverloadManagerImpl overload_manager_;
+};
+
+TEST_F(OverloadManagerImplTest, NoPressure) {
+  EXPECT_CALL(*timer_, enableTimer(std::chrono::milliseconds(1000)));
+  now_ += std::chrono::milliseconds(1000);
+  timer_->callback_();
+
+  EXPECT_EQ(0U, gauge("pressure"));
+  EXPECT_FALSE(overload_manager_.disableKeepalive());
+  EXPECT_FALSE(overload_manager_.rejectNewStreams());
+  EXPECT_FALSE(overload_manager_.stopAcceptingConnections());
+}
+
+TEST_F(OverloadManagerImplTest, Connections) {
+  now_ += std::chrono::milliseconds(1000);
+  connections_ = 80;
+  timer_->callback_();
+  EXPECT_EQ(80U, gauge("pressure"));
+  EXPECT_TRUE(overload_manager_.disableKeepalive());
+  EXPECT_FALSE(overload_manager_.rejectNewStreams());
+  EXPECT_FALSE(overload_manager_.stopAcceptingConnections());
+  EXPECT_EQ(1U, gauge("keepalive_disabled"));
+
+  now_ += std::chrono::milliseconds(1000);
+  connections_ = 95;
+  timer_->callback_();
+  EXPECT_TRUE(overload_manager_.rejectNewStreams());
+  EXPECT_FALSE(overload_manager_.stopAcceptingConnections());
+  EXPECT_EQ(1U, gauge("new_streams_rejected"));
+
+  EXPECT_CALL(listener_manager_, disableListeners());
+  now_ += std::chrono::milliseconds(1000);
+  connections_ = 100;
+  timer_->callback_();
+  EXPECT_TRUE(overload_manager_.stopAcceptingConnections());
+  EXPECT_EQ(1U, gauge("accept_disabled"));
+
+  // The listeners are only disabled once.
+  EXPECT_CALL(listener_manager_, disableListeners()).Times(0);
+  now_ += std::chrono::milliseconds(1000);
+  connections_ = 120;
+  timer_->callback_();
+
+  EXPECT_CALL(listener_manager_, enableListeners());
+  now_ += std::chrono::milliseconds(1000);
+  connections_ = 10;
+  timer_->callback_();
+  EXPECT_EQ(10U, gauge("pressure"));
+  EXPECT_FALSE(overload_manager_.disableKeepalive());
+  EXPECT_FALSE(overload_manager_.rejectNewStreams());
+  EXPECT_FALSE(overload_manager_.stopAcceptingConnections());
+  EXPECT_EQ(0U, gauge("accept_disabled"));
+}
+
+TEST_F(OverloadManagerImplTest, EventLoopLag) {
+  ON_CALL(runtime_.snapshot_, getInteger("overload.max_event_loop_lag_ms", _))
+      .WillByDefault(Return(500));
+
+  // The timer fires 400ms after it was due.
+  now_ += std::chrono::milliseconds(1400);
+  timer_->callback_();
+  EXPECT_EQ(400U, gauge("event_loop_lag_ms"));
+  EXPECT_EQ(80U, gauge("pressure"));
+  EXPECT_TRUE(overload_manager_.disableKeepalive());
+
+  now_ += std::chrono::milliseconds(1000);
+  timer_->callback_();
+  EXPECT_EQ(0U, gauge("event_loop_lag_ms"));
+  EXPECT_FALSE(overload_manager_.disableKeepalive());
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -25,16 +25,23 @@ TEST(ServerInstanceUtil, flushHelper) {
 
   Stats::IsolatedStoreImpl store;
   store.counter("hello").inc();
+  store.counter("unused");
   store.gauge("world").set(5);
-  std::unique_ptr<Stats::MockSink> sink(new StrictMock<Stats::MockSink>());
+  Stats::MockSink* sink = new StrictMock<Stats::MockSink>();
   EXPECT_CALL(*sink, beginFlush());
   EXPECT_CALL(*sink, flushCounter(Property(&Stats::Metric::name, "hello"), 1));
   EXPECT_CALL(*sink, flushGauge(Property(&Stats::Metric::name, "world"), 5));
   EXPECT_CALL(*sink, endFlush());
 
   std::list<Stats::SinkPtr> sinks;
-  sinks.emplace_back(std::move(sink));
-  InstanceUtil::flushCountersAndGaugesToSinks(sinks, store);
+  sinks.emplace_back(sink);
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+
+  // Counters which were not incremented since the last flush are skipped.
+  EXPECT_CALL(*sink, beginFlush());
+  EXPECT_CALL(*sink, flushGauge(Property(&Stats::Metric::name, "world"), 5));
+  EXPECT_CALL(*sink, endFlush());
+  InstanceUtil::flushMetricsToSinks(sinks, store);
 }
 
 class RunHelperTest : public testing::Test {
@@ -135,6 +142,8 @@ TEST_P(ServerInstanceImplTest, Stats) {
   options_.service_node_name_ = "some_node_name";
   initialize(std::string());
   EXPECT_NE(nullptr, TestUtility::findCounter(stats_store_, "server.watchdog_miss"));
+  EXPECT_NE(nullptr, TestUtility::findGauge(stats_store_, "server.initialization_time_ms"));
+  EXPECT_NE(nullptr, TestUtility::findGauge(stats_store_, "server.workers_started_time_ms"));
 }
 
 // Validate server localInfo() from bootstrap Node.
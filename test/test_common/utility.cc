@@ -45,27 +45,9 @@ bool TestUtility::buffersEqual(const Buffer::Instance& lhs, const Buffer::Instan
     return false;
   }
 
-  uint64_t lhs_num_slices = lhs.getRawSlices(nullptr, 0);
-  uint64_t rhs_num_slices = rhs.getRawSlices(nullptr, 0);
-  if (lhs_num_slices != rhs_num_slices) {
-    return false;
-  }
-
-  Buffer::RawSlice lhs_slices[lhs_num_slices];
-  lhs.getRawSlices(lhs_slices, lhs_num_slices);
-  Buffer::RawSlice rhs_slices[rhs_num_slices];
-  rhs.getRawSlices(rhs_slices, rhs_num_slices);
-  for (size_t i = 0; i < lhs_num_slices; i++) {
-    if (lhs_slices[i].len_ != rhs_slices[i].len_) {
-      return false;
-    }
-
-    if (0 != memcmp(lhs_slices[i].mem_, rhs_slices[i].mem_, lhs_slices[i].len_)) {
-      return false;
-    }
-  }
-
-  return true;
+  // Slice layout depends on how each buffer was built (e.g. move() may transfer or coalesce
+  // slices), so compare the contents rather than the slices themselves.
+  return bufferToString(lhs) == bufferToString(rhs);
 }
 
 std::string TestUtility::bufferToString(const Buffer::Instance& buffer) {